@@ -0,0 +1,399 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This program runs a standard set of benchmarks on every available Platform and reports
+ * the results as JSON.  The test systems are built programmatically, so no input files or
+ * Python layer are needed.  Results can be compared against a stored baseline (the output
+ * of an earlier run) to catch performance regressions.
+ *
+ * Run it with --help for a list of options.
+ */
+
+#include "BenchmarkSystems.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * The result of running one benchmark.
+ */
+struct BenchmarkResult {
+    string test, description, platform, precision;
+    int numParticles, steps;
+    double timestep, elapsedTime, nsPerDay, contextCreationTime;
+    map<string, pair<int, double> > kernelTimings;
+};
+
+static const vector<string> TEST_NAMES = {"argon", "customnonbonded", "water", "dhfr", "apoa1", "gbsa", "amoeba"};
+
+/**
+ * Run one benchmark.
+ */
+static BenchmarkResult runBenchmark(const string& testName, Platform& platform, const string& precision, double seconds, bool profile) {
+    TestSystem test = createTestSystem(testName);
+    map<string, string> properties;
+    const vector<string>& names = platform.getPropertyNames();
+    if (find(names.begin(), names.end(), "Precision") != names.end())
+        properties["Precision"] = precision;
+    if (profile && find(names.begin(), names.end(), "EnableProfiling") != names.end())
+        properties["EnableProfiling"] = "true";
+    LangevinMiddleIntegrator integrator(300.0, 1.0, test.timestep);
+    auto start = chrono::steady_clock::now();
+    Context context(*test.system, integrator, platform, properties);
+    BenchmarkResult result;
+    result.contextCreationTime = secondsSince(start);
+    initializeContext(context, test);
+    int steps;
+    double elapsed = runTimedSimulation(context, integrator, seconds, steps);
+    result.test = testName;
+    result.description = test.description;
+    result.platform = platform.getName();
+    result.precision = (properties.find("Precision") == properties.end() ? "default" : precision);
+    result.numParticles = test.system->getNumParticles();
+    result.steps = steps;
+    result.timestep = test.timestep;
+    result.elapsedTime = elapsed;
+    result.nsPerDay = steps*test.timestep*1e-3*86400/elapsed;
+    result.kernelTimings = context.getKernelTimings();
+    return result;
+}
+
+static void writeResults(const vector<BenchmarkResult>& results, ostream& out) {
+    out << setprecision(8);
+    out << "{\n    \"benchmarks\": [";
+    for (int i = 0; i < results.size(); i++) {
+        const BenchmarkResult& r = results[i];
+        out << (i == 0 ? "\n" : ",\n");
+        out << "        {\n";
+        out << "            \"test\": " << quote(r.test) << ",\n";
+        out << "            \"description\": " << quote(r.description) << ",\n";
+        out << "            \"platform\": " << quote(r.platform) << ",\n";
+        out << "            \"precision\": " << quote(r.precision) << ",\n";
+        out << "            \"atoms\": " << r.numParticles << ",\n";
+        out << "            \"steps\": " << r.steps << ",\n";
+        out << "            \"timestep_in_fs\": " << r.timestep*1000 << ",\n";
+        out << "            \"elapsed_seconds\": " << r.elapsedTime << ",\n";
+        out << "            \"ns_per_day\": " << r.nsPerDay << ",\n";
+        out << "            \"context_creation_seconds\": " << r.contextCreationTime << ",\n";
+        out << "            \"kernel_timings\": {";
+        bool first = true;
+        for (auto& timing : r.kernelTimings) {
+            out << (first ? "\n" : ",\n");
+            out << "                " << quote(timing.first) << ": {\"count\": " << timing.second.first << ", \"microseconds\": " << timing.second.second << "}";
+            first = false;
+        }
+        out << (first ? "}\n" : "\n            }\n");
+        out << "        }";
+    }
+    out << "\n    ]\n}\n";
+}
+
+/**
+ * A minimal JSON parser, just capable enough to read the output of writeResults().
+ */
+class JsonValue {
+public:
+    enum Type {Null, Boolean, Number, String, Array, Object};
+    Type type;
+    double number;
+    string str;
+    vector<JsonValue> elements;
+    map<string, JsonValue> members;
+    JsonValue() : type(Null), number(0) {
+    }
+    static JsonValue parse(const string& text) {
+        int pos = 0;
+        JsonValue value = parseValue(text, pos);
+        skipWhitespace(text, pos);
+        if (pos != text.size())
+            throw OpenMMException("Unexpected data at end of JSON");
+        return value;
+    }
+private:
+    static void skipWhitespace(const string& text, int& pos) {
+        while (pos < text.size() && isspace(text[pos]))
+            pos++;
+    }
+    static void expect(const string& text, int& pos, char c) {
+        skipWhitespace(text, pos);
+        if (pos >= text.size() || text[pos] != c)
+            throw OpenMMException(string("Malformed JSON: expected '")+c+"'");
+        pos++;
+    }
+    static string parseString(const string& text, int& pos) {
+        expect(text, pos, '"');
+        string result;
+        while (pos < text.size() && text[pos] != '"') {
+            if (text[pos] == '\\')
+                pos++;
+            if (pos < text.size())
+                result += text[pos++];
+        }
+        expect(text, pos, '"');
+        return result;
+    }
+    static JsonValue parseValue(const string& text, int& pos) {
+        skipWhitespace(text, pos);
+        if (pos >= text.size())
+            throw OpenMMException("Malformed JSON: unexpected end of data");
+        JsonValue value;
+        char c = text[pos];
+        if (c == '{') {
+            value.type = Object;
+            pos++;
+            skipWhitespace(text, pos);
+            if (pos < text.size() && text[pos] == '}')
+                pos++;
+            else {
+                while (true) {
+                    string key = parseString(text, pos);
+                    expect(text, pos, ':');
+                    value.members[key] = parseValue(text, pos);
+                    skipWhitespace(text, pos);
+                    if (pos < text.size() && text[pos] == ',')
+                        pos++;
+                    else
+                        break;
+                }
+                expect(text, pos, '}');
+            }
+        }
+        else if (c == '[') {
+            value.type = Array;
+            pos++;
+            skipWhitespace(text, pos);
+            if (pos < text.size() && text[pos] == ']')
+                pos++;
+            else {
+                while (true) {
+                    value.elements.push_back(parseValue(text, pos));
+                    skipWhitespace(text, pos);
+                    if (pos < text.size() && text[pos] == ',')
+                        pos++;
+                    else
+                        break;
+                }
+                expect(text, pos, ']');
+            }
+        }
+        else if (c == '"') {
+            value.type = String;
+            value.str = parseString(text, pos);
+        }
+        else if (text.compare(pos, 4, "true") == 0 || text.compare(pos, 5, "false") == 0) {
+            value.type = Boolean;
+            value.number = (c == 't' ? 1 : 0);
+            pos += (c == 't' ? 4 : 5);
+        }
+        else if (text.compare(pos, 4, "null") == 0)
+            pos += 4;
+        else {
+            value.type = Number;
+            const char* begin = text.c_str()+pos;
+            char* end;
+            value.number = strtod(begin, &end);
+            if (end == begin)
+                throw OpenMMException("Malformed JSON: unexpected character");
+            pos += end-begin;
+        }
+        return value;
+    }
+};
+
+/**
+ * Compare results to a baseline.  Every benchmark whose speed has dropped by more than the
+ * tolerance is reported.  The return value is the number of regressions found.
+ */
+static int compareToBaseline(const vector<BenchmarkResult>& results, const string& baselineFile, double tolerance) {
+    ifstream in(baselineFile.c_str());
+    if (!in.is_open())
+        throw OpenMMException("Failed to open baseline file: "+baselineFile);
+    stringstream buffer;
+    buffer << in.rdbuf();
+    JsonValue baseline = JsonValue::parse(buffer.str());
+    map<string, const JsonValue*> baselineByKey;
+    auto benchmarks = baseline.members.find("benchmarks");
+    if (benchmarks == baseline.members.end() || benchmarks->second.type != JsonValue::Array)
+        throw OpenMMException("Baseline file does not contain a list of benchmarks");
+    for (const JsonValue& entry : benchmarks->second.elements) {
+        auto test = entry.members.find("test");
+        auto platform = entry.members.find("platform");
+        auto precision = entry.members.find("precision");
+        if (test != entry.members.end() && platform != entry.members.end() && precision != entry.members.end())
+            baselineByKey[test->second.str+"/"+platform->second.str+"/"+precision->second.str] = &entry;
+    }
+    int regressions = 0;
+    for (const BenchmarkResult& r : results) {
+        string key = r.test+"/"+r.platform+"/"+r.precision;
+        if (baselineByKey.find(key) == baselineByKey.end()) {
+            cerr << key << ": no baseline" << endl;
+            continue;
+        }
+        const JsonValue& entry = *baselineByKey[key];
+        auto speed = entry.members.find("ns_per_day");
+        if (speed == entry.members.end() || speed->second.type != JsonValue::Number)
+            continue;
+        double change = r.nsPerDay/speed->second.number-1.0;
+        bool regressed = (change < -tolerance);
+        cerr << key << ": " << r.nsPerDay << " ns/day, baseline " << speed->second.number << " ns/day (" << showpos << fixed << setprecision(1) << 100*change << noshowpos << defaultfloat << "%)";
+        cerr << (regressed ? "  REGRESSION" : "") << endl;
+        if (regressed)
+            regressions++;
+    }
+    return regressions;
+}
+
+static void printUsage() {
+    cout << "Usage: openmm_benchmarks [options]\n\n";
+    cout << "Options:\n";
+    cout << "  --test NAME         run the named test.  May be repeated.  Available tests:\n                      ";
+    for (const string& name : TEST_NAMES)
+        cout << " " << name;
+    cout << "\n                      By default all tests are run.\n";
+    cout << "  --platform NAME     run on the named Platform.  May be repeated.  By default every\n";
+    cout << "                      Platform except Reference is used.\n";
+    cout << "  --precision P       precision to use: single, mixed, or double (default single)\n";
+    cout << "  --seconds S         approximate time to spend running each benchmark (default 20)\n";
+    cout << "  --no-profile        do not record per-kernel timings\n";
+    cout << "  --output FILE       write the results to FILE instead of standard output\n";
+    cout << "  --baseline FILE     compare the results to ones written by an earlier run\n";
+    cout << "  --tolerance T       fractional slowdown relative to the baseline that counts as a\n";
+    cout << "                      regression (default 0.1)\n";
+    cout << "  --plugins DIR       directory to load plugins from (default ";
+    cout << Platform::getDefaultPluginsDirectory() << ")\n\n";
+    cout << "The exit code is 1 if any benchmark regressed relative to the baseline.\n";
+}
+
+int main(int argc, char* argv[]) {
+    vector<string> tests, platforms;
+    string precision = "single", outputFile, baselineFile, pluginDir = Platform::getDefaultPluginsDirectory();
+    double seconds = 20.0, tolerance = 0.1;
+    bool profile = true;
+    try {
+        for (int i = 1; i < argc; i++) {
+            string arg = argv[i];
+            if (arg == "--help" || arg == "-h") {
+                printUsage();
+                return 0;
+            }
+            if (arg == "--no-profile") {
+                profile = false;
+                continue;
+            }
+            if (i == argc-1)
+                throw OpenMMException("Missing value for option: "+arg);
+            string value = argv[++i];
+            if (arg == "--test")
+                tests.push_back(value);
+            else if (arg == "--platform")
+                platforms.push_back(value);
+            else if (arg == "--precision")
+                precision = value;
+            else if (arg == "--seconds")
+                seconds = atof(value.c_str());
+            else if (arg == "--output")
+                outputFile = value;
+            else if (arg == "--baseline")
+                baselineFile = value;
+            else if (arg == "--tolerance")
+                tolerance = atof(value.c_str());
+            else if (arg == "--plugins")
+                pluginDir = value;
+            else
+                throw OpenMMException("Unknown option: "+arg);
+        }
+        if (precision != "single" && precision != "mixed" && precision != "double")
+            throw OpenMMException("Illegal value for precision: "+precision);
+        Platform::loadPluginsFromDirectory(pluginDir);
+        if (tests.size() == 0) {
+            for (const string& name : TEST_NAMES) {
+#ifndef OPENMM_BENCHMARK_AMOEBA
+                if (name == "amoeba")
+                    continue;
+#endif
+                tests.push_back(name);
+            }
+        }
+        if (platforms.size() == 0)
+            for (int i = 0; i < Platform::getNumPlatforms(); i++)
+                if (Platform::getPlatform(i).getName() != "Reference")
+                    platforms.push_back(Platform::getPlatform(i).getName());
+
+        // Run the benchmarks.  A failure in one of them is reported but does not stop the others.
+
+        vector<BenchmarkResult> results;
+        int failures = 0;
+        for (const string& platformName : platforms) {
+            Platform& platform = Platform::getPlatformByName(platformName);
+            for (const string& test : tests) {
+                cerr << test << " on " << platformName << "... " << flush;
+                try {
+                    results.push_back(runBenchmark(test, platform, precision, seconds, profile));
+                    cerr << results.back().nsPerDay << " ns/day" << endl;
+                }
+                catch (const exception& ex) {
+                    cerr << "failed: " << ex.what() << endl;
+                    failures++;
+                }
+            }
+        }
+        if (outputFile.size() > 0) {
+            ofstream out(outputFile.c_str());
+            if (!out.is_open())
+                throw OpenMMException("Failed to open output file: "+outputFile);
+            writeResults(results, out);
+        }
+        else
+            writeResults(results, cout);
+        if (baselineFile.size() > 0 && compareToBaseline(results, baselineFile, tolerance) > 0)
+            return 1;
+        if (failures > 0)
+            return 2;
+    }
+    catch (const exception& ex) {
+        cerr << "Error: " << ex.what() << endl;
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,343 @@
+#ifndef OPENMM_BENCHMARK_SYSTEMS_H_
+#define OPENMM_BENCHMARK_SYSTEMS_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This file contains the test systems shared by the benchmark programs, and a few utilities
+ * for running and reporting them.  Every system is built programmatically, so no input files
+ * are needed.  Each one can be scaled to a different number of atoms, which is used for
+ * measuring weak scaling.
+ */
+
+#include "OpenMM.h"
+#ifdef OPENMM_BENCHMARK_AMOEBA
+#include "OpenMMAmoeba.h"
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * A test system, along with the settings to simulate it with.
+ */
+struct TestSystem {
+    std::unique_ptr<OpenMM::System> system;
+    std::vector<OpenMM::Vec3> positions;
+    double timestep;
+    std::string description;
+};
+
+/**
+ * Get the number of lattice sites to put along each side of a box so it holds approximately
+ * scale times as many as a box with baseSize sites per side.
+ */
+static int scaledLatticeSize(int baseSize, double scale) {
+    return std::max(1, (int) std::round(baseSize*std::cbrt(scale)));
+}
+
+/**
+ * Build a simple cubic lattice of argon atoms.  If custom is true, the Lennard-Jones
+ * interaction is computed with a CustomNonbondedForce instead of a NonbondedForce.
+ */
+static TestSystem createArgon(bool custom, int atomsPerSide) {
+    const double spacing = 0.362;
+    const double sigma = 0.3350, epsilon = 0.996;
+    const double boxSize = atomsPerSide*spacing;
+    TestSystem test;
+    test.system.reset(new OpenMM::System());
+    OpenMM::System& system = *test.system;
+    system.setDefaultPeriodicBoxVectors(OpenMM::Vec3(boxSize, 0, 0), OpenMM::Vec3(0, boxSize, 0), OpenMM::Vec3(0, 0, boxSize));
+    if (custom) {
+        OpenMM::CustomNonbondedForce* force = new OpenMM::CustomNonbondedForce("4*eps*((sigma/r)^12-(sigma/r)^6); sigma=0.5*(sigma1+sigma2); eps=sqrt(eps1*eps2)");
+        force->addPerParticleParameter("sigma");
+        force->addPerParticleParameter("eps");
+        force->setNonbondedMethod(OpenMM::CustomNonbondedForce::CutoffPeriodic);
+        force->setCutoffDistance(1.0);
+        for (int i = 0; i < atomsPerSide*atomsPerSide*atomsPerSide; i++)
+            force->addParticle({sigma, epsilon});
+        system.addForce(force);
+        test.description = "Liquid argon with a CustomNonbondedForce";
+    }
+    else {
+        OpenMM::NonbondedForce* force = new OpenMM::NonbondedForce();
+        force->setNonbondedMethod(OpenMM::NonbondedForce::CutoffPeriodic);
+        force->setCutoffDistance(1.0);
+        for (int i = 0; i < atomsPerSide*atomsPerSide*atomsPerSide; i++)
+            force->addParticle(0.0, sigma, epsilon);
+        system.addForce(force);
+        test.description = "Liquid argon";
+    }
+    for (int i = 0; i < atomsPerSide; i++)
+        for (int j = 0; j < atomsPerSide; j++)
+            for (int k = 0; k < atomsPerSide; k++) {
+                system.addParticle(39.948);
+                test.positions.push_back(OpenMM::Vec3(i*spacing, j*spacing, k*spacing));
+            }
+    test.timestep = 0.004;
+    return test;
+}
+
+/**
+ * Add the particles and positions for a cubic lattice of rigid water molecules.  The
+ * lattice spacing gives a density of about 1 g/mL.  bondLength and angle describe the
+ * molecular geometry.  The index of the first atom of each molecule is returned.
+ */
+static std::vector<int> addWaterLattice(TestSystem& test, int moleculesPerSide, double bondLength, double angle) {
+    const double spacing = 0.3104;
+    const double boxSize = moleculesPerSide*spacing;
+    OpenMM::System& system = *test.system;
+    system.setDefaultPeriodicBoxVectors(OpenMM::Vec3(boxSize, 0, 0), OpenMM::Vec3(0, boxSize, 0), OpenMM::Vec3(0, 0, boxSize));
+    double hhDistance = 2*bondLength*sin(angle/2);
+    OpenMM::Vec3 h1(bondLength*sin(angle/2), bondLength*cos(angle/2), 0);
+    OpenMM::Vec3 h2(-bondLength*sin(angle/2), bondLength*cos(angle/2), 0);
+    std::vector<int> molecules;
+    for (int i = 0; i < moleculesPerSide; i++)
+        for (int j = 0; j < moleculesPerSide; j++)
+            for (int k = 0; k < moleculesPerSide; k++) {
+                int first = system.addParticle(15.999);
+                system.addParticle(1.008);
+                system.addParticle(1.008);
+                system.addConstraint(first, first+1, bondLength);
+                system.addConstraint(first, first+2, bondLength);
+                system.addConstraint(first+1, first+2, hhDistance);
+                OpenMM::Vec3 pos(i*spacing, j*spacing, k*spacing);
+                test.positions.push_back(pos);
+                test.positions.push_back(pos+h1);
+                test.positions.push_back(pos+h2);
+                molecules.push_back(first);
+            }
+    return molecules;
+}
+
+/**
+ * Build a box of rigid TIP3P water simulated with PME.  The sizes of the "dhfr" and "apoa1"
+ * tests match the numbers of atoms and the cutoffs of the standard DHFR (23,558 atoms) and
+ * ApoA1 (92,224 atoms) benchmarks.
+ */
+static TestSystem createWaterBox(int moleculesPerSide, double cutoff, const std::string& description) {
+    TestSystem test;
+    test.system.reset(new OpenMM::System());
+    OpenMM::NonbondedForce* force = new OpenMM::NonbondedForce();
+    force->setNonbondedMethod(OpenMM::NonbondedForce::PME);
+    force->setCutoffDistance(cutoff);
+    force->setEwaldErrorTolerance(0.0005);
+    test.system->addForce(force);
+    std::vector<std::pair<int, int> > bonds;
+    for (int first : addWaterLattice(test, moleculesPerSide, 0.09572, 104.52*M_PI/180)) {
+        force->addParticle(-0.834, 0.315061, 0.636386);
+        force->addParticle(0.417, 1.0, 0.0);
+        force->addParticle(0.417, 1.0, 0.0);
+        bonds.push_back(std::make_pair(first, first+1));
+        bonds.push_back(std::make_pair(first, first+2));
+    }
+    force->createExceptionsFromBonds(bonds, 0.5, 0.5);
+    test.timestep = 0.002;
+    test.description = description;
+    return test;
+}
+
+/**
+ * Build a roughly spherical cluster of charged particles in implicit solvent.  With the
+ * default radius it is about the size of DHFR without its water.
+ */
+static TestSystem createGBSA(double radius) {
+    const double spacing = 0.3;
+    const int maxIndex = (int) (radius/spacing);
+    TestSystem test;
+    test.system.reset(new OpenMM::System());
+    OpenMM::System& system = *test.system;
+    OpenMM::NonbondedForce* nonbonded = new OpenMM::NonbondedForce();
+    nonbonded->setNonbondedMethod(OpenMM::NonbondedForce::CutoffNonPeriodic);
+    nonbonded->setCutoffDistance(2.0);
+    system.addForce(nonbonded);
+    OpenMM::GBSAOBCForce* gbsa = new OpenMM::GBSAOBCForce();
+    gbsa->setNonbondedMethod(OpenMM::GBSAOBCForce::CutoffNonPeriodic);
+    gbsa->setCutoffDistance(2.0);
+    system.addForce(gbsa);
+    for (int i = -maxIndex; i <= maxIndex; i++)
+        for (int j = -maxIndex; j <= maxIndex; j++)
+            for (int k = -maxIndex; k <= maxIndex; k++) {
+                OpenMM::Vec3 pos(i*spacing, j*spacing, k*spacing);
+                if (sqrt(pos.dot(pos)) > radius)
+                    continue;
+                double charge = ((i+j+k)%2 == 0 ? 0.25 : -0.25);
+                system.addParticle(12.0);
+                nonbonded->addParticle(charge, 0.25, 0.4);
+                gbsa->addParticle(charge, 0.15, 0.8);
+                test.positions.push_back(pos);
+            }
+    test.timestep = 0.002;
+    test.description = "Implicit solvent with GBSAOBCForce";
+    return test;
+}
+
+#ifdef OPENMM_BENCHMARK_AMOEBA
+/**
+ * Build a box of rigid AMOEBA water with mutual polarization and PME.
+ */
+static TestSystem createAmoebaWater(int moleculesPerSide) {
+    TestSystem test;
+    test.system.reset(new OpenMM::System());
+    OpenMM::AmoebaMultipoleForce* multipoles = new OpenMM::AmoebaMultipoleForce();
+    multipoles->setNonbondedMethod(OpenMM::AmoebaMultipoleForce::PME);
+    multipoles->setPolarizationType(OpenMM::AmoebaMultipoleForce::Mutual);
+    multipoles->setCutoffDistance(0.7);
+    multipoles->setMutualInducedTargetEpsilon(1e-5);
+    multipoles->setEwaldErrorTolerance(0.00075);
+    test.system->addForce(multipoles);
+    OpenMM::AmoebaVdwForce* vdw = new OpenMM::AmoebaVdwForce();
+    vdw->setNonbondedMethod(OpenMM::AmoebaVdwForce::CutoffPeriodic);
+    vdw->setCutoffDistance(0.9);
+    test.system->addForce(vdw);
+    std::vector<double> oxygenDipole = {0.0, 0.0, 7.5561214e-3};
+    std::vector<double> oxygenQuadrupole = {3.5403072e-4, 0.0, 0.0, 0.0, -3.9025708e-4, 0.0, 0.0, 0.0, 3.6226356e-5};
+    std::vector<double> hydrogenDipole = {-2.0420949e-3, 0.0, -3.0787530e-3};
+    std::vector<double> hydrogenQuadrupole = {-3.4284825e-5, 0.0, -1.8948597e-6, 0.0, -1.0024088e-4, 0.0, -1.8948597e-6, 0.0, 1.3452570e-4};
+    for (int first : addWaterLattice(test, moleculesPerSide, 0.09572, 108.5*M_PI/180)) {
+        int o = first, h1 = first+1, h2 = first+2;
+        multipoles->addMultipole(-5.1966000e-1, oxygenDipole, oxygenQuadrupole, OpenMM::AmoebaMultipoleForce::Bisector, h1, h2, -1, 0.39, 3.0698765e-1, 8.3700000e-4);
+        multipoles->addMultipole(2.5983000e-1, hydrogenDipole, hydrogenQuadrupole, OpenMM::AmoebaMultipoleForce::ZThenX, o, h2, -1, 0.39, 2.8135002e-1, 4.9600000e-4);
+        multipoles->addMultipole(2.5983000e-1, hydrogenDipole, hydrogenQuadrupole, OpenMM::AmoebaMultipoleForce::ZThenX, o, h1, -1, 0.39, 2.8135002e-1, 4.9600000e-4);
+        std::vector<int> molecule = {o, h1, h2};
+        for (int atom : molecule)
+            multipoles->setCovalentMap(atom, OpenMM::AmoebaMultipoleForce::PolarizationCovalent11, molecule);
+        multipoles->setCovalentMap(o, OpenMM::AmoebaMultipoleForce::Covalent12, {h1, h2});
+        multipoles->setCovalentMap(h1, OpenMM::AmoebaMultipoleForce::Covalent12, {o});
+        multipoles->setCovalentMap(h2, OpenMM::AmoebaMultipoleForce::Covalent12, {o});
+        multipoles->setCovalentMap(h1, OpenMM::AmoebaMultipoleForce::Covalent13, {h2});
+        multipoles->setCovalentMap(h2, OpenMM::AmoebaMultipoleForce::Covalent13, {h1});
+        vdw->addParticle(o, 0.3405, 0.46024, 0.0);
+        vdw->addParticle(o, 0.2655, 0.056484, 0.91);
+        vdw->addParticle(o, 0.2655, 0.056484, 0.91);
+        for (int atom : molecule)
+            vdw->setParticleExclusions(atom, molecule);
+    }
+    test.timestep = 0.002;
+    test.description = "AMOEBA water with mutual polarization";
+    return test;
+}
+#endif
+
+/**
+ * Create one of the named test systems.  The number of atoms is multiplied by approximately
+ * scale.  Periodic systems are made larger at the same density, and the GBSA cluster gets a
+ * larger radius.
+ */
+static TestSystem createTestSystem(const std::string& name, double scale=1.0) {
+    if (name == "argon")
+        return createArgon(false, scaledLatticeSize(20, scale));
+    if (name == "customnonbonded")
+        return createArgon(true, scaledLatticeSize(20, scale));
+    if (name == "water")
+        return createWaterBox(scaledLatticeSize(16, scale), 0.9, "TIP3P water with PME");
+    if (name == "dhfr")
+        return createWaterBox(scaledLatticeSize(20, scale), 0.9, "TIP3P water with PME, the size of DHFR");
+    if (name == "apoa1")
+        return createWaterBox(scaledLatticeSize(31, scale), 1.2, "TIP3P water with PME, the size of ApoA1");
+    if (name == "gbsa")
+        return createGBSA(2.5*std::cbrt(scale));
+#ifdef OPENMM_BENCHMARK_AMOEBA
+    if (name == "amoeba")
+        return createAmoebaWater(scaledLatticeSize(12, scale));
+#endif
+    throw OpenMM::OpenMMException("Unknown or unsupported test: "+name);
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+}
+
+/**
+ * Prepare a Context for timing: set the positions, minimize the energy to remove bad contacts
+ * from the lattice, and assign velocities.
+ */
+static void initializeContext(OpenMM::Context& context, const TestSystem& test) {
+    context.setPositions(test.positions);
+    context.applyConstraints(1e-5);
+    OpenMM::LocalEnergyMinimizer::minimize(context, 100.0, 200);
+    context.setVelocitiesToTemperature(300.0, 1);
+}
+
+/**
+ * Time a simulation.  It is first run for a few steps to make sure everything is initialized,
+ * then for enough steps to take approximately the requested amount of time.  Kernel timings
+ * are reset before the timed run, so afterward they cover only that run.  The number of
+ * steps is stored in steps, and the elapsed time in seconds is returned.
+ */
+static double runTimedSimulation(OpenMM::Context& context, OpenMM::Integrator& integrator, double seconds, int& steps) {
+    // Warm up, and use that to estimate how many steps we can do in the requested time.
+
+    steps = 5;
+    auto start = std::chrono::steady_clock::now();
+    integrator.step(steps);
+    context.getState(OpenMM::State::Positions);
+    double elapsed = secondsSince(start);
+    while (elapsed < 0.1*seconds && elapsed < 2.0) {
+        steps *= 2;
+        start = std::chrono::steady_clock::now();
+        integrator.step(steps);
+        context.getState(OpenMM::State::Positions);
+        elapsed = secondsSince(start);
+    }
+    steps = std::max(1, (int) (steps*seconds/std::max(elapsed, 1e-6)));
+
+    // Run the timed simulation.
+
+    context.resetKernelTimings();
+    start = std::chrono::steady_clock::now();
+    integrator.step(steps);
+    context.getState(OpenMM::State::Positions);
+    return secondsSince(start);
+}
+
+/**
+ * Quote a string for inclusion in JSON output.
+ */
+static std::string quote(const std::string& s) {
+    std::stringstream out;
+    out << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            out << '\\';
+        out << c;
+    }
+    out << '"';
+    return out.str();
+}
+
+#endif /*OPENMM_BENCHMARK_SYSTEMS_H_*/
@@ -0,0 +1,408 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This program measures how the speed of a simulation scales with the number of workers: the
+ * number of threads on the CPU Platform, or the number of devices on a GPU Platform.  For each
+ * test it runs a sweep over worker counts twice.  Strong scaling keeps the system the same size,
+ * and weak scaling grows it in proportion to the number of workers.  The results, including
+ * the per-phase timings from Context::getKernelTimings(), are reported as JSON.
+ *
+ * Run it with --help for a list of options.
+ */
+
+#include "BenchmarkSystems.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * One point in a sweep: the value of the Platform property that selects the workers, and
+ * the number of workers it corresponds to.
+ */
+struct WorkerConfig {
+    string value;
+    int numWorkers;
+};
+
+/**
+ * The result of running one point in a sweep.
+ */
+struct ScalingResult {
+    string test, description, platform, precision, mode, property, value;
+    int numWorkers, numParticles, steps;
+    double timestep, elapsedTime, nsPerDay, atomStepsPerSecond, speedup, efficiency;
+    long long bytesPerLaunch;
+    map<string, pair<int, double> > kernelTimings;
+};
+
+static const vector<string> TEST_NAMES = {"argon", "customnonbonded", "water", "dhfr", "apoa1", "gbsa", "amoeba"};
+
+static bool hasProperty(Platform& platform, const string& property) {
+    const vector<string>& names = platform.getPropertyNames();
+    return (find(names.begin(), names.end(), property) != names.end());
+}
+
+/**
+ * Get the property used to select workers on a Platform, or an empty string if it does not
+ * have one.
+ */
+static string getWorkerProperty(Platform& platform) {
+    if (hasProperty(platform, "DeviceIndex"))
+        return "DeviceIndex";
+    if (hasProperty(platform, "Threads"))
+        return "Threads";
+    return "";
+}
+
+static vector<string> splitList(const string& list, char separator) {
+    vector<string> items;
+    stringstream stream(list);
+    string item;
+    while (getline(stream, item, separator))
+        if (item.size() > 0)
+            items.push_back(item);
+    return items;
+}
+
+/**
+ * Find the number of bytes that must move to or from memory each time a kernel is launched
+ * for it to read every atom position and write every force once.  This is the minimum traffic
+ * for a kernel that processes every atom, and is used to estimate the bandwidth each kernel
+ * achieves.  Context::getMemoryUsage() adds up the arrays on all devices, so the total is
+ * divided by the number of devices.  If the Platform does not track memory usage, this
+ * returns 0.
+ */
+static long long getBytesPerLaunch(Context& context, int numDevices) {
+    map<string, map<string, long long> > usage = context.getMemoryUsage();
+    auto arrays = usage.find("Context");
+    if (arrays == usage.end())
+        return 0;
+    long long bytes = 0;
+    for (const string& name : {"posq", "posqCorrection", "force"}) {
+        auto array = arrays->second.find(name);
+        if (array != arrays->second.end())
+            bytes += array->second;
+    }
+    return bytes/max(1, numDevices);
+}
+
+/**
+ * Run one point of a sweep.  For weak scaling the system is made larger by the ratio of the
+ * number of workers to the number in the first point of the sweep.
+ */
+static ScalingResult runPoint(const string& testName, Platform& platform, const string& property, const WorkerConfig& workers,
+        double scale, const string& precision, double seconds, bool profile) {
+    TestSystem test = createTestSystem(testName, scale);
+    map<string, string> properties;
+    properties[property] = workers.value;
+    if (hasProperty(platform, "Precision"))
+        properties["Precision"] = precision;
+    if (profile && hasProperty(platform, "EnableProfiling"))
+        properties["EnableProfiling"] = "true";
+    LangevinMiddleIntegrator integrator(300.0, 1.0, test.timestep);
+    Context context(*test.system, integrator, platform, properties);
+    initializeContext(context, test);
+    ScalingResult result;
+    double elapsed = runTimedSimulation(context, integrator, seconds, result.steps);
+    result.test = testName;
+    result.description = test.description;
+    result.platform = platform.getName();
+    result.precision = (properties.find("Precision") == properties.end() ? "default" : precision);
+    result.property = property;
+    result.value = workers.value;
+    result.numWorkers = workers.numWorkers;
+    result.numParticles = test.system->getNumParticles();
+    result.timestep = test.timestep;
+    result.elapsedTime = elapsed;
+    result.nsPerDay = result.steps*test.timestep*1e-3*86400/elapsed;
+    result.atomStepsPerSecond = (double) result.steps*result.numParticles/elapsed;
+    result.bytesPerLaunch = getBytesPerLaunch(context, property == "DeviceIndex" ? workers.numWorkers : 1);
+    result.kernelTimings = context.getKernelTimings();
+    return result;
+}
+
+/**
+ * Run a sweep over worker configurations.  Speedup and efficiency are computed relative to the
+ * first point that succeeds.  For strong scaling they are based on the simulation speed.  For
+ * weak scaling they are based on the number of atoms advanced per second, since rounding to a
+ * whole lattice means the system size does not grow in exactly the same ratio as the workers.
+ * If stopOnFailure is true, the sweep ends at the first configuration that cannot be run.  This
+ * is used when probing for the number of available devices.
+ */
+static int runSweep(const string& testName, Platform& platform, const string& property, const vector<WorkerConfig>& configs, const string& mode,
+        const string& precision, double seconds, bool profile, bool stopOnFailure, vector<ScalingResult>& results) {
+    int failures = 0, firstWorkers = 0;
+    double firstNsPerDay, firstAtomStepsPerSecond;
+    for (const WorkerConfig& config : configs) {
+        double scale = (mode == "weak" && firstWorkers > 0 ? config.numWorkers/(double) firstWorkers : 1.0);
+        cerr << testName << " on " << platform.getName() << ", " << mode << " scaling, " << property << "=" << config.value << "... " << flush;
+        try {
+            results.push_back(runPoint(testName, platform, property, config, scale, precision, seconds, profile));
+        }
+        catch (const exception& ex) {
+            cerr << "failed: " << ex.what() << endl;
+            if (stopOnFailure) {
+                // Running out of devices is expected while probing, and only counts as a failure
+                // if nothing could be run at all.
+
+                if (firstWorkers == 0)
+                    failures++;
+                break;
+            }
+            failures++;
+            continue;
+        }
+        ScalingResult& r = results.back();
+        r.mode = mode;
+        if (firstWorkers == 0) {
+            firstWorkers = r.numWorkers;
+            firstNsPerDay = r.nsPerDay;
+            firstAtomStepsPerSecond = r.atomStepsPerSecond;
+        }
+        if (mode == "strong")
+            r.speedup = r.nsPerDay/firstNsPerDay;
+        else
+            r.speedup = r.atomStepsPerSecond/firstAtomStepsPerSecond;
+        r.efficiency = r.speedup*firstWorkers/r.numWorkers;
+        cerr << r.nsPerDay << " ns/day, efficiency " << r.efficiency << endl;
+    }
+    return failures;
+}
+
+static void writeResults(const vector<ScalingResult>& results, ostream& out) {
+    out << setprecision(8);
+    out << "{\n    \"scaling\": [";
+    for (int i = 0; i < results.size(); i++) {
+        const ScalingResult& r = results[i];
+        out << (i == 0 ? "\n" : ",\n");
+        out << "        {\n";
+        out << "            \"test\": " << quote(r.test) << ",\n";
+        out << "            \"description\": " << quote(r.description) << ",\n";
+        out << "            \"platform\": " << quote(r.platform) << ",\n";
+        out << "            \"precision\": " << quote(r.precision) << ",\n";
+        out << "            \"mode\": " << quote(r.mode) << ",\n";
+        out << "            \"property\": " << quote(r.property) << ",\n";
+        out << "            \"value\": " << quote(r.value) << ",\n";
+        out << "            \"workers\": " << r.numWorkers << ",\n";
+        out << "            \"atoms\": " << r.numParticles << ",\n";
+        out << "            \"steps\": " << r.steps << ",\n";
+        out << "            \"timestep_in_fs\": " << r.timestep*1000 << ",\n";
+        out << "            \"elapsed_seconds\": " << r.elapsedTime << ",\n";
+        out << "            \"ns_per_day\": " << r.nsPerDay << ",\n";
+        out << "            \"atom_steps_per_second\": " << r.atomStepsPerSecond << ",\n";
+        out << "            \"speedup\": " << r.speedup << ",\n";
+        out << "            \"efficiency\": " << r.efficiency << ",\n";
+        out << "            \"phases\": {";
+
+        // The CPU Platform records how much longer the slowest thread took than the average
+        // under the phase name followed by " imbalance".  Merge those into the phases they
+        // describe.
+
+        bool first = true;
+        for (auto& timing : r.kernelTimings) {
+            const string& name = timing.first;
+            if (name.size() > 10 && name.compare(name.size()-10, 10, " imbalance") == 0 && r.kernelTimings.find(name.substr(0, name.size()-10)) != r.kernelTimings.end())
+                continue;
+            int count = timing.second.first;
+            double microseconds = timing.second.second;
+            out << (first ? "\n" : ",\n");
+            out << "                " << quote(name) << ": {\"count\": " << count << ", \"microseconds\": " << microseconds;
+            auto imbalance = r.kernelTimings.find(name+" imbalance");
+            if (imbalance != r.kernelTimings.end()) {
+                out << ", \"imbalance_microseconds\": " << imbalance->second.second;
+                out << ", \"imbalance_fraction\": " << (microseconds > 0 ? imbalance->second.second/microseconds : 0.0);
+            }
+            if (r.bytesPerLaunch > 0 && microseconds > 0)
+                out << ", \"bandwidth_gb_per_s\": " << count*(double) r.bytesPerLaunch/(1e3*microseconds);
+            out << "}";
+            first = false;
+        }
+        out << (first ? "}\n" : "\n            }\n");
+        out << "        }";
+    }
+    out << "\n    ]\n}\n";
+}
+
+static void printUsage() {
+    cout << "Usage: openmm_scaling_benchmarks [options]\n\n";
+    cout << "Options:\n";
+    cout << "  --test NAME         run the named test.  May be repeated.  Available tests:\n                      ";
+    for (const string& name : TEST_NAMES)
+        cout << " " << name;
+    cout << "\n                      The default is dhfr.\n";
+    cout << "  --platform NAME     run on the named Platform.  May be repeated.  By default every\n";
+    cout << "                      Platform except Reference is used.\n";
+    cout << "  --threads LIST      comma separated thread counts to use on Platforms that select\n";
+    cout << "                      workers with the Threads property (default 1, 2, 4, ... up to\n";
+    cout << "                      the number of cores)\n";
+    cout << "  --devices LIST      comma separated device indices to use together on Platforms that\n";
+    cout << "                      select workers with the DeviceIndex property.  May be repeated to\n";
+    cout << "                      give several sets.  By default the sets 0; 0,1; 0,1,2; ... are\n";
+    cout << "                      used until one fails.\n";
+    cout << "  --mode MODE         strong, weak, or both (default both)\n";
+    cout << "  --precision P       precision to use: single, mixed, or double (default single)\n";
+    cout << "  --seconds S         approximate time to spend running each point (default 10)\n";
+    cout << "  --no-profile        do not record per-phase timings\n";
+    cout << "  --output FILE       write the results to FILE instead of standard output\n";
+    cout << "  --plugins DIR       directory to load plugins from (default ";
+    cout << Platform::getDefaultPluginsDirectory() << ")\n";
+}
+
+int main(int argc, char* argv[]) {
+    vector<string> tests, platforms, deviceSets;
+    vector<int> threads;
+    string mode = "both", precision = "single", outputFile, pluginDir = Platform::getDefaultPluginsDirectory();
+    double seconds = 10.0;
+    bool profile = true;
+    try {
+        for (int i = 1; i < argc; i++) {
+            string arg = argv[i];
+            if (arg == "--help" || arg == "-h") {
+                printUsage();
+                return 0;
+            }
+            if (arg == "--no-profile") {
+                profile = false;
+                continue;
+            }
+            if (i == argc-1)
+                throw OpenMMException("Missing value for option: "+arg);
+            string value = argv[++i];
+            if (arg == "--test")
+                tests.push_back(value);
+            else if (arg == "--platform")
+                platforms.push_back(value);
+            else if (arg == "--threads") {
+                for (const string& item : splitList(value, ',')) {
+                    int count = atoi(item.c_str());
+                    if (count < 1)
+                        throw OpenMMException("Illegal thread count: "+item);
+                    threads.push_back(count);
+                }
+            }
+            else if (arg == "--devices")
+                deviceSets.push_back(value);
+            else if (arg == "--mode")
+                mode = value;
+            else if (arg == "--precision")
+                precision = value;
+            else if (arg == "--seconds")
+                seconds = atof(value.c_str());
+            else if (arg == "--output")
+                outputFile = value;
+            else if (arg == "--plugins")
+                pluginDir = value;
+            else
+                throw OpenMMException("Unknown option: "+arg);
+        }
+        if (precision != "single" && precision != "mixed" && precision != "double")
+            throw OpenMMException("Illegal value for precision: "+precision);
+        if (mode != "strong" && mode != "weak" && mode != "both")
+            throw OpenMMException("Illegal value for mode: "+mode);
+        Platform::loadPluginsFromDirectory(pluginDir);
+        if (tests.size() == 0)
+            tests.push_back("dhfr");
+        if (platforms.size() == 0)
+            for (int i = 0; i < Platform::getNumPlatforms(); i++)
+                if (Platform::getPlatform(i).getName() != "Reference")
+                    platforms.push_back(Platform::getPlatform(i).getName());
+
+        // Build the lists of worker configurations to sweep over.
+
+        vector<WorkerConfig> threadConfigs, deviceConfigs;
+        if (threads.size() == 0) {
+            int cores = max(1, (int) thread::hardware_concurrency());
+            for (int count = 1; count < cores; count *= 2)
+                threads.push_back(count);
+            threads.push_back(cores);
+        }
+        for (int count : threads)
+            threadConfigs.push_back({to_string(count), count});
+        bool probeDevices = (deviceSets.size() == 0);
+        if (probeDevices) {
+            string devices;
+            for (int i = 0; i < 16; i++) {
+                devices += (i == 0 ? "" : ",")+to_string(i);
+                deviceSets.push_back(devices);
+            }
+        }
+        for (const string& devices : deviceSets)
+            deviceConfigs.push_back({devices, (int) splitList(devices, ',').size()});
+        vector<string> modes;
+        if (mode != "weak")
+            modes.push_back("strong");
+        if (mode != "strong")
+            modes.push_back("weak");
+
+        // Run the sweeps.  A failure in one point is reported but does not stop the others.
+
+        vector<ScalingResult> results;
+        int failures = 0;
+        for (const string& platformName : platforms) {
+            Platform& platform = Platform::getPlatformByName(platformName);
+            string property = getWorkerProperty(platform);
+            if (property == "") {
+                cerr << "Skipping " << platformName << ": it has no property for selecting workers" << endl;
+                continue;
+            }
+            bool devices = (property == "DeviceIndex");
+            for (const string& test : tests)
+                for (const string& m : modes)
+                    failures += runSweep(test, platform, property, devices ? deviceConfigs : threadConfigs, m, precision, seconds, profile, devices && probeDevices, results);
+        }
+        if (outputFile.size() > 0) {
+            ofstream out(outputFile.c_str());
+            if (!out.is_open())
+                throw OpenMMException("Failed to open output file: "+outputFile);
+            writeResults(results, out);
+        }
+        else
+            writeResults(results, cout);
+        if (failures > 0)
+            return 2;
+    }
+    catch (const exception& ex) {
+        cerr << "Error: " << ex.what() << endl;
+        return 2;
+    }
+    return 0;
+}
@@ -61,9 +61,13 @@ class ParsedExpression;
  * You should treat it as an opaque object; none of the internal representation is visible.
  * 
  * A CompiledVectorExpression is created by calling createCompiledVectorExpression() on a ParsedExpression.  When you create
- * it, you must specify the width of the vectors on which to compute the expression.  The allowed widths depend on the type of
- * CPU it is running on.  4 is always allowed, and 8 is allowed on x86 processors with AVX.  Call getAllowedWidths() to query
- * the allowed values.
+ * it, you must specify the width of the vectors on which to compute the expression.  Machine code is generated for width 4,
+ * and also for width 8 on x86 processors with AVX.  Call getAllowedWidths() to query the widths that are optimized on the
+ * current processor.  Any other positive width is also accepted.  It is evaluated by an interpreter whose common operations
+ * are simple loops over the vector elements, so they still are vectorized by the compiler.
+ * 
+ * You also can create one from a list of expressions.  They then are evaluated together, and any subexpression that
+ * appears in more than one of them (for example, an energy and its derivatives) is computed only once.
  * 
  * WARNING: CompiledVectorExpression is NOT thread safe.  You should never access a CompiledVectorExpression from two threads at
  * the same time.
@@ -72,6 +76,14 @@ class ParsedExpression;
 class LEPTON_EXPORT CompiledVectorExpression {
 public:
     CompiledVectorExpression();
+    /**
+     * Create a CompiledVectorExpression that evaluates several expressions at once, sharing all their common
+     * subexpressions.  evaluate() returns the values of the last one.  Call getResult() to get the values of the others.
+     *
+     * @param expressions    the expressions to evaluate
+     * @param width          the width of the vectors on which to compute the expressions
+     */
+    CompiledVectorExpression(const std::vector<ParsedExpression>& expressions, int width);
     CompiledVectorExpression(const CompiledVectorExpression& expression);
     ~CompiledVectorExpression();
     CompiledVectorExpression& operator=(const CompiledVectorExpression& expression);
@@ -105,20 +117,34 @@ public:
      */
     const float* evaluate() const;
     /**
-     * Get the list of vector widths that are supported on the current processor.
+     * Get the values of one of the expressions, as computed by the most recent call to evaluate().
+     *
+     * @param index    the index of the expression in the list this was created from
+     * @return a pointer to N floating point values, where N is the vector width
+     */
+    const float* getResult(int index) const;
+    /**
+     * Get the list of vector widths for which optimized machine code can be generated on the current
+     * processor.  Any other positive width may also be used, but is evaluated by an interpreter.
      */
     static const std::vector<int>& getAllowedWidths();
 private:
     friend class ParsedExpression;
     CompiledVectorExpression(const ParsedExpression& expression, int width);
+    void compileExpressions(const std::vector<ParsedExpression>& expressions);
     void compileExpression(const ExpressionTreeNode& node, std::vector<std::pair<ExpressionTreeNode, int> >& temps, int& workspaceSize);
     int findTempIndex(const ExpressionTreeNode& node, std::vector<std::pair<ExpressionTreeNode, int> >& temps);
+    void findOperationConstants();
+    void findCustomArguments();
     int width;
     std::map<std::string, float*> variablePointers;
     std::vector<std::pair<float*, float*> > variablesToCopy;
     std::vector<std::vector<int> > arguments;
     std::vector<int> target;
+    std::vector<int> resultIndex;
     std::vector<Operation*> operation;
+    std::vector<float> operationConstant;
+    std::vector<std::vector<const float*> > customArgPointers;
     std::map<std::string, int> variableIndices;
     std::set<std::string> variableNames;
     mutable std::vector<float> workspace;
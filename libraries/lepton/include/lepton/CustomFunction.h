@@ -33,6 +33,8 @@
  * -------------------------------------------------------------------------- */
 
 #include "windowsIncludes.h"
+#include <cstddef>
+#include <vector>
 
 namespace Lepton {
 
@@ -66,6 +68,28 @@ public:
      *                     a second derivative with respect to the second argument.
      */
     virtual double evaluateDerivative(const double* arguments, const int* derivOrder) const = 0;
+    /**
+     * Evaluate the function (or one of its derivatives) for many sets of arguments at once.  This is
+     * used by CompiledVectorExpression.  The default implementation calls evaluate() or evaluateDerivative()
+     * once for each set.  Subclasses may override it with a faster version that processes the whole
+     * batch in a single loop.
+     *
+     * @param arguments    arguments[i] points to an array containing the values of the i'th argument
+     *                     for every set
+     * @param derivOrder   the derivative to evaluate, in the same format as for evaluateDerivative().
+     *                     If this is NULL, the value of the function itself is computed.
+     * @param results      on exit, results[j] contains the value for the j'th set of arguments
+     * @param count        the number of sets of arguments to evaluate
+     */
+    virtual void evaluateVector(const float* const* arguments, const int* derivOrder, float* results, int count) const {
+        int numArgs = getNumArguments();
+        std::vector<double> args(numArgs > 0 ? numArgs : 1);
+        for (int j = 0; j < count; j++) {
+            for (int i = 0; i < numArgs; i++)
+                args[i] = arguments[i][j];
+            results[j] = (float) (derivOrder == NULL ? evaluate(&args[0]) : evaluateDerivative(&args[0], derivOrder));
+        }
+    }
     /**
      * Create a new duplicate of this object on the heap using the "new" operator.
      */
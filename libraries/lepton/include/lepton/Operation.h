@@ -258,6 +258,12 @@ public:
             return function->evaluateDerivative(args, &derivOrder[0]);
         return function->evaluate(args);
     }
+    /**
+     * Evaluate this operation for many sets of arguments at once.  See CustomFunction::evaluateVector().
+     */
+    void evaluateVector(const float* const* args, float* results, int count) const {
+        function->evaluateVector(args, isDerivative ? &derivOrder[0] : NULL, results, count);
+    }
     ExpressionTreeNode differentiate(const std::vector<ExpressionTreeNode>& children, const std::vector<ExpressionTreeNode>& childDerivs, const std::string& variable) const;
     const std::vector<int>& getDerivOrder() const {
         return derivOrder;
@@ -107,10 +107,10 @@ public:
      * Create a CompiledVectorExpression that allows the expression to be evaluated efficiently
      * using the CPU's vector unit.
      * 
-     * @param width    the width of the vectors to evaluate it on.  The allowed values
-     *                 depend on the CPU.  4 is always allowed, and 8 is allowed on
-     *                 x86 processors with AVX.  Call CompiledVectorExpression::getAllowedWidths()
-     *                 to query the allowed widths on the current processor.
+     * @param width    the width of the vectors to evaluate it on.  Any positive width is
+     *                 allowed, but only some are compiled to machine code: 4 always, and 8
+     *                 on x86 processors with AVX.  Call CompiledVectorExpression::getAllowedWidths()
+     *                 to query the optimized widths on the current processor.
      */
     CompiledVectorExpression createCompiledVectorExpression(int width) const;
     /**
@@ -63,6 +63,7 @@ public:
      */
     static ParsedExpression parse(const std::string& expression, const std::map<std::string, CustomFunction*>& customFunctions);
 private:
+    static ParsedExpression parseExpression(const std::string& expression, const std::map<std::string, CustomFunction*>& customFunctions);
     static std::string trim(const std::string& expression);
     static std::vector<ParseToken> tokenize(const std::string& expression);
     static ParseToken getNextToken(const std::string& expression, int start);
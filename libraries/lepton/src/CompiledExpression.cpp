@@ -30,6 +30,7 @@
  * -------------------------------------------------------------------------- */
 
 #include "lepton/CompiledExpression.h"
+#include "lepton/Exception.h"
 #include "lepton/Operation.h"
 #include "lepton/ParsedExpression.h"
 #include <utility>
@@ -44,9 +45,25 @@ CompiledExpression::CompiledExpression() : jitCode(NULL) {
 }
 
 CompiledExpression::CompiledExpression(const ParsedExpression& expression) : jitCode(NULL) {
-    ParsedExpression expr = expression.optimize(); // Just in case it wasn't already optimized.
+    compileExpressions(vector<ParsedExpression>(1, expression));
+}
+
+CompiledExpression::CompiledExpression(const vector<ParsedExpression>& expressions) : jitCode(NULL) {
+    if (expressions.size() == 0)
+        throw Exception("CompiledExpression: No expressions specified");
+    compileExpressions(expressions);
+}
+
+void CompiledExpression::compileExpressions(const vector<ParsedExpression>& expressions) {
+    // All the expressions share one list of temporaries, so any subexpression that appears
+    // in more than one of them is only computed once.
+
     vector<pair<ExpressionTreeNode, int> > temps;
-    compileExpression(expr.getRootNode(), temps);
+    for (const ParsedExpression& expression : expressions) {
+        ParsedExpression expr = expression.optimize(); // Just in case it wasn't already optimized.
+        compileExpression(expr.getRootNode(), temps);
+        resultIndex.push_back(temps[findTempIndex(expr.getRootNode(), temps)].second);
+    }
     int maxArguments = 1;
     for (int i = 0; i < (int) operation.size(); i++)
         if (operation[i]->getNumArguments() > maxArguments)
@@ -70,6 +87,7 @@ CompiledExpression::CompiledExpression(const CompiledExpression& expression) : j
 CompiledExpression& CompiledExpression::operator=(const CompiledExpression& expression) {
     arguments = expression.arguments;
     target = expression.target;
+    resultIndex = expression.resultIndex;
     variableIndices = expression.variableIndices;
     variableNames = expression.variableNames;
     workspace.resize(expression.workspace.size());
@@ -180,7 +198,11 @@ double CompiledExpression::evaluate() const {
             workspace[target[step]] = operation[step]->evaluate(&argValues[0], dummyVariables);
         }
     }
-    return workspace[workspace.size()-1];
+    return workspace[resultIndex.back()];
+}
+
+double CompiledExpression::getResult(int index) const {
+    return workspace[resultIndex[index]];
 }
 
 #ifdef LEPTON_USE_JIT
@@ -488,7 +510,15 @@ void CompiledExpression::generateJitCode() {
                 invoke->setRet(0, workspaceVar[target[step]]);
         }
     }
-    c.ret(workspaceVar[workspace.size()-1]);
+
+    // Store the results so getResult() can retrieve them.
+
+    arm::Gp resultPointer = c.newIntPtr();
+    for (int index : resultIndex) {
+        c.mov(resultPointer, imm(&workspace[index]));
+        c.str(workspaceVar[index], arm::ptr(resultPointer, 0));
+    }
+    c.ret(workspaceVar[resultIndex.back()]);
     c.endFunc();
     c.finalize();
     runtime.add(&jitCode, &code);
@@ -784,7 +814,15 @@ void CompiledExpression::generateJitCode() {
                 invoke->setRet(0, workspaceVar[target[step]]);
         }
     }
-    c.ret(workspaceVar[workspace.size()-1]);
+
+    // Store the results so getResult() can retrieve them.
+
+    x86::Gp resultPointer = c.newIntPtr();
+    for (int index : resultIndex) {
+        c.mov(resultPointer, imm(&workspace[index]));
+        c.vmovsd(x86::ptr(resultPointer, 0, 0), workspaceVar[index]);
+    }
+    c.ret(workspaceVar[resultIndex.back()]);
     c.endFunc();
     c.finalize();
     runtime.add(&jitCode, &code);
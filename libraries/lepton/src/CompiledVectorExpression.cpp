@@ -33,6 +33,7 @@
 #include "lepton/Operation.h"
 #include "lepton/ParsedExpression.h"
 #include <algorithm>
+#include <cmath>
 #include <utility>
 
 using namespace Lepton;
@@ -45,24 +46,69 @@ CompiledVectorExpression::CompiledVectorExpression() : jitCode(NULL) {
 }
 
 CompiledVectorExpression::CompiledVectorExpression(const ParsedExpression& expression, int width) : jitCode(NULL), width(width) {
-    const vector<int> allowedWidths = getAllowedWidths();
-    if (find(allowedWidths.begin(), allowedWidths.end(), width) == allowedWidths.end())
+    if (width < 1)
         throw Exception("Unsupported width for vector expression: "+to_string(width));
-    ParsedExpression expr = expression.optimize(); // Just in case it wasn't already optimized.
+    compileExpressions(vector<ParsedExpression>(1, expression));
+}
+
+CompiledVectorExpression::CompiledVectorExpression(const vector<ParsedExpression>& expressions, int width) : jitCode(NULL), width(width) {
+    if (width < 1)
+        throw Exception("Unsupported width for vector expression: "+to_string(width));
+    if (expressions.size() == 0)
+        throw Exception("CompiledVectorExpression: No expressions specified");
+    compileExpressions(expressions);
+}
+
+void CompiledVectorExpression::compileExpressions(const vector<ParsedExpression>& expressions) {
+    // All the expressions share one list of temporaries, so any subexpression that appears
+    // in more than one of them is only computed once.
+
     vector<pair<ExpressionTreeNode, int> > temps;
     int workspaceSize = 0;
-    compileExpression(expr.getRootNode(), temps, workspaceSize);
+    for (const ParsedExpression& expression : expressions) {
+        ParsedExpression expr = expression.optimize(); // Just in case it wasn't already optimized.
+        compileExpression(expr.getRootNode(), temps, workspaceSize);
+        resultIndex.push_back(temps[findTempIndex(expr.getRootNode(), temps)].second);
+    }
     workspace.resize(workspaceSize*width);
     int maxArguments = 1;
     for (int i = 0; i < (int) operation.size(); i++)
         if (operation[i]->getNumArguments() > maxArguments)
             maxArguments = operation[i]->getNumArguments();
     argValues.resize(maxArguments);
+    findOperationConstants();
+    findCustomArguments();
 #ifdef LEPTON_USE_JIT
     generateJitCode();
 #endif
 }
 
+void CompiledVectorExpression::findOperationConstants() {
+    operationConstant.resize(operation.size(), 0.0f);
+    for (int step = 0; step < (int) operation.size(); step++) {
+        const Operation& op = *operation[step];
+        if (op.getId() == Operation::ADD_CONSTANT)
+            operationConstant[step] = (float) dynamic_cast<const Operation::AddConstant&>(op).getValue();
+        else if (op.getId() == Operation::MULTIPLY_CONSTANT)
+            operationConstant[step] = (float) dynamic_cast<const Operation::MultiplyConstant&>(op).getValue();
+    }
+}
+
+void CompiledVectorExpression::findCustomArguments() {
+    // Custom functions are evaluated for a whole vector at once, reading their arguments directly
+    // from the workspace.  Record where each argument is located.
+
+    customArgPointers.clear();
+    customArgPointers.resize(operation.size());
+    for (int step = 0; step < (int) operation.size(); step++) {
+        if (operation[step]->getId() != Operation::CUSTOM)
+            continue;
+        const vector<int>& args = arguments[step];
+        for (int i = 0; i < operation[step]->getNumArguments(); i++)
+            customArgPointers[step].push_back(&workspace[(args.size() == 1 ? args[0]+i : args[i])*width]);
+    }
+}
+
 CompiledVectorExpression::~CompiledVectorExpression() {
     for (int i = 0; i < (int) operation.size(); i++)
         if (operation[i] != NULL)
@@ -77,6 +123,7 @@ CompiledVectorExpression& CompiledVectorExpression::operator=(const CompiledVect
     arguments = expression.arguments;
     width = expression.width;
     target = expression.target;
+    resultIndex = expression.resultIndex;
     variableIndices = expression.variableIndices;
     variableNames = expression.variableNames;
     workspace.resize(expression.workspace.size());
@@ -84,6 +131,8 @@ CompiledVectorExpression& CompiledVectorExpression::operator=(const CompiledVect
     operation.resize(expression.operation.size());
     for (int i = 0; i < (int) operation.size(); i++)
         operation[i] = expression.operation[i]->clone();
+    operationConstant = expression.operationConstant;
+    findCustomArguments();
     setVariableLocations(variablePointers);
     return *this;
 }
@@ -189,16 +238,94 @@ void CompiledVectorExpression::setVariableLocations(map<string, float*>& variabl
 const float* CompiledVectorExpression::evaluate() const {
     if (jitCode) {
         jitCode();
-        return &workspace[workspace.size()-width];
+        return &workspace[resultIndex.back()*width];
     }
     for (int i = 0; i < variablesToCopy.size(); i++)
         for (int j = 0; j < width; j++)
             variablesToCopy[i].first[j] = variablesToCopy[i].second[j];
 
-    // Loop over the operations and evaluate each one.
+    // Loop over the operations and evaluate each one.  The most common operations are written as
+    // simple loops over the vector elements, which the compiler can turn into SIMD instructions.
+    // Custom functions process the whole vector in one call.  Everything else goes through the
+    // Operation one element at a time.
 
     for (int step = 0; step < operation.size(); step++) {
         const vector<int>& args = arguments[step];
+        float* result = &workspace[target[step]*width];
+        const float* arg1 = &workspace[args[0]*width];
+        const float* arg2 = (args.size() == 1 ? arg1+width : &workspace[args[1]*width]);
+        const float constant = operationConstant[step];
+        switch (operation[step]->getId()) {
+            case Operation::ADD:
+                for (int j = 0; j < width; j++)
+                    result[j] = arg1[j]+arg2[j];
+                continue;
+            case Operation::SUBTRACT:
+                for (int j = 0; j < width; j++)
+                    result[j] = arg1[j]-arg2[j];
+                continue;
+            case Operation::MULTIPLY:
+                for (int j = 0; j < width; j++)
+                    result[j] = arg1[j]*arg2[j];
+                continue;
+            case Operation::DIVIDE:
+                for (int j = 0; j < width; j++)
+                    result[j] = arg1[j]/arg2[j];
+                continue;
+            case Operation::NEGATE:
+                for (int j = 0; j < width; j++)
+                    result[j] = -arg1[j];
+                continue;
+            case Operation::SQRT:
+                for (int j = 0; j < width; j++)
+                    result[j] = sqrtf(arg1[j]);
+                continue;
+            case Operation::EXP:
+                for (int j = 0; j < width; j++)
+                    result[j] = expf(arg1[j]);
+                continue;
+            case Operation::LOG:
+                for (int j = 0; j < width; j++)
+                    result[j] = logf(arg1[j]);
+                continue;
+            case Operation::SQUARE:
+                for (int j = 0; j < width; j++)
+                    result[j] = arg1[j]*arg1[j];
+                continue;
+            case Operation::CUBE:
+                for (int j = 0; j < width; j++)
+                    result[j] = arg1[j]*arg1[j]*arg1[j];
+                continue;
+            case Operation::RECIPROCAL:
+                for (int j = 0; j < width; j++)
+                    result[j] = 1.0f/arg1[j];
+                continue;
+            case Operation::ADD_CONSTANT:
+                for (int j = 0; j < width; j++)
+                    result[j] = arg1[j]+constant;
+                continue;
+            case Operation::MULTIPLY_CONSTANT:
+                for (int j = 0; j < width; j++)
+                    result[j] = arg1[j]*constant;
+                continue;
+            case Operation::MIN:
+                for (int j = 0; j < width; j++)
+                    result[j] = (min)(arg1[j], arg2[j]);
+                continue;
+            case Operation::MAX:
+                for (int j = 0; j < width; j++)
+                    result[j] = (max)(arg1[j], arg2[j]);
+                continue;
+            case Operation::ABS:
+                for (int j = 0; j < width; j++)
+                    result[j] = fabsf(arg1[j]);
+                continue;
+            case Operation::CUSTOM:
+                dynamic_cast<const Operation::Custom*>(operation[step])->evaluateVector(customArgPointers[step].data(), result, width);
+                continue;
+            default:
+                break;
+        }
         if (args.size() == 1) {
             for (int j = 0; j < width; j++) {
                 for (int i = 0; i < operation[step]->getNumArguments(); i++)
@@ -213,7 +340,11 @@ const float* CompiledVectorExpression::evaluate() const {
             }
         }
     }
-    return &workspace[workspace.size()-width];
+    return &workspace[resultIndex.back()*width];
+}
+
+const float* CompiledVectorExpression::getResult(int index) const {
+    return &workspace[resultIndex[index]*width];
 }
 
 #ifdef LEPTON_USE_JIT
@@ -223,6 +354,10 @@ static double evaluateOperation(Operation* op, double* args) {
     return op->evaluate(args, dummyVariables);
 }
 
+static void evaluateCustomOperation(Operation::Custom* op, const float* const* args, float* results, int width) {
+    op->evaluateVector(args, results, width);
+}
+
 void CompiledVectorExpression::findPowerGroups(vector<vector<int> >& groups, vector<vector<int> >& groupPowers, vector<int>& stepGroup) {
     // Identify every step that raises an argument to an integer power.
 
@@ -268,6 +403,8 @@ void CompiledVectorExpression::findPowerGroups(vector<vector<int> >& groups, vec
 #if defined(__ARM__) || defined(__ARM64__)
 
 void CompiledVectorExpression::generateJitCode() {
+    if (width != 4)
+        return; // Other widths are evaluated by the interpreter.
     CodeHolder code;
     code.init(runtime.environment());
     a64::Compiler c(&code);
@@ -511,6 +648,28 @@ void CompiledVectorExpression::generateJitCode() {
                 c.fcmeq(workspaceVar[target[step]].s4(), workspaceVar[args[0]].s4(), imm(0));
                 c.bsl(workspaceVar[target[step]], workspaceVar[args[2]], workspaceVar[args[1]]);
                 break;
+            case Operation::CUSTOM:
+            {
+                // Write the arguments to the workspace and evaluate the whole vector with a single call.
+
+                arm::Gp pointer = c.newIntPtr();
+                for (int i = 0; i < op.getNumArguments(); i++) {
+                    int index = (args.size() == 1 ? args[0]+i : args[i]);
+                    c.mov(pointer, imm(&workspace[index*width]));
+                    c.str(workspaceVar[index].s4(), arm::ptr(pointer, 0));
+                }
+                arm::Gp fn = c.newIntPtr();
+                c.mov(fn, imm((void*) evaluateCustomOperation));
+                InvokeNode* invoke;
+                c.invoke(&invoke, fn, FuncSignatureT<void, Operation::Custom*, const float* const*, float*, int>());
+                invoke->setArg(0, imm(dynamic_cast<Operation::Custom*>(&op)));
+                invoke->setArg(1, imm(customArgPointers[step].data()));
+                invoke->setArg(2, imm(&workspace[target[step]*width]));
+                invoke->setArg(3, imm(width));
+                c.mov(pointer, imm(&workspace[target[step]*width]));
+                c.ldr(workspaceVar[target[step]].s4(), arm::ptr(pointer, 0));
+                break;
+            }
             default:
                 // Just invoke evaluateOperation().
                 for (int element = 0; element < width; element++) {
@@ -532,8 +691,10 @@ void CompiledVectorExpression::generateJitCode() {
         }
     }
     arm::Gp resultPointer = c.newIntPtr();
-    c.mov(resultPointer, imm(&workspace[workspace.size()-width]));
-    c.str(workspaceVar.back().s4(), arm::ptr(resultPointer, 0));
+    for (int index : resultIndex) {
+        c.mov(resultPointer, imm(&workspace[index*width]));
+        c.str(workspaceVar[index].s4(), arm::ptr(resultPointer, 0));
+    }
     c.endFunc();
     c.finalize();
     runtime.add(&jitCode, &code);
@@ -575,13 +736,14 @@ void CompiledVectorExpression::generateTwoArgCall(a64::Compiler& c, arm::Vec& de
 
 void CompiledVectorExpression::generateJitCode() {
     const CpuInfo& cpu = CpuInfo::host();
-    if (!cpu.hasFeature(CpuFeatures::X86::kAVX))
-        return;
+    if (!cpu.hasFeature(CpuFeatures::X86::kAVX) || (width != 4 && width != 8))
+        return; // Other widths are evaluated by the interpreter.
     CodeHolder code;
     code.init(runtime.environment());
     x86::Compiler c(&code);
     FuncNode* funcNode = c.addFunc(FuncSignatureT<void>());
     funcNode->frame().setAvxEnabled();
+    funcNode->frame().setAvxCleanup();
     vector<x86::Ymm> workspaceVar(workspace.size()/width);
     for (int i = 0; i < (int) workspaceVar.size(); i++)
         workspaceVar[i] = c.newYmmPs();
@@ -835,6 +997,34 @@ void CompiledVectorExpression::generateJitCode() {
                 c.vblendvps(workspaceVar[target[step]], workspaceVar[args[1]], workspaceVar[args[2]], mask);
                 break;
             }
+            case Operation::CUSTOM:
+            {
+                // Write the arguments to the workspace and evaluate the whole vector with a single call.
+
+                x86::Gp pointer = c.newIntPtr();
+                for (int i = 0; i < op.getNumArguments(); i++) {
+                    int index = (args.size() == 1 ? args[0]+i : args[i]);
+                    c.mov(pointer, imm(&workspace[index*width]));
+                    if (width == 4)
+                        c.vmovdqu(x86::ptr(pointer, 0, 0), workspaceVar[index].xmm());
+                    else
+                        c.vmovdqu(x86::ptr(pointer, 0, 0), workspaceVar[index]);
+                }
+                x86::Gp fn = c.newIntPtr();
+                c.mov(fn, imm((void*) evaluateCustomOperation));
+                InvokeNode* invoke;
+                c.invoke(&invoke, fn, FuncSignatureT<void, Operation::Custom*, const float* const*, float*, int>());
+                invoke->setArg(0, imm(dynamic_cast<Operation::Custom*>(&op)));
+                invoke->setArg(1, imm(customArgPointers[step].data()));
+                invoke->setArg(2, imm(&workspace[target[step]*width]));
+                invoke->setArg(3, imm(width));
+                c.mov(pointer, imm(&workspace[target[step]*width]));
+                if (width == 4)
+                    c.vmovdqu(workspaceVar[target[step]].xmm(), x86::ptr(pointer, 0, 0));
+                else
+                    c.vmovdqu(workspaceVar[target[step]], x86::ptr(pointer, 0, 0));
+                break;
+            }
             default:
                 // Just invoke evaluateOperation().
 
@@ -866,11 +1056,13 @@ void CompiledVectorExpression::generateJitCode() {
         }
     }
     x86::Gp resultPointer = c.newIntPtr();
-    c.mov(resultPointer, imm(&workspace[workspace.size()-width]));
-    if (width == 4)
-        c.vmovdqu(x86::ptr(resultPointer, 0, 0), workspaceVar.back().xmm());
-    else
-        c.vmovdqu(x86::ptr(resultPointer, 0, 0), workspaceVar.back());
+    for (int index : resultIndex) {
+        c.mov(resultPointer, imm(&workspace[index*width]));
+        if (width == 4)
+            c.vmovdqu(x86::ptr(resultPointer, 0, 0), workspaceVar[index].xmm());
+        else
+            c.vmovdqu(x86::ptr(resultPointer, 0, 0), workspaceVar[index]);
+    }
     c.endFunc();
     c.finalize();
     runtime.add(&jitCode, &code);
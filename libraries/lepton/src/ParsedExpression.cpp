@@ -34,12 +34,79 @@
 #include "lepton/CompiledVectorExpression.h"
 #include "lepton/ExpressionProgram.h"
 #include "lepton/Operation.h"
+#include <cstring>
 #include <limits>
+#include <mutex>
 #include <vector>
 
 using namespace Lepton;
 using namespace std;
 
+// Optimizing and differentiating expressions is slow, and the same expressions often get processed many
+// times, for example when creating many Contexts for the same System.  The results are cached in a process
+// wide table, keyed by an exact description of the expression tree.  Expressions involving custom functions
+// are never cached, since two functions with the same name may behave differently.
+
+static const size_t MaxCacheSize = 2000;
+static mutex cacheLock;
+static map<string, ExpressionTreeNode> optimizeCache, derivativeCache;
+
+static bool appendCacheKey(const ExpressionTreeNode& node, string& key) {
+    const Operation& op = node.getOperation();
+    key += to_string((int) op.getId());
+    double value;
+    switch (op.getId()) {
+        case Operation::CUSTOM:
+            return false;
+        case Operation::VARIABLE:
+            key += ':'+to_string(op.getName().size())+':'+op.getName();
+            break;
+        case Operation::CONSTANT:
+        case Operation::ADD_CONSTANT:
+        case Operation::MULTIPLY_CONSTANT:
+        case Operation::POWER_CONSTANT: {
+            if (op.getId() == Operation::CONSTANT)
+                value = dynamic_cast<const Operation::Constant&>(op).getValue();
+            else if (op.getId() == Operation::ADD_CONSTANT)
+                value = dynamic_cast<const Operation::AddConstant&>(op).getValue();
+            else if (op.getId() == Operation::MULTIPLY_CONSTANT)
+                value = dynamic_cast<const Operation::MultiplyConstant&>(op).getValue();
+            else
+                value = dynamic_cast<const Operation::PowerConstant&>(op).getValue();
+            unsigned long long bits;
+            memcpy(&bits, &value, sizeof(bits));
+            key += ':'+to_string(bits);
+            break;
+        }
+        default:
+            break;
+    }
+    key += '(';
+    for (const ExpressionTreeNode& child : node.getChildren()) {
+        if (!appendCacheKey(child, key))
+            return false;
+        key += ',';
+    }
+    key += ')';
+    return true;
+}
+
+static bool findCachedNode(map<string, ExpressionTreeNode>& cache, const string& key, ExpressionTreeNode& result) {
+    lock_guard<mutex> guard(cacheLock);
+    auto cached = cache.find(key);
+    if (cached == cache.end())
+        return false;
+    result = cached->second;
+    return true;
+}
+
+static void addCachedNode(map<string, ExpressionTreeNode>& cache, const string& key, const ExpressionTreeNode& node) {
+    lock_guard<mutex> guard(cacheLock);
+    if (cache.size() >= MaxCacheSize)
+        cache.clear();
+    cache[key] = node;
+}
+
 ParsedExpression::ParsedExpression() : rootNode(ExpressionTreeNode()) {
 }
 
@@ -69,7 +136,12 @@ double ParsedExpression::evaluate(const ExpressionTreeNode& node, const map<stri
 }
 
 ParsedExpression ParsedExpression::optimize() const {
-    ExpressionTreeNode result = getRootNode();
+    string key;
+    bool cacheable = appendCacheKey(getRootNode(), key);
+    ExpressionTreeNode result;
+    if (cacheable && findCachedNode(optimizeCache, key, result))
+        return ParsedExpression(result);
+    result = getRootNode();
     vector<const ExpressionTreeNode*> examples;
     result.assignTags(examples);
     map<int, ExpressionTreeNode> nodeCache;
@@ -83,6 +155,8 @@ ParsedExpression ParsedExpression::optimize() const {
             break;
         result = simplified;
     }
+    if (cacheable)
+        addCachedNode(optimizeCache, key, result);
     return ParsedExpression(result);
 }
 
@@ -345,10 +419,18 @@ ExpressionTreeNode ParsedExpression::substituteSimplerExpression(const Expressio
 }
 
 ParsedExpression ParsedExpression::differentiate(const string& variable) const {
+    string key = variable+'\n';
+    bool cacheable = appendCacheKey(getRootNode(), key);
+    ExpressionTreeNode result;
+    if (cacheable && findCachedNode(derivativeCache, key, result))
+        return ParsedExpression(result);
     vector<const ExpressionTreeNode*> examples;
     getRootNode().assignTags(examples);
     map<int, ExpressionTreeNode> nodeCache;
-    return differentiate(getRootNode(), variable, nodeCache);
+    result = differentiate(getRootNode(), variable, nodeCache);
+    if (cacheable)
+        addCachedNode(derivativeCache, key, result);
+    return ParsedExpression(result);
 }
 
 ExpressionTreeNode ParsedExpression::differentiate(const ExpressionTreeNode& node, const string& variable, map<int, ExpressionTreeNode>& nodeCache) {
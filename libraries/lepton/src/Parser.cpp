@@ -37,6 +37,7 @@
 #include "lepton/ParsedExpression.h"
 #include <cctype>
 #include <iostream>
+#include <mutex>
 
 using namespace Lepton;
 using namespace std;
@@ -47,6 +48,13 @@ static const bool LeftAssociative[] = {true, true, true, true, false};
 static const int Precedence[] = {0, 0, 1, 1, 3};
 static const Operation::Id OperationId[] = {Operation::ADD, Operation::SUBTRACT, Operation::MULTIPLY, Operation::DIVIDE, Operation::POWER};
 
+// Expressions without custom functions are cached, since the same ones often get parsed many times,
+// for example when creating many Contexts for the same System.
+
+static const size_t MaxCacheSize = 2000;
+static mutex parseCacheLock;
+static map<string, ExpressionTreeNode> parseCache;
+
 class Lepton::ParseToken {
 public:
     enum Type {Number, Operator, Variable, Function, LeftParen, RightParen, Comma, Whitespace};
@@ -150,6 +158,23 @@ ParsedExpression Parser::parse(const string& expression) {
 }
 
 ParsedExpression Parser::parse(const string& expression, const map<string, CustomFunction*>& customFunctions) {
+    if (customFunctions.size() > 0)
+        return parseExpression(expression, customFunctions);
+    {
+        lock_guard<mutex> guard(parseCacheLock);
+        auto cached = parseCache.find(expression);
+        if (cached != parseCache.end())
+            return ParsedExpression(cached->second);
+    }
+    ParsedExpression result = parseExpression(expression, customFunctions);
+    lock_guard<mutex> guard(parseCacheLock);
+    if (parseCache.size() >= MaxCacheSize)
+        parseCache.clear();
+    parseCache[expression] = result.getRootNode();
+    return result;
+}
+
+ParsedExpression Parser::parseExpression(const string& expression, const map<string, CustomFunction*>& customFunctions) {
     try {
         // First split the expression into subexpressions.
 
@@ -9,7 +9,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2008-2024 Stanford University and the Authors.      *
+ * Portions copyright (c) 2008-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -34,6 +34,7 @@
 
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 #include "openmm/internal/windowsExport.h"
 
@@ -106,6 +107,45 @@ public:
      * @param value       the value to set for the property
      */
     virtual void setPropertyValue(Context& context, const std::string& property, const std::string& value) const;
+    /**
+     * Get the execution times that have been recorded for the kernels run by a Context.  The default
+     * implementation returns an empty map.  Platforms that support profiling should override it.
+     *
+     * @param context     the Context for which to get the timings
+     * @return a map whose keys are kernel names and whose values contain the number of executions and
+     * the total device time in microseconds
+     */
+    virtual std::map<std::string, std::pair<int, double> > getKernelTimings(Context& context) const;
+    /**
+     * Discard all kernel execution times that have been recorded for a Context.
+     *
+     * @param context     the Context for which to reset the timings
+     */
+    virtual void resetKernelTimings(Context& context) const;
+    /**
+     * Get the amount of device memory used by the arrays a Context has allocated.  The default
+     * implementation returns an empty map.  Platforms that track memory usage should override it.
+     *
+     * @param context     the Context for which to get the memory usage
+     * @return a map whose keys are the owners of arrays (usually Forces) and whose values map array
+     * names to the number of bytes they use
+     */
+    virtual std::map<std::string, std::map<std::string, long long> > getMemoryUsage(Context& context) const;
+    /**
+     * Get direct access to one of the arrays a Context stores on a GPU, so it can be passed to other
+     * libraries without copying it to the host.  All pending work on the device is completed before
+     * this returns.  The array is owned by the Context and must be treated as read-only.  The default
+     * implementation throws an exception.  Platforms that store arrays on a GPU should override it.
+     *
+     * @param context      the Context for which to get the array
+     * @param name         the name of the array to get
+     * @param[out] pointer the device address of the array
+     * @param[out] shape   the number of elements along each dimension of the array
+     * @param[out] type    the element type, in the format used by the numpy array interface (for example "<f4")
+     * @param[out] deviceIndex the index of the device the array is stored on
+     */
+    virtual void getDeviceArray(Context& context, const std::string& name, long long& pointer, std::vector<int>& shape,
+                                std::string& type, int& deviceIndex) const;
     /**
      * Get the default value of a Platform-specific property.  This is the value that will be used for
      * newly created Contexts.
@@ -234,8 +274,17 @@ public:
      * for each one.  If an error occurs while trying to load a particular file, that file is simply
      * ignored. You can retrieve a list of all such errors by calling getPluginLoadFailures().
      *
+     * A library may be accompanied by a manifest: a text file with the same name plus the suffix
+     * ".platforms", listing the names of the Platforms the library defines or adds kernels to.
+     * Loading such a library is deferred until one of those Platforms is requested by name, or until
+     * the full list of Platforms is needed (for example, by getNumPlatforms() or findPlatform()).
+     * This avoids initializing GPU drivers in programs that never use them.  Errors from deferred
+     * libraries are reported by getPluginLoadFailures() once they are loaded.  When a library adds
+     * new Platforms, libraries that were loaded earlier have their kernel factories registered on
+     * the new Platforms as well.
+     *
      * @param directory    a ':' (unix) or ';' (windows) deliminated list of paths containing libraries to load
-     * @return the names of all files which were successfully loaded as libraries
+     * @return the names of all files which were successfully loaded as libraries, or whose loading was deferred
      */
     static std::vector<std::string> loadPluginsFromDirectory(const std::string& directory);
     /**
@@ -266,6 +315,11 @@ private:
     std::map<std::string, KernelFactory*> kernelFactories;
     std::map<std::string, std::string> defaultProperties;
     static std::vector<Platform*>& getPlatforms();
+    /**
+     * Load plugin libraries whose loading was deferred by loadPluginsFromDirectory().  If platformName
+     * is empty, all of them are loaded.  Otherwise only the ones needed for that Platform are loaded.
+     */
+    static void loadPendingPlugins(const std::string& platformName);
     static std::vector<std::string> pluginLoadFailures;
 };
 
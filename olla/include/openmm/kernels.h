@@ -9,7 +9,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2008-2025 Stanford University and the Authors.      *
+ * Portions copyright (c) 2008-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -56,6 +56,7 @@
 #include "openmm/HarmonicBondForce.h"
 #include "openmm/KernelImpl.h"
 #include "openmm/MonteCarloBarostat.h"
+#include "openmm/MTSLangevinIntegrator.h"
 #include "openmm/PeriodicTorsionForce.h"
 #include "openmm/RBTorsionForce.h"
 #include "openmm/RMSDForce.h"
@@ -68,9 +69,13 @@
 #include "openmm/NoseHooverChain.h"
 #include "openmm/ATMForce.h"
 #include "openmm/internal/CustomCPPForceImpl.h"
+#include <functional>
 #include <iosfwd>
+#include <map>
+#include <memory>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace OpenMM {
@@ -118,6 +123,27 @@ public:
      * energy directly, <i>or</i> add it to an internal buffer so that it will be included here.
      */
     virtual double finishComputation(ContextImpl& context, bool includeForce, bool includeEnergy, int groups, bool& valid) = 0;
+    /**
+     * This is called immediately before calcForcesAndEnergy() is called on each ForceImpl.  Platforms may
+     * override it to annotate the work done for each Force, for example for external profiling tools.
+     * The default implementation does nothing.
+     *
+     * @param context       the context in which to execute this kernel
+     * @param force         the Force whose contribution is about to be computed
+     * @param groups        a set of bit flags for which force groups to include
+     */
+    virtual void beginForce(ContextImpl& context, const Force& force, int groups) {
+    }
+    /**
+     * This is called immediately after calcForcesAndEnergy() returns for each ForceImpl.  The default
+     * implementation does nothing.
+     *
+     * @param context       the context in which to execute this kernel
+     * @param force         the Force whose contribution was just computed
+     * @param groups        a set of bit flags for which force groups to include
+     */
+    virtual void endForce(ContextImpl& context, const Force& force, int groups) {
+    }
 };
 
 /**
@@ -126,6 +152,11 @@ public:
  */
 class UpdateStateDataKernel : public KernelImpl {
 public:
+    /**
+     * A function returned by getStateDataAsync().  When invoked, it blocks until the data is available,
+     * then stores the positions, velocities, and forces (whichever were requested) in its arguments.
+     */
+    typedef std::function<void(std::vector<Vec3>& positions, std::vector<Vec3>& velocities, std::vector<Vec3>& forces)> StateDataFunction;
     static std::string Name() {
         return "UpdateTime";
     }
@@ -168,6 +199,19 @@ public:
      * @param positions  on exit, this contains the particle positions
      */
     virtual void getPositions(ContextImpl& context, std::vector<Vec3>& positions) = 0;
+    /**
+     * Get the positions of all particles, rounded to a fixed precision.  This is intended for
+     * writing compressed trajectory formats that store coordinates as fixed point values.  Each
+     * coordinate is guaranteed to be within precision/2 of its full precision value, so platforms
+     * whose data lives on a device may pack the rounded values before transferring them to the
+     * host.  The default implementation simply calls getPositions().
+     *
+     * @param precision  the precision to which coordinates are rounded, in nm
+     * @param positions  on exit, this contains the particle positions
+     */
+    virtual void getQuantizedPositions(ContextImpl& context, double precision, std::vector<Vec3>& positions) {
+        getPositions(context, positions);
+    }
     /**
      * Set the positions of all particles.
      *
@@ -201,12 +245,105 @@ public:
      * @param forces  on exit, this contains the forces
      */
     virtual void getForces(ContextImpl& context, std::vector<Vec3>& forces) = 0;
+    /**
+     * Get the positions of a subset of particles.
+     *
+     * The default implementation retrieves the positions of all particles and then selects
+     * the requested ones.  Platforms that can retrieve only the subset should override it.
+     *
+     * @param particles  the indices of the particles to retrieve
+     * @param positions  on exit, element i contains the position of particle particles[i]
+     */
+    virtual void getParticlePositions(ContextImpl& context, const std::vector<int>& particles, std::vector<Vec3>& positions) {
+        std::vector<Vec3> all;
+        getPositions(context, all);
+        positions.resize(particles.size());
+        for (int i = 0; i < (int) particles.size(); i++)
+            positions[i] = all[particles[i]];
+    }
+    /**
+     * Get the velocities of a subset of particles.
+     *
+     * The default implementation retrieves the velocities of all particles and then selects
+     * the requested ones.  Platforms that can retrieve only the subset should override it.
+     *
+     * @param particles   the indices of the particles to retrieve
+     * @param velocities  on exit, element i contains the velocity of particle particles[i]
+     */
+    virtual void getParticleVelocities(ContextImpl& context, const std::vector<int>& particles, std::vector<Vec3>& velocities) {
+        std::vector<Vec3> all;
+        getVelocities(context, all);
+        velocities.resize(particles.size());
+        for (int i = 0; i < (int) particles.size(); i++)
+            velocities[i] = all[particles[i]];
+    }
+    /**
+     * Multiply the velocities of all particles by a constant factor.
+     *
+     * The default implementation retrieves the velocities, scales them, and sets them again.
+     * Platforms that can scale them in place should override it.
+     *
+     * @param scale      the factor to multiply the velocities by
+     */
+    virtual void scaleVelocities(ContextImpl& context, double scale) {
+        std::vector<Vec3> velocities;
+        getVelocities(context, velocities);
+        for (Vec3& v : velocities)
+            v *= scale;
+        setVelocities(context, velocities);
+    }
+    /**
+     * Get the current forces on a subset of particles.
+     *
+     * The default implementation retrieves the forces on all particles and then selects
+     * the requested ones.  Platforms that can retrieve only the subset should override it.
+     *
+     * @param particles  the indices of the particles to retrieve
+     * @param forces     on exit, element i contains the force on particle particles[i]
+     */
+    virtual void getParticleForces(ContextImpl& context, const std::vector<int>& particles, std::vector<Vec3>& forces) {
+        std::vector<Vec3> all;
+        getForces(context, all);
+        forces.resize(particles.size());
+        for (int i = 0; i < (int) particles.size(); i++)
+            forces[i] = all[particles[i]];
+    }
     /**
      * Get the current derivatives of the energy with respect to context parameters.
      *
      * @param derivs  on exit, this contains the derivatives
      */
     virtual void getEnergyParameterDerivatives(ContextImpl& context, std::map<std::string, double>& derivs) = 0;
+    /**
+     * Begin retrieving the current positions, velocities, and/or forces without waiting for the data
+     * to reach the host.  The values are captured at the time of the call, so later changes to the
+     * Context do not affect them.  The returned function may be invoked on a different thread.
+     *
+     * The default implementation retrieves the data immediately.  Platforms that can overlap the
+     * transfer with further computation should override it.
+     *
+     * @param context     the context in which to execute this kernel
+     * @param positions   whether to retrieve the positions
+     * @param velocities  whether to retrieve the velocities
+     * @param forces      whether to retrieve the forces
+     * @return a function which completes the retrieval
+     */
+    virtual StateDataFunction getStateDataAsync(ContextImpl& context, bool positions, bool velocities, bool forces) {
+        std::shared_ptr<std::vector<Vec3> > pos = std::make_shared<std::vector<Vec3> >();
+        std::shared_ptr<std::vector<Vec3> > vel = std::make_shared<std::vector<Vec3> >();
+        std::shared_ptr<std::vector<Vec3> > f = std::make_shared<std::vector<Vec3> >();
+        if (positions)
+            getPositions(context, *pos);
+        if (velocities)
+            getVelocities(context, *vel);
+        if (forces)
+            getForces(context, *f);
+        return [pos, vel, f] (std::vector<Vec3>& positions, std::vector<Vec3>& velocities, std::vector<Vec3>& forces) {
+            positions.swap(*pos);
+            velocities.swap(*vel);
+            forces.swap(*f);
+        };
+    }
     /**
      * Get the current periodic box vectors.
      *
@@ -293,6 +430,38 @@ public:
     virtual void computePositions(ContextImpl& context) = 0;
 };
 
+/**
+ * This kernel is invoked by LocalEnergyMinimizer to perform an energy minimization entirely
+ * within the Platform, without transferring positions and forces to the host on every step.
+ * Platforms are not required to provide it.
+ */
+class MinimizeKernel : public KernelImpl {
+public:
+    static std::string Name() {
+        return "Minimize";
+    }
+    MinimizeKernel(std::string name, const Platform& platform) : KernelImpl(name, platform) {
+    }
+    /**
+     * Initialize the kernel.
+     *
+     * @param system     the System this kernel will be applied to
+     */
+    virtual void initialize(const System& system) = 0;
+    /**
+     * Search for a new arrangement of particles which represents a local minimum of the potential
+     * energy.  The arguments have the same meaning as for LocalEnergyMinimizer::minimize().
+     *
+     * @param context        the context in which to execute this kernel
+     * @param tolerance      the convergence criterion for the minimization
+     * @param maxIterations  the maximum number of iterations to perform, or 0 for no limit
+     * @return true if the minimization was completed.  If this returns false, the kernel was unable to
+     * continue (for example because forces became too large to be computed reliably) and the caller
+     * should finish the minimization by other means, starting from the current positions.
+     */
+    virtual bool execute(ContextImpl& context, double tolerance, int maxIterations) = 0;
+};
+
 /**
  * This kernel is invoked by HarmonicBondForce to calculate the forces acting on the system and the energy of the system.
  */
@@ -1228,6 +1397,79 @@ public:
     virtual double computeKineticEnergy(ContextImpl& context, const LangevinMiddleIntegrator& integrator) = 0;
 };
 
+/**
+ * This kernel is invoked by MTSLangevinIntegrator to take one time step.  The integrator decides which
+ * forces to evaluate and when, and calls the primitive operations defined by this kernel to update the
+ * positions and velocities.
+ */
+class IntegrateMTSLangevinStepKernel : public KernelImpl {
+public:
+    static std::string Name() {
+        return "IntegrateMTSLangevinStep";
+    }
+    IntegrateMTSLangevinStepKernel(std::string name, const Platform& platform) : KernelImpl(name, platform) {
+    }
+    /**
+     * Initialize the kernel.
+     * 
+     * @param system     the System this kernel will be applied to
+     * @param integrator the MTSLangevinIntegrator this kernel will be used for
+     */
+    virtual void initialize(const System& system, const MTSLangevinIntegrator& integrator) = 0;
+    /**
+     * Update the velocities based on the forces currently stored in the context.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     * @param dt         the time interval to apply the forces over
+     */
+    virtual void kick(ContextImpl& context, const MTSLangevinIntegrator& integrator, double dt) = 0;
+    /**
+     * Perform one substep of the innermost (fastest) level.  This applies a kick with the forces
+     * currently stored in the context, then a BAOAB drift, thermalize, drift sequence, and finally
+     * applies constraints and updates the positions of virtual sites.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     * @param kickDt     the time interval to apply the forces over
+     * @param dt         the size of the substep
+     */
+    virtual void innerStep(ContextImpl& context, const MTSLangevinIntegrator& integrator, double kickDt, double dt) = 0;
+    /**
+     * Save a copy of the forces currently stored in the context, so they can later be restored
+     * without recomputing them.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     * @param level      the index of the level (in the integrator's sorted list of groups) the forces belong to
+     */
+    virtual void saveForces(ContextImpl& context, const MTSLangevinIntegrator& integrator, int level) = 0;
+    /**
+     * Copy forces previously saved with saveForces() back into the context.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     * @param level      the index of the level (in the integrator's sorted list of groups) the forces belong to
+     */
+    virtual void restoreForces(ContextImpl& context, const MTSLangevinIntegrator& integrator, int level) = 0;
+    /**
+     * Complete a time step.  This applies velocity constraints and advances the time and step count.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     * @return false if any forces that were computed earlier are no longer valid (for example, because
+     * atoms were reordered), true otherwise
+     */
+    virtual bool finishStep(ContextImpl& context, const MTSLangevinIntegrator& integrator) = 0;
+    /**
+     * Compute the kinetic energy.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     */
+    virtual double computeKineticEnergy(ContextImpl& context, const MTSLangevinIntegrator& integrator) = 0;
+};
+
 /**
  * This kernel is invoked by BrownianIntegrator to take one time step.
  */
@@ -1287,6 +1529,18 @@ public:
      * @return the size of the step that was taken
      */
     virtual double execute(ContextImpl& context, const VariableLangevinIntegrator& integrator, double maxTime) = 0;
+    /**
+     * Get the size of the last step that was taken.  A platform that selects the step size on the
+     * device may return the size of an earlier step from execute() when maxTime is infinite, so it
+     * does not need to wait for the device on every step.  It then overrides this to return the
+     * exact value, which is requested once all the steps in a call to step() have been taken.
+     *
+     * @param context    the context in which to execute this kernel
+     * @param stepSize   the value most recently returned by execute()
+     */
+    virtual double getLastStepSize(ContextImpl& context, double stepSize) {
+        return stepSize;
+    }
     /**
      * Compute the kinetic energy.
      * 
@@ -1322,6 +1576,18 @@ public:
      * @return the size of the step that was taken
      */
     virtual double execute(ContextImpl& context, const VariableVerletIntegrator& integrator, double maxTime) = 0;
+    /**
+     * Get the size of the last step that was taken.  A platform that selects the step size on the
+     * device may return the size of an earlier step from execute() when maxTime is infinite, so it
+     * does not need to wait for the device on every step.  It then overrides this to return the
+     * exact value, which is requested once all the steps in a call to step() have been taken.
+     *
+     * @param context    the context in which to execute this kernel
+     * @param stepSize   the value most recently returned by execute()
+     */
+    virtual double getLastStepSize(ContextImpl& context, double stepSize) {
+        return stepSize;
+    }
     /**
      * Compute the kinetic energy.
      * 
@@ -1519,6 +1785,53 @@ public:
     virtual void computeKineticEnergy(ContextImpl& context, std::vector<double>& ke) = 0;
 };
 
+/**
+ * This kernel is invoked by NCMCDriver to save and restore the state of a Context around a switching
+ * move, and to accumulate the protocol work of the move.  Platforms that run on a device should keep
+ * the work on the device, so that it only needs to be transferred once at the end of the move.
+ */
+class CalcProtocolWorkKernel : public KernelImpl {
+public:
+    static std::string Name() {
+        return "CalcProtocolWork";
+    }
+    CalcProtocolWorkKernel(std::string name, const Platform& platform) : KernelImpl(name, platform) {
+    }
+    /**
+     * Initialize the kernel.
+     *
+     * @param system     the System this kernel will be applied to
+     */
+    virtual void initialize(const System& system) = 0;
+    /**
+     * Save the positions and velocities at the start of a move, and set the accumulated work to zero.
+     *
+     * @param context    the context in which to execute this kernel
+     */
+    virtual void beginMove(ContextImpl& context) = 0;
+    /**
+     * Restore the positions and velocities to what they were when beginMove() was last called.
+     *
+     * @param context    the context in which to execute this kernel
+     */
+    virtual void restoreState(ContextImpl& context) = 0;
+    /**
+     * Compute the potential energy of a set of force groups and add it, multiplied by a scale factor,
+     * to the accumulated work.
+     *
+     * @param context    the context in which to execute this kernel
+     * @param scale      the factor to multiply the energy by
+     * @param groups     a set of bit flags for which force groups to include
+     */
+    virtual void addEnergy(ContextImpl& context, double scale, int groups) = 0;
+    /**
+     * Get the work accumulated since beginMove() was last called.
+     *
+     * @param context    the context in which to execute this kernel
+     */
+    virtual double getWork(ContextImpl& context) = 0;
+};
+
 /**
  * This kernel is invoked to remove center of mass motion from the system.
  */
@@ -1594,6 +1907,22 @@ public:
      * @param nz      the number of grid points along the Z axis
      */
     virtual void getPMEParameters(double& alpha, int& nx, int& ny, int& nz) const = 0;
+    /**
+     * Set whether to record the time spent in each phase of the calculation.  Implementations that
+     * do not support profiling ignore this.
+     */
+    virtual void setProfilingEnabled(bool enabled) {
+    }
+    /**
+     * Add the times that have been recorded for each phase of the calculation to a set of timings, then
+     * discard them.  This should only be called between finishComputation() and the next beginComputation().
+     * Implementations that do not support profiling leave the timings unchanged.
+     *
+     * @param timings   maps each phase name to the number of times it was executed and the total time
+     *                  in microseconds.  The recorded times are added to it.
+     */
+    virtual void collectProfilingTimes(std::map<std::string, std::pair<int, double> >& timings) {
+    }
 };
 
 /**
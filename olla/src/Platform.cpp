@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2008-2024 Stanford University and the Authors.      *
+ * Portions copyright (c) 2008-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -44,6 +44,8 @@
 #include <dirent.h>
 #include <cstdlib>
 #endif
+#include <fstream>
+#include <mutex>
 #include <sstream>
 #include <set>
 #include <algorithm>
@@ -58,6 +60,47 @@ static bool stringLengthComparator(string i, string j) {
   return (i.size() < j.size());
 }
 
+/**
+ * A plugin library whose loading has been deferred, along with the names of the Platforms
+ * listed in its manifest.
+ */
+struct PendingPlugin {
+    string file;
+    set<string> platforms;
+};
+
+static vector<PendingPlugin>& getPendingPlugins() {
+    static vector<PendingPlugin> pending;
+    return pending;
+}
+
+static recursive_mutex& getPluginMutex() {
+    static recursive_mutex mutex;
+    return mutex;
+}
+
+// While plugins are being initialized they query the list of Platforms to decide where to
+// register kernel factories.  That must not trigger loading of deferred plugins.
+
+static int pluginInitializationDepth = 0;
+
+// When deferred plugins add new Platforms, plugins that were initialized earlier get to register
+// kernel factories on them.  While that happens, only the new Platforms are visible.
+
+static int firstVisiblePlatform = 0;
+
+class PluginInitializationGuard {
+public:
+    PluginInitializationGuard() {
+        pluginInitializationDepth++;
+    }
+    ~PluginInitializationGuard() {
+        pluginInitializationDepth--;
+    }
+};
+
+static const string manifestSuffix = ".platforms";
+
 static int registerPlatforms() {
 
     // Register the Platforms built into the main library.  This should eventually be moved elsewhere.
@@ -89,6 +132,21 @@ void Platform::setPropertyValue(Context& context, const string& property, const
     throw OpenMMException("setPropertyValue: Illegal property name");
 }
 
+map<string, pair<int, double> > Platform::getKernelTimings(Context& context) const {
+    return map<string, pair<int, double> >();
+}
+
+void Platform::resetKernelTimings(Context& context) const {
+}
+
+map<string, map<string, long long> > Platform::getMemoryUsage(Context& context) const {
+    return map<string, map<string, long long> >();
+}
+
+void Platform::getDeviceArray(Context& context, const string& name, long long& pointer, vector<int>& shape, string& type, int& deviceIndex) const {
+    throw OpenMMException("getDeviceArray: This Platform does not store arrays on a GPU");
+}
+
 const string& Platform::getPropertyDefaultValue(const string& property) const {
     string propertyName = property;
     if (deprecatedPropertyReplacements.find(property) != deprecatedPropertyReplacements.end())
@@ -153,12 +211,14 @@ void Platform::registerPlatform(Platform* platform) {
 }
 
 int Platform::getNumPlatforms() {
-    return getPlatforms().size();
+    loadPendingPlugins("");
+    return getPlatforms().size()-firstVisiblePlatform;
 }
 
 Platform& Platform::getPlatform(int index) {
+    loadPendingPlugins("");
     if (index >= 0 && index < getNumPlatforms()) {
-        return *getPlatforms()[index];
+        return *getPlatforms()[firstVisiblePlatform+index];
     }
     throw OpenMMException("Invalid platform index");
 }
@@ -172,6 +232,14 @@ std::vector<std::string> Platform::getPluginLoadFailures() {
 }
 
 Platform& Platform::getPlatformByName(const string& name) {
+    // First load only the deferred plugins that are needed for this Platform.  If it still
+    // is not found, fall back to loading everything.
+
+    loadPendingPlugins(name);
+    vector<Platform*>& platforms = getPlatforms();
+    for (int i = firstVisiblePlatform; i < platforms.size(); i++)
+        if (platforms[i]->getName() == name)
+            return *platforms[i];
     for (int i = 0; i < getNumPlatforms(); i++)
         if (getPlatform(i).getName() == name)
             return getPlatform(i);
@@ -179,6 +247,7 @@ Platform& Platform::getPlatformByName(const string& name) {
 }
 
 Platform& Platform::findPlatform(const vector<string>& kernelNames) {
+    loadPendingPlugins("");
     Platform* best = 0;
     vector<Platform*>& platforms = getPlatforms();
     double speed = 0.0;
@@ -207,19 +276,8 @@ static HMODULE loadOneLibrary(const string& file) {
     return handle;
 }
 
-static void initializePlugins(vector<HMODULE>& plugins) {
-    for (auto plugin : plugins) {
-        void (*init)();
-        *(void **)(&init) = (void *) GetProcAddress(plugin, "registerPlatforms");
-        if (init != NULL)
-            (*init)();
-    }
-    for (auto plugin : plugins) {
-        void (*init)();
-        *(void **)(&init) = (void *) GetProcAddress(plugin, "registerKernelFactories");
-        if (init != NULL)
-            (*init)();
-    }
+static void* findPluginFunction(HMODULE plugin, const char* name) {
+    return (void*) GetProcAddress(plugin, name);
 }
 #else
 static void* loadOneLibrary(const string& file) {
@@ -238,30 +296,93 @@ static void* loadOneLibrary(const string& file) {
 #endif
 }
 
-static void initializePlugins(vector<void*>& plugins) {
-#ifndef __PNACL__
-    for (auto plugin : plugins) {
-        void (*init)();
-        *(void **)(&init) = dlsym(plugin, "registerPlatforms");
-        if (init != NULL)
-            (*init)();
-    }
-    for (auto plugin : plugins) {
-        void (*init)();
-        *(void **)(&init) = dlsym(plugin, "registerKernelFactories");
-        if (init != NULL)
-            (*init)();
-    }
+static void* findPluginFunction(void* plugin, const char* name) {
+#ifdef __PNACL__
+    return NULL;
+#else
+    return dlsym(plugin, name);
 #endif
 }
 #endif
 
-void Platform::loadPluginLibrary(const string& file) {
 #ifdef WIN32
-    vector<HMODULE> plugins;
+typedef HMODULE PluginHandle;
 #else
-    vector<void*> plugins;
+typedef void* PluginHandle;
 #endif
+
+static vector<PluginHandle>& getInitializedPlugins() {
+    static vector<PluginHandle> initialized;
+    return initialized;
+}
+
+static void callPluginFunction(PluginHandle plugin, const char* name) {
+    void (*init)();
+    *(void **)(&init) = findPluginFunction(plugin, name);
+    if (init != NULL)
+        (*init)();
+}
+
+static void initializePlugins(vector<PluginHandle>& plugins) {
+    PluginInitializationGuard guard;
+    vector<PluginHandle>& initialized = getInitializedPlugins();
+    int firstNewPlatform = Platform::getNumPlatforms();
+    for (auto plugin : plugins)
+        callPluginFunction(plugin, "registerPlatforms");
+
+    // Let plugins that were initialized earlier register kernel factories on any new Platforms.
+    // This happens first so the new plugins can override them.
+
+    if (Platform::getNumPlatforms() > firstNewPlatform) {
+        firstVisiblePlatform = firstNewPlatform;
+        try {
+            for (auto plugin : initialized)
+                callPluginFunction(plugin, "registerKernelFactories");
+        }
+        catch (...) {
+            firstVisiblePlatform = 0;
+            throw;
+        }
+        firstVisiblePlatform = 0;
+    }
+    for (auto plugin : plugins)
+        callPluginFunction(plugin, "registerKernelFactories");
+    initialized.insert(initialized.end(), plugins.begin(), plugins.end());
+}
+
+void Platform::loadPendingPlugins(const string& platformName) {
+    if (pluginInitializationDepth > 0)
+        return;
+    lock_guard<recursive_mutex> lock(getPluginMutex());
+    vector<PendingPlugin>& pending = getPendingPlugins();
+    if (pending.size() == 0)
+        return;
+    vector<bool> selected(pending.size(), platformName.empty());
+    for (int i = 0; i < pending.size(); i++)
+        if (pending[i].platforms.find(platformName) != pending[i].platforms.end())
+            selected[i] = true;
+    vector<string> files;
+    vector<PendingPlugin> remaining;
+    for (int i = 0; i < pending.size(); i++) {
+        if (selected[i])
+            files.push_back(pending[i].file);
+        else
+            remaining.push_back(pending[i]);
+    }
+    pending = remaining;
+    vector<PluginHandle> plugins;
+    for (auto& file : files) {
+        try {
+            plugins.push_back(loadOneLibrary(file));
+        } catch (OpenMMException& ex) {
+            pluginLoadFailures.push_back(ex.what());
+        }
+    }
+    initializePlugins(plugins);
+}
+
+void Platform::loadPluginLibrary(const string& file) {
+    vector<PluginHandle> plugins;
     plugins.push_back(loadOneLibrary(file));
     initializePlugins(plugins);
 }
@@ -311,7 +432,24 @@ vector<string> Platform::loadPluginsFromDirectory(const string& directory) {
     pluginLoadFailures.resize(0);
     std::sort (files.begin(), files.end(), stringLengthComparator);
 
+    lock_guard<recursive_mutex> lock(getPluginMutex());
     for (unsigned int i = 0; i < files.size(); ++i) {
+        // Manifests are not libraries.  A library that has one is only loaded once a Platform
+        // listed in it is needed.
+
+        if (files[i].size() > manifestSuffix.size() && files[i].compare(files[i].size()-manifestSuffix.size(), manifestSuffix.size(), manifestSuffix) == 0)
+            continue;
+        ifstream manifest(files[i]+manifestSuffix);
+        if (manifest.is_open()) {
+            PendingPlugin plugin;
+            plugin.file = files[i];
+            string name;
+            while (manifest >> name)
+                plugin.platforms.insert(name);
+            getPendingPlugins().push_back(plugin);
+            loadedLibraries.push_back(files[i]);
+            continue;
+        }
         try {
             plugins.push_back(loadOneLibrary(files[i]));
             loadedLibraries.push_back(files[i]);
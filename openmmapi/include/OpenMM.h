@@ -33,6 +33,7 @@
  * -------------------------------------------------------------------------- */
 
 #include "openmm/AndersenThermostat.h"
+#include "openmm/BatchEnergyMinimizer.h"
 #include "openmm/BrownianIntegrator.h"
 #include "openmm/CMAPTorsionForce.h"
 #include "openmm/CMMotionRemover.h"
@@ -56,23 +57,35 @@
 #include "openmm/GBSAOBCForce.h"
 #include "openmm/HarmonicAngleForce.h"
 #include "openmm/HarmonicBondForce.h"
+#include "openmm/HydrogenMassRepartitioner.h"
 #include "openmm/Integrator.h"
 #include "openmm/LangevinIntegrator.h"
 #include "openmm/LangevinMiddleIntegrator.h"
+#include "openmm/MTSLangevinIntegrator.h"
 #include "openmm/LocalEnergyMinimizer.h"
 #include "openmm/MonteCarloAnisotropicBarostat.h"
 #include "openmm/MonteCarloBarostat.h"
 #include "openmm/MonteCarloFlexibleBarostat.h"
 #include "openmm/MonteCarloMembraneBarostat.h"
+#include "openmm/NCMCDriver.h"
 #include "openmm/NonbondedForce.h"
+#include "openmm/ObservableRecorder.h"
+#include "openmm/OffloadForce.h"
 #include "openmm/Context.h"
 #include "openmm/OpenMMException.h"
 #include "openmm/PeriodicTorsionForce.h"
+#include "openmm/PMETuner.h"
+#include "openmm/PlatformSelector.h"
 #include "openmm/RBTorsionForce.h"
+#include "openmm/ReplicaExchange.h"
 #include "openmm/RMSDForce.h"
+#include "openmm/SharedMemoryExporter.h"
+#include "openmm/SimulatedTemperingDriver.h"
 #include "openmm/State.h"
 #include "openmm/System.h"
+#include "openmm/SystemReplicator.h"
 #include "openmm/TabulatedFunction.h"
+#include "openmm/TrajectoryWriter.h"
 #include "openmm/Units.h"
 #include "openmm/VariableLangevinIntegrator.h"
 #include "openmm/VariableVerletIntegrator.h"
@@ -82,6 +95,7 @@
 #include "openmm/NoseHooverChain.h"
 #include "openmm/VirtualSite.h"
 #include "openmm/Platform.h"
+#include "openmm/serialization/BinarySerializer.h"
 #include "openmm/serialization/XmlSerializer.h"
 #include "openmm/ATMForce.h"
 
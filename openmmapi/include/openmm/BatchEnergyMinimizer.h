@@ -0,0 +1,159 @@
+#ifndef OPENMM_BATCHENERGYMINIMIZER_H_
+#define OPENMM_BATCHENERGYMINIMIZER_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "Context.h"
+#include "System.h"
+#include "VerletIntegrator.h"
+#include "Vec3.h"
+#include "internal/windowsExport.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace OpenMM {
+
+class Platform;
+
+/**
+ * This class minimizes the energies of many conformers of the same System, such as a set of
+ * docked ligand poses in a binding pocket.  Calling LocalEnergyMinimizer on each conformer
+ * separately leaves a GPU almost idle when the System is small.  Instead, this class uses
+ * SystemReplicator to pack a batch of conformers into one Context, so the forces on all of
+ * them are computed together.
+ *
+ * Each conformer is minimized independently with its own L-BFGS iterations, and the
+ * conformers advance in lockstep: every force evaluation computes the forces on all of them
+ * at once.  A conformer stops moving as soon as it has converged or reached the maximum
+ * number of iterations, while the others continue.  Because a State only reports the total
+ * energy of all conformers, the line search uses only the forces.  It looks for a step
+ * along which the directional derivative of the energy has been sufficiently reduced.  The
+ * final energy of each conformer is evaluated separately.
+ *
+ * The System must satisfy the same requirements as for SystemReplicator.  In particular,
+ * nonbonded forces must use a non-periodic cutoff that is smaller than the spacing between
+ * conformers.  Constraints are not supported.
+ */
+
+class OPENMM_EXPORT BatchEnergyMinimizer {
+public:
+    /**
+     * Create a BatchEnergyMinimizer.
+     *
+     * @param system      the System to minimize.  It must not be modified or deleted while the
+     *                    BatchEnergyMinimizer exists.
+     * @param batchSize   the number of conformers to minimize at once
+     * @param spacing     the distance between adjacent conformers in the combined System, in nm.
+     *                    It must be larger than the nonbonded cutoff plus the size of a conformer.
+     * @param platform    the Platform to create the Context for
+     * @param properties  Platform-specific properties to create the Context with
+     */
+    BatchEnergyMinimizer(const System& system, int batchSize, double spacing, Platform& platform,
+            const std::map<std::string, std::string>& properties=std::map<std::string, std::string>());
+    ~BatchEnergyMinimizer();
+    /**
+     * Get the number of conformers that are minimized at once.
+     */
+    int getBatchSize() const {
+        return batchSize;
+    }
+    /**
+     * Get the Context for the combined System containing every conformer of a batch.  You can use it to set
+     * global parameters.  Its positions are overwritten by minimize().
+     */
+    Context& getContext() {
+        return *context;
+    }
+    /**
+     * Minimize the energy of a set of conformers.  Any number of conformers may be given.  They are processed
+     * in batches of getBatchSize().  After this returns, call getPositions(), getEnergies(), getIterations(),
+     * and getConverged() to retrieve the results.
+     *
+     * @param positions      the positions of every particle in each conformer
+     * @param tolerance      this specifies how precisely the energy minimum must be located.  A conformer has
+     *                       converged once the root-mean-square value of its force components reaches this
+     *                       tolerance (in kJ/mol/nm).  The default value is 10.
+     * @param maxIterations  the maximum number of iterations to perform for each conformer.  If this is 0,
+     *                       minimization continues until every conformer has converged.  The default value is 0.
+     */
+    void minimize(const std::vector<std::vector<Vec3> >& positions, double tolerance=10, int maxIterations=0);
+    /**
+     * Get the minimized positions of each conformer from the most recent call to minimize().
+     */
+    const std::vector<std::vector<Vec3> >& getPositions() const {
+        return minimizedPositions;
+    }
+    /**
+     * Get the potential energy of each minimized conformer from the most recent call to minimize(), in kJ/mol.
+     */
+    const std::vector<double>& getEnergies() const {
+        return energies;
+    }
+    /**
+     * Get the number of L-BFGS iterations that were performed for each conformer in the most recent call to
+     * minimize().
+     */
+    const std::vector<int>& getIterations() const {
+        return iterations;
+    }
+    /**
+     * Get which conformers converged in the most recent call to minimize().  Element i is 1 if conformer i
+     * reached the tolerance, or 0 if it stopped because it reached the maximum number of iterations or the
+     * line search failed.
+     */
+    const std::vector<int>& getConverged() const {
+        return converged;
+    }
+private:
+    class ConformerData;
+    void minimizeBatch(int firstConformer, const std::vector<std::vector<Vec3> >& positions, double tolerance, int maxIterations);
+    void computeGradients(std::vector<ConformerData>& conformers, bool trial);
+    /**
+     * Compute the energy of a single conformer at the point x+alpha*d.
+     */
+    double computeEnergy(const std::vector<double>& x, double alpha=0.0, const std::vector<double>& d=std::vector<double>());
+    const System& system;
+    int batchSize;
+    double spacing;
+    System* combinedSystem;
+    VerletIntegrator integrator, energyIntegrator;
+    Context* context;
+    Context* energyContext;
+    std::vector<std::vector<Vec3> > minimizedPositions;
+    std::vector<double> energies;
+    std::vector<int> iterations, converged;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_BATCHENERGYMINIMIZER_H_*/
@@ -9,7 +9,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2008-2021 Stanford University and the Authors.      *
+ * Portions copyright (c) 2008-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -35,9 +35,11 @@
 #include "Integrator.h"
 #include "State.h"
 #include "System.h"
+#include <future>
 #include <iosfwd>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 #include "internal/windowsExport.h"
 #include "internal/OSRngSeed.h"
@@ -125,6 +127,79 @@ public:
      * and energies.  Group i will be included if (groups&(1<<i)) != 0.  The default value includes all groups.
      */
     State getState(int types, bool enforcePeriodicBox=false, int groups=0xFFFFFFFF) const;
+    /**
+     * Get a State object recording the current state information for a subset of the particles.
+     * This is identical to getState(), except that positions, velocities, and forces are only
+     * retrieved for the specified particles.  Element i of each array in the returned State
+     * corresponds to particle particles[i].  When you only need a small number of particles,
+     * this is much faster than retrieving all of them.  Energies are still those of the entire System.
+     *
+     * @param types the set of data types which should be stored in the State object.  This
+     * should be a union of DataType values, e.g. (State::Positions | State::Velocities).
+     * @param particles the indices of the particles to include in the State
+     * @param enforcePeriodicBox if false, the position of each particle will be whatever position
+     * is stored in the Context, regardless of periodic boundary conditions.  If true, the requested
+     * particles that belong to each molecule are translated together so their center lies in the
+     * same periodic box.
+     * @param groups a set of bit flags for which force groups to include when computing forces
+     * and energies.  Group i will be included if (groups&(1<<i)) != 0.  The default value includes all groups.
+     */
+    State getState(int types, const std::vector<int>& particles, bool enforcePeriodicBox=false, int groups=0xFFFFFFFF) const;
+    /**
+     * Get a State object recording the current state information stored in this context, without
+     * waiting for positions, velocities, and forces to be transferred from the device.  This is
+     * identical to getState(), except that it returns as soon as the data has been captured.  The
+     * transfer and the construction of the State take place in the background while you continue
+     * to use the Context, for example by calling step() on the Integrator.  The returned State
+     * reflects the Context at the time of this call.
+     *
+     * Energies and parameter derivatives are computed and retrieved before this returns, so
+     * requesting them still requires waiting for the calculation to finish.  The Context must not
+     * be deleted until the State has been retrieved from the future.
+     *
+     * @param types the set of data types which should be stored in the State object.  This
+     * should be a union of DataType values, e.g. (State::Positions | State::Velocities).
+     * @param enforcePeriodicBox if false, the position of each particle will be whatever position
+     * is stored in the Context, regardless of periodic boundary conditions.  If true, particle
+     * positions will be translated so the center of every molecule lies in the same periodic box.
+     * @param groups a set of bit flags for which force groups to include when computing forces
+     * and energies.  Group i will be included if (groups&(1<<i)) != 0.  The default value includes all groups.
+     * @return a future that provides the State once it is available
+     */
+    std::future<State> getStateAsync(int types, bool enforcePeriodicBox=false, int groups=0xFFFFFFFF) const;
+    /**
+     * Get the positions of all particles, rounded to a fixed precision.  This is intended for writing
+     * compressed trajectory formats such as XTC, which store every coordinate as an integer multiple of
+     * a precision.  Because only the rounded values are needed, platforms that store positions on a GPU
+     * can pack them into a compact fixed point representation before transferring them, so far less
+     * data must be copied than with getState().  Each coordinate is guaranteed to be within precision/2
+     * of the position stored in the Context.  Periodic boundary conditions are not applied.
+     *
+     * @param precision  the precision to which coordinates are rounded, in nm.  For example, 0.001
+     *                   corresponds to the default precision of XTC files.
+     * @return the particle positions
+     */
+    std::vector<Vec3> getQuantizedPositions(double precision) const;
+    /**
+     * Compute the potential energy of many sets of particle positions (for example, the frames of a
+     * trajectory) in a single call.  This is much faster than calling setPositions() and getState()
+     * for each frame separately, especially from Python, because it avoids the per-call overhead.
+     * The positions and periodic box vectors of the Context are restored before this returns.
+     *
+     * @param positions   the positions of every frame.  This must contain numFrames*numParticles
+     *                    elements, with the positions for frame i starting at element i*numParticles.
+     * @param boxVectors  the periodic box vectors of every frame.  This must either be empty, in which
+     *                    case the current box vectors are used for all frames, or contain 3*numFrames
+     *                    elements, with the three vectors for frame i starting at element 3*i.
+     * @param groups      the force groups to compute energies for.  Each element is a set of bit flags,
+     *                    as for getState(), and a separate energy is computed for each one.  If this is
+     *                    empty (the default), a single energy is computed for each frame including all
+     *                    groups.
+     * @return the potential energies.  Element i*numGroups+j contains the energy of frame i for
+     * groups[j], where numGroups is the number of elements in groups (or 1 if it is empty).
+     */
+    std::vector<double> computeFrameEnergies(const std::vector<Vec3>& positions, const std::vector<Vec3>& boxVectors=std::vector<Vec3>(),
+                                             const std::vector<int>& groups=std::vector<int>());
     /**
      * Copy information from a State object into this Context.  This restores the Context to
      * approximately the same state it was in when the State was created.  If the State does not include
@@ -228,6 +303,27 @@ public:
      * constraints.
      */
     void computeVirtualSites();
+    /**
+     * Start integrating time steps in the background.  This is equivalent to calling step() on
+     * the Integrator, except that it returns immediately.  The steps are taken on a separate
+     * thread while you do other work, such as processing a State you retrieved earlier.  Call
+     * waitForSteps() to block until they have finished.
+     *
+     * While steps are in progress, every method of this Context that queries or modifies its
+     * state first waits for them to finish, so it always sees the Context as it is after the
+     * last step.  The Integrator is not protected in this way.  You must not call any of its
+     * methods, or delete it, until waitForSteps() has returned.  If steps from a previous call
+     * are still in progress, this waits for them before starting the new ones.
+     *
+     * @param steps   the number of time steps to take
+     */
+    void stepAsync(int steps);
+    /**
+     * Wait until all steps started by stepAsync() have finished.  If an exception was thrown
+     * while taking them, it is rethrown here.  If no steps are in progress, this returns
+     * immediately.
+     */
+    void waitForSteps();
     /**
      * When a Context is created, it caches information about the System being simulated
      * and the Force objects contained in it.  This means that, if the System or Forces are then
@@ -252,9 +348,30 @@ public:
      * Create a checkpoint recording the current state of the Context.  This should be treated
      * as an opaque block of binary data.  See loadCheckpoint() for more details.
      * 
+     * Checkpoints for large systems can be big.  If compress is true, the checkpoint is
+     * compressed with zlib before being written.  loadCheckpoint() recognizes compressed
+     * checkpoints automatically.  Compression is only available if OpenMM was built with
+     * zlib support.  Otherwise, requesting it throws an exception.
+     * 
      * @param stream    an output stream the checkpoint data should be written to
+     * @param compress  whether to compress the checkpoint data
      */
-    void createCheckpoint(std::ostream& stream);
+    void createCheckpoint(std::ostream& stream, bool compress=false);
+    /**
+     * Create a checkpoint in the background.  This is similar to createCheckpoint(), but it
+     * only blocks long enough to copy the state of the Context into host memory.  Compressing
+     * the data and writing it to the stream are done on a separate thread, so you can continue
+     * to simulate while that happens.
+     * 
+     * The stream must remain valid until the returned future has completed.  If an error
+     * occurs while writing, it is reported by throwing an exception from the future's get()
+     * method.
+     * 
+     * @param stream    an output stream the checkpoint data should be written to
+     * @param compress  whether to compress the checkpoint data
+     * @return a future that completes once the checkpoint has been written to the stream
+     */
+    std::future<void> createCheckpointAsync(std::ostream& stream, bool compress=true);
     /**
      * Load a checkpoint that was written by createCheckpoint().
      * 
@@ -284,12 +401,74 @@ public:
      * belong to exactly one molecule.
      */
     const std::vector<std::vector<int> >& getMolecules() const;
+    /**
+     * Get the execution times that have been recorded for the kernels run by this Context.  Profiling
+     * must first be enabled when the Context is created, usually by setting the Platform-specific
+     * property "EnableProfiling" to "true".  If the Platform does not support profiling or it is
+     * not enabled, this returns an empty map.
+     *
+     * Each key is the name of a kernel, or of a set of force groups for the time spent computing
+     * them.  The corresponding value contains the number of times it was executed and the total device
+     * time in microseconds.  Calling this blocks until all queued work has completed.
+     */
+    std::map<std::string, std::pair<int, double> > getKernelTimings();
+    /**
+     * Discard all kernel execution times that have been recorded so far.
+     */
+    void resetKernelTimings();
+    /**
+     * Get the amount of device memory used by the arrays this Context has allocated.  Each key of the
+     * outer map is the owner of some arrays: the name of the Force they were created for, or "Context"
+     * for arrays that are not associated with any Force.  The inner map gives the number of bytes used
+     * by the arrays with each name.  If the Platform does not track memory usage (for example the
+     * Reference and CPU Platforms), this returns an empty map.
+     */
+    std::map<std::string, std::map<std::string, long long> > getMemoryUsage();
+    /**
+     * Get direct access to one of the arrays this Context stores on a GPU, so it can be analyzed by
+     * other libraries (for example through __cuda_array_interface__ in Python) without copying it
+     * to the host.  This blocks until all queued work has completed, so the contents are up to date
+     * when it returns.  The array is owned by the Context and must be treated as read-only.  It stays
+     * valid until the Context next does anything (such as taking a step or reordering atoms) and
+     * may be reallocated after that.  The following arrays are available:
+     *
+     * <ul>
+     * <li>"posq": the position (xyz) and charge (w) of each atom, with shape (paddedNumAtoms, 4)</li>
+     * <li>"posqCorrection": the correction to each position, with shape (paddedNumAtoms, 4).  This
+     * only exists in mixed precision mode.</li>
+     * <li>"velm": the velocity (xyz) and inverse mass (w) of each atom, with shape (paddedNumAtoms, 4)</li>
+     * <li>"force": the most recently computed force on each atom as 64 bit fixed point values with a scale of 2^32, with
+     * shape (3, paddedNumAtoms).  All x components come first, then all y, then all z.</li>
+     * <li>"atomIndex": the index within the System of the atom stored in each element, with shape (paddedNumAtoms)</li>
+     * </ul>
+     *
+     * Atoms are stored in a different order from the System, and the order changes as the
+     * simulation runs.  Use "atomIndex" to map them back.  Elements beyond the number of atoms are
+     * padding and should be ignored.  If the Platform does not store arrays on a GPU (for example
+     * the Reference and CPU Platforms), this throws an exception.
+     *
+     * @param name              the name of the array to get
+     * @param[out] pointer      the device address of the array
+     * @param[out] shape        the number of elements along each dimension of the array
+     * @param[out] type         the element type, in the format used by the numpy array interface (for example "<f4")
+     * @param[out] deviceIndex  the index of the device the array is stored on
+     */
+    void getDeviceArray(const std::string& name, long long& pointer, std::vector<int>& shape, std::string& type, int& deviceIndex);
 private:
     friend class ContextImpl;
     friend class Force;
     friend class ForceImpl;
+    friend class LocalEnergyMinimizer;
+    friend class NCMCDriver;
     friend class Platform;
+    friend class ReplicaExchange;
+    friend class SimulatedTemperingDriver;
     Context(const System& system, Integrator& integrator, ContextImpl& linked);
+    /**
+     * Create a StateBuilder containing everything requested by getState() except positions,
+     * velocities, and forces.  If forces or energies are requested, this also computes them.
+     */
+    State::StateBuilder createStateBuilder(int types, int groups) const;
     ContextImpl& getImpl();
     const ContextImpl& getImpl() const;
     ContextImpl* impl;
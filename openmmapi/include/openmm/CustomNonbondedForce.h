@@ -415,6 +415,16 @@ public:
      * @return the index of the exclusion that was added
      */
     int addExclusion(int particle1, int particle2);
+    /**
+     * Add many exclusions at once.  This is equivalent to calling addExclusion() once for each element of
+     * the arrays, which must have the same length, but it is much faster when building large Systems
+     * from Python.
+     *
+     * @param particle1  the index of the first particle in each pair
+     * @param particle2  the index of the second particle in each pair
+     * @return the index of the first exclusion that was added
+     */
+    int addExclusions(const std::vector<int>& particle1, const std::vector<int>& particle2);
     /**
      * Get the particles in a pair whose interaction should be excluded.
      *
@@ -558,6 +568,29 @@ public:
      * the data range) must not be changed.
      */
     void updateParametersInContext(Context& context);
+    /**
+     * Compute how the energy of this force would change if some particles were moved to new positions.  This is
+     * intended for Monte Carlo displacement moves.  Only interactions involving the moved particles are evaluated,
+     * so it is much faster than setting the positions and calling getState().  The calculation is done on the host
+     * and does not modify the Context.
+     *
+     * @param context       the Context in which to evaluate the energy change
+     * @param particles     the indices of the particles to move
+     * @param newPositions  the new positions of the particles, in the same order as particles
+     * @return the energy after the move minus the energy before it, in kJ/mol
+     */
+    double computeEnergyChange(Context& context, const std::vector<int>& particles, const std::vector<Vec3>& newPositions) const;
+    /**
+     * Compute the part of the energy of this force that involves a set of particles, using the current positions
+     * and global parameters in a Context.  This equals the change in energy if all interactions involving the
+     * particles were switched off, so it is useful for Monte Carlo insertion and deletion moves.  The long range
+     * correction is not included.  The calculation is done on the host and does not modify the Context.
+     *
+     * @param context     the Context in which to evaluate the energy
+     * @param particles   the indices of the particles to compute the energy of
+     * @return the energy of all interactions involving at least one of the particles, in kJ/mol
+     */
+    double computeParticleEnergy(Context& context, const std::vector<int>& particles) const;
     /**
      * Returns whether or not this force makes use of periodic boundary
      * conditions.
@@ -70,6 +70,20 @@ public:
      * @return the index of the angle that was added
      */
     int addAngle(int particle1, int particle2, int particle3, double angle, double k);
+    /**
+     * Add many angle terms at once.  This is equivalent to calling addAngle() once for each element of
+     * the arrays, which must all have the same length, but it is much faster when building large
+     * Systems from Python.
+     *
+     * @param particle1 the index of the first particle forming each angle
+     * @param particle2 the index of the second particle forming each angle
+     * @param particle3 the index of the third particle forming each angle
+     * @param angle     the equilibrium value of each angle, measured in radians
+     * @param k         the harmonic force constant for each angle, measured in kJ/mol/radian^2
+     * @return the index of the first angle that was added
+     */
+    int addAngles(const std::vector<int>& particle1, const std::vector<int>& particle2, const std::vector<int>& particle3,
+                  const std::vector<double>& angle, const std::vector<double>& k);
     /**
      * Get the force field parameters for an angle term.
      *
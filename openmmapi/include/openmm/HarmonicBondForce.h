@@ -69,6 +69,18 @@ public:
      * @return the index of the bond that was added
      */
     int addBond(int particle1, int particle2, double length, double k);
+    /**
+     * Add many bond terms at once.  This is equivalent to calling addBond() once for each element of
+     * the arrays, which must all have the same length, but it is much faster when building large
+     * Systems from Python.
+     *
+     * @param particle1 the index of the first particle connected by each bond
+     * @param particle2 the index of the second particle connected by each bond
+     * @param length    the equilibrium length of each bond, measured in nm
+     * @param k         the harmonic force constant for each bond, measured in kJ/mol/nm^2
+     * @return the index of the first bond that was added
+     */
+    int addBonds(const std::vector<int>& particle1, const std::vector<int>& particle2, const std::vector<double>& length, const std::vector<double>& k);
     /**
      * Get the force field parameters for a bond term.
      *
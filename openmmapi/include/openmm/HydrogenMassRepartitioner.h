@@ -0,0 +1,70 @@
+#ifndef OPENMM_HYDROGENMASSREPARTITIONER_H_
+#define OPENMM_HYDROGENMASSREPARTITIONER_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "System.h"
+#include "internal/windowsExport.h"
+
+namespace OpenMM {
+
+/**
+ * This class implements hydrogen mass repartitioning.  It increases the mass of each hydrogen
+ * atom and subtracts the same amount from the heavy atom it is bonded to, so the total mass is
+ * unchanged.  This slows down the fastest motions in the System, which usually allows
+ * a 4 fs time step when combined with constraints on bonds involving hydrogen.
+ *
+ * The System does not record which particles are hydrogens or how they are bonded, so both are
+ * inferred.  A particle is treated as a hydrogen if its mass is greater than 0.5 and less than
+ * 1.5 amu.  This excludes Drude particles and massless particles.  Bonds are taken from the
+ * System's constraints and from every HarmonicBondForce.  If a hydrogen is not found in either
+ * of those, bonds are also taken from every CustomBondForce.  That is how AMOEBA bonds are
+ * represented.  Each hydrogen must be bonded to exactly one heavy atom.  Hydrogens that are
+ * bonded or constrained to another hydrogen keep their mass.  This happens in rigid water, which
+ * does not benefit from repartitioning.
+ */
+
+class OPENMM_EXPORT HydrogenMassRepartitioner {
+public:
+    /**
+     * Repartition the masses of the hydrogen atoms in a System.
+     *
+     * @param system         the System to modify
+     * @param hydrogenMass   the mass to give each hydrogen, in amu
+     * @return the number of hydrogens whose mass was changed
+     */
+    static int repartition(System& system, double hydrogenMass);
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_HYDROGENMASSREPARTITIONER_H_*/
@@ -117,6 +117,10 @@ public:
  * Energy minimization is done using the force groups defined by the Integrator.
  * If you have called setIntegrationForceGroups() on it to restrict the set of forces
  * used for integration, only the energy of the included forces will be minimized.
+ *
+ * On the CUDA, OpenCL, and HIP platforms, minimization is performed entirely on the device
+ * unless a MinimizationReporter is specified.  This avoids transferring positions and forces
+ * to the host on every step, which makes a large difference for very large systems.
  */
 
 class OPENMM_EXPORT LocalEnergyMinimizer {
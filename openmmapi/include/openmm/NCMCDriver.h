@@ -0,0 +1,183 @@
+#ifndef OPENMM_NCMCDRIVER_H_
+#define OPENMM_NCMCDRIVER_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "Context.h"
+#include "openmm/Kernel.h"
+#include "internal/windowsExport.h"
+#include <string>
+#include <vector>
+
+namespace OpenMM_SFMT {
+    class SFMT;
+}
+
+namespace OpenMM {
+
+/**
+ * This class performs nonequilibrium candidate Monte Carlo (NCMC) moves, as described in Nilmeier,
+ * J. P. et al., PNAS 108(45), pp. E1009-E1018 (2011).  Each move gradually switches one or more
+ * Context parameters (for example, an alchemical lambda) along a schedule while the Integrator
+ * propagates the system, then accepts or rejects the result based on the protocol work.
+ *
+ * To use it, create an NCMCDriver for a Context and call addParameter() for every parameter to switch,
+ * giving the value it takes at every point of the schedule.  All schedules must have the same length.
+ * The first value is where the parameter starts, and each later value is one perturbation.  Each call
+ * to move() then does the following for every perturbation: it sets the parameters to their next
+ * values, adds the resulting change in potential energy to the protocol work, and takes a fixed number
+ * of steps with the Integrator.  At the end, the move is accepted with probability min(1, exp(-W/kT)),
+ * where W is the protocol work.  If it is accepted, the parameters keep their final values.  If it is
+ * rejected, the positions, velocities, periodic box vectors, and parameters are restored to what they
+ * were at the start of the move.
+ *
+ * The work is accumulated on the device, and the only data transferred back to the host during a move
+ * is the total work at the end.  This makes it practical to run many short moves.  If only some force
+ * groups depend on the switched parameters, call setForceGroups() to restrict the energy evaluations to
+ * them.
+ *
+ * The Integrator should leave the equilibrium distribution unchanged at each fixed parameter value,
+ * such as LangevinMiddleIntegrator.  The simulation time and step count keep advancing even when a move
+ * is rejected.
+ */
+
+class OPENMM_EXPORT NCMCDriver {
+public:
+    /**
+     * Create an NCMCDriver.
+     *
+     * @param context               the Context to perform moves in.  It must not be deleted while the
+     *                              NCMCDriver exists.
+     * @param temperature           the temperature (in Kelvin) used in the acceptance test
+     * @param stepsPerPerturbation  the number of Integrator steps to take after each perturbation
+     * @param randomSeed            the seed for the random number generator used in the acceptance test
+     */
+    NCMCDriver(Context& context, double temperature, int stepsPerPerturbation=1, int randomSeed=osrngseed());
+    ~NCMCDriver();
+    /**
+     * Add a Context parameter to switch during each move.
+     *
+     * @param name       the name of the parameter
+     * @param schedule   the value of the parameter at the start of the move, followed by its value after
+     *                   each perturbation
+     * @return the index of the parameter that was added
+     */
+    int addParameter(const std::string& name, const std::vector<double>& schedule);
+    /**
+     * Get the number of parameters that are switched during each move.
+     */
+    int getNumParameters() const {
+        return parameterNames.size();
+    }
+    /**
+     * Get the name of a parameter that is switched during each move.
+     *
+     * @param index   the index of the parameter
+     */
+    const std::string& getParameterName(int index) const;
+    /**
+     * Get the schedule for a parameter that is switched during each move.
+     *
+     * @param index   the index of the parameter
+     */
+    const std::vector<double>& getParameterSchedule(int index) const;
+    /**
+     * Get the number of perturbations in each move.  This is one less than the length of the schedules.
+     */
+    int getNumPerturbations() const;
+    /**
+     * Get the number of Integrator steps taken after each perturbation.
+     */
+    int getStepsPerPerturbation() const {
+        return stepsPerPerturbation;
+    }
+    /**
+     * Get the temperature (in Kelvin) used in the acceptance test.
+     */
+    double getTemperature() const {
+        return temperature;
+    }
+    /**
+     * Set the temperature (in Kelvin) used in the acceptance test.
+     */
+    void setTemperature(double temperature);
+    /**
+     * Get the set of force groups whose energy is included in the protocol work.  This is a set of bit
+     * flags, where bit i corresponds to force group i.
+     */
+    int getForceGroups() const {
+        return forceGroups;
+    }
+    /**
+     * Set the set of force groups whose energy is included in the protocol work.  This is a set of bit
+     * flags, where bit i corresponds to force group i.  Every group whose energy depends on the switched
+     * parameters must be included.  By default, all groups are included.
+     */
+    void setForceGroups(int groups);
+    /**
+     * Perform one move.
+     *
+     * @return true if the move was accepted, false if it was rejected
+     */
+    bool move();
+    /**
+     * Get the protocol work (in kJ/mol) of the most recent move.
+     */
+    double getLastWork() const {
+        return lastWork;
+    }
+    /**
+     * Get the number of moves that have been attempted.
+     */
+    int getNumAttempted() const {
+        return numAttempted;
+    }
+    /**
+     * Get the number of moves that have been accepted.
+     */
+    int getNumAccepted() const {
+        return numAccepted;
+    }
+private:
+    void setParameters(int index);
+    Context& context;
+    Kernel kernel;
+    std::vector<std::string> parameterNames;
+    std::vector<std::vector<double> > schedules;
+    OpenMM_SFMT::SFMT* random;
+    double temperature, lastWork;
+    int stepsPerPerturbation, forceGroups, numAttempted, numAccepted;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_NCMCDRIVER_H_*/
@@ -36,6 +36,7 @@
 #include "Force.h"
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 #include "internal/windowsExport.h"
@@ -180,6 +181,12 @@ public:
     int getNumExceptionParameterOffsets() const {
         return exceptionOffsets.size();
     }
+    /**
+     * Get the number of titration sites that have been added.
+     */
+    int getNumTitrationSites() const {
+        return titrationSites.size();
+    }
     /**
      * Get the method used for handling long range nonbonded interactions.
      */
@@ -329,6 +336,17 @@ public:
      * @return the index of the particle that was added
      */
     int addParticle(double charge, double sigma, double epsilon);
+    /**
+     * Add the nonbonded force parameters for many particles at once.  This is equivalent to calling
+     * addParticle() once for each element of the arrays, which must all have the same length, but it
+     * is much faster when building large Systems from Python.
+     *
+     * @param charge    the charge of each particle, measured in units of the proton charge
+     * @param sigma     the sigma parameter of the Lennard-Jones potential for each particle, measured in nm
+     * @param epsilon   the epsilon parameter of the Lennard-Jones potential for each particle, measured in kJ/mol
+     * @return the index of the first particle that was added
+     */
+    int addParticles(const std::vector<double>& charge, const std::vector<double>& sigma, const std::vector<double>& epsilon);
     /**
      * Get the nonbonded force parameters for a particle.
      *
@@ -370,6 +388,25 @@ public:
      * @return the index of the exception that was added
      */
     int addException(int particle1, int particle2, double chargeProd, double sigma, double epsilon, bool replace = false);
+    /**
+     * Add many exceptions at once.  This is equivalent to calling addException() once for each element of
+     * the arrays, which must all have the same length, but it is much faster when building large Systems
+     * from Python.
+     *
+     * @param particle1  the index of the first particle involved in each interaction
+     * @param particle2  the index of the second particle involved in each interaction
+     * @param chargeProd the scaled product of the atomic charges for each interaction, measured in units of the proton charge squared
+     * @param sigma      the sigma parameter of the Lennard-Jones potential for each interaction, measured in nm
+     * @param epsilon    the epsilon parameter of the Lennard-Jones potential for each interaction, measured in kJ/mol
+     * @param replace    determines the behavior if there is already an exception for the same two particles.  If true, the existing one is replaced.  If false,
+     *                   an exception is thrown and none of the new exceptions are added.
+     * @return the index at which the new exceptions begin, which is the number of exceptions before this call.
+     *         Exceptions that replaced existing ones keep their original indices, and all others are added in
+     *         order starting at this index.  If every element replaced an existing exception, nothing was added
+     *         and the return value equals getNumExceptions().
+     */
+    int addExceptions(const std::vector<int>& particle1, const std::vector<int>& particle2, const std::vector<double>& chargeProd,
+                      const std::vector<double>& sigma, const std::vector<double>& epsilon, bool replace = false);
     /**
      * Get the force field parameters for an interaction that should be calculated differently from others.
      *
@@ -519,6 +556,114 @@ public:
      * @param epsilonScale    this value multiplied by the parameter value is added to the exception's epsilon
      */
     void setExceptionParameterOffset(int index, const std::string& parameter, int exceptionIndex, double chargeProdScale, double sigmaScale, double epsilonScale);
+    /**
+     * Add a titration site, a group of particles whose parameters can be switched between several predefined
+     * states.  This is intended for constant pH simulations, where each titratable residue is a site and each
+     * protonation state is a state.  State 0 is defined by the standard parameters of the particles, and
+     * additional states are added with addTitrationState().
+     *
+     * The current state of the site is selected by a global parameter whose value is the index of the state.
+     * It is added to the Context with a default value of 0, and calling Context::setParameter() with a new
+     * value switches the site to that state.  Internally, each state other than state 0 is represented by
+     * parameter offsets that are controlled by an additional global parameter, whose name is the site's
+     * parameter followed by "_state" and the state index.  These are set automatically and should not be
+     * modified directly.  Because of this, switching states does not require any parameters to be copied to
+     * the Context.
+     *
+     * The charge product and epsilon of each exception involving a particle of the site are scaled in
+     * proportion to the product of the particle charges and the square root of the product of the particle
+     * epsilons, so exceptions created with createExceptionsFromBonds() remain consistent.  Exceptions whose
+     * charge product and epsilon are both zero are left unchanged.  This cannot work when a particle has zero
+     * charge or epsilon in state 0, such as a dummy proton, so in that case call
+     * setTitrationStateExceptionParameters() to specify the exception parameters for each state explicitly.
+     * The long range dispersion correction is always computed from the state 0 parameters.
+     *
+     * @param parameter   the name of the global parameter that selects the state of the site
+     * @param particles   the indices of the particles whose parameters depend on the state
+     * @return the index of the site that was added
+     */
+    int addTitrationSite(const std::string& parameter, const std::vector<int>& particles);
+    /**
+     * Get the properties of a titration site.
+     *
+     * @param index            the index of the site to query, as returned by addTitrationSite()
+     * @param[out] parameter   the name of the global parameter that selects the state of the site
+     * @param[out] particles   the indices of the particles whose parameters depend on the state
+     */
+    void getTitrationSiteParameters(int index, std::string& parameter, std::vector<int>& particles) const;
+    /**
+     * Get the number of states of a titration site, including state 0.
+     *
+     * @param index     the index of the site to query, as returned by addTitrationSite()
+     */
+    int getNumTitrationStates(int index) const;
+    /**
+     * Add a state to a titration site.
+     *
+     * @param index      the index of the site, as returned by addTitrationSite()
+     * @param charges    the charge of each particle of the site in this state, measured in units of the proton charge
+     * @param sigmas     the sigma of each particle of the site in this state, measured in nm
+     * @param epsilons   the epsilon of each particle of the site in this state, measured in kJ/mol
+     * @return the index of the state that was added.  This is the value of the site's parameter that selects it.
+     */
+    int addTitrationState(int index, const std::vector<double>& charges, const std::vector<double>& sigmas, const std::vector<double>& epsilons);
+    /**
+     * Get the parameters of the particles of a titration site in one of its states.
+     *
+     * @param index           the index of the site, as returned by addTitrationSite()
+     * @param state           the index of the state, as returned by addTitrationState().  It must be at least 1,
+     *                        since state 0 is defined by the standard particle parameters.
+     * @param[out] charges    the charge of each particle of the site in this state, measured in units of the proton charge
+     * @param[out] sigmas     the sigma of each particle of the site in this state, measured in nm
+     * @param[out] epsilons   the epsilon of each particle of the site in this state, measured in kJ/mol
+     */
+    void getTitrationStateParameters(int index, int state, std::vector<double>& charges, std::vector<double>& sigmas, std::vector<double>& epsilons) const;
+    /**
+     * Set the parameters of an exception when a titration site is in one of its states, instead of deriving them
+     * from the particle parameters.  In state 0 the exception always has its standard parameters.  At least one
+     * of the two particles must belong to the site.  If parameters were already set for this exception and state,
+     * they are replaced.
+     *
+     * @param index           the index of the site, as returned by addTitrationSite()
+     * @param state           the index of the state, as returned by addTitrationState()
+     * @param exceptionIndex  the index of the exception, as returned by addException()
+     * @param chargeProd      the scaled product of the atomic charges in this state, measured in units of the proton charge squared
+     * @param sigma           the sigma parameter of the Lennard-Jones potential in this state, measured in nm
+     * @param epsilon         the epsilon parameter of the Lennard-Jones potential in this state, measured in kJ/mol
+     */
+    void setTitrationStateExceptionParameters(int index, int state, int exceptionIndex, double chargeProd, double sigma, double epsilon);
+    /**
+     * Get the number of exceptions whose parameters have been set explicitly for a state of a titration site.
+     *
+     * @param index     the index of the site, as returned by addTitrationSite()
+     * @param state     the index of the state, as returned by addTitrationState()
+     */
+    int getNumTitrationStateExceptions(int index, int state) const;
+    /**
+     * Get the parameters of an exception that were set explicitly for a state of a titration site.
+     *
+     * @param index                the index of the site, as returned by addTitrationSite()
+     * @param state                the index of the state, as returned by addTitrationState()
+     * @param stateExceptionIndex  the index of the exception within this state, between 0 and getNumTitrationStateExceptions()-1
+     * @param[out] exceptionIndex  the index of the exception, as returned by addException()
+     * @param[out] chargeProd      the scaled product of the atomic charges in this state, measured in units of the proton charge squared
+     * @param[out] sigma           the sigma parameter of the Lennard-Jones potential in this state, measured in nm
+     * @param[out] epsilon         the epsilon parameter of the Lennard-Jones potential in this state, measured in kJ/mol
+     */
+    void getTitrationStateExceptionParameters(int index, int state, int stateExceptionIndex, int& exceptionIndex, double& chargeProd, double& sigma, double& epsilon) const;
+    /**
+     * Compute how the energy of this force would change if a titration site were switched to a different state,
+     * for use in the Metropolis test of a constant pH move.  The energy is computed by the Context's Platform
+     * with the current positions, neighbor list, and reciprocal space settings, so it is exactly consistent with
+     * the energy used for dynamics.  Only the force groups used by this force are evaluated.  The site is left
+     * in its original state.
+     *
+     * @param context   the Context in which to evaluate the energy change
+     * @param index     the index of the site, as returned by addTitrationSite()
+     * @param state     the state to compute the energy of
+     * @return the energy in the new state minus the energy in the current state, in kJ/mol
+     */
+    double computeTitrationEnergyChange(Context& context, int index, int state) const;
     /**
      * Get whether to add a contribution to the energy that approximately represents the effect of Lennard-Jones
      * interactions beyond the cutoff distance.  The energy depends on the volume of the periodic box, and is only
@@ -581,6 +726,78 @@ public:
      * this method cannot be used to add new particles or exceptions, only to change the parameters of existing ones.
      */
     void updateParametersInContext(Context& context);
+    /**
+     * Compute the interaction energy between two sets of particles, using the current positions and global
+     * parameters in a Context.  Only pairs with one particle in each set contribute.  This is useful for
+     * analyses such as decomposing a binding energy, since it does not require building a new System for
+     * each pair of groups.  The calculation is done on the host and does not modify the Context.
+     *
+     * Particle and exception parameters are taken from this Force object, including any parameter offsets.
+     * Excluded pairs contribute nothing, and exceptions are evaluated without a cutoff, just as in a
+     * normal energy evaluation.  Other pairs beyond the cutoff are ignored.  For CutoffNonPeriodic and
+     * CutoffPeriodic, Coulomb interactions use the reaction field approximation exactly as for a normal
+     * evaluation.  For Ewald, PME, and LJPME there is no well defined way to assign reciprocal space energy
+     * to pairs of particles, so the reaction field approximation is used for them as well.  Long range
+     * dispersion corrections are not included.
+     *
+     * @param context   the Context in which to evaluate the energy
+     * @param set1      the indices of the particles in the first set
+     * @param set2      the indices of the particles in the second set.  It may not share any particles with set1.
+     * @return the interaction energy between the two sets, in kJ/mol
+     */
+    double computeInteractionEnergy(Context& context, const std::vector<int>& set1, const std::vector<int>& set2) const;
+    /**
+     * Compute how the energy of this force would change if some particles were moved to new positions.  This is
+     * intended for Monte Carlo displacement moves.  Only interactions involving the moved particles are evaluated,
+     * and reciprocal space is handled by updating the structure factors for just those particles, so it is much
+     * faster than setting the positions and calling getState().  The Context is not modified.
+     *
+     * The calculation is done on the host, using the particle and exception parameters of this Force object including
+     * any parameter offsets.  For PME, reciprocal space is evaluated with an Ewald sum whose accuracy is set by the
+     * Ewald error tolerance, so the result may differ slightly from the change in the energy computed with PME.
+     * LJPME is not supported.
+     *
+     * @param context       the Context in which to evaluate the energy change
+     * @param particles     the indices of the particles to move
+     * @param newPositions  the new positions of the particles, in the same order as particles
+     * @return the energy after the move minus the energy before it, in kJ/mol
+     */
+    double computeEnergyChange(Context& context, const std::vector<int>& particles, const std::vector<Vec3>& newPositions) const;
+    /**
+     * Compute the part of the energy of this force that involves a set of particles, using the current positions
+     * and global parameters in a Context.  This equals the change in energy if the particles were switched off
+     * (all their charges and Lennard-Jones parameters, and all exceptions involving them, set to zero), so it is
+     * useful for Monte Carlo insertion and deletion moves.  The work scales with the number of particles in the set
+     * times the number of particles in the System.  The Context is not modified.
+     *
+     * This has the same limitations as computeEnergyChange().  In addition, the long range dispersion correction is
+     * not included.
+     *
+     * @param context     the Context in which to evaluate the energy
+     * @param particles   the indices of the particles to compute the energy of
+     * @return the energy of all interactions involving at least one of the particles, in kJ/mol
+     */
+    double computeParticleEnergy(Context& context, const std::vector<int>& particles) const;
+    /**
+     * Compute the energy of this force in each of several states that differ in the values of global parameters,
+     * using the current positions in a Context.  This is intended for free energy methods such as MBAR that need
+     * the energy of every configuration in every alchemical state, where the states are defined by parameter
+     * offsets.  It is much faster than calling setParameter() and getState() once for each state, since the
+     * distance between each pair of particles is computed only once, interactions whose parameters do not depend
+     * on any global parameter are computed only once, and the reciprocal space structure factors are formed as
+     * linear combinations of precomputed ones.  The calculation is done on the host and does not modify the Context.
+     *
+     * The energy includes both direct and reciprocal space, regardless of their force groups.  For PME, reciprocal
+     * space is evaluated with an Ewald sum whose accuracy is set by the Ewald error tolerance.  LJPME is not supported.
+     *
+     * @param context          the Context in which to evaluate the energies
+     * @param parameters       the names of the global parameters that differ between states.  Any other global
+     *                         parameters keep their current values in the Context.
+     * @param values           values[i][j] is the value of parameters[j] in state i
+     * @param[out] energies    on exit, energies[i] is the energy of this force in state i
+     */
+    void computeStateEnergies(Context& context, const std::vector<std::string>& parameters, const std::vector<std::vector<double> >& values,
+            std::vector<double>& energies) const;
     /**
      * Returns whether or not this force makes use of periodic boundary
      * conditions.
@@ -619,6 +836,37 @@ public:
      * normally used to represent bonded interactions.
      */
     void setExceptionsUsePeriodicBoundaryConditions(bool periodic);
+    /**
+     * Get the indices of the particles that make up the solute region for replica exchange with solute
+     * tempering (REST2).  See setSoluteParticles() for details.
+     */
+    const std::vector<int>& getSoluteParticles() const;
+    /**
+     * Set the indices of the particles that make up the solute region for replica exchange with solute
+     * tempering (REST2).  This has no effect unless a solute scale parameter has also been specified with
+     * setSoluteScaleParameter().  It must be called before the Context is created.
+     *
+     * When the scale parameter has the value lambda, interactions within the solute are multiplied by lambda
+     * and interactions between the solute and the rest of the System are multiplied by sqrt(lambda).  This is
+     * done by multiplying the charge of each solute particle by sqrt(lambda) and its epsilon by lambda, and by
+     * scaling chargeProd and epsilon of each exception in the same way.  Parameter offsets applied to solute
+     * particles and exceptions are scaled along with the base parameters.  Interactions that do not involve
+     * the solute are unaffected.
+     */
+    void setSoluteParticles(const std::vector<int>& particles);
+    /**
+     * Get the name of the global parameter that scales the solute interactions, or an empty string if solute
+     * scaling is not used.
+     */
+    const std::string& getSoluteScaleParameter() const;
+    /**
+     * Set the name of the global parameter that scales the solute interactions.  For REST2 its value should be
+     * beta_m/beta_0, the ratio of the inverse temperature of a replica to that of the unscaled System.  The
+     * parameter is added to the Context with a default value of 1, and its value must always be positive.
+     * Changing it causes the scaled parameters to be copied to the Context, so it is much cheaper than adding
+     * extra forces but should not be done every time step.  Pass an empty string to disable solute scaling.
+     */
+    void setSoluteScaleParameter(const std::string& parameter);
 protected:
     ForceImpl* createImpl() const;
 private:
@@ -627,18 +875,22 @@ private:
     class GlobalParameterInfo;
     class ParticleOffsetInfo;
     class ExceptionOffsetInfo;
+    class TitrationSiteInfo;
     NonbondedMethod nonbondedMethod;
     double cutoffDistance, switchingDistance, rfDielectric, ewaldErrorTol, alpha, dalpha;
     bool useSwitchingFunction, useDispersionCorrection, exceptionsUsePeriodic, includeDirectSpace;
     int recipForceGroup, nx, ny, nz, dnx, dny, dnz;
-    void addExclusionsToSet(const std::vector<std::set<int> >& bonded12, std::set<int>& exclusions, int baseParticle, int fromParticle, int currentLevel) const;
+    static long long getExceptionKey(int particle1, int particle2);
     int getGlobalParameterIndex(const std::string& parameter) const;
     std::vector<ParticleInfo> particles;
     std::vector<ExceptionInfo> exceptions;
     std::vector<GlobalParameterInfo> globalParameters;
     std::vector<ParticleOffsetInfo> particleOffsets;
     std::vector<ExceptionOffsetInfo> exceptionOffsets;
-    std::map<std::pair<int, int>, int> exceptionMap;
+    std::vector<TitrationSiteInfo> titrationSites;
+    std::unordered_map<long long, int> exceptionMap;
+    std::vector<int> soluteParticles;
+    std::string soluteScaleParameter;
     mutable int numContexts, firstChangedParticle, lastChangedParticle, firstChangedException, lastChangedException;
 };
 
@@ -722,6 +974,23 @@ public:
     }
 };
 
+/**
+ * This is an internal class used to record information about a titration site.
+ * @private
+ */
+class NonbondedForce::TitrationSiteInfo {
+public:
+    std::string parameter;
+    std::vector<int> particles;
+    std::vector<std::vector<double> > charges, sigmas, epsilons;
+    std::vector<std::vector<int> > exceptions;
+    std::vector<std::vector<double> > exceptionChargeProds, exceptionSigmas, exceptionEpsilons;
+    TitrationSiteInfo() {
+    }
+    TitrationSiteInfo(const std::string& parameter, const std::vector<int>& particles) : parameter(parameter), particles(particles) {
+    }
+};
+
 } // namespace OpenMM
 
 #endif /*OPENMM_NONBONDEDFORCE_H_*/
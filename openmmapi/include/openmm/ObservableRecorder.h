@@ -0,0 +1,172 @@
+#ifndef OPENMM_OBSERVABLERECORDER_H_
+#define OPENMM_OBSERVABLERECORDER_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "Context.h"
+#include "internal/windowsExport.h"
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class records a time series of scalar observables while a simulation runs.  Call step()
+ * instead of calling step() on the Integrator directly.  It advances the Context, and every time
+ * the step count reaches a multiple of the interval it records the value of every observable.  The
+ * values are stored in a ring buffer of fixed capacity, and all samples recorded since the last call
+ * are retrieved at once by calling drain().  If more samples are recorded than the buffer can hold,
+ * the oldest ones are discarded.
+ *
+ * The observables are computed by the platform and only the scalar results are transferred, so
+ * recording at short intervals is much cheaper than retrieving a State and processing it in Python.
+ * The available observables are
+ *
+ * <ul>
+ * <li>the potential energy of a set of force groups (see addPotentialEnergy())</li>
+ * <li>the kinetic energy</li>
+ * <li>the instantaneous temperature computed from the kinetic energy</li>
+ * <li>the volume of the periodic box</li>
+ * </ul>
+ *
+ * Because energies can be restricted to force groups, any quantity that can be expressed as a Force
+ * can be recorded by placing it in a group of its own.  For example, to record the RMSD of a selection
+ * of particles, add an RMSDForce to the System in an otherwise unused force group and record the
+ * potential energy of that group.  Each distinct set of force groups requires one energy evaluation
+ * per sample.
+ */
+
+class OPENMM_EXPORT ObservableRecorder {
+public:
+    /**
+     * Create an ObservableRecorder.
+     *
+     * @param context    the Context to record observables for.  It must not be deleted while the
+     *                   ObservableRecorder exists.
+     * @param interval   the interval (in time steps) at which to record samples
+     * @param capacity   the maximum number of samples that can be stored between calls to drain()
+     */
+    ObservableRecorder(Context& context, int interval, int capacity);
+    /**
+     * Get the interval (in time steps) at which samples are recorded.
+     */
+    int getInterval() const {
+        return interval;
+    }
+    /**
+     * Get the maximum number of samples that can be stored between calls to drain().
+     */
+    int getCapacity() const {
+        return capacity;
+    }
+    /**
+     * Get the number of observables that are recorded for each sample.
+     */
+    int getNumObservables() const {
+        return observables.size();
+    }
+    /**
+     * Get the number of samples that are currently stored and will be returned by the next call to drain().
+     */
+    int getNumSamples() const {
+        return numSamples;
+    }
+    /**
+     * Get the number of samples that have been discarded because the buffer was full.
+     */
+    long long getNumDiscarded() const {
+        return numDiscarded;
+    }
+    /**
+     * Add an observable for the potential energy of a set of force groups, in kJ/mol.
+     *
+     * @param groups  a set of bit flags for which force groups to include.  Group i will be included
+     *                if (groups&(1<<i)) != 0.  The default value includes all groups.
+     * @return the index of the observable within each sample
+     */
+    int addPotentialEnergy(int groups=0xFFFFFFFF);
+    /**
+     * Add an observable for the kinetic energy, in kJ/mol.
+     *
+     * @return the index of the observable within each sample
+     */
+    int addKineticEnergy();
+    /**
+     * Add an observable for the instantaneous temperature, in Kelvin.  It is computed from the kinetic
+     * energy and the number of degrees of freedom, which accounts for massless particles, constraints,
+     * and CMMotionRemovers.
+     *
+     * @return the index of the observable within each sample
+     */
+    int addTemperature();
+    /**
+     * Add an observable for the volume of the periodic box, in nm^3.
+     *
+     * @return the index of the observable within each sample
+     */
+    int addVolume();
+    /**
+     * Advance the simulation by a number of time steps, recording a sample each time the Context's
+     * step count is a multiple of the interval.
+     *
+     * @param steps   the number of time steps to take
+     */
+    void step(int steps);
+    /**
+     * Record a sample for the current state of the Context.
+     */
+    void recordSample();
+    /**
+     * Retrieve all samples that have been recorded since the last call, and remove them from the buffer.
+     * Samples are returned in the order they were recorded.  Element 0 of each one is the simulation
+     * time in ps, and element i+1 is the value of observable i.
+     */
+    std::vector<std::vector<double> > drain();
+private:
+    enum ObservableType {
+        PotentialEnergy, KineticEnergy, Temperature, Volume
+    };
+    struct ObservableInfo {
+        ObservableType type;
+        int groups;
+    };
+    int addObservable(ObservableType type, int groups);
+    Context& context;
+    int interval, capacity, numSamples, firstSample;
+    long long numDiscarded;
+    double dof;
+    std::vector<ObservableInfo> observables;
+    std::vector<double> buffer;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_OBSERVABLERECORDER_H_*/
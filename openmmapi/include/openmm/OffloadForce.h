@@ -0,0 +1,148 @@
+#ifndef OPENMM_OFFLOADFORCE_H_
+#define OPENMM_OFFLOADFORCE_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "Force.h"
+#include "internal/windowsExport.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace OpenMM {
+
+class Context;
+
+/**
+ * This class computes a set of other Forces on a different Platform from the one used by
+ * the Context it belongs to.  A typical use is to move a few inexpensive but awkward terms
+ * (for example, a CustomCompoundBondForce defining restraints) onto otherwise idle CPU cores
+ * while the rest of the System is simulated on a GPU.
+ *
+ * To use it, create an OffloadForce, specifying the name of the Platform to use.  Then call
+ * addForce() to add the Forces it should compute.  Those Forces become owned by the
+ * OffloadForce and should not also be added to the System.  The force group of each one is
+ * ignored.  All of them are computed whenever the force group of the OffloadForce is
+ * included in a calculation.
+ *
+ * When a Context is created, internally it creates a new System containing the Forces and a
+ * Context for it on the specified Platform.  Each time forces are computed, the positions
+ * are copied to that Context, and the resulting forces are added to the ones computed by
+ * the main Context.  On the CUDA, HIP, and OpenCL platforms, this happens on a separate
+ * thread, so it runs concurrently with the calculation of the other Forces on the GPU.
+ */
+
+class OPENMM_EXPORT OffloadForce : public Force {
+public:
+    /**
+     * Create an OffloadForce.
+     *
+     * @param platformName   the name of the Platform on which to compute the Forces
+     */
+    explicit OffloadForce(const std::string& platformName="CPU");
+    ~OffloadForce();
+    /**
+     * Get the number of Forces that have been added.
+     */
+    int getNumForces() const {
+        return forces.size();
+    }
+    /**
+     * Get the name of the Platform on which to compute the Forces.
+     */
+    const std::string& getPlatformName() const;
+    /**
+     * Set the name of the Platform on which to compute the Forces.
+     */
+    void setPlatformName(const std::string& name);
+    /**
+     * Set a property of the Platform that should be used when creating the inner Context,
+     * such as the number of threads the CPU platform should use.
+     *
+     * @param name     the name of the property
+     * @param value    the value of the property
+     */
+    void setPlatformProperty(const std::string& name, const std::string& value);
+    /**
+     * Get the Platform properties that will be used when creating the inner Context.
+     */
+    const std::map<std::string, std::string>& getPlatformProperties() const;
+    /**
+     * Add a Force to be computed on the other Platform.  The Force should have been created
+     * on the heap with the "new" operator.  The OffloadForce takes over ownership of it, and
+     * deletes the Force when the OffloadForce itself is deleted.
+     *
+     * @param force    the Force to add
+     * @return the index within the OffloadForce of the Force that was added
+     */
+    int addForce(Force* force);
+    /**
+     * Get a writable reference to one of the Forces.
+     *
+     * @param index     the index of the Force to get
+     * @return the Force object
+     */
+    Force& getForce(int index);
+    /**
+     * Get a const reference to one of the Forces.
+     *
+     * @param index     the index of the Force to get
+     * @return the Force object
+     */
+    const Force& getForce(int index) const;
+    /**
+     * Get the inner Context used for computing the Forces.  If you want to modify one of
+     * the Forces and call updateParametersInContext() on it, you need to pass this inner
+     * Context to it.
+     *
+     * @param context    the Context containing the OffloadForce
+     * @return the inner Context used to compute the Forces
+     */
+    Context& getInnerContext(Context& context);
+    /**
+     * Returns whether or not this force makes use of periodic boundary
+     * conditions.
+     *
+     * @returns true if force uses PBC and false otherwise
+     */
+    bool usesPeriodicBoundaryConditions() const;
+protected:
+    ForceImpl* createImpl() const;
+private:
+    std::string platformName;
+    std::map<std::string, std::string> platformProperties;
+    std::vector<Force*> forces;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_OFFLOADFORCE_H_*/
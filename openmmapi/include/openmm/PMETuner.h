@@ -0,0 +1,116 @@
+#ifndef OPENMM_PMETUNER_H_
+#define OPENMM_PMETUNER_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.            *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "System.h"
+#include "Vec3.h"
+#include "internal/windowsExport.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace OpenMM {
+
+class Platform;
+
+/**
+ * Given a System containing a NonbondedForce that uses PME or LJPME, this class
+ * benchmarks a few alternative ways of computing the reciprocal space interactions
+ * on a particular Platform and selects the one that runs fastest.
+ *
+ * The cutoff distance and Ewald error tolerance are never changed, so the accuracy
+ * of the simulation is unaffected.  The NonbondedForce first has its PME parameters
+ * set to the values that would have been selected automatically.  The grid dimensions
+ * calculated that way are the smallest ones that achieve the requested accuracy,
+ * but they are not necessarily the fastest, since some grid sizes are handled much
+ * more efficiently by the FFT than others.  The tuner therefore tries several larger
+ * grids with the same Ewald separation parameter.  It then tries toggling the
+ * UseCpuPme and DisablePmeStream properties, if the Platform supports them.
+ *
+ * Each candidate is timed by creating a temporary Context and taking a series of very
+ * short time steps.  The fastest grid is stored into the NonbondedForce by calling
+ * setPMEParameters(), and the fastest combination of Platform properties is returned.
+ * You should then create your Context, passing it the same Platform and the returned
+ * properties.
+ *
+ * The grid chosen from the Ewald error tolerance is based on an analytic error estimate that
+ * is conservative for most systems.  Before calling tune(), you can call selectGrid() to find a
+ * smaller grid by measuring the actual error in the forces instead.
+ */
+
+class OPENMM_EXPORT PMETuner {
+public:
+    /**
+     * Select the fastest PME parameters for a System.
+     *
+     * @param system      the System to tune.  The PME parameters of its NonbondedForce are
+     *                    modified to the fastest values found.  If the System does not contain
+     *                    a NonbondedForce that uses PME or LJPME, it is not modified.
+     * @param positions   the positions of all particles, which are used for benchmarking
+     * @param platform    the Platform to tune for
+     * @param properties  the Platform-specific properties the Context will be created with
+     * @param numSteps    the number of time steps to time for each candidate.  Larger values
+     *                    give more reliable timings but take longer.
+     * @return a copy of properties, updated with the values of UseCpuPme and DisablePmeStream
+     * that were found to be fastest.  Properties the Platform does not support are not added.
+     */
+    static std::map<std::string, std::string> tune(System& system, const std::vector<Vec3>& positions, Platform& platform,
+            const std::map<std::string, std::string>& properties = std::map<std::string, std::string>(), int numSteps = 100);
+    /**
+     * Select the smallest PME grid for a System that meets its Ewald error tolerance, based on
+     * the measured error in the forces.
+     *
+     * The Ewald separation parameter is chosen from the tolerance in the usual way, since that
+     * determines the accuracy of the direct space interactions.  The forces are then computed
+     * with a grid twice as fine as the one that would be selected automatically, which serves
+     * as the reference.  Successively coarser grids are tried, and the smallest one for which the
+     * RMS error in the nonbonded forces, relative to the RMS reference force, is no larger than
+     * the error tolerance is stored into the NonbondedForce by calling setPMEParameters().  The
+     * grid is never made larger than the automatically selected one.  For LJPME, only the grid
+     * for the electrostatic interactions is selected this way.
+     *
+     * @param system      the System to tune.  The PME parameters of its NonbondedForce are
+     *                    modified to the values selected.  If the System does not contain
+     *                    a NonbondedForce that uses PME or LJPME, it is not modified.
+     * @param positions   the positions of all particles, which are used to measure the error.
+     *                    They should be representative of the configurations that will be simulated.
+     * @param platform    the Platform to compute the forces with
+     * @param properties  the Platform-specific properties to create Contexts with
+     */
+    static void selectGrid(System& system, const std::vector<Vec3>& positions, Platform& platform,
+            const std::map<std::string, std::string>& properties = std::map<std::string, std::string>());
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_PMETUNER_H_*/
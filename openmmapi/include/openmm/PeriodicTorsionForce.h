@@ -35,6 +35,7 @@
 #include "Force.h"
 #include "Vec3.h"
 #include <map>
+#include <string>
 #include <vector>
 #include "internal/windowsExport.h"
 
@@ -72,6 +73,22 @@ public:
      * @return the index of the torsion that was added
      */
     int addTorsion(int particle1, int particle2, int particle3, int particle4, int periodicity, double phase, double k);
+    /**
+     * Add many periodic torsion terms at once.  This is equivalent to calling addTorsion() once for each
+     * element of the arrays, which must all have the same length, but it is much faster when building
+     * large Systems from Python.
+     *
+     * @param particle1    the index of the first particle forming each torsion
+     * @param particle2    the index of the second particle forming each torsion
+     * @param particle3    the index of the third particle forming each torsion
+     * @param particle4    the index of the fourth particle forming each torsion
+     * @param periodicity  the periodicity of each torsion
+     * @param phase        the phase offset of each torsion, measured in radians
+     * @param k            the force constant for each torsion
+     * @return the index of the first torsion that was added
+     */
+    int addTorsions(const std::vector<int>& particle1, const std::vector<int>& particle2, const std::vector<int>& particle3, const std::vector<int>& particle4,
+                    const std::vector<int>& periodicity, const std::vector<double>& phase, const std::vector<double>& k);
     /**
      * Get the force field parameters for a periodic torsion term.
      *
@@ -120,12 +137,40 @@ public:
      * @returns true if force uses PBC and false otherwise
      */
     bool usesPeriodicBoundaryConditions() const;
+    /**
+     * Get the indices of the particles that make up the solute region for replica exchange with solute
+     * tempering (REST2).  See setSoluteParticles() for details.
+     */
+    const std::vector<int>& getSoluteParticles() const;
+    /**
+     * Set the indices of the particles that make up the solute region for replica exchange with solute
+     * tempering (REST2).  This has no effect unless a solute scale parameter has also been specified with
+     * setSoluteScaleParameter().  It must be called before the Context is created.
+     *
+     * When the scale parameter has the value lambda, the force constant of a torsion is multiplied by lambda
+     * if all four of its particles are in the solute, or by sqrt(lambda) if only some of them are.
+     */
+    void setSoluteParticles(const std::vector<int>& particles);
+    /**
+     * Get the name of the global parameter that scales the solute torsions, or an empty string if solute
+     * scaling is not used.
+     */
+    const std::string& getSoluteScaleParameter() const;
+    /**
+     * Set the name of the global parameter that scales the solute torsions.  For REST2 its value should be
+     * beta_m/beta_0, and the same parameter is normally used for the NonbondedForce.  The parameter is added
+     * to the Context with a default value of 1, and its value must always be positive.  Changing it causes
+     * the scaled parameters to be copied to the Context.  Pass an empty string to disable solute scaling.
+     */
+    void setSoluteScaleParameter(const std::string& parameter);
 protected:
     ForceImpl* createImpl() const;
 private:
     class PeriodicTorsionInfo;
     std::vector<PeriodicTorsionInfo> periodicTorsions;
     bool usePeriodic;
+    std::vector<int> soluteParticles;
+    std::string soluteScaleParameter;
     mutable int numContexts, firstChangedTorsion, lastChangedTorsion;
 };
 
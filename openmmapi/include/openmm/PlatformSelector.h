@@ -0,0 +1,154 @@
+#ifndef OPENMM_PLATFORMSELECTOR_H_
+#define OPENMM_PLATFORMSELECTOR_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "Integrator.h"
+#include "System.h"
+#include "Vec3.h"
+#include "internal/windowsExport.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace OpenMM {
+
+class Platform;
+
+/**
+ * This class chooses the fastest Platform, and the fastest values of a few performance
+ * related Platform properties, for simulating a particular System with a particular Integrator
+ * on the current hardware.  Rather than relying on each Platform's estimated speed, as
+ * Platform::findPlatform() does, it creates a temporary Context for each candidate and
+ * times a short series of steps.
+ *
+ * Every available Platform is tried except Reference, which is only used if nothing else
+ * works.  For each Platform, the precisions passed to setPrecisions() are tried if the
+ * Platform has a Precision property.  By default no precision is specified, so each Platform
+ * uses its default.  If the System contains a NonbondedForce that uses PME or LJPME, the
+ * UseCpuPme and DisablePmeStream properties are then toggled on the fastest Platform, if it
+ * supports them.
+ *
+ * Calibration takes time, so the result can be saved in a cache directory.  It is identified
+ * by a hash of the System, the Integrator, the precisions, and a description of the hardware
+ * (the available Platforms and the devices they use).  A later call for the same workload on
+ * the same kind of node loads the decision instead of repeating the benchmark, while a node
+ * with different hardware runs its own.
+ *
+ * To use it, call select(), then create your Context with the Platform returned by
+ * getPlatform() and the properties returned by getProperties().
+ */
+
+class OPENMM_EXPORT PlatformSelector {
+public:
+    /**
+     * Create a PlatformSelector.
+     */
+    PlatformSelector();
+    /**
+     * Get the precisions to try on Platforms that have a Precision property.  If this is empty,
+     * each Platform uses its default precision.
+     */
+    const std::vector<std::string>& getPrecisions() const {
+        return precisions;
+    }
+    /**
+     * Set the precisions to try on Platforms that have a Precision property, such as "single",
+     * "mixed", and "double".  If this is empty, each Platform uses its default precision.
+     */
+    void setPrecisions(const std::vector<std::string>& precisions) {
+        this->precisions = precisions;
+    }
+    /**
+     * Get the directory in which decisions are cached.  If this is an empty string, nothing is cached.
+     */
+    const std::string& getCacheDirectory() const {
+        return cacheDirectory;
+    }
+    /**
+     * Set the directory in which decisions are cached.  If this is an empty string, nothing is cached.
+     */
+    void setCacheDirectory(const std::string& directory) {
+        cacheDirectory = directory;
+    }
+    /**
+     * Get the number of time steps to time for each candidate.
+     */
+    int getNumSteps() const {
+        return numSteps;
+    }
+    /**
+     * Set the number of time steps to time for each candidate.  Larger values give more
+     * reliable timings but take longer.
+     */
+    void setNumSteps(int steps);
+    /**
+     * Select the fastest Platform and properties.
+     *
+     * @param system      the System that will be simulated
+     * @param integrator  the Integrator that will be used.  It is not modified; each candidate
+     *                    is timed with a copy of it.
+     * @param positions   the positions of all particles, which are used for benchmarking
+     */
+    void select(const System& system, const Integrator& integrator, const std::vector<Vec3>& positions);
+    /**
+     * Get the Platform chosen by the most recent call to select().
+     */
+    Platform& getPlatform() const;
+    /**
+     * Get the Platform properties chosen by the most recent call to select().
+     */
+    const std::map<std::string, std::string>& getProperties() const {
+        return properties;
+    }
+    /**
+     * Get whether the most recent call to select() loaded its decision from the cache, rather than
+     * running a benchmark.
+     */
+    bool getLoadedFromCache() const {
+        return loadedFromCache;
+    }
+private:
+    std::string describeHardware(std::vector<Platform*>& candidates) const;
+    bool loadFromCache(const std::string& fileName);
+    void saveToCache(const std::string& fileName) const;
+    std::vector<std::string> precisions;
+    std::string cacheDirectory;
+    int numSteps;
+    Platform* platform;
+    std::map<std::string, std::string> properties;
+    bool loadedFromCache;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_PLATFORMSELECTOR_H_*/
@@ -0,0 +1,179 @@
+#ifndef OPENMM_REPLICAEXCHANGE_H_
+#define OPENMM_REPLICAEXCHANGE_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "Context.h"
+#include "Integrator.h"
+#include "System.h"
+#include "internal/windowsExport.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace OpenMM_SFMT {
+    class SFMT;
+}
+
+namespace OpenMM {
+
+class Platform;
+
+/**
+ * This class runs a replica exchange simulation.  It creates one Context for each of a set of
+ * thermodynamic states, all simulating the same System.  Each state is defined by a temperature
+ * and optionally by values for Context parameters, so it can be used both for temperature replica
+ * exchange and for Hamiltonian replica exchange.
+ *
+ * Call step() to advance every replica, and attemptExchanges() to attempt swapping the states of
+ * replicas in neighboring states using the Metropolis criterion.  Exchanges alternate between
+ * pairs (0, 1), (2, 3), ... and pairs (1, 2), (3, 4), ...  When an exchange is accepted, the
+ * coordinates stay in their Contexts.  Instead the two Contexts exchange thermodynamic states:
+ * their parameters and temperatures are changed, and their velocities are rescaled to the new
+ * temperatures.  This avoids transferring positions between Contexts.
+ *
+ * The temperature is applied to the Integrator, which must be one of the thermostated integrators
+ * that has a setTemperature() method, and to the Context parameters used by AndersenThermostat and
+ * the Monte Carlo barostats if they are present.  When a barostat is used, the acceptance
+ * criterion does not include the pressure-volume term, so all states should use the same
+ * pressure and temperature.
+ *
+ * On Platforms that support it (currently CUDA and HIP), setting the "ShareParameters" property to "true"
+ * reduces the device memory used by the replicas.  The Contexts for all replicas after the first are then
+ * created as linked Contexts that share read-only parameter arrays with the first one.
+ */
+
+class OPENMM_EXPORT ReplicaExchange {
+public:
+    /**
+     * Create a ReplicaExchange.
+     *
+     * @param system        the System to simulate.  It must not be modified or deleted while the
+     *                      ReplicaExchange exists.
+     * @param integrator    the Integrator to use.  A copy of it is made for each replica.
+     * @param temperatures  the temperature of each thermodynamic state, in Kelvin
+     * @param parameters    the values of Context parameters in each thermodynamic state.  This may be
+     *                      empty, in which case the states differ only in temperature.  Otherwise it
+     *                      must have one element for each state.
+     * @param platform      the Platform to create the Contexts for
+     * @param properties    Platform-specific properties to create the Contexts with
+     * @param randomSeed    the seed for the random number generator used to accept or reject exchanges
+     */
+    ReplicaExchange(const System& system, const Integrator& integrator, const std::vector<double>& temperatures,
+            const std::vector<std::map<std::string, double> >& parameters, Platform& platform,
+            const std::map<std::string, std::string>& properties=std::map<std::string, std::string>(), int randomSeed=osrngseed());
+    ~ReplicaExchange();
+    /**
+     * Get the number of replicas.  This equals the number of thermodynamic states.
+     */
+    int getNumReplicas() const {
+        return contexts.size();
+    }
+    /**
+     * Get the Context used to simulate a replica.  You can set its positions and velocities, or
+     * retrieve its State.  Do not change its parameters or the temperature of its Integrator, since
+     * those are determined by the state it is in.
+     *
+     * @param replica   the index of the replica
+     */
+    Context& getContext(int replica);
+    /**
+     * Get the Integrator used to simulate a replica.
+     *
+     * @param replica   the index of the replica
+     */
+    Integrator& getIntegrator(int replica);
+    /**
+     * Get the thermodynamic state each replica is currently in.  Element i is the index of the
+     * state replica i is in.
+     */
+    const std::vector<int>& getReplicaStates() const {
+        return replicaState;
+    }
+    /**
+     * Advance every replica by a number of time steps.
+     *
+     * @param steps   the number of time steps to take
+     */
+    void step(int steps);
+    /**
+     * Attempt to exchange replicas between pairs of neighboring states.
+     *
+     * @return the number of exchanges that were accepted
+     */
+    int attemptExchanges();
+    /**
+     * Compute the reduced potential energy (the potential energy divided by kT) of every replica
+     * in every thermodynamic state.  Element [i][j] is the reduced potential of replica i
+     * evaluated in state j.  This requires evaluating each Context's energy once for each state
+     * with distinct parameters.  States that differ only in temperature share a single evaluation.
+     */
+    std::vector<std::vector<double> > computeReducedPotentials();
+    /**
+     * Get the number of exchanges that have been attempted between state i and state i+1.
+     */
+    int getNumAttempted(int state) const;
+    /**
+     * Get the number of exchanges that have been accepted between state i and state i+1.
+     */
+    int getNumAccepted(int state) const;
+    /**
+     * Set the temperature of an Integrator.  This is used by replica exchange drivers when a
+     * replica changes state.
+     *
+     * @param integrator    the Integrator to modify
+     * @param temperature   the temperature to set, in Kelvin
+     * @return false if the Integrator does not have a temperature, true otherwise
+     */
+    static bool setIntegratorTemperature(Integrator& integrator, double temperature);
+    /**
+     * Get the names of the Context parameters that specify the temperature of Forces in a System,
+     * such as thermostats and barostats.
+     */
+    static std::vector<std::string> getTemperatureParameters(const System& system);
+private:
+    void applyState(int replica, int state);
+    double computeEnergy(int replica, int state);
+    const System& system;
+    std::vector<double> temperatures;
+    std::vector<std::map<std::string, double> > parameters;
+    std::vector<Integrator*> integrators;
+    std::vector<Context*> contexts;
+    std::vector<int> replicaState, numAttempted, numAccepted;
+    std::vector<std::string> temperatureParameters;
+    OpenMM_SFMT::SFMT* random;
+    int exchangeParity;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_REPLICAEXCHANGE_H_*/
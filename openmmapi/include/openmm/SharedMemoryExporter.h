@@ -0,0 +1,230 @@
+#ifndef OPENMM_SHAREDMEMORYEXPORTER_H_
+#define OPENMM_SHAREDMEMORYEXPORTER_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "Context.h"
+#include "State.h"
+#include "internal/windowsExport.h"
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace OpenMM {
+
+/**
+ * This class publishes snapshots of a simulation to a shared memory segment, so that analysis programs
+ * running in other processes on the same computer can read them while the simulation runs.  It works
+ * like TrajectoryWriter: call step() instead of calling step() on the Integrator directly.  Every time
+ * the step count reaches a multiple of the output interval, the state is captured with
+ * Context::getStateAsync(), and a background thread copies it into shared memory while the Integrator
+ * continues taking time steps.
+ *
+ * The shared memory segment is a ring buffer holding a fixed number of frames.  Once it is full, each
+ * new frame overwrites the oldest one.  The exporter never waits for readers, so a reader that falls
+ * behind misses frames rather than slowing down the simulation.  Readers use a sequence lock to detect
+ * frames that were being overwritten while they read them.  Use SharedMemoryReader to read frames from
+ * C++ or Python.  The layout is simple enough to read from other languages as well.  All values use the
+ * native byte order.
+ *
+ * The segment begins with a 64 byte header:
+ *
+ * <ul>
+ * <li>bytes 0-7: the characters "OMMSHM01"</li>
+ * <li>bytes 8-11: the number of atoms (int32)</li>
+ * <li>bytes 12-15: the number of frames in the ring buffer (int32)</li>
+ * <li>bytes 16-19: 1 if frames include energies, otherwise 0 (int32)</li>
+ * <li>bytes 24-31: the size of each frame in bytes (int64)</li>
+ * <li>bytes 32-39: the number of frames that have been published so far (uint64)</li>
+ * </ul>
+ *
+ * It is followed by the frames.  Frame i is stored in slot i%(number of frames in the ring buffer).
+ * Each slot begins with a 128 byte header:
+ *
+ * <ul>
+ * <li>bytes 0-7: the sequence number (uint64).  This is 2*i+1 while frame i is being written and
+ * 2*i+2 once it is complete.</li>
+ * <li>bytes 8-15: the step count (int64)</li>
+ * <li>bytes 16-23: the simulation time in ps (double)</li>
+ * <li>bytes 24-31: the potential energy in kJ/mol (double)</li>
+ * <li>bytes 32-39: the kinetic energy in kJ/mol (double)</li>
+ * <li>bytes 40-111: the periodic box vectors in nm (9 doubles)</li>
+ * </ul>
+ *
+ * It is followed by the positions in nm, stored as 3 doubles for each atom.  To read a frame, load the
+ * sequence number, copy the frame, then load the sequence number again.  If the two values are equal and
+ * the first one is 2*i+2, the copy holds a consistent version of frame i.
+ *
+ * Shared memory export is only supported on POSIX systems.  On other operating systems, the constructor
+ * throws an exception.  Errors that happen on the background thread are reported by throwing an exception
+ * from the next call to step(), publishFrame(), or flush().
+ */
+
+class OPENMM_EXPORT SharedMemoryExporter {
+public:
+    /**
+     * Create a SharedMemoryExporter.  This creates the shared memory segment, replacing any existing
+     * segment with the same name.
+     *
+     * @param context             the Context to publish snapshots of.  It must not be deleted while the
+     *                            SharedMemoryExporter exists.
+     * @param name                the name of the shared memory segment.  If it does not begin with "/",
+     *                            one is added.
+     * @param interval            the interval (in time steps) at which to publish frames
+     * @param numSlots            the number of frames the ring buffer can hold
+     * @param includeEnergy       if true, the potential and kinetic energy are included in each frame.  This
+     *                            requires the energy to be computed each time a frame is captured.
+     * @param enforcePeriodicBox  if true, positions are translated so the center of every molecule lies in
+     *                            the same periodic box
+     */
+    SharedMemoryExporter(Context& context, const std::string& name, int interval, int numSlots=16, bool includeEnergy=false,
+            bool enforcePeriodicBox=false);
+    /**
+     * Wait for all frames to be published, then remove the shared memory segment.  Readers that have
+     * already opened it can continue to read the frames it contains.
+     */
+    ~SharedMemoryExporter();
+    /**
+     * Get the name of the shared memory segment.
+     */
+    const std::string& getName() const {
+        return name;
+    }
+    /**
+     * Get the interval (in time steps) at which frames are published.
+     */
+    int getInterval() const {
+        return interval;
+    }
+    /**
+     * Get the number of frames the ring buffer can hold.
+     */
+    int getNumSlots() const {
+        return numSlots;
+    }
+    /**
+     * Get the number of frames that have been captured, including ones that have not yet been published.
+     */
+    long long getNumFrames() const {
+        return numFrames;
+    }
+    /**
+     * Advance the simulation by a number of time steps, publishing a frame each time the Context's
+     * step count is a multiple of the interval.
+     *
+     * @param steps   the number of time steps to take
+     */
+    void step(int steps);
+    /**
+     * Capture the current state and publish it as a new frame.  This returns as soon as the state has
+     * been captured.
+     */
+    void publishFrame();
+    /**
+     * Block until every frame that has been captured has been published.
+     */
+    void flush();
+private:
+    void threadBody();
+    void writeState(const State& state);
+    void checkError();
+    Context& context;
+    std::string name;
+    int interval, numSlots, numAtoms;
+    long long numFrames, numPublished;
+    bool includeEnergy, enforcePeriodicBox, finished, busy;
+    char* memory;
+    size_t memorySize, slotSize;
+    std::deque<std::future<State> > pending;
+    std::thread thread;
+    std::mutex lock;
+    std::condition_variable condition;
+    std::string error;
+};
+
+/**
+ * This class reads frames from a shared memory segment created by a SharedMemoryExporter, which may
+ * be in a different process.
+ */
+
+class OPENMM_EXPORT SharedMemoryReader {
+public:
+    /**
+     * Open a shared memory segment for reading.
+     *
+     * @param name    the name of the shared memory segment, as passed to the SharedMemoryExporter
+     */
+    SharedMemoryReader(const std::string& name);
+    ~SharedMemoryReader();
+    /**
+     * Get the number of atoms in each frame.
+     */
+    int getNumAtoms() const {
+        return numAtoms;
+    }
+    /**
+     * Get the number of frames the ring buffer can hold.
+     */
+    int getNumSlots() const {
+        return numSlots;
+    }
+    /**
+     * Get the number of frames that have been published so far.  Only the most recent getNumSlots()
+     * of them are still available.
+     */
+    long long getNumFrames() const;
+    /**
+     * Read a frame.  The returned State contains the positions, periodic box vectors, step count, and time.
+     * If the exporter was told to include energies, it contains them as well.  An exception is thrown if
+     * the frame has not been published yet, or if it has already been overwritten by a newer one.
+     *
+     * @param frame    the index of the frame to read
+     */
+    State getFrame(long long frame) const;
+    /**
+     * Read the most recently published frame.  An exception is thrown if no frames have been published yet.
+     */
+    State getLatestFrame() const;
+private:
+    bool tryReadFrame(long long frame, State& state) const;
+    int numAtoms, numSlots;
+    bool includeEnergy;
+    char* memory;
+    size_t memorySize, slotSize;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_SHAREDMEMORYEXPORTER_H_*/
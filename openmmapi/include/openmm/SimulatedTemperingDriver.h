@@ -0,0 +1,156 @@
+#ifndef OPENMM_SIMULATEDTEMPERINGDRIVER_H_
+#define OPENMM_SIMULATEDTEMPERINGDRIVER_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "Context.h"
+#include "internal/windowsExport.h"
+#include <string>
+#include <vector>
+
+namespace OpenMM_SFMT {
+    class SFMT;
+}
+
+namespace OpenMM {
+
+/**
+ * This class runs a simulated tempering simulation, in which the temperature of a single Context
+ * moves between a set of temperatures.  At high temperatures it can more easily cross energy
+ * barriers, while at low temperatures it thoroughly explores each local region.  For details, see
+ * Marinari, E. and Parisi, G., Europhys. Lett. 19(6). pp. 451-458 (1992).
+ *
+ * Call step() instead of calling step() on the Integrator.  At regular intervals, specified by
+ * the tempChangeInterval argument, it attempts to move to a new temperature, selected with the
+ * independence sampling method described in Chodera, J. and Shirts, M., J. Chem. Phys. 135, 194110
+ * (2011).  Each attempt only requires the potential energy from the Context.  When the
+ * temperature changes, the velocities are rescaled in place, without transferring them to the host.
+ *
+ * Simulated tempering requires a weight factor for each temperature.  Ideally these should be
+ * chosen so the simulation spends equal time at every temperature.  If they are not specified,
+ * they are selected automatically with the Wang-Landau algorithm as described in Wang, F. and
+ * Landau, D. P., Phys. Rev. Lett. 86(10), pp. 2050-2053 (2001).
+ *
+ * The temperature is applied to the Integrator, which must be one of the thermostated integrators
+ * that has a setTemperature() method, and to the Context parameters used by AndersenThermostat and
+ * the Monte Carlo barostats if they are present.
+ *
+ * This implements the same algorithm as the SimulatedTempering class in the Python application
+ * layer, but performs every attempt in C++ so it adds almost no cost even when attempts are frequent.
+ */
+
+class OPENMM_EXPORT SimulatedTemperingDriver {
+public:
+    /**
+     * Create a SimulatedTemperingDriver.
+     *
+     * @param context             the Context to simulate.  It must not be deleted while the
+     *                            SimulatedTemperingDriver exists.
+     * @param temperatures        the temperatures to use for tempering, in Kelvin, in strictly increasing order
+     * @param weights             the weight factor for each temperature.  If this is empty, the weights
+     *                            are selected automatically.
+     * @param tempChangeInterval  the interval (in time steps) at which to attempt transitions between temperatures
+     * @param randomSeed          the seed for the random number generator used to select temperatures
+     */
+    SimulatedTemperingDriver(Context& context, const std::vector<double>& temperatures, const std::vector<double>& weights=std::vector<double>(),
+            int tempChangeInterval=25, int randomSeed=osrngseed());
+    ~SimulatedTemperingDriver();
+    /**
+     * Advance the simulation by a number of time steps, attempting to change the temperature
+     * whenever the step count reaches a multiple of the temperature change interval.
+     *
+     * @param steps   the number of time steps to take
+     */
+    void step(int steps);
+    /**
+     * Get the number of temperatures.
+     */
+    int getNumTemperatures() const {
+        return temperatures.size();
+    }
+    /**
+     * Get the temperature with a particular index, in Kelvin.
+     *
+     * @param index   the index of the temperature to get
+     */
+    double getTemperature(int index) const;
+    /**
+     * Get the index of the temperature the simulation is currently at.
+     */
+    int getCurrentTemperature() const {
+        return currentTemperature;
+    }
+    /**
+     * Get the current weight factor for each temperature.  They are shifted so that the weight
+     * of the first temperature is 0.
+     */
+    std::vector<double> getWeights() const;
+    /**
+     * Get whether the weights are being selected automatically.
+     */
+    bool getUpdateWeights() const {
+        return updateWeights;
+    }
+    /**
+     * Get the interval (in time steps) at which transitions between temperatures are attempted.
+     */
+    int getTempChangeInterval() const {
+        return tempChangeInterval;
+    }
+    /**
+     * Get the number of transitions to a new temperature that have been attempted.
+     */
+    int getNumAttempted() const {
+        return numAttempted;
+    }
+    /**
+     * Get the number of transitions that have moved to a different temperature.
+     */
+    int getNumAccepted() const {
+        return numAccepted;
+    }
+private:
+    void applyTemperature(int index);
+    void attemptTemperatureChange();
+    Context& context;
+    std::vector<double> temperatures, weights;
+    std::vector<int> histogram;
+    std::vector<std::string> temperatureParameters;
+    OpenMM_SFMT::SFMT* random;
+    int tempChangeInterval, currentTemperature, numAttempted, numAccepted;
+    bool updateWeights, hasMadeTransition;
+    double weightUpdateFactor;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_SIMULATEDTEMPERINGDRIVER_H_*/
@@ -59,7 +59,7 @@ public:
      * This is an enumeration of the types of data which may be stored in a State.  When you create
      * a State, use these values to specify which data types it should contain.
      */
-    enum DataType {Positions=1, Velocities=2, Forces=4, Energy=8, Parameters=16, ParameterDerivatives=32, IntegratorParameters=64};
+    enum DataType {Positions=1, Velocities=2, Forces=4, Energy=8, Parameters=16, ParameterDerivatives=32, IntegratorParameters=64, GroupEnergies=128};
     /**
      * Construct an empty State containing no data.  This exists so State objects can be used in STL containers.
      */
@@ -97,6 +97,12 @@ public:
      * Get the total potential energy of the system.  If this State does not contain energies, this will throw an exception.
      */
     double getPotentialEnergy() const;
+    /**
+     * Get the potential energy of each force group.  The returned vector has 32 elements, with element
+     * i containing the energy of group i.  Groups that were not requested when the State was created
+     * have an energy of 0.  If this State does not contain group energies, this will throw an exception.
+     */
+    const std::vector<double>& getGroupEnergies() const;
     /**
      * Get the vectors defining the axes of the periodic box (measured in nm).
      *
@@ -138,6 +144,7 @@ private:
     void setParameters(const std::map<std::string, double>& params);
     void setEnergyParameterDerivatives(const std::map<std::string, double>& derivs);
     void setEnergy(double ke, double pe);
+    void setGroupEnergies(const std::vector<double>& energies);
     void setPeriodicBoxVectors(const Vec3& a, const Vec3& b, const Vec3& c);
     SerializationNode& updateIntegratorParameters();
     const SerializationNode& getIntegratorParameters() const;
@@ -147,6 +154,7 @@ private:
     std::vector<Vec3> positions;
     std::vector<Vec3> velocities;
     std::vector<Vec3> forces;
+    std::vector<double> groupEnergies;
     Vec3 periodicBoxVectors[3];
     std::map<std::string, double> parameters, energyParameterDerivatives;
     SerializationNode integratorParameters;
@@ -167,6 +175,7 @@ public:
     void setParameters(const std::map<std::string, double>& params);
     void setEnergyParameterDerivatives(const std::map<std::string, double>& params);
     void setEnergy(double ke, double pe);
+    void setGroupEnergies(const std::vector<double>& energies);
     void setPeriodicBoxVectors(const Vec3& a, const Vec3& b, const Vec3& c);
     SerializationNode& updateIntegratorParameters();
 private:
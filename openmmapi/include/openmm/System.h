@@ -33,6 +33,7 @@
  * -------------------------------------------------------------------------- */
 
 #include "Vec3.h"
+#include <memory>
 #include <vector>
 #include "internal/windowsExport.h"
 
@@ -89,6 +90,14 @@ public:
         masses.push_back(mass);
         return masses.size()-1;
     }
+    /**
+     * Add many particles to the System at once.  This is equivalent to calling addParticle() once
+     * for each element of masses, but it is much faster when building large Systems from Python.
+     *
+     * @param masses   the masses of the particles (in atomic mass units)
+     * @return the index of the first particle that was added
+     */
+    int addParticles(const std::vector<double>& masses);
     /**
      * Get the mass (in atomic mass units) of a particle.  If the mass is 0, Integrators will ignore
      * the particle and not modify its position or velocity.  This is most often
@@ -149,6 +158,16 @@ public:
      * @return the index of the constraint that was added
      */
     int addConstraint(int particle1, int particle2, double distance);
+    /**
+     * Add many constraints to the System at once.  This is equivalent to calling addConstraint()
+     * once for each element of the arrays, which must all have the same length.
+     *
+     * @param particle1 the index of the first particle involved in each constraint
+     * @param particle2 the index of the second particle involved in each constraint
+     * @param distance  the required distance between the two particles for each constraint, measured in nm
+     * @return the index of the first constraint that was added
+     */
+    int addConstraints(const std::vector<int>& particle1, const std::vector<int>& particle2, const std::vector<double>& distance);
     /**
      * Get the parameters defining a distance constraint.
      *
@@ -174,6 +193,36 @@ public:
      * @param index    the index of the constraint to remove
      */
     void removeConstraint(int index);
+    /**
+     * Get the number of molecule types that have been declared.
+     */
+    int getNumMoleculeTypes() const {
+        return moleculeTypes.size();
+    }
+    /**
+     * Declare that several ranges of particles are identical copies of the same molecule,
+     * such as all the water molecules in a solvent box.  Each copy consists of numParticles
+     * consecutive particles, starting from one of the indices in firstParticles.
+     *
+     * This is an optional hint.  It does not change how interactions are defined: every
+     * copy must still be added to the System and its Forces in the usual way.  Platforms
+     * may use it to avoid searching for identical molecules themselves, which can take a
+     * significant amount of time when a Context is created for a large solvated System.
+     * They still verify that the copies really are identical before relying on it.
+     *
+     * @param numParticles    the number of particles in each copy of the molecule
+     * @param firstParticles  the index of the first particle of each copy
+     * @return the index of the molecule type that was added
+     */
+    int addMoleculeType(int numParticles, const std::vector<int>& firstParticles);
+    /**
+     * Get the copies of a molecule that were declared with addMoleculeType().
+     *
+     * @param index                the index of the molecule type to get
+     * @param[out] numParticles    the number of particles in each copy of the molecule
+     * @param[out] firstParticles  the index of the first particle of each copy
+     */
+    void getMoleculeTypeParameters(int index, int& numParticles, std::vector<int>& firstParticles) const;
     /**
      * Add a Force to the System.  The Force should have been created on the heap with the
      * "new" operator.  The System takes over ownership of it, and deletes the Force when the
@@ -245,12 +294,17 @@ public:
      */
     bool usesPeriodicBoundaryConditions() const;
 private:
+    friend class ContextImpl;
     class ConstraintInfo;
+    class MoleculeTypeInfo;
+    class MoleculeCache;
     Vec3 periodicBoxVectors[3];
     std::vector<double> masses;
     std::vector<ConstraintInfo> constraints;
+    std::vector<MoleculeTypeInfo> moleculeTypes;
     std::vector<Force*> forces;
     std::vector<VirtualSite*> virtualSites;
+    mutable std::shared_ptr<MoleculeCache> moleculeCache;
 };
 
 /**
@@ -270,6 +324,21 @@ public:
     }
 };
 
+/**
+ * This is an internal class used to record information about a molecule type.
+ * @private
+ */
+class System::MoleculeTypeInfo {
+public:
+    int numParticles;
+    std::vector<int> firstParticles;
+    MoleculeTypeInfo() : numParticles(0) {
+    }
+    MoleculeTypeInfo(int numParticles, const std::vector<int>& firstParticles) :
+        numParticles(numParticles), firstParticles(firstParticles) {
+    }
+};
+
 } // namespace OpenMM
 
 #endif /*OPENMM_SYSTEM_H_*/
@@ -0,0 +1,102 @@
+#ifndef OPENMM_SYSTEMREPLICATOR_H_
+#define OPENMM_SYSTEMREPLICATOR_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "System.h"
+#include "Vec3.h"
+#include "internal/windowsExport.h"
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class packs many independent copies of a small System into a single larger System,
+ * so they can all be simulated in one Context.  When each System has only a few hundred
+ * particles, a GPU spends most of its time launching kernels rather than doing useful work.
+ * Simulating an ensemble of replicas together makes much better use of it.
+ *
+ * Particle i of replica r becomes particle r*n+i of the new System, where n is the number
+ * of particles in the original System.  Every Force is copied, with the interactions of the
+ * original System repeated for each replica.  Replicas are placed a fixed distance apart
+ * along the x axis.  To keep them from interacting, nonbonded forces must use a non-periodic
+ * cutoff, and the spacing must be larger than the cutoff distance plus the size of each
+ * replica.  Forces whose interactions cannot be kept within a single replica, and Forces
+ * this class does not know how to copy, cause an exception to be thrown.
+ *
+ * A CMMotionRemover is copied as a single Force acting on the whole ensemble, so it removes
+ * the center of mass motion of all replicas together rather than of each one individually.
+ */
+
+class OPENMM_EXPORT SystemReplicator {
+public:
+    /**
+     * Create a System containing independent copies of another System.
+     *
+     * @param system       the System to copy
+     * @param numReplicas  the number of copies to create
+     * @param spacing      the distance between adjacent replicas along the x axis, in nm
+     * @return a newly created System.  The caller assumes ownership of it.
+     */
+    static System* createSystem(const System& system, int numReplicas, double spacing);
+    /**
+     * Combine the positions of all replicas into positions for the System created by
+     * createSystem(), moving each replica to its place along the x axis.
+     *
+     * @param positions  the positions of the particles in each replica.  The number of elements
+     *                   determines the number of replicas.
+     * @param spacing    the distance between adjacent replicas, which should equal the value
+     *                   passed to createSystem()
+     */
+    static std::vector<Vec3> combinePositions(const std::vector<std::vector<Vec3> >& positions, double spacing);
+    /**
+     * Divide per-particle values for the System created by createSystem(), such as the
+     * velocities or forces retrieved from a State, into separate values for each replica.
+     *
+     * @param values       the values for every particle in the combined System
+     * @param numReplicas  the number of replicas
+     */
+    static std::vector<std::vector<Vec3> > splitValues(const std::vector<Vec3>& values, int numReplicas);
+    /**
+     * Divide the positions of the System created by createSystem() into separate positions for
+     * each replica, undoing the offset added by combinePositions().
+     *
+     * @param positions    the positions of every particle in the combined System
+     * @param numReplicas  the number of replicas
+     * @param spacing      the distance between adjacent replicas
+     */
+    static std::vector<std::vector<Vec3> > splitPositions(const std::vector<Vec3>& positions, int numReplicas, double spacing);
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_SYSTEMREPLICATOR_H_*/
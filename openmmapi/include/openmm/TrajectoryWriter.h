@@ -0,0 +1,139 @@
+#ifndef OPENMM_TRAJECTORYWRITER_H_
+#define OPENMM_TRAJECTORYWRITER_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "Context.h"
+#include "State.h"
+#include "internal/windowsExport.h"
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class writes a trajectory to a DCD file while a simulation runs.  Call step() instead of
+ * calling step() on the Integrator directly.  It advances the Context, and every time the step
+ * count reaches a multiple of the output interval it captures the positions.  Converting them to
+ * the file format and writing them happens on a background thread, while the Integrator continues
+ * taking time steps.  On platforms that support it, even the transfer of positions from the device
+ * happens in the background (see Context::getStateAsync()).
+ *
+ * The file is written in the same format as DCDFile in the Python application layer: the CHARMM
+ * version of DCD, with little-endian byte ordering, positions in Angstroms, and unit cell information
+ * for periodic Systems.
+ *
+ * Errors that happen on the background thread, such as a failure writing the file or a position
+ * that is NaN, are reported by throwing an exception from the next call to step(), writeFrame(),
+ * or flush().
+ */
+
+class OPENMM_EXPORT TrajectoryWriter {
+public:
+    /**
+     * Create a TrajectoryWriter.
+     *
+     * @param context             the Context to write a trajectory for.  It must not be deleted
+     *                            while the TrajectoryWriter exists.
+     * @param filename            the path of the DCD file to write
+     * @param interval            the interval (in time steps) at which to write frames
+     * @param enforcePeriodicBox  if true, positions are translated so the center of every molecule
+     *                            lies in the same periodic box
+     * @param atomSubset          the indices of the particles to write.  If this is empty, all
+     *                            particles are written.
+     * @param append              if true, frames are appended to an existing DCD file.  Otherwise a
+     *                            new file is created.
+     */
+    TrajectoryWriter(Context& context, const std::string& filename, int interval, bool enforcePeriodicBox=false,
+            const std::vector<int>& atomSubset=std::vector<int>(), bool append=false);
+    /**
+     * Wait for all frames to be written, then close the file.
+     */
+    ~TrajectoryWriter();
+    /**
+     * Get the interval (in time steps) at which frames are written.
+     */
+    int getInterval() const {
+        return interval;
+    }
+    /**
+     * Get the number of frames in the file, including ones that have been captured but not yet written.
+     */
+    int getNumFrames() const {
+        return numFrames;
+    }
+    /**
+     * Advance the simulation by a number of time steps, writing a frame each time the Context's
+     * step count is a multiple of the interval.
+     *
+     * @param steps   the number of time steps to take
+     */
+    void step(int steps);
+    /**
+     * Capture the current positions and add a frame for them to the file.  This returns as soon as
+     * the positions have been captured.
+     */
+    void writeFrame();
+    /**
+     * Block until every frame that has been captured has been written to disk.
+     */
+    void flush();
+private:
+    void threadBody();
+    void writeHeader();
+    void writeState(const State& state);
+    void updateHeader();
+    void checkError();
+    Context& context;
+    int interval, numAtoms, numFrames, numWritten, firstStep, stepInterval;
+    bool enforcePeriodicBox, periodic, finished, busy;
+    float timeStep;
+    std::vector<int> atomSubset;
+    std::vector<float> buffer;
+    std::fstream file;
+    std::vector<char> fileBuffer;
+    std::deque<std::future<State> > pending;
+    std::thread thread;
+    std::mutex lock;
+    std::condition_variable condition;
+    std::string error;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_TRAJECTORYWRITER_H_*/
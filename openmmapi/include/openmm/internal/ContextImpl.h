@@ -9,7 +9,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2008-2022 Stanford University and the Authors.      *
+ * Portions copyright (c) 2008-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -34,13 +34,19 @@
 
 #include "openmm/Kernel.h"
 #include "openmm/Platform.h"
+#include "openmm/State.h"
 #include "openmm/Vec3.h"
+#include <functional>
+#include <future>
 #include <iosfwd>
 #include <map>
+#include <mutex>
+#include <utility>
 #include <vector>
 
 namespace OpenMM {
 
+class Force;
 class ForceImpl;
 class Integrator;
 class Context;
@@ -106,6 +112,14 @@ public:
      * @param positions  on exit, this contains the particle positions
      */
     void getPositions(std::vector<Vec3>& positions);
+    /**
+     * Get the positions of all particles, rounded to a fixed precision.  Each coordinate is
+     * within precision/2 of its full precision value.
+     *
+     * @param precision  the precision to which coordinates are rounded, in nm
+     * @param positions  on exit, this contains the particle positions
+     */
+    void getQuantizedPositions(double precision, std::vector<Vec3>& positions);
     /**
      * Set the positions of all particles.
      *
@@ -124,12 +138,57 @@ public:
      * @param velocities  a vector containg the particle velocities
      */
     void setVelocities(const std::vector<Vec3>& velocities);
+    /**
+     * Multiply the velocities of all particles by a constant factor.  On Platforms that support
+     * it, this is done without transferring the velocities to the host.
+     *
+     * @param scale      the factor to multiply the velocities by
+     */
+    void scaleVelocities(double scale);
+    /**
+     * Notify the Integrator that part of the state was modified by a kernel acting on it directly,
+     * rather than through the methods of this class.
+     *
+     * @param changed    the part of the state that was modified
+     */
+    void notifyStateChanged(State::DataType changed);
     /**
      * Get the current forces on all particles.
      *
      * @param forces  on exit, this contains the forces
      */
     void getForces(std::vector<Vec3>& forces);
+    /**
+     * Get the positions of a subset of particles.
+     *
+     * @param particles  the indices of the particles to retrieve
+     * @param positions  on exit, element i contains the position of particle particles[i]
+     */
+    void getParticlePositions(const std::vector<int>& particles, std::vector<Vec3>& positions);
+    /**
+     * Get the velocities of a subset of particles.
+     *
+     * @param particles   the indices of the particles to retrieve
+     * @param velocities  on exit, element i contains the velocity of particle particles[i]
+     */
+    void getParticleVelocities(const std::vector<int>& particles, std::vector<Vec3>& velocities);
+    /**
+     * Get the current forces on a subset of particles.
+     *
+     * @param particles  the indices of the particles to retrieve
+     * @param forces     on exit, element i contains the force on particle particles[i]
+     */
+    void getParticleForces(const std::vector<int>& particles, std::vector<Vec3>& forces);
+    /**
+     * Begin retrieving the positions, velocities, and/or forces without waiting for them to be
+     * transferred to the host.  This returns a function that, when invoked (possibly on a different
+     * thread), blocks until the data is available and stores it in its arguments.
+     *
+     * @param positions   whether to retrieve the positions
+     * @param velocities  whether to retrieve the velocities
+     * @param forces      whether to retrieve the forces
+     */
+    std::function<void(std::vector<Vec3>&, std::vector<Vec3>&, std::vector<Vec3>&)> getStateDataAsync(bool positions, bool velocities, bool forces);
     /**
      * Get the set of all adjustable parameters and their values
      */
@@ -195,6 +254,17 @@ public:
      * constraints.
      */
     void computeVirtualSites();
+    /**
+     * Perform a local energy minimization with a MinimizeKernel, if the Platform provides one.  The
+     * kernel is created the first time this is called.
+     *
+     * @param tolerance      the convergence criterion, as defined by LocalEnergyMinimizer::minimize()
+     * @param maxIterations  the maximum number of iterations to perform, or 0 for no limit
+     * @return true if the minimization was completed.  If this returns false, either the Platform has no
+     * MinimizeKernel or the kernel was unable to finish, and the caller should minimize the current
+     * positions by other means.
+     */
+    bool minimize(double tolerance, int maxIterations);
     /**
      * Recalculate all of the forces in the system and/or the potential energy of the system (in kJ/mol).
      * After calling this, use getForces() to retrieve the forces that were calculated.
@@ -206,6 +276,17 @@ public:
      * @return the potential energy of the system, or 0 if includeEnergy is false
      */
     double calcForcesAndEnergy(bool includeForces, bool includeEnergy, int groups=0xFFFFFFFF);
+    /**
+     * Calculate the potential energy of each force group (in kJ/mol).  Only the energy is computed,
+     * and groups that do not contain any forces are skipped without doing any work.  Because this
+     * changes the forces stored in the Context, use calcForcesAndEnergy() before retrieving them.
+     *
+     * @param groups    a set of bit flags for which force groups to include.  Group i will be included
+     *                  if (groups&(1<<i)) != 0.
+     * @param energies  on exit, this has 32 elements, with element i containing the energy of group i.
+     *                  Groups that were not included have an energy of 0.
+     */
+    void calcGroupEnergies(int groups, std::vector<double>& energies);
     /**
      * Get the set of force group flags that were passed to the most recent call to calcForcesAndEnergy().
      * 
@@ -258,18 +339,44 @@ public:
      * same molecule if they are connected by constraints or bonds.
      */
     const std::vector<std::vector<int> >& getMolecules() const;
+    /**
+     * Get the Force whose ForceImpl is currently being initialized.  This allows a Platform to know which
+     * Force a resource is being created for.  While the Context is not initializing Forces, this returns NULL.
+     */
+    const Force* getInitializingForce() const {
+        return initializingForce;
+    }
     /**
      * Create a checkpoint recording the current state of the Context.
      * 
      * @param stream    an output stream the checkpoint data should be written to
+     * @param compress  whether to compress the checkpoint data
      */
-    void createCheckpoint(std::ostream& stream);
+    void createCheckpoint(std::ostream& stream, bool compress=false);
+    /**
+     * Create a checkpoint, compressing and writing it on a background thread.
+     * 
+     * @param stream    an output stream the checkpoint data should be written to
+     * @param compress  whether to compress the checkpoint data
+     */
+    std::future<void> createCheckpointAsync(std::ostream& stream, bool compress);
     /**
      * Load a checkpoint that was written by createCheckpoint().
      * 
      * @param stream    an input stream the checkpoint data should be read from
      */
     void loadCheckpoint(std::istream& stream);
+    /**
+     * Start integrating time steps on a background thread.  See Context::stepAsync().
+     *
+     * @param steps   the number of time steps to take
+     */
+    void stepAsync(int steps);
+    /**
+     * Wait for steps started by stepAsync() to finish, rethrowing any exception they produced.
+     * When called from the thread that is taking the steps, this returns immediately.
+     */
+    void waitForSteps();
     /**
      * This is invoked by the Integrator when it is deleted.  This is needed to ensure the cleanup process
      * is done correctly, since we don't know whether the Integrator or Context will be deleted first.
@@ -286,6 +393,17 @@ public:
      * you should never call it.  It is exposed here because the same logic is useful to other classes too.
      */
     static std::vector<std::vector<int> > findMolecules(int numParticles, std::vector<std::vector<int> >& particleBonds);
+    /**
+     * Identify the molecules formed by a set of bonds.  This is equivalent to the other version of findMolecules(),
+     * but takes a flat list of bonds.
+     *
+     * @param numParticles   the number of particles in the system
+     * @param bonds          every pair of particles that are bonded to each other.  Each pair only needs to be
+     *                       listed once, and duplicates are allowed.
+     * @return the particles in each molecule.  Molecules are sorted by their lowest particle index, and the particles
+     * within each molecule are in increasing order.
+     */
+    static std::vector<std::vector<int> > findMolecules(int numParticles, const std::vector<std::pair<int, int> >& bonds);
     /**
      * Create a new Context based on this one.  The new context will use the same Platform, device, and property
      * values as this one.  With the CUDA and OpenCL platforms, it also shares the same GPU context, allowing data
@@ -304,11 +422,14 @@ private:
     std::vector<ForceImpl*> forceImpls;
     std::map<std::string, double> parameters;
     mutable std::vector<std::vector<int> > molecules;
-    bool hasInitializedForces, hasSetPositions, integratorIsDeleted;
+    bool hasInitializedForces, hasSetPositions, integratorIsDeleted, hasCreatedMinimizeKernel;
     int lastForceGroups;
+    const Force* initializingForce;
     Platform* platform;
-    Kernel initializeForcesKernel, updateStateDataKernel, applyConstraintsKernel, virtualSitesKernel;
+    Kernel initializeForcesKernel, updateStateDataKernel, applyConstraintsKernel, virtualSitesKernel, minimizeKernel;
     void* platformData;
+    std::future<void> pendingSteps;
+    std::mutex pendingStepsLock;
 };
 
 } // namespace OpenMM
@@ -55,10 +55,57 @@ namespace OpenMM {
  * own public APIs.  In that case, there is little opportunity for optimization.
  * This class allows you to write a single implementation that is automatically
  * used for all platforms.
+ *
+ * When the external library can itself run on the GPU, you can also override
+ * computeForceOnDevice().  On the CUDA, HIP, and OpenCL platforms it is given
+ * direct access to the device memory holding positions and forces, so the
+ * calculation does not require copying data to and from the host.
  */
 
 class OPENMM_EXPORT CustomCPPForceImpl : public ForceImpl {
 public:
+    /**
+     * This describes the device memory in which a GPU based platform stores positions and
+     * forces.  All handles are platform-specific objects cast to void*: CUdeviceptr and CUstream
+     * on CUDA, hipDeviceptr_t and hipStream_t on HIP, or cl_mem and cl_command_queue on OpenCL.
+     *
+     * Particles are stored in a different order from the System, which changes as the simulation
+     * runs.  Element i of every array corresponds to the particle whose index in the System is
+     * atomIndex[i].
+     */
+    struct DeviceData {
+        /**
+         * The name of the Platform: "CUDA", "HIP", or "OpenCL"
+         */
+        std::string platformName;
+        /**
+         * The queue on which to enqueue work.  Work added to it executes in order with the
+         * Platform's own kernels.
+         */
+        void* queue;
+        /**
+         * The positions (x, y, z) and charge (w) of each particle, stored as float4, or as double4
+         * when useDoublePrecision is true
+         */
+        void* posq;
+        /**
+         * When useMixedPrecision is true, this array of float4 holds the low order bits of the
+         * positions, which must be added to the values in posq.  Otherwise it is NULL.
+         */
+        void* posqCorrection;
+        /**
+         * The force buffer, containing 3*paddedNumParticles 64 bit integers in fixed point format
+         * (force times 2^32).  It stores all x components, then all y components, then all z
+         * components.  Add to the values already present, since other forces also write to it.
+         */
+        void* forces;
+        /**
+         * An array of 32 bit integers giving the System index of the particle stored in each element
+         */
+        void* atomIndex;
+        int numParticles, paddedNumParticles;
+        bool useDoublePrecision, useMixedPrecision;
+    };
     CustomCPPForceImpl(const Force& owner);
     /**
      * Subclasses may override this to do their own initialization, but they should
@@ -79,6 +126,23 @@ public:
      * force does not contribute to potential energy
      */
     virtual double computeForce(ContextImpl& context, const std::vector<Vec3>& positions, std::vector<Vec3>& forces) = 0;
+    /**
+     * Override this to compute the forces directly on the device.  It is called on the CUDA, HIP,
+     * and OpenCL platforms (when the Context uses a single device) in place of computeForce().
+     * Enqueue the calculation on the queue in data, adding the forces into the force buffer.
+     * Nothing needs to be synchronized, unless the energy must be returned.
+     *
+     * @param context        the context in which the system is being simulated
+     * @param data           describes where the positions and forces are stored
+     * @param includeForces  true if forces should be calculated
+     * @param includeEnergy  true if the energy should be calculated
+     * @param energy         if includeEnergy is true, store this force's contribution to the
+     *                       potential energy into this
+     * @return true if the forces were computed, or false to fall back to computeForce()
+     */
+    virtual bool computeForceOnDevice(ContextImpl& context, const DeviceData& data, bool includeForces, bool includeEnergy, double& energy) {
+        return false;
+    }
     /**
      * Override this if the force updates the context state directly.  In general
      * it should only make changes by invoking public methods of the ContextImpl.
@@ -40,6 +40,7 @@
 #include "lepton/CompiledVectorExpression.h"
 #include <utility>
 #include <map>
+#include <memory>
 #include <string>
 
 namespace OpenMM {
@@ -64,6 +65,8 @@ public:
     std::map<std::string, double> getDefaultParameters();
     std::vector<std::string> getKernelNames();
     void updateParametersInContext(ContextImpl& context, int firstParticle, int lastParticle);
+    double computeEnergyChange(ContextImpl& context, const std::vector<int>& particles, const std::vector<Vec3>& newPositions) const;
+    double computeParticleEnergy(ContextImpl& context, const std::vector<int>& particles) const;
     /**
      * Prepare for computing the long range correction.  This function pre-computes anything
      * that depends only on the Force (such as particle parameters) but not on information in
@@ -71,18 +74,38 @@ public:
      * more quickly when global parameters change.
      */
     static LongRangeCorrectionData prepareLongRangeCorrection(const CustomNonbondedForce& force, int numThreads);
+    /**
+     * Prepare for computing the long range correction after the Force's parameters have changed.
+     * Integrals that were already computed with the previous data are kept if they are still valid,
+     * so only pairs of particle classes whose parameters changed need to be integrated again.
+     */
+    static LongRangeCorrectionData prepareLongRangeCorrection(const CustomNonbondedForce& force, int numThreads, LongRangeCorrectionData& previous);
     /**
      * Compute the coefficient which, when divided by the periodic box volume, gives the
      * long range correction to the energy.  If the Force computes parameter derivatives,
-     * also compute the corresponding derivatives of the correction.
+     * also compute the corresponding derivatives of the correction.  The integral for each
+     * pair of particle classes is cached, so returning to a previous set of global parameter
+     * values does not require any integrals to be recomputed.
      */
     static void calcLongRangeCorrection(const CustomNonbondedForce& force, LongRangeCorrectionData& data, const Context& context, double& coefficient, std::vector<double>& derivatives, ThreadPool& threads);
 private:
     static double integrateInteraction(Lepton::CompiledVectorExpression& expression, const std::vector<double>& params1, const std::vector<double>& params2,
             const std::vector<double>& computedValues1, const std::vector<double>& computedValues2, const CustomNonbondedForce& force, const Context& context,
             const std::vector<std::string>& paramNames, const std::vector<std::string>& computedValueNames);
+    class LocalEnergyData;
+    static bool integralsAreCompatible(const LongRangeCorrectionData& data1, const LongRangeCorrectionData& data2);
+    /**
+     * Compute the sum of all interactions that involve at least one of the specified particles.
+     */
+    double computeLocalEnergy(ContextImpl& context, const std::vector<Vec3>& positions, const std::vector<int>& particles) const;
+    /**
+     * Get the compiled expressions and per-particle data used by computeLocalEnergy(), creating them
+     * the first time it is called.  Computed values are reevaluated if any global parameter has changed.
+     */
+    LocalEnergyData& getLocalEnergyData(ContextImpl& context) const;
     const CustomNonbondedForce& owner;
     Kernel kernel;
+    mutable std::unique_ptr<LocalEnergyData> localEnergyData;
 };
 
 class CustomNonbondedForceImpl::LongRangeCorrectionData {
@@ -94,6 +117,18 @@ public:
     std::vector<Lepton::CompiledVectorExpression> energyExpression;
     std::vector<std::vector<Lepton::CompiledVectorExpression> > derivExpressions;
     std::vector<Lepton::CompiledExpression> computedValueExpressions;
+    /**
+     * Everything other than the particle classes and global parameters that affects the integrals.
+     * This is used to decide whether cached integrals can be reused after the Force changes.
+     */
+    std::vector<std::string> definition;
+    std::vector<std::pair<std::string, std::shared_ptr<TabulatedFunction> > > functions;
+    /**
+     * Cached integrals.  The key contains the global parameter values followed by the parameters of
+     * the two classes.  The value contains the energy integral followed by the integrals for each
+     * parameter derivative.
+     */
+    std::map<std::vector<double>, std::vector<double> > integralCache;
 };
 
 } // namespace OpenMM
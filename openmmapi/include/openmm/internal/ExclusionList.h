@@ -0,0 +1,176 @@
+#ifndef OPENMM_EXCLUSION_LIST_H_
+#define OPENMM_EXCLUSION_LIST_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "windowsExport.h"
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace OpenMM {
+
+class ThreadPool;
+
+/**
+ * This class records which atoms each atom should not interact with.  It stores them in compressed
+ * sparse row format: the exclusions of every atom are kept as a sorted list in a single shared
+ * array.  This takes much less memory than a std::set for each atom, and is much faster to build.
+ *
+ * Exclusions are always symmetric: if atom j is excluded from atom i, atom i is also excluded
+ * from atom j.  Indexing the list with [] returns a lightweight range over the exclusions of one
+ * atom, which can be iterated over like the std::set it replaces.
+ */
+class OPENMM_EXPORT ExclusionList {
+public:
+    class Range;
+    /**
+     * Create an empty ExclusionList with no atoms.
+     */
+    ExclusionList();
+    /**
+     * Create an ExclusionList for a set of atoms that have no exclusions.
+     *
+     * @param numAtoms   the number of atoms
+     */
+    explicit ExclusionList(int numAtoms);
+    /**
+     * Create an ExclusionList from a list of excluded pairs.  Each pair is recorded for both atoms,
+     * and duplicate pairs are allowed.
+     *
+     * @param numAtoms   the number of atoms
+     * @param pairs      the pairs of atoms that are excluded from interacting with each other
+     */
+    ExclusionList(int numAtoms, const std::vector<std::pair<int, int> >& pairs);
+    /**
+     * Create an ExclusionList from a list of excluded pairs, using a ThreadPool to sort the
+     * exclusions of each atom in parallel.  Each pair is recorded for both atoms, and duplicate
+     * pairs are allowed.
+     *
+     * @param numAtoms   the number of atoms
+     * @param pairs      the pairs of atoms that are excluded from interacting with each other
+     * @param threads    used for parallelization
+     */
+    ExclusionList(int numAtoms, const std::vector<std::pair<int, int> >& pairs, ThreadPool& threads);
+    /**
+     * Create an ExclusionList from a set of exclusions for each atom.  The sets must already be
+     * symmetric.
+     *
+     * @param exclusions  exclusions[i] contains the indices of all atoms with which atom i should not interact
+     */
+    explicit ExclusionList(const std::vector<std::set<int> >& exclusions);
+    /**
+     * Get the number of atoms.
+     */
+    int getNumAtoms() const {
+        return offsets.size()-1;
+    }
+    /**
+     * Get the total number of exclusions summed over all atoms.  Every excluded pair is counted twice.
+     */
+    int getTotalExclusions() const {
+        return indices.size();
+    }
+    /**
+     * Get the exclusions of one atom.
+     */
+    Range operator[](int atom) const;
+    /**
+     * Get whether two atoms are excluded from interacting with each other.
+     */
+    bool isExcluded(int atom1, int atom2) const;
+    /**
+     * Find every pair of atoms that is separated by a path of at most maxSeparation bonds.  The bond
+     * graph is stored in compressed form and each atom is searched independently, so this scales to
+     * very large systems and runs in parallel when there are many atoms.
+     *
+     * @param numAtoms       the number of atoms
+     * @param bonds          the pairs of atoms that are bonded to each other
+     * @param maxSeparation  the maximum number of bonds separating a pair
+     * @param pairs          on exit, every pair (j, i) with j < i that is separated by at most maxSeparation
+     *                       bonds.  They are sorted by i, then by j.
+     * @param separation     on exit, separation[k] is the smallest number of bonds separating the atoms in pairs[k]
+     */
+    static void findBondedPairs(int numAtoms, const std::vector<std::pair<int, int> >& bonds, int maxSeparation,
+            std::vector<std::pair<int, int> >& pairs, std::vector<int>& separation);
+    bool operator==(const ExclusionList& other) const {
+        return (offsets == other.offsets && indices == other.indices);
+    }
+    bool operator!=(const ExclusionList& other) const {
+        return !(*this == other);
+    }
+private:
+    void initialize(int numAtoms, const std::vector<std::pair<int, int> >& pairs, ThreadPool* threads);
+    std::vector<int> offsets, indices;
+};
+
+/**
+ * The sorted exclusions of a single atom in an ExclusionList.  This provides the subset of the
+ * std::set interface needed to iterate over and query them.
+ */
+class OPENMM_EXPORT ExclusionList::Range {
+public:
+    Range(const int* first, const int* last) : first(first), last(last) {
+    }
+    const int* begin() const {
+        return first;
+    }
+    const int* end() const {
+        return last;
+    }
+    int size() const {
+        return last-first;
+    }
+    bool empty() const {
+        return first == last;
+    }
+    /**
+     * Get the number of times an atom appears in the range, which is either 0 or 1.
+     */
+    int count(int atom) const;
+private:
+    const int* first;
+    const int* last;
+};
+
+inline ExclusionList::Range ExclusionList::operator[](int atom) const {
+    const int* data = indices.data();
+    return Range(data+offsets[atom], data+offsets[atom+1]);
+}
+
+inline bool ExclusionList::isExcluded(int atom1, int atom2) const {
+    return ((*this)[atom1].count(atom2) != 0);
+}
+
+} // namespace OpenMM
+
+#endif // OPENMM_EXCLUSION_LIST_H_
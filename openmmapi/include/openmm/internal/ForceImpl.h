@@ -34,6 +34,7 @@
 
 #include "openmm/Context.h"
 #include "openmm/internal/windowsExport.h"
+#include <iosfwd>
 #include <map>
 #include <string>
 #include <utility>
@@ -96,11 +97,28 @@ public:
      * force does not contribute to potential energy (or if includeEnergy is false)
      */
     virtual double calcForcesAndEnergy(ContextImpl& context, bool includeForces, bool includeEnergy, int groups) = 0;
+    /**
+     * Get the set of force groups this ForceImpl contributes to, as a set of bit flags.  Group i is
+     * included if (groups&(1<<i)) != 0.  The default implementation returns the group of the owning
+     * Force.  Subclasses that split their calculation across several groups should override it.
+     */
+    virtual int getForceGroups() const;
     /**
      * Get a map containing the default values for all adjustable parameters defined by this ForceImpl.  These
      * parameters and their default values will automatically be added to the Context.
      */
     virtual std::map<std::string, double> getDefaultParameters() = 0;
+    /**
+     * This is called whenever setParameter() is called on the Context, after the new value has been stored.
+     * It is also called for every parameter whose value is changed by loading a checkpoint.  It allows a ForceImpl whose parameters depend on a global parameter in ways the kernels cannot
+     * evaluate to update them.  The default implementation does nothing.
+     *
+     * @param context   the context in which the system is being simulated
+     * @param name      the name of the parameter that was set
+     * @param value     the new value of the parameter
+     */
+    virtual void contextParameterChanged(ContextImpl& context, const std::string& name, double value) {
+    }
     /**
      * Get the names of all Kernels used by this Force.
      */
@@ -112,6 +130,27 @@ public:
     virtual std::vector<std::pair<int, int> > getBondedParticles() const {
         return std::vector<std::pair<int, int> >(0);
     }
+    /**
+     * Write any internal state that should be preserved in a checkpoint, such as information the kernels
+     * accumulate from previous steps.  This is called by Context::createCheckpoint().  The default
+     * implementation writes nothing.
+     *
+     * @param context   the context in which the system is being simulated
+     * @param stream    an output stream the data should be written to
+     */
+    virtual void createCheckpoint(ContextImpl& context, std::ostream& stream) {
+    }
+    /**
+     * Load internal state that was written by createCheckpoint().  This is only called if createCheckpoint()
+     * wrote a non-empty block of data, and the stream contains exactly that data.  If it no longer matches
+     * the Force (for example, because the System was modified before reinitializing the Context), the data
+     * should be ignored.
+     *
+     * @param context   the context in which the system is being simulated
+     * @param stream    an input stream the data should be read from
+     */
+    virtual void loadCheckpoint(ContextImpl& context, std::istream& stream) {
+    }
 protected:
     /**
      * Get the ContextImpl corresponding to a Context.
@@ -35,9 +35,13 @@
 #include "ForceImpl.h"
 #include "openmm/NonbondedForce.h"
 #include "openmm/Kernel.h"
+#include <complex>
+#include <map>
+#include <memory>
 #include <utility>
 #include <set>
 #include <string>
+#include <vector>
 
 namespace OpenMM {
 
@@ -59,11 +63,25 @@ public:
         // This force field doesn't update the state directly.
     }
     double calcForcesAndEnergy(ContextImpl& context, bool includeForces, bool includeEnergy, int groups);
+    int getForceGroups() const {
+        return (1<<forceGroup) | (1<<recipForceGroup);
+    }
     std::map<std::string, double> getDefaultParameters();
+    void contextParameterChanged(ContextImpl& context, const std::string& name, double value);
     std::vector<std::string> getKernelNames();
     void updateParametersInContext(ContextImpl& context, int firstParticle, int lastParticle, int firstException, int lastException);
     void getPMEParameters(double& alpha, int& nx, int& ny, int& nz) const;
     void getLJPMEParameters(double& alpha, int& nx, int& ny, int& nz) const;
+    double computeInteractionEnergy(ContextImpl& context, const std::vector<int>& set1, const std::vector<int>& set2) const;
+    double computeEnergyChange(ContextImpl& context, const std::vector<int>& particles, const std::vector<Vec3>& newPositions) const;
+    double computeParticleEnergy(ContextImpl& context, const std::vector<int>& particles) const;
+    void computeStateEnergies(ContextImpl& context, const std::vector<std::string>& parameters, const std::vector<std::vector<double> >& values,
+            std::vector<double>& energies) const;
+    double computeTitrationEnergyChange(ContextImpl& context, int site, int state) const;
+    /**
+     * Get the name of the global parameter that controls the offsets for one state of a titration site.
+     */
+    static std::string getTitrationStateParameter(const std::string& siteParameter, int state);
     /**
      * This is a utility routine that calculates the values to use for alpha and kmax when using
      * Ewald summation.
@@ -84,10 +102,87 @@ private:
     class EwaldErrorFunction;
     static int findZero(const ErrorFunction& f, int initialGuess);
     static double evalIntegral(double r, double rs, double rc, double sigma);
+    std::map<std::string, double> getGlobalParameterValues(ContextImpl& context) const;
+    /**
+     * Get the force whose parameters are passed to the kernel.  If there are titration sites, this is a copy
+     * of the owner with parameter offsets added for the titration states.  Otherwise it is the owner.
+     */
+    const NonbondedForce& getForce() const {
+        return (titrationForce ? *titrationForce : owner);
+    }
+    /**
+     * Create the copy of the owner that represents titration states with parameter offsets.
+     */
+    void createTitrationForce();
+    /**
+     * Record which particles, exceptions, and parameter offsets involve the solute, and discard the
+     * scaled copy of the force.  This must be called whenever the force passed to the kernel changes.
+     */
+    void findSoluteParameters();
+    /**
+     * Copy parameters to the kernel, first applying solute scaling if the solute scale parameter is not 1.
+     */
+    void copyScaledParametersToContext(ContextImpl& context, int firstParticle, int lastParticle, int firstException, int lastException);
+    /**
+     * Get the factor by which the chargeProd and epsilon of an exception are multiplied for solute scaling.
+     */
+    double getExceptionSoluteScale(int exception, double scale) const;
+    /**
+     * Compute the charges and Lennard-Jones parameters of all particles and exceptions, including the
+     * offsets for the specified values of global parameters.
+     */
+    void getEffectiveParameters(const std::map<std::string, double>& globalValues, std::vector<double>& charge, std::vector<double>& sigma,
+            std::vector<double>& epsilon, std::vector<std::vector<double> >& exceptionParams) const;
+    /**
+     * Compute the direct space energy of a pair of particles that is not an exception.  If alpha is 0,
+     * the reaction field approximation is used for cutoff methods.
+     */
+    double computePairEnergy(double r, double chargeProd, double sigma, double epsilon, double alpha) const;
+    double computePairEnergy(int p1, int p2, const std::vector<Vec3>& positions, const Vec3* boxVectors, const std::vector<double>& charge,
+            const std::vector<double>& sigma, const std::vector<double>& epsilon, double alpha) const;
+    /**
+     * Compute the energy of an exception.  If alpha is not 0, this includes removing the interaction that
+     * is implicitly included in reciprocal space, for which chargeProd is the product of the particle charges.
+     */
+    double computeExceptionEnergy(double r, const std::vector<double>& params, double chargeProd, double alpha) const;
+    double computeExceptionEnergy(int p1, int p2, const std::vector<double>& params, const std::vector<Vec3>& positions, const Vec3* boxVectors,
+            const std::vector<double>& charge, double alpha) const;
+    void getEwaldParameters(ContextImpl& context, double& alpha, int kmax[3]) const;
+    void computeStructureFactors(const std::vector<Vec3>& positions, const std::vector<double>& charge, const std::vector<int>& particles,
+            const Vec3* boxVectors, const int kmax[3], std::vector<std::complex<double> >& structureFactors) const;
+    double computeReciprocalEnergy(const std::vector<std::complex<double> >& structureFactors, double totalCharge, const Vec3* boxVectors,
+            double alpha, const int kmax[3]) const;
+    /**
+     * Get the structure factors of all particles.  They are cached between calls.  When the box and wave
+     * vectors are unchanged, only the contributions of particles whose positions or charges have changed
+     * since the last call are recomputed.
+     */
+    const std::vector<std::complex<double> >& getStructureFactors(const std::vector<Vec3>& positions, const std::vector<double>& charge,
+            const Vec3* boxVectors, const int kmax[3]) const;
+    void prepareLocalEnergy(ContextImpl& context, const std::vector<int>& particles, std::vector<bool>& inSubset, std::vector<double>& charge,
+            std::vector<double>& sigma, std::vector<double>& epsilon, std::vector<std::vector<double> >& exceptionParams,
+            std::vector<std::vector<std::pair<int, int> > >& particleExceptions) const;
+    /**
+     * Compute all direct space and self energy terms that involve at least one of the specified particles.
+     */
+    double computeLocalEnergy(const std::vector<Vec3>& positions, const Vec3* boxVectors, const std::vector<int>& particles, const std::vector<bool>& inSubset,
+            const std::vector<double>& charge, const std::vector<double>& sigma, const std::vector<double>& epsilon,
+            const std::vector<std::vector<double> >& exceptionParams, const std::vector<std::vector<std::pair<int, int> > >& particleExceptions, double alpha) const;
     const NonbondedForce& owner;
     Kernel kernel;
     int recipForceGroup;
     bool includeDirectSpace;
+    std::vector<bool> isSolute;
+    std::vector<int> soluteParticles, soluteExceptions, soluteParticleOffsets, soluteExceptionOffsets;
+    double soluteScale;
+    std::unique_ptr<NonbondedForce> scaledForce;
+    std::unique_ptr<NonbondedForce> titrationForce;
+    std::map<std::string, int> siteIndex;
+    mutable std::vector<std::complex<double> > cachedStructureFactors;
+    mutable std::vector<Vec3> cachedPositions;
+    mutable std::vector<double> cachedCharges;
+    mutable Vec3 cachedBoxVectors[3];
+    mutable int cachedKmax[3], cachedUpdateCount;
 };
 
 } // namespace OpenMM
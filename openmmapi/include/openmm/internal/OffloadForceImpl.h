@@ -0,0 +1,73 @@
+#ifndef OPENMM_OFFLOADFORCEIMPL_H_
+#define OPENMM_OFFLOADFORCEIMPL_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CustomCPPForceImpl.h"
+#include "openmm/Context.h"
+#include "openmm/OffloadForce.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This is the internal implementation of OffloadForce.  It is built on CustomCPPForceImpl, so
+ * GPU platforms run it on their worker thread and merge the forces into the device force buffer.
+ */
+
+class OPENMM_EXPORT OffloadForceImpl : public CustomCPPForceImpl {
+public:
+    OffloadForceImpl(const OffloadForce& owner);
+    ~OffloadForceImpl();
+    void initialize(ContextImpl& context);
+    const OffloadForce& getOwner() const {
+        return owner;
+    }
+    double computeForce(ContextImpl& context, const std::vector<Vec3>& positions, std::vector<Vec3>& forces);
+    std::map<std::string, double> getDefaultParameters();
+    std::vector<std::pair<int, int> > getBondedParticles() const;
+    Context& getInnerContext();
+private:
+    const OffloadForce& owner;
+    System innerSystem;
+    VerletIntegrator innerIntegrator;
+    Context* innerContext;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_OFFLOADFORCEIMPL_H_*/
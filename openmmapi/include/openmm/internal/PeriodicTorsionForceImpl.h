@@ -35,6 +35,7 @@
 #include "ForceImpl.h"
 #include "openmm/PeriodicTorsionForce.h"
 #include "openmm/Kernel.h"
+#include <memory>
 #include <utility>
 #include <set>
 #include <string>
@@ -57,14 +58,26 @@ public:
         // This force field doesn't update the state directly.
     }
     double calcForcesAndEnergy(ContextImpl& context, bool includeForces, bool includeEnergy, int groups);
-    std::map<std::string, double> getDefaultParameters() {
-        return std::map<std::string, double>(); // This force field doesn't define any parameters.
-    }
+    std::map<std::string, double> getDefaultParameters();
+    void contextParameterChanged(ContextImpl& context, const std::string& name, double value);
     std::vector<std::string> getKernelNames();
     void updateParametersInContext(ContextImpl& context, int firstTorsion, int lastTorsion);
 private:
+    /**
+     * Record which torsions involve the solute, and discard the scaled copy of the force.  This must be
+     * called whenever the owner's torsions change.
+     */
+    void findSoluteTorsions();
+    /**
+     * Copy parameters to the kernel, first applying solute scaling if the solute scale parameter is not 1.
+     */
+    void copyScaledParametersToContext(ContextImpl& context, int firstTorsion, int lastTorsion);
     const PeriodicTorsionForce& owner;
     Kernel kernel;
+    std::vector<bool> isSolute;
+    std::vector<int> soluteTorsions;
+    double soluteScale;
+    std::unique_ptr<PeriodicTorsionForce> scaledForce;
 };
 
 } // namespace OpenMM
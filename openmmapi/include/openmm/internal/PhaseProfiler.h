@@ -0,0 +1,118 @@
+#ifndef OPENMM_PHASE_PROFILER_H_
+#define OPENMM_PHASE_PROFILER_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "ThreadPool.h"
+#include "windowsExport.h"
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * A PhaseProfiler records the wall clock time spent in each phase of a calculation on the CPU.  Each
+ * phase is bracketed by calls to startInterval() and endInterval().  Intervals may be nested, in which
+ * case the time recorded for the outer interval excludes the time spent in the inner ones.
+ *
+ * If a ThreadPool is used for the work, the profiler also measures how evenly it was divided between
+ * threads.  For every interval in which the worker threads did any work, the difference between the
+ * longest time any thread spent working and the average over all threads is recorded under the name
+ * of the phase followed by " imbalance".
+ *
+ * When profiling is disabled, startInterval() and endInterval() do nothing.
+ */
+class OPENMM_EXPORT PhaseProfiler {
+public:
+    /**
+     * Create a PhaseProfiler.
+     *
+     * @param threads   the ThreadPool used for the work being profiled
+     */
+    PhaseProfiler(ThreadPool& threads);
+    /**
+     * Get whether profiling is enabled.
+     */
+    bool getEnabled() const {
+        return enabled;
+    }
+    /**
+     * Set whether profiling is enabled.  This also enables or disables recording thread times in
+     * the ThreadPool.
+     */
+    void setEnabled(bool enabled);
+    /**
+     * Mark the beginning of a phase.  Each call must be matched by a call to endInterval().
+     */
+    void startInterval() {
+        if (enabled)
+            pushInterval();
+    }
+    /**
+     * Mark the end of the most recently started phase, and add its time to the total recorded under
+     * the specified name.
+     */
+    void endInterval(const std::string& name) {
+        if (enabled)
+            popInterval(name);
+    }
+    /**
+     * Get the times that have been recorded.  The result maps each name to the number of intervals
+     * recorded under it and their total time in microseconds.
+     */
+    std::map<std::string, std::pair<int, double> >& getTimes() {
+        return times;
+    }
+    /**
+     * Discard all times that have been recorded so far.
+     */
+    void resetTimes();
+private:
+    struct Interval;
+    void pushInterval();
+    void popInterval(const std::string& name);
+    ThreadPool& threads;
+    bool enabled;
+    std::vector<Interval> stack;
+    std::map<std::string, std::pair<int, double> > times;
+};
+
+struct PhaseProfiler::Interval {
+    double startTime, childTime;
+    std::vector<double> startThreadTimes, childThreadTimes;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_PHASE_PROFILER_H_*/
@@ -34,6 +34,7 @@
 
 #define NOMINMAX
 #include "windowsExport.h"
+#include <atomic>
 #include <condition_variable>
 #include <functional>
 #include <mutex>
@@ -56,6 +57,7 @@ class OPENMM_EXPORT ThreadPool {
 public:
     class Task;
     class ThreadData;
+    struct WorkRange;
     /**
      * Create a ThreadPool.
      *
@@ -68,6 +70,40 @@ public:
      * Get the number of worker threads in the pool.
      */
     int getNumThreads() const;
+    /**
+     * Bind each worker thread to a specific logical CPU core, so threads do not migrate between cores
+     * (and, on multi-socket computers, between memory domains).  This is supported on Linux and Windows.
+     * On other operating systems it has no effect.
+     *
+     * @param cores  thread i is bound to core cores[i%cores.size()]
+     * @return true if the affinity was successfully set for all threads, false otherwise
+     */
+    bool setThreadAffinity(const std::vector<int>& cores);
+    /**
+     * Set how long threads spin while waiting, before they block on a condition variable.  When a
+     * computation consists of many short parallel phases, the time needed to wake a sleeping thread can
+     * be larger than the work itself.  Spinning for a short time avoids that cost, but it keeps cores
+     * busy, so it is only helpful when every thread has a core to itself.
+     *
+     * @param microseconds  the maximum time to spin.  If this is 0 (the default), threads block immediately.
+     */
+    void setSpinWaitTime(int microseconds);
+    /**
+     * Get the maximum time in microseconds that threads spin while waiting, before they block.
+     */
+    int getSpinWaitTime() const;
+    /**
+     * Set whether to record how much time each worker thread spends working.  The time is measured from
+     * when a thread starts running a task or resumes after a synchronization point, until it reaches the
+     * next synchronization point or finishes the task.  Time spent waiting for other threads is excluded.
+     */
+    void setRecordThreadTimes(bool record);
+    /**
+     * Get the total time in seconds that each worker thread has spent working while recording was enabled
+     * by setRecordThreadTimes().  This should only be called while the threads are stopped, such as after
+     * waitForThreads() returns.
+     */
+    std::vector<double> getThreadTimes() const;
     /**
      * Execute a Task in parallel on the worker threads.
      */
@@ -76,6 +112,18 @@ public:
      * Execute a function in parallel on the worker threads.
      */
     void execute(std::function<void (ThreadPool&, int)> task);
+    /**
+     * Process a range of items in parallel, and block until all of them have been processed.  Each thread
+     * starts with a contiguous share of the items.  When a thread finishes its own share, it steals half of
+     * the remaining items from the thread with the most left, so items with very uneven costs do not leave
+     * threads idle.  This must be called from the thread that owns the pool, not from inside a task.
+     *
+     * @param numItems   the number of items to process
+     * @param grainSize  the number of items a thread removes from its share at a time
+     * @param task       this is called as task(pool, threadIndex, start, end) to process items start
+     *                   through end-1
+     */
+    void parallelFor(int numItems, int grainSize, std::function<void (ThreadPool&, int, int, int)> task);
     /**
      * This is called by the worker threads to block until all threads have reached the same point
      * and the master thread instructs them to continue by calling resumeThreads().
@@ -91,8 +139,10 @@ public:
      */
     void resumeThreads();
 private:
-    bool isDeleted;
-    int numThreads, waitCount;
+    bool spinUntil(const std::function<bool ()>& condition) const;
+    bool isDeleted, recordThreadTimes;
+    int numThreads, spinWaitTime;
+    std::atomic<int> waitCount, generation;
     std::vector<std::thread> threads;
     std::vector<ThreadData*> threadData;
     std::condition_variable startCondition, endCondition;
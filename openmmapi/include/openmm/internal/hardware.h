@@ -139,6 +139,46 @@ static bool isAvxSupported() {
     return false;
 }
 
+/**
+ * Get whether this is an x86 CPU that supports AVX-512 (the AVX512F subset), and the
+ * operating system has enabled saving the extended register state it requires.
+ */
+static bool isAvx512Supported() {
+#if defined(__x86_64__) || defined(_M_X64)
+    int cpuInfo[4];
+    cpuid(cpuInfo, 0);
+    if (cpuInfo[0] < 7)
+        return false;
+    cpuid(cpuInfo, 1);
+    if ((cpuInfo[2] & ((int) 1 << 27)) == 0)
+        return false; // The OS does not support XGETBV.
+
+    // Leaf 7 needs ECX to be set to 0, which cpuid() above does not do.
+
+#ifdef WIN32
+    __cpuidex(cpuInfo, 7, 0);
+    unsigned long long xcr0 = _xgetbv(0);
+#else
+    __asm__ __volatile__ (
+        "cpuid":
+        "=a" (cpuInfo[0]),
+        "=b" (cpuInfo[1]),
+        "=c" (cpuInfo[2]),
+        "=d" (cpuInfo[3]) :
+        "a" (7), "c" (0)
+    );
+    unsigned int xcrLow, xcrHigh;
+    __asm__ __volatile__ ("xgetbv" : "=a" (xcrLow), "=d" (xcrHigh) : "c" (0));
+    unsigned long long xcr0 = xcrLow | ((unsigned long long) xcrHigh << 32);
+#endif
+    // The OS must save the SSE, AVX, opmask, and upper ZMM register state.
+
+    return ((cpuInfo[1] & ((int) 1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6);
+#else
+    return false;
+#endif
+}
+
 /**
  * Get the maximum supported size for vectors in multiples of four bytes.  This
  * is the number of int or float values that can be contained in a vector.
@@ -0,0 +1,364 @@
+#ifndef OPENMM_VECTORIZE_AVX512_H_
+#define OPENMM_VECTORIZE_AVX512_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "vectorizeAvx.h"
+#include <immintrin.h>
+
+// This file defines classes and functions to simplify vectorizing code with AVX-512.  Only
+// the AVX512F subset is used, so it works on every processor that supports AVX-512.
+
+class ivec16;
+
+/**
+ * A sixteen element vector of floats.
+ */
+class fvec16 {
+public:
+    __m512 val;
+
+    fvec16() = default;
+    fvec16(float v) : val(_mm512_set1_ps(v)) {}
+    fvec16(__m512 v) : val(v) {}
+    fvec16(const float* v) : val(_mm512_loadu_ps(v)) {}
+
+    /** Create a vector by gathering individual indexes of data from a table. Element i of the vector will
+     * be loaded from table[idx[i]].
+     * @param table The table from which to do a lookup.
+     * @param indexes The indexes to gather.
+     */
+    fvec16(const float* table, const int32_t idx[16]) : val(_mm512_i32gather_ps(_mm512_loadu_si512(idx), table, 4)) {}
+
+    operator __m512() const {
+        return val;
+    }
+    fvec8 lowerVec() const {
+        return _mm512_castps512_ps256(val);
+    }
+    fvec8 upperVec() const {
+        return _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(val), 1));
+    }
+    void store(float* v) const {
+        _mm512_storeu_ps(v, val);
+    }
+    fvec16 operator+(fvec16 other) const {
+        return _mm512_add_ps(val, other);
+    }
+    fvec16 operator-(fvec16 other) const {
+        return _mm512_sub_ps(val, other);
+    }
+    fvec16 operator*(fvec16 other) const {
+        return _mm512_mul_ps(val, other);
+    }
+    fvec16 operator/(fvec16 other) const {
+        return _mm512_div_ps(val, other);
+    }
+    void operator+=(fvec16 other) {
+        val = _mm512_add_ps(val, other);
+    }
+    void operator-=(fvec16 other) {
+        val = _mm512_sub_ps(val, other);
+    }
+    void operator*=(fvec16 other) {
+        val = _mm512_mul_ps(val, other);
+    }
+    void operator/=(fvec16 other) {
+        val = _mm512_div_ps(val, other);
+    }
+    fvec16 operator-() const {
+        return _mm512_sub_ps(_mm512_setzero_ps(), val);
+    }
+    fvec16 operator&(fvec16 other) const {
+        return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(val), _mm512_castps_si512(other.val)));
+    }
+    fvec16 operator|(fvec16 other) const {
+        return _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(val), _mm512_castps_si512(other.val)));
+    }
+    fvec16 operator==(fvec16 other) const {
+        return maskToVector(_mm512_cmp_ps_mask(val, other, _CMP_EQ_OQ));
+    }
+    fvec16 operator!=(fvec16 other) const {
+        return maskToVector(_mm512_cmp_ps_mask(val, other, _CMP_NEQ_OQ));
+    }
+    fvec16 operator>(fvec16 other) const {
+        return maskToVector(_mm512_cmp_ps_mask(val, other, _CMP_GT_OQ));
+    }
+    fvec16 operator<(fvec16 other) const {
+        return maskToVector(_mm512_cmp_ps_mask(val, other, _CMP_LT_OQ));
+    }
+    fvec16 operator>=(fvec16 other) const {
+        return maskToVector(_mm512_cmp_ps_mask(val, other, _CMP_GE_OQ));
+    }
+    fvec16 operator<=(fvec16 other) const {
+        return maskToVector(_mm512_cmp_ps_mask(val, other, _CMP_LE_OQ));
+    }
+    operator ivec16() const;
+
+    /**
+     * Convert an integer bitmask into a full vector of elements which can be used
+     * by the blend function.
+     */
+    static fvec16 expandBitsToMask(int bitmask);
+
+    /**
+     * AVX-512 comparisons produce a mask register rather than a vector.  Convert it to
+     * a full vector of elements, so masks can be used the same way as with other vector types.
+     */
+    static fvec16 maskToVector(__mmask16 mask) {
+        return _mm512_castsi512_ps(_mm512_maskz_set1_epi32(mask, -1));
+    }
+
+    /**
+     * Convert a full vector of elements back into a mask register.  Only the sign bit
+     * of each element is used.
+     */
+    __mmask16 vectorToMask() const {
+        return _mm512_cmplt_epi32_mask(_mm512_castps_si512(val), _mm512_setzero_si512());
+    }
+};
+
+/**
+ * A sixteen element vector of ints.
+ */
+class ivec16 {
+public:
+    __m512i val;
+
+    ivec16() {}
+    ivec16(int v) : val(_mm512_set1_epi32(v)) {}
+    ivec16(__m512i v) : val(v) {}
+    ivec16(const int* v) : val(_mm512_loadu_si512(v)) {}
+    operator __m512i() const {
+        return val;
+    }
+    ivec8 lowerVec() const {
+        return _mm512_castsi512_si256(val);
+    }
+    ivec8 upperVec() const {
+        return _mm512_extracti64x4_epi64(val, 1);
+    }
+    void store(int* v) const {
+        _mm512_storeu_si512(v, val);
+    }
+    ivec16 operator&(ivec16 other) const {
+        return _mm512_and_si512(val, other.val);
+    }
+    ivec16 operator|(ivec16 other) const {
+        return _mm512_or_si512(val, other.val);
+    }
+    operator fvec16() const;
+};
+
+// Conversion operators.
+
+inline fvec16::operator ivec16() const {
+    return _mm512_cvttps_epi32(val);
+}
+
+inline ivec16::operator fvec16() const {
+    return _mm512_cvtepi32_ps(val);
+}
+
+inline fvec16 fvec16::expandBitsToMask(int bitmask) {
+    return maskToVector((__mmask16) bitmask);
+}
+
+// Functions that operate on fvec16s.
+
+static inline fvec16 floor(fvec16 v) {
+    return fvec16(_mm512_roundscale_ps(v.val, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC));
+}
+
+static inline fvec16 ceil(fvec16 v) {
+    return fvec16(_mm512_roundscale_ps(v.val, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC));
+}
+
+static inline fvec16 round(fvec16 v) {
+    return fvec16(_mm512_roundscale_ps(v.val, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+}
+
+static inline fvec16 min(fvec16 v1, fvec16 v2) {
+    return fvec16(_mm512_min_ps(v1.val, v2.val));
+}
+
+static inline fvec16 max(fvec16 v1, fvec16 v2) {
+    return fvec16(_mm512_max_ps(v1.val, v2.val));
+}
+
+static inline fvec16 abs(fvec16 v) {
+    return fvec16(_mm512_abs_ps(v.val));
+}
+
+static inline fvec16 sqrt(fvec16 v) {
+    return fvec16(_mm512_sqrt_ps(v.val));
+}
+
+static inline fvec16 rsqrt(fvec16 v) {
+    // Initial estimate of rsqrt().
+
+    fvec16 y(_mm512_rsqrt14_ps(v.val));
+
+    // Perform an iteration of Newton refinement.
+
+    fvec16 x2 = v*0.5f;
+    y *= fvec16(1.5f)-x2*y*y;
+    return y;
+}
+
+static inline float reduceAdd(fvec16 v) {
+    return _mm512_reduce_add_ps(v.val);
+}
+
+/** Given a vec4[16] input array, generate 4 vec16 outputs. The first output contains all the first elements
+ * the second output the second elements, and so on. Note that the prototype is essentially differing only
+ * in output type so it can be overloaded in other SIMD fvec types.
+ */
+static inline void transpose(const fvec4 in[16], fvec16& out1, fvec16& out2, fvec16& out3, fvec16& out4) {
+    // Each input register holds four consecutive vec4s.
+    const float* data = (const float*) in;
+    const __m512 r0 = _mm512_loadu_ps(data);
+    const __m512 r1 = _mm512_loadu_ps(data+16);
+    const __m512 r2 = _mm512_loadu_ps(data+32);
+    const __m512 r3 = _mm512_loadu_ps(data+48);
+
+    // Collect the first and second elements of eight vec4s into one register, and the third and
+    // fourth elements into another.
+    const __m512i idx01 = _mm512_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28, 1, 5, 9, 13, 17, 21, 25, 29);
+    const __m512i idx23 = _mm512_setr_epi32(2, 6, 10, 14, 18, 22, 26, 30, 3, 7, 11, 15, 19, 23, 27, 31);
+    const __m512 t0 = _mm512_permutex2var_ps(r0, idx01, r1);
+    const __m512 t1 = _mm512_permutex2var_ps(r0, idx23, r1);
+    const __m512 t2 = _mm512_permutex2var_ps(r2, idx01, r3);
+    const __m512 t3 = _mm512_permutex2var_ps(r2, idx23, r3);
+
+    // Combine the halves from the two sets of eight vec4s.
+    const __m512i idxLow = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 16, 17, 18, 19, 20, 21, 22, 23);
+    const __m512i idxHigh = _mm512_setr_epi32(8, 9, 10, 11, 12, 13, 14, 15, 24, 25, 26, 27, 28, 29, 30, 31);
+    out1 = _mm512_permutex2var_ps(t0, idxLow, t2);
+    out2 = _mm512_permutex2var_ps(t0, idxHigh, t2);
+    out3 = _mm512_permutex2var_ps(t1, idxLow, t3);
+    out4 = _mm512_permutex2var_ps(t1, idxHigh, t3);
+}
+
+/**
+ * Given 4 input vectors of 16 elements, transpose them to form 16 output vectors of 4 elements.
+ */
+static inline void transpose(fvec16 in1, fvec16 in2, fvec16 in3, fvec16 in4, fvec4 out[16]) {
+    // Pair up the first eight elements of in1 and in2, the last eight elements of in1 and in2,
+    // and likewise for in3 and in4.
+    const __m512i idxLow = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 16, 17, 18, 19, 20, 21, 22, 23);
+    const __m512i idxHigh = _mm512_setr_epi32(8, 9, 10, 11, 12, 13, 14, 15, 24, 25, 26, 27, 28, 29, 30, 31);
+    const __m512 t0 = _mm512_permutex2var_ps(in1, idxLow, in2);
+    const __m512 t1 = _mm512_permutex2var_ps(in1, idxHigh, in2);
+    const __m512 t2 = _mm512_permutex2var_ps(in3, idxLow, in4);
+    const __m512 t3 = _mm512_permutex2var_ps(in3, idxHigh, in4);
+
+    // Interleave them to form four consecutive vec4s in each register.
+    const __m512i idxFirst = _mm512_setr_epi32(0, 8, 16, 24, 1, 9, 17, 25, 2, 10, 18, 26, 3, 11, 19, 27);
+    const __m512i idxSecond = _mm512_setr_epi32(4, 12, 20, 28, 5, 13, 21, 29, 6, 14, 22, 30, 7, 15, 23, 31);
+    float* data = (float*) out;
+    _mm512_storeu_ps(data, _mm512_permutex2var_ps(t0, idxFirst, t2));
+    _mm512_storeu_ps(data+16, _mm512_permutex2var_ps(t0, idxSecond, t2));
+    _mm512_storeu_ps(data+32, _mm512_permutex2var_ps(t1, idxFirst, t3));
+    _mm512_storeu_ps(data+48, _mm512_permutex2var_ps(t1, idxSecond, t3));
+}
+
+// Functions that operate on ivec16s.
+
+static inline bool any(ivec16 v) {
+    return _mm512_test_epi32_mask(v, v) != 0;
+}
+
+static inline bool any(fvec16 v) {
+    return any(ivec16(_mm512_castps_si512(v.val)));
+}
+
+// Mathematical operators involving a scalar and a vector.
+
+static inline fvec16 operator+(float v1, fvec16 v2) {
+    return fvec16(v1)+v2;
+}
+
+static inline fvec16 operator-(float v1, fvec16 v2) {
+    return fvec16(v1)-v2;
+}
+
+static inline fvec16 operator*(float v1, fvec16 v2) {
+    return fvec16(v1)*v2;
+}
+
+static inline fvec16 operator/(float v1, fvec16 v2) {
+    return fvec16(v1)/v2;
+}
+
+// Operation for blending fvec16 from a full bitmask.
+static inline fvec16 blend(fvec16 v1, fvec16 v2, fvec16 mask) {
+    return fvec16(_mm512_mask_blend_ps(mask.vectorToMask(), v1.val, v2.val));
+}
+
+static inline fvec16 blendZero(fvec16 v, fvec16 mask) {
+    return fvec16(_mm512_maskz_mov_ps(mask.vectorToMask(), v.val));
+}
+
+/**
+ * Given a table of floating-point values and a set of indexes, perform a gather read into a pair
+ * of vectors. The first result vector contains the values at the given indexes, and the second
+ * result vector contains the values from each respective index+1.
+ */
+static inline void gatherVecPair(const float* table, ivec16 index, fvec16& out0, fvec16& out1) {
+    const double* tableAsDbl = (const double*) table;
+
+    // Each pair of floats is loaded as a single 64-bit value, using two gathers of eight
+    // 64-bit values each.
+    const __m512i lowerIdx = _mm512_cvtepi32_epi64(_mm512_castsi512_si256(index));
+    const __m512i upperIdx = _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(index, 1));
+    const __m512 lowerGather = _mm512_castpd_ps(_mm512_i64gather_pd(lowerIdx, tableAsDbl, 4));
+    const __m512 upperGather = _mm512_castpd_ps(_mm512_i64gather_pd(upperIdx, tableAsDbl, 4));
+
+    // The first value of each pair is in the even elements, and the second value is in the odd elements.
+    const __m512i evenIdx = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    const __m512i oddIdx = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+    out0 = _mm512_permutex2var_ps(lowerGather, evenIdx, upperGather);
+    out1 = _mm512_permutex2var_ps(lowerGather, oddIdx, upperGather);
+}
+
+/**
+ * Given 3 vectors of floating-point data, reduce them to a single 3-element position
+ * value by adding all the elements in each vector.  The fourth element of the result
+ * is undefined.
+ */
+static inline fvec4 reduceToVec3(fvec16 x, fvec16 y, fvec16 z) {
+    // Add the upper and lower halves of each vector, then reuse the 8 element version.
+    return reduceToVec3(x.lowerVec()+x.upperVec(), y.lowerVec()+y.upperVec(), z.lowerVec()+z.upperVec());
+}
+
+#endif /*OPENMM_VECTORIZE_AVX512_H_*/
@@ -0,0 +1,339 @@
+#ifndef OPENMM_VECTORIZE_SVE_H_
+#define OPENMM_VECTORIZE_SVE_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "vectorize.h"
+#include <arm_sve.h>
+#if !defined(__APPLE__) && !defined(__ANDROID__)
+#include <sys/auxv.h>
+#endif
+
+// This file defines classes and functions to simplify vectorizing code with SVE.  SVE vectors
+// have a length that is only known at runtime, but they cannot be stored in classes unless the
+// length is fixed at compile time.  This file must therefore be compiled with -msve-vector-bits=N,
+// and the resulting code only runs on processors whose vector length is exactly N bits.  The
+// classes are templates over the number of elements so that the types compiled for different
+// vector lengths are distinct.
+
+#ifndef HWCAP_SVE
+#define HWCAP_SVE (1 << 22)
+#endif
+
+#define OPENMM_SVE_WIDTH (__ARM_FEATURE_SVE_BITS/32)
+
+typedef svfloat32_t svfloat32Fixed __attribute__((arm_sve_vector_bits(__ARM_FEATURE_SVE_BITS)));
+typedef svint32_t svint32Fixed __attribute__((arm_sve_vector_bits(__ARM_FEATURE_SVE_BITS)));
+
+/**
+ * Determine whether this processor supports SVE with the vector length this file was compiled for.
+ */
+static bool isSveSupported() {
+#if defined(__APPLE__) || defined(__ANDROID__)
+    return false;
+#else
+    if ((getauxval(AT_HWCAP) & HWCAP_SVE) == 0)
+        return false;
+    return ((int) svcntw() == OPENMM_SVE_WIDTH);
+#endif
+}
+
+template <int WIDTH> class ivecSveImpl;
+
+/**
+ * A vector of floats that fills an SVE register.
+ */
+template <int WIDTH>
+class fvecSveImpl {
+public:
+    svfloat32Fixed val;
+
+    fvecSveImpl() = default;
+    fvecSveImpl(float v) : val(svdup_n_f32(v)) {}
+    fvecSveImpl(svfloat32_t v) : val(v) {}
+    fvecSveImpl(const float* v) : val(svld1_f32(svptrue_b32(), v)) {}
+
+    /** Create a vector by gathering individual indexes of data from a table. Element i of the vector will
+     * be loaded from table[idx[i]].
+     * @param table The table from which to do a lookup.
+     * @param indexes The indexes to gather.
+     */
+    fvecSveImpl(const float* table, const int32_t idx[WIDTH]) :
+        val(svld1_gather_s32index_f32(svptrue_b32(), table, svld1_s32(svptrue_b32(), idx))) {}
+
+    operator svfloat32_t() const {
+        return val;
+    }
+    void store(float* v) const {
+        svst1_f32(svptrue_b32(), v, val);
+    }
+    fvecSveImpl operator+(fvecSveImpl other) const {
+        return svadd_f32_x(svptrue_b32(), val, other.val);
+    }
+    fvecSveImpl operator-(fvecSveImpl other) const {
+        return svsub_f32_x(svptrue_b32(), val, other.val);
+    }
+    fvecSveImpl operator*(fvecSveImpl other) const {
+        return svmul_f32_x(svptrue_b32(), val, other.val);
+    }
+    fvecSveImpl operator/(fvecSveImpl other) const {
+        return svdiv_f32_x(svptrue_b32(), val, other.val);
+    }
+    void operator+=(fvecSveImpl other) {
+        val = svadd_f32_x(svptrue_b32(), val, other.val);
+    }
+    void operator-=(fvecSveImpl other) {
+        val = svsub_f32_x(svptrue_b32(), val, other.val);
+    }
+    void operator*=(fvecSveImpl other) {
+        val = svmul_f32_x(svptrue_b32(), val, other.val);
+    }
+    void operator/=(fvecSveImpl other) {
+        val = svdiv_f32_x(svptrue_b32(), val, other.val);
+    }
+    fvecSveImpl operator-() const {
+        return svneg_f32_x(svptrue_b32(), val);
+    }
+    fvecSveImpl operator&(fvecSveImpl other) const {
+        return svreinterpret_f32_s32(svand_s32_x(svptrue_b32(), svreinterpret_s32_f32(val), svreinterpret_s32_f32(other.val)));
+    }
+    fvecSveImpl operator|(fvecSveImpl other) const {
+        return svreinterpret_f32_s32(svorr_s32_x(svptrue_b32(), svreinterpret_s32_f32(val), svreinterpret_s32_f32(other.val)));
+    }
+    fvecSveImpl operator==(fvecSveImpl other) const {
+        return predicateToVector(svcmpeq_f32(svptrue_b32(), val, other.val));
+    }
+    fvecSveImpl operator!=(fvecSveImpl other) const {
+        return predicateToVector(svcmpne_f32(svptrue_b32(), val, other.val));
+    }
+    fvecSveImpl operator>(fvecSveImpl other) const {
+        return predicateToVector(svcmpgt_f32(svptrue_b32(), val, other.val));
+    }
+    fvecSveImpl operator<(fvecSveImpl other) const {
+        return predicateToVector(svcmplt_f32(svptrue_b32(), val, other.val));
+    }
+    fvecSveImpl operator>=(fvecSveImpl other) const {
+        return predicateToVector(svcmpge_f32(svptrue_b32(), val, other.val));
+    }
+    fvecSveImpl operator<=(fvecSveImpl other) const {
+        return predicateToVector(svcmple_f32(svptrue_b32(), val, other.val));
+    }
+    operator ivecSveImpl<WIDTH>() const;
+
+    /**
+     * Convert an integer bitmask into a full vector of elements which can be used
+     * by the blend function.
+     */
+    static fvecSveImpl expandBitsToMask(int bitmask) {
+        const svint32_t bits = svlsl_s32_x(svptrue_b32(), svdup_n_s32(1), svindex_u32(0, 1));
+        const svint32_t selected = svand_s32_x(svptrue_b32(), svdup_n_s32(bitmask), bits);
+        return predicateToVector(svcmpne_n_s32(svptrue_b32(), selected, 0));
+    }
+
+    /**
+     * SVE comparisons produce a predicate rather than a vector.  Convert it to a full vector
+     * of elements, so masks can be used the same way as with other vector types.
+     */
+    static fvecSveImpl predicateToVector(svbool_t predicate) {
+        return svreinterpret_f32_s32(svdup_n_s32_z(predicate, -1));
+    }
+
+    /**
+     * Convert a full vector of elements back into a predicate.  Only the sign bit
+     * of each element is used.
+     */
+    svbool_t vectorToPredicate() const {
+        return svcmplt_n_s32(svptrue_b32(), svreinterpret_s32_f32(val), 0);
+    }
+};
+
+/**
+ * A vector of ints that fills an SVE register.
+ */
+template <int WIDTH>
+class ivecSveImpl {
+public:
+    svint32Fixed val;
+
+    ivecSveImpl() = default;
+    ivecSveImpl(int v) : val(svdup_n_s32(v)) {}
+    ivecSveImpl(svint32_t v) : val(v) {}
+    ivecSveImpl(const int* v) : val(svld1_s32(svptrue_b32(), v)) {}
+    operator svint32_t() const {
+        return val;
+    }
+    void store(int* v) const {
+        svst1_s32(svptrue_b32(), v, val);
+    }
+    ivecSveImpl operator&(ivecSveImpl other) const {
+        return svand_s32_x(svptrue_b32(), val, other.val);
+    }
+    ivecSveImpl operator|(ivecSveImpl other) const {
+        return svorr_s32_x(svptrue_b32(), val, other.val);
+    }
+    operator fvecSveImpl<WIDTH>() const {
+        return svcvt_f32_s32_x(svptrue_b32(), val);
+    }
+};
+
+template <int WIDTH>
+inline fvecSveImpl<WIDTH>::operator ivecSveImpl<WIDTH>() const {
+    return svcvt_s32_f32_x(svptrue_b32(), val);
+}
+
+/**
+ * The vector types for the vector length this file is being compiled for.  The functions below
+ * are not templates, so arguments can be implicitly converted from scalars.
+ */
+typedef fvecSveImpl<OPENMM_SVE_WIDTH> fvecSve;
+typedef ivecSveImpl<OPENMM_SVE_WIDTH> ivecSve;
+
+// Functions that operate on fvecSves.
+
+static inline fvecSve floor(fvecSve v) {
+    return svrintm_f32_x(svptrue_b32(), v.val);
+}
+
+static inline fvecSve ceil(fvecSve v) {
+    return svrintp_f32_x(svptrue_b32(), v.val);
+}
+
+static inline fvecSve round(fvecSve v) {
+    return svrintn_f32_x(svptrue_b32(), v.val);
+}
+
+static inline fvecSve min(fvecSve v1, fvecSve v2) {
+    return svmin_f32_x(svptrue_b32(), v1.val, v2.val);
+}
+
+static inline fvecSve max(fvecSve v1, fvecSve v2) {
+    return svmax_f32_x(svptrue_b32(), v1.val, v2.val);
+}
+
+static inline fvecSve abs(fvecSve v) {
+    return svabs_f32_x(svptrue_b32(), v.val);
+}
+
+static inline fvecSve sqrt(fvecSve v) {
+    return svsqrt_f32_x(svptrue_b32(), v.val);
+}
+
+static inline fvecSve rsqrt(fvecSve v) {
+    // Initial estimate of rsqrt(), followed by two iterations of Newton refinement.
+
+    svfloat32_t y = svrsqrte_f32(v.val);
+    y = svmul_f32_x(svptrue_b32(), y, svrsqrts_f32(svmul_f32_x(svptrue_b32(), y, v.val), y));
+    y = svmul_f32_x(svptrue_b32(), y, svrsqrts_f32(svmul_f32_x(svptrue_b32(), y, v.val), y));
+    return y;
+}
+
+static inline float reduceAdd(fvecSve v) {
+    return svaddv_f32(svptrue_b32(), v.val);
+}
+
+/**
+ * Given an array of vec4s, one for each element of a vector, generate 4 vector outputs.  The
+ * first output contains all the first elements, the second output the second elements, and so on.
+ */
+static inline void transpose(const fvec4 in[OPENMM_SVE_WIDTH], fvecSve& out1, fvecSve& out2, fvecSve& out3, fvecSve& out4) {
+    // A structure load deinterleaves the four elements of each vec4.
+    svfloat32x4_t data = svld4_f32(svptrue_b32(), (const float*) in);
+    out1 = svget4_f32(data, 0);
+    out2 = svget4_f32(data, 1);
+    out3 = svget4_f32(data, 2);
+    out4 = svget4_f32(data, 3);
+}
+
+/**
+ * Given 4 input vectors, transpose them to form one vec4 for each element of the vectors.
+ */
+static inline void transpose(fvecSve in1, fvecSve in2, fvecSve in3, fvecSve in4, fvec4 out[OPENMM_SVE_WIDTH]) {
+    svst4_f32(svptrue_b32(), (float*) out, svcreate4_f32(in1.val, in2.val, in3.val, in4.val));
+}
+
+// Functions that operate on ivecSves.
+
+static inline bool any(ivecSve v) {
+    return svptest_any(svptrue_b32(), svcmpne_n_s32(svptrue_b32(), v.val, 0));
+}
+
+static inline bool any(fvecSve v) {
+    return any(ivecSve(svreinterpret_s32_f32(v.val)));
+}
+
+// Mathematical operators involving a scalar and a vector.
+
+static inline fvecSve operator+(float v1, fvecSve v2) {
+    return fvecSve(v1)+v2;
+}
+
+static inline fvecSve operator-(float v1, fvecSve v2) {
+    return fvecSve(v1)-v2;
+}
+
+static inline fvecSve operator*(float v1, fvecSve v2) {
+    return fvecSve(v1)*v2;
+}
+
+static inline fvecSve operator/(float v1, fvecSve v2) {
+    return fvecSve(v1)/v2;
+}
+
+// Operation for blending fvecSve from a full bitmask.
+static inline fvecSve blend(fvecSve v1, fvecSve v2, fvecSve mask) {
+    return svsel_f32(mask.vectorToPredicate(), v2.val, v1.val);
+}
+
+static inline fvecSve blendZero(fvecSve v, fvecSve mask) {
+    return svsel_f32(mask.vectorToPredicate(), v.val, svdup_n_f32(0.0f));
+}
+
+/**
+ * Given a table of floating-point values and a set of indexes, perform a gather read into a pair
+ * of vectors. The first result vector contains the values at the given indexes, and the second
+ * result vector contains the values from each respective index+1.
+ */
+static inline void gatherVecPair(const float* table, ivecSve index, fvecSve& out0, fvecSve& out1) {
+    out0 = svld1_gather_s32index_f32(svptrue_b32(), table, index.val);
+    out1 = svld1_gather_s32index_f32(svptrue_b32(), table+1, index.val);
+}
+
+/**
+ * Given 3 vectors of floating-point data, reduce them to a single 3-element position
+ * value by adding all the elements in each vector.  The fourth element of the result
+ * is undefined.
+ */
+static inline fvec4 reduceToVec3(fvecSve x, fvecSve y, fvecSve z) {
+    return fvec4(reduceAdd(x), reduceAdd(y), reduceAdd(z), 0.0f);
+}
+
+#endif /*OPENMM_VECTORIZE_SVE_H_*/
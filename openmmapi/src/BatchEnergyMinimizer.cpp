@@ -0,0 +1,368 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/BatchEnergyMinimizer.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/Platform.h"
+#include "openmm/SystemReplicator.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace OpenMM;
+using namespace std;
+
+// The number of correction pairs stored by L-BFGS.
+static const int NUM_CORRECTIONS = 6;
+// The maximum number of force evaluations in a single line search.
+static const int MAX_LINE_SEARCH_STEPS = 20;
+// The maximum distance any coordinate may move in a single step, in nm.
+static const double MAX_STEP = 0.3;
+// The fraction of the decrease predicted by the initial slope that a step must achieve (the Armijo condition).
+static const double SUFFICIENT_DECREASE = 1e-4;
+
+/**
+ * This class records the state of the minimization of one conformer.
+ */
+class BatchEnergyMinimizer::ConformerData {
+public:
+    ConformerData() : done(false), converged(false), iterations(0) {
+    }
+    vector<double> x, g, d, trialGradient, gradientLo;
+    vector<vector<double> > s, y;
+    vector<double> rho;
+    double alpha, alphaLo, alphaHi, phi0, phiLo, dphi0, dphiLo, dphiHi;
+    bool hasHi, done, converged;
+    int iterations, lineSearchSteps;
+};
+
+static double dot(const vector<double>& a, const vector<double>& b) {
+    double sum = 0.0;
+    for (int i = 0; i < (int) a.size(); i++)
+        sum += a[i]*b[i];
+    return sum;
+}
+
+static double maxAbs(const vector<double>& a) {
+    double result = 0.0;
+    for (double v : a)
+        result = max(result, fabs(v));
+    return result;
+}
+
+/**
+ * Compute the L-BFGS search direction for a conformer and begin a line search along it.
+ */
+static void startLineSearch(vector<double>& g, vector<double>& d, vector<vector<double> >& s, vector<vector<double> >& y,
+            vector<double>& rho, double& alpha, double& dphi0) {
+    int n = g.size();
+    d = g;
+    int numPairs = s.size();
+    vector<double> a(numPairs);
+    for (int i = numPairs-1; i >= 0; i--) {
+        a[i] = rho[i]*dot(s[i], d);
+        for (int j = 0; j < n; j++)
+            d[j] -= a[i]*y[i][j];
+    }
+    if (numPairs > 0) {
+        double gamma = dot(s[numPairs-1], y[numPairs-1])/dot(y[numPairs-1], y[numPairs-1]);
+        for (int j = 0; j < n; j++)
+            d[j] *= gamma;
+    }
+    for (int i = 0; i < numPairs; i++) {
+        double b = rho[i]*dot(y[i], d);
+        for (int j = 0; j < n; j++)
+            d[j] += s[i][j]*(a[i]-b);
+    }
+    for (int j = 0; j < n; j++)
+        d[j] = -d[j];
+    dphi0 = dot(g, d);
+    if (!(dphi0 < 0.0) || numPairs == 0) {
+        // Use steepest descent, with an initial step small enough to be safe.
+
+        s.clear();
+        y.clear();
+        rho.clear();
+        for (int j = 0; j < n; j++)
+            d[j] = -g[j];
+        dphi0 = dot(g, d);
+        alpha = 0.01/maxAbs(d);
+    }
+    else
+        alpha = min(1.0, MAX_STEP/maxAbs(d));
+}
+
+BatchEnergyMinimizer::BatchEnergyMinimizer(const System& system, int batchSize, double spacing, Platform& platform,
+            const map<string, string>& properties) : system(system), batchSize(batchSize), spacing(spacing), combinedSystem(NULL),
+            integrator(1.0), energyIntegrator(1.0), context(NULL), energyContext(NULL) {
+    if (batchSize < 1)
+        throw OpenMMException("BatchEnergyMinimizer: The batch size must be at least 1");
+    if (system.getNumConstraints() > 0)
+        throw OpenMMException("BatchEnergyMinimizer: Constraints are not supported");
+    combinedSystem = SystemReplicator::createSystem(system, batchSize, spacing);
+    try {
+        context = new Context(*combinedSystem, integrator, platform, properties);
+        energyContext = new Context(system, energyIntegrator, platform, properties);
+    }
+    catch (...) {
+        if (context != NULL)
+            delete context;
+        delete combinedSystem;
+        throw;
+    }
+}
+
+BatchEnergyMinimizer::~BatchEnergyMinimizer() {
+    delete energyContext;
+    delete context;
+    delete combinedSystem;
+}
+
+void BatchEnergyMinimizer::minimize(const vector<vector<Vec3> >& positions, double tolerance, int maxIterations) {
+    int numConformers = positions.size();
+    for (const vector<Vec3>& pos : positions)
+        if ((int) pos.size() != system.getNumParticles())
+            throw OpenMMException("BatchEnergyMinimizer: The number of positions for a conformer does not match the number of particles");
+    minimizedPositions.resize(numConformers);
+    energies.resize(numConformers);
+    iterations.resize(numConformers);
+    converged.resize(numConformers);
+    for (auto& param : context->getParameters())
+        energyContext->setParameter(param.first, param.second);
+    for (int first = 0; first < numConformers; first += batchSize)
+        minimizeBatch(first, positions, tolerance, maxIterations);
+
+    // Compute the final energy of each conformer.
+
+    for (int i = 0; i < numConformers; i++) {
+        energyContext->setPositions(minimizedPositions[i]);
+        energyContext->computeVirtualSites();
+        energies[i] = energyContext->getState(State::Energy, false, integrator.getIntegrationForceGroups()).getPotentialEnergy();
+    }
+}
+
+void BatchEnergyMinimizer::minimizeBatch(int firstConformer, const vector<vector<Vec3> >& positions, double tolerance, int maxIterations) {
+    // Initialize the conformers.  If there are fewer conformers left than the batch size, the extra slots are
+    // filled with copies of the last one that never move.
+
+    int numParticles = system.getNumParticles();
+    int numInBatch = min(batchSize, (int) positions.size()-firstConformer);
+    vector<ConformerData> conformers(batchSize);
+    for (int i = 0; i < batchSize; i++) {
+        ConformerData& c = conformers[i];
+        const vector<Vec3>& pos = positions[firstConformer+min(i, numInBatch-1)];
+        c.x.resize(3*numParticles);
+        for (int j = 0; j < numParticles; j++)
+            for (int k = 0; k < 3; k++)
+                c.x[3*j+k] = pos[j][k];
+        c.done = (i >= numInBatch);
+        if (!c.done)
+            c.phi0 = computeEnergy(c.x);
+    }
+    computeGradients(conformers, false);
+    double maxNorm2 = tolerance*tolerance*3*numParticles;
+    for (ConformerData& c : conformers) {
+        if (c.done)
+            continue;
+        if (dot(c.g, c.g) <= maxNorm2) {
+            c.done = true;
+            c.converged = true;
+        }
+        else if (maxIterations > 0 && c.iterations >= maxIterations)
+            c.done = true;
+        else
+            startLineSearch(c.g, c.d, c.s, c.y, c.rho, c.alpha, c.dphi0);
+        c.alphaLo = 0.0;
+        c.phiLo = c.phi0;
+        c.dphiLo = c.dphi0;
+        c.hasHi = false;
+        c.lineSearchSteps = 0;
+    }
+
+    // Advance all the conformers in lockstep.  Each pass evaluates the forces at a trial point on the line
+    // search of every active conformer.  A step is accepted only if it satisfies both the Armijo condition
+    // and the strong Wolfe curvature condition, so the energy of a conformer never increases.
+
+    while (true) {
+        bool anyActive = false;
+        for (ConformerData& c : conformers)
+            anyActive |= !c.done;
+        if (!anyActive)
+            break;
+        computeGradients(conformers, true);
+        for (ConformerData& c : conformers) {
+            if (c.done)
+                continue;
+            c.lineSearchSteps++;
+            double dphi = dot(c.trialGradient, c.d);
+            bool valid = isfinite(dphi);
+            double phi = NAN;
+            if (valid && (dphi < 0.0 || fabs(dphi) <= 0.9*fabs(c.dphi0))) {
+                // Only points that could be accepted or become the low end of the bracket need the energy.
+
+                phi = computeEnergy(c.x, c.alpha, c.d);
+                valid = (phi <= c.phi0+SUFFICIENT_DECREASE*c.alpha*c.dphi0);
+            }
+            bool accept = false;
+            if (valid && fabs(dphi) <= 0.9*fabs(c.dphi0))
+                accept = true;
+            else {
+                if (valid && dphi < 0.0) {
+                    c.alphaLo = c.alpha;
+                    c.phiLo = phi;
+                    c.dphiLo = dphi;
+                    c.gradientLo = c.trialGradient;
+                }
+                else {
+                    c.alphaHi = c.alpha;
+                    c.dphiHi = (isfinite(dphi) ? dphi : NAN);
+                    c.hasHi = true;
+                }
+                if (c.lineSearchSteps >= MAX_LINE_SEARCH_STEPS) {
+                    // The line search failed.  Move to the best point found if there is one.
+
+                    if (c.alphaLo > 0.0) {
+                        c.alpha = c.alphaLo;
+                        c.trialGradient = c.gradientLo;
+                        phi = c.phiLo;
+                        accept = true;
+                    }
+                    else {
+                        c.done = true;
+                        continue;
+                    }
+                }
+                else if (!c.hasHi)
+                    c.alpha *= 2;
+                else {
+                    // Interpolate to find where the directional derivative is zero, keeping the new point
+                    // safely inside the bracket.
+
+                    double width = c.alphaHi-c.alphaLo;
+                    double newAlpha = c.alphaLo+0.5*width;
+                    if (isfinite(c.dphiHi) && c.dphiHi != c.dphiLo)
+                        newAlpha = c.alphaLo-c.dphiLo*width/(c.dphiHi-c.dphiLo);
+                    c.alpha = max(c.alphaLo+0.1*width, min(c.alphaHi-0.1*width, newAlpha));
+                }
+            }
+            if (!accept)
+                continue;
+
+            // Take the step and update the L-BFGS corrections.
+
+            int n = c.x.size();
+            vector<double> step(n), change(n);
+            for (int j = 0; j < n; j++) {
+                step[j] = c.alpha*c.d[j];
+                change[j] = c.trialGradient[j]-c.g[j];
+                c.x[j] += step[j];
+            }
+            c.g = c.trialGradient;
+            c.phi0 = phi;
+            double sy = dot(step, change);
+            if (sy > 1e-10) {
+                if (c.s.size() == NUM_CORRECTIONS) {
+                    c.s.erase(c.s.begin());
+                    c.y.erase(c.y.begin());
+                    c.rho.erase(c.rho.begin());
+                }
+                c.s.push_back(step);
+                c.y.push_back(change);
+                c.rho.push_back(1.0/sy);
+            }
+            c.iterations++;
+            if (dot(c.g, c.g) <= maxNorm2) {
+                c.done = true;
+                c.converged = true;
+            }
+            else if (maxIterations > 0 && c.iterations >= maxIterations)
+                c.done = true;
+            else {
+                startLineSearch(c.g, c.d, c.s, c.y, c.rho, c.alpha, c.dphi0);
+                c.alphaLo = 0.0;
+                c.phiLo = c.phi0;
+                c.dphiLo = c.dphi0;
+                c.hasHi = false;
+                c.lineSearchSteps = 0;
+            }
+        }
+    }
+
+    // Record the results.
+
+    for (int i = 0; i < numInBatch; i++) {
+        ConformerData& c = conformers[i];
+        vector<Vec3>& pos = minimizedPositions[firstConformer+i];
+        pos.resize(numParticles);
+        for (int j = 0; j < numParticles; j++)
+            pos[j] = Vec3(c.x[3*j], c.x[3*j+1], c.x[3*j+2]);
+        iterations[firstConformer+i] = c.iterations;
+        converged[firstConformer+i] = (c.converged ? 1 : 0);
+    }
+}
+
+void BatchEnergyMinimizer::computeGradients(vector<ConformerData>& conformers, bool trial) {
+    // Evaluate the forces on every conformer, either at its current position or at the trial point of its line search.
+
+    int numParticles = system.getNumParticles();
+    vector<vector<Vec3> > positions(batchSize, vector<Vec3>(numParticles));
+    for (int i = 0; i < batchSize; i++) {
+        ConformerData& c = conformers[i];
+        bool moved = (trial && !c.done);
+        for (int j = 0; j < numParticles; j++)
+            for (int k = 0; k < 3; k++)
+                positions[i][j][k] = c.x[3*j+k] + (moved ? c.alpha*c.d[3*j+k] : 0.0);
+    }
+    context->setPositions(SystemReplicator::combinePositions(positions, spacing));
+    context->computeVirtualSites();
+    State state = context->getState(State::Forces, false, integrator.getIntegrationForceGroups());
+    vector<vector<Vec3> > forces = SystemReplicator::splitValues(state.getForces(), batchSize);
+    for (int i = 0; i < batchSize; i++) {
+        ConformerData& c = conformers[i];
+        if (trial && c.done)
+            continue;
+        vector<double>& g = (trial ? c.trialGradient : c.g);
+        g.resize(3*numParticles);
+        for (int j = 0; j < numParticles; j++)
+            for (int k = 0; k < 3; k++)
+                g[3*j+k] = (system.getParticleMass(j) == 0 ? 0.0 : -forces[i][j][k]);
+    }
+}
+
+double BatchEnergyMinimizer::computeEnergy(const vector<double>& x, double alpha, const vector<double>& d) {
+    int numParticles = system.getNumParticles();
+    vector<Vec3> positions(numParticles);
+    for (int j = 0; j < numParticles; j++)
+        for (int k = 0; k < 3; k++)
+            positions[j][k] = x[3*j+k] + (alpha == 0.0 ? 0.0 : alpha*d[3*j+k]);
+    energyContext->setPositions(positions);
+    energyContext->computeVirtualSites();
+    return energyContext->getState(State::Energy, false, integrator.getIntegrationForceGroups()).getPotentialEnergy();
+}
@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2008-2024 Stanford University and the Authors.      *
+ * Portions copyright (c) 2008-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -35,6 +35,8 @@
 #include "openmm/internal/ForceImpl.h"
 #include <cmath>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <sstream>
 
 using namespace OpenMM;
@@ -86,7 +88,31 @@ Platform& Context::getPlatform() {
     return impl->getPlatform();
 }
 
-State Context::getState(int types, bool enforcePeriodicBox, int groups) const {
+/**
+ * Translate each molecule so its center lies in the first periodic box.
+ */
+static void applyPeriodicBox(vector<Vec3>& positions, const vector<vector<int> >& molecules, const Vec3* periodicBoxSize) {
+    for (auto& mol : molecules) {
+        // Find the molecule center.
+
+        Vec3 center;
+        for (int j : mol)
+            center += positions[j];
+        center *= 1.0/mol.size();
+
+        // Find the displacement to move it into the first periodic box.
+        Vec3 diff;
+        diff += periodicBoxSize[2]*floor(center[2]/periodicBoxSize[2][2]);
+        diff += periodicBoxSize[1]*floor((center[1]-diff[1])/periodicBoxSize[1][1]);
+        diff += periodicBoxSize[0]*floor((center[0]-diff[0])/periodicBoxSize[0][0]);
+
+        // Translate all the particles in the molecule.
+        for (int j : mol)
+            positions[j] -= diff;
+    }
+}
+
+State::StateBuilder Context::createStateBuilder(int types, int groups) const {
     State::StateBuilder builder(impl->getTime(), impl->getStepCount());
     Vec3 periodicBoxSize[3];
     impl->getPeriodicBoxVectors(periodicBoxSize[0], periodicBoxSize[1], periodicBoxSize[2]);
@@ -95,16 +121,27 @@ State Context::getState(int types, bool enforcePeriodicBox, int groups) const {
     bool includeEnergy = types&State::Energy;
     bool includeParameterDerivs = types&State::ParameterDerivatives;
     bool needForcesForEnergy = (includeEnergy && getIntegrator().kineticEnergyRequiresForce());
-    if (includeForces || includeEnergy || includeParameterDerivs) {
-        double energy = impl->calcForcesAndEnergy(includeForces || needForcesForEnergy || includeParameterDerivs, includeEnergy, groups);
-        if (includeEnergy)
+    bool needForces = (includeForces || needForcesForEnergy || includeParameterDerivs);
+    if (types&State::GroupEnergies) {
+        // The total potential energy is the sum over groups, so it only needs to be computed
+        // separately if forces are also required.
+
+        vector<double> groupEnergies;
+        impl->calcGroupEnergies(groups, groupEnergies);
+        builder.setGroupEnergies(groupEnergies);
+        if (includeEnergy && !needForces) {
+            double energy = 0.0;
+            for (double e : groupEnergies)
+                energy += e;
             builder.setEnergy(impl->calcKineticEnergy(), energy);
-        if (includeForces) {
-            vector<Vec3> forces;
-            impl->getForces(forces);
-            builder.setForces(forces);
+            includeEnergy = false;
         }
     }
+    if (needForces || includeEnergy) {
+        double energy = impl->calcForcesAndEnergy(needForces, includeEnergy, groups);
+        if (includeEnergy)
+            builder.setEnergy(impl->calcKineticEnergy(), energy);
+    }
     if (types&State::Parameters) {
         map<string, double> params;
         for (auto& param : impl->parameters)
@@ -116,29 +153,27 @@ State Context::getState(int types, bool enforcePeriodicBox, int groups) const {
         impl->getEnergyParameterDerivatives(derivs);
         builder.setEnergyParameterDerivatives(derivs);
     }
+    if (types&State::IntegratorParameters) {
+        getIntegrator().serializeParameters(builder.updateIntegratorParameters());
+    }
+    return builder;
+}
+
+State Context::getState(int types, bool enforcePeriodicBox, int groups) const {
+    impl->waitForSteps();
+    State::StateBuilder builder = createStateBuilder(types, groups);
+    if (types&State::Forces) {
+        vector<Vec3> forces;
+        impl->getForces(forces);
+        builder.setForces(forces);
+    }
     if (types&State::Positions) {
         vector<Vec3> positions;
         impl->getPositions(positions);
         if (enforcePeriodicBox) {
-            const vector<vector<int> >& molecules = impl->getMolecules();
-            for (auto& mol : molecules) {
-                // Find the molecule center.
-
-                Vec3 center;
-                for (int j : mol)
-                    center += positions[j];
-                center *= 1.0/mol.size();
-
-                // Find the displacement to move it into the first periodic box.
-                Vec3 diff;
-                diff += periodicBoxSize[2]*floor(center[2]/periodicBoxSize[2][2]);
-                diff += periodicBoxSize[1]*floor((center[1]-diff[1])/periodicBoxSize[1][1]);
-                diff += periodicBoxSize[0]*floor((center[0]-diff[0])/periodicBoxSize[0][0]);
-
-                // Translate all the particles in the molecule.
-                for (int j : mol)
-                    positions[j] -= diff;
-            }
+            Vec3 periodicBoxSize[3];
+            impl->getPeriodicBoxVectors(periodicBoxSize[0], periodicBoxSize[1], periodicBoxSize[2]);
+            applyPeriodicBox(positions, impl->getMolecules(), periodicBoxSize);
         }
         builder.setPositions(positions);
     }
@@ -147,13 +182,138 @@ State Context::getState(int types, bool enforcePeriodicBox, int groups) const {
         impl->getVelocities(velocities);
         builder.setVelocities(velocities);
     }
-    if (types&State::IntegratorParameters) {
-        getIntegrator().serializeParameters(builder.updateIntegratorParameters());
+    return builder.getState();
+}
+
+State Context::getState(int types, const vector<int>& particles, bool enforcePeriodicBox, int groups) const {
+    impl->waitForSteps();
+    int numParticles = impl->getSystem().getNumParticles();
+    for (int particle : particles)
+        if (particle < 0 || particle >= numParticles)
+            throw OpenMMException("getState: Illegal particle index: "+to_string(particle));
+    State::StateBuilder builder = createStateBuilder(types, groups);
+    if (types&State::Forces) {
+        vector<Vec3> forces;
+        impl->getParticleForces(particles, forces);
+        builder.setForces(forces);
+    }
+    if (types&State::Positions) {
+        vector<Vec3> positions;
+        impl->getParticlePositions(particles, positions);
+        if (enforcePeriodicBox) {
+            // Group the requested particles by molecule, then wrap each group as a unit.
+
+            vector<int> particleMolecule(numParticles);
+            const vector<vector<int> >& molecules = impl->getMolecules();
+            for (int i = 0; i < molecules.size(); i++)
+                for (int j : molecules[i])
+                    particleMolecule[j] = i;
+            map<int, vector<int> > groupedParticles;
+            for (int i = 0; i < particles.size(); i++)
+                groupedParticles[particleMolecule[particles[i]]].push_back(i);
+            vector<vector<int> > requestedMolecules;
+            for (auto& group : groupedParticles)
+                requestedMolecules.push_back(group.second);
+            Vec3 periodicBoxSize[3];
+            impl->getPeriodicBoxVectors(periodicBoxSize[0], periodicBoxSize[1], periodicBoxSize[2]);
+            applyPeriodicBox(positions, requestedMolecules, periodicBoxSize);
+        }
+        builder.setPositions(positions);
+    }
+    if (types&State::Velocities) {
+        vector<Vec3> velocities;
+        impl->getParticleVelocities(particles, velocities);
+        builder.setVelocities(velocities);
     }
     return builder.getState();
 }
 
+future<State> Context::getStateAsync(int types, bool enforcePeriodicBox, int groups) const {
+    impl->waitForSteps();
+    // Everything except the per-particle arrays is small, so retrieve it now.  The platform
+    // captures the arrays and finishes transferring them in the background.
+
+    State::StateBuilder builder = createStateBuilder(types, groups);
+    bool includePositions = types&State::Positions;
+    bool includeVelocities = types&State::Velocities;
+    bool includeForces = types&State::Forces;
+    auto getStateData = impl->getStateDataAsync(includePositions, includeVelocities, includeForces);
+    Vec3 periodicBoxSize[3];
+    impl->getPeriodicBoxVectors(periodicBoxSize[0], periodicBoxSize[1], periodicBoxSize[2]);
+    shared_ptr<vector<vector<int> > > molecules;
+    if (includePositions && enforcePeriodicBox)
+        molecules = make_shared<vector<vector<int> > >(impl->getMolecules());
+    return async(launch::async, [=] () mutable {
+        vector<Vec3> positions, velocities, forces;
+        getStateData(positions, velocities, forces);
+        if (includeForces)
+            builder.setForces(forces);
+        if (includePositions) {
+            if (molecules)
+                applyPeriodicBox(positions, *molecules, periodicBoxSize);
+            builder.setPositions(positions);
+        }
+        if (includeVelocities)
+            builder.setVelocities(velocities);
+        return builder.getState();
+    });
+}
+
+vector<Vec3> Context::getQuantizedPositions(double precision) const {
+    impl->waitForSteps();
+    if (precision <= 0)
+        throw OpenMMException("getQuantizedPositions: precision must be positive");
+    vector<Vec3> positions;
+    impl->getQuantizedPositions(precision, positions);
+    return positions;
+}
+
+vector<double> Context::computeFrameEnergies(const vector<Vec3>& positions, const vector<Vec3>& boxVectors, const vector<int>& groups) {
+    impl->waitForSteps();
+    int numParticles = impl->getSystem().getNumParticles();
+    if (numParticles == 0 || positions.size()%numParticles != 0)
+        throw OpenMMException("computeFrameEnergies: The number of positions must be a multiple of the number of particles");
+    int numFrames = positions.size()/numParticles;
+    if (boxVectors.size() != 0 && boxVectors.size() != 3*numFrames)
+        throw OpenMMException("computeFrameEnergies: The number of box vectors must be 0 or 3 times the number of frames");
+    vector<int> groupFlags = groups;
+    if (groupFlags.size() == 0)
+        groupFlags.push_back(0xFFFFFFFF);
+    int numGroups = groupFlags.size();
+
+    // Record the current state so it can be restored afterward.
+
+    vector<Vec3> savedPositions;
+    impl->getPositions(savedPositions);
+    Vec3 savedBox[3];
+    impl->getPeriodicBoxVectors(savedBox[0], savedBox[1], savedBox[2]);
+
+    // Loop over frames.
+
+    vector<double> energies(numFrames*numGroups);
+    vector<Vec3> framePositions(numParticles);
+    try {
+        for (int frame = 0; frame < numFrames; frame++) {
+            if (boxVectors.size() > 0)
+                impl->setPeriodicBoxVectors(boxVectors[3*frame], boxVectors[3*frame+1], boxVectors[3*frame+2]);
+            framePositions.assign(positions.begin()+frame*numParticles, positions.begin()+(frame+1)*numParticles);
+            impl->setPositions(framePositions);
+            for (int i = 0; i < numGroups; i++)
+                energies[frame*numGroups+i] = impl->calcForcesAndEnergy(false, true, groupFlags[i]);
+        }
+    }
+    catch (...) {
+        impl->setPeriodicBoxVectors(savedBox[0], savedBox[1], savedBox[2]);
+        impl->setPositions(savedPositions);
+        throw;
+    }
+    impl->setPeriodicBoxVectors(savedBox[0], savedBox[1], savedBox[2]);
+    impl->setPositions(savedPositions);
+    return energies;
+}
+
 void Context::setState(const State& state) {
+    impl->waitForSteps();
     setTime(state.getTime());
     setStepCount(state.getStepCount());
     Vec3 a, b, c;
@@ -171,34 +331,41 @@ void Context::setState(const State& state) {
 }
 
 double Context::getTime() const {
+    impl->waitForSteps();
     return impl->getTime();
 }
 
 void Context::setTime(double time) {
+    impl->waitForSteps();
     impl->setTime(time);
 }
 
 long long Context::getStepCount() const {
+    impl->waitForSteps();
     return impl->getStepCount();
 }
 
 void Context::setStepCount(long long count) {
+    impl->waitForSteps();
     impl->setStepCount(count);
 }
 
 void Context::setPositions(const vector<Vec3>& positions) {
+    impl->waitForSteps();
     if ((int) positions.size() != impl->getSystem().getNumParticles())
         throw OpenMMException("Called setPositions() on a Context with the wrong number of positions");
     impl->setPositions(positions);
 }
 
 void Context::setVelocities(const vector<Vec3>& velocities) {
+    impl->waitForSteps();
     if ((int) velocities.size() != impl->getSystem().getNumParticles())
         throw OpenMMException("Called setVelocities() on a Context with the wrong number of velocities");
     impl->setVelocities(velocities);
 }
 
 void Context::setVelocitiesToTemperature(double temperature, int randomSeed) {
+    impl->waitForSteps();
     const Integrator& integrator = impl->getIntegrator();
     const System& system = impl->getSystem();
     vector<Vec3> velocities = integrator.getVelocitiesForTemperature(system, temperature, randomSeed);
@@ -218,34 +385,50 @@ void Context::setVelocitiesToTemperature(double temperature, int randomSeed) {
 }
 
 const map<string, double>& Context::getParameters() const {
+    impl->waitForSteps();
     return impl->getParameters();
 }
 
 double Context::getParameter(const string& name) const {
+    impl->waitForSteps();
     return impl->getParameter(name);
 }
 
 void Context::setParameter(const string& name, double value) {
+    impl->waitForSteps();
     impl->setParameter(name, value);
 }
 
 void Context::setPeriodicBoxVectors(const Vec3& a, const Vec3& b, const Vec3& c) {
+    impl->waitForSteps();
     impl->setPeriodicBoxVectors(a, b, c);
 }
 
 void Context::applyConstraints(double tol) {
+    impl->waitForSteps();
     impl->applyConstraints(tol);
 }
 
 void Context::applyVelocityConstraints(double tol) {
+    impl->waitForSteps();
     impl->applyVelocityConstraints(tol);
 }
 
 void Context::computeVirtualSites() {
+    impl->waitForSteps();
     impl->computeVirtualSites();
 }
 
+void Context::stepAsync(int steps) {
+    impl->stepAsync(steps);
+}
+
+void Context::waitForSteps() {
+    impl->waitForSteps();
+}
+
 void Context::reinitialize(bool preserveState) {
+    impl->waitForSteps();
     const System& system = impl->getSystem();
     Integrator& integrator = impl->getIntegrator();
     Platform& platform = impl->getPlatform();
@@ -263,22 +446,51 @@ void Context::reinitialize(bool preserveState) {
     }
 }
 
-void Context::createCheckpoint(ostream& stream) {
-    impl->createCheckpoint(stream);
+void Context::createCheckpoint(ostream& stream, bool compress) {
+    impl->waitForSteps();
+    impl->createCheckpoint(stream, compress);
+}
+
+future<void> Context::createCheckpointAsync(ostream& stream, bool compress) {
+    impl->waitForSteps();
+    return impl->createCheckpointAsync(stream, compress);
 }
 
 void Context::loadCheckpoint(istream& stream) {
+    impl->waitForSteps();
     impl->loadCheckpoint(stream);
 }
 
 ContextImpl& Context::getImpl() {
+    impl->waitForSteps();
     return *impl;
 }
 
 const ContextImpl& Context::getImpl() const {
+    impl->waitForSteps();
     return *impl;
 }
 
 const vector<vector<int> >& Context::getMolecules() const {
     return impl->getMolecules();
 }
+
+map<string, pair<int, double> > Context::getKernelTimings() {
+    impl->waitForSteps();
+    return impl->getPlatform().getKernelTimings(*this);
+}
+
+void Context::resetKernelTimings() {
+    impl->waitForSteps();
+    impl->getPlatform().resetKernelTimings(*this);
+}
+
+map<string, map<string, long long> > Context::getMemoryUsage() {
+    impl->waitForSteps();
+    return impl->getPlatform().getMemoryUsage(*this);
+}
+
+void Context::getDeviceArray(const string& name, long long& pointer, vector<int>& shape, string& type, int& deviceIndex) {
+    impl->waitForSteps();
+    impl->getPlatform().getDeviceArray(*this, name, pointer, shape, type, deviceIndex);
+}
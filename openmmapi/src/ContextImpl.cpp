@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2008-2022 Stanford University and the Authors.      *
+ * Portions copyright (c) 2008-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -44,18 +44,41 @@
 #include <cstdlib>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <utility>
 #include <vector>
 #include <string.h>
+#ifdef OPENMM_HAS_ZLIB
+#include <zlib.h>
+#endif
 
 using namespace OpenMM;
 using namespace std;
+
+namespace OpenMM {
+
+/**
+ * This records the molecules most recently found for a System, along with the bonds they were derived from.
+ */
+class System::MoleculeCache {
+public:
+    int numParticles;
+    vector<pair<int, int> > bonds;
+    vector<vector<int> > molecules;
+};
+
+}
 const static char CHECKPOINT_MAGIC_BYTES[] = "OpenMM Binary Checkpoint\n";
+const static char COMPRESSED_CHECKPOINT_MAGIC_BYTES[] = "OpenMM Compressed Checkpoint\n";
+const static char FORCE_DATA_MAGIC_BYTES[] = "OpenMM Force Data\n";
+const static int FORCE_DATA_VERSION = 1;
 
 
 ContextImpl::ContextImpl(Context& owner, const System& system, Integrator& integrator, Platform* platform, const map<string, string>& properties, ContextImpl* originalContext) :
-        owner(owner), system(system), integrator(integrator), hasInitializedForces(false), hasSetPositions(false), integratorIsDeleted(false),
-        lastForceGroups(-1), platform(platform), platformData(NULL) {
+        owner(owner), system(system), integrator(integrator), hasInitializedForces(false), hasSetPositions(false), integratorIsDeleted(false), hasCreatedMinimizeKernel(false),
+        lastForceGroups(-1), initializingForce(NULL), platform(platform), platformData(NULL) {
     int numParticles = system.getNumParticles();
     if (numParticles == 0)
         throw OpenMMException("Cannot create a Context for a System with no particles");
@@ -83,6 +106,21 @@ ContextImpl::ContextImpl(Context& owner, const System& system, Integrator& integ
             throw OpenMMException("The System has two constraints between the same atoms.  This will produce a singular constraint matrix.");
         constraintAtoms.insert(atoms);
     }
+    vector<bool> inMoleculeType(numParticles, false);
+    for (int i = 0; i < system.getNumMoleculeTypes(); i++) {
+        int numMoleculeParticles;
+        vector<int> firstParticles;
+        system.getMoleculeTypeParameters(i, numMoleculeParticles, firstParticles);
+        for (int first : firstParticles) {
+            if (first < 0 || first+numMoleculeParticles > numParticles)
+                throw OpenMMException("Illegal particle index in molecule type");
+            for (int j = first; j < first+numMoleculeParticles; j++) {
+                if (inMoleculeType[j])
+                    throw OpenMMException("A particle cannot belong to more than one molecule in the declared molecule types");
+                inMoleculeType[j] = true;
+            }
+        }
+    }
     
     // Validate the list of properties.
 
@@ -179,7 +217,9 @@ void ContextImpl::initialize() {
     system.getDefaultPeriodicBoxVectors(periodicBoxVectors[0], periodicBoxVectors[1], periodicBoxVectors[2]);
     updateStateDataKernel.getAs<UpdateStateDataKernel>().setPeriodicBoxVectors(*this, periodicBoxVectors[0], periodicBoxVectors[1], periodicBoxVectors[2]);
     for (size_t i = 0; i < forceImpls.size(); ++i) {
+        initializingForce = &forceImpls[i]->getOwner();
         forceImpls[i]->initialize(*this);
+        initializingForce = NULL;
         map<string, double> forceParameters = forceImpls[i]->getDefaultParameters();
         for (auto param : forceParameters)
             if (parameters.find(param.first) != parameters.end() && parameters[param.first] != forceParameters[param.first])
@@ -191,6 +231,12 @@ void ContextImpl::initialize() {
 }
 
 ContextImpl::~ContextImpl() {
+    // Steps may still be running in the background.  Any error they produced can no longer be
+    // reported, so just wait for them to finish.
+
+    lock_guard<mutex> guard(pendingStepsLock);
+    if (pendingSteps.valid())
+        pendingSteps.wait();
     for (auto force : forceImpls)
         delete force;
     
@@ -200,6 +246,7 @@ ContextImpl::~ContextImpl() {
     updateStateDataKernel = Kernel();
     applyConstraintsKernel = Kernel();
     virtualSitesKernel = Kernel();
+    minimizeKernel = Kernel();
     if (!integratorIsDeleted) {
         // The Context is being deleted before the Integrator, so call cleanup() on it now.
         
@@ -229,6 +276,10 @@ void ContextImpl::getPositions(std::vector<Vec3>& positions) {
     updateStateDataKernel.getAs<UpdateStateDataKernel>().getPositions(*this, positions);
 }
 
+void ContextImpl::getQuantizedPositions(double precision, std::vector<Vec3>& positions) {
+    updateStateDataKernel.getAs<UpdateStateDataKernel>().getQuantizedPositions(*this, precision, positions);
+}
+
 void ContextImpl::setPositions(const std::vector<Vec3>& positions) {
     hasSetPositions = true;
     updateStateDataKernel.getAs<UpdateStateDataKernel>().setPositions(*this, positions);
@@ -244,10 +295,35 @@ void ContextImpl::setVelocities(const std::vector<Vec3>& velocities) {
     integrator.stateChanged(State::Velocities);
 }
 
+void ContextImpl::scaleVelocities(double scale) {
+    updateStateDataKernel.getAs<UpdateStateDataKernel>().scaleVelocities(*this, scale);
+    integrator.stateChanged(State::Velocities);
+}
+
+void ContextImpl::notifyStateChanged(State::DataType changed) {
+    integrator.stateChanged(changed);
+}
+
 void ContextImpl::getForces(std::vector<Vec3>& forces) {
     updateStateDataKernel.getAs<UpdateStateDataKernel>().getForces(*this, forces);
 }
 
+void ContextImpl::getParticlePositions(const std::vector<int>& particles, std::vector<Vec3>& positions) {
+    updateStateDataKernel.getAs<UpdateStateDataKernel>().getParticlePositions(*this, particles, positions);
+}
+
+void ContextImpl::getParticleVelocities(const std::vector<int>& particles, std::vector<Vec3>& velocities) {
+    updateStateDataKernel.getAs<UpdateStateDataKernel>().getParticleVelocities(*this, particles, velocities);
+}
+
+void ContextImpl::getParticleForces(const std::vector<int>& particles, std::vector<Vec3>& forces) {
+    updateStateDataKernel.getAs<UpdateStateDataKernel>().getParticleForces(*this, particles, forces);
+}
+
+std::function<void(std::vector<Vec3>&, std::vector<Vec3>&, std::vector<Vec3>&)> ContextImpl::getStateDataAsync(bool positions, bool velocities, bool forces) {
+    return updateStateDataKernel.getAs<UpdateStateDataKernel>().getStateDataAsync(*this, positions, velocities, forces);
+}
+
 const std::map<std::string, double>& ContextImpl::getParameters() const {
     return parameters;
 }
@@ -262,6 +338,8 @@ void ContextImpl::setParameter(std::string name, double value) {
     if (parameters.find(name) == parameters.end())
         throw OpenMMException("Called setParameter() with invalid parameter name: "+name);
     parameters[name] = value;
+    for (auto impl : forceImpls)
+        impl->contextParameterChanged(*this, name, value);
     integrator.stateChanged(State::Parameters);
 }
 
@@ -299,6 +377,19 @@ void ContextImpl::computeVirtualSites() {
     virtualSitesKernel.getAs<VirtualSitesKernel>().computePositions(*this);
 }
 
+bool ContextImpl::minimize(double tolerance, int maxIterations) {
+    if (!hasSetPositions)
+        throw OpenMMException("Particle positions have not been set");
+    if (!hasCreatedMinimizeKernel) {
+        if (!platform->supportsKernels(vector<string>(1, MinimizeKernel::Name())))
+            return false;
+        minimizeKernel = platform->createKernel(MinimizeKernel::Name(), *this);
+        minimizeKernel.getAs<MinimizeKernel>().initialize(system);
+        hasCreatedMinimizeKernel = true;
+    }
+    return minimizeKernel.getAs<MinimizeKernel>().execute(*this, tolerance, maxIterations);
+}
+
 double ContextImpl::calcForcesAndEnergy(bool includeForces, bool includeEnergy, int groups) {
     if (!hasSetPositions)
         throw OpenMMException("Particle positions have not been set");
@@ -307,8 +398,11 @@ double ContextImpl::calcForcesAndEnergy(bool includeForces, bool includeEnergy,
     while (true) {
         double energy = 0.0;
         kernel.beginComputation(*this, includeForces, includeEnergy, groups);
-        for (auto force : forceImpls)
+        for (auto force : forceImpls) {
+            kernel.beginForce(*this, force->getOwner(), groups);
             energy += force->calcForcesAndEnergy(*this, includeForces, includeEnergy, groups);
+            kernel.endForce(*this, force->getOwner(), groups);
+        }
         bool valid = true;
         energy += kernel.finishComputation(*this, includeForces, includeEnergy, groups, valid);
         if (valid)
@@ -316,6 +410,17 @@ double ContextImpl::calcForcesAndEnergy(bool includeForces, bool includeEnergy,
     }
 }
 
+void ContextImpl::calcGroupEnergies(int groups, vector<double>& energies) {
+    int usedGroups = 0;
+    for (auto force : forceImpls)
+        usedGroups |= force->getForceGroups();
+    energies.clear();
+    energies.resize(32, 0.0);
+    for (int i = 0; i < 32; i++)
+        if ((groups&usedGroups&(1<<i)) != 0)
+            energies[i] = calcForcesAndEnergy(false, true, 1<<i);
+}
+
 int& ContextImpl::getLastForceGroups() {
     return lastForceGroups;
 }
@@ -382,60 +487,93 @@ const vector<vector<int> >& ContextImpl::getMolecules() const {
         }
     }
 
-    // Make a list of every other particle to which each particle is connected
+    // It is common to create many Contexts for the same System, so the result is cached on the System.
+    // It is only reused if the bonds are exactly the same as last time, so it remains correct even if
+    // the System or its Forces have been modified since then.
 
+    static mutex cacheMutex;
     int numParticles = system.getNumParticles();
-    vector<vector<int> > particleBonds(numParticles);
-    for (auto& bond : bonds) {
-        particleBonds[bond.first].push_back(bond.second);
-        particleBonds[bond.second].push_back(bond.first);
+    shared_ptr<System::MoleculeCache> cache;
+    {
+        lock_guard<mutex> lock(cacheMutex);
+        cache = system.moleculeCache;
+    }
+    if (cache != nullptr && cache->numParticles == numParticles && cache->bonds == bonds) {
+        molecules = cache->molecules;
+        return molecules;
     }
 
     // Now identify particles by which molecule they belong to.
 
-    molecules = findMolecules(numParticles, particleBonds);
+    molecules = findMolecules(numParticles, bonds);
+    cache = make_shared<System::MoleculeCache>();
+    cache->numParticles = numParticles;
+    cache->bonds.swap(bonds);
+    cache->molecules = molecules;
+    lock_guard<mutex> lock(cacheMutex);
+    system.moleculeCache = cache;
     return molecules;
 }
 
 vector<vector<int> > ContextImpl::findMolecules(int numParticles, vector<vector<int> >& particleBonds) {
-    // This is essentially a recursive algorithm, but it is reformulated as a loop to avoid
-    // stack overflows.  It selects a particle, marks it as a new molecule, then recursively
-    // marks every particle bonded to it as also being in that molecule.
-    
-    vector<int> particleMolecule(numParticles, -1);
-    int numMolecules = 0;
+    vector<pair<int, int> > bonds;
+    for (int i = 0; i < (int) particleBonds.size(); i++)
+        for (int j : particleBonds[i])
+            if (i < j)
+                bonds.push_back(make_pair(i, j));
+            else if (i > j)
+                bonds.push_back(make_pair(j, i));
+    return findMolecules(numParticles, bonds);
+}
+
+/**
+ * Find the root of the tree containing a particle, halving the path to it along the way.  Every particle's
+ * parent has an index no larger than its own, so the root is always the lowest index in the molecule.
+ */
+static int findMoleculeRoot(vector<int>& parent, int particle) {
+    while (parent[particle] != particle) {
+        parent[particle] = parent[parent[particle]];
+        particle = parent[particle];
+    }
+    return particle;
+}
+
+vector<vector<int> > ContextImpl::findMolecules(int numParticles, const vector<pair<int, int> >& bonds) {
+    // Build a union-find forest over the particles.  When two trees are merged, the root with the larger
+    // index is attached to the other one.
+
+    vector<int> parent(numParticles);
     for (int i = 0; i < numParticles; i++)
-        if (particleMolecule[i] == -1) {
-            // Start a new molecule.
-            
-            vector<int> particleStack;
-            vector<int> neighborStack;
-            particleStack.push_back(i);
-            neighborStack.push_back(0);
-            int molecule = numMolecules++;
-            
-            // Recursively tag all the bonded particles.
-            
-            while (particleStack.size() > 0) {
-                int particle = particleStack.back();
-                particleMolecule[particle] = molecule;
-                int& neighbor = neighborStack.back();
-                while (neighbor < particleBonds[particle].size() && particleMolecule[particleBonds[particle][neighbor]] != -1)
-                    neighbor++;
-                if (neighbor < particleBonds[particle].size()) {
-                    particleStack.push_back(particleBonds[particle][neighbor]);
-                    neighborStack.push_back(0);
-                }
-                else {
-                    particleStack.pop_back();
-                    neighborStack.pop_back();
-                }
-            }
+        parent[i] = i;
+    for (auto& bond : bonds) {
+        int root1 = findMoleculeRoot(parent, bond.first);
+        int root2 = findMoleculeRoot(parent, bond.second);
+        if (root1 < root2)
+            parent[root2] = root1;
+        else if (root2 < root1)
+            parent[root1] = root2;
+    }
+
+    // Number the molecules in order of their lowest particle, which is the root of each tree.
+
+    vector<int> particleMolecule(numParticles);
+    vector<int> moleculeSize;
+    for (int i = 0; i < numParticles; i++) {
+        int root = findMoleculeRoot(parent, i);
+        if (root == i) {
+            particleMolecule[i] = moleculeSize.size();
+            moleculeSize.push_back(0);
         }
-    
+        else
+            particleMolecule[i] = particleMolecule[root];
+        moleculeSize[particleMolecule[i]]++;
+    }
+
     // Build the final output vector.
-    
-    vector<vector<int> > molecules(numMolecules);
+
+    vector<vector<int> > molecules(moleculeSize.size());
+    for (int i = 0; i < (int) molecules.size(); i++)
+        molecules[i].reserve(moleculeSize[i]);
     for (int i = 0; i < numParticles; i++)
         molecules[particleMolecule[i]].push_back(i);
     return molecules;
@@ -455,7 +593,56 @@ static string readString(istream& stream) {
     return str;
 }
 
-void ContextImpl::createCheckpoint(ostream& stream) {
+/**
+ * Compress a checkpoint and write it to a stream.  The output consists of a header, the
+ * uncompressed size, the compressed size, and the zlib compressed data.
+ */
+static void writeCompressedCheckpoint(const string& data, ostream& stream) {
+#ifdef OPENMM_HAS_ZLIB
+    uLongf compressedSize = compressBound(data.size());
+    vector<Bytef> compressed(compressedSize);
+    if (compress2(compressed.data(), &compressedSize, (const Bytef*) data.data(), data.size(), Z_BEST_SPEED) != Z_OK)
+        throw OpenMMException("createCheckpoint: Failed to compress checkpoint");
+    stream.write(COMPRESSED_CHECKPOINT_MAGIC_BYTES, sizeof(COMPRESSED_CHECKPOINT_MAGIC_BYTES)/sizeof(COMPRESSED_CHECKPOINT_MAGIC_BYTES[0]));
+    long long sizes[] = {(long long) data.size(), (long long) compressedSize};
+    stream.write((char*) sizes, sizeof(sizes));
+    stream.write((char*) compressed.data(), compressedSize);
+    stream.flush();
+#else
+    throw OpenMMException("createCheckpoint: Compressed checkpoints require OpenMM to be built with zlib");
+#endif
+}
+
+/**
+ * Read the body of a compressed checkpoint (everything after the header) and decompress it.
+ */
+static string readCompressedCheckpoint(istream& stream) {
+#ifdef OPENMM_HAS_ZLIB
+    long long sizes[2];
+    stream.read((char*) sizes, sizeof(sizes));
+    if (!stream || sizes[0] < 0 || sizes[1] < 0)
+        throw OpenMMException("loadCheckpoint: Compressed checkpoint is truncated or corrupt");
+    vector<Bytef> compressed(sizes[1]);
+    stream.read((char*) compressed.data(), sizes[1]);
+    if (!stream)
+        throw OpenMMException("loadCheckpoint: Compressed checkpoint is truncated or corrupt");
+    string data(sizes[0], '\0');
+    uLongf size = sizes[0];
+    if (uncompress((Bytef*) &data[0], &size, compressed.data(), sizes[1]) != Z_OK || size != sizes[0])
+        throw OpenMMException("loadCheckpoint: Failed to decompress checkpoint");
+    return data;
+#else
+    throw OpenMMException("loadCheckpoint: Loading a compressed checkpoint requires OpenMM to be built with zlib");
+#endif
+}
+
+void ContextImpl::createCheckpoint(ostream& stream, bool compress) {
+    if (compress) {
+        stringstream buffer(ios_base::out | ios_base::binary);
+        createCheckpoint(buffer);
+        writeCompressedCheckpoint(buffer.str(), stream);
+        return;
+    }
     stream.write(CHECKPOINT_MAGIC_BYTES, sizeof(CHECKPOINT_MAGIC_BYTES)/sizeof(CHECKPOINT_MAGIC_BYTES[0]));
     writeString(stream, getPlatform().getName());
     int numParticles = getSystem().getNumParticles();
@@ -468,13 +655,94 @@ void ContextImpl::createCheckpoint(ostream& stream) {
     }
     updateStateDataKernel.getAs<UpdateStateDataKernel>().createCheckpoint(*this, stream);
     integrator.createCheckpoint(stream);
+
+    // Record internal state from any ForceImpls that have it.  Each block is tagged with the index of
+    // the Force so it can be given back to the right one.
+
+    vector<pair<int, string> > forceData;
+    for (int i = 0; i < (int) forceImpls.size(); i++) {
+        stringstream data(ios_base::out | ios_base::binary);
+        forceImpls[i]->createCheckpoint(*this, data);
+        if (data.tellp() > 0)
+            forceData.push_back(make_pair(i, data.str()));
+    }
+    stream.write(FORCE_DATA_MAGIC_BYTES, sizeof(FORCE_DATA_MAGIC_BYTES)/sizeof(FORCE_DATA_MAGIC_BYTES[0]));
+    stream.write((char*) &FORCE_DATA_VERSION, sizeof(int));
+    int numForceData = forceData.size();
+    stream.write((char*) &numForceData, sizeof(int));
+    for (auto& data : forceData) {
+        stream.write((char*) &data.first, sizeof(int));
+        writeString(stream, data.second);
+    }
     stream.flush();
 }
 
+future<void> ContextImpl::createCheckpointAsync(ostream& stream, bool compress) {
+    // Capturing the state has to happen now, since the Context may be modified as soon as
+    // we return.  Compressing and writing it can be done in the background.
+
+    auto buffer = make_shared<stringstream>(ios_base::in | ios_base::out | ios_base::binary);
+    createCheckpoint(*buffer);
+    ostream* output = &stream;
+    return async(launch::async, [buffer, output, compress] () {
+        if (compress)
+            writeCompressedCheckpoint(buffer->str(), *output);
+        else {
+            *output << buffer->rdbuf();
+            output->flush();
+        }
+    });
+}
+
+/**
+ * The Context whose steps are being taken on the current thread, if any.
+ */
+static thread_local const ContextImpl* steppingContext = NULL;
+
+void ContextImpl::stepAsync(int steps) {
+    waitForSteps();
+    lock_guard<mutex> guard(pendingStepsLock);
+    pendingSteps = async(launch::async, [this, steps] () {
+        steppingContext = this;
+        try {
+            integrator.step(steps);
+        }
+        catch (...) {
+            steppingContext = NULL;
+            throw;
+        }
+        steppingContext = NULL;
+    });
+}
+
+void ContextImpl::waitForSteps() {
+    // The Integrator may call back into the Context while taking steps.  That must not wait
+    // for itself, and must not touch the future, which the thread that launched the steps
+    // may be reading or assigning at the same time.
+
+    if (steppingContext == this)
+        return;
+    lock_guard<mutex> guard(pendingStepsLock);
+    if (pendingSteps.valid())
+        pendingSteps.get();
+}
+
 void ContextImpl::loadCheckpoint(istream& stream) {
     static const int magiclength = sizeof(CHECKPOINT_MAGIC_BYTES)/sizeof(CHECKPOINT_MAGIC_BYTES[0]);
     char magicbytes[magiclength];
     stream.read(magicbytes, magiclength);
+    static const int compressedMagicLength = sizeof(COMPRESSED_CHECKPOINT_MAGIC_BYTES)/sizeof(COMPRESSED_CHECKPOINT_MAGIC_BYTES[0]);
+    if (stream && memcmp(magicbytes, COMPRESSED_CHECKPOINT_MAGIC_BYTES, magiclength) == 0) {
+        // The compressed header is longer than the uncompressed one, so read the rest of it.
+
+        char remainder[compressedMagicLength-magiclength];
+        stream.read(remainder, compressedMagicLength-magiclength);
+        if (memcmp(remainder, COMPRESSED_CHECKPOINT_MAGIC_BYTES+magiclength, compressedMagicLength-magiclength) != 0)
+            throw OpenMMException("loadCheckpoint: Checkpoint header was not correct");
+        stringstream buffer(readCompressedCheckpoint(stream), ios_base::in | ios_base::binary);
+        loadCheckpoint(buffer);
+        return;
+    }
     if (memcmp(magicbytes, CHECKPOINT_MAGIC_BYTES, magiclength) != 0)
         throw OpenMMException("loadCheckpoint: Checkpoint header was not correct");
 
@@ -487,14 +755,52 @@ void ContextImpl::loadCheckpoint(istream& stream) {
         throw OpenMMException("loadCheckpoint: Checkpoint contains the wrong number of particles");
     int numParameters;
     stream.read((char*) &numParameters, sizeof(int));
+    vector<string> changedParameters;
     for (int i = 0; i < numParameters; i++) {
         string name = readString(stream);
         double value;
         stream.read((char*) &value, sizeof(double));
+        auto param = parameters.find(name);
+        if (param == parameters.end() || param->second != value)
+            changedParameters.push_back(name);
         parameters[name] = value;
     }
     updateStateDataKernel.getAs<UpdateStateDataKernel>().loadCheckpoint(*this, stream);
     integrator.loadCheckpoint(stream);
+
+    // Checkpoints created by older versions do not contain any data for the ForceImpls.  In that case
+    // whatever follows belongs to the caller, so put back anything that was read.
+
+    static const int forceDataMagicLength = sizeof(FORCE_DATA_MAGIC_BYTES)/sizeof(FORCE_DATA_MAGIC_BYTES[0]);
+    char forceDataMagicBytes[forceDataMagicLength];
+    streampos forceDataStart = stream.tellg();
+    stream.read(forceDataMagicBytes, forceDataMagicLength);
+    int numForceData = 0;
+    if (stream && memcmp(forceDataMagicBytes, FORCE_DATA_MAGIC_BYTES, forceDataMagicLength) == 0) {
+        int version;
+        stream.read((char*) &version, sizeof(int));
+        if (!stream || version != FORCE_DATA_VERSION)
+            throw OpenMMException("loadCheckpoint: Checkpoint contains an unsupported version of Force data");
+        stream.read((char*) &numForceData, sizeof(int));
+    }
+    else {
+        stream.clear();
+        if (forceDataStart != streampos(-1))
+            stream.seekg(forceDataStart);
+    }
+    for (int i = 0; i < numForceData; i++) {
+        int forceIndex;
+        stream.read((char*) &forceIndex, sizeof(int));
+        stringstream data(readString(stream), ios_base::in | ios_base::binary);
+        if (forceIndex >= 0 && forceIndex < (int) forceImpls.size())
+            forceImpls[forceIndex]->loadCheckpoint(*this, data);
+    }
+
+    // Let the ForceImpls update anything that depends on the parameters that were restored.
+
+    for (const string& name : changedParameters)
+        for (auto impl : forceImpls)
+            impl->contextParameterChanged(*this, name, parameters[name]);
     hasSetPositions = true;
     integrator.stateChanged(State::Positions);
     integrator.stateChanged(State::Velocities);
@@ -34,6 +34,7 @@
 #include "openmm/CustomNonbondedForce.h"
 #include "openmm/internal/AssertionUtilities.h"
 #include "openmm/internal/CustomNonbondedForceImpl.h"
+#include "openmm/internal/ExclusionList.h"
 #include <cmath>
 #include <map>
 #include <sstream>
@@ -199,6 +200,17 @@ int CustomNonbondedForce::addExclusion(int particle1, int particle2) {
     exclusions.push_back(ExclusionInfo(particle1, particle2));
     return exclusions.size()-1;
 }
+
+int CustomNonbondedForce::addExclusions(const vector<int>& particle1, const vector<int>& particle2) {
+    if (particle2.size() != particle1.size())
+        throw OpenMMException("CustomNonbondedForce: All arrays passed to addExclusions() must have the same length");
+    int first = exclusions.size();
+    exclusions.reserve(first+particle1.size());
+    for (int i = 0; i < particle1.size(); i++)
+        exclusions.push_back(ExclusionInfo(particle1[i], particle2[i]));
+    return first;
+}
+
 void CustomNonbondedForce::getExclusionParticles(int index, int& particle1, int& particle2) const {
     ASSERT_VALID_INDEX(index, exclusions);
     particle1 = exclusions[index].particle1;
@@ -217,26 +229,12 @@ void CustomNonbondedForce::createExclusionsFromBonds(const vector<pair<int, int>
     for (auto& bond : bonds)
         if (bond.first < 0 || bond.second < 0 || bond.first >= particles.size() || bond.second >= particles.size())
             throw OpenMMException("createExclusionsFromBonds: Illegal particle index in list of bonds");
-    vector<set<int> > exclusions(particles.size());
-    vector<set<int> > bonded12(exclusions.size());
-    for (auto& bond : bonds) {
-        int p1 = bond.first;
-        int p2 = bond.second;
-        exclusions[p1].insert(p2);
-        exclusions[p2].insert(p1);
-        bonded12[p1].insert(p2);
-        bonded12[p2].insert(p1);
-    }
-    for (int level = 0; level < bondCutoff-1; level++) {
-        vector<set<int> > currentExclusions = exclusions;
-        for (int i = 0; i < (int) particles.size(); i++)
-            for (int j : currentExclusions[i])
-                exclusions[j].insert(bonded12[i].begin(), bonded12[i].end());
-    }
-    for (int i = 0; i < (int) exclusions.size(); ++i)
-        for (int j : exclusions[i])
-            if (j < i)
-                addExclusion(j, i);
+    vector<pair<int, int> > bondedPairs;
+    vector<int> separation;
+    ExclusionList::findBondedPairs(particles.size(), bonds, bondCutoff, bondedPairs, separation);
+    exclusions.reserve(exclusions.size()+bondedPairs.size());
+    for (auto& p : bondedPairs)
+        addExclusion(p.first, p.second);
 }
 
 int CustomNonbondedForce::addTabulatedFunction(const std::string& name, TabulatedFunction* function) {
@@ -334,6 +332,14 @@ ForceImpl* CustomNonbondedForce::createImpl() const {
     return new CustomNonbondedForceImpl(*this);
 }
 
+double CustomNonbondedForce::computeEnergyChange(Context& context, const vector<int>& particles, const vector<Vec3>& newPositions) const {
+    return dynamic_cast<const CustomNonbondedForceImpl&>(getImplInContext(context)).computeEnergyChange(getContextImpl(context), particles, newPositions);
+}
+
+double CustomNonbondedForce::computeParticleEnergy(Context& context, const vector<int>& particles) const {
+    return dynamic_cast<const CustomNonbondedForceImpl&>(getImplInContext(context)).computeParticleEnergy(getContextImpl(context), particles);
+}
+
 void CustomNonbondedForce::updateParametersInContext(Context& context) {
     dynamic_cast<CustomNonbondedForceImpl&>(getImplInContext(context)).updateParametersInContext(getContextImpl(context), firstChangedParticle, lastChangedParticle);
     if (numContexts == 1) {
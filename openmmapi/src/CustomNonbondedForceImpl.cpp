@@ -162,6 +162,7 @@ map<string, double> CustomNonbondedForceImpl::getDefaultParameters() {
 void CustomNonbondedForceImpl::updateParametersInContext(ContextImpl& context, int firstParticle, int lastParticle) {
     kernel.getAs<CalcCustomNonbondedForceKernel>().copyParametersToContext(context, owner, firstParticle, lastParticle);
     context.systemChanged();
+    localEnergyData.reset();
 }
 
 CustomNonbondedForceImpl::LongRangeCorrectionData CustomNonbondedForceImpl::prepareLongRangeCorrection(const CustomNonbondedForce& force, int numThreads) {
@@ -254,9 +255,45 @@ CustomNonbondedForceImpl::LongRangeCorrectionData CustomNonbondedForceImpl::prep
         data.computedValueNames.push_back(name+"2");
         data.computedValueExpressions.push_back(Lepton::Parser::parse(exp, functions).createCompiledExpression());
     }
+
+    // Record what the integrals depend on, so later calls can tell whether cached values are still valid.
+
+    stringstream distances;
+    distances.precision(17);
+    distances << force.getCutoffDistance() << " " << force.getUseSwitchingFunction() << " " << force.getSwitchingDistance();
+    data.definition.push_back(force.getEnergyFunction());
+    data.definition.push_back(distances.str());
+    data.definition.insert(data.definition.end(), data.paramNames.begin(), data.paramNames.end());
+    for (int i = 0; i < force.getNumComputedValues(); i++) {
+        string name, exp;
+        force.getComputedValueParameters(i, name, exp);
+        data.definition.push_back(exp);
+    }
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        data.definition.push_back(force.getGlobalParameterName(i));
+    for (int i = 0; i < force.getNumEnergyParameterDerivatives(); i++)
+        data.definition.push_back(force.getEnergyParameterDerivativeName(i));
+    for (int i = 0; i < force.getNumTabulatedFunctions(); i++)
+        data.functions.push_back(make_pair(force.getTabulatedFunctionName(i), shared_ptr<TabulatedFunction>(force.getTabulatedFunction(i).Copy())));
     return data;
 }
 
+CustomNonbondedForceImpl::LongRangeCorrectionData CustomNonbondedForceImpl::prepareLongRangeCorrection(const CustomNonbondedForce& force, int numThreads, LongRangeCorrectionData& previous) {
+    LongRangeCorrectionData data = prepareLongRangeCorrection(force, numThreads);
+    if (integralsAreCompatible(data, previous))
+        data.integralCache.swap(previous.integralCache);
+    return data;
+}
+
+bool CustomNonbondedForceImpl::integralsAreCompatible(const LongRangeCorrectionData& data1, const LongRangeCorrectionData& data2) {
+    if (data1.method != data2.method || data1.definition != data2.definition || data1.functions.size() != data2.functions.size())
+        return false;
+    for (int i = 0; i < data1.functions.size(); i++)
+        if (data1.functions[i].first != data2.functions[i].first || *data1.functions[i].second != *data2.functions[i].second)
+            return false;
+    return true;
+}
+
 void CustomNonbondedForceImpl::calcLongRangeCorrection(const CustomNonbondedForce& force, LongRangeCorrectionData& data, const Context& context, double& coefficient, vector<double>& derivatives, ThreadPool& threads) {
     if (data.method == CustomNonbondedForce::NoCutoff || data.method == CustomNonbondedForce::CutoffNonPeriodic) {
         coefficient = 0.0;
@@ -285,55 +322,79 @@ void CustomNonbondedForceImpl::calcLongRangeCorrection(const CustomNonbondedForc
         }
     }
 
-    // Compute the coefficient.  Use multiple threads to compute the integrals in parallel.
+    // Look up the integral for every pair of classes that interact, and make a list of the ones that
+    // are not already in the cache.  If global parameters take many different values, the cache could
+    // grow without limit, so discard it once it gets much larger than the set of pairs.
 
-    double nPart = (double) context.getSystem().getNumParticles();
-    double numInteractions = (nPart*(nPart+1))/2;
-    vector<double> threadSum(threads.getNumThreads(), 0.0);
-    atomic<int> atomicCounter(0);
-    threads.execute([&] (ThreadPool& threads, int threadIndex) {
-        Lepton::CompiledVectorExpression& expression = data.energyExpression[threadIndex];
-        while (true) {
-            int i = atomicCounter++;
-            if (i >= numClasses)
-                break;
-            for (int j = i; j < numClasses; j++)
-                threadSum[threadIndex] += data.interactionCount.at(make_pair(i, j))*integrateInteraction(expression, data.classes[i], data.classes[j],
-                        computedValues[i], computedValues[j], force, context, data.paramNames, data.computedValueNames);
-        }
-    });
-    threads.waitForThreads();
-    double sum = 0;
-    for (int i = 0; i < threadSum.size(); i++)
-        sum += threadSum[i];
-    sum /= numInteractions;
-    coefficient = 2*M_PI*nPart*nPart*sum;
-    
-    // Now do the same for parameter derivatives.
-    
+    if (data.integralCache.size() > 16*data.interactionCount.size())
+        data.integralCache.clear();
     int numDerivs = data.derivExpressions[0].size();
-    derivatives.resize(numDerivs);
-    for (int k = 0; k < numDerivs; k++) {
-        atomicCounter = 0;
+    vector<double> globalValues;
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        globalValues.push_back(context.getParameter(force.getGlobalParameterName(i)));
+    vector<pair<int, int> > classPairs;
+    vector<const vector<double>*> pairIntegrals;
+    vector<pair<int, int> > missingPairs;
+    vector<vector<double> > missingKeys;
+    for (auto& count : data.interactionCount) {
+        if (count.second == 0)
+            continue;
+        int i = count.first.first, j = count.first.second;
+        vector<double> key = globalValues;
+        key.insert(key.end(), data.classes[i].begin(), data.classes[i].end());
+        key.insert(key.end(), data.classes[j].begin(), data.classes[j].end());
+        auto cached = data.integralCache.find(key);
+        classPairs.push_back(count.first);
+        if (cached == data.integralCache.end()) {
+            pairIntegrals.push_back(NULL);
+            missingPairs.push_back(count.first);
+            missingKeys.push_back(key);
+        }
+        else
+            pairIntegrals.push_back(&cached->second);
+    }
+
+    // Compute the missing integrals.  Each class pair is an independent task, and the energy and
+    // all its derivatives are integrated together, so the work is spread evenly over the threads.
+
+    if (missingPairs.size() > 0) {
+        vector<vector<double> > results(missingPairs.size(), vector<double>(numDerivs+1));
+        atomic<int> atomicCounter(0);
         threads.execute([&] (ThreadPool& threads, int threadIndex) {
-            threadSum[threadIndex] = 0;
-            Lepton::CompiledVectorExpression& expression = data.derivExpressions[threadIndex][k];
             while (true) {
-                int i = atomicCounter++;
-                if (i >= numClasses)
+                int index = atomicCounter++;
+                if (index >= missingPairs.size())
                     break;
-                for (int j = i; j < numClasses; j++)
-                    threadSum[threadIndex] += data.interactionCount.at(make_pair(i, j))*integrateInteraction(expression, data.classes[i], data.classes[j],
+                int i = missingPairs[index].first, j = missingPairs[index].second;
+                results[index][0] = integrateInteraction(data.energyExpression[threadIndex], data.classes[i], data.classes[j],
+                        computedValues[i], computedValues[j], force, context, data.paramNames, data.computedValueNames);
+                for (int k = 0; k < numDerivs; k++)
+                    results[index][k+1] = integrateInteraction(data.derivExpressions[threadIndex][k], data.classes[i], data.classes[j],
                             computedValues[i], computedValues[j], force, context, data.paramNames, data.computedValueNames);
             }
         });
         threads.waitForThreads();
-        sum = 0;
-        for (int i = 0; i < threadSum.size(); i++)
-            sum += threadSum[i];
-        sum /= numInteractions;
-        derivatives[k] = 2*M_PI*nPart*nPart*sum;
+        for (int i = 0; i < missingPairs.size(); i++)
+            data.integralCache[missingKeys[i]] = results[i];
+        for (int i = 0, next = 0; i < classPairs.size(); i++)
+            if (pairIntegrals[i] == NULL)
+                pairIntegrals[i] = &data.integralCache[missingKeys[next++]];
+    }
+
+    // Sum the contributions in a fixed order so the result is reproducible.
+
+    double nPart = (double) context.getSystem().getNumParticles();
+    double numInteractions = (nPart*(nPart+1))/2;
+    vector<double> sum(numDerivs+1, 0.0);
+    for (int i = 0; i < classPairs.size(); i++) {
+        double count = (double) data.interactionCount.at(classPairs[i]);
+        for (int k = 0; k <= numDerivs; k++)
+            sum[k] += count*(*pairIntegrals[i])[k];
     }
+    coefficient = 2*M_PI*nPart*nPart*sum[0]/numInteractions;
+    derivatives.resize(numDerivs);
+    for (int k = 0; k < numDerivs; k++)
+        derivatives[k] = 2*M_PI*nPart*nPart*sum[k+1]/numInteractions;
 }
 
 double CustomNonbondedForceImpl::integrateInteraction(Lepton::CompiledVectorExpression& expression, const vector<double>& params1, const vector<double>& params2,
@@ -452,3 +513,218 @@ double CustomNonbondedForceImpl::integrateInteraction(Lepton::CompiledVectorExpr
     }
     return sum/cutoff+sum2;
 }
+
+class CustomNonbondedForceImpl::LocalEnergyData {
+public:
+    Lepton::CompiledExpression energyExpression;
+    std::vector<Lepton::CompiledExpression> computedValueExpressions;
+    std::vector<double*> energyParams1, energyParams2, energyValues1, energyValues2, energyGlobals;
+    std::vector<std::vector<double*> > computedValueParams, computedValueGlobals;
+    double* energyR;
+    double unused;
+    std::vector<double> globalValues;
+    std::vector<std::vector<double> > particleParams, computedValues;
+    std::vector<std::set<int> > exclusions;
+    std::vector<std::pair<std::set<int>, std::set<int> > > groups;
+    double* getVariablePointer(Lepton::CompiledExpression& expression, const std::string& name) {
+        if (expression.getVariables().find(name) == expression.getVariables().end())
+            return &unused;
+        return &expression.getVariableReference(name);
+    }
+};
+
+CustomNonbondedForceImpl::LocalEnergyData& CustomNonbondedForceImpl::getLocalEnergyData(ContextImpl& context) const {
+    int numParticles = owner.getNumParticles();
+    int numParams = owner.getNumPerParticleParameters();
+    int numGlobals = owner.getNumGlobalParameters();
+    if (localEnergyData == nullptr) {
+        // Compile the expressions and record the variables they depend on.
+
+        localEnergyData.reset(new LocalEnergyData());
+        LocalEnergyData& data = *localEnergyData;
+        map<string, Lepton::CustomFunction*> functions;
+        for (int i = 0; i < owner.getNumTabulatedFunctions(); i++)
+            functions[owner.getTabulatedFunctionName(i)] = createReferenceTabulatedFunction(owner.getTabulatedFunction(i));
+        data.energyExpression = Lepton::Parser::parse(owner.getEnergyFunction(), functions).createCompiledExpression();
+        for (int i = 0; i < owner.getNumComputedValues(); i++) {
+            string name, expression;
+            owner.getComputedValueParameters(i, name, expression);
+            data.computedValueExpressions.push_back(Lepton::Parser::parse(expression, functions).createCompiledExpression());
+        }
+        for (auto& function : functions)
+            delete function.second;
+        for (int i = 0; i < numParams; i++) {
+            const string& name = owner.getPerParticleParameterName(i);
+            data.energyParams1.push_back(data.getVariablePointer(data.energyExpression, name+"1"));
+            data.energyParams2.push_back(data.getVariablePointer(data.energyExpression, name+"2"));
+        }
+        for (int i = 0; i < owner.getNumComputedValues(); i++) {
+            string name, expression;
+            owner.getComputedValueParameters(i, name, expression);
+            data.energyValues1.push_back(data.getVariablePointer(data.energyExpression, name+"1"));
+            data.energyValues2.push_back(data.getVariablePointer(data.energyExpression, name+"2"));
+        }
+        data.energyR = data.getVariablePointer(data.energyExpression, "r");
+        for (int i = 0; i < numGlobals; i++)
+            data.energyGlobals.push_back(data.getVariablePointer(data.energyExpression, owner.getGlobalParameterName(i)));
+        data.computedValueParams.resize(data.computedValueExpressions.size());
+        data.computedValueGlobals.resize(data.computedValueExpressions.size());
+        for (int i = 0; i < data.computedValueExpressions.size(); i++) {
+            for (int j = 0; j < numParams; j++)
+                data.computedValueParams[i].push_back(data.getVariablePointer(data.computedValueExpressions[i], owner.getPerParticleParameterName(j)));
+            for (int j = 0; j < numGlobals; j++)
+                data.computedValueGlobals[i].push_back(data.getVariablePointer(data.computedValueExpressions[i], owner.getGlobalParameterName(j)));
+        }
+
+        // Record the per-particle parameters, exclusions, and interaction groups.
+
+        data.particleParams.resize(numParticles);
+        for (int i = 0; i < numParticles; i++)
+            owner.getParticleParameters(i, data.particleParams[i]);
+        data.exclusions.resize(numParticles);
+        for (int i = 0; i < owner.getNumExclusions(); i++) {
+            int p1, p2;
+            owner.getExclusionParticles(i, p1, p2);
+            data.exclusions[p1].insert(p2);
+            data.exclusions[p2].insert(p1);
+        }
+        data.groups.resize(owner.getNumInteractionGroups());
+        for (int i = 0; i < owner.getNumInteractionGroups(); i++)
+            owner.getInteractionGroupParameters(i, data.groups[i].first, data.groups[i].second);
+    }
+
+    // Update the global parameters, and reevaluate the computed values if any of them changed.
+
+    LocalEnergyData& data = *localEnergyData;
+    vector<double> globalValues(numGlobals);
+    for (int i = 0; i < numGlobals; i++)
+        globalValues[i] = context.getParameter(owner.getGlobalParameterName(i));
+    if (data.computedValues.size() != numParticles || globalValues != data.globalValues) {
+        data.globalValues = globalValues;
+        for (int i = 0; i < numGlobals; i++) {
+            *data.energyGlobals[i] = globalValues[i];
+            for (auto& globals : data.computedValueGlobals)
+                *globals[i] = globalValues[i];
+        }
+        data.computedValues.resize(numParticles, vector<double>(data.computedValueExpressions.size()));
+        for (int i = 0; i < numParticles; i++)
+            for (int j = 0; j < data.computedValueExpressions.size(); j++) {
+                for (int k = 0; k < numParams; k++)
+                    *data.computedValueParams[j][k] = data.particleParams[i][k];
+                data.computedValues[i][j] = data.computedValueExpressions[j].evaluate();
+            }
+    }
+    return data;
+}
+
+double CustomNonbondedForceImpl::computeLocalEnergy(ContextImpl& context, const vector<Vec3>& positions, const vector<int>& particles) const {
+    int numParticles = owner.getNumParticles();
+    vector<bool> inSubset(numParticles, false);
+    for (int i : particles) {
+        if (i < 0 || i >= numParticles || inSubset[i]) {
+            stringstream msg;
+            msg << "CustomNonbondedForce: Illegal or repeated particle index: ";
+            msg << i;
+            throw OpenMMException(msg.str());
+        }
+        inSubset[i] = true;
+    }
+    LocalEnergyData& data = getLocalEnergyData(context);
+    int numParams = owner.getNumPerParticleParameters();
+    const vector<vector<double> >& particleParams = data.particleParams;
+    const vector<vector<double> >& computedValues = data.computedValues;
+    const vector<set<int> >& exclusions = data.exclusions;
+
+    // Evaluate one interaction, following the same rules as a normal energy evaluation.
+
+    Vec3 boxVectors[3];
+    context.getPeriodicBoxVectors(boxVectors[0], boxVectors[1], boxVectors[2]);
+    bool periodic = owner.usesPeriodicBoundaryConditions();
+    bool cutoff = (owner.getNonbondedMethod() != CustomNonbondedForce::NoCutoff);
+    double cutoffDistance = owner.getCutoffDistance();
+    double switchingDistance = owner.getSwitchingDistance();
+    bool useSwitch = cutoff && owner.getUseSwitchingFunction();
+    auto computeInteraction = [&] (int p1, int p2) {
+        Vec3 delta = positions[p2]-positions[p1];
+        if (periodic) {
+            delta -= boxVectors[2]*floor(delta[2]/boxVectors[2][2]+0.5);
+            delta -= boxVectors[1]*floor(delta[1]/boxVectors[1][1]+0.5);
+            delta -= boxVectors[0]*floor(delta[0]/boxVectors[0][0]+0.5);
+        }
+        double r = sqrt(delta.dot(delta));
+        if (cutoff && r >= cutoffDistance)
+            return 0.0;
+        for (int i = 0; i < numParams; i++) {
+            *data.energyParams1[i] = particleParams[p1][i];
+            *data.energyParams2[i] = particleParams[p2][i];
+        }
+        for (int i = 0; i < data.energyValues1.size(); i++) {
+            *data.energyValues1[i] = computedValues[p1][i];
+            *data.energyValues2[i] = computedValues[p2][i];
+        }
+        *data.energyR = r;
+        double energy = data.energyExpression.evaluate();
+        if (useSwitch && r > switchingDistance) {
+            double t = (r-switchingDistance)/(cutoffDistance-switchingDistance);
+            energy *= 1+t*t*t*(-10+t*(15-t*6));
+        }
+        return energy;
+    };
+
+    // Loop over every interaction that involves at least one particle in the subset.
+
+    double energy = 0.0;
+    if (owner.getNumInteractionGroups() == 0) {
+        for (int i : particles)
+            for (int j = 0; j < numParticles; j++) {
+                if (j == i || (inSubset[j] && j < i) || exclusions[i].find(j) != exclusions[i].end())
+                    continue;
+                energy += computeInteraction(i, j);
+            }
+    }
+    else {
+        for (auto& group : data.groups) {
+            const set<int>& set1 = group.first;
+            const set<int>& set2 = group.second;
+            auto includePair = [&] (int atom1, int atom2) {
+                if (atom1 == atom2)
+                    return false;
+                if (atom1 > atom2 && set1.find(atom2) != set1.end() && set2.find(atom1) != set2.end())
+                    return false; // Both atoms are in both sets, so skip duplicate interactions.
+                int subsetAtom = (inSubset[atom1] ? atom1 : atom2);
+                int otherAtom = (subsetAtom == atom1 ? atom2 : atom1);
+                return (exclusions[subsetAtom].find(otherAtom) == exclusions[subsetAtom].end());
+            };
+            for (int i : particles) {
+                if (set1.find(i) != set1.end())
+                    for (int atom2 : set2)
+                        if (includePair(i, atom2))
+                            energy += computeInteraction(i, atom2);
+                if (set2.find(i) != set2.end())
+                    for (int atom1 : set1)
+                        if (!inSubset[atom1] && includePair(atom1, i))
+                            energy += computeInteraction(atom1, i);
+            }
+        }
+    }
+    return energy;
+}
+
+double CustomNonbondedForceImpl::computeEnergyChange(ContextImpl& context, const vector<int>& particles, const vector<Vec3>& newPositions) const {
+    if (newPositions.size() != particles.size())
+        throw OpenMMException("CustomNonbondedForce: The number of positions does not match the number of particles");
+    vector<Vec3> oldPositions;
+    context.getPositions(oldPositions);
+    vector<Vec3> positions = oldPositions;
+    for (int i = 0; i < particles.size(); i++) {
+        if (particles[i] >= 0 && particles[i] < positions.size())
+            positions[particles[i]] = newPositions[i];
+    }
+    return computeLocalEnergy(context, positions, particles)-computeLocalEnergy(context, oldPositions, particles);
+}
+
+double CustomNonbondedForceImpl::computeParticleEnergy(ContextImpl& context, const vector<int>& particles) const {
+    vector<Vec3> positions;
+    context.getPositions(positions);
+    return computeLocalEnergy(context, positions, particles);
+}
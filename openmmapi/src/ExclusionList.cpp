@@ -0,0 +1,178 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/ExclusionList.h"
+#include "openmm/internal/ThreadPool.h"
+#include <algorithm>
+#include <iterator>
+
+using namespace OpenMM;
+using namespace std;
+
+ExclusionList::ExclusionList() : offsets(1, 0) {
+}
+
+ExclusionList::ExclusionList(int numAtoms) : offsets(numAtoms+1, 0) {
+}
+
+ExclusionList::ExclusionList(int numAtoms, const vector<pair<int, int> >& pairs) {
+    initialize(numAtoms, pairs, NULL);
+}
+
+ExclusionList::ExclusionList(int numAtoms, const vector<pair<int, int> >& pairs, ThreadPool& threads) {
+    initialize(numAtoms, pairs, &threads);
+}
+
+ExclusionList::ExclusionList(const vector<set<int> >& exclusions) : offsets(exclusions.size()+1) {
+    offsets[0] = 0;
+    for (int i = 0; i < exclusions.size(); i++)
+        offsets[i+1] = offsets[i]+exclusions[i].size();
+    indices.reserve(offsets.back());
+    for (const set<int>& atomExclusions : exclusions)
+        indices.insert(indices.end(), atomExclusions.begin(), atomExclusions.end());
+}
+
+void ExclusionList::initialize(int numAtoms, const vector<pair<int, int> >& pairs, ThreadPool* threads) {
+    // Count the exclusions of each atom and scatter them into place.
+
+    offsets.resize(numAtoms+1, 0);
+    for (const pair<int, int>& p : pairs) {
+        offsets[p.first+1]++;
+        if (p.second != p.first)
+            offsets[p.second+1]++;
+    }
+    for (int i = 0; i < numAtoms; i++)
+        offsets[i+1] += offsets[i];
+    indices.resize(offsets[numAtoms]);
+    vector<int> next(offsets.begin(), offsets.end()-1);
+    for (const pair<int, int>& p : pairs) {
+        indices[next[p.first]++] = p.second;
+        if (p.second != p.first)
+            indices[next[p.second]++] = p.first;
+    }
+
+    // Sort the exclusions of each atom and remove duplicates.  This is the expensive part, so
+    // it is done in parallel when possible.  next[i] is reused to hold the number of unique
+    // exclusions of atom i.
+
+    auto sortAtoms = [&] (int start, int stride) {
+        for (int i = start; i < numAtoms; i += stride) {
+            int* first = indices.data()+offsets[i];
+            int* last = indices.data()+offsets[i+1];
+            sort(first, last);
+            next[i] = unique(first, last)-first;
+        }
+    };
+    if (threads == NULL)
+        sortAtoms(0, 1);
+    else {
+        threads->execute([&] (ThreadPool& pool, int threadIndex) { sortAtoms(threadIndex, pool.getNumThreads()); });
+        threads->waitForThreads();
+    }
+
+    // Compact the list to remove the space left by duplicates.
+
+    int total = 0;
+    for (int i = 0; i < numAtoms; i++) {
+        int start = offsets[i];
+        offsets[i] = total;
+        if (start != total)
+            copy(indices.begin()+start, indices.begin()+start+next[i], indices.begin()+total);
+        total += next[i];
+    }
+    offsets[numAtoms] = total;
+    indices.resize(total);
+}
+
+void ExclusionList::findBondedPairs(int numAtoms, const vector<pair<int, int> >& bonds, int maxSeparation,
+            vector<pair<int, int> >& pairs, vector<int>& separation) {
+    // Small systems are not worth the cost of creating threads.
+
+    ThreadPool* threads = (numAtoms >= 10000 ? new ThreadPool() : NULL);
+    ExclusionList bonded = (threads == NULL ? ExclusionList(numAtoms, bonds) : ExclusionList(numAtoms, bonds, *threads));
+    int numChunks = (threads == NULL ? 1 : threads->getNumThreads());
+    vector<vector<pair<int, int> > > chunkPairs(numChunks);
+    vector<vector<int> > chunkSeparation(numChunks);
+
+    // Each chunk is a contiguous range of atoms, so concatenating them gives the pairs in order.
+    // For each atom, do a breadth first search outward along bonds, keeping a sorted list of the
+    // atoms found so far.
+
+    auto searchChunk = [&] (int chunk) {
+        int start = (int) ((long long) chunk*numAtoms/numChunks);
+        int end = (int) ((long long) (chunk+1)*numAtoms/numChunks);
+        vector<int> visited, frontier, candidates, found, merged;
+        vector<pair<int, int> > atomPairs;
+        for (int i = start; i < end; i++) {
+            visited.assign(1, i);
+            frontier.assign(1, i);
+            atomPairs.clear();
+            for (int level = 1; level <= maxSeparation && !frontier.empty(); level++) {
+                candidates.clear();
+                for (int atom : frontier)
+                    candidates.insert(candidates.end(), bonded[atom].begin(), bonded[atom].end());
+                sort(candidates.begin(), candidates.end());
+                candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+                found.clear();
+                set_difference(candidates.begin(), candidates.end(), visited.begin(), visited.end(), back_inserter(found));
+                for (int j : found)
+                    if (j < i)
+                        atomPairs.push_back(make_pair(j, level));
+                merged.clear();
+                merge(visited.begin(), visited.end(), found.begin(), found.end(), back_inserter(merged));
+                visited.swap(merged);
+                frontier.swap(found);
+            }
+            sort(atomPairs.begin(), atomPairs.end());
+            for (auto& p : atomPairs) {
+                chunkPairs[chunk].push_back(make_pair(p.first, i));
+                chunkSeparation[chunk].push_back(p.second);
+            }
+        }
+    };
+    if (threads == NULL)
+        searchChunk(0);
+    else {
+        threads->execute([&] (ThreadPool& pool, int threadIndex) { searchChunk(threadIndex); });
+        threads->waitForThreads();
+        delete threads;
+    }
+    pairs.clear();
+    separation.clear();
+    for (int i = 0; i < numChunks; i++) {
+        pairs.insert(pairs.end(), chunkPairs[i].begin(), chunkPairs[i].end());
+        separation.insert(separation.end(), chunkSeparation[i].begin(), chunkSeparation[i].end());
+    }
+}
+
+int ExclusionList::Range::count(int atom) const {
+    return (binary_search(first, last, atom) ? 1 : 0);
+}
@@ -30,6 +30,7 @@
  * -------------------------------------------------------------------------- */
 
 #include "openmm/internal/ForceImpl.h"
+#include "openmm/Force.h"
 
 using namespace OpenMM;
 using namespace std;
@@ -44,3 +45,7 @@ void ForceImpl::updateContextState(ContextImpl& context, bool& forcesInvalid) {
 
 void ForceImpl::updateContextState(ContextImpl& context) {
 }
+
+int ForceImpl::getForceGroups() const {
+    return 1<<getOwner().getForceGroup();
+}
@@ -46,6 +46,18 @@ int HarmonicAngleForce::addAngle(int particle1, int particle2, int particle3, do
     return angles.size()-1;
 }
 
+int HarmonicAngleForce::addAngles(const vector<int>& particle1, const vector<int>& particle2, const vector<int>& particle3,
+                                  const vector<double>& angle, const vector<double>& k) {
+    int numAngles = particle1.size();
+    if (particle2.size() != numAngles || particle3.size() != numAngles || angle.size() != numAngles || k.size() != numAngles)
+        throw OpenMMException("HarmonicAngleForce: All arrays passed to addAngles() must have the same length");
+    int first = angles.size();
+    angles.reserve(first+numAngles);
+    for (int i = 0; i < numAngles; i++)
+        angles.push_back(AngleInfo(particle1[i], particle2[i], particle3[i], angle[i], k[i]));
+    return first;
+}
+
 void HarmonicAngleForce::getAngleParameters(int index, int& particle1, int& particle2, int& particle3, double& angle, double& k) const {
     ASSERT_VALID_INDEX(index, angles);
     particle1 = angles[index].particle1;
@@ -46,6 +46,17 @@ int HarmonicBondForce::addBond(int particle1, int particle2, double length, doub
     return bonds.size()-1;
 }
 
+int HarmonicBondForce::addBonds(const vector<int>& particle1, const vector<int>& particle2, const vector<double>& length, const vector<double>& k) {
+    int numBonds = particle1.size();
+    if (particle2.size() != numBonds || length.size() != numBonds || k.size() != numBonds)
+        throw OpenMMException("HarmonicBondForce: All arrays passed to addBonds() must have the same length");
+    int first = bonds.size();
+    bonds.reserve(first+numBonds);
+    for (int i = 0; i < numBonds; i++)
+        bonds.push_back(BondInfo(particle1[i], particle2[i], length[i], k[i]));
+    return first;
+}
+
 void HarmonicBondForce::getBondParameters(int index, int& particle1, int& particle2, double& length, double& k) const {
     ASSERT_VALID_INDEX(index, bonds);
     particle1 = bonds[index].particle1;
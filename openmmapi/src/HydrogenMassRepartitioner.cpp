@@ -0,0 +1,127 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+#include "openmm/HydrogenMassRepartitioner.h"
+#include "openmm/CustomBondForce.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/OpenMMException.h"
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+static bool isHydrogen(const System& system, int particle) {
+    double mass = system.getParticleMass(particle);
+    return (mass > 0.5 && mass < 1.5);
+}
+
+static void addBond(vector<set<int> >& bonded, int particle1, int particle2) {
+    bonded[particle1].insert(particle2);
+    bonded[particle2].insert(particle1);
+}
+
+int HydrogenMassRepartitioner::repartition(System& system, double hydrogenMass) {
+    if (hydrogenMass <= 0)
+        throw OpenMMException("HydrogenMassRepartitioner: The hydrogen mass must be positive");
+    int numParticles = system.getNumParticles();
+
+    // Find the particles each one is bonded to.  Bonds in CustomBondForces are kept separately,
+    // since those forces are sometimes used for interactions other than bonds, such as 1-4 pairs.
+
+    vector<set<int> > bonded(numParticles), customBonded(numParticles);
+    for (int i = 0; i < system.getNumConstraints(); i++) {
+        int particle1, particle2;
+        double distance;
+        system.getConstraintParameters(i, particle1, particle2, distance);
+        addBond(bonded, particle1, particle2);
+    }
+    for (int i = 0; i < system.getNumForces(); i++) {
+        const HarmonicBondForce* harmonic = dynamic_cast<const HarmonicBondForce*>(&system.getForce(i));
+        if (harmonic != NULL) {
+            for (int j = 0; j < harmonic->getNumBonds(); j++) {
+                int particle1, particle2;
+                double length, k;
+                harmonic->getBondParameters(j, particle1, particle2, length, k);
+                addBond(bonded, particle1, particle2);
+            }
+        }
+        const CustomBondForce* custom = dynamic_cast<const CustomBondForce*>(&system.getForce(i));
+        if (custom != NULL) {
+            for (int j = 0; j < custom->getNumBonds(); j++) {
+                int particle1, particle2;
+                vector<double> parameters;
+                custom->getBondParameters(j, particle1, particle2, parameters);
+                addBond(customBonded, particle1, particle2);
+            }
+        }
+    }
+
+    // Find the heavy atom each hydrogen is bonded to.  Do this before changing any masses,
+    // since the changes would affect which particles look like hydrogens.
+
+    vector<pair<int, int> > transfers;
+    for (int i = 0; i < numParticles; i++) {
+        if (!isHydrogen(system, i) || system.isVirtualSite(i))
+            continue;
+        const set<int>& partners = (bonded[i].size() > 0 ? bonded[i] : customBonded[i]);
+        if (partners.size() == 0)
+            continue;
+        int heavyAtom = -1;
+        bool bondedToHydrogen = false;
+        for (int j : partners) {
+            if (isHydrogen(system, j))
+                bondedToHydrogen = true;
+            else if (system.getParticleMass(j) > 0) {
+                if (heavyAtom != -1)
+                    throw OpenMMException("HydrogenMassRepartitioner: Particle "+to_string(i)+" looks like a hydrogen but is bonded to more than one heavy atom");
+                heavyAtom = j;
+            }
+        }
+        if (heavyAtom != -1 && !bondedToHydrogen)
+            transfers.push_back(make_pair(i, heavyAtom));
+    }
+
+    // Move mass from each heavy atom to its hydrogens.
+
+    for (auto& transfer : transfers) {
+        int hydrogen = transfer.first;
+        int heavyAtom = transfer.second;
+        double heavyMass = system.getParticleMass(heavyAtom)-(hydrogenMass-system.getParticleMass(hydrogen));
+        if (heavyMass <= 0)
+            throw OpenMMException("HydrogenMassRepartitioner: Repartitioning would give particle "+to_string(heavyAtom)+" a mass that is not positive");
+        system.setParticleMass(heavyAtom, heavyMass);
+        system.setParticleMass(hydrogen, hydrogenMass);
+    }
+    return transfers.size();
+}
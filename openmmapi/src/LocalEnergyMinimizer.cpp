@@ -33,6 +33,7 @@
 #include "openmm/OpenMMException.h"
 #include "openmm/Platform.h"
 #include "openmm/VerletIntegrator.h"
+#include "openmm/internal/ContextImpl.h"
 #include "lbfgs.h"
 #include <cmath>
 #include <sstream>
@@ -196,6 +197,12 @@ static int report(void *instance, const lbfgsfloatval_t *x, const lbfgsfloatval_
 }
 
 void LocalEnergyMinimizer::minimize(Context& context, double tolerance, int maxIterations, MinimizationReporter* reporter) {
+    // If the platform can perform the minimization itself, let it do so.  That avoids transferring
+    // positions and forces on every step.  Reporters need the full coordinates at every iteration,
+    // so they always use the implementation below.
+
+    if (reporter == NULL && context.getImpl().minimize(tolerance, maxIterations))
+        return;
     const System& system = context.getSystem();
     int numParticles = system.getNumParticles();
     double constraintTol = context.getIntegrator().getConstraintTolerance();
@@ -288,6 +295,6 @@ void LocalEnergyMinimizer::minimize(Context& context, double tolerance, int maxI
     // to the full precision requested by the user.
     
     if (constraintTol < workingConstraintTol)
-        context.applyConstraints(workingConstraintTol);
+        context.applyConstraints(constraintTol);
 }
 
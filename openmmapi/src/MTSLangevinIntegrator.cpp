@@ -0,0 +1,174 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2013-2026 Stanford University and the Authors.      *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/MTSLangevinIntegrator.h"
+#include "openmm/Context.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/internal/ContextImpl.h"
+#include "openmm/kernels.h"
+#include <algorithm>
+#include <string>
+
+using namespace OpenMM;
+using std::pair;
+using std::string;
+using std::vector;
+
+MTSLangevinIntegrator::MTSLangevinIntegrator(double temperature, double frictionCoeff, double stepSize, const vector<pair<int, int> >& groups) :
+        groups(groups), forcesAreValid(false), currentForceLevel(-1) {
+    if (groups.size() == 0)
+        throw OpenMMException("MTSLangevinIntegrator: No force groups specified");
+    std::stable_sort(this->groups.begin(), this->groups.end(), [](const pair<int, int>& a, const pair<int, int>& b) { return a.second < b.second; });
+    int parentSubsteps = 1;
+    for (auto& group : this->groups) {
+        if (group.first < 0 || group.first > 31)
+            throw OpenMMException("MTSLangevinIntegrator: Force group must be between 0 and 31");
+        if (group.second < parentSubsteps || group.second%parentSubsteps != 0)
+            throw OpenMMException("MTSLangevinIntegrator: The number for substeps for each group must be a multiple of the number for the previous group");
+        parentSubsteps = group.second;
+    }
+    savedForcesAreValid.resize(this->groups.size(), false);
+    setTemperature(temperature);
+    setFriction(frictionCoeff);
+    setStepSize(stepSize);
+    setConstraintTolerance(1e-5);
+    setRandomNumberSeed(0);
+}
+
+void MTSLangevinIntegrator::initialize(ContextImpl& contextRef) {
+    if (owner != NULL && &contextRef.getOwner() != owner)
+        throw OpenMMException("This Integrator is already bound to a context");
+    context = &contextRef;
+    owner = &contextRef.getOwner();
+    kernel = context->getPlatform().createKernel(IntegrateMTSLangevinStepKernel::Name(), contextRef);
+    kernel.getAs<IntegrateMTSLangevinStepKernel>().initialize(contextRef.getSystem(), *this);
+    invalidateForces();
+}
+
+void MTSLangevinIntegrator::setTemperature(double temp) {
+    if (temp < 0)
+        throw OpenMMException("Temperature cannot be negative");
+    temperature = temp;
+}
+
+void MTSLangevinIntegrator::setFriction(double coeff) {
+    if (coeff < 0)
+        throw OpenMMException("Friction cannot be negative");
+    friction = coeff;
+}
+
+void MTSLangevinIntegrator::cleanup() {
+    kernel = Kernel();
+}
+
+void MTSLangevinIntegrator::stateChanged(State::DataType changed) {
+    invalidateForces();
+}
+
+vector<string> MTSLangevinIntegrator::getKernelNames() {
+    std::vector<std::string> names;
+    names.push_back(IntegrateMTSLangevinStepKernel::Name());
+    return names;
+}
+
+double MTSLangevinIntegrator::computeKineticEnergy() {
+    return kernel.getAs<IntegrateMTSLangevinStepKernel>().computeKineticEnergy(*context, *this);
+}
+
+bool MTSLangevinIntegrator::kineticEnergyRequiresForce() const {
+    return false;
+}
+
+void MTSLangevinIntegrator::step(int steps) {
+    if (context == NULL)
+        throw OpenMMException("This Integrator is not bound to a context!");
+    IntegrateMTSLangevinStepKernel& mtsKernel = kernel.getAs<IntegrateMTSLangevinStepKernel>();
+    for (int i = 0; i < steps; ++i) {
+        if (context->updateContextState())
+            invalidateForces();
+        stepLevel(0, getStepSize());
+        if (!mtsKernel.finishStep(*context, *this))
+            invalidateForces();
+    }
+}
+
+void MTSLangevinIntegrator::stepLevel(int level, double dt) {
+    // The kick at the end of each substep and the one at the start of the next use the same
+    // forces, so they are merged into a single kick.
+
+    IntegrateMTSLangevinStepKernel& mtsKernel = kernel.getAs<IntegrateMTSLangevinStepKernel>();
+    int parentSubsteps = (level == 0 ? 1 : groups[level-1].second);
+    int numSubsteps = groups[level].second/parentSubsteps;
+    double substepSize = dt/numSubsteps;
+    bool innermost = (level == (int) groups.size()-1);
+    for (int i = 0; i < numSubsteps; i++) {
+        double kick = (i == 0 ? 0.5*substepSize : substepSize);
+        computeForces(level);
+        if (innermost) {
+            mtsKernel.innerStep(*context, *this, kick, substepSize);
+            invalidateForces();
+        }
+        else {
+            mtsKernel.kick(*context, *this, kick);
+            stepLevel(level+1, substepSize);
+        }
+    }
+    computeForces(level);
+    mtsKernel.kick(*context, *this, 0.5*substepSize);
+}
+
+void MTSLangevinIntegrator::computeForces(int level) {
+    IntegrateMTSLangevinStepKernel& mtsKernel = kernel.getAs<IntegrateMTSLangevinStepKernel>();
+    int groupFlags = 1<<groups[level].first;
+    int& lastForceGroups = context->getLastForceGroups();
+    if (forcesAreValid && currentForceLevel == level && lastForceGroups == groupFlags)
+        return;
+    if (forcesAreValid && currentForceLevel != -1 && lastForceGroups == 1<<groups[currentForceLevel].first && !savedForcesAreValid[currentForceLevel]) {
+        // Another level's forces are still valid.  Save them in case they are needed again at these positions.
+
+        mtsKernel.saveForces(*context, *this, currentForceLevel);
+        savedForcesAreValid[currentForceLevel] = true;
+    }
+    if (savedForcesAreValid[level]) {
+        mtsKernel.restoreForces(*context, *this, level);
+        lastForceGroups = groupFlags;
+    }
+    else
+        context->calcForcesAndEnergy(true, false, groupFlags);
+    currentForceLevel = level;
+    forcesAreValid = true;
+}
+
+void MTSLangevinIntegrator::invalidateForces() {
+    forcesAreValid = false;
+    currentForceLevel = -1;
+    savedForcesAreValid.assign(groups.size(), false);
+}
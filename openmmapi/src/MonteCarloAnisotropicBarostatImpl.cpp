@@ -72,7 +72,7 @@ void MonteCarloAnisotropicBarostatImpl::updateContextState(ContextImpl& context,
     // Compute the current potential energy.
     
     int groups = context.getIntegrator().getIntegrationForceGroups();
-    double initialEnergy = context.getOwner().getState(State::Energy, false, groups).getPotentialEnergy();
+    double initialEnergy = context.calcForcesAndEnergy(false, true, groups);
     double pressure;
     
     // Choose which axis to modify at random.
@@ -115,7 +115,7 @@ void MonteCarloAnisotropicBarostatImpl::updateContextState(ContextImpl& context,
 
     // Compute the energy of the modified system.
     
-    double finalEnergy = context.getOwner().getState(State::Energy, false, groups).getPotentialEnergy();
+    double finalEnergy = context.calcForcesAndEnergy(false, true, groups);
     double kT = BOLTZ*context.getParameter(MonteCarloAnisotropicBarostat::Temperature());
     double w = finalEnergy-initialEnergy + pressure*deltaVolume - context.getMolecules().size()*kT*log(newVolume/volume);
     if (w > 0 && SimTKOpenMMUtilities::getUniformlyDistributedRandomNumber() > exp(-w/kT)) {
@@ -179,7 +179,7 @@ Vec3 MonteCarloAnisotropicBarostatImpl::computeCurrentPressure(ContextImpl& cont
         scale1[axis] = 1.0+delta;
         context.getOwner().setPeriodicBoxVectors(box[0]*scale1[0], box[1]*scale1[1], box[2]*scale1[2]);
         kernel.getAs<ApplyMonteCarloBarostatKernel>().scaleCoordinates(context, scale1[0], scale1[1], scale1[2]);
-        double energy1 = context.getOwner().getState(State::Energy, false, groups).getPotentialEnergy();
+        double energy1 = context.calcForcesAndEnergy(false, true, groups);
 
         // Compute the second energy.
 
@@ -187,7 +187,7 @@ Vec3 MonteCarloAnisotropicBarostatImpl::computeCurrentPressure(ContextImpl& cont
         scale2[axis] = 1.0-delta;
         context.getOwner().setPeriodicBoxVectors(box[0]*scale2[0], box[1]*scale2[1], box[2]*scale2[2]);
         kernel.getAs<ApplyMonteCarloBarostatKernel>().scaleCoordinates(context, scale2[0]/scale1[0], scale2[1]/scale1[1], scale2[2]/scale1[2]);
-        double energy2 = context.getOwner().getState(State::Energy, false, groups).getPotentialEnergy();
+        double energy2 = context.calcForcesAndEnergy(false, true, groups);
 
         // Reset the box shape.
 
@@ -65,10 +65,11 @@ void MonteCarloBarostatImpl::updateContextState(ContextImpl& context, bool& forc
         return;
     step = 0;
 
-    // Compute the current potential energy.
+    // Compute the current potential energy.  This calls calcForcesAndEnergy() directly rather than
+    // getState(), which would also compute the kinetic energy (and for some integrators the forces).
 
     int groups = context.getIntegrator().getIntegrationForceGroups();
-    double initialEnergy = context.getOwner().getState(State::Energy, false, groups).getPotentialEnergy();
+    double initialEnergy = context.calcForcesAndEnergy(false, true, groups);
 
     // Modify the periodic box size.
 
@@ -84,7 +85,7 @@ void MonteCarloBarostatImpl::updateContextState(ContextImpl& context, bool& forc
 
     // Compute the energy of the modified system.
     
-    double finalEnergy = context.getOwner().getState(State::Energy, false, groups).getPotentialEnergy();
+    double finalEnergy = context.calcForcesAndEnergy(false, true, groups);
     double pressure = context.getParameter(MonteCarloBarostat::Pressure())*(AVOGADRO*1e-25);
     double kT = BOLTZ*context.getParameter(MonteCarloBarostat::Temperature());
     double w = finalEnergy-initialEnergy + pressure*deltaVolume - context.getMolecules().size()*kT*log(newVolume/volume);
@@ -139,14 +140,14 @@ double MonteCarloBarostatImpl::computeCurrentPressure(ContextImpl& context) {
     double scale1 = 1.0+delta;
     context.getOwner().setPeriodicBoxVectors(box[0]*scale1, box[1]*scale1, box[2]*scale1);
     kernel.getAs<ApplyMonteCarloBarostatKernel>().scaleCoordinates(context, scale1, scale1, scale1);
-    double energy1 = context.getOwner().getState(State::Energy, false, groups).getPotentialEnergy();
+    double energy1 = context.calcForcesAndEnergy(false, true, groups);
 
     // Compute the second energy.
 
     double scale2 = 1.0-delta;
     context.getOwner().setPeriodicBoxVectors(box[0]*scale2, box[1]*scale2, box[2]*scale2);
     kernel.getAs<ApplyMonteCarloBarostatKernel>().scaleCoordinates(context, scale2/scale1, scale2/scale1, scale2/scale1);
-    double energy2 = context.getOwner().getState(State::Energy, false, groups).getPotentialEnergy();
+    double energy2 = context.calcForcesAndEnergy(false, true, groups);
 
     // Restore the context to its original state.
 
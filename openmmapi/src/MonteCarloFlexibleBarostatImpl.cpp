@@ -68,7 +68,7 @@ void MonteCarloFlexibleBarostatImpl::updateContextState(ContextImpl& context, bo
     // Compute the current potential energy.
 
     int groups = context.getIntegrator().getIntegrationForceGroups();
-    double initialEnergy = context.getOwner().getState(State::Energy, false, groups).getPotentialEnergy();
+    double initialEnergy = context.calcForcesAndEnergy(false, true, groups);
     double pressure = context.getParameter(MonteCarloFlexibleBarostat::Pressure())*(AVOGADRO*1e-25);
 
     // Generate trial box vectors
@@ -106,7 +106,7 @@ void MonteCarloFlexibleBarostatImpl::updateContextState(ContextImpl& context, bo
         numberOfScaledParticles = context.getMolecules().size();
     else
         numberOfScaledParticles = context.getSystem().getNumParticles();
-    double finalEnergy = context.getOwner().getState(State::Energy, false, groups).getPotentialEnergy();
+    double finalEnergy = context.calcForcesAndEnergy(false, true, groups);
     double kT = BOLTZ*context.getParameter(MonteCarloFlexibleBarostat::Temperature());
     double w0 = finalEnergy-initialEnergy;
     double w1 = pressure*(newVolume-volume);
@@ -206,7 +206,7 @@ double MonteCarloFlexibleBarostatImpl::computePressureComponent(ContextImpl& con
     }
     newBox[scaleVec][scaleComponent] *= 1.0+delta;
     setBoxVectors(context, newBox[0], newBox[1], newBox[2]);
-    double energy1 = context.getOwner().getState(State::Energy, false, groups).getPotentialEnergy();
+    double energy1 = context.calcForcesAndEnergy(false, true, groups);
 
     // Compute the second energy.
 
@@ -216,7 +216,7 @@ double MonteCarloFlexibleBarostatImpl::computePressureComponent(ContextImpl& con
     }
     newBox[scaleVec][scaleComponent] = box[scaleVec][scaleComponent]*(1.0-delta);
     setBoxVectors(context, newBox[0], newBox[1], newBox[2]);
-    double energy2 = context.getOwner().getState(State::Energy, false, groups).getPotentialEnergy();
+    double energy2 = context.calcForcesAndEnergy(false, true, groups);
 
     // Reset the box shape.
 
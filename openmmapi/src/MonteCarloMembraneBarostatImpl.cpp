@@ -70,7 +70,7 @@ void MonteCarloMembraneBarostatImpl::updateContextState(ContextImpl& context, bo
     // Compute the current potential energy.
     
     int groups = context.getIntegrator().getIntegrationForceGroups();
-    double initialEnergy = context.getOwner().getState(State::Energy, false, groups).getPotentialEnergy();
+    double initialEnergy = context.calcForcesAndEnergy(false, true, groups);
     double pressure = context.getParameter(MonteCarloMembraneBarostat::Pressure())*(AVOGADRO*1e-25);
     double tension = context.getParameter(MonteCarloMembraneBarostat::SurfaceTension())*(AVOGADRO*1e-25);
     
@@ -116,7 +116,7 @@ void MonteCarloMembraneBarostatImpl::updateContextState(ContextImpl& context, bo
 
     // Compute the energy of the modified system.
 
-    double finalEnergy = context.getOwner().getState(State::Energy, false, groups).getPotentialEnergy();
+    double finalEnergy = context.calcForcesAndEnergy(false, true, groups);
     double kT = BOLTZ*context.getParameter(MonteCarloMembraneBarostat::Temperature());
     double w = finalEnergy-initialEnergy + pressure*deltaVolume - tension*deltaArea - context.getMolecules().size()*kT*log(newVolume/volume);
     if (w > 0 && SimTKOpenMMUtilities::getUniformlyDistributedRandomNumber() > exp(-w/kT)) {
@@ -179,7 +179,7 @@ Vec3 MonteCarloMembraneBarostatImpl::computeCurrentPressure(ContextImpl& context
         scale1[axis] = 1.0+delta;
         context.getOwner().setPeriodicBoxVectors(box[0]*scale1[0], box[1]*scale1[1], box[2]*scale1[2]);
         kernel.getAs<ApplyMonteCarloBarostatKernel>().scaleCoordinates(context, scale1[0], scale1[1], scale1[2]);
-        double energy1 = context.getOwner().getState(State::Energy, false, groups).getPotentialEnergy();
+        double energy1 = context.calcForcesAndEnergy(false, true, groups);
 
         // Compute the second energy.
 
@@ -187,7 +187,7 @@ Vec3 MonteCarloMembraneBarostatImpl::computeCurrentPressure(ContextImpl& context
         scale2[axis] = 1.0-delta;
         context.getOwner().setPeriodicBoxVectors(box[0]*scale2[0], box[1]*scale2[1], box[2]*scale2[2]);
         kernel.getAs<ApplyMonteCarloBarostatKernel>().scaleCoordinates(context, scale2[0]/scale1[0], scale2[1]/scale1[1], scale2[2]/scale1[2]);
-        double energy2 = context.getOwner().getState(State::Energy, false, groups).getPotentialEnergy();
+        double energy2 = context.calcForcesAndEnergy(false, true, groups);
 
         // Reset the box shape.
 
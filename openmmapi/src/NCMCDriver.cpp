@@ -0,0 +1,156 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/NCMCDriver.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/kernels.h"
+#include "openmm/internal/ContextImpl.h"
+#include "SimTKOpenMMRealType.h"
+#include "sfmt/SFMT.h"
+#include <cmath>
+
+using namespace OpenMM;
+using namespace std;
+
+NCMCDriver::NCMCDriver(Context& context, double temperature, int stepsPerPerturbation, int randomSeed) : context(context),
+            temperature(temperature), lastWork(0.0), stepsPerPerturbation(stepsPerPerturbation), forceGroups(0xFFFFFFFF),
+            numAttempted(0), numAccepted(0) {
+    if (temperature <= 0)
+        throw OpenMMException("NCMCDriver: The temperature must be positive");
+    if (stepsPerPerturbation < 0)
+        throw OpenMMException("NCMCDriver: The number of steps per perturbation cannot be negative");
+    ContextImpl& impl = context.getImpl();
+    kernel = impl.getPlatform().createKernel(CalcProtocolWorkKernel::Name(), impl);
+    kernel.getAs<CalcProtocolWorkKernel>().initialize(impl.getSystem());
+    random = new OpenMM_SFMT::SFMT();
+    init_gen_rand(randomSeed, *random);
+}
+
+NCMCDriver::~NCMCDriver() {
+    delete random;
+}
+
+int NCMCDriver::addParameter(const string& name, const vector<double>& schedule) {
+    context.getParameter(name); // Throws an exception if the parameter does not exist.
+    if (schedule.size() < 2)
+        throw OpenMMException("NCMCDriver: A schedule must contain at least two values");
+    if (schedules.size() > 0 && schedule.size() != schedules[0].size())
+        throw OpenMMException("NCMCDriver: All schedules must have the same length");
+    for (const string& existing : parameterNames)
+        if (existing == name)
+            throw OpenMMException("NCMCDriver: The parameter "+name+" has already been added");
+    parameterNames.push_back(name);
+    schedules.push_back(schedule);
+    return parameterNames.size()-1;
+}
+
+const string& NCMCDriver::getParameterName(int index) const {
+    if (index < 0 || index >= (int) parameterNames.size())
+        throw OpenMMException("NCMCDriver: Illegal parameter index");
+    return parameterNames[index];
+}
+
+const vector<double>& NCMCDriver::getParameterSchedule(int index) const {
+    if (index < 0 || index >= (int) schedules.size())
+        throw OpenMMException("NCMCDriver: Illegal parameter index");
+    return schedules[index];
+}
+
+int NCMCDriver::getNumPerturbations() const {
+    if (schedules.size() == 0)
+        return 0;
+    return schedules[0].size()-1;
+}
+
+void NCMCDriver::setTemperature(double temperature) {
+    if (temperature <= 0)
+        throw OpenMMException("NCMCDriver: The temperature must be positive");
+    this->temperature = temperature;
+}
+
+void NCMCDriver::setForceGroups(int groups) {
+    forceGroups = groups;
+}
+
+void NCMCDriver::setParameters(int index) {
+    for (int i = 0; i < (int) parameterNames.size(); i++)
+        context.setParameter(parameterNames[i], schedules[i][index]);
+}
+
+bool NCMCDriver::move() {
+    if (parameterNames.size() == 0)
+        throw OpenMMException("NCMCDriver: No parameters have been added");
+    ContextImpl& impl = context.getImpl();
+    CalcProtocolWorkKernel& workKernel = kernel.getAs<CalcProtocolWorkKernel>();
+    Integrator& integrator = context.getIntegrator();
+    Vec3 box[3];
+    impl.getPeriodicBoxVectors(box[0], box[1], box[2]);
+    setParameters(0);
+    workKernel.beginMove(impl);
+
+    // Each perturbation contributes U(lambda_i, x)-U(lambda_i-1, x) to the work.  If no steps are taken
+    // between perturbations the positions never change, so the sum telescopes and only the energies at
+    // the two ends of the schedule are needed.
+
+    int numPerturbations = getNumPerturbations();
+    if (stepsPerPerturbation == 0) {
+        workKernel.addEnergy(impl, -1.0, forceGroups);
+        setParameters(numPerturbations);
+        workKernel.addEnergy(impl, 1.0, forceGroups);
+    }
+    else {
+        for (int i = 1; i <= numPerturbations; i++) {
+            workKernel.addEnergy(impl, -1.0, forceGroups);
+            setParameters(i);
+            workKernel.addEnergy(impl, 1.0, forceGroups);
+            integrator.step(stepsPerPerturbation);
+        }
+    }
+    lastWork = workKernel.getWork(impl);
+
+    // Accept or reject the move.
+
+    numAttempted++;
+    bool accept = (lastWork <= 0 || genrand_real2(*random) < exp(-lastWork/(BOLTZ*temperature)));
+    if (accept) {
+        numAccepted++;
+        return true;
+    }
+    workKernel.restoreState(impl);
+    Vec3 newBox[3];
+    impl.getPeriodicBoxVectors(newBox[0], newBox[1], newBox[2]);
+    if (newBox[0] != box[0] || newBox[1] != box[1] || newBox[2] != box[2])
+        impl.setPeriodicBoxVectors(box[0], box[1], box[2]);
+    setParameters(0);
+    impl.notifyStateChanged(State::Positions);
+    impl.notifyStateChanged(State::Velocities);
+    return false;
+}
@@ -33,7 +33,9 @@
 #include "openmm/OpenMMException.h"
 #include "openmm/NonbondedForce.h"
 #include "openmm/internal/AssertionUtilities.h"
+#include "openmm/internal/ExclusionList.h"
 #include "openmm/internal/NonbondedForceImpl.h"
+#include <algorithm>
 #include <cmath>
 #include <map>
 #include <sstream>
@@ -138,6 +140,17 @@ int NonbondedForce::addParticle(double charge, double sigma, double epsilon) {
     return particles.size()-1;
 }
 
+int NonbondedForce::addParticles(const vector<double>& charge, const vector<double>& sigma, const vector<double>& epsilon) {
+    int numParticles = charge.size();
+    if (sigma.size() != numParticles || epsilon.size() != numParticles)
+        throw OpenMMException("NonbondedForce: All arrays passed to addParticles() must have the same length");
+    int first = particles.size();
+    particles.reserve(first+numParticles);
+    for (int i = 0; i < numParticles; i++)
+        particles.push_back(ParticleInfo(charge[i], sigma[i], epsilon[i]));
+    return first;
+}
+
 void NonbondedForce::getParticleParameters(int index, double& charge, double& sigma, double& epsilon) const {
     ASSERT_VALID_INDEX(index, particles);
     charge = particles[index].charge;
@@ -156,10 +169,9 @@ void NonbondedForce::setParticleParameters(int index, double charge, double sigm
     }}
 
 int NonbondedForce::addException(int particle1, int particle2, double chargeProd, double sigma, double epsilon, bool replace) {
-    map<pair<int, int>, int>::iterator iter = exceptionMap.find(pair<int, int>(particle1, particle2));
+    long long key = getExceptionKey(particle1, particle2);
+    auto iter = exceptionMap.find(key);
     int newIndex;
-    if (iter == exceptionMap.end())
-        iter = exceptionMap.find(pair<int, int>(particle2, particle1));
     if (iter != exceptionMap.end()) {
         if (!replace) {
             stringstream msg;
@@ -171,15 +183,54 @@ int NonbondedForce::addException(int particle1, int particle2, double chargeProd
         }
         exceptions[iter->second] = ExceptionInfo(particle1, particle2, chargeProd, sigma, epsilon);
         newIndex = iter->second;
-        exceptionMap.erase(iter->first);
     }
     else {
         exceptions.push_back(ExceptionInfo(particle1, particle2, chargeProd, sigma, epsilon));
         newIndex = exceptions.size()-1;
+        exceptionMap[key] = newIndex;
     }
-    exceptionMap[pair<int, int>(particle1, particle2)] = newIndex;
     return newIndex;
 }
+
+int NonbondedForce::addExceptions(const vector<int>& particle1, const vector<int>& particle2, const vector<double>& chargeProd,
+                                  const vector<double>& sigma, const vector<double>& epsilon, bool replace) {
+    int numExceptions = particle1.size();
+    if (particle2.size() != numExceptions || chargeProd.size() != numExceptions || sigma.size() != numExceptions || epsilon.size() != numExceptions)
+        throw OpenMMException("NonbondedForce: All arrays passed to addExceptions() must have the same length");
+    int firstNew = exceptions.size();
+    exceptions.reserve(firstNew+numExceptions);
+    exceptionMap.reserve(exceptionMap.size()+numExceptions);
+    for (int i = 0; i < numExceptions; i++) {
+        // A single emplace() both looks up the pair and records it if it is new.
+
+        auto result = exceptionMap.emplace(getExceptionKey(particle1[i], particle2[i]), (int) exceptions.size());
+        if (result.second)
+            exceptions.push_back(ExceptionInfo(particle1[i], particle2[i], chargeProd[i], sigma[i], epsilon[i]));
+        else if (replace)
+            exceptions[result.first->second] = ExceptionInfo(particle1[i], particle2[i], chargeProd[i], sigma[i], epsilon[i]);
+        else {
+            // Undo the additions made by this call so the Force is left unchanged.
+
+            for (int j = firstNew; j < exceptions.size(); j++)
+                exceptionMap.erase(getExceptionKey(exceptions[j].particle1, exceptions[j].particle2));
+            exceptions.resize(firstNew);
+            stringstream msg;
+            msg << "NonbondedForce: There is already an exception for particles ";
+            msg << particle1[i];
+            msg << " and ";
+            msg << particle2[i];
+            throw OpenMMException(msg.str());
+        }
+    }
+    return firstNew;
+}
+
+long long NonbondedForce::getExceptionKey(int particle1, int particle2) {
+    if (particle1 > particle2)
+        swap(particle1, particle2);
+    return (((long long) particle1)<<32) + particle2;
+}
+
 void NonbondedForce::getExceptionParameters(int index, int& particle1, int& particle2, double& chargeProd, double& sigma, double& epsilon) const {
     ASSERT_VALID_INDEX(index, exceptions);
     particle1 = exceptions[index].particle1;
@@ -220,48 +271,32 @@ void NonbondedForce::createExceptionsFromBonds(const vector<pair<int, int> >& bo
 
     // Find particles separated by 1, 2, or 3 bonds.
 
-    vector<set<int> > exclusions(particles.size());
-    vector<set<int> > bonded12(exclusions.size());
-    for (auto& bond : bonds) {
-        bonded12[bond.first].insert(bond.second);
-        bonded12[bond.second].insert(bond.first);
-    }
-    for (int i = 0; i < (int) exclusions.size(); ++i)
-        addExclusionsToSet(bonded12, exclusions[i], i, i, 2);
-
-    // Find particles separated by 1 or 2 bonds and create the exceptions.
-
-    for (int i = 0; i < (int) exclusions.size(); ++i) {
-        set<int> bonded13;
-        addExclusionsToSet(bonded12, bonded13, i, i, 1);
-        for (int j : exclusions[i]) {
-            if (j < i) {
-                if (bonded13.find(j) == bonded13.end()) {
-                    // This is a 1-4 interaction.
-
-                    const ParticleInfo& particle1 = particles[j];
-                    const ParticleInfo& particle2 = particles[i];
-                    const double chargeProd = coulomb14Scale*particle1.charge*particle2.charge;
-                    const double sigma = 0.5*(particle1.sigma+particle2.sigma);
-                    const double epsilon = lj14Scale*std::sqrt(particle1.epsilon*particle2.epsilon);
-                    addException(j, i, chargeProd, sigma, epsilon);
-                }
-                else {
-                    // This interaction should be completely excluded.
-
-                    addException(j, i, 0.0, 1.0, 0.0);
-                }
-            }
+    vector<pair<int, int> > bondedPairs;
+    vector<int> separation;
+    ExclusionList::findBondedPairs(particles.size(), bonds, 3, bondedPairs, separation);
+
+    // Create the exceptions.
+
+    exceptions.reserve(exceptions.size()+bondedPairs.size());
+    exceptionMap.reserve(exceptionMap.size()+bondedPairs.size());
+    for (int i = 0; i < (int) bondedPairs.size(); i++) {
+        int j = bondedPairs[i].first;
+        int k = bondedPairs[i].second;
+        if (separation[i] == 3) {
+            // This is a 1-4 interaction.
+
+            const ParticleInfo& particle1 = particles[j];
+            const ParticleInfo& particle2 = particles[k];
+            const double chargeProd = coulomb14Scale*particle1.charge*particle2.charge;
+            const double sigma = 0.5*(particle1.sigma+particle2.sigma);
+            const double epsilon = lj14Scale*std::sqrt(particle1.epsilon*particle2.epsilon);
+            addException(j, k, chargeProd, sigma, epsilon);
         }
-    }
-}
+        else {
+            // This interaction should be completely excluded.
 
-void NonbondedForce::addExclusionsToSet(const vector<set<int> >& bonded12, set<int>& exclusions, int baseParticle, int fromParticle, int currentLevel) const {
-    for (int i : bonded12[fromParticle]) {
-        if (i != baseParticle)
-            exclusions.insert(i);
-        if (currentLevel > 0)
-            addExclusionsToSet(bonded12, exclusions, baseParticle, i, currentLevel-1);
+            addException(j, k, 0.0, 1.0, 0.0);
+        }
     }
 }
 
@@ -343,6 +378,92 @@ void NonbondedForce::setExceptionParameterOffset(int index, const std::string& p
     exceptionOffsets[index].epsilonScale = epsilonScale;
 }
 
+int NonbondedForce::addTitrationSite(const string& parameter, const vector<int>& particles) {
+    titrationSites.push_back(TitrationSiteInfo(parameter, particles));
+    return titrationSites.size()-1;
+}
+
+void NonbondedForce::getTitrationSiteParameters(int index, string& parameter, vector<int>& particles) const {
+    ASSERT_VALID_INDEX(index, titrationSites);
+    parameter = titrationSites[index].parameter;
+    particles = titrationSites[index].particles;
+}
+
+int NonbondedForce::getNumTitrationStates(int index) const {
+    ASSERT_VALID_INDEX(index, titrationSites);
+    return titrationSites[index].charges.size()+1;
+}
+
+int NonbondedForce::addTitrationState(int index, const vector<double>& charges, const vector<double>& sigmas, const vector<double>& epsilons) {
+    ASSERT_VALID_INDEX(index, titrationSites);
+    TitrationSiteInfo& site = titrationSites[index];
+    if (charges.size() != site.particles.size() || sigmas.size() != site.particles.size() || epsilons.size() != site.particles.size())
+        throw OpenMMException("NonbondedForce: The number of parameters for a titration state does not match the number of particles in the site");
+    site.charges.push_back(charges);
+    site.sigmas.push_back(sigmas);
+    site.epsilons.push_back(epsilons);
+    site.exceptions.push_back(vector<int>());
+    site.exceptionChargeProds.push_back(vector<double>());
+    site.exceptionSigmas.push_back(vector<double>());
+    site.exceptionEpsilons.push_back(vector<double>());
+    return site.charges.size();
+}
+
+void NonbondedForce::getTitrationStateParameters(int index, int state, vector<double>& charges, vector<double>& sigmas, vector<double>& epsilons) const {
+    ASSERT_VALID_INDEX(index, titrationSites);
+    const TitrationSiteInfo& site = titrationSites[index];
+    if (state < 1 || state > site.charges.size())
+        throw OpenMMException("NonbondedForce: Illegal index for a titration state");
+    charges = site.charges[state-1];
+    sigmas = site.sigmas[state-1];
+    epsilons = site.epsilons[state-1];
+}
+
+void NonbondedForce::setTitrationStateExceptionParameters(int index, int state, int exceptionIndex, double chargeProd, double sigma, double epsilon) {
+    ASSERT_VALID_INDEX(index, titrationSites);
+    ASSERT_VALID_INDEX(exceptionIndex, exceptions);
+    TitrationSiteInfo& site = titrationSites[index];
+    if (state < 1 || state > site.charges.size())
+        throw OpenMMException("NonbondedForce: Illegal index for a titration state");
+    vector<int>& stateExceptions = site.exceptions[state-1];
+    int i = find(stateExceptions.begin(), stateExceptions.end(), exceptionIndex)-stateExceptions.begin();
+    if (i == stateExceptions.size()) {
+        stateExceptions.push_back(exceptionIndex);
+        site.exceptionChargeProds[state-1].push_back(chargeProd);
+        site.exceptionSigmas[state-1].push_back(sigma);
+        site.exceptionEpsilons[state-1].push_back(epsilon);
+    }
+    else {
+        site.exceptionChargeProds[state-1][i] = chargeProd;
+        site.exceptionSigmas[state-1][i] = sigma;
+        site.exceptionEpsilons[state-1][i] = epsilon;
+    }
+}
+
+int NonbondedForce::getNumTitrationStateExceptions(int index, int state) const {
+    ASSERT_VALID_INDEX(index, titrationSites);
+    const TitrationSiteInfo& site = titrationSites[index];
+    if (state < 1 || state > site.charges.size())
+        throw OpenMMException("NonbondedForce: Illegal index for a titration state");
+    return site.exceptions[state-1].size();
+}
+
+void NonbondedForce::getTitrationStateExceptionParameters(int index, int state, int stateExceptionIndex, int& exceptionIndex, double& chargeProd, double& sigma, double& epsilon) const {
+    ASSERT_VALID_INDEX(index, titrationSites);
+    const TitrationSiteInfo& site = titrationSites[index];
+    if (state < 1 || state > site.charges.size())
+        throw OpenMMException("NonbondedForce: Illegal index for a titration state");
+    ASSERT_VALID_INDEX(stateExceptionIndex, site.exceptions[state-1]);
+    exceptionIndex = site.exceptions[state-1][stateExceptionIndex];
+    chargeProd = site.exceptionChargeProds[state-1][stateExceptionIndex];
+    sigma = site.exceptionSigmas[state-1][stateExceptionIndex];
+    epsilon = site.exceptionEpsilons[state-1][stateExceptionIndex];
+}
+
+double NonbondedForce::computeTitrationEnergyChange(Context& context, int index, int state) const {
+    return dynamic_cast<const NonbondedForceImpl&>(getImplInContext(context)).computeTitrationEnergyChange(getContextImpl(context), index, state);
+}
+
 int NonbondedForce::getReciprocalSpaceForceGroup() const {
     return recipForceGroup;
 }
@@ -361,6 +482,22 @@ void NonbondedForce::setIncludeDirectSpace(bool include) {
     includeDirectSpace = include;
 }
 
+double NonbondedForce::computeInteractionEnergy(Context& context, const vector<int>& set1, const vector<int>& set2) const {
+    return dynamic_cast<const NonbondedForceImpl&>(getImplInContext(context)).computeInteractionEnergy(getContextImpl(context), set1, set2);
+}
+
+double NonbondedForce::computeEnergyChange(Context& context, const vector<int>& particles, const vector<Vec3>& newPositions) const {
+    return dynamic_cast<const NonbondedForceImpl&>(getImplInContext(context)).computeEnergyChange(getContextImpl(context), particles, newPositions);
+}
+
+double NonbondedForce::computeParticleEnergy(Context& context, const vector<int>& particles) const {
+    return dynamic_cast<const NonbondedForceImpl&>(getImplInContext(context)).computeParticleEnergy(getContextImpl(context), particles);
+}
+
+void NonbondedForce::computeStateEnergies(Context& context, const vector<string>& parameters, const vector<vector<double> >& values, vector<double>& energies) const {
+    dynamic_cast<const NonbondedForceImpl&>(getImplInContext(context)).computeStateEnergies(getContextImpl(context), parameters, values, energies);
+}
+
 void NonbondedForce::updateParametersInContext(Context& context) {
     dynamic_cast<NonbondedForceImpl&>(getImplInContext(context)).updateParametersInContext(getContextImpl(context),
             firstChangedParticle, lastChangedParticle, firstChangedException, lastChangedException);
@@ -381,3 +518,19 @@ bool NonbondedForce::getExceptionsUsePeriodicBoundaryConditions() const {
 void NonbondedForce::setExceptionsUsePeriodicBoundaryConditions(bool periodic) {
     exceptionsUsePeriodic = periodic;
 }
+
+const vector<int>& NonbondedForce::getSoluteParticles() const {
+    return soluteParticles;
+}
+
+void NonbondedForce::setSoluteParticles(const vector<int>& particles) {
+    soluteParticles = particles;
+}
+
+const string& NonbondedForce::getSoluteScaleParameter() const {
+    return soluteScaleParameter;
+}
+
+void NonbondedForce::setSoluteScaleParameter(const string& parameter) {
+    soluteScaleParameter = parameter;
+}
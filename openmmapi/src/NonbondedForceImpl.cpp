@@ -34,18 +34,21 @@
 #endif
 #include "openmm/OpenMMException.h"
 #include "openmm/internal/ContextImpl.h"
+#include "openmm/internal/ExclusionList.h"
 #include "openmm/internal/Messages.h"
 #include "openmm/internal/NonbondedForceImpl.h"
 #include "openmm/kernels.h"
+#include "ReferenceNeighborList.h"
 #include <cmath>
 #include <map>
 #include <sstream>
 #include <algorithm>
+#include <complex>
 
 using namespace OpenMM;
 using namespace std;
 
-NonbondedForceImpl::NonbondedForceImpl(const NonbondedForce& owner) : owner(owner) {
+NonbondedForceImpl::NonbondedForceImpl(const NonbondedForce& owner) : owner(owner), soluteScale(1.0), cachedUpdateCount(0) {
     forceGroup = owner.getForceGroup();
     recipForceGroup = owner.getReciprocalSpaceForceGroup();
     if (recipForceGroup < 0)
@@ -138,7 +141,59 @@ void NonbondedForceImpl::initialize(ContextImpl& context) {
         if (owner.getNonbondedMethod() == NonbondedForce::Ewald && (boxVectors[1][0] != 0.0 || boxVectors[2][0] != 0.0 || boxVectors[2][1] != 0))
             throw OpenMMException("NonbondedForce: Ewald is not supported with non-rectangular boxes.  Use PME instead.");
     }
-    kernel.getAs<CalcNonbondedForceKernel>().initialize(context.getSystem(), owner);
+    isSolute.resize(owner.getNumParticles(), false);
+    for (int particle : owner.getSoluteParticles()) {
+        if (particle < 0 || particle >= owner.getNumParticles()) {
+            stringstream msg;
+            msg << "NonbondedForce: Illegal particle index for a solute particle: ";
+            msg << particle;
+            throw OpenMMException(msg.str());
+        }
+        isSolute[particle] = true;
+    }
+    vector<bool> inSite(owner.getNumParticles(), false);
+    set<string> siteParameters;
+    for (int i = 0; i < owner.getNumTitrationSites(); i++) {
+        string parameter;
+        vector<int> particles;
+        owner.getTitrationSiteParameters(i, parameter, particles);
+        if (siteParameters.find(parameter) != siteParameters.end())
+            throw OpenMMException("NonbondedForce: Multiple titration sites use the parameter "+parameter);
+        siteParameters.insert(parameter);
+        for (int j = 0; j < owner.getNumGlobalParameters(); j++)
+            if (owner.getGlobalParameterName(j) == parameter)
+                throw OpenMMException("NonbondedForce: The parameter of a titration site cannot also be a global parameter: "+parameter);
+        for (int particle : particles) {
+            if (particle < 0 || particle >= owner.getNumParticles()) {
+                stringstream msg;
+                msg << "NonbondedForce: Illegal particle index for a titration site: ";
+                msg << particle;
+                throw OpenMMException(msg.str());
+            }
+            if (inSite[particle]) {
+                stringstream msg;
+                msg << "NonbondedForce: Particle ";
+                msg << particle;
+                msg << " belongs to more than one titration site";
+                throw OpenMMException(msg.str());
+            }
+            inSite[particle] = true;
+        }
+        for (int state = 1; state < owner.getNumTitrationStates(i); state++)
+            for (int j = 0; j < owner.getNumTitrationStateExceptions(i, state); j++) {
+                int exception, p1, p2;
+                double chargeProd, sigma, epsilon;
+                owner.getTitrationStateExceptionParameters(i, state, j, exception, chargeProd, sigma, epsilon);
+                owner.getExceptionParameters(exception, p1, p2, chargeProd, sigma, epsilon);
+                if (find(particles.begin(), particles.end(), p1) == particles.end() && find(particles.begin(), particles.end(), p2) == particles.end())
+                    throw OpenMMException("NonbondedForce: An exception with parameters for a titration state does not involve any particle of the site");
+            }
+        siteIndex[parameter] = i;
+    }
+    if (owner.getNumTitrationSites() > 0)
+        createTitrationForce();
+    findSoluteParameters();
+    kernel.getAs<CalcNonbondedForceKernel>().initialize(context.getSystem(), getForce());
 }
 
 double NonbondedForceImpl::calcForcesAndEnergy(ContextImpl& context, bool includeForces, bool includeEnergy, int groups) {
@@ -149,11 +204,153 @@ double NonbondedForceImpl::calcForcesAndEnergy(ContextImpl& context, bool includ
 
 map<string, double> NonbondedForceImpl::getDefaultParameters() {
     map<string, double> parameters;
-    for (int i = 0; i < owner.getNumGlobalParameters(); i++)
-        parameters[owner.getGlobalParameterName(i)] = owner.getGlobalParameterDefaultValue(i);
+    const NonbondedForce& force = getForce();
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        parameters[force.getGlobalParameterName(i)] = force.getGlobalParameterDefaultValue(i);
+    if (owner.getSoluteScaleParameter() != "")
+        parameters[owner.getSoluteScaleParameter()] = 1.0;
+    for (auto& site : siteIndex)
+        parameters[site.first] = 0.0;
     return parameters;
 }
 
+void NonbondedForceImpl::contextParameterChanged(ContextImpl& context, const string& name, double value) {
+    auto site = siteIndex.find(name);
+    if (site != siteIndex.end()) {
+        // Select the new state by setting the parameters that control the offsets for each state.
+
+        int state = (int) value;
+        int numStates = owner.getNumTitrationStates(site->second);
+        if (state != value || state < 0 || state >= numStates)
+            throw OpenMMException("NonbondedForce: Illegal state for titration site "+name);
+        for (int i = 1; i < numStates; i++) {
+            string stateParameter = getTitrationStateParameter(name, i);
+            double selected = (i == state ? 1.0 : 0.0);
+            if (context.getParameter(stateParameter) != selected)
+                context.setParameter(stateParameter, selected);
+        }
+        return;
+    }
+    if (name != owner.getSoluteScaleParameter() || value == soluteScale)
+        return;
+    if (value <= 0.0)
+        throw OpenMMException("NonbondedForce: The solute scale parameter must be positive");
+    soluteScale = value;
+
+    // Only the particles and exceptions involving the solute need to be updated.
+
+    int firstParticle = 0, lastParticle = -1, firstException = 0, lastException = -1;
+    if (soluteParticles.size() > 0) {
+        firstParticle = soluteParticles.front();
+        lastParticle = soluteParticles.back();
+    }
+    if (soluteExceptions.size() > 0) {
+        firstException = soluteExceptions.front();
+        lastException = soluteExceptions.back();
+    }
+    copyScaledParametersToContext(context, firstParticle, lastParticle, firstException, lastException);
+    context.systemChanged();
+}
+
+string NonbondedForceImpl::getTitrationStateParameter(const string& siteParameter, int state) {
+    stringstream name;
+    name << siteParameter << "_state" << state;
+    return name.str();
+}
+
+void NonbondedForceImpl::createTitrationForce() {
+    // Each state other than state 0 is represented by offsets from the standard parameters, multiplied by
+    // a global parameter that is 1 when the site is in that state and 0 otherwise.
+
+    titrationForce.reset(new NonbondedForce(owner));
+    vector<int> siteOfParticle(owner.getNumParticles(), -1), indexInSite(owner.getNumParticles());
+    vector<vector<int> > siteExceptions(owner.getNumTitrationSites());
+    for (int i = 0; i < owner.getNumTitrationSites(); i++) {
+        string parameter;
+        vector<int> particles;
+        owner.getTitrationSiteParameters(i, parameter, particles);
+        for (int j = 0; j < particles.size(); j++) {
+            siteOfParticle[particles[j]] = i;
+            indexInSite[particles[j]] = j;
+        }
+    }
+    for (int i = 0; i < owner.getNumExceptions(); i++) {
+        int p1, p2;
+        double chargeProd, sigma, epsilon;
+        owner.getExceptionParameters(i, p1, p2, chargeProd, sigma, epsilon);
+        if (chargeProd == 0.0 && epsilon == 0.0)
+            continue;
+        if (siteOfParticle[p1] != -1)
+            siteExceptions[siteOfParticle[p1]].push_back(i);
+        if (siteOfParticle[p2] != -1 && siteOfParticle[p2] != siteOfParticle[p1])
+            siteExceptions[siteOfParticle[p2]].push_back(i);
+    }
+    for (int i = 0; i < owner.getNumTitrationSites(); i++) {
+        string parameter;
+        vector<int> particles;
+        owner.getTitrationSiteParameters(i, parameter, particles);
+        for (int state = 1; state < owner.getNumTitrationStates(i); state++) {
+            string stateParameter = getTitrationStateParameter(parameter, state);
+            titrationForce->addGlobalParameter(stateParameter, 0.0);
+            vector<double> charges, sigmas, epsilons;
+            owner.getTitrationStateParameters(i, state, charges, sigmas, epsilons);
+            for (int j = 0; j < particles.size(); j++) {
+                double charge, sigma, epsilon;
+                owner.getParticleParameters(particles[j], charge, sigma, epsilon);
+                titrationForce->addParticleParameterOffset(stateParameter, particles[j], charges[j]-charge, sigmas[j]-sigma, epsilons[j]-epsilon);
+            }
+            // Exceptions with explicit parameters for this state are offset to those parameters.  All others
+            // are scaled based on the particle parameters.
+
+            set<int> explicitExceptions;
+            for (int j = 0; j < owner.getNumTitrationStateExceptions(i, state); j++) {
+                int exception, p1, p2;
+                double chargeProd, sigma, epsilon, stateChargeProd, stateSigma, stateEpsilon;
+                owner.getTitrationStateExceptionParameters(i, state, j, exception, stateChargeProd, stateSigma, stateEpsilon);
+                owner.getExceptionParameters(exception, p1, p2, chargeProd, sigma, epsilon);
+                titrationForce->addExceptionParameterOffset(stateParameter, exception, stateChargeProd-chargeProd, stateSigma-sigma, stateEpsilon-epsilon);
+                explicitExceptions.insert(exception);
+            }
+            for (int exception : siteExceptions[i]) {
+                if (explicitExceptions.find(exception) != explicitExceptions.end())
+                    continue;
+                int p[2];
+                double chargeProd, sigma, epsilon;
+                owner.getExceptionParameters(exception, p[0], p[1], chargeProd, sigma, epsilon);
+                double q[2], qState[2], eps[2], epsState[2];
+                for (int j = 0; j < 2; j++) {
+                    double sig;
+                    owner.getParticleParameters(p[j], q[j], sig, eps[j]);
+                    qState[j] = (siteOfParticle[p[j]] == i ? charges[indexInSite[p[j]]] : q[j]);
+                    epsState[j] = (siteOfParticle[p[j]] == i ? epsilons[indexInSite[p[j]]] : eps[j]);
+                }
+                double chargeProdOffset = (q[0]*q[1] == 0.0 ? 0.0 : chargeProd*(qState[0]*qState[1]/(q[0]*q[1])-1));
+                double epsilonOffset = (eps[0]*eps[1] == 0.0 ? 0.0 : epsilon*(sqrt(epsState[0]*epsState[1]/(eps[0]*eps[1]))-1));
+                titrationForce->addExceptionParameterOffset(stateParameter, exception, chargeProdOffset, 0.0, epsilonOffset);
+            }
+        }
+    }
+}
+
+double NonbondedForceImpl::computeTitrationEnergyChange(ContextImpl& context, int site, int state) const {
+    if (site < 0 || site >= owner.getNumTitrationSites())
+        throw OpenMMException("NonbondedForce: Illegal index for a titration site");
+    if (state < 0 || state >= owner.getNumTitrationStates(site))
+        throw OpenMMException("NonbondedForce: Illegal index for a titration state");
+    string parameter;
+    vector<int> particles;
+    owner.getTitrationSiteParameters(site, parameter, particles);
+    double currentState = context.getParameter(parameter);
+    if (state == currentState)
+        return 0.0;
+    int groups = getForceGroups();
+    double energy1 = context.calcForcesAndEnergy(false, true, groups);
+    context.setParameter(parameter, state);
+    double energy2 = context.calcForcesAndEnergy(false, true, groups);
+    context.setParameter(parameter, currentState);
+    return energy2-energy1;
+}
+
 std::vector<std::string> NonbondedForceImpl::getKernelNames() {
     std::vector<std::string> names;
     names.push_back(CalcNonbondedForceKernel::Name());
@@ -346,10 +543,106 @@ double NonbondedForceImpl::calcDispersionCorrection(const System& system, const
 }
 
 void NonbondedForceImpl::updateParametersInContext(ContextImpl& context, int firstParticle, int lastParticle, int firstException, int lastException) {
-    kernel.getAs<CalcNonbondedForceKernel>().copyParametersToContext(context, owner, firstParticle, lastParticle, firstException, lastException);
+    if (titrationForce)
+        createTitrationForce();
+    findSoluteParameters();
+    copyScaledParametersToContext(context, firstParticle, lastParticle, firstException, lastException);
     context.systemChanged();
 }
 
+void NonbondedForceImpl::findSoluteParameters() {
+    const NonbondedForce& force = getForce();
+    soluteParticles.clear();
+    soluteExceptions.clear();
+    soluteParticleOffsets.clear();
+    soluteExceptionOffsets.clear();
+    scaledForce.reset();
+    for (int i = 0; i < isSolute.size(); i++)
+        if (isSolute[i])
+            soluteParticles.push_back(i);
+    if (soluteParticles.size() == 0)
+        return;
+    for (int i = 0; i < force.getNumExceptions(); i++) {
+        int p1, p2;
+        double chargeProd, sigma, epsilon;
+        force.getExceptionParameters(i, p1, p2, chargeProd, sigma, epsilon);
+        if (isSolute[p1] || isSolute[p2])
+            soluteExceptions.push_back(i);
+    }
+    for (int i = 0; i < force.getNumParticleParameterOffsets(); i++) {
+        string param;
+        int particle;
+        double chargeOffset, sigmaOffset, epsilonOffset;
+        force.getParticleParameterOffset(i, param, particle, chargeOffset, sigmaOffset, epsilonOffset);
+        if (isSolute[particle])
+            soluteParticleOffsets.push_back(i);
+    }
+    for (int i = 0; i < force.getNumExceptionParameterOffsets(); i++) {
+        string param;
+        int exception, p1, p2;
+        double chargeProdOffset, sigmaOffset, epsilonOffset, chargeProd, sigma, epsilon;
+        force.getExceptionParameterOffset(i, param, exception, chargeProdOffset, sigmaOffset, epsilonOffset);
+        force.getExceptionParameters(exception, p1, p2, chargeProd, sigma, epsilon);
+        if (isSolute[p1] || isSolute[p2])
+            soluteExceptionOffsets.push_back(i);
+    }
+}
+
+void NonbondedForceImpl::copyScaledParametersToContext(ContextImpl& context, int firstParticle, int lastParticle, int firstException, int lastException) {
+    const NonbondedForce& force = getForce();
+    if (soluteScale == 1.0) {
+        kernel.getAs<CalcNonbondedForceKernel>().copyParametersToContext(context, force, firstParticle, lastParticle, firstException, lastException);
+        return;
+    }
+
+    // Keep a copy of the force in which the parameters involving the solute have been scaled.  It is
+    // created once, and afterward only the solute parameters need to be updated when the scale changes.
+
+    if (!scaledForce)
+        scaledForce.reset(new NonbondedForce(force));
+    double chargeScale = sqrt(soluteScale);
+    for (int i : soluteParticles) {
+        double charge, sigma, epsilon;
+        force.getParticleParameters(i, charge, sigma, epsilon);
+        scaledForce->setParticleParameters(i, charge*chargeScale, sigma, epsilon*soluteScale);
+    }
+    for (int i : soluteExceptions) {
+        double scale = getExceptionSoluteScale(i, soluteScale);
+        int p1, p2;
+        double chargeProd, sigma, epsilon;
+        force.getExceptionParameters(i, p1, p2, chargeProd, sigma, epsilon);
+        scaledForce->setExceptionParameters(i, p1, p2, chargeProd*scale, sigma, epsilon*scale);
+    }
+    for (int i : soluteParticleOffsets) {
+        string param;
+        int particle;
+        double chargeOffset, sigmaOffset, epsilonOffset;
+        force.getParticleParameterOffset(i, param, particle, chargeOffset, sigmaOffset, epsilonOffset);
+        scaledForce->setParticleParameterOffset(i, param, particle, chargeOffset*chargeScale, sigmaOffset, epsilonOffset*soluteScale);
+    }
+    for (int i : soluteExceptionOffsets) {
+        string param;
+        int exception;
+        double chargeProdOffset, sigmaOffset, epsilonOffset;
+        force.getExceptionParameterOffset(i, param, exception, chargeProdOffset, sigmaOffset, epsilonOffset);
+        double scale = getExceptionSoluteScale(exception, soluteScale);
+        scaledForce->setExceptionParameterOffset(i, param, exception, chargeProdOffset*scale, sigmaOffset, epsilonOffset*scale);
+    }
+    kernel.getAs<CalcNonbondedForceKernel>().copyParametersToContext(context, *scaledForce, firstParticle, lastParticle, firstException, lastException);
+}
+
+double NonbondedForceImpl::getExceptionSoluteScale(int exception, double scale) const {
+    int p1, p2;
+    double chargeProd, sigma, epsilon;
+    owner.getExceptionParameters(exception, p1, p2, chargeProd, sigma, epsilon);
+    int numSolute = (isSolute[p1] ? 1 : 0) + (isSolute[p2] ? 1 : 0);
+    if (numSolute == 2)
+        return scale;
+    if (numSolute == 1)
+        return sqrt(scale);
+    return 1.0;
+}
+
 void NonbondedForceImpl::getPMEParameters(double& alpha, int& nx, int& ny, int& nz) const {
     kernel.getAs<CalcNonbondedForceKernel>().getPMEParameters(alpha, nx, ny, nz);
 }
@@ -357,3 +650,637 @@ void NonbondedForceImpl::getPMEParameters(double& alpha, int& nx, int& ny, int&
 void NonbondedForceImpl::getLJPMEParameters(double& alpha, int& nx, int& ny, int& nz) const {
     kernel.getAs<CalcNonbondedForceKernel>().getLJPMEParameters(alpha, nx, ny, nz);
 }
+
+static const double ONE_4PI_EPS0 = 138.935456;
+
+map<string, double> NonbondedForceImpl::getGlobalParameterValues(ContextImpl& context) const {
+    map<string, double> values;
+    const NonbondedForce& force = getForce();
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        values[force.getGlobalParameterName(i)] = context.getParameter(force.getGlobalParameterName(i));
+    if (owner.getSoluteScaleParameter() != "")
+        values[owner.getSoluteScaleParameter()] = context.getParameter(owner.getSoluteScaleParameter());
+    return values;
+}
+
+void NonbondedForceImpl::getEffectiveParameters(const map<string, double>& globalValues, vector<double>& charge, vector<double>& sigma, vector<double>& epsilon, vector<vector<double> >& exceptionParams) const {
+    const NonbondedForce& force = getForce();
+    int numParticles = owner.getNumParticles();
+    charge.resize(numParticles);
+    sigma.resize(numParticles);
+    epsilon.resize(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        owner.getParticleParameters(i, charge[i], sigma[i], epsilon[i]);
+    for (int i = 0; i < force.getNumParticleParameterOffsets(); i++) {
+        string param;
+        int particle;
+        double chargeScale, sigmaScale, epsilonScale;
+        force.getParticleParameterOffset(i, param, particle, chargeScale, sigmaScale, epsilonScale);
+        double value = globalValues.at(param);
+        charge[particle] += value*chargeScale;
+        sigma[particle] += value*sigmaScale;
+        epsilon[particle] += value*epsilonScale;
+    }
+    exceptionParams.resize(owner.getNumExceptions(), vector<double>(3));
+    for (int i = 0; i < owner.getNumExceptions(); i++) {
+        int p1, p2;
+        owner.getExceptionParameters(i, p1, p2, exceptionParams[i][0], exceptionParams[i][1], exceptionParams[i][2]);
+    }
+    for (int i = 0; i < force.getNumExceptionParameterOffsets(); i++) {
+        string param;
+        int exception;
+        double chargeProdScale, sigmaScale, epsilonScale;
+        force.getExceptionParameterOffset(i, param, exception, chargeProdScale, sigmaScale, epsilonScale);
+        double value = globalValues.at(param);
+        exceptionParams[exception][0] += value*chargeProdScale;
+        exceptionParams[exception][1] += value*sigmaScale;
+        exceptionParams[exception][2] += value*epsilonScale;
+    }
+    if (owner.getSoluteScaleParameter() != "") {
+        double scale = globalValues.at(owner.getSoluteScaleParameter());
+        for (int i = 0; i < numParticles; i++)
+            if (isSolute[i]) {
+                charge[i] *= sqrt(scale);
+                epsilon[i] *= scale;
+            }
+        for (int i = 0; i < owner.getNumExceptions(); i++) {
+            double exceptionScale = getExceptionSoluteScale(i, scale);
+            exceptionParams[i][0] *= exceptionScale;
+            exceptionParams[i][2] *= exceptionScale;
+        }
+    }
+}
+
+static Vec3 computeDelta(const Vec3& pos1, const Vec3& pos2, const Vec3* boxVectors, bool periodic) {
+    Vec3 delta = pos2-pos1;
+    if (periodic) {
+        delta -= boxVectors[2]*floor(delta[2]/boxVectors[2][2]+0.5);
+        delta -= boxVectors[1]*floor(delta[1]/boxVectors[1][1]+0.5);
+        delta -= boxVectors[0]*floor(delta[0]/boxVectors[0][0]+0.5);
+    }
+    return delta;
+}
+
+static double computeLJ(double r, double sigma, double epsilon) {
+    double sig2 = sigma*sigma/(r*r);
+    double sig6 = sig2*sig2*sig2;
+    return 4.0*epsilon*(sig6-1.0)*sig6;
+}
+
+double NonbondedForceImpl::computePairEnergy(double r, double chargeProd, double sigma, double epsilon, double alpha) const {
+    NonbondedForce::NonbondedMethod method = owner.getNonbondedMethod();
+    double cutoff = owner.getCutoffDistance();
+    if (method != NonbondedForce::NoCutoff && r >= cutoff)
+        return 0.0;
+    chargeProd *= ONE_4PI_EPS0;
+    double energy;
+    if (method == NonbondedForce::NoCutoff)
+        energy = chargeProd/r;
+    else if (alpha > 0.0)
+        energy = chargeProd*erfc(alpha*r)/r;
+    else {
+        double dielectric = owner.getReactionFieldDielectric();
+        double krf = (1.0/(cutoff*cutoff*cutoff))*(dielectric-1.0)/(2.0*dielectric+1.0);
+        double crf = (1.0/cutoff)*(3.0*dielectric)/(2.0*dielectric+1.0);
+        energy = chargeProd*(1.0/r + krf*r*r - crf);
+    }
+    double lj = computeLJ(r, sigma, epsilon);
+    double switchingDistance = owner.getSwitchingDistance();
+    if (method != NonbondedForce::NoCutoff && owner.getUseSwitchingFunction() && r > switchingDistance) {
+        double t = (r-switchingDistance)/(cutoff-switchingDistance);
+        lj *= 1.0+t*t*t*(-10.0+t*(15.0-t*6.0));
+    }
+    return energy+lj;
+}
+
+double NonbondedForceImpl::computePairEnergy(int p1, int p2, const vector<Vec3>& positions, const Vec3* boxVectors, const vector<double>& charge,
+            const vector<double>& sigma, const vector<double>& epsilon, double alpha) const {
+    Vec3 delta = computeDelta(positions[p1], positions[p2], boxVectors, owner.usesPeriodicBoundaryConditions());
+    double r = sqrt(delta.dot(delta));
+    return computePairEnergy(r, charge[p1]*charge[p2], 0.5*(sigma[p1]+sigma[p2]), sqrt(epsilon[p1]*epsilon[p2]), alpha);
+}
+
+double NonbondedForceImpl::computeExceptionEnergy(double r, const vector<double>& params, double chargeProd, double alpha) const {
+    double energy = 0.0;
+    if (params[0] != 0.0 || params[2] != 0.0)
+        energy += ONE_4PI_EPS0*params[0]/r + computeLJ(r, params[1], params[2]);
+    if (alpha > 0.0) {
+        // Remove the interaction that is implicitly included in the reciprocal space sum.
+
+        double alphaR = alpha*r;
+        if (erf(alphaR) > 1e-6)
+            energy -= ONE_4PI_EPS0*chargeProd*erf(alphaR)/r;
+        else
+            energy -= ONE_4PI_EPS0*chargeProd*alpha*2.0/sqrt(M_PI);
+    }
+    return energy;
+}
+
+double NonbondedForceImpl::computeExceptionEnergy(int p1, int p2, const vector<double>& params, const vector<Vec3>& positions, const Vec3* boxVectors,
+            const vector<double>& charge, double alpha) const {
+    bool periodic = owner.usesPeriodicBoundaryConditions() && owner.getExceptionsUsePeriodicBoundaryConditions();
+    Vec3 delta = computeDelta(positions[p1], positions[p2], boxVectors, periodic);
+    double r = sqrt(delta.dot(delta));
+    return computeExceptionEnergy(r, params, charge[p1]*charge[p2], alpha);
+}
+
+double NonbondedForceImpl::computeInteractionEnergy(ContextImpl& context, const vector<int>& set1, const vector<int>& set2) const {
+    // Record which set each particle belongs to.
+
+    int numParticles = owner.getNumParticles();
+    vector<int> setIndex(numParticles, 0);
+    for (int i : set1) {
+        if (i < 0 || i >= numParticles)
+            throw OpenMMException("computeInteractionEnergy: Illegal particle index");
+        setIndex[i] = 1;
+    }
+    for (int i : set2) {
+        if (i < 0 || i >= numParticles)
+            throw OpenMMException("computeInteractionEnergy: Illegal particle index");
+        if (setIndex[i] == 1)
+            throw OpenMMException("computeInteractionEnergy: The two sets of particles may not overlap");
+        setIndex[i] = 2;
+    }
+    vector<double> charge, sigma, epsilon;
+    vector<vector<double> > exceptionParams;
+    getEffectiveParameters(getGlobalParameterValues(context), charge, sigma, epsilon, exceptionParams);
+
+    // Find the exceptions that connect the two sets.  Any pair with an exception is excluded from the
+    // normal interaction.
+
+    map<pair<int, int>, int> exceptionIndex;
+    for (int i = 0; i < owner.getNumExceptions(); i++) {
+        int p1, p2;
+        double chargeProd, sig, eps;
+        owner.getExceptionParameters(i, p1, p2, chargeProd, sig, eps);
+        if (setIndex[p1] != 0 && setIndex[p2] != 0 && setIndex[p1] != setIndex[p2])
+            exceptionIndex[make_pair(min(p1, p2), max(p1, p2))] = i;
+    }
+
+    // Loop over pairs.  Reciprocal space is never used, so pass alpha=0 to get the reaction field
+    // approximation for all cutoff methods.
+
+    vector<Vec3> positions;
+    context.getPositions(positions);
+    Vec3 boxVectors[3];
+    context.getPeriodicBoxVectors(boxVectors[0], boxVectors[1], boxVectors[2]);
+    double energy = 0.0;
+    for (int i : set1)
+        for (int j : set2) {
+            auto exception = exceptionIndex.find(make_pair(min(i, j), max(i, j)));
+            if (exception != exceptionIndex.end())
+                energy += computeExceptionEnergy(i, j, exceptionParams[exception->second], positions, boxVectors, charge, 0.0);
+            else
+                energy += computePairEnergy(i, j, positions, boxVectors, charge, sigma, epsilon, 0.0);
+        }
+    return energy;
+}
+
+void NonbondedForceImpl::getEwaldParameters(ContextImpl& context, double& alpha, int kmax[3]) const {
+    NonbondedForce::NonbondedMethod method = owner.getNonbondedMethod();
+    if (method == NonbondedForce::LJPME)
+        throw OpenMMException("NonbondedForce: Computing local energy changes is not supported for LJPME");
+    if (!includeDirectSpace)
+        throw OpenMMException("NonbondedForce: Computing local energy changes is not supported when direct space is excluded");
+    alpha = 0.0;
+    if (method == NonbondedForce::Ewald)
+        calcEwaldParameters(context.getSystem(), owner, alpha, kmax[0], kmax[1], kmax[2]);
+    else if (method == NonbondedForce::PME) {
+        // Reciprocal space is evaluated with a direct Ewald sum, using enough wave vectors that the
+        // error is below the Ewald error tolerance.
+
+        int nx, ny, nz;
+        getPMEParameters(alpha, nx, ny, nz);
+        Vec3 boxVectors[3];
+        context.getPeriodicBoxVectors(boxVectors[0], boxVectors[1], boxVectors[2]);
+        double scale = alpha*sqrt(-log(owner.getEwaldErrorTolerance()))/M_PI;
+        for (int i = 0; i < 3; i++)
+            kmax[i] = 2+(int) ceil(scale*boxVectors[i][i]);
+    }
+}
+
+/**
+ * Compute the vectors whose dot products with the box vectors form the identity matrix.
+ */
+static void computeReciprocalBoxVectors(const Vec3* boxVectors, Vec3* recipBoxVectors) {
+    double volume = boxVectors[0][0]*boxVectors[1][1]*boxVectors[2][2];
+    recipBoxVectors[0] = boxVectors[1].cross(boxVectors[2])/volume;
+    recipBoxVectors[1] = boxVectors[2].cross(boxVectors[0])/volume;
+    recipBoxVectors[2] = boxVectors[0].cross(boxVectors[1])/volume;
+}
+
+/**
+ * Get the number of wave vectors in half of reciprocal space, excluding k=0.
+ */
+static int getNumWaveVectors(const int kmax[3]) {
+    return ((2*kmax[0]-1)*(2*kmax[1]-1)*(2*kmax[2]-1)-1)/2;
+}
+
+void NonbondedForceImpl::computeStructureFactors(const vector<Vec3>& positions, const vector<double>& charge, const vector<int>& particles,
+            const Vec3* boxVectors, const int kmax[3], vector<complex<double> >& structureFactors) const {
+    // Wave vectors are enumerated over half of reciprocal space, skipping k=0, in the same order
+    // as in computeReciprocalEnergy().
+
+    Vec3 recipBoxVectors[3];
+    computeReciprocalBoxVectors(boxVectors, recipBoxVectors);
+    vector<vector<complex<double> > > eir(3);
+    for (int i = 0; i < 3; i++)
+        eir[i].resize(kmax[i]);
+    for (int particle : particles) {
+        if (charge[particle] == 0.0)
+            continue;
+        for (int i = 0; i < 3; i++) {
+            double phase = 2*M_PI*positions[particle].dot(recipBoxVectors[i]);
+            eir[i][0] = complex<double>(1, 0);
+            if (kmax[i] > 1)
+                eir[i][1] = complex<double>(cos(phase), sin(phase));
+            for (int j = 2; j < kmax[i]; j++)
+                eir[i][j] = eir[i][j-1]*eir[i][1];
+        }
+        int index = 0;
+        for (int rx = 0; rx < kmax[0]; rx++)
+            for (int ry = (rx == 0 ? 0 : 1-kmax[1]); ry < kmax[1]; ry++) {
+                complex<double> xy = charge[particle]*eir[0][rx]*(ry >= 0 ? eir[1][ry] : conj(eir[1][-ry]));
+                for (int rz = (rx == 0 && ry == 0 ? 1 : 1-kmax[2]); rz < kmax[2]; rz++)
+                    structureFactors[index++] += xy*(rz >= 0 ? eir[2][rz] : conj(eir[2][-rz]));
+            }
+    }
+}
+
+const vector<complex<double> >& NonbondedForceImpl::getStructureFactors(const vector<Vec3>& positions, const vector<double>& charge,
+            const Vec3* boxVectors, const int kmax[3]) const {
+    // Rebuild the cache from scratch if the wave vectors have changed, if many particles have changed,
+    // or after many incremental updates to limit the accumulation of roundoff error.
+
+    int numParticles = positions.size();
+    bool rebuild = (cachedPositions.size() != positions.size() || cachedUpdateCount >= 1000);
+    for (int i = 0; i < 3 && !rebuild; i++)
+        rebuild = (kmax[i] != cachedKmax[i] || boxVectors[i] != cachedBoxVectors[i]);
+    vector<int> changed;
+    if (!rebuild) {
+        for (int i = 0; i < numParticles; i++)
+            if (positions[i] != cachedPositions[i] || charge[i] != cachedCharges[i])
+                changed.push_back(i);
+        rebuild = (4*changed.size() > positions.size());
+    }
+    if (rebuild) {
+        vector<int> allParticles(numParticles);
+        for (int i = 0; i < numParticles; i++)
+            allParticles[i] = i;
+        cachedStructureFactors.assign(getNumWaveVectors(kmax), complex<double>(0, 0));
+        computeStructureFactors(positions, charge, allParticles, boxVectors, kmax, cachedStructureFactors);
+        for (int i = 0; i < 3; i++) {
+            cachedKmax[i] = kmax[i];
+            cachedBoxVectors[i] = boxVectors[i];
+        }
+        cachedUpdateCount = 0;
+    }
+    else if (changed.size() > 0) {
+        // Remove the old contributions of the changed particles and add their new ones.
+
+        int numWaveVectors = cachedStructureFactors.size();
+        vector<complex<double> > oldContribution(numWaveVectors), newContribution(numWaveVectors);
+        computeStructureFactors(cachedPositions, cachedCharges, changed, boxVectors, kmax, oldContribution);
+        computeStructureFactors(positions, charge, changed, boxVectors, kmax, newContribution);
+        for (int i = 0; i < numWaveVectors; i++)
+            cachedStructureFactors[i] += newContribution[i]-oldContribution[i];
+        cachedUpdateCount++;
+    }
+    cachedPositions = positions;
+    cachedCharges = charge;
+    return cachedStructureFactors;
+}
+
+double NonbondedForceImpl::computeReciprocalEnergy(const vector<complex<double> >& structureFactors, double totalCharge, const Vec3* boxVectors, double alpha, const int kmax[3]) const {
+    Vec3 recipBoxVectors[3];
+    computeReciprocalBoxVectors(boxVectors, recipBoxVectors);
+    double volume = boxVectors[0][0]*boxVectors[1][1]*boxVectors[2][2];
+    double recipCoeff = ONE_4PI_EPS0*4*M_PI/volume;
+    double factor = -1/(4*alpha*alpha);
+    double energy = 0.0;
+    int index = 0;
+    for (int rx = 0; rx < kmax[0]; rx++)
+        for (int ry = (rx == 0 ? 0 : 1-kmax[1]); ry < kmax[1]; ry++)
+            for (int rz = (rx == 0 && ry == 0 ? 1 : 1-kmax[2]); rz < kmax[2]; rz++) {
+                Vec3 k = (recipBoxVectors[0]*rx + recipBoxVectors[1]*ry + recipBoxVectors[2]*rz)*(2*M_PI);
+                double k2 = k.dot(k);
+                energy += recipCoeff*exp(k2*factor)/k2*norm(structureFactors[index++]);
+            }
+
+    // Correction for the neutralizing plasma.
+
+    energy -= ONE_4PI_EPS0*M_PI*totalCharge*totalCharge/(2*volume*alpha*alpha);
+    return energy;
+}
+
+double NonbondedForceImpl::computeLocalEnergy(const vector<Vec3>& positions, const Vec3* boxVectors, const vector<int>& particles, const vector<bool>& inSubset,
+            const vector<double>& charge, const vector<double>& sigma, const vector<double>& epsilon, const vector<vector<double> >& exceptionParams,
+            const vector<vector<pair<int, int> > >& particleExceptions, double alpha) const {
+    // Sum every direct space term that involves at least one particle in the subset.  The loop over
+    // partners scales with the number of particles, not the number of pairs.
+
+    int numParticles = positions.size();
+    double energy = 0.0;
+    vector<int> isException(numParticles, -1);
+    for (int i : particles) {
+        for (auto& e : particleExceptions[i])
+            isException[e.first] = i;
+        for (int j = 0; j < numParticles; j++) {
+            if (j == i || (inSubset[j] && j < i) || isException[j] == i)
+                continue;
+            energy += computePairEnergy(i, j, positions, boxVectors, charge, sigma, epsilon, alpha);
+        }
+        for (auto& e : particleExceptions[i])
+            if (!inSubset[e.first] || e.first > i)
+                energy += computeExceptionEnergy(i, e.first, exceptionParams[e.second], positions, boxVectors, charge, alpha);
+        if (alpha > 0.0)
+            energy -= ONE_4PI_EPS0*charge[i]*charge[i]*alpha/sqrt(M_PI);
+    }
+    return energy;
+}
+
+void NonbondedForceImpl::prepareLocalEnergy(ContextImpl& context, const vector<int>& particles, vector<bool>& inSubset, vector<double>& charge, vector<double>& sigma,
+            vector<double>& epsilon, vector<vector<double> >& exceptionParams, vector<vector<pair<int, int> > >& particleExceptions) const {
+    int numParticles = owner.getNumParticles();
+    inSubset.resize(numParticles, false);
+    for (int i : particles) {
+        if (i < 0 || i >= numParticles || inSubset[i]) {
+            stringstream msg;
+            msg << "NonbondedForce: Illegal or repeated particle index: ";
+            msg << i;
+            throw OpenMMException(msg.str());
+        }
+        inSubset[i] = true;
+    }
+    getEffectiveParameters(getGlobalParameterValues(context), charge, sigma, epsilon, exceptionParams);
+    particleExceptions.resize(numParticles);
+    for (int i = 0; i < owner.getNumExceptions(); i++) {
+        int p1, p2;
+        double chargeProd, sig, eps;
+        owner.getExceptionParameters(i, p1, p2, chargeProd, sig, eps);
+        if (inSubset[p1])
+            particleExceptions[p1].push_back(make_pair(p2, i));
+        if (inSubset[p2])
+            particleExceptions[p2].push_back(make_pair(p1, i));
+    }
+}
+
+double NonbondedForceImpl::computeEnergyChange(ContextImpl& context, const vector<int>& particles, const vector<Vec3>& newPositions) const {
+    if (newPositions.size() != particles.size())
+        throw OpenMMException("NonbondedForce: The number of positions does not match the number of particles");
+    double alpha;
+    int kmax[3];
+    getEwaldParameters(context, alpha, kmax);
+    vector<bool> inSubset;
+    vector<double> charge, sigma, epsilon;
+    vector<vector<double> > exceptionParams;
+    vector<vector<pair<int, int> > > particleExceptions;
+    prepareLocalEnergy(context, particles, inSubset, charge, sigma, epsilon, exceptionParams, particleExceptions);
+    vector<Vec3> oldPositions;
+    context.getPositions(oldPositions);
+    vector<Vec3> positions = oldPositions;
+    for (int i = 0; i < particles.size(); i++)
+        positions[particles[i]] = newPositions[i];
+    Vec3 boxVectors[3];
+    context.getPeriodicBoxVectors(boxVectors[0], boxVectors[1], boxVectors[2]);
+    double delta = computeLocalEnergy(positions, boxVectors, particles, inSubset, charge, sigma, epsilon, exceptionParams, particleExceptions, alpha) -
+                   computeLocalEnergy(oldPositions, boxVectors, particles, inSubset, charge, sigma, epsilon, exceptionParams, particleExceptions, alpha);
+    if (alpha > 0.0) {
+        // Update the structure factors by removing the moved particles at their old positions and adding
+        // them back at their new ones.
+
+        int numWaveVectors = getNumWaveVectors(kmax);
+        vector<complex<double> > structureFactors = getStructureFactors(oldPositions, charge, boxVectors, kmax);
+        vector<complex<double> > oldContribution(numWaveVectors), newContribution(numWaveVectors);
+        computeStructureFactors(oldPositions, charge, particles, boxVectors, kmax, oldContribution);
+        computeStructureFactors(positions, charge, particles, boxVectors, kmax, newContribution);
+        double totalCharge = 0.0;
+        for (double q : charge)
+            totalCharge += q;
+        double oldEnergy = computeReciprocalEnergy(structureFactors, totalCharge, boxVectors, alpha, kmax);
+        for (int i = 0; i < numWaveVectors; i++)
+            structureFactors[i] += newContribution[i]-oldContribution[i];
+        delta += computeReciprocalEnergy(structureFactors, totalCharge, boxVectors, alpha, kmax)-oldEnergy;
+    }
+    return delta;
+}
+
+double NonbondedForceImpl::computeParticleEnergy(ContextImpl& context, const vector<int>& particles) const {
+    double alpha;
+    int kmax[3];
+    getEwaldParameters(context, alpha, kmax);
+    vector<bool> inSubset;
+    vector<double> charge, sigma, epsilon;
+    vector<vector<double> > exceptionParams;
+    vector<vector<pair<int, int> > > particleExceptions;
+    prepareLocalEnergy(context, particles, inSubset, charge, sigma, epsilon, exceptionParams, particleExceptions);
+    vector<Vec3> positions;
+    context.getPositions(positions);
+    Vec3 boxVectors[3];
+    context.getPeriodicBoxVectors(boxVectors[0], boxVectors[1], boxVectors[2]);
+    double energy = computeLocalEnergy(positions, boxVectors, particles, inSubset, charge, sigma, epsilon, exceptionParams, particleExceptions, alpha);
+    if (alpha > 0.0) {
+        // Compare the reciprocal space energy with and without the particles.
+
+        int numWaveVectors = getNumWaveVectors(kmax);
+        vector<complex<double> > structureFactors = getStructureFactors(positions, charge, boxVectors, kmax);
+        vector<complex<double> > contribution(numWaveVectors);
+        computeStructureFactors(positions, charge, particles, boxVectors, kmax, contribution);
+        double totalCharge = 0.0, subsetCharge = 0.0;
+        for (double q : charge)
+            totalCharge += q;
+        for (int i : particles)
+            subsetCharge += charge[i];
+        energy += computeReciprocalEnergy(structureFactors, totalCharge, boxVectors, alpha, kmax);
+        for (int i = 0; i < numWaveVectors; i++)
+            structureFactors[i] -= contribution[i];
+        energy -= computeReciprocalEnergy(structureFactors, totalCharge-subsetCharge, boxVectors, alpha, kmax);
+    }
+    return energy;
+}
+
+void NonbondedForceImpl::computeStateEnergies(ContextImpl& context, const vector<string>& parameters, const vector<vector<double> >& values, vector<double>& energies) const {
+    double alpha;
+    int kmax[3];
+    getEwaldParameters(context, alpha, kmax);
+    map<string, double> contextValues = getGlobalParameterValues(context);
+    for (const string& param : parameters)
+        if (contextValues.find(param) == contextValues.end())
+            throw OpenMMException("NonbondedForce: Unknown global parameter: "+param);
+    const NonbondedForce& force = getForce();
+    int numStates = values.size();
+    int numParticles = owner.getNumParticles();
+    int numExceptions = owner.getNumExceptions();
+
+    // Compute the parameters for every state.
+
+    vector<vector<double> > charge(numStates), sigma(numStates), epsilon(numStates);
+    vector<vector<vector<double> > > exceptionParams(numStates);
+    for (int state = 0; state < numStates; state++) {
+        if (values[state].size() != parameters.size())
+            throw OpenMMException("NonbondedForce: The number of values for a state does not match the number of parameters");
+        map<string, double> stateValues = contextValues;
+        for (int i = 0; i < parameters.size(); i++)
+            stateValues[parameters[i]] = values[state][i];
+        getEffectiveParameters(stateValues, charge[state], sigma[state], epsilon[state], exceptionParams[state]);
+    }
+
+    // Identify the particles and exceptions whose parameters can differ between states.  Interactions
+    // that involve none of them have the same energy in every state, so they are only computed once.
+
+    vector<bool> particleVaries(numParticles, false), exceptionVaries(numExceptions, false);
+    for (int i = 0; i < force.getNumParticleParameterOffsets(); i++) {
+        string param;
+        int particle;
+        double chargeScale, sigmaScale, epsilonScale;
+        force.getParticleParameterOffset(i, param, particle, chargeScale, sigmaScale, epsilonScale);
+        particleVaries[particle] = true;
+    }
+    for (int i = 0; i < force.getNumExceptionParameterOffsets(); i++) {
+        string param;
+        int exception;
+        double chargeProdScale, sigmaScale, epsilonScale;
+        force.getExceptionParameterOffset(i, param, exception, chargeProdScale, sigmaScale, epsilonScale);
+        exceptionVaries[exception] = true;
+    }
+    if (find(parameters.begin(), parameters.end(), owner.getSoluteScaleParameter()) != parameters.end()) {
+        for (int i = 0; i < numParticles; i++)
+            if (isSolute[i])
+                particleVaries[i] = true;
+        for (int i = 0; i < numExceptions; i++) {
+            int p1, p2;
+            double chargeProd, sig, eps;
+            owner.getExceptionParameters(i, p1, p2, chargeProd, sig, eps);
+            if (isSolute[p1] || isSolute[p2])
+                exceptionVaries[i] = true;
+        }
+    }
+    energies.resize(numStates);
+    if (numStates == 0)
+        return;
+    double commonEnergy = 0.0;
+    vector<Vec3> positions;
+    context.getPositions(positions);
+    Vec3 boxVectors[3];
+    context.getPeriodicBoxVectors(boxVectors[0], boxVectors[1], boxVectors[2]);
+    for (int state = 0; state < numStates; state++)
+        energies[state] = 0.0;
+
+    // Compute the direct space interactions.  The distance to each neighbor is computed only once.
+
+    vector<pair<int, int> > excludedPairs;
+    for (int i = 0; i < numExceptions; i++) {
+        int p1, p2;
+        double chargeProd, sig, eps;
+        owner.getExceptionParameters(i, p1, p2, chargeProd, sig, eps);
+        excludedPairs.push_back(make_pair(p1, p2));
+    }
+    ExclusionList exclusions(numParticles, excludedPairs);
+    bool periodic = owner.usesPeriodicBoundaryConditions();
+    NeighborList neighbors;
+    if (owner.getNonbondedMethod() == NonbondedForce::NoCutoff) {
+        for (int i = 0; i < numParticles; i++)
+            for (int j = i+1; j < numParticles; j++)
+                if (!exclusions.isExcluded(i, j))
+                    neighbors.push_back(AtomPair(i, j));
+    }
+    else
+        computeNeighborListVoxelHash(neighbors, numParticles, positions, exclusions, boxVectors, periodic, owner.getCutoffDistance(), 0.0);
+    for (auto& pair : neighbors) {
+        int p1 = pair.first, p2 = pair.second;
+        Vec3 delta = computeDelta(positions[p1], positions[p2], boxVectors, periodic);
+        double r = sqrt(delta.dot(delta));
+        int numToCompute = (particleVaries[p1] || particleVaries[p2] ? numStates : 1);
+        for (int state = 0; state < numToCompute; state++) {
+            double energy = computePairEnergy(r, charge[state][p1]*charge[state][p2], 0.5*(sigma[state][p1]+sigma[state][p2]),
+                    sqrt(epsilon[state][p1]*epsilon[state][p2]), alpha);
+            if (numToCompute == 1)
+                commonEnergy += energy;
+            else
+                energies[state] += energy;
+        }
+    }
+    bool periodicExceptions = periodic && owner.getExceptionsUsePeriodicBoundaryConditions();
+    for (int i = 0; i < numExceptions; i++) {
+        int p1 = excludedPairs[i].first, p2 = excludedPairs[i].second;
+        Vec3 delta = computeDelta(positions[p1], positions[p2], boxVectors, periodicExceptions);
+        double r = sqrt(delta.dot(delta));
+        int numToCompute = (exceptionVaries[i] || (alpha > 0.0 && (particleVaries[p1] || particleVaries[p2])) ? numStates : 1);
+        for (int state = 0; state < numToCompute; state++) {
+            double energy = computeExceptionEnergy(r, exceptionParams[state][i], charge[state][p1]*charge[state][p2], alpha);
+            if (numToCompute == 1)
+                commonEnergy += energy;
+            else
+                energies[state] += energy;
+        }
+    }
+    if (alpha > 0.0) {
+        // The reciprocal space structure factors depend linearly on the charges, so compute one set for the
+        // base charges and one for the offsets of each global parameter.  The structure factors for any state
+        // are then a linear combination of them.  When solute scaling is used, the solute and the rest of the
+        // System are handled as separate groups, since the solute charges are also multiplied by sqrt(lambda).
+
+        int numWaveVectors = getNumWaveVectors(kmax);
+        bool scaleSolute = (owner.getSoluteScaleParameter() != "");
+        int numGroups = (scaleSolute ? 2 : 1);
+        vector<vector<complex<double> > > baseStructureFactors(numGroups, vector<complex<double> >(numWaveVectors));
+        vector<map<string, vector<complex<double> > > > offsetStructureFactors(numGroups);
+        for (int group = 0; group < numGroups; group++) {
+            vector<int> groupParticles;
+            vector<double> baseCharge(numParticles, 0.0);
+            for (int i = 0; i < numParticles; i++)
+                if (!scaleSolute || isSolute[i] == (group == 1)) {
+                    double sig, eps;
+                    owner.getParticleParameters(i, baseCharge[i], sig, eps);
+                    groupParticles.push_back(i);
+                }
+            computeStructureFactors(positions, baseCharge, groupParticles, boxVectors, kmax, baseStructureFactors[group]);
+            map<string, vector<double> > offsetCharge;
+            map<string, vector<int> > offsetParticles;
+            for (int i = 0; i < force.getNumParticleParameterOffsets(); i++) {
+                string param;
+                int particle;
+                double chargeScale, sigmaScale, epsilonScale;
+                force.getParticleParameterOffset(i, param, particle, chargeScale, sigmaScale, epsilonScale);
+                if (chargeScale == 0.0 || (scaleSolute && isSolute[particle] != (group == 1)))
+                    continue;
+                if (offsetCharge.find(param) == offsetCharge.end())
+                    offsetCharge[param].resize(numParticles, 0.0);
+                if (offsetCharge[param][particle] == 0.0)
+                    offsetParticles[param].push_back(particle);
+                offsetCharge[param][particle] += chargeScale;
+            }
+            for (auto& param : offsetCharge) {
+                offsetStructureFactors[group][param.first].resize(numWaveVectors);
+                computeStructureFactors(positions, param.second, offsetParticles[param.first], boxVectors, kmax, offsetStructureFactors[group][param.first]);
+            }
+        }
+        vector<complex<double> > structureFactors(numWaveVectors);
+        for (int state = 0; state < numStates; state++) {
+            map<string, double> stateValues = contextValues;
+            for (int i = 0; i < parameters.size(); i++)
+                stateValues[parameters[i]] = values[state][i];
+            structureFactors.assign(numWaveVectors, 0.0);
+            for (int group = 0; group < numGroups; group++) {
+                double groupScale = (group == 1 ? sqrt(stateValues[owner.getSoluteScaleParameter()]) : 1.0);
+                for (int i = 0; i < numWaveVectors; i++)
+                    structureFactors[i] += groupScale*baseStructureFactors[group][i];
+                for (auto& param : offsetStructureFactors[group]) {
+                    double value = groupScale*stateValues[param.first];
+                    for (int i = 0; i < numWaveVectors; i++)
+                        structureFactors[i] += value*param.second[i];
+                }
+            }
+            double totalCharge = 0.0, selfEnergy = 0.0;
+            for (double q : charge[state]) {
+                totalCharge += q;
+                selfEnergy -= ONE_4PI_EPS0*q*q*alpha/sqrt(M_PI);
+            }
+            energies[state] += selfEnergy + computeReciprocalEnergy(structureFactors, totalCharge, boxVectors, alpha, kmax);
+        }
+    }
+    if (owner.getUseDispersionCorrection() && periodic)
+        commonEnergy += calcDispersionCorrection(context.getSystem(), owner)/(boxVectors[0][0]*boxVectors[1][1]*boxVectors[2][2]);
+    for (int state = 0; state < numStates; state++)
+        energies[state] += commonEnergy;
+}
@@ -0,0 +1,174 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/ObservableRecorder.h"
+#include "openmm/CMMotionRemover.h"
+#include "openmm/Integrator.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/State.h"
+#include "openmm/System.h"
+#include "SimTKOpenMMRealType.h"
+#include <algorithm>
+#include <map>
+
+using namespace OpenMM;
+using namespace std;
+
+ObservableRecorder::ObservableRecorder(Context& context, int interval, int capacity) : context(context), interval(interval),
+        capacity(capacity), numSamples(0), firstSample(0), numDiscarded(0) {
+    if (interval <= 0)
+        throw OpenMMException("ObservableRecorder: The interval must be positive");
+    if (capacity <= 0)
+        throw OpenMMException("ObservableRecorder: The capacity must be positive");
+
+    // Compute the number of degrees of freedom, the same way StateDataReporter does.
+
+    const System& system = context.getSystem();
+    dof = 0;
+    for (int i = 0; i < system.getNumParticles(); i++)
+        if (system.getParticleMass(i) > 0)
+            dof += 3;
+    for (int i = 0; i < system.getNumConstraints(); i++) {
+        int p1, p2;
+        double distance;
+        system.getConstraintParameters(i, p1, p2, distance);
+        if (system.getParticleMass(p1) > 0 || system.getParticleMass(p2) > 0)
+            dof -= 1;
+    }
+    for (int i = 0; i < system.getNumForces(); i++)
+        if (dynamic_cast<const CMMotionRemover*>(&system.getForce(i)) != NULL) {
+            dof -= 3;
+            break;
+        }
+}
+
+int ObservableRecorder::addObservable(ObservableType type, int groups) {
+    if (numSamples > 0)
+        throw OpenMMException("ObservableRecorder: Observables cannot be added while samples are stored.  Call drain() first.");
+    ObservableInfo info;
+    info.type = type;
+    info.groups = groups;
+    observables.push_back(info);
+    buffer.clear();
+    return observables.size()-1;
+}
+
+int ObservableRecorder::addPotentialEnergy(int groups) {
+    return addObservable(PotentialEnergy, groups);
+}
+
+int ObservableRecorder::addKineticEnergy() {
+    return addObservable(KineticEnergy, 0);
+}
+
+int ObservableRecorder::addTemperature() {
+    if (dof <= 0)
+        throw OpenMMException("ObservableRecorder: The System has no degrees of freedom, so the temperature is undefined");
+    return addObservable(Temperature, 0);
+}
+
+int ObservableRecorder::addVolume() {
+    if (!context.getSystem().usesPeriodicBoundaryConditions())
+        throw OpenMMException("ObservableRecorder: The volume can only be recorded for a periodic System");
+    return addObservable(Volume, 0);
+}
+
+void ObservableRecorder::step(int steps) {
+    Integrator& integrator = context.getIntegrator();
+    while (steps > 0) {
+        int stepsToSample = interval-(int) (context.getStepCount()%interval);
+        int stepsToTake = min(steps, stepsToSample);
+        integrator.step(stepsToTake);
+        steps -= stepsToTake;
+        if (context.getStepCount()%interval == 0)
+            recordSample();
+    }
+}
+
+void ObservableRecorder::recordSample() {
+    // Each distinct set of force groups needs one energy evaluation.  If no potential energies
+    // are requested, no groups are evaluated and only the kinetic energy is computed.
+
+    map<int, double> potentialEnergy;
+    for (const ObservableInfo& info : observables)
+        if (info.type == PotentialEnergy)
+            potentialEnergy[info.groups] = 0.0;
+    State state;
+    if (potentialEnergy.size() == 0)
+        state = context.getState(State::Energy | State::GroupEnergies, false, 0);
+    bool first = true;
+    for (auto& energy : potentialEnergy) {
+        State groupState = context.getState(State::Energy, false, energy.first);
+        energy.second = groupState.getPotentialEnergy();
+        if (first)
+            state = groupState;
+        first = false;
+    }
+
+    // Store the sample in the ring buffer, discarding the oldest one if it is full.
+
+    int width = observables.size()+1;
+    if (buffer.size() == 0)
+        buffer.resize(capacity*width);
+    int index;
+    if (numSamples == capacity) {
+        index = firstSample;
+        firstSample = (firstSample+1)%capacity;
+        numDiscarded++;
+    }
+    else
+        index = (firstSample+numSamples++)%capacity;
+    double* sample = &buffer[index*width];
+    sample[0] = state.getTime();
+    for (int i = 0; i < observables.size(); i++) {
+        const ObservableInfo& info = observables[i];
+        if (info.type == PotentialEnergy)
+            sample[i+1] = potentialEnergy[info.groups];
+        else if (info.type == KineticEnergy)
+            sample[i+1] = state.getKineticEnergy();
+        else if (info.type == Temperature)
+            sample[i+1] = 2*state.getKineticEnergy()/(dof*BOLTZ);
+        else
+            sample[i+1] = state.getPeriodicBoxVolume();
+    }
+}
+
+vector<vector<double> > ObservableRecorder::drain() {
+    int width = observables.size()+1;
+    vector<vector<double> > samples(numSamples);
+    for (int i = 0; i < numSamples; i++) {
+        const double* sample = &buffer[((firstSample+i)%capacity)*width];
+        samples[i].assign(sample, sample+width);
+    }
+    numSamples = 0;
+    firstSample = 0;
+    return samples;
+}
@@ -0,0 +1,91 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/OffloadForce.h"
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/internal/OffloadForceImpl.h"
+
+using namespace OpenMM;
+using namespace std;
+
+OffloadForce::OffloadForce(const string& platformName) : platformName(platformName) {
+}
+
+OffloadForce::~OffloadForce() {
+    for (Force* force : forces)
+        delete force;
+}
+
+const string& OffloadForce::getPlatformName() const {
+    return platformName;
+}
+
+void OffloadForce::setPlatformName(const string& name) {
+    platformName = name;
+}
+
+void OffloadForce::setPlatformProperty(const string& name, const string& value) {
+    platformProperties[name] = value;
+}
+
+const map<string, string>& OffloadForce::getPlatformProperties() const {
+    return platformProperties;
+}
+
+int OffloadForce::addForce(Force* force) {
+    forces.push_back(force);
+    return forces.size()-1;
+}
+
+Force& OffloadForce::getForce(int index) {
+    ASSERT_VALID_INDEX(index, forces);
+    return *forces[index];
+}
+
+const Force& OffloadForce::getForce(int index) const {
+    ASSERT_VALID_INDEX(index, forces);
+    return *forces[index];
+}
+
+ForceImpl* OffloadForce::createImpl() const {
+    return new OffloadForceImpl(*this);
+}
+
+Context& OffloadForce::getInnerContext(Context& context) {
+    return dynamic_cast<OffloadForceImpl&>(getImplInContext(context)).getInnerContext();
+}
+
+bool OffloadForce::usesPeriodicBoundaryConditions() const {
+    for (Force* force : forces)
+        if (force->usesPeriodicBoundaryConditions())
+            return true;
+    return false;
+}
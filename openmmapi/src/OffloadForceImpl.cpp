@@ -0,0 +1,113 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/NonbondedForce.h"
+#include "openmm/Platform.h"
+#include "openmm/State.h"
+#include "openmm/internal/ContextImpl.h"
+#include "openmm/internal/OffloadForceImpl.h"
+#include "openmm/serialization/XmlSerializer.h"
+
+using namespace OpenMM;
+using namespace std;
+
+OffloadForceImpl::OffloadForceImpl(const OffloadForce& owner) : CustomCPPForceImpl(owner), owner(owner), innerIntegrator(1.0),
+        innerContext(NULL) {
+}
+
+OffloadForceImpl::~OffloadForceImpl() {
+    if (innerContext != NULL)
+        delete innerContext;
+}
+
+void OffloadForceImpl::initialize(ContextImpl& context) {
+    CustomCPPForceImpl::initialize(context);
+
+    // Construct the inner system containing the offloaded forces.
+
+    const System& system = context.getSystem();
+    Vec3 a, b, c;
+    system.getDefaultPeriodicBoxVectors(a, b, c);
+    innerSystem.setDefaultPeriodicBoxVectors(a, b, c);
+    for (int i = 0; i < system.getNumParticles(); i++)
+        innerSystem.addParticle(system.getParticleMass(i));
+    for (int i = 0; i < owner.getNumForces(); i++) {
+        Force* force = XmlSerializer::clone<Force>(owner.getForce(i));
+        force->setForceGroup(0);
+        NonbondedForce* nonbonded = dynamic_cast<NonbondedForce*>(force);
+        if (nonbonded != NULL)
+            nonbonded->setReciprocalSpaceForceGroup(-1);
+        innerSystem.addForce(force);
+    }
+
+    // Create the inner context on the requested platform.
+
+    Platform& platform = Platform::getPlatformByName(owner.getPlatformName());
+    innerContext = new Context(innerSystem, innerIntegrator, platform, owner.getPlatformProperties());
+}
+
+double OffloadForceImpl::computeForce(ContextImpl& context, const vector<Vec3>& positions, vector<Vec3>& forces) {
+    // Copy the current state to the inner context.
+
+    Vec3 a, b, c;
+    context.getPeriodicBoxVectors(a, b, c);
+    innerContext->setPeriodicBoxVectors(a, b, c);
+    innerContext->setPositions(positions);
+    for (auto& param : innerContext->getParameters()) {
+        double value = context.getParameter(param.first);
+        if (value != param.second)
+            innerContext->setParameter(param.first, value);
+    }
+
+    // Compute the forces.
+
+    State state = innerContext->getState(State::Forces | State::Energy);
+    forces = state.getForces();
+    return state.getPotentialEnergy();
+}
+
+map<string, double> OffloadForceImpl::getDefaultParameters() {
+    return innerContext->getParameters();
+}
+
+vector<pair<int, int> > OffloadForceImpl::getBondedParticles() const {
+    vector<pair<int, int> > bonds;
+    const ContextImpl& innerContextImpl = getContextImpl(*innerContext);
+    for (auto& impl : innerContextImpl.getForceImpls()) {
+        for (auto& bond : impl->getBondedParticles())
+            bonds.push_back(bond);
+    }
+    return bonds;
+}
+
+Context& OffloadForceImpl::getInnerContext() {
+    return *innerContext;
+}
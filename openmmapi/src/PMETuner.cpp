@@ -0,0 +1,294 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.            *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/PMETuner.h"
+#include "openmm/Context.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/Platform.h"
+#include "openmm/State.h"
+#include "openmm/VerletIntegrator.h"
+#include "openmm/internal/NonbondedForceImpl.h"
+#include "openmm/internal/timer.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <set>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * Create a Context with the specified properties and measure how long it takes to execute a
+ * series of time steps.  On exit, gridSize contains the PME grid dimensions the Platform
+ * actually used.  If Context creation fails, this returns a negative time.
+ */
+static double timeSteps(const System& system, NonbondedForce& force, const vector<Vec3>& positions, Platform& platform,
+        const map<string, string>& properties, int numSteps, vector<int>& gridSize, map<string, string>& actualProperties) {
+    // Use a tiny step size so the particles barely move.  The starting positions usually
+    // are not minimized, and we only care about the cost of each step, not the trajectory.
+
+    VerletIntegrator integrator(1e-6);
+    Context* context;
+    try {
+        context = new Context(system, integrator, platform, properties);
+    }
+    catch (OpenMMException& ex) {
+        return -1.0;
+    }
+    double elapsed;
+    try {
+        context->setPositions(positions);
+        double alpha;
+        gridSize.resize(3);
+        force.getPMEParametersInContext(*context, alpha, gridSize[0], gridSize[1], gridSize[2]);
+        for (auto& prop : properties)
+            actualProperties[prop.first] = platform.getPropertyValue(*context, prop.first);
+
+        // Take a few steps first so that kernel compilation and other one time setup costs
+        // are not included in the timing.
+
+        integrator.step(5);
+        context->getState(State::Positions);
+        double startTime = getCurrentTime();
+        integrator.step(numSteps);
+        context->getState(State::Positions);
+        elapsed = getCurrentTime()-startTime;
+    }
+    catch (...) {
+        delete context;
+        throw;
+    }
+    delete context;
+    return elapsed;
+}
+
+/**
+ * Create a Context with the specified properties and compute the forces in one force group.  On
+ * exit, gridSize contains the PME grid dimensions the Platform actually used.  If Context creation
+ * fails, this returns false.
+ */
+static bool computeForces(const System& system, NonbondedForce& force, const vector<Vec3>& positions, Platform& platform,
+        const map<string, string>& properties, int group, vector<Vec3>& forces, vector<int>& gridSize) {
+    VerletIntegrator integrator(0.001);
+    Context* context;
+    try {
+        context = new Context(system, integrator, platform, properties);
+    }
+    catch (OpenMMException& ex) {
+        return false;
+    }
+    try {
+        context->setPositions(positions);
+        double alpha;
+        gridSize.resize(3);
+        force.getPMEParametersInContext(*context, alpha, gridSize[0], gridSize[1], gridSize[2]);
+        forces = context->getState(State::Forces, false, 1<<group).getForces();
+    }
+    catch (...) {
+        delete context;
+        throw;
+    }
+    delete context;
+    return true;
+}
+
+/**
+ * Find the NonbondedForce in a System that uses PME or LJPME, or NULL if there is none.
+ */
+static NonbondedForce* findPMEForce(System& system) {
+    for (int i = 0; i < system.getNumForces(); i++) {
+        NonbondedForce* nb = dynamic_cast<NonbondedForce*>(&system.getForce(i));
+        if (nb != NULL && (nb->getNonbondedMethod() == NonbondedForce::PME || nb->getNonbondedMethod() == NonbondedForce::LJPME))
+            return nb;
+    }
+    return NULL;
+}
+
+static string toLower(string value) {
+    transform(value.begin(), value.end(), value.begin(), ::tolower);
+    return value;
+}
+
+map<string, string> PMETuner::tune(System& system, const vector<Vec3>& positions, Platform& platform, const map<string, string>& properties, int numSteps) {
+    if (numSteps < 1)
+        throw OpenMMException("PMETuner: numSteps must be at least 1");
+    if ((int) positions.size() != system.getNumParticles())
+        throw OpenMMException("PMETuner: The number of positions does not match the number of particles in the System");
+    NonbondedForce* force = findPMEForce(system);
+    map<string, string> bestProperties = properties;
+    if (force == NULL)
+        return bestProperties;
+
+    // The starting point is the parameters that would be used anyway.  These give the smallest
+    // grid that achieves the requested accuracy.  Larger grids with the same alpha are at least
+    // as accurate, and sometimes faster because their dimensions factor better for the FFT.
+
+    double alpha;
+    int nx, ny, nz;
+    force->getPMEParameters(alpha, nx, ny, nz);
+    if (alpha == 0.0)
+        NonbondedForceImpl::calcPMEParameters(system, *force, alpha, nx, ny, nz, false);
+    const double scales[] = {1.0, 1.1, 1.2, 1.3};
+    vector<vector<int> > testedGrids;
+    vector<int> bestGrid;
+    double bestTime = -1.0;
+    for (double scale : scales) {
+        force->setPMEParameters(alpha, (int) ceil(nx*scale), (int) ceil(ny*scale), (int) ceil(nz*scale));
+        vector<int> grid;
+        map<string, string> actual;
+        double time = timeSteps(system, *force, positions, platform, properties, numSteps, grid, actual);
+        if (time < 0.0) {
+            if (bestTime < 0.0)
+                throw OpenMMException("PMETuner: Failed to create a Context with the specified Platform and properties");
+            continue;
+        }
+        if (find(testedGrids.begin(), testedGrids.end(), grid) != testedGrids.end())
+            continue;
+        testedGrids.push_back(grid);
+        if (bestTime < 0.0 || time < bestTime) {
+            bestTime = time;
+            bestGrid = grid;
+        }
+    }
+    force->setPMEParameters(alpha, bestGrid[0], bestGrid[1], bestGrid[2]);
+
+    // Now see whether computing PME on the CPU, or on the default stream rather than a separate
+    // one, is faster.  Only try properties the Platform supports, and skip a candidate if the
+    // Platform ignored the requested value.
+
+    const vector<string>& names = platform.getPropertyNames();
+    const string toggles[] = {"UseCpuPme", "DisablePmeStream"};
+    for (const string& name : toggles) {
+        if (find(names.begin(), names.end(), name) == names.end())
+            continue;
+        string current = (bestProperties.find(name) == bestProperties.end() ? platform.getPropertyDefaultValue(name) : bestProperties[name]);
+        string alternative = (toLower(current) == "true" ? "false" : "true");
+        map<string, string> candidate = bestProperties;
+        candidate[name] = alternative;
+        vector<int> grid;
+        map<string, string> actual;
+        double time = timeSteps(system, *force, positions, platform, candidate, numSteps, grid, actual);
+        if (time < 0.0 || toLower(actual[name]) != alternative)
+            continue;
+        if (time < bestTime) {
+            bestTime = time;
+            bestProperties = candidate;
+        }
+    }
+    return bestProperties;
+}
+
+void PMETuner::selectGrid(System& system, const vector<Vec3>& positions, Platform& platform, const map<string, string>& properties) {
+    if ((int) positions.size() != system.getNumParticles())
+        throw OpenMMException("PMETuner: The number of positions does not match the number of particles in the System");
+    NonbondedForce* force = findPMEForce(system);
+    if (force == NULL)
+        return;
+
+    // Put the NonbondedForce into a force group of its own, so its forces can be computed separately
+    // from everything else.
+
+    set<int> usedGroups;
+    for (int i = 0; i < system.getNumForces(); i++) {
+        Force& f = system.getForce(i);
+        if (&f == force)
+            continue;
+        usedGroups.insert(f.getForceGroup());
+        NonbondedForce* nb = dynamic_cast<NonbondedForce*>(&f);
+        if (nb != NULL && nb->getReciprocalSpaceForceGroup() >= 0)
+            usedGroups.insert(nb->getReciprocalSpaceForceGroup());
+    }
+    int group = 0;
+    while (group < 32 && usedGroups.find(group) != usedGroups.end())
+        group++;
+    if (group == 32)
+        throw OpenMMException("PMETuner: No force group is available for measuring the error in the forces");
+    int originalGroup = force->getForceGroup();
+    int originalReciprocalGroup = force->getReciprocalSpaceForceGroup();
+    double originalAlpha;
+    int originalX, originalY, originalZ;
+    force->getPMEParameters(originalAlpha, originalX, originalY, originalZ);
+    force->setForceGroup(group);
+    force->setReciprocalSpaceForceGroup(-1);
+    double alpha;
+    int nx, ny, nz;
+    NonbondedForceImpl::calcPMEParameters(system, *force, alpha, nx, ny, nz, false);
+    vector<int> bestGrid;
+    try {
+        // Compute the reference forces with a much finer grid.  The direct space part is identical for every
+        // grid, so all the differences come from reciprocal space.
+
+        vector<Vec3> referenceForces, forces;
+        vector<int> grid;
+        force->setPMEParameters(alpha, 2*nx, 2*ny, 2*nz);
+        if (!computeForces(system, *force, positions, platform, properties, group, referenceForces, grid))
+            throw OpenMMException("PMETuner: Failed to create a Context with the specified Platform and properties");
+        double norm = 0.0;
+        for (const Vec3& f : referenceForces)
+            norm += f.dot(f);
+        double tolerance = force->getEwaldErrorTolerance();
+
+        // Try successively coarser grids until one fails to meet the tolerance.  The error grows
+        // as the grid gets coarser, so there is no need to try any after that.
+
+        const double scales[] = {1.0, 0.9, 0.8, 0.7, 0.6, 0.5};
+        vector<vector<int> > testedGrids;
+        for (double scale : scales) {
+            force->setPMEParameters(alpha, max(1, (int) ceil(nx*scale)), max(1, (int) ceil(ny*scale)), max(1, (int) ceil(nz*scale)));
+            if (!computeForces(system, *force, positions, platform, properties, group, forces, grid))
+                break;
+            if (find(testedGrids.begin(), testedGrids.end(), grid) != testedGrids.end())
+                continue;
+            testedGrids.push_back(grid);
+            double error = 0.0;
+            for (int i = 0; i < forces.size(); i++) {
+                Vec3 delta = forces[i]-referenceForces[i];
+                error += delta.dot(delta);
+            }
+            if (norm > 0.0 && sqrt(error/norm) > tolerance)
+                break;
+            bestGrid = grid;
+        }
+    }
+    catch (...) {
+        force->setForceGroup(originalGroup);
+        force->setReciprocalSpaceForceGroup(originalReciprocalGroup);
+        force->setPMEParameters(originalAlpha, originalX, originalY, originalZ);
+        throw;
+    }
+    force->setForceGroup(originalGroup);
+    force->setReciprocalSpaceForceGroup(originalReciprocalGroup);
+    if (bestGrid.size() == 0)
+        force->setPMEParameters(alpha, nx, ny, nz);
+    else
+        force->setPMEParameters(alpha, bestGrid[0], bestGrid[1], bestGrid[2]);
+}
@@ -46,6 +46,19 @@ int PeriodicTorsionForce::addTorsion(int particle1, int particle2, int particle3
     return periodicTorsions.size()-1;
 }
 
+int PeriodicTorsionForce::addTorsions(const vector<int>& particle1, const vector<int>& particle2, const vector<int>& particle3, const vector<int>& particle4,
+                                      const vector<int>& periodicity, const vector<double>& phase, const vector<double>& k) {
+    int numTorsions = particle1.size();
+    if (particle2.size() != numTorsions || particle3.size() != numTorsions || particle4.size() != numTorsions ||
+            periodicity.size() != numTorsions || phase.size() != numTorsions || k.size() != numTorsions)
+        throw OpenMMException("PeriodicTorsionForce: All arrays passed to addTorsions() must have the same length");
+    int first = periodicTorsions.size();
+    periodicTorsions.reserve(first+numTorsions);
+    for (int i = 0; i < numTorsions; i++)
+        periodicTorsions.push_back(PeriodicTorsionInfo(particle1[i], particle2[i], particle3[i], particle4[i], periodicity[i], phase[i], k[i]));
+    return first;
+}
+
 void PeriodicTorsionForce::getTorsionParameters(int index, int& particle1, int& particle2, int& particle3, int& particle4, int& periodicity, double& phase, double& k) const {
     ASSERT_VALID_INDEX(index, periodicTorsions);
     particle1 = periodicTorsions[index].particle1;
@@ -99,3 +112,19 @@ void PeriodicTorsionForce::setUsesPeriodicBoundaryConditions(bool periodic) {
 bool PeriodicTorsionForce::usesPeriodicBoundaryConditions() const {
     return usePeriodic;
 }
+
+const vector<int>& PeriodicTorsionForce::getSoluteParticles() const {
+    return soluteParticles;
+}
+
+void PeriodicTorsionForce::setSoluteParticles(const vector<int>& particles) {
+    soluteParticles = particles;
+}
+
+const string& PeriodicTorsionForce::getSoluteScaleParameter() const {
+    return soluteScaleParameter;
+}
+
+void PeriodicTorsionForce::setSoluteScaleParameter(const string& parameter) {
+    soluteScaleParameter = parameter;
+}
@@ -33,12 +33,13 @@
 #include "openmm/internal/ContextImpl.h"
 #include "openmm/internal/PeriodicTorsionForceImpl.h"
 #include "openmm/kernels.h"
+#include <cmath>
 #include <sstream>
 
 using namespace OpenMM;
 using namespace std;
 
-PeriodicTorsionForceImpl::PeriodicTorsionForceImpl(const PeriodicTorsionForce& owner) : owner(owner) {
+PeriodicTorsionForceImpl::PeriodicTorsionForceImpl(const PeriodicTorsionForce& owner) : owner(owner), soluteScale(1.0) {
     forceGroup = owner.getForceGroup();
 }
 
@@ -62,6 +63,17 @@ void PeriodicTorsionForceImpl::initialize(ContextImpl& context) {
         if (periodicity < 1)
             throw OpenMMException("PeriodicTorsionForce: periodicity must be positive");
     }
+    isSolute.resize(system.getNumParticles(), false);
+    for (int particle : owner.getSoluteParticles()) {
+        if (particle < 0 || particle >= system.getNumParticles()) {
+            stringstream msg;
+            msg << "PeriodicTorsionForce: Illegal particle index for a solute particle: ";
+            msg << particle;
+            throw OpenMMException(msg.str());
+        }
+        isSolute[particle] = true;
+    }
+    findSoluteTorsions();
     kernel = context.getPlatform().createKernel(CalcPeriodicTorsionForceKernel::Name(), context);
     kernel.getAs<CalcPeriodicTorsionForceKernel>().initialize(context.getSystem(), owner);
 }
@@ -72,6 +84,27 @@ double PeriodicTorsionForceImpl::calcForcesAndEnergy(ContextImpl& context, bool
     return 0.0;
 }
 
+map<string, double> PeriodicTorsionForceImpl::getDefaultParameters() {
+    map<string, double> parameters;
+    if (owner.getSoluteScaleParameter() != "")
+        parameters[owner.getSoluteScaleParameter()] = 1.0;
+    return parameters;
+}
+
+void PeriodicTorsionForceImpl::contextParameterChanged(ContextImpl& context, const string& name, double value) {
+    if (name != owner.getSoluteScaleParameter() || value == soluteScale)
+        return;
+    if (value <= 0.0)
+        throw OpenMMException("PeriodicTorsionForce: The solute scale parameter must be positive");
+    soluteScale = value;
+
+    // Only the torsions involving the solute need to be updated.
+
+    if (soluteTorsions.size() > 0)
+        copyScaledParametersToContext(context, soluteTorsions.front(), soluteTorsions.back());
+    context.systemChanged();
+}
+
 std::vector<std::string> PeriodicTorsionForceImpl::getKernelNames() {
     std::vector<std::string> names;
     names.push_back(CalcPeriodicTorsionForceKernel::Name());
@@ -79,6 +112,47 @@ std::vector<std::string> PeriodicTorsionForceImpl::getKernelNames() {
 }
 
 void PeriodicTorsionForceImpl::updateParametersInContext(ContextImpl& context, int firstTorsion, int lastTorsion) {
-    kernel.getAs<CalcPeriodicTorsionForceKernel>().copyParametersToContext(context, owner, firstTorsion, lastTorsion);
+    findSoluteTorsions();
+    copyScaledParametersToContext(context, firstTorsion, lastTorsion);
     context.systemChanged();
 }
+
+void PeriodicTorsionForceImpl::findSoluteTorsions() {
+    soluteTorsions.clear();
+    scaledForce.reset();
+    for (int i = 0; i < owner.getNumTorsions(); i++) {
+        int particle[4], periodicity;
+        double phase, k;
+        owner.getTorsionParameters(i, particle[0], particle[1], particle[2], particle[3], periodicity, phase, k);
+        if (isSolute[particle[0]] || isSolute[particle[1]] || isSolute[particle[2]] || isSolute[particle[3]])
+            soluteTorsions.push_back(i);
+    }
+}
+
+void PeriodicTorsionForceImpl::copyScaledParametersToContext(ContextImpl& context, int firstTorsion, int lastTorsion) {
+    if (soluteScale == 1.0) {
+        kernel.getAs<CalcPeriodicTorsionForceKernel>().copyParametersToContext(context, owner, firstTorsion, lastTorsion);
+        return;
+    }
+
+    // Keep a copy of the force in which the torsions involving the solute have been scaled.  It is created
+    // once, and afterward only the solute torsions need to be updated when the scale changes.
+
+    if (!scaledForce)
+        scaledForce.reset(new PeriodicTorsionForce(owner));
+    for (int i : soluteTorsions) {
+        int particle[4], periodicity;
+        double phase, k;
+        owner.getTorsionParameters(i, particle[0], particle[1], particle[2], particle[3], periodicity, phase, k);
+        int numSolute = 0;
+        for (int j = 0; j < 4; j++)
+            if (isSolute[particle[j]])
+                numSolute++;
+        if (numSolute == 4)
+            k *= soluteScale;
+        else
+            k *= sqrt(soluteScale);
+        scaledForce->setTorsionParameters(i, particle[0], particle[1], particle[2], particle[3], periodicity, phase, k);
+    }
+    kernel.getAs<CalcPeriodicTorsionForceKernel>().copyParametersToContext(context, *scaledForce, firstTorsion, lastTorsion);
+}
@@ -0,0 +1,97 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/PhaseProfiler.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/internal/timer.h"
+#include <algorithm>
+
+using namespace OpenMM;
+using namespace std;
+
+PhaseProfiler::PhaseProfiler(ThreadPool& threads) : threads(threads), enabled(false) {
+}
+
+void PhaseProfiler::setEnabled(bool enabled) {
+    this->enabled = enabled;
+    threads.setRecordThreadTimes(enabled);
+    stack.clear();
+}
+
+void PhaseProfiler::pushInterval() {
+    Interval interval;
+    interval.startTime = getCurrentTime();
+    interval.childTime = 0.0;
+    interval.startThreadTimes = threads.getThreadTimes();
+    interval.childThreadTimes.resize(interval.startThreadTimes.size(), 0.0);
+    stack.push_back(interval);
+}
+
+void PhaseProfiler::popInterval(const string& name) {
+    if (stack.size() == 0)
+        throw OpenMMException("PhaseProfiler: endInterval() called without a matching call to startInterval()");
+    Interval interval = stack.back();
+    stack.pop_back();
+    double elapsed = getCurrentTime()-interval.startTime;
+    pair<int, double>& time = times[name];
+    time.first++;
+    time.second += 1e6*max(0.0, elapsed-interval.childTime);
+
+    // Find how long each thread spent working on this phase, excluding nested phases.
+
+    vector<double> threadTimes = threads.getThreadTimes();
+    int numThreads = threadTimes.size();
+    double maxTime = 0.0, sumTime = 0.0;
+    for (int i = 0; i < numThreads; i++) {
+        threadTimes[i] -= interval.startThreadTimes[i];
+        double selfTime = threadTimes[i]-interval.childThreadTimes[i];
+        maxTime = max(maxTime, selfTime);
+        sumTime += selfTime;
+    }
+    if (maxTime > 0.0) {
+        pair<int, double>& imbalance = times[name+" imbalance"];
+        imbalance.first++;
+        imbalance.second += 1e6*(maxTime-sumTime/numThreads);
+    }
+
+    // Exclude this interval from the time recorded for the one containing it.
+
+    if (stack.size() > 0) {
+        Interval& parent = stack.back();
+        parent.childTime += elapsed;
+        for (int i = 0; i < numThreads; i++)
+            parent.childThreadTimes[i] += threadTimes[i];
+    }
+}
+
+void PhaseProfiler::resetTimes() {
+    times.clear();
+}
@@ -0,0 +1,298 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/PlatformSelector.h"
+#include "openmm/Context.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/Platform.h"
+#include "openmm/State.h"
+#include "openmm/VerletIntegrator.h"
+#include "openmm/internal/timer.h"
+#include "openmm/serialization/XmlSerializer.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <sstream>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * Create a Context with the specified Platform and properties and measure how long it takes to
+ * execute a series of time steps.  If Context creation fails, or the Platform does not accept
+ * the requested property values, this returns a negative time.
+ */
+static string toLower(string value) {
+    transform(value.begin(), value.end(), value.begin(), ::tolower);
+    return value;
+}
+
+/**
+ * Create a Context with the specified Platform and properties and measure how long it takes to
+ * execute a series of time steps.  If Context creation fails, or the Platform does not accept
+ * the requested property values, this returns a negative time.
+ */
+static double timeSteps(const System& system, const Integrator& integrator, const vector<Vec3>& positions, Platform& platform,
+        const map<string, string>& properties, int numSteps) {
+    // Use a tiny step size so the particles barely move.  The starting positions usually
+    // are not minimized, and we only care about the cost of each step, not the trajectory.
+
+    Integrator* copy = XmlSerializer::clone<Integrator>(integrator);
+    copy->setStepSize(1e-6);
+    Context* context;
+    try {
+        context = new Context(system, *copy, platform, properties);
+    }
+    catch (OpenMMException& ex) {
+        delete copy;
+        return -1.0;
+    }
+    double elapsed = -1.0;
+    try {
+        bool accepted = true;
+        for (auto& prop : properties)
+            if (toLower(platform.getPropertyValue(*context, prop.first)) != toLower(prop.second))
+                accepted = false;
+        if (accepted) {
+            context->setPositions(positions);
+
+            // Take a few steps first so that kernel compilation and other one time setup costs
+            // are not included in the timing.
+
+            copy->step(5);
+            context->getState(State::Positions);
+            double startTime = getCurrentTime();
+            copy->step(numSteps);
+            context->getState(State::Positions);
+            elapsed = getCurrentTime()-startTime;
+        }
+    }
+    catch (OpenMMException& ex) {
+        elapsed = -1.0;
+    }
+    delete context;
+    delete copy;
+    return elapsed;
+}
+
+static bool hasProperty(Platform& platform, const string& name) {
+    const vector<string>& names = platform.getPropertyNames();
+    return (find(names.begin(), names.end(), name) != names.end());
+}
+
+static bool usesPME(const System& system) {
+    for (int i = 0; i < system.getNumForces(); i++) {
+        const NonbondedForce* nb = dynamic_cast<const NonbondedForce*>(&system.getForce(i));
+        if (nb != NULL && (nb->getNonbondedMethod() == NonbondedForce::PME || nb->getNonbondedMethod() == NonbondedForce::LJPME))
+            return true;
+    }
+    return false;
+}
+
+PlatformSelector::PlatformSelector() : numSteps(100), platform(NULL), loadedFromCache(false) {
+}
+
+void PlatformSelector::setNumSteps(int steps) {
+    if (steps < 1)
+        throw OpenMMException("PlatformSelector: numSteps must be at least 1");
+    numSteps = steps;
+}
+
+Platform& PlatformSelector::getPlatform() const {
+    if (platform == NULL)
+        throw OpenMMException("PlatformSelector: select() has not been called");
+    return *platform;
+}
+
+string PlatformSelector::describeHardware(vector<Platform*>& candidates) const {
+    // Create a trivial Context on each Platform to find out what device it uses.  Platforms
+    // that cannot create one are removed from the candidates.
+
+    stringstream description;
+    vector<Platform*> usable;
+    const string deviceProperties[] = {"DeviceName", "Threads"};
+    for (Platform* candidate : candidates) {
+        System system;
+        system.addParticle(1.0);
+        VerletIntegrator integrator(0.001);
+        try {
+            Context context(system, integrator, *candidate);
+            description << candidate->getName();
+            for (const string& name : deviceProperties)
+                if (hasProperty(*candidate, name))
+                    description << " " << name << "=" << candidate->getPropertyValue(context, name);
+            description << "\n";
+            usable.push_back(candidate);
+        }
+        catch (OpenMMException& ex) {
+        }
+    }
+    candidates = usable;
+    return description.str();
+}
+
+bool PlatformSelector::loadFromCache(const string& fileName) {
+    ifstream in(fileName.c_str());
+    if (!in.is_open())
+        return false;
+    string platformName, line;
+    if (!getline(in, platformName))
+        return false;
+    map<string, string> cachedProperties;
+    while (getline(in, line)) {
+        size_t separator = line.find('=');
+        if (separator != string::npos)
+            cachedProperties[line.substr(0, separator)] = line.substr(separator+1);
+    }
+    try {
+        platform = &Platform::getPlatformByName(platformName);
+    }
+    catch (OpenMMException& ex) {
+        return false;
+    }
+    properties = cachedProperties;
+    return true;
+}
+
+void PlatformSelector::saveToCache(const string& fileName) const {
+    // Write to a temporary file and then rename it, so another process reading the same file
+    // never sees it partially written.  Failures are ignored.
+
+    string tempFileName = fileName+".tmp";
+    ofstream out(tempFileName.c_str());
+    out << platform->getName() << "\n";
+    for (auto& prop : properties)
+        out << prop.first << "=" << prop.second << "\n";
+    out.close();
+    if (out.fail() || rename(tempFileName.c_str(), fileName.c_str()) != 0)
+        remove(tempFileName.c_str());
+}
+
+void PlatformSelector::select(const System& system, const Integrator& integrator, const vector<Vec3>& positions) {
+    if ((int) positions.size() != system.getNumParticles())
+        throw OpenMMException("PlatformSelector: The number of positions does not match the number of particles in the System");
+    loadedFromCache = false;
+
+    // Reference is only a fallback.  It is never faster than the other Platforms.
+
+    vector<Platform*> candidates;
+    Platform* reference = NULL;
+    for (int i = 0; i < Platform::getNumPlatforms(); i++) {
+        Platform& p = Platform::getPlatform(i);
+        if (p.getName() == "Reference")
+            reference = &p;
+        else
+            candidates.push_back(&p);
+    }
+    string hardware = describeHardware(candidates);
+    if (candidates.size() == 0 && reference != NULL)
+        candidates.push_back(reference);
+
+    // See whether a decision has already been cached for this workload on this hardware.
+
+    string cacheFile;
+    if (cacheDirectory.size() > 0) {
+        stringstream key;
+        XmlSerializer::serialize<System>(&system, "System", key);
+        XmlSerializer::serialize<Integrator>(&integrator, "Integrator", key);
+        for (const string& precision : precisions)
+            key << precision << "\n";
+        key << hardware;
+        stringstream name;
+        name << cacheDirectory;
+#ifdef WIN32
+        if (cacheDirectory.back() != '\\')
+            name << "\\";
+#else
+        if (cacheDirectory.back() != '/')
+            name << "/";
+#endif
+        name << "openmm-platform-" << hex << hash<string>()(key.str());
+        cacheFile = name.str();
+        if (loadFromCache(cacheFile)) {
+            loadedFromCache = true;
+            return;
+        }
+    }
+
+    // Time each Platform, trying each of the requested precisions on the ones that support them.
+
+    double bestTime = -1.0;
+    for (Platform* candidate : candidates) {
+        vector<map<string, string> > options;
+        if (precisions.size() > 0 && hasProperty(*candidate, "Precision")) {
+            for (const string& precision : precisions) {
+                map<string, string> option;
+                option["Precision"] = precision;
+                options.push_back(option);
+            }
+        }
+        else
+            options.push_back(map<string, string>());
+        for (auto& option : options) {
+            double time = timeSteps(system, integrator, positions, *candidate, option, numSteps);
+            if (time >= 0.0 && (bestTime < 0.0 || time < bestTime)) {
+                bestTime = time;
+                platform = candidate;
+                properties = option;
+            }
+        }
+    }
+    if (bestTime < 0.0) {
+        platform = NULL;
+        properties.clear();
+        throw OpenMMException("PlatformSelector: No Platform was able to simulate the System");
+    }
+
+    // Now see whether computing PME on the CPU, or on the default stream rather than a separate
+    // one, is faster on the chosen Platform.
+
+    if (usesPME(system)) {
+        const string toggles[] = {"UseCpuPme", "DisablePmeStream"};
+        for (const string& name : toggles) {
+            if (!hasProperty(*platform, name))
+                continue;
+            map<string, string> candidate = properties;
+            string current = (candidate.find(name) == candidate.end() ? platform->getPropertyDefaultValue(name) : candidate[name]);
+            candidate[name] = (toLower(current) == "true" ? "false" : "true");
+            double time = timeSteps(system, integrator, positions, *platform, candidate, numSteps);
+            if (time >= 0.0 && time < bestTime) {
+                bestTime = time;
+                properties = candidate;
+            }
+        }
+    }
+    if (cacheFile.size() > 0)
+        saveToCache(cacheFile);
+}
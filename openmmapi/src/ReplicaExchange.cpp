@@ -0,0 +1,268 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/ReplicaExchange.h"
+#include "openmm/AndersenThermostat.h"
+#include "openmm/BrownianIntegrator.h"
+#include "openmm/DPDIntegrator.h"
+#include "openmm/LangevinIntegrator.h"
+#include "openmm/LangevinMiddleIntegrator.h"
+#include "openmm/MonteCarloAnisotropicBarostat.h"
+#include "openmm/MonteCarloBarostat.h"
+#include "openmm/MonteCarloFlexibleBarostat.h"
+#include "openmm/MonteCarloMembraneBarostat.h"
+#include "openmm/NoseHooverIntegrator.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/Platform.h"
+#include "openmm/State.h"
+#include "openmm/VariableLangevinIntegrator.h"
+#include "openmm/internal/ContextImpl.h"
+#include "openmm/serialization/XmlSerializer.h"
+#include "SimTKOpenMMRealType.h"
+#include "sfmt/SFMT.h"
+#include <cmath>
+
+using namespace OpenMM;
+using namespace std;
+
+bool ReplicaExchange::setIntegratorTemperature(Integrator& integrator, double temperature) {
+    if (dynamic_cast<LangevinMiddleIntegrator*>(&integrator) != NULL)
+        dynamic_cast<LangevinMiddleIntegrator&>(integrator).setTemperature(temperature);
+    else if (dynamic_cast<LangevinIntegrator*>(&integrator) != NULL)
+        dynamic_cast<LangevinIntegrator&>(integrator).setTemperature(temperature);
+    else if (dynamic_cast<BrownianIntegrator*>(&integrator) != NULL)
+        dynamic_cast<BrownianIntegrator&>(integrator).setTemperature(temperature);
+    else if (dynamic_cast<VariableLangevinIntegrator*>(&integrator) != NULL)
+        dynamic_cast<VariableLangevinIntegrator&>(integrator).setTemperature(temperature);
+    else if (dynamic_cast<DPDIntegrator*>(&integrator) != NULL)
+        dynamic_cast<DPDIntegrator&>(integrator).setTemperature(temperature);
+    else if (dynamic_cast<NoseHooverIntegrator*>(&integrator) != NULL) {
+        NoseHooverIntegrator& nh = dynamic_cast<NoseHooverIntegrator&>(integrator);
+        for (int i = 0; i < nh.getNumThermostats(); i++)
+            nh.setTemperature(temperature, i);
+    }
+    else
+        return false;
+    return true;
+}
+
+vector<string> ReplicaExchange::getTemperatureParameters(const System& system) {
+    vector<string> names;
+    for (int i = 0; i < system.getNumForces(); i++) {
+        const Force& force = system.getForce(i);
+        if (dynamic_cast<const AndersenThermostat*>(&force) != NULL)
+            names.push_back(AndersenThermostat::Temperature());
+        else if (dynamic_cast<const MonteCarloAnisotropicBarostat*>(&force) != NULL)
+            names.push_back(MonteCarloAnisotropicBarostat::Temperature());
+        else if (dynamic_cast<const MonteCarloMembraneBarostat*>(&force) != NULL)
+            names.push_back(MonteCarloMembraneBarostat::Temperature());
+        else if (dynamic_cast<const MonteCarloBarostat*>(&force) != NULL || dynamic_cast<const MonteCarloFlexibleBarostat*>(&force) != NULL)
+            names.push_back(MonteCarloBarostat::Temperature());
+    }
+    return names;
+}
+
+ReplicaExchange::ReplicaExchange(const System& system, const Integrator& integrator, const vector<double>& temperatures,
+            const vector<map<string, double> >& parameters, Platform& platform, const map<string, string>& properties, int randomSeed) :
+            system(system), temperatures(temperatures), parameters(parameters), exchangeParity(0) {
+    int numStates = temperatures.size();
+    if (numStates < 2)
+        throw OpenMMException("ReplicaExchange: At least two thermodynamic states are required");
+    if (parameters.size() != 0 && (int) parameters.size() != numStates)
+        throw OpenMMException("ReplicaExchange: The number of parameter sets must equal the number of temperatures");
+    for (double t : temperatures)
+        if (t <= 0)
+            throw OpenMMException("ReplicaExchange: Temperatures must be positive");
+    temperatureParameters = getTemperatureParameters(system);
+    random = new OpenMM_SFMT::SFMT();
+    init_gen_rand(randomSeed, *random);
+
+    // If parameters are to be shared, every replica after the first is linked to the first one, so they
+    // can share device memory.
+
+    auto share = properties.find("ShareParameters");
+    bool linkReplicas = (share != properties.end() && share->second == "true");
+    try {
+        for (int i = 0; i < numStates; i++) {
+            integrators.push_back(XmlSerializer::clone<Integrator>(integrator));
+            if (!setIntegratorTemperature(*integrators[i], temperatures[i]) && temperatureParameters.size() == 0)
+                throw OpenMMException("ReplicaExchange: The Integrator does not have a temperature, and the System does not contain a thermostat");
+            if (linkReplicas && i > 0)
+                contexts.push_back(contexts[0]->getImpl().createLinkedContext(system, *integrators[i]));
+            else
+                contexts.push_back(new Context(system, *integrators[i], platform, properties));
+            replicaState.push_back(i);
+            applyState(i, i);
+        }
+    }
+    catch (...) {
+        for (int i = contexts.size()-1; i >= 0; i--)
+            delete contexts[i];
+        for (Integrator* integ : integrators)
+            delete integ;
+        delete random;
+        throw;
+    }
+    numAttempted.resize(numStates-1, 0);
+    numAccepted.resize(numStates-1, 0);
+}
+
+ReplicaExchange::~ReplicaExchange() {
+    // Delete the Contexts in reverse order, since later ones may be linked to the first one.
+
+    for (int i = contexts.size()-1; i >= 0; i--)
+        delete contexts[i];
+    for (Integrator* integrator : integrators)
+        delete integrator;
+    delete random;
+}
+
+Context& ReplicaExchange::getContext(int replica) {
+    if (replica < 0 || replica >= (int) contexts.size())
+        throw OpenMMException("ReplicaExchange: Illegal replica index");
+    return *contexts[replica];
+}
+
+Integrator& ReplicaExchange::getIntegrator(int replica) {
+    if (replica < 0 || replica >= (int) integrators.size())
+        throw OpenMMException("ReplicaExchange: Illegal replica index");
+    return *integrators[replica];
+}
+
+int ReplicaExchange::getNumAttempted(int state) const {
+    if (state < 0 || state >= (int) numAttempted.size())
+        throw OpenMMException("ReplicaExchange: Illegal state index");
+    return numAttempted[state];
+}
+
+int ReplicaExchange::getNumAccepted(int state) const {
+    if (state < 0 || state >= (int) numAccepted.size())
+        throw OpenMMException("ReplicaExchange: Illegal state index");
+    return numAccepted[state];
+}
+
+void ReplicaExchange::step(int steps) {
+    for (Integrator* integrator : integrators)
+        integrator->step(steps);
+}
+
+void ReplicaExchange::applyState(int replica, int state) {
+    Context& context = *contexts[replica];
+    if (parameters.size() > 0)
+        for (auto& param : parameters[state])
+            context.setParameter(param.first, param.second);
+    setIntegratorTemperature(*integrators[replica], temperatures[state]);
+    for (const string& param : temperatureParameters)
+        context.setParameter(param, temperatures[state]);
+}
+
+double ReplicaExchange::computeEnergy(int replica, int state) {
+    // Temporarily switch the Context to the other state's parameters, then restore its own.
+
+    Context& context = *contexts[replica];
+    int currentState = replicaState[replica];
+    bool switchParameters = (parameters.size() > 0 && parameters[state] != parameters[currentState]);
+    if (switchParameters)
+        for (auto& param : parameters[state])
+            context.setParameter(param.first, param.second);
+    double energy = context.getState(State::Energy).getPotentialEnergy();
+    if (switchParameters)
+        for (auto& param : parameters[currentState])
+            context.setParameter(param.first, param.second);
+    return energy;
+}
+
+vector<vector<double> > ReplicaExchange::computeReducedPotentials() {
+    int numStates = temperatures.size();
+    vector<vector<double> > u(numStates, vector<double>(numStates));
+    for (int i = 0; i < numStates; i++) {
+        map<map<string, double>, double> energies;
+        for (int j = 0; j < numStates; j++) {
+            const map<string, double>& key = (parameters.size() > 0 ? parameters[j] : map<string, double>());
+            if (energies.find(key) == energies.end())
+                energies[key] = computeEnergy(i, j);
+            u[i][j] = energies[key]/(BOLTZ*temperatures[j]);
+        }
+    }
+    return u;
+}
+
+int ReplicaExchange::attemptExchanges() {
+    int numStates = temperatures.size();
+    vector<int> stateReplica(numStates);
+    for (int i = 0; i < numStates; i++)
+        stateReplica[replicaState[i]] = i;
+    vector<double> energy(numStates);
+    for (int i = 0; i < numStates; i++)
+        energy[i] = computeEnergy(i, replicaState[i]);
+    int accepted = 0;
+    for (int s1 = exchangeParity; s1+1 < numStates; s1 += 2) {
+        int s2 = s1+1;
+        int r1 = stateReplica[s1];
+        int r2 = stateReplica[s2];
+        double beta1 = 1.0/(BOLTZ*temperatures[s1]);
+        double beta2 = 1.0/(BOLTZ*temperatures[s2]);
+
+        // Compute the energy of each replica in the other one's state.  If the states have
+        // the same parameters, the energies we already have can be reused.
+
+        double energy1in2 = energy[r1], energy2in1 = energy[r2];
+        if (parameters.size() > 0 && parameters[s1] != parameters[s2]) {
+            energy1in2 = computeEnergy(r1, s2);
+            energy2in1 = computeEnergy(r2, s1);
+        }
+        double delta = beta1*(energy2in1-energy[r1]) + beta2*(energy1in2-energy[r2]);
+        numAttempted[s1]++;
+        if (delta > 0 && genrand_real2(*random) >= exp(-delta))
+            continue;
+
+        // Accept the exchange.  Each Context switches to the other state, and its velocities are
+        // rescaled to the new temperature.
+
+        numAccepted[s1]++;
+        accepted++;
+        replicaState[r1] = s2;
+        replicaState[r2] = s1;
+        stateReplica[s1] = r2;
+        stateReplica[s2] = r1;
+        energy[r1] = energy1in2;
+        energy[r2] = energy2in1;
+        for (int r : {r1, r2}) {
+            int newState = replicaState[r];
+            int oldState = (newState == s1 ? s2 : s1);
+            applyState(r, newState);
+            if (temperatures[newState] != temperatures[oldState])
+                contexts[r]->getImpl().scaleVelocities(sqrt(temperatures[newState]/temperatures[oldState]));
+        }
+    }
+    exchangeParity = 1-exchangeParity;
+    return accepted;
+}
@@ -0,0 +1,337 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/SharedMemoryExporter.h"
+#include "openmm/Integrator.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/System.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * The maximum number of captured frames that may wait to be published.  When this is reached,
+ * publishFrame() blocks until the background thread catches up.
+ */
+static const int MaxPendingFrames = 4;
+
+/**
+ * The size in bytes of the header at the start of the shared memory segment.
+ */
+static const size_t SegmentHeaderSize = 64;
+
+/**
+ * The size in bytes of the header at the start of each frame.
+ */
+static const size_t FrameHeaderSize = 128;
+
+static const char Magic[] = "OMMSHM01";
+
+static string getSegmentName(const string& name) {
+    if (name.size() > 0 && name[0] == '/')
+        return name;
+    return "/"+name;
+}
+
+static atomic<uint64_t>& getAtomic(char* pointer) {
+    return *reinterpret_cast<atomic<uint64_t>*>(pointer);
+}
+
+SharedMemoryExporter::SharedMemoryExporter(Context& context, const string& name, int interval, int numSlots, bool includeEnergy,
+            bool enforcePeriodicBox) : context(context), name(getSegmentName(name)), interval(interval), numSlots(numSlots),
+            numFrames(0), numPublished(0), includeEnergy(includeEnergy), enforcePeriodicBox(enforcePeriodicBox), finished(false),
+            busy(false), memory(NULL) {
+#ifdef _WIN32
+    throw OpenMMException("SharedMemoryExporter: Shared memory export is not supported on this operating system");
+#else
+    if (interval <= 0)
+        throw OpenMMException("SharedMemoryExporter: The interval must be positive");
+    if (numSlots <= 0)
+        throw OpenMMException("SharedMemoryExporter: The number of slots must be positive");
+    numAtoms = context.getSystem().getNumParticles();
+    slotSize = ((FrameHeaderSize+3*sizeof(double)*numAtoms+63)/64)*64;
+    memorySize = SegmentHeaderSize+numSlots*slotSize;
+
+    // Create the shared memory segment.
+
+    shm_unlink(this->name.c_str());
+    int fd = shm_open(this->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd == -1)
+        throw OpenMMException("SharedMemoryExporter: Failed to create shared memory segment: "+this->name);
+    if (ftruncate(fd, memorySize) != 0) {
+        close(fd);
+        shm_unlink(this->name.c_str());
+        throw OpenMMException("SharedMemoryExporter: Failed to allocate shared memory segment: "+this->name);
+    }
+    void* pointer = mmap(NULL, memorySize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (pointer == MAP_FAILED) {
+        shm_unlink(this->name.c_str());
+        throw OpenMMException("SharedMemoryExporter: Failed to map shared memory segment: "+this->name);
+    }
+    memory = (char*) pointer;
+
+    // Write the header.  The magic number goes last, so a reader never sees a partially initialized header.
+
+    int32_t values[] = {numAtoms, numSlots, includeEnergy ? 1 : 0};
+    memcpy(memory+8, values, sizeof(values));
+    int64_t size = slotSize;
+    memcpy(memory+24, &size, sizeof(size));
+    getAtomic(memory+32).store(0);
+    for (int i = 0; i < numSlots; i++)
+        getAtomic(memory+SegmentHeaderSize+i*slotSize).store(0);
+    atomic_thread_fence(memory_order_release);
+    memcpy(memory, Magic, 8);
+    thread = std::thread(&SharedMemoryExporter::threadBody, this);
+#endif
+}
+
+SharedMemoryExporter::~SharedMemoryExporter() {
+#ifndef _WIN32
+    {
+        lock_guard<mutex> guard(lock);
+        finished = true;
+    }
+    condition.notify_all();
+    thread.join();
+    munmap(memory, memorySize);
+    shm_unlink(name.c_str());
+#endif
+}
+
+void SharedMemoryExporter::step(int steps) {
+    checkError();
+    Integrator& integrator = context.getIntegrator();
+    while (steps > 0) {
+        int stepsToFrame = interval-(int) (context.getStepCount()%interval);
+        int stepsToTake = min(steps, stepsToFrame);
+        integrator.step(stepsToTake);
+        steps -= stepsToTake;
+        if (context.getStepCount()%interval == 0)
+            publishFrame();
+    }
+}
+
+void SharedMemoryExporter::publishFrame() {
+    checkError();
+    {
+        unique_lock<mutex> guard(lock);
+        condition.wait(guard, [&] {return pending.size() < MaxPendingFrames;});
+    }
+    int types = State::Positions;
+    if (includeEnergy)
+        types |= State::Energy;
+    future<State> state = context.getStateAsync(types, enforcePeriodicBox);
+    {
+        lock_guard<mutex> guard(lock);
+        pending.push_back(move(state));
+        numFrames++;
+    }
+    condition.notify_all();
+}
+
+void SharedMemoryExporter::flush() {
+    {
+        unique_lock<mutex> guard(lock);
+        condition.wait(guard, [&] {return pending.empty() && !busy;});
+    }
+    checkError();
+}
+
+void SharedMemoryExporter::checkError() {
+    string message;
+    {
+        lock_guard<mutex> guard(lock);
+        message.swap(error);
+    }
+    if (message.size() > 0)
+        throw OpenMMException(message);
+}
+
+void SharedMemoryExporter::threadBody() {
+    while (true) {
+        future<State> next;
+        {
+            unique_lock<mutex> guard(lock);
+            condition.wait(guard, [&] {return finished || !pending.empty();});
+            if (pending.empty())
+                return;
+            next = move(pending.front());
+            pending.pop_front();
+            busy = true;
+        }
+        condition.notify_all();
+        string message;
+        try {
+            writeState(next.get());
+        }
+        catch (exception& ex) {
+            message = ex.what();
+        }
+        {
+            lock_guard<mutex> guard(lock);
+            busy = false;
+            if (error.size() == 0)
+                error = message;
+        }
+        condition.notify_all();
+    }
+}
+
+void SharedMemoryExporter::writeState(const State& state) {
+    // Mark the slot as being written, copy the frame into it, then mark it as complete.
+
+    char* slot = memory+SegmentHeaderSize+(numPublished%numSlots)*slotSize;
+    atomic<uint64_t>& sequence = getAtomic(slot);
+    sequence.store(2*numPublished+1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    int64_t stepCount = state.getStepCount();
+    double values[12];
+    values[0] = state.getTime();
+    values[1] = (includeEnergy ? state.getPotentialEnergy() : 0.0);
+    values[2] = (includeEnergy ? state.getKineticEnergy() : 0.0);
+    Vec3 box[3];
+    state.getPeriodicBoxVectors(box[0], box[1], box[2]);
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            values[3+3*i+j] = box[i][j];
+    memcpy(slot+8, &stepCount, sizeof(stepCount));
+    memcpy(slot+16, values, sizeof(values));
+    memcpy(slot+FrameHeaderSize, state.getPositions().data(), 3*sizeof(double)*numAtoms);
+    sequence.store(2*numPublished+2, memory_order_release);
+    numPublished++;
+    getAtomic(memory+32).store(numPublished, memory_order_release);
+}
+
+SharedMemoryReader::SharedMemoryReader(const string& name) : memory(NULL) {
+#ifdef _WIN32
+    throw OpenMMException("SharedMemoryReader: Shared memory export is not supported on this operating system");
+#else
+    string segmentName = getSegmentName(name);
+    int fd = shm_open(segmentName.c_str(), O_RDONLY, 0);
+    if (fd == -1)
+        throw OpenMMException("SharedMemoryReader: Failed to open shared memory segment: "+segmentName);
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t) SegmentHeaderSize) {
+        close(fd);
+        throw OpenMMException("SharedMemoryReader: Invalid shared memory segment: "+segmentName);
+    }
+    memorySize = info.st_size;
+    void* pointer = mmap(NULL, memorySize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (pointer == MAP_FAILED)
+        throw OpenMMException("SharedMemoryReader: Failed to map shared memory segment: "+segmentName);
+    memory = (char*) pointer;
+    bool valid = (memcmp(memory, Magic, 8) == 0);
+    atomic_thread_fence(memory_order_acquire);
+    int32_t values[3];
+    memcpy(values, memory+8, sizeof(values));
+    int64_t size;
+    memcpy(&size, memory+24, sizeof(size));
+    numAtoms = values[0];
+    numSlots = values[1];
+    includeEnergy = (values[2] != 0);
+    slotSize = size;
+    if (!valid || numAtoms < 0 || numSlots <= 0 || slotSize < FrameHeaderSize+3*sizeof(double)*numAtoms ||
+            memorySize < SegmentHeaderSize+numSlots*slotSize) {
+        munmap(memory, memorySize);
+        throw OpenMMException("SharedMemoryReader: Invalid shared memory segment: "+segmentName);
+    }
+#endif
+}
+
+SharedMemoryReader::~SharedMemoryReader() {
+#ifndef _WIN32
+    munmap(memory, memorySize);
+#endif
+}
+
+long long SharedMemoryReader::getNumFrames() const {
+    return getAtomic(memory+32).load(memory_order_acquire);
+}
+
+State SharedMemoryReader::getFrame(long long frame) const {
+    if (frame < 0 || frame >= getNumFrames())
+        throw OpenMMException("SharedMemoryReader: Frame "+to_string(frame)+" has not been published");
+    State state;
+    if (!tryReadFrame(frame, state))
+        throw OpenMMException("SharedMemoryReader: Frame "+to_string(frame)+" has been overwritten");
+    return state;
+}
+
+State SharedMemoryReader::getLatestFrame() const {
+    // If the frame gets overwritten while we are reading it, there is a newer one to read instead.
+
+    State state;
+    while (true) {
+        long long frames = getNumFrames();
+        if (frames == 0)
+            throw OpenMMException("SharedMemoryReader: No frames have been published");
+        if (tryReadFrame(frames-1, state))
+            return state;
+    }
+}
+
+bool SharedMemoryReader::tryReadFrame(long long frame, State& state) const {
+    // Copy the frame, then check that the sequence number did not change while we were copying it.
+
+    char* slot = memory+SegmentHeaderSize+(frame%numSlots)*slotSize;
+    atomic<uint64_t>& sequence = getAtomic(slot);
+    uint64_t expected = 2*frame+2;
+    if (sequence.load(memory_order_acquire) != expected)
+        return false;
+    int64_t stepCount;
+    double values[12];
+    vector<Vec3> positions(numAtoms);
+    memcpy(&stepCount, slot+8, sizeof(stepCount));
+    memcpy(values, slot+16, sizeof(values));
+    memcpy(positions.data(), slot+FrameHeaderSize, 3*sizeof(double)*numAtoms);
+    atomic_thread_fence(memory_order_acquire);
+    if (sequence.load(memory_order_relaxed) != expected)
+        return false;
+    State::StateBuilder builder(values[0], stepCount);
+    builder.setPositions(positions);
+    builder.setPeriodicBoxVectors(Vec3(values[3], values[4], values[5]), Vec3(values[6], values[7], values[8]), Vec3(values[9], values[10], values[11]));
+    if (includeEnergy)
+        builder.setEnergy(values[2], values[1]);
+    state = builder.getState();
+    return true;
+}
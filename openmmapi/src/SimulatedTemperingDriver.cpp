@@ -0,0 +1,167 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/SimulatedTemperingDriver.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/ReplicaExchange.h"
+#include "openmm/internal/ContextImpl.h"
+#include "SimTKOpenMMRealType.h"
+#include "sfmt/SFMT.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace OpenMM;
+using namespace std;
+
+SimulatedTemperingDriver::SimulatedTemperingDriver(Context& context, const vector<double>& temperatures, const vector<double>& weights,
+            int tempChangeInterval, int randomSeed) : context(context), temperatures(temperatures), weights(weights),
+            tempChangeInterval(tempChangeInterval), currentTemperature(0), numAttempted(0), numAccepted(0),
+            hasMadeTransition(false), weightUpdateFactor(1.0) {
+    int numTemperatures = temperatures.size();
+    if (numTemperatures < 2)
+        throw OpenMMException("SimulatedTemperingDriver: At least two temperatures are required");
+    if (temperatures[0] <= 0)
+        throw OpenMMException("SimulatedTemperingDriver: Temperatures must be positive");
+    for (int i = 0; i < numTemperatures-1; i++)
+        if (temperatures[i] >= temperatures[i+1])
+            throw OpenMMException("SimulatedTemperingDriver: The temperatures must be in strictly increasing order");
+    if (weights.size() != 0 && (int) weights.size() != numTemperatures)
+        throw OpenMMException("SimulatedTemperingDriver: The number of weights must equal the number of temperatures");
+    if (tempChangeInterval < 1)
+        throw OpenMMException("SimulatedTemperingDriver: The temperature change interval must be positive");
+    updateWeights = (weights.size() == 0);
+    if (updateWeights) {
+        this->weights.resize(numTemperatures, 0.0);
+        histogram.resize(numTemperatures, 0);
+    }
+    temperatureParameters = ReplicaExchange::getTemperatureParameters(context.getSystem());
+    if (!ReplicaExchange::setIntegratorTemperature(context.getIntegrator(), temperatures[0]) && temperatureParameters.size() == 0)
+        throw OpenMMException("SimulatedTemperingDriver: The Integrator does not have a temperature, and the System does not contain a thermostat");
+    applyTemperature(0);
+    random = new OpenMM_SFMT::SFMT();
+    init_gen_rand(randomSeed, *random);
+}
+
+SimulatedTemperingDriver::~SimulatedTemperingDriver() {
+    delete random;
+}
+
+double SimulatedTemperingDriver::getTemperature(int index) const {
+    if (index < 0 || index >= (int) temperatures.size())
+        throw OpenMMException("SimulatedTemperingDriver: Illegal temperature index");
+    return temperatures[index];
+}
+
+vector<double> SimulatedTemperingDriver::getWeights() const {
+    vector<double> result(weights.size());
+    for (int i = 0; i < (int) weights.size(); i++)
+        result[i] = weights[i]-weights[0];
+    return result;
+}
+
+void SimulatedTemperingDriver::step(int steps) {
+    Integrator& integrator = context.getIntegrator();
+    while (steps > 0) {
+        int nextSteps = min(steps, tempChangeInterval-(int) (context.getStepCount()%tempChangeInterval));
+        integrator.step(nextSteps);
+        steps -= nextSteps;
+        if (context.getStepCount()%tempChangeInterval == 0)
+            attemptTemperatureChange();
+    }
+}
+
+void SimulatedTemperingDriver::applyTemperature(int index) {
+    ReplicaExchange::setIntegratorTemperature(context.getIntegrator(), temperatures[index]);
+    for (const string& param : temperatureParameters)
+        context.setParameter(param, temperatures[index]);
+}
+
+void SimulatedTemperingDriver::attemptTemperatureChange() {
+    // Compute the probability for each temperature.  This is done in log space to avoid overflow.
+    // Only the potential energy is needed, so don't compute forces or the kinetic energy.
+
+    int numTemperatures = temperatures.size();
+    double energy = context.getImpl().calcForcesAndEnergy(false, true);
+    vector<double> logProbability(numTemperatures);
+    for (int i = 0; i < numTemperatures; i++)
+        logProbability[i] = weights[i]-energy/(BOLTZ*temperatures[i]);
+    double maxLogProb = *max_element(logProbability.begin(), logProbability.end());
+    double sum = 0.0;
+    for (double p : logProbability)
+        sum += exp(p-maxLogProb);
+    double offset = maxLogProb+log(sum);
+    vector<double> probability(numTemperatures);
+    for (int i = 0; i < numTemperatures; i++)
+        probability[i] = exp(logProbability[i]-offset);
+
+    // Select the new temperature.
+
+    double r = genrand_real2(*random);
+    int j = 0;
+    while (j < numTemperatures-1 && r >= probability[j]) {
+        r -= probability[j];
+        j++;
+    }
+    numAttempted++;
+    if (j != currentTemperature) {
+        context.getImpl().scaleVelocities(sqrt(temperatures[j]/temperatures[currentTemperature]));
+        hasMadeTransition = true;
+        numAccepted++;
+        currentTemperature = j;
+        applyTemperature(j);
+    }
+    if (updateWeights) {
+        // Update the weight factors.
+
+        weights[j] -= weightUpdateFactor;
+        histogram[j]++;
+        int minCounts = *min_element(histogram.begin(), histogram.end());
+        int totalCounts = 0;
+        for (int count : histogram)
+            totalCounts += count;
+        if (minCounts > 20 && minCounts >= 0.2*totalCounts/numTemperatures) {
+            // Reduce the weight update factor and reset the histogram.
+
+            weightUpdateFactor *= 0.5;
+            histogram.assign(numTemperatures, 0);
+            double w0 = weights[0];
+            for (double& w : weights)
+                w -= w0;
+        }
+        else if (!hasMadeTransition && probability[currentTemperature] > 0.99) {
+            // Rapidly increase the weight update factor at the start of the simulation to find
+            // a reasonable starting value.
+
+            weightUpdateFactor *= 2.0;
+            histogram.assign(numTemperatures, 0);
+        }
+    }
+}
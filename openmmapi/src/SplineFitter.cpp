@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2010-2022 Stanford University and the Authors.      *
+ * Portions copyright (c) 2010-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -43,6 +43,35 @@ static bool notEqual(double a, double b) {
   return (fabs(a-b) > 1e-15 + 1e-15*fabs(b));
 }
 
+/**
+ * Convert the values and derivatives of a cubic at the two ends of an interval into the coefficients
+ * of the polynomial.  The inputs are stored at in[0], in[stride], in[2*stride], and in[3*stride], in
+ * the order (f(0), f(1), f'(0), f'(1)).  The coefficients of 1, t, t^2, and t^3 are written to out
+ * with the same stride.  Bicubic and tricubic coefficients are found by applying this along each axis.
+ */
+static void hermiteToPolynomial(const double* in, double* out, int stride) {
+    double f0 = in[0], f1 = in[stride], d0 = in[2*stride], d1 = in[3*stride];
+    out[0] = f0;
+    out[stride] = d0;
+    out[2*stride] = 3.0*(f1-f0)-2.0*d0-d1;
+    out[3*stride] = 2.0*(f0-f1)+d0+d1;
+}
+
+/**
+ * Evaluate the derivative of a spline at one of its knots.  This gives the same result as
+ * evaluateSplineDerivative(x, y, deriv, x[k]), but does not need to search for the interval.
+ */
+static double knotDerivative(const vector<double>& x, const vector<double>& y, const vector<double>& deriv, int k) {
+    int n = x.size();
+    int lower = (k < n-1 ? k : n-2);
+    int upper = lower+1;
+    double dx = x[upper]-x[lower];
+    double dadx = -1.0/dx;
+    if (k < n-1)
+        return dadx*y[lower]-dadx*y[upper]+(-2.0*deriv[lower] - deriv[upper])*dx/6.0;
+    return dadx*y[lower]-dadx*y[upper]+(deriv[lower] + 2.0*deriv[upper])*dx/6.0;
+}
+
 void SplineFitter::createSpline(const vector<double>& x, const vector<double>& y, bool periodic, vector<double>& deriv) {
     if (periodic)
         SplineFitter::createPeriodicSpline(x, y, deriv);
@@ -222,7 +251,7 @@ void SplineFitter::create2DSpline(const vector<double>& x, const vector<double>&
             t[j] = values[j+xsize*i];
         SplineFitter::createSpline(x, t, periodic, deriv);
         for (int j = 0; j < xsize; j++)
-            d1[j+xsize*i] = SplineFitter::evaluateSplineDerivative(x, t, deriv, x[j]);
+            d1[j+xsize*i] = knotDerivative(x, t, deriv, j);
     }
 
     // Compute derivatives with respect to y.
@@ -234,7 +263,7 @@ void SplineFitter::create2DSpline(const vector<double>& x, const vector<double>&
             t[j] = values[i+xsize*j];
         SplineFitter::createSpline(y, t, periodic, deriv);
         for (int j = 0; j < ysize; j++)
-            d2[i+xsize*j] = SplineFitter::evaluateSplineDerivative(y, t, deriv, y[j]);
+            d2[i+xsize*j] = knotDerivative(y, t, deriv, j);
     }
 
     // Compute cross derivatives.
@@ -246,58 +275,37 @@ void SplineFitter::create2DSpline(const vector<double>& x, const vector<double>&
             t[j] = d2[j+xsize*i];
         SplineFitter::createSpline(x, t, periodic, deriv);
         for (int j = 0; j < xsize; j++)
-            d12[j+xsize*i] = SplineFitter::evaluateSplineDerivative(x, t, deriv, x[j]);
+            d12[j+xsize*i] = knotDerivative(x, t, deriv, j);
     }
 
     // Now compute the coefficients.
 
-    const int wt[] = {
-        1, 0, -3, 2, 0, 0, 0, 0, -3, 0, 9, -6, 2, 0, -6, 4,
-        0, 0, 0, 0, 0, 0, 0, 0, 3, 0, -9, 6, -2, 0, 6, -4,
-        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 9, -6, 0, 0, -6, 4,
-        0, 0, 3, -2, 0, 0, 0, 0, 0, 0, -9, 6, 0, 0, 6, -4,
-        0, 0, 0, 0, 1, 0, -3, 2, -2, 0, 6, -4, 1, 0, -3, 2,
-        0, 0, 0, 0, 0, 0, 0, 0, -1, 0, 3, -2, 1, 0, -3, 2,
-        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -3, 2, 0, 0, 3, -2,
-        0, 0, 0, 0, 0, 0, 3, -2, 0, 0, -6, 4, 0, 0, 3, -2,
-        0, 1, -2, 1, 0, 0, 0, 0, 0, -3, 6, -3, 0, 2, -4, 2,
-        0, 0, 0, 0, 0, 0, 0, 0, 0, 3, -6, 3, 0, -2, 4, -2,
-        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -3, 3, 0, 0, 2, -2,
-        0, 0, -1, 1, 0, 0, 0, 0, 0, 0, 3, -3, 0, 0, -2, 2,
-        0, 0, 0, 0, 0, 1, -2, 1, 0, -2, 4, -2, 0, 1, -2, 1,
-        0, 0, 0, 0, 0, 0, 0, 0, 0, -1, 2, -1, 0, 1, -2, 1,
-        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 0, 0, -1, 1,
-        0, 0, 0, 0, 0, 0, -1, 1, 0, 0, 2, -2, 0, 0, -1, 1
-    };
-    vector<double> rhs(16);
     c.resize((xsize-1)*(ysize-1));
     for (int i = 0; i < xsize-1; i++) {
         for (int j = 0; j < ysize-1; j++) {
-            // Compute the 16 coefficients for patch (i, j).
+            // Compute the 16 coefficients for patch (i, j).  The values and derivatives at the corners
+            // are arranged as a 4x4 matrix, indexed by (f(0), f(1), f'(0), f'(1)) along each axis.
 
             int nexti = i+1;
             int nextj = j+1;
             double deltax = x[nexti]-x[i];
             double deltay = y[nextj]-y[j];
-            double e[] = {values[i+j*xsize], values[nexti+j*xsize], values[nexti+nextj*xsize], values[i+nextj*xsize]};
-            double e1[] = {d1[i+j*xsize], d1[nexti+j*xsize], d1[nexti+nextj*xsize], d1[i+nextj*xsize]};
-            double e2[] = {d2[i+j*xsize], d2[nexti+j*xsize], d2[nexti+nextj*xsize], d2[i+nextj*xsize]};
-            double e12[] = {d12[i+j*xsize], d12[nexti+j*xsize], d12[nexti+nextj*xsize], d12[i+nextj*xsize]};
-
+            int corner[] = {i+j*xsize, nexti+j*xsize, i+nextj*xsize, nexti+nextj*xsize};
+            double g[16], h[16];
             for (int k = 0; k < 4; k++) {
-                rhs[k] = e[k];
-                rhs[k+4] = e1[k]*deltax;
-                rhs[k+8] = e2[k]*deltay;
-                rhs[k+12] = e12[k]*deltax*deltay;
+                int index = corner[k];
+                int gx = k%2, gy = k/2;
+                g[4*gx+gy] = values[index];
+                g[4*(gx+2)+gy] = d1[index]*deltax;
+                g[4*gx+gy+2] = d2[index]*deltay;
+                g[4*(gx+2)+gy+2] = d12[index]*deltax*deltay;
             }
+            for (int k = 0; k < 4; k++)
+                hermiteToPolynomial(&g[k], &h[k], 4);
             vector<double>& coeff = c[i+j*(xsize-1)];
             coeff.resize(16);
-            for (int k = 0; k < 16; k++) {
-                double sum = 0.0;
-                for (int m = 0; m < 16; m++)
-                    sum += wt[k+16*m]*rhs[m];
-                coeff[k] = sum;
-            }
+            for (int k = 0; k < 4; k++)
+                hermiteToPolynomial(&h[4*k], &coeff[4*k], 1);
         }
     }
 }
@@ -415,7 +423,7 @@ void SplineFitter::create3DSpline(const vector<double>& x, const vector<double>&
                     t[k] = values[k+xsize*i+xysize*j];
                 SplineFitter::createSpline(x, t, periodic, deriv);
                 for (int k = 0; k < xsize; k++)
-                    d1[k+xsize*i+xysize*j] = SplineFitter::evaluateSplineDerivative(x, t, deriv, x[k]);
+                    d1[k+xsize*i+xysize*j] = knotDerivative(x, t, deriv, k);
             }
         }
 
@@ -429,7 +437,7 @@ void SplineFitter::create3DSpline(const vector<double>& x, const vector<double>&
                     t[k] = values[i+xsize*k+xysize*j];
                 SplineFitter::createSpline(y, t, periodic, deriv);
                 for (int k = 0; k < ysize; k++)
-                    d2[i+xsize*k+xysize*j] = SplineFitter::evaluateSplineDerivative(y, t, deriv, y[k]);
+                    d2[i+xsize*k+xysize*j] = knotDerivative(y, t, deriv, k);
             }
         }
 
@@ -443,7 +451,7 @@ void SplineFitter::create3DSpline(const vector<double>& x, const vector<double>&
                     t[k] = values[i+xsize*j+xysize*k];
                 SplineFitter::createSpline(z, t, periodic, deriv);
                 for (int k = 0; k < zsize; k++)
-                    d3[i+xsize*j+xysize*k] = SplineFitter::evaluateSplineDerivative(z, t, deriv, z[k]);
+                    d3[i+xsize*j+xysize*k] = knotDerivative(z, t, deriv, k);
             }
         }
 
@@ -458,7 +466,7 @@ void SplineFitter::create3DSpline(const vector<double>& x, const vector<double>&
                     t[k] = d2[k+xsize*i+xysize*j];
                 SplineFitter::createSpline(x, t, periodic, deriv);
                 for (int k = 0; k < xsize; k++)
-                    d12[k+xsize*i+xysize*j] = SplineFitter::evaluateSplineDerivative(x, t, deriv, x[k]);
+                    d12[k+xsize*i+xysize*j] = knotDerivative(x, t, deriv, k);
             }
         }
 
@@ -472,7 +480,7 @@ void SplineFitter::create3DSpline(const vector<double>& x, const vector<double>&
                     t[k] = d3[j+xsize*k+xysize*i];
                 SplineFitter::createSpline(y, t, periodic, deriv);
                 for (int k = 0; k < ysize; k++)
-                    d23[j+xsize*k+xysize*i] = SplineFitter::evaluateSplineDerivative(y, t, deriv, y[k]);
+                    d23[j+xsize*k+xysize*i] = knotDerivative(y, t, deriv, k);
             }
         }
 
@@ -480,13 +488,13 @@ void SplineFitter::create3DSpline(const vector<double>& x, const vector<double>&
 
         t.resize(zsize);
         deriv.resize(zsize);
-        for (int i = 0; i < xsize; i++) {
+        for (int i = threadIndex; i < xsize; i += threads.getNumThreads()) {
             for (int j = 0; j < ysize; j++) {
                 for (int k = 0; k < zsize; k++)
                     t[k] = d1[i+xsize*j+xysize*k];
                 SplineFitter::createSpline(z, t, periodic, deriv);
                 for (int k = 0; k < zsize; k++)
-                    d13[i+xsize*j+xysize*k] = SplineFitter::evaluateSplineDerivative(z, t, deriv, z[k]);
+                    d13[i+xsize*j+xysize*k] = knotDerivative(z, t, deriv, k);
             }
         }
 
@@ -501,7 +509,7 @@ void SplineFitter::create3DSpline(const vector<double>& x, const vector<double>&
                     t[k] = d23[k+xsize*i+xysize*j];
                 SplineFitter::createSpline(x, t, periodic, deriv);
                 for (int k = 0; k < xsize; k++)
-                    d123[k+xsize*i+xysize*j] = SplineFitter::evaluateSplineDerivative(x, t, deriv, x[k]);
+                    d123[k+xsize*i+xysize*j] = knotDerivative(x, t, deriv, k);
             }
         }
     });
@@ -511,95 +519,20 @@ void SplineFitter::create3DSpline(const vector<double>& x, const vector<double>&
     threads.resumeThreads();
     threads.waitForThreads();
 
-    // Now compute the coefficients.  This involves multiplying by a sparse 64x64 matrix, given
-    // here in packed form.
-
-    const int wt[] = {
-        1,0,1,
-        1,8,1,
-        4,0,-3,1,3,8,-2,9,-1,
-        4,0,2,1,-2,8,1,9,1,
-        1,16,1,
-        1,32,1,
-        4,16,-3,17,3,32,-2,33,-1,
-        4,16,2,17,-2,32,1,33,1,
-        4,0,-3,2,3,16,-2,18,-1,
-        4,8,-3,10,3,32,-2,34,-1,
-        16,0,9,1,-9,2,-9,3,9,8,6,9,3,10,-6,11,-3,16,6,17,-6,18,3,19,-3,32,4,33,2,34,2,35,1,
-        16,0,-6,1,6,2,6,3,-6,8,-3,9,-3,10,3,11,3,16,-4,17,4,18,-2,19,2,32,-2,33,-2,34,-1,35,-1,
-        4,0,2,2,-2,16,1,18,1,
-        4,8,2,10,-2,32,1,34,1,
-        16,0,-6,1,6,2,6,3,-6,8,-4,9,-2,10,4,11,2,16,-3,17,3,18,-3,19,3,32,-2,33,-1,34,-2,35,-1,
-        16,0,4,1,-4,2,-4,3,4,8,2,9,2,10,-2,11,-2,16,2,17,-2,18,2,19,-2,32,1,33,1,34,1,35,1,
-        1,24,1,
-        1,40,1,
-        4,24,-3,25,3,40,-2,41,-1,
-        4,24,2,25,-2,40,1,41,1,
-        1,48,1,
-        1,56,1,
-        4,48,-3,49,3,56,-2,57,-1,
-        4,48,2,49,-2,56,1,57,1,
-        4,24,-3,26,3,48,-2,50,-1,
-        4,40,-3,42,3,56,-2,58,-1,
-        16,24,9,25,-9,26,-9,27,9,40,6,41,3,42,-6,43,-3,48,6,49,-6,50,3,51,-3,56,4,57,2,58,2,59,1,
-        16,24,-6,25,6,26,6,27,-6,40,-3,41,-3,42,3,43,3,48,-4,49,4,50,-2,51,2,56,-2,57,-2,58,-1,59,-1,
-        4,24,2,26,-2,48,1,50,1,
-        4,40,2,42,-2,56,1,58,1,
-        16,24,-6,25,6,26,6,27,-6,40,-4,41,-2,42,4,43,2,48,-3,49,3,50,-3,51,3,56,-2,57,-1,58,-2,59,-1,
-        16,24,4,25,-4,26,-4,27,4,40,2,41,2,42,-2,43,-2,48,2,49,-2,50,2,51,-2,56,1,57,1,58,1,59,1,
-        4,0,-3,4,3,24,-2,28,-1,
-        4,8,-3,12,3,40,-2,44,-1,
-        16,0,9,1,-9,4,-9,5,9,8,6,9,3,12,-6,13,-3,24,6,25,-6,28,3,29,-3,40,4,41,2,44,2,45,1,
-        16,0,-6,1,6,4,6,5,-6,8,-3,9,-3,12,3,13,3,24,-4,25,4,28,-2,29,2,40,-2,41,-2,44,-1,45,-1,
-        4,16,-3,20,3,48,-2,52,-1,
-        4,32,-3,36,3,56,-2,60,-1,
-        16,16,9,17,-9,20,-9,21,9,32,6,33,3,36,-6,37,-3,48,6,49,-6,52,3,53,-3,56,4,57,2,60,2,61,1,
-        16,16,-6,17,6,20,6,21,-6,32,-3,33,-3,36,3,37,3,48,-4,49,4,52,-2,53,2,56,-2,57,-2,60,-1,61,-1,
-        16,0,9,2,-9,4,-9,6,9,16,6,18,3,20,-6,22,-3,24,6,26,-6,28,3,30,-3,48,4,50,2,52,2,54,1,
-        16,8,9,10,-9,12,-9,14,9,32,6,34,3,36,-6,38,-3,40,6,42,-6,44,3,46,-3,56,4,58,2,60,2,62,1,
-        64,0,-27,1,27,2,27,3,-27,4,27,5,-27,6,-27,7,27,8,-18,9,-9,10,18,11,9,12,18,13,9,14,-18,15,-9,16,-18,17,18,18,-9,19,9,20,18,21,-18,22,9,23,-9,24,-18,25,18,26,18,27,-18,28,-9,29,9,30,9,31,-9,32,-12,33,-6,34,-6,35,-3,36,12,37,6,38,6,39,3,40,-12,41,-6,42,12,43,6,44,-6,45,-3,46,6,47,3,48,-12,49,12,50,-6,51,6,52,-6,53,6,54,-3,55,3,56,-8,57,-4,58,-4,59,-2,60,-4,61,-2,62,-2,63,-1,
-        64,0,18,1,-18,2,-18,3,18,4,-18,5,18,6,18,7,-18,8,9,9,9,10,-9,11,-9,12,-9,13,-9,14,9,15,9,16,12,17,-12,18,6,19,-6,20,-12,21,12,22,-6,23,6,24,12,25,-12,26,-12,27,12,28,6,29,-6,30,-6,31,6,32,6,33,6,34,3,35,3,36,-6,37,-6,38,-3,39,-3,40,6,41,6,42,-6,43,-6,44,3,45,3,46,-3,47,-3,48,8,49,-8,50,4,51,-4,52,4,53,-4,54,2,55,-2,56,4,57,4,58,2,59,2,60,2,61,2,62,1,63,1,
-        16,0,-6,2,6,4,6,6,-6,16,-3,18,-3,20,3,22,3,24,-4,26,4,28,-2,30,2,48,-2,50,-2,52,-1,54,-1,
-        16,8,-6,10,6,12,6,14,-6,32,-3,34,-3,36,3,38,3,40,-4,42,4,44,-2,46,2,56,-2,58,-2,60,-1,62,-1,
-        64,0,18,1,-18,2,-18,3,18,4,-18,5,18,6,18,7,-18,8,12,9,6,10,-12,11,-6,12,-12,13,-6,14,12,15,6,16,9,17,-9,18,9,19,-9,20,-9,21,9,22,-9,23,9,24,12,25,-12,26,-12,27,12,28,6,29,-6,30,-6,31,6,32,6,33,3,34,6,35,3,36,-6,37,-3,38,-6,39,-3,40,8,41,4,42,-8,43,-4,44,4,45,2,46,-4,47,-2,48,6,49,-6,50,6,51,-6,52,3,53,-3,54,3,55,-3,56,4,57,2,58,4,59,2,60,2,61,1,62,2,63,1,
-        64,0,-12,1,12,2,12,3,-12,4,12,5,-12,6,-12,7,12,8,-6,9,-6,10,6,11,6,12,6,13,6,14,-6,15,-6,16,-6,17,6,18,-6,19,6,20,6,21,-6,22,6,23,-6,24,-8,25,8,26,8,27,-8,28,-4,29,4,30,4,31,-4,32,-3,33,-3,34,-3,35,-3,36,3,37,3,38,3,39,3,40,-4,41,-4,42,4,43,4,44,-2,45,-2,46,2,47,2,48,-4,49,4,50,-4,51,4,52,-2,53,2,54,-2,55,2,56,-2,57,-2,58,-2,59,-2,60,-1,61,-1,62,-1,63,-1,
-        4,0,2,4,-2,24,1,28,1,
-        4,8,2,12,-2,40,1,44,1,
-        16,0,-6,1,6,4,6,5,-6,8,-4,9,-2,12,4,13,2,24,-3,25,3,28,-3,29,3,40,-2,41,-1,44,-2,45,-1,
-        16,0,4,1,-4,4,-4,5,4,8,2,9,2,12,-2,13,-2,24,2,25,-2,28,2,29,-2,40,1,41,1,44,1,45,1,
-        4,16,2,20,-2,48,1,52,1,
-        4,32,2,36,-2,56,1,60,1,
-        16,16,-6,17,6,20,6,21,-6,32,-4,33,-2,36,4,37,2,48,-3,49,3,52,-3,53,3,56,-2,57,-1,60,-2,61,-1,
-        16,16,4,17,-4,20,-4,21,4,32,2,33,2,36,-2,37,-2,48,2,49,-2,52,2,53,-2,56,1,57,1,60,1,61,1,
-        16,0,-6,2,6,4,6,6,-6,16,-4,18,-2,20,4,22,2,24,-3,26,3,28,-3,30,3,48,-2,50,-1,52,-2,54,-1,
-        16,8,-6,10,6,12,6,14,-6,32,-4,34,-2,36,4,38,2,40,-3,42,3,44,-3,46,3,56,-2,58,-1,60,-2,62,-1,
-        64,0,18,1,-18,2,-18,3,18,4,-18,5,18,6,18,7,-18,8,12,9,6,10,-12,11,-6,12,-12,13,-6,14,12,15,6,16,12,17,-12,18,6,19,-6,20,-12,21,12,22,-6,23,6,24,9,25,-9,26,-9,27,9,28,9,29,-9,30,-9,31,9,32,8,33,4,34,4,35,2,36,-8,37,-4,38,-4,39,-2,40,6,41,3,42,-6,43,-3,44,6,45,3,46,-6,47,-3,48,6,49,-6,50,3,51,-3,52,6,53,-6,54,3,55,-3,56,4,57,2,58,2,59,1,60,4,61,2,62,2,63,1,
-        64,0,-12,1,12,2,12,3,-12,4,12,5,-12,6,-12,7,12,8,-6,9,-6,10,6,11,6,12,6,13,6,14,-6,15,-6,16,-8,17,8,18,-4,19,4,20,8,21,-8,22,4,23,-4,24,-6,25,6,26,6,27,-6,28,-6,29,6,30,6,31,-6,32,-4,33,-4,34,-2,35,-2,36,4,37,4,38,2,39,2,40,-3,41,-3,42,3,43,3,44,-3,45,-3,46,3,47,3,48,-4,49,4,50,-2,51,2,52,-4,53,4,54,-2,55,2,56,-2,57,-2,58,-1,59,-1,60,-2,61,-2,62,-1,63,-1,
-        16,0,4,2,-4,4,-4,6,4,16,2,18,2,20,-2,22,-2,24,2,26,-2,28,2,30,-2,48,1,50,1,52,1,54,1,
-        16,8,4,10,-4,12,-4,14,4,32,2,34,2,36,-2,38,-2,40,2,42,-2,44,2,46,-2,56,1,58,1,60,1,62,1,
-        64,0,-12,1,12,2,12,3,-12,4,12,5,-12,6,-12,7,12,8,-8,9,-4,10,8,11,4,12,8,13,4,14,-8,15,-4,16,-6,17,6,18,-6,19,6,20,6,21,-6,22,6,23,-6,24,-6,25,6,26,6,27,-6,28,-6,29,6,30,6,31,-6,32,-4,33,-2,34,-4,35,-2,36,4,37,2,38,4,39,2,40,-4,41,-2,42,4,43,2,44,-4,45,-2,46,4,47,2,48,-3,49,3,50,-3,51,3,52,-3,53,3,54,-3,55,3,56,-2,57,-1,58,-2,59,-1,60,-2,61,-1,62,-2,63,-1,
-        64,0,8,1,-8,2,-8,3,8,4,-8,5,8,6,8,7,-8,8,4,9,4,10,-4,11,-4,12,-4,13,-4,14,4,15,4,16,4,17,-4,18,4,19,-4,20,-4,21,4,22,-4,23,4,24,4,25,-4,26,-4,27,4,28,4,29,-4,30,-4,31,4,32,2,33,2,34,2,35,2,36,-2,37,-2,38,-2,39,-2,40,2,41,2,42,-2,43,-2,44,2,45,2,46,-2,47,-2,48,2,49,-2,50,2,51,-2,52,2,53,-2,54,2,55,-2,56,1,57,1,58,1,59,1,60,1,61,1,62,1,63,1
-    };
-    vector<vector<int> > weight(64);
-    int index = 0;
-    for (int i = 0; i < 64; i++) {
-        int numElements = wt[index++];
-        for (int j = 0; j < numElements; j++) {
-            weight[i].push_back(wt[index++]);
-            weight[i].push_back(wt[index++]);
-        }
-    }
+    // Now compute the coefficients.
+
     c.resize((xsize-1)*(ysize-1)*(zsize-1));
     atomic<int> atomicCounter(0);
     threads.execute([&] (ThreadPool& threads, int threadIndex) {
-        vector<double> rhs(64);
         while (true) {
             int i = atomicCounter++;
             if (i >= xsize-1)
                 break;
             for (int j = 0; j < ysize-1; j++) {
                 for (int k = 0; k < zsize-1; k++) {
-                    // Compute the 64 coefficients for patch (i, j, k).
+                    // Compute the 64 coefficients for patch (i, j, k).  The values and derivatives at the
+                    // corners are arranged as a 4x4x4 array, indexed by (f(0), f(1), f'(0), f'(1)) along
+                    // each axis.
 
                     int nexti = i+1;
                     int nextj = j+1;
@@ -607,33 +540,28 @@ void SplineFitter::create3DSpline(const vector<double>& x, const vector<double>&
                     double deltax = x[nexti]-x[i];
                     double deltay = y[nextj]-y[j];
                     double deltaz = z[nextk]-z[k];
-                    double e[] = {values[i+j*xsize+k*xysize], values[nexti+j*xsize+k*xysize], values[i+nextj*xsize+k*xysize], values[nexti+nextj*xsize+k*xysize], values[i+j*xsize+nextk*xysize], values[nexti+j*xsize+nextk*xysize], values[i+nextj*xsize+nextk*xysize], values[nexti+nextj*xsize+nextk*xysize]};
-                    double e1[] = {d1[i+j*xsize+k*xysize], d1[nexti+j*xsize+k*xysize], d1[i+nextj*xsize+k*xysize], d1[nexti+nextj*xsize+k*xysize], d1[i+j*xsize+nextk*xysize], d1[nexti+j*xsize+nextk*xysize], d1[i+nextj*xsize+nextk*xysize], d1[nexti+nextj*xsize+nextk*xysize]};
-                    double e2[] = {d2[i+j*xsize+k*xysize], d2[nexti+j*xsize+k*xysize], d2[i+nextj*xsize+k*xysize], d2[nexti+nextj*xsize+k*xysize], d2[i+j*xsize+nextk*xysize], d2[nexti+j*xsize+nextk*xysize], d2[i+nextj*xsize+nextk*xysize], d2[nexti+nextj*xsize+nextk*xysize]};
-                    double e3[] = {d3[i+j*xsize+k*xysize], d3[nexti+j*xsize+k*xysize], d3[i+nextj*xsize+k*xysize], d3[nexti+nextj*xsize+k*xysize], d3[i+j*xsize+nextk*xysize], d3[nexti+j*xsize+nextk*xysize], d3[i+nextj*xsize+nextk*xysize], d3[nexti+nextj*xsize+nextk*xysize]};
-                    double e12[] = {d12[i+j*xsize+k*xysize], d12[nexti+j*xsize+k*xysize], d12[i+nextj*xsize+k*xysize], d12[nexti+nextj*xsize+k*xysize], d12[i+j*xsize+nextk*xysize], d12[nexti+j*xsize+nextk*xysize], d12[i+nextj*xsize+nextk*xysize], d12[nexti+nextj*xsize+nextk*xysize]};
-                    double e13[] = {d13[i+j*xsize+k*xysize], d13[nexti+j*xsize+k*xysize], d13[i+nextj*xsize+k*xysize], d13[nexti+nextj*xsize+k*xysize], d13[i+j*xsize+nextk*xysize], d13[nexti+j*xsize+nextk*xysize], d13[i+nextj*xsize+nextk*xysize], d13[nexti+nextj*xsize+nextk*xysize]};
-                    double e23[] = {d23[i+j*xsize+k*xysize], d23[nexti+j*xsize+k*xysize], d23[i+nextj*xsize+k*xysize], d23[nexti+nextj*xsize+k*xysize], d23[i+j*xsize+nextk*xysize], d23[nexti+j*xsize+nextk*xysize], d23[i+nextj*xsize+nextk*xysize], d23[nexti+nextj*xsize+nextk*xysize]};
-                    double e123[] = {d123[i+j*xsize+k*xysize], d123[nexti+j*xsize+k*xysize], d123[i+nextj*xsize+k*xysize], d123[nexti+nextj*xsize+k*xysize], d123[i+j*xsize+nextk*xysize], d123[nexti+j*xsize+nextk*xysize], d123[i+nextj*xsize+nextk*xysize], d123[nexti+nextj*xsize+nextk*xysize]};
+                    double g[64], h[64];
                     for (int m = 0; m < 8; m++) {
-                        rhs[m] = e[m];
-                        rhs[m+8] = e1[m]*deltax;
-                        rhs[m+16] = e2[m]*deltay;
-                        rhs[m+24] = e3[m]*deltaz;
-                        rhs[m+32] = e12[m]*deltax*deltay;
-                        rhs[m+40] = e13[m]*deltax*deltaz;
-                        rhs[m+48] = e23[m]*deltay*deltaz;
-                        rhs[m+56] = e123[m]*deltax*deltay*deltaz;
+                        int gx = m%2, gy = (m/2)%2, gz = m/4;
+                        int index = (i+gx)+(j+gy)*xsize+(k+gz)*xysize;
+                        int base = gx+4*gy+16*gz;
+                        g[base] = values[index];
+                        g[base+2] = d1[index]*deltax;
+                        g[base+8] = d2[index]*deltay;
+                        g[base+32] = d3[index]*deltaz;
+                        g[base+10] = d12[index]*deltax*deltay;
+                        g[base+34] = d13[index]*deltax*deltaz;
+                        g[base+40] = d23[index]*deltay*deltaz;
+                        g[base+42] = d123[index]*deltax*deltay*deltaz;
                     }
+                    for (int m = 0; m < 16; m++)
+                        hermiteToPolynomial(&g[4*m], &h[4*m], 1);
+                    for (int m = 0; m < 16; m++)
+                        hermiteToPolynomial(&h[m%4+16*(m/4)], &g[m%4+16*(m/4)], 4);
                     vector<double>& coeff = c[i+j*(xsize-1)+k*(xsize-1)*(ysize-1)];
                     coeff.resize(64);
-                    for (int m = 0; m < 64; m++) {
-                        double sum = 0.0;
-                        int numElements = weight[m].size();
-                        for (int n = 0; n < numElements; n += 2)
-                            sum += weight[m][n+1]*rhs[weight[m][n]];
-                        coeff[m] = sum;
-                    }
+                    for (int m = 0; m < 16; m++)
+                        hermiteToPolynomial(&g[m], &coeff[m], 16);
                 }
             }
         }
@@ -66,6 +66,11 @@ double State::getPotentialEnergy() const {
         throw OpenMMException("Invoked getPotentialEnergy() on a State which does not contain energies.");
     return pe;
 }
+const vector<double>& State::getGroupEnergies() const {
+    if ((types&GroupEnergies) == 0)
+        throw OpenMMException("Invoked getGroupEnergies() on a State which does not contain group energies.");
+    return groupEnergies;
+}
 void State::getPeriodicBoxVectors(Vec3& a, Vec3& b, Vec3& c) const {
     a = periodicBoxVectors[0];
     b = periodicBoxVectors[1];
@@ -132,6 +137,11 @@ void State::setEnergy(double kinetic, double potential) {
     types |= Energy;
 }
 
+void State::setGroupEnergies(const std::vector<double>& energies) {
+    groupEnergies = energies;
+    types |= GroupEnergies;
+}
+
 void State::setPeriodicBoxVectors(const Vec3& a, const Vec3& b, const Vec3& c) {
     periodicBoxVectors[0] = a;
     periodicBoxVectors[1] = b;
@@ -169,6 +179,10 @@ void State::StateBuilder::setEnergy(double ke, double pe) {
     state.setEnergy(ke, pe);
 }
 
+void State::StateBuilder::setGroupEnergies(const std::vector<double>& energies) {
+    state.setGroupEnergies(energies);
+}
+
 void State::StateBuilder::setPeriodicBoxVectors(const Vec3& a, const Vec3& b, const Vec3& c) {
     state.setPeriodicBoxVectors(a, b, c);
 }
@@ -80,6 +80,22 @@ int System::addConstraint(int particle1, int particle2, double distance) {
     return constraints.size()-1;
 }
 
+int System::addParticles(const std::vector<double>& masses) {
+    int first = this->masses.size();
+    this->masses.insert(this->masses.end(), masses.begin(), masses.end());
+    return first;
+}
+
+int System::addConstraints(const std::vector<int>& particle1, const std::vector<int>& particle2, const std::vector<double>& distance) {
+    if (particle2.size() != particle1.size() || distance.size() != particle1.size())
+        throw OpenMMException("addConstraints: All arrays must have the same length");
+    int first = constraints.size();
+    constraints.reserve(constraints.size()+particle1.size());
+    for (int i = 0; i < particle1.size(); i++)
+        constraints.push_back(ConstraintInfo(particle1[i], particle2[i], distance[i]));
+    return first;
+}
+
 void System::getConstraintParameters(int index, int& particle1, int& particle2, double& distance) const {
     ASSERT_VALID_INDEX(index, constraints);
     particle1 = constraints[index].particle1;
@@ -99,6 +115,19 @@ void System::removeConstraint(int index) {
     constraints.erase(constraints.begin()+index);
 }
 
+int System::addMoleculeType(int numParticles, const std::vector<int>& firstParticles) {
+    if (numParticles < 1)
+        throw OpenMMException("addMoleculeType: A molecule must contain at least one particle");
+    moleculeTypes.push_back(MoleculeTypeInfo(numParticles, firstParticles));
+    return moleculeTypes.size()-1;
+}
+
+void System::getMoleculeTypeParameters(int index, int& numParticles, std::vector<int>& firstParticles) const {
+    ASSERT_VALID_INDEX(index, moleculeTypes);
+    numParticles = moleculeTypes[index].numParticles;
+    firstParticles = moleculeTypes[index].firstParticles;
+}
+
 const Force& System::getForce(int index) const {
     ASSERT_VALID_INDEX(index, forces);
     return *forces[index];
@@ -0,0 +1,371 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/SystemReplicator.h"
+#include "openmm/CMAPTorsionForce.h"
+#include "openmm/CMMotionRemover.h"
+#include "openmm/CustomAngleForce.h"
+#include "openmm/CustomBondForce.h"
+#include "openmm/CustomExternalForce.h"
+#include "openmm/CustomNonbondedForce.h"
+#include "openmm/CustomTorsionForce.h"
+#include "openmm/GBSAOBCForce.h"
+#include "openmm/HarmonicAngleForce.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/PeriodicTorsionForce.h"
+#include "openmm/RBTorsionForce.h"
+#include "openmm/VirtualSite.h"
+#include <set>
+
+using namespace OpenMM;
+using namespace std;
+
+static void checkCutoff(double cutoff, double spacing, const string& forceName) {
+    if (cutoff >= spacing)
+        throw OpenMMException("SystemReplicator: The spacing between replicas must be larger than the cutoff distance of "+forceName);
+}
+
+/**
+ * Create a copy of a Force in which every interaction is repeated for each replica.  This returns
+ * NULL if the Force is of a type that cannot be replicated.
+ */
+static Force* replicateForce(const Force& force, int numParticles, int numReplicas, double spacing) {
+    if (dynamic_cast<const CMMotionRemover*>(&force) != NULL)
+        return new CMMotionRemover(dynamic_cast<const CMMotionRemover&>(force));
+    if (dynamic_cast<const HarmonicBondForce*>(&force) != NULL) {
+        HarmonicBondForce* copy = new HarmonicBondForce(dynamic_cast<const HarmonicBondForce&>(force));
+        int numBonds = copy->getNumBonds();
+        for (int r = 1; r < numReplicas; r++) {
+            int offset = r*numParticles;
+            for (int i = 0; i < numBonds; i++) {
+                int p1, p2;
+                double length, k;
+                copy->getBondParameters(i, p1, p2, length, k);
+                copy->addBond(p1+offset, p2+offset, length, k);
+            }
+        }
+        return copy;
+    }
+    if (dynamic_cast<const HarmonicAngleForce*>(&force) != NULL) {
+        HarmonicAngleForce* copy = new HarmonicAngleForce(dynamic_cast<const HarmonicAngleForce&>(force));
+        int numAngles = copy->getNumAngles();
+        for (int r = 1; r < numReplicas; r++) {
+            int offset = r*numParticles;
+            for (int i = 0; i < numAngles; i++) {
+                int p1, p2, p3;
+                double angle, k;
+                copy->getAngleParameters(i, p1, p2, p3, angle, k);
+                copy->addAngle(p1+offset, p2+offset, p3+offset, angle, k);
+            }
+        }
+        return copy;
+    }
+    if (dynamic_cast<const PeriodicTorsionForce*>(&force) != NULL) {
+        PeriodicTorsionForce* copy = new PeriodicTorsionForce(dynamic_cast<const PeriodicTorsionForce&>(force));
+        int numTorsions = copy->getNumTorsions();
+        for (int r = 1; r < numReplicas; r++) {
+            int offset = r*numParticles;
+            for (int i = 0; i < numTorsions; i++) {
+                int p1, p2, p3, p4, periodicity;
+                double phase, k;
+                copy->getTorsionParameters(i, p1, p2, p3, p4, periodicity, phase, k);
+                copy->addTorsion(p1+offset, p2+offset, p3+offset, p4+offset, periodicity, phase, k);
+            }
+        }
+        return copy;
+    }
+    if (dynamic_cast<const RBTorsionForce*>(&force) != NULL) {
+        RBTorsionForce* copy = new RBTorsionForce(dynamic_cast<const RBTorsionForce&>(force));
+        int numTorsions = copy->getNumTorsions();
+        for (int r = 1; r < numReplicas; r++) {
+            int offset = r*numParticles;
+            for (int i = 0; i < numTorsions; i++) {
+                int p1, p2, p3, p4;
+                double c0, c1, c2, c3, c4, c5;
+                copy->getTorsionParameters(i, p1, p2, p3, p4, c0, c1, c2, c3, c4, c5);
+                copy->addTorsion(p1+offset, p2+offset, p3+offset, p4+offset, c0, c1, c2, c3, c4, c5);
+            }
+        }
+        return copy;
+    }
+    if (dynamic_cast<const CMAPTorsionForce*>(&force) != NULL) {
+        CMAPTorsionForce* copy = new CMAPTorsionForce(dynamic_cast<const CMAPTorsionForce&>(force));
+        int numTorsions = copy->getNumTorsions();
+        for (int r = 1; r < numReplicas; r++) {
+            int offset = r*numParticles;
+            for (int i = 0; i < numTorsions; i++) {
+                int map, a1, a2, a3, a4, b1, b2, b3, b4;
+                copy->getTorsionParameters(i, map, a1, a2, a3, a4, b1, b2, b3, b4);
+                copy->addTorsion(map, a1+offset, a2+offset, a3+offset, a4+offset, b1+offset, b2+offset, b3+offset, b4+offset);
+            }
+        }
+        return copy;
+    }
+    if (dynamic_cast<const CustomBondForce*>(&force) != NULL) {
+        CustomBondForce* copy = new CustomBondForce(dynamic_cast<const CustomBondForce&>(force));
+        int numBonds = copy->getNumBonds();
+        vector<double> parameters;
+        for (int r = 1; r < numReplicas; r++) {
+            int offset = r*numParticles;
+            for (int i = 0; i < numBonds; i++) {
+                int p1, p2;
+                copy->getBondParameters(i, p1, p2, parameters);
+                copy->addBond(p1+offset, p2+offset, parameters);
+            }
+        }
+        return copy;
+    }
+    if (dynamic_cast<const CustomAngleForce*>(&force) != NULL) {
+        CustomAngleForce* copy = new CustomAngleForce(dynamic_cast<const CustomAngleForce&>(force));
+        int numAngles = copy->getNumAngles();
+        vector<double> parameters;
+        for (int r = 1; r < numReplicas; r++) {
+            int offset = r*numParticles;
+            for (int i = 0; i < numAngles; i++) {
+                int p1, p2, p3;
+                copy->getAngleParameters(i, p1, p2, p3, parameters);
+                copy->addAngle(p1+offset, p2+offset, p3+offset, parameters);
+            }
+        }
+        return copy;
+    }
+    if (dynamic_cast<const CustomTorsionForce*>(&force) != NULL) {
+        CustomTorsionForce* copy = new CustomTorsionForce(dynamic_cast<const CustomTorsionForce&>(force));
+        int numTorsions = copy->getNumTorsions();
+        vector<double> parameters;
+        for (int r = 1; r < numReplicas; r++) {
+            int offset = r*numParticles;
+            for (int i = 0; i < numTorsions; i++) {
+                int p1, p2, p3, p4;
+                copy->getTorsionParameters(i, p1, p2, p3, p4, parameters);
+                copy->addTorsion(p1+offset, p2+offset, p3+offset, p4+offset, parameters);
+            }
+        }
+        return copy;
+    }
+    if (dynamic_cast<const CustomExternalForce*>(&force) != NULL) {
+        // The positions of later replicas are shifted along the x axis, so an external
+        // potential (which depends on absolute positions) would differ between them.
+
+        throw OpenMMException("SystemReplicator: CustomExternalForce cannot be replicated, because replicas are at different positions");
+    }
+    if (dynamic_cast<const NonbondedForce*>(&force) != NULL) {
+        const NonbondedForce& original = dynamic_cast<const NonbondedForce&>(force);
+        if (original.getNonbondedMethod() != NonbondedForce::CutoffNonPeriodic)
+            throw OpenMMException("SystemReplicator: NonbondedForce must use CutoffNonPeriodic, so that replicas do not interact");
+        checkCutoff(original.getCutoffDistance(), spacing, "NonbondedForce");
+        NonbondedForce* copy = new NonbondedForce(original);
+        int numExceptions = copy->getNumExceptions();
+        int numParticleOffsets = copy->getNumParticleParameterOffsets();
+        int numExceptionOffsets = copy->getNumExceptionParameterOffsets();
+        for (int r = 1; r < numReplicas; r++) {
+            int offset = r*numParticles;
+            for (int i = 0; i < numParticles; i++) {
+                double charge, sigma, epsilon;
+                copy->getParticleParameters(i, charge, sigma, epsilon);
+                copy->addParticle(charge, sigma, epsilon);
+            }
+            for (int i = 0; i < numExceptions; i++) {
+                int p1, p2;
+                double chargeProd, sigma, epsilon;
+                copy->getExceptionParameters(i, p1, p2, chargeProd, sigma, epsilon);
+                copy->addException(p1+offset, p2+offset, chargeProd, sigma, epsilon);
+            }
+            for (int i = 0; i < numParticleOffsets; i++) {
+                string parameter;
+                int particle;
+                double chargeScale, sigmaScale, epsilonScale;
+                copy->getParticleParameterOffset(i, parameter, particle, chargeScale, sigmaScale, epsilonScale);
+                copy->addParticleParameterOffset(parameter, particle+offset, chargeScale, sigmaScale, epsilonScale);
+            }
+            for (int i = 0; i < numExceptionOffsets; i++) {
+                string parameter;
+                int exception;
+                double chargeProdScale, sigmaScale, epsilonScale;
+                copy->getExceptionParameterOffset(i, parameter, exception, chargeProdScale, sigmaScale, epsilonScale);
+                copy->addExceptionParameterOffset(parameter, exception+r*numExceptions, chargeProdScale, sigmaScale, epsilonScale);
+            }
+        }
+        return copy;
+    }
+    if (dynamic_cast<const GBSAOBCForce*>(&force) != NULL) {
+        const GBSAOBCForce& original = dynamic_cast<const GBSAOBCForce&>(force);
+        if (original.getNonbondedMethod() != GBSAOBCForce::CutoffNonPeriodic)
+            throw OpenMMException("SystemReplicator: GBSAOBCForce must use CutoffNonPeriodic, so that replicas do not interact");
+        checkCutoff(original.getCutoffDistance(), spacing, "GBSAOBCForce");
+        GBSAOBCForce* copy = new GBSAOBCForce(original);
+        for (int r = 1; r < numReplicas; r++) {
+            for (int i = 0; i < numParticles; i++) {
+                double charge, radius, scalingFactor;
+                copy->getParticleParameters(i, charge, radius, scalingFactor);
+                copy->addParticle(charge, radius, scalingFactor);
+            }
+        }
+        return copy;
+    }
+    if (dynamic_cast<const CustomNonbondedForce*>(&force) != NULL) {
+        const CustomNonbondedForce& original = dynamic_cast<const CustomNonbondedForce&>(force);
+        if (original.getNonbondedMethod() != CustomNonbondedForce::CutoffNonPeriodic)
+            throw OpenMMException("SystemReplicator: CustomNonbondedForce must use CutoffNonPeriodic, so that replicas do not interact");
+        checkCutoff(original.getCutoffDistance(), spacing, "CustomNonbondedForce");
+        CustomNonbondedForce* copy = new CustomNonbondedForce(original);
+        int numExclusions = copy->getNumExclusions();
+        int numGroups = copy->getNumInteractionGroups();
+        vector<double> parameters;
+        for (int r = 1; r < numReplicas; r++) {
+            int offset = r*numParticles;
+            for (int i = 0; i < numParticles; i++) {
+                copy->getParticleParameters(i, parameters);
+                copy->addParticle(parameters);
+            }
+            for (int i = 0; i < numExclusions; i++) {
+                int p1, p2;
+                copy->getExclusionParticles(i, p1, p2);
+                copy->addExclusion(p1+offset, p2+offset);
+            }
+            for (int i = 0; i < numGroups; i++) {
+                set<int> set1, set2, newSet1, newSet2;
+                copy->getInteractionGroupParameters(i, set1, set2);
+                for (int p : set1)
+                    newSet1.insert(p+offset);
+                for (int p : set2)
+                    newSet2.insert(p+offset);
+                copy->addInteractionGroup(newSet1, newSet2);
+            }
+        }
+        return copy;
+    }
+    return NULL;
+}
+
+System* SystemReplicator::createSystem(const System& system, int numReplicas, double spacing) {
+    if (numReplicas < 1)
+        throw OpenMMException("SystemReplicator: The number of replicas must be positive");
+    if (spacing <= 0)
+        throw OpenMMException("SystemReplicator: The spacing between replicas must be positive");
+    int numParticles = system.getNumParticles();
+    System* replicated = new System();
+    try {
+        Vec3 a, b, c;
+        system.getDefaultPeriodicBoxVectors(a, b, c);
+        replicated->setDefaultPeriodicBoxVectors(a, b, c);
+        for (int r = 0; r < numReplicas; r++)
+            for (int i = 0; i < numParticles; i++)
+                replicated->addParticle(system.getParticleMass(i));
+        for (int r = 0; r < numReplicas; r++) {
+            int offset = r*numParticles;
+            for (int i = 0; i < system.getNumConstraints(); i++) {
+                int p1, p2;
+                double distance;
+                system.getConstraintParameters(i, p1, p2, distance);
+                replicated->addConstraint(p1+offset, p2+offset, distance);
+            }
+            for (int i = 0; i < numParticles; i++) {
+                if (!system.isVirtualSite(i))
+                    continue;
+                const VirtualSite& site = system.getVirtualSite(i);
+                VirtualSite* newSite;
+                if (dynamic_cast<const TwoParticleAverageSite*>(&site) != NULL) {
+                    const TwoParticleAverageSite& s = dynamic_cast<const TwoParticleAverageSite&>(site);
+                    newSite = new TwoParticleAverageSite(s.getParticle(0)+offset, s.getParticle(1)+offset, s.getWeight(0), s.getWeight(1));
+                }
+                else if (dynamic_cast<const ThreeParticleAverageSite*>(&site) != NULL) {
+                    const ThreeParticleAverageSite& s = dynamic_cast<const ThreeParticleAverageSite&>(site);
+                    newSite = new ThreeParticleAverageSite(s.getParticle(0)+offset, s.getParticle(1)+offset, s.getParticle(2)+offset, s.getWeight(0), s.getWeight(1), s.getWeight(2));
+                }
+                else if (dynamic_cast<const OutOfPlaneSite*>(&site) != NULL) {
+                    const OutOfPlaneSite& s = dynamic_cast<const OutOfPlaneSite&>(site);
+                    newSite = new OutOfPlaneSite(s.getParticle(0)+offset, s.getParticle(1)+offset, s.getParticle(2)+offset, s.getWeight12(), s.getWeight13(), s.getWeightCross());
+                }
+                else if (dynamic_cast<const LocalCoordinatesSite*>(&site) != NULL) {
+                    const LocalCoordinatesSite& s = dynamic_cast<const LocalCoordinatesSite&>(site);
+                    vector<int> particles(s.getNumParticles());
+                    for (int j = 0; j < (int) particles.size(); j++)
+                        particles[j] = s.getParticle(j)+offset;
+                    vector<double> originWeights, xWeights, yWeights;
+                    s.getOriginWeights(originWeights);
+                    s.getXWeights(xWeights);
+                    s.getYWeights(yWeights);
+                    newSite = new LocalCoordinatesSite(particles, originWeights, xWeights, yWeights, s.getLocalPosition());
+                }
+                else
+                    throw OpenMMException("SystemReplicator: Unsupported virtual site type");
+                replicated->setVirtualSite(i+offset, newSite);
+            }
+        }
+        for (int i = 0; i < system.getNumForces(); i++) {
+            Force* force = replicateForce(system.getForce(i), numParticles, numReplicas, spacing);
+            if (force == NULL)
+                throw OpenMMException("SystemReplicator: Unsupported Force type: "+system.getForce(i).getName());
+            if (force->usesPeriodicBoundaryConditions()) {
+                delete force;
+                throw OpenMMException("SystemReplicator: Forces that use periodic boundary conditions cannot be replicated");
+            }
+            replicated->addForce(force);
+        }
+    }
+    catch (...) {
+        delete replicated;
+        throw;
+    }
+    return replicated;
+}
+
+vector<Vec3> SystemReplicator::combinePositions(const vector<vector<Vec3> >& positions, double spacing) {
+    vector<Vec3> combined;
+    for (int r = 0; r < (int) positions.size(); r++) {
+        if (positions[r].size() != positions[0].size())
+            throw OpenMMException("SystemReplicator: All replicas must have the same number of particles");
+        for (const Vec3& pos : positions[r])
+            combined.push_back(pos+Vec3(r*spacing, 0, 0));
+    }
+    return combined;
+}
+
+vector<vector<Vec3> > SystemReplicator::splitValues(const vector<Vec3>& values, int numReplicas) {
+    if (numReplicas < 1 || values.size()%numReplicas != 0)
+        throw OpenMMException("SystemReplicator: The number of values is not a multiple of the number of replicas");
+    int numParticles = values.size()/numReplicas;
+    vector<vector<Vec3> > split(numReplicas);
+    for (int r = 0; r < numReplicas; r++)
+        split[r].assign(values.begin()+r*numParticles, values.begin()+(r+1)*numParticles);
+    return split;
+}
+
+vector<vector<Vec3> > SystemReplicator::splitPositions(const vector<Vec3>& positions, int numReplicas, double spacing) {
+    vector<vector<Vec3> > split = splitValues(positions, numReplicas);
+    for (int r = 0; r < numReplicas; r++)
+        for (Vec3& pos : split[r])
+            pos -= Vec3(r*spacing, 0, 0);
+    return split;
+}
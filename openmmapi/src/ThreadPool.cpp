@@ -31,6 +31,13 @@
 
 #include "openmm/internal/ThreadPool.h"
 #include "openmm/internal/hardware.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#ifdef __linux__
+    #include <pthread.h>
+    #include <sched.h>
+#endif
 
 using namespace std;
 
@@ -38,7 +45,7 @@ namespace OpenMM {
 
 class ThreadPool::ThreadData {
 public:
-    ThreadData(ThreadPool& owner, int index) : owner(owner), index(index), isDeleted(false) {
+    ThreadData(ThreadPool& owner, int index) : owner(owner), index(index), isDeleted(false), isTiming(false), busyTime(0.0) {
     }
     void executeTask() {
         if (owner.currentTask != NULL)
@@ -48,13 +55,21 @@ public:
     }
     ThreadPool& owner;
     int index;
-    bool isDeleted;
+    bool isDeleted, isTiming;
+    double busyTime;
+    chrono::steady_clock::time_point segmentStart;
     Task* currentTask;
     function<void (ThreadPool& pool, int)> currentFunction;
 };
 
+/**
+ * The ThreadData for the worker thread that is currently running, or NULL if it is not a worker thread.
+ */
+static thread_local ThreadPool::ThreadData* currentThreadData = NULL;
+
 static void* threadBody(void* args) {
     ThreadPool::ThreadData& data = *reinterpret_cast<ThreadPool::ThreadData*>(args);
+    currentThreadData = &data;
     while (true) {
         // Wait for the signal to start running.
 
@@ -67,7 +82,7 @@ static void* threadBody(void* args) {
     return 0;
 }
 
-ThreadPool::ThreadPool(int numThreads) : currentTask(NULL) {
+ThreadPool::ThreadPool(int numThreads) : currentTask(NULL), spinWaitTime(0), generation(0), recordThreadTimes(false) {
     if (numThreads <= 0)
         numThreads = getNumProcessors();
     this->numThreads = numThreads;
@@ -86,9 +101,7 @@ ThreadPool::ThreadPool(int numThreads) : currentTask(NULL) {
 ThreadPool::~ThreadPool() {
     for (auto data : threadData)
         data->isDeleted = true;
-    lock.lock();
-    startCondition.notify_all();
-    lock.unlock();
+    resumeThreads();
     for (auto &t : threads)
         t.join();
 }
@@ -97,6 +110,65 @@ int ThreadPool::getNumThreads() const {
     return numThreads;
 }
 
+void ThreadPool::setSpinWaitTime(int microseconds) {
+    spinWaitTime = max(0, microseconds);
+}
+
+int ThreadPool::getSpinWaitTime() const {
+    return spinWaitTime;
+}
+
+void ThreadPool::setRecordThreadTimes(bool record) {
+    recordThreadTimes = record;
+}
+
+vector<double> ThreadPool::getThreadTimes() const {
+    vector<double> times(numThreads);
+    for (int i = 0; i < numThreads; i++)
+        times[i] = threadData[i]->busyTime;
+    return times;
+}
+
+bool ThreadPool::spinUntil(const function<bool ()>& condition) const {
+    if (spinWaitTime == 0)
+        return false;
+    auto endTime = chrono::steady_clock::now()+chrono::microseconds(spinWaitTime);
+    while (true) {
+        for (int i = 0; i < 100; i++)
+            if (condition())
+                return true;
+        if (chrono::steady_clock::now() > endTime)
+            return false;
+        this_thread::yield();
+    }
+}
+
+bool ThreadPool::setThreadAffinity(const vector<int>& cores) {
+    if (cores.size() == 0)
+        return false;
+    bool success = true;
+    for (int i = 0; i < numThreads; i++) {
+        int core = cores[i%cores.size()];
+#if defined(__linux__)
+        if (core < 0 || core >= CPU_SETSIZE)
+            return false;
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(core, &cpuset);
+        if (pthread_setaffinity_np(threads[i].native_handle(), sizeof(cpuset), &cpuset) != 0)
+            success = false;
+#elif defined(WIN32)
+        if (core < 0 || core >= 8*sizeof(DWORD_PTR))
+            return false;
+        if (SetThreadAffinityMask(threads[i].native_handle(), ((DWORD_PTR) 1)<<core) == 0)
+            success = false;
+#else
+        success = false;
+#endif
+    }
+    return success;
+}
+
 void ThreadPool::execute(Task& task) {
     currentTask = &task;
     resumeThreads();
@@ -108,14 +180,106 @@ void ThreadPool::execute(function<void (ThreadPool&, int)> task) {
     resumeThreads();
 }
 
+/**
+ * The items that remain to be processed by one thread in parallelFor().  The bounds are only
+ * modified while holding the lock, but they may be read without it to pick a thread to steal from.
+ */
+struct ThreadPool::WorkRange {
+    mutex lock;
+    atomic<int> start, end;
+};
+
+void ThreadPool::parallelFor(int numItems, int grainSize, function<void (ThreadPool&, int, int, int)> task) {
+    if (numItems <= 0)
+        return;
+    grainSize = max(1, grainSize);
+    vector<WorkRange> ranges(numThreads);
+    for (int i = 0; i < numThreads; i++) {
+        ranges[i].start = (int) ((i*(long long) numItems)/numThreads);
+        ranges[i].end = (int) (((i+1)*(long long) numItems)/numThreads);
+    }
+    execute([&] (ThreadPool& pool, int threadIndex) {
+        WorkRange& ownRange = ranges[threadIndex];
+        while (true) {
+            // Take the next items from this thread's own range.
+
+            int start, end;
+            {
+                lock_guard<mutex> guard(ownRange.lock);
+                start = ownRange.start;
+                end = min((int) ownRange.end, start+grainSize);
+                if (start < end)
+                    ownRange.start = end;
+            }
+            if (start < end) {
+                task(pool, threadIndex, start, end);
+                continue;
+            }
+
+            // Our own range is empty, so steal half of the largest remaining one.  Items that another
+            // thread has already removed from its range are guaranteed to be processed by that thread,
+            // so once every range is empty we are done.
+
+            int victim = -1, victimSize = 0;
+            for (int i = 0; i < numThreads; i++) {
+                int size = ranges[i].end-ranges[i].start;
+                if (size > victimSize) {
+                    victim = i;
+                    victimSize = size;
+                }
+            }
+            if (victim == -1)
+                break;
+            {
+                lock_guard<mutex> guard(ranges[victim].lock);
+                int size = ranges[victim].end-ranges[victim].start;
+                if (size <= 0)
+                    continue;
+                end = ranges[victim].end;
+                start = end-(size+1)/2;
+                ranges[victim].end = start;
+            }
+            lock_guard<mutex> guard(ownRange.lock);
+            ownRange.start = start;
+            ownRange.end = end;
+        }
+    });
+    waitForThreads();
+}
+
 void ThreadPool::syncThreads() {
-    unique_lock<mutex> ul(lock);
-    waitCount++;
-    endCondition.notify_one();
-    startCondition.wait(ul);
+    // If this thread's work is being timed, the segment it was running ends here.
+
+    ThreadData* data = (currentThreadData != NULL && &currentThreadData->owner == this ? currentThreadData : NULL);
+    if (data != NULL && data->isTiming) {
+        data->busyTime += chrono::duration<double>(chrono::steady_clock::now()-data->segmentStart).count();
+        data->isTiming = false;
+    }
+
+    // Each call to resumeThreads() starts a new generation.  Record the current one, then wait
+    // for it to change.
+
+    int currentGeneration;
+    {
+        unique_lock<mutex> ul(lock);
+        currentGeneration = generation;
+        waitCount++;
+        endCondition.notify_one();
+    }
+    if (!spinUntil([&] () { return generation != currentGeneration; })) {
+        unique_lock<mutex> ul(lock);
+        while (generation == currentGeneration)
+            startCondition.wait(ul);
+    }
+    if (data != NULL && recordThreadTimes) {
+        data->segmentStart = chrono::steady_clock::now();
+        data->isTiming = true;
+    }
 }
 
 void ThreadPool::waitForThreads() {
+    if (spinUntil([&] () { return waitCount >= numThreads; }))
+        return;
     unique_lock<mutex> ul(lock);
     while (waitCount < numThreads)
         endCondition.wait(ul);
@@ -124,6 +288,7 @@ void ThreadPool::waitForThreads() {
 void ThreadPool::resumeThreads() {
     unique_lock<mutex> ul(lock);
     waitCount = 0;
+    generation++;
     startCondition.notify_all();
 }
 
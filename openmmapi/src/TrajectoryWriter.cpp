@@ -0,0 +1,318 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/TrajectoryWriter.h"
+#include "openmm/Integrator.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/System.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * The maximum number of captured frames that may wait to be written.  When this is reached,
+ * writeFrame() blocks until the background thread catches up.
+ */
+static const int MaxPendingFrames = 4;
+
+/**
+ * The size of the buffer used for writing the file.
+ */
+static const int FileBufferSize = 1<<22;
+
+/**
+ * DCD files measure time in AKMA units.  This is the length of one of them in picoseconds.
+ */
+static const double AkmaTimeUnit = 0.04888821;
+
+template <class T>
+static void writeValue(fstream& file, T value) {
+    file.write((char*) &value, sizeof(T));
+}
+
+template <class T>
+static T readValue(fstream& file) {
+    T value;
+    file.read((char*) &value, sizeof(T));
+    return value;
+}
+
+TrajectoryWriter::TrajectoryWriter(Context& context, const string& filename, int interval, bool enforcePeriodicBox,
+            const vector<int>& atomSubset, bool append) : context(context), interval(interval), numFrames(0), numWritten(0),
+            firstStep(0), stepInterval(interval), enforcePeriodicBox(enforcePeriodicBox), finished(false), busy(false), atomSubset(atomSubset) {
+    if (interval <= 0)
+        throw OpenMMException("TrajectoryWriter: The interval must be positive");
+    const System& system = context.getSystem();
+    for (int atom : atomSubset)
+        if (atom < 0 || atom >= system.getNumParticles())
+            throw OpenMMException("TrajectoryWriter: Illegal particle index in atom subset: "+to_string(atom));
+    numAtoms = (atomSubset.size() == 0 ? system.getNumParticles() : atomSubset.size());
+    periodic = system.usesPeriodicBoundaryConditions();
+    timeStep = (float) (context.getIntegrator().getStepSize()/AkmaTimeUnit);
+    buffer.resize(3*(numAtoms+2));
+    fileBuffer.resize(FileBufferSize);
+    file.rdbuf()->pubsetbuf(fileBuffer.data(), fileBuffer.size());
+    if (append) {
+        file.open(filename, ios::in | ios::out | ios::binary);
+        if (!file.is_open())
+            throw OpenMMException("TrajectoryWriter: Failed to open file: "+filename);
+        char magic[4];
+        int headerSize = readValue<int>(file);
+        file.read(magic, 4);
+        if (!file || headerSize != 84 || strncmp(magic, "CORD", 4) != 0)
+            throw OpenMMException("TrajectoryWriter: Cannot append to file with invalid DCD header");
+        numWritten = readValue<int>(file);
+        firstStep = readValue<int>(file);
+        stepInterval = readValue<int>(file);
+        file.seekg(44, ios::beg);
+        timeStep = readValue<float>(file);
+        file.seekg(92, ios::beg);
+        int commentsBytes = readValue<int>(file);
+        file.seekg(104+commentsBytes, ios::beg);
+        int fileAtoms = readValue<int>(file);
+        if (!file)
+            throw OpenMMException("TrajectoryWriter: Cannot append to file with invalid DCD header");
+        if (fileAtoms != numAtoms)
+            throw OpenMMException("TrajectoryWriter: Cannot append "+to_string(numAtoms)+" atoms to DCD file with "+to_string(fileAtoms)+" atoms");
+        numFrames = numWritten;
+        file.seekp(0, ios::end);
+    }
+    else {
+        file.open(filename, ios::in | ios::out | ios::binary | ios::trunc);
+        if (!file.is_open())
+            throw OpenMMException("TrajectoryWriter: Failed to open file: "+filename);
+        writeHeader();
+        file.flush();
+        if (!file)
+            throw OpenMMException("TrajectoryWriter: Error writing to file: "+filename);
+    }
+    thread = std::thread(&TrajectoryWriter::threadBody, this);
+}
+
+TrajectoryWriter::~TrajectoryWriter() {
+    {
+        lock_guard<mutex> guard(lock);
+        finished = true;
+    }
+    condition.notify_all();
+    thread.join();
+    file.close();
+}
+
+void TrajectoryWriter::step(int steps) {
+    checkError();
+    Integrator& integrator = context.getIntegrator();
+    while (steps > 0) {
+        int stepsToFrame = interval-(int) (context.getStepCount()%interval);
+        int stepsToTake = min(steps, stepsToFrame);
+        integrator.step(stepsToTake);
+        steps -= stepsToTake;
+        if (context.getStepCount()%interval == 0)
+            writeFrame();
+    }
+}
+
+void TrajectoryWriter::writeFrame() {
+    checkError();
+    {
+        unique_lock<mutex> guard(lock);
+        condition.wait(guard, [&] {return pending.size() < MaxPendingFrames;});
+    }
+    future<State> state = context.getStateAsync(State::Positions, enforcePeriodicBox);
+    {
+        lock_guard<mutex> guard(lock);
+        pending.push_back(move(state));
+        numFrames++;
+    }
+    condition.notify_all();
+}
+
+void TrajectoryWriter::flush() {
+    {
+        unique_lock<mutex> guard(lock);
+        condition.wait(guard, [&] {return pending.empty() && !busy;});
+    }
+    checkError();
+}
+
+void TrajectoryWriter::checkError() {
+    string message;
+    {
+        lock_guard<mutex> guard(lock);
+        message.swap(error);
+    }
+    if (message.size() > 0)
+        throw OpenMMException(message);
+}
+
+void TrajectoryWriter::threadBody() {
+    while (true) {
+        future<State> next;
+        bool failed;
+        {
+            unique_lock<mutex> guard(lock);
+            condition.wait(guard, [&] {return finished || !pending.empty();});
+            if (pending.empty())
+                return;
+            next = move(pending.front());
+            pending.pop_front();
+            busy = true;
+            failed = (error.size() > 0);
+        }
+        condition.notify_all();
+        string message;
+        try {
+            // Once an error has happened, frames are still retrieved so the Context is not left
+            // with outstanding transfers, but they are not written.
+
+            State state = next.get();
+            if (!failed) {
+                writeState(state);
+                bool morePending;
+                {
+                    lock_guard<mutex> guard(lock);
+                    morePending = !pending.empty();
+                }
+                if (!morePending)
+                    updateHeader();
+            }
+        }
+        catch (exception& ex) {
+            message = ex.what();
+        }
+        {
+            lock_guard<mutex> guard(lock);
+            busy = false;
+            if (error.size() == 0)
+                error = message;
+        }
+        condition.notify_all();
+    }
+}
+
+void TrajectoryWriter::writeHeader() {
+    // This is the CHARMM version of the header, identical to the one written by DCDFile.
+
+    file.seekp(0, ios::beg);
+    writeValue<int>(file, 84);
+    file.write("CORD", 4);
+    int values[] = {numWritten, firstStep, stepInterval, firstStep+max(numWritten-1, 0)*stepInterval, 0, 0, 0, 0, 0};
+    for (int value : values)
+        writeValue<int>(file, value);
+    writeValue<float>(file, timeStep);
+    int values2[] = {periodic ? 1 : 0, 0, 0, 0, 0, 0, 0, 0, 0, 24, 84, 164, 2};
+    for (int value : values2)
+        writeValue<int>(file, value);
+    char title[80];
+    memset(title, 0, sizeof(title));
+    strncpy(title, "Created by OpenMM", sizeof(title));
+    file.write(title, sizeof(title));
+    time_t currentTime = time(NULL);
+    string created = "Created "+string(asctime(localtime(&currentTime)));
+    if (created.back() == '\n')
+        created.pop_back();
+    memset(title, 0, sizeof(title));
+    created.copy(title, sizeof(title)-1);
+    file.write(title, sizeof(title));
+    int values3[] = {164, 4, numAtoms, 4};
+    for (int value : values3)
+        writeValue<int>(file, value);
+}
+
+void TrajectoryWriter::updateHeader() {
+    // Record the number of frames and the last step, then flush everything to disk.
+
+    file.seekp(8, ios::beg);
+    int values[] = {numWritten, firstStep, stepInterval, firstStep+(numWritten-1)*stepInterval};
+    for (int value : values)
+        writeValue<int>(file, value);
+    file.seekp(0, ios::end);
+    file.flush();
+    if (!file)
+        throw OpenMMException("TrajectoryWriter: Error writing to file");
+}
+
+void TrajectoryWriter::writeState(const State& state) {
+    const vector<Vec3>& positions = state.getPositions();
+    for (int i = 0; i < numAtoms; i++) {
+        const Vec3& pos = positions[atomSubset.size() == 0 ? i : atomSubset[i]];
+        for (int j = 0; j < 3; j++) {
+            if (isnan(pos[j]))
+                throw OpenMMException("Particle position is NaN.  For more information, see https://github.com/openmm/openmm/wiki/Frequently-Asked-Questions#nan");
+            if (isinf(pos[j]))
+                throw OpenMMException("Particle position is infinite.  For more information, see https://github.com/openmm/openmm/wiki/Frequently-Asked-Questions#nan");
+        }
+    }
+    if (numWritten == 0)
+        firstStep = (int) state.getStepCount();
+    numWritten++;
+    if (stepInterval > 1 && firstStep+(long long) numWritten*stepInterval > (1LL<<31)) {
+        // This would exceed the range of a 32 bit integer.  To avoid producing a corrupt file, say
+        // the trajectory consisted of a smaller number of larger steps (so the total length remains
+        // correct), just as DCDFile does.
+
+        firstStep /= stepInterval;
+        timeStep *= stepInterval;
+        stepInterval = 1;
+        file.seekp(0, ios::beg);
+        writeHeader();
+        file.seekp(0, ios::end);
+    }
+    if (periodic) {
+        // Write the unit cell as lengths in Angstroms and the cosines of the angles between the box vectors.
+
+        Vec3 a, b, c;
+        state.getPeriodicBoxVectors(a, b, c);
+        double aLength = sqrt(a.dot(a)), bLength = sqrt(b.dot(b)), cLength = sqrt(c.dot(c));
+        double cell[] = {10*aLength, a.dot(b)/(aLength*bLength), 10*bLength, a.dot(c)/(aLength*cLength), b.dot(c)/(bLength*cLength), 10*cLength};
+        writeValue<int>(file, 48);
+        file.write((char*) cell, sizeof(cell));
+        writeValue<int>(file, 48);
+    }
+
+    // Write the x, y, and z coordinates as three records, each surrounded by its length.
+
+    int length = 4*numAtoms;
+    for (int j = 0; j < 3; j++) {
+        float* record = &buffer[j*(numAtoms+2)];
+        memcpy(&record[0], &length, 4);
+        for (int i = 0; i < numAtoms; i++)
+            record[i+1] = (float) (10*positions[atomSubset.size() == 0 ? i : atomSubset[i]][j]);
+        memcpy(&record[numAtoms+1], &length, 4);
+    }
+    file.write((char*) buffer.data(), buffer.size()*sizeof(float));
+    if (!file)
+        throw OpenMMException("TrajectoryWriter: Error writing to file");
+}
@@ -107,6 +107,8 @@ void VariableLangevinIntegrator::step(int steps) {
         context->calcForcesAndEnergy(true, false, getIntegrationForceGroups());
         setStepSize(kernel.getAs<IntegrateVariableLangevinStepKernel>().execute(*context, *this, std::numeric_limits<double>::infinity()));
     }
+    if (steps > 0)
+        setStepSize(kernel.getAs<IntegrateVariableLangevinStepKernel>().getLastStepSize(*context, getStepSize()));
 }
 
 void VariableLangevinIntegrator::stepTo(double time) {
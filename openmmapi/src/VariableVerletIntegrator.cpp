@@ -89,6 +89,8 @@ void VariableVerletIntegrator::step(int steps) {
         context->calcForcesAndEnergy(true, false, getIntegrationForceGroups());
         setStepSize(kernel.getAs<IntegrateVariableVerletStepKernel>().execute(*context, *this, std::numeric_limits<double>::infinity()));
     }
+    if (steps > 0)
+        setStepSize(kernel.getAs<IntegrateVariableVerletStepKernel>().getLastStepSize(*context, getStepSize()));
 }
 
 void VariableVerletIntegrator::stepTo(double time) {
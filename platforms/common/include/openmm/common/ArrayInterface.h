@@ -9,7 +9,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2019-2022 Stanford University and the Authors.      *
+ * Portions copyright (c) 2019-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -63,6 +63,23 @@ public:
     void initialize(ComputeContext& context, size_t size, const std::string& name) {
         initialize(context, size, sizeof(T), name);
     }
+    /**
+     * Initialize this array so it refers to the same device memory as another array holding
+     * read-only data.  If the contents of this array are later modified by uploading new values
+     * or resizing it, it first receives its own copy of the memory, so the source array is never
+     * affected.  Kernels must not write to an array initialized this way.
+     *
+     * Not every platform can share memory.  The default implementation allocates new memory and
+     * copies the contents of the source array to it.
+     *
+     * @param context           the context for which to create the array
+     * @param source            the array whose memory should be shared
+     * @param name              the name of the array
+     */
+    virtual void initializeShared(ComputeContext& context, ArrayInterface& source, const std::string& name) {
+        initialize(context, source.getSize(), source.getElementSize(), name);
+        source.copyTo(*this);
+    }
     /**
      * Recreate the internal storage to have a different size.
      */
@@ -160,12 +177,29 @@ public:
      *                 in page-locked memory.
      */
     virtual void download(void* data, bool blocking=true) const = 0;
+    /**
+     * Copy a subset of the values in the array to host memory.
+     * 
+     * @param data     the destination to copy the values to
+     * @param offset   the index of the element within the array at which the copy should begin
+     * @param elements the number of elements to copy
+     * @param blocking if true, this call will block until the transfer is complete.  Subclasses often
+     *                 have restrictions on non-blocking copies, such as that the destination must be
+     *                 in page-locked memory.
+     */
+    virtual void downloadSubArray(void* data, int offset, int elements, bool blocking=true) const = 0;
     /**
      * Copy the values in this array to a second array.
      * 
      * @param dest     the destination array to copy to
      */
     virtual void copyTo(ArrayInterface& dest) const = 0;
+    /**
+     * Get the platform-specific handle for the device memory.  This is a CUdeviceptr on CUDA,
+     * a hipDeviceptr_t on HIP, or a cl_mem on OpenCL, cast to a void*.  It allows code that
+     * is not part of OpenMM, such as external libraries, to read or modify the array in place.
+     */
+    virtual void* getNativeHandle() = 0;
 };
 
 } // namespace OpenMM
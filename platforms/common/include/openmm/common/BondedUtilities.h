@@ -30,6 +30,7 @@
 #include "openmm/common/ComputeArray.h"
 #include "openmm/common/ComputeKernel.h"
 #include "openmm/System.h"
+#include <map>
 #include <string>
 #include <vector>
 
@@ -128,12 +129,17 @@ public:
      * Compute the bonded interactions.
      * 
      * @param groups        a set of bit flags for which force groups to include
+     * @param includeForces whether to compute forces.  If this is false, a separate version of the
+     *                      kernel is used that only computes energy, and never writes to the force buffer.
      */
-    void computeInteractions(int groups);
+    void computeInteractions(int groups, bool includeForces=true);
 private:
     std::string createForceSource(int forceIndex, int numBonds, int numAtoms, int group, const std::string& computeForce);
+    void addKernelArgs(ComputeKernel& kernel);
     ComputeContext& context;
-    ComputeKernel kernel;
+    ComputeKernel kernel, energyKernel;
+    std::string kernelSource;
+    std::map<std::string, std::string> kernelDefines;
     std::vector<std::vector<std::vector<int> > > forceAtoms;
     std::vector<std::vector<int> > indexWidth;
     std::vector<std::string> forceSource;
@@ -141,10 +147,11 @@ private:
     std::vector<ArrayInterface*> arguments;
     std::vector<std::string> argTypes;
     std::vector<std::vector<ComputeArray> > atomIndices;
+    std::vector<ComputeArray> bondOrder;
     std::vector<std::string> prefixCode;
     std::vector<std::string> energyParameterDerivatives;
     int numForceBuffers, maxBonds, allGroups;
-    bool hasInitializedKernels, hasInteractions;
+    bool hasInitializedKernels, hasInitializedEnergyKernel, hasInteractions;
 };
 
 } // namespace OpenMM
@@ -44,7 +44,8 @@ namespace OpenMM {
 class CommonCalcCustomGBForceKernel : public CalcCustomGBForceKernel {
 public:
     CommonCalcCustomGBForceKernel(std::string name, const Platform& platform, ComputeContext& cc, const System& system) : CalcCustomGBForceKernel(name, platform),
-            hasInitializedKernels(false), cc(cc), params(NULL), computedValues(NULL), energyDerivs(NULL), energyDerivChain(NULL), system(system) {
+            hasInitializedKernels(false), useSpecializedKernels(false), stableSteps(0), specializationThreshold(InitialSpecializationThreshold), cc(cc),
+            params(NULL), computedValues(NULL), energyDerivs(NULL), energyDerivChain(NULL), system(system) {
     }
     ~CommonCalcCustomGBForceKernel();
     /**
@@ -72,9 +73,13 @@ public:
     void copyParametersToContext(ContextImpl& context, const CustomGBForce& force);
 private:
     class ForceInfo;
+    ComputeKernel createPairValueKernel(const std::string& source);
+    ComputeKernel createPairEnergyKernel(const std::string& source);
+    std::string specializeGlobals(const std::string& source);
+    void updateKernelSpecialization(ContextImpl& context);
     double cutoff;
-    bool hasInitializedKernels, needGlobalParams, needParameterGradient, needEnergyParamDerivs;
-    int maxTiles, numComputedValues;
+    bool hasInitializedKernels, needGlobalParams, needParameterGradient, needEnergyParamDerivs, hasPairEnergyTerms, useSpecializedKernels;
+    int maxTiles, numComputedValues, stableSteps, specializationThreshold;
     ComputeContext& cc;
     ForceInfo* info;
     ComputeParameterSet* params;
@@ -86,11 +91,16 @@ private:
     ComputeArray longEnergyDerivs, valueBuffers;
     std::vector<ComputeArray> tabulatedFunctionArrays;
     std::map<std::string, int> tabulatedFunctionUpdateCount;
+    std::vector<std::vector<float> > tabulatedFunctionValues;
     std::vector<bool> pairValueUsesParam, pairEnergyUsesParam, pairEnergyUsesValue;
     const System& system;
     ComputeKernel pairValueKernel, perParticleValueKernel, pairEnergyKernel, perParticleEnergyKernel, gradientChainRuleKernel;
+    ComputeKernel genericPairValueKernel, genericPairEnergyKernel, specializedPairValueKernel, specializedPairEnergyKernel;
     std::string pairValueSrc, pairEnergySrc;
     std::map<std::string, std::string> pairValueDefines, pairEnergyDefines;
+    std::vector<std::pair<int, std::string> > globalParams;
+    std::vector<double> globalParamValues;
+    static const int InitialSpecializationThreshold = 1000;
 };
 
 } // namespace OpenMM
@@ -85,6 +85,7 @@ private:
     ComputeArray donorBlockCenter, donorBlockSize, acceptorBlockCenter, acceptorBlockSize;
     std::vector<ComputeArray> tabulatedFunctionArrays;
     std::map<std::string, int> tabulatedFunctionUpdateCount;
+    std::vector<std::vector<float> > tabulatedFunctionValues;
     const System& system;
     ComputeKernel blockBoundsKernel, forceKernel;
 };
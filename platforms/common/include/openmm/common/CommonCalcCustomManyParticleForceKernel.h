@@ -74,19 +74,26 @@ public:
 
 private:
     class ForceInfo;
+    /**
+     * Select the grid of cells used for building the neighbor list.
+     */
+    mm_int4 selectCellGrid();
     ComputeContext& cc;
     ForceInfo* info;
     bool hasInitializedKernel, needGlobalParams;
     NonbondedMethod nonbondedMethod;
-    int maxNeighborPairs, forceWorkgroupSize, findNeighborsWorkgroupSize;
+    int maxNeighbors, maxCells, numCellTypes, forceWorkgroupSize;
+    double cutoff;
     ComputeParameterSet* params;
-    ComputeArray  particleTypes,  orderIndex, particleOrder;
-    ComputeArray exclusions, exclusionStartIndex, blockCenter, blockBoundingBox;
-    ComputeArray neighborPairs, numNeighborPairs, neighborStartIndex, numNeighborsForAtom, neighbors;
+    ComputeArray  particleTypes,  orderIndex, particleOrder, neighborTypeAllowed;
+    ComputeArray exclusions, exclusionStartIndex;
+    ComputeArray atomCell, atomIndexInCell, cellCount, cellStart, sortedAtoms, sortedPos;
+    ComputeArray numOverflows, numNeighborsForAtom, neighbors;
     std::vector<ComputeArray> tabulatedFunctionArrays;
     std::map<std::string, int> tabulatedFunctionUpdateCount;
+    std::vector<std::vector<float> > tabulatedFunctionValues;
     const System& system;
-    ComputeKernel forceKernel, blockBoundsKernel, neighborsKernel, startIndicesKernel, copyPairsKernel;
+    ComputeKernel forceKernel, cellsKernel, cellStartKernel, sortKernel, neighborsKernel;
     ComputeEvent event;
 };
 
@@ -89,6 +89,7 @@ private:
     std::vector<float> globalParamValues;
     std::vector<ComputeArray> tabulatedFunctionArrays;
     std::map<std::string, int> tabulatedFunctionUpdateCount;
+    std::vector<std::vector<float> > tabulatedFunctionValues;
     std::vector<std::string> paramNames, computedValueNames;
     std::vector<ComputeParameterInfo> paramBuffers, computedValueBuffers;
     double longRangeCoefficient;
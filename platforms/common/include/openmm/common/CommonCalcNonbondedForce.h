@@ -47,7 +47,7 @@ namespace OpenMM {
 class CommonCalcNonbondedForceKernel : public CalcNonbondedForceKernel {
 public:
     CommonCalcNonbondedForceKernel(std::string name, const Platform& platform, ComputeContext& cc, const System& system) : CalcNonbondedForceKernel(name, platform),
-            hasInitializedKernel(false), cc(cc), pmeio(NULL) {
+            hasInitializedKernel(false), cc(cc), pmeio(NULL), numPmeTiles(0), numDispersionTiles(0), usePmeFusedConvolution(false) {
     }
     ~CommonCalcNonbondedForceKernel();
     /**
@@ -59,8 +59,11 @@ public:
      * @param deviceIsCpu  whether the device this calculation is running on is a CPU
      * @param useFixedPointChargeSpreading  whether PME charge spreading should be done in fixed point or floating point
      * @param useCpuPme    whether to perform the PME reciprocal space calculation on the CPU
+     * @param allowTiledChargeSpreading  whether the device supports atomic operations on local memory, so PME charge
+     *                                   spreading may accumulate each tile of the grid in local memory
      */
-    void commonInitialize(const System& system, const NonbondedForce& force, bool usePmeQueue, bool deviceIsCpu, bool useFixedPointChargeSpreading, bool useCpuPme);
+    void commonInitialize(const System& system, const NonbondedForce& force, bool usePmeQueue, bool deviceIsCpu, bool useFixedPointChargeSpreading, bool useCpuPme,
+            bool allowTiledChargeSpreading=false);
     /**
      * Execute the kernel to calculate the forces and/or energy.
      *
@@ -143,6 +146,7 @@ private:
     ComputeArray pmeDispersionBsplineModuliZ;
     ComputeArray pmeAtomGridIndex;
     ComputeArray pmeEnergyBuffer;
+    ComputeArray pmeInfluence;
     ComputeArray chargeBuffer;
     ComputeSort sort;
     ComputeQueue pmeQueue;
@@ -156,7 +160,7 @@ private:
     ComputeKernel pmeGridIndexKernel, pmeDispersionGridIndexKernel;
     ComputeKernel pmeSpreadChargeKernel, pmeDispersionSpreadChargeKernel;
     ComputeKernel pmeFinishSpreadChargeKernel, pmeDispersionFinishSpreadChargeKernel;
-    ComputeKernel pmeConvolutionKernel, pmeDispersionConvolutionKernel;
+    ComputeKernel pmeConvolutionKernel, pmeDispersionConvolutionKernel, pmeInfluenceKernel;
     ComputeKernel pmeEvalEnergyKernel, pmeDispersionEvalEnergyKernel;
     ComputeKernel pmeInterpolateForceKernel, pmeDispersionInterpolateForceKernel;
     std::map<std::string, std::string> pmeDefines;
@@ -165,13 +169,16 @@ private:
     std::map<std::string, int> paramIndices;
     std::map<std::string, double> paramValues;
     std::map<int, int> exceptionIndex;
+    Vec3 influenceBoxVectors[3];
     double ewaldSelfEnergy, dispersionCoefficient, alpha, dispersionAlpha, totalCharge;
-    int gridSizeX, gridSizeY, gridSizeZ;
-    int dispersionGridSizeX, dispersionGridSizeY, dispersionGridSizeZ;
-    bool usePmeQueue, deviceIsCpu, useFixedPointChargeSpreading, useCpuPme;
+    int gridSizeX, gridSizeY, gridSizeZ, numForceExceptions;
+    int dispersionGridSizeX, dispersionGridSizeY, dispersionGridSizeZ, numPmeTiles, numDispersionTiles;
+    bool usePmeQueue, deviceIsCpu, useFixedPointChargeSpreading, useCpuPme, usePmeFusedConvolution;
     bool hasCoulomb, hasLJ, doLJPME, usePosqCharges, recomputeParams, hasOffsets;
     NonbondedMethod nonbondedMethod;
     static const int PmeOrder = 5;
+    static const int PmeTileSize = 8;
+    static const int PmeTileThreadBlockSize = 128;
 };
 
 } // namespace OpenMM
@@ -47,7 +47,7 @@ class CommonIntegrateCustomStepKernel : public IntegrateCustomStepKernel {
 public:
     enum GlobalTargetType {DT, VARIABLE, PARAMETER};
     CommonIntegrateCustomStepKernel(std::string name, const Platform& platform, ComputeContext& cc) : IntegrateCustomStepKernel(name, platform), cc(cc),
-            hasInitializedKernels(false), deviceGlobalsAreCurrent(false), needsEnergyParamDerivs(false) {
+            hasInitializedKernels(false), deviceGlobalsAreCurrent(false), localGlobalsAreCurrent(true), needsEnergyParamDerivs(false) {
     }
     /**
      * Initialize the kernel.
@@ -120,12 +120,17 @@ private:
     void findExpressionsForDerivs(const Lepton::ExpressionTreeNode& node, std::vector<std::pair<Lepton::ExpressionTreeNode, std::string> >& variableNodes);
     void recordGlobalValue(double value, GlobalTarget target, CustomIntegrator& integrator);
     void recordChangedParameters(ContextImpl& context);
+    /**
+     * Copy the global values from the device to the host, if any of them have been computed on the device
+     * since the last time they were downloaded.
+     */
+    void downloadGlobalValues();
     bool evaluateCondition(int step);
     ComputeContext& cc;
     double energy;
     float energyFloat;
     int numGlobalVariables, sumWorkGroupSize;
-    bool hasInitializedKernels, deviceGlobalsAreCurrent, modifiesParameters, hasAnyConstraints, needsEnergyParamDerivs;
+    bool hasInitializedKernels, deviceGlobalsAreCurrent, localGlobalsAreCurrent, modifiesParameters, hasAnyConstraints, needsEnergyParamDerivs;
     std::vector<bool> deviceValuesAreCurrent;
     mutable std::vector<bool> localValuesAreCurrent;
     ComputeArray globalValues, sumBuffer, summedValue;
@@ -147,9 +152,9 @@ private:
     std::vector<CustomIntegratorUtilities::Comparison> comparisons;
     std::vector<std::vector<Lepton::CompiledExpression> > globalExpressions;
     CompiledExpressionSet expressionSet;
-    std::vector<bool> needsGlobals, needsForces, needsEnergy;
+    std::vector<bool> needsGlobals, needsForces, needsEnergy, globalOnDevice;
     std::vector<bool> computeBothForceAndEnergy, invalidatesForces, merged;
-    std::vector<int> forceGroupFlags, blockEnd, requiredGaussian, requiredUniform;
+    std::vector<int> forceGroupFlags, blockEnd, requiredGaussian, requiredUniform, mergedSumStep;
     std::vector<int> stepEnergyVariableIndex, globalVariableIndex, parameterVariableIndex;
     int gaussianVariableIndex, uniformVariableIndex, dtVariableIndex;
     std::vector<std::string> parameterNames;
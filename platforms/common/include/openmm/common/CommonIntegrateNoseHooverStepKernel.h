@@ -45,7 +45,8 @@ public:
     CommonIntegrateNoseHooverStepKernel(std::string name, const Platform& platform, ComputeContext& cc) :
                                   IntegrateNoseHooverStepKernel(name, platform), cc(cc), hasInitializedKernels(false),
                                   hasInitializedKineticEnergyKernel(false), hasInitializedHeatBathEnergyKernel(false),
-                                  hasInitializedScaleVelocitiesKernel(false), hasInitializedPropagateKernel(false) {}
+                                  hasInitializedScaleVelocitiesKernel(false), hasInitializedPropagateKernel(false),
+                                  hasInitializedThermostats(false) {}
     ~CommonIntegrateNoseHooverStepKernel() {}
     /**
      * Initialize the kernel.
@@ -128,12 +129,44 @@ public:
      */
     void setChainStates(ContextImpl& context, const std::vector<std::vector<double> >& positions, const std::vector<std::vector<double> >& velocities);
 private:
+    /**
+     * Apply every thermostat in the integrator.  This computes the kinetic energies, propagates the chains,
+     * and scales the velocities for all of them together, using a fixed number of kernel launches.
+     */
+    void applyThermostats(const NoseHooverIntegrator& integrator, double timeStep);
+    /**
+     * Build the arrays describing the particles coupled to each thermostat.
+     */
+    void initializeThermostats(const NoseHooverIntegrator& integrator);
+    /**
+     * Make sure a state of the specified length exists for a chain, creating or resizing it if necessary.
+     */
+    void ensureChainState(int key, int chainLength);
+    /**
+     * Change the layout of the chain states.  States whose lengths do not change are preserved.  Others are
+     * set to zero.
+     *
+     * @param lengths    the length of each chain state, keyed by 2*chainID for the absolute chain or 2*chainID+1
+     *                   for the relative chain
+     */
+    void setChainStateLayout(const std::map<int, int>& lengths);
+    std::vector<mm_double2> downloadChainStates() const;
+    void uploadChainStates(const std::vector<mm_double2>& states);
     ComputeContext& cc;
     float prevMaxPairDistance;
     ComputeArray maxPairDistanceBuffer, pairListBuffer, atomListBuffer, pairTemperatureBuffer, oldDelta;
-    std::map<int, ComputeArray> chainState;
+    ComputeArray chainState;
+    std::map<int, mm_int2> chainStateRange;
+    ComputeArray thermostatAtoms, thermostatAtomChain, thermostatPairs, thermostatPairChain, thermostatBlocks;
+    ComputeArray chainBlocks, chainInfo, chainOffsets, chainTemperatures, chainWeights, chainScaleFactors;
+    ComputeArray partialKineticEnergy, thermostatChainForces;
+    ComputeKernel thermostatEnergyKernel, propagateChainsKernel, scaleThermostatVelocitiesKernel;
+    std::vector<int> thermostatAtomCounts, thermostatPairCounts;
+    std::vector<int> chainInfoVec, chainOffsetsVec;
+    std::vector<double> chainTemperaturesVec, chainWeightsVec;
+    int numThermostatBlocks, numThermostatAtoms, numThermostatPairs;
     ComputeKernel kernel1, kernel2, kernel3, kernel4, kernelHardWall;
-    bool hasInitializedKernels;
+    bool hasInitializedKernels, computeCMMomentum;
     ComputeKernel reduceEnergyKernel;
     ComputeKernel computeHeatBathEnergyKernel;
     ComputeKernel computeAtomsKineticEnergyKernel;
@@ -147,6 +180,7 @@ private:
     bool hasInitializedKineticEnergyKernel;
     bool hasInitializedHeatBathEnergyKernel;
     bool hasInitializedScaleVelocitiesKernel;
+    bool hasInitializedThermostats;
 };
 
 } // namespace OpenMM
@@ -47,8 +47,10 @@ namespace OpenMM {
  */
 class CommonUpdateStateDataKernel : public UpdateStateDataKernel {
 public:
-    CommonUpdateStateDataKernel(std::string name, const Platform& platform, ComputeContext& cc) : UpdateStateDataKernel(name, platform), cc(cc) {
+    CommonUpdateStateDataKernel(std::string name, const Platform& platform, ComputeContext& cc) : UpdateStateDataKernel(name, platform), cc(cc),
+            uploadStaging(NULL), uploadPending(false) {
     }
+    ~CommonUpdateStateDataKernel();
     /**
      * Initialize the kernel.
      *
@@ -85,6 +87,14 @@ public:
      * @param positions  on exit, this contains the particle positions
      */
     void getPositions(ContextImpl& context, std::vector<Vec3>& positions);
+    /**
+     * Get the positions of all particles, rounded to a fixed precision.  The coordinates are rounded and
+     * packed into a compact bit stream on the device, so only the packed data is transferred.
+     *
+     * @param precision  the precision to which coordinates are rounded, in nm
+     * @param positions  on exit, this contains the particle positions
+     */
+    void getQuantizedPositions(ContextImpl& context, double precision, std::vector<Vec3>& positions);
     /**
      * Set the positions of all particles.
      *
@@ -118,12 +128,51 @@ public:
      * @param forces  on exit, this contains the forces
      */
     void getForces(ContextImpl& context, std::vector<Vec3>& forces);
+    /**
+     * Get the positions of a subset of particles.
+     *
+     * @param particles  the indices of the particles to retrieve
+     * @param positions  on exit, element i contains the position of particle particles[i]
+     */
+    void getParticlePositions(ContextImpl& context, const std::vector<int>& particles, std::vector<Vec3>& positions);
+    /**
+     * Get the velocities of a subset of particles.
+     *
+     * @param particles   the indices of the particles to retrieve
+     * @param velocities  on exit, element i contains the velocity of particle particles[i]
+     */
+    void getParticleVelocities(ContextImpl& context, const std::vector<int>& particles, std::vector<Vec3>& velocities);
+    /**
+     * Multiply the velocities of all particles by a constant factor.
+     *
+     * @param scale      the factor to multiply the velocities by
+     */
+    void scaleVelocities(ContextImpl& context, double scale);
+    /**
+     * Get the current forces on a subset of particles.
+     *
+     * @param particles  the indices of the particles to retrieve
+     * @param forces     on exit, element i contains the force on particle particles[i]
+     */
+    void getParticleForces(ContextImpl& context, const std::vector<int>& particles, std::vector<Vec3>& forces);
     /**
      * Get the current derivatives of the energy with respect to context parameters.
      *
      * @param derivs  on exit, this contains the derivatives
      */
     void getEnergyParameterDerivatives(ContextImpl& context, std::map<std::string, double>& derivs);
+    /**
+     * Begin retrieving the current positions, velocities, and/or forces without waiting for the data
+     * to reach the host.  The arrays are copied to staging buffers on the device, then downloaded to
+     * pinned memory on a separate queue, so the next step can begin immediately.
+     *
+     * @param context     the context in which to execute this kernel
+     * @param positions   whether to retrieve the positions
+     * @param velocities  whether to retrieve the velocities
+     * @param forces      whether to retrieve the forces
+     * @return a function which completes the retrieval
+     */
+    StateDataFunction getStateDataAsync(ContextImpl& context, bool positions, bool velocities, bool forces);
     /**
      * Get the current periodic box vectors.
      *
@@ -153,9 +202,22 @@ public:
      */
     void loadCheckpoint(ContextImpl& context, std::istream& stream);
 private:
+    class AsyncTransfer;
+    void setParticleSubset(const std::vector<int>& particles);
+    void uploadCoordinates(const std::vector<Vec3>& values);
     ComputeContext& cc;
-    ComputeArray floatBuffer, doubleBuffer;
-    ComputeKernel copyFloatKernel, copyDoubleKernel;
+    ComputeArray uploadBuffer;
+    ComputeArray particleSlot, gatheredIndex, gatheredPositions, gatheredVelocities, gatheredForces;
+    ComputeKernel setPositionsKernel, setVelocitiesKernel;
+    ComputeEvent uploadEvent;
+    void* uploadStaging;
+    bool uploadPending;
+    ComputeKernel gatherPositionsKernel, gatherVelocitiesKernel, gatherForcesKernel, scaleVelocitiesKernel;
+    ComputeArray quantizedRange, quantizedHeader, packedPositions;
+    ComputeKernel findRangeKernel, combineRangeKernel, packPositionsKernel;
+    std::vector<int> subsetParticles, subsetSlots;
+    ComputeQueue transferQueue;
+    std::vector<std::shared_ptr<AsyncTransfer> > asyncTransfers;
 };
 
 /**
@@ -557,6 +619,7 @@ private:
     ForceInfo* info;
     const System& system;
     std::vector<mm_int2> mapPositionsVec;
+    std::vector<int> torsionOrder;
     ComputeArray coefficients;
     ComputeArray mapPositions;
     ComputeArray torsionMaps;
@@ -647,6 +710,7 @@ private:
     ComputeParameterSet* params;
     std::vector<ComputeArray> tabulatedFunctionArrays;
     std::map<std::string, int> tabulatedFunctionUpdateCount;
+    std::vector<std::vector<float> > tabulatedFunctionValues;
     const System& system;
 };
 
@@ -685,17 +749,18 @@ public:
 
 private:
     class ForceInfo;
-    int numGroups, numBonds;
+    int numGroups, numSegments, numBonds;
     bool needGlobalParams, needEnergyParamDerivs;
     ComputeContext& cc;
     ForceInfo* info;
     ComputeParameterSet* params;
-    ComputeArray groupParticles, groupWeights, groupOffsets;
-    ComputeArray groupForces, bondGroups, centerPositions;
+    ComputeArray groupParticles, groupWeights, segmentOffsets, segmentGroups, groupSegmentOffsets;
+    ComputeArray groupForces, bondGroups, centerPositions, segmentCenters;
     std::vector<ComputeArray> tabulatedFunctionArrays;
     std::map<std::string, int> tabulatedFunctionUpdateCount;
+    std::vector<std::vector<float> > tabulatedFunctionValues;
     std::vector<void*> groupForcesArgs;
-    ComputeKernel computeCentersKernel, groupForcesKernel, applyForcesKernel;
+    ComputeKernel computeCentersKernel, sumSegmentsKernel, groupForcesKernel, applyForcesKernel;
     const System& system;
 };
 
@@ -778,18 +843,18 @@ private:
     ComputeContext& cc;
     ForceInfo* info;
     bool hasInitializedKernels;
-    int numRealParticles, maxNeighborBlocks;
+    int numRealParticles, maxNeighborBlocks, maxBlockNeighbors;
     GayBerneForce::NonbondedMethod nonbondedMethod;
     ComputeArray sortedParticles, axisParticleIndices, sigParams, epsParams;
     ComputeArray scale, exceptionParticles, exceptionParams;
     ComputeArray aMatrix, bMatrix, gMatrix;
     ComputeArray exclusions, exclusionStartIndex, blockCenter, blockBoundingBox;
-    ComputeArray neighbors, neighborIndex, neighborBlockCount;
+    ComputeArray neighbors, neighborIndex, neighborBlockCount, blockNeighbors, blockNeighborCount;
     ComputeArray sortedPos, torque;
     std::vector<bool> isRealParticle;
     std::vector<std::pair<int, int> > exceptionAtoms;
     std::vector<std::pair<int, int> > excludedPairs;
-    ComputeKernel framesKernel, blockBoundsKernel, neighborsKernel, forceKernel, torqueKernel;
+    ComputeKernel framesKernel, blockBoundsKernel, blockNeighborsKernel, neighborsKernel, forceKernel, torqueKernel;
     ComputeEvent event;
 };
 
@@ -851,9 +916,9 @@ private:
     std::vector<ComputeArray> cvForces;
     std::vector<double> globalValues, cvValues;
     std::vector<Lepton::CustomFunction*> tabulatedFunctions;
-    ComputeArray invAtomOrder;
+    std::vector<int> tabulatedFunctionUpdateCount;
     ComputeArray innerInvAtomOrder;
-    ComputeKernel copyStateKernel, copyForcesKernel, addForcesKernel;
+    ComputeKernel copyStateKernel, addForcesKernel;
 };
 
 /**
@@ -887,7 +952,7 @@ public:
     double computeKineticEnergy(ContextImpl& context, const VerletIntegrator& integrator);
 private:
     ComputeContext& cc;
-    bool hasInitializedKernels;
+    bool hasInitializedKernels, computeCMMomentum;
     ComputeKernel kernel1, kernel2;
 };
 
@@ -923,11 +988,83 @@ public:
 private:
     ComputeContext& cc;
     double prevTemp, prevFriction, prevStepSize;
-    bool hasInitializedKernels;
+    bool hasInitializedKernels, computeCMMomentum;
     ComputeArray params, oldDelta;
     ComputeKernel kernel1, kernel2, kernel3;
 };
 
+/**
+ * This kernel is invoked by MTSLangevinIntegrator to take one time step.
+ */
+class CommonIntegrateMTSLangevinStepKernel : public IntegrateMTSLangevinStepKernel {
+public:
+    CommonIntegrateMTSLangevinStepKernel(std::string name, const Platform& platform, ComputeContext& cc) : IntegrateMTSLangevinStepKernel(name, platform), cc(cc),
+            hasInitializedKernels(false) {
+    }
+    /**
+     * Initialize the kernel.
+     * 
+     * @param system     the System this kernel will be applied to
+     * @param integrator the MTSLangevinIntegrator this kernel will be used for
+     */
+    void initialize(const System& system, const MTSLangevinIntegrator& integrator);
+    /**
+     * Update the velocities based on the forces currently stored in the context.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     * @param dt         the time interval to apply the forces over
+     */
+    void kick(ContextImpl& context, const MTSLangevinIntegrator& integrator, double dt);
+    /**
+     * Perform one substep of the innermost (fastest) level.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     * @param kickDt     the time interval to apply the forces over
+     * @param dt         the size of the substep
+     */
+    void innerStep(ContextImpl& context, const MTSLangevinIntegrator& integrator, double kickDt, double dt);
+    /**
+     * Save a copy of the forces currently stored in the context.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     * @param level      the index of the level the forces belong to
+     */
+    void saveForces(ContextImpl& context, const MTSLangevinIntegrator& integrator, int level);
+    /**
+     * Copy forces previously saved with saveForces() back into the context.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     * @param level      the index of the level the forces belong to
+     */
+    void restoreForces(ContextImpl& context, const MTSLangevinIntegrator& integrator, int level);
+    /**
+     * Complete a time step.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     * @return false if atoms were reordered, true otherwise
+     */
+    bool finishStep(ContextImpl& context, const MTSLangevinIntegrator& integrator);
+    /**
+     * Compute the kinetic energy.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     */
+    double computeKineticEnergy(ContextImpl& context, const MTSLangevinIntegrator& integrator);
+private:
+    void initializeKernels();
+    ComputeContext& cc;
+    bool hasInitializedKernels;
+    ComputeArray oldDelta;
+    std::vector<ComputeArray> savedForces;
+    ComputeKernel kickKernel, innerKernel1, innerKernel2;
+};
+
 /**
  * This kernel is invoked by BrownianIntegrator to take one time step.
  */
@@ -988,6 +1125,13 @@ public:
      * @return the size of the step that was taken
      */
     double execute(ContextImpl& context, const VariableVerletIntegrator& integrator, double maxTime);
+    /**
+     * Get the size of the last step that was taken.
+     *
+     * @param context    the context in which to execute this kernel
+     * @param stepSize   the value most recently returned by execute()
+     */
+    double getLastStepSize(ContextImpl& context, double stepSize);
     /**
      * Compute the kinetic energy.
      * 
@@ -1026,6 +1170,13 @@ public:
      * @return the size of the step that was taken
      */
     double execute(ContextImpl& context, const VariableLangevinIntegrator& integrator, double maxTime);
+    /**
+     * Get the size of the last step that was taken.
+     *
+     * @param context    the context in which to execute this kernel
+     * @param stepSize   the value most recently returned by execute()
+     */
+    double getLastStepSize(ContextImpl& context, double stepSize);
     /**
      * Compute the kinetic energy.
      * 
@@ -1081,6 +1232,57 @@ private:
     ComputeKernel kernel1, kernel2, kernel3, kernel4;
 };
 
+/**
+ * This kernel is invoked by NCMCDriver to accumulate the protocol work of a move.  The work is kept on
+ * the device, so only the final value needs to be downloaded.
+ */
+class CommonCalcProtocolWorkKernel : public CalcProtocolWorkKernel {
+public:
+    CommonCalcProtocolWorkKernel(std::string name, const Platform& platform, ComputeContext& cc) : CalcProtocolWorkKernel(name, platform), cc(cc),
+            hostWork(0.0) {
+    }
+    /**
+     * Initialize the kernel.
+     *
+     * @param system     the System this kernel will be applied to
+     */
+    void initialize(const System& system);
+    /**
+     * Save the positions and velocities at the start of a move, and set the accumulated work to zero.
+     *
+     * @param context    the context in which to execute this kernel
+     */
+    void beginMove(ContextImpl& context);
+    /**
+     * Restore the positions and velocities to what they were when beginMove() was last called.
+     *
+     * @param context    the context in which to execute this kernel
+     */
+    void restoreState(ContextImpl& context);
+    /**
+     * Compute the potential energy of a set of force groups and add it, multiplied by a scale factor,
+     * to the accumulated work.
+     *
+     * @param context    the context in which to execute this kernel
+     * @param scale      the factor to multiply the energy by
+     * @param groups     a set of bit flags for which force groups to include
+     */
+    void addEnergy(ContextImpl& context, double scale, int groups);
+    /**
+     * Get the work accumulated since beginMove() was last called.
+     *
+     * @param context    the context in which to execute this kernel
+     */
+    double getWork(ContextImpl& context);
+private:
+    ComputeContext& cc;
+    double hostWork;
+    ComputeArray savedPositions, savedCorrections, savedVelocities, work;
+    ComputeKernel kernel;
+    std::vector<int> lastAtomOrder;
+    std::vector<mm_int4> lastPosCellOffsets;
+};
+
 /**
  * This kernel is invoked to remove center of mass motion from the system.
  */
@@ -1135,12 +1337,6 @@ public:
      * @return the potential energy due to the force
      */
     double execute(ContextImpl& context, bool includeForces, bool includeEnergy);
-    /**
-     * This is the internal implementation of execute(), templatized on whether we're
-     * using single or double precision.
-     */
-    template <class REAL>
-    double executeImpl(ContextImpl& context);
     /**
      * Copy changed parameters over to a context.
      *
@@ -1309,7 +1505,7 @@ private:
     ComputeContext& cc;
     ComputeArray displ1;
     ComputeArray displ0;
-    ComputeArray invAtomOrder, inner0InvAtomOrder, inner1InvAtomOrder;
+    ComputeArray inner0InvAtomOrder, inner1InvAtomOrder;
     ComputeKernel copyStateKernel;
     ComputeKernel hybridForceKernel;
 
@@ -1322,7 +1518,7 @@ private:
 class CommonCalcCustomCPPForceKernel : public CalcCustomCPPForceKernel {
 public:
     CommonCalcCustomCPPForceKernel(std::string name, const Platform& platform, OpenMM::ContextImpl& contextImpl, ComputeContext& cc) :
-            CalcCustomCPPForceKernel(name, platform), contextImpl(contextImpl), cc(cc), force(NULL) {
+            CalcCustomCPPForceKernel(name, platform), contextImpl(contextImpl), cc(cc), force(NULL), computedOnDevice(false) {
     }
     /**
      * Initialize the kernel.
@@ -1365,6 +1561,7 @@ private:
     std::vector<float> floatForces;
     int forceGroupFlag;
     double energy;
+    bool computedOnDevice;
 };
 
 } // namespace OpenMM
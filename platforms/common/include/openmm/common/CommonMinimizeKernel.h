@@ -0,0 +1,104 @@
+#ifndef OPENMM_COMMONMINIMIZEKERNEL_H_
+#define OPENMM_COMMONMINIMIZEKERNEL_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/common/ComputeArray.h"
+#include "openmm/common/ComputeContext.h"
+#include "openmm/Platform.h"
+#include "openmm/kernels.h"
+#include <string>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This kernel performs L-BFGS energy minimization on the device.  Positions, gradients, and the
+ * L-BFGS history vectors are all stored in ComputeArrays, and the steps of the two loop recursion
+ * are done with device kernels, so the only data transferred to the host on each step are a few
+ * scalars.  Constraints are handled the same way as in LocalEnergyMinimizer: they are replaced by
+ * harmonic restraints whose strength is increased until the minimized configuration satisfies them,
+ * and the positions are projected onto the constraints with IntegrationUtilities before and after
+ * minimizing.
+ */
+class CommonMinimizeKernel : public MinimizeKernel {
+public:
+    CommonMinimizeKernel(std::string name, const Platform& platform, ComputeContext& cc) : MinimizeKernel(name, platform), cc(cc) {
+    }
+    /**
+     * Initialize the kernel.
+     *
+     * @param system     the System this kernel will be applied to
+     */
+    void initialize(const System& system);
+    /**
+     * Search for a new arrangement of particles which represents a local minimum of the potential energy.
+     *
+     * @param context        the context in which to execute this kernel
+     * @param tolerance      the convergence criterion for the minimization
+     * @param maxIterations  the maximum number of iterations to perform, or 0 for no limit
+     * @return true if the minimization was completed, or false if forces became too large to be
+     * computed reliably
+     */
+    bool execute(ContextImpl& context, double tolerance, int maxIterations);
+private:
+    /**
+     * Run L-BFGS starting from the positions in x, with restraints of strength k for the constraints.
+     * Returns false if forces became too large.
+     */
+    bool minimizeWithRestraints(ContextImpl& context, double k, double epsilon, int maxIterations);
+    /**
+     * Set the positions to xPrev - step*dir and compute the energy and gradient.  Returns false if
+     * forces became too large.
+     */
+    bool evaluate(ContextImpl& context, double step, double k, double& energy);
+    /**
+     * Move the atoms to the positions stored in a vector.
+     */
+    void setPositions(ComputeArray& positions, ComputeArray& target);
+    /**
+     * Compute the dot product of two vectors and store it in an element of a scalar array.  The offsets
+     * are measured in atoms.
+     */
+    void computeDot(ComputeArray& a, int aOffset, ComputeArray& b, int bOffset, ComputeArray& result, int index);
+    /**
+     * Download the results array to the host.
+     */
+    void downloadResults(std::vector<double>& values);
+    ComputeContext& cc;
+    int numConstraints, numPartial, blockSize, historySize;
+    ComputeArray x, xPrev, g, gPrev, dir, initialX, s, y;
+    ComputeArray historyScalars, results, partial;
+    ComputeArray constraintAtoms, constraintDistance;
+    ComputeKernel getPositionsKernel, setPositionsKernel, constraintForcesKernel, constraintErrorKernel;
+    ComputeKernel gradientKernel, dotKernel, sumKernel, maxKernel, storeHistoryKernel;
+    ComputeKernel updateQKernel, scaleQKernel, updateRKernel;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_COMMONMINIMIZEKERNEL_H_*/
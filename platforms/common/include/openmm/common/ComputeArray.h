@@ -9,7 +9,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2019-2022 Stanford University and the Authors.      *
+ * Portions copyright (c) 2019-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -72,6 +72,15 @@ public:
     void initialize(ComputeContext& context, size_t size, const std::string& name) {
         initialize(context, size, sizeof(T), name);
     }
+    /**
+     * Initialize this array so it refers to the same device memory as another array holding
+     * read-only data.  See ArrayInterface::initializeShared() for details.
+     *
+     * @param context           the context for which to create the array
+     * @param source            the array whose memory should be shared
+     * @param name              the name of the array
+     */
+    void initializeShared(ComputeContext& context, ArrayInterface& source, const std::string& name);
     /**
      * Recreate the internal storage to have a different size.
      */
@@ -141,12 +150,28 @@ public:
      *                 in page-locked memory.
      */
     void download(void* data, bool blocking=true) const;
+    /**
+     * Copy a subset of the values in the array to host memory.
+     * 
+     * @param data     the destination to copy the values to
+     * @param offset   the index of the element within the array at which the copy should begin
+     * @param elements the number of elements to copy
+     * @param blocking if true, this call will block until the transfer is complete.  Subclasses often
+     *                 have restrictions on non-blocking copies, such as that the destination must be
+     *                 in page-locked memory.
+     */
+    void downloadSubArray(void* data, int offset, int elements, bool blocking=true) const;
     /**
      * Copy the values in this array to a second array.
      * 
      * @param dest     the destination array to copy to
      */
     void copyTo(ArrayInterface& dest) const;
+    /**
+     * Get the platform-specific handle for the device memory.  This is a CUdeviceptr on CUDA,
+     * a hipDeviceptr_t on HIP, or a cl_mem on OpenCL, cast to a void*.
+     */
+    void* getNativeHandle();
 private:
     ArrayInterface* impl;
 };
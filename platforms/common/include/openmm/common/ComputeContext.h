@@ -9,7 +9,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2019-2025 Stanford University and the Authors.      *
+ * Portions copyright (c) 2019-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -50,6 +50,7 @@
 #include <queue>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 namespace OpenMM {
@@ -71,6 +72,7 @@ public:
     class ReorderListener;
     class ForcePreComputation;
     class ForcePostComputation;
+    class Annotation;
     static const int ThreadBlockSize;
     static const int TileSize;
     ComputeContext(const System& system);
@@ -175,6 +177,11 @@ public:
      * Construct a ComputeEvent object of the appropriate class for this platform.
      */
     virtual ComputeEvent createEvent() = 0;
+    /**
+     * Construct a ComputeEvent object of the appropriate class for this platform that records
+     * device timestamps, so the time between two of them can be measured with getElapsedTime().
+     */
+    virtual ComputeEvent createTimingEvent() = 0;
     /**
      * Construct a ComputeSort object of the appropriate class for this platform.
      * 
@@ -195,6 +202,18 @@ public:
      * @param defines            a set of preprocessor definitions (name, value) to define when compiling the program
      */
     virtual ComputeProgram compileProgram(const std::string source, const std::map<std::string, std::string>& defines=std::map<std::string, std::string>()) = 0;
+    /**
+     * Compile source code to create a ComputeProgram that is only needed occasionally, such as
+     * one whose kernels are executed every few hundred steps.  Platforms may postpone compiling
+     * it until a kernel is first executed, or until after the first force evaluation.  The
+     * default implementation simply calls compileProgram().
+     *
+     * @param source             the source code of the program
+     * @param defines            a set of preprocessor definitions (name, value) to define when compiling the program
+     */
+    virtual ComputeProgram compileProgramOnDemand(const std::string source, const std::map<std::string, std::string>& defines=std::map<std::string, std::string>()) {
+        return compileProgram(source, defines);
+    }
     /**
      * Compute the largest thread block size that can be used for a kernel that requires a particular amount of
      * shared memory per thread.
@@ -239,14 +258,25 @@ public:
      * Get the current simulation time.
      */
     double getTime() {
+        if (timeIsOnDevice)
+            getIntegrationUtilities().downloadDeviceTime();
         return time;
     }
     /**
      * Set the current simulation time.
      */
     void setTime(double t) {
+        if (timeIsOnDevice)
+            getIntegrationUtilities().resetDeviceTime();
         time = t;
     }
+    /**
+     * Set whether integration steps have advanced the time on the device without it yet being
+     * recorded on the host.  If so, the next call to getTime() downloads it.
+     */
+    void setTimeIsOnDevice(bool onDevice) {
+        timeIsOnDevice = onDevice;
+    }
     /**
      * Get the number of integration steps that have been taken.
      */
@@ -283,6 +313,20 @@ public:
     void setStepsSinceReorder(int steps) {
         stepsSinceReorder = steps;
     }
+    /**
+     * Get the number of times the positions have been set from outside the integrator, either by
+     * setPositions() or by loading a checkpoint.  Kernels that carry information from one step to
+     * the next can use this to detect that the trajectory has been interrupted.
+     */
+    int getPositionsSetCount() const {
+        return positionsSetCount;
+    }
+    /**
+     * Set the number of times the positions have been set from outside the integrator.
+     */
+    void setPositionsSetCount(int count) {
+        positionsSetCount = count;
+    }
     /**
      * Get whether atoms were reordered during the most recent force/energy computation.
      */
@@ -321,6 +365,16 @@ public:
     std::vector<ReorderListener*>& getReorderListeners() {
         return reorderListeners;
     }
+    /**
+     * Get the array describing the most recent reordering.  Element i holds the index the atom
+     * now at index i had before the atoms were reordered.  ReorderListeners can use this to
+     * permute their own per-atom arrays on the device without downloading the atom order.
+     * If the atoms have never been reordered, or the order was last set by setAtomIndex(),
+     * its contents are undefined.
+     */
+    ArrayInterface& getReorderPermutation() {
+        return reorderPermutation;
+    }
     /**
      * Add a pre-computation that should be called at the very start of force and energy evaluations.
      * The OpenCLContext assumes ownership of the object, and deletes it when the context itself is deleted.
@@ -355,6 +409,21 @@ public:
     void setForcesValid(bool valid) {
         forcesValid = valid;
     }
+    /**
+     * Get whether the total energy is left on the device when a force evaluation finishes.
+     */
+    bool getKeepEnergyOnDevice() const {
+        return keepEnergyOnDevice;
+    }
+    /**
+     * Set whether the total energy is left on the device when a force evaluation finishes.  When this
+     * is true, the energy buffer is still summed into getEnergySum(), but it is not downloaded, and the
+     * energy reported to the host is 0.  This lets a caller use the energy in later kernels without
+     * waiting for the device.
+     */
+    void setKeepEnergyOnDevice(bool keep) {
+        keepEnergyOnDevice = keep;
+    }
     /**
      * Get the number of atoms.
      */
@@ -410,6 +479,11 @@ public:
      * Get the array which contains the buffer in which energy is computed.
      */
     virtual ArrayInterface& getEnergyBuffer() = 0;
+    /**
+     * Get the array into which reduceEnergy() sums the energy buffer.  It has elements of type mixed,
+     * whose sum is the total energy.
+     */
+    virtual ArrayInterface& getEnergySum() = 0;
     /**
      * Get the array which contains the buffer in which derivatives of the energy with respect to parameters are computed.
      */
@@ -423,6 +497,18 @@ public:
      * might make use of it
      */
     virtual void* getPinnedBuffer() = 0;
+    /**
+     * Allocate a new block of pinned memory that is owned by the caller.  Unlike the buffer returned by
+     * getPinnedBuffer(), it can be the destination of a transfer that is still in progress while other
+     * code runs.  It must be released by calling freePinnedMemory().
+     *
+     * @param size    the size of the block in bytes
+     */
+    virtual void* allocatePinnedMemory(size_t size) = 0;
+    /**
+     * Release a block of memory that was allocated by allocatePinnedMemory().
+     */
+    virtual void freePinnedMemory(void* memory) = 0;
     /**
      * Get a shared ThreadPool that code can use to parallelize operations.
      * 
@@ -435,6 +521,8 @@ public:
      * Get the host-side vector which contains the index of each atom.
      */
     const std::vector<int>& getAtomIndex() const {
+        if (atomIndexIsOnDevice)
+            downloadAtomIndex();
         return atomIndex;
     }
     /**
@@ -449,6 +537,9 @@ public:
      * Get the number of cells by which the positions are offset.
      */
     std::vector<mm_int4>& getPosCellOffsets() {
+        if (cellOffsetsAreOnDevice)
+            downloadPosCellOffsets();
+        deviceCellOffsetsAreCurrent = false;
         return posCellOffsets;
     }
     /**
@@ -456,6 +547,8 @@ public:
      */
     void setPosCellOffsets(std::vector<mm_int4>& offsets) {
         posCellOffsets = offsets;
+        cellOffsetsAreOnDevice = false;
+        deviceCellOffsetsAreCurrent = false;
     }
     /**
      * Replace all occurrences of a list of substrings.
@@ -512,19 +605,59 @@ public:
      */
     virtual NonbondedUtilities* createNonbondedUtilities() = 0;
     /**
-     * Create an object for performing 3D FFTs.  The caller is responsible for deleting
-     * the object when it is no longer needed.
+     * Create an object for performing 3D FFTs.
+     *
+     * If getFFTBackends() returns more than one implementation for this grid, each one is
+     * benchmarked the first time a grid of this shape is requested on this device, and the
+     * fastest one is returned.  The choice is remembered, so later requests for the same shape
+     * do not repeat the benchmark.
      *
      * @param xsize   the first dimension of the data sets on which FFTs will be performed
      * @param ysize   the second dimension of the data sets on which FFTs will be performed
      * @param zsize   the third dimension of the data sets on which FFTs will be performed
      * @param realToComplex  if true, a real-to-complex transform will be done.  Otherwise, it is complex-to-complex.
      */
-    virtual FFT3D createFFT(int xsize, int ysize, int zsize, bool realToComplex=false) = 0;
+    virtual FFT3D createFFT(int xsize, int ysize, int zsize, bool realToComplex=false);
+    /**
+     * Get the name of the device this context is running on.  Devices with the same name are
+     * assumed to have the same performance characteristics.
+     */
+    virtual std::string getDeviceName() = 0;
     /**
-     * Get the smallest legal size for a dimension of the grid.
+     * Get the names of the FFT implementations that can perform transforms of a particular size.
+     * If there is more than one, they are listed in order of preference.
+     *
+     * @param xsize   the first dimension of the data sets on which FFTs will be performed
+     * @param ysize   the second dimension of the data sets on which FFTs will be performed
+     * @param zsize   the third dimension of the data sets on which FFTs will be performed
+     * @param realToComplex  if true, a real-to-complex transform will be done.  Otherwise, it is complex-to-complex.
+     */
+    virtual std::vector<std::string> getFFTBackends(int xsize, int ysize, int zsize, bool realToComplex) = 0;
+    /**
+     * Create an object for performing 3D FFTs with a specific implementation.
+     *
+     * @param backend the name of the implementation to use, as returned by getFFTBackends()
+     * @param xsize   the first dimension of the data sets on which FFTs will be performed
+     * @param ysize   the second dimension of the data sets on which FFTs will be performed
+     * @param zsize   the third dimension of the data sets on which FFTs will be performed
+     * @param realToComplex  if true, a real-to-complex transform will be done.  Otherwise, it is complex-to-complex.
+     */
+    virtual FFT3D createFFTWithBackend(const std::string& backend, int xsize, int ysize, int zsize, bool realToComplex) = 0;
+    /**
+     * Get the size to use for a dimension of the grid.  This is the fastest legal size that is
+     * not less than the minimum and is at most a few percent larger than it.
      */
     virtual int findLegalFFTDimension(int minimum);
+    /**
+     * Select the size to use for a dimension of an FFT grid.  Every size from minimum up to a few
+     * percent larger whose only prime factors are no greater than maxFactor is considered, and the
+     * one with the lowest estimated cost is returned.  Large prime factors require more work per
+     * element than small ones, so a slightly larger grid is often faster to transform.
+     *
+     * @param minimum    the minimum size the return value must be greater than or equal to
+     * @param maxFactor  the largest prime factor the FFT implementation supports
+     */
+    static int findFastFFTDimension(int minimum, int maxFactor);
     /**
      * This should be called by the Integrator from its own initialize() method.
      * It ensures all contexts are fully initialized.
@@ -609,6 +742,192 @@ public:
      * up to date.
      */
     void updateGlobalParamValues();
+    /**
+     * Get whether kernel execution times are being recorded.
+     */
+    bool getProfilingEnabled() const {
+        return profilingEnabled;
+    }
+    /**
+     * Set whether kernel execution times should be recorded.  Platforms call this during
+     * initialization based on the value of their EnableProfiling property.
+     */
+    void setProfilingEnabled(bool enabled) {
+        profilingEnabled = enabled;
+    }
+    /**
+     * Mark the beginning of an interval of device work to be timed.  Intervals may be nested,
+     * and each one must be ended by calling endProfilingInterval().  This should only be called
+     * when getProfilingEnabled() returns true.
+     */
+    void startProfilingInterval();
+    /**
+     * Mark the end of the most recently started profiling interval.  Once the work has completed,
+     * its device time is added to the total recorded under the specified name.
+     *
+     * @param name    the name under which to record the interval, typically the name of a kernel
+     */
+    void endProfilingInterval(const std::string& name);
+    /**
+     * Add a single interval to the timing information, for work whose time was measured by some
+     * other means than startProfilingInterval() and endProfilingInterval().
+     *
+     * @param name           the name under which to record the interval
+     * @param microseconds   the time the work took, in microseconds
+     */
+    void recordProfilingTime(const std::string& name, double microseconds);
+    /**
+     * Get the name used for recording the time spent computing a set of force groups.
+     *
+     * @param groups   a set of bit flags for the force groups being computed
+     */
+    static std::string getForceGroupsProfilingName(int groups);
+    /**
+     * Get the timing information that has been recorded.  This blocks until all profiled work has
+     * completed.  The result maps each name to the number of intervals recorded under it and their
+     * total device time in microseconds.
+     */
+    const std::map<std::string, std::pair<int, double> >& getProfilingTimes();
+    /**
+     * Discard all timing information that has been recorded so far.
+     */
+    void resetProfilingTimes();
+    /**
+     * Get whether ranges of work are being annotated for external profiling tools.
+     */
+    bool getAnnotationsEnabled() const {
+        return annotationsEnabled;
+    }
+    /**
+     * Set whether ranges of work should be annotated for external profiling tools.  Platforms call
+     * this during initialization based on the value of their EnableAnnotations property, but it may
+     * be changed at any time.  When it is disabled, annotations cost nothing beyond checking this flag.
+     */
+    void setAnnotationsEnabled(bool enabled) {
+        annotationsEnabled = enabled;
+    }
+    /**
+     * Begin a named range of work to be shown by external profiling tools such as Nsight Systems or
+     * rocprof.  Ranges may be nested, and each one must be ended by calling popAnnotation().  Usually
+     * it is simpler to create an Annotation than to call this directly.  The default implementation
+     * does nothing.  Platforms that support a profiling tool override it.
+     *
+     * @param name    the name of the range
+     */
+    virtual void pushAnnotation(const std::string& name) {
+    }
+    /**
+     * End the most recently begun annotation range.
+     */
+    virtual void popAnnotation() {
+    }
+    /**
+     * Record the amount of device memory used by an array.  The platform specific array classes call
+     * this before allocating memory, and again if the array is resized.  When an array is first
+     * recorded, it is attributed to the Force being initialized, or to "Context" if there is none.
+     * If a memory budget has been set and this would exceed it, an exception is thrown that describes
+     * how memory is currently being used, and the array is not recorded.
+     *
+     * @param array    the array that is being allocated
+     * @param bytes    the number of bytes the array will use
+     */
+    void recordArrayAllocation(const ArrayInterface& array, size_t bytes);
+    /**
+     * Record that an array has released its device memory.
+     *
+     * @param array    the array that is being freed
+     */
+    void recordArrayRelease(const ArrayInterface& array);
+    /**
+     * Get the device memory currently used by arrays.  The result maps the owner of each array
+     * (usually the name of a Force) to the names of its arrays, and the total number of bytes
+     * used by the arrays with each name.
+     */
+    std::map<std::string, std::map<std::string, long long> > getMemoryUsage();
+    /**
+     * Get a human readable summary of the device memory currently used by arrays, listing the
+     * owners that use the most memory first.
+     */
+    std::string getMemoryUsageReport();
+    /**
+     * Get the maximum number of bytes that arrays are allowed to use, or 0 if there is no limit.
+     */
+    long long getMemoryBudget() const {
+        return memoryBudget;
+    }
+    /**
+     * Set the maximum number of bytes that arrays are allowed to use.  Platforms call this during
+     * initialization based on the value of their DeviceMemoryBudget property.  A value of 0 means
+     * there is no limit.
+     */
+    void setMemoryBudget(long long bytes) {
+        memoryBudget = bytes;
+    }
+    /**
+     * Initialize an array that holds read-only parameters and upload values to it.  If sharing has
+     * been enabled for this context (see enableSharedArrays()) and this context or another one on
+     * the same device has already created an array with the same name and contents, the array
+     * refers to the existing device memory instead of allocating more.  If the array is later
+     * modified, for example by updateParametersInContext(), it first receives its own copy, so
+     * sharing never affects results.  Kernels must not write to arrays created this way.
+     *
+     * @param array        the array to initialize
+     * @param size         the number of elements in the array
+     * @param elementSize  the size of each element in bytes
+     * @param data         the values to store in the array
+     * @param name         the name of the array
+     */
+    void initializeSharedArray(ArrayInterface& array, size_t size, int elementSize, const void* data, const std::string& name);
+    /**
+     * Initialize an array that holds read-only parameters and upload values to it.  The template
+     * argument is the data type of each array element.  This is identical to the other form of
+     * initializeSharedArray(), except that the size and values are taken from a vector.
+     *
+     * @param array        the array to initialize
+     * @param data         the values to store in the array
+     * @param name         the name of the array
+     */
+    template <class T>
+    void initializeSharedArray(ArrayInterface& array, const std::vector<T>& data, const std::string& name) {
+        initializeSharedArray(array, data.size(), sizeof(T), data.data(), name);
+    }
+    /**
+     * Get whether this context shares read-only arrays with other contexts.
+     */
+    bool getSharesArrays() const {
+        return (sharedArrays != NULL);
+    }
+    /**
+     * Begin capturing the device work that is queued from this point on into a graph, so the whole
+     * sequence can be launched at once by endGraphCapture().  While capturing, work is recorded
+     * rather than executed, so the caller must not read back any results or wait for the device
+     * until capture has ended.  Capture only happens if the platform supports it, the user has
+     * requested it, and every part of the System is known to be safe to capture.
+     *
+     * @param key    identifies the sequence of work being captured.  An executable graph is cached
+     *               for each key and updated in place each time the same sequence is captured again.
+     * @return true if capture has begun, in which case endGraphCapture() must be called to execute
+     * the work.  If this returns false, work is executed immediately as usual.
+     */
+    virtual bool beginGraphCapture(const std::string& key) {
+        return false;
+    }
+    /**
+     * Finish capturing the work that was begun by beginGraphCapture() and launch it.
+     *
+     * @return true if the work was launched.  If the graph could not be captured, instantiated, or
+     * launched, this returns false and none of the work has been executed.  Graph capture is then
+     * disabled for this context, so the caller should simply queue the same work again.
+     */
+    virtual bool endGraphCapture() {
+        return true;
+    }
+    /**
+     * Get whether work is currently being captured into a graph rather than executed.
+     */
+    virtual bool isCapturingGraph() const {
+        return false;
+    }
 protected:
     struct Molecule;
     struct MoleculeGroup;
@@ -616,28 +935,110 @@ protected:
     void findMoleculeGroups();
     void resetAtomOrder();
     /**
-     * This is the internal implementation of reorderAtoms(), templatized by the numerical precision in use.
+     * This is the internal implementation of reorderAtoms().  The molecules are binned, sorted, and
+     * moved entirely on the device.
      */
-    template <class Real, class Real4, class Mixed, class Mixed4>
     void reorderAtomsImpl();
+    /**
+     * Create the arrays and kernels used by reorderAtomsImpl().  This is called again whenever the
+     * groups of identical molecules change.
+     */
+    void initializeReordering();
+    /**
+     * Copy the atom order from the device after it was changed by reorderAtomsImpl().
+     */
+    void downloadAtomIndex() const;
+    /**
+     * Copy the cell offsets from the device after they were changed by reorderAtomsImpl().
+     */
+    void downloadPosCellOffsets() const;
+    /**
+     * Get whether the kernels for every Force in the System, and for applying constraints, queue a
+     * fixed sequence of work that never requires the host to wait for results from the device.
+     * Platforms that support graph capture use this to decide whether it is safe.
+     */
+    bool getSystemSupportsGraphCapture();
+    /**
+     * Enable sharing of read-only arrays created with initializeSharedArray().  Contexts can only
+     * share arrays if device memory allocated by one of them can be used by the others.  Platforms
+     * call this during initialization, before any Force has been initialized.
+     *
+     * @param original   if this is not NULL and sharing is enabled for it, this context shares
+     *                   arrays with it and with every other context that does.  Otherwise a new
+     *                   set of shared arrays is created, which this context owns.  The owner must
+     *                   be deleted after all other contexts that share its arrays.
+     */
+    void enableSharedArrays(ComputeContext* original);
+    /**
+     * Delete the arrays this context owns because it created the set of shared arrays.  Platforms
+     * call this from their destructors while device memory can still be freed.
+     */
+    void releaseSharedArrays();
     const System& system;
     double time;
-    int numAtoms, paddedNumAtoms, computeForceCount, stepsSinceReorder;
+    int numAtoms, paddedNumAtoms, computeForceCount, stepsSinceReorder, positionsSetCount;
     long long stepCount;
-    bool forceNextReorder, atomsWereReordered, forcesValid, hasInitializedGlobals;
+    bool forceNextReorder, atomsWereReordered, forcesValid, hasInitializedGlobals, keepEnergyOnDevice;
     ComputeQueue defaultQueue, currentQueue;
     std::vector<ComputeForceInfo*> forces;
     std::vector<Molecule> molecules;
     std::vector<MoleculeGroup> moleculeGroups;
-    std::vector<int> atomIndex;
-    std::vector<mm_int4> posCellOffsets;
+    mutable std::vector<int> atomIndex;
+    mutable std::vector<mm_int4> posCellOffsets;
     std::vector<ReorderListener*> reorderListeners;
     std::vector<ForcePreComputation*> preComputations;
     std::vector<ForcePostComputation*> postComputations;
     std::vector<std::string> globalParamNames;
     std::vector<double> lastGlobalParamValues;
     ComputeArray globalParamValues;
+    ComputeArray reorderMoleculeInfo, reorderMoleculeAtoms, reorderAtomMolecule, reorderMoleculeCenters, reorderMoleculeCells;
+    ComputeArray reorderMoleculeSource, reorderRange, reorderInvalidPosition, reorderPermutation, reorderCellOffsets;
+    ComputeArray reorderOldPosq, reorderOldPosqCorrection, reorderOldVelm, reorderOldAtomIndex, reorderOldCellOffsets;
+    std::vector<ComputeArray> reorderKeys;
+    std::vector<ComputeSort> reorderSorts;
+    std::vector<int> reorderGroupFirst, reorderGroupSize, reorderGroupHilbert;
+    ComputeKernel findRangeKernel, computeCentersKernel, computeKeysKernel, recordOrderKernel, applyOrderKernel;
+    bool hasInitializedReordering, deviceCellOffsetsAreCurrent;
+    mutable bool atomIndexIsOnDevice, cellOffsetsAreOnDevice;
+    bool timeIsOnDevice;
     WorkThread* workThread;
+private:
+    struct ProfilingInterval;
+    void processProfilingIntervals();
+    bool profilingEnabled, annotationsEnabled;
+    std::vector<ComputeEvent> profilingStack, unusedTimingEvents;
+    std::vector<ProfilingInterval> pendingProfilingIntervals;
+    std::map<std::string, std::pair<int, double> > profilingTimes;
+    struct ArrayMemory;
+    std::map<const ArrayInterface*, ArrayMemory> arrayMemory;
+    long long arrayMemoryTotal, memoryBudget;
+    std::mutex arrayMemoryLock;
+    std::string selectFFTBackend(const std::vector<std::string>& backends, int xsize, int ysize, int zsize, bool realToComplex);
+    struct SharedArray;
+    struct SharedArrayCache;
+    SharedArrayCache* sharedArrays;
+    bool ownsSharedArrays;
+};
+
+struct ComputeContext::ProfilingInterval {
+    std::string name;
+    ComputeEvent start, end;
+};
+
+struct ComputeContext::ArrayMemory {
+    std::string owner;
+    long long bytes;
+};
+
+struct ComputeContext::SharedArray {
+    std::vector<char> data;
+    ArrayInterface* storage;
+};
+
+struct ComputeContext::SharedArrayCache {
+    ComputeContext* owner;
+    std::map<std::string, std::vector<SharedArray> > arrays;
+    std::mutex lock;
 };
 
 struct ComputeContext::Molecule {
@@ -697,10 +1098,48 @@ private:
     std::thread workThread;
 };
 
+/**
+ * An Annotation marks a range of host code, and the device work it launches, for external profiling
+ * tools.  Create one on the stack and the range ends when it goes out of scope.  If annotations are
+ * disabled when it is created it does nothing, and the name is never constructed.
+ */
+class OPENMM_EXPORT_COMMON ComputeContext::Annotation {
+public:
+    /**
+     * Create an Annotation.
+     *
+     * @param context   the context whose work is being annotated
+     * @param name      the name of the range
+     */
+    Annotation(ComputeContext& context, const char* name) : context(context), active(context.getAnnotationsEnabled()) {
+        if (active)
+            context.pushAnnotation(name);
+    }
+    /**
+     * Create an Annotation whose name is formed by concatenating two strings.
+     *
+     * @param context   the context whose work is being annotated
+     * @param prefix    the first part of the name
+     * @param suffix    the second part of the name
+     */
+    Annotation(ComputeContext& context, const char* prefix, const std::string& suffix) : context(context), active(context.getAnnotationsEnabled()) {
+        if (active)
+            context.pushAnnotation(prefix+suffix);
+    }
+    ~Annotation() {
+        if (active)
+            context.popAnnotation();
+    }
+private:
+    ComputeContext& context;
+    bool active;
+};
+
 /**
  * This abstract class defines a function to be executed whenever atoms get reordered.
  * Objects that need to know when reordering happens should create a ReorderListener
- * and register it by calling addReorderListener().
+ * and register it by calling addReorderListener().  When execute() is called,
+ * ComputeContext::getReorderPermutation() describes how the atoms were moved.
  */
 class OPENMM_EXPORT_COMMON ComputeContext::ReorderListener {
 public:
@@ -62,6 +62,14 @@ public:
      * operations started before the call to enqueue() have completed.
      */
     virtual void queueWait(ComputeQueue queue) = 0;
+    /**
+     * Get the time in milliseconds that elapsed on the device between another event and this one.
+     * Both events must have been created with ComputeContext::createTimingEvent() and enqueued,
+     * and this one must have completed.
+     *
+     * @param start    the event marking the beginning of the interval
+     */
+    virtual double getElapsedTime(ComputeEventImpl& start) = 0;
 };
 
 typedef std::shared_ptr<ComputeEventImpl> ComputeEvent;
@@ -47,6 +47,12 @@ class OPENMM_EXPORT_COMMON ComputeQueueImpl {
 public:
     virtual ~ComputeQueueImpl() {
     }
+    /**
+     * Get the platform-specific handle for the queue.  This is a CUstream on CUDA, a
+     * hipStream_t on HIP, or a cl_command_queue on OpenCL, cast to a void*.  External
+     * code can enqueue work on it to have it execute in order with OpenMM's own kernels.
+     */
+    virtual void* getNativeHandle() = 0;
 };
 
 typedef std::shared_ptr<ComputeQueueImpl> ComputeQueue;
@@ -9,7 +9,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2009-2021 Stanford University and the Authors.      *
+ * Portions copyright (c) 2009-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -87,6 +87,17 @@ public:
      * @return the spline coefficients
      */
     std::vector<float> computeFunctionCoefficients(const TabulatedFunction& function, int& width);
+    /**
+     * Upload new coefficients for a TabulatedFunction whose values have changed.  Only the range of
+     * elements that differ from the ones uploaded previously is transferred, so modifying a small
+     * region of a large table is inexpensive.
+     *
+     * @param function   the function to upload coefficients for
+     * @param array      the array containing the coefficients
+     * @param previous   the coefficients that were last uploaded to the array.  On exit, this is
+     *                   updated to contain the new coefficients.
+     */
+    void updateFunctionCoefficients(const TabulatedFunction& function, ArrayInterface& array, std::vector<float>& previous);
     /**
      * Get a Lepton::CustomFunction that can be used to represent a TabulatedFunction when parsing expressions.
      * 
@@ -28,6 +28,7 @@
  * -------------------------------------------------------------------------- */
 
 #include "openmm/common/ArrayInterface.h"
+#include "openmm/OpenMMException.h"
 #include <memory>
 
 namespace OpenMM {
@@ -69,6 +70,28 @@ public:
      * @param forward  true to perform a forward transform, false to perform an inverse transform
      */
     virtual void execFFT(ArrayInterface& in, ArrayInterface& out, bool forward=true) = 0;
+    /**
+     * Get whether this object can perform fused convolutions with execConvolution().  If this
+     * returns false, the caller should perform the transforms and multiplication separately.
+     */
+    virtual bool supportsConvolution() {
+        return false;
+    }
+    /**
+     * Convolve a data set with a kernel.  This is equivalent to calling execFFT(in, out, true),
+     * multiplying each element of out by the corresponding element of kernel, and then calling
+     * execFFT(out, in, false).  The multiplication is fused into the transforms, however, so
+     * the transformed data does not need to make an extra pass through memory.  This may only
+     * be called if supportsConvolution() returns true.
+     *
+     * @param in       the data to convolve.  On exit, this contains the result.
+     * @param out      used as workspace.  It must be large enough to hold the output of a forward transform.
+     * @param kernel   the complex values to multiply the transformed data by, in the same layout as
+     *                 the output of a forward transform
+     */
+    virtual void execConvolution(ArrayInterface& in, ArrayInterface& out, ArrayInterface& kernel) {
+        throw OpenMMException("This FFT does not support convolution");
+    }
 };
 
 typedef std::shared_ptr<FFT3DImpl> FFT3D;
@@ -45,7 +45,16 @@ class ComputeContext;
 
 class OPENMM_EXPORT_COMMON IntegrationUtilities {
 public:
-    IntegrationUtilities(ComputeContext& context, const System& system);
+    /**
+     * Create an IntegrationUtilities.
+     *
+     * @param context    the context this object belongs to
+     * @param system     the System being simulated
+     * @param useLincs   if true, constraints that cannot be handled by SETTLE or SHAKE are applied with
+     *                   P-LINCS instead of CCMA.  It uses a fixed number of iterations, so it never needs
+     *                   to synchronize with the host, but it ignores the constraint tolerance.
+     */
+    IntegrationUtilities(ComputeContext& context, const System& system, bool useLincs=false);
     virtual ~IntegrationUtilities() {
     }
     /**
@@ -73,6 +82,33 @@ public:
      * Get the size that was used for the last step.
      */
     double getLastStepSize();
+    /**
+     * Get the array that variable step size integrators use to accumulate the simulation time on
+     * the device, so the host does not need to wait for each step size to be selected.  It has a
+     * single element whose x component is the time elapsed since it was last downloaded, y is the
+     * compensation term for summing it, z is 1 if the last step was shortened to end exactly at the
+     * maximum time, and w is the size of the last step.
+     */
+    ArrayInterface& getDeviceTime();
+    /**
+     * Record that a step has been taken whose duration was accumulated in the array returned by
+     * getDeviceTime().  The context's time is brought up to date when it is next requested.
+     *
+     * @param maxTime    the maximum time the step was allowed to advance the simulation to
+     */
+    void addDeviceTimeStep(double maxTime);
+    /**
+     * Add the time accumulated on the device to the context's time and reset the accumulator.
+     * ComputeContext::getTime() calls this automatically when needed.
+     *
+     * @return the size of the last step that was taken
+     */
+    double downloadDeviceTime();
+    /**
+     * Discard any time accumulated on the device.  ComputeContext::setTime() calls this automatically
+     * when needed.  The size of the last step is retained.
+     */
+    void resetDeviceTime();
     /**
      * Apply constraints to the atom positions.  When calling this method, the
      * context's array of positions should contain the positions at the start of the
@@ -89,6 +125,12 @@ public:
      * @param tol             the constraint tolerance
      */
     void applyVelocityConstraints(double tol);
+    /**
+     * Get whether applying constraints requires the host to check for convergence while the
+     * iterations are running.  This is the case when there are too many CCMA constraints for
+     * the version of the algorithm that runs in a single kernel.  It is never the case for LINCS.
+     */
+    bool getConstraintsRequireHostSync() const;
     /**
      * Initialize the random number generator.  This should be called once when the
      * context is first created.  Subsequent calls will be ignored if the random
@@ -103,10 +145,54 @@ public:
      * @return the index in the array at which to start reading
      */
     int prepareRandomNumbers(int numValues);
+    /**
+     * Get the key for generating random numbers on the fly with philoxNormal4(), which is defined
+     * in CommonKernelSources::random.  It is derived from the seed passed to initRandomNumberGenerator().
+     */
+    mm_int2 getRandomKey() const {
+        return randomKey;
+    }
+    /**
+     * Get a new counter for generating random numbers on the fly with philoxNormal4().  Every call
+     * returns a different value, so a kernel that combines it with the key from getRandomKey() and
+     * an index (such as the atom index) gets independent random numbers each time.  Unlike
+     * prepareRandomNumbers(), this does not require any values to be generated in advance.
+     *
+     * @return the counter to pass to the kernel, with the low 32 bits in x and the high 32 bits in y
+     */
+    mm_int2 prepareRandomCounter();
     /**
      * Compute the positions of virtual sites.
      */
     void computeVirtualSites();
+    /**
+     * Set the array in which CMMotionRemover records the center of mass momentum of each thread block.
+     * Integrators that support it fill in this array at the end of every step, so the momentum does not
+     * need to be computed again before it is removed.  To do this, they must execute the kernel that
+     * computes the final velocities with the same number of threads and thread block size (64) as
+     * CMMotionRemover.
+     */
+    void setCMMomentum(ArrayInterface& array);
+    /**
+     * Get the array set by setCMMomentum(), or NULL if there is none.
+     */
+    ArrayInterface* getCMMomentum() {
+        return cmMomentum;
+    }
+    /**
+     * Set the step at which the array returned by getCMMomentum() was last computed from the current
+     * velocities.  Pass -1 to indicate that it does not match the current velocities.
+     */
+    void setCMMomentumStep(long long step) {
+        cmMomentumStep = step;
+    }
+    /**
+     * Get the step at which the array returned by getCMMomentum() was last computed from the current
+     * velocities, or -1 if it does not match them.
+     */
+    long long getCMMomentumStep() const {
+        return cmMomentumStep;
+    }
     /**
      * Distribute forces from virtual sites to the atoms they are based on.
      */
@@ -139,11 +225,17 @@ public:
     void computeShiftedVelocities(double timeShift, std::vector<Vec3>& velocities);
 protected:
     virtual void applyConstraintsImpl(bool constrainVelocities, double tol) = 0;
+    /**
+     * Apply the constraints that are not handled by SETTLE or SHAKE with LINCS.
+     */
+    void applyLincs(bool constrainVelocities);
+    void solveLincsMatrix();
     ComputeContext& context;
     ComputeKernel settlePosKernel, settleVelKernel;
     ComputeKernel shakePosKernel, shakeVelKernel;
     ComputeKernel ccmaDirectionsKernel, ccmaPosForceKernel, ccmaVelForceKernel;
     ComputeKernel ccmaMultiplyKernel, ccmaUpdateKernel, ccmaFullKernel;
+    ComputeKernel lincsDirectionsKernel, lincsMatrixKernel, lincsMultiplyKernel, lincsUpdateKernel, lincsCorrectionKernel;
     ComputeKernel vsitePositionKernel, vsiteForceKernel, vsiteSaveForcesKernel;
     ComputeKernel randomKernel, timeShiftKernel, kineticEnergyKernel;
     ComputeArray posDelta;
@@ -154,6 +246,7 @@ protected:
     ComputeArray random;
     ComputeArray randomSeed;
     ComputeArray stepSize;
+    ComputeArray deviceTime;
     ComputeArray ccmaAtoms;
     ComputeArray ccmaConstraintAtoms;
     ComputeArray ccmaDistance;
@@ -165,6 +258,13 @@ protected:
     ComputeArray ccmaDelta1;
     ComputeArray ccmaDelta2;
     ComputeArray ccmaConverged;
+    ComputeArray lincsCoupledConstraints;
+    ComputeArray lincsCouplingCoefficients;
+    ComputeArray lincsCouplingMatrix;
+    ComputeArray lincsS;
+    ComputeArray lincsRhs1;
+    ComputeArray lincsRhs2;
+    ComputeArray lincsSolution;
     ComputeArray vsite2AvgAtoms;
     ComputeArray vsite2AvgWeights;
     ComputeArray vsite3AvgAtoms;
@@ -177,10 +277,18 @@ protected:
     ComputeArray vsiteLocalCoordsPos;
     ComputeArray vsiteLocalCoordsStartIndex;
     ComputeArray vsiteStage;
+    ComputeArray vsiteWaterAtoms;
+    ComputeArray vsiteWaterSecondSite;
+    ComputeArray vsiteWaterWeights;
     ComputeArray kineticEnergy;
     int randomPos, lastSeed, numVsites, numVsiteStages, keWorkGroupSize;
-    bool hasOverlappingVsites;
+    long long randomCounter;
+    mm_int2 randomKey;
+    double deviceTimeLimit, deviceStepSize;
+    bool hasOverlappingVsites, useLincs;
     mm_double2 lastStepSize;
+    ArrayInterface* cmMomentum;
+    long long cmMomentumStep;
     struct ShakeCluster;
     struct ConstraintOrderer;
 };
@@ -0,0 +1,125 @@
+#ifndef OPENMM_KERNELCACHE_H_
+#define OPENMM_KERNELCACHE_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.            *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/common/windowsExportCommon.h"
+#include <string>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class manages a directory of compiled kernels, so they can be reused by later Contexts
+ * instead of being compiled again.  Each file is identified by a hash of a key, which should
+ * include everything that affects the compiled code: the source, the compilation options, and
+ * the device.
+ *
+ * The total size of the files is kept below a limit by deleting the ones that were least recently
+ * used.  The limit is 1 GB by default, and can be changed by setting the environment variable
+ * OPENMM_CACHE_MAX_SIZE to the number of megabytes to allow.  A value of 0 means there is no limit.
+ *
+ * A cache can also search read-only directories of prebuilt kernels, such as ones generated when
+ * OpenMM was built.  They are never written to or pruned.
+ */
+
+class OPENMM_EXPORT_COMMON KernelCache {
+public:
+    /**
+     * Create a KernelCache.
+     *
+     * @param directory   the directory to store files in.  If this is an empty string, the directory
+     *                    specified by the environment variable OPENMM_CACHE_DIR is used, or defaultDirectory
+     *                    if that is not set.
+     * @param defaultDirectory  the directory to use if none is specified
+     * @param prefix      a prefix for the names of all files created by this cache.  Only files that start with
+     *                    it are considered when enforcing the size limit.
+     */
+    KernelCache(const std::string& directory, const std::string& defaultDirectory, const std::string& prefix);
+    /**
+     * Get the directory where files are stored, including a trailing separator.
+     */
+    const std::string& getDirectory() const {
+        return directory;
+    }
+    /**
+     * Get the name of the file used to store the data for a key.
+     */
+    std::string getFileName(const std::string& key) const;
+    /**
+     * Add a read-only directory to search for files that are not found in the main directory.
+     */
+    void addReadOnlyDirectory(const std::string& directory);
+    /**
+     * Find an existing file containing the data for a key.  The main directory is searched first,
+     * followed by read-only directories in the order they were added.
+     *
+     * @param key    the key identifying the data
+     * @return the name of the file, or an empty string if none was found
+     */
+    std::string findFile(const std::string& key) const;
+    /**
+     * Load the data that was saved for a key.
+     *
+     * @param key    the key identifying the data
+     * @param data   on exit, the data that was loaded
+     * @return true if the data was found, false otherwise
+     */
+    bool load(const std::string& key, std::vector<char>& data);
+    /**
+     * Save data for a key.  Failures to write the file (for example, because the directory is not
+     * writable) are ignored.
+     *
+     * @param key    the key identifying the data
+     * @param data   the data to save
+     */
+    void save(const std::string& key, const std::vector<char>& data);
+    /**
+     * Record that a file has been used, so it will not be evicted before files that are used less
+     * recently.  load() does this automatically.  Call it directly when a file has been read by
+     * other means.
+     */
+    void recordUse(const std::string& fileName);
+    /**
+     * Record that a file has been added to the directory by other means than save(), and delete the
+     * least recently used files if the directory is now over its size limit.
+     */
+    void recordNewFile(const std::string& fileName);
+    /**
+     * Compute a hexadecimal SHA1 hash of a string.
+     */
+    static std::string getHash(const std::string& text);
+private:
+    void enforceSizeLimit();
+    std::string directory, prefix;
+    std::vector<std::string> readOnlyDirectories;
+    long long maxSize;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_KERNELCACHE_H_*/
@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2011-2023 Stanford University and the Authors.      *
+ * Portions copyright (c) 2011-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -27,12 +27,13 @@
 #include "openmm/common/BondedUtilities.h"
 #include "openmm/common/ComputeContext.h"
 #include "openmm/OpenMMException.h"
+#include <algorithm>
 #include <iostream>
 
 using namespace OpenMM;
 using namespace std;
 
-BondedUtilities::BondedUtilities(ComputeContext& context) : context(context), numForceBuffers(0), maxBonds(0), allGroups(0), hasInitializedKernels(false) {
+BondedUtilities::BondedUtilities(ComputeContext& context) : context(context), numForceBuffers(0), maxBonds(0), allGroups(0), hasInitializedKernels(false), hasInitializedEnergyKernel(false) {
 }
 
 void BondedUtilities::addInteraction(const vector<vector<int> >& atoms, const string& source, int group) {
@@ -76,12 +77,31 @@ void BondedUtilities::initialize(const System& system) {
     if (!hasInteractions)
         return;
     
-    // Build the lists of atom indices.
+    // Build the lists of atom indices.  Atom reordering only swaps identical molecules, so each
+    // bond always refers to the same atom slots, and the slots are in spatial order.  Processing
+    // bonds in order of their first atom therefore keeps the memory accesses local.  If a force
+    // lists its bonds in some other order, sort them and record the original index of each one.
     
     atomIndices.resize(numForces);
+    bondOrder.resize(numForces);
     for (int i = 0; i < numForces; i++) {
         int numBonds = forceAtoms[i].size();
         int numAtoms = forceAtoms[i][0].size();
+        vector<int> order(numBonds);
+        for (int bond = 0; bond < numBonds; bond++)
+            order[bond] = bond;
+        const vector<vector<int> >& bondAtoms = forceAtoms[i];
+        stable_sort(order.begin(), order.end(), [&bondAtoms] (int a, int b) { return bondAtoms[a][0] < bondAtoms[b][0]; });
+        bool isSorted = true;
+        for (int bond = 0; bond < numBonds && isSorted; bond++)
+            isSorted = (order[bond] == bond);
+        if (!isSorted) {
+            vector<vector<int> > sortedAtoms(numBonds);
+            for (int bond = 0; bond < numBonds; bond++)
+                sortedAtoms[bond] = forceAtoms[i][order[bond]];
+            forceAtoms[i] = sortedAtoms;
+            context.initializeSharedArray(bondOrder[i], order, "bondedOrder");
+        }
         int numArrays = (numAtoms+3)/4;
         int startAtom = 0;
         atomIndices[i].resize(numArrays);
@@ -93,8 +113,7 @@ void BondedUtilities::initialize(const System& system) {
                 for (int atom = 0; atom < width; atom++)
                     indexVec[bond*paddedWidth+atom] = forceAtoms[i][bond][startAtom+atom];
             }
-            atomIndices[i][j].initialize(context, numBonds, 4*paddedWidth, "bondedIndices");
-            atomIndices[i][j].upload(&indexVec[0]);
+            context.initializeSharedArray(atomIndices[i][j], numBonds, 4*paddedWidth, &indexVec[0], "bondedIndices");
             startAtom += width;
         }
     }
@@ -111,6 +130,8 @@ void BondedUtilities::initialize(const System& system) {
             string indexType = (indexWidth == 1 ? "unsigned int" : "uint"+context.intToString(indexWidth));
             s<<", GLOBAL const "<<indexType<<"* RESTRICT atomIndices"<<force<<"_"<<i;
         }
+        if (bondOrder[force].isInitialized())
+            s<<", GLOBAL const int* RESTRICT bondOrder"<<force;
     }
     for (int i = 0; i < (int) arguments.size(); i++)
         s<<", GLOBAL "<<argTypes[i]<<"* customArg"<<(i+1);
@@ -130,9 +151,11 @@ void BondedUtilities::initialize(const System& system) {
             if (allParamDerivNames[index] == energyParameterDerivatives[i])
                 s<<"energyParamDerivs[(GLOBAL_ID)*"<<numDerivs<<"+"<<index<<"] += energyParamDeriv"<<i<<";\n";
     s<<"}\n";
-    map<string, string> defines;
-    defines["PADDED_NUM_ATOMS"] = context.intToString(context.getPaddedNumAtoms());
-    ComputeProgram program = context.compileProgram(s.str(), defines);
+    kernelSource = s.str();
+    kernelDefines["PADDED_NUM_ATOMS"] = context.intToString(context.getPaddedNumAtoms());
+    map<string, string> defines = kernelDefines;
+    defines["INCLUDE_FORCES"] = "1";
+    ComputeProgram program = context.compileProgram(kernelSource, defines);
     kernel = program->createKernel("computeBondedForces");
     forceAtoms.clear();
     forceSource.clear();
@@ -144,13 +167,20 @@ string BondedUtilities::createForceSource(int forceIndex, int numBonds, int numA
     string suffix4[] = {".x", ".y", ".z", ".w"};
     stringstream s;
     s<<"if ((groups&"<<(1<<group)<<") != 0)\n";
-    s<<"for (unsigned int index = GLOBAL_ID; index < "<<numBonds<<"; index += GLOBAL_SIZE) {\n";
+    string sortedIndex = "index";
+    if (bondOrder[forceIndex].isInitialized()) {
+        sortedIndex = "sortedIndex";
+        s<<"for (unsigned int sortedIndex = GLOBAL_ID; sortedIndex < "<<numBonds<<"; sortedIndex += GLOBAL_SIZE) {\n";
+        s<<"    unsigned int index = bondOrder"<<forceIndex<<"[sortedIndex];\n";
+    }
+    else
+        s<<"for (unsigned int index = GLOBAL_ID; index < "<<numBonds<<"; index += GLOBAL_SIZE) {\n";
     int startAtom = 0;
     for (int i = 0; i < (int) atomIndices[forceIndex].size(); i++) {
         int indexWidth = atomIndices[forceIndex][i].getElementSize()/4;
         string* suffix = (indexWidth == 1 ? suffix1 : suffix4);
         string indexType = (indexWidth == 1 ? "unsigned int" : "uint"+context.intToString(indexWidth));
-        s<<"    "<<indexType<<" atoms"<<i<<" = atomIndices"<<forceIndex<<"_"<<i<<"[index];\n";
+        s<<"    "<<indexType<<" atoms"<<i<<" = atomIndices"<<forceIndex<<"_"<<i<<"["<<sortedIndex<<"];\n";
         int atomsToLoad = min(indexWidth, numAtoms-startAtom);
         for (int j = 0; j < atomsToLoad; j++) {
             s<<"    unsigned int atom"<<(startAtom+j+1)<<" = atoms"<<i<<suffix[j]<<";\n";
@@ -159,36 +189,54 @@ string BondedUtilities::createForceSource(int forceIndex, int numBonds, int numA
         startAtom += indexWidth;
     }
     s<<computeForce<<"\n";
+    s<<"#ifdef INCLUDE_FORCES\n";
     for (int i = 0; i < numAtoms; i++) {
         s<<"    ATOMIC_ADD(&forceBuffer[atom"<<(i+1)<<"], (mm_ulong) realToFixedPoint(force"<<(i+1)<<".x));\n";
         s<<"    ATOMIC_ADD(&forceBuffer[atom"<<(i+1)<<"+PADDED_NUM_ATOMS], (mm_ulong) realToFixedPoint(force"<<(i+1)<<".y));\n";
         s<<"    ATOMIC_ADD(&forceBuffer[atom"<<(i+1)<<"+PADDED_NUM_ATOMS*2], (mm_ulong) realToFixedPoint(force"<<(i+1)<<".z));\n";
         s<<"    MEM_FENCE;\n";
     }
+    s<<"#endif\n";
     s<<"}\n";
     return s.str();
 }
 
-void BondedUtilities::computeInteractions(int groups) {
+void BondedUtilities::addKernelArgs(ComputeKernel& kernel) {
+    kernel->addArg(context.getLongForceBuffer());
+    kernel->addArg(context.getEnergyBuffer());
+    kernel->addArg(context.getPosq());
+    for (int i = 0; i < 6; i++)
+        kernel->addArg();
+    for (int i = 0; i < (int) atomIndices.size(); i++) {
+        for (int j = 0; j < (int) atomIndices[i].size(); j++)
+            kernel->addArg(atomIndices[i][j]);
+        if (bondOrder[i].isInitialized())
+            kernel->addArg(bondOrder[i]);
+    }
+    for (int i = 0; i < (int) arguments.size(); i++)
+        kernel->addArg(*arguments[i]);
+    if (energyParameterDerivatives.size() > 0)
+        kernel->addArg(context.getEnergyParamDerivBuffer());
+}
+
+void BondedUtilities::computeInteractions(int groups, bool includeForces) {
     if ((groups&allGroups) == 0)
         return;
+    if (!hasInteractions)
+        return;
     if (!hasInitializedKernels) {
         hasInitializedKernels = true;
-        kernel->addArg(context.getLongForceBuffer());
-        kernel->addArg(context.getEnergyBuffer());
-        kernel->addArg(context.getPosq());
-        for (int i = 0; i < 6; i++)
-            kernel->addArg();
-        for (int i = 0; i < (int) atomIndices.size(); i++)
-            for (int j = 0; j < (int) atomIndices[i].size(); j++)
-                kernel->addArg(atomIndices[i][j]);
-        for (int i = 0; i < (int) arguments.size(); i++)
-            kernel->addArg(*arguments[i]);
-        if (energyParameterDerivatives.size() > 0)
-            kernel->addArg(context.getEnergyParamDerivBuffer());
+        addKernelArgs(kernel);
     }
-    if (!hasInteractions)
-        return;
+    if (!includeForces && !hasInitializedEnergyKernel) {
+        // The energy-only version is only needed by callers such as Monte Carlo moves, so it is compiled
+        // the first time it is used.
+
+        hasInitializedEnergyKernel = true;
+        energyKernel = context.compileProgram(kernelSource, kernelDefines)->createKernel("computeBondedForces");
+        addKernelArgs(energyKernel);
+    }
+    ComputeKernel& kernel = (includeForces ? this->kernel : energyKernel);
     kernel->setArg(3, groups);
     Vec3 a, b, c;
     context.getPeriodicBoxVectors(a, b, c);
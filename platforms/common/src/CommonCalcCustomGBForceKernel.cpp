@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2008-2025 Stanford University and the Authors.      *
+ * Portions copyright (c) 2008-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -36,6 +36,8 @@
 #include "lepton/Operation.h"
 #include "lepton/Parser.h"
 #include "lepton/ParsedExpression.h"
+#include <iomanip>
+#include <limits>
 
 using namespace OpenMM;
 using namespace std;
@@ -144,6 +146,7 @@ void CommonCalcCustomGBForceKernel::initialize(const System& system, const Custo
     vector<const TabulatedFunction*> functionList;
     stringstream tableArgs;
     tabulatedFunctionArrays.resize(force.getNumTabulatedFunctions());
+    tabulatedFunctionValues.resize(force.getNumTabulatedFunctions());
     for (int i = 0; i < force.getNumTabulatedFunctions(); i++) {
         functionList.push_back(&force.getTabulatedFunction(i));
         string name = force.getTabulatedFunctionName(i);
@@ -153,8 +156,8 @@ void CommonCalcCustomGBForceKernel::initialize(const System& system, const Custo
         functions[name] = cc.getExpressionUtilities().getFunctionPlaceholder(force.getTabulatedFunction(i));
         int width;
         vector<float> f = cc.getExpressionUtilities().computeFunctionCoefficients(force.getTabulatedFunction(i), width);
-        tabulatedFunctionArrays[i].initialize<float>(cc, f.size(), "TabulatedFunction");
-        tabulatedFunctionArrays[i].upload(f);
+        cc.initializeSharedArray(tabulatedFunctionArrays[i], f, "TabulatedFunction");
+        tabulatedFunctionValues[i] = f;
         nb.addArgument(ComputeParameterInfo(tabulatedFunctionArrays[i], arrayName, "float", width));
         tableArgs << ", GLOBAL const float";
         if (width > 1)
@@ -429,12 +432,14 @@ void CommonCalcCustomGBForceKernel::initialize(const System& system, const Custo
         }
         stringstream n2EnergySource;
         bool anyExclusions = (force.getNumExclusions() > 0);
+        hasPairEnergyTerms = false;
         for (int i = 0; i < force.getNumEnergyTerms(); i++) {
             string expression;
             CustomGBForce::ComputationType type;
             force.getEnergyTermParameters(i, expression, type);
             if (type == CustomGBForce::SingleParticle)
                 continue;
+            hasPairEnergyTerms = true;
             bool exclude = (anyExclusions && type == CustomGBForce::ParticlePair);
             map<string, Lepton::ParsedExpression> n2EnergyExpressions;
             n2EnergyExpressions["tempEnergy += "] = Lepton::Parser::parse(expression, functions).optimize();
@@ -708,26 +713,32 @@ void CommonCalcCustomGBForceKernel::initialize(const System& system, const Custo
         for (int i = 0; i < numComputedValues; i++)
             variables[computedValueNames[i]] = "values"+computedValues->getParameterSuffix(i, "[index]");
         if (needParameterGradient) {
+            // Generate all the derivatives with a single call to createExpressions(), so subexpressions
+            // they have in common are only computed once.  The chain rule terms are added afterward.
+
+            map<string, Lepton::ParsedExpression> gradientExpressions;
             for (int i = 1; i < numComputedValues; i++) {
                 string is = cc.intToString(i);
                 compute << "real3 dV"<<is<<"dR = make_real3(0);\n";
-                for (int j = 1; j < i; j++) {
-                    if (!isZeroExpression(valueDerivExpressions[i][j])) {
-                        map<string, Lepton::ParsedExpression> derivExpressions;
-                        string js = cc.intToString(j);
-                        derivExpressions["real dV"+is+"dV"+js+" = "] = valueDerivExpressions[i][j];
-                        compute << cc.getExpressionUtilities().createExpressions(derivExpressions, variables, functionList, functionDefinitions, "temp_"+is+"_"+js);
-                        compute << "dV"<<is<<"dR += dV"<<is<<"dV"<<js<<"*dV"<<js<<"dR;\n";
-                    }
-                }
-                map<string, Lepton::ParsedExpression> gradientExpressions;
+                for (int j = 1; j < i; j++)
+                    if (!isZeroExpression(valueDerivExpressions[i][j]))
+                        gradientExpressions["real dV"+is+"dV"+cc.intToString(j)+" = "] = valueDerivExpressions[i][j];
                 if (!isZeroExpression(valueGradientExpressions[i][0]))
                     gradientExpressions["dV"+is+"dR.x += "] = valueGradientExpressions[i][0];
                 if (!isZeroExpression(valueGradientExpressions[i][1]))
                     gradientExpressions["dV"+is+"dR.y += "] = valueGradientExpressions[i][1];
                 if (!isZeroExpression(valueGradientExpressions[i][2]))
                     gradientExpressions["dV"+is+"dR.z += "] = valueGradientExpressions[i][2];
-                compute << cc.getExpressionUtilities().createExpressions(gradientExpressions, variables, functionList, functionDefinitions, "gradtemp_"+is);
+            }
+            compute << cc.getExpressionUtilities().createExpressions(gradientExpressions, variables, functionList, functionDefinitions, "gradtemp");
+            for (int i = 1; i < numComputedValues; i++) {
+                string is = cc.intToString(i);
+                for (int j = 1; j < i; j++) {
+                    if (!isZeroExpression(valueDerivExpressions[i][j])) {
+                        string js = cc.intToString(j);
+                        compute << "dV"<<is<<"dR += dV"<<is<<"dV"<<js<<"*dV"<<js<<"dR;\n";
+                    }
+                }
             }
             for (int i = 1; i < numComputedValues; i++)
                 compute << "force -= deriv"<<energyDerivs->getParameterSuffix(i)<<"*dV"<<i<<"dR;\n";
@@ -828,6 +839,136 @@ void CommonCalcCustomGBForceKernel::initialize(const System& system, const Custo
     cc.addAutoclearBuffer(longEnergyDerivs);
 }
 
+ComputeKernel CommonCalcCustomGBForceKernel::createPairValueKernel(const string& source) {
+    NonbondedUtilities& nb = cc.getNonbondedUtilities();
+    ComputeProgram program = cc.compileProgram(source, pairValueDefines);
+    ComputeKernel kernel = program->createKernel("computeN2Value");
+    int numAtomBlocks = cc.getPaddedNumAtoms()/32;
+    kernel->addArg(cc.getPosq());
+    kernel->addArg(nb.getExclusions());
+    kernel->addArg(nb.getExclusionTiles());
+    kernel->addArg(valueBuffers);
+    if (nb.getUseCutoff()) {
+        kernel->addArg(nb.getInteractingTiles());
+        kernel->addArg(nb.getInteractionCount());
+        for (int i = 0; i < 5; i++)
+            kernel->addArg(); // Periodic box size arguments are set when the kernel is executed.
+        kernel->addArg(maxTiles);
+        kernel->addArg(nb.getBlockCenters());
+        kernel->addArg(nb.getBlockBoundingBoxes());
+        kernel->addArg(nb.getInteractingAtoms());
+    }
+    else
+        kernel->addArg(numAtomBlocks*(numAtomBlocks+1)/2);
+    if (needGlobalParams)
+        kernel->addArg(cc.getGlobalParamValues());
+    for (int i = 0; i < (int) params->getParameterInfos().size(); i++) {
+        if (pairValueUsesParam[i]) {
+            ComputeParameterInfo& buffer = params->getParameterInfos()[i];
+            kernel->addArg(buffer.getArray());
+        }
+    }
+    for (auto& d : dValue0dParam)
+        kernel->addArg(d);
+    for (auto& function : tabulatedFunctionArrays)
+        kernel->addArg(function);
+    return kernel;
+}
+
+ComputeKernel CommonCalcCustomGBForceKernel::createPairEnergyKernel(const string& source) {
+    NonbondedUtilities& nb = cc.getNonbondedUtilities();
+    ComputeProgram program = cc.compileProgram(source, pairEnergyDefines);
+    ComputeKernel kernel = program->createKernel("computeN2Energy");
+    int numAtomBlocks = cc.getPaddedNumAtoms()/32;
+    kernel->addArg(cc.getLongForceBuffer());
+    kernel->addArg(cc.getEnergyBuffer());
+    kernel->addArg(cc.getPosq());
+    kernel->addArg(nb.getExclusions());
+    kernel->addArg(nb.getExclusionTiles());
+    kernel->addArg(); // Whether to include energy.
+    if (nb.getUseCutoff()) {
+        kernel->addArg(nb.getInteractingTiles());
+        kernel->addArg(nb.getInteractionCount());
+        for (int i = 0; i < 5; i++)
+            kernel->addArg(); // Periodic box size arguments are set when the kernel is executed.
+        kernel->addArg(maxTiles);
+        kernel->addArg(nb.getBlockCenters());
+        kernel->addArg(nb.getBlockBoundingBoxes());
+        kernel->addArg(nb.getInteractingAtoms());
+    }
+    else
+        kernel->addArg(numAtomBlocks*(numAtomBlocks+1)/2);
+    if (needGlobalParams)
+        kernel->addArg(cc.getGlobalParamValues());
+    for (int i = 0; i < (int) params->getParameterInfos().size(); i++) {
+        if (pairEnergyUsesParam[i]) {
+            ComputeParameterInfo& buffer = params->getParameterInfos()[i];
+            kernel->addArg(buffer.getArray());
+        }
+    }
+    for (int i = 0; i < (int) computedValues->getParameterInfos().size(); i++) {
+        if (pairEnergyUsesValue[i]) {
+            ComputeParameterInfo& buffer = computedValues->getParameterInfos()[i];
+            kernel->addArg(buffer.getArray());
+        }
+    }
+    kernel->addArg(longEnergyDerivs);
+    if (needEnergyParamDerivs)
+        kernel->addArg(cc.getEnergyParamDerivBuffer());
+    for (auto& function : tabulatedFunctionArrays)
+        kernel->addArg(function);
+    return kernel;
+}
+
+string CommonCalcCustomGBForceKernel::specializeGlobals(const string& source) {
+    // Replace every reference to a global parameter with its current value, formatted so
+    // it rounds to exactly the value stored in the globals array.
+
+    map<string, string> replacements;
+    for (int i = 0; i < globalParams.size(); i++) {
+        stringstream value;
+        if (cc.getUseDoublePrecision())
+            value << setprecision(17) << scientific << globalParamValues[i];
+        else
+            value << setprecision(9) << scientific << (float) globalParamValues[i] << "f";
+        replacements["globals["+cc.intToString(globalParams[i].first)+"]"] = "("+value.str()+")";
+    }
+    return cc.replaceStrings(source, replacements);
+}
+
+void CommonCalcCustomGBForceKernel::updateKernelSpecialization(ContextImpl& context) {
+    // Global parameters are read from memory so they can change at any time, but that prevents the
+    // compiler from simplifying expressions that involve them.  Once none of them has changed for a
+    // while, compile versions of the pairwise kernels with their values inlined.  If one changes,
+    // switch back to the generic kernels, and wait twice as long before trying again.
+
+    bool changed = false;
+    for (int i = 0; i < globalParams.size(); i++) {
+        double value = context.getParameter(globalParams[i].second);
+        if (value != globalParamValues[i]) {
+            globalParamValues[i] = value;
+            changed = true;
+        }
+    }
+    if (changed) {
+        stableSteps = 0;
+        if (useSpecializedKernels) {
+            useSpecializedKernels = false;
+            pairValueKernel = genericPairValueKernel;
+            pairEnergyKernel = genericPairEnergyKernel;
+            specializationThreshold = min(2*specializationThreshold, 1<<30);
+        }
+    }
+    else if (!useSpecializedKernels && ++stableSteps >= specializationThreshold) {
+        useSpecializedKernels = true;
+        specializedPairValueKernel = createPairValueKernel(specializeGlobals(pairValueSrc));
+        if (hasPairEnergyTerms)
+            specializedPairEnergyKernel = createPairEnergyKernel(specializeGlobals(pairEnergySrc));
+        pairValueKernel = specializedPairValueKernel;
+        pairEnergyKernel = specializedPairEnergyKernel;
+    }
+}
+
 double CommonCalcCustomGBForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
     ContextSelector selector(cc);
     NonbondedUtilities& nb = cc.getNonbondedUtilities();
@@ -835,69 +976,30 @@ double CommonCalcCustomGBForceKernel::execute(ContextImpl& context, bool include
         hasInitializedKernels = true;
 
         // These two kernels can't be compiled in initialize(), because the nonbonded utilities object
-        // has not yet been initialized then.
+        // has not yet been initialized then.  All pairwise energy terms are evaluated by a single
+        // traversal of the neighbor list, which can be skipped entirely if there are none.  The source
+        // code is kept in case specialized versions are compiled later.
 
-        {
-            int numExclusionTiles = nb.getExclusionTiles().getSize();
-            pairValueDefines["NUM_TILES_WITH_EXCLUSIONS"] = cc.intToString(numExclusionTiles);
-            int numContexts = cc.getNumContexts();
-            int startExclusionIndex = cc.getContextIndex()*numExclusionTiles/numContexts;
-            int endExclusionIndex = (cc.getContextIndex()+1)*numExclusionTiles/numContexts;
-            pairValueDefines["FIRST_EXCLUSION_TILE"] = cc.intToString(startExclusionIndex);
-            pairValueDefines["LAST_EXCLUSION_TILE"] = cc.intToString(endExclusionIndex);
-            pairValueDefines["CUTOFF"] = cc.doubleToString(cutoff);
-            ComputeProgram program = cc.compileProgram(pairValueSrc, pairValueDefines);
-            pairValueKernel = program->createKernel("computeN2Value");
-            pairValueSrc = "";
-            pairValueDefines.clear();
+        maxTiles = (nb.getUseCutoff() ? nb.getInteractingTiles().getSize() : 0);
+        int numExclusionTiles = nb.getExclusionTiles().getSize();
+        int numContexts = cc.getNumContexts();
+        int startExclusionIndex = cc.getContextIndex()*numExclusionTiles/numContexts;
+        int endExclusionIndex = (cc.getContextIndex()+1)*numExclusionTiles/numContexts;
+        for (map<string, string>* defines : {&pairValueDefines, &pairEnergyDefines}) {
+            (*defines)["NUM_TILES_WITH_EXCLUSIONS"] = cc.intToString(numExclusionTiles);
+            (*defines)["FIRST_EXCLUSION_TILE"] = cc.intToString(startExclusionIndex);
+            (*defines)["LAST_EXCLUSION_TILE"] = cc.intToString(endExclusionIndex);
+            (*defines)["CUTOFF"] = cc.doubleToString(cutoff);
         }
-        {
-            int numExclusionTiles = nb.getExclusionTiles().getSize();
-            pairEnergyDefines["NUM_TILES_WITH_EXCLUSIONS"] = cc.intToString(numExclusionTiles);
-            int numContexts = cc.getNumContexts();
-            int startExclusionIndex = cc.getContextIndex()*numExclusionTiles/numContexts;
-            int endExclusionIndex = (cc.getContextIndex()+1)*numExclusionTiles/numContexts;
-            pairEnergyDefines["FIRST_EXCLUSION_TILE"] = cc.intToString(startExclusionIndex);
-            pairEnergyDefines["LAST_EXCLUSION_TILE"] = cc.intToString(endExclusionIndex);
-            pairEnergyDefines["CUTOFF"] = cc.doubleToString(cutoff);
-            ComputeProgram program = cc.compileProgram(pairEnergySrc, pairEnergyDefines);
-            pairEnergyKernel = program->createKernel("computeN2Energy");
-            pairEnergySrc = "";
-            pairEnergyDefines.clear();
+        genericPairValueKernel = createPairValueKernel(pairValueSrc);
+        pairValueKernel = genericPairValueKernel;
+        if (hasPairEnergyTerms) {
+            genericPairEnergyKernel = createPairEnergyKernel(pairEnergySrc);
+            pairEnergyKernel = genericPairEnergyKernel;
         }
 
-        // Set arguments for kernels.
+        // Set arguments for the other kernels.
 
-        maxTiles = (nb.getUseCutoff() ? nb.getInteractingTiles().getSize() : 0);
-        int numAtomBlocks = cc.getPaddedNumAtoms()/32;
-        pairValueKernel->addArg(cc.getPosq());
-        pairValueKernel->addArg(cc.getNonbondedUtilities().getExclusions());
-        pairValueKernel->addArg(cc.getNonbondedUtilities().getExclusionTiles());
-        pairValueKernel->addArg(valueBuffers);
-        if (nb.getUseCutoff()) {
-            pairValueKernel->addArg(nb.getInteractingTiles());
-            pairValueKernel->addArg(nb.getInteractionCount());
-            for (int i = 0; i < 5; i++)
-                pairValueKernel->addArg(); // Periodic box size arguments are set when the kernel is executed.
-            pairValueKernel->addArg(maxTiles);
-            pairValueKernel->addArg(nb.getBlockCenters());
-            pairValueKernel->addArg(nb.getBlockBoundingBoxes());
-            pairValueKernel->addArg(nb.getInteractingAtoms());
-        }
-        else
-            pairValueKernel->addArg(numAtomBlocks*(numAtomBlocks+1)/2);
-        if (needGlobalParams)
-            pairValueKernel->addArg(cc.getGlobalParamValues());
-        for (int i = 0; i < (int) params->getParameterInfos().size(); i++) {
-            if (pairValueUsesParam[i]) {
-                ComputeParameterInfo& buffer = params->getParameterInfos()[i];
-                pairValueKernel->addArg(buffer.getArray());
-            }
-        }
-        for (auto& d : dValue0dParam)
-            pairValueKernel->addArg(d);
-        for (auto& function : tabulatedFunctionArrays)
-            pairValueKernel->addArg(function);
         perParticleValueKernel->addArg(cc.getPosq());
         perParticleValueKernel->addArg(valueBuffers);
         if (needGlobalParams)
@@ -913,43 +1015,6 @@ double CommonCalcCustomGBForceKernel::execute(ContextImpl& context, bool include
         }
         for (auto& function : tabulatedFunctionArrays)
             perParticleValueKernel->addArg(function);
-        pairEnergyKernel->addArg(cc.getLongForceBuffer());
-        pairEnergyKernel->addArg(cc.getEnergyBuffer());
-        pairEnergyKernel->addArg(cc.getPosq());
-        pairEnergyKernel->addArg(cc.getNonbondedUtilities().getExclusions());
-        pairEnergyKernel->addArg(cc.getNonbondedUtilities().getExclusionTiles());
-        pairEnergyKernel->addArg(); // Whether to include energy.
-        if (nb.getUseCutoff()) {
-            pairEnergyKernel->addArg(nb.getInteractingTiles());
-            pairEnergyKernel->addArg(nb.getInteractionCount());
-            for (int i = 0; i < 5; i++)
-                pairEnergyKernel->addArg(); // Periodic box size arguments are set when the kernel is executed.
-            pairEnergyKernel->addArg(maxTiles);
-            pairEnergyKernel->addArg(nb.getBlockCenters());
-            pairEnergyKernel->addArg(nb.getBlockBoundingBoxes());
-            pairEnergyKernel->addArg(nb.getInteractingAtoms());
-        }
-        else
-            pairEnergyKernel->addArg(numAtomBlocks*(numAtomBlocks+1)/2);
-        if (needGlobalParams)
-            pairEnergyKernel->addArg(cc.getGlobalParamValues());
-        for (int i = 0; i < (int) params->getParameterInfos().size(); i++) {
-            if (pairEnergyUsesParam[i]) {
-                ComputeParameterInfo& buffer = params->getParameterInfos()[i];
-                pairEnergyKernel->addArg(buffer.getArray());
-            }
-        }
-        for (int i = 0; i < (int) computedValues->getParameterInfos().size(); i++) {
-            if (pairEnergyUsesValue[i]) {
-                ComputeParameterInfo& buffer = computedValues->getParameterInfos()[i];
-                pairEnergyKernel->addArg(buffer.getArray());
-            }
-        }
-        pairEnergyKernel->addArg(longEnergyDerivs);
-        if (needEnergyParamDerivs)
-            pairEnergyKernel->addArg(cc.getEnergyParamDerivBuffer());
-        for (auto& function : tabulatedFunctionArrays)
-            pairEnergyKernel->addArg(function);
         perParticleEnergyKernel->addArg(cc.getEnergyBuffer());
         perParticleEnergyKernel->addArg(cc.getPosq());
         perParticleEnergyKernel->addArg(cc.getLongForceBuffer());
@@ -989,19 +1054,28 @@ double CommonCalcCustomGBForceKernel::execute(ContextImpl& context, bool include
                 gradientChainRuleKernel->addArg(function);
         }
     }
-    pairEnergyKernel->setArg(5, (int) includeEnergy);
+    if (needGlobalParams)
+        updateKernelSpecialization(context);
+    if (hasPairEnergyTerms)
+        pairEnergyKernel->setArg(5, (int) includeEnergy);
     if (nb.getUseCutoff()) {
         setPeriodicBoxArgs(cc, pairValueKernel, 6);
-        setPeriodicBoxArgs(cc, pairEnergyKernel, 8);
+        if (hasPairEnergyTerms)
+            setPeriodicBoxArgs(cc, pairEnergyKernel, 8);
         if (maxTiles < nb.getInteractingTiles().getSize()) {
             maxTiles = nb.getInteractingTiles().getSize();
-            pairValueKernel->setArg(11, maxTiles);
-            pairEnergyKernel->setArg(13, maxTiles);
+            for (ComputeKernel kernel : {genericPairValueKernel, specializedPairValueKernel})
+                if (kernel)
+                    kernel->setArg(11, maxTiles);
+            for (ComputeKernel kernel : {genericPairEnergyKernel, specializedPairEnergyKernel})
+                if (kernel)
+                    kernel->setArg(13, maxTiles);
         }
     }
     pairValueKernel->execute(nb.getNumForceThreadBlocks()*nb.getForceThreadBlockSize(), nb.getForceThreadBlockSize());
     perParticleValueKernel->execute(cc.getPaddedNumAtoms());
-    pairEnergyKernel->execute(nb.getNumForceThreadBlocks()*nb.getForceThreadBlockSize(), nb.getForceThreadBlockSize());
+    if (hasPairEnergyTerms)
+        pairEnergyKernel->execute(nb.getNumForceThreadBlocks()*nb.getForceThreadBlockSize(), nb.getForceThreadBlockSize());
     perParticleEnergyKernel->execute(cc.getPaddedNumAtoms());
     if (needParameterGradient || needEnergyParamDerivs)
         gradientChainRuleKernel->execute(cc.getPaddedNumAtoms());
@@ -1031,9 +1105,7 @@ void CommonCalcCustomGBForceKernel::copyParametersToContext(ContextImpl& context
         string name = force.getTabulatedFunctionName(i);
         if (force.getTabulatedFunction(i).getUpdateCount() != tabulatedFunctionUpdateCount[name]) {
             tabulatedFunctionUpdateCount[name] = force.getTabulatedFunction(i).getUpdateCount();
-            int width;
-            vector<float> f = cc.getExpressionUtilities().computeFunctionCoefficients(force.getTabulatedFunction(i), width);
-            tabulatedFunctionArrays[i].upload(f);
+            cc.getExpressionUtilities().updateFunctionCoefficients(force.getTabulatedFunction(i), tabulatedFunctionArrays[i], tabulatedFunctionValues[i]);
         }
     }
 
@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2008-2025 Stanford University and the Authors.      *
+ * Portions copyright (c) 2008-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -233,6 +233,7 @@ void CommonCalcCustomHbondForceKernel::initialize(const System& system, const Cu
     vector<const TabulatedFunction*> functionList;
     stringstream tableArgs;
     tabulatedFunctionArrays.resize(force.getNumTabulatedFunctions());
+    tabulatedFunctionValues.resize(force.getNumTabulatedFunctions());
     for (int i = 0; i < force.getNumTabulatedFunctions(); i++) {
         functionList.push_back(&force.getTabulatedFunction(i));
         string name = force.getTabulatedFunctionName(i);
@@ -242,8 +243,8 @@ void CommonCalcCustomHbondForceKernel::initialize(const System& system, const Cu
         functions[name] = cc.getExpressionUtilities().getFunctionPlaceholder(force.getTabulatedFunction(i));
         int width;
         vector<float> f = cc.getExpressionUtilities().computeFunctionCoefficients(force.getTabulatedFunction(i), width);
-        tabulatedFunctionArrays[i].initialize<float>(cc, f.size(), "TabulatedFunction");
-        tabulatedFunctionArrays[i].upload(f);
+        cc.initializeSharedArray(tabulatedFunctionArrays[i], f, "TabulatedFunction");
+        tabulatedFunctionValues[i] = f;
         tableArgs << ", GLOBAL const float";
         if (width > 1)
             tableArgs << width;
@@ -542,9 +543,7 @@ void CommonCalcCustomHbondForceKernel::copyParametersToContext(ContextImpl& cont
         string name = force.getTabulatedFunctionName(i);
         if (force.getTabulatedFunction(i).getUpdateCount() != tabulatedFunctionUpdateCount[name]) {
             tabulatedFunctionUpdateCount[name] = force.getTabulatedFunction(i).getUpdateCount();
-            int width;
-            vector<float> f = cc.getExpressionUtilities().computeFunctionCoefficients(force.getTabulatedFunction(i), width);
-            tabulatedFunctionArrays[i].upload(f);
+            cc.getExpressionUtilities().updateFunctionCoefficients(force.getTabulatedFunction(i), tabulatedFunctionArrays[i], tabulatedFunctionValues[i]);
         }
     }
 
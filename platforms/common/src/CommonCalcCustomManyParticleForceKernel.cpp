@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2008-2025 Stanford University and the Authors.      *
+ * Portions copyright (c) 2008-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -88,8 +88,8 @@ void CommonCalcCustomManyParticleForceKernel::initialize(const System& system, c
     int particlesPerSet = force.getNumParticlesPerSet();
     bool centralParticleMode = (force.getPermutationMode() == CustomManyParticleForce::UniqueCentralParticle);
     nonbondedMethod = CalcCustomManyParticleForceKernel::NonbondedMethod(force.getNonbondedMethod());
+    cutoff = force.getCutoffDistance();
     forceWorkgroupSize = 128;
-    findNeighborsWorkgroupSize = (cc.getSIMDWidth() >= 32 ? 128 : 32);
 
     // Record parameter values.
 
@@ -114,6 +114,7 @@ void CommonCalcCustomManyParticleForceKernel::initialize(const System& system, c
     vector<const TabulatedFunction*> functionList;
     stringstream tableArgs;
     tabulatedFunctionArrays.resize(force.getNumTabulatedFunctions());
+    tabulatedFunctionValues.resize(force.getNumTabulatedFunctions());
     for (int i = 0; i < force.getNumTabulatedFunctions(); i++) {
         functionList.push_back(&force.getTabulatedFunction(i));
         string name = force.getTabulatedFunctionName(i);
@@ -123,8 +124,8 @@ void CommonCalcCustomManyParticleForceKernel::initialize(const System& system, c
         functions[name] = cc.getExpressionUtilities().getFunctionPlaceholder(force.getTabulatedFunction(i));
         int width;
         vector<float> f = cc.getExpressionUtilities().computeFunctionCoefficients(force.getTabulatedFunction(i), width);
-        tabulatedFunctionArrays[i].initialize<float>(cc, f.size(), "TabulatedFunction");
-        tabulatedFunctionArrays[i].upload(f);
+        cc.initializeSharedArray(tabulatedFunctionArrays[i], f, "TabulatedFunction");
+        tabulatedFunctionValues[i] = f;
         tableArgs << ", GLOBAL const float";
         if (width > 1)
             tableArgs << width;
@@ -174,7 +175,27 @@ void CommonCalcCustomManyParticleForceKernel::initialize(const System& system, c
             for (int j = 0; j < particlesPerSet; j++)
                 flattenedOrder[i*particlesPerSet+j] = particleOrderVec[i][j];
         particleOrder.upload(flattenedOrder);
+        if (nonbondedMethod != NoCutoff) {
+            // Record which types can be neighbors of each type.  A neighbor of particle p1 can only be p2, p3,
+            // etc. in a set, so it is needed only if some set of types that passes the filters combines
+            // them in those positions.
+
+            vector<int> allowed(numTypes*numTypes, 0);
+            for (int i = 0; i < (int) orderIndexVec.size(); i++) {
+                if (orderIndexVec[i] == -1)
+                    continue;
+                int type1 = i%numTypes;
+                int index = i/numTypes;
+                for (int j = 1; j < particlesPerSet; j++) {
+                    allowed[type1*numTypes+index%numTypes] = 1;
+                    index /= numTypes;
+                }
+            }
+            neighborTypeAllowed.initialize<int>(cc, allowed.size(), "customManyParticleNeighborTypeAllowed");
+            neighborTypeAllowed.upload(allowed);
+        }
     }
+    numCellTypes = (hasTypeFilters ? numTypes : 1);
 
     // Build data structures for exclusions.
 
@@ -202,21 +223,27 @@ void CommonCalcCustomManyParticleForceKernel::initialize(const System& system, c
 
     // Build data structures for the neighbor list.
 
-    int numAtomBlocks = cc.getPaddedNumAtoms()/32;
     if (nonbondedMethod != NoCutoff) {
+        // Atoms are sorted into a grid of cells at least as wide as the cutoff.  Limit the number
+        // of cells to the number of atoms, so the grid does not become very sparse.
+
+        maxCells = max(1, numParticles);
         int elementSize = (cc.getUseDoublePrecision() ? sizeof(double) : sizeof(float));
-        blockCenter.initialize(cc, numAtomBlocks, 4*elementSize, "blockCenter");
-        blockBoundingBox.initialize(cc, numAtomBlocks, 4*elementSize, "blockBoundingBox");
-        numNeighborPairs.initialize<int>(cc, 1, "customManyParticleNumNeighborPairs");
-        neighborStartIndex.initialize<int>(cc, numParticles+1, "customManyParticleNeighborStartIndex");
+        atomCell.initialize<int>(cc, numParticles, "customManyParticleAtomCell");
+        atomIndexInCell.initialize<int>(cc, numParticles, "customManyParticleAtomIndexInCell");
+        cellCount.initialize<int>(cc, numCellTypes*maxCells, "customManyParticleCellCount");
+        cellStart.initialize<int>(cc, numCellTypes*maxCells+1, "customManyParticleCellStart");
+        sortedAtoms.initialize<int>(cc, numParticles, "customManyParticleSortedAtoms");
+        sortedPos.initialize(cc, numParticles, 4*elementSize, "customManyParticleSortedPos");
+        numOverflows.initialize<int>(cc, 1, "customManyParticleNumOverflows");
         numNeighborsForAtom.initialize<int>(cc, numParticles, "customManyParticleNumNeighborsForAtom");
+        cc.clearBuffer(cellCount);
 
-        // Select a size for the array that holds the neighbor list.  We have to make a fairly
+        // Select the number of neighbors to allocate space for.  We have to make a fairly
         // arbitrary guess, but if this turns out to be too small we'll increase it later.
 
-        maxNeighborPairs = 150*numParticles;
-        neighborPairs.initialize<mm_int2>(cc, maxNeighborPairs, "customManyParticleNeighborPairs");
-        neighbors.initialize<int>(cc, maxNeighborPairs, "customManyParticleNeighbors");
+        maxNeighbors = 32;
+        neighbors.initialize<int>(cc, maxNeighbors*numParticles, "customManyParticleNeighbors");
     }
 
     // Generate the kernel.
@@ -377,18 +404,44 @@ void CommonCalcCustomManyParticleForceKernel::initialize(const System& system, c
     defines["PADDED_NUM_ATOMS"] = cc.intToString(cc.getPaddedNumAtoms());
     defines["M_PI"] = cc.doubleToString(M_PI);
     defines["CUTOFF_SQUARED"] = cc.doubleToString(force.getCutoffDistance()*force.getCutoffDistance());
-    defines["TILE_SIZE"] = cc.intToString(32);
-    defines["NUM_BLOCKS"] = cc.intToString(numAtomBlocks);
-    defines["FIND_NEIGHBORS_WORKGROUP_SIZE"] = cc.intToString(findNeighborsWorkgroupSize);
+    defines["INV_CELL_SIZE"] = cc.doubleToString(1.0/force.getCutoffDistance());
+    defines["NUM_TYPES"] = cc.intToString(numCellTypes);
     ComputeProgram program = cc.compileProgram(cc.replaceStrings(CommonKernelSources::pointFunctions+CommonKernelSources::customManyParticle, replacements), defines);
     forceKernel = program->createKernel("computeInteraction");
-    blockBoundsKernel = program->createKernel("findBlockBounds");
-    neighborsKernel = program->createKernel("findNeighbors");
-    startIndicesKernel = program->createKernel("computeNeighborStartIndices");
-    copyPairsKernel = program->createKernel("copyPairsToNeighborList");
+    if (nonbondedMethod != NoCutoff) {
+        cellsKernel = program->createKernel("findAtomCells");
+        cellStartKernel = program->createKernel("computeCellStartIndices");
+        sortKernel = program->createKernel("sortAtomsByCell");
+        neighborsKernel = program->createKernel("findNeighbors");
+    }
     event = cc.createEvent();
 }
 
+mm_int4 CommonCalcCustomManyParticleForceKernel::selectCellGrid() {
+    if (nonbondedMethod != CutoffPeriodic)
+        return mm_int4(0, 0, 0, maxCells);
+
+    // Divide each box vector into as many pieces as possible, while keeping the distance between
+    // opposite faces of every cell at least as large as the cutoff.
+
+    Vec3 a, b, c;
+    cc.getPeriodicBoxVectors(a, b, c);
+    double volume = a[0]*b[1]*c[2];
+    Vec3 bc = b.cross(c), ca = c.cross(a), ab = a.cross(b);
+    int nx = max(1, (int) floor(volume/(sqrt(bc.dot(bc))*cutoff)));
+    int ny = max(1, (int) floor(volume/(sqrt(ca.dot(ca))*cutoff)));
+    int nz = max(1, (int) floor(volume/(sqrt(ab.dot(ab))*cutoff)));
+    while ((long long) nx*ny*nz > maxCells) {
+        if (nx >= ny && nx >= nz)
+            nx = max(1, nx/2);
+        else if (ny >= nz)
+            ny = max(1, ny/2);
+        else
+            nz = max(1, nz/2);
+    }
+    return mm_int4(nx, ny, nz, nx*ny*nz);
+}
+
 double CommonCalcCustomManyParticleForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
     ContextSelector selector(cc);
     if (!hasInitializedKernel) {
@@ -404,7 +457,8 @@ double CommonCalcCustomManyParticleForceKernel::execute(ContextImpl& context, bo
         setPeriodicBoxArgs(cc, forceKernel, 3);
         if (nonbondedMethod != NoCutoff) {
             forceKernel->addArg(neighbors);
-            forceKernel->addArg(neighborStartIndex);
+            forceKernel->addArg(numNeighborsForAtom);
+            forceKernel->addArg(maxNeighbors);
         }
         if (particleTypes.isInitialized()) {
             forceKernel->addArg(particleTypes);
@@ -423,64 +477,77 @@ double CommonCalcCustomManyParticleForceKernel::execute(ContextImpl& context, bo
             forceKernel->addArg(function);
 
         if (nonbondedMethod != NoCutoff) {
-            // Set arguments for the block bounds kernel.
+            // Set arguments for the kernel to assign atoms to cells.
 
             for (int i = 0; i < 5; i++)
-                blockBoundsKernel->addArg(); // Periodic box information will be set just before it is executed.
-            blockBoundsKernel->addArg(cc.getPosq());
-            blockBoundsKernel->addArg(blockCenter);
-            blockBoundsKernel->addArg(blockBoundingBox);
-            blockBoundsKernel->addArg(numNeighborPairs);
+                cellsKernel->addArg(); // Periodic box information will be set just before it is executed.
+            cellsKernel->addArg(cc.getPosq());
+            cellsKernel->addArg(); // The cell grid will be set just before it is executed.
+            cellsKernel->addArg(atomCell);
+            cellsKernel->addArg(atomIndexInCell);
+            cellsKernel->addArg(cellCount);
+            cellsKernel->addArg(numOverflows);
+            if (particleTypes.isInitialized())
+                cellsKernel->addArg(particleTypes);
+
+            // Set arguments for the kernel to find cell start indices.
+
+            cellStartKernel->addArg(cellCount);
+            cellStartKernel->addArg(cellStart);
+            cellStartKernel->addArg(); // The number of cells will be set just before it is executed.
+
+            // Set arguments for the kernel to sort atoms by cell.
+
+            sortKernel->addArg(cc.getPosq());
+            sortKernel->addArg(atomCell);
+            sortKernel->addArg(atomIndexInCell);
+            sortKernel->addArg(cellStart);
+            sortKernel->addArg(sortedAtoms);
+            sortKernel->addArg(sortedPos);
 
             // Set arguments for the neighbor list kernel.
 
             for (int i = 0; i < 5; i++)
                 neighborsKernel->addArg(); // Periodic box information will be set just before it is executed.
             neighborsKernel->addArg(cc.getPosq());
-            neighborsKernel->addArg(blockCenter);
-            neighborsKernel->addArg(blockBoundingBox);
-            neighborsKernel->addArg(neighborPairs);
-            neighborsKernel->addArg(numNeighborPairs);
+            neighborsKernel->addArg(); // The cell grid will be set just before it is executed.
+            neighborsKernel->addArg(cellStart);
+            neighborsKernel->addArg(sortedAtoms);
+            neighborsKernel->addArg(sortedPos);
+            neighborsKernel->addArg(neighbors);
             neighborsKernel->addArg(numNeighborsForAtom);
-            neighborsKernel->addArg(maxNeighborPairs);
+            neighborsKernel->addArg(numOverflows);
+            neighborsKernel->addArg(maxNeighbors);
+            if (particleTypes.isInitialized()) {
+                neighborsKernel->addArg(particleTypes);
+                neighborsKernel->addArg(neighborTypeAllowed);
+            }
             if (exclusions.isInitialized()) {
                 neighborsKernel->addArg(exclusions);
                 neighborsKernel->addArg(exclusionStartIndex);
             }
-
-            // Set arguments for the kernel to find neighbor list start indices.
-
-            startIndicesKernel->addArg(numNeighborsForAtom);
-            startIndicesKernel->addArg(neighborStartIndex);
-            startIndicesKernel->addArg(numNeighborPairs);
-            startIndicesKernel->addArg(maxNeighborPairs);
-
-            // Set arguments for the kernel to assemble the final neighbor list.
-
-            copyPairsKernel->addArg(neighborPairs);
-            copyPairsKernel->addArg(neighbors);
-            copyPairsKernel->addArg(numNeighborPairs);
-            copyPairsKernel->addArg(maxNeighborPairs);
-            copyPairsKernel->addArg(numNeighborsForAtom);
-            copyPairsKernel->addArg(neighborStartIndex);
        }
     }
     while (true) {
-        int* numPairs = (int*) cc.getPinnedBuffer();
+        int* overflows = (int*) cc.getPinnedBuffer();
         if (nonbondedMethod != NoCutoff) {
+            mm_int4 cellGrid = selectCellGrid();
             setPeriodicBoxArgs(cc, forceKernel, 3);
-            setPeriodicBoxArgs(cc, blockBoundsKernel, 0);
+            setPeriodicBoxArgs(cc, cellsKernel, 0);
             setPeriodicBoxArgs(cc, neighborsKernel, 0);
-            blockBoundsKernel->execute(cc.getPaddedNumAtoms()/32);
-            neighborsKernel->execute(cc.getNumAtoms(), findNeighborsWorkgroupSize);
+            cellsKernel->setArg(6, cellGrid);
+            cellStartKernel->setArg(2, numCellTypes*cellGrid.w);
+            neighborsKernel->setArg(6, cellGrid);
+            cellsKernel->execute(cc.getNumAtoms());
+            cellStartKernel->execute(256, 256);
+            sortKernel->execute(cc.getNumAtoms());
+            neighborsKernel->execute(cc.getNumAtoms());
 
             // We need to make sure there was enough memory for the neighbor list.  Download the
             // information asynchronously so kernels can be running at the same time.
 
-            numNeighborPairs.download(numPairs, false);
+            numOverflows.download(overflows, false);
             event->enqueue();
-            startIndicesKernel->execute(256, 256);
-            copyPairsKernel->execute(maxNeighborPairs);
         }
         int maxThreads = min(cc.getNumAtoms()*forceWorkgroupSize, (int) cc.getEnergyBuffer().getSize());
         forceKernel->execute(maxThreads, forceWorkgroupSize);
@@ -488,15 +555,15 @@ double CommonCalcCustomManyParticleForceKernel::execute(ContextImpl& context, bo
             // Make sure there was enough memory for the neighbor list.
 
             event->wait();
-            if (*numPairs > maxNeighborPairs) {
-                // Resize the arrays and run the calculation again.
-
-                maxNeighborPairs = (int) (1.1*(*numPairs));
-                neighborPairs.resize(maxNeighborPairs);
-                neighbors.resize(maxNeighborPairs);
-                neighborsKernel->setArg(11, maxNeighborPairs);
-                startIndicesKernel->setArg(3, maxNeighborPairs);
-                copyPairsKernel->setArg(3, maxNeighborPairs);
+            if (*overflows > 0) {
+                // Resize the neighbor list and run the calculation again.
+
+                vector<int> counts;
+                numNeighborsForAtom.download(counts);
+                maxNeighbors = (int) (1.1*(*max_element(counts.begin(), counts.end())));
+                neighbors.resize(maxNeighbors*cc.getNumAtoms());
+                forceKernel->setArg(10, maxNeighbors);
+                neighborsKernel->setArg(13, maxNeighbors);
                 continue;
             }
         }
@@ -530,9 +597,7 @@ void CommonCalcCustomManyParticleForceKernel::copyParametersToContext(ContextImp
         string name = force.getTabulatedFunctionName(i);
         if (force.getTabulatedFunction(i).getUpdateCount() != tabulatedFunctionUpdateCount[name]) {
             tabulatedFunctionUpdateCount[name] = force.getTabulatedFunction(i).getUpdateCount();
-            int width;
-            vector<float> f = cc.getExpressionUtilities().computeFunctionCoefficients(force.getTabulatedFunction(i), width);
-            tabulatedFunctionArrays[i].upload(f);
+            cc.getExpressionUtilities().updateFunctionCoefficients(force.getTabulatedFunction(i), tabulatedFunctionArrays[i], tabulatedFunctionValues[i]);
         }
     }
 
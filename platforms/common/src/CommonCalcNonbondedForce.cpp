@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2008-2025 Stanford University and the Authors.      *
+ * Portions copyright (c) 2008-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -35,6 +35,7 @@
 #include "SimTKOpenMMRealType.h"
 #include <algorithm>
 #include <assert.h>
+#include <climits>
 #include <cmath>
 #include <iterator>
 #include <set>
@@ -42,6 +43,39 @@
 using namespace OpenMM;
 using namespace std;
 
+/**
+ * Decide whether PME charge spreading should accumulate each tile of the grid in local memory.  That replaces
+ * order^3 atomic operations on global memory per atom with one per point of each occupied tile, so it only pays
+ * off when there are enough atoms per tile.  Returns the number of tiles, or 0 if charges should be spread
+ * directly onto the global grid.
+ */
+static int selectNumPmeTiles(int numAtoms, int xsize, int ysize, int zsize, int order, int tileSize) {
+    int tilesX = (xsize+tileSize-1)/tileSize;
+    int tilesY = (ysize+tileSize-1)/tileSize;
+    int tilesZ = (zsize+tileSize-1)/tileSize;
+    double numTiles = (double) tilesX*tilesY*tilesZ;
+    double subgridSize = tileSize+order-1;
+    if (numTiles*tileSize*tileSize*tileSize >= INT_MAX)
+        return 0;
+    if ((double) numAtoms*order*order*order <= numTiles*subgridSize*subgridSize*subgridSize)
+        return 0;
+    return (int) numTiles;
+}
+
+static void setPmeTileDefines(map<string, string>& defines, ComputeContext& cc, int numTiles, int xsize, int ysize, int zsize, int order, int tileSize) {
+    if (numTiles == 0) {
+        defines.erase("USE_TILED_CHARGE_SPREADING");
+        return;
+    }
+    defines["USE_TILED_CHARGE_SPREADING"] = "1";
+    defines["PME_TILE_SIZE"] = cc.intToString(tileSize);
+    defines["PME_TILE_VOLUME"] = cc.intToString(tileSize*tileSize*tileSize);
+    defines["PME_SUBGRID_SIZE"] = cc.intToString(tileSize+order-1);
+    defines["NUM_TILES_X"] = cc.intToString((xsize+tileSize-1)/tileSize);
+    defines["NUM_TILES_Y"] = cc.intToString((ysize+tileSize-1)/tileSize);
+    defines["NUM_TILES_Z"] = cc.intToString((zsize+tileSize-1)/tileSize);
+}
+
 class CommonCalcNonbondedForceKernel::ForceInfo : public ComputeForceInfo {
 public:
     ForceInfo(const NonbondedForce& force) : force(force) {
@@ -194,7 +228,12 @@ public:
     }
     double computeForceAndEnergy(bool includeForces, bool includeEnergy, int groups) {
         if ((groups&(1<<forceGroup)) != 0) {
-            event->wait();
+            // The host cannot wait for captured work, so make the main queue wait instead.
+
+            if (cc.isCapturingGraph())
+                event->queueWait(cc.getCurrentQueue());
+            else
+                event->wait();
             if (includeEnergy)
                 addEnergyKernel->execute(pmeEnergyBuffer.getSize());
         }
@@ -215,7 +254,7 @@ CommonCalcNonbondedForceKernel::~CommonCalcNonbondedForceKernel() {
 }
 
 void CommonCalcNonbondedForceKernel::commonInitialize(const System& system, const NonbondedForce& force, bool usePmeQueue,
-        bool deviceIsCpu, bool useFixedPointChargeSpreading, bool useCpuPme) {
+        bool deviceIsCpu, bool useFixedPointChargeSpreading, bool useCpuPme, bool allowTiledChargeSpreading) {
     this->usePmeQueue = false;
     this->deviceIsCpu = deviceIsCpu;
     this->useFixedPointChargeSpreading = useFixedPointChargeSpreading;
@@ -248,6 +287,7 @@ void CommonCalcNonbondedForceKernel::commonInitialize(const System& system, cons
             exceptions.push_back(i);
         }
     }
+    numForceExceptions = force.getNumExceptions();
 
     // Initialize nonbonded interactions.
 
@@ -416,6 +456,12 @@ void CommonCalcNonbondedForceKernel::commonInitialize(const System& system, cons
                 pmeDefines["USE_FIXED_POINT_CHARGE_SPREADING"] = "1";
             if (deviceIsCpu)
                 pmeDefines["DEVICE_IS_CPU"] = "1";
+            if (allowTiledChargeSpreading && !deviceIsCpu) {
+                numPmeTiles = selectNumPmeTiles(numParticles, gridSizeX, gridSizeY, gridSizeZ, PmeOrder, PmeTileSize);
+                if (doLJPME)
+                    numDispersionTiles = selectNumPmeTiles(numParticles, dispersionGridSizeX, dispersionGridSizeY, dispersionGridSizeZ, PmeOrder, PmeTileSize);
+            }
+            setPmeTileDefines(pmeDefines, cc, numPmeTiles, gridSizeX, gridSizeY, gridSizeZ, PmeOrder, PmeTileSize);
             if (useCpuPme && !doLJPME && usePosqCharges) {
                 // Create the CPU PME kernel.
 
@@ -460,6 +506,9 @@ void CommonCalcNonbondedForceKernel::commonInitialize(const System& system, cons
                 cc.clearBuffer(pmeEnergyBuffer);
                 sort = cc.createSort(new SortTrait(), cc.getNumAtoms());
                 fft = cc.createFFT(gridSizeX, gridSizeY, gridSizeZ, true);
+                usePmeFusedConvolution = fft->supportsConvolution();
+                if (usePmeFusedConvolution)
+                    pmeInfluence.initialize(cc, gridSizeX*gridSizeY*(gridSizeZ/2+1), 2*elementSize, "pmeInfluence");
                 if (doLJPME)
                     dispersionFft = cc.createFFT(dispersionGridSizeX, dispersionGridSizeY, dispersionGridSizeZ, true);
                 this->usePmeQueue = usePmeQueue;
@@ -772,6 +821,15 @@ double CommonCalcNonbondedForceKernel::execute(ContextImpl& context, bool includ
             pmeConvolutionKernel = program->createKernel("reciprocalConvolution");
             pmeEvalEnergyKernel = program->createKernel("gridEvaluateEnergy");
             pmeInterpolateForceKernel = program->createKernel("gridInterpolateForce");
+            if (usePmeFusedConvolution) {
+                pmeInfluenceKernel = program->createKernel("computeInfluenceFunction");
+                pmeInfluenceKernel->addArg(pmeInfluence);
+                pmeInfluenceKernel->addArg(pmeBsplineModuliX);
+                pmeInfluenceKernel->addArg(pmeBsplineModuliY);
+                pmeInfluenceKernel->addArg(pmeBsplineModuliZ);
+                for (int i = 0; i < 3; i++)
+                    pmeInfluenceKernel->addArg();
+            }
             pmeGridIndexKernel->addArg(cc.getPosq());
             pmeGridIndexKernel->addArg(pmeAtomGridIndex);
             for (int i = 0; i < 8; i++)
@@ -827,6 +885,7 @@ double CommonCalcNonbondedForceKernel::execute(ContextImpl& context, bool includ
                 pmeDefines["RECIP_EXP_FACTOR"] = cc.doubleToString(M_PI*M_PI/(dispersionAlpha*dispersionAlpha));
                 pmeDefines["USE_LJPME"] = "1";
                 pmeDefines["CHARGE_FROM_SIGEPS"] = "1";
+                setPmeTileDefines(pmeDefines, cc, numDispersionTiles, dispersionGridSizeX, dispersionGridSizeY, dispersionGridSizeZ, PmeOrder, PmeTileSize);
                 program = cc.compileProgram(CommonKernelSources::pme, pmeDefines);
                 pmeDispersionGridIndexKernel = program->createKernel("findAtomGridIndex");
                 pmeDispersionSpreadChargeKernel = program->createKernel("gridSpreadCharge");
@@ -937,9 +996,11 @@ double CommonCalcNonbondedForceKernel::execute(ContextImpl& context, bool includ
             ewaldForcesKernel->setArg(3, mm_float4((float) a[0], (float) b[1], (float) c[2], 0));
         }
         ewaldSumsKernel->execute(cosSinSums.getSize());
-        ewaldForcesKernel->execute(cc.getNumAtoms());
+        if (includeForces)
+            ewaldForcesKernel->execute(cc.getNumAtoms());
     }
     if (pmeGrid1.isInitialized() && includeReciprocal) {
+        ComputeContext::Annotation pmeAnnotation(cc, "PME");
         if (usePmeQueue)
             cc.setCurrentQueue(pmeQueue);
 
@@ -984,30 +1045,69 @@ double CommonCalcNonbondedForceKernel::execute(ContextImpl& context, bool includ
                 pmeSpreadChargeKernel->setArg(8, recipBoxVectorsFloat[1]);
                 pmeSpreadChargeKernel->setArg(9, recipBoxVectorsFloat[2]);
             }
-            pmeSpreadChargeKernel->execute(cc.getNumAtoms());
+            if (numPmeTiles > 0)
+                pmeSpreadChargeKernel->execute(numPmeTiles*PmeTileThreadBlockSize, PmeTileThreadBlockSize);
+            else
+                pmeSpreadChargeKernel->execute(cc.getNumAtoms());
             if (useFixedPointChargeSpreading)
                 pmeFinishSpreadChargeKernel->execute(gridSizeX*gridSizeY*gridSizeZ);
-            fft->execFFT(pmeGrid1, pmeGrid2, true);
-            if (cc.getUseDoublePrecision()) {
-                pmeConvolutionKernel->setArg<mm_double4>(4, recipBoxVectors[0]);
-                pmeConvolutionKernel->setArg<mm_double4>(5, recipBoxVectors[1]);
-                pmeConvolutionKernel->setArg<mm_double4>(6, recipBoxVectors[2]);
-                pmeEvalEnergyKernel->setArg<mm_double4>(5, recipBoxVectors[0]);
-                pmeEvalEnergyKernel->setArg<mm_double4>(6, recipBoxVectors[1]);
-                pmeEvalEnergyKernel->setArg<mm_double4>(7, recipBoxVectors[2]);
+            if (usePmeFusedConvolution && !includeEnergy) {
+                // The FFT can apply the convolution itself, so the transformed grid never needs to
+                // be written out and read back by a separate kernel.  The influence function only
+                // needs to be recomputed when the box changes.
+
+                if (boxVectors[0] != influenceBoxVectors[0] || boxVectors[1] != influenceBoxVectors[1] || boxVectors[2] != influenceBoxVectors[2]) {
+                    if (cc.getUseDoublePrecision()) {
+                        pmeInfluenceKernel->setArg<mm_double4>(4, recipBoxVectors[0]);
+                        pmeInfluenceKernel->setArg<mm_double4>(5, recipBoxVectors[1]);
+                        pmeInfluenceKernel->setArg<mm_double4>(6, recipBoxVectors[2]);
+                    }
+                    else {
+                        pmeInfluenceKernel->setArg<mm_float4>(4, recipBoxVectorsFloat[0]);
+                        pmeInfluenceKernel->setArg<mm_float4>(5, recipBoxVectorsFloat[1]);
+                        pmeInfluenceKernel->setArg<mm_float4>(6, recipBoxVectorsFloat[2]);
+                    }
+                    pmeInfluenceKernel->execute(gridSizeX*gridSizeY*(gridSizeZ/2+1));
+                    for (int i = 0; i < 3; i++)
+                        influenceBoxVectors[i] = boxVectors[i];
+                }
+                ComputeContext::Annotation annotation(cc, "PME convolution");
+                fft->execConvolution(pmeGrid1, pmeGrid2, pmeInfluence);
             }
             else {
-                pmeConvolutionKernel->setArg<mm_float4>(4, recipBoxVectorsFloat[0]);
-                pmeConvolutionKernel->setArg<mm_float4>(5, recipBoxVectorsFloat[1]);
-                pmeConvolutionKernel->setArg<mm_float4>(6, recipBoxVectorsFloat[2]);
-                pmeEvalEnergyKernel->setArg<mm_float4>(5, recipBoxVectorsFloat[0]);
-                pmeEvalEnergyKernel->setArg<mm_float4>(6, recipBoxVectorsFloat[1]);
-                pmeEvalEnergyKernel->setArg<mm_float4>(7, recipBoxVectorsFloat[2]);
+                {
+                    ComputeContext::Annotation annotation(cc, "PME forward FFT");
+                    fft->execFFT(pmeGrid1, pmeGrid2, true);
+                }
+                if (cc.getUseDoublePrecision()) {
+                    pmeConvolutionKernel->setArg<mm_double4>(4, recipBoxVectors[0]);
+                    pmeConvolutionKernel->setArg<mm_double4>(5, recipBoxVectors[1]);
+                    pmeConvolutionKernel->setArg<mm_double4>(6, recipBoxVectors[2]);
+                    pmeEvalEnergyKernel->setArg<mm_double4>(5, recipBoxVectors[0]);
+                    pmeEvalEnergyKernel->setArg<mm_double4>(6, recipBoxVectors[1]);
+                    pmeEvalEnergyKernel->setArg<mm_double4>(7, recipBoxVectors[2]);
+                }
+                else {
+                    pmeConvolutionKernel->setArg<mm_float4>(4, recipBoxVectorsFloat[0]);
+                    pmeConvolutionKernel->setArg<mm_float4>(5, recipBoxVectorsFloat[1]);
+                    pmeConvolutionKernel->setArg<mm_float4>(6, recipBoxVectorsFloat[2]);
+                    pmeEvalEnergyKernel->setArg<mm_float4>(5, recipBoxVectorsFloat[0]);
+                    pmeEvalEnergyKernel->setArg<mm_float4>(6, recipBoxVectorsFloat[1]);
+                    pmeEvalEnergyKernel->setArg<mm_float4>(7, recipBoxVectorsFloat[2]);
+                }
+                if (includeEnergy)
+                    pmeEvalEnergyKernel->execute(gridSizeX*gridSizeY*gridSizeZ);
+                if (includeForces) {
+                    pmeConvolutionKernel->execute(gridSizeX*gridSizeY*gridSizeZ);
+                    ComputeContext::Annotation annotation(cc, "PME inverse FFT");
+                    fft->execFFT(pmeGrid2, pmeGrid1, false);
+                }
             }
-            if (includeEnergy)
-                pmeEvalEnergyKernel->execute(gridSizeX*gridSizeY*gridSizeZ);
-            pmeConvolutionKernel->execute(gridSizeX*gridSizeY*gridSizeZ);
-            fft->execFFT(pmeGrid2, pmeGrid1, false);
+        }
+        if (hasCoulomb && includeForces) {
+            // The energy is computed directly from the transformed grid, so the convolution, inverse
+            // FFT, and interpolation are only needed for forces.
+
             setPeriodicBoxArgs(cc, pmeInterpolateForceKernel, 3);
             if (cc.getUseDoublePrecision()) {
                 pmeInterpolateForceKernel->setArg(8, recipBoxVectors[0]);
@@ -1026,20 +1126,27 @@ double CommonCalcNonbondedForceKernel::execute(ContextImpl& context, bool includ
         }
 
         if (doLJPME && hasLJ) {
-            setPeriodicBoxArgs(cc, pmeDispersionGridIndexKernel, 2);
-            if (cc.getUseDoublePrecision()) {
-                pmeDispersionGridIndexKernel->setArg(7, recipBoxVectors[0]);
-                pmeDispersionGridIndexKernel->setArg(8, recipBoxVectors[1]);
-                pmeDispersionGridIndexKernel->setArg(9, recipBoxVectors[2]);
-            }
-            else {
-                pmeDispersionGridIndexKernel->setArg(7, recipBoxVectorsFloat[0]);
-                pmeDispersionGridIndexKernel->setArg(8, recipBoxVectorsFloat[1]);
-                pmeDispersionGridIndexKernel->setArg(9, recipBoxVectorsFloat[2]);
-            }
-            pmeDispersionGridIndexKernel->execute(cc.getNumAtoms());
-            if (!hasCoulomb)
+            // The spreading and interpolation kernels only use pmeAtomGridIndex to visit atoms in
+            // spatially sorted order.  If the electrostatic grid already sorted them, that order works
+            // just as well for the dispersion grid, so there is no need to compute and sort it again.
+            // The exception is tiled spreading, which needs the atoms grouped by tiles of its own grid.
+
+            bool sameTiles = (numPmeTiles > 0 && gridSizeX == dispersionGridSizeX && gridSizeY == dispersionGridSizeY && gridSizeZ == dispersionGridSizeZ);
+            if (!hasCoulomb || (numDispersionTiles > 0 && !sameTiles)) {
+                setPeriodicBoxArgs(cc, pmeDispersionGridIndexKernel, 2);
+                if (cc.getUseDoublePrecision()) {
+                    pmeDispersionGridIndexKernel->setArg(7, recipBoxVectors[0]);
+                    pmeDispersionGridIndexKernel->setArg(8, recipBoxVectors[1]);
+                    pmeDispersionGridIndexKernel->setArg(9, recipBoxVectors[2]);
+                }
+                else {
+                    pmeDispersionGridIndexKernel->setArg(7, recipBoxVectorsFloat[0]);
+                    pmeDispersionGridIndexKernel->setArg(8, recipBoxVectorsFloat[1]);
+                    pmeDispersionGridIndexKernel->setArg(9, recipBoxVectorsFloat[2]);
+                }
+                pmeDispersionGridIndexKernel->execute(cc.getNumAtoms());
                 sort->sort(pmeAtomGridIndex);
+            }
             if (useFixedPointChargeSpreading)
                 cc.clearBuffer(pmeGrid2);
             else
@@ -1055,10 +1162,16 @@ double CommonCalcNonbondedForceKernel::execute(ContextImpl& context, bool includ
                 pmeDispersionSpreadChargeKernel->setArg(8, recipBoxVectorsFloat[1]);
                 pmeDispersionSpreadChargeKernel->setArg(9, recipBoxVectorsFloat[2]);
             }
-            pmeDispersionSpreadChargeKernel->execute(cc.getNumAtoms());
+            if (numDispersionTiles > 0)
+                pmeDispersionSpreadChargeKernel->execute(numDispersionTiles*PmeTileThreadBlockSize, PmeTileThreadBlockSize);
+            else
+                pmeDispersionSpreadChargeKernel->execute(cc.getNumAtoms());
             if (useFixedPointChargeSpreading)
                 pmeDispersionFinishSpreadChargeKernel->execute(gridSizeX*gridSizeY*gridSizeZ);
-            dispersionFft->execFFT(pmeGrid1, pmeGrid2, true);
+            {
+                ComputeContext::Annotation annotation(cc, "LJPME forward FFT");
+                dispersionFft->execFFT(pmeGrid1, pmeGrid2, true);
+            }
             if (cc.getUseDoublePrecision()) {
                 pmeDispersionConvolutionKernel->setArg(4, recipBoxVectors[0]);
                 pmeDispersionConvolutionKernel->setArg(5, recipBoxVectors[1]);
@@ -1079,8 +1192,13 @@ double CommonCalcNonbondedForceKernel::execute(ContextImpl& context, bool includ
                 cc.clearBuffer(pmeEnergyBuffer);
             if (includeEnergy)
                 pmeDispersionEvalEnergyKernel->execute(gridSizeX*gridSizeY*gridSizeZ);
-            pmeDispersionConvolutionKernel->execute(gridSizeX*gridSizeY*gridSizeZ);
-            dispersionFft->execFFT(pmeGrid2, pmeGrid1, false);
+            if (includeForces) {
+                pmeDispersionConvolutionKernel->execute(gridSizeX*gridSizeY*gridSizeZ);
+                ComputeContext::Annotation annotation(cc, "LJPME inverse FFT");
+                dispersionFft->execFFT(pmeGrid2, pmeGrid1, false);
+            }
+        }
+        if (doLJPME && hasLJ && includeForces) {
             setPeriodicBoxArgs(cc, pmeDispersionInterpolateForceKernel, 3);
             if (cc.getUseDoublePrecision()) {
                 pmeDispersionInterpolateForceKernel->setArg(8, recipBoxVectors[0]);
@@ -1111,13 +1229,14 @@ double CommonCalcNonbondedForceKernel::execute(ContextImpl& context, bool includ
 }
 
 void CommonCalcNonbondedForceKernel::copyParametersToContext(ContextImpl& context, const NonbondedForce& force, int firstParticle, int lastParticle, int firstException, int lastException) {
-    // Make sure the new parameters are acceptable.
+    // Make sure the new parameters are acceptable.  Only the particles and exceptions that have
+    // changed since the last update need to be checked.
 
     ContextSelector selector(cc);
     if (force.getNumParticles() != cc.getNumAtoms())
         throw OpenMMException("updateParametersInContext: The number of particles has changed");
     if (!hasCoulomb || !hasLJ) {
-        for (int i = 0; i < force.getNumParticles(); i++) {
+        for (int i = firstParticle; i <= lastParticle; i++) {
             double charge, sigma, epsilon;
             force.getParticleParameters(i, charge, sigma, epsilon);
             if (!hasCoulomb && charge != 0.0)
@@ -1126,43 +1245,36 @@ void CommonCalcNonbondedForceKernel::copyParametersToContext(ContextImpl& contex
                 throw OpenMMException("updateParametersInContext: The nonbonded force kernel does not include Lennard-Jones interactions, because all epsilons were originally 0");
         }
     }
-    set<int> exceptionsWithOffsets;
-    for (int i = 0; i < force.getNumExceptionParameterOffsets(); i++) {
-        string param;
-        int exception;
-        double charge, sigma, epsilon;
-        force.getExceptionParameterOffset(i, param, exception, charge, sigma, epsilon);
-        exceptionsWithOffsets.insert(exception);
-    }
-    vector<int> exceptions;
-    for (int i = 0; i < force.getNumExceptions(); i++) {
-        int particle1, particle2;
-        double chargeProd, sigma, epsilon;
-        force.getExceptionParameters(i, particle1, particle2, chargeProd, sigma, epsilon);
-        if (exceptionIndex.find(i) == exceptionIndex.end()) {
-            if (chargeProd != 0.0 || epsilon != 0.0 || exceptionsWithOffsets.find(i) != exceptionsWithOffsets.end())
+    if (force.getNumExceptions() < numForceExceptions)
+        throw OpenMMException("updateParametersInContext: The set of non-excluded exceptions has changed");
+    auto checkExcludedException = [&] (int index) {
+        if (exceptionIndex.find(index) == exceptionIndex.end()) {
+            int particle1, particle2;
+            double chargeProd, sigma, epsilon;
+            force.getExceptionParameters(index, particle1, particle2, chargeProd, sigma, epsilon);
+            if (chargeProd != 0.0 || epsilon != 0.0)
                 throw OpenMMException("updateParametersInContext: The set of non-excluded exceptions has changed");
         }
-        else
-            exceptions.push_back(i);
-    }
+    };
+    for (int i = firstException; i <= lastException; i++)
+        checkExcludedException(i);
+    for (int i = numForceExceptions; i < force.getNumExceptions(); i++)
+        checkExcludedException(i);
     int numContexts = cc.getNumContexts();
-    int startIndex = cc.getContextIndex()*exceptions.size()/numContexts;
-    int endIndex = (cc.getContextIndex()+1)*exceptions.size()/numContexts;
+    int startIndex = cc.getContextIndex()*exceptionIndex.size()/numContexts;
+    int endIndex = (cc.getContextIndex()+1)*exceptionIndex.size()/numContexts;
     int numExceptions = endIndex-startIndex;
-    if (numExceptions != exceptionAtoms.size())
-        throw OpenMMException("updateParametersInContext: The set of non-excluded exceptions has changed");
 
     // Record the per-particle parameters.
 
     if (firstParticle <= lastParticle) {
-        vector<mm_float4> baseParticleParamVec(cc.getPaddedNumAtoms(), mm_float4(0, 0, 0, 0));
-        for (int i = 0; i < force.getNumParticles(); i++) {
+        vector<mm_float4> baseParticleParamVec(lastParticle-firstParticle+1);
+        for (int i = firstParticle; i <= lastParticle; i++) {
             double charge, sigma, epsilon;
             force.getParticleParameters(i, charge, sigma, epsilon);
-            baseParticleParamVec[i] = mm_float4(charge, sigma, epsilon, 0);
+            baseParticleParamVec[i-firstParticle] = mm_float4(charge, sigma, epsilon, 0);
         }
-        baseParticleParams.uploadSubArray(&baseParticleParamVec[firstParticle], firstParticle, lastParticle-firstParticle+1);
+        baseParticleParams.uploadSubArray(baseParticleParamVec.data(), firstParticle, baseParticleParamVec.size());
 
         // Compute the self energy.
 
@@ -1171,28 +1283,38 @@ void CommonCalcNonbondedForceKernel::copyParametersToContext(ContextImpl& contex
         if (nonbondedMethod == Ewald || nonbondedMethod == PME || nonbondedMethod == LJPME) {
             if (cc.getContextIndex() == 0) {
                 for (int i = 0; i < force.getNumParticles(); i++) {
-                    ewaldSelfEnergy -= baseParticleParamVec[i].x*baseParticleParamVec[i].x*ONE_4PI_EPS0*alpha/sqrt(M_PI);
-                    totalCharge += baseParticleParamVec[i].x;
+                    double charge, sigma, epsilon;
+                    force.getParticleParameters(i, charge, sigma, epsilon);
+                    ewaldSelfEnergy -= charge*charge*ONE_4PI_EPS0*alpha/sqrt(M_PI);
+                    totalCharge += charge;
                     if (doLJPME)
-                        ewaldSelfEnergy += baseParticleParamVec[i].z*pow(baseParticleParamVec[i].y*dispersionAlpha, 6)/3.0;
+                        ewaldSelfEnergy += epsilon*pow(sigma*dispersionAlpha, 6)/3.0;
                 }
             }
         }
     }
 
-    // Record the exceptions.
+    // Record the exceptions.  Exceptions are stored on the device in the same order as in the
+    // Force, so the changed ones form a contiguous block.
 
     if (firstException <= lastException) {
-        vector<mm_float4> baseExceptionParamsVec(numExceptions);
-        for (int i = 0; i < numExceptions; i++) {
-            int particle1, particle2;
-            double chargeProd, sigma, epsilon;
-            force.getExceptionParameters(exceptions[startIndex+i], particle1, particle2, chargeProd, sigma, epsilon);
-            if (make_pair(particle1, particle2) != exceptionAtoms[i])
-                throw OpenMMException("updateParametersInContext: The set of non-excluded exceptions has changed");
-            baseExceptionParamsVec[i] = mm_float4(chargeProd, sigma, epsilon, 0);
+        vector<int> changed;
+        for (auto iter = exceptionIndex.lower_bound(firstException); iter != exceptionIndex.end() && iter->first <= lastException; ++iter)
+            if (iter->second >= startIndex && iter->second < endIndex)
+                changed.push_back(iter->first);
+        if (changed.size() > 0) {
+            int firstIndex = exceptionIndex[changed[0]]-startIndex;
+            vector<mm_float4> baseExceptionParamsVec(changed.size());
+            for (int i = 0; i < changed.size(); i++) {
+                int particle1, particle2;
+                double chargeProd, sigma, epsilon;
+                force.getExceptionParameters(changed[i], particle1, particle2, chargeProd, sigma, epsilon);
+                if (make_pair(particle1, particle2) != exceptionAtoms[firstIndex+i])
+                    throw OpenMMException("updateParametersInContext: The set of non-excluded exceptions has changed");
+                baseExceptionParamsVec[i] = mm_float4(chargeProd, sigma, epsilon, 0);
+            }
+            baseExceptionParams.uploadSubArray(baseExceptionParamsVec.data(), firstIndex, changed.size());
         }
-        baseExceptionParams.upload(baseExceptionParamsVec);
     }
 
     // Record parameter offsets.
@@ -1214,13 +1336,15 @@ void CommonCalcNonbondedForceKernel::copyParametersToContext(ContextImpl& contex
         int exception;
         double charge, sigma, epsilon;
         force.getExceptionParameterOffset(i, param, exception, charge, sigma, epsilon);
-        int index = exceptionIndex[exception];
-        if (index < startIndex || index >= endIndex)
+        auto index = exceptionIndex.find(exception);
+        if (index == exceptionIndex.end())
+            throw OpenMMException("updateParametersInContext: The set of non-excluded exceptions has changed");
+        if (index->second < startIndex || index->second >= endIndex)
             continue;
         auto paramIndex = paramIndices.find(param);
         if (paramIndex == paramIndices.end())
             throw OpenMMException("updateParametersInContext: The parameter of an exception parameter offset has changed");
-        exceptionOffsetVec[index-startIndex].push_back(mm_float4(charge, sigma, epsilon, paramIndex->second));
+        exceptionOffsetVec[index->second-startIndex].push_back(mm_float4(charge, sigma, epsilon, paramIndex->second));
     }
     if (max(force.getNumParticleParameterOffsets(), 1) != particleParamOffsets.getSize())
         throw OpenMMException("updateParametersInContext: The number of particle parameter offsets has changed");
@@ -1240,7 +1364,7 @@ void CommonCalcNonbondedForceKernel::copyParametersToContext(ContextImpl& contex
 
     // Compute other values.
 
-    if (force.getUseDispersionCorrection() && cc.getContextIndex() == 0 && (nonbondedMethod == CutoffPeriodic || nonbondedMethod == Ewald || nonbondedMethod == PME))
+    if (firstParticle <= lastParticle && force.getUseDispersionCorrection() && cc.getContextIndex() == 0 && (nonbondedMethod == CutoffPeriodic || nonbondedMethod == Ewald || nonbondedMethod == PME))
         dispersionCoefficient = NonbondedForceImpl::calcDispersionCorrection(context.getSystem(), force);
     cc.invalidateMolecules(info, firstParticle <= lastParticle || force.getNumParticleParameterOffsets() > 0,
                            firstException <= lastException || force.getNumExceptionParameterOffsets() > 0);
@@ -115,6 +115,15 @@ private:
     string param;
 };
 
+static bool usesCustomFunction(const ExpressionTreeNode& node) {
+    if (node.getOperation().getId() == Operation::CUSTOM)
+        return true;
+    for (auto& child : node.getChildren())
+        if (usesCustomFunction(child))
+            return true;
+    return false;
+}
+
 void CommonIntegrateCustomStepKernel::initialize(const System& system, const CustomIntegrator& integrator) {
     cc.initializeContexts();
     ContextSelector selector(cc);
@@ -331,6 +340,23 @@ void CommonIntegrateCustomStepKernel::prepareForComputation(ContextImpl& context
             }
         }
 
+        // Identify global steps that can be evaluated on the device, so their results never need to be
+        // downloaded.  This is only done when global values are stored in double precision, so the results
+        // match evaluating them on the host.  Steps that set dt or a context parameter, or that call deriv()
+        // or a tabulated function, are still evaluated on the host.
+
+        globalOnDevice.resize(numSteps, false);
+        if (useDouble) {
+            for (int step = 0; step < numSteps; step++) {
+                if (stepType[step] == CustomIntegrator::ComputeSum)
+                    globalOnDevice[step] = (stepTarget[step].type == VARIABLE);
+                else if (stepType[step] == CustomIntegrator::ComputeGlobal)
+                    globalOnDevice[step] = (stepTarget[step].type == VARIABLE && !usesCustomFunction(expression[step][0].getRootNode()));
+                if (globalOnDevice[step])
+                    needsGlobals[step] = true;
+            }
+        }
+
         // Identify which per-DOF steps are going to require global variables or context parameters.
 
         for (int step = 0; step < numSteps; step++) {
@@ -367,13 +393,33 @@ void CommonIntegrateCustomStepKernel::prepareForComputation(ContextImpl& context
             }
         }
 
-        // Identify steps that can be merged into a single kernel.
+        // Identify steps that can be merged into a single kernel.  A kernel can include at most one
+        // ComputeSum step, since there is only one buffer to sum.  Its result is not available until
+        // after the kernel finishes, so later steps can only be merged with it if they do not use
+        // the value being computed.
 
-        for (int step = 1; step < numSteps; step++) {
-            if (invalidatesForces[step-1] || forceGroupFlags[step] != forceGroupFlags[step-1])
-                continue;
-            if (stepType[step-1] == CustomIntegrator::ComputePerDof && stepType[step] == CustomIntegrator::ComputePerDof)
-                merged[step] = true;
+        mergedSumStep.resize(numSteps, -1);
+        int sumStep = -1;
+        for (int step = 0; step < numSteps; step++) {
+            bool isPerDof = (stepType[step] == CustomIntegrator::ComputePerDof || stepType[step] == CustomIntegrator::ComputeSum);
+            if (step > 0 && isPerDof && !invalidatesForces[step-1] && forceGroupFlags[step] == forceGroupFlags[step-1] &&
+                    (stepType[step-1] == CustomIntegrator::ComputePerDof || stepType[step-1] == CustomIntegrator::ComputeSum)) {
+                if (sumStep == -1)
+                    merged[step] = true;
+                else
+                    merged[step] = (stepType[step] == CustomIntegrator::ComputePerDof && stepTarget[sumStep].type == VARIABLE &&
+                            !usesVariable(expression[step][0], variable[sumStep]));
+            }
+            if (!merged[step])
+                sumStep = -1;
+            if (stepType[step] == CustomIntegrator::ComputeSum)
+                sumStep = step;
+        }
+        for (int step = numSteps-1; step >= 0; step--) {
+            if (stepType[step] == CustomIntegrator::ComputeSum)
+                mergedSumStep[step] = step;
+            if (step > 0 && merged[step] && mergedSumStep[step] != -1)
+                mergedSumStep[step-1] = mergedSumStep[step];
         }
         for (int step = numSteps-1; step > 0; step--)
             if (merged[step]) {
@@ -418,7 +464,7 @@ void CommonIntegrateCustomStepKernel::prepareForComputation(ContextImpl& context
                         else
                             compute << "velm[index] = velocity;\n";
                     }
-                    else {
+                    else if (stepType[j] == CustomIntegrator::ComputePerDof) {
                         for (int i = 0; i < perDofValues.size(); i++)
                             compute << "perDofValues"<<cc.intToString(i)<<"[index] = make_"<<perDofType<<"(perDof"<<cc.intToString(i)<<".x, perDof"<<cc.intToString(i)<<".y, perDof"<<cc.intToString(i)<<".z, 0);\n";
                     }
@@ -465,17 +511,50 @@ void CommonIntegrateCustomStepKernel::prepareForComputation(ContextImpl& context
                     kernel->addArg(array);
                 for (auto& array : tabulatedFunctions)
                     kernel->addArg(array);
-                if (stepType[step] == CustomIntegrator::ComputeSum) {
-                    // Create a second kernel for this step that sums the values.
+                int sumStep = mergedSumStep[step];
+                if (sumStep != -1) {
+                    // Create a second kernel that sums the values.
 
                     program = cc.compileProgram(CommonKernelSources::customIntegrator, defines);
                     kernel = program->createKernel(useDouble ? "computeDoubleSum" : "computeFloatSum");
                     kernels[step].push_back(kernel);
                     kernel->addArg(sumBuffer);
-                    kernel->addArg(summedValue);
-                    kernel->addArg(numAtoms);
+                    if (globalOnDevice[sumStep]) {
+                        kernel->addArg(globalValues);
+                        kernel->addArg(numAtoms);
+                        kernel->addArg(stepTarget[sumStep].variableIndex);
+                    }
+                    else {
+                        kernel->addArg(summedValue);
+                        kernel->addArg(numAtoms);
+                        kernel->addArg(0);
+                    }
                 }
             }
+            else if (stepType[step] == CustomIntegrator::ComputeGlobal && globalOnDevice[step]) {
+                // Compute a global value on the device.
+
+                map<string, Lepton::ParsedExpression> expressions;
+                expressions["globals["+cc.intToString(stepTarget[step].variableIndex)+"] = "] = expression[step][0];
+                map<string, string> variables;
+                variables["dt"] = "globals["+cc.intToString(dtVariableIndex)+"]";
+                variables["uniform"] = "uniform";
+                variables["gaussian"] = "gaussian";
+                variables[energyName[step]] = "energy";
+                for (int i = 0; i < integrator.getNumGlobalVariables(); i++)
+                    variables[integrator.getGlobalVariableName(i)] = "globals["+cc.intToString(globalVariableIndex[i])+"]";
+                for (int i = 0; i < (int) parameterNames.size(); i++)
+                    variables[parameterNames[i]] = "globals["+cc.intToString(parameterVariableIndex[i])+"]";
+                map<string, string> replacements;
+                replacements["COMPUTE_STEP"] = cc.getExpressionUtilities().createExpressions(expressions, variables, functionList, functionNames, "temp", "double");
+                ComputeProgram program = cc.compileProgram(cc.replaceStrings(CommonKernelSources::customIntegratorGlobal, replacements), defines);
+                ComputeKernel kernel = program->createKernel("computeGlobal");
+                kernels[step].push_back(kernel);
+                kernel->addArg(globalValues);
+                kernel->addArg(0.0); // energy
+                kernel->addArg(0.0); // uniform
+                kernel->addArg(0.0); // gaussian
+            }
             else if (stepType[step] == CustomIntegrator::ConstrainPositions) {
                 // Apply position constraints.
 
@@ -569,6 +648,7 @@ void CommonIntegrateCustomStepKernel::prepareForComputation(ContextImpl& context
         sumKineticEnergyKernel->addArg(sumBuffer);
         sumKineticEnergyKernel->addArg(summedValue);
         sumKineticEnergyKernel->addArg(numAtoms);
+        sumKineticEnergyKernel->addArg(0);
 
         // Delete the custom functions.
 
@@ -593,6 +673,7 @@ void CommonIntegrateCustomStepKernel::prepareForComputation(ContextImpl& context
     for (int i = 0; i < (int) parameterNames.size(); i++) {
         double value = context.getParameter(parameterNames[i]);
         if (value != localGlobalValues[parameterVariableIndex[i]]) {
+            downloadGlobalValues();
             expressionSet.setVariable(parameterVariableIndex[i], value);
             localGlobalValues[parameterVariableIndex[i]] = value;
             deviceGlobalsAreCurrent = false;
@@ -707,7 +788,7 @@ void CommonIntegrateCustomStepKernel::execute(ContextImpl& context, CustomIntegr
             deviceGlobalsAreCurrent = true;
         }
         bool stepInvalidatesForces = invalidatesForces[step];
-        if (stepType[step] == CustomIntegrator::ComputePerDof && !merged[step]) {
+        if ((stepType[step] == CustomIntegrator::ComputePerDof || stepType[step] == CustomIntegrator::ComputeSum) && !merged[step]) {
             kernels[step][0]->setArg(9, integration.prepareRandomNumbers(requiredGaussian[step]));
             kernels[step][0]->setArg(8, integration.getRandom());
             kernels[step][0]->setArg(10, uniformRandoms);
@@ -717,36 +798,42 @@ void CommonIntegrateCustomStepKernel::execute(ContextImpl& context, CustomIntegr
                 kernels[step][0]->setArg(11, (float) energy);
             if (requiredUniform[step] > 0)
                 randomKernel->execute(numAtoms, 64);
+            int sumStep = mergedSumStep[step];
+            if (sumStep != -1)
+                cc.clearBuffer(sumBuffer);
             kernels[step][0]->execute(numAtoms, 128);
+            if (sumStep != -1) {
+                kernels[step][1]->execute(sumWorkGroupSize, sumWorkGroupSize);
+                if (globalOnDevice[sumStep])
+                    localGlobalsAreCurrent = false;
+                else if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision()) {
+                    double value;
+                    summedValue.download(&value);
+                    recordGlobalValue(value, stepTarget[sumStep], integrator);
+                }
+                else {
+                    float value;
+                    summedValue.download(&value);
+                    recordGlobalValue(value, stepTarget[sumStep], integrator);
+                }
+            }
         }
         else if (stepType[step] == CustomIntegrator::ComputeGlobal) {
-            expressionSet.setVariable(uniformVariableIndex, SimTKOpenMMUtilities::getUniformlyDistributedRandomNumber());
-            expressionSet.setVariable(gaussianVariableIndex, SimTKOpenMMUtilities::getNormallyDistributedRandomNumber());
-            expressionSet.setVariable(stepEnergyVariableIndex[step], energy);
-            recordGlobalValue(globalExpressions[step][0].evaluate(), stepTarget[step], integrator);
-        }
-        else if (stepType[step] == CustomIntegrator::ComputeSum) {
-            kernels[step][0]->setArg(9, integration.prepareRandomNumbers(requiredGaussian[step]));
-            kernels[step][0]->setArg(8, integration.getRandom());
-            kernels[step][0]->setArg(10, uniformRandoms);
-            if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision())
-                kernels[step][0]->setArg(11, energy);
-            else
-                kernels[step][0]->setArg(11, (float) energy);
-            if (requiredUniform[step] > 0)
-                randomKernel->execute(numAtoms, 64);
-            cc.clearBuffer(sumBuffer);
-            kernels[step][0]->execute(numAtoms, 128);
-            kernels[step][1]->execute(sumWorkGroupSize, sumWorkGroupSize);
-            if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision()) {
-                double value;
-                summedValue.download(&value);
-                recordGlobalValue(value, stepTarget[step], integrator);
+            double uniform = SimTKOpenMMUtilities::getUniformlyDistributedRandomNumber();
+            double gaussian = SimTKOpenMMUtilities::getNormallyDistributedRandomNumber();
+            if (globalOnDevice[step]) {
+                kernels[step][0]->setArg(1, energy);
+                kernels[step][0]->setArg(2, uniform);
+                kernels[step][0]->setArg(3, gaussian);
+                kernels[step][0]->execute(1, 1);
+                localGlobalsAreCurrent = false;
             }
             else {
-                float value;
-                summedValue.download(&value);
-                recordGlobalValue(value, stepTarget[step], integrator);
+                downloadGlobalValues();
+                expressionSet.setVariable(uniformVariableIndex, uniform);
+                expressionSet.setVariable(gaussianVariableIndex, gaussian);
+                expressionSet.setVariable(stepEnergyVariableIndex[step], energy);
+                recordGlobalValue(globalExpressions[step][0].evaluate(), stepTarget[step], integrator);
             }
         }
         else if (stepType[step] == CustomIntegrator::UpdateContextState) {
@@ -799,6 +886,7 @@ void CommonIntegrateCustomStepKernel::execute(ContextImpl& context, CustomIntegr
 }
 
 bool CommonIntegrateCustomStepKernel::evaluateCondition(int step) {
+    downloadGlobalValues();
     expressionSet.setVariable(uniformVariableIndex, SimTKOpenMMUtilities::getUniformlyDistributedRandomNumber());
     expressionSet.setVariable(gaussianVariableIndex, SimTKOpenMMUtilities::getNormallyDistributedRandomNumber());
     expressionSet.setVariable(stepEnergyVariableIndex[step], energy);
@@ -844,8 +932,10 @@ double CommonIntegrateCustomStepKernel::computeKineticEnergy(ContextImpl& contex
 void CommonIntegrateCustomStepKernel::recordGlobalValue(double value, GlobalTarget target, CustomIntegrator& integrator) {
     switch (target.type) {
         case DT:
-            if (value != localGlobalValues[dtVariableIndex])
+            if (value != localGlobalValues[dtVariableIndex]) {
+                downloadGlobalValues();
                 deviceGlobalsAreCurrent = false;
+            }
             expressionSet.setVariable(dtVariableIndex, value);
             localGlobalValues[dtVariableIndex] = value;
             cc.getIntegrationUtilities().setNextStepSize(value);
@@ -853,6 +943,7 @@ void CommonIntegrateCustomStepKernel::recordGlobalValue(double value, GlobalTarg
             break;
         case VARIABLE:
         case PARAMETER:
+            downloadGlobalValues();
             expressionSet.setVariable(target.variableIndex, value);
             localGlobalValues[target.variableIndex] = value;
             deviceGlobalsAreCurrent = false;
@@ -860,6 +951,17 @@ void CommonIntegrateCustomStepKernel::recordGlobalValue(double value, GlobalTarg
     }
 }
 
+void CommonIntegrateCustomStepKernel::downloadGlobalValues() {
+    // Only global variables can be modified on the device, so they are the only values that need updating.
+
+    if (localGlobalsAreCurrent)
+        return;
+    globalValues.download(localGlobalValues);
+    for (int index : globalVariableIndex)
+        expressionSet.setVariable(index, localGlobalValues[index]);
+    localGlobalsAreCurrent = true;
+}
+
 void CommonIntegrateCustomStepKernel::recordChangedParameters(ContextImpl& context) {
     if (!modifiesParameters)
         return;
@@ -878,6 +980,16 @@ void CommonIntegrateCustomStepKernel::getGlobalVariables(ContextImpl& context, v
         return;
     }
     values.resize(numGlobalVariables);
+    if (!localGlobalsAreCurrent) {
+        // Some values were computed on the device, so retrieve them without modifying the local copies.
+
+        ContextSelector selector(cc);
+        vector<double> deviceValues;
+        globalValues.download(deviceValues);
+        for (int i = 0; i < numGlobalVariables; i++)
+            values[i] = deviceValues[globalVariableIndex[i]];
+        return;
+    }
     for (int i = 0; i < numGlobalVariables; i++)
         values[i] = localGlobalValues[globalVariableIndex[i]];
 }
@@ -891,6 +1003,8 @@ void CommonIntegrateCustomStepKernel::setGlobalVariables(ContextImpl& context, c
         initialGlobalVariables = values;
         return;
     }
+    ContextSelector selector(cc);
+    downloadGlobalValues();
     for (int i = 0; i < numGlobalVariables; i++) {
         localGlobalValues[globalVariableIndex[i]] = values[i];
         expressionSet.setVariable(globalVariableIndex[i], values[i]);
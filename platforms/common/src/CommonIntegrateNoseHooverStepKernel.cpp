@@ -41,7 +41,14 @@ void CommonIntegrateNoseHooverStepKernel::initialize(const System& system, const
     bool useDouble = cc.getUseDoublePrecision() || cc.getUseMixedPrecision();
     map<string, string> defines;
     defines["BOLTZ"] = cc.doubleToString(BOLTZ, true);
-    ComputeProgram program = cc.compileProgram(CommonKernelSources::noseHooverIntegrator, defines);
+
+    // The hard wall kernel changes velocities after the last integration kernel, so the center of mass
+    // momentum can only be computed there when there are no thermostated pairs.
+
+    computeCMMomentum = (cc.getIntegrationUtilities().getCMMomentum() != NULL && integrator.getAllThermostatedPairs().size() == 0);
+    if (computeCMMomentum)
+        defines["COMPUTE_CM_MOMENTUM"] = "1";
+    ComputeProgram program = cc.compileProgram(CommonKernelSources::cmMomentum+CommonKernelSources::noseHooverIntegrator, defines);
     kernel1 = program->createKernel("integrateNoseHooverMiddlePart1");
     kernel2 = program->createKernel("integrateNoseHooverMiddlePart2");
     kernel3 = program->createKernel("integrateNoseHooverMiddlePart3");
@@ -90,6 +97,9 @@ void CommonIntegrateNoseHooverStepKernel::initialize(const System& system, const
     computePairsKineticEnergyKernel = program->createKernel("computePairsKineticEnergy");
     scaleAtomsVelocitiesKernel = program->createKernel("scaleAtomsVelocities");
     scalePairsVelocitiesKernel = program->createKernel("scalePairsVelocities");
+    thermostatEnergyKernel = program->createKernel("computeThermostatKineticEnergies");
+    propagateChainsKernel = program->createKernel("propagateNoseHooverChains");
+    scaleThermostatVelocitiesKernel = program->createKernel("scaleThermostatVelocities");
     int energyBufferSize = cc.getEnergyBuffer().getSize();
     if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision())
         energyBuffer.initialize<mm_double2>(cc, energyBufferSize, "energyBuffer");
@@ -175,6 +185,8 @@ void CommonIntegrateNoseHooverStepKernel::execute(ContextImpl& context, const No
         kernel4->addArg(integration.getStepSize());
         if (cc.getUseMixedPrecision())
             kernel4->addArg(cc.getPosqCorrection());
+        if (computeCMMomentum)
+            kernel4->addArg(*integration.getCMMomentum());
         if (numPairs > 0) {
             kernelHardWall->addArg(numPairs);
             kernelHardWall->addArg(maxPairDistanceBuffer);
@@ -196,19 +208,16 @@ void CommonIntegrateNoseHooverStepKernel::execute(ContextImpl& context, const No
     integration.applyVelocityConstraints(integrator.getConstraintTolerance());
     // Position update
     kernel2->execute(numParticles);
-    // Apply the thermostat
-    int numChains = integrator.getNumThermostats();
-    for(int chain = 0; chain < numChains; ++chain) {
-        const auto &thermostatChain = integrator.getThermostat(chain);
-        auto KEs = computeMaskedKineticEnergy(context, thermostatChain, false);
-        auto scaleFactors = propagateChain(context, thermostatChain, KEs, dt);
-        scaleVelocities(context, thermostatChain, scaleFactors);
-    }
+    // Apply the thermostats
+    applyThermostats(integrator, dt);
     // Position update
     kernel3->execute(numParticles);
     integration.applyConstraints(integrator.getConstraintTolerance());
     // Apply constraint forces
-    kernel4->execute(numAtoms);
+    if (computeCMMomentum)
+        kernel4->execute(totalAtoms, 64);
+    else
+        kernel4->execute(numAtoms);
     // Make sure any Drude-like particles have not wandered too far from home
     if (numPairs > 0) kernelHardWall->execute(numPairs);
     integration.computeVirtualSites();
@@ -216,6 +225,8 @@ void CommonIntegrateNoseHooverStepKernel::execute(ContextImpl& context, const No
     // Update the time and step count.
     cc.setTime(cc.getTime()+dt);
     cc.setStepCount(cc.getStepCount()+1);
+    if (computeCMMomentum)
+        integration.setCMMomentumStep(cc.getStepCount());
     cc.reorderAtoms();
 
     // Reduce UI lag.
@@ -294,53 +305,10 @@ std::pair<double, double> CommonIntegrateNoseHooverStepKernel::propagateChain(Co
 
 
     // N.B. We ignore the incoming kineticEnergy and grab it from the device buffer instead
-    if (nAtoms) {
-        if (!chainState.count(2*chainID))
-            chainState[2*chainID] = ComputeArray();
-        if (!chainState.at(2*chainID).isInitialized() || chainState.at(2*chainID).getSize() != chainLength) {
-            // We need to upload the Common array
-            if (useDouble) {
-                if (chainState.at(2*chainID).isInitialized())
-                    chainState.at(2*chainID).resize(chainLength);
-                else
-                    chainState.at(2*chainID).initialize<mm_double2>(cc, chainLength, "chainState" + std::to_string(2*chainID));
-                std::vector<mm_double2> zeros(chainLength, mm_double2(0.0, 0.0));
-                chainState.at(2*chainID).upload(zeros.data());
-            }
-            else {
-                if (chainState.at(2*chainID).isInitialized())
-                    chainState.at(2*chainID).resize(chainLength);
-                else
-                    chainState.at(2*chainID).initialize<mm_float2>(cc, chainLength, "chainState" + std::to_string(2*chainID));
-                std::vector<mm_float2> zeros(chainLength, mm_float2(0.0f, 0.0f));
-                chainState.at(2*chainID).upload(zeros.data());
-            }
-        }
-    }
-
-    if (nPairs) {
-        if (!chainState.count(2*chainID+1))
-            chainState[2*chainID+1] = ComputeArray();
-        if (!chainState.at(2*chainID+1).isInitialized() || chainState.at(2*chainID+1).getSize() != chainLength) {
-            // We need to upload the Common array
-            if (useDouble) {
-                if (chainState.at(2*chainID+1).isInitialized())
-                    chainState.at(2*chainID+1).resize(chainLength);
-                else
-                    chainState.at(2*chainID+1).initialize<mm_double2>(cc, chainLength, "chainState" + std::to_string(2*chainID+1));
-                std::vector<mm_double2> zeros(chainLength, mm_double2(0.0, 0.0));
-                chainState.at(2*chainID+1).upload(zeros.data());
-            }
-            else {
-                if (chainState.at(2*chainID+1).isInitialized())
-                    chainState.at(2*chainID+1).resize(chainLength);
-                else
-                    chainState.at(2*chainID+1).initialize<mm_float2>(cc, chainLength, "chainState" + std::to_string(2*chainID+1));
-                std::vector<mm_float2> zeros(chainLength, mm_float2(0.0f, 0.0f));
-                chainState.at(2*chainID+1).upload(zeros.data());
-            }
-        }
-    }
+    if (nAtoms)
+        ensureChainState(2*chainID, chainLength);
+    if (nPairs)
+        ensureChainState(2*chainID+1, chainLength);
 
     if (!hasInitializedPropagateKernel) {
         hasInitializedPropagateKernel = true;
@@ -356,6 +324,7 @@ std::pair<double, double> CommonIntegrateNoseHooverStepKernel::propagateChain(Co
         propagateKernels[numYS]->addArg((float)timeStep);
         propagateKernels[numYS]->addArg(); // kT
         propagateKernels[numYS]->addArg(); // frequency
+        propagateKernels[numYS]->addArg(); // stateOffset
     }
 
     if (nAtoms) {
@@ -364,7 +333,7 @@ std::pair<double, double> CommonIntegrateNoseHooverStepKernel::propagateChain(Co
         float frequency = nhc.getCollisionFrequency();
         double kT = BOLTZ * temperature;
         int numDOFs = nhc.getNumDegreesOfFreedom();
-        propagateKernels[numYS]->setArg(0, chainState[2*chainID]);
+        propagateKernels[numYS]->setArg(0, chainState);
         propagateKernels[numYS]->setArg(5, chainType);
         propagateKernels[numYS]->setArg(8, numDOFs);
         if (useDouble) {
@@ -373,6 +342,7 @@ std::pair<double, double> CommonIntegrateNoseHooverStepKernel::propagateChain(Co
             propagateKernels[numYS]->setArg(10, (float)kT);
         }
         propagateKernels[numYS]->setArg(11, frequency);
+        propagateKernels[numYS]->setArg(12, chainStateRange[2*chainID].x);
         propagateKernels[numYS]->execute(1, 1);
     }
     if (nPairs) {
@@ -381,7 +351,7 @@ std::pair<double, double> CommonIntegrateNoseHooverStepKernel::propagateChain(Co
         float relativeFrequency = nhc.getRelativeCollisionFrequency();
         double kT = BOLTZ * relativeTemperature;
         int ndf = 3*nPairs;
-        propagateKernels[numYS]->setArg(0, chainState[2*chainID+1]);
+        propagateKernels[numYS]->setArg(0, chainState);
         propagateKernels[numYS]->setArg(5, chainType);
         propagateKernels[numYS]->setArg(8, ndf);
         if (useDouble) {
@@ -390,6 +360,7 @@ std::pair<double, double> CommonIntegrateNoseHooverStepKernel::propagateChain(Co
             propagateKernels[numYS]->setArg(10, (float)kT);
         }
         propagateKernels[numYS]->setArg(11, relativeFrequency);
+        propagateKernels[numYS]->setArg(12, chainStateRange[2*chainID+1].x);
         propagateKernels[numYS]->execute(1, 1);
     }
     return {0, 0};
@@ -401,12 +372,8 @@ double CommonIntegrateNoseHooverStepKernel::computeHeatBathEnergy(ContextImpl& c
     int chainID = nhc.getChainID();
     int chainLength = nhc.getChainLength();
 
-    bool absChainIsValid = chainState.count(2*chainID) != 0 &&
-                           chainState[2*chainID].isInitialized() &&
-                           chainState[2*chainID].getSize() == chainLength;
-    bool relChainIsValid = chainState.count(2*chainID+1) != 0 &&
-                           chainState[2*chainID+1].isInitialized() &&
-                           chainState[2*chainID+1].getSize() == chainLength;
+    bool absChainIsValid = chainStateRange.count(2*chainID) != 0 && chainStateRange[2*chainID].y == chainLength;
+    bool relChainIsValid = chainStateRange.count(2*chainID+1) != 0 && chainStateRange[2*chainID+1].y == chainLength;
 
     if (!absChainIsValid && !relChainIsValid) return 0.0;
 
@@ -433,6 +400,7 @@ double CommonIntegrateNoseHooverStepKernel::computeHeatBathEnergy(ContextImpl& c
         computeHeatBathEnergyKernel->addArg(); // kT
         computeHeatBathEnergyKernel->addArg(); // frequency
         computeHeatBathEnergyKernel->addArg(); // chainstate
+        computeHeatBathEnergyKernel->addArg(); // stateOffset
     }
 
     if (absChainIsValid) {
@@ -448,7 +416,8 @@ double CommonIntegrateNoseHooverStepKernel::computeHeatBathEnergy(ContextImpl& c
             computeHeatBathEnergyKernel->setArg(3, (float)kT);
         }
         computeHeatBathEnergyKernel->setArg(4, frequency);
-        computeHeatBathEnergyKernel->setArg(5, chainState[2*chainID]);
+        computeHeatBathEnergyKernel->setArg(5, chainState);
+        computeHeatBathEnergyKernel->setArg(6, chainStateRange[2*chainID].x);
         computeHeatBathEnergyKernel->execute(1, 1);
     }
     if (relChainIsValid) {
@@ -464,7 +433,8 @@ double CommonIntegrateNoseHooverStepKernel::computeHeatBathEnergy(ContextImpl& c
             computeHeatBathEnergyKernel->setArg(3, (float)kT);
         }
         computeHeatBathEnergyKernel->setArg(4, frequency);
-        computeHeatBathEnergyKernel->setArg(5, chainState[2*chainID+1]);
+        computeHeatBathEnergyKernel->setArg(5, chainState);
+        computeHeatBathEnergyKernel->setArg(6, chainStateRange[2*chainID+1].x);
         computeHeatBathEnergyKernel->execute(1, 1);
     }
 
@@ -602,24 +572,299 @@ void CommonIntegrateNoseHooverStepKernel::scaleVelocities(ContextImpl& context,
     }
 }
 
+void CommonIntegrateNoseHooverStepKernel::initializeThermostats(const NoseHooverIntegrator& integrator) {
+    bool useDouble = cc.getUseDoublePrecision() || cc.getUseMixedPrecision();
+    int numChains = integrator.getNumThermostats();
+    int workGroupSize = std::min(cc.getMaxThreadBlockSize(), 512);
+
+    // Build flattened lists of all thermostated atoms and pairs, and divide them into blocks that
+    // each contain particles from only one thermostat.
+
+    vector<int> atoms, atomChain, pairChain;
+    vector<mm_int2> pairs, blockRanges(numChains);
+    vector<mm_int4> blocks;
+    thermostatAtomCounts.resize(numChains);
+    thermostatPairCounts.resize(numChains);
+    for (int chain = 0; chain < numChains; chain++) {
+        const NoseHooverChain& nhc = integrator.getThermostat(chain);
+        const auto& nhcAtoms = nhc.getThermostatedAtoms();
+        const auto& nhcPairs = nhc.getThermostatedPairs();
+        thermostatAtomCounts[chain] = nhcAtoms.size();
+        thermostatPairCounts[chain] = nhcPairs.size();
+        blockRanges[chain].x = blocks.size();
+        for (int start = 0; start < nhcAtoms.size(); start += workGroupSize)
+            blocks.push_back(mm_int4(0, atoms.size()+start, atoms.size()+std::min(start+workGroupSize, (int) nhcAtoms.size()), 0));
+        for (int start = 0; start < nhcPairs.size(); start += workGroupSize)
+            blocks.push_back(mm_int4(1, pairs.size()+start, pairs.size()+std::min(start+workGroupSize, (int) nhcPairs.size()), 0));
+        blockRanges[chain].y = blocks.size();
+        for (int atom : nhcAtoms) {
+            atoms.push_back(atom);
+            atomChain.push_back(chain);
+        }
+        for (const auto& pair : nhcPairs) {
+            pairs.push_back(mm_int2(pair.first, pair.second));
+            pairChain.push_back(chain);
+        }
+    }
+    numThermostatAtoms = atoms.size();
+    numThermostatPairs = pairs.size();
+    numThermostatBlocks = blocks.size();
+    atoms.resize(std::max(numThermostatAtoms, 1), 0);
+    atomChain.resize(atoms.size(), 0);
+    pairs.resize(std::max(numThermostatPairs, 1), mm_int2(0, 0));
+    pairChain.resize(pairs.size(), 0);
+    blocks.resize(std::max(numThermostatBlocks, 1), mm_int4(0, 0, 0, 0));
+    thermostatAtoms.initialize<int>(cc, atoms.size(), "thermostatAtoms");
+    thermostatAtomChain.initialize<int>(cc, atomChain.size(), "thermostatAtomChain");
+    thermostatPairs.initialize<mm_int2>(cc, pairs.size(), "thermostatPairs");
+    thermostatPairChain.initialize<int>(cc, pairChain.size(), "thermostatPairChain");
+    thermostatBlocks.initialize<mm_int4>(cc, blocks.size(), "thermostatBlocks");
+    chainBlocks.initialize<mm_int2>(cc, numChains, "chainBlocks");
+    thermostatAtoms.upload(atoms);
+    thermostatAtomChain.upload(atomChain);
+    thermostatPairs.upload(pairs);
+    thermostatPairChain.upload(pairChain);
+    thermostatBlocks.upload(blocks);
+    chainBlocks.upload(blockRanges);
+
+    // Create the arrays for the per-thermostat parameters.  Their contents are filled in by applyThermostats().
+
+    chainInfo.initialize<mm_int4>(cc, numChains, "chainInfo");
+    chainOffsets.initialize<mm_int4>(cc, numChains, "chainOffsets");
+    if (useDouble) {
+        chainTemperatures.initialize<mm_double4>(cc, numChains, "chainTemperatures");
+        chainWeights.initialize<double>(cc, 7*numChains, "chainWeights");
+        chainScaleFactors.initialize<mm_double2>(cc, numChains, "chainScaleFactors");
+        partialKineticEnergy.initialize<mm_double2>(cc, blocks.size(), "partialKineticEnergy");
+        thermostatChainForces.initialize<double>(cc, 1, "thermostatChainForces");
+    }
+    else {
+        chainTemperatures.initialize<mm_float4>(cc, numChains, "chainTemperatures");
+        chainWeights.initialize<float>(cc, 7*numChains, "chainWeights");
+        chainScaleFactors.initialize<mm_float2>(cc, numChains, "chainScaleFactors");
+        partialKineticEnergy.initialize<mm_float2>(cc, blocks.size(), "partialKineticEnergy");
+        thermostatChainForces.initialize<float>(cc, 1, "thermostatChainForces");
+    }
+    chainInfoVec.clear();
+    chainOffsetsVec.clear();
+    chainTemperaturesVec.clear();
+    chainWeightsVec.clear();
+    if (!chainState.isInitialized())
+        setChainStateLayout(map<int, int>());
+
+    thermostatEnergyKernel->addArg(cc.getVelm());
+    thermostatEnergyKernel->addArg(thermostatAtoms);
+    thermostatEnergyKernel->addArg(thermostatPairs);
+    thermostatEnergyKernel->addArg(thermostatBlocks);
+    thermostatEnergyKernel->addArg(numThermostatBlocks);
+    thermostatEnergyKernel->addArg(partialKineticEnergy);
+    propagateChainsKernel->addArg(partialKineticEnergy);
+    propagateChainsKernel->addArg(chainBlocks);
+    propagateChainsKernel->addArg(chainState);
+    propagateChainsKernel->addArg(thermostatChainForces);
+    propagateChainsKernel->addArg(chainInfo);
+    propagateChainsKernel->addArg(chainOffsets);
+    propagateChainsKernel->addArg(chainTemperatures);
+    propagateChainsKernel->addArg(chainWeights);
+    propagateChainsKernel->addArg(chainScaleFactors);
+    propagateChainsKernel->addArg(numChains);
+    propagateChainsKernel->addArg(); // timeStep
+    scaleThermostatVelocitiesKernel->addArg(chainScaleFactors);
+    scaleThermostatVelocitiesKernel->addArg(cc.getVelm());
+    scaleThermostatVelocitiesKernel->addArg(thermostatAtoms);
+    scaleThermostatVelocitiesKernel->addArg(thermostatAtomChain);
+    scaleThermostatVelocitiesKernel->addArg(numThermostatAtoms);
+    scaleThermostatVelocitiesKernel->addArg(thermostatPairs);
+    scaleThermostatVelocitiesKernel->addArg(thermostatPairChain);
+    scaleThermostatVelocitiesKernel->addArg(numThermostatPairs);
+    hasInitializedThermostats = true;
+}
+
+void CommonIntegrateNoseHooverStepKernel::applyThermostats(const NoseHooverIntegrator& integrator, double timeStep) {
+    int numChains = integrator.getNumThermostats();
+    if (numChains == 0)
+        return;
+    if (!hasInitializedThermostats)
+        initializeThermostats(integrator);
+    bool useDouble = cc.getUseDoublePrecision() || cc.getUseMixedPrecision();
+
+    // Make sure every thermostat has a state of the right length.
+
+    map<int, int> lengths;
+    for (auto& range : chainStateRange)
+        lengths[range.first] = range.second.y;
+    bool layoutChanged = false;
+    for (int chain = 0; chain < numChains; chain++) {
+        const NoseHooverChain& nhc = integrator.getThermostat(chain);
+        if (nhc.getThermostatedAtoms().size() != thermostatAtomCounts[chain])
+            throw OpenMMException("Number of atoms changed. Cannot be handled by the same Nose-Hoover thermostat.");
+        if (nhc.getThermostatedPairs().size() != thermostatPairCounts[chain])
+            throw OpenMMException("Number of thermostated pairs changed. Cannot be handled by the same Nose-Hoover thermostat.");
+        int chainID = nhc.getChainID();
+        int chainLength = nhc.getChainLength();
+        for (int key = 2*chainID; key < 2*chainID+2; key++) {
+            int count = (key == 2*chainID ? thermostatAtomCounts[chain] : thermostatPairCounts[chain]);
+            if (count > 0 && (lengths.count(key) == 0 || lengths[key] != chainLength)) {
+                lengths[key] = chainLength;
+                layoutChanged = true;
+            }
+        }
+    }
+    if (layoutChanged)
+        setChainStateLayout(lengths);
+
+    // Update the per-thermostat parameters, uploading only the ones that have changed.
+
+    vector<int> info(4*numChains), offsets(4*numChains);
+    vector<double> temperatures(4*numChains), weights(7*numChains, 0.0);
+    int forceOffset = 0;
+    for (int chain = 0; chain < numChains; chain++) {
+        const NoseHooverChain& nhc = integrator.getThermostat(chain);
+        int chainID = nhc.getChainID();
+        int numYS = nhc.getNumYoshidaSuzukiTimeSteps();
+        if (numYS != 1 && numYS != 3 && numYS != 5 && numYS != 7)
+            throw OpenMMException("Number of Yoshida Suzuki time steps has to be 1, 3, 5, or 7.");
+        info[4*chain] = nhc.getChainLength();
+        info[4*chain+1] = nhc.getNumMultiTimeSteps();
+        info[4*chain+2] = numYS;
+        info[4*chain+3] = nhc.getNumDegreesOfFreedom();
+        offsets[4*chain] = (thermostatAtomCounts[chain] > 0 ? chainStateRange[2*chainID].x : -1);
+        offsets[4*chain+1] = (thermostatPairCounts[chain] > 0 ? chainStateRange[2*chainID+1].x : -1);
+        offsets[4*chain+2] = 3*thermostatPairCounts[chain];
+        offsets[4*chain+3] = forceOffset;
+        forceOffset += nhc.getChainLength();
+        temperatures[4*chain] = BOLTZ*nhc.getTemperature();
+        temperatures[4*chain+1] = nhc.getCollisionFrequency();
+        temperatures[4*chain+2] = BOLTZ*nhc.getRelativeTemperature();
+        temperatures[4*chain+3] = nhc.getRelativeCollisionFrequency();
+        vector<double> ysWeights = nhc.getYoshidaSuzukiWeights();
+        for (int i = 0; i < ysWeights.size(); i++)
+            weights[7*chain+i] = ysWeights[i];
+    }
+    if (forceOffset > thermostatChainForces.getSize())
+        thermostatChainForces.resize(forceOffset);
+    if (info != chainInfoVec) {
+        chainInfo.upload(info.data());
+        chainInfoVec = info;
+    }
+    if (offsets != chainOffsetsVec) {
+        chainOffsets.upload(offsets.data());
+        chainOffsetsVec = offsets;
+    }
+    if (temperatures != chainTemperaturesVec) {
+        if (useDouble) {
+            vector<mm_double4> temperatureVec;
+            for (int i = 0; i < numChains; i++)
+                temperatureVec.push_back(mm_double4(temperatures[4*i], temperatures[4*i+1], temperatures[4*i+2], temperatures[4*i+3]));
+            chainTemperatures.upload(temperatureVec);
+        }
+        else {
+            vector<mm_float4> temperatureVec;
+            for (int i = 0; i < numChains; i++)
+                temperatureVec.push_back(mm_float4(temperatures[4*i], temperatures[4*i+1], temperatures[4*i+2], temperatures[4*i+3]));
+            chainTemperatures.upload(temperatureVec);
+        }
+        chainTemperaturesVec = temperatures;
+    }
+    if (weights != chainWeightsVec) {
+        chainWeights.upload(weights, true);
+        chainWeightsVec = weights;
+    }
+
+    // Compute the kinetic energies, propagate the chains, and scale the velocities.
+
+    int workGroupSize = std::min(cc.getMaxThreadBlockSize(), 512);
+    if (numThermostatBlocks > 0)
+        thermostatEnergyKernel->execute(numThermostatBlocks*workGroupSize, workGroupSize);
+    propagateChainsKernel->setArg(10, (float) timeStep);
+    propagateChainsKernel->execute(numChains*workGroupSize, workGroupSize);
+    if (numThermostatAtoms+numThermostatPairs > 0)
+        scaleThermostatVelocitiesKernel->execute(numThermostatAtoms+numThermostatPairs);
+}
+
+void CommonIntegrateNoseHooverStepKernel::ensureChainState(int key, int chainLength) {
+    if (chainStateRange.count(key) != 0 && chainStateRange[key].y == chainLength)
+        return;
+    map<int, int> lengths;
+    for (auto& range : chainStateRange)
+        lengths[range.first] = range.second.y;
+    lengths[key] = chainLength;
+    setChainStateLayout(lengths);
+}
+
+void CommonIntegrateNoseHooverStepKernel::setChainStateLayout(const map<int, int>& lengths) {
+    vector<mm_double2> oldStates;
+    if (chainState.isInitialized())
+        oldStates = downloadChainStates();
+    map<int, mm_int2> newRange;
+    int totalLength = 0;
+    for (auto& length : lengths) {
+        newRange[length.first] = mm_int2(totalLength, length.second);
+        totalLength += length.second;
+    }
+    vector<mm_double2> newStates(std::max(totalLength, 1), mm_double2(0.0, 0.0));
+    for (auto& range : chainStateRange) {
+        auto newLocation = newRange.find(range.first);
+        if (newLocation != newRange.end() && newLocation->second.y == range.second.y)
+            for (int i = 0; i < range.second.y; i++)
+                newStates[newLocation->second.x+i] = oldStates[range.second.x+i];
+    }
+
+    // Resize the existing array rather than replacing it, since kernels may already hold it as an argument.
+
+    if (chainState.isInitialized())
+        chainState.resize(newStates.size());
+    else if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision())
+        chainState.initialize<mm_double2>(cc, newStates.size(), "chainState");
+    else
+        chainState.initialize<mm_float2>(cc, newStates.size(), "chainState");
+    chainStateRange = newRange;
+    uploadChainStates(newStates);
+}
+
+vector<mm_double2> CommonIntegrateNoseHooverStepKernel::downloadChainStates() const {
+    vector<mm_double2> states(chainState.getSize());
+    if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision())
+        chainState.download(states);
+    else {
+        vector<mm_float2> floatStates;
+        chainState.download(floatStates);
+        for (int i = 0; i < floatStates.size(); i++)
+            states[i] = mm_double2(floatStates[i].x, floatStates[i].y);
+    }
+    return states;
+}
+
+void CommonIntegrateNoseHooverStepKernel::uploadChainStates(const vector<mm_double2>& states) {
+    if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision())
+        chainState.upload(states);
+    else {
+        vector<mm_float2> floatStates(states.size());
+        for (int i = 0; i < states.size(); i++)
+            floatStates[i] = mm_float2((float) states[i].x, (float) states[i].y);
+        chainState.upload(floatStates);
+    }
+}
+
 void CommonIntegrateNoseHooverStepKernel::createCheckpoint(ContextImpl& context, ostream& stream) const {
     ContextSelector selector(cc);
-    int numChains = chainState.size();
+    int numChains = chainStateRange.size();
     bool useDouble = cc.getUseDoublePrecision() || cc.getUseMixedPrecision();
     stream.write((char*) &numChains, sizeof(int));
-    for (auto& state : chainState){
-        int chainID = state.first;
-        int chainLength = state.second.getSize();
+    if (numChains == 0)
+        return;
+    vector<mm_double2> states = downloadChainStates();
+    for (auto& range : chainStateRange) {
+        int chainID = range.first;
+        int chainLength = range.second.y;
         stream.write((char*) &chainID, sizeof(int));
         stream.write((char*) &chainLength, sizeof(int));
-        if (useDouble) {
-            vector<mm_double2> stateVec;
-            state.second.download(stateVec);
-            stream.write((char*) stateVec.data(), sizeof(mm_double2)*chainLength);
-        }
+        if (useDouble)
+            stream.write((char*) &states[range.second.x], sizeof(mm_double2)*chainLength);
         else {
             vector<mm_float2> stateVec;
-            state.second.download(stateVec);
+            for (int i = 0; i < chainLength; i++)
+                stateVec.push_back(mm_float2((float) states[range.second.x+i].x, (float) states[range.second.x+i].y));
             stream.write((char*) stateVec.data(), sizeof(mm_float2)*chainLength);
         }
     }
@@ -630,78 +875,64 @@ void CommonIntegrateNoseHooverStepKernel::loadCheckpoint(ContextImpl& context, i
     int numChains;
     bool useDouble = cc.getUseDoublePrecision() || cc.getUseMixedPrecision();
     stream.read((char*) &numChains, sizeof(int));
-    chainState.clear();
+    map<int, int> lengths;
+    map<int, vector<mm_double2> > loaded;
     for (int i = 0; i < numChains; i++) {
         int chainID, chainLength;
         stream.read((char*) &chainID, sizeof(int));
         stream.read((char*) &chainLength, sizeof(int));
-        if (useDouble) {
-            chainState[chainID] = ComputeArray();
-            chainState[chainID].initialize<mm_double2>(cc, chainLength, "chainState" + to_string(chainID));
-            vector<mm_double2> stateVec(chainLength);
-            stream.read((char*) &stateVec[0], sizeof(mm_double2)*chainLength);
-            chainState[chainID].upload(stateVec);
-        }
+        vector<mm_double2>& stateVec = loaded[chainID];
+        stateVec.resize(chainLength);
+        if (useDouble)
+            stream.read((char*) stateVec.data(), sizeof(mm_double2)*chainLength);
         else {
-            chainState[chainID] = ComputeArray();
-            chainState[chainID].initialize<mm_float2>(cc, chainLength, "chainState" + to_string(chainID));
-            vector<mm_float2> stateVec(chainLength);
-            stream.read((char*) &stateVec[0], sizeof(mm_float2)*chainLength);
-            chainState[chainID].upload(stateVec);
+            vector<mm_float2> floatVec(chainLength);
+            stream.read((char*) floatVec.data(), sizeof(mm_float2)*chainLength);
+            for (int j = 0; j < chainLength; j++)
+                stateVec[j] = mm_double2(floatVec[j].x, floatVec[j].y);
         }
+        lengths[chainID] = chainLength;
     }
+    chainStateRange.clear();
+    setChainStateLayout(lengths);
+    vector<mm_double2> states = downloadChainStates();
+    for (auto& state : loaded)
+        for (int j = 0; j < state.second.size(); j++)
+            states[chainStateRange[state.first].x+j] = state.second[j];
+    uploadChainStates(states);
 }
 
 void CommonIntegrateNoseHooverStepKernel::getChainStates(ContextImpl& context, vector<vector<double> >& positions, vector<vector<double> >& velocities) const {
     ContextSelector selector(cc);
-    int numChains = chainState.size();
-    bool useDouble = cc.getUseDoublePrecision() || cc.getUseMixedPrecision();
+    int numChains = chainStateRange.size();
     positions.clear();
     velocities.clear();
     positions.resize(numChains);
     velocities.resize(numChains);
-    for (int i = 0; i < numChains; i++) {
-        const ComputeArray& state = chainState.at(i);
-        if (useDouble) {
-            vector<mm_double2> stateVec;
-            state.download(stateVec);
-            for (int j = 0; j < stateVec.size(); j++) {
-                positions[i].push_back(stateVec[j].x);
-                velocities[i].push_back(stateVec[j].y);
-            }
-        }
-        else {
-            vector<mm_float2> stateVec;
-            state.download(stateVec);
-            for (int j = 0; j < stateVec.size(); j++) {
-                positions[i].push_back((float) stateVec[j].x);
-                velocities[i].push_back((float) stateVec[j].y);
-            }
+    if (numChains == 0)
+        return;
+    vector<mm_double2> states = downloadChainStates();
+    int i = 0;
+    for (auto& range : chainStateRange) {
+        for (int j = 0; j < range.second.y; j++) {
+            positions[i].push_back(states[range.second.x+j].x);
+            velocities[i].push_back(states[range.second.x+j].y);
         }
+        i++;
     }
 }
 
 void CommonIntegrateNoseHooverStepKernel::setChainStates(ContextImpl& context, const vector<vector<double> >& positions, const vector<vector<double> >& velocities) {
     ContextSelector selector(cc);
     int numChains = positions.size();
-    bool useDouble = cc.getUseDoublePrecision() || cc.getUseMixedPrecision();
-    chainState.clear();
-    for (int i = 0; i < numChains; i++) {
-        int chainLength = positions[i].size();
-        chainState[i] = ComputeArray();
-        if (useDouble) {
-            chainState[i].initialize<mm_double2>(cc, chainLength, "chainState"+cc.intToString(i));
-            vector<mm_double2> stateVec;
-            for (int j = 0; j < chainLength; j++)
-                stateVec.push_back(mm_double2(positions[i][j], velocities[i][j]));
-            chainState[i].upload(stateVec);
-        }
-        else {
-            chainState[i].initialize<mm_float2>(cc, chainLength, "chainState"+cc.intToString(i));
-            vector<mm_float2> stateVec;
-            for (int j = 0; j < chainLength; j++)
-                stateVec.push_back(mm_float2((float) positions[i][j], (float) velocities[i][j]));
-            chainState[i].upload(stateVec);
-        }
-    }
+    map<int, int> lengths;
+    for (int i = 0; i < numChains; i++)
+        lengths[i] = positions[i].size();
+    chainStateRange.clear();
+    setChainStateLayout(lengths);
+    vector<mm_double2> states = downloadChainStates();
+    for (int i = 0; i < numChains; i++)
+        for (int j = 0; j < positions[i].size(); j++)
+            states[chainStateRange[i].x+j] = mm_double2(positions[i][j], velocities[i][j]);
+    uploadChainStates(states);
 }
@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2008-2025 Stanford University and the Authors.      *
+ * Portions copyright (c) 2008-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -47,11 +47,12 @@
 #include "ReferenceTabulatedFunction.h"
 #include "SimTKOpenMMRealType.h"
 #include "SimTKOpenMMUtilities.h"
-#include "jama_eig.h"
 #include <algorithm>
 #include <cmath>
 #include <iterator>
+#include <limits>
 #include <set>
+#include <thread>
 
 using namespace OpenMM;
 using namespace std;
@@ -59,20 +60,57 @@ using namespace Lepton;
 
 void CommonUpdateStateDataKernel::initialize(const System& system) {
     ContextSelector selector(cc);
-    floatBuffer.initialize<float>(cc, 3*system.getNumParticles(), "floatBuffer");
+
+    // Positions and velocities are uploaded in the System's order through a dedicated block of pinned
+    // memory, and a kernel applies the atom order and converts them to the working precision.
+
+    bool useDouble = cc.getSupportsDoublePrecision();
+    int elementSize = (useDouble ? sizeof(double) : sizeof(float));
+    uploadBuffer.initialize(cc, max(3*system.getNumParticles(), 1), elementSize, "uploadBuffer");
+    uploadStaging = cc.allocatePinnedMemory(uploadBuffer.getSize()*elementSize);
+    uploadEvent = cc.createEvent();
     map<string, string> defines;
+    defines["STAGING_TYPE"] = (useDouble ? "double" : "float");
     ComputeProgram program = cc.compileProgram(CommonKernelSources::copyCoordinateBuffers, defines);
-    copyFloatKernel = program->createKernel("copyFloatBuffer");
-    copyFloatKernel->addArg(floatBuffer);
-    copyFloatKernel->addArg();
-    copyFloatKernel->addArg(cc.getNumAtoms());
-    if (cc.getUseMixedPrecision() || cc.getUseDoublePrecision()) {
-        doubleBuffer.initialize<double>(cc, 3*system.getNumParticles(), "doubleBuffer");
-        copyDoubleKernel = program->createKernel("copyDoubleBuffer");
-        copyDoubleKernel->addArg(doubleBuffer);
-        copyDoubleKernel->addArg();
-        copyDoubleKernel->addArg(cc.getNumAtoms());
-    }
+    setPositionsKernel = program->createKernel("setPositions");
+    setPositionsKernel->addArg(uploadBuffer);
+    setPositionsKernel->addArg(cc.getPosq());
+    if (cc.getUseMixedPrecision())
+        setPositionsKernel->addArg(cc.getPosqCorrection());
+    setPositionsKernel->addArg(cc.getAtomIndexArray());
+    setPositionsKernel->addArg(cc.getNumAtoms());
+    setVelocitiesKernel = program->createKernel("setVelocities");
+    setVelocitiesKernel->addArg(uploadBuffer);
+    setVelocitiesKernel->addArg(cc.getVelm());
+    setVelocitiesKernel->addArg(cc.getAtomIndexArray());
+    setVelocitiesKernel->addArg(cc.getNumAtoms());
+    particleSlot.initialize<int>(cc, system.getNumParticles(), "particleSlot");
+    gatherPositionsKernel = program->createKernel("gatherPositions");
+    gatherPositionsKernel->addArg(cc.getPosq());
+    if (cc.getUseMixedPrecision())
+        gatherPositionsKernel->addArg(cc.getPosqCorrection());
+    gatherPositionsKernel->addArg(cc.getAtomIndexArray());
+    gatherPositionsKernel->addArg(particleSlot);
+    gatherPositionsKernel->addArg();
+    gatherPositionsKernel->addArg();
+    gatherPositionsKernel->addArg(cc.getNumAtoms());
+    gatherVelocitiesKernel = program->createKernel("gatherVelocities");
+    gatherVelocitiesKernel->addArg(cc.getVelm());
+    gatherVelocitiesKernel->addArg(cc.getAtomIndexArray());
+    gatherVelocitiesKernel->addArg(particleSlot);
+    gatherVelocitiesKernel->addArg();
+    gatherVelocitiesKernel->addArg(cc.getNumAtoms());
+    gatherForcesKernel = program->createKernel("gatherForces");
+    gatherForcesKernel->addArg(cc.getLongForceBuffer());
+    gatherForcesKernel->addArg(cc.getAtomIndexArray());
+    gatherForcesKernel->addArg(particleSlot);
+    gatherForcesKernel->addArg();
+    gatherForcesKernel->addArg(cc.getNumAtoms());
+    gatherForcesKernel->addArg(cc.getPaddedNumAtoms());
+    scaleVelocitiesKernel = program->createKernel("scaleVelocities");
+    scaleVelocitiesKernel->addArg(cc.getVelm());
+    scaleVelocitiesKernel->addArg(cc.getNumAtoms());
+    scaleVelocitiesKernel->addArg();
 }
 
 double CommonUpdateStateDataKernel::getTime(const ContextImpl& context) const {
@@ -91,6 +129,7 @@ long long CommonUpdateStateDataKernel::getStepCount(const ContextImpl& context)
 void CommonUpdateStateDataKernel::setStepCount(const ContextImpl& context, long long count) {
     for (auto ctx : cc.getAllContexts())
         ctx->setStepCount(count);
+    cc.getIntegrationUtilities().setCMMomentumStep(-1);
 }
 
 void CommonUpdateStateDataKernel::getPositions(ContextImpl& context, vector<Vec3>& positions) {
@@ -154,50 +193,134 @@ void CommonUpdateStateDataKernel::getPositions(ContextImpl& context, vector<Vec3
     cc.getThreadPool().waitForThreads();
 }
 
-void CommonUpdateStateDataKernel::setPositions(ContextImpl& context, const vector<Vec3>& positions) {
+void CommonUpdateStateDataKernel::getQuantizedPositions(ContextImpl& context, double precision, vector<Vec3>& positions) {
     ContextSelector selector(cc);
-    const vector<int>& order = cc.getAtomIndex();
-    int numParticles = context.getSystem().getNumParticles();
-    if (cc.getUseDoublePrecision()) {
-        double* pos = (double*) cc.getPinnedBuffer();
-        for (int i = 0; i < numParticles; ++i) {
-            const Vec3& p = positions[order[i]];
-            pos[3*i] = p[0];
-            pos[3*i+1] = p[1];
-            pos[3*i+2] = p[2];
-        }
-        doubleBuffer.upload(pos);
-        copyDoubleKernel->setArg(1, cc.getPosq());
-        copyDoubleKernel->execute(numParticles);
+    int numParticles = cc.getNumAtoms();
+    int blockSize = cc.ThreadBlockSize;
+    int numGroups = min(cc.getNumThreadBlocks(), (numParticles+blockSize-1)/blockSize);
+    if (!findRangeKernel) {
+        // Create the kernels the first time they are needed.
+
+        quantizedRange.initialize<int>(cc, 6*numGroups, "quantizedRange");
+        quantizedHeader.initialize<int>(cc, 6, "quantizedHeader");
+        packedPositions.initialize<int>(cc, 2*numParticles, "packedPositions");
+        map<string, string> defines;
+        defines["WORK_GROUP_SIZE"] = cc.intToString(blockSize);
+        ComputeProgram program = cc.compileProgram(CommonKernelSources::quantizePositions, defines);
+        findRangeKernel = program->createKernel("findQuantizedRange");
+        findRangeKernel->addArg(cc.getPosq());
+        if (cc.getUseMixedPrecision())
+            findRangeKernel->addArg(cc.getPosqCorrection());
+        findRangeKernel->addArg(quantizedRange);
+        findRangeKernel->addArg(numParticles);
+        findRangeKernel->addArg();
+        combineRangeKernel = program->createKernel("combineQuantizedRange");
+        combineRangeKernel->addArg(quantizedRange);
+        combineRangeKernel->addArg(numGroups);
+        combineRangeKernel->addArg(quantizedHeader);
+        packPositionsKernel = program->createKernel("packQuantizedPositions");
+        packPositionsKernel->addArg(cc.getPosq());
+        if (cc.getUseMixedPrecision())
+            packPositionsKernel->addArg(cc.getPosqCorrection());
+        packPositionsKernel->addArg(quantizedHeader);
+        packPositionsKernel->addArg(packedPositions);
+        packPositionsKernel->addArg(numParticles);
+        packPositionsKernel->addArg();
+    }
+    int precisionArg = (cc.getUseMixedPrecision() ? 3 : 2);
+    int packPrecisionArg = (cc.getUseMixedPrecision() ? 5 : 4);
+    if (cc.getUseMixedPrecision() || cc.getUseDoublePrecision()) {
+        findRangeKernel->setArg(precisionArg, 1.0/precision);
+        packPositionsKernel->setArg(packPrecisionArg, 1.0/precision);
     }
     else {
-        float* pos = (float*) cc.getPinnedBuffer();
-        for (int i = 0; i < numParticles; ++i) {
-            const Vec3& p = positions[order[i]];
-            pos[3*i] = (float) p[0];
-            pos[3*i+1] = (float) p[1];
-            pos[3*i+2] = (float) p[2];
+        findRangeKernel->setArg(precisionArg, (float) (1.0/precision));
+        packPositionsKernel->setArg(packPrecisionArg, (float) (1.0/precision));
+    }
+    findRangeKernel->execute(numGroups*blockSize, blockSize);
+    combineRangeKernel->execute(blockSize, blockSize);
+    packPositionsKernel->execute(cc.getNumThreadBlocks()*blockSize, blockSize);
+    vector<int> header;
+    quantizedHeader.download(header);
+    int totalBits = header[3]+header[4]+header[5];
+    if (totalBits > 64) {
+        // The coordinates span too wide a range to pack, so transfer the full positions instead.
+
+        getPositions(context, positions);
+        return;
+    }
+    int numWords = (int) (((long long) numParticles*totalBits+31)/32);
+    unsigned int* packed = (unsigned int*) cc.getPinnedBuffer();
+    packedPositions.downloadSubArray(packed, 0, numWords);
+
+    // Unpacking the output array is done in parallel for speed.
+
+    positions.resize(context.getSystem().getNumParticles());
+    cc.getThreadPool().execute([&] (ThreadPool& threads, int threadIndex) {
+        const vector<int>& order = cc.getAtomIndex();
+        Vec3 boxVectors[3];
+        cc.getPeriodicBoxVectors(boxVectors[0], boxVectors[1], boxVectors[2]);
+        unsigned long long mask[3];
+        for (int axis = 0; axis < 3; axis++)
+            mask[axis] = (1ULL<<header[3+axis])-1;
+        int numThreads = threads.getNumThreads();
+        int start = threadIndex*numParticles/numThreads;
+        int end = (threadIndex+1)*numParticles/numThreads;
+        for (int i = start; i < end; ++i) {
+            long long firstBit = i*(long long) totalBits;
+            int word = (int) (firstBit/32);
+            int shift = (int) (firstBit%32);
+            unsigned long long bits = packed[word];
+            if (word+1 < numWords)
+                bits |= ((unsigned long long) packed[word+1])<<32;
+            bits >>= shift;
+            if (shift > 0 && totalBits > 64-shift && word+2 < numWords)
+                bits |= ((unsigned long long) packed[word+2])<<(64-shift);
+            int x = (int) (bits&mask[0])+header[0];
+            int y = (int) ((bits>>header[3])&mask[1])+header[1];
+            int z = (int) ((bits>>(header[3]+header[4]))&mask[2])+header[2];
+            mm_int4 offset = cc.getPosCellOffsets()[i];
+            positions[order[i]] = Vec3(x*precision, y*precision, z*precision)-boxVectors[0]*offset.x-boxVectors[1]*offset.y-boxVectors[2]*offset.z;
+        }
+    });
+    cc.getThreadPool().waitForThreads();
+}
+
+void CommonUpdateStateDataKernel::uploadCoordinates(const vector<Vec3>& values) {
+    // The upload does not block, so wait until the previous one has finished reading the staging memory
+    // before overwriting it.  Later kernels are queued behind the upload, so nothing else needs to wait.
+
+    if (uploadPending)
+        uploadEvent->wait();
+    if (uploadBuffer.getElementSize() == sizeof(double)) {
+        double* staging = (double*) uploadStaging;
+        for (int i = 0; i < values.size(); i++) {
+            staging[3*i] = values[i][0];
+            staging[3*i+1] = values[i][1];
+            staging[3*i+2] = values[i][2];
         }
-        floatBuffer.upload(pos);
-        copyFloatKernel->setArg(1, cc.getPosq());
-        copyFloatKernel->execute(numParticles);
     }
-    if (cc.getUseMixedPrecision()) {
-        mm_float4* posCorrection = (mm_float4*) cc.getPinnedBuffer();
-        for (int i = 0; i < numParticles; ++i) {
-            mm_float4& c = posCorrection[i];
-            const Vec3& p = positions[order[i]];
-            c.x = (float) (p[0]-(float)p[0]);
-            c.y = (float) (p[1]-(float)p[1]);
-            c.z = (float) (p[2]-(float)p[2]);
-            c.w = 0;
+    else {
+        float* staging = (float*) uploadStaging;
+        for (int i = 0; i < values.size(); i++) {
+            staging[3*i] = (float) values[i][0];
+            staging[3*i+1] = (float) values[i][1];
+            staging[3*i+2] = (float) values[i][2];
         }
-        for (int i = numParticles; i < cc.getPaddedNumAtoms(); i++)
-            posCorrection[i] = mm_float4(0.0f, 0.0f, 0.0f, 0.0f);
-        cc.getPosqCorrection().upload(posCorrection);
     }
+    uploadBuffer.upload(uploadStaging, false);
+    uploadEvent->enqueue();
+    uploadPending = true;
+}
+
+void CommonUpdateStateDataKernel::setPositions(ContextImpl& context, const vector<Vec3>& positions) {
+    ContextSelector selector(cc);
+    uploadCoordinates(positions);
+    setPositionsKernel->execute(cc.getNumAtoms());
     for (auto& offset : cc.getPosCellOffsets())
         offset = mm_int4(0, 0, 0, 0);
+    for (auto ctx : cc.getAllContexts())
+        ctx->setPositionsSetCount(ctx->getPositionsSetCount()+1);
     cc.reorderAtoms();
 }
 
@@ -226,32 +349,9 @@ void CommonUpdateStateDataKernel::getVelocities(ContextImpl& context, vector<Vec
 
 void CommonUpdateStateDataKernel::setVelocities(ContextImpl& context, const vector<Vec3>& velocities) {
     ContextSelector selector(cc);
-    const vector<int>& order = cc.getAtomIndex();
-    int numParticles = context.getSystem().getNumParticles();
-    if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision()) {
-        double* vel = (double*) cc.getPinnedBuffer();
-        for (int i = 0; i < numParticles; ++i) {
-            const Vec3& p = velocities[order[i]];
-            vel[3*i] = p[0];
-            vel[3*i+1] = p[1];
-            vel[3*i+2] = p[2];
-        }
-        doubleBuffer.upload(vel);
-        copyDoubleKernel->setArg(1, cc.getVelm());
-        copyDoubleKernel->execute(numParticles);
-    }
-    else {
-        float* vel = (float*) cc.getPinnedBuffer();
-        for (int i = 0; i < numParticles; ++i) {
-            const Vec3& p = velocities[order[i]];
-            vel[3*i] = (float) p[0];
-            vel[3*i+1] = (float) p[1];
-            vel[3*i+2] = (float) p[2];
-        }
-        floatBuffer.upload(vel);
-        copyFloatKernel->setArg(1, cc.getVelm());
-        copyFloatKernel->execute(numParticles);
-    }
+    cc.getIntegrationUtilities().setCMMomentumStep(-1);
+    uploadCoordinates(velocities);
+    setVelocitiesKernel->execute(cc.getNumAtoms());
 }
 
 void CommonUpdateStateDataKernel::computeShiftedVelocities(ContextImpl& context, double timeShift, vector<Vec3>& velocities) {
@@ -271,6 +371,128 @@ void CommonUpdateStateDataKernel::getForces(ContextImpl& context, vector<Vec3>&
         forces[order[i]] = Vec3(scale*force[i], scale*force[i+paddedNumParticles], scale*force[i+paddedNumParticles*2]);
 }
 
+void CommonUpdateStateDataKernel::setParticleSubset(const vector<int>& particles) {
+    if (particles == subsetParticles)
+        return;
+    subsetParticles = particles;
+
+    // Assign a slot in the gathered arrays to each distinct particle.
+
+    vector<int> slot(cc.getNumAtoms(), -1);
+    subsetSlots.resize(particles.size());
+    int numSlots = 0;
+    for (int i = 0; i < particles.size(); i++) {
+        if (slot[particles[i]] == -1)
+            slot[particles[i]] = numSlots++;
+        subsetSlots[i] = slot[particles[i]];
+    }
+    particleSlot.upload(slot);
+
+    // Allocate arrays of exactly the right size, so only the requested data gets downloaded.
+
+    int elementSize = (cc.getUseDoublePrecision() || cc.getUseMixedPrecision() ? sizeof(mm_double4) : sizeof(mm_float4));
+    if (!gatheredIndex.isInitialized()) {
+        gatheredIndex.initialize<int>(cc, numSlots, "gatheredIndex");
+        gatheredPositions.initialize(cc, numSlots, elementSize, "gatheredPositions");
+        gatheredVelocities.initialize(cc, numSlots, elementSize, "gatheredVelocities");
+        gatheredForces.initialize<long long>(cc, 3*numSlots, "gatheredForces");
+    }
+    else if (gatheredIndex.getSize() != numSlots) {
+        gatheredIndex.resize(numSlots);
+        gatheredPositions.resize(numSlots);
+        gatheredVelocities.resize(numSlots);
+        gatheredForces.resize(3*numSlots);
+    }
+    int posArg = (cc.getUseMixedPrecision() ? 4 : 3);
+    gatherPositionsKernel->setArg(posArg, gatheredPositions);
+    gatherPositionsKernel->setArg(posArg+1, gatheredIndex);
+    gatherVelocitiesKernel->setArg(3, gatheredVelocities);
+    gatherForcesKernel->setArg(3, gatheredForces);
+}
+
+void CommonUpdateStateDataKernel::getParticlePositions(ContextImpl& context, const vector<int>& particles, vector<Vec3>& positions) {
+    positions.resize(particles.size());
+    if (particles.size() == 0)
+        return;
+    ContextSelector selector(cc);
+    setParticleSubset(particles);
+    gatherPositionsKernel->execute(cc.getNumAtoms());
+    int numSlots = gatheredIndex.getSize();
+    vector<int> index;
+    gatheredIndex.download(index);
+    vector<Vec3> pos(numSlots);
+    if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision()) {
+        mm_double4* data = (mm_double4*) cc.getPinnedBuffer();
+        gatheredPositions.download(data);
+        for (int i = 0; i < numSlots; i++)
+            pos[i] = Vec3(data[i].x, data[i].y, data[i].z);
+    }
+    else {
+        mm_float4* data = (mm_float4*) cc.getPinnedBuffer();
+        gatheredPositions.download(data);
+        for (int i = 0; i < numSlots; i++)
+            pos[i] = Vec3(data[i].x, data[i].y, data[i].z);
+    }
+    Vec3 boxVectors[3];
+    cc.getPeriodicBoxVectors(boxVectors[0], boxVectors[1], boxVectors[2]);
+    for (int i = 0; i < numSlots; i++) {
+        mm_int4 offset = cc.getPosCellOffsets()[index[i]];
+        pos[i] -= boxVectors[0]*offset.x+boxVectors[1]*offset.y+boxVectors[2]*offset.z;
+    }
+    for (int i = 0; i < particles.size(); i++)
+        positions[i] = pos[subsetSlots[i]];
+}
+
+void CommonUpdateStateDataKernel::getParticleVelocities(ContextImpl& context, const vector<int>& particles, vector<Vec3>& velocities) {
+    velocities.resize(particles.size());
+    if (particles.size() == 0)
+        return;
+    ContextSelector selector(cc);
+    setParticleSubset(particles);
+    gatherVelocitiesKernel->execute(cc.getNumAtoms());
+    if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision()) {
+        mm_double4* data = (mm_double4*) cc.getPinnedBuffer();
+        gatheredVelocities.download(data);
+        for (int i = 0; i < particles.size(); i++) {
+            mm_double4 vel = data[subsetSlots[i]];
+            velocities[i] = Vec3(vel.x, vel.y, vel.z);
+        }
+    }
+    else {
+        mm_float4* data = (mm_float4*) cc.getPinnedBuffer();
+        gatheredVelocities.download(data);
+        for (int i = 0; i < particles.size(); i++) {
+            mm_float4 vel = data[subsetSlots[i]];
+            velocities[i] = Vec3(vel.x, vel.y, vel.z);
+        }
+    }
+}
+
+void CommonUpdateStateDataKernel::scaleVelocities(ContextImpl& context, double scale) {
+    ContextSelector selector(cc);
+    if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision())
+        scaleVelocitiesKernel->setArg(2, scale);
+    else
+        scaleVelocitiesKernel->setArg(2, (float) scale);
+    scaleVelocitiesKernel->execute(cc.getNumAtoms());
+}
+
+void CommonUpdateStateDataKernel::getParticleForces(ContextImpl& context, const vector<int>& particles, vector<Vec3>& forces) {
+    forces.resize(particles.size());
+    if (particles.size() == 0)
+        return;
+    ContextSelector selector(cc);
+    setParticleSubset(particles);
+    gatherForcesKernel->execute(cc.getNumAtoms());
+    long long* force = (long long*) cc.getPinnedBuffer();
+    gatheredForces.download(force);
+    double scale = 1.0/(double) 0x100000000LL;
+    for (int i = 0; i < particles.size(); i++) {
+        int slot = subsetSlots[i];
+        forces[i] = Vec3(scale*force[3*slot], scale*force[3*slot+1], scale*force[3*slot+2]);
+    }
+}
+
 void CommonUpdateStateDataKernel::getEnergyParameterDerivatives(ContextImpl& context, map<string, double>& derivs) {
     ContextSelector selector(cc);
     const vector<string>& paramDerivNames = cc.getEnergyParamDerivNames();
@@ -299,6 +521,169 @@ void CommonUpdateStateDataKernel::getEnergyParameterDerivatives(ContextImpl& con
     }
 }
 
+/**
+ * This holds the staging buffers used by one call to getStateDataAsync().  They are reused by later
+ * calls once the data has been retrieved.
+ */
+class CommonUpdateStateDataKernel::AsyncTransfer {
+public:
+    AsyncTransfer(ComputeContext& cc) : cc(cc), pinnedMemory(NULL) {
+        posq.initialize(cc, cc.getPosq().getSize(), cc.getPosq().getElementSize(), "asyncPosq");
+        if (cc.getUseMixedPrecision())
+            posqCorrection.initialize(cc, cc.getPosqCorrection().getSize(), cc.getPosqCorrection().getElementSize(), "asyncPosqCorrection");
+        velm.initialize(cc, cc.getVelm().getSize(), cc.getVelm().getElementSize(), "asyncVelm");
+        force.initialize(cc, cc.getLongForceBuffer().getSize(), cc.getLongForceBuffer().getElementSize(), "asyncForce");
+        copyEvent = cc.createEvent();
+        transferEvent = cc.createEvent();
+        positionOffset = 0;
+        correctionOffset = positionOffset + posq.getSize()*posq.getElementSize();
+        velocityOffset = correctionOffset + (posqCorrection.isInitialized() ? posqCorrection.getSize()*posqCorrection.getElementSize() : 0);
+        forceOffset = velocityOffset + velm.getSize()*velm.getElementSize();
+        pinnedMemory = (char*) cc.allocatePinnedMemory(forceOffset + force.getSize()*force.getElementSize());
+    }
+    ~AsyncTransfer() {
+        ContextSelector selector(cc);
+        cc.freePinnedMemory(pinnedMemory);
+    }
+    ComputeContext& cc;
+    ComputeArray posq, posqCorrection, velm, force;
+    ComputeEvent copyEvent, transferEvent;
+    char* pinnedMemory;
+    size_t positionOffset, correctionOffset, velocityOffset, forceOffset;
+    vector<int> order;
+    vector<mm_int4> cellOffsets;
+    Vec3 boxVectors[3];
+};
+
+CommonUpdateStateDataKernel::~CommonUpdateStateDataKernel() {
+    // Wait for any background retrievals that are still using the staging buffers.
+
+    for (auto& transfer : asyncTransfers)
+        while (transfer.use_count() > 1)
+            this_thread::yield();
+    if (uploadStaging != NULL) {
+        ContextSelector selector(cc);
+        if (uploadPending)
+            uploadEvent->wait();
+        cc.freePinnedMemory(uploadStaging);
+    }
+}
+
+UpdateStateDataKernel::StateDataFunction CommonUpdateStateDataKernel::getStateDataAsync(ContextImpl& context, bool positions, bool velocities, bool forces) {
+    ContextSelector selector(cc);
+
+    // Find a set of staging buffers that is not being used by an earlier call.
+
+    shared_ptr<AsyncTransfer> transfer;
+    for (auto& t : asyncTransfers)
+        if (t.use_count() == 1) {
+            transfer = t;
+            break;
+        }
+    if (!transfer) {
+        transfer = make_shared<AsyncTransfer>(cc);
+        asyncTransfers.push_back(transfer);
+    }
+    if (!transferQueue)
+        transferQueue = cc.createQueue();
+
+    // Copy the arrays to the staging buffers.  This happens in the normal order of execution, so it
+    // captures them as they are now, and later kernels are free to modify the originals.
+
+    if (positions) {
+        cc.getPosq().copyTo(transfer->posq);
+        if (cc.getUseMixedPrecision())
+            cc.getPosqCorrection().copyTo(transfer->posqCorrection);
+        transfer->order = cc.getAtomIndex();
+        transfer->cellOffsets = cc.getPosCellOffsets();
+        cc.getPeriodicBoxVectors(transfer->boxVectors[0], transfer->boxVectors[1], transfer->boxVectors[2]);
+    }
+    if (velocities || forces)
+        transfer->order = cc.getAtomIndex();
+    if (velocities)
+        cc.getVelm().copyTo(transfer->velm);
+    if (forces)
+        cc.getLongForceBuffer().copyTo(transfer->force);
+    transfer->copyEvent->enqueue();
+
+    // Download them to pinned memory on a separate queue, so the transfer does not delay other work.
+
+    cc.setCurrentQueue(transferQueue);
+    transfer->copyEvent->queueWait(transferQueue);
+    if (positions) {
+        transfer->posq.download(transfer->pinnedMemory+transfer->positionOffset, false);
+        if (cc.getUseMixedPrecision())
+            transfer->posqCorrection.download(transfer->pinnedMemory+transfer->correctionOffset, false);
+    }
+    if (velocities)
+        transfer->velm.download(transfer->pinnedMemory+transfer->velocityOffset, false);
+    if (forces)
+        transfer->force.download(transfer->pinnedMemory+transfer->forceOffset, false);
+    transfer->transferEvent->enqueue();
+    cc.restoreDefaultQueue();
+
+    // Return a function that waits for the transfer and converts the data.
+
+    ComputeContext& cc = this->cc;
+    int numParticles = context.getSystem().getNumParticles();
+    return [transfer, &cc, numParticles, positions, velocities, forces] (vector<Vec3>& positionsOut, vector<Vec3>& velocitiesOut, vector<Vec3>& forcesOut) mutable {
+        {
+            ContextSelector selector(cc);
+            transfer->transferEvent->wait();
+        }
+        const vector<int>& order = transfer->order;
+        int paddedNumParticles = cc.getPaddedNumAtoms();
+        if (positions) {
+            positionsOut.resize(numParticles);
+            const Vec3* box = transfer->boxVectors;
+            char* data = transfer->pinnedMemory+transfer->positionOffset;
+            for (int i = 0; i < numParticles; ++i) {
+                Vec3 pos;
+                if (cc.getUseDoublePrecision()) {
+                    mm_double4 p = ((mm_double4*) data)[i];
+                    pos = Vec3(p.x, p.y, p.z);
+                }
+                else if (cc.getUseMixedPrecision()) {
+                    mm_float4 p1 = ((mm_float4*) data)[i];
+                    mm_float4 p2 = ((mm_float4*) (transfer->pinnedMemory+transfer->correctionOffset))[i];
+                    pos = Vec3((double) p1.x+(double) p2.x, (double) p1.y+(double) p2.y, (double) p1.z+(double) p2.z);
+                }
+                else {
+                    mm_float4 p = ((mm_float4*) data)[i];
+                    pos = Vec3(p.x, p.y, p.z);
+                }
+                mm_int4 offset = transfer->cellOffsets[i];
+                positionsOut[order[i]] = pos-box[0]*offset.x-box[1]*offset.y-box[2]*offset.z;
+            }
+        }
+        if (velocities) {
+            velocitiesOut.resize(numParticles);
+            char* data = transfer->pinnedMemory+transfer->velocityOffset;
+            for (int i = 0; i < numParticles; ++i) {
+                if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision()) {
+                    mm_double4 v = ((mm_double4*) data)[i];
+                    velocitiesOut[order[i]] = Vec3(v.x, v.y, v.z);
+                }
+                else {
+                    mm_float4 v = ((mm_float4*) data)[i];
+                    velocitiesOut[order[i]] = Vec3(v.x, v.y, v.z);
+                }
+            }
+        }
+        if (forces) {
+            forcesOut.resize(numParticles);
+            long long* force = (long long*) (transfer->pinnedMemory+transfer->forceOffset);
+            double scale = 1.0/(double) 0x100000000LL;
+            for (int i = 0; i < numParticles; ++i)
+                forcesOut[order[i]] = Vec3(scale*force[i], scale*force[i+paddedNumParticles], scale*force[i+paddedNumParticles*2]);
+        }
+
+        // Release the staging buffers so later calls can reuse them.
+
+        transfer.reset();
+    };
+}
+
 void CommonUpdateStateDataKernel::getPeriodicBoxVectors(ContextImpl& context, Vec3& a, Vec3& b, Vec3& c) const {
     cc.getPeriodicBoxVectors(a, b, c);
 }
@@ -358,6 +743,7 @@ void CommonUpdateStateDataKernel::createCheckpoint(ContextImpl& context, ostream
 
 void CommonUpdateStateDataKernel::loadCheckpoint(ContextImpl& context, istream& stream) {
     ContextSelector selector(cc);
+    cc.getIntegrationUtilities().setCMMomentumStep(-1);
     int version;
     stream.read((char*) &version, sizeof(int));
     if (version != 3)
@@ -378,6 +764,7 @@ void CommonUpdateStateDataKernel::loadCheckpoint(ContextImpl& context, istream&
         ctx->setTime(time);
         ctx->setStepCount(stepCount);
         ctx->setStepsSinceReorder(stepsSinceReorder);
+        ctx->setPositionsSetCount(ctx->getPositionsSetCount()+1);
     }
     char* buffer = (char*) cc.getPinnedBuffer();
     stream.read(buffer, cc.getPosq().getSize()*cc.getPosq().getElementSize());
@@ -427,6 +814,7 @@ void CommonApplyConstraintsKernel::apply(ContextImpl& context, double tol) {
 
 void CommonApplyConstraintsKernel::applyToVelocities(ContextImpl& context, double tol) {
     cc.getIntegrationUtilities().applyVelocityConstraints(tol);
+    cc.getIntegrationUtilities().setCMMomentumStep(-1);
 }
 
 void CommonVirtualSitesKernel::initialize(const System& system) {
@@ -471,14 +859,13 @@ void CommonCalcHarmonicBondForceKernel::initialize(const System& system, const H
     if (numBonds == 0)
         return;
     vector<vector<int> > atoms(numBonds, vector<int>(2));
-    params.initialize<mm_float2>(cc, numBonds, "bondParams");
     vector<mm_float2> paramVector(numBonds);
     for (int i = 0; i < numBonds; i++) {
         double length, k;
         force.getBondParameters(startIndex+i, atoms[i][0], atoms[i][1], length, k);
         paramVector[i] = mm_float2((float) length, (float) k);
     }
-    params.upload(paramVector);
+    cc.initializeSharedArray(params, paramVector, "bondParams");
     map<string, string> replacements;
     replacements["APPLY_PERIODIC"] = (force.usesPeriodicBoundaryConditions() ? "1" : "0");
     replacements["COMPUTE_FORCE"] = CommonKernelSources::harmonicBondForce;
@@ -684,7 +1071,6 @@ void CommonCalcHarmonicAngleForceKernel::initialize(const System& system, const
     if (numAngles == 0)
         return;
     vector<vector<int> > atoms(numAngles, vector<int>(3));
-    params.initialize<mm_float2>(cc, numAngles, "angleParams");
     vector<mm_float2> paramVector(numAngles);
     for (int i = 0; i < numAngles; i++) {
         double angle, k;
@@ -692,7 +1078,7 @@ void CommonCalcHarmonicAngleForceKernel::initialize(const System& system, const
         paramVector[i] = mm_float2((float) angle, (float) k);
 
     }
-    params.upload(paramVector);
+    cc.initializeSharedArray(params, paramVector, "angleParams");
     map<string, string> replacements;
     replacements["APPLY_PERIODIC"] = (force.usesPeriodicBoundaryConditions() ? "1" : "0");
     replacements["COMPUTE_FORCE"] = CommonKernelSources::harmonicAngleForce;
@@ -901,7 +1287,6 @@ void CommonCalcPeriodicTorsionForceKernel::initialize(const System& system, cons
     if (numTorsions == 0)
         return;
     vector<vector<int> > atoms(numTorsions, vector<int>(4));
-    params.initialize<mm_float4>(cc, numTorsions, "periodicTorsionParams");
     vector<mm_float4> paramVector(numTorsions);
     for (int i = 0; i < numTorsions; i++) {
         int periodicity;
@@ -909,7 +1294,7 @@ void CommonCalcPeriodicTorsionForceKernel::initialize(const System& system, cons
         force.getTorsionParameters(startIndex+i, atoms[i][0], atoms[i][1], atoms[i][2], atoms[i][3], periodicity, phase, k);
         paramVector[i] = mm_float4((float) k, (float) phase, (float) periodicity, 0.0f);
     }
-    params.upload(paramVector);
+    cc.initializeSharedArray(params, paramVector, "periodicTorsionParams");
     map<string, string> replacements;
     replacements["APPLY_PERIODIC"] = (force.usesPeriodicBoundaryConditions() ? "1" : "0");
     replacements["COMPUTE_FORCE"] = CommonKernelSources::periodicTorsionForce;
@@ -989,8 +1374,6 @@ void CommonCalcRBTorsionForceKernel::initialize(const System& system, const RBTo
     if (numTorsions == 0)
         return;
     vector<vector<int> > atoms(numTorsions, vector<int>(4));
-    params1.initialize<mm_float4>(cc, numTorsions, "rbTorsionParams1");
-    params2.initialize<mm_float2>(cc, numTorsions, "rbTorsionParams2");
     vector<mm_float4> paramVector1(numTorsions);
     vector<mm_float2> paramVector2(numTorsions);
     for (int i = 0; i < numTorsions; i++) {
@@ -1000,8 +1383,8 @@ void CommonCalcRBTorsionForceKernel::initialize(const System& system, const RBTo
         paramVector2[i] = mm_float2((float) c4, (float) c5);
 
     }
-    params1.upload(paramVector1);
-    params2.upload(paramVector2);
+    cc.initializeSharedArray(params1, paramVector1, "rbTorsionParams1");
+    cc.initializeSharedArray(params2, paramVector2, "rbTorsionParams2");
     map<string, string> replacements;
     replacements["APPLY_PERIODIC"] = (force.usesPeriodicBoundaryConditions() ? "1" : "0");
     replacements["COMPUTE_FORCE"] = CommonKernelSources::rbTorsionForce;
@@ -1231,10 +1614,23 @@ void CommonCalcCMAPTorsionForceKernel::initialize(const System& system, const CM
             coeffVec.push_back(mm_float4((float) c[j][12], (float) c[j][13], (float) c[j][14], (float) c[j][15]));
         }
     }
+
+    // Sort the torsions by map, so neighboring threads read from the same coefficient table.
+
+    vector<pair<int, int> > sortedTorsions(numTorsions);
+    for (int i = 0; i < numTorsions; i++) {
+        int map, a1, a2, a3, a4, b1, b2, b3, b4;
+        force.getTorsionParameters(startIndex+i, map, a1, a2, a3, a4, b1, b2, b3, b4);
+        sortedTorsions[i] = make_pair(map, startIndex+i);
+    }
+    sort(sortedTorsions.begin(), sortedTorsions.end());
+    torsionOrder.resize(numTorsions);
     vector<vector<int> > atoms(numTorsions, vector<int>(8));
     vector<int> torsionMapsVec(numTorsions);
-    for (int i = 0; i < numTorsions; i++)
-        force.getTorsionParameters(startIndex+i, torsionMapsVec[i], atoms[i][0], atoms[i][1], atoms[i][2], atoms[i][3], atoms[i][4], atoms[i][5], atoms[i][6], atoms[i][7]);
+    for (int i = 0; i < numTorsions; i++) {
+        torsionOrder[i] = sortedTorsions[i].second;
+        force.getTorsionParameters(torsionOrder[i], torsionMapsVec[i], atoms[i][0], atoms[i][1], atoms[i][2], atoms[i][3], atoms[i][4], atoms[i][5], atoms[i][6], atoms[i][7]);
+    }
     coefficients.initialize<mm_float4>(cc, coeffVec.size(), "cmapTorsionCoefficients");
     mapPositions.initialize<mm_int2>(cc, numMaps, "cmapTorsionMapPositions");
     torsionMaps.initialize<int>(cc, numTorsions, "cmapTorsionMaps");
@@ -1294,7 +1690,7 @@ void CommonCalcCMAPTorsionForceKernel::copyParametersToContext(ContextImpl& cont
     vector<int> torsionMapsVec(numTorsions);
     for (int i = 0; i < numTorsions; i++) {
         int index[8];
-        force.getTorsionParameters(i, torsionMapsVec[i], index[0], index[1], index[2], index[3], index[4], index[5], index[6], index[7]);
+        force.getTorsionParameters(torsionOrder[i], torsionMapsVec[i], index[0], index[1], index[2], index[3], index[4], index[5], index[6], index[7]);
     }
     torsionMaps.upload(torsionMapsVec);
 }
@@ -1484,6 +1880,7 @@ void CommonCalcCustomCompoundBondForceKernel::initialize(const System& system, c
     vector<pair<string, string> > functionDefinitions;
     vector<const TabulatedFunction*> functionList;
     tabulatedFunctionArrays.resize(force.getNumTabulatedFunctions());
+    tabulatedFunctionValues.resize(force.getNumTabulatedFunctions());
     for (int i = 0; i < force.getNumTabulatedFunctions(); i++) {
         functionList.push_back(&force.getTabulatedFunction(i));
         string name = force.getTabulatedFunctionName(i);
@@ -1491,8 +1888,8 @@ void CommonCalcCustomCompoundBondForceKernel::initialize(const System& system, c
         functions[name] = cc.getExpressionUtilities().getFunctionPlaceholder(force.getTabulatedFunction(i));
         int width;
         vector<float> f = cc.getExpressionUtilities().computeFunctionCoefficients(force.getTabulatedFunction(i), width);
-        tabulatedFunctionArrays[i].initialize<float>(cc, f.size(), "TabulatedFunction");
-        tabulatedFunctionArrays[i].upload(f);
+        cc.initializeSharedArray(tabulatedFunctionArrays[i], f, "TabulatedFunction");
+        tabulatedFunctionValues[i] = f;
         string arrayName = cc.getBondedUtilities().addArgument(tabulatedFunctionArrays[i], width == 1 ? "float" : "float"+cc.intToString(width));
         functionDefinitions.push_back(make_pair(name, arrayName));
     }
@@ -1588,9 +1985,7 @@ void CommonCalcCustomCompoundBondForceKernel::copyParametersToContext(ContextImp
         string name = force.getTabulatedFunctionName(i);
         if (force.getTabulatedFunction(i).getUpdateCount() != tabulatedFunctionUpdateCount[name]) {
             tabulatedFunctionUpdateCount[name] = force.getTabulatedFunction(i).getUpdateCount();
-            int width;
-            vector<float> f = cc.getExpressionUtilities().computeFunctionCoefficients(force.getTabulatedFunction(i), width);
-            tabulatedFunctionArrays[i].upload(f);
+            cc.getExpressionUtilities().updateFunctionCoefficients(force.getTabulatedFunction(i), tabulatedFunctionArrays[i], tabulatedFunctionValues[i]);
         }
     }
 
@@ -1674,19 +2069,50 @@ void CommonCalcCustomCentroidBondForceKernel::initialize(const System& system, c
     CustomCentroidBondForceImpl::computeNormalizedWeights(force, system, normalizedWeights);
     for (int i = 0; i < numGroups; i++)
         groupWeightVec.insert(groupWeightVec.end(), normalizedWeights[i].begin(), normalizedWeights[i].end());
+
+    // Large groups are divided into segments, each of which is processed by a single thread block.
+    // That keeps a few very large groups from serializing the work.  The partial centers of the
+    // segments are then summed for each group.
+
+    const int maxSegmentSize = 1024;
+    vector<int> segmentOffsetVec, segmentGroupVec, groupSegmentOffsetVec;
+    segmentOffsetVec.push_back(0);
+    groupSegmentOffsetVec.push_back(0);
+    for (int i = 0; i < numGroups; i++) {
+        for (int start = groupOffsetVec[i]; start < groupOffsetVec[i+1]; start += maxSegmentSize) {
+            segmentOffsetVec.push_back(min(start+maxSegmentSize, groupOffsetVec[i+1]));
+            segmentGroupVec.push_back(i);
+        }
+        if (groupOffsetVec[i] == groupOffsetVec[i+1]) {
+            segmentOffsetVec.push_back(groupOffsetVec[i]);
+            segmentGroupVec.push_back(i);
+        }
+        groupSegmentOffsetVec.push_back(segmentGroupVec.size());
+    }
+    numSegments = segmentGroupVec.size();
     groupParticles.initialize<int>(cc, groupParticleVec.size(), "groupParticles");
     groupParticles.upload(groupParticleVec);
     if (cc.getUseDoublePrecision()) {
         groupWeights.initialize<double>(cc, groupParticleVec.size(), "groupWeights");
         centerPositions.initialize<mm_double4>(cc, numGroups, "centerPositions");
+        if (numSegments > numGroups)
+            segmentCenters.initialize<mm_double4>(cc, numSegments, "segmentCenters");
     }
     else {
         groupWeights.initialize<float>(cc, groupParticleVec.size(), "groupWeights");
         centerPositions.initialize<mm_float4>(cc, numGroups, "centerPositions");
+        if (numSegments > numGroups)
+            segmentCenters.initialize<mm_float4>(cc, numSegments, "segmentCenters");
     }
     groupWeights.upload(groupWeightVec, true);
-    groupOffsets.initialize<int>(cc, groupOffsetVec.size(), "groupOffsets");
-    groupOffsets.upload(groupOffsetVec);
+    segmentOffsets.initialize<int>(cc, segmentOffsetVec.size(), "segmentOffsets");
+    segmentOffsets.upload(segmentOffsetVec);
+    segmentGroups.initialize<int>(cc, segmentGroupVec.size(), "segmentGroups");
+    segmentGroups.upload(segmentGroupVec);
+    if (numSegments > numGroups) {
+        groupSegmentOffsets.initialize<int>(cc, groupSegmentOffsetVec.size(), "groupSegmentOffsets");
+        groupSegmentOffsets.upload(groupSegmentOffsetVec);
+    }
     groupForces.initialize<long long>(cc, numGroups*3, "groupForces");
     cc.addAutoclearBuffer(groupForces);
     
@@ -1713,6 +2139,7 @@ void CommonCalcCustomCentroidBondForceKernel::initialize(const System& system, c
     vector<const TabulatedFunction*> functionList;
     stringstream extraArgs;
     tabulatedFunctionArrays.resize(force.getNumTabulatedFunctions());
+    tabulatedFunctionValues.resize(force.getNumTabulatedFunctions());
     for (int i = 0; i < force.getNumTabulatedFunctions(); i++) {
         functionList.push_back(&force.getTabulatedFunction(i));
         string name = force.getTabulatedFunctionName(i);
@@ -1722,8 +2149,8 @@ void CommonCalcCustomCentroidBondForceKernel::initialize(const System& system, c
         functions[name] = cc.getExpressionUtilities().getFunctionPlaceholder(force.getTabulatedFunction(i));
         int width;
         vector<float> f = cc.getExpressionUtilities().computeFunctionCoefficients(force.getTabulatedFunction(i), width);
-        tabulatedFunctionArrays[i].initialize<float>(cc, f.size(), "TabulatedFunction");
-        tabulatedFunctionArrays[i].upload(f);
+        cc.initializeSharedArray(tabulatedFunctionArrays[i], f, "TabulatedFunction");
+        tabulatedFunctionValues[i] = f;
         extraArgs << ", GLOBAL const float";
         if (width > 1)
             extraArgs << width;
@@ -1823,12 +2250,21 @@ void CommonCalcCustomCentroidBondForceKernel::initialize(const System& system, c
     replacements["SAVE_PARAM_DERIVS"] = saveParamDerivs.str();
     ComputeProgram program = cc.compileProgram(cc.replaceStrings(CommonKernelSources::pointFunctions+CommonKernelSources::customCentroidBond, replacements));
     computeCentersKernel = program->createKernel("computeGroupCenters");
-    computeCentersKernel->addArg(numGroups);
+    computeCentersKernel->addArg(numSegments);
     computeCentersKernel->addArg(cc.getPosq());
     computeCentersKernel->addArg(groupParticles);
     computeCentersKernel->addArg(groupWeights);
-    computeCentersKernel->addArg(groupOffsets);
-    computeCentersKernel->addArg(centerPositions);
+    computeCentersKernel->addArg(segmentOffsets);
+    if (numSegments > numGroups) {
+        computeCentersKernel->addArg(segmentCenters);
+        sumSegmentsKernel = program->createKernel("sumSegmentCenters");
+        sumSegmentsKernel->addArg(numGroups);
+        sumSegmentsKernel->addArg(groupSegmentOffsets);
+        sumSegmentsKernel->addArg(segmentCenters);
+        sumSegmentsKernel->addArg(centerPositions);
+    }
+    else
+        computeCentersKernel->addArg(centerPositions);
     groupForcesKernel = program->createKernel("computeGroupForces");
     groupForcesKernel->addArg(numGroups);
     groupForcesKernel->addArg(groupForces);
@@ -1846,10 +2282,12 @@ void CommonCalcCustomCentroidBondForceKernel::initialize(const System& system, c
     for (auto& parameter : params->getParameterInfos())
         groupForcesKernel->addArg(parameter.getArray());
     applyForcesKernel = program->createKernel("applyForcesToAtoms");
+    applyForcesKernel->addArg(numSegments);
     applyForcesKernel->addArg(numGroups);
     applyForcesKernel->addArg(groupParticles);
     applyForcesKernel->addArg(groupWeights);
-    applyForcesKernel->addArg(groupOffsets);
+    applyForcesKernel->addArg(segmentOffsets);
+    applyForcesKernel->addArg(segmentGroups);
     applyForcesKernel->addArg(groupForces);
     applyForcesKernel->addArg();
 }
@@ -1858,7 +2296,9 @@ double CommonCalcCustomCentroidBondForceKernel::execute(ContextImpl& context, bo
     if (numBonds == 0)
         return 0.0;
     ContextSelector selector(cc);
-    computeCentersKernel->execute(32*numGroups);
+    computeCentersKernel->execute(32*numSegments, 64);
+    if (numSegments > numGroups)
+        sumSegmentsKernel->execute(numGroups);
     groupForcesKernel->setArg(2, cc.getEnergyBuffer());
     setPeriodicBoxArgs(cc, groupForcesKernel, 5);
     if (needEnergyParamDerivs)
@@ -1870,8 +2310,8 @@ double CommonCalcCustomCentroidBondForceKernel::execute(ContextImpl& context, bo
         groupForcesKernel->setArg(index, cc.getGlobalParamValues());
     }
     groupForcesKernel->execute(numBonds);
-    applyForcesKernel->setArg(5, cc.getLongForceBuffer());
-    applyForcesKernel->execute(32*numGroups);
+    applyForcesKernel->setArg(7, cc.getLongForceBuffer());
+    applyForcesKernel->execute(32*numSegments, 64);
     return 0.0;
 }
 
@@ -1896,9 +2336,7 @@ void CommonCalcCustomCentroidBondForceKernel::copyParametersToContext(ContextImp
         string name = force.getTabulatedFunctionName(i);
         if (force.getTabulatedFunction(i).getUpdateCount() != tabulatedFunctionUpdateCount[name]) {
             tabulatedFunctionUpdateCount[name] = force.getTabulatedFunction(i).getUpdateCount();
-            int width;
-            vector<float> f = cc.getExpressionUtilities().computeFunctionCoefficients(force.getTabulatedFunction(i), width);
-            tabulatedFunctionArrays[i].upload(f);
+            cc.getExpressionUtilities().updateFunctionCoefficients(force.getTabulatedFunction(i), tabulatedFunctionArrays[i], tabulatedFunctionValues[i]);
         }
     }
 
@@ -2243,7 +2681,10 @@ void CommonCalcGayBerneForceKernel::initialize(const System& system, const GayBe
     maxNeighborBlocks = numRealParticles*2;
     neighbors.initialize<int>(cc, maxNeighborBlocks*32, "neighbors");
     neighborIndex.initialize<int>(cc, maxNeighborBlocks, "neighborIndex");
-    neighborBlockCount.initialize<int>(cc, 1, "neighborBlockCount");
+    neighborBlockCount.initialize<int>(cc, 2, "neighborBlockCount");
+    maxBlockNeighbors = max(1, min(numAtomBlocks, 128));
+    blockNeighbors.initialize<int>(cc, max(1, numAtomBlocks)*maxBlockNeighbors, "blockNeighbors");
+    blockNeighborCount.initialize<int>(cc, max(1, numAtomBlocks), "blockNeighborCount");
     event = cc.createEvent();
 
     // Create array for accumulating torques.
@@ -2278,6 +2719,7 @@ void CommonCalcGayBerneForceKernel::initialize(const System& system, const GayBe
     ComputeProgram program = cc.compileProgram(CommonKernelSources::gayBerne, defines);
     framesKernel = program->createKernel("computeEllipsoidFrames");
     blockBoundsKernel = program->createKernel("findBlockBounds");
+    blockNeighborsKernel = program->createKernel("findBlockNeighbors");
     neighborsKernel = program->createKernel("findNeighbors");
     forceKernel = program->createKernel("computeForce");
     torqueKernel = program->createKernel("applyTorques");
@@ -2309,6 +2751,15 @@ double CommonCalcGayBerneForceKernel::execute(ContextImpl& context, bool include
         blockBoundsKernel->addArg(blockCenter);
         blockBoundsKernel->addArg(blockBoundingBox);
         blockBoundsKernel->addArg(neighborBlockCount);
+        blockNeighborsKernel->addArg(numRealParticles);
+        blockNeighborsKernel->addArg(maxBlockNeighbors);
+        for (int i = 0; i < 5; i++)
+            blockNeighborsKernel->addArg(); // Periodic box information will be set just before it is executed.
+        blockNeighborsKernel->addArg(blockCenter);
+        blockNeighborsKernel->addArg(blockBoundingBox);
+        blockNeighborsKernel->addArg(blockNeighbors);
+        blockNeighborsKernel->addArg(blockNeighborCount);
+        blockNeighborsKernel->addArg(neighborBlockCount);
         neighborsKernel->addArg(numRealParticles);
         neighborsKernel->addArg(maxNeighborBlocks);
         for (int i = 0; i < 5; i++)
@@ -2321,6 +2772,9 @@ double CommonCalcGayBerneForceKernel::execute(ContextImpl& context, bool include
         neighborsKernel->addArg(neighborBlockCount);
         neighborsKernel->addArg(exclusions);
         neighborsKernel->addArg(exclusionStartIndex);
+        neighborsKernel->addArg(maxBlockNeighbors);
+        neighborsKernel->addArg(blockNeighbors);
+        neighborsKernel->addArg(blockNeighborCount);
         forceKernel->addArg(cc.getLongForceBuffer());
         forceKernel->addArg(torque);
         forceKernel->addArg(numRealParticles);
@@ -2358,7 +2812,13 @@ double CommonCalcGayBerneForceKernel::execute(ContextImpl& context, bool include
     if (nonbondedMethod == GayBerneForce::NoCutoff)
         forceKernel->execute(cc.getNonbondedUtilities().getNumForceThreadBlocks()*cc.getNonbondedUtilities().getForceThreadBlockSize());
     else {
+        int numAtomBlocks = (numRealParticles+31)/32;
         while (true) {
+            // First find which blocks are near each other, then search only those blocks for the
+            // neighbors of each atom.
+
+            setPeriodicBoxArgs(cc, blockNeighborsKernel, 2);
+            blockNeighborsKernel->execute(numAtomBlocks);
             setPeriodicBoxArgs(cc, neighborsKernel, 2);
             neighborsKernel->execute(numRealParticles);
             int* count = (int*) cc.getPinnedBuffer();
@@ -2367,18 +2827,34 @@ double CommonCalcGayBerneForceKernel::execute(ContextImpl& context, bool include
             setPeriodicBoxArgs(cc, forceKernel, 20);
             forceKernel->execute(cc.getNonbondedUtilities().getNumForceThreadBlocks()*cc.getNonbondedUtilities().getForceThreadBlockSize());
             event->wait();
-            if (*count <= maxNeighborBlocks)
+            if (count[0] <= maxNeighborBlocks && count[1] == 0)
                 break;
             
             // There wasn't enough room for the neighbor list, so we need to recreate it.
 
-            maxNeighborBlocks = (int) ceil((*count)*1.1);
-            neighbors.resize(maxNeighborBlocks*32);
-            neighborIndex.resize(maxNeighborBlocks);
-            neighborsKernel->setArg(10, neighbors);
-            neighborsKernel->setArg(11, neighborIndex);
-            forceKernel->setArg(17, neighbors);
-            forceKernel->setArg(18, neighborIndex);
+            if (count[1] != 0) {
+                maxBlockNeighbors = min(2*maxBlockNeighbors, numAtomBlocks);
+                blockNeighbors.resize(numAtomBlocks*maxBlockNeighbors);
+                blockNeighborsKernel->setArg(1, maxBlockNeighbors);
+                blockNeighborsKernel->setArg(9, blockNeighbors);
+                neighborsKernel->setArg(15, maxBlockNeighbors);
+                neighborsKernel->setArg(16, blockNeighbors);
+            }
+            if (count[0] > maxNeighborBlocks) {
+                maxNeighborBlocks = (int) ceil(count[0]*1.1);
+                neighbors.resize(maxNeighborBlocks*32);
+                neighborIndex.resize(maxNeighborBlocks);
+                neighborsKernel->setArg(1, maxNeighborBlocks);
+                neighborsKernel->setArg(10, neighbors);
+                neighborsKernel->setArg(11, neighborIndex);
+                forceKernel->setArg(16, maxNeighborBlocks);
+                forceKernel->setArg(17, neighbors);
+                forceKernel->setArg(18, neighborIndex);
+            }
+
+            // Recompute the block bounds, which also resets the counts.
+
+            blockBoundsKernel->execute(numAtomBlocks);
         }
     }
     torqueKernel->execute(numRealParticles);
@@ -2478,6 +2954,7 @@ void CommonCalcGayBerneForceKernel::sortAtoms() {
     vector<int> startIndexVec(exclusionStartIndex.getSize());
     for (int i = 0; i < numRealParticles; i++) {
         startIndexVec[i] = index;
+        sort(excludedAtoms[i].begin(), excludedAtoms[i].end());
         for (int j = 0; j < excludedAtoms[i].size(); j++)
             exclusionVec[index++] = excludedAtoms[i][j];
     }
@@ -2563,8 +3040,10 @@ void CommonCalcCustomCVForceKernel::initialize(const System& system, const Custo
 
     map<string, Lepton::CustomFunction*> functions;
     tabulatedFunctions.resize(force.getNumTabulatedFunctions(), NULL);
+    tabulatedFunctionUpdateCount.resize(force.getNumTabulatedFunctions());
     for (int i = 0; i < force.getNumTabulatedFunctions(); i++) {
         tabulatedFunctions[i] = createReferenceTabulatedFunction(force.getTabulatedFunction(i));
+        tabulatedFunctionUpdateCount[i] = force.getTabulatedFunction(i).getUpdateCount();
         functions[force.getTabulatedFunctionName(i)] = new TabulatedFunctionWrapper(tabulatedFunctions, i);
     }
 
@@ -2602,20 +3081,21 @@ void CommonCalcCustomCVForceKernel::initialize(const System& system, const Custo
     for (auto& param : cc2.getEnergyParamDerivNames())
         cc.addEnergyParameterDerivative(param);
     
-    // Create arrays for storing information.
+    // Create arrays for storing information.  The forces from each CV are kept in the inner context's atom
+    // order, so they can be saved with a plain copy.  The last CV's forces are read directly from the inner
+    // context's force buffer, so no array is needed for it.
     
-    cvForces.resize(numCVs);
-    for (int i = 0; i < numCVs; i++)
+    cvForces.resize(max(0, numCVs-1));
+    for (int i = 0; i < numCVs-1; i++)
         cvForces[i].initialize<long long>(cc, 3*cc.getPaddedNumAtoms(), "cvForce");
-    invAtomOrder.initialize<int>(cc, cc.getPaddedNumAtoms(), "invAtomOrder");
     innerInvAtomOrder.initialize<int>(cc, cc.getPaddedNumAtoms(), "innerInvAtomOrder");
     
     // Create the kernels.
     
     stringstream args, add;
     for (int i = 0; i < numCVs; i++) {
-        args << ", GLOBAL mm_long * RESTRICT force" << i << ", real dEdV" << i;
-        add << "forces[i] += (mm_long) (force" << i << "[i]*dEdV" << i << ");\n";
+        args << ", GLOBAL const mm_long * RESTRICT force" << i << ", real dEdV" << i;
+        add << "forces[outer] += (mm_long) (force" << i << "[inner]*dEdV" << i << ");\n";
     }
     map<string, string> replacements;
     replacements["PARAMETER_ARGUMENTS"] = args.str();
@@ -2633,18 +3113,17 @@ void CommonCalcCustomCVForceKernel::initialize(const System& system, const Custo
     copyStateKernel->addArg(cc.getAtomIndexArray());
     copyStateKernel->addArg(innerInvAtomOrder);
     copyStateKernel->addArg(cc.getNumAtoms());
-    copyForcesKernel = program->createKernel("copyForces");
-    copyForcesKernel->addArg();
-    copyForcesKernel->addArg(invAtomOrder);
-    copyForcesKernel->addArg(cc2.getLongForceBuffer());
-    copyForcesKernel->addArg(cc2.getAtomIndexArray());
-    copyForcesKernel->addArg(cc.getNumAtoms());
-    copyForcesKernel->addArg(cc.getPaddedNumAtoms());
     addForcesKernel = program->createKernel("addForces");
     addForcesKernel->addArg(cc.getLongForceBuffer());
-    addForcesKernel->addArg((int) cc.getLongForceBuffer().getSize());
+    addForcesKernel->addArg(cc.getAtomIndexArray());
+    addForcesKernel->addArg(innerInvAtomOrder);
+    addForcesKernel->addArg(cc.getNumAtoms());
+    addForcesKernel->addArg(cc.getPaddedNumAtoms());
     for (int i = 0; i < numCVs; i++) {
-        addForcesKernel->addArg();
+        if (i < numCVs-1)
+            addForcesKernel->addArg(cvForces[i]);
+        else
+            addForcesKernel->addArg(cc2.getLongForceBuffer());
         addForcesKernel->addArg();
     }
 
@@ -2665,12 +3144,14 @@ double CommonCalcCustomCVForceKernel::execute(ContextImpl& context, ContextImpl&
     int numCVs = variableNames.size();
     int numAtoms = cc.getNumAtoms();
     int paddedNumAtoms = cc.getPaddedNumAtoms();
+    ComputeContext& cc2 = getInnerComputeContext(innerContext);
     vector<map<string, double> > cvDerivs(numCVs);
     for (int i = 0; i < numCVs; i++) {
         cvValues[i] = innerContext.calcForcesAndEnergy(true, true, 1<<i);
-        ContextSelector selector(cc);
-        copyForcesKernel->setArg(0, cvForces[i]);
-        copyForcesKernel->execute(numAtoms);
+        if (i < numCVs-1) {
+            ContextSelector selector(cc);
+            cc2.getLongForceBuffer().copyTo(cvForces[i]);
+        }
         innerContext.getEnergyParameterDerivatives(cvDerivs[i]);
     }
 
@@ -2682,11 +3163,10 @@ double CommonCalcCustomCVForceKernel::execute(ContextImpl& context, ContextImpl&
     double energy = energyExpression.evaluate();
     for (int i = 0; i < numCVs; i++) {
         double dEdV = variableDerivExpressions[i].evaluate();
-        addForcesKernel->setArg(2*i+2, cvForces[i]);
         if (cc.getUseDoublePrecision())
-            addForcesKernel->setArg(2*i+3, dEdV);
+            addForcesKernel->setArg(2*i+6, dEdV);
         else
-            addForcesKernel->setArg(2*i+3, (float) dEdV);
+            addForcesKernel->setArg(2*i+6, (float) dEdV);
     }
     addForcesKernel->execute(numAtoms);
 
@@ -2714,12 +3194,9 @@ void CommonCalcCustomCVForceKernel::copyState(ContextImpl& context, ContextImpl&
         
         // Initialize the listeners.
         
-        ReorderListener* listener1 = new ReorderListener(cc, invAtomOrder);
-        ReorderListener* listener2 = new ReorderListener(cc2, innerInvAtomOrder);
-        cc.addReorderListener(listener1);
-        cc2.addReorderListener(listener2);
-        listener1->execute();
-        listener2->execute();
+        ReorderListener* listener = new ReorderListener(cc2, innerInvAtomOrder);
+        cc2.addReorderListener(listener);
+        listener->execute();
     }
     cc2.reorderAtoms();
     copyStateKernel->execute(numAtoms);
@@ -2733,9 +3210,12 @@ void CommonCalcCustomCVForceKernel::copyState(ContextImpl& context, ContextImpl&
 }
 
 void CommonCalcCustomCVForceKernel::copyParametersToContext(ContextImpl& context, const CustomCVForce& force) {
-    // Create custom functions for the tabulated functions.
+    // Recreate the custom functions for any tabulated functions that have changed.
 
     for (int i = 0; i < force.getNumTabulatedFunctions(); i++) {
+        if (force.getTabulatedFunction(i).getUpdateCount() == tabulatedFunctionUpdateCount[i])
+            continue;
+        tabulatedFunctionUpdateCount[i] = force.getTabulatedFunction(i).getUpdateCount();
         if (tabulatedFunctions[i] != NULL) {
             delete tabulatedFunctions[i];
             tabulatedFunctions[i] = NULL;
@@ -2747,7 +3227,11 @@ void CommonCalcCustomCVForceKernel::copyParametersToContext(ContextImpl& context
 void CommonIntegrateVerletStepKernel::initialize(const System& system, const VerletIntegrator& integrator) {
     cc.initializeContexts();
     ContextSelector selector(cc);
-    ComputeProgram program = cc.compileProgram(CommonKernelSources::verlet);
+    map<string, string> defines;
+    computeCMMomentum = (cc.getIntegrationUtilities().getCMMomentum() != NULL);
+    if (computeCMMomentum)
+        defines["COMPUTE_CM_MOMENTUM"] = "1";
+    ComputeProgram program = cc.compileProgram(CommonKernelSources::cmMomentum+CommonKernelSources::verlet, defines);
     kernel1 = program->createKernel("integrateVerletPart1");
     kernel2 = program->createKernel("integrateVerletPart2");
 }
@@ -2776,6 +3260,8 @@ void CommonIntegrateVerletStepKernel::execute(ContextImpl& context, const Verlet
         kernel2->addArg(integration.getPosDelta());
         if (cc.getUseMixedPrecision())
             kernel2->addArg(cc.getPosqCorrection());
+        if (computeCMMomentum)
+            kernel2->addArg(*integration.getCMMomentum());
     }
     integration.setNextStepSize(dt);
 
@@ -2789,13 +3275,18 @@ void CommonIntegrateVerletStepKernel::execute(ContextImpl& context, const Verlet
 
     // Call the second integration kernel.
 
-    kernel2->execute(numAtoms);
+    if (computeCMMomentum)
+        kernel2->execute(numAtoms, 64);
+    else
+        kernel2->execute(numAtoms);
     integration.computeVirtualSites();
 
     // Update the time and step count.
 
     cc.setTime(cc.getTime()+dt);
     cc.setStepCount(cc.getStepCount()+1);
+    if (computeCMMomentum)
+        integration.setCMMomentumStep(cc.getStepCount());
     cc.reorderAtoms();
     
     // Reduce UI lag.
@@ -2811,7 +3302,11 @@ void CommonIntegrateLangevinMiddleStepKernel::initialize(const System& system, c
     cc.initializeContexts();
     ContextSelector selector(cc);
     cc.getIntegrationUtilities().initRandomNumberGenerator(integrator.getRandomNumberSeed());
-    ComputeProgram program = cc.compileProgram(CommonKernelSources::langevinMiddle);
+    map<string, string> defines;
+    computeCMMomentum = (cc.getIntegrationUtilities().getCMMomentum() != NULL);
+    if (computeCMMomentum)
+        defines["COMPUTE_CM_MOMENTUM"] = "1";
+    ComputeProgram program = cc.compileProgram(CommonKernelSources::random+CommonKernelSources::cmMomentum+CommonKernelSources::langevinMiddle, defines);
     kernel1 = program->createKernel("integrateLangevinMiddlePart1");
     kernel2 = program->createKernel("integrateLangevinMiddlePart2");
     kernel3 = program->createKernel("integrateLangevinMiddlePart3");
@@ -2844,8 +3339,9 @@ void CommonIntegrateLangevinMiddleStepKernel::execute(ContextImpl& context, cons
         kernel2->addArg(oldDelta);
         kernel2->addArg(params);
         kernel2->addArg(integration.getStepSize());
-        kernel2->addArg(integration.getRandom());
-        kernel2->addArg(); // Random index will be set just before it is executed.
+        kernel2->addArg(cc.getAtomIndexArray());
+        kernel2->addArg(integration.getRandomKey());
+        kernel2->addArg(); // Random counter will be set just before it is executed.
         kernel3->addArg(numAtoms);
         kernel3->addArg(cc.getPosq());
         kernel3->addArg(cc.getVelm());
@@ -2854,6 +3350,8 @@ void CommonIntegrateLangevinMiddleStepKernel::execute(ContextImpl& context, cons
         kernel3->addArg(integration.getStepSize());
         if (cc.getUseMixedPrecision())
             kernel3->addArg(cc.getPosqCorrection());
+        if (computeCMMomentum)
+            kernel3->addArg(*integration.getCMMomentum());
     }
     double temperature = integrator.getTemperature();
     double friction = integrator.getFriction();
@@ -2876,18 +3374,33 @@ void CommonIntegrateLangevinMiddleStepKernel::execute(ContextImpl& context, cons
 
     // Perform the integration.
 
-    kernel2->setArg(7, integration.prepareRandomNumbers(cc.getPaddedNumAtoms()));
-    kernel1->execute(numAtoms);
-    integration.applyVelocityConstraints(integrator.getConstraintTolerance());
-    kernel2->execute(numAtoms);
-    integration.applyConstraints(integrator.getConstraintTolerance());
-    kernel3->execute(numAtoms);
-    integration.computeVirtualSites();
+    kernel2->setArg(8, integration.prepareRandomCounter());
+    auto integrate = [&] () {
+        kernel1->execute(numAtoms);
+        integration.applyVelocityConstraints(integrator.getConstraintTolerance());
+        kernel2->execute(numAtoms);
+        integration.applyConstraints(integrator.getConstraintTolerance());
+        if (computeCMMomentum)
+            kernel3->execute(numAtoms, 64);
+        else
+            kernel3->execute(numAtoms);
+        integration.computeVirtualSites();
+    };
+    bool capturing = cc.beginGraphCapture("langevinMiddle");
+    integrate();
+
+    // If the graph could not be launched, none of the work was done.  Capture is now disabled, so
+    // execute it directly.
+
+    if (capturing && !cc.endGraphCapture())
+        integrate();
 
     // Update the time and step count.
 
     cc.setTime(cc.getTime()+stepSize);
     cc.setStepCount(cc.getStepCount()+1);
+    if (computeCMMomentum)
+        integration.setCMMomentumStep(cc.getStepCount());
     cc.reorderAtoms();
     
     // Reduce UI lag.
@@ -2899,11 +3412,134 @@ double CommonIntegrateLangevinMiddleStepKernel::computeKineticEnergy(ContextImpl
     return cc.getIntegrationUtilities().computeKineticEnergy(0.0);
 }
 
+void CommonIntegrateMTSLangevinStepKernel::initialize(const System& system, const MTSLangevinIntegrator& integrator) {
+    cc.initializeContexts();
+    ContextSelector selector(cc);
+    cc.getIntegrationUtilities().initRandomNumberGenerator(integrator.getRandomNumberSeed());
+    ComputeProgram program = cc.compileProgram(CommonKernelSources::mtsLangevin);
+    kickKernel = program->createKernel("mtsLangevinKick");
+    innerKernel1 = program->createKernel("mtsLangevinInnerPart1");
+    innerKernel2 = program->createKernel("mtsLangevinInnerPart2");
+    if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision())
+        oldDelta.initialize<mm_double4>(cc, cc.getPaddedNumAtoms(), "oldDelta");
+    else
+        oldDelta.initialize<mm_float4>(cc, cc.getPaddedNumAtoms(), "oldDelta");
+    savedForces.resize(integrator.getGroups().size());
+    for (int i = 0; i < savedForces.size(); i++)
+        savedForces[i].initialize(cc, cc.getLongForceBuffer().getSize(), cc.getLongForceBuffer().getElementSize(), "savedForces");
+}
+
+void CommonIntegrateMTSLangevinStepKernel::initializeKernels() {
+    // The time step dependent parameters are set just before each kernel is executed.
+
+    hasInitializedKernels = true;
+    IntegrationUtilities& integration = cc.getIntegrationUtilities();
+    int numAtoms = cc.getNumAtoms();
+    int paddedNumAtoms = cc.getPaddedNumAtoms();
+    kickKernel->addArg(numAtoms);
+    kickKernel->addArg(paddedNumAtoms);
+    kickKernel->addArg(cc.getVelm());
+    kickKernel->addArg(cc.getLongForceBuffer());
+    kickKernel->addArg();
+    innerKernel1->addArg(numAtoms);
+    innerKernel1->addArg(paddedNumAtoms);
+    innerKernel1->addArg(cc.getVelm());
+    innerKernel1->addArg(cc.getLongForceBuffer());
+    innerKernel1->addArg(integration.getPosDelta());
+    innerKernel1->addArg(oldDelta);
+    for (int i = 0; i < 4; i++)
+        innerKernel1->addArg();
+    innerKernel1->addArg(integration.getRandom());
+    innerKernel1->addArg(); // Random index will be set just before it is executed.
+    innerKernel2->addArg(numAtoms);
+    innerKernel2->addArg(cc.getPosq());
+    innerKernel2->addArg(cc.getVelm());
+    innerKernel2->addArg(integration.getPosDelta());
+    innerKernel2->addArg(oldDelta);
+    innerKernel2->addArg();
+    if (cc.getUseMixedPrecision())
+        innerKernel2->addArg(cc.getPosqCorrection());
+}
+
+void CommonIntegrateMTSLangevinStepKernel::kick(ContextImpl& context, const MTSLangevinIntegrator& integrator, double dt) {
+    ContextSelector selector(cc);
+    if (!hasInitializedKernels)
+        initializeKernels();
+    double fscale = dt/(double) 0x100000000;
+    if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision())
+        kickKernel->setArg(4, fscale);
+    else
+        kickKernel->setArg(4, (float) fscale);
+    kickKernel->execute(cc.getNumAtoms());
+}
+
+void CommonIntegrateMTSLangevinStepKernel::innerStep(ContextImpl& context, const MTSLangevinIntegrator& integrator, double kickDt, double dt) {
+    ContextSelector selector(cc);
+    if (!hasInitializedKernels)
+        initializeKernels();
+    IntegrationUtilities& integration = cc.getIntegrationUtilities();
+    int numAtoms = cc.getNumAtoms();
+    double fscale = kickDt/(double) 0x100000000;
+    double vscale = exp(-dt*integrator.getFriction());
+    double noisescale = sqrt(BOLTZ*integrator.getTemperature()*(1-vscale*vscale));
+    if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision()) {
+        innerKernel1->setArg(6, fscale);
+        innerKernel1->setArg(7, 0.5*dt);
+        innerKernel1->setArg(8, vscale);
+        innerKernel1->setArg(9, noisescale);
+        innerKernel2->setArg(5, 1.0/dt);
+    }
+    else {
+        innerKernel1->setArg(6, (float) fscale);
+        innerKernel1->setArg(7, (float) (0.5*dt));
+        innerKernel1->setArg(8, (float) vscale);
+        innerKernel1->setArg(9, (float) noisescale);
+        innerKernel2->setArg(5, (float) (1.0/dt));
+    }
+    innerKernel1->setArg(11, integration.prepareRandomNumbers(cc.getPaddedNumAtoms()));
+    innerKernel1->execute(numAtoms);
+    integration.applyConstraints(integrator.getConstraintTolerance());
+    innerKernel2->execute(numAtoms);
+    integration.applyVelocityConstraints(integrator.getConstraintTolerance());
+    integration.computeVirtualSites();
+}
+
+void CommonIntegrateMTSLangevinStepKernel::saveForces(ContextImpl& context, const MTSLangevinIntegrator& integrator, int level) {
+    ContextSelector selector(cc);
+    cc.getLongForceBuffer().copyTo(savedForces[level]);
+}
+
+void CommonIntegrateMTSLangevinStepKernel::restoreForces(ContextImpl& context, const MTSLangevinIntegrator& integrator, int level) {
+    ContextSelector selector(cc);
+    savedForces[level].copyTo(cc.getLongForceBuffer());
+}
+
+bool CommonIntegrateMTSLangevinStepKernel::finishStep(ContextImpl& context, const MTSLangevinIntegrator& integrator) {
+    ContextSelector selector(cc);
+    cc.getIntegrationUtilities().applyVelocityConstraints(integrator.getConstraintTolerance());
+
+    // Update the time and step count.
+
+    cc.setTime(cc.getTime()+integrator.getStepSize());
+    cc.setStepCount(cc.getStepCount()+1);
+    cc.reorderAtoms();
+    bool forcesAreValid = !cc.getAtomsWereReordered();
+
+    // Reduce UI lag.
+
+    flushPeriodically(cc);
+    return forcesAreValid;
+}
+
+double CommonIntegrateMTSLangevinStepKernel::computeKineticEnergy(ContextImpl& context, const MTSLangevinIntegrator& integrator) {
+    return cc.getIntegrationUtilities().computeKineticEnergy(0.0);
+}
+
 void CommonIntegrateBrownianStepKernel::initialize(const System& system, const BrownianIntegrator& integrator) {
     cc.initializeContexts();
     ContextSelector selector(cc);
     cc.getIntegrationUtilities().initRandomNumberGenerator(integrator.getRandomNumberSeed());
-    ComputeProgram program = cc.compileProgram(CommonKernelSources::brownian);
+    ComputeProgram program = cc.compileProgram(CommonKernelSources::random+CommonKernelSources::brownian);
     kernel1 = program->createKernel("integrateBrownianPart1");
     kernel2 = program->createKernel("integrateBrownianPart2");
     prevStepSize = -1.0;
@@ -2923,8 +3559,9 @@ void CommonIntegrateBrownianStepKernel::execute(ContextImpl& context, const Brow
         kernel1->addArg(cc.getLongForceBuffer());
         kernel1->addArg(integration.getPosDelta());
         kernel1->addArg(cc.getVelm());
-        kernel1->addArg(integration.getRandom());
-        kernel1->addArg(); // Random index will be set just before it is executed.
+        kernel1->addArg(cc.getAtomIndexArray());
+        kernel1->addArg(integration.getRandomKey());
+        kernel1->addArg(); // Random counter will be set just before it is executed.
         kernel2->addArg(numAtoms);
         kernel2->addArg(); // oneOverDeltaT
         kernel2->addArg(cc.getPosq());
@@ -2955,7 +3592,7 @@ void CommonIntegrateBrownianStepKernel::execute(ContextImpl& context, const Brow
 
     // Call the first integration kernel.
 
-    kernel1->setArg(8, integration.prepareRandomNumbers(cc.getPaddedNumAtoms()));
+    kernel1->setArg(9, integration.prepareRandomCounter());
     kernel1->execute(numAtoms);
 
     // Apply constraints.
@@ -3022,22 +3659,26 @@ double CommonIntegrateVariableVerletStepKernel::execute(ContextImpl& context, co
         selectSizeKernel->addArg(cc.getIntegrationUtilities().getStepSize());
         selectSizeKernel->addArg(cc.getVelm());
         selectSizeKernel->addArg(cc.getLongForceBuffer());
+        selectSizeKernel->addArg();
+        selectSizeKernel->addArg(integration.getDeviceTime());
     }
 
-    // Select the step size to use.
+    // Select the step size to use.  The time is accumulated on the device, so the current time
+    // only needs to be known on the host if there is a maximum time.
 
     bool useDouble = cc.getUseDoublePrecision() || cc.getUseMixedPrecision();
-    double maxStepSize = maxTime-cc.getTime();
-    if (integrator.getMaximumStepSize() > 0)
-        maxStepSize = min(integrator.getMaximumStepSize(), maxStepSize);
-    float maxStepSizeFloat = (float) maxStepSize;
+    bool hasMaxTime = (maxTime != numeric_limits<double>::infinity());
+    double remainingTime = (hasMaxTime ? maxTime-cc.getTime() : maxTime);
+    double maxStepSize = (integrator.getMaximumStepSize() > 0 ? integrator.getMaximumStepSize() : numeric_limits<double>::infinity());
     if (useDouble) {
         selectSizeKernel->setArg(2, maxStepSize);
         selectSizeKernel->setArg(3, integrator.getErrorTolerance());
+        selectSizeKernel->setArg(7, remainingTime);
     }
     else {
-        selectSizeKernel->setArg(2, maxStepSizeFloat);
+        selectSizeKernel->setArg(2, (float) maxStepSize);
         selectSizeKernel->setArg(3, (float) integrator.getErrorTolerance());
+        selectSizeKernel->setArg(7, (float) remainingTime);
     }
     selectSizeKernel->execute(blockSize, blockSize);
 
@@ -3058,22 +3699,21 @@ double CommonIntegrateVariableVerletStepKernel::execute(ContextImpl& context, co
 
     flushPeriodically(cc);
 
-    // Update the time and step count.
+    // Update the step count.  The time is only downloaded if stepTo() needs it to decide whether
+    // to continue.  Otherwise the size of an earlier step is returned, and getLastStepSize()
+    // retrieves the correct one at the end.
 
-    double dt = cc.getIntegrationUtilities().getLastStepSize();
-    double time = cc.getTime()+dt;
-    if (useDouble) {
-        if (dt == maxStepSize)
-            time = maxTime; // Avoid round-off error
-    }
-    else {
-        if (dt == maxStepSizeFloat)
-            time = maxTime; // Avoid round-off error
-    }
-    cc.setTime(time);
     cc.setStepCount(cc.getStepCount()+1);
+    integration.addDeviceTimeStep(maxTime);
     cc.reorderAtoms();
-    return dt;
+    if (hasMaxTime)
+        return integration.downloadDeviceTime();
+    return integrator.getStepSize();
+}
+
+double CommonIntegrateVariableVerletStepKernel::getLastStepSize(ContextImpl& context, double stepSize) {
+    ContextSelector selector(cc);
+    return cc.getIntegrationUtilities().downloadDeviceTime();
 }
 
 double CommonIntegrateVariableVerletStepKernel::computeKineticEnergy(ContextImpl& context, const VariableVerletIntegrator& integrator) {
@@ -3084,7 +3724,7 @@ void CommonIntegrateVariableLangevinStepKernel::initialize(const System& system,
     cc.initializeContexts();
     ContextSelector selector(cc);
     cc.getIntegrationUtilities().initRandomNumberGenerator(integrator.getRandomNumberSeed());
-    ComputeProgram program = cc.compileProgram(CommonKernelSources::langevinMiddle);
+    ComputeProgram program = cc.compileProgram(CommonKernelSources::random+CommonKernelSources::langevinMiddle);
     kernel1 = program->createKernel("integrateLangevinMiddlePart1");
     kernel2 = program->createKernel("integrateLangevinMiddlePart2");
     kernel3 = program->createKernel("integrateLangevinMiddlePart3");
@@ -3120,8 +3760,9 @@ double CommonIntegrateVariableLangevinStepKernel::execute(ContextImpl& context,
         kernel2->addArg(oldDelta);
         kernel2->addArg(params);
         kernel2->addArg(integration.getStepSize());
-        kernel2->addArg(integration.getRandom());
-        kernel2->addArg(); // Random index will be set just before it is executed.
+        kernel2->addArg(cc.getAtomIndexArray());
+        kernel2->addArg(integration.getRandomKey());
+        kernel2->addArg(); // Random counter will be set just before it is executed.
         kernel3->addArg(numAtoms);
         kernel3->addArg(cc.getPosq());
         kernel3->addArg(cc.getVelm());
@@ -3138,31 +3779,35 @@ double CommonIntegrateVariableLangevinStepKernel::execute(ContextImpl& context,
         selectSizeKernel->addArg(cc.getVelm());
         selectSizeKernel->addArg(cc.getLongForceBuffer());
         selectSizeKernel->addArg(params);
+        selectSizeKernel->addArg();
+        selectSizeKernel->addArg(integration.getDeviceTime());
     }
 
-    // Select the step size to use.
+    // Select the step size to use.  The time is accumulated on the device, so the current time
+    // only needs to be known on the host if there is a maximum time.
 
-    double maxStepSize = maxTime-cc.getTime();
-    if (integrator.getMaximumStepSize() > 0)
-        maxStepSize = min(integrator.getMaximumStepSize(), maxStepSize);
-    float maxStepSizeFloat = (float) maxStepSize;
+    bool hasMaxTime = (maxTime != numeric_limits<double>::infinity());
+    double remainingTime = (hasMaxTime ? maxTime-cc.getTime() : maxTime);
+    double maxStepSize = (integrator.getMaximumStepSize() > 0 ? integrator.getMaximumStepSize() : numeric_limits<double>::infinity());
     if (useDouble) {
         selectSizeKernel->setArg(2, maxStepSize);
         selectSizeKernel->setArg(3, integrator.getErrorTolerance());
         selectSizeKernel->setArg(4, integrator.getFriction());
         selectSizeKernel->setArg(5, BOLTZ*integrator.getTemperature());
+        selectSizeKernel->setArg(10, remainingTime);
     }
     else {
-        selectSizeKernel->setArg(2, maxStepSizeFloat);
+        selectSizeKernel->setArg(2, (float) maxStepSize);
         selectSizeKernel->setArg(3, (float) integrator.getErrorTolerance());
         selectSizeKernel->setArg(4, (float) integrator.getFriction());
         selectSizeKernel->setArg(5, (float) (BOLTZ*integrator.getTemperature()));
+        selectSizeKernel->setArg(10, (float) remainingTime);
     }
     selectSizeKernel->execute(blockSize, blockSize);
 
     // Perform the integration.
 
-    kernel2->setArg(7, integration.prepareRandomNumbers(cc.getPaddedNumAtoms()));
+    kernel2->setArg(8, integration.prepareRandomCounter());
     kernel1->execute(numAtoms);
     integration.applyVelocityConstraints(integrator.getConstraintTolerance());
     kernel2->execute(numAtoms);
@@ -3174,22 +3819,21 @@ double CommonIntegrateVariableLangevinStepKernel::execute(ContextImpl& context,
 
     flushPeriodically(cc);
 
-    // Update the time and step count.
+    // Update the step count.  The time is only downloaded if stepTo() needs it to decide whether
+    // to continue.  Otherwise the size of an earlier step is returned, and getLastStepSize()
+    // retrieves the correct one at the end.
 
-    double dt = cc.getIntegrationUtilities().getLastStepSize();
-    double time = cc.getTime()+dt;
-    if (useDouble) {
-        if (dt == maxStepSize)
-            time = maxTime; // Avoid round-off error
-    }
-    else {
-        if (dt == maxStepSizeFloat)
-            time = maxTime; // Avoid round-off error
-    }
-    cc.setTime(time);
     cc.setStepCount(cc.getStepCount()+1);
+    integration.addDeviceTimeStep(maxTime);
     cc.reorderAtoms();
-    return dt;
+    if (hasMaxTime)
+        return integration.downloadDeviceTime();
+    return integrator.getStepSize();
+}
+
+double CommonIntegrateVariableLangevinStepKernel::getLastStepSize(ContextImpl& context, double stepSize) {
+    ContextSelector selector(cc);
+    return cc.getIntegrationUtilities().downloadDeviceTime();
 }
 
 double CommonIntegrateVariableLangevinStepKernel::computeKineticEnergy(ContextImpl& context, const VariableLangevinIntegrator& integrator) {
@@ -3372,17 +4016,95 @@ double CommonIntegrateDPDStepKernel::computeKineticEnergy(ContextImpl& context,
     return cc.getIntegrationUtilities().computeKineticEnergy(0.0);
 }
 
+void CommonCalcProtocolWorkKernel::initialize(const System& system) {
+    ContextSelector selector(cc);
+    bool useMixed = (cc.getUseDoublePrecision() || cc.getUseMixedPrecision());
+    savedPositions.initialize(cc, cc.getPaddedNumAtoms(), cc.getUseDoublePrecision() ? sizeof(mm_double4) : sizeof(mm_float4), "savedPositions");
+    if (cc.getUseMixedPrecision())
+        savedCorrections.initialize<mm_float4>(cc, cc.getPaddedNumAtoms(), "savedCorrections");
+    savedVelocities.initialize(cc, cc.getPaddedNumAtoms(), useMixed ? sizeof(mm_double4) : sizeof(mm_float4), "savedVelocities");
+    work.initialize(cc, 1, useMixed ? sizeof(double) : sizeof(float), "protocolWork");
+    ComputeProgram program = cc.compileProgramOnDemand(CommonKernelSources::protocolWork);
+    kernel = program->createKernel("addEnergyToWork");
+    kernel->addArg(cc.getEnergySum());
+    kernel->addArg(work);
+    kernel->addArg((int) cc.getEnergySum().getSize());
+    kernel->addArg();
+}
+
+void CommonCalcProtocolWorkKernel::beginMove(ContextImpl& context) {
+    ContextSelector selector(cc);
+    cc.getPosq().copyTo(savedPositions);
+    if (savedCorrections.isInitialized())
+        cc.getPosqCorrection().copyTo(savedCorrections);
+    cc.getVelm().copyTo(savedVelocities);
+    lastPosCellOffsets = cc.getPosCellOffsets();
+    lastAtomOrder = cc.getAtomIndex();
+    cc.clearBuffer(work);
+    hostWork = 0.0;
+}
+
+void CommonCalcProtocolWorkKernel::restoreState(ContextImpl& context) {
+    ContextSelector selector(cc);
+    savedPositions.copyTo(cc.getPosq());
+    if (savedCorrections.isInitialized())
+        savedCorrections.copyTo(cc.getPosqCorrection());
+    savedVelocities.copyTo(cc.getVelm());
+    cc.setPosCellOffsets(lastPosCellOffsets);
+    if (cc.getAtomIndex() != lastAtomOrder)
+        cc.setAtomIndex(lastAtomOrder);
+}
+
+void CommonCalcProtocolWorkKernel::addEnergy(ContextImpl& context, double scale, int groups) {
+    // When the platform splits the computation over several devices, the energy has to be summed on the
+    // host anyway, so just accumulate it there.
+
+    if (cc.getNumContexts() > 1) {
+        hostWork += scale*context.calcForcesAndEnergy(false, true, groups);
+        return;
+    }
+
+    // Leave the energy summed by the device in place, and add it to the work with a kernel.  Anything the
+    // computation returns is energy computed on the host.
+
+    cc.setKeepEnergyOnDevice(true);
+    try {
+        hostWork += scale*context.calcForcesAndEnergy(false, true, groups);
+    }
+    catch (...) {
+        cc.setKeepEnergyOnDevice(false);
+        throw;
+    }
+    cc.setKeepEnergyOnDevice(false);
+    ContextSelector selector(cc);
+    kernel->setArg(3, (float) scale);
+    kernel->execute(1, 1);
+}
+
+double CommonCalcProtocolWorkKernel::getWork(ContextImpl& context) {
+    ContextSelector selector(cc);
+    if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision()) {
+        vector<double> result;
+        work.download(result);
+        return result[0]+hostWork;
+    }
+    vector<float> result;
+    work.download(result);
+    return result[0]+hostWork;
+}
+
 void CommonRemoveCMMotionKernel::initialize(const System& system, const CMMotionRemover& force) {
     ContextSelector selector(cc);
     frequency = force.getFrequency();
     int numAtoms = cc.getNumAtoms();
     cmMomentum.initialize<mm_float4>(cc, cc.getPaddedNumAtoms(), "cmMomentum");
+    cc.getIntegrationUtilities().setCMMomentum(cmMomentum);
     double totalMass = 0.0;
     for (int i = 0; i < numAtoms; i++)
         totalMass += system.getParticleMass(i);
     map<string, string> defines;
     defines["INVERSE_TOTAL_MASS"] = cc.doubleToString(totalMass == 0 ? 0.0 : 1.0/totalMass);
-    ComputeProgram program = cc.compileProgram(CommonKernelSources::removeCM, defines);
+    ComputeProgram program = cc.compileProgramOnDemand(CommonKernelSources::cmMomentum+CommonKernelSources::removeCM, defines);
     kernel1 = program->createKernel("calcCenterOfMassMomentum");
     kernel1->addArg(numAtoms);
     kernel1->addArg(cc.getVelm());
@@ -3395,8 +4117,15 @@ void CommonRemoveCMMotionKernel::initialize(const System& system, const CMMotion
 
 void CommonRemoveCMMotionKernel::execute(ContextImpl& context) {
     ContextSelector selector(cc);
-    kernel1->execute(cc.getNumAtoms(), 64);
+    IntegrationUtilities& integration = cc.getIntegrationUtilities();
+
+    // If the integrator already computed the momentum at the end of the last step, we only
+    // need to remove it.
+
+    if (integration.getCMMomentumStep() != cc.getStepCount())
+        kernel1->execute(cc.getNumAtoms(), 64);
     kernel2->execute(cc.getNumAtoms(), 64);
+    integration.setCMMomentumStep(-1);
 }
 
 class CommonCalcRMSDForceKernel::ForceInfo : public ComputeForceInfo {
@@ -3444,10 +4173,12 @@ void CommonCalcRMSDForceKernel::initialize(const System& system, const RMSDForce
     kernel1 = program->createKernel("computeRMSDPart1");
     kernel2 = program->createKernel("computeRMSDForces");
     kernel1->addArg();
+    kernel1->addArg();
     kernel1->addArg(cc.getPosq());
     kernel1->addArg(referencePos);
     kernel1->addArg(particles);
     kernel1->addArg(buffer);
+    kernel1->addArg(); // Energy buffer hasn't been created yet
     kernel2->addArg();
     kernel2->addArg(cc.getPaddedNumAtoms());
     kernel2->addArg(cc.getPosq());
@@ -3490,89 +4221,21 @@ void CommonCalcRMSDForceKernel::recordParameters(const RMSDForce& force) {
 }
 
 double CommonCalcRMSDForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
-    ContextSelector selector(cc);
-    if (cc.getUseDoublePrecision())
-        return executeImpl<double>(context);
-    return executeImpl<float>(context);
-}
-
-template <class REAL>
-double CommonCalcRMSDForceKernel::executeImpl(ContextImpl& context) {
-    // Execute the first kernel.
+    // The first kernel finds the optimal rotation and adds the RMSD to the energy buffer, so
+    // nothing needs to be downloaded.
 
+    ContextSelector selector(cc);
     int numParticles = particles.getSize();
     kernel1->setArg(0, numParticles);
+    if (cc.getUseMixedPrecision() || cc.getUseDoublePrecision())
+        kernel1->setArg(1, sumNormRef);
+    else
+        kernel1->setArg(1, (float) sumNormRef);
+    kernel1->setArg(6, cc.getEnergyBuffer());
     kernel1->execute(blockSize, blockSize);
-    
-    // Download the results, build the F matrix, and find the maximum eigenvalue
-    // and eigenvector.
-
-    vector<REAL> b;
-    buffer.download(b);
-
-    // JAMA::Eigenvalue may run into an infinite loop if we have any NaN
-    for (int i = 0; i < 9; i++) {
-        if (b[i] != b[i])
-            throw OpenMMException("NaN encountered during RMSD force calculation");
-    }
-    
-    Array2D<double> F(4, 4);
-    F[0][0] =  b[0*3+0] + b[1*3+1] + b[2*3+2];
-    F[1][0] =  b[1*3+2] - b[2*3+1];
-    F[2][0] =  b[2*3+0] - b[0*3+2];
-    F[3][0] =  b[0*3+1] - b[1*3+0];
-    F[0][1] =  b[1*3+2] - b[2*3+1];
-    F[1][1] =  b[0*3+0] - b[1*3+1] - b[2*3+2];
-    F[2][1] =  b[0*3+1] + b[1*3+0];
-    F[3][1] =  b[0*3+2] + b[2*3+0];
-    F[0][2] =  b[2*3+0] - b[0*3+2];
-    F[1][2] =  b[0*3+1] + b[1*3+0];
-    F[2][2] = -b[0*3+0] + b[1*3+1] - b[2*3+2];
-    F[3][2] =  b[1*3+2] + b[2*3+1];
-    F[0][3] =  b[0*3+1] - b[1*3+0];
-    F[1][3] =  b[0*3+2] + b[2*3+0];
-    F[2][3] =  b[1*3+2] + b[2*3+1];
-    F[3][3] = -b[0*3+0] - b[1*3+1] + b[2*3+2];
-    JAMA::Eigenvalue<double> eigen(F);
-    Array1D<double> values;
-    eigen.getRealEigenvalues(values);
-    Array2D<double> vectors;
-    eigen.getV(vectors);
-
-    // Compute the RMSD.
-
-    double msd = (sumNormRef+b[9]-2*values[3])/numParticles;
-    if (msd < 1e-20) {
-        // The particles are perfectly aligned, so all the forces should be zero.
-        // Numerical error can lead to NaNs, so just return 0 now.
-        return 0.0;
-    }
-    double rmsd = sqrt(msd);
-    b[9] = rmsd;
-
-    // Compute the rotation matrix.
-
-    double q[] = {vectors[0][3], vectors[1][3], vectors[2][3], vectors[3][3]};
-    double q00 = q[0]*q[0], q01 = q[0]*q[1], q02 = q[0]*q[2], q03 = q[0]*q[3];
-    double q11 = q[1]*q[1], q12 = q[1]*q[2], q13 = q[1]*q[3];
-    double q22 = q[2]*q[2], q23 = q[2]*q[3];
-    double q33 = q[3]*q[3];
-    b[0] = q00+q11-q22-q33;
-    b[1] = 2*(q12-q03);
-    b[2] = 2*(q13+q02);
-    b[3] = 2*(q12+q03);
-    b[4] = q00-q11+q22-q33;
-    b[5] = 2*(q23-q01);
-    b[6] = 2*(q13-q02);
-    b[7] = 2*(q23+q01);
-    b[8] = q00-q11-q22+q33;
-
-    // Upload it to the device and invoke the kernel to apply forces.
-    
-    buffer.upload(b);
     kernel2->setArg(0, numParticles);
     kernel2->execute(numParticles);
-    return rmsd;
+    return 0.0;
 }
 
 void CommonCalcRMSDForceKernel::copyParametersToContext(ContextImpl& context, const RMSDForce& force) {
@@ -3630,6 +4293,7 @@ void CommonApplyAndersenThermostatKernel::execute(ContextImpl& context) {
         kernel->setArg(4, (float) stepSize);
     kernel->setArg(6, cc.getIntegrationUtilities().prepareRandomNumbers(cc.getPaddedNumAtoms()));
     kernel->execute(cc.getNumAtoms());
+    cc.getIntegrationUtilities().setCMMomentumStep(-1);
 }
 
 void CommonApplyMonteCarloBarostatKernel::initialize(const System& system, const Force& thermostat, int components, bool rigidMolecules) {
@@ -3655,7 +4319,7 @@ void CommonApplyMonteCarloBarostatKernel::initialize(const System& system, const
     map<string, string> defines;
     defines["WORK_GROUP_SIZE"] = cc.intToString(cc.ThreadBlockSize);
     defines["COMPONENTS"] = cc.intToString(components);
-    ComputeProgram program = cc.compileProgram(CommonKernelSources::monteCarloBarostat, defines);
+    ComputeProgram program = cc.compileProgramOnDemand(CommonKernelSources::monteCarloBarostat, defines);
     kernel = program->createKernel("scalePositions");
     kineticEnergyKernel = program->createKernel("computeMolecularKineticEnergy");
 }
@@ -3800,7 +4464,6 @@ void CommonCalcATMForceKernel::initialize(const System& system, const ATMForce&
     displ1.upload(displVector1);
     displ0.initialize<mm_float4>(cc, cc.getPaddedNumAtoms(), "displ0");
     displ0.upload(displVector0);
-    invAtomOrder.initialize<int>(cc, cc.getPaddedNumAtoms(), "invAtomOrder");
     inner0InvAtomOrder.initialize<int>(cc, cc.getPaddedNumAtoms(), "inner0InvAtomOrder");
     inner1InvAtomOrder.initialize<int>(cc, cc.getPaddedNumAtoms(), "inner1InvAtomOrder");
     for (int i = 0; i < force.getNumEnergyParameterDerivatives(); i++)
@@ -3821,21 +4484,19 @@ void CommonCalcATMForceKernel::initKernels(ContextImpl& context, ContextImpl& in
         innerContext0.setPositions(positions);
         innerContext1.setPositions(positions);
 
-        // Initialize the listeners.
-        ReorderListener* listener = new ReorderListener(cc, invAtomOrder);
+        // Initialize the listeners.  Both kernels loop over atoms in the outer context's order, so only the
+        // inner contexts need inverse orders.
         ReorderListener* listener0 = new ReorderListener(cc0, inner0InvAtomOrder);
         ReorderListener* listener1 = new ReorderListener(cc1, inner1InvAtomOrder);
-        cc.addReorderListener(listener);
         cc0.addReorderListener(listener0);
         cc1.addReorderListener(listener1);
-        listener->execute();
         listener0->execute();
         listener1->execute();
 
         //create CopyState kernel
         ComputeProgram program = cc.compileProgram(CommonKernelSources::atmforce);
         copyStateKernel = program->createKernel("copyState");
-        copyStateKernel->addArg(numParticles);
+        copyStateKernel->addArg(cc.getNumAtoms());
         copyStateKernel->addArg(cc.getPosq());
         copyStateKernel->addArg(cc0.getPosq());
         copyStateKernel->addArg(cc1.getPosq());
@@ -3852,12 +4513,12 @@ void CommonCalcATMForceKernel::initKernels(ContextImpl& context, ContextImpl& in
 
         //create the HybridForce kernel
         hybridForceKernel = program->createKernel("hybridForce");
-        hybridForceKernel->addArg(numParticles);
+        hybridForceKernel->addArg(cc.getNumAtoms());
         hybridForceKernel->addArg(cc.getPaddedNumAtoms());
         hybridForceKernel->addArg(cc.getLongForceBuffer());
         hybridForceKernel->addArg(cc0.getLongForceBuffer());
         hybridForceKernel->addArg(cc1.getLongForceBuffer());
-        hybridForceKernel->addArg(invAtomOrder);
+        hybridForceKernel->addArg(cc.getAtomIndexArray());
         hybridForceKernel->addArg(inner0InvAtomOrder);
         hybridForceKernel->addArg(inner1InvAtomOrder);
         hybridForceKernel->addArg();
@@ -3881,7 +4542,7 @@ void CommonCalcATMForceKernel::applyForces(ContextImpl& context, ContextImpl& in
         hybridForceKernel->setArg(8, (float) dEdu0);
         hybridForceKernel->setArg(9, (float) dEdu1);
     }
-    hybridForceKernel->execute(numParticles);
+    hybridForceKernel->execute(cc.getNumAtoms());
     map<string, double>& derivs = cc.getEnergyParamDerivWorkspace();
     for (auto deriv : energyParamDerivs)
         derivs[deriv.first] += deriv.second;
@@ -3905,7 +4566,7 @@ void CommonCalcATMForceKernel::copyState(ContextImpl& context,
 
     cc0.reorderAtoms();
     cc1.reorderAtoms();
-    copyStateKernel->execute(numParticles);
+    copyStateKernel->execute(cc.getNumAtoms());
 
     map<string, double> innerParameters0 = innerContext0.getParameters();
     for (auto& param : innerParameters0)
@@ -4008,6 +4669,24 @@ double CommonCalcCustomCPPForceKernel::execute(ContextImpl& context, bool includ
 void CommonCalcCustomCPPForceKernel::beginComputation(bool includeForces, bool includeEnergy, int groups) {
     if ((groups&forceGroupFlag) == 0)
         return;
+
+    // Give the force a chance to do the calculation on the device.
+
+    CustomCPPForceImpl::DeviceData data;
+    data.platformName = contextImpl.getPlatform().getName();
+    data.queue = cc.getCurrentQueue()->getNativeHandle();
+    data.posq = cc.getPosq().getNativeHandle();
+    data.posqCorrection = (cc.getUseMixedPrecision() ? cc.getPosqCorrection().getNativeHandle() : NULL);
+    data.forces = cc.getLongForceBuffer().getNativeHandle();
+    data.atomIndex = cc.getAtomIndexArray().getNativeHandle();
+    data.numParticles = cc.getNumAtoms();
+    data.paddedNumParticles = cc.getPaddedNumAtoms();
+    data.useDoublePrecision = cc.getUseDoublePrecision();
+    data.useMixedPrecision = cc.getUseMixedPrecision();
+    energy = 0.0;
+    computedOnDevice = force->computeForceOnDevice(contextImpl, data, includeForces, includeEnergy, energy);
+    if (computedOnDevice)
+        return;
     contextImpl.getPositions(positionsVec);
     
     // The actual force computation will be done on a different thread.
@@ -4036,6 +4715,8 @@ void CommonCalcCustomCPPForceKernel::executeOnWorkerThread(bool includeForces) {
 double CommonCalcCustomCPPForceKernel::addForces(bool includeForces, bool includeEnergy, int groups) {
     if ((groups&forceGroupFlag) == 0)
         return 0;
+    if (computedOnDevice)
+        return energy;
 
     // Wait until executeOnWorkerThread() is finished.
     
@@ -0,0 +1,447 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/common/CommonMinimizeKernel.h"
+#include "openmm/common/ContextSelector.h"
+#include "openmm/common/IntegrationUtilities.h"
+#include "openmm/Integrator.h"
+#include "openmm/internal/ContextImpl.h"
+#include "CommonKernelSources.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace OpenMM;
+using namespace std;
+
+// Indices of the values stored in the results array.
+
+static const int RestraintEnergyIndex = 0;
+static const int LargeForceIndex = 1;
+static const int GradientNormIndex = 2;
+static const int PositionNormIndex = 3;
+static const int DirectionIndex = 4;
+static const int ConstraintErrorIndex = 5;
+static const int NumResults = 6;
+
+// The number of history vectors to store, and the maximum number of energy evaluations in a line search.
+// These match the defaults used by LocalEnergyMinimizer.
+
+static const int HistorySize = 6;
+static const int MaxLineSearch = 40;
+
+void CommonMinimizeKernel::initialize(const System& system) {
+    ContextSelector selector(cc);
+    numConstraints = system.getNumConstraints();
+    historySize = HistorySize;
+    numPartial = cc.getNumThreadBlocks();
+    blockSize = 1;
+    while (2*blockSize <= min(256, cc.getMaxThreadBlockSize()))
+        blockSize *= 2;
+    bool useDouble = cc.getUseDoublePrecision() || cc.getUseMixedPrecision();
+    int elementSize = (useDouble ? sizeof(mm_double4) : sizeof(mm_float4));
+    int accumSize = (cc.getSupportsDoublePrecision() ? sizeof(double) : sizeof(float));
+    int paddedNumAtoms = cc.getPaddedNumAtoms();
+    x.initialize(cc, paddedNumAtoms, elementSize, "minimizerX");
+    xPrev.initialize(cc, paddedNumAtoms, elementSize, "minimizerXPrev");
+    g.initialize(cc, paddedNumAtoms, elementSize, "minimizerGradient");
+    gPrev.initialize(cc, paddedNumAtoms, elementSize, "minimizerGradientPrev");
+    dir.initialize(cc, paddedNumAtoms, elementSize, "minimizerDirection");
+    initialX.initialize(cc, paddedNumAtoms, elementSize, "minimizerInitialX");
+    s.initialize(cc, historySize*paddedNumAtoms, elementSize, "minimizerS");
+    y.initialize(cc, historySize*paddedNumAtoms, elementSize, "minimizerY");
+    historyScalars.initialize(cc, 3*historySize+1, accumSize, "minimizerHistoryScalars");
+    results.initialize(cc, NumResults, accumSize, "minimizerResults");
+    partial.initialize(cc, numPartial, accumSize, "minimizerPartial");
+    if (numConstraints > 0) {
+        constraintAtoms.initialize<mm_int2>(cc, numConstraints, "minimizerConstraintAtoms");
+        constraintDistance.initialize(cc, numConstraints, accumSize, "minimizerConstraintDistance");
+        vector<double> distance(numConstraints);
+        for (int i = 0; i < numConstraints; i++) {
+            int particle1, particle2;
+            system.getConstraintParameters(i, particle1, particle2, distance[i]);
+        }
+        constraintDistance.upload(distance, true);
+    }
+    map<string, string> defines;
+    defines["NUM_ATOMS"] = cc.intToString(cc.getNumAtoms());
+    defines["PADDED_NUM_ATOMS"] = cc.intToString(paddedNumAtoms);
+    defines["NUM_CONSTRAINTS"] = cc.intToString(numConstraints);
+    defines["NUM_PARTIAL"] = cc.intToString(numPartial);
+    defines["WORK_GROUP_SIZE"] = cc.intToString(blockSize);
+    ComputeProgram program = cc.compileProgram(CommonKernelSources::minimize, defines);
+    getPositionsKernel = program->createKernel("getPositions");
+    getPositionsKernel->addArg(cc.getPosq());
+    getPositionsKernel->addArg(cc.getPosqCorrection());
+    getPositionsKernel->addArg(initialX);
+    setPositionsKernel = program->createKernel("setPositions");
+    setPositionsKernel->addArg(cc.getPosq());
+    setPositionsKernel->addArg(cc.getPosqCorrection());
+    setPositionsKernel->addArg(x);
+    setPositionsKernel->addArg(xPrev);
+    setPositionsKernel->addArg(dir);
+    setPositionsKernel->addArg();
+    if (numConstraints > 0) {
+        constraintForcesKernel = program->createKernel("applyConstraintForces");
+        constraintForcesKernel->addArg(cc.getPosq());
+        constraintForcesKernel->addArg(cc.getPosqCorrection());
+        constraintForcesKernel->addArg(cc.getLongForceBuffer());
+        constraintForcesKernel->addArg(constraintAtoms);
+        constraintForcesKernel->addArg(constraintDistance);
+        constraintForcesKernel->addArg();
+        constraintForcesKernel->addArg(partial);
+        constraintErrorKernel = program->createKernel("computeConstraintError");
+        constraintErrorKernel->addArg(cc.getPosq());
+        constraintErrorKernel->addArg(cc.getPosqCorrection());
+        constraintErrorKernel->addArg(constraintAtoms);
+        constraintErrorKernel->addArg(constraintDistance);
+        constraintErrorKernel->addArg(partial);
+    }
+    gradientKernel = program->createKernel("computeGradient");
+    gradientKernel->addArg(cc.getLongForceBuffer());
+    gradientKernel->addArg(cc.getVelm());
+    gradientKernel->addArg(g);
+    gradientKernel->addArg(results);
+    gradientKernel->addArg(LargeForceIndex);
+    dotKernel = program->createKernel("dotProduct");
+    for (int i = 0; i < 4; i++)
+        dotKernel->addArg();
+    dotKernel->addArg(partial);
+    sumKernel = program->createKernel("reduceSum");
+    sumKernel->addArg(partial);
+    sumKernel->addArg();
+    sumKernel->addArg();
+    maxKernel = program->createKernel("reduceMax");
+    maxKernel->addArg(partial);
+    maxKernel->addArg(results);
+    maxKernel->addArg(ConstraintErrorIndex);
+    storeHistoryKernel = program->createKernel("storeHistory");
+    storeHistoryKernel->addArg(x);
+    storeHistoryKernel->addArg(xPrev);
+    storeHistoryKernel->addArg(g);
+    storeHistoryKernel->addArg(gPrev);
+    storeHistoryKernel->addArg(s);
+    storeHistoryKernel->addArg(y);
+    storeHistoryKernel->addArg();
+    updateQKernel = program->createKernel("updateQ");
+    updateQKernel->addArg(dir);
+    updateQKernel->addArg(y);
+    updateQKernel->addArg();
+    updateQKernel->addArg(historyScalars);
+    updateQKernel->addArg(3*historySize);
+    updateQKernel->addArg();
+    updateQKernel->addArg();
+    scaleQKernel = program->createKernel("scaleQ");
+    scaleQKernel->addArg(dir);
+    scaleQKernel->addArg(historyScalars);
+    scaleQKernel->addArg();
+    scaleQKernel->addArg();
+    updateRKernel = program->createKernel("updateR");
+    updateRKernel->addArg(dir);
+    updateRKernel->addArg(s);
+    updateRKernel->addArg();
+    updateRKernel->addArg(historyScalars);
+    updateRKernel->addArg(3*historySize);
+    updateRKernel->addArg();
+    updateRKernel->addArg();
+}
+
+bool CommonMinimizeKernel::execute(ContextImpl& context, double tolerance, int maxIterations) {
+    ContextSelector selector(cc);
+    const System& system = context.getSystem();
+    double constraintTol = context.getIntegrator().getConstraintTolerance();
+    double workingConstraintTol = std::max(1e-4, constraintTol);
+    double k = 100/workingConstraintTol;
+
+    // Atoms may have been reordered since the last call, so map the constraints to the current order.
+
+    if (numConstraints > 0) {
+        const vector<int>& order = cc.getAtomIndex();
+        vector<int> inverseOrder(order.size());
+        for (int i = 0; i < order.size(); i++)
+            inverseOrder[order[i]] = i;
+        vector<mm_int2> atoms(numConstraints);
+        for (int i = 0; i < numConstraints; i++) {
+            int particle1, particle2;
+            double distance;
+            system.getConstraintParameters(i, particle1, particle2, distance);
+            atoms[i] = mm_int2(inverseOrder[particle1], inverseOrder[particle2]);
+        }
+        constraintAtoms.upload(atoms);
+    }
+
+    // Make sure the initial configuration satisfies all constraints.
+
+    context.applyConstraints(workingConstraintTol);
+
+    // Record the initial positions and determine a normalization constant for scaling the tolerance.
+
+    getPositionsKernel->execute(cc.getNumAtoms());
+    initialX.copyTo(x);
+    vector<double> values;
+    computeDot(initialX, 0, initialX, 0, results, PositionNormIndex);
+    downloadResults(values);
+    double norm = values[PositionNormIndex]/system.getNumParticles();
+    norm = (norm < 1 ? 1 : sqrt(norm));
+    double epsilon = tolerance/norm;
+
+    // Repeatedly minimize, steadily increasing the strength of the springs until all constraints are satisfied.
+
+    double prevMaxError = 1e10;
+    while (true) {
+        // Perform the minimization.
+
+        if (!minimizeWithRestraints(context, k, epsilon, maxIterations)) {
+            // Forces became too large to compute reliably.  Leave the last good positions in the
+            // context so the caller can continue from them.
+
+            setPositions(xPrev, x);
+            return false;
+        }
+        if (numConstraints == 0)
+            break;
+
+        // Check whether all constraints are satisfied.
+
+        constraintErrorKernel->execute(numPartial*blockSize, blockSize);
+        maxKernel->execute(blockSize, blockSize);
+        downloadResults(values);
+        double maxError = values[ConstraintErrorIndex];
+        if (maxError <= workingConstraintTol)
+            break; // All constraints are satisfied.
+        setPositions(initialX, gPrev);
+        if (maxError >= prevMaxError)
+            break; // Further tightening the springs doesn't seem to be helping, so just give up.
+        prevMaxError = maxError;
+        k *= 10;
+        if (maxError > 100*workingConstraintTol) {
+            // We've gotten far enough from a valid state that we might have trouble getting
+            // back, so reset to the original positions.
+
+            initialX.copyTo(x);
+        }
+    }
+
+    // If necessary, do a final constraint projection to make sure they are satisfied
+    // to the full precision requested by the user.
+
+    if (constraintTol < workingConstraintTol)
+        context.applyConstraints(constraintTol);
+    return true;
+}
+
+bool CommonMinimizeKernel::minimizeWithRestraints(ContextImpl& context, double k, double epsilon, int maxIterations) {
+    // Evaluate the starting point.  xPrev holds the positions to evaluate, and the step length is 0.
+
+    vector<double> values;
+    double energy;
+    x.copyTo(xPrev);
+    cc.clearBuffer(dir);
+    if (!evaluate(context, 0.0, k, energy))
+        return false;
+    computeDot(g, 0, g, 0, results, GradientNormIndex);
+    computeDot(x, 0, x, 0, results, PositionNormIndex);
+    downloadResults(values);
+    double gnorm = sqrt(values[GradientNormIndex]);
+    if (gnorm/max(1.0, sqrt(values[PositionNormIndex])) <= epsilon)
+        return true;
+
+    // The first step is along the gradient, scaled to unit length.  dir holds H*g, where H is
+    // the current estimate of the inverse Hessian, so the search direction is -dir.
+
+    int paddedNumAtoms = cc.getPaddedNumAtoms();
+    int numHistory = 0, newest = historySize-1;
+    g.copyTo(dir);
+    double step = 1/gnorm;
+    for (int iteration = 0; maxIterations == 0 || iteration < maxIterations; ) {
+        x.copyTo(xPrev);
+        g.copyTo(gPrev);
+        double prevEnergy = energy;
+        computeDot(g, 0, dir, 0, results, DirectionIndex);
+        downloadResults(values);
+        double slope = -values[DirectionIndex];
+        if (!(slope < 0)) {
+            // This isn't a descent direction, so discard the history and use the gradient.
+
+            numHistory = 0;
+            g.copyTo(dir);
+            slope = -gnorm*gnorm;
+            step = 1/gnorm;
+        }
+
+        // Perform a backtracking line search until the energy decreases sufficiently.
+
+        bool accepted = false;
+        for (int i = 0; i < MaxLineSearch && !accepted; i++) {
+            if (!evaluate(context, step, k, energy))
+                return false;
+            if (energy <= prevEnergy+1e-4*step*slope)
+                accepted = true;
+            else
+                step *= 0.5;
+        }
+        if (!accepted) {
+            // Return to the previous positions.  If we were already moving along the gradient, no further
+            // progress is possible.  Otherwise discard the history and try again along the gradient.
+
+            setPositions(xPrev, x);
+            gPrev.copyTo(g);
+            energy = prevEnergy;
+            if (numHistory == 0)
+                break;
+            numHistory = 0;
+            g.copyTo(dir);
+            step = 1/gnorm;
+            continue;
+        }
+        iteration++;
+
+        // Record the new pair of history vectors and check for convergence.
+
+        int slot = (newest+1)%historySize;
+        storeHistoryKernel->setArg(6, slot*paddedNumAtoms);
+        storeHistoryKernel->execute(cc.getNumAtoms());
+        computeDot(s, slot*paddedNumAtoms, y, slot*paddedNumAtoms, historyScalars, slot);
+        computeDot(y, slot*paddedNumAtoms, y, slot*paddedNumAtoms, historyScalars, historySize+slot);
+        computeDot(g, 0, g, 0, results, GradientNormIndex);
+        computeDot(x, 0, x, 0, results, PositionNormIndex);
+        downloadResults(values);
+        gnorm = sqrt(values[GradientNormIndex]);
+        if (gnorm/max(1.0, sqrt(values[PositionNormIndex])) <= epsilon)
+            break;
+        vector<double> history;
+        if (cc.getSupportsDoublePrecision())
+            historyScalars.download(history);
+        else {
+            vector<float> historyFloat;
+            historyScalars.download(historyFloat);
+            history.assign(historyFloat.begin(), historyFloat.end());
+        }
+        if (history[slot] > 0 && history[historySize+slot] > 0) {
+            newest = slot;
+            numHistory = min(numHistory+1, historySize);
+        }
+        else if (numHistory == historySize) {
+            // The pair doesn't satisfy the curvature condition, so it was discarded.  It overwrote the oldest pair.
+
+            numHistory--;
+        }
+
+        // Compute the new direction with the L-BFGS two loop recursion.
+
+        g.copyTo(dir);
+        for (int j = 0; j < numHistory; j++) {
+            int index = (newest-j+historySize)%historySize;
+            computeDot(s, index*paddedNumAtoms, dir, 0, historyScalars, 3*historySize);
+            updateQKernel->setArg(2, index*paddedNumAtoms);
+            updateQKernel->setArg(5, index);
+            updateQKernel->setArg(6, 2*historySize+index);
+            updateQKernel->execute(cc.getNumAtoms());
+        }
+        if (numHistory > 0) {
+            scaleQKernel->setArg(2, newest);
+            scaleQKernel->setArg(3, historySize+newest);
+            scaleQKernel->execute(cc.getNumAtoms());
+        }
+        for (int j = numHistory-1; j >= 0; j--) {
+            int index = (newest-j+historySize)%historySize;
+            computeDot(y, index*paddedNumAtoms, dir, 0, historyScalars, 3*historySize);
+            updateRKernel->setArg(2, index*paddedNumAtoms);
+            updateRKernel->setArg(5, index);
+            updateRKernel->setArg(6, 2*historySize+index);
+            updateRKernel->execute(cc.getNumAtoms());
+        }
+        step = (numHistory > 0 ? 1.0 : 1/gnorm);
+    }
+    return true;
+}
+
+bool CommonMinimizeKernel::evaluate(ContextImpl& context, double step, double k, double& energy) {
+    if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision())
+        setPositionsKernel->setArg(5, step);
+    else
+        setPositionsKernel->setArg(5, (float) step);
+    setPositionsKernel->execute(cc.getNumAtoms());
+    cc.getIntegrationUtilities().computeVirtualSites();
+    energy = context.calcForcesAndEnergy(true, true, context.getIntegrator().getIntegrationForceGroups());
+    cc.clearBuffer(results);
+    if (numConstraints > 0) {
+        if (cc.getSupportsDoublePrecision())
+            constraintForcesKernel->setArg(5, k);
+        else
+            constraintForcesKernel->setArg(5, (float) k);
+        constraintForcesKernel->execute(numPartial*blockSize, blockSize);
+        sumKernel->setArg(1, results);
+        sumKernel->setArg(2, RestraintEnergyIndex);
+        sumKernel->execute(blockSize, blockSize);
+    }
+    gradientKernel->execute(cc.getNumAtoms());
+    vector<double> values;
+    downloadResults(values);
+    if (values[LargeForceIndex] != 0)
+        return false;
+    energy += values[RestraintEnergyIndex];
+    return true;
+}
+
+void CommonMinimizeKernel::setPositions(ComputeArray& positions, ComputeArray& target) {
+    // The setPositions kernel computes positions as xPrev - step*dir and stores them in both the
+    // context and x.  Temporarily point it at other arrays, using a step length of 0.  The direction
+    // is cleared so that stale values (which might not be finite) cannot affect the result.  target
+    // is overwritten, so it must not be dir.
+
+    cc.clearBuffer(dir);
+    setPositionsKernel->setArg(2, target);
+    setPositionsKernel->setArg(3, positions);
+    if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision())
+        setPositionsKernel->setArg(5, 0.0);
+    else
+        setPositionsKernel->setArg(5, 0.0f);
+    setPositionsKernel->execute(cc.getNumAtoms());
+    setPositionsKernel->setArg(2, x);
+    setPositionsKernel->setArg(3, xPrev);
+    cc.getIntegrationUtilities().computeVirtualSites();
+}
+
+void CommonMinimizeKernel::computeDot(ComputeArray& a, int aOffset, ComputeArray& b, int bOffset, ComputeArray& result, int index) {
+    dotKernel->setArg(0, a);
+    dotKernel->setArg(1, aOffset);
+    dotKernel->setArg(2, b);
+    dotKernel->setArg(3, bOffset);
+    dotKernel->execute(numPartial*blockSize, blockSize);
+    sumKernel->setArg(1, result);
+    sumKernel->setArg(2, index);
+    sumKernel->execute(blockSize, blockSize);
+}
+
+void CommonMinimizeKernel::downloadResults(vector<double>& values) {
+    if (cc.getSupportsDoublePrecision())
+        results.download(values);
+    else {
+        vector<float> floatValues;
+        results.download(floatValues);
+        values.assign(floatValues.begin(), floatValues.end());
+    }
+}
@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2019-2022 Stanford University and the Authors.      *
+ * Portions copyright (c) 2019-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -50,6 +50,13 @@ void ComputeArray::initialize(ComputeContext& context, size_t size, int elementS
     impl->initialize(context, size, elementSize, name);
 }
 
+void ComputeArray::initializeShared(ComputeContext& context, ArrayInterface& source, const std::string& name) {
+    if (impl != NULL)
+        throw OpenMMException("The array "+getName()+" has already been initialized");
+    impl = context.createArray();
+    impl->initializeShared(context, source, name);
+}
+
 void ComputeArray::resize(size_t size) {
     if (impl == NULL)
         throw OpenMMException("ComputeArray has not been initialized");
@@ -96,8 +103,20 @@ void ComputeArray::download(void* data, bool blocking) const {
     impl->download(data, blocking);
 }
 
+void ComputeArray::downloadSubArray(void* data, int offset, int elements, bool blocking) const {
+    if (impl == NULL)
+        throw OpenMMException("ComputeArray has not been initialized");
+    impl->downloadSubArray(data, offset, elements, blocking);
+}
+
 void ComputeArray::copyTo(ArrayInterface& dest) const {
     if (impl == NULL)
         throw OpenMMException("ComputeArray has not been initialized");
     impl->copyTo(dest);
-}
\ No newline at end of file
+}
+
+void* ComputeArray::getNativeHandle() {
+    if (impl == NULL)
+        throw OpenMMException("ComputeArray has not been initialized");
+    return impl->getNativeHandle();
+}
@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2019-2024 Stanford University and the Authors.      *
+ * Portions copyright (c) 2019-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -25,17 +25,36 @@
  * -------------------------------------------------------------------------- */
 
 #include "openmm/common/ComputeContext.h"
+#include "openmm/common/CommonKernelUtilities.h"
 #include "openmm/common/ContextSelector.h"
+#include "CommonKernelSources.h"
+#include "openmm/AndersenThermostat.h"
+#include "openmm/CMAPTorsionForce.h"
+#include "openmm/CMMotionRemover.h"
+#include "openmm/CustomAngleForce.h"
+#include "openmm/CustomBondForce.h"
+#include "openmm/CustomExternalForce.h"
+#include "openmm/CustomTorsionForce.h"
+#include "openmm/GBSAOBCForce.h"
+#include "openmm/HarmonicAngleForce.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/MonteCarloAnisotropicBarostat.h"
+#include "openmm/MonteCarloBarostat.h"
+#include "openmm/MonteCarloFlexibleBarostat.h"
+#include "openmm/MonteCarloMembraneBarostat.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/PeriodicTorsionForce.h"
+#include "openmm/RBTorsionForce.h"
 #include "openmm/System.h"
 #include "openmm/VirtualSite.h"
 #include "openmm/internal/ContextImpl.h"
 #include "openmm/internal/ThreadPool.h"
-#include "hilbert.h"
 #include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <iomanip>
 #include <set>
 #include <sstream>
-#include <unordered_set>
 #include <utility>
 
 using namespace OpenMM;
@@ -44,12 +63,15 @@ using namespace std;
 const int ComputeContext::ThreadBlockSize = 64;
 const int ComputeContext::TileSize = 32;
 
-ComputeContext::ComputeContext(const System& system) : system(system), time(0.0), stepCount(0), computeForceCount(0), stepsSinceReorder(99999),
-        forceNextReorder(false), atomsWereReordered(false), forcesValid(false), hasInitializedGlobals(false) {
+ComputeContext::ComputeContext(const System& system) : system(system), time(0.0), stepCount(0), computeForceCount(0), stepsSinceReorder(99999), positionsSetCount(0),
+        forceNextReorder(false), atomsWereReordered(false), forcesValid(false), hasInitializedGlobals(false), keepEnergyOnDevice(false), profilingEnabled(false), annotationsEnabled(false),
+        hasInitializedReordering(false), deviceCellOffsetsAreCurrent(false), atomIndexIsOnDevice(false), cellOffsetsAreOnDevice(false), timeIsOnDevice(false),
+        arrayMemoryTotal(0), memoryBudget(0), sharedArrays(NULL), ownsSharedArrays(false) {
     workThread = new WorkThread();
 }
 
 ComputeContext::~ComputeContext() {
+    releaseSharedArrays();
 }
 
 ComputeQueue ComputeContext::getCurrentQueue() {
@@ -70,6 +92,7 @@ void ComputeContext::addForce(ComputeForceInfo* force) {
 
 void ComputeContext::setAtomIndex(std::vector<int>& index){
     atomIndex = index;
+    atomIndexIsOnDevice = false;
     getAtomIndexArray().upload(atomIndex);
     for (auto listener : reorderListeners)
         listener->execute();
@@ -210,29 +233,23 @@ void ComputeContext::findMoleculeGroups() {
 
         addForce(new VirtualSiteInfo(system));
 
-        // First make a list of every other atom to which each atom is connect by a constraint or force group.
+        // First make a list of every pair of atoms that are connected by a constraint or force group.
 
-        vector<unordered_set<int> > atomBondSets(system.getNumParticles());
+        vector<pair<int, int> > atomBonds;
         for (int i = 0; i < system.getNumConstraints(); i++) {
             int particle1, particle2;
             double distance;
             system.getConstraintParameters(i, particle1, particle2, distance);
-            atomBondSets[particle1].insert(particle2);
-            atomBondSets[particle2].insert(particle1);
+            atomBonds.push_back(make_pair(particle1, particle2));
         }
         for (auto force : forces) {
             vector<int> particles;
             for (int j = 0; j < force->getNumParticleGroups(); j++) {
                 force->getParticlesInGroup(j, particles);
-                for (int k = 1; k < (int) particles.size(); k++) {
-                    atomBondSets[particles[k]].insert(particles[k-1]);
-                    atomBondSets[particles[k-1]].insert(particles[k]);
-                }
+                for (int k = 1; k < (int) particles.size(); k++)
+                    atomBonds.push_back(make_pair(particles[k-1], particles[k]));
             }
         }
-        vector<vector<int> > atomBonds(system.getNumParticles());
-        for (int i = 0; i < system.getNumParticles(); i++)
-            atomBonds[i].insert(atomBonds[i].begin(), atomBondSets[i].begin(),atomBondSets[i].end());
 
         // Now identify atoms by which molecule they belong to.
 
@@ -266,72 +283,92 @@ void ComputeContext::findMoleculeGroups() {
         }
     }
 
-    // Sort them into groups of identical molecules.
-
+    // Sort them into groups of identical molecules.  If the System declares molecule types, the first
+    // instance of each type is the first candidate checked for the other instances.  Otherwise the
+    // group matched by the previous molecule is tried first, since identical molecules such as
+    // waters are usually consecutive.  In either case the molecules are still compared, and if the
+    // candidate does not match, every group is searched.
+
+    vector<int> declaredType(numAtoms, -1);
+    for (int i = 0; i < system.getNumMoleculeTypes(); i++) {
+        int numParticles;
+        vector<int> firstParticles;
+        system.getMoleculeTypeParameters(i, numParticles, firstParticles);
+        for (int first : firstParticles)
+            declaredType[first] = i;
+    }
+    vector<int> groupForType(system.getNumMoleculeTypes(), -1);
+    int lastMatch = -1;
     vector<Molecule> uniqueMolecules;
     vector<vector<int> > moleculeInstances;
     vector<vector<int> > moleculeOffsets;
-    for (int molIndex = 0; molIndex < (int) molecules.size(); molIndex++) {
-        Molecule& mol = molecules[molIndex];
+    auto areMoleculesIdentical = [&] (Molecule& mol, Molecule& mol2) {
+        bool identical = (mol.atoms.size() == mol2.atoms.size() && mol.constraints.size() == mol2.constraints.size());
 
-        // See if it is identical to another molecule.
-
-        bool isNew = true;
-        for (int j = 0; j < (int) uniqueMolecules.size() && isNew; j++) {
-            Molecule& mol2 = uniqueMolecules[j];
-            bool identical = (mol.atoms.size() == mol2.atoms.size() && mol.constraints.size() == mol2.constraints.size());
-
-            // See if the atoms are identical.
+        // See if the atoms are identical.
 
-            int atomOffset = mol2.atoms[0]-mol.atoms[0];
-            for (int i = 0; i < (int) mol.atoms.size() && identical; i++) {
-                if (mol.atoms[i] != mol2.atoms[i]-atomOffset || system.getParticleMass(mol.atoms[i]) != system.getParticleMass(mol2.atoms[i]))
+        int atomOffset = mol2.atoms[0]-mol.atoms[0];
+        for (int i = 0; i < (int) mol.atoms.size() && identical; i++) {
+            if (mol.atoms[i] != mol2.atoms[i]-atomOffset || system.getParticleMass(mol.atoms[i]) != system.getParticleMass(mol2.atoms[i]))
+                identical = false;
+            for (int k = 0; k < (int) forces.size(); k++)
+                if (!forces[k]->areParticlesIdentical(mol.atoms[i], mol2.atoms[i]))
                     identical = false;
-                for (int k = 0; k < (int) forces.size(); k++)
-                    if (!forces[k]->areParticlesIdentical(mol.atoms[i], mol2.atoms[i]))
-                        identical = false;
-            }
+        }
 
-            // See if the constraints are identical.
+        // See if the constraints are identical.
 
-            for (int i = 0; i < (int) mol.constraints.size() && identical; i++) {
-                int c1particle1, c1particle2, c2particle1, c2particle2;
-                double distance1, distance2;
-                system.getConstraintParameters(mol.constraints[i], c1particle1, c1particle2, distance1);
-                system.getConstraintParameters(mol2.constraints[i], c2particle1, c2particle2, distance2);
-                if (c1particle1 != c2particle1-atomOffset || c1particle2 != c2particle2-atomOffset || distance1 != distance2)
-                    identical = false;
-            }
+        for (int i = 0; i < (int) mol.constraints.size() && identical; i++) {
+            int c1particle1, c1particle2, c2particle1, c2particle2;
+            double distance1, distance2;
+            system.getConstraintParameters(mol.constraints[i], c1particle1, c1particle2, distance1);
+            system.getConstraintParameters(mol2.constraints[i], c2particle1, c2particle2, distance2);
+            if (c1particle1 != c2particle1-atomOffset || c1particle2 != c2particle2-atomOffset || distance1 != distance2)
+                identical = false;
+        }
 
-            // See if the force groups are identical.
+        // See if the force groups are identical.
 
-            for (int i = 0; i < (int) forces.size() && identical; i++) {
-                if (mol.groups[i].size() != mol2.groups[i].size())
+        for (int i = 0; i < (int) forces.size() && identical; i++) {
+            if (mol.groups[i].size() != mol2.groups[i].size())
+                identical = false;
+            vector<int> p1, p2;
+            for (int k = 0; k < (int) mol.groups[i].size() && identical; k++) {
+                if (!forces[i]->areGroupsIdentical(mol.groups[i][k], mol2.groups[i][k]))
                     identical = false;
-                vector<int> p1, p2;
-                for (int k = 0; k < (int) mol.groups[i].size() && identical; k++) {
-                    if (!forces[i]->areGroupsIdentical(mol.groups[i][k], mol2.groups[i][k]))
+                forces[i]->getParticlesInGroup(mol.groups[i][k], p1);
+                forces[i]->getParticlesInGroup(mol2.groups[i][k], p2);
+                for (int m = 0; m < p1.size(); m++)
+                    if (p1[m] != p2[m]-atomOffset)
                         identical = false;
-                    forces[i]->getParticlesInGroup(mol.groups[i][k], p1);
-                    forces[i]->getParticlesInGroup(mol2.groups[i][k], p2);
-                    for (int m = 0; m < p1.size(); m++)
-                        if (p1[m] != p2[m]-atomOffset)
-                            identical = false;
-                }
-            }
-            if (identical) {
-                moleculeInstances[j].push_back(molIndex);
-                moleculeOffsets[j].push_back(mol.atoms[0]);
-                isNew = false;
             }
         }
-        if (isNew) {
+        return identical;
+    };
+    for (int molIndex = 0; molIndex < (int) molecules.size(); molIndex++) {
+        Molecule& mol = molecules[molIndex];
+        int type = declaredType[mol.atoms[0]];
+
+        // See if it is identical to another molecule.
+
+        int candidate = (type == -1 ? lastMatch : groupForType[type]);
+        int match = -1;
+        if (candidate != -1 && areMoleculesIdentical(mol, uniqueMolecules[candidate]))
+            match = candidate;
+        for (int j = 0; j < (int) uniqueMolecules.size() && match == -1; j++)
+            if (j != candidate && areMoleculesIdentical(mol, uniqueMolecules[j]))
+                match = j;
+        if (match == -1) {
+            match = uniqueMolecules.size();
             uniqueMolecules.push_back(mol);
             moleculeInstances.push_back(vector<int>());
-            moleculeInstances[moleculeInstances.size()-1].push_back(molIndex);
             moleculeOffsets.push_back(vector<int>());
-            moleculeOffsets[moleculeOffsets.size()-1].push_back(mol.atoms[0]);
         }
+        moleculeInstances[match].push_back(molIndex);
+        moleculeOffsets[match].push_back(mol.atoms[0]);
+        if (type != -1 && groupForType[type] == -1)
+            groupForType[type] = match;
+        lastMatch = match;
     }
     moleculeGroups.resize(moleculeInstances.size());
     for (int i = 0; i < (int) moleculeInstances.size(); i++)
@@ -343,6 +380,7 @@ void ComputeContext::findMoleculeGroups() {
         for (int j = 0; j < (int) atoms.size(); j++)
             moleculeGroups[i].atoms[j] = atoms[j]-atoms[0];
     }
+    hasInitializedReordering = false;
 }
 
 void ComputeContext::invalidateMolecules() {
@@ -409,6 +447,8 @@ bool ComputeContext::invalidateMolecules(ComputeForceInfo* force, bool checkAtom
 
 void ComputeContext::resetAtomOrder() {
     ContextSelector selector(*this);
+    getAtomIndex();
+    getPosCellOffsets();
     vector<mm_int4> newCellOffsets(numAtoms);
     if (getUseDoublePrecision()) {
         vector<mm_double4> oldPosq(paddedNumAtoms);
@@ -474,6 +514,7 @@ void ComputeContext::resetAtomOrder() {
 }
 
 void ComputeContext::validateAtomOrder() {
+    getAtomIndex();
     for (auto& mol : moleculeGroups) {
         for (int atom : mol.atoms) {
             set<int> identical;
@@ -502,183 +543,231 @@ void ComputeContext::reorderAtoms() {
     forceNextReorder = false;
     atomsWereReordered = true;
     stepsSinceReorder = 0;
-    if (getUseDoublePrecision())
-        reorderAtomsImpl<double, mm_double4, double, mm_double4>();
-    else if (getUseMixedPrecision())
-        reorderAtomsImpl<float, mm_float4, double, mm_double4>();
-    else
-        reorderAtomsImpl<float, mm_float4, float, mm_float4>();
+    Annotation annotation(*this, "reorderAtoms");
+    reorderAtomsImpl();
 }
 
-template <class Real, class Real4, class Mixed, class Mixed4>
-void ComputeContext::reorderAtomsImpl() {
-
-    // Find the range of positions and the number of bins along each axis.
-
-    vector<Real4> oldPosq(paddedNumAtoms);
-    vector<Real4> oldPosqCorrection(paddedNumAtoms);
-    vector<Mixed4> oldVelm(paddedNumAtoms);
-    getPosq().download(oldPosq);
-    getVelm().download(oldVelm);
-    if (getUseMixedPrecision())
-        getPosqCorrection().download(oldPosqCorrection);
-    Real minx = oldPosq[0].x, maxx = oldPosq[0].x;
-    Real miny = oldPosq[0].y, maxy = oldPosq[0].y;
-    Real minz = oldPosq[0].z, maxz = oldPosq[0].z;
-    Vec3 periodicBoxX, periodicBoxY, periodicBoxZ;
-    getPeriodicBoxVectors(periodicBoxX, periodicBoxY, periodicBoxZ);
-    Vec3 invPeriodicBoxSize(1.0/periodicBoxX[0], 1.0/periodicBoxY[1], 1.0/periodicBoxZ[2]);
-    if (getNonbondedUtilities().getUsePeriodic()) {
-        minx = miny = minz = 0.0;
-        maxx = periodicBoxX[0];
-        maxy = periodicBoxY[1];
-        maxz = periodicBoxZ[2];
-    }
-    else {
-        for (int i = 1; i < numAtoms; i++) {
-            const Real4& pos = oldPosq[i];
-            minx = min(minx, pos.x);
-            maxx = max(maxx, pos.x);
-            miny = min(miny, pos.y);
-            maxy = max(maxy, pos.y);
-            minz = min(minz, pos.z);
-            maxz = max(maxz, pos.z);
-        }
-    }
+/**
+ * This defines the keys used for sorting molecules.  Each one is a 64 bit integer.
+ */
+class ReorderSortTrait : public ComputeSortImpl::SortTrait {
+    int getDataSize() const {return 8;}
+    int getKeySize() const {return 8;}
+    const char* getDataType() const {return "mm_long";}
+    const char* getKeyType() const {return "mm_long";}
+    const char* getMinKey() const {return "((mm_long) 0)";}
+    const char* getMaxKey() const {return "((mm_long) 0x7FFFFFFFFFFFFFFF)";}
+    const char* getMaxValue() const {return "((mm_long) 0x7FFFFFFFFFFFFFFF)";}
+    const char* getSortKey() const {return "value";}
+};
 
-    // Loop over each group of identical molecules and reorder them.
+void ComputeContext::initializeReordering() {
+    // Build the tables describing every molecule.  Molecules are numbered consecutively
+    // within each group of identical molecules.
 
-    
-    vector<int> originalIndex(numAtoms);
-    vector<Real4> newPosq(paddedNumAtoms, Real4(0,0,0,0));
-    vector<Real4> newPosqCorrection(paddedNumAtoms, Real4(0,0,0,0));
-    vector<Mixed4> newVelm(paddedNumAtoms, Mixed4(0,0,0,0));
-    vector<mm_int4> newCellOffsets(numAtoms);
+    vector<mm_int4> moleculeInfo;
+    vector<int> moleculeAtoms, atomMolecule(numAtoms, 0);
+    reorderGroupFirst.clear();
+    reorderGroupSize.clear();
+    reorderGroupHilbert.clear();
     for (auto& mol : moleculeGroups) {
-        // Find the center of each molecule.
-
         int numMolecules = mol.offsets.size();
-        vector<int>& atoms = mol.atoms;
-        vector<Real4> molPos(numMolecules);
-        Real invNumAtoms = (Real) (1.0/atoms.size());
-        for (int i = 0; i < numMolecules; i++) {
-            molPos[i].x = 0.0f;
-            molPos[i].y = 0.0f;
-            molPos[i].z = 0.0f;
-            for (int j = 0; j < (int)atoms.size(); j++) {
-                int atom = atoms[j]+mol.offsets[i];
-                const Real4& pos = oldPosq[atom];
-                molPos[i].x += pos.x;
-                molPos[i].y += pos.y;
-                molPos[i].z += pos.z;
-            }
-            molPos[i].x *= invNumAtoms;
-            molPos[i].y *= invNumAtoms;
-            molPos[i].z *= invNumAtoms;
-            if (molPos[i].x != molPos[i].x)
-                throw OpenMMException("Particle coordinate is NaN.  For more information, see https://github.com/openmm/openmm/wiki/Frequently-Asked-Questions#nan");
-        }
-        if (getNonbondedUtilities().getUsePeriodic()) {
-            // Move each molecule position into the same box.
-
-            for (int i = 0; i < numMolecules; i++) {
-                Real4 center = molPos[i];
-                int zcell = (int) floor(center.z*invPeriodicBoxSize[2]);
-                center.x -= zcell*periodicBoxZ[0];
-                center.y -= zcell*periodicBoxZ[1];
-                center.z -= zcell*periodicBoxZ[2];
-                int ycell = (int) floor(center.y*invPeriodicBoxSize[1]);
-                center.x -= ycell*periodicBoxY[0];
-                center.y -= ycell*periodicBoxY[1];
-                int xcell = (int) floor(center.x*invPeriodicBoxSize[0]);
-                center.x -= xcell*periodicBoxX[0];
-                if (xcell != 0 || ycell != 0 || zcell != 0) {
-                    Real dx = molPos[i].x-center.x;
-                    Real dy = molPos[i].y-center.y;
-                    Real dz = molPos[i].z-center.z;
-                    molPos[i] = center;
-                    for (int j = 0; j < (int) atoms.size(); j++) {
-                        int atom = atoms[j]+mol.offsets[i];
-                        Real4 p = oldPosq[atom];
-                        p.x -= dx;
-                        p.y -= dy;
-                        p.z -= dz;
-                        oldPosq[atom] = p;
-                        posCellOffsets[atom].x -= xcell;
-                        posCellOffsets[atom].y -= ycell;
-                        posCellOffsets[atom].z -= zcell;
-                    }
-                }
-            }
+        if (numMolecules > 1) {
+            reorderGroupFirst.push_back(moleculeInfo.size());
+            reorderGroupSize.push_back(numMolecules);
+            reorderGroupHilbert.push_back(numMolecules > 5000 || mol.atoms.size() > 8); // For small systems, a simple zigzag curve works better than a Hilbert curve.
         }
-
-        // Select a bin for each molecule, then sort them by bin.
-
-        bool useHilbert = (numMolecules > 5000 || atoms.size() > 8); // For small systems, a simple zigzag curve works better than a Hilbert curve.
-        Real binWidth;
-        if (useHilbert)
-            binWidth = (Real) (max(max(maxx-minx, maxy-miny), maxz-minz)/255.0);
-        else
-            binWidth = (Real) (0.2*getNonbondedUtilities().getMaxCutoffDistance());
-        Real invBinWidth = (Real) (1.0/binWidth);
-        int xbins = 1 + (int) ((maxx-minx)*invBinWidth);
-        int ybins = 1 + (int) ((maxy-miny)*invBinWidth);
-        vector<pair<int, int> > molBins(numMolecules);
-        bitmask_t coords[3];
-        for (int i = 0; i < numMolecules; i++) {
-            int x = (int) ((molPos[i].x-minx)*invBinWidth);
-            int y = (int) ((molPos[i].y-miny)*invBinWidth);
-            int z = (int) ((molPos[i].z-minz)*invBinWidth);
-            int bin;
-            if (useHilbert) {
-                coords[0] = x;
-                coords[1] = y;
-                coords[2] = z;
-                bin = (int) hilbert_c2i(3, 8, coords);
-            }
-            else {
-                int yodd = y&1;
-                int zodd = z&1;
-                bin = z*xbins*ybins;
-                bin += (zodd ? ybins-y : y)*xbins;
-                bin += (yodd ? xbins-x : x);
-            }
-            molBins[i] = pair<int, int>(bin, i);
+        int atomsStart = moleculeAtoms.size();
+        moleculeAtoms.insert(moleculeAtoms.end(), mol.atoms.begin(), mol.atoms.end());
+        for (int offset : mol.offsets) {
+            for (int atom : mol.atoms)
+                atomMolecule[offset+atom] = moleculeInfo.size();
+            moleculeInfo.push_back(mm_int4(offset, atomsStart, mol.atoms.size(), 0));
         }
-        sort(molBins.begin(), molBins.end());
+    }
+    int numMolecules = moleculeInfo.size();
+    vector<int> moleculeSource(numMolecules);
+    for (int i = 0; i < numMolecules; i++)
+        moleculeSource[i] = i;
+
+    // Create the arrays.
+
+    int elementSize = (getUseDoublePrecision() ? sizeof(mm_double4) : sizeof(mm_float4));
+    int mixedElementSize = (getUseDoublePrecision() || getUseMixedPrecision() ? sizeof(mm_double4) : sizeof(mm_float4));
+    if (!reorderPermutation.isInitialized()) {
+        reorderAtomMolecule.initialize<int>(*this, numAtoms, "reorderAtomMolecule");
+        reorderMoleculeCenters.initialize(*this, numMolecules, elementSize, "reorderMoleculeCenters");
+        reorderMoleculeCells.initialize<mm_int4>(*this, numMolecules, "reorderMoleculeCells");
+        reorderMoleculeSource.initialize<int>(*this, numMolecules, "reorderMoleculeSource");
+        reorderRange.initialize(*this, 2, elementSize, "reorderRange");
+        reorderInvalidPosition.initialize<int>(*this, 1, "reorderInvalidPosition");
+        reorderPermutation.initialize<int>(*this, paddedNumAtoms, "reorderPermutation");
+        reorderCellOffsets.initialize<mm_int4>(*this, paddedNumAtoms, "posCellOffsets");
+        reorderOldPosq.initialize(*this, paddedNumAtoms, elementSize, "reorderOldPosq");
+        if (getUseMixedPrecision())
+            reorderOldPosqCorrection.initialize(*this, paddedNumAtoms, elementSize, "reorderOldPosqCorrection");
+        reorderOldVelm.initialize(*this, paddedNumAtoms, mixedElementSize, "reorderOldVelm");
+        reorderOldAtomIndex.initialize<int>(*this, paddedNumAtoms, "reorderOldAtomIndex");
+        reorderOldCellOffsets.initialize<mm_int4>(*this, paddedNumAtoms, "reorderOldCellOffsets");
+        reorderInvalidPosition.upload(vector<int>(1, 0));
+    }
+    if (reorderMoleculeInfo.isInitialized()) {
+        reorderMoleculeInfo.resize(numMolecules);
+        reorderMoleculeAtoms.resize(moleculeAtoms.size());
+    }
+    else {
+        reorderMoleculeInfo.initialize<mm_int4>(*this, numMolecules, "reorderMoleculeInfo");
+        reorderMoleculeAtoms.initialize<int>(*this, moleculeAtoms.size(), "reorderMoleculeAtoms");
+    }
+    reorderMoleculeInfo.upload(moleculeInfo);
+    reorderMoleculeAtoms.upload(moleculeAtoms);
+    reorderAtomMolecule.upload(atomMolecule);
+    reorderMoleculeSource.upload(moleculeSource);
+    reorderKeys.clear();
+    reorderSorts.clear();
+    reorderKeys.resize(reorderGroupSize.size());
+    for (int i = 0; i < reorderGroupSize.size(); i++) {
+        reorderKeys[i].initialize<long long>(*this, reorderGroupSize[i], "reorderKeys");
+        reorderSorts.push_back(createSort(new ReorderSortTrait(), reorderGroupSize[i], false));
+    }
 
-        // Reorder the atoms.
+    // Create the kernels.
+
+    map<string, string> defines;
+    defines["WORK_GROUP_SIZE"] = intToString(ThreadBlockSize);
+    if (getNonbondedUtilities().getUsePeriodic())
+        defines["USE_PERIODIC"] = "1";
+    ComputeProgram program = compileProgramOnDemand(CommonKernelSources::reorderAtoms, defines);
+    findRangeKernel = program->createKernel("findPositionRange");
+    findRangeKernel->addArg(numAtoms);
+    findRangeKernel->addArg(getPosq());
+    findRangeKernel->addArg(reorderRange);
+    computeCentersKernel = program->createKernel("computeMoleculeCenters");
+    computeCentersKernel->addArg(numMolecules);
+    computeCentersKernel->addArg(getPosq());
+    computeCentersKernel->addArg(reorderMoleculeInfo);
+    computeCentersKernel->addArg(reorderMoleculeAtoms);
+    computeCentersKernel->addArg(reorderMoleculeCenters);
+    computeCentersKernel->addArg(reorderMoleculeCells);
+    computeCentersKernel->addArg(reorderInvalidPosition);
+    for (int i = 0; i < 5; i++)
+        computeCentersKernel->addArg(); // Periodic box information will be set just before it is executed.
+    computeKeysKernel = program->createKernel("computeMoleculeKeys");
+    computeKeysKernel->addArg(); // The group will be set just before it is executed.
+    computeKeysKernel->addArg();
+    computeKeysKernel->addArg();
+    if (getUseDoublePrecision())
+        computeKeysKernel->addArg(0.2*getNonbondedUtilities().getMaxCutoffDistance());
+    else
+        computeKeysKernel->addArg((float) (0.2*getNonbondedUtilities().getMaxCutoffDistance()));
+    computeKeysKernel->addArg(reorderMoleculeCenters);
+    computeKeysKernel->addArg(reorderRange);
+    computeKeysKernel->addArg();
+    for (int i = 0; i < 5; i++)
+        computeKeysKernel->addArg();
+    recordOrderKernel = program->createKernel("recordMoleculeOrder");
+    recordOrderKernel->addArg();
+    recordOrderKernel->addArg();
+    recordOrderKernel->addArg();
+    recordOrderKernel->addArg(reorderMoleculeSource);
+    applyOrderKernel = program->createKernel("applyAtomOrder");
+    applyOrderKernel->addArg(numAtoms);
+    applyOrderKernel->addArg(paddedNumAtoms);
+    applyOrderKernel->addArg(reorderMoleculeInfo);
+    applyOrderKernel->addArg(reorderAtomMolecule);
+    applyOrderKernel->addArg(reorderMoleculeSource);
+    applyOrderKernel->addArg(reorderMoleculeCells);
+    applyOrderKernel->addArg(reorderOldPosq);
+    applyOrderKernel->addArg(getPosq());
+    if (getUseMixedPrecision()) {
+        applyOrderKernel->addArg(reorderOldPosqCorrection);
+        applyOrderKernel->addArg(getPosqCorrection());
+    }
+    else {
+        applyOrderKernel->addArg(nullptr);
+        applyOrderKernel->addArg(nullptr);
+    }
+    applyOrderKernel->addArg(reorderOldVelm);
+    applyOrderKernel->addArg(getVelm());
+    applyOrderKernel->addArg(reorderOldAtomIndex);
+    applyOrderKernel->addArg(getAtomIndexArray());
+    applyOrderKernel->addArg(reorderOldCellOffsets);
+    applyOrderKernel->addArg(reorderCellOffsets);
+    applyOrderKernel->addArg(reorderPermutation);
+    for (int i = 0; i < 5; i++)
+        applyOrderKernel->addArg();
+    hasInitializedReordering = true;
+}
 
-        for (int i = 0; i < numMolecules; i++) {
-            for (int atom : atoms) {
-                int oldIndex = mol.offsets[molBins[i].second]+atom;
-                int newIndex = mol.offsets[i]+atom;
-                originalIndex[newIndex] = atomIndex[oldIndex];
-                newPosq[newIndex] = oldPosq[oldIndex];
-                if (getUseMixedPrecision())
-                    newPosqCorrection[newIndex] = oldPosqCorrection[oldIndex];
-                newVelm[newIndex] = oldVelm[oldIndex];
-                newCellOffsets[newIndex] = posCellOffsets[oldIndex];
-            }
-        }
+void ComputeContext::reorderAtomsImpl() {
+    ContextSelector selector(*this);
+    if (!hasInitializedReordering)
+        initializeReordering();
+    if (!deviceCellOffsetsAreCurrent) {
+        reorderCellOffsets.upload(posCellOffsets);
+        deviceCellOffsetsAreCurrent = true;
     }
 
-    // Update the arrays.
+    // Find the center of every molecule and the range of positions.
+
+    bool usePeriodic = getNonbondedUtilities().getUsePeriodic();
+    if (!usePeriodic)
+        findRangeKernel->execute(ThreadBlockSize, ThreadBlockSize);
+    setPeriodicBoxArgs(*this, computeCentersKernel, 7);
+    computeCentersKernel->execute(reorderMoleculeInfo.getSize());
+    int invalidPosition;
+    reorderInvalidPosition.download(&invalidPosition);
+    if (invalidPosition) {
+        reorderInvalidPosition.upload(vector<int>(1, 0));
+        throw OpenMMException("Particle coordinate is NaN.  For more information, see https://github.com/openmm/openmm/wiki/Frequently-Asked-Questions#nan");
+    }
 
-    ContextSelector selector(*this);
-    for (int i = 0; i < numAtoms; i++) {
-        atomIndex[i] = originalIndex[i];
-        posCellOffsets[i] = newCellOffsets[i];
+    // Sort each group of identical molecules by their bins along a space filling curve.
+
+    setPeriodicBoxArgs(*this, computeKeysKernel, 7);
+    for (int i = 0; i < reorderKeys.size(); i++) {
+        computeKeysKernel->setArg(0, reorderGroupFirst[i]);
+        computeKeysKernel->setArg(1, reorderGroupSize[i]);
+        computeKeysKernel->setArg(2, reorderGroupHilbert[i]);
+        computeKeysKernel->setArg(6, reorderKeys[i]);
+        computeKeysKernel->execute(reorderGroupSize[i]);
+        reorderSorts[i]->sort(reorderKeys[i]);
+        recordOrderKernel->setArg(0, reorderGroupFirst[i]);
+        recordOrderKernel->setArg(1, reorderGroupSize[i]);
+        recordOrderKernel->setArg(2, reorderKeys[i]);
+        recordOrderKernel->execute(reorderGroupSize[i]);
     }
-    getPosq().upload(newPosq);
+
+    // Move the atoms.
+
+    getPosq().copyTo(reorderOldPosq);
     if (getUseMixedPrecision())
-        getPosqCorrection().upload(newPosqCorrection);
-    getVelm().upload(newVelm);
-    getAtomIndexArray().upload(atomIndex);
+        getPosqCorrection().copyTo(reorderOldPosqCorrection);
+    getVelm().copyTo(reorderOldVelm);
+    getAtomIndexArray().copyTo(reorderOldAtomIndex);
+    reorderCellOffsets.copyTo(reorderOldCellOffsets);
+    setPeriodicBoxArgs(*this, applyOrderKernel, 17);
+    applyOrderKernel->execute(paddedNumAtoms);
+    atomIndexIsOnDevice = true;
+    cellOffsetsAreOnDevice = true;
     for (auto listener : reorderListeners)
         listener->execute();
 }
 
+void ComputeContext::downloadAtomIndex() const {
+    ComputeContext& cc = const_cast<ComputeContext&>(*this);
+    ContextSelector selector(cc);
+    cc.getAtomIndexArray().download(atomIndex);
+    atomIndexIsOnDevice = false;
+}
+
+void ComputeContext::downloadPosCellOffsets() const {
+    ComputeContext& cc = const_cast<ComputeContext&>(*this);
+    ContextSelector selector(cc);
+    cc.reorderCellOffsets.download(posCellOffsets);
+    cellOffsetsAreOnDevice = false;
+}
+
 void ComputeContext::addReorderListener(ReorderListener* listener) {
     reorderListeners.push_back(listener);
 }
@@ -691,21 +780,112 @@ void ComputeContext::addPostComputation(ForcePostComputation* computation) {
     postComputations.push_back(computation);
 }
 
+FFT3D ComputeContext::createFFT(int xsize, int ysize, int zsize, bool realToComplex) {
+    vector<string> backends = getFFTBackends(xsize, ysize, zsize, realToComplex);
+    if (backends.size() == 0)
+        throw OpenMMException("No FFT implementation supports a grid of size "+intToString(xsize)+"x"+intToString(ysize)+"x"+intToString(zsize));
+    string backend = backends[0];
+    if (backends.size() > 1)
+        backend = selectFFTBackend(backends, xsize, ysize, zsize, realToComplex);
+    return createFFTWithBackend(backend, xsize, ysize, zsize, realToComplex);
+}
+
+string ComputeContext::selectFFTBackend(const vector<string>& backends, int xsize, int ysize, int zsize, bool realToComplex) {
+    // See if we have already benchmarked this grid shape on an identical device.
+
+    static map<string, string> selectedBackends;
+    static mutex selectedBackendsLock;
+    stringstream key;
+    key<<getDeviceName()<<" "<<getUseDoublePrecision()<<" "<<xsize<<" "<<ysize<<" "<<zsize<<" "<<realToComplex;
+    for (const string& backend : backends)
+        key<<" "<<backend;
+    {
+        lock_guard<mutex> lock(selectedBackendsLock);
+        auto selected = selectedBackends.find(key.str());
+        if (selected != selectedBackends.end())
+            return selected->second;
+    }
+
+    // Time a forward and inverse transform with each implementation.  The first pair is not
+    // timed, since it may include one time costs like compiling kernels.
+
+    ContextSelector selector(*this);
+    int elementSize = (getUseDoublePrecision() ? sizeof(double) : sizeof(float));
+    ComputeArray in, out;
+    in.initialize(*this, xsize*ysize*zsize, 2*elementSize, "fftBenchmarkIn");
+    out.initialize(*this, xsize*ysize*zsize, 2*elementSize, "fftBenchmarkOut");
+    clearBuffer(in);
+    clearBuffer(out);
+    const int numRepetitions = 5;
+    string fastest = backends[0];
+    double fastestTime = 0.0;
+    for (const string& backend : backends) {
+        FFT3D fft;
+        try {
+            fft = createFFTWithBackend(backend, xsize, ysize, zsize, realToComplex);
+        }
+        catch (OpenMMException& ex) {
+            // This implementation cannot handle the grid after all, so skip it.
+
+            continue;
+        }
+        fft->execFFT(in, out, true);
+        fft->execFFT(in, out, false);
+        ComputeEvent start = createTimingEvent();
+        ComputeEvent end = createTimingEvent();
+        start->enqueue();
+        for (int i = 0; i < numRepetitions; i++) {
+            fft->execFFT(in, out, true);
+            fft->execFFT(in, out, false);
+        }
+        end->enqueue();
+        end->wait();
+        double elapsed = end->getElapsedTime(*start);
+        if (fastestTime == 0.0 || elapsed < fastestTime) {
+            fastest = backend;
+            fastestTime = elapsed;
+        }
+    }
+    lock_guard<mutex> lock(selectedBackendsLock);
+    selectedBackends[key.str()] = fastest;
+    return fastest;
+}
+
 int ComputeContext::findLegalFFTDimension(int minimum) {
+    return findFastFFTDimension(minimum, 7);
+}
+
+int ComputeContext::findFastFFTDimension(int minimum, int maxFactor) {
     if (minimum < 1)
         return 1;
-    while (true) {
+
+    // The estimated cost per element of each prime radix, relative to the cost of radix 2.  The
+    // cost of transforming a dimension of size n is n times the sum over its prime factors.
+
+    const double radixCost[] = {0, 0, 1.0, 1.75, 0, 2.8, 0, 3.9, 0, 0, 0, 6.1, 0, 7.2};
+    int maxSize = minimum + minimum/20;
+    int best = -1;
+    double bestCost = 0.0;
+    for (int size = minimum; best == -1 || size <= maxSize; size++) {
         // Attempt to factor the current value.
 
-        int unfactored = minimum;
-        for (int factor = 2; factor < 8; factor++) {
-            while (unfactored > 1 && unfactored%factor == 0)
+        int unfactored = size;
+        double cost = 0.0;
+        for (int factor = 2; factor <= maxFactor; factor++) {
+            while (unfactored > 1 && unfactored%factor == 0) {
                 unfactored /= factor;
+                cost += (factor < 14 ? radixCost[factor] : factor);
+            }
+        }
+        if (unfactored != 1)
+            continue;
+        cost *= size;
+        if (best == -1 || cost < bestCost) {
+            best = size;
+            bestCost = cost;
         }
-        if (unfactored == 1)
-            return minimum;
-        minimum++;
     }
+    return best;
 }
 
 int ComputeContext::registerGlobalParam(const string& name) {
@@ -737,6 +917,253 @@ void ComputeContext::updateGlobalParamValues() {
         getGlobalParamValues().upload(lastGlobalParamValues, true);
 }
 
+void ComputeContext::startProfilingInterval() {
+    ComputeEvent event;
+    if (unusedTimingEvents.size() > 0) {
+        event = unusedTimingEvents.back();
+        unusedTimingEvents.pop_back();
+    }
+    else
+        event = createTimingEvent();
+    event->enqueue();
+    profilingStack.push_back(event);
+}
+
+void ComputeContext::endProfilingInterval(const string& name) {
+    if (profilingStack.size() == 0)
+        throw OpenMMException("endProfilingInterval() called without a matching call to startProfilingInterval()");
+    ProfilingInterval interval;
+    interval.name = name;
+    interval.start = profilingStack.back();
+    profilingStack.pop_back();
+    if (unusedTimingEvents.size() > 0) {
+        interval.end = unusedTimingEvents.back();
+        unusedTimingEvents.pop_back();
+    }
+    else
+        interval.end = createTimingEvent();
+    interval.end->enqueue();
+    pendingProfilingIntervals.push_back(interval);
+
+    // Process the intervals periodically so the number of events in flight stays bounded.
+
+    if (pendingProfilingIntervals.size() >= 1000)
+        processProfilingIntervals();
+}
+
+void ComputeContext::recordProfilingTime(const string& name, double microseconds) {
+    pair<int, double>& times = profilingTimes[name];
+    times.first++;
+    times.second += microseconds;
+}
+
+void ComputeContext::processProfilingIntervals() {
+    for (ProfilingInterval& interval : pendingProfilingIntervals) {
+        interval.end->wait();
+        pair<int, double>& times = profilingTimes[interval.name];
+        times.first++;
+        times.second += 1000.0*interval.end->getElapsedTime(*interval.start);
+        unusedTimingEvents.push_back(interval.start);
+        unusedTimingEvents.push_back(interval.end);
+    }
+    pendingProfilingIntervals.clear();
+}
+
+string ComputeContext::getForceGroupsProfilingName(int groups) {
+    if (groups == -1)
+        return "All force groups";
+    stringstream name;
+    int count = 0;
+    for (int i = 0; i < 32; i++)
+        if ((groups & (1<<i)) != 0) {
+            name << (count == 0 ? "" : ",") << i;
+            count++;
+        }
+    return (count == 1 ? "Force group " : "Force groups ")+name.str();
+}
+
+const map<string, pair<int, double> >& ComputeContext::getProfilingTimes() {
+    processProfilingIntervals();
+    return profilingTimes;
+}
+
+void ComputeContext::resetProfilingTimes() {
+    processProfilingIntervals();
+    profilingTimes.clear();
+}
+
+void ComputeContext::recordArrayAllocation(const ArrayInterface& array, size_t bytes) {
+    unique_lock<mutex> lock(arrayMemoryLock);
+    auto record = arrayMemory.find(&array);
+    long long previousBytes = (record == arrayMemory.end() ? 0 : record->second.bytes);
+    if (memoryBudget > 0 && arrayMemoryTotal-previousBytes+(long long) bytes > memoryBudget) {
+        string owner = (record == arrayMemory.end() ? "" : record->second.owner);
+        if (owner.size() == 0) {
+            const Force* force = getContextImpl()->getInitializingForce();
+            owner = (force == NULL ? "Context" : force->getName());
+        }
+        lock.unlock();
+        stringstream message;
+        message<<fixed<<setprecision(1);
+        message<<"Allocating "<<bytes/1048576.0<<" MB for array "<<array.getName()<<" ("<<owner<<") would exceed the memory budget of ";
+        message<<memoryBudget/1048576.0<<" MB.  "<<getMemoryUsageReport();
+        throw OpenMMException(message.str());
+    }
+    if (record == arrayMemory.end()) {
+        ArrayMemory& memory = arrayMemory[&array];
+        const Force* force = getContextImpl()->getInitializingForce();
+        memory.owner = (force == NULL ? "Context" : force->getName());
+        memory.bytes = bytes;
+    }
+    else
+        record->second.bytes = bytes;
+    arrayMemoryTotal += (long long) bytes-previousBytes;
+}
+
+void ComputeContext::recordArrayRelease(const ArrayInterface& array) {
+    lock_guard<mutex> lock(arrayMemoryLock);
+    auto record = arrayMemory.find(&array);
+    if (record != arrayMemory.end()) {
+        arrayMemoryTotal -= record->second.bytes;
+        arrayMemory.erase(record);
+    }
+}
+
+map<string, map<string, long long> > ComputeContext::getMemoryUsage() {
+    lock_guard<mutex> lock(arrayMemoryLock);
+    map<string, map<string, long long> > usage;
+    for (auto& record : arrayMemory)
+        usage[record.second.owner][record.first->getName()] += record.second.bytes;
+    return usage;
+}
+
+string ComputeContext::getMemoryUsageReport() {
+    // Sort the owners, and the arrays for each owner, in order of decreasing memory use.
+
+    map<string, map<string, long long> > usage = getMemoryUsage();
+    vector<pair<long long, string> > owners;
+    long long total = 0;
+    for (auto& owner : usage) {
+        long long ownerTotal = 0;
+        for (auto& array : owner.second)
+            ownerTotal += array.second;
+        owners.push_back(make_pair(ownerTotal, owner.first));
+        total += ownerTotal;
+    }
+    sort(owners.rbegin(), owners.rend());
+    stringstream report;
+    report<<fixed<<setprecision(1);
+    report<<"Device memory used by arrays: "<<total/1048576.0<<" MB";
+    for (auto& owner : owners) {
+        report<<"\n  "<<owner.second<<": "<<owner.first/1048576.0<<" MB";
+        vector<pair<long long, string> > arrays;
+        for (auto& array : usage[owner.second])
+            arrays.push_back(make_pair(array.second, array.first));
+        sort(arrays.rbegin(), arrays.rend());
+        for (auto& array : arrays)
+            report<<"\n    "<<array.second<<": "<<array.first/1048576.0<<" MB";
+    }
+    return report.str();
+}
+
+void ComputeContext::enableSharedArrays(ComputeContext* original) {
+    if (sharedArrays != NULL)
+        return;
+    if (original != NULL && original->sharedArrays != NULL) {
+        sharedArrays = original->sharedArrays;
+        ownsSharedArrays = false;
+    }
+    else {
+        sharedArrays = new SharedArrayCache();
+        sharedArrays->owner = this;
+        ownsSharedArrays = true;
+    }
+}
+
+void ComputeContext::releaseSharedArrays() {
+    if (sharedArrays != NULL && ownsSharedArrays) {
+        for (auto& entry : sharedArrays->arrays)
+            for (SharedArray& array : entry.second)
+                delete array.storage;
+        delete sharedArrays;
+    }
+    sharedArrays = NULL;
+    ownsSharedArrays = false;
+}
+
+void ComputeContext::initializeSharedArray(ArrayInterface& array, size_t size, int elementSize, const void* data, const string& name) {
+    if (sharedArrays == NULL || size == 0) {
+        array.initialize(*this, size, elementSize, name);
+        if (size > 0)
+            array.upload(data, true);
+        return;
+    }
+
+    // Look for an existing array with the same name and contents.  If there is none, the
+    // owner of the cache creates one, so it stays valid as long as any context can use it.
+
+    lock_guard<mutex> lock(sharedArrays->lock);
+    stringstream key;
+    key<<name<<':'<<size<<':'<<elementSize;
+    vector<SharedArray>& candidates = sharedArrays->arrays[key.str()];
+    const char* bytes = reinterpret_cast<const char*>(data);
+    size_t numBytes = size*elementSize;
+    ArrayInterface* storage = NULL;
+    for (SharedArray& candidate : candidates)
+        if (memcmp(candidate.data.data(), bytes, numBytes) == 0) {
+            storage = candidate.storage;
+            break;
+        }
+    if (storage == NULL) {
+        ComputeContext& owner = *sharedArrays->owner;
+        SharedArray shared;
+        shared.data.assign(bytes, bytes+numBytes);
+        shared.storage = owner.createArray();
+        try {
+            shared.storage->initialize(owner, size, elementSize, name);
+            shared.storage->upload(data, true);
+        }
+        catch (...) {
+            delete shared.storage;
+            throw;
+        }
+        candidates.push_back(shared);
+        storage = shared.storage;
+    }
+    array.initializeShared(*this, *storage, name);
+}
+
+bool ComputeContext::getSystemSupportsGraphCapture() {
+    // Only allow Forces whose kernels are known to queue the same work on every step without
+    // reading anything back from the device.  Others (for example, ones that iterate until
+    // convergence or hand data to the CPU) make capture unsafe.
+
+    if (getProfilingEnabled() || getIntegrationUtilities().getConstraintsRequireHostSync())
+        return false;
+    for (int i = 0; i < system.getNumForces(); i++) {
+        const Force& force = system.getForce(i);
+        if (dynamic_cast<const HarmonicBondForce*>(&force) == NULL &&
+                dynamic_cast<const HarmonicAngleForce*>(&force) == NULL &&
+                dynamic_cast<const PeriodicTorsionForce*>(&force) == NULL &&
+                dynamic_cast<const RBTorsionForce*>(&force) == NULL &&
+                dynamic_cast<const CMAPTorsionForce*>(&force) == NULL &&
+                dynamic_cast<const CustomBondForce*>(&force) == NULL &&
+                dynamic_cast<const CustomAngleForce*>(&force) == NULL &&
+                dynamic_cast<const CustomTorsionForce*>(&force) == NULL &&
+                dynamic_cast<const CustomExternalForce*>(&force) == NULL &&
+                dynamic_cast<const NonbondedForce*>(&force) == NULL &&
+                dynamic_cast<const GBSAOBCForce*>(&force) == NULL &&
+                dynamic_cast<const CMMotionRemover*>(&force) == NULL &&
+                dynamic_cast<const AndersenThermostat*>(&force) == NULL &&
+                dynamic_cast<const MonteCarloBarostat*>(&force) == NULL &&
+                dynamic_cast<const MonteCarloAnisotropicBarostat*>(&force) == NULL &&
+                dynamic_cast<const MonteCarloFlexibleBarostat*>(&force) == NULL &&
+                dynamic_cast<const MonteCarloMembraneBarostat*>(&force) == NULL)
+            return false;
+    }
+    return true;
+}
+
 struct ComputeContext::WorkThread::ThreadData {
     ThreadData(std::queue<ComputeContext::WorkTask*>& tasks, bool& waiting,  bool& finished, bool& threwException, OpenMMException& stashedException,
             mutex& queueLock, condition_variable& waitForTaskCondition, condition_variable& queueEmptyCondition) :
@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2009-2024 Stanford University and the Authors.      *
+ * Portions copyright (c) 2009-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -969,6 +969,31 @@ vector<float> ExpressionUtilities::computeFunctionCoefficients(const TabulatedFu
     throw OpenMMException("computeFunctionCoefficients: Unknown function type");
 }
 
+void ExpressionUtilities::updateFunctionCoefficients(const TabulatedFunction& function, ArrayInterface& array, vector<float>& previous) {
+    int width;
+    vector<float> f = computeFunctionCoefficients(function, width);
+    if (f.size() != previous.size()) {
+        array.upload(f);
+        previous = f;
+        return;
+    }
+
+    // Find the range of elements that have changed.
+
+    int size = f.size();
+    int first = 0, last = size-1;
+    while (first < size && f[first] == previous[first])
+        first++;
+    if (first == size)
+        return;
+    while (f[last] == previous[last])
+        last--;
+    first /= width;
+    last /= width;
+    array.uploadSubArray(&f[first*width], first, last-first+1);
+    previous.swap(f);
+}
+
 vector<vector<double> > ExpressionUtilities::computeFunctionParameters(const vector<const TabulatedFunction*>& functions) {
     vector<vector<double> > params(functions.size());
     for (int i = 0; i < (int) functions.size(); i++) {
@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2009-2025 Stanford University and the Authors.      *
+ * Portions copyright (c) 2009-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -42,6 +42,44 @@
 using namespace OpenMM;
 using namespace std;
 
+// The expansion order and number of rotational corrections used by LINCS.  These are fixed, rather than
+// chosen from the constraint tolerance, so applying constraints never requires checking for convergence.
+
+static const int LincsOrder = 4;
+static const int LincsIterations = 2;
+
+/**
+ * Express a three particle average or out of plane site in the form a*p1 + b*(p2-p1) + c*(p3-p1) + d*((p2-p1) x (p3-p1)),
+ * which is used for the sites that are processed in groups.
+ */
+static mm_double4 getWaterSiteWeights(const VirtualSite& site) {
+    const ThreeParticleAverageSite* average = dynamic_cast<const ThreeParticleAverageSite*>(&site);
+    if (average != NULL)
+        return mm_double4(average->getWeight(0)+average->getWeight(1)+average->getWeight(2), average->getWeight(1), average->getWeight(2), 0.0);
+    const OutOfPlaneSite& outOfPlane = dynamic_cast<const OutOfPlaneSite&>(site);
+    return mm_double4(1.0, outOfPlane.getWeight12(), outOfPlane.getWeight13(), outOfPlane.getWeightCross());
+}
+
+/**
+ * Sort a list of virtual sites by their first parent atom, so sites that are processed together
+ * access nearby memory.
+ */
+template <class T>
+static void sortSitesByParent(vector<mm_int4>& atoms, vector<T>& weights) {
+    vector<int> order(atoms.size());
+    for (int i = 0; i < order.size(); i++)
+        order[i] = i;
+    stable_sort(order.begin(), order.end(), [&atoms] (int a, int b) { return atoms[a].y < atoms[b].y; });
+    vector<mm_int4> sortedAtoms(atoms.size());
+    vector<T> sortedWeights(weights.size());
+    for (int i = 0; i < order.size(); i++) {
+        sortedAtoms[i] = atoms[order[i]];
+        sortedWeights[i] = weights[order[i]];
+    }
+    atoms = sortedAtoms;
+    weights = sortedWeights;
+}
+
 struct IntegrationUtilities::ShakeCluster {
     int centralID;
     int peripheralID[3];
@@ -90,8 +128,8 @@ struct IntegrationUtilities::ConstraintOrderer {
     }
 };
 
-IntegrationUtilities::IntegrationUtilities(ComputeContext& context, const System& system) : context(context),
-        randomPos(0), hasOverlappingVsites(false) {
+IntegrationUtilities::IntegrationUtilities(ComputeContext& context, const System& system, bool useLincs) : context(context),
+        randomPos(0), randomCounter(0), deviceStepSize(0), hasOverlappingVsites(false), useLincs(useLincs), cmMomentum(NULL), cmMomentumStep(-1) {
     // Create workspace arrays.
 
     lastStepSize = mm_double2(0.0, 0.0);
@@ -301,38 +339,43 @@ IntegrationUtilities::IntegrationUtilities(ComputeContext& context, const System
     int numCCMA = (int) ccmaConstraints.size();
     int numCCMAAtoms = 0;
     if (numCCMA > 0) {
-        // Record information needed by ReferenceCCMAAlgorithm.
-        
-        vector<pair<int, int> > refIndices(numCCMA);
-        vector<double> refDistance(numCCMA);
-        for (int i = 0; i < numCCMA; i++) {
-            int index = ccmaConstraints[i];
-            refIndices[i] = make_pair(atom1[index], atom2[index]);
-            refDistance[i] = distance[index];
-        }
-        vector<double> refMasses(numAtoms);
-        for (int i = 0; i < numAtoms; ++i)
-            refMasses[i] = system.getParticleMass(i);
-
-        // Look up angles for CCMA.
-        
-        vector<ReferenceCCMAAlgorithm::AngleInfo> angles;
-        for (int i = 0; i < system.getNumForces(); i++) {
-            const HarmonicAngleForce* force = dynamic_cast<const HarmonicAngleForce*>(&system.getForce(i));
-            if (force != NULL) {
-                for (int j = 0; j < force->getNumAngles(); j++) {
-                    int atom1, atom2, atom3;
-                    double angle, k;
-                    force->getAngleParameters(j, atom1, atom2, atom3, angle, k);
-                    angles.push_back(ReferenceCCMAAlgorithm::AngleInfo(atom1, atom2, atom3, angle));
+        // LINCS builds its own coupling matrix below, so only CCMA needs the inverted constraint matrix.
+
+        vector<vector<pair<int, double> > > matrix(numCCMA);
+        if (!useLincs) {
+            // Record information needed by ReferenceCCMAAlgorithm.
+
+            vector<pair<int, int> > refIndices(numCCMA);
+            vector<double> refDistance(numCCMA);
+            for (int i = 0; i < numCCMA; i++) {
+                int index = ccmaConstraints[i];
+                refIndices[i] = make_pair(atom1[index], atom2[index]);
+                refDistance[i] = distance[index];
+            }
+            vector<double> refMasses(numAtoms);
+            for (int i = 0; i < numAtoms; ++i)
+                refMasses[i] = system.getParticleMass(i);
+
+            // Look up angles for CCMA.
+
+            vector<ReferenceCCMAAlgorithm::AngleInfo> angles;
+            for (int i = 0; i < system.getNumForces(); i++) {
+                const HarmonicAngleForce* force = dynamic_cast<const HarmonicAngleForce*>(&system.getForce(i));
+                if (force != NULL) {
+                    for (int j = 0; j < force->getNumAngles(); j++) {
+                        int atom1, atom2, atom3;
+                        double angle, k;
+                        force->getAngleParameters(j, atom1, atom2, atom3, angle, k);
+                        angles.push_back(ReferenceCCMAAlgorithm::AngleInfo(atom1, atom2, atom3, angle));
+                    }
                 }
             }
+
+            // Create a ReferenceCCMAAlgorithm.  It will build and invert the constraint matrix for us.
+
+            ReferenceCCMAAlgorithm ccma(numAtoms, numCCMA, refIndices, refDistance, refMasses, angles, 0.1);
+            matrix = ccma.getMatrix();
         }
-        
-        // Create a ReferenceCCMAAlgorithm.  It will build and invert the constraint matrix for us.
-        
-        ReferenceCCMAAlgorithm ccma(numAtoms, numCCMA, refIndices, refDistance, refMasses, angles, 0.1);
-        vector<vector<pair<int, double> > > matrix = ccma.getMatrix();
         int maxRowElements = 0;
         for (unsigned i = 0; i < matrix.size(); i++)
             maxRowElements = max(maxRowElements, (int) matrix[i].size());
@@ -422,9 +465,97 @@ IntegrationUtilities::IntegrationUtilities(ComputeContext& context, const System
         ccmaAtomConstraints.upload(atomConstraintsVec);
         ccmaNumAtomConstraints.upload(numAtomConstraintsVec);
         ccmaConstraintMatrixColumn.upload(constraintMatrixColumnVec);
+        if (useLincs) {
+            // Record the LINCS coupling coefficients.  Two constraints are coupled when they share an
+            // atom.  The coefficient depends on that atom's inverse mass and on whether it is at the same
+            // end of both constraints.  It gets multiplied by the dot product of their directions each step.
+
+            vector<double> invMass(numAtoms);
+            for (int i = 0; i < numAtoms; i++) {
+                double mass = system.getParticleMass(i);
+                invMass[i] = (mass == 0.0 ? 0.0 : 1.0/mass);
+            }
+            vector<double> sVec(numCCMA);
+            for (int i = 0; i < numCCMA; i++) {
+                int c = ccmaConstraints[constraintOrder[i]];
+                sVec[i] = 1.0/sqrt(invMass[atom1[c]]+invMass[atom2[c]]);
+            }
+            vector<vector<pair<int, double> > > coupling(numCCMA);
+            for (int atom = 0; atom < numAtoms; atom++)
+                for (int j = 0; j < atomConstraints[atom].size(); j++)
+                    for (int k = 0; k < j; k++) {
+                        int c1 = inverseOrder[atomConstraints[atom][j]];
+                        int c2 = inverseOrder[atomConstraints[atom][k]];
+                        bool sameEnd = ((atom1[ccmaConstraints[atomConstraints[atom][j]]] == atom) == (atom1[ccmaConstraints[atomConstraints[atom][k]]] == atom));
+                        double coeff = (sameEnd ? -1.0 : 1.0)*invMass[atom]*sVec[c1]*sVec[c2];
+                        coupling[c1].push_back(make_pair(c2, coeff));
+                        coupling[c2].push_back(make_pair(c1, coeff));
+                    }
+            int maxCoupled = 0;
+            for (int i = 0; i < numCCMA; i++)
+                maxCoupled = max(maxCoupled, (int) coupling[i].size());
+            maxCoupled++;
+            vector<int> coupledVec(numCCMA*maxCoupled, numCCMA);
+            vector<double> coefficientVec(numCCMA*maxCoupled, 0.0);
+            for (int i = 0; i < numCCMA; i++)
+                for (int j = 0; j < coupling[i].size(); j++) {
+                    coupledVec[i+j*numCCMA] = coupling[i][j].first;
+                    coefficientVec[i+j*numCCMA] = coupling[i][j].second;
+                }
+            lincsCoupledConstraints.initialize<int>(context, coupledVec.size(), "lincsCoupledConstraints");
+            lincsCouplingCoefficients.initialize(context, coefficientVec.size(), elementSize, "lincsCouplingCoefficients");
+            lincsCouplingMatrix.initialize(context, coefficientVec.size(), elementSize, "lincsCouplingMatrix");
+            lincsS.initialize(context, numCCMA, elementSize, "lincsS");
+            lincsRhs1.initialize(context, numCCMA, elementSize, "lincsRhs1");
+            lincsRhs2.initialize(context, numCCMA, elementSize, "lincsRhs2");
+            lincsSolution.initialize(context, numCCMA, elementSize, "lincsSolution");
+            lincsCoupledConstraints.upload(coupledVec);
+            lincsCouplingCoefficients.upload(coefficientVec, true);
+            lincsS.upload(sVec, true);
+        }
     }
     
-    // Build the list of virtual sites.
+    // Find groups of at most two sites that are built from the same three parent atoms, with no
+    // other site depending on those atoms.  This covers the extra sites of water models like
+    // TIP4P and TIP5P.  Each group is processed by a single thread, so its forces can be
+    // distributed without atomic operations.
+
+    vector<int> atomCounts(numAtoms, 0);
+    map<vector<int>, vector<int> > parentSites;
+    for (int i = 0; i < numAtoms; i++) {
+        if (!system.isVirtualSite(i))
+            continue;
+        const VirtualSite& site = system.getVirtualSite(i);
+        for (int j = 0; j < site.getNumParticles(); j++)
+            atomCounts[site.getParticle(j)]++;
+        if (dynamic_cast<const ThreeParticleAverageSite*>(&site) == NULL && dynamic_cast<const OutOfPlaneSite*>(&site) == NULL)
+            continue;
+        vector<int> parents = {site.getParticle(0), site.getParticle(1), site.getParticle(2)};
+        if (!system.isVirtualSite(parents[0]) && !system.isVirtualSite(parents[1]) && !system.isVirtualSite(parents[2]))
+            parentSites[parents].push_back(i);
+    }
+    vector<bool> isWaterSite(numAtoms, false);
+    vector<mm_int4> vsiteWaterAtomVec;
+    vector<int> vsiteWaterSecondSiteVec;
+    vector<mm_double4> vsiteWaterWeightVec;
+    for (auto& group : parentSites) {
+        const vector<int>& parents = group.first;
+        const vector<int>& groupSites = group.second;
+        bool exclusive = (groupSites.size() <= 2);
+        for (int parent : parents)
+            if (atomCounts[parent] != groupSites.size())
+                exclusive = false;
+        if (!exclusive)
+            continue;
+        vsiteWaterAtomVec.push_back(mm_int4(groupSites[0], parents[0], parents[1], parents[2]));
+        vsiteWaterSecondSiteVec.push_back(groupSites.size() > 1 ? groupSites[1] : -1);
+        for (int j = 0; j < 2; j++)
+            vsiteWaterWeightVec.push_back(j < groupSites.size() ? getWaterSiteWeights(system.getVirtualSite(groupSites[j])) : mm_double4(0.0, 0.0, 0.0, 0.0));
+        for (int site : groupSites)
+            isWaterSite[site] = true;
+    }
+
+    // Build the list of other virtual sites.
     
     vector<mm_int4> vsite2AvgAtomVec;
     vector<mm_double2> vsite2AvgWeightVec;
@@ -438,7 +569,7 @@ IntegrationUtilities::IntegrationUtilities(ComputeContext& context, const System
     vector<double> vsiteLocalCoordsWeightVec;
     vector<mm_double4> vsiteLocalCoordsPosVec;
     for (int i = 0; i < numAtoms; i++) {
-        if (system.isVirtualSite(i)) {
+        if (system.isVirtualSite(i) && !isWaterSite[i]) {
             if (dynamic_cast<const TwoParticleAverageSite*>(&system.getVirtualSite(i)) != NULL) {
                 // A two particle average.
                 
@@ -483,17 +614,23 @@ IntegrationUtilities::IntegrationUtilities(ComputeContext& context, const System
         }
     }
     vsiteLocalCoordsStartVec.push_back(vsiteLocalCoordsAtomVec.size());
+    sortSitesByParent(vsite2AvgAtomVec, vsite2AvgWeightVec);
+    sortSitesByParent(vsite3AvgAtomVec, vsite3AvgWeightVec);
+    sortSitesByParent(vsiteOutOfPlaneAtomVec, vsiteOutOfPlaneWeightVec);
     int num2Avg = vsite2AvgAtomVec.size();
     int num3Avg = vsite3AvgAtomVec.size();
     int numOutOfPlane = vsiteOutOfPlaneAtomVec.size();
     int numLocalCoords = vsiteLocalCoordsPosVec.size();
-    numVsites = num2Avg+num3Avg+numOutOfPlane+numLocalCoords;
+    int numWaterGroups = vsiteWaterAtomVec.size();
+    numVsites = num2Avg+num3Avg+numOutOfPlane+numLocalCoords+numWaterGroups;
     vsite2AvgAtoms.initialize<mm_int4>(context, max(1, num2Avg), "vsite2AvgAtoms");
     vsite3AvgAtoms.initialize<mm_int4>(context, max(1, num3Avg), "vsite3AvgAtoms");
     vsiteOutOfPlaneAtoms.initialize<mm_int4>(context, max(1, numOutOfPlane), "vsiteOutOfPlaneAtoms");
     vsiteLocalCoordsIndex.initialize<int>(context, max(1, (int) vsiteLocalCoordsIndexVec.size()), "vsiteLocalCoordsIndex");
     vsiteLocalCoordsAtoms.initialize<int>(context, max(1, (int) vsiteLocalCoordsAtomVec.size()), "vsiteLocalCoordsAtoms");
     vsiteLocalCoordsStartIndex.initialize<int>(context, max(1, (int) vsiteLocalCoordsStartVec.size()), "vsiteLocalCoordsStartIndex");
+    vsiteWaterAtoms.initialize<mm_int4>(context, max(1, numWaterGroups), "vsiteWaterAtoms");
+    vsiteWaterSecondSite.initialize<int>(context, max(1, numWaterGroups), "vsiteWaterSecondSite");
     if (num2Avg > 0)
         vsite2AvgAtoms.upload(vsite2AvgAtomVec);
     if (num3Avg > 0)
@@ -505,12 +642,17 @@ IntegrationUtilities::IntegrationUtilities(ComputeContext& context, const System
         vsiteLocalCoordsAtoms.upload(vsiteLocalCoordsAtomVec);
         vsiteLocalCoordsStartIndex.upload(vsiteLocalCoordsStartVec);
     }
+    if (numWaterGroups > 0) {
+        vsiteWaterAtoms.upload(vsiteWaterAtomVec);
+        vsiteWaterSecondSite.upload(vsiteWaterSecondSiteVec);
+    }
     int elementSize = (context.getUseDoublePrecision() ? sizeof(double) : sizeof(float));
     vsite2AvgWeights.initialize(context, max(1, num2Avg), 2*elementSize, "vsite2AvgWeights");
     vsite3AvgWeights.initialize(context, max(1, num3Avg), 4*elementSize, "vsite3AvgWeights");
     vsiteOutOfPlaneWeights.initialize(context, max(1, numOutOfPlane), 4*elementSize, "vsiteOutOfPlaneWeights");
     vsiteLocalCoordsWeights.initialize(context, max(1, (int) vsiteLocalCoordsWeightVec.size()), elementSize, "vsiteLocalCoordsWeights");
     vsiteLocalCoordsPos.initialize(context, max(1, (int) vsiteLocalCoordsPosVec.size()), 4*elementSize, "vsiteLocalCoordsPos");
+    vsiteWaterWeights.initialize(context, max(2, 2*numWaterGroups), 4*elementSize, "vsiteWaterWeights");
     if (num2Avg > 0)
         vsite2AvgWeights.upload(vsite2AvgWeightVec, true);
     if (num3Avg > 0)
@@ -521,13 +663,15 @@ IntegrationUtilities::IntegrationUtilities(ComputeContext& context, const System
         vsiteLocalCoordsWeights.upload(vsiteLocalCoordsWeightVec, true);
         vsiteLocalCoordsPos.upload(vsiteLocalCoordsPosVec, true);
     }
+    if (numWaterGroups > 0)
+        vsiteWaterWeights.upload(vsiteWaterWeightVec, true);
 
     // If multiple virtual sites depend on the same particle, make sure the force distribution
-    // can be done safely.
+    // can be done safely.  Sites in the water groups never share parents with other groups.
     
-    vector<int> atomCounts(numAtoms, 0);
+    fill(atomCounts.begin(), atomCounts.end(), 0);
     for (int i = 0; i < numAtoms; i++)
-        if (system.isVirtualSite(i))
+        if (system.isVirtualSite(i) && !isWaterSite[i])
             for (int j = 0; j < system.getVirtualSite(i).getNumParticles(); j++)
                 atomCounts[system.getVirtualSite(i).getParticle(j)]++;
     for (int i = 0; i < numAtoms; i++)
@@ -577,6 +721,7 @@ IntegrationUtilities::IntegrationUtilities(ComputeContext& context, const System
     defines["NUM_3_AVERAGE"] = context.intToString(num3Avg);
     defines["NUM_OUT_OF_PLANE"] = context.intToString(numOutOfPlane);
     defines["NUM_LOCAL_COORDS"] = context.intToString(numLocalCoords);
+    defines["NUM_WATER_VSITE_GROUPS"] = context.intToString(numWaterGroups);
     defines["PADDED_NUM_ATOMS"] = context.intToString(context.getPaddedNumAtoms());
     defines["KE_WORK_GROUP_SIZE"] = context.intToString(keWorkGroupSize);
     if (hasOverlappingVsites)
@@ -594,6 +739,11 @@ IntegrationUtilities::IntegrationUtilities(ComputeContext& context, const System
     ccmaMultiplyKernel = program->createKernel("multiplyByCCMAConstraintMatrixKernel");
     ccmaUpdateKernel = program->createKernel("updateCCMAAtomPositionsKernel");
     ccmaFullKernel = program->createKernel("runCCMA");
+    lincsDirectionsKernel = program->createKernel("computeLincsDirections");
+    lincsMatrixKernel = program->createKernel("computeLincsMatrix");
+    lincsMultiplyKernel = program->createKernel("multiplyByLincsMatrix");
+    lincsUpdateKernel = program->createKernel("updateLincsAtoms");
+    lincsCorrectionKernel = program->createKernel("computeLincsCorrection");
     vsitePositionKernel = program->createKernel("computeVirtualSites");
     vsiteForceKernel = program->createKernel("distributeVirtualSiteForces");
     vsiteSaveForcesKernel = program->createKernel("saveDistributedForces");
@@ -621,6 +771,9 @@ IntegrationUtilities::IntegrationUtilities(ComputeContext& context, const System
     vsitePositionKernel->addArg(vsiteLocalCoordsStartIndex);
     vsitePositionKernel->addArg(vsiteStage);
     vsitePositionKernel->addArg();
+    vsitePositionKernel->addArg(vsiteWaterAtoms);
+    vsitePositionKernel->addArg(vsiteWaterSecondSite);
+    vsitePositionKernel->addArg(vsiteWaterWeights);
     vsiteForceKernel->addArg(context.getPosq());
     if (context.getUseMixedPrecision())
         vsiteForceKernel->addArg(context.getPosqCorrection());
@@ -640,6 +793,9 @@ IntegrationUtilities::IntegrationUtilities(ComputeContext& context, const System
     vsiteForceKernel->addArg(vsiteLocalCoordsStartIndex);
     vsiteForceKernel->addArg(vsiteStage);
     vsiteForceKernel->addArg();
+    vsiteForceKernel->addArg(vsiteWaterAtoms);
+    vsiteForceKernel->addArg(vsiteWaterSecondSite);
+    vsiteForceKernel->addArg(vsiteWaterWeights);
     for (int i = 0; i < 3; i++)
         vsiteSaveForcesKernel->addArg();
 
@@ -742,6 +898,45 @@ IntegrationUtilities::IntegrationUtilities(ComputeContext& context, const System
         if (context.getUseMixedPrecision())
             ccmaFullKernel->addArg(context.getPosqCorrection());
     }
+    if (lincsS.isInitialized()) {
+        lincsDirectionsKernel->addArg();
+        lincsDirectionsKernel->addArg(ccmaConstraintAtoms);
+        lincsDirectionsKernel->addArg(ccmaDistance);
+        lincsDirectionsKernel->addArg(context.getPosq());
+        lincsDirectionsKernel->addArg(posDelta);
+        lincsDirectionsKernel->addArg(context.getVelm());
+        lincsDirectionsKernel->addArg(lincsS);
+        lincsDirectionsKernel->addArg(lincsRhs1);
+        lincsDirectionsKernel->addArg(lincsSolution);
+        if (context.getUseMixedPrecision())
+            lincsDirectionsKernel->addArg(context.getPosqCorrection());
+        lincsMatrixKernel->addArg(ccmaDistance);
+        lincsMatrixKernel->addArg(lincsCoupledConstraints);
+        lincsMatrixKernel->addArg(lincsCouplingCoefficients);
+        lincsMatrixKernel->addArg(lincsCouplingMatrix);
+        lincsMultiplyKernel->addArg();
+        lincsMultiplyKernel->addArg();
+        lincsMultiplyKernel->addArg(lincsSolution);
+        lincsMultiplyKernel->addArg(lincsCoupledConstraints);
+        lincsMultiplyKernel->addArg(lincsCouplingMatrix);
+        lincsUpdateKernel->addArg(ccmaAtoms);
+        lincsUpdateKernel->addArg(ccmaNumAtomConstraints);
+        lincsUpdateKernel->addArg(ccmaAtomConstraints);
+        lincsUpdateKernel->addArg(ccmaDistance);
+        lincsUpdateKernel->addArg(lincsS);
+        lincsUpdateKernel->addArg(lincsSolution);
+        lincsUpdateKernel->addArg();
+        lincsUpdateKernel->addArg(context.getVelm());
+        lincsCorrectionKernel->addArg(ccmaConstraintAtoms);
+        lincsCorrectionKernel->addArg(ccmaDistance);
+        lincsCorrectionKernel->addArg(context.getPosq());
+        lincsCorrectionKernel->addArg(posDelta);
+        lincsCorrectionKernel->addArg(lincsS);
+        lincsCorrectionKernel->addArg(lincsRhs1);
+        lincsCorrectionKernel->addArg(lincsSolution);
+        if (context.getUseMixedPrecision())
+            lincsCorrectionKernel->addArg(context.getPosqCorrection());
+    }
 
     // Arguments for time shift kernel will be set later.
     
@@ -777,14 +972,110 @@ double IntegrationUtilities::getLastStepSize() {
     return lastStepSize.y;
 }
 
+ArrayInterface& IntegrationUtilities::getDeviceTime() {
+    if (!deviceTime.isInitialized()) {
+        if (context.getUseDoublePrecision() || context.getUseMixedPrecision()) {
+            deviceTime.initialize<mm_double4>(context, 1, "deviceTime");
+            mm_double4 zero(0, 0, 0, 0);
+            deviceTime.upload(&zero);
+        }
+        else {
+            deviceTime.initialize<mm_float4>(context, 1, "deviceTime");
+            mm_float4 zero(0, 0, 0, 0);
+            deviceTime.upload(&zero);
+        }
+    }
+    return deviceTime;
+}
+
+void IntegrationUtilities::addDeviceTimeStep(double maxTime) {
+    deviceTimeLimit = maxTime;
+    context.setTimeIsOnDevice(true);
+}
+
+double IntegrationUtilities::downloadDeviceTime() {
+    context.setTimeIsOnDevice(false);
+    if (!deviceTime.isInitialized())
+        return deviceStepSize;
+    ContextSelector selector(context);
+    mm_double4 value;
+    if (context.getUseDoublePrecision() || context.getUseMixedPrecision())
+        deviceTime.download(&value);
+    else {
+        mm_float4 valueFloat;
+        deviceTime.download(&valueFloat);
+        value = mm_double4(valueFloat.x, valueFloat.y, valueFloat.z, valueFloat.w);
+    }
+    if (value.z != 0)
+        context.setTime(deviceTimeLimit); // Avoid round-off error
+    else
+        context.setTime(context.getTime()+(value.x-value.y));
+    deviceStepSize = value.w;
+    resetDeviceTime();
+    return deviceStepSize;
+}
+
+void IntegrationUtilities::resetDeviceTime() {
+    context.setTimeIsOnDevice(false);
+    if (!deviceTime.isInitialized())
+        return;
+    ContextSelector selector(context);
+    if (context.getUseDoublePrecision() || context.getUseMixedPrecision()) {
+        mm_double4 value(0, 0, 0, deviceStepSize);
+        deviceTime.upload(&value);
+    }
+    else {
+        mm_float4 value(0, 0, 0, (float) deviceStepSize);
+        deviceTime.upload(&value);
+    }
+}
+
 void IntegrationUtilities::applyConstraints(double tol) {
+    ComputeContext::Annotation annotation(context, "applyConstraints");
     applyConstraintsImpl(false, tol);
 }
 
 void IntegrationUtilities::applyVelocityConstraints(double tol) {
+    ComputeContext::Annotation annotation(context, "applyVelocityConstraints");
     applyConstraintsImpl(true, tol);
 }
 
+bool IntegrationUtilities::getConstraintsRequireHostSync() const {
+    return (!useLincs && ccmaConstraintAtoms.isInitialized() && ccmaConstraintAtoms.getSize() > 1024);
+}
+
+void IntegrationUtilities::applyLincs(bool constrainVelocities) {
+    // Find the constraint directions and solve the matrix equation by a fixed order expansion.  The
+    // number of kernel launches never depends on the result, so the host never needs to wait.
+
+    int numConstraints = ccmaConstraintAtoms.getSize();
+    lincsDirectionsKernel->setArg(0, (int) constrainVelocities);
+    lincsDirectionsKernel->execute(numConstraints);
+    lincsMatrixKernel->execute(numConstraints);
+    solveLincsMatrix();
+    lincsUpdateKernel->setArg(6, constrainVelocities ? context.getVelm() : posDelta);
+    lincsUpdateKernel->execute(ccmaAtoms.getSize());
+    if (constrainVelocities)
+        return;
+
+    // Correct for the lengthening caused by rotation of the constraints.
+
+    for (int i = 0; i < LincsIterations; i++) {
+        lincsCorrectionKernel->execute(numConstraints);
+        solveLincsMatrix();
+        lincsUpdateKernel->execute(ccmaAtoms.getSize());
+    }
+}
+
+void IntegrationUtilities::solveLincsMatrix() {
+    int numConstraints = ccmaConstraintAtoms.getSize();
+    for (int i = 0; i < LincsOrder; i++) {
+        lincsMultiplyKernel->setArg(0, i%2 == 0 ? lincsRhs1 : lincsRhs2);
+        lincsMultiplyKernel->setArg(1, i%2 == 0 ? lincsRhs2 : lincsRhs1);
+        lincsMultiplyKernel->execute(numConstraints);
+    }
+}
+
 void IntegrationUtilities::computeVirtualSites() {
     ContextSelector selector(context);
     for (int i = 0; i < numVsiteStages; i++) {
@@ -793,6 +1084,11 @@ void IntegrationUtilities::computeVirtualSites() {
     }
 }
 
+void IntegrationUtilities::setCMMomentum(ArrayInterface& array) {
+    cmMomentum = &array;
+    cmMomentumStep = -1;
+}
+
 void IntegrationUtilities::initRandomNumberGenerator(unsigned int randomNumberSeed) {
     if (random.isInitialized()) {
         if (randomNumberSeed != lastSeed)
@@ -823,6 +1119,8 @@ void IntegrationUtilities::initRandomNumberGenerator(unsigned int randomNumberSe
         seed[i].w = r = (1664525*r + 1013904223) & 0xFFFFFFFF;
     }
     randomSeed.upload(seed);
+    randomKey.x = r = (1664525*r + 1013904223) & 0xFFFFFFFF;
+    randomKey.y = r = (1664525*r + 1013904223) & 0xFFFFFFFF;
 }
 
 int IntegrationUtilities::prepareRandomNumbers(int numValues) {
@@ -840,6 +1138,11 @@ int IntegrationUtilities::prepareRandomNumbers(int numValues) {
     return 0;
 }
 
+mm_int2 IntegrationUtilities::prepareRandomCounter() {
+    long long counter = randomCounter++;
+    return mm_int2((int) (counter&0xFFFFFFFF), (int) (counter>>32));
+}
+
 void IntegrationUtilities::createCheckpoint(ostream& stream) {
     if (!random.isInitialized())
         return;
@@ -850,6 +1153,8 @@ void IntegrationUtilities::createCheckpoint(ostream& stream) {
     vector<mm_int4> randomSeedVec;
     randomSeed.download(randomSeedVec);
     stream.write((char*) &randomSeedVec[0], sizeof(mm_int4)*randomSeed.getSize());
+    stream.write((char*) &randomCounter, sizeof(long long));
+    stream.write((char*) &randomKey, sizeof(mm_int2));
 }
 
 void IntegrationUtilities::loadCheckpoint(istream& stream) {
@@ -862,6 +1167,8 @@ void IntegrationUtilities::loadCheckpoint(istream& stream) {
     vector<mm_int4> randomSeedVec(randomSeed.getSize());
     stream.read((char*) &randomSeedVec[0], sizeof(mm_int4)*randomSeed.getSize());
     randomSeed.upload(randomSeedVec);
+    stream.read((char*) &randomCounter, sizeof(long long));
+    stream.read((char*) &randomKey, sizeof(mm_int2));
 }
 
 double IntegrationUtilities::computeKineticEnergy(double timeShift) {
@@ -0,0 +1,222 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.            *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/common/KernelCache.h"
+#include "SHA1.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <sys/stat.h>
+#ifdef WIN32
+  #include <windows.h>
+  #include <sys/utime.h>
+#else
+  #include <dirent.h>
+  #include <utime.h>
+#endif
+
+using namespace OpenMM;
+using namespace std;
+
+KernelCache::KernelCache(const string& directory, const string& defaultDirectory, const string& prefix) : prefix(prefix) {
+    char* cacheVariable = getenv("OPENMM_CACHE_DIR");
+    if (directory.size() > 0)
+        this->directory = directory;
+    else
+        this->directory = (cacheVariable == NULL ? defaultDirectory : string(cacheVariable));
+#ifdef WIN32
+    if (this->directory.size() == 0 || this->directory.back() != '\\')
+        this->directory += "\\";
+#else
+    if (this->directory.size() == 0 || this->directory.back() != '/')
+        this->directory += "/";
+#endif
+    maxSize = 1024LL*1024*1024;
+    char* sizeVariable = getenv("OPENMM_CACHE_MAX_SIZE");
+    if (sizeVariable != NULL) {
+        double megabytes;
+        if (stringstream(sizeVariable) >> megabytes)
+            maxSize = (long long) (megabytes*1024*1024);
+    }
+}
+
+string KernelCache::getHash(const string& text) {
+    CSHA1 sha1;
+    sha1.Update((const UINT_8*) text.c_str(), text.size());
+    sha1.Final();
+    UINT_8 hash[20];
+    sha1.GetHash(hash);
+    stringstream result;
+    result.flags(ios::hex);
+    for (int i = 0; i < 20; i++)
+        result << setw(2) << setfill('0') << (int) hash[i];
+    return result.str();
+}
+
+string KernelCache::getFileName(const string& key) const {
+    return directory+prefix+getHash(key);
+}
+
+void KernelCache::addReadOnlyDirectory(const string& directory) {
+    if (directory.size() == 0)
+        return;
+    string dir = directory;
+#ifdef WIN32
+    if (dir.back() != '\\')
+        dir += "\\";
+#else
+    if (dir.back() != '/')
+        dir += "/";
+#endif
+    readOnlyDirectories.push_back(dir);
+}
+
+string KernelCache::findFile(const string& key) const {
+    string name = prefix+getHash(key);
+    struct stat info;
+    if (stat((directory+name).c_str(), &info) == 0)
+        return directory+name;
+    for (const string& dir : readOnlyDirectories)
+        if (stat((dir+name).c_str(), &info) == 0)
+            return dir+name;
+    return "";
+}
+
+bool KernelCache::load(const string& key, vector<char>& data) {
+    string fileName = getFileName(key);
+    ifstream in(fileName.c_str(), ios::in | ios::binary);
+    if (!in.is_open())
+        return false;
+    in.seekg(0, ios::end);
+    streamoff size = in.tellg();
+    if (size <= 0)
+        return false;
+    in.seekg(0, ios::beg);
+    data.resize(size);
+    in.read(&data[0], size);
+    if (in.fail())
+        return false;
+    recordUse(fileName);
+    return true;
+}
+
+void KernelCache::save(const string& key, const vector<char>& data) {
+    // Write to a temporary file and then rename it, so another process reading the same file
+    // never sees it partially written.
+
+    string fileName = getFileName(key);
+    stringstream tempFileName;
+    tempFileName << fileName << "_" << this << "_" << this_thread::get_id();
+    try {
+        ofstream out(tempFileName.str().c_str(), ios::out | ios::binary);
+        out.write(data.data(), data.size());
+        out.close();
+        if (out.fail() || rename(tempFileName.str().c_str(), fileName.c_str()) != 0) {
+            remove(tempFileName.str().c_str());
+            return;
+        }
+    }
+    catch (...) {
+        // An error occurred.  Possibly we don't have permission to write to the directory.
+        // Ignore.
+
+        return;
+    }
+    enforceSizeLimit();
+}
+
+void KernelCache::recordUse(const string& fileName) {
+    // The modification time serves as the time of last use.
+
+    utime(fileName.c_str(), NULL);
+}
+
+void KernelCache::recordNewFile(const string& fileName) {
+    enforceSizeLimit();
+}
+
+void KernelCache::enforceSizeLimit() {
+    if (maxSize <= 0)
+        return;
+
+    // Find all files created by this cache, along with their sizes and times of last use.
+
+    vector<string> names;
+#ifdef WIN32
+    WIN32_FIND_DATA fileInfo;
+    string filePattern(directory+prefix+"*");
+    HANDLE findHandle = FindFirstFile(filePattern.c_str(), &fileInfo);
+    if (findHandle != INVALID_HANDLE_VALUE) {
+        do {
+            names.push_back(string(fileInfo.cFileName));
+        } while (FindNextFile(findHandle, &fileInfo));
+        FindClose(findHandle);
+    }
+#else
+    DIR* dir = opendir(directory.c_str());
+    if (dir == NULL)
+        return;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        string name(entry->d_name);
+        if (name.compare(0, prefix.size(), prefix) == 0)
+            names.push_back(name);
+    }
+    closedir(dir);
+#endif
+    vector<pair<long long, string> > files;
+    vector<long long> sizes;
+    long long totalSize = 0;
+    for (const string& name : names) {
+        string path = directory+name;
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0)
+            continue;
+        files.push_back(make_pair((long long) info.st_mtime, path));
+        sizes.push_back(info.st_size);
+        totalSize += info.st_size;
+    }
+    if (totalSize <= maxSize)
+        return;
+
+    // Delete the least recently used files until we are under the limit.  Other processes may
+    // be doing the same thing at once, so ignore failures.
+
+    vector<int> order(files.size());
+    for (int i = 0; i < (int) order.size(); i++)
+        order[i] = i;
+    sort(order.begin(), order.end(), [&] (int a, int b) { return files[a] < files[b]; });
+    for (int i : order) {
+        if (totalSize <= maxSize)
+            break;
+        if (remove(files[i].second.c_str()) == 0)
+            totalSize -= sizes[i];
+    }
+}
@@ -3,17 +3,16 @@
  */
 
 KERNEL void integrateBrownianPart1(int numAtoms, int paddedNumAtoms, mixed tauDeltaT, mixed noiseAmplitude, GLOBAL const mm_long* RESTRICT force,
-        GLOBAL mixed4* RESTRICT posDelta, GLOBAL const mixed4* RESTRICT velm, GLOBAL const float4* RESTRICT random, unsigned int randomIndex) {
-    randomIndex += GLOBAL_ID;
+        GLOBAL mixed4* RESTRICT posDelta, GLOBAL const mixed4* RESTRICT velm, GLOBAL const int* RESTRICT atomIndex, uint2 randomKey, uint2 randomCounter) {
     const mixed fscale = tauDeltaT/(mixed) 0x100000000;
     for (int index = GLOBAL_ID; index < numAtoms; index += GLOBAL_SIZE) {
         mixed invMass = velm[index].w;
         if (invMass != 0) {
-            posDelta[index].x = fscale*invMass*force[index] + noiseAmplitude*SQRT(invMass)*random[randomIndex].x;
-            posDelta[index].y = fscale*invMass*force[index+paddedNumAtoms] + noiseAmplitude*SQRT(invMass)*random[randomIndex].y;
-            posDelta[index].z = fscale*invMass*force[index+paddedNumAtoms*2] + noiseAmplitude*SQRT(invMass)*random[randomIndex].z;
+            float4 rand = philoxNormal4(randomKey, randomCounter, atomIndex[index]);
+            posDelta[index].x = fscale*invMass*force[index] + noiseAmplitude*SQRT(invMass)*rand.x;
+            posDelta[index].y = fscale*invMass*force[index+paddedNumAtoms] + noiseAmplitude*SQRT(invMass)*rand.y;
+            posDelta[index].z = fscale*invMass*force[index+paddedNumAtoms*2] + noiseAmplitude*SQRT(invMass)*rand.z;
         }
-        randomIndex += GLOBAL_SIZE;
     }
 }
 
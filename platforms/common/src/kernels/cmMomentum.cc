@@ -0,0 +1,26 @@
+/**
+ * Sum the center of mass momentum accumulated by each thread in a block of 64 threads, and record the
+ * total for the block in cmMomentum.  This must be called by every thread in the block.
+ */
+DEVICE void recordCMMomentum(float4 cm, GLOBAL float4* RESTRICT cmMomentum, LOCAL_ARG float4* temp) {
+    int thread = LOCAL_ID;
+    temp[thread] = cm;
+    SYNC_THREADS;
+    if (thread < 32)
+        temp[thread] += temp[thread+32];
+    SYNC_THREADS;
+    if (thread < 16)
+        temp[thread] += temp[thread+16];
+    SYNC_THREADS;
+    if (thread < 8)
+        temp[thread] += temp[thread+8];
+    SYNC_THREADS;
+    if (thread < 4)
+        temp[thread] += temp[thread+4];
+    SYNC_THREADS;
+    if (thread < 2)
+        temp[thread] += temp[thread+2];
+    SYNC_THREADS;
+    if (thread == 0)
+        cmMomentum[GROUP_ID] = temp[thread]+temp[thread+1];
+}
@@ -1,17 +1,89 @@
-KERNEL void copyFloatBuffer(GLOBAL float* RESTRICT source, GLOBAL float4* RESTRICT dest, int numAtoms) {
+/**
+ * Copy positions that were uploaded in the order of the System's particles into posq, applying the
+ * current atom order and converting them to the working precision.
+ */
+KERNEL void setPositions(GLOBAL const STAGING_TYPE* RESTRICT source, GLOBAL real4* RESTRICT posq,
+#ifdef USE_MIXED_PRECISION
+        GLOBAL real4* RESTRICT posqCorrection,
+#endif
+        GLOBAL const int* RESTRICT atomIndex, int numAtoms) {
     for (int i = GLOBAL_ID; i < numAtoms; i += GLOBAL_SIZE) {
-        dest[i].x = source[3*i];
-        dest[i].y = source[3*i+1];
-        dest[i].z = source[3*i+2];
+        int atom = atomIndex[i];
+        mixed4 p = make_mixed4((mixed) source[3*atom], (mixed) source[3*atom+1], (mixed) source[3*atom+2], 0);
+        real4 pos = posq[i];
+        pos.x = (real) p.x;
+        pos.y = (real) p.y;
+        pos.z = (real) p.z;
+        posq[i] = pos;
+#ifdef USE_MIXED_PRECISION
+        posqCorrection[i] = make_real4((real) (p.x-(real) p.x), (real) (p.y-(real) p.y), (real) (p.z-(real) p.z), 0);
+#endif
     }
 }
 
-#ifdef SUPPORTS_DOUBLE_PRECISION
-KERNEL void copyDoubleBuffer(GLOBAL double* RESTRICT source, GLOBAL double4* RESTRICT dest, int numAtoms) {
+/**
+ * Copy velocities that were uploaded in the order of the System's particles into velm, applying the
+ * current atom order.
+ */
+KERNEL void setVelocities(GLOBAL const STAGING_TYPE* RESTRICT source, GLOBAL mixed4* RESTRICT velm, GLOBAL const int* RESTRICT atomIndex, int numAtoms) {
     for (int i = GLOBAL_ID; i < numAtoms; i += GLOBAL_SIZE) {
-        dest[i].x = source[3*i];
-        dest[i].y = source[3*i+1];
-        dest[i].z = source[3*i+2];
+        int atom = atomIndex[i];
+        mixed4 v = velm[i];
+        velm[i] = make_mixed4((mixed) source[3*atom], (mixed) source[3*atom+1], (mixed) source[3*atom+2], v.w);
+    }
+}
+/**
+ * Copy the positions of a subset of particles into a compact array.  particleSlot maps each
+ * particle index to its position in the output, or -1 if it was not requested.
+ */
+KERNEL void gatherPositions(GLOBAL const real4* RESTRICT posq,
+#ifdef USE_MIXED_PRECISION
+        GLOBAL const real4* RESTRICT posqCorrection,
+#endif
+        GLOBAL const int* RESTRICT atomIndex, GLOBAL const int* RESTRICT particleSlot, GLOBAL mixed4* RESTRICT gatheredPositions,
+        GLOBAL int* RESTRICT gatheredIndex, int numAtoms) {
+    for (int i = GLOBAL_ID; i < numAtoms; i += GLOBAL_SIZE) {
+        int slot = particleSlot[atomIndex[i]];
+        if (slot >= 0) {
+            real4 pos = posq[i];
+#ifdef USE_MIXED_PRECISION
+            real4 correction = posqCorrection[i];
+            gatheredPositions[slot] = make_mixed4(pos.x+(mixed) correction.x, pos.y+(mixed) correction.y, pos.z+(mixed) correction.z, 0);
+#else
+            gatheredPositions[slot] = make_mixed4(pos.x, pos.y, pos.z, 0);
+#endif
+            gatheredIndex[slot] = i;
+        }
+    }
+}
+
+KERNEL void gatherVelocities(GLOBAL const mixed4* RESTRICT velm, GLOBAL const int* RESTRICT atomIndex, GLOBAL const int* RESTRICT particleSlot,
+        GLOBAL mixed4* RESTRICT gatheredVelocities, int numAtoms) {
+    for (int i = GLOBAL_ID; i < numAtoms; i += GLOBAL_SIZE) {
+        int slot = particleSlot[atomIndex[i]];
+        if (slot >= 0)
+            gatheredVelocities[slot] = velm[i];
+    }
+}
+
+/**
+ * Multiply the velocity of every atom by a constant factor.
+ */
+KERNEL void scaleVelocities(GLOBAL mixed4* RESTRICT velm, int numAtoms, mixed scale) {
+    for (int i = GLOBAL_ID; i < numAtoms; i += GLOBAL_SIZE) {
+        mixed4 v = velm[i];
+        velm[i] = make_mixed4(scale*v.x, scale*v.y, scale*v.z, v.w);
+    }
+}
+
+KERNEL void gatherForces(GLOBAL const mm_long* RESTRICT force, GLOBAL const int* RESTRICT atomIndex, GLOBAL const int* RESTRICT particleSlot,
+        GLOBAL mm_long* RESTRICT gatheredForces, int numAtoms, int paddedNumAtoms) {
+    for (int i = GLOBAL_ID; i < numAtoms; i += GLOBAL_SIZE) {
+        int slot = particleSlot[atomIndex[i]];
+        if (slot >= 0) {
+            gatheredForces[3*slot] = force[i];
+            gatheredForces[3*slot+1] = force[i+paddedNumAtoms];
+            gatheredForces[3*slot+2] = force[i+2*paddedNumAtoms];
+        }
     }
 }
-#endif
\ No newline at end of file
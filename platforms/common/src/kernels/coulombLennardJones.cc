@@ -76,10 +76,39 @@
     dEdR += includeInteraction ? tempForce*invR*invR : 0;
 #else
 #ifdef USE_CUTOFF
-    unsigned int includeInteraction = (!isExcluded && r2 < CUTOFF_SQUARED);
+    // Reaction field.  In sparse systems, such as coarse grained ones, most pairs in a tile are beyond the
+    // cutoff, so skip all the work for them rather than computing and then discarding it.
+
+    if (!isExcluded && r2 < CUTOFF_SQUARED) {
+        real tempForce = 0.0f;
+#if HAS_LENNARD_JONES
+        real sig = SIGMA_EPSILON1.x + SIGMA_EPSILON2.x;
+        real sig2 = invR*sig;
+        sig2 *= sig2;
+        real sig6 = sig2*sig2*sig2;
+        real epssig6 = sig6*(SIGMA_EPSILON1.y*SIGMA_EPSILON2.y);
+        tempForce = epssig6*(12.0f*sig6 - 6.0f);
+        real ljEnergy = epssig6*(sig6 - 1);
+        #if USE_LJ_SWITCH
+        if (r > LJ_SWITCH_CUTOFF) {
+            real x = r-LJ_SWITCH_CUTOFF;
+            real switchValue = 1+x*x*x*(LJ_SWITCH_C3+x*(LJ_SWITCH_C4+x*LJ_SWITCH_C5));
+            real switchDeriv = x*x*(3*LJ_SWITCH_C3+x*(4*LJ_SWITCH_C4+x*5*LJ_SWITCH_C5));
+            tempForce = tempForce*switchValue - ljEnergy*switchDeriv*r;
+            ljEnergy *= switchValue;
+        }
+        #endif
+        tempEnergy += ljEnergy;
+#endif
+#if HAS_COULOMB
+        const real prefactor = ONE_4PI_EPS0*CHARGE1*CHARGE2;
+        tempForce += prefactor*(invR - 2.0f*REACTION_FIELD_K*r2);
+        tempEnergy += prefactor*(invR + REACTION_FIELD_K*r2 - REACTION_FIELD_C);
+#endif
+        dEdR += tempForce*invR*invR;
+    }
 #else
     unsigned int includeInteraction = (!isExcluded);
-#endif
     real tempForce = 0.0f;
 #if HAS_LENNARD_JONES
     real sig = SIGMA_EPSILON1.x + SIGMA_EPSILON2.x;
@@ -89,28 +118,14 @@
     real epssig6 = sig6*(SIGMA_EPSILON1.y*SIGMA_EPSILON2.y);
     tempForce = epssig6*(12.0f*sig6 - 6.0f);
     real ljEnergy = includeInteraction ? epssig6*(sig6 - 1) : 0;
-    #if USE_LJ_SWITCH
-    if (r > LJ_SWITCH_CUTOFF) {
-        real x = r-LJ_SWITCH_CUTOFF;
-        real switchValue = 1+x*x*x*(LJ_SWITCH_C3+x*(LJ_SWITCH_C4+x*LJ_SWITCH_C5));
-        real switchDeriv = x*x*(3*LJ_SWITCH_C3+x*(4*LJ_SWITCH_C4+x*5*LJ_SWITCH_C5));
-        tempForce = tempForce*switchValue - ljEnergy*switchDeriv*r;
-        ljEnergy *= switchValue;
-    }
-    #endif
     tempEnergy += ljEnergy;
 #endif
 #if HAS_COULOMB
-  #ifdef USE_CUTOFF
-    const real prefactor = ONE_4PI_EPS0*CHARGE1*CHARGE2;
-    tempForce += prefactor*(invR - 2.0f*REACTION_FIELD_K*r2);
-    tempEnergy += includeInteraction ? prefactor*(invR + REACTION_FIELD_K*r2 - REACTION_FIELD_C) : 0;
-  #else
     const real prefactor = ONE_4PI_EPS0*CHARGE1*CHARGE2*invR;
     tempForce += prefactor;
     tempEnergy += includeInteraction ? prefactor : 0;
-  #endif
 #endif
     dEdR += includeInteraction ? tempForce*invR*invR : 0;
 #endif
+#endif
 }
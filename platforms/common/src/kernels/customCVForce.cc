@@ -21,24 +21,16 @@ KERNEL void copyState(GLOBAL real4* RESTRICT posq, GLOBAL real4* RESTRICT innerP
 }
 
 /**
- * Copy the forces back to the main context.
+ * Add all the forces from the CVs.  They are stored in the inner context's atom order.
  */
-KERNEL void copyForces(GLOBAL mm_long* RESTRICT forces, GLOBAL int* RESTRICT invAtomOrder, GLOBAL mm_long* RESTRICT innerForces,
-        GLOBAL int* RESTRICT innerAtomOrder, int numAtoms, int paddedNumAtoms) {
+KERNEL void addForces(GLOBAL mm_long* RESTRICT forces, GLOBAL const int* RESTRICT atomOrder, GLOBAL const int* RESTRICT innerInvAtomOrder,
+        int numAtoms, int paddedNumAtoms PARAMETER_ARGUMENTS) {
     for (int i = GLOBAL_ID; i < numAtoms; i += GLOBAL_SIZE) {
-        int index = invAtomOrder[innerAtomOrder[i]];
-        forces[index] = innerForces[i];
-        forces[index+paddedNumAtoms] = innerForces[i+paddedNumAtoms];
-        forces[index+paddedNumAtoms*2] = innerForces[i+paddedNumAtoms*2];
-    }
-}
-
-/**
- * Add all the forces from the CVs.
- */
-KERNEL void addForces(GLOBAL mm_long* RESTRICT forces, int bufferSize
-    PARAMETER_ARGUMENTS) {
-    for (int i = GLOBAL_ID; i < bufferSize; i += GLOBAL_SIZE) {
-        ADD_FORCES
+        int index = innerInvAtomOrder[atomOrder[i]];
+        for (int j = 0; j < 3; j++) {
+            int outer = i+j*paddedNumAtoms;
+            int inner = index+j*paddedNumAtoms;
+            ADD_FORCES
+        }
     }
 }
@@ -1,14 +1,15 @@
 /**
- * Compute the center of each group.
+ * Compute the weighted sum of positions in each segment.  Large groups are divided into several segments,
+ * whose sums are added by sumSegmentCenters().  Otherwise each segment is a whole group.
  */
-KERNEL void computeGroupCenters(int numParticleGroups, GLOBAL const real4* RESTRICT posq, GLOBAL const int* RESTRICT groupParticles,
-        GLOBAL const real* RESTRICT groupWeights, GLOBAL const int* RESTRICT groupOffsets, GLOBAL real4* RESTRICT centerPositions) {
+KERNEL void computeGroupCenters(int numSegments, GLOBAL const real4* RESTRICT posq, GLOBAL const int* RESTRICT groupParticles,
+        GLOBAL const real* RESTRICT groupWeights, GLOBAL const int* RESTRICT segmentOffsets, GLOBAL real4* RESTRICT centerPositions) {
     LOCAL volatile real3 temp[64];
-    for (int group = GROUP_ID; group < numParticleGroups; group += NUM_GROUPS) {
-        // The threads in this block work together to compute the center one group.
+    for (int segment = GROUP_ID; segment < numSegments; segment += NUM_GROUPS) {
+        // The threads in this block work together to compute the center one segment.
 
-        int firstIndex = groupOffsets[group];
-        int lastIndex = groupOffsets[group+1];
+        int firstIndex = segmentOffsets[segment];
+        int lastIndex = segmentOffsets[segment+1];
         real3 center = make_real3(0);
         for (int index = LOCAL_ID; index < lastIndex-firstIndex; index += LOCAL_SIZE) {
             int atom = groupParticles[firstIndex+index];
@@ -57,7 +58,21 @@ KERNEL void computeGroupCenters(int numParticleGroups, GLOBAL const real4* RESTR
         }
         SYNC_WARPS;
         if (thread == 0)
-            centerPositions[group] = make_real4(temp[0].x+temp[1].x, temp[0].y+temp[1].y, temp[0].z+temp[1].z, 0);
+            centerPositions[segment] = make_real4(temp[0].x+temp[1].x, temp[0].y+temp[1].y, temp[0].z+temp[1].z, 0);
+        SYNC_THREADS;
+    }
+}
+
+/**
+ * Sum the partial centers of the segments that make up each group.
+ */
+KERNEL void sumSegmentCenters(int numParticleGroups, GLOBAL const int* RESTRICT groupSegmentOffsets, GLOBAL const real4* RESTRICT segmentCenters,
+        GLOBAL real4* RESTRICT centerPositions) {
+    for (int group = GLOBAL_ID; group < numParticleGroups; group += GLOBAL_SIZE) {
+        real4 center = make_real4(0);
+        for (int segment = groupSegmentOffsets[group]; segment < groupSegmentOffsets[group+1]; segment++)
+            center += segmentCenters[segment];
+        centerPositions[group] = center;
     }
 }
 
@@ -79,14 +94,15 @@ KERNEL void computeGroupForces(int numParticleGroups, GLOBAL mm_ulong* RESTRICT
 /**
  * Apply the forces from the group centers to the individual atoms.
  */
-KERNEL void applyForcesToAtoms(int numParticleGroups, GLOBAL const int* RESTRICT groupParticles, GLOBAL const real* RESTRICT groupWeights, GLOBAL const int* RESTRICT groupOffsets,
-        GLOBAL const mm_long* RESTRICT groupForce, GLOBAL mm_ulong* RESTRICT atomForce) {
-    for (int group = GROUP_ID; group < numParticleGroups; group += NUM_GROUPS) {
+KERNEL void applyForcesToAtoms(int numSegments, int numParticleGroups, GLOBAL const int* RESTRICT groupParticles, GLOBAL const real* RESTRICT groupWeights,
+        GLOBAL const int* RESTRICT segmentOffsets, GLOBAL const int* RESTRICT segmentGroups, GLOBAL const mm_long* RESTRICT groupForce, GLOBAL mm_ulong* RESTRICT atomForce) {
+    for (int segment = GROUP_ID; segment < numSegments; segment += NUM_GROUPS) {
+        int group = segmentGroups[segment];
         mm_long fx = groupForce[group];
         mm_long fy = groupForce[group+numParticleGroups];
         mm_long fz = groupForce[group+numParticleGroups*2];
-        int firstIndex = groupOffsets[group];
-        int lastIndex = groupOffsets[group+1];
+        int firstIndex = segmentOffsets[segment];
+        int lastIndex = segmentOffsets[segment+1];
         for (int index = LOCAL_ID; index < lastIndex-firstIndex; index += LOCAL_SIZE) {
             int atom = groupParticles[firstIndex+index];
             real weight = groupWeights[firstIndex+index];
@@ -236,7 +236,7 @@ KERNEL void computeN2Energy(
             LOAD_ATOM1_PARAMETERS
             const unsigned int localAtomIndex = LOCAL_ID;
 #ifdef USE_CUTOFF
-            unsigned int j = interactingAtoms[pos*TILE_SIZE+tgx];
+            unsigned int j = interactingAtoms[((mm_long) pos)*TILE_SIZE+tgx];
 #else
             unsigned int j = y*TILE_SIZE + tgx;
 #endif
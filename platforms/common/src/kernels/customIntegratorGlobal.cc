@@ -0,0 +1,9 @@
+/**
+ * Evaluate a global expression on the device and store the result in the array of global values.
+ * The energy and random values are generated on the host and passed in as arguments.
+ */
+KERNEL void computeGlobal(GLOBAL mixed* RESTRICT globals, const mixed energy, const mixed uniform, const mixed gaussian) {
+    if (GLOBAL_ID == 0) {
+        COMPUTE_STEP
+    }
+}
@@ -48,7 +48,7 @@ KERNEL void computeInteraction(
         GLOBAL mm_ulong* RESTRICT forceBuffers, GLOBAL mixed* RESTRICT energyBuffer, GLOBAL const real4* RESTRICT posq,
         real4 periodicBoxSize, real4 invPeriodicBoxSize, real4 periodicBoxVecX, real4 periodicBoxVecY, real4 periodicBoxVecZ
 #ifdef USE_CUTOFF
-        , GLOBAL const int* RESTRICT neighbors, GLOBAL const int* RESTRICT neighborStartIndex
+        , GLOBAL const int* RESTRICT neighbors, GLOBAL const int* RESTRICT numNeighborsForAtom, int maxNeighbors
 #endif
 #ifdef USE_FILTERS
         , GLOBAL int* RESTRICT particleTypes, GLOBAL int* RESTRICT orderIndex, GLOBAL int* RESTRICT particleOrder
@@ -68,8 +68,8 @@ KERNEL void computeInteraction(
         const int a1 = 0;
 #endif
 #ifdef USE_CUTOFF
-        int firstNeighbor = neighborStartIndex[p1];
-        int numNeighbors = neighborStartIndex[p1+1]-firstNeighbor;
+        int firstNeighbor = p1*maxNeighbors;
+        int numNeighbors = min(numNeighborsForAtom[p1], maxNeighbors);
 #else
   #ifdef USE_CENTRAL_PARTICLE
         int numNeighbors = NUM_ATOMS;
@@ -106,174 +106,77 @@ KERNEL void computeInteraction(
     energyBuffer[GLOBAL_ID] += energy;
 }
 
+#ifdef USE_CUTOFF
 /**
- * Find a bounding box for the atoms in each block.
+ * Find the coordinates of the cell containing a position.  With periodic boundary conditions, the cells
+ * divide each box vector into an integer number of pieces.  Otherwise they are cubes of width CELL_SIZE.
  */
-KERNEL void findBlockBounds(real4 periodicBoxSize, real4 invPeriodicBoxSize, real4 periodicBoxVecX, real4 periodicBoxVecY, real4 periodicBoxVecZ,
-        GLOBAL const real4* RESTRICT posq, GLOBAL real4* RESTRICT blockCenter, GLOBAL real4* RESTRICT blockBoundingBox, GLOBAL int* RESTRICT numNeighborPairs) {
-    int index = GLOBAL_ID;
-    int base = index*TILE_SIZE;
-    while (base < NUM_ATOMS) {
-        real4 pos = posq[base];
-#ifdef USE_PERIODIC
-        APPLY_PERIODIC_TO_POS(pos)
-#endif
-        real4 minPos = pos;
-        real4 maxPos = pos;
-        int last = min(base+TILE_SIZE, NUM_ATOMS);
-        for (int i = base+1; i < last; i++) {
-            pos = posq[i];
+inline DEVICE int4 getCellCoordinates(real3 pos, real4 invPeriodicBoxSize, real4 periodicBoxVecY, real4 periodicBoxVecZ, int4 cellGrid) {
 #ifdef USE_PERIODIC
-            real4 center = 0.5f*(maxPos+minPos);
-            APPLY_PERIODIC_TO_POS_WITH_CENTER(pos, center)
+    real sz = pos.z*invPeriodicBoxSize.z;
+    real sy = (pos.y-sz*periodicBoxVecZ.y)*invPeriodicBoxSize.y;
+    real sx = (pos.x-sz*periodicBoxVecZ.x-sy*periodicBoxVecY.x)*invPeriodicBoxSize.x;
+    sx -= floor(sx);
+    sy -= floor(sy);
+    sz -= floor(sz);
+    return make_int4(min((int) (sx*cellGrid.x), cellGrid.x-1), min((int) (sy*cellGrid.y), cellGrid.y-1), min((int) (sz*cellGrid.z), cellGrid.z-1), 0);
+#else
+    return make_int4((int) floor(pos.x*INV_CELL_SIZE), (int) floor(pos.y*INV_CELL_SIZE), (int) floor(pos.z*INV_CELL_SIZE), 0);
 #endif
-            minPos = make_real4(min(minPos.x,pos.x), min(minPos.y,pos.y), min(minPos.z,pos.z), 0);
-            maxPos = make_real4(max(maxPos.x,pos.x), max(maxPos.y,pos.y), max(maxPos.z,pos.z), 0);
-        }
-        real4 blockSize = 0.5f*(maxPos-minPos);
-        blockBoundingBox[index] = blockSize;
-        blockCenter[index] = 0.5f*(maxPos+minPos);
-        index += GLOBAL_SIZE;
-        base = index*TILE_SIZE;
-    }
-    if (GROUP_ID == 0 && LOCAL_ID == 0)
-        *numNeighborPairs = 0;
 }
 
 /**
- * Find a list of neighbors for each atom.
+ * Get the index of the cell with specified coordinates.  Coordinates outside the grid are wrapped
+ * with periodic boundary conditions, and hashed into the available cells without them.
  */
-KERNEL void findNeighbors(real4 periodicBoxSize, real4 invPeriodicBoxSize, real4 periodicBoxVecX, real4 periodicBoxVecY, real4 periodicBoxVecZ,
-        GLOBAL const real4* RESTRICT posq, GLOBAL const real4* RESTRICT blockCenter, GLOBAL const real4* RESTRICT blockBoundingBox, GLOBAL int2* RESTRICT neighborPairs,
-        GLOBAL int* RESTRICT numNeighborPairs, GLOBAL int* RESTRICT numNeighborsForAtom, int maxNeighborPairs
-#ifdef USE_EXCLUSIONS
-        , GLOBAL const int* RESTRICT exclusions, GLOBAL const int* RESTRICT exclusionStartIndex
-#endif
-        ) {
-    LOCAL real3 positionCache[FIND_NEIGHBORS_WORKGROUP_SIZE];
-    int indexInWarp = LOCAL_ID%32;
-#if !(defined(__CUDA_ARCH__) || defined(USE_HIP))
-    LOCAL bool includeBlockFlags[FIND_NEIGHBORS_WORKGROUP_SIZE];
-    int warpStart = LOCAL_ID-indexInWarp;
-#endif
-    for (int atom1 = GLOBAL_ID; atom1 < PADDED_NUM_ATOMS; atom1 += GLOBAL_SIZE) {
-        // Load data for this atom.  Note that all threads in a warp are processing atoms from the same block.
-        
-        real3 pos1 = trimTo3(posq[atom1]);
-        int block1 = atom1/TILE_SIZE;
-        real4 blockCenter1 = blockCenter[block1];
-        real4 blockSize1 = blockBoundingBox[block1];
-        int totalNeighborsForAtom1 = 0;
-        
-        // Loop over atom blocks to search for neighbors.  The threads in a warp compare block1 against 32
-        // other blocks in parallel.
-
-#ifdef USE_CENTRAL_PARTICLE
-        int startBlock = 0;
-#else
-        int startBlock = block1;
-#endif
-        for (int block2Base = startBlock; block2Base < NUM_BLOCKS; block2Base += 32) {
-            int block2 = block2Base+indexInWarp;
-            bool includeBlock2 = (block2 < NUM_BLOCKS);
-            if (includeBlock2) {
-                real4 blockCenter2 = blockCenter[block2];
-                real4 blockSize2 = blockBoundingBox[block2];
-                real4 blockDelta = blockCenter1-blockCenter2;
+inline DEVICE int getCellIndex(int x, int y, int z, int4 cellGrid) {
 #ifdef USE_PERIODIC
-                APPLY_PERIODIC_TO_DELTA(blockDelta)
-#endif
-                blockDelta.x = max((real) 0, fabs(blockDelta.x)-blockSize1.x-blockSize2.x);
-                blockDelta.y = max((real) 0, fabs(blockDelta.y)-blockSize1.y-blockSize2.y);
-                blockDelta.z = max((real) 0, fabs(blockDelta.z)-blockSize1.z-blockSize2.z);
-                includeBlock2 &= (blockDelta.x*blockDelta.x+blockDelta.y*blockDelta.y+blockDelta.z*blockDelta.z < CUTOFF_SQUARED);
-            }
-            
-            // Loop over any blocks we identified as potentially containing neighbors.
-            
-#if defined(__CUDA_ARCH__) || defined(USE_HIP)
-            int includeBlockFlags = BALLOT(includeBlock2);
-            while (includeBlockFlags != 0) {
-                int i = __ffs(includeBlockFlags)-1;
-                includeBlockFlags &= includeBlockFlags-1;
-                {
+    x = (x+cellGrid.x)%cellGrid.x;
+    y = (y+cellGrid.y)%cellGrid.y;
+    z = (z+cellGrid.z)%cellGrid.z;
+    return x+cellGrid.x*(y+cellGrid.y*z);
 #else
-            includeBlockFlags[LOCAL_ID] = includeBlock2;
-            SYNC_WARPS;
-            for (int i = 0; i < TILE_SIZE; i++) {
-                if (includeBlockFlags[warpStart+i]) {
+    unsigned int hash = (((unsigned int) x)*73856093u) ^ (((unsigned int) y)*19349663u) ^ (((unsigned int) z)*83492791u);
+    return (int) (hash%((unsigned int) cellGrid.w));
 #endif
-                    int block2 = block2Base+i;
-
-                    // Loop over atoms in this block.
-
-                    int start = block2*TILE_SIZE;
-                    int included[TILE_SIZE];
-                    int numIncluded = 0;
-                    SYNC_WARPS;
-                    positionCache[LOCAL_ID] = trimTo3(posq[start+indexInWarp]);
-                    SYNC_WARPS;
-                    if (atom1 < NUM_ATOMS) {
-                        for (int j = 0; j < 32; j++) {
-                            int atom2 = start+j;
-                            real3 pos2 = positionCache[LOCAL_ID-indexInWarp+j];
-
-                            // Decide whether to include this atom pair in the neighbor list.
+}
 
-                            real4 atomDelta = delta(pos1, pos2, periodicBoxSize, invPeriodicBoxSize, periodicBoxVecX, periodicBoxVecY, periodicBoxVecZ);
-#ifdef USE_CENTRAL_PARTICLE
-                            bool includeAtom = (atom2 != atom1 && atom2 < NUM_ATOMS && atomDelta.w < CUTOFF_SQUARED);
-#else
-                            bool includeAtom = (atom2 > atom1 && atom2 < NUM_ATOMS && atomDelta.w < CUTOFF_SQUARED);
+/**
+ * Assign each atom to a cell, and count the atoms in each cell.  When there are type filters, each type
+ * has its own set of cells, so the atoms end up sorted by type.
+ */
+KERNEL void findAtomCells(real4 periodicBoxSize, real4 invPeriodicBoxSize, real4 periodicBoxVecX, real4 periodicBoxVecY, real4 periodicBoxVecZ,
+        GLOBAL const real4* RESTRICT posq, int4 cellGrid, GLOBAL int* RESTRICT atomCell, GLOBAL int* RESTRICT atomIndexInCell,
+        GLOBAL int* RESTRICT cellCount, GLOBAL int* RESTRICT numOverflows
+#ifdef USE_FILTERS
+        , GLOBAL const int* RESTRICT particleTypes
 #endif
-#ifdef USE_EXCLUSIONS
-                            if (includeAtom)
-                                includeAtom &= !isInteractionExcluded(atom1, atom2, exclusions, exclusionStartIndex);
+        ) {
+    for (int atom = GLOBAL_ID; atom < NUM_ATOMS; atom += GLOBAL_SIZE) {
+        int4 coords = getCellCoordinates(trimTo3(posq[atom]), invPeriodicBoxSize, periodicBoxVecY, periodicBoxVecZ, cellGrid);
+        int cell = getCellIndex(coords.x, coords.y, coords.z, cellGrid);
+#ifdef USE_FILTERS
+        cell += particleTypes[atom]*cellGrid.w;
 #endif
-                            if (includeAtom)
-                                included[numIncluded++] = atom2;
-                        }
-                    }
-
-                    // If we found any neighbors, store them to the neighbor list.
-
-                    if (numIncluded > 0) {
-                        int baseIndex = ATOMIC_ADD(numNeighborPairs, numIncluded);
-                        if (baseIndex+numIncluded <= maxNeighborPairs)
-                            for (int j = 0; j < numIncluded; j++)
-                                neighborPairs[baseIndex+j] = make_int2(atom1, included[j]);
-                        totalNeighborsForAtom1 += numIncluded;
-                    }
-                }
-            }
-        }
-        if (atom1 < NUM_ATOMS)
-            numNeighborsForAtom[atom1] = totalNeighborsForAtom1;
-        SYNC_WARPS;
+        atomCell[atom] = cell;
+        atomIndexInCell[atom] = ATOMIC_ADD(&cellCount[cell], 1);
     }
+    if (GROUP_ID == 0 && LOCAL_ID == 0)
+        *numOverflows = 0;
 }
 
 /**
- * Sum the neighbor counts to compute the start position of each atom.  This kernel
- * is executed as a single work group.
+ * Sum the atom counts to compute the start position of each cell.  This kernel is executed as
+ * a single work group.
  */
-KERNEL void computeNeighborStartIndices(GLOBAL int* RESTRICT numNeighborsForAtom, GLOBAL int* RESTRICT neighborStartIndex,
-            GLOBAL int* RESTRICT numNeighborPairs, int maxNeighborPairs) {
+KERNEL void computeCellStartIndices(GLOBAL int* RESTRICT cellCount, GLOBAL int* RESTRICT cellStart, int numCells) {
     LOCAL unsigned int posBuffer[256];
-    if (*numNeighborPairs > maxNeighborPairs) {
-        // There wasn't enough memory for the neighbor list, so we'll need to rebuild it.  Set the neighbor start
-        // indices to indicate no neighbors for any atom.
-        
-        for (int i = LOCAL_ID; i <= NUM_ATOMS; i += LOCAL_SIZE)
-            neighborStartIndex[i] = 0;
-        return;
-    }
     unsigned int globalOffset = 0;
-    for (unsigned int startAtom = 0; startAtom < NUM_ATOMS; startAtom += LOCAL_SIZE) {
-        // Load the neighbor counts into local memory.
+    for (unsigned int startCell = 0; startCell < numCells; startCell += LOCAL_SIZE) {
+        // Load the atom counts into local memory.
 
-        unsigned int globalIndex = startAtom+LOCAL_ID;
-        posBuffer[LOCAL_ID] = (globalIndex < NUM_ATOMS ? numNeighborsForAtom[globalIndex] : 0);
+        unsigned int globalIndex = startCell+LOCAL_ID;
+        posBuffer[LOCAL_ID] = (globalIndex < numCells ? cellCount[globalIndex] : 0);
         SYNC_THREADS;
 
         // Perform a parallel prefix sum.
@@ -287,29 +190,109 @@ KERNEL void computeNeighborStartIndices(GLOBAL int* RESTRICT numNeighborsForAtom
 
         // Write the results back to global memory.
 
-        if (globalIndex < NUM_ATOMS) {
-            neighborStartIndex[globalIndex+1] = posBuffer[LOCAL_ID]+globalOffset;
-            numNeighborsForAtom[globalIndex] = 0; // Clear this so the next kernel can use it as a counter
+        if (globalIndex < numCells) {
+            cellStart[globalIndex+1] = posBuffer[LOCAL_ID]+globalOffset;
+            cellCount[globalIndex] = 0; // Clear this so it is ready for the next time the neighbor list is built
         }
         globalOffset += posBuffer[LOCAL_SIZE-1];
         SYNC_THREADS;
     }
     if (LOCAL_ID == 0)
-        neighborStartIndex[0] = 0;
+        cellStart[0] = 0;
 }
 
 /**
- * Assemble the final neighbor list.
+ * Sort the atoms by cell, recording the position of each one in the sorted order.
  */
-KERNEL void copyPairsToNeighborList(GLOBAL const int2* RESTRICT neighborPairs, GLOBAL int* RESTRICT neighbors, GLOBAL int* RESTRICT numNeighborPairs,
-            int maxNeighborPairs, GLOBAL int* RESTRICT numNeighborsForAtom, GLOBAL const int* RESTRICT neighborStartIndex) {
-    int actualPairs = *numNeighborPairs;
-    if (actualPairs > maxNeighborPairs)
-        return; // There wasn't enough memory for the neighbor list, so we'll need to rebuild it.
-    for (unsigned int index = GLOBAL_ID; index < actualPairs; index += GLOBAL_SIZE) {
-        int2 pair = neighborPairs[index];
-        int startIndex = neighborStartIndex[pair.x];
-        int offset = ATOMIC_ADD(numNeighborsForAtom+pair.x, 1);
-        neighbors[startIndex+offset] = pair.y;
+KERNEL void sortAtomsByCell(GLOBAL const real4* RESTRICT posq, GLOBAL const int* RESTRICT atomCell, GLOBAL const int* RESTRICT atomIndexInCell,
+        GLOBAL const int* RESTRICT cellStart, GLOBAL int* RESTRICT sortedAtoms, GLOBAL real4* RESTRICT sortedPos) {
+    for (int atom = GLOBAL_ID; atom < NUM_ATOMS; atom += GLOBAL_SIZE) {
+        int index = cellStart[atomCell[atom]]+atomIndexInCell[atom];
+        sortedAtoms[index] = atom;
+        sortedPos[index] = posq[atom];
     }
 }
+
+/**
+ * Find the neighbors of each atom by searching the cells adjacent to the one containing it.  The neighbors
+ * of atom i are stored in elements i*maxNeighbors through (i+1)*maxNeighbors-1 of the neighbor list.  If
+ * there are type filters, neighbors are only searched for among types that can appear in a set with
+ * the atom, and they are sorted by type.
+ */
+KERNEL void findNeighbors(real4 periodicBoxSize, real4 invPeriodicBoxSize, real4 periodicBoxVecX, real4 periodicBoxVecY, real4 periodicBoxVecZ,
+        GLOBAL const real4* RESTRICT posq, int4 cellGrid, GLOBAL const int* RESTRICT cellStart, GLOBAL const int* RESTRICT sortedAtoms,
+        GLOBAL const real4* RESTRICT sortedPos, GLOBAL int* RESTRICT neighbors, GLOBAL int* RESTRICT numNeighborsForAtom,
+        GLOBAL int* RESTRICT numOverflows, int maxNeighbors
+#ifdef USE_FILTERS
+        , GLOBAL const int* RESTRICT particleTypes, GLOBAL const int* RESTRICT neighborTypeAllowed
+#endif
+#ifdef USE_EXCLUSIONS
+        , GLOBAL const int* RESTRICT exclusions, GLOBAL const int* RESTRICT exclusionStartIndex
+#endif
+        ) {
+    for (int atom1 = GLOBAL_ID; atom1 < NUM_ATOMS; atom1 += GLOBAL_SIZE) {
+        real3 pos1 = trimTo3(posq[atom1]);
+        int4 coords = getCellCoordinates(pos1, invPeriodicBoxSize, periodicBoxVecY, periodicBoxVecZ, cellGrid);
+
+        // Identify the cells to search.  When there are fewer than three cells along an axis, or when cells
+        // are hashed, the same cell may appear more than once, so skip duplicates.
+
+        int cells[27];
+        int numCells = 0;
+        for (int dz = -1; dz <= 1; dz++)
+            for (int dy = -1; dy <= 1; dy++)
+                for (int dx = -1; dx <= 1; dx++) {
+                    int cell = getCellIndex(coords.x+dx, coords.y+dy, coords.z+dz, cellGrid);
+                    bool isNew = true;
+                    for (int i = 0; i < numCells; i++)
+                        isNew &= (cells[i] != cell);
+                    if (isNew)
+                        cells[numCells++] = cell;
+                }
+
+        // Loop over atoms in those cells.
+
+        int numNeighbors = 0;
+        int firstNeighbor = atom1*maxNeighbors;
+#ifdef USE_FILTERS
+        int type1 = particleTypes[atom1];
+        for (int type2 = 0; type2 < NUM_TYPES; type2++) {
+            if (!neighborTypeAllowed[type1*NUM_TYPES+type2])
+                continue;
+            int cellOffset = type2*cellGrid.w;
+#else
+        {
+            int cellOffset = 0;
+#endif
+            for (int i = 0; i < numCells; i++) {
+                int start = cellStart[cellOffset+cells[i]];
+                int end = cellStart[cellOffset+cells[i]+1];
+                for (int j = start; j < end; j++) {
+                    int atom2 = sortedAtoms[j];
+
+                    // Decide whether to include this atom pair in the neighbor list.
+
+                    real4 atomDelta = delta(pos1, trimTo3(sortedPos[j]), periodicBoxSize, invPeriodicBoxSize, periodicBoxVecX, periodicBoxVecY, periodicBoxVecZ);
+#ifdef USE_CENTRAL_PARTICLE
+                    bool includeAtom = (atom2 != atom1 && atomDelta.w < CUTOFF_SQUARED);
+#else
+                    bool includeAtom = (atom2 > atom1 && atomDelta.w < CUTOFF_SQUARED);
+#endif
+#ifdef USE_EXCLUSIONS
+                    if (includeAtom)
+                        includeAtom &= !isInteractionExcluded(atom1, atom2, exclusions, exclusionStartIndex);
+#endif
+                    if (includeAtom) {
+                        if (numNeighbors < maxNeighbors)
+                            neighbors[firstNeighbor+numNeighbors] = atom2;
+                        numNeighbors++;
+                    }
+                }
+            }
+        }
+        numNeighborsForAtom[atom1] = numNeighbors;
+        if (numNeighbors > maxNeighbors)
+            ATOMIC_ADD(numOverflows, 1);
+    }
+}
+#endif
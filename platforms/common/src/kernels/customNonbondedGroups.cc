@@ -35,6 +35,67 @@ DEVICE int reduceMax(int val, LOCAL_ARG int* temp) {
 #endif
 }
 
+/**
+ * Find the bitwise OR of a value across all threads in a warp, and return that to
+ * every thread.
+ */
+DEVICE int reduceOr(int val, LOCAL_ARG int* temp) {
+#if defined(__CUDA_ARCH__) && __CUDA_ARCH__ >= 700
+    for (int mask = 16; mask > 0; mask /= 2)
+        val |= __shfl_xor_sync(0xffffffff, val, mask);
+    return val;
+#elif defined(USE_HIP)
+    for (int mask = 16; mask > 0; mask /= 2)
+        val |= __shfl_xor(val, mask, 32);
+    return val;
+#else
+    int indexInWarp = LOCAL_ID%32;
+    SYNC_WARPS;
+    temp[LOCAL_ID] = val;
+    SYNC_WARPS;
+    for (int offset = 16; offset > 0; offset /= 2) {
+        if (indexInWarp < offset)
+            temp[LOCAL_ID] |= temp[LOCAL_ID+offset];
+        SYNC_WARPS;
+    }
+    return temp[LOCAL_ID-indexInWarp];
+#endif
+}
+
+/**
+ * Find the component-wise minimum (if findMax is false) or maximum (if findMax is true)
+ * of a position across all threads in a warp, and return that to every thread.
+ */
+DEVICE real3 reduceBound(real3 val, bool findMax, LOCAL_ARG real4* temp) {
+#if defined(__CUDA_ARCH__) && __CUDA_ARCH__ >= 700
+    for (int mask = 16; mask > 0; mask /= 2) {
+        real3 other = make_real3(__shfl_xor_sync(0xffffffff, val.x, mask), __shfl_xor_sync(0xffffffff, val.y, mask), __shfl_xor_sync(0xffffffff, val.z, mask));
+        val = (findMax ? make_real3(max(val.x, other.x), max(val.y, other.y), max(val.z, other.z)) : make_real3(min(val.x, other.x), min(val.y, other.y), min(val.z, other.z)));
+    }
+    return val;
+#elif defined(USE_HIP)
+    for (int mask = 16; mask > 0; mask /= 2) {
+        real3 other = make_real3(__shfl_xor(val.x, mask, 32), __shfl_xor(val.y, mask, 32), __shfl_xor(val.z, mask, 32));
+        val = (findMax ? make_real3(max(val.x, other.x), max(val.y, other.y), max(val.z, other.z)) : make_real3(min(val.x, other.x), min(val.y, other.y), min(val.z, other.z)));
+    }
+    return val;
+#else
+    int indexInWarp = LOCAL_ID%32;
+    SYNC_WARPS;
+    temp[LOCAL_ID] = make_real4(val.x, val.y, val.z, 0);
+    SYNC_WARPS;
+    for (int offset = 16; offset > 0; offset /= 2) {
+        if (indexInWarp < offset) {
+            real4 a = temp[LOCAL_ID], b = temp[LOCAL_ID+offset];
+            temp[LOCAL_ID] = (findMax ? make_real4(max(a.x, b.x), max(a.y, b.y), max(a.z, b.z), 0) : make_real4(min(a.x, b.x), min(a.y, b.y), min(a.z, b.z), 0));
+        }
+        SYNC_WARPS;
+    }
+    real4 result = temp[LOCAL_ID-indexInWarp];
+    return make_real3(result.x, result.y, result.z);
+#endif
+}
+
 KERNEL void computeInteractionGroups(
         GLOBAL mm_ulong* RESTRICT forceBuffers,
         GLOBAL mixed* RESTRICT energyBuffer, GLOBAL const real4* RESTRICT posq, GLOBAL const int4* RESTRICT groupData,
@@ -155,6 +216,7 @@ KERNEL void buildNeighborList(GLOBAL int* RESTRICT rebuildNeighborList, GLOBAL i
     LOCAL volatile bool anyInteraction[WARPS_IN_BLOCK];
     LOCAL volatile int tileIndex[WARPS_IN_BLOCK];
     LOCAL int reductionBuffer[LOCAL_MEMORY_SIZE];
+    LOCAL real4 boundsBuffer[LOCAL_MEMORY_SIZE];
 
     const unsigned int startTile = (unsigned int) (warp*(mm_ulong)NUM_TILES/totalWarps);
     const unsigned int endTile = (unsigned int) ((warp+1)*(mm_ulong)NUM_TILES/totalWarps);
@@ -166,7 +228,39 @@ KERNEL void buildNeighborList(GLOBAL int* RESTRICT rebuildNeighborList, GLOBAL i
         const int rangeEnd = (atomData.z>>16)&0xFFFF;
         const int exclusions = atomData.w;
         real4 posq1 = posq[atom1];
-        localPos[LOCAL_ID] = posq[atom2];
+        real4 posq2 = posq[atom2];
+
+        // Before checking individual pairs, compare bounding boxes for the two sets of atoms
+        // in this tile set, as findInteractingBlocks does for the main neighbor list.  Rows
+        // with no unexcluded interactions and padding columns are left out of the boxes.
+        // Positions are imaged relative to the first atom so each box stays compact.
+
+        int usedColumns = reduceOr(exclusions, reductionBuffer);
+        real4 reference = posq[groupData[TILE_SIZE*tile].x];
+        real3 delta1 = make_real3(posq1.x-reference.x, posq1.y-reference.y, posq1.z-reference.z);
+        real3 delta2 = make_real3(posq2.x-reference.x, posq2.y-reference.y, posq2.z-reference.z);
+#ifdef USE_PERIODIC
+        APPLY_PERIODIC_TO_DELTA(delta1)
+        APPLY_PERIODIC_TO_DELTA(delta2)
+#endif
+        bool includeRow = (exclusions != 0);
+        bool includeColumn = (((usedColumns>>tgx)&1) != 0);
+        real3 minPos1 = reduceBound(includeRow ? delta1 : make_real3(1e38f, 1e38f, 1e38f), false, boundsBuffer);
+        real3 maxPos1 = reduceBound(includeRow ? delta1 : make_real3(-1e38f, -1e38f, -1e38f), true, boundsBuffer);
+        real3 minPos2 = reduceBound(includeColumn ? delta2 : make_real3(1e38f, 1e38f, 1e38f), false, boundsBuffer);
+        real3 maxPos2 = reduceBound(includeColumn ? delta2 : make_real3(-1e38f, -1e38f, -1e38f), true, boundsBuffer);
+        real3 blockSize1 = 0.5f*(maxPos1-minPos1);
+        real3 blockSize2 = 0.5f*(maxPos2-minPos2);
+        real3 blockDelta = 0.5f*(maxPos1+minPos1)-0.5f*(maxPos2+minPos2);
+#ifdef USE_PERIODIC
+        APPLY_PERIODIC_TO_DELTA(blockDelta)
+#endif
+        blockDelta.x = max((real) 0, fabs(blockDelta.x)-blockSize1.x-blockSize2.x);
+        blockDelta.y = max((real) 0, fabs(blockDelta.y)-blockSize1.y-blockSize2.y);
+        blockDelta.z = max((real) 0, fabs(blockDelta.z)-blockSize1.z-blockSize2.z);
+        if (!(blockDelta.x*blockDelta.x+blockDelta.y*blockDelta.y+blockDelta.z*blockDelta.z < PADDED_CUTOFF_SQUARED))
+            continue;
+        localPos[LOCAL_ID] = posq2;
         if (tgx == 0)
             anyInteraction[local_warp] = false;
         int tj = tgx;
@@ -209,7 +209,7 @@ KERNEL void integrateDPDPart2(int numAtoms, int paddedNumAtoms, GLOBAL const rea
         if (vel1.w != 0)
             pos1 += halfdt*trimTo3(vel1);
         int type1 = particleType[atom1];
-        int atom2 = interactingAtoms[tileIndex*TILE_SIZE+tgx];
+        int atom2 = interactingAtoms[((mm_long) tileIndex)*TILE_SIZE+tgx];
         atomIndices[LOCAL_ID] = atom2;
         mixed4 vel2 = velm[atom2];
         mixed3 pos2 = loadPos(posq, posqCorrection, atom2);
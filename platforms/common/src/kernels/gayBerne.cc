@@ -92,8 +92,44 @@ KERNEL void findBlockBounds(int numAtoms, real4 periodicBoxSize, real4 invPeriod
         index += GLOBAL_SIZE;
         base = index*TILE_SIZE;
     }
-    if (GLOBAL_ID == 0)
-        *neighborBlockCount = 0;
+    if (GLOBAL_ID == 0) {
+        neighborBlockCount[0] = 0;
+        neighborBlockCount[1] = 0;
+    }
+}
+
+/**
+ * Find which blocks might contain neighbors of the atoms in each block.  Only blocks with the same or
+ * higher index are recorded, since each pair of atoms is processed only once.  If a block has more
+ * than maxBlockNeighbors neighbors, this is flagged in neighborBlockCount[1].
+ */
+KERNEL void findBlockNeighbors(int numAtoms, int maxBlockNeighbors, real4 periodicBoxSize, real4 invPeriodicBoxSize, real4 periodicBoxVecX, real4 periodicBoxVecY, real4 periodicBoxVecZ,
+        GLOBAL const real4* RESTRICT blockCenter, GLOBAL const real4* RESTRICT blockBoundingBox, GLOBAL int* RESTRICT blockNeighbors,
+        GLOBAL int* RESTRICT blockNeighborCount, GLOBAL int* RESTRICT neighborBlockCount) {
+    const int numBlocks = (numAtoms+TILE_SIZE-1)/TILE_SIZE;
+    for (int block1 = GLOBAL_ID; block1 < numBlocks; block1 += GLOBAL_SIZE) {
+        real4 center1 = blockCenter[block1];
+        real4 size1 = blockBoundingBox[block1];
+        int count = 0;
+        for (int block2 = block1; block2 < numBlocks; block2++) {
+            real4 size2 = blockBoundingBox[block2];
+            real4 blockDelta = blockCenter[block2]-center1;
+#ifdef USE_PERIODIC
+            APPLY_PERIODIC_TO_DELTA(blockDelta)
+#endif
+            blockDelta.x = max((real) 0, fabs(blockDelta.x)-size1.x-size2.x);
+            blockDelta.y = max((real) 0, fabs(blockDelta.y)-size1.y-size2.y);
+            blockDelta.z = max((real) 0, fabs(blockDelta.z)-size1.z-size2.z);
+            if (blockDelta.x*blockDelta.x+blockDelta.y*blockDelta.y+blockDelta.z*blockDelta.z < CUTOFF_SQUARED) {
+                if (count < maxBlockNeighbors)
+                    blockNeighbors[block1*maxBlockNeighbors+count] = block2;
+                count++;
+            }
+        }
+        blockNeighborCount[block1] = min(count, maxBlockNeighbors);
+        if (count > maxBlockNeighbors)
+            ATOMIC_ADD(&neighborBlockCount[1], 1);
+    }
 }
 
 /**
@@ -117,8 +153,8 @@ DEVICE void storeNeighbors(int atom1, int* neighborBuffer, int numAtomsInBuffer,
  */
 KERNEL void findNeighbors(int numAtoms, int maxNeighborBlocks, real4 periodicBoxSize, real4 invPeriodicBoxSize, real4 periodicBoxVecX, real4 periodicBoxVecY, real4 periodicBoxVecZ,
         GLOBAL real4* RESTRICT sortedPos, GLOBAL real4* RESTRICT blockCenter, GLOBAL real4* RESTRICT blockBoundingBox, GLOBAL int* RESTRICT neighbors,
-        GLOBAL int* RESTRICT neighborIndex, GLOBAL int* RESTRICT neighborBlockCount, GLOBAL const int* RESTRICT exclusions, GLOBAL const int* RESTRICT exclusionStartIndex) {
-    const int numBlocks = (numAtoms+TILE_SIZE-1)/TILE_SIZE;
+        GLOBAL int* RESTRICT neighborIndex, GLOBAL int* RESTRICT neighborBlockCount, GLOBAL const int* RESTRICT exclusions, GLOBAL const int* RESTRICT exclusionStartIndex,
+        int maxBlockNeighbors, GLOBAL const int* RESTRICT blockNeighbors, GLOBAL const int* RESTRICT blockNeighborCount) {
     int neighborBuffer[NEIGHBOR_BLOCK_SIZE];
     for (int atom1 = GLOBAL_ID; atom1 < numAtoms; atom1 += GLOBAL_SIZE) {
         int nextExclusion = exclusionStartIndex[atom1];
@@ -126,9 +162,13 @@ KERNEL void findNeighbors(int numAtoms, int maxNeighborBlocks, real4 periodicBox
         real4 pos = sortedPos[atom1];
         int nextBufferIndex = 0;
         
-        // Loop over atom blocks and compute the distance of this atom from each one's bounding box.
-        
-        for (int block = (atom1+1)/TILE_SIZE; block < numBlocks; block++) {
+        // Loop over the blocks that are near this atom's block and compute the distance of this atom from
+        // each one's bounding box.
+
+        int block1 = atom1/TILE_SIZE;
+        int numBlockNeighbors = blockNeighborCount[block1];
+        for (int i = 0; i < numBlockNeighbors; i++) {
+            int block = blockNeighbors[block1*maxBlockNeighbors+i];
             real4 center = blockCenter[block];
             real4 blockSize = blockBoundingBox[block];
             real4 blockDelta = center-pos;
@@ -148,10 +188,10 @@ KERNEL void findNeighbors(int numAtoms, int maxNeighborBlocks, real4 periodicBox
             for (int atom2 = first; atom2 < last; atom2++) {
                 // Skip over excluded interactions.
 
-                if (nextExclusion < lastExclusion && exclusions[nextExclusion] >= atom2) {
+                while (nextExclusion < lastExclusion && exclusions[nextExclusion] < atom2)
                     nextExclusion++;
+                if (nextExclusion < lastExclusion && exclusions[nextExclusion] == atom2)
                     continue;
-                }
                 real4 delta = pos-sortedPos[atom2];
 #ifdef USE_PERIODIC
                 APPLY_PERIODIC_TO_DELTA(delta)
@@ -350,8 +390,8 @@ KERNEL void computeForce(
     const unsigned int warp = GLOBAL_ID/TILE_SIZE;
     mixed energy = 0;
 #ifdef USE_CUTOFF
-    const int numBlocks = *neighborBlockCount;
-    if (numBlocks > maxNeighborBlocks)
+    const int numBlocks = neighborBlockCount[0];
+    if (numBlocks > maxNeighborBlocks || neighborBlockCount[1] != 0)
         return; // There wasn't enough memory for the neighbor list.
     for (int block = GLOBAL_ID; block < numBlocks; block += GLOBAL_SIZE) {
         // Load parameters for atom1.
@@ -799,6 +799,143 @@ KERNEL void runCCMA(int constrainVelocities, GLOBAL const int* RESTRICT atoms, G
     }
 }
 
+/**
+ * Compute the direction of each LINCS constraint from the positions at the start of the step, along
+ * with the right hand side of the matrix equation, which is also the first term of its solution.
+ */
+KERNEL void computeLincsDirections(int constrainVelocities, GLOBAL const int2* RESTRICT constraintAtoms, GLOBAL mixed4* RESTRICT constraintDistance,
+        GLOBAL const real4* RESTRICT atomPositions, GLOBAL const mixed4* RESTRICT posDelta, GLOBAL const mixed4* RESTRICT velm,
+        GLOBAL const mixed* RESTRICT sMatrix, GLOBAL mixed* RESTRICT rhs, GLOBAL mixed* RESTRICT solution
+#ifdef USE_MIXED_PRECISION
+        , GLOBAL const real4* RESTRICT posqCorrection
+#endif
+        ) {
+#ifndef USE_MIXED_PRECISION
+        GLOBAL real4* posqCorrection = 0;
+#endif
+    for (int index = GLOBAL_ID; index < NUM_CCMA_CONSTRAINTS; index += GLOBAL_SIZE) {
+        int2 atoms = constraintAtoms[index];
+        mixed4 dir = constraintDistance[index];
+        mixed4 oldPos1 = loadPos(atomPositions, posqCorrection, atoms.x);
+        mixed4 oldPos2 = loadPos(atomPositions, posqCorrection, atoms.y);
+        mixed dx = oldPos1.x-oldPos2.x;
+        mixed dy = oldPos1.y-oldPos2.y;
+        mixed dz = oldPos1.z-oldPos2.z;
+        mixed invLength = 1/sqrt(dx*dx + dy*dy + dz*dz);
+        dir.x = dx*invLength;
+        dir.y = dy*invLength;
+        dir.z = dz*invLength;
+        constraintDistance[index] = dir;
+        mixed value;
+        if (constrainVelocities) {
+            mixed4 v1 = velm[atoms.x];
+            mixed4 v2 = velm[atoms.y];
+            value = dir.x*(v1.x-v2.x) + dir.y*(v1.y-v2.y) + dir.z*(v1.z-v2.z);
+        }
+        else {
+            mixed4 delta1 = posDelta[atoms.x];
+            mixed4 delta2 = posDelta[atoms.y];
+            value = dir.x*(dx+delta1.x-delta2.x) + dir.y*(dy+delta1.y-delta2.y) + dir.z*(dz+delta1.z-delta2.z) - dir.w;
+        }
+        value *= sMatrix[index];
+        rhs[index] = value;
+        solution[index] = value;
+    }
+}
+
+/**
+ * Compute the elements of the LINCS coupling matrix from the current constraint directions.
+ */
+KERNEL void computeLincsMatrix(GLOBAL const mixed4* RESTRICT constraintDistance, GLOBAL const int* RESTRICT coupledConstraints,
+        GLOBAL const mixed* RESTRICT couplingCoefficients, GLOBAL mixed* RESTRICT couplingMatrix) {
+    for (int index = GLOBAL_ID; index < NUM_CCMA_CONSTRAINTS; index += GLOBAL_SIZE) {
+        mixed4 dir1 = constraintDistance[index];
+        for (int i = 0; ; i++) {
+            int element = index+i*NUM_CCMA_CONSTRAINTS;
+            int column = coupledConstraints[element];
+            if (column >= NUM_CCMA_CONSTRAINTS)
+                break;
+            mixed4 dir2 = constraintDistance[column];
+            couplingMatrix[element] = couplingCoefficients[element]*(dir1.x*dir2.x + dir1.y*dir2.y + dir1.z*dir2.z);
+        }
+    }
+}
+
+/**
+ * Compute the next term in the expansion of the LINCS matrix inverse and add it to the solution.
+ */
+KERNEL void multiplyByLincsMatrix(GLOBAL const mixed* RESTRICT rhs1, GLOBAL mixed* RESTRICT rhs2, GLOBAL mixed* RESTRICT solution,
+        GLOBAL const int* RESTRICT coupledConstraints, GLOBAL const mixed* RESTRICT couplingMatrix) {
+    for (int index = GLOBAL_ID; index < NUM_CCMA_CONSTRAINTS; index += GLOBAL_SIZE) {
+        mixed sum = 0;
+        for (int i = 0; ; i++) {
+            int element = index+i*NUM_CCMA_CONSTRAINTS;
+            int column = coupledConstraints[element];
+            if (column >= NUM_CCMA_CONSTRAINTS)
+                break;
+            sum += couplingMatrix[element]*rhs1[column];
+        }
+        rhs2[index] = sum;
+        solution[index] += sum;
+    }
+}
+
+/**
+ * Update the atom positions or velocities based on the solution to the LINCS matrix equation.
+ */
+KERNEL void updateLincsAtoms(GLOBAL const int* RESTRICT atoms, GLOBAL const int* RESTRICT numAtomConstraints, GLOBAL const int* RESTRICT atomConstraints,
+        GLOBAL const mixed4* RESTRICT constraintDistance, GLOBAL const mixed* RESTRICT sMatrix, GLOBAL const mixed* RESTRICT solution,
+        GLOBAL mixed4* RESTRICT atomPositions, GLOBAL const mixed4* RESTRICT velm) {
+    for (int i = GLOBAL_ID; i < NUM_CCMA_ATOMS; i += GLOBAL_SIZE) {
+        int index = atoms[i];
+        mixed4 atomPos = atomPositions[index];
+        mixed invMass = velm[index].w;
+        int num = numAtomConstraints[index];
+        for (int j = 0; j < num; j++) {
+            int constraint = atomConstraints[index+j*NUM_ATOMS];
+            bool forward = (constraint > 0);
+            constraint = (forward ? constraint-1 : -constraint-1);
+            mixed scale = invMass*sMatrix[constraint]*solution[constraint];
+            scale = (forward ? -scale : scale);
+            mixed4 dir = constraintDistance[constraint];
+            atomPos.x += scale*dir.x;
+            atomPos.y += scale*dir.y;
+            atomPos.z += scale*dir.z;
+        }
+        atomPositions[index] = atomPos;
+    }
+}
+
+/**
+ * Compute the right hand side for correcting the lengthening of LINCS constraints caused by rotation.
+ */
+KERNEL void computeLincsCorrection(GLOBAL const int2* RESTRICT constraintAtoms, GLOBAL const mixed4* RESTRICT constraintDistance,
+        GLOBAL const real4* RESTRICT atomPositions, GLOBAL const mixed4* RESTRICT posDelta, GLOBAL const mixed* RESTRICT sMatrix,
+        GLOBAL mixed* RESTRICT rhs, GLOBAL mixed* RESTRICT solution
+#ifdef USE_MIXED_PRECISION
+        , GLOBAL const real4* RESTRICT posqCorrection
+#endif
+        ) {
+#ifndef USE_MIXED_PRECISION
+        GLOBAL real4* posqCorrection = 0;
+#endif
+    for (int index = GLOBAL_ID; index < NUM_CCMA_CONSTRAINTS; index += GLOBAL_SIZE) {
+        int2 atoms = constraintAtoms[index];
+        mixed distance = constraintDistance[index].w;
+        mixed4 pos1 = loadPos(atomPositions, posqCorrection, atoms.x);
+        mixed4 pos2 = loadPos(atomPositions, posqCorrection, atoms.y);
+        mixed4 delta1 = posDelta[atoms.x];
+        mixed4 delta2 = posDelta[atoms.y];
+        mixed dx = pos1.x+delta1.x-pos2.x-delta2.x;
+        mixed dy = pos1.y+delta1.y-pos2.y-delta2.y;
+        mixed dz = pos1.z+delta1.z-pos2.z-delta2.z;
+        mixed p2 = 2*distance*distance - (dx*dx + dy*dy + dz*dz);
+        mixed value = sMatrix[index]*(distance - sqrt(max(p2, (mixed) 0)));
+        rhs[index] = value;
+        solution[index] = value;
+    }
+}
+
 /**
  * Compute the positions of virtual sites
  */
@@ -809,7 +946,8 @@ KERNEL void computeVirtualSites(GLOBAL real4* RESTRICT posq, GLOBAL real4* RESTR
         GLOBAL const int* RESTRICT localCoordsIndex, GLOBAL const int* RESTRICT localCoordsAtoms,
         GLOBAL const real* RESTRICT localCoordsWeights, GLOBAL const real4* RESTRICT localCoordsPos,
         GLOBAL const int* RESTRICT localCoordsStartIndex, GLOBAL const int* RESTRICT vsiteStage,
-        int currentStage) {
+        int currentStage, GLOBAL const int4* RESTRICT waterAtoms, GLOBAL const int* RESTRICT waterSecondSite,
+        GLOBAL const real4* RESTRICT waterWeights) {
     
     // Two particle average sites.
     
@@ -903,6 +1041,34 @@ KERNEL void computeVirtualSites(GLOBAL real4* RESTRICT posq, GLOBAL real4* RESTR
         pos.z = origin.z + xdir.z*localPosition.x + ydir.z*localPosition.y + zdir.z*localPosition.z;
         storePos(posq, posqCorrection, siteAtomIndex, pos);
     }
+    
+    // Groups of up to two sites that share the same parent atoms, such as water models.  Their parents
+    // are never virtual sites, so they are always computed in the first stage.
+    
+#ifdef MULTIPLE_VSITE_STAGES
+    if (currentStage == 0)
+#endif
+    for (int index = GLOBAL_ID; index < NUM_WATER_VSITE_GROUPS; index += GLOBAL_SIZE) {
+        int4 atoms = waterAtoms[index];
+        int secondSite = waterSecondSite[index];
+        mixed4 pos1 = loadPos(posq, posqCorrection, atoms.y);
+        mixed4 pos2 = loadPos(posq, posqCorrection, atoms.z);
+        mixed4 pos3 = loadPos(posq, posqCorrection, atoms.w);
+        mixed4 v12 = pos2-pos1;
+        mixed4 v13 = pos3-pos1;
+        mixed4 cr = cross(v12, v13);
+        for (int j = 0; j < 2; j++) {
+            int site = (j == 0 ? atoms.x : secondSite);
+            if (site < 0)
+                break;
+            real4 weights = waterWeights[2*index+j];
+            mixed4 pos = loadPos(posq, posqCorrection, site);
+            pos.x = pos1.x*weights.x + v12.x*weights.y + v13.x*weights.z + cr.x*weights.w;
+            pos.y = pos1.y*weights.x + v12.y*weights.y + v13.y*weights.z + cr.y*weights.w;
+            pos.z = pos1.z*weights.x + v12.z*weights.y + v13.z*weights.z + cr.z*weights.w;
+            storePos(posq, posqCorrection, site, pos);
+        }
+    }
 }
 
 inline DEVICE real3 loadForce(int index, GLOBAL const mm_long* RESTRICT force) {
@@ -923,6 +1089,16 @@ inline DEVICE void addForce(int index, GLOBAL mm_long* RESTRICT force, real3 val
 #endif
 }
 
+/**
+ * Add a force to an atom that no other thread will modify.
+ */
+inline DEVICE void addExclusiveForce(int index, GLOBAL mm_long* RESTRICT force, real3 value) {
+    GLOBAL mm_ulong* f = (GLOBAL mm_ulong*) force;
+    f[index] += (mm_ulong) realToFixedPoint(value.x);
+    f[index+PADDED_NUM_ATOMS] += (mm_ulong) realToFixedPoint(value.y);
+    f[index+PADDED_NUM_ATOMS*2] += (mm_ulong) realToFixedPoint(value.z);
+}
+
 /**
  * Distribute forces from virtual sites to the atoms they are based on.
  */
@@ -933,7 +1109,8 @@ KERNEL void distributeVirtualSiteForces(GLOBAL const real4* RESTRICT posq, GLOBA
         GLOBAL const int* RESTRICT localCoordsIndex, GLOBAL const int* RESTRICT localCoordsAtoms,
         GLOBAL const real* RESTRICT localCoordsWeights, GLOBAL const real4* RESTRICT localCoordsPos,
         GLOBAL const int* RESTRICT localCoordsStartIndex, GLOBAL const int* RESTRICT vsiteStage,
-        int currentStage) {
+        int currentStage, GLOBAL const int4* RESTRICT waterAtoms, GLOBAL const int* RESTRICT waterSecondSite,
+        GLOBAL const real4* RESTRICT waterWeights) {
     
     // Two particle average sites.
     
@@ -1048,6 +1225,42 @@ KERNEL void distributeVirtualSiteForces(GLOBAL const real4* RESTRICT posq, GLOBA
             addForce(localCoordsAtoms[j], force, fresult);
         }
     }
+    
+    // Groups of sites that share the same parent atoms.  No other site uses those atoms, so
+    // the forces are accumulated for the whole group and written without atomics.
+    
+#ifdef MULTIPLE_VSITE_STAGES
+    if (currentStage == 0)
+#endif
+    for (int index = GLOBAL_ID; index < NUM_WATER_VSITE_GROUPS; index += GLOBAL_SIZE) {
+        int4 atoms = waterAtoms[index];
+        int secondSite = waterSecondSite[index];
+        mixed4 pos1 = loadPos(posq, posqCorrection, atoms.y);
+        mixed4 pos2 = loadPos(posq, posqCorrection, atoms.z);
+        mixed4 pos3 = loadPos(posq, posqCorrection, atoms.w);
+        mixed4 v12 = pos2-pos1;
+        mixed4 v13 = pos3-pos1;
+        real3 f1 = make_real3(0), f2 = make_real3(0), f3 = make_real3(0);
+        for (int j = 0; j < 2; j++) {
+            int site = (j == 0 ? atoms.x : secondSite);
+            if (site < 0)
+                break;
+            real4 weights = waterWeights[2*index+j];
+            real3 f = loadForce(site, force);
+            real3 fp2 = make_real3((real) (weights.y*f.x - weights.w*v13.z*f.y + weights.w*v13.y*f.z),
+                       (real) (weights.w*v13.z*f.x + weights.y*f.y - weights.w*v13.x*f.z),
+                       (real) (-weights.w*v13.y*f.x + weights.w*v13.x*f.y + weights.y*f.z));
+            real3 fp3 = make_real3((real) (weights.z*f.x + weights.w*v12.z*f.y - weights.w*v12.y*f.z),
+                       (real) (-weights.w*v12.z*f.x + weights.z*f.y + weights.w*v12.x*f.z),
+                       (real) (weights.w*v12.y*f.x - weights.w*v12.x*f.y + weights.z*f.z));
+            f1 += f*weights.x-fp2-fp3;
+            f2 += fp2;
+            f3 += fp3;
+        }
+        addExclusiveForce(atoms.y, force, f1);
+        addExclusiveForce(atoms.z, force, f2);
+        addExclusiveForce(atoms.w, force, f3);
+    }
 }
 
 /**
@@ -24,28 +24,25 @@ KERNEL void integrateLangevinMiddlePart1(int numAtoms, int paddedNumAtoms, GLOBA
  */
 
 KERNEL void integrateLangevinMiddlePart2(int numAtoms, GLOBAL mixed4* RESTRICT velm, GLOBAL mixed4* RESTRICT posDelta,
-        GLOBAL mixed4* RESTRICT oldDelta, GLOBAL const mixed* RESTRICT paramBuffer, GLOBAL const mixed2* RESTRICT dt, GLOBAL const float4* RESTRICT random, unsigned int randomIndex
-        ) {
+        GLOBAL mixed4* RESTRICT oldDelta, GLOBAL const mixed* RESTRICT paramBuffer, GLOBAL const mixed2* RESTRICT dt, GLOBAL const int* RESTRICT atomIndex,
+        uint2 randomKey, uint2 randomCounter) {
     mixed vscale = paramBuffer[VelScale];
     mixed noisescale = paramBuffer[NoiseScale];
     mixed halfdt = 0.5f*dt[0].y;
-    int index = GLOBAL_ID;
-    randomIndex += index;
-    while (index < numAtoms) {
+    for (int index = GLOBAL_ID; index < numAtoms; index += GLOBAL_SIZE) {
         mixed4 velocity = velm[index];
         if (velocity.w != 0.0) {
             mixed4 delta = make_mixed4(halfdt*velocity.x, halfdt*velocity.y, halfdt*velocity.z, 0);
             mixed sqrtInvMass = SQRT(velocity.w);
-            velocity.x = vscale*velocity.x + noisescale*sqrtInvMass*random[randomIndex].x;
-            velocity.y = vscale*velocity.y + noisescale*sqrtInvMass*random[randomIndex].y;
-            velocity.z = vscale*velocity.z + noisescale*sqrtInvMass*random[randomIndex].z;
+            float4 rand = philoxNormal4(randomKey, randomCounter, atomIndex[index]);
+            velocity.x = vscale*velocity.x + noisescale*sqrtInvMass*rand.x;
+            velocity.y = vscale*velocity.y + noisescale*sqrtInvMass*rand.y;
+            velocity.z = vscale*velocity.z + noisescale*sqrtInvMass*rand.z;
             velm[index] = velocity;
             delta += make_mixed4(halfdt*velocity.x, halfdt*velocity.y, halfdt*velocity.z, 0);
             posDelta[index] = delta;
             oldDelta[index] = delta;
         }
-        randomIndex += GLOBAL_SIZE;
-        index += GLOBAL_SIZE;
     }
 }
 
@@ -58,9 +55,16 @@ KERNEL void integrateLangevinMiddlePart3(int numAtoms, GLOBAL real4* RESTRICT po
          GLOBAL mixed4* RESTRICT posDelta, GLOBAL mixed4* RESTRICT oldDelta, GLOBAL const mixed2* RESTRICT dt
 #ifdef USE_MIXED_PRECISION
         , GLOBAL real4* RESTRICT posqCorrection
+#endif
+#ifdef COMPUTE_CM_MOMENTUM
+        , GLOBAL float4* RESTRICT cmMomentum
 #endif
         ) {
     mixed invDt = 1/dt[0].y;
+#ifdef COMPUTE_CM_MOMENTUM
+    LOCAL float4 cmTemp[64];
+    float4 cm = make_float4(0);
+#endif
     for (int index = GLOBAL_ID; index < numAtoms; index += GLOBAL_SIZE) {
         mixed4 velocity = velm[index];
         if (velocity.w != 0.0) {
@@ -69,6 +73,12 @@ KERNEL void integrateLangevinMiddlePart3(int numAtoms, GLOBAL real4* RESTRICT po
             velocity.y += (delta.y-oldDelta[index].y)*invDt;
             velocity.z += (delta.z-oldDelta[index].z)*invDt;
             velm[index] = velocity;
+#ifdef COMPUTE_CM_MOMENTUM
+            mixed mass = RECIP(velocity.w);
+            cm.x += (float) (velocity.x*mass);
+            cm.y += (float) (velocity.y*mass);
+            cm.z += (float) (velocity.z*mass);
+#endif
 #ifdef USE_MIXED_PRECISION
             real4 pos1 = posq[index];
             real4 pos2 = posqCorrection[index];
@@ -87,6 +97,9 @@ KERNEL void integrateLangevinMiddlePart3(int numAtoms, GLOBAL real4* RESTRICT po
 #endif
         }
     }
+#ifdef COMPUTE_CM_MOMENTUM
+    recordCMMomentum(cm, cmMomentum, cmTemp);
+#endif
 }
 
 /**
@@ -94,7 +107,8 @@ KERNEL void integrateLangevinMiddlePart3(int numAtoms, GLOBAL real4* RESTRICT po
  */
 
 KERNEL void selectLangevinStepSize(int numAtoms, int paddedNumAtoms, mixed maxStepSize, mixed errorTol, mixed friction, mixed kT, GLOBAL mixed2* RESTRICT dt,
-        GLOBAL const mixed4* RESTRICT velm, GLOBAL const mm_long* RESTRICT force, GLOBAL mixed* RESTRICT paramBuffer) {
+        GLOBAL const mixed4* RESTRICT velm, GLOBAL const mm_long* RESTRICT force, GLOBAL mixed* RESTRICT paramBuffer,
+        mixed remainingTime, GLOBAL mixed4* RESTRICT deviceTime) {
     // Calculate the error.
 
     LOCAL mixed error[256];
@@ -128,7 +142,24 @@ KERNEL void selectLangevinStepSize(int numAtoms, int paddedNumAtoms, mixed maxSt
             newStepSize = oldStepSize; // Keeping dt constant between steps improves the behavior of the integrator.
         if (newStepSize > maxStepSize)
             newStepSize = maxStepSize;
+
+        // If the step would go past the maximum time, shorten it to end there.  Then add it to the
+        // elapsed time with compensated summation, so the host only needs to read it occasionally.
+
+        mixed4 time = deviceTime[0];
+        mixed remaining = remainingTime-(time.x-time.y);
+        time.z = 0;
+        if (newStepSize >= remaining) {
+            newStepSize = remaining;
+            time.z = 1;
+        }
         dt[0].y = newStepSize;
+        mixed y = newStepSize-time.y;
+        mixed sum = time.x+y;
+        time.y = (sum-time.x)-y;
+        time.x = sum;
+        time.w = newStepSize;
+        deviceTime[0] = time;
 
         // Recalculate the integration parameters.
 
@@ -0,0 +1,262 @@
+// This file contains kernels used by CommonMinimizeKernel to perform L-BFGS energy minimization
+// on the device.  Vectors of coordinates are stored as mixed4 with one element per atom (the w
+// component is ignored).  Reductions are done in two stages: each work group writes a partial result
+// to a buffer, then reduceSum() or reduceMax() combines them into an element of the scalars array.
+
+#ifdef SUPPORTS_DOUBLE_PRECISION
+typedef double accum;
+#else
+typedef float accum;
+#endif
+
+/**
+ * Sum a value over all threads in a work group.
+ */
+DEVICE accum sumOverGroup(accum value, LOCAL_ARG volatile accum* temp) {
+    const int thread = LOCAL_ID;
+    SYNC_THREADS;
+    temp[thread] = value;
+    SYNC_THREADS;
+    for (int step = 1; step < WORK_GROUP_SIZE; step *= 2) {
+        if (thread%(2*step) == 0 && thread+step < WORK_GROUP_SIZE)
+            temp[thread] = temp[thread] + temp[thread+step];
+        SYNC_THREADS;
+    }
+    return temp[0];
+}
+
+/**
+ * Find the maximum of a value over all threads in a work group.
+ */
+DEVICE accum maxOverGroup(accum value, LOCAL_ARG volatile accum* temp) {
+    const int thread = LOCAL_ID;
+    SYNC_THREADS;
+    temp[thread] = value;
+    SYNC_THREADS;
+    for (int step = 1; step < WORK_GROUP_SIZE; step *= 2) {
+        if (thread%(2*step) == 0 && thread+step < WORK_GROUP_SIZE)
+            temp[thread] = max(temp[thread], temp[thread+step]);
+        SYNC_THREADS;
+    }
+    return temp[0];
+}
+
+/**
+ * Copy the current atom positions into a vector.
+ */
+KERNEL void getPositions(GLOBAL const real4* RESTRICT posq, GLOBAL const real4* RESTRICT posqCorrection, GLOBAL mixed4* RESTRICT x) {
+    for (int i = GLOBAL_ID; i < NUM_ATOMS; i += GLOBAL_SIZE) {
+#ifdef USE_MIXED_PRECISION
+        real4 pos1 = posq[i];
+        real4 pos2 = posqCorrection[i];
+        x[i] = make_mixed4(pos1.x+(mixed)pos2.x, pos1.y+(mixed)pos2.y, pos1.z+(mixed)pos2.z, 0);
+#else
+        real4 pos = posq[i];
+        x[i] = make_mixed4(pos.x, pos.y, pos.z, 0);
+#endif
+    }
+}
+
+/**
+ * Set x = xPrev - step*dir and copy it into the atom positions.  dir holds the product of the
+ * approximate inverse Hessian with the gradient, so the search direction is -dir.
+ */
+KERNEL void setPositions(GLOBAL real4* RESTRICT posq, GLOBAL real4* RESTRICT posqCorrection, GLOBAL mixed4* RESTRICT x,
+        GLOBAL const mixed4* RESTRICT xPrev, GLOBAL const mixed4* RESTRICT dir, mixed step) {
+    for (int i = GLOBAL_ID; i < NUM_ATOMS; i += GLOBAL_SIZE) {
+        mixed4 pos = xPrev[i]-step*dir[i];
+        x[i] = pos;
+#ifdef USE_MIXED_PRECISION
+        posq[i] = make_real4((real) pos.x, (real) pos.y, (real) pos.z, posq[i].w);
+        posqCorrection[i] = make_real4(pos.x-(real) pos.x, pos.y-(real) pos.y, pos.z-(real) pos.z, 0);
+#else
+        posq[i] = make_real4(pos.x, pos.y, pos.z, posq[i].w);
+#endif
+    }
+}
+
+/**
+ * Add harmonic restraining forces for all constraints to the force buffer, and compute the
+ * restraint energy.
+ */
+KERNEL void applyConstraintForces(GLOBAL const real4* RESTRICT posq, GLOBAL const real4* RESTRICT posqCorrection,
+        GLOBAL mm_ulong* RESTRICT force, GLOBAL const int2* RESTRICT constraintAtoms, GLOBAL const accum* RESTRICT constraintDistance,
+        accum k, GLOBAL accum* RESTRICT partial) {
+    LOCAL volatile accum temp[WORK_GROUP_SIZE];
+    accum energy = 0;
+    for (int i = GLOBAL_ID; i < NUM_CONSTRAINTS; i += GLOBAL_SIZE) {
+        int2 atoms = constraintAtoms[i];
+#ifdef USE_MIXED_PRECISION
+        real4 pos1a = posq[atoms.x], pos1b = posqCorrection[atoms.x];
+        real4 pos2a = posq[atoms.y], pos2b = posqCorrection[atoms.y];
+        accum dx = (pos2a.x+(mixed)pos2b.x)-(pos1a.x+(mixed)pos1b.x);
+        accum dy = (pos2a.y+(mixed)pos2b.y)-(pos1a.y+(mixed)pos1b.y);
+        accum dz = (pos2a.z+(mixed)pos2b.z)-(pos1a.z+(mixed)pos1b.z);
+#else
+        real4 pos1 = posq[atoms.x];
+        real4 pos2 = posq[atoms.y];
+        accum dx = pos2.x-pos1.x;
+        accum dy = pos2.y-pos1.y;
+        accum dz = pos2.z-pos1.z;
+#endif
+        accum r = sqrt(dx*dx+dy*dy+dz*dz);
+        accum dr = r-constraintDistance[i];
+        accum kdr = k*dr;
+        energy += 0.5f*kdr*dr;
+        accum scale = kdr/r;
+        ATOMIC_ADD(&force[atoms.x], (mm_ulong) realToFixedPoint((real) (scale*dx)));
+        ATOMIC_ADD(&force[atoms.x+PADDED_NUM_ATOMS], (mm_ulong) realToFixedPoint((real) (scale*dy)));
+        ATOMIC_ADD(&force[atoms.x+2*PADDED_NUM_ATOMS], (mm_ulong) realToFixedPoint((real) (scale*dz)));
+        ATOMIC_ADD(&force[atoms.y], (mm_ulong) realToFixedPoint((real) (-scale*dx)));
+        ATOMIC_ADD(&force[atoms.y+PADDED_NUM_ATOMS], (mm_ulong) realToFixedPoint((real) (-scale*dy)));
+        ATOMIC_ADD(&force[atoms.y+2*PADDED_NUM_ATOMS], (mm_ulong) realToFixedPoint((real) (-scale*dz)));
+    }
+    energy = sumOverGroup(energy, temp);
+    if (LOCAL_ID == 0)
+        partial[GROUP_ID] = energy;
+}
+
+/**
+ * Compute the maximum relative error in any constraint.
+ */
+KERNEL void computeConstraintError(GLOBAL const real4* RESTRICT posq, GLOBAL const real4* RESTRICT posqCorrection,
+        GLOBAL const int2* RESTRICT constraintAtoms, GLOBAL const accum* RESTRICT constraintDistance, GLOBAL accum* RESTRICT partial) {
+    LOCAL volatile accum temp[WORK_GROUP_SIZE];
+    accum maxError = 0;
+    for (int i = GLOBAL_ID; i < NUM_CONSTRAINTS; i += GLOBAL_SIZE) {
+        int2 atoms = constraintAtoms[i];
+#ifdef USE_MIXED_PRECISION
+        real4 pos1a = posq[atoms.x], pos1b = posqCorrection[atoms.x];
+        real4 pos2a = posq[atoms.y], pos2b = posqCorrection[atoms.y];
+        accum dx = (pos2a.x+(mixed)pos2b.x)-(pos1a.x+(mixed)pos1b.x);
+        accum dy = (pos2a.y+(mixed)pos2b.y)-(pos1a.y+(mixed)pos1b.y);
+        accum dz = (pos2a.z+(mixed)pos2b.z)-(pos1a.z+(mixed)pos1b.z);
+#else
+        real4 pos1 = posq[atoms.x];
+        real4 pos2 = posq[atoms.y];
+        accum dx = pos2.x-pos1.x;
+        accum dy = pos2.y-pos1.y;
+        accum dz = pos2.z-pos1.z;
+#endif
+        accum distance = constraintDistance[i];
+        accum error = fabs(sqrt(dx*dx+dy*dy+dz*dz)-distance)/distance;
+        maxError = max(maxError, error);
+    }
+    maxError = maxOverGroup(maxError, temp);
+    if (LOCAL_ID == 0)
+        partial[GROUP_ID] = maxError;
+}
+
+/**
+ * Convert the forces to the gradient of the energy.  Massless particles are held fixed.  If any
+ * force is too large to be accumulated reliably in fixed point, a flag is set in the scalars array.
+ */
+KERNEL void computeGradient(GLOBAL const mm_long* RESTRICT force, GLOBAL const mixed4* RESTRICT velm, GLOBAL mixed4* RESTRICT g,
+        GLOBAL accum* RESTRICT scalars, int flagIndex) {
+    const accum scale = -1/(accum) 0x100000000;
+    for (int i = GLOBAL_ID; i < NUM_ATOMS; i += GLOBAL_SIZE) {
+        accum gx = scale*force[i];
+        accum gy = scale*force[i+PADDED_NUM_ATOMS];
+        accum gz = scale*force[i+2*PADDED_NUM_ATOMS];
+        if (!(fabs(gx) < 2e9f && fabs(gy) < 2e9f && fabs(gz) < 2e9f))
+            scalars[flagIndex] = 1;
+        if (velm[i].w == 0)
+            g[i] = make_mixed4(0);
+        else
+            g[i] = make_mixed4(gx, gy, gz, 0);
+    }
+}
+
+/**
+ * Compute the dot product of two vectors.  a and b are offsets (in atoms) into the arrays, so
+ * that history vectors can be used directly.  This must be executed with exactly one partial
+ * result per work group.
+ */
+KERNEL void dotProduct(GLOBAL const mixed4* RESTRICT aArray, int aOffset, GLOBAL const mixed4* RESTRICT bArray, int bOffset,
+        GLOBAL accum* RESTRICT partial) {
+    LOCAL volatile accum temp[WORK_GROUP_SIZE];
+    GLOBAL const mixed4* a = aArray+aOffset;
+    GLOBAL const mixed4* b = bArray+bOffset;
+    accum sum = 0;
+    for (int i = GLOBAL_ID; i < NUM_ATOMS; i += GLOBAL_SIZE) {
+        mixed4 va = a[i];
+        mixed4 vb = b[i];
+        sum += (accum) va.x*vb.x + (accum) va.y*vb.y + (accum) va.z*vb.z;
+    }
+    sum = sumOverGroup(sum, temp);
+    if (LOCAL_ID == 0)
+        partial[GROUP_ID] = sum;
+}
+
+/**
+ * Sum the partial results from a previous kernel and store it in the scalars array.  This is
+ * executed as a single work group.
+ */
+KERNEL void reduceSum(GLOBAL const accum* RESTRICT partial, GLOBAL accum* RESTRICT scalars, int index) {
+    LOCAL volatile accum temp[WORK_GROUP_SIZE];
+    accum sum = 0;
+    for (int i = LOCAL_ID; i < NUM_PARTIAL; i += LOCAL_SIZE)
+        sum += partial[i];
+    sum = sumOverGroup(sum, temp);
+    if (LOCAL_ID == 0)
+        scalars[index] = sum;
+}
+
+/**
+ * Find the maximum of the partial results from a previous kernel and store it in the scalars array.
+ * This is executed as a single work group.
+ */
+KERNEL void reduceMax(GLOBAL const accum* RESTRICT partial, GLOBAL accum* RESTRICT scalars, int index) {
+    LOCAL volatile accum temp[WORK_GROUP_SIZE];
+    accum result = 0;
+    for (int i = LOCAL_ID; i < NUM_PARTIAL; i += LOCAL_SIZE)
+        result = max(result, partial[i]);
+    result = maxOverGroup(result, temp);
+    if (LOCAL_ID == 0)
+        scalars[index] = result;
+}
+
+/**
+ * Record a new pair of history vectors s = x-xPrev and y = g-gPrev.
+ */
+KERNEL void storeHistory(GLOBAL const mixed4* RESTRICT x, GLOBAL const mixed4* RESTRICT xPrev, GLOBAL const mixed4* RESTRICT g,
+        GLOBAL const mixed4* RESTRICT gPrev, GLOBAL mixed4* RESTRICT s, GLOBAL mixed4* RESTRICT y, int offset) {
+    for (int i = GLOBAL_ID; i < NUM_ATOMS; i += GLOBAL_SIZE) {
+        s[offset+i] = x[i]-xPrev[i];
+        y[offset+i] = g[i]-gPrev[i];
+    }
+}
+
+/**
+ * One step of the first loop of the L-BFGS two loop recursion: alpha = rho*(s.q), q -= alpha*y.
+ * scalars[dotIndex] holds s.q, scalars[rhoIndex] holds 1/rho = s.y, and alpha is stored in
+ * scalars[alphaIndex] for use in the second loop.
+ */
+KERNEL void updateQ(GLOBAL mixed4* RESTRICT q, GLOBAL const mixed4* RESTRICT y, int offset, GLOBAL accum* RESTRICT scalars,
+        int dotIndex, int rhoIndex, int alphaIndex) {
+    mixed alpha = (mixed) (scalars[dotIndex]/scalars[rhoIndex]);
+    if (GLOBAL_ID == 0)
+        scalars[alphaIndex] = alpha;
+    for (int i = GLOBAL_ID; i < NUM_ATOMS; i += GLOBAL_SIZE)
+        q[i] -= alpha*y[offset+i];
+}
+
+/**
+ * Scale q by the initial inverse Hessian estimate gamma = (s.y)/(y.y) from the most recent history pair.
+ */
+KERNEL void scaleQ(GLOBAL mixed4* RESTRICT q, GLOBAL const accum* RESTRICT scalars, int syIndex, int yyIndex) {
+    mixed gamma = (mixed) (scalars[syIndex]/scalars[yyIndex]);
+    for (int i = GLOBAL_ID; i < NUM_ATOMS; i += GLOBAL_SIZE)
+        q[i] *= gamma;
+}
+
+/**
+ * One step of the second loop of the L-BFGS two loop recursion: beta = rho*(y.r), r += (alpha-beta)*s.
+ */
+KERNEL void updateR(GLOBAL mixed4* RESTRICT r, GLOBAL const mixed4* RESTRICT s, int offset, GLOBAL const accum* RESTRICT scalars,
+        int dotIndex, int rhoIndex, int alphaIndex) {
+    mixed beta = (mixed) (scalars[dotIndex]/scalars[rhoIndex]);
+    mixed scale = (mixed) scalars[alphaIndex]-beta;
+    for (int i = GLOBAL_ID; i < NUM_ATOMS; i += GLOBAL_SIZE)
+        r[i] += scale*s[offset+i];
+}
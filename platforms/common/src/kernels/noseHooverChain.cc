@@ -1,7 +1,8 @@
 // Propagates a Nose Hoover chain a full timestep
 KERNEL void propagateNoseHooverChain(GLOBAL mixed2* RESTRICT chainData, GLOBAL const mixed2 * RESTRICT energySum, GLOBAL mixed2* RESTRICT scaleFactor,
                                      GLOBAL mixed* RESTRICT chainMasses, GLOBAL mixed* RESTRICT chainForces, int chainType, int chainLength, int numMTS,
-                                     int numDOFs, float timeStep, mixed kT, float frequency){
+                                     int numDOFs, float timeStep, mixed kT, float frequency, int stateOffset){
+    chainData += stateOffset;
     const mixed kineticEnergy = chainType == 0 ? energySum[0].x : energySum[0].y;
     mixed scale = 1;
     if(kineticEnergy < 1e-8) return;
@@ -50,7 +51,8 @@ KERNEL void propagateNoseHooverChain(GLOBAL mixed2* RESTRICT chainData, GLOBAL c
  * Compute total (potential + kinetic) energy of the Nose-Hoover beads
  */
 KERNEL void computeHeatBathEnergy(GLOBAL mixed* RESTRICT heatBathEnergy, int chainLength, int numDOFs,
-                                  mixed kT, float frequency, GLOBAL const mixed2* RESTRICT chainData){
+                                  mixed kT, float frequency, GLOBAL const mixed2* RESTRICT chainData, int stateOffset){
+    chainData += stateOffset;
     // Note that this is always incremented; make sure it's zeroed properly before the first call
     for(int i = 0; i < chainLength; ++i) {
         mixed prefac = i ? 1 : numDOFs;
@@ -171,3 +173,199 @@ KERNEL void reduceEnergyPair(GLOBAL const mixed2* RESTRICT sumBuffer, GLOBAL mix
     if (thread == 0)
         *result = tempBuffer[0];
 }
+
+/**
+ * Propagate one Nose Hoover chain a full timestep, and return the factor by which to scale the
+ * velocities it is coupled to.
+ */
+DEVICE mixed propagateChainState(GLOBAL mixed2* RESTRICT chainData, GLOBAL mixed* RESTRICT chainForces, mixed kineticEnergy,
+                                 int chainLength, int numMTS, int numYS, GLOBAL const mixed* RESTRICT weights,
+                                 int numDOFs, float timeStep, mixed kT, mixed frequency) {
+    const mixed beadMass = kT / (frequency * frequency);
+    const mixed firstBeadMass = numDOFs * beadMass;
+    mixed scale = 1;
+    mixed KE2 = 2.0f * kineticEnergy;
+    mixed timeOverMTS = timeStep / numMTS;
+    chainForces[0] = (KE2 - numDOFs * kT) / firstBeadMass;
+    for (int bead = 0; bead < chainLength - 1; ++bead) {
+        mixed mass = (bead == 0 ? firstBeadMass : beadMass);
+        chainForces[bead + 1] = (mass * chainData[bead].y * chainData[bead].y - kT) / beadMass;
+    }
+    for (int mts = 0; mts < numMTS; ++mts) {
+        for (int ys = 0; ys < numYS; ++ys) {
+            mixed wdt = weights[ys] * timeOverMTS;
+            chainData[chainLength-1].y += 0.5f * wdt * chainForces[chainLength-1];
+            for (int bead = chainLength - 2; bead >= 0; --bead) {
+                mixed aa = exp(-0.25f * wdt * chainData[bead + 1].y);
+                chainData[bead].y = aa * (chainData[bead].y * aa + 0.5f * wdt * chainForces[bead]);
+            }
+            // update particle velocities
+            scale *= (mixed) exp(-wdt * chainData[0].y);
+            // update the thermostat positions
+            for (int bead = 0; bead < chainLength; ++bead) {
+                chainData[bead].x += chainData[bead].y * wdt;
+            }
+            // update the forces
+            chainForces[0] = (scale * scale * KE2 - numDOFs * kT) / firstBeadMass;
+            // update thermostat velocities
+            for (int bead = 0; bead < chainLength - 1; ++bead) {
+                mixed aa = exp(-0.25f * wdt * chainData[bead + 1].y);
+                chainData[bead].y = aa * (aa * chainData[bead].y + 0.5f * wdt * chainForces[bead]);
+                mixed mass = (bead == 0 ? firstBeadMass : beadMass);
+                chainForces[bead + 1] = (mass * chainData[bead].y * chainData[bead].y - kT) / beadMass;
+            }
+            chainData[chainLength-1].y += 0.5f * wdt * chainForces[chainLength-1];
+        }
+    }
+    return scale;
+}
+
+/**
+ * Compute the kinetic energies of the particles coupled to every thermostat.  Each block
+ * contains up to WORK_GROUP_SIZE atoms or pairs from a single thermostat.  Its partial sums of the
+ * absolute (x) and relative (y) kinetic energies are written to partialEnergy.
+ */
+KERNEL void computeThermostatKineticEnergies(GLOBAL const mixed4* RESTRICT velm, GLOBAL const int* RESTRICT atoms,
+                                             GLOBAL const int2* RESTRICT pairs, GLOBAL const int4* RESTRICT blocks, int numBlocks,
+                                             GLOBAL mixed2* RESTRICT partialEnergy) {
+    LOCAL mixed2 tempBuffer[WORK_GROUP_SIZE];
+    const unsigned int thread = LOCAL_ID;
+    for (int block = GROUP_ID; block < numBlocks; block += NUM_GROUPS) {
+        int4 blockInfo = blocks[block];
+        int index = blockInfo.y+thread;
+        mixed2 energy = make_mixed2(0, 0);
+        if (index < blockInfo.z) {
+            if (blockInfo.x == 0) {
+                mixed4 v = velm[atoms[index]];
+                mixed mass = v.w == 0 ? 0 : 1 / v.w;
+                energy.x = 0.5f * mass * (v.x*v.x + v.y*v.y + v.z*v.z);
+            }
+            else {
+                int2 pair = pairs[index];
+                mixed4 v1 = velm[pair.x];
+                mixed4 v2 = velm[pair.y];
+                mixed m1 = v1.w == 0 ? 0 : 1 / v1.w;
+                mixed m2 = v2.w == 0 ? 0 : 1 / v2.w;
+                mixed4 cv;
+                cv.x = (m1*v1.x + m2*v2.x) / (m1 + m2);
+                cv.y = (m1*v1.y + m2*v2.y) / (m1 + m2);
+                cv.z = (m1*v1.z + m2*v2.z) / (m1 + m2);
+                mixed4 rv;
+                rv.x = v2.x - v1.x;
+                rv.y = v2.y - v1.y;
+                rv.z = v2.z - v1.z;
+                energy.x = 0.5f * (m1 + m2) * (cv.x*cv.x + cv.y*cv.y + cv.z*cv.z);
+                energy.y = 0.5f * (m1 * m2 / (m1 + m2)) * (rv.x*rv.x + rv.y*rv.y + rv.z*rv.z);
+            }
+        }
+        tempBuffer[thread].x = energy.x;
+        tempBuffer[thread].y = energy.y;
+        for (int i = 1; i < WORK_GROUP_SIZE; i *= 2) {
+            SYNC_THREADS;
+            if (thread%(i*2) == 0 && thread+i < WORK_GROUP_SIZE) {
+                tempBuffer[thread].x += tempBuffer[thread+i].x;
+                tempBuffer[thread].y += tempBuffer[thread+i].y;
+            }
+        }
+        if (thread == 0)
+            partialEnergy[block] = tempBuffer[0];
+        SYNC_THREADS;
+    }
+}
+
+/**
+ * Propagate every Nose Hoover chain a full timestep.  Each work group processes one thermostat:
+ * it sums the partial kinetic energies of the thermostat's blocks, then propagates its absolute
+ * and relative chains and records the velocity scale factors.
+ *
+ * chainInfo holds (chain length, number of multi time steps, number of Yoshida-Suzuki steps, degrees of freedom),
+ * chainOffsets holds (offset of the absolute chain state or -1, offset of the relative chain state or -1,
+ * relative degrees of freedom, offset into chainForces), and chainTemperatures holds (kT, frequency, relative kT,
+ * relative frequency).
+ */
+KERNEL void propagateNoseHooverChains(GLOBAL const mixed2* RESTRICT partialEnergy, GLOBAL const int2* RESTRICT chainBlocks,
+                                      GLOBAL mixed2* RESTRICT chainData, GLOBAL mixed* RESTRICT chainForces,
+                                      GLOBAL const int4* RESTRICT chainInfo, GLOBAL const int4* RESTRICT chainOffsets,
+                                      GLOBAL const mixed4* RESTRICT chainTemperatures, GLOBAL const mixed* RESTRICT weights,
+                                      GLOBAL mixed2* RESTRICT scaleFactors, int numChains, float timeStep) {
+    LOCAL mixed2 tempBuffer[WORK_GROUP_SIZE];
+    const unsigned int thread = LOCAL_ID;
+    for (int chain = GROUP_ID; chain < numChains; chain += NUM_GROUPS) {
+        int2 range = chainBlocks[chain];
+        mixed2 sum = make_mixed2(0, 0);
+        for (int block = range.x+thread; block < range.y; block += LOCAL_SIZE) {
+            sum.x += partialEnergy[block].x;
+            sum.y += partialEnergy[block].y;
+        }
+        tempBuffer[thread].x = sum.x;
+        tempBuffer[thread].y = sum.y;
+        for (int i = 1; i < WORK_GROUP_SIZE; i *= 2) {
+            SYNC_THREADS;
+            if (thread%(i*2) == 0 && thread+i < WORK_GROUP_SIZE) {
+                tempBuffer[thread].x += tempBuffer[thread+i].x;
+                tempBuffer[thread].y += tempBuffer[thread+i].y;
+            }
+        }
+        if (thread == 0) {
+            mixed2 energy = tempBuffer[0];
+            mixed2 scale = make_mixed2(1, 1);
+
+            // Skip the first step when all the velocities are still zero, since there is nothing to scale.
+
+            if (energy.x >= 1e-8) {
+                int4 info = chainInfo[chain];
+                int4 offsets = chainOffsets[chain];
+                mixed4 temperatures = chainTemperatures[chain];
+                scale.x = 0;
+                scale.y = 0;
+                if (offsets.x != -1)
+                    scale.x = propagateChainState(&chainData[offsets.x], &chainForces[offsets.w], energy.x, info.x, info.y, info.z,
+                            &weights[7*chain], info.w, timeStep, temperatures.x, temperatures.y);
+                if (offsets.y != -1)
+                    scale.y = propagateChainState(&chainData[offsets.y], &chainForces[offsets.w], energy.y, info.x, info.y, info.z,
+                            &weights[7*chain], offsets.z, timeStep, temperatures.z, temperatures.w);
+            }
+            scaleFactors[chain] = scale;
+        }
+        SYNC_THREADS;
+    }
+}
+
+/**
+ * Scale the velocities of the particles coupled to every thermostat.
+ */
+KERNEL void scaleThermostatVelocities(GLOBAL const mixed2* RESTRICT scaleFactors, GLOBAL mixed4* RESTRICT velm,
+                                      GLOBAL const int* RESTRICT atoms, GLOBAL const int* RESTRICT atomChain, int numAtoms,
+                                      GLOBAL const int2* RESTRICT pairs, GLOBAL const int* RESTRICT pairChain, int numPairs) {
+    for (int index = GLOBAL_ID; index < numAtoms+numPairs; index += GLOBAL_SIZE) {
+        if (index < numAtoms) {
+            int atom = atoms[index];
+            const mixed scale = scaleFactors[atomChain[index]].x;
+            velm[atom].x *= scale;
+            velm[atom].y *= scale;
+            velm[atom].z *= scale;
+        }
+        else {
+            int pairIndex = index-numAtoms;
+            int atom1 = pairs[pairIndex].x;
+            int atom2 = pairs[pairIndex].y;
+            mixed2 scale = scaleFactors[pairChain[pairIndex]];
+            mixed m1 = velm[atom1].w == 0 ? 0 : 1 / velm[atom1].w;
+            mixed m2 = velm[atom2].w == 0 ? 0 : 1 / velm[atom2].w;
+            mixed4 cv;
+            cv.x = (m1*velm[atom1].x + m2*velm[atom2].x) / (m1 + m2);
+            cv.y = (m1*velm[atom1].y + m2*velm[atom2].y) / (m1 + m2);
+            cv.z = (m1*velm[atom1].z + m2*velm[atom2].z) / (m1 + m2);
+            mixed4 rv;
+            rv.x = velm[atom2].x - velm[atom1].x;
+            rv.y = velm[atom2].y - velm[atom1].y;
+            rv.z = velm[atom2].z - velm[atom1].z;
+            velm[atom1].x = scale.x * cv.x - scale.y * rv.x * m2 / (m1 + m2);
+            velm[atom1].y = scale.x * cv.y - scale.y * rv.y * m2 / (m1 + m2);
+            velm[atom1].z = scale.x * cv.z - scale.y * rv.z * m2 / (m1 + m2);
+            velm[atom2].x = scale.x * cv.x + scale.y * rv.x * m1 / (m1 + m2);
+            velm[atom2].y = scale.x * cv.y + scale.y * rv.y * m1 / (m1 + m2);
+            velm[atom2].z = scale.x * cv.z + scale.y * rv.z * m1 / (m1 + m2);
+        }
+    }
+}
@@ -117,9 +117,16 @@ KERNEL void integrateNoseHooverMiddlePart4(int numAtoms, GLOBAL real4* RESTRICT
          GLOBAL mixed4* RESTRICT posDelta, GLOBAL mixed4* RESTRICT oldDelta, GLOBAL const mixed2* RESTRICT dt
 #ifdef USE_MIXED_PRECISION
         , GLOBAL real4* RESTRICT posqCorrection
+#endif
+#ifdef COMPUTE_CM_MOMENTUM
+        , GLOBAL float4* RESTRICT cmMomentum
 #endif
         ) {
     mixed invDt = 1/dt[0].y;
+#ifdef COMPUTE_CM_MOMENTUM
+    LOCAL float4 cmTemp[64];
+    float4 cm = make_float4(0);
+#endif
     for (int index = GLOBAL_ID; index < numAtoms; index += GLOBAL_SIZE) {
         mixed4 velocity = velm[index];
         if (velocity.w != 0.0) {
@@ -128,6 +135,12 @@ KERNEL void integrateNoseHooverMiddlePart4(int numAtoms, GLOBAL real4* RESTRICT
             velocity.y += (delta.y-oldDelta[index].y)*invDt;
             velocity.z += (delta.z-oldDelta[index].z)*invDt;
             velm[index] = velocity;
+#ifdef COMPUTE_CM_MOMENTUM
+            mixed mass = RECIP(velocity.w);
+            cm.x += (float) (velocity.x*mass);
+            cm.y += (float) (velocity.y*mass);
+            cm.z += (float) (velocity.z*mass);
+#endif
 #ifdef USE_MIXED_PRECISION
             real4 pos1 = posq[index];
             real4 pos2 = posqCorrection[index];
@@ -146,6 +159,9 @@ KERNEL void integrateNoseHooverMiddlePart4(int numAtoms, GLOBAL real4* RESTRICT
 #endif
         }
     }
+#ifdef COMPUTE_CM_MOMENTUM
+    recordCMMomentum(cm, cmMomentum, cmTemp);
+#endif
 }
 
 KERNEL void integrateNoseHooverHardWall(int numPairs, GLOBAL const float* RESTRICT maxPairDistance, 
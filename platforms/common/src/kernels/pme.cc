@@ -16,10 +16,157 @@ KERNEL void findAtomGridIndex(GLOBAL const real4* RESTRICT posq, GLOBAL int2* RE
         int3 gridIndex = make_int3(((int) t.x) % GRID_SIZE_X,
                                    ((int) t.y) % GRID_SIZE_Y,
                                    ((int) t.z) % GRID_SIZE_Z);
+#ifdef USE_TILED_CHARGE_SPREADING
+        // Number the grid points tile by tile, so sorting places all atoms in the same tile next to each other.
+
+        int tile = ((gridIndex.x/PME_TILE_SIZE)*NUM_TILES_Y + gridIndex.y/PME_TILE_SIZE)*NUM_TILES_Z + gridIndex.z/PME_TILE_SIZE;
+        int pointInTile = ((gridIndex.x%PME_TILE_SIZE)*PME_TILE_SIZE + gridIndex.y%PME_TILE_SIZE)*PME_TILE_SIZE + gridIndex.z%PME_TILE_SIZE;
+        pmeAtomGridIndex[atom] = make_int2(atom, tile*PME_TILE_VOLUME+pointInTile);
+#else
         pmeAtomGridIndex[atom] = make_int2(atom, gridIndex.x*GRID_SIZE_Y*GRID_SIZE_Z+gridIndex.y*GRID_SIZE_Z+gridIndex.z);
+#endif
+    }
+}
+
+#ifdef USE_TILED_CHARGE_SPREADING
+/**
+ * Find the first atom (in sorted order) whose grid index is greater than or equal to a value.
+ */
+DEVICE int findFirstAtomInTile(GLOBAL const int2* RESTRICT pmeAtomGridIndex, int key) {
+    int lower = 0;
+    int upper = NUM_ATOMS;
+    while (lower < upper) {
+        int middle = (lower+upper)/2;
+        if (pmeAtomGridIndex[middle].y < key)
+            lower = middle+1;
+        else
+            upper = middle;
     }
+    return lower;
 }
+#endif
+
+#ifdef USE_TILED_CHARGE_SPREADING
+KERNEL void gridSpreadCharge(GLOBAL const real4* RESTRICT posq,
+#ifdef USE_FIXED_POINT_CHARGE_SPREADING
+        GLOBAL mm_ulong* RESTRICT pmeGrid,
+#else
+        GLOBAL real* RESTRICT pmeGrid,
+#endif
+        real4 periodicBoxSize, real4 invPeriodicBoxSize, real4 periodicBoxVecX, real4 periodicBoxVecY, real4 periodicBoxVecZ,
+        real4 recipBoxVecX, real4 recipBoxVecY, real4 recipBoxVecZ, GLOBAL const int2* RESTRICT pmeAtomGridIndex,
+#ifdef CHARGE_FROM_SIGEPS
+        GLOBAL const float2* RESTRICT sigmaEpsilon
+#else
+        GLOBAL const real* RESTRICT charges
+#endif
+        ) {
+    // Each thread block processes one tile of the grid at a time.  The atoms in the tile are spread onto
+    // a local copy of the tile (extended by PME_ORDER-1 points along each axis), which is then added to the
+    // global grid.  This replaces most of the atomic operations on global memory with ones on local memory.
 
+#ifdef USE_FIXED_POINT_CHARGE_SPREADING
+    LOCAL mm_ulong subgrid[PME_SUBGRID_SIZE*PME_SUBGRID_SIZE*PME_SUBGRID_SIZE];
+#else
+    LOCAL real subgrid[PME_SUBGRID_SIZE*PME_SUBGRID_SIZE*PME_SUBGRID_SIZE];
+#endif
+    real3 data[PME_ORDER];
+    const real scale = RECIP((real) (PME_ORDER-1));
+    for (int tile = GROUP_ID; tile < NUM_TILES_X*NUM_TILES_Y*NUM_TILES_Z; tile += NUM_GROUPS) {
+        int firstAtom = findFirstAtomInTile(pmeAtomGridIndex, tile*PME_TILE_VOLUME);
+        int lastAtom = findFirstAtomInTile(pmeAtomGridIndex, (tile+1)*PME_TILE_VOLUME);
+        if (firstAtom == lastAtom)
+            continue;
+        for (int i = LOCAL_ID; i < PME_SUBGRID_SIZE*PME_SUBGRID_SIZE*PME_SUBGRID_SIZE; i += LOCAL_SIZE)
+            subgrid[i] = 0;
+        SYNC_THREADS;
+        for (int i = firstAtom*PME_ORDER+LOCAL_ID; i < lastAtom*PME_ORDER; i += LOCAL_SIZE) {
+            int2 atomIndex = pmeAtomGridIndex[i/PME_ORDER];
+            int atom = atomIndex.x;
+            real4 pos = posq[atom];
+#ifdef CHARGE_FROM_SIGEPS
+            const float2 sigEps = sigmaEpsilon[atom];
+            const real charge = 8*sigEps.x*sigEps.x*sigEps.x*sigEps.y;
+#else
+            const real charge = (CHARGE)*EPSILON_FACTOR;
+#endif
+            if (charge == 0)
+                continue;
+            APPLY_PERIODIC_TO_POS(pos)
+            real3 t = make_real3(pos.x*recipBoxVecX.x+pos.y*recipBoxVecY.x+pos.z*recipBoxVecZ.x,
+                                 pos.y*recipBoxVecY.y+pos.z*recipBoxVecZ.y,
+                                 pos.z*recipBoxVecZ.z);
+            t.x = (t.x-floor(t.x))*GRID_SIZE_X;
+            t.y = (t.y-floor(t.y))*GRID_SIZE_Y;
+            t.z = (t.z-floor(t.z))*GRID_SIZE_Z;
+
+            // Compute the spline coefficients.
+
+            real3 dr = make_real3(t.x-(int) t.x, t.y-(int) t.y, t.z-(int) t.z);
+            data[PME_ORDER-1] = make_real3(0);
+            data[1] = dr;
+            data[0] = make_real3(1)-dr;
+            for (int j = 3; j < PME_ORDER; j++) {
+                real div = RECIP((real) (j-1));
+                data[j-1] = div*dr*data[j-2];
+                for (int k = 1; k < (j-1); k++)
+                    data[j-k-1] = div*((dr+make_real3(k))*data[j-k-2] + (make_real3(j-k)-dr)*data[j-k-1]);
+                data[0] = div*(make_real3(1)-dr)*data[0];
+            }
+            data[PME_ORDER-1] = scale*dr*data[PME_ORDER-2];
+            for (int j = 1; j < (PME_ORDER-1); j++)
+                data[PME_ORDER-j-1] = scale*((dr+make_real3(j))*data[PME_ORDER-j-2] + (make_real3(PME_ORDER-j)-dr)*data[PME_ORDER-j-1]);
+            data[0] = scale*(make_real3(1)-dr)*data[0];
+
+            // Spread the charge onto the local grid.  The position within the tile is taken from the
+            // sort key, so it is guaranteed to be consistent with the tile the atom was assigned to.
+
+            int pointInTile = atomIndex.y-tile*PME_TILE_VOLUME;
+            int localX = pointInTile/(PME_TILE_SIZE*PME_TILE_SIZE);
+            int localY = (pointInTile/PME_TILE_SIZE)%PME_TILE_SIZE;
+            int iz = i%PME_ORDER;
+            int localZ = pointInTile%PME_TILE_SIZE + iz;
+            real dz = 0;
+            for (int j = 0; j < PME_ORDER; j++)
+                dz = j == iz ? data[j].z : dz;
+            dz *= charge;
+            for (int ix = 0; ix < PME_ORDER; ix++) {
+                int xbase = (localX+ix)*PME_SUBGRID_SIZE*PME_SUBGRID_SIZE;
+                real dzdx = dz*data[ix].x;
+                for (int iy = 0; iy < PME_ORDER; iy++) {
+                    int index = xbase + (localY+iy)*PME_SUBGRID_SIZE + localZ;
+                    real add = dzdx*data[iy].y;
+#ifdef USE_FIXED_POINT_CHARGE_SPREADING
+                    ATOMIC_ADD(&subgrid[index], (mm_ulong) realToFixedPoint(add));
+#else
+                    ATOMIC_ADD(&subgrid[index], add);
+#endif
+                }
+            }
+        }
+        SYNC_THREADS;
+
+        // Add the local grid to the global one, wrapping points that lie past the edge of the box.
+
+        int tileX = tile/(NUM_TILES_Y*NUM_TILES_Z);
+        int tileY = (tile/NUM_TILES_Z)%NUM_TILES_Y;
+        int tileZ = tile%NUM_TILES_Z;
+        for (int i = LOCAL_ID; i < PME_SUBGRID_SIZE*PME_SUBGRID_SIZE*PME_SUBGRID_SIZE; i += LOCAL_SIZE) {
+            if (subgrid[i] == 0)
+                continue;
+            int x = (tileX*PME_TILE_SIZE + i/(PME_SUBGRID_SIZE*PME_SUBGRID_SIZE)) % GRID_SIZE_X;
+            int y = (tileY*PME_TILE_SIZE + (i/PME_SUBGRID_SIZE)%PME_SUBGRID_SIZE) % GRID_SIZE_Y;
+            int z = (tileZ*PME_TILE_SIZE + i%PME_SUBGRID_SIZE) % GRID_SIZE_Z;
+            ATOMIC_ADD(&pmeGrid[x*GRID_SIZE_Y*GRID_SIZE_Z+y*GRID_SIZE_Z+z], subgrid[i]);
+#if defined(USE_FIXED_POINT_CHARGE_SPREADING) && defined(__GFX12__)
+            // See the comment in the untiled kernel below.
+            asm volatile("s_wait_storecnt 0x0");
+#endif
+        }
+        SYNC_THREADS;
+    }
+}
+#else
 KERNEL void gridSpreadCharge(GLOBAL const real4* RESTRICT posq,
 #ifdef USE_FIXED_POINT_CHARGE_SPREADING
         GLOBAL mm_ulong* RESTRICT pmeGrid,
@@ -118,6 +265,8 @@ KERNEL void gridSpreadCharge(GLOBAL const real4* RESTRICT posq,
     }
 }
 
+#endif
+
 #ifdef USE_FIXED_POINT_CHARGE_SPREADING
 
 KERNEL void finishSpreadCharge(
@@ -184,6 +333,57 @@ KERNEL void reciprocalConvolution(GLOBAL real2* RESTRICT pmeGrid, GLOBAL const r
     }
 }
 
+/**
+ * Record the factor by which reciprocalConvolution() multiplies each element of the transformed
+ * grid.  It is stored as a complex value so an FFT that supports fused convolution can apply it
+ * directly while performing the transforms.
+ */
+KERNEL void computeInfluenceFunction(GLOBAL real2* RESTRICT influence, GLOBAL const real* RESTRICT pmeBsplineModuliX,
+        GLOBAL const real* RESTRICT pmeBsplineModuliY, GLOBAL const real* RESTRICT pmeBsplineModuliZ,
+        real4 recipBoxVecX, real4 recipBoxVecY, real4 recipBoxVecZ) {
+    const unsigned int gridSize = GRID_SIZE_X*GRID_SIZE_Y*(GRID_SIZE_Z/2+1);
+#ifdef USE_LJPME
+    const real recipScaleFactor = -(2*M_PI/6)*SQRT(M_PI)*recipBoxVecX.x*recipBoxVecY.y*recipBoxVecZ.z;
+    real bfac = M_PI / EWALD_ALPHA;
+    real fac1 = 2*M_PI*M_PI*M_PI*SQRT(M_PI);
+    real fac2 = EWALD_ALPHA*EWALD_ALPHA*EWALD_ALPHA;
+    real fac3 = -2*EWALD_ALPHA*M_PI*M_PI;
+#else
+    const real recipScaleFactor = RECIP(M_PI)*recipBoxVecX.x*recipBoxVecY.y*recipBoxVecZ.z;
+#endif
+
+    for (int index = GLOBAL_ID; index < gridSize; index += GLOBAL_SIZE) {
+        int kx = index/(GRID_SIZE_Y*(GRID_SIZE_Z/2+1));
+        int remainder = index-kx*GRID_SIZE_Y*(GRID_SIZE_Z/2+1);
+        int ky = remainder/(GRID_SIZE_Z/2+1);
+        int kz = remainder-ky*(GRID_SIZE_Z/2+1);
+        int mx = (kx < (GRID_SIZE_X+1)/2) ? kx : (kx-GRID_SIZE_X);
+        int my = (ky < (GRID_SIZE_Y+1)/2) ? ky : (ky-GRID_SIZE_Y);
+        int mz = (kz < (GRID_SIZE_Z+1)/2) ? kz : (kz-GRID_SIZE_Z);
+        real mhx = mx*recipBoxVecX.x;
+        real mhy = mx*recipBoxVecY.x+my*recipBoxVecY.y;
+        real mhz = mx*recipBoxVecZ.x+my*recipBoxVecZ.y+mz*recipBoxVecZ.z;
+        real bx = pmeBsplineModuliX[kx];
+        real by = pmeBsplineModuliY[ky];
+        real bz = pmeBsplineModuliZ[kz];
+        real m2 = mhx*mhx+mhy*mhy+mhz*mhz;
+#ifdef USE_LJPME
+        real denom = recipScaleFactor/(bx*by*bz);
+        real m = SQRT(m2);
+        real m3 = m*m2;
+        real b = bfac*m;
+        real expfac = -b*b;
+        real expterm = EXP(expfac);
+        real erfcterm = ERFC(b);
+        real eterm = (fac1*erfcterm*m3 + expterm*(fac2 + fac3*m2)) * denom;
+#else
+        real denom = m2*bx*by*bz;
+        real eterm = (index == 0 ? (real) 1 : recipScaleFactor*EXP(-RECIP_EXP_FACTOR*m2)/denom);
+#endif
+        influence[index] = make_real2(eterm, 0);
+    }
+}
+
 KERNEL void gridEvaluateEnergy(GLOBAL real2* RESTRICT pmeGrid, GLOBAL mixed* RESTRICT energyBuffer,
                       GLOBAL const real* RESTRICT pmeBsplineModuliX, GLOBAL const real* RESTRICT pmeBsplineModuliY, GLOBAL const real* RESTRICT pmeBsplineModuliZ,
                       real4 recipBoxVecX, real4 recipBoxVecY, real4 recipBoxVecZ) {
@@ -0,0 +1,12 @@
+/**
+ * Add the potential energy most recently summed into energySum, multiplied by a scale factor,
+ * to the accumulated work.
+ */
+KERNEL void addEnergyToWork(GLOBAL const mixed* RESTRICT energySum, GLOBAL mixed* RESTRICT work, int numValues, float scale) {
+    if (GLOBAL_ID == 0) {
+        mixed sum = 0;
+        for (int i = 0; i < numValues; i++)
+            sum += energySum[i];
+        work[0] += scale*sum;
+    }
+}
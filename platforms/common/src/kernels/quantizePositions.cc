@@ -0,0 +1,141 @@
+#define QUANTIZED_LIMIT 0x40000000
+
+/**
+ * Round a particle's position to an integer multiple of the precision.  Values are clamped to
+ * +/- QUANTIZED_LIMIT so they cannot overflow.  combineQuantizedRange() detects clamped values and
+ * forces the host to fall back to the full positions.
+ */
+DEVICE int3 quantizePosition(GLOBAL const real4* RESTRICT posq,
+#ifdef USE_MIXED_PRECISION
+        GLOBAL const real4* RESTRICT posqCorrection,
+#endif
+        int index, mixed invPrecision) {
+    real4 pos = posq[index];
+#ifdef USE_MIXED_PRECISION
+    real4 correction = posqCorrection[index];
+    mixed3 p = make_mixed3(pos.x+(mixed) correction.x, pos.y+(mixed) correction.y, pos.z+(mixed) correction.z);
+#else
+    mixed3 p = make_mixed3(pos.x, pos.y, pos.z);
+#endif
+    const mixed limit = QUANTIZED_LIMIT;
+    mixed3 q = make_mixed3(floor(p.x*invPrecision+(mixed) 0.5), floor(p.y*invPrecision+(mixed) 0.5), floor(p.z*invPrecision+(mixed) 0.5));
+    return make_int3((int) min(max(q.x, -limit), limit), (int) min(max(q.y, -limit), limit), (int) min(max(q.z, -limit), limit));
+}
+
+/**
+ * Find the range of quantized coordinates along each axis for the particles processed by each thread block.
+ * Elements 6*GROUP_ID through 6*GROUP_ID+5 of groupRange receive the minimum and maximum along x, y, and z.
+ */
+KERNEL void findQuantizedRange(GLOBAL const real4* RESTRICT posq,
+#ifdef USE_MIXED_PRECISION
+        GLOBAL const real4* RESTRICT posqCorrection,
+#endif
+        GLOBAL int* RESTRICT groupRange, int numAtoms, mixed invPrecision) {
+    int range[6] = {0x7FFFFFFF, -0x7FFFFFFF, 0x7FFFFFFF, -0x7FFFFFFF, 0x7FFFFFFF, -0x7FFFFFFF};
+    for (int i = GLOBAL_ID; i < numAtoms; i += GLOBAL_SIZE) {
+#ifdef USE_MIXED_PRECISION
+        int3 q = quantizePosition(posq, posqCorrection, i, invPrecision);
+#else
+        int3 q = quantizePosition(posq, i, invPrecision);
+#endif
+        range[0] = min(range[0], q.x);
+        range[1] = max(range[1], q.x);
+        range[2] = min(range[2], q.y);
+        range[3] = max(range[3], q.y);
+        range[4] = min(range[4], q.z);
+        range[5] = max(range[5], q.z);
+    }
+    LOCAL int tempBuffer[WORK_GROUP_SIZE];
+    for (int j = 0; j < 6; j++) {
+        tempBuffer[LOCAL_ID] = range[j];
+        for (int i = 1; i < WORK_GROUP_SIZE; i *= 2) {
+            SYNC_THREADS;
+            if (LOCAL_ID%(i*2) == 0 && LOCAL_ID+i < WORK_GROUP_SIZE)
+                tempBuffer[LOCAL_ID] = (j%2 == 0 ? min(tempBuffer[LOCAL_ID], tempBuffer[LOCAL_ID+i]) : max(tempBuffer[LOCAL_ID], tempBuffer[LOCAL_ID+i]));
+        }
+        if (LOCAL_ID == 0)
+            groupRange[6*GROUP_ID+j] = tempBuffer[0];
+        SYNC_THREADS;
+    }
+}
+
+/**
+ * Combine the ranges found by findQuantizedRange() and choose how many bits to use for each axis.
+ * This is executed by a single thread block.  On exit, header contains the minimum along each axis
+ * followed by the number of bits for each axis.
+ */
+KERNEL void combineQuantizedRange(GLOBAL const int* RESTRICT groupRange, int numGroups, GLOBAL int* RESTRICT header) {
+    int range[6] = {0x7FFFFFFF, -0x7FFFFFFF, 0x7FFFFFFF, -0x7FFFFFFF, 0x7FFFFFFF, -0x7FFFFFFF};
+    for (int group = LOCAL_ID; group < numGroups; group += LOCAL_SIZE)
+        for (int j = 0; j < 6; j++)
+            range[j] = (j%2 == 0 ? min(range[j], groupRange[6*group+j]) : max(range[j], groupRange[6*group+j]));
+    LOCAL int tempBuffer[WORK_GROUP_SIZE];
+    for (int j = 0; j < 6; j++) {
+        tempBuffer[LOCAL_ID] = range[j];
+        for (int i = 1; i < WORK_GROUP_SIZE; i *= 2) {
+            SYNC_THREADS;
+            if (LOCAL_ID%(i*2) == 0 && LOCAL_ID+i < WORK_GROUP_SIZE)
+                tempBuffer[LOCAL_ID] = (j%2 == 0 ? min(tempBuffer[LOCAL_ID], tempBuffer[LOCAL_ID+i]) : max(tempBuffer[LOCAL_ID], tempBuffer[LOCAL_ID+i]));
+        }
+        if (LOCAL_ID == 0)
+            range[j] = tempBuffer[0];
+        SYNC_THREADS;
+    }
+    if (LOCAL_ID == 0) {
+        bool overflow = false;
+        for (int axis = 0; axis < 3; axis++) {
+            unsigned int width = (unsigned int) (range[2*axis+1]-range[2*axis]);
+            int bits = 1;
+            while (bits < 32 && (width>>bits) != 0)
+                bits++;
+            header[axis] = range[2*axis];
+            header[3+axis] = bits;
+            if (range[2*axis] <= -QUANTIZED_LIMIT || range[2*axis+1] >= QUANTIZED_LIMIT)
+                overflow = true;
+        }
+        if (overflow)
+            for (int axis = 0; axis < 3; axis++)
+                header[3+axis] = 32;
+    }
+}
+
+/**
+ * Pack the quantized positions into a bit stream.  Each particle's coordinates are stored relative to
+ * the minimum along each axis, using a fixed number of bits per axis, and particles follow each other
+ * with no padding.  Each thread writes complete 32 bit words, so no atomic operations are needed.  If
+ * more than 64 bits would be needed per particle, nothing is written and the host falls back to
+ * downloading the full positions.
+ */
+KERNEL void packQuantizedPositions(GLOBAL const real4* RESTRICT posq,
+#ifdef USE_MIXED_PRECISION
+        GLOBAL const real4* RESTRICT posqCorrection,
+#endif
+        GLOBAL const int* RESTRICT header, GLOBAL unsigned int* RESTRICT packed, int numAtoms, mixed invPrecision) {
+    int xbits = header[3], ybits = header[4], zbits = header[5];
+    int totalBits = xbits+ybits+zbits;
+    if (totalBits > 64)
+        return;
+    int numWords = (int) (((mm_long) numAtoms*totalBits+31)/32);
+    for (int word = GLOBAL_ID; word < numWords; word += GLOBAL_SIZE) {
+        mm_long wordStart = 32*(mm_long) word;
+        int firstAtom = (int) (wordStart/totalBits);
+        int lastAtom = min((int) ((wordStart+31)/totalBits), numAtoms-1);
+        unsigned int value = 0;
+        for (int atom = firstAtom; atom <= lastAtom; atom++) {
+#ifdef USE_MIXED_PRECISION
+            int3 q = quantizePosition(posq, posqCorrection, atom, invPrecision);
+#else
+            int3 q = quantizePosition(posq, atom, invPrecision);
+#endif
+            mm_ulong bits = (mm_ulong) (unsigned int) (q.x-header[0]);
+            bits |= ((mm_ulong) (unsigned int) (q.y-header[1])) << xbits;
+            bits |= ((mm_ulong) (unsigned int) (q.z-header[2])) << (xbits+ybits);
+            int shift = (int) (atom*(mm_long) totalBits-wordStart);
+            if (shift >= 0)
+                value |= (unsigned int) (bits << shift);
+            else
+                value |= (unsigned int) (bits >> (-shift));
+        }
+        packed[word] = value;
+    }
+}
@@ -0,0 +1,34 @@
+/**
+ * Generate four normally distributed random numbers with the Philox4x32-10 counter-based
+ * generator (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3", SC 2011).  The
+ * result depends only on the key, the counter, and the index, so each thread can generate
+ * the values it needs directly rather than reading them from a buffer filled in advance.
+ * Every distinct combination of arguments gives an independent set of values.
+ *
+ * @param key       the key, which is derived from the random number seed
+ * @param counter   a value that is different on every step, from IntegrationUtilities::prepareRandomCounter()
+ * @param index     identifies which of the values generated on this step to return, typically an atom index
+ */
+DEVICE float4 philoxNormal4(uint2 key, uint2 counter, unsigned int index) {
+    unsigned int c0 = index, c1 = 0, c2 = counter.x, c3 = counter.y;
+    unsigned int k0 = key.x, k1 = key.y;
+    for (int round = 0; round < 10; round++) {
+        mm_ulong p0 = ((mm_ulong) 0xD2511F53u)*c0;
+        mm_ulong p1 = ((mm_ulong) 0xCD9E8D57u)*c2;
+        c0 = ((unsigned int) (p1>>32))^c1^k0;
+        c1 = (unsigned int) p1;
+        c2 = ((unsigned int) (p0>>32))^c3^k1;
+        c3 = (unsigned int) p0;
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+
+    // Convert to normally distributed values with Box-Muller.
+
+    const float scale = 1.0f/4294967296.0f;
+    float r1 = SQRT(-2.0f*LOG(scale*max(c0, 1u)));
+    float r2 = SQRT(-2.0f*LOG(scale*max(c2, 1u)));
+    float theta1 = (2.0f*3.14159265f*scale)*c1;
+    float theta2 = (2.0f*3.14159265f*scale)*c3;
+    return make_float4(r1*COS(theta1), r1*SIN(theta1), r2*COS(theta2), r2*SIN(theta2));
+}
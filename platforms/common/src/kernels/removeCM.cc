@@ -15,28 +15,7 @@ KERNEL void calcCenterOfMassMomentum(int numAtoms, GLOBAL const mixed4* RESTRICT
         }
     }
 
-    // Sum the threads in this group.
-
-    int thread = LOCAL_ID;
-    temp[thread] = cm;
-    SYNC_THREADS;
-    if (thread < 32)
-        temp[thread] += temp[thread+32];
-    SYNC_THREADS;
-    if (thread < 16)
-        temp[thread] += temp[thread+16];
-    SYNC_THREADS;
-    if (thread < 8)
-        temp[thread] += temp[thread+8];
-    SYNC_THREADS;
-    if (thread < 4)
-        temp[thread] += temp[thread+4];
-    SYNC_THREADS;
-    if (thread < 2)
-        temp[thread] += temp[thread+2];
-    SYNC_THREADS;
-    if (thread == 0)
-        cmMomentum[GROUP_ID] = temp[thread]+temp[thread+1];
+    recordCMMomentum(cm, cmMomentum, temp);
 }
 
 /**
@@ -0,0 +1,185 @@
+/**
+ * Compute the index of a point along a 3D Hilbert curve with 8 bits per axis.  This gives
+ * the same result as hilbert_c2i(3, 8, coords).
+ */
+DEVICE unsigned int hilbertIndex(unsigned int x, unsigned int y, unsigned int z) {
+    // Interleave the bits of the coordinates.
+
+    unsigned int coords = 0;
+    for (int b = 0; b < 8; b++)
+        coords |= (((x>>b)&1)<<(3*b)) | (((y>>b)&1)<<(3*b+1)) | (((z>>b)&1)<<(3*b+2));
+    coords ^= coords>>3;
+
+    // Convert to an index one level at a time.
+
+    unsigned int index = 0;
+    unsigned int rotation = 0;
+    unsigned int flipBit = 0;
+    for (int b = 21; b >= 0; b -= 3) {
+        unsigned int bits = ((coords>>b)&7)^flipBit;
+        bits = ((bits>>rotation) | (bits<<(3-rotation)))&7;
+        index = (index<<3) | bits;
+        flipBit = 1<<rotation;
+        bits &= (0u-bits)&3;
+        while (bits != 0) {
+            bits >>= 1;
+            rotation++;
+        }
+        if (++rotation >= 3)
+            rotation -= 3;
+    }
+    index ^= 0x124924;
+    for (int d = 1; d < 24; d *= 2)
+        index ^= index>>d;
+    return index;
+}
+
+/**
+ * Find the range of atom positions.  This is executed as a single thread block, and is only
+ * used for non-periodic systems.
+ */
+KERNEL void findPositionRange(int numAtoms, GLOBAL const real4* RESTRICT posq, GLOBAL real4* RESTRICT range) {
+    LOCAL real4 minBuffer[WORK_GROUP_SIZE];
+    LOCAL real4 maxBuffer[WORK_GROUP_SIZE];
+    real4 minPos = posq[0];
+    real4 maxPos = minPos;
+    for (int i = LOCAL_ID; i < numAtoms; i += LOCAL_SIZE) {
+        real4 pos = posq[i];
+        minPos = make_real4(min(minPos.x, pos.x), min(minPos.y, pos.y), min(minPos.z, pos.z), 0);
+        maxPos = make_real4(max(maxPos.x, pos.x), max(maxPos.y, pos.y), max(maxPos.z, pos.z), 0);
+    }
+    minBuffer[LOCAL_ID] = minPos;
+    maxBuffer[LOCAL_ID] = maxPos;
+    for (int i = 1; i < WORK_GROUP_SIZE; i *= 2) {
+        SYNC_THREADS;
+        if (LOCAL_ID%(i*2) == 0 && LOCAL_ID+i < WORK_GROUP_SIZE) {
+            real4 min1 = minBuffer[LOCAL_ID], min2 = minBuffer[LOCAL_ID+i];
+            real4 max1 = maxBuffer[LOCAL_ID], max2 = maxBuffer[LOCAL_ID+i];
+            minBuffer[LOCAL_ID] = make_real4(min(min1.x, min2.x), min(min1.y, min2.y), min(min1.z, min2.z), 0);
+            maxBuffer[LOCAL_ID] = make_real4(max(max1.x, max2.x), max(max1.y, max2.y), max(max1.z, max2.z), 0);
+        }
+    }
+    SYNC_THREADS;
+    if (LOCAL_ID == 0) {
+        range[0] = minBuffer[0];
+        range[1] = maxBuffer[0];
+    }
+}
+
+/**
+ * Find the center of each molecule.  For periodic systems, also find how many box widths it
+ * must be shifted by to put the center inside the periodic box.
+ */
+KERNEL void computeMoleculeCenters(int numMolecules, GLOBAL const real4* RESTRICT posq, GLOBAL const int4* RESTRICT moleculeInfo,
+        GLOBAL const int* RESTRICT moleculeAtoms, GLOBAL real4* RESTRICT moleculeCenters, GLOBAL int4* RESTRICT moleculeCells,
+        GLOBAL int* RESTRICT invalidPosition, real4 periodicBoxSize, real4 invPeriodicBoxSize, real4 periodicBoxVecX,
+        real4 periodicBoxVecY, real4 periodicBoxVecZ) {
+    for (int index = GLOBAL_ID; index < numMolecules; index += GLOBAL_SIZE) {
+        int4 mol = moleculeInfo[index];
+        real3 center = make_real3(0);
+        for (int i = 0; i < mol.z; i++)
+            center += trimTo3(posq[mol.x+moleculeAtoms[mol.y+i]]);
+        center *= RECIP((real) mol.z);
+        if (center.x != center.x)
+            *invalidPosition = 1;
+        int4 cells = make_int4(0, 0, 0, 0);
+#ifdef USE_PERIODIC
+        cells.z = (int) floor(center.z*invPeriodicBoxSize.z);
+        center -= trimTo3(periodicBoxVecZ)*(real) cells.z;
+        cells.y = (int) floor(center.y*invPeriodicBoxSize.y);
+        center -= trimTo3(periodicBoxVecY)*(real) cells.y;
+        cells.x = (int) floor(center.x*invPeriodicBoxSize.x);
+        center.x -= periodicBoxVecX.x*cells.x;
+#endif
+        moleculeCenters[index] = make_real4(center.x, center.y, center.z, 0);
+        moleculeCells[index] = cells;
+    }
+}
+
+/**
+ * Compute the sorting key for each molecule in a group of identical molecules.  The key combines
+ * the molecule's bin along a space filling curve with its index within the group, so every
+ * key is unique and the order is reproducible.
+ */
+KERNEL void computeMoleculeKeys(int firstMolecule, int numMolecules, int useHilbert, real zigzagBinWidth,
+        GLOBAL const real4* RESTRICT moleculeCenters, GLOBAL const real4* RESTRICT range, GLOBAL mm_long* RESTRICT keys,
+        real4 periodicBoxSize, real4 invPeriodicBoxSize, real4 periodicBoxVecX, real4 periodicBoxVecY, real4 periodicBoxVecZ) {
+#ifdef USE_PERIODIC
+    real3 minPos = make_real3(0);
+    real3 maxPos = trimTo3(periodicBoxSize);
+#else
+    real3 minPos = trimTo3(range[0]);
+    real3 maxPos = trimTo3(range[1]);
+#endif
+    real binWidth = (useHilbert ? max(max(maxPos.x-minPos.x, maxPos.y-minPos.y), maxPos.z-minPos.z)/255 : zigzagBinWidth);
+    real invBinWidth = RECIP(binWidth);
+    int xbins = 1 + (int) ((maxPos.x-minPos.x)*invBinWidth);
+    int ybins = 1 + (int) ((maxPos.y-minPos.y)*invBinWidth);
+    for (int index = GLOBAL_ID; index < numMolecules; index += GLOBAL_SIZE) {
+        real4 center = moleculeCenters[firstMolecule+index];
+        int x = (int) ((center.x-minPos.x)*invBinWidth);
+        int y = (int) ((center.y-minPos.y)*invBinWidth);
+        int z = (int) ((center.z-minPos.z)*invBinWidth);
+        mm_long bin;
+        if (useHilbert)
+            bin = hilbertIndex(min(max(x, 0), 255), min(max(y, 0), 255), min(max(z, 0), 255));
+        else {
+            int yodd = y&1;
+            int zodd = z&1;
+            bin = ((mm_long) z)*xbins*ybins;
+            bin += ((mm_long) (zodd ? ybins-y : y))*xbins;
+            bin += (yodd ? xbins-x : x);
+            bin = max(bin, (mm_long) 0);
+        }
+        keys[index] = bin*numMolecules+index;
+    }
+}
+
+/**
+ * Record which molecule of a group should be moved into each position, based on the sorted keys.
+ */
+KERNEL void recordMoleculeOrder(int firstMolecule, int numMolecules, GLOBAL const mm_long* RESTRICT keys, GLOBAL int* RESTRICT moleculeSource) {
+    for (int index = GLOBAL_ID; index < numMolecules; index += GLOBAL_SIZE)
+        moleculeSource[firstMolecule+index] = firstMolecule + (int) (keys[index]%numMolecules);
+}
+
+/**
+ * Move every atom to its new position, shifting each molecule into the periodic box.  The
+ * old values of all arrays have been copied to separate arrays before this is called.
+ */
+KERNEL void applyAtomOrder(int numAtoms, int paddedNumAtoms, GLOBAL const int4* RESTRICT moleculeInfo, GLOBAL const int* RESTRICT atomMolecule,
+        GLOBAL const int* RESTRICT moleculeSource, GLOBAL const int4* RESTRICT moleculeCells, GLOBAL const real4* RESTRICT oldPosq,
+        GLOBAL real4* RESTRICT posq, GLOBAL const real4* RESTRICT oldPosqCorrection, GLOBAL real4* RESTRICT posqCorrection,
+        GLOBAL const mixed4* RESTRICT oldVelm, GLOBAL mixed4* RESTRICT velm, GLOBAL const int* RESTRICT oldAtomIndex,
+        GLOBAL int* RESTRICT atomIndex, GLOBAL const int4* RESTRICT oldCellOffsets, GLOBAL int4* RESTRICT cellOffsets,
+        GLOBAL int* RESTRICT permutation, real4 periodicBoxSize, real4 invPeriodicBoxSize, real4 periodicBoxVecX,
+        real4 periodicBoxVecY, real4 periodicBoxVecZ) {
+    for (int index = GLOBAL_ID; index < paddedNumAtoms; index += GLOBAL_SIZE) {
+        if (index >= numAtoms) {
+            permutation[index] = index;
+            continue;
+        }
+        int molecule = atomMolecule[index];
+        int sourceMolecule = moleculeSource[molecule];
+        int source = moleculeInfo[sourceMolecule].x + index-moleculeInfo[molecule].x;
+        real4 pos = oldPosq[source];
+        int4 offset = oldCellOffsets[source];
+#ifdef USE_PERIODIC
+        int4 cells = moleculeCells[sourceMolecule];
+        pos.x -= cells.x*periodicBoxVecX.x + cells.y*periodicBoxVecY.x + cells.z*periodicBoxVecZ.x;
+        pos.y -= cells.y*periodicBoxVecY.y + cells.z*periodicBoxVecZ.y;
+        pos.z -= cells.z*periodicBoxVecZ.z;
+        offset.x -= cells.x;
+        offset.y -= cells.y;
+        offset.z -= cells.z;
+#endif
+        posq[index] = pos;
+#ifdef USE_MIXED_PRECISION
+        posqCorrection[index] = oldPosqCorrection[source];
+#endif
+        velm[index] = oldVelm[source];
+        atomIndex[index] = oldAtomIndex[source];
+        cellOffsets[index] = offset;
+        permutation[index] = source;
+    }
+}
@@ -23,10 +23,62 @@ DEVICE real reduceValue(real value, LOCAL_ARG volatile real* temp) {
 }
 
 /**
- * Perform the first step of computing the RMSD.  This is executed as a single work group.
+ * Find the largest eigenvalue of a symmetric 4x4 matrix and the corresponding unit eigenvector, using
+ * the cyclic Jacobi method.  The matrix is overwritten.
  */
-KERNEL void computeRMSDPart1(int numParticles, GLOBAL const real4* RESTRICT posq, GLOBAL const real4* RESTRICT referencePos,
-        GLOBAL const int* RESTRICT particles, GLOBAL real* buffer) {
+DEVICE mixed findLargestEigenvector(mixed A[4][4], mixed* eigenvector) {
+    mixed V[4][4] = {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}};
+    for (int sweep = 0; sweep < 50; sweep++) {
+        mixed offDiagonal = 0, diagonal = 0;
+        for (int p = 0; p < 4; p++) {
+            diagonal += A[p][p]*A[p][p];
+            for (int q = p+1; q < 4; q++)
+                offDiagonal += A[p][q]*A[p][q];
+        }
+        if (offDiagonal <= (mixed) 1e-30*diagonal || offDiagonal == 0)
+            break;
+        for (int p = 0; p < 3; p++)
+            for (int q = p+1; q < 4; q++) {
+                if (A[p][q] == 0)
+                    continue;
+                mixed theta = (A[q][q]-A[p][p])/(2*A[p][q]);
+                mixed t = 1/(fabs(theta)+sqrt(theta*theta+1));
+                if (theta < 0)
+                    t = -t;
+                mixed c = 1/sqrt(t*t+1);
+                mixed s = t*c;
+                for (int k = 0; k < 4; k++) {
+                    mixed akp = A[k][p], akq = A[k][q];
+                    A[k][p] = c*akp - s*akq;
+                    A[k][q] = s*akp + c*akq;
+                }
+                for (int k = 0; k < 4; k++) {
+                    mixed apk = A[p][k], aqk = A[q][k];
+                    A[p][k] = c*apk - s*aqk;
+                    A[q][k] = s*apk + c*aqk;
+                }
+                for (int k = 0; k < 4; k++) {
+                    mixed vkp = V[k][p], vkq = V[k][q];
+                    V[k][p] = c*vkp - s*vkq;
+                    V[k][q] = s*vkp + c*vkq;
+                }
+            }
+    }
+    int best = 0;
+    for (int i = 1; i < 4; i++)
+        if (A[i][i] > A[best][best])
+            best = i;
+    for (int i = 0; i < 4; i++)
+        eigenvector[i] = V[i][best];
+    return A[best][best];
+}
+
+/**
+ * Perform the first step of computing the RMSD: find the correlation matrix, then the optimal rotation.
+ * This is executed as a single work group.
+ */
+KERNEL void computeRMSDPart1(int numParticles, mixed sumNormRef, GLOBAL const real4* RESTRICT posq, GLOBAL const real4* RESTRICT referencePos,
+        GLOBAL const int* RESTRICT particles, GLOBAL real* buffer, GLOBAL mixed* RESTRICT energyBuffer) {
     LOCAL volatile real temp[THREAD_BLOCK_SIZE];
 
     // Compute the center of the particle positions.
@@ -62,16 +114,57 @@ KERNEL void computeRMSDPart1(int numParticles, GLOBAL const real4* RESTRICT posq
             R[i][j] = reduceValue(R[i][j], temp);
     sum = reduceValue(sum, temp);
 
-    // Copy everything into the output buffer to send back to the host.
-    
+    // Find the optimal rotation and record everything needed by the second kernel.  This is a tiny
+    // amount of work, so a single thread does it.
+
     if (LOCAL_ID == 0) {
-        for (int i = 0; i < 3; i++)
-            for (int j = 0; j < 3; j++)
-                buffer[3*i+j] = R[i][j];
-        buffer[9] = sum;
+        mixed F[4][4];
+        F[0][0] =  R[0][0] + R[1][1] + R[2][2];
+        F[1][0] =  R[1][2] - R[2][1];
+        F[2][0] =  R[2][0] - R[0][2];
+        F[3][0] =  R[0][1] - R[1][0];
+        F[1][1] =  R[0][0] - R[1][1] - R[2][2];
+        F[2][1] =  R[0][1] + R[1][0];
+        F[3][1] =  R[0][2] + R[2][0];
+        F[2][2] = -R[0][0] + R[1][1] - R[2][2];
+        F[3][2] =  R[1][2] + R[2][1];
+        F[3][3] = -R[0][0] - R[1][1] + R[2][2];
+        for (int i = 0; i < 4; i++)
+            for (int j = i+1; j < 4; j++)
+                F[i][j] = F[j][i];
+        mixed q[4];
+        mixed maxEigenvalue = findLargestEigenvector(F, q);
+
+        // Compute the RMSD and the rotation matrix.
+
+        mixed msd = (sumNormRef+sum-2*maxEigenvalue)/numParticles;
+        mixed q00 = q[0]*q[0], q01 = q[0]*q[1], q02 = q[0]*q[2], q03 = q[0]*q[3];
+        mixed q11 = q[1]*q[1], q12 = q[1]*q[2], q13 = q[1]*q[3];
+        mixed q22 = q[2]*q[2], q23 = q[2]*q[3];
+        mixed q33 = q[3]*q[3];
+        buffer[0] = q00+q11-q22-q33;
+        buffer[1] = 2*(q12-q03);
+        buffer[2] = 2*(q13+q02);
+        buffer[3] = 2*(q12+q03);
+        buffer[4] = q00-q11+q22-q33;
+        buffer[5] = 2*(q23-q01);
+        buffer[6] = 2*(q13-q02);
+        buffer[7] = 2*(q23+q01);
+        buffer[8] = q00-q11-q22+q33;
         buffer[10] = center.x;
         buffer[11] = center.y;
         buffer[12] = center.z;
+        if (msd < 1e-20 || msd != msd) {
+            // The particles are perfectly aligned, so all the forces should be zero.  Numerical
+            // error can lead to NaNs, so just skip them.
+
+            buffer[9] = 0;
+        }
+        else {
+            mixed rmsd = sqrt(msd);
+            buffer[9] = 1/(rmsd*numParticles);
+            energyBuffer[0] += rmsd;
+        }
     }
 }
 
@@ -81,7 +174,7 @@ KERNEL void computeRMSDPart1(int numParticles, GLOBAL const real4* RESTRICT posq
 KERNEL void computeRMSDForces(int numParticles, int paddedNumAtoms, GLOBAL const real4* RESTRICT posq, GLOBAL const real4* RESTRICT referencePos,
         GLOBAL const int* RESTRICT particles, GLOBAL const real* buffer, GLOBAL mm_long* RESTRICT forceBuffers) {
     real3 center = make_real3(buffer[10], buffer[11], buffer[12]);
-    real scale = 1 / (real) (buffer[9]*numParticles);
+    real scale = buffer[9];
     for (int i = GLOBAL_ID; i < numParticles; i += GLOBAL_SIZE) {
         int index = particles[i];
         real3 pos = trimTo3(posq[index]) - center;
@@ -42,9 +42,16 @@ KERNEL void integrateVerletPart2(int numAtoms, GLOBAL mixed2* RESTRICT dt, GLOBA
         GLOBAL mixed4* RESTRICT velm, GLOBAL const mixed4* RESTRICT posDelta
 #ifdef USE_MIXED_PRECISION
         , GLOBAL real4* RESTRICT posqCorrection
+#endif
+#ifdef COMPUTE_CM_MOMENTUM
+        , GLOBAL float4* RESTRICT cmMomentum
 #endif
     ) {
     mixed2 stepSize = dt[0];
+#ifdef COMPUTE_CM_MOMENTUM
+    LOCAL float4 cmTemp[64];
+    float4 cm = make_float4(0);
+#endif
 #ifdef SUPPORTS_DOUBLE_PRECISION
     double oneOverDt = 1.0/stepSize.y;
 #else
@@ -81,15 +88,25 @@ KERNEL void integrateVerletPart2(int numAtoms, GLOBAL mixed2* RESTRICT dt, GLOBA
             posq[index] = pos;
 #endif
             velm[index] = velocity;
+#ifdef COMPUTE_CM_MOMENTUM
+            mixed mass = RECIP(velocity.w);
+            cm.x += (float) (velocity.x*mass);
+            cm.y += (float) (velocity.y*mass);
+            cm.z += (float) (velocity.z*mass);
+#endif
         }
     }
+#ifdef COMPUTE_CM_MOMENTUM
+    recordCMMomentum(cm, cmMomentum, cmTemp);
+#endif
 }
 
 /**
  * Select the step size to use for the next step.
  */
 
-KERNEL void selectVerletStepSize(int numAtoms, int paddedNumAtoms, mixed maxStepSize, mixed errorTol, GLOBAL mixed2* RESTRICT dt, GLOBAL const mixed4* RESTRICT velm, GLOBAL const mm_long* RESTRICT force) {
+KERNEL void selectVerletStepSize(int numAtoms, int paddedNumAtoms, mixed maxStepSize, mixed errorTol, GLOBAL mixed2* RESTRICT dt, GLOBAL const mixed4* RESTRICT velm, GLOBAL const mm_long* RESTRICT force,
+        mixed remainingTime, GLOBAL mixed4* RESTRICT deviceTime) {
     // Calculate the error.
 
     LOCAL mixed error[256];
@@ -120,6 +137,23 @@ KERNEL void selectVerletStepSize(int numAtoms, int paddedNumAtoms, mixed maxStep
             newStepSize = oldStepSize; // Keeping dt constant between steps improves the behavior of the integrator.
         if (newStepSize > maxStepSize)
             newStepSize = maxStepSize;
+
+        // If the step would go past the maximum time, shorten it to end there.  Then add it to the
+        // elapsed time with compensated summation, so the host only needs to read it occasionally.
+
+        mixed4 time = deviceTime[0];
+        mixed remaining = remainingTime-(time.x-time.y);
+        time.z = 0;
+        if (newStepSize >= remaining) {
+            newStepSize = remaining;
+            time.z = 1;
+        }
         dt[0].y = newStepSize;
+        mixed y = newStepSize-time.y;
+        mixed sum = time.x+y;
+        time.y = (sum-time.x)-y;
+        time.x = sum;
+        time.w = newStepSize;
+        deviceTime[0] = time;
     }
 }
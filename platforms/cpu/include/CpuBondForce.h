@@ -56,11 +56,21 @@ public:
      */
     void calculateForce(std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<std::vector<double> >& parameters, std::vector<OpenMM::Vec3>& forces, 
             double* totalEnergy, ReferenceBondIxn& referenceBondIxn);
+    /**
+     * Compute the forces from all bonds, using a separate ReferenceBondIxn for each thread.  This is needed
+     * when the interaction is not thread safe, for example because it evaluates compiled expressions.
+     *
+     * @param referenceBondIxns     one interaction for each thread in the ThreadPool
+     * @param energyParamDerivs     derivatives of the energy with respect to parameters are added to this
+     * @param numEnergyParamDerivs  the number of elements in energyParamDerivs
+     */
+    void calculateForce(std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<std::vector<double> >& parameters, std::vector<OpenMM::Vec3>& forces,
+            double* totalEnergy, std::vector<ReferenceBondIxn*>& referenceBondIxns, double* energyParamDerivs, int numEnergyParamDerivs);
     /**
      * This routine contains the code executed by each thread.
      */
     void threadComputeForce(ThreadPool& threads, int threadIndex, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<std::vector<double> >& parameters,
-            std::vector<OpenMM::Vec3>& forces, double* totalEnergy, ReferenceBondIxn& referenceBondIxn);
+            std::vector<OpenMM::Vec3>& forces, double* totalEnergy, ReferenceBondIxn& referenceBondIxn, double* energyParamDerivs=NULL);
 private:
     bool canAssignBond(int bond, int thread, std::vector<int>& atomThread);
     void assignBond(int bond, int thread, std::vector<int>& atomThread, std::vector<int>& bondThread, std::vector<std::set<int> >& atomBonds, std::list<int>& candidateBonds);
@@ -27,6 +27,8 @@
 
 #include "CpuNeighborList.h"
 #include "lepton/CompiledExpression.h"
+#include "lepton/CompiledVectorExpression.h"
+#include "lepton/ParsedExpression.h"
 #include "openmm/CustomGBForce.h"
 #include "openmm/internal/CompiledExpressionSet.h"
 #include "openmm/internal/ThreadPool.h"
@@ -48,15 +50,18 @@ private:
     float periodicBoxSize[3];
     float cutoffDistance, cutoffDistance2;
     int numValues, numParams;
-    const std::vector<std::set<int> > exclusions;
+    const ExclusionList exclusions;
     std::vector<CustomGBForce::ComputationType> valueTypes;
     std::vector<CustomGBForce::ComputationType> energyTypes;
     ThreadPool& threads;
     std::vector<ThreadData*> threadData;
     std::vector<double> threadEnergy;
     std::vector<std::vector<std::vector<float> > > dValuedParam;
+    std::vector<std::string> paramNames, valueNames;
+    bool useVecExpressions;
     // Workspace vectors
     std::vector<std::vector<float> > values, dEdV;
+    std::vector<float> chainRuleScale;
     // The following variables are used to make information accessible to the individual threads.
     int numberOfAtoms;
     float* posq;
@@ -99,6 +104,38 @@ private:
     void calculateOnePairValue(int index, int atom1, int atom2, ThreadData& data, float* posq, std::vector<double>* atomParameters,
                                std::vector<float>& valueArray, const fvec4& boxSize, const fvec4& invBoxSize);
 
+    /**
+     * Add a pair to the batch that will be evaluated with vectorized expressions.
+     * 
+     * @param data             workspace for the current thread
+     * @param atom1            the index of the first atom in the pair
+     * @param atom2            the index of the second atom in the pair
+     * @param deltaR           the displacement from atom2 to atom1
+     * @param r                the distance between the atoms
+     * @param atomParameters   atomParameters[atomIndex][paramterIndex]
+     * @param numValuesToLoad  the number of computed values the expressions may depend on
+     */
+
+    void addPairToBatch(ThreadData& data, int atom1, int atom2, const fvec4& deltaR, float r, std::vector<double>* atomParameters, int numValuesToLoad);
+
+    /**
+     * Evaluate the first computed value for all pairs in the current batch, and add it to the first atom of each pair.
+     */
+
+    void flushValueBatch(ThreadData& data, std::vector<float>& valueArray);
+
+    /**
+     * Evaluate an energy term for all pairs in the current batch.
+     */
+
+    void flushEnergyBatch(int index, ThreadData& data, float* forces, double& totalEnergy);
+
+    /**
+     * Apply the chain rule for all pairs in the current batch.
+     */
+
+    void flushChainRuleBatch(ThreadData& data, float* forces);
+
     /**
      * Calculate an energy term of type SingleParticle
      * 
@@ -185,7 +222,7 @@ public:
      * Construct a new CpuCustomGBForce.
      */
 
-     CpuCustomGBForce(int numAtoms, const std::vector<std::set<int> >& exclusions,
+     CpuCustomGBForce(int numAtoms, const ExclusionList& exclusions,
                         const std::vector<Lepton::CompiledExpression>& valueExpressions,
                         const std::vector<std::vector<Lepton::CompiledExpression> >& valueDerivExpressions,
                         const std::vector<std::vector<Lepton::CompiledExpression> >& valueGradientExpressions,
@@ -220,6 +257,22 @@ public:
 
     void setPeriodic(Vec3& boxSize);
 
+    /**
+     * Provide the particle pair expressions in parsed form, so that pairs can be collected into batches
+     * and evaluated with vectorized expressions.  If this is not called, every pair is evaluated with
+     * scalar expressions.  This must not be used when there are derivatives with respect to global
+     * parameters.
+     * 
+     * @param valueExpression       the expression for the first computed value
+     * @param valueDerivExpression  the derivative of the first computed value with respect to r
+     * @param energyExpressions     for every ParticlePair or ParticlePairNoExclusions energy term, the energy followed
+     *                              by its derivatives with respect to r and then to the first and second particle's
+     *                              copy of each computed value.  The list is empty for SingleParticle terms.
+     */
+
+    void setVectorizedExpressions(const Lepton::ParsedExpression& valueExpression, const Lepton::ParsedExpression& valueDerivExpression,
+                                  const std::vector<std::vector<Lepton::ParsedExpression> >& energyExpressions);
+
     /**
      * Calculate custom GB ixn
      * 
@@ -249,6 +302,9 @@ public:
                const std::vector<std::vector<Lepton::CompiledExpression> >& energyGradientExpressions,
                const std::vector<std::vector<Lepton::CompiledExpression> >& energyParamDerivExpressions,
                const std::vector<std::string>& parameterNames);
+    void initializeVecExpressions(const Lepton::CompiledVectorExpression& valueExpression, const Lepton::CompiledVectorExpression& valueDerivExpression,
+               const std::vector<std::vector<Lepton::CompiledVectorExpression> >& energyExpressions,
+               const std::vector<std::string>& parameterNames, const std::vector<std::string>& valueNames);
     CompiledExpressionSet expressionSet;
     std::vector<Lepton::CompiledExpression> valueExpressions;
     std::vector<std::vector<Lepton::CompiledExpression> > valueDerivExpressions;
@@ -265,10 +321,17 @@ public:
     double x, y, z, r;
     int firstAtom, lastAtom;
     // Workspace vectors
-    std::vector<float> value0, dVdR1, dVdR2, dVdX, dVdY, dVdZ;
+    std::vector<float> value0, dVdV0, dVdX, dVdY, dVdZ;
     std::vector<std::vector<float> > dEdV;
     std::vector<std::vector<float> > dValue0dParam;
     std::vector<float> energyParamDerivs;
+    // Vectorized expressions, and the batch of pairs they are evaluated for
+    std::vector<Lepton::CompiledVectorExpression> valueVecExpressions;
+    std::vector<std::vector<Lepton::CompiledVectorExpression> > energyVecExpressions;
+    std::vector<Lepton::CompiledVectorExpression*> allVecExpressions;
+    int batchSize, numBatched;
+    std::vector<int> batchAtom1, batchAtom2;
+    std::vector<float> rvec, batchDx, batchDy, batchDz, vecParams1, vecParams2, vecValues1, vecValues2;
 };
 
 } // namespace OpenMM
@@ -32,6 +32,7 @@
 #include "openmm/internal/vectorize.h"
 #include "lepton/CompiledVectorExpression.h"
 #include "lepton/ParsedExpression.h"
+#include <algorithm>
 #include <atomic>
 #include <map>
 #include <set>
@@ -51,7 +52,7 @@ public:
        CpuCustomNonbondedForce(ThreadPool& threads, const CpuNeighborList& neighbors);
 
        void initialize(const Lepton::ParsedExpression& energyExpression, const Lepton::ParsedExpression& forceExpression,
-                       const std::vector<std::string>& parameterNames, const std::vector<std::set<int> >& exclusions,
+                       const std::vector<std::string>& parameterNames, const ExclusionList& exclusions,
                        const std::vector<Lepton::ParsedExpression> energyParamDerivExpressions,
                        const std::vector<std::string>& computedValueNames, const std::vector<Lepton::ParsedExpression> computedValueExpressions);
 
@@ -138,7 +139,7 @@ protected:
     AlignedArray<fvec4> periodicBoxVec4;
     double cutoffDistance, switchingDistance;
     ThreadPool& threads;
-    std::vector<std::set<int> > exclusions;
+    ExclusionList exclusions;
     std::vector<ThreadData*> threadData;
     std::vector<std::string> paramNames, computedValueNames;
     std::vector<std::pair<int, int> > groupInteractions;
@@ -193,21 +194,56 @@ protected:
 
 class CpuCustomNonbondedForce::ThreadData {
 public:
-    ThreadData(const Lepton::CompiledExpression& energyExpression, const Lepton::CompiledVectorExpression& energyVecExpression,
-            const Lepton::CompiledExpression& forceExpression, const Lepton::CompiledVectorExpression& forceVecExpression, const std::vector<std::string>& parameterNames,
-            const std::vector<Lepton::CompiledExpression> energyParamDerivExpressions, const std::vector<std::string>& computedValueNames,
-            const std::vector<Lepton::CompiledExpression> computedValueExpressions, std::vector<std::vector<double> >& atomComputedValues);
-    Lepton::CompiledExpression energyExpression, forceExpression;
-    Lepton::CompiledVectorExpression energyVecExpression, forceVecExpression;
+    ThreadData(const Lepton::CompiledExpression& energyExpression, const Lepton::CompiledExpression& forceExpression,
+            const Lepton::CompiledExpression& energyForceExpression, const Lepton::CompiledVectorExpression& forceVecExpression,
+            const Lepton::CompiledVectorExpression& energyForceVecExpression, int blockSize,
+            const std::vector<std::string>& parameterNames, const std::vector<Lepton::CompiledExpression> energyParamDerivExpressions,
+            const std::vector<std::string>& computedValueNames, const std::vector<Lepton::CompiledExpression> computedValueExpressions,
+            std::vector<std::vector<double> >& atomComputedValues);
+    /**
+     * Evaluate a vectorized expression for every atom in a block.  When the block is wider than the
+     * expression, each element of the vector evaluates a different segment of the block.
+     */
+    const float* evaluateVec(const std::vector<Lepton::CompiledVectorExpression>& expressions);
+    /**
+     * Get the values of one of the expressions a vectorized expression was compiled from, as computed by
+     * the most recent call to evaluateVec().  The returned pointer is only valid until the next call to
+     * evaluateVec() or getVecResult().
+     */
+    const float* getVecResult(const std::vector<Lepton::CompiledVectorExpression>& expressions, int index);
+    Lepton::CompiledExpression energyExpression, forceExpression, energyForceExpression;
+    std::vector<Lepton::CompiledVectorExpression> forceVecExpressions, energyForceVecExpressions;
     std::vector<Lepton::CompiledExpression> computedValueExpressions, energyParamDerivExpressions;
     CompiledExpressionSet expressionSet;
     std::vector<double> particleParam, computedValues;
-    std::vector<float> rvec, vecParticle1Params, vecParticle2Params, vecParticle1Values, vecParticle2Values;
+    std::vector<float> rvec, vecParticle1Params, vecParticle2Params, vecParticle1Values, vecParticle2Values, vecResult;
     double r;
     std::vector<double> energyParamDerivs; 
     std::vector<std::vector<double> >& atomComputedValues;
 };
 
+inline const float* CpuCustomNonbondedForce::ThreadData::evaluateVec(const std::vector<Lepton::CompiledVectorExpression>& expressions) {
+    if (expressions.size() == 1)
+        return expressions[0].evaluate();
+    int width = expressions[0].getWidth();
+    for (int i = 0; i < expressions.size(); i++) {
+        const float* result = expressions[i].evaluate();
+        std::copy(result, result+width, &vecResult[i*width]);
+    }
+    return vecResult.data();
+}
+
+inline const float* CpuCustomNonbondedForce::ThreadData::getVecResult(const std::vector<Lepton::CompiledVectorExpression>& expressions, int index) {
+    if (expressions.size() == 1)
+        return expressions[0].getResult(index);
+    int width = expressions[0].getWidth();
+    for (int i = 0; i < expressions.size(); i++) {
+        const float* result = expressions[i].getResult(index);
+        std::copy(result, result+width, &vecResult[i*width]);
+    }
+    return vecResult.data();
+}
+
 /**
  * This function is called to create an instance of an appropriate subclass for the current CPU.
  */
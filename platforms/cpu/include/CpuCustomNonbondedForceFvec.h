@@ -50,7 +50,18 @@ protected:
      */
     void calculateBlockIxn(ThreadData& data, int blockIndex, float* forces, double& totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize);
 
-    template <int PERIODIC_TYPE>
+    /**
+     * Select the version of calculateBlockIxnImpl to call for a block, based on the type of periodic
+     * boundary conditions it requires.
+     */
+    template <bool USE_SWITCH>
+    void calculateBlockIxnForPeriodicType(PeriodicType periodicType, ThreadData& data, int blockIndex, float* forces, double& totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize, const fvec4& blockCenter);
+
+    /**
+     * Calculate all the interactions for one block of atoms.  The periodic boundary conditions and
+     * switching function are template parameters, so the inner loop does not need to branch on them.
+     */
+    template <int PERIODIC_TYPE, bool USE_SWITCH>
     void calculateBlockIxnImpl(ThreadData& data, int blockIndex, float* forces, double& totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize, const fvec4& blockCenter);
 
     /**
@@ -99,22 +110,35 @@ void CpuCustomNonbondedForceFvec<FVEC, BLOCK_SIZE>::calculateBlockIxn(ThreadData
             periodicType = PeriodicPerInteraction;
     }
 
-    // Call the appropriate version depending on what calculation is required for periodic boundary conditions.
-
     if (!cutoff)
-        calculateBlockIxnImpl<NoCutoff>(data, blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+        periodicType = NoCutoff;
+
+    // Call the appropriate version depending on what calculation is required for periodic boundary conditions
+    // and whether a switching function is used.
+
+    if (useSwitch)
+        calculateBlockIxnForPeriodicType<true>(periodicType, data, blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+    else
+        calculateBlockIxnForPeriodicType<false>(periodicType, data, blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+}
+
+template<typename FVEC, int BLOCK_SIZE>
+template <bool USE_SWITCH>
+void CpuCustomNonbondedForceFvec<FVEC, BLOCK_SIZE>::calculateBlockIxnForPeriodicType(PeriodicType periodicType, ThreadData& data, int blockIndex, float* forces, double& totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize, const fvec4& blockCenter) {
+    if (periodicType == NoCutoff)
+        calculateBlockIxnImpl<NoCutoff, USE_SWITCH>(data, blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
     else if (periodicType == NoPeriodic)
-        calculateBlockIxnImpl<NoPeriodic>(data, blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+        calculateBlockIxnImpl<NoPeriodic, USE_SWITCH>(data, blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
     else if (periodicType == PeriodicPerAtom)
-        calculateBlockIxnImpl<PeriodicPerAtom>(data, blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+        calculateBlockIxnImpl<PeriodicPerAtom, USE_SWITCH>(data, blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
     else if (periodicType == PeriodicPerInteraction)
-        calculateBlockIxnImpl<PeriodicPerInteraction>(data, blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+        calculateBlockIxnImpl<PeriodicPerInteraction, USE_SWITCH>(data, blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
     else if (periodicType == PeriodicTriclinic)
-        calculateBlockIxnImpl<PeriodicTriclinic>(data, blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+        calculateBlockIxnImpl<PeriodicTriclinic, USE_SWITCH>(data, blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
 }
 
 template<typename FVEC, int BLOCK_SIZE>
-template <int PERIODIC_TYPE>
+template <int PERIODIC_TYPE, bool USE_SWITCH>
 void CpuCustomNonbondedForceFvec<FVEC, BLOCK_SIZE>::calculateBlockIxnImpl(ThreadData& data, int blockIndex, float* forces, double& totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize, const fvec4& blockCenter) {
     // Load the positions and parameters of the atoms in the block.
 
@@ -170,11 +194,14 @@ void CpuCustomNonbondedForceFvec<FVEC, BLOCK_SIZE>::calculateBlockIxnImpl(Thread
         const auto inverseR = rsqrt(r2);
         const auto r = r2*inverseR;
         r.store(data.rvec.data());
-        FVEC dEdR(data.forceVecExpression.evaluate());
-        FVEC energy;
-        if (includeEnergy || useSwitch)
-            energy = FVEC(data.energyVecExpression.evaluate());
-        if (useSwitch) {
+        FVEC dEdR, energy;
+        if (includeEnergy || USE_SWITCH) {
+            dEdR = FVEC(data.evaluateVec(data.energyForceVecExpressions));
+            energy = FVEC(data.getVecResult(data.energyForceVecExpressions, 0));
+        }
+        else
+            dEdR = FVEC(data.evaluateVec(data.forceVecExpressions));
+        if (USE_SWITCH) {
             const auto t = blendZero((r-switchingDistance)*invSwitchingInterval, r>switchingDistance);
             const auto switchValue = 1+t*t*t*(-10.0f+t*(15.0f-t*6.0f));
             const auto switchDeriv = t*t*(-30.0f+t*(60.0f-t*30.0f))*invSwitchingInterval;
@@ -0,0 +1,103 @@
+
+/* Portions copyright (c) 2026 Stanford University and Simbios.
+ * Authors: Peter Eastman
+ * Contributors: 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __CPU_DPD_DYNAMICS_H__
+#define __CPU_DPD_DYNAMICS_H__
+
+#include "ReferenceDPDDynamics.h"
+#include "CpuNeighborList.h"
+#include "AlignedArray.h"
+#include "openmm/internal/ThreadPool.h"
+
+namespace OpenMM {
+
+/**
+ * This is a multithreaded version of ReferenceDPDDynamics.  Pairs are found with a CpuNeighborList,
+ * and the random numbers are generated by hashing the seed, step index, and particle indices, so
+ * the result does not depend on the order in which threads process the pairs.
+ */
+class CpuDPDDynamics : public ReferenceDPDDynamics {
+public:
+    /**
+     * Constructor.
+     *
+     * @param system       the system to simulate
+     * @param integrator   the integrator being used
+     * @param threads      thread pool for parallelizing computation
+     */
+    CpuDPDDynamics(const System& system, const DPDIntegrator& integrator, OpenMM::ThreadPool& threads);
+
+    /**
+     * Destructor.
+     */
+    ~CpuDPDDynamics();
+
+    /**
+     * Set the index of the step about to be taken.  This is combined with the random number
+     * seed to generate the noise for each pair.
+     */
+    void setStepIndex(long long step);
+
+    /**
+     * The first stage of the update algorithm.
+     */
+    void updatePart1(int numParticles, std::vector<OpenMM::Vec3>& velocities, std::vector<OpenMM::Vec3>& forces);
+
+    /**
+     * The second stage of the update algorithm.
+     */
+    void updatePart2(int numParticles, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities,
+                     std::vector<OpenMM::Vec3>& xPrime);
+
+    /**
+     * The third stage of the update algorithm.
+     */
+    void updatePart3(OpenMM::ContextImpl& context, int numParticles, std::vector<OpenMM::Vec3>& atomCoordinates,
+                     std::vector<OpenMM::Vec3>& velocities, std::vector<OpenMM::Vec3>& xPrime);
+
+private:
+    void threadUpdate1(int threadIndex);
+    void threadUpdate2a(int threadIndex);
+    void threadUpdate2b(int threadIndex);
+    void threadUpdate2c(int threadIndex);
+    void threadUpdate3(int threadIndex);
+    OpenMM::ThreadPool& threads;
+    CpuNeighborList cpuNeighborList;
+    AlignedArray<float> posq;
+    ExclusionList noExclusions;
+    std::vector<std::vector<OpenMM::Vec3> > threadDeltaV;
+    unsigned long long randomSeed;
+    long long stepIndex;
+    // The following variables are used to make information accessible to the individual threads.
+    int numParticles;
+    OpenMM::Vec3* atomCoordinates;
+    OpenMM::Vec3* velocities;
+    OpenMM::Vec3* forces;
+    OpenMM::Vec3* xPrime;
+};
+
+} // namespace OpenMM
+
+#endif // __CPU_DPD_DYNAMICS_H__
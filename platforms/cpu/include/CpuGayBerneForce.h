@@ -71,7 +71,7 @@ public:
     /**
      * Get the exclusions being used by the force.
      */
-    const std::vector<std::set<int> >& getExclusions() const;
+    const ExclusionList& getExclusions() const;
 
 private:
     struct ParticleInfo;
@@ -79,7 +79,7 @@ private:
     std::vector<ParticleInfo> particles;
     std::vector<ExceptionInfo> exceptions;
     std::set<std::pair<int, int> > exclusions;
-    std::vector<std::set<int> > particleExclusions;
+    ExclusionList particleExclusions;
     GayBerneForce::NonbondedMethod nonbondedMethod;
     double cutoffDistance, switchingDistance;
     bool useSwitchingFunction;
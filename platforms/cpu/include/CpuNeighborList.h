@@ -35,6 +35,7 @@
 #include "AlignedArray.h"
 #include "openmm/Vec3.h"
 #include "windowsExportCpu.h"
+#include "openmm/internal/ExclusionList.h"
 #include "openmm/internal/ThreadPool.h"
 #include <atomic>
 #include <set>
@@ -59,7 +60,7 @@ public:
      * @param maxDistance         the neighbor list will contain all pairs that are within this distance of each other
      * @param threads             used for parallelization
      */
-    void computeNeighborList(int numAtoms, const AlignedArray<float>& atomLocations, const std::vector<std::set<int> >& exclusions,
+    void computeNeighborList(int numAtoms, const AlignedArray<float>& atomLocations, const ExclusionList& exclusions,
             const Vec3* periodicBoxVectors, bool usePeriodic, float maxDistance, ThreadPool& threads);
     /**
      * Build a dense neighbor list, in which every atom interacts with every other (except exclusions), regardless of distance.
@@ -67,7 +68,20 @@ public:
      * @param numAtoms            the number of atoms in the system
      * @param exclusions          exclusions[i] contains the indices of all atoms with which atom i should not interact
      */
-    void createDenseNeighborList(int numAtoms, const std::vector<std::set<int> >& exclusions);
+    void createDenseNeighborList(int numAtoms, const ExclusionList& exclusions);
+    /**
+     * Remove neighbors that are no longer close to their blocks.  The full list built by the most recent call to
+     * computeNeighborList() is retained, and each call to this method rebuilds the pruned list from it, so the
+     * atoms may move by up to half the padding between calls without any interactions being lost.  This is
+     * much cheaper than computing a new list, and reduces the number of pairs the force kernels must evaluate.
+     * 
+     * @param atomLocations       the current positions of the atoms
+     * @param periodicBoxVectors  the current periodic box vectors
+     * @param usePeriodic         whether to apply periodic boundary conditions
+     * @param maxDistance         neighbors are kept if they are within this distance of any atom in the block
+     * @param threads             used for parallelization
+     */
+    void pruneNeighborList(const AlignedArray<float>& atomLocations, const Vec3* periodicBoxVectors, bool usePeriodic, float maxDistance, ThreadPool& threads);
     int getNumBlocks() const;
     int getBlockSize() const;
     /**
@@ -94,17 +108,19 @@ private:
     int blockSize;
     std::vector<int> sortedAtoms;
     std::vector<float> sortedPositions;
-    std::vector<std::vector<int> > blockNeighbors, blockExclusionIndices;
+    std::vector<std::vector<int> > blockNeighbors, blockSortedNeighbors, blockExclusionIndices;
     std::vector<std::vector<BlockExclusionMask> > blockExclusions;
+    std::vector<std::vector<int> > fullBlockNeighbors, fullBlockSortedNeighbors;
+    std::vector<std::vector<BlockExclusionMask> > fullBlockExclusions;
     // The following variables are used to make information accessible to the individual threads.
     float minx, maxx, miny, maxy, minz, maxz;
     std::vector<std::pair<int, int> > atomBins;
     Voxels* voxels;
-    const std::vector<std::set<int> >* exclusions;
+    const ExclusionList* exclusions;
     const float* atomLocations;
     Vec3 periodicBoxVectors[3];
     int numAtoms;
-    bool usePeriodic, dense;
+    bool usePeriodic, dense, isPruned;
     float maxDistance;
     std::atomic<int> atomicCounter;
 };
@@ -115,7 +131,7 @@ public:
      * This constructor is used for standard neighbor lists.  Do not call it directly.  Obtain a
      * NeighborIterator by calling getNeighborIterator() on a neighbor list.
      */
-    NeighborIterator(const std::vector<int>& neighbors, const std::vector<BlockExclusionMask>& exclusions);
+    NeighborIterator(const std::vector<int>& neighbors, const std::vector<int>& sortedNeighbors, const std::vector<BlockExclusionMask>& exclusions);
     /**
      * This constructor is used for dense neighbor lists.  Do not call it directly.  Obtain a
      * NeighborIterator by calling getNeighborIterator() on a neighbor list.
@@ -131,15 +147,21 @@ public:
      * Get the index of the current neighbor.
      */
     int getNeighbor() const;
+    /**
+     * Get the position of the current neighbor in the array returned by getSortedAtoms().  Kernels that
+     * keep copies of their per-atom data in sorted order can use this to access them contiguously.
+     */
+    int getSortedNeighbor() const;
     /**
      * Get bit flags marking which atoms in the block the current atom is excluded from interacting with.
      */
     BlockExclusionMask getExclusions() const;
 private:
     bool dense;
-    int currentAtom, currentIndex, lastAtom;
+    int currentAtom, currentSortedIndex, currentIndex, lastAtom;
     BlockExclusionMask currentExclusions;
     const std::vector<int>* neighbors;
+    const std::vector<int>* sortedNeighbors;
     const std::vector<int>* exclusionIndices;
     const std::vector<BlockExclusionMask>* exclusions;
 };
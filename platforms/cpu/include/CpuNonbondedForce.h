@@ -134,6 +134,16 @@ class CpuNonbondedForce {
 
       void setPeriodicExceptions(bool periodic);
 
+      /**---------------------------------------------------------------------------------------
+
+         Set whether to compute direct space interactions deterministically.  When this is enabled,
+         every thread accumulates its forces and energy in 64 bit fixed point, so the result does
+         not depend on the number of threads or on how work is divided between them.
+
+         --------------------------------------------------------------------------------------- */
+
+      void setDeterministic(bool deterministic);
+
       /**---------------------------------------------------------------------------------------
       
          Calculate Ewald ixn
@@ -152,7 +162,7 @@ class CpuNonbondedForce {
 
       void calculateReciprocalIxn(int numberOfAtoms, float* posq, const std::vector<Vec3>& atomCoordinates,
                                   const std::vector<std::pair<float, float> >& atomParameters, const std::vector<float> &C6params,
-                                  const std::vector<std::set<int> >& exclusions, std::vector<Vec3>& forces, double* totalEnergy) const;
+                                  const ExclusionList& exclusions, std::vector<Vec3>& forces, double* totalEnergy) const;
       
       /**---------------------------------------------------------------------------------------
       
@@ -171,7 +181,7 @@ class CpuNonbondedForce {
          --------------------------------------------------------------------------------------- */
           
       void calculateDirectIxn(int numberOfAtoms, float* posq, const std::vector<Vec3>& atomCoordinates, const std::vector<std::pair<float, float> >& atomParameters,
-            const std::vector<float>& C6params, const std::vector<std::set<int> >& exclusions, std::vector<AlignedArray<float> >& threadForce, double* totalEnergy, ThreadPool& threads);
+            const std::vector<float>& C6params, const ExclusionList& exclusions, std::vector<AlignedArray<float> >& threadForce, double* totalEnergy, ThreadPool& threads);
 
     /**
      * This routine contains the code executed by each thread.
@@ -186,6 +196,7 @@ protected:
         bool ewald;
         bool ljpme, pme;
         bool tableIsValid, expTableIsValid;
+        bool deterministic;
         const CpuNeighborList* neighborList;
         float recipBoxSize[3];
         Vec3 periodicBoxVectors[3];
@@ -205,14 +216,24 @@ protected:
         Vec3 const* atomCoordinates;
         std::pair<float, float> const* atomParameters;        
         float const *C6params;
-        std::set<int> const* exclusions;
+        const ExclusionList* exclusions;
         std::vector<AlignedArray<float> >* threadForce;
+        // Copies of the per-atom data, and per-thread force buffers, in the order given by the neighbor
+        // list's sorted atoms.  Atoms that are close in space are close in these arrays, so the block
+        // kernels can access them with much better cache locality than the original arrays.
+        AlignedArray<float> sortedPosq;
+        std::vector<float> sortedSigma, sortedEpsilon, sortedC6params;
+        std::vector<AlignedArray<float> > sortedThreadForce;
+        // Per-thread fixed point accumulators used in deterministic mode.  Forces are indexed by atom.
+        std::vector<std::vector<long long> > threadFixedForce;
+        std::vector<long long> threadFixedEnergy;
         bool includeEnergy;
         float inverseRcut6;
         float inverseRcut6Expterm;
         std::atomic<int> atomicCounter, atomicCounter2;
 
         static const float TWO_OVER_SQRT_PI;
+        static const double FIXED_POINT_SCALE;
         static const int NUM_TABLE_POINTS;
             
       /**---------------------------------------------------------------------------------------
@@ -220,7 +241,7 @@ protected:
          Calculate all the interactions for one atom block.
       
          @param blockIndex       the index of the atom block
-         @param forces           force array (forces added)
+         @param forces           force array in the neighbor list's sorted atom order (forces added)
          @param totalEnergy      total energy
             
          --------------------------------------------------------------------------------------- */
@@ -232,13 +253,25 @@ protected:
          Calculate all the interactions for one atom block.
       
          @param blockIndex       the index of the atom block
-         @param forces           force array (forces added)
+         @param forces           force array in the neighbor list's sorted atom order (forces added)
          @param totalEnergy      total energy
             
          --------------------------------------------------------------------------------------- */
           
       virtual void calculateBlockEwaldIxn(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize) = 0;
 
+      /**
+       * In deterministic mode, convert the forces and energy computed for one block to fixed point and
+       * add them to a thread's accumulators.  The block's entries in sortedForces are reset to zero.
+       */
+      void accumulateBlockFixedPoint(int blockIndex, float* sortedForces, double blockEnergy, int threadIndex);
+
+      /**
+       * In deterministic mode, add the force and energy for one excluded pair to a thread's fixed point
+       * accumulators.  The force is subtracted from atom1 and added to atom2.
+       */
+      void accumulatePairFixedPoint(int atom1, int atom2, const fvec4& force, double energy, int threadIndex);
+
       /**
        * Compute the displacement and squared distance between two points, optionally using
        * periodic boundary conditions.
@@ -275,6 +308,13 @@ protected:
       float dExptermsApprox(float R);
 };
 
+/**
+ * Get the number of atoms per block that the vectorized nonbonded kernels expect a CpuNeighborList
+ * to use.  This is 16 if the CPU supports AVX-512 or 512 bit SVE, and 8 if it supports 256 bit SVE,
+ * provided OpenMM was compiled with support for them.  Otherwise it equals getVectorWidth().
+ */
+int getCpuNonbondedBlockSize();
+
 } // namespace OpenMM
 
 // ---------------------------------------------------------------------------------------
@@ -77,12 +77,21 @@ protected:
     template<BlockType BLOCK_TYPE>
     void calculateBlockIxnHandler(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize);
 
+    /**
+     * Select the version of calculateBlockIxnImpl to call for a block, based on the type of periodic
+     * boundary conditions it requires.
+     */
+    template<BlockType BLOCK_TYPE, bool USE_SWITCH>
+    void calculateBlockIxnForPeriodicType(PeriodicType periodicType, int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize, const fvec4& blockCenter);
+
     /**
     * Templatized implementation of calculateBlockIxn. It can handle both Ewald and non-ewald interactions
     * through a template parameter since the code is so similar for the two cases. Note also that the
-    * floating-point SIMD type is also templated to allow any suitable type to be used.
+    * floating-point SIMD type is also templated to allow any suitable type to be used.  The periodic
+    * boundary conditions and switching function are template parameters as well, so the inner loop
+    * does not need to branch on them.
     */
-    template <int PERIODIC_TYPE, BlockType BLOCK_TYPE>
+    template <int PERIODIC_TYPE, BlockType BLOCK_TYPE, bool USE_SWITCH>
     void calculateBlockIxnImpl(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize, const fvec4& blockCenter);
 
     /**
@@ -146,18 +155,18 @@ void CpuNonbondedForceFvec<FVEC>::calculateBlockIxnHandler(int blockIndex, float
         using std::min;
         using std::max;
 
-        const int32_t* blockAtom = &neighborList->getSortedAtoms()[blockSize*blockIndex];
+        const float* blockPosq = &sortedPosq[4*blockSize*blockIndex];
         float minx, maxx, miny, maxy, minz, maxz;
-        minx = maxx = posq[4*blockAtom[0]];
-        miny = maxy = posq[4*blockAtom[0]+1];
-        minz = maxz = posq[4*blockAtom[0]+2];
+        minx = maxx = blockPosq[0];
+        miny = maxy = blockPosq[1];
+        minz = maxz = blockPosq[2];
         for (int i = 1; i < blockSize; i++) {
-            minx = min(minx, posq[4*blockAtom[i]]);
-            maxx = max(maxx, posq[4*blockAtom[i]]);
-            miny = min(miny, posq[4*blockAtom[i]+1]);
-            maxy = max(maxy, posq[4*blockAtom[i]+1]);
-            minz = min(minz, posq[4*blockAtom[i]+2]);
-            maxz = max(maxz, posq[4*blockAtom[i]+2]);
+            minx = min(minx, blockPosq[4*i]);
+            maxx = max(maxx, blockPosq[4*i]);
+            miny = min(miny, blockPosq[4*i+1]);
+            maxy = max(maxy, blockPosq[4*i+1]);
+            minz = min(minz, blockPosq[4*i+2]);
+            maxz = max(maxz, blockPosq[4*i+2]);
         }
         blockCenter = fvec4(0.5f*(minx+maxx), 0.5f*(miny+maxy), 0.5f*(minz+maxz), 0.0f);
         if (!(minx < cutoffDistance || miny < cutoffDistance || minz < cutoffDistance ||
@@ -173,30 +182,44 @@ void CpuNonbondedForceFvec<FVEC>::calculateBlockIxnHandler(int blockIndex, float
             periodicType = PeriodicPerInteraction;
     }
     
-    // Call the appropriate version depending on what calculation is required for periodic boundary conditions.
     if (!cutoff)
-        calculateBlockIxnImpl<NoCutoff, BLOCK_TYPE>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+        periodicType = NoCutoff;
+
+    // Call the appropriate version depending on what calculation is required for periodic boundary conditions
+    // and whether a switching function is used.
+    if (useSwitch)
+        calculateBlockIxnForPeriodicType<BLOCK_TYPE, true>(periodicType, blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+    else
+        calculateBlockIxnForPeriodicType<BLOCK_TYPE, false>(periodicType, blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+}
+
+template<typename FVEC>
+template<BlockType BLOCK_TYPE, bool USE_SWITCH>
+void CpuNonbondedForceFvec<FVEC>::calculateBlockIxnForPeriodicType(PeriodicType periodicType, int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize, const fvec4& blockCenter) {
+    if (periodicType == NoCutoff)
+        calculateBlockIxnImpl<NoCutoff, BLOCK_TYPE, USE_SWITCH>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
     else if (periodicType == NoPeriodic)
-        calculateBlockIxnImpl<NoPeriodic, BLOCK_TYPE>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+        calculateBlockIxnImpl<NoPeriodic, BLOCK_TYPE, USE_SWITCH>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
     else if (periodicType == PeriodicPerAtom)
-        calculateBlockIxnImpl<PeriodicPerAtom, BLOCK_TYPE>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+        calculateBlockIxnImpl<PeriodicPerAtom, BLOCK_TYPE, USE_SWITCH>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
     else if (periodicType == PeriodicPerInteraction)
-        calculateBlockIxnImpl<PeriodicPerInteraction, BLOCK_TYPE>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+        calculateBlockIxnImpl<PeriodicPerInteraction, BLOCK_TYPE, USE_SWITCH>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
     else if (periodicType == PeriodicTriclinic)
-        calculateBlockIxnImpl<PeriodicTriclinic, BLOCK_TYPE>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+        calculateBlockIxnImpl<PeriodicTriclinic, BLOCK_TYPE, USE_SWITCH>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
 }
 
 template<typename FVEC>
-template <int PERIODIC_TYPE, BlockType BLOCK_TYPE>
+template <int PERIODIC_TYPE, BlockType BLOCK_TYPE, bool USE_SWITCH>
 void CpuNonbondedForceFvec<FVEC>::calculateBlockIxnImpl(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize, const fvec4& blockCenter) {
-    // Load the positions and parameters of the atoms in the block.
+    // Load the positions and parameters of the atoms in the block.  All per-atom data is accessed
+    // through the sorted copies, so atom indices below are positions in the neighbor list's sorted order.
 
-    const int32_t* blockAtom = &neighborList->getSortedAtoms()[blockSize*blockIndex];
+    const int firstAtom = blockSize*blockIndex;
     fvec4 blockAtomPosq[blockSize];
     FVEC blockAtomForceX(0.0f), blockAtomForceY(0.0f), blockAtomForceZ(0.0f);
     FVEC blockAtomX, blockAtomY, blockAtomZ, blockAtomCharge;
     for (int i = 0; i < blockSize; i++) {
-        blockAtomPosq[i] = fvec4(posq+4*blockAtom[i]);
+        blockAtomPosq[i] = fvec4(&sortedPosq[4*(firstAtom+i)]);
         if (PERIODIC_TYPE == PeriodicPerAtom)
             blockAtomPosq[i] -= floor((blockAtomPosq[i]-blockCenter)*invBoxSize+0.5f)*boxSize; // :TODO: Apply one to blockAtom?
     }
@@ -204,17 +227,11 @@ void CpuNonbondedForceFvec<FVEC>::calculateBlockIxnImpl(int blockIndex, float* f
     transpose(blockAtomPosq, blockAtomX, blockAtomY, blockAtomZ, blockAtomCharge);
     blockAtomCharge *= ONE_4PI_EPS0;
 
-    // Not the most efficient way to do this, but it works across all types we care about, and this isn't where
-    // the cycles are spent anyway.
-    FVEC blockAtomSigma = {};
-    FVEC blockAtomEpsilon = {};
-    for (int i = 0; i < blockSize; ++i) {
-        ((float*)&blockAtomSigma)[i] = atomParameters[blockAtom[i]].first;
-        ((float*)&blockAtomEpsilon)[i] = atomParameters[blockAtom[i]].second;
-    }
+    const FVEC blockAtomSigma(&sortedSigma[firstAtom]);
+    const FVEC blockAtomEpsilon(&sortedEpsilon[firstAtom]);
 
-    // Ewald needs C6 data gathered from a table. Unused variable for non-ewald.
-    const FVEC C6s = (BLOCK_TYPE == BlockType::EWALD) ? FVEC(C6params, blockAtom) : FVEC();
+    // LJPME needs C6 data. Unused variable otherwise.
+    const FVEC C6s = (BLOCK_TYPE == BlockType::EWALD && ljpme) ? FVEC(&sortedC6params[firstAtom]) : FVEC();
 
     const float invSwitchingInterval = 1/(cutoffDistance-switchingDistance);
     const FVEC cutoffDistanceSquared = cutoffDistance * cutoffDistance;
@@ -225,12 +242,12 @@ void CpuNonbondedForceFvec<FVEC>::calculateBlockIxnImpl(int blockIndex, float* f
     while (neighbors.next()) {
         // Load the next neighbor.
 
-        int atom = neighbors.getNeighbor();
+        int atom = neighbors.getSortedNeighbor();
 
         // Compute the distances to the block atoms.
 
         FVEC dx, dy, dz, r2;
-        fvec4 atomPos(posq+4*atom);
+        fvec4 atomPos(&sortedPosq[4*atom]);
         if (PERIODIC_TYPE == PeriodicPerAtom)
             atomPos -= floor((atomPos-blockCenter)*invBoxSize+0.5f)*boxSize;
         getDeltaR<PERIODIC_TYPE>(atomPos, blockAtomX, blockAtomY, blockAtomZ, dx, dy, dz, r2, boxSize, invBoxSize);
@@ -244,16 +261,16 @@ void CpuNonbondedForceFvec<FVEC>::calculateBlockIxnImpl(int blockIndex, float* f
         const auto inverseR = rsqrt(r2);
         const auto r = r2*inverseR;
         FVEC energy, dEdR;
-        float atomEpsilon = atomParameters[atom].second;
+        float atomEpsilon = sortedEpsilon[atom];
         if (atomEpsilon != 0.0f) {
-            const auto sig = blockAtomSigma+atomParameters[atom].first;
+            const auto sig = blockAtomSigma+sortedSigma[atom];
             const auto sig2 = (inverseR*sig)*(inverseR*sig);
             const auto sig6 = sig2*sig2*sig2;
             const auto eps = blockAtomEpsilon*atomEpsilon;
             const auto epsSig6 = eps*sig6;
             dEdR = epsSig6*(12.0f*sig6 - 6.0f);
             energy = epsSig6*(sig6-1.0f);
-            if (useSwitch) {
+            if (USE_SWITCH) {
                 const auto t = blendZero((r-switchingDistance)*invSwitchingInterval, r>switchingDistance);
                 const auto switchValue = 1+t*t*t*(-10.0f+t*(15.0f-t*6.0f));
                 const auto switchDeriv = t*t*(-30.0f+t*(60.0f-t*30.0f))*invSwitchingInterval;
@@ -261,7 +278,7 @@ void CpuNonbondedForceFvec<FVEC>::calculateBlockIxnImpl(int blockIndex, float* f
                 energy *= switchValue;
             }
             if (BLOCK_TYPE == BlockType::EWALD && ljpme) {
-                const auto C6ij = C6s*C6params[atom];
+                const auto C6ij = C6s*sortedC6params[atom];
                 const auto inverseR2 = inverseR*inverseR;
                 const auto mysig2 = sig*sig;
                 const auto mysig6 = mysig2*mysig2*mysig2;
@@ -276,12 +293,12 @@ void CpuNonbondedForceFvec<FVEC>::calculateBlockIxnImpl(int blockIndex, float* f
             energy = 0.0f;
             dEdR = 0.0f;
         }
-        const auto chargeProd = blockAtomCharge*posq[4*atom+3];
+        const auto chargeProd = blockAtomCharge*sortedPosq[4*atom+3];
         if (BLOCK_TYPE == BlockType::EWALD) {
             dEdR += chargeProd*inverseR*approximateFunctionFromTable(ewaldScaleTable, r, FVEC(ewaldDXInv));
         }
         else {
-            if (cutoff)
+            if (PERIODIC_TYPE != NoCutoff)
                 dEdR += chargeProd*(inverseR-2.0f*krf*r2);
             else
                 dEdR += chargeProd*inverseR;
@@ -293,7 +310,7 @@ void CpuNonbondedForceFvec<FVEC>::calculateBlockIxnImpl(int blockIndex, float* f
             if (BLOCK_TYPE == BlockType::EWALD)
                 energy += chargeProd*inverseR*approximateFunctionFromTable(erfcTable, alphaEwald*r, FVEC(erfcDXInv));
             else {  // Non-ewald.
-                if (cutoff)
+                if (PERIODIC_TYPE != NoCutoff)
                     energy += chargeProd*(inverseR+krf*r2-crf);
                 else
                     energy += chargeProd*inverseR;
@@ -324,7 +341,7 @@ void CpuNonbondedForceFvec<FVEC>::calculateBlockIxnImpl(int blockIndex, float* f
     fvec4 f[blockSize];
     transpose(blockAtomForceX, blockAtomForceY, blockAtomForceZ, 0.0f, f);
     for (int j = 0; j < blockSize; j++)
-        (fvec4(forces+4*blockAtom[j])+f[j]).store(forces+4*blockAtom[j]);
+        (fvec4(forces+4*(firstAtom+j))+f[j]).store(forces+4*(firstAtom+j));
 }
 
 template<typename FVEC>
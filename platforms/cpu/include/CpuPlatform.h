@@ -37,6 +37,7 @@
 #include "CpuNeighborList.h"
 #include "ReferencePlatform.h"
 #include "openmm/internal/ContextImpl.h"
+#include "openmm/internal/PhaseProfiler.h"
 #include "openmm/internal/ThreadPool.h"
 #include "windowsExportCpu.h"
 #include <map>
@@ -61,6 +62,8 @@ public:
     static bool isProcessorSupported();
     void contextCreated(ContextImpl& context, const std::map<std::string, std::string>& properties) const;
     void contextDestroyed(ContextImpl& context) const;
+    std::map<std::string, std::pair<int, double> > getKernelTimings(Context& context) const;
+    void resetKernelTimings(Context& context) const;
     /**
      * This is the name of the parameter for selecting the number of threads to use.
      */
@@ -77,6 +80,36 @@ public:
         static const std::string key = "DeterministicForces";
         return key;
     }
+    /**
+     * This is the name of the parameter for binding worker threads to specific CPU cores.  The value may be
+     * "none" (threads are not bound), "compact" (thread i is bound to core i), "scatter" (threads are distributed
+     * round robin across physical processor packages), or a comma separated list of core indices and ranges
+     * such as "0-7,16-23".
+     */
+    static const std::string& CpuThreadAffinity() {
+        static const std::string key = "ThreadAffinity";
+        return key;
+    }
+    /**
+     * This is the name of the parameter for the maximum time in microseconds that worker threads spin while
+     * waiting for each other, before they go to sleep.  Spinning reduces the latency of every parallel phase,
+     * which helps small systems, but it should only be used when each thread has a core to itself.  The
+     * default value is "0", which means threads sleep immediately.
+     */
+    static const std::string& CpuSpinWaitTime() {
+        static const std::string key = "SpinWaitTime";
+        return key;
+    }
+    /**
+     * This is the name of the parameter for selecting whether to record the time spent in each phase of the
+     * calculation, such as building the neighbor list, computing direct and reciprocal space nonbonded
+     * interactions, computing bonded interactions, and integrating.  The times can be retrieved with
+     * getKernelTimings() on the Context.
+     */
+    static const std::string& CpuEnableProfiling() {
+        static const std::string key = "EnableProfiling";
+        return key;
+    }
     /**
      * We cannot use the standard mechanism for platform data, because that is already used by the superclass.
      * Instead, we maintain a table of ContextImpls to PlatformDatas.
@@ -103,11 +136,12 @@ public:
      * @param exclusionList   if useExclusions is true, exclusionList[i] should contain the indices of all
      *                        particles with which particle i should not interact
      */
-    void requestNeighborList(double cutoffDistance, double padding, bool useExclusions, const std::vector<std::set<int> >& exclusionList);
+    void requestNeighborList(double cutoffDistance, double padding, bool useExclusions, const ExclusionList& exclusionList);
     int requestPosqIndex();
     AlignedArray<float> posq;
     std::vector<AlignedArray<float> > threadForce;
     ThreadPool& threads;
+    PhaseProfiler profiler;
     bool isPeriodic;
     CpuRandom random;
     std::map<std::string, std::string> propertyValues;
@@ -116,7 +150,7 @@ public:
     double cutoff, paddedCutoff;
     bool anyExclusions, deterministicForces;
     int currentPosqIndex, nextPosqIndex;
-    std::vector<std::set<int> > exclusions;
+    ExclusionList exclusions;
 };
 
 } // namespace OpenMM
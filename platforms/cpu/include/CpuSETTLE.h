@@ -35,6 +35,7 @@
 #include "ReferenceSETTLEAlgorithm.h"
 #include "windowsExportCpu.h"
 #include "openmm/System.h"
+#include "openmm/internal/PhaseProfiler.h"
 #include "openmm/internal/ThreadPool.h"
 #include <vector>
 
@@ -45,7 +46,7 @@ namespace OpenMM {
  */
 class OPENMM_EXPORT_CPU CpuSETTLE : public ReferenceConstraintAlgorithm {
 public:
-    CpuSETTLE(const System& system, const ReferenceSETTLEAlgorithm& settle, ThreadPool& threads);
+    CpuSETTLE(const System& system, const ReferenceSETTLEAlgorithm& settle, ThreadPool& threads, PhaseProfiler& profiler);
     ~CpuSETTLE();
 
     /**
@@ -70,6 +71,7 @@ public:
 private:
     std::vector<ReferenceSETTLEAlgorithm*> threadSettle;
     ThreadPool& threads;
+    PhaseProfiler& profiler;
 };
 
 } // namespace OpenMM
@@ -189,12 +189,45 @@ void CpuBondForce::calculateForce(vector<Vec3>& atomCoordinates, vector<vector<d
             *totalEnergy += threadEnergy[i];
 }
 
+void CpuBondForce::calculateForce(vector<Vec3>& atomCoordinates, vector<vector<double> >& parameters, vector<Vec3>& forces,
+        double* totalEnergy, vector<ReferenceBondIxn*>& referenceBondIxns, double* energyParamDerivs, int numEnergyParamDerivs) {
+    // Have the worker threads compute their forces.  Each one accumulates parameter derivatives
+    // into its own array.  The arrays have an extra element so they are never empty.
+
+    int numThreads = threads->getNumThreads();
+    if (referenceBondIxns.size() != numThreads)
+        throw OpenMMException("CpuBondForce: The number of interactions does not match the number of threads");
+    vector<double> threadEnergy(numThreads, 0);
+    vector<vector<double> > threadDerivs(numThreads, vector<double>(numEnergyParamDerivs+1, 0));
+    threads->execute([&] (ThreadPool& threads, int threadIndex) {
+        double* energy = (totalEnergy == NULL ? NULL : &threadEnergy[threadIndex]);
+        threadComputeForce(threads, threadIndex, atomCoordinates, parameters, forces, energy, *referenceBondIxns[threadIndex], &threadDerivs[threadIndex][0]);
+    });
+    threads->waitForThreads();
+
+    // Compute any "extra" bonds.
+
+    for (int i = 0; i < extraBonds.size(); i++) {
+        int bond = extraBonds[i];
+        referenceBondIxns[0]->calculateBondIxn(bondAtoms[bond], atomCoordinates, parameters[bond], forces, totalEnergy, &threadDerivs[0][0]);
+    }
+
+    // Compute the total energy and derivatives.
+
+    for (int i = 0; i < numThreads; i++) {
+        if (totalEnergy != NULL)
+            *totalEnergy += threadEnergy[i];
+        for (int j = 0; j < numEnergyParamDerivs; j++)
+            energyParamDerivs[j] += threadDerivs[i][j];
+    }
+}
+
 void CpuBondForce::threadComputeForce(ThreadPool& threads, int threadIndex, vector<Vec3>& atomCoordinates, vector<vector<double> >& parameters, vector<Vec3>& forces, 
-            double* totalEnergy, ReferenceBondIxn& referenceBondIxn) {
+            double* totalEnergy, ReferenceBondIxn& referenceBondIxn, double* energyParamDerivs) {
     vector<int>& bonds = threadBonds[threadIndex];
     int numBonds = bonds.size();
     for (int i = 0; i < numBonds; i++) {
         int bond = bonds[i];
-        referenceBondIxn.calculateBondIxn(bondAtoms[bond], atomCoordinates, parameters[bond], forces, totalEnergy, NULL);
+        referenceBondIxn.calculateBondIxn(bondAtoms[bond], atomCoordinates, parameters[bond], forces, totalEnergy, energyParamDerivs);
     }
 }
\ No newline at end of file
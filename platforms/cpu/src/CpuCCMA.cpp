@@ -0,0 +1,149 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuCCMA.h"
+#include "openmm/HarmonicAngleForce.h"
+#include <atomic>
+
+using namespace OpenMM;
+using namespace std;
+
+static int findClusterRoot(vector<int>& parent, int atom) {
+    while (parent[atom] != atom) {
+        parent[atom] = parent[parent[atom]];
+        atom = parent[atom];
+    }
+    return atom;
+}
+
+CpuCCMA::CpuCCMA(const System& system, const ReferenceCCMAAlgorithm& ccma, ThreadPool& threads, PhaseProfiler& profiler) : threads(threads), profiler(profiler) {
+    int numAtoms = system.getNumParticles();
+    int numConstraints = ccma.getNumberOfConstraints();
+    vector<double> mass(numAtoms);
+    for (int i = 0; i < numAtoms; i++)
+        mass[i] = system.getParticleMass(i);
+
+    // Find clusters of constraints that are connected through shared atoms.  Different
+    // clusters are independent of each other, so they can be processed in parallel.
+
+    vector<int> parent(numAtoms);
+    for (int i = 0; i < numAtoms; i++)
+        parent[i] = i;
+    vector<pair<int, int> > atomIndices(numConstraints);
+    vector<double> distance(numConstraints);
+    for (int i = 0; i < numConstraints; i++) {
+        ccma.getConstraintParameters(i, atomIndices[i].first, atomIndices[i].second, distance[i]);
+        parent[findClusterRoot(parent, atomIndices[i].first)] = findClusterRoot(parent, atomIndices[i].second);
+    }
+    vector<int> rootCluster(numAtoms, -1);
+    vector<vector<int> > clusters;
+    for (int i = 0; i < numConstraints; i++) {
+        int root = findClusterRoot(parent, atomIndices[i].first);
+        if (rootCluster[root] == -1) {
+            rootCluster[root] = clusters.size();
+            clusters.push_back(vector<int>());
+        }
+        clusters[rootCluster[root]].push_back(i);
+    }
+
+    // Look up angles, which are used in building the coupling matrix.
+
+    vector<ReferenceCCMAAlgorithm::AngleInfo> angles;
+    for (int i = 0; i < system.getNumForces(); i++) {
+        const HarmonicAngleForce* force = dynamic_cast<const HarmonicAngleForce*>(&system.getForce(i));
+        if (force != NULL) {
+            for (int j = 0; j < force->getNumAngles(); j++) {
+                int atom1, atom2, atom3;
+                double angle, k;
+                force->getAngleParameters(j, atom1, atom2, atom3, angle, k);
+                angles.push_back(ReferenceCCMAAlgorithm::AngleInfo(atom1, atom2, atom3, angle));
+            }
+        }
+    }
+
+    // Group the clusters into blocks with similar numbers of constraints, and create a
+    // separate ReferenceCCMAAlgorithm for each block.
+
+    int numBlocks = 10*threads.getNumThreads();
+    int targetBlockSize = (numConstraints+numBlocks-1)/numBlocks;
+    vector<pair<int, int> > blockIndices;
+    vector<double> blockDistance;
+    for (int i = 0; i < (int) clusters.size(); i++) {
+        for (int constraint : clusters[i]) {
+            blockIndices.push_back(atomIndices[constraint]);
+            blockDistance.push_back(distance[constraint]);
+        }
+        if ((int) blockIndices.size() >= targetBlockSize || i == (int) clusters.size()-1) {
+            ReferenceCCMAAlgorithm* block = new ReferenceCCMAAlgorithm(numAtoms, blockIndices.size(), blockIndices, blockDistance, mass, angles, 0.02);
+            block->setMaximumNumberOfIterations(ccma.getMaximumNumberOfIterations());
+            threadCCMA.push_back(block);
+            blockIndices.clear();
+            blockDistance.clear();
+        }
+    }
+}
+
+CpuCCMA::~CpuCCMA() {
+    for (auto ccma : threadCCMA)
+        delete ccma;
+}
+
+void CpuCCMA::apply(vector<OpenMM::Vec3>& atomCoordinates, vector<OpenMM::Vec3>& atomCoordinatesP, vector<double>& inverseMasses, double tolerance) {
+    profiler.startInterval();
+    atomic<int> atomicCounter;
+    atomicCounter = 0;
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        while (true) {
+            int index = atomicCounter++;
+            if (index >= (int) threadCCMA.size())
+                break;
+            threadCCMA[index]->apply(atomCoordinates, atomCoordinatesP, inverseMasses, tolerance);
+        }
+    });
+    threads.waitForThreads();
+    profiler.endInterval("CCMA");
+}
+
+void CpuCCMA::applyToVelocities(vector<OpenMM::Vec3>& atomCoordinates, vector<OpenMM::Vec3>& velocities, vector<double>& inverseMasses, double tolerance) {
+    profiler.startInterval();
+    atomic<int> atomicCounter;
+    atomicCounter = 0;
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        while (true) {
+            int index = atomicCounter++;
+            if (index >= (int) threadCCMA.size())
+                break;
+            threadCCMA[index]->applyToVelocities(atomCoordinates, velocities, inverseMasses, tolerance);
+        }
+    });
+    threads.waitForThreads();
+    profiler.endInterval("CCMA");
+}
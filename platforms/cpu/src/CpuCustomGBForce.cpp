@@ -23,6 +23,8 @@
  */
 
 #include <string.h>
+#include <algorithm>
+#include <map>
 #include <sstream>
 
 #include "SimTKOpenMMUtilities.h"
@@ -118,13 +120,51 @@ CpuCustomGBForce::ThreadData::ThreadData(int numAtoms, int numThreads, int threa
     dVdX.resize(valueDerivExpressions.size());
     dVdY.resize(valueDerivExpressions.size());
     dVdZ.resize(valueDerivExpressions.size());
-    dVdR1.resize(valueDerivExpressions.size());
-    dVdR2.resize(valueDerivExpressions.size());
+    dVdV0.resize(valueDerivExpressions.size());
     dValue0dParam.resize(valueParamDerivExpressions[0].size(), vector<float>(numAtoms));
     energyParamDerivs.resize(valueParamDerivExpressions[0].size());
+    batchSize = 0;
+    numBatched = 0;
 }
 
-CpuCustomGBForce::CpuCustomGBForce(int numAtoms, const std::vector<std::set<int> >& exclusions,
+void CpuCustomGBForce::ThreadData::initializeVecExpressions(const Lepton::CompiledVectorExpression& valueExpression,
+            const Lepton::CompiledVectorExpression& valueDerivExpression, const vector<vector<Lepton::CompiledVectorExpression> >& energyExpressions,
+            const vector<string>& parameterNames, const vector<string>& valueNames) {
+    batchSize = valueExpression.getWidth();
+    numBatched = 0;
+    batchAtom1.resize(batchSize, 0);
+    batchAtom2.resize(batchSize, 0);
+    rvec.resize(batchSize, 1.0f);
+    batchDx.resize(batchSize, 0.0f);
+    batchDy.resize(batchSize, 0.0f);
+    batchDz.resize(batchSize, 0.0f);
+    vecParams1.resize(batchSize*parameterNames.size(), 0.0f);
+    vecParams2.resize(batchSize*parameterNames.size(), 0.0f);
+    vecValues1.resize(batchSize*valueNames.size(), 0.0f);
+    vecValues2.resize(batchSize*valueNames.size(), 0.0f);
+    map<string, float*> variableLocations;
+    variableLocations["r"] = &rvec[0];
+    for (int i = 0; i < parameterNames.size(); i++) {
+        variableLocations[parameterNames[i]+"1"] = &vecParams1[i*batchSize];
+        variableLocations[parameterNames[i]+"2"] = &vecParams2[i*batchSize];
+    }
+    for (int i = 0; i < valueNames.size(); i++) {
+        variableLocations[valueNames[i]+"1"] = &vecValues1[i*batchSize];
+        variableLocations[valueNames[i]+"2"] = &vecValues2[i*batchSize];
+    }
+    valueVecExpressions = {valueExpression, valueDerivExpression};
+    energyVecExpressions = energyExpressions;
+    allVecExpressions.clear();
+    for (auto& expression : valueVecExpressions)
+        allVecExpressions.push_back(&expression);
+    for (auto& expressions : energyVecExpressions)
+        for (auto& expression : expressions)
+            allVecExpressions.push_back(&expression);
+    for (auto expression : allVecExpressions)
+        expression->setVariableLocations(variableLocations);
+}
+
+CpuCustomGBForce::CpuCustomGBForce(int numAtoms, const ExclusionList& exclusions,
                      const vector<Lepton::CompiledExpression>& valueExpressions,
                      const vector<vector<Lepton::CompiledExpression> >& valueDerivExpressions,
                      const vector<vector<Lepton::CompiledExpression> >& valueGradientExpressions,
@@ -138,7 +178,7 @@ CpuCustomGBForce::CpuCustomGBForce(int numAtoms, const std::vector<std::set<int>
                      const vector<CustomGBForce::ComputationType>& energyTypes,
                      const vector<string>& parameterNames, ThreadPool& threads) :
             exclusions(exclusions), cutoff(false), periodic(false), valueTypes(valueTypes), energyTypes(energyTypes), numValues(valueNames.size()),
-            numParams(parameterNames.size()), threads(threads) {
+            numParams(parameterNames.size()), paramNames(parameterNames), valueNames(valueNames), useVecExpressions(false), threads(threads) {
     for (int i = 0; i < threads.getNumThreads(); i++)
         threadData.push_back(new ThreadData(numAtoms, threads.getNumThreads(), i, valueExpressions, valueDerivExpressions, valueGradientExpressions,
                 valueParamDerivExpressions, valueNames, energyExpressions, energyDerivExpressions, energyGradientExpressions, energyParamDerivExpressions, parameterNames));
@@ -151,6 +191,7 @@ CpuCustomGBForce::CpuCustomGBForce(int numAtoms, const std::vector<std::set<int>
     dValuedParam.resize(numValues);
     for (int i = 0; i < numValues; i++)
         dValuedParam[i].resize(valueParamDerivExpressions[0].size(), vector<float>(numAtoms));
+    chainRuleScale.resize(numAtoms);
 }
 
 CpuCustomGBForce::~CpuCustomGBForce() {
@@ -177,6 +218,21 @@ void CpuCustomGBForce::setPeriodic(Vec3& boxSize) {
     periodicBoxSize[2] = boxSize[2];
   }
 
+void CpuCustomGBForce::setVectorizedExpressions(const Lepton::ParsedExpression& valueExpression, const Lepton::ParsedExpression& valueDerivExpression,
+            const vector<vector<Lepton::ParsedExpression> >& energyExpressions) {
+    const vector<int>& widths = Lepton::CompiledVectorExpression::getAllowedWidths();
+    int width = *max_element(widths.begin(), widths.end());
+    Lepton::CompiledVectorExpression valueVecExpression = valueExpression.createCompiledVectorExpression(width);
+    Lepton::CompiledVectorExpression valueDerivVecExpression = valueDerivExpression.createCompiledVectorExpression(width);
+    vector<vector<Lepton::CompiledVectorExpression> > energyVecExpressions(energyExpressions.size());
+    for (int i = 0; i < energyExpressions.size(); i++)
+        for (auto& expression : energyExpressions[i])
+            energyVecExpressions[i].push_back(expression.createCompiledVectorExpression(width));
+    for (auto data : threadData)
+        data->initializeVecExpressions(valueVecExpression, valueDerivVecExpression, energyVecExpressions, paramNames, valueNames);
+    useVecExpressions = true;
+}
+
 void CpuCustomGBForce::calculateIxn(int numberOfAtoms, float* posq, vector<vector<double> >& atomParameters,
                                            map<string, double>& globalParameters, vector<AlignedArray<float> >& threadForce,
                                            bool includeForce, bool includeEnergy, double& totalEnergy, double* energyParamDerivs) {
@@ -252,8 +308,16 @@ void CpuCustomGBForce::threadComputeForce(ThreadPool& threads, int threadIndex)
     ThreadData& data = *threadData[threadIndex];
     fvec4 boxSize(periodicBoxSize[0], periodicBoxSize[1], periodicBoxSize[2], 0);
     fvec4 invBoxSize((1/periodicBoxSize[0]), (1/periodicBoxSize[1]), (1/periodicBoxSize[2]), 0);
-    for (auto& param : *globalParameters)
+    for (auto& param : *globalParameters) {
         data.expressionSet.setVariable(data.expressionSet.getVariableIndex(param.first), param.second);
+        for (auto expression : data.allVecExpressions) {
+            if (expression->getVariables().find(param.first) != expression->getVariables().end()) {
+                float* p = expression->getVariablePointer(param.first);
+                for (int i = 0; i < expression->getWidth(); i++)
+                    p[i] = param.second;
+            }
+        }
+    }
 
     // Calculate the first computed value.
 
@@ -331,7 +395,9 @@ void CpuCustomGBForce::threadComputeForce(ThreadPool& threads, int threadIndex)
         threads.syncThreads();
     }
 
-    // Sum the energy derivatives.
+    // Sum the energy derivatives.  Every computed value depends on particle pairs only through the first
+    // one, so also combine them into a single factor that multiplies the derivative of the first value
+    // with respect to r when applying the chain rule.
 
     for (int atom = data.firstAtom; atom < data.lastAtom; atom++) {
         for (int i = 0; i < (int) dEdV.size(); i++) {
@@ -340,6 +406,22 @@ void CpuCustomGBForce::threadComputeForce(ThreadPool& threads, int threadIndex)
                 sum += data->dEdV[i][atom];
             dEdV[i][atom] = sum;
         }
+        data.x = posq[4*atom];
+        data.y = posq[4*atom+1];
+        data.z = posq[4*atom+2];
+        for (int j = 0; j < numParams; j++)
+            data.param[j] = atomParameters[atom][j];
+        for (int j = 0; j < numValues; j++)
+            data.value[j] = values[j][atom];
+        data.dVdV0[0] = 1.0f;
+        float scale = dEdV[0][atom];
+        for (int i = 1; i < numValues; i++) {
+            data.dVdV0[i] = 0.0f;
+            for (int j = 0; j < i; j++)
+                data.dVdV0[i] += (float) data.valueDerivExpressions[i][j].evaluate()*data.dVdV0[j];
+            scale += dEdV[i][atom]*data.dVdV0[i];
+        }
+        chainRuleScale[atom] = scale;
     }
     threads.syncThreads();
 
@@ -369,7 +451,7 @@ void CpuCustomGBForce::calculateParticlePairValue(int index, ThreadData& data, i
                 for (int k = 0; k < blockSize; k++) {
                     if ((blockExclusions[i] & (1<<k)) == 0) {
                         int second = blockAtom[k];
-                        if (useExclusions && exclusions[first].find(second) != exclusions[first].end())
+                        if (useExclusions && exclusions.isExcluded(first, second))
                             continue;
                         calculateOnePairValue(index, first, second, data, posq, atomParameters, valueArray, boxSize, invBoxSize);
                         calculateOnePairValue(index, second, first, data, posq, atomParameters, valueArray, boxSize, invBoxSize);
@@ -386,13 +468,15 @@ void CpuCustomGBForce::calculateParticlePairValue(int index, ThreadData& data, i
             if (i >= numAtoms)
                 break;
             for (int j = i+1; j < numAtoms; j++) {
-                if (useExclusions && exclusions[i].find(j) != exclusions[i].end())
+                if (useExclusions && exclusions.isExcluded(i, j))
                     continue;
                 calculateOnePairValue(index, i, j, data, posq, atomParameters, valueArray, boxSize, invBoxSize);
                 calculateOnePairValue(index, j, i, data, posq, atomParameters, valueArray, boxSize, invBoxSize);
            }
         }
     }
+    if (useVecExpressions)
+        flushValueBatch(data, valueArray);
 }
 
 void CpuCustomGBForce::calculateOnePairValue(int index, int atom1, int atom2, ThreadData& data, float* posq, vector<double>* atomParameters,
@@ -404,6 +488,12 @@ void CpuCustomGBForce::calculateOnePairValue(int index, int atom1, int atom2, Th
     getDeltaR(pos2, pos1, deltaR, r2, periodic, boxSize, invBoxSize);
     if (cutoff && r2 >= cutoffDistance2)
         return;
+    if (useVecExpressions) {
+        addPairToBatch(data, atom1, atom2, deltaR, sqrtf(r2), atomParameters, 0);
+        if (data.numBatched == data.batchSize)
+            flushValueBatch(data, valueArray);
+        return;
+    }
     data.r = sqrtf(r2);
     for (int i = 0; i < numParams; i++) {
         data.particleParam[i*2] = atomParameters[atom1][i];
@@ -464,7 +554,7 @@ void CpuCustomGBForce::calculateParticlePairEnergyTerm(int index, ThreadData& da
                 for (int k = 0; k < blockSize; k++) {
                     if ((blockExclusions[i] & (1<<k)) == 0) {
                         int second = blockAtom[k];
-                        if (useExclusions && exclusions[first].find(second) != exclusions[first].end())
+                        if (useExclusions && exclusions.isExcluded(first, second))
                             continue;
                         calculateOnePairEnergyTerm(index, first, second, data, posq, atomParameters, forces, totalEnergy, boxSize, invBoxSize);
                     }
@@ -480,12 +570,14 @@ void CpuCustomGBForce::calculateParticlePairEnergyTerm(int index, ThreadData& da
             if (i >= numAtoms)
                 break;
             for (int j = i+1; j < numAtoms; j++) {
-                if (useExclusions && exclusions[i].find(j) != exclusions[i].end())
+                if (useExclusions && exclusions.isExcluded(i, j))
                     continue;
                 calculateOnePairEnergyTerm(index, i, j, data, posq, atomParameters, forces, totalEnergy, boxSize, invBoxSize);
            }
         }
     }
+    if (useVecExpressions)
+        flushEnergyBatch(index, data, forces, totalEnergy);
 }
 
 void CpuCustomGBForce::calculateOnePairEnergyTerm(int index, int atom1, int atom2, ThreadData& data, float* posq, vector<double>* atomParameters,
@@ -500,6 +592,12 @@ void CpuCustomGBForce::calculateOnePairEnergyTerm(int index, int atom1, int atom
     if (cutoff && r2 >= cutoffDistance2)
         return;
     float r = sqrtf(r2);
+    if (useVecExpressions) {
+        addPairToBatch(data, atom1, atom2, deltaR, r, atomParameters, values.size());
+        if (data.numBatched == data.batchSize)
+            flushEnergyBatch(index, data, forces, totalEnergy);
+        return;
+    }
     data.r = r;
 
     // Record variables for evaluating expressions.
@@ -551,7 +649,7 @@ void CpuCustomGBForce::calculateChainRuleForces(ThreadData& data, int numAtoms,
                 for (int k = 0; k < blockSize; k++) {
                     if ((blockExclusions[i] & (1<<k)) == 0) {
                         int second = blockAtom[k];
-                        bool isExcluded = (exclusions[first].find(second) != exclusions[first].end());
+                        bool isExcluded = (exclusions.isExcluded(first, second));
                         calculateOnePairChainRule(first, second, data, posq, atomParameters, forces, isExcluded, boxSize, invBoxSize);
                         calculateOnePairChainRule(second, first, data, posq, atomParameters, forces, isExcluded, boxSize, invBoxSize);
                     }
@@ -567,12 +665,14 @@ void CpuCustomGBForce::calculateChainRuleForces(ThreadData& data, int numAtoms,
             if (i >= numAtoms)
                 break;
             for (int j = i+1; j < numAtoms; j++) {
-                bool isExcluded = (exclusions[i].find(j) != exclusions[i].end());
+                bool isExcluded = (exclusions.isExcluded(i, j));
                 calculateOnePairChainRule(i, j, data, posq, atomParameters, forces, isExcluded, boxSize, invBoxSize);
                 calculateOnePairChainRule(j, i, data, posq, atomParameters, forces, isExcluded, boxSize, invBoxSize);
            }
         }
     }
+    if (useVecExpressions)
+        flushChainRuleBatch(data, forces);
 
     // Compute chain rule terms for computed values that depend explicitly on particle coordinates.
 
@@ -612,6 +712,9 @@ void CpuCustomGBForce::calculateChainRuleForces(ThreadData& data, int numAtoms,
 
 void CpuCustomGBForce::calculateOnePairChainRule(int atom1, int atom2, ThreadData& data, float* posq, vector<double>* atomParameters,
         float* forces, bool isExcluded, const fvec4& boxSize, const fvec4& invBoxSize) {
+    if (isExcluded && valueTypes[0] == CustomGBForce::ParticlePair)
+        return;
+
     // Compute the displacement.
 
     fvec4 deltaR;
@@ -622,6 +725,12 @@ void CpuCustomGBForce::calculateOnePairChainRule(int atom1, int atom2, ThreadDat
     if (cutoff && r2 >= cutoffDistance2)
         return;
     float r = sqrtf(r2);
+    if (useVecExpressions) {
+        addPairToBatch(data, atom1, atom2, deltaR, r, atomParameters, 0);
+        if (data.numBatched == data.batchSize)
+            flushChainRuleBatch(data, forces);
+        return;
+    }
     data.r = r;
 
     // Record variables for evaluating expressions.
@@ -629,40 +738,89 @@ void CpuCustomGBForce::calculateOnePairChainRule(int atom1, int atom2, ThreadDat
     for (int i = 0; i < numParams; i++) {
         data.particleParam[i*2] = atomParameters[atom1][i];
         data.particleParam[i*2+1] = atomParameters[atom2][i];
-        data.param[i] = atomParameters[atom1][i];
-    }
-    data.value[0] = values[0][atom1];
-    data.x = posq[4*atom1];
-    data.y = posq[4*atom1+1];
-    data.z = posq[4*atom1+2];
-    data.particleValue[0] = values[0][atom1];
-    data.particleValue[1] = values[0][atom2];
-
-    // Evaluate the derivative of each parameter with respect to position and apply forces.
-
-    float rinv = 1/r;
-    deltaR *= rinv;
-    fvec4 f1(0.0f), f2(0.0f);
-    if (!isExcluded || valueTypes[0] != CustomGBForce::ParticlePair) {
-        data.dVdR1[0] = (float) data.valueDerivExpressions[0][0].evaluate();
-        data.dVdR2[0] = -data.dVdR1[0];
-        f1 -= deltaR*(dEdV[0][atom1]*data.dVdR1[0]);
-        f2 -= deltaR*(dEdV[0][atom1]*data.dVdR2[0]);
-    }
-    for (int i = 1; i < (int) values.size(); i++) {
-        data.value[i] = values[i][atom1];
-        data.dVdR1[i] = 0.0;
-        data.dVdR2[i] = 0.0;
-        for (int j = 0; j < i; j++) {
-            float dVdV = (float) data.valueDerivExpressions[i][j].evaluate();
-            data.dVdR1[i] += dVdV*data.dVdR1[j];
-            data.dVdR2[i] += dVdV*data.dVdR2[j];
-        }
-        f1 -= deltaR*(dEdV[i][atom1]*data.dVdR1[i]);
-        f2 -= deltaR*(dEdV[i][atom1]*data.dVdR2[i]);
     }
-    (fvec4(forces+4*atom1)+f1).store(forces+4*atom1);
-    (fvec4(forces+4*atom2)+f2).store(forces+4*atom2);
+
+    // Evaluate the derivative of the first computed value with respect to position and apply forces.
+    // The derivatives of the energy with respect to all computed values are included in chainRuleScale.
+
+    float dVdR = (float) data.valueDerivExpressions[0][0].evaluate();
+    fvec4 f = deltaR*(chainRuleScale[atom1]*dVdR/r);
+    (fvec4(forces+4*atom1)-f).store(forces+4*atom1);
+    (fvec4(forces+4*atom2)+f).store(forces+4*atom2);
+}
+
+void CpuCustomGBForce::addPairToBatch(ThreadData& data, int atom1, int atom2, const fvec4& deltaR, float r, vector<double>* atomParameters, int numValuesToLoad) {
+    int k = data.numBatched++;
+    int batchSize = data.batchSize;
+    data.batchAtom1[k] = atom1;
+    data.batchAtom2[k] = atom2;
+    data.rvec[k] = r;
+    data.batchDx[k] = deltaR[0];
+    data.batchDy[k] = deltaR[1];
+    data.batchDz[k] = deltaR[2];
+    for (int i = 0; i < numParams; i++) {
+        data.vecParams1[i*batchSize+k] = atomParameters[atom1][i];
+        data.vecParams2[i*batchSize+k] = atomParameters[atom2][i];
+    }
+    for (int i = 0; i < numValuesToLoad; i++) {
+        data.vecValues1[i*batchSize+k] = values[i][atom1];
+        data.vecValues2[i*batchSize+k] = values[i][atom2];
+    }
+}
+
+void CpuCustomGBForce::flushValueBatch(ThreadData& data, vector<float>& valueArray) {
+    if (data.numBatched == 0)
+        return;
+    const float* value = data.valueVecExpressions[0].evaluate();
+    for (int k = 0; k < data.numBatched; k++)
+        valueArray[data.batchAtom1[k]] += value[k];
+    data.numBatched = 0;
+}
+
+void CpuCustomGBForce::flushEnergyBatch(int index, ThreadData& data, float* forces, double& totalEnergy) {
+    if (data.numBatched == 0)
+        return;
+    vector<Lepton::CompiledVectorExpression>& expressions = data.energyVecExpressions[index];
+    if (includeEnergy) {
+        const float* energy = expressions[0].evaluate();
+        float sum = 0.0f;
+        for (int k = 0; k < data.numBatched; k++)
+            sum += energy[k];
+        totalEnergy += sum;
+    }
+    const float* dEdR = expressions[1].evaluate();
+    for (int k = 0; k < data.numBatched; k++) {
+        int atom1 = data.batchAtom1[k];
+        int atom2 = data.batchAtom2[k];
+        float scale = dEdR[k]/data.rvec[k];
+        fvec4 result(data.batchDx[k]*scale, data.batchDy[k]*scale, data.batchDz[k]*scale, 0.0f);
+        (fvec4(forces+4*atom1)-result).store(forces+4*atom1);
+        (fvec4(forces+4*atom2)+result).store(forces+4*atom2);
+    }
+    for (int i = 0; i < (int) values.size(); i++) {
+        const float* dEdV1 = expressions[2*i+2].evaluate();
+        for (int k = 0; k < data.numBatched; k++)
+            data.dEdV[i][data.batchAtom1[k]] += dEdV1[k];
+        const float* dEdV2 = expressions[2*i+3].evaluate();
+        for (int k = 0; k < data.numBatched; k++)
+            data.dEdV[i][data.batchAtom2[k]] += dEdV2[k];
+    }
+    data.numBatched = 0;
+}
+
+void CpuCustomGBForce::flushChainRuleBatch(ThreadData& data, float* forces) {
+    if (data.numBatched == 0)
+        return;
+    const float* dVdR = data.valueVecExpressions[1].evaluate();
+    for (int k = 0; k < data.numBatched; k++) {
+        int atom1 = data.batchAtom1[k];
+        int atom2 = data.batchAtom2[k];
+        float scale = chainRuleScale[atom1]*dVdR[k]/data.rvec[k];
+        fvec4 f(data.batchDx[k]*scale, data.batchDy[k]*scale, data.batchDz[k]*scale, 0.0f);
+        (fvec4(forces+4*atom1)-f).store(forces+4*atom1);
+        (fvec4(forces+4*atom2)+f).store(forces+4*atom2);
+    }
+    data.numBatched = 0;
 }
 
 void CpuCustomGBForce::getDeltaR(const fvec4& posI, const fvec4& posJ, fvec4& deltaR, float& r2, bool periodic, const fvec4& boxSize, const fvec4& invBoxSize) const {
@@ -70,13 +70,10 @@ CpuCustomManyParticleForce::CpuCustomManyParticleForce(const CustomManyParticleF
     
     // Record exclusions.
     
-    exclusions.resize(force.getNumParticles());
-    for (int i = 0; i < (int) force.getNumExclusions(); i++) {
-        int p1, p2;
-        force.getExclusionParticles(i, p1, p2);
-        exclusions[p1].insert(p2);
-        exclusions[p2].insert(p1);
-    }
+    vector<pair<int, int> > excludedPairs(force.getNumExclusions());
+    for (int i = 0; i < (int) excludedPairs.size(); i++)
+        force.getExclusionParticles(i, excludedPairs[i].first, excludedPairs[i].second);
+    exclusions = ExclusionList(force.getNumParticles(), excludedPairs, threads);
     
     // Record information about type filters.
     
@@ -111,21 +108,30 @@ void CpuCustomManyParticleForce::calculateIxn(AlignedArray<float>& posq, vector<
         for (int i = 0; i < numParticles; i++)
             particleNeighbors[i].clear();
         neighborList->computeNeighborList(numParticles, posq, exclusions, periodicBoxVectors, usePeriodic, cutoffDistance, threads);
-        for (int blockIndex = 0; blockIndex < neighborList->getNumBlocks(); blockIndex++) {
-            const vector<int>& neighbors = neighborList->getBlockNeighbors(blockIndex);
-            const auto& exclusions = neighborList->getBlockExclusions(blockIndex);
-            int numNeighbors = neighbors.size();
-            for (int i = 0; i < 4; i++) {
-                int p1 = neighborList->getSortedAtoms()[4*blockIndex+i];
-                for (int j = 0; j < numNeighbors; j++) {
-                    if ((exclusions[j] & (1<<i)) == 0) {
-                        int p2 = neighbors[j];
-                        particleNeighbors[p1].push_back(p2);
-                        if (centralParticleMode)
-                            particleNeighbors[p2].push_back(p1);
-                    }
+
+        // Each block contains different atoms, so the blocks can be copied in parallel.  The symmetric
+        // pairs are then added in a second pass.
+
+        threads.parallelFor(neighborList->getNumBlocks(), 4, [&] (ThreadPool& threads, int threadIndex, int start, int end) {
+            for (int blockIndex = start; blockIndex < end; blockIndex++) {
+                const vector<int>& neighbors = neighborList->getBlockNeighbors(blockIndex);
+                const auto& exclusions = neighborList->getBlockExclusions(blockIndex);
+                int numNeighbors = neighbors.size();
+                for (int i = 0; i < 4; i++) {
+                    int p1 = neighborList->getSortedAtoms()[4*blockIndex+i];
+                    for (int j = 0; j < numNeighbors; j++)
+                        if ((exclusions[j] & (1<<i)) == 0)
+                            particleNeighbors[p1].push_back(neighbors[j]);
                 }
             }
+        });
+        if (centralParticleMode) {
+            vector<int> numForward(numParticles);
+            for (int i = 0; i < numParticles; i++)
+                numForward[i] = particleNeighbors[i].size();
+            for (int p1 = 0; p1 < numParticles; p1++)
+                for (int j = 0; j < numForward[p1]; j++)
+                    particleNeighbors[particleNeighbors[p1][j]].push_back(p1);
         }
     }
     
@@ -231,7 +237,7 @@ void CpuCustomManyParticleForce::loopOverInteractions(vector<int>& availablePart
             }
         }
         for (int j = 0; j < loopIndex && include; j++)
-            include &= (exclusions[particle].find(particleSet[j]) == exclusions[particle].end());
+            include &= (!exclusions.isExcluded(particle, particleSet[j]));
         if (include) {
             if (loopIndex > 0 && availableParticles[i] == particleSet[0])
                 continue;
@@ -30,13 +30,14 @@ using namespace OpenMM;
 using namespace Lepton;
 using namespace std;
 
-CpuCustomNonbondedForce::ThreadData::ThreadData(const CompiledExpression& energyExpression, const CompiledVectorExpression& energyVecExpression,
-            const CompiledExpression& forceExpression, const CompiledVectorExpression& forceVecExpression,
+CpuCustomNonbondedForce::ThreadData::ThreadData(const CompiledExpression& energyExpression, const CompiledExpression& forceExpression,
+            const CompiledExpression& energyForceExpression, const CompiledVectorExpression& forceVecExpression,
+            const CompiledVectorExpression& energyForceVecExpression, int blockSize,
             const vector<string>& parameterNames, const std::vector<CompiledExpression> energyParamDerivExpressions,
             const vector<string>& computedValueNames, const vector<CompiledExpression> computedValueExpressions,
             vector<vector<double> >& atomComputedValues) :
-            energyExpression(energyExpression), energyVecExpression(energyVecExpression), forceExpression(forceExpression),
-            forceVecExpression(forceVecExpression), energyParamDerivExpressions(energyParamDerivExpressions),
+            energyExpression(energyExpression), forceExpression(forceExpression), energyForceExpression(energyForceExpression),
+            energyParamDerivExpressions(energyParamDerivExpressions),
             computedValueExpressions(computedValueExpressions), atomComputedValues(atomComputedValues) {
     // Prepare for passing variables to expressions.
 
@@ -55,33 +56,43 @@ CpuCustomNonbondedForce::ThreadData::ThreadData(const CompiledExpression& energy
     energyParamDerivs.resize(energyParamDerivExpressions.size());
     this->energyExpression.setVariableLocations(variableLocations);
     this->forceExpression.setVariableLocations(variableLocations);
+    this->energyForceExpression.setVariableLocations(variableLocations);
     expressionSet.registerExpression(this->energyExpression);
     expressionSet.registerExpression(this->forceExpression);
+    expressionSet.registerExpression(this->energyForceExpression);
     for (auto& expression : this->energyParamDerivExpressions) {
         expression.setVariableLocations(variableLocations);
         expressionSet.registerExpression(expression);
     }
 
-    // Prepare for passing variables to vectorized expressions.
+    // Prepare for passing variables to vectorized expressions.  If the block is wider than the
+    // expressions, each copy of an expression processes a different segment of it.
 
-    map<string, float*> vecVariableLocations;
-    int blockSize = getVectorWidth();
     rvec.resize(blockSize);
+    vecResult.resize(blockSize);
     vecParticle1Params.resize(blockSize*parameterNames.size());
     vecParticle2Params.resize(blockSize*parameterNames.size());
     vecParticle1Values.resize(blockSize*computedValueNames.size());
     vecParticle2Values.resize(blockSize*computedValueNames.size());
-    vecVariableLocations["r"] = rvec.data();
-    for (int i = 0; i < parameterNames.size(); i++) {
-        vecVariableLocations[parameterNames[i]+"1"] = &vecParticle1Params[i*blockSize];
-        vecVariableLocations[parameterNames[i]+"2"] = &vecParticle2Params[i*blockSize];
-    }
-    for (int i = 0; i < computedValueNames.size(); i++) {
-        vecVariableLocations[computedValueNames[i]+"1"] = &vecParticle1Values[i*blockSize];
-        vecVariableLocations[computedValueNames[i]+"2"] = &vecParticle2Values[i*blockSize];
+    int width = forceVecExpression.getWidth();
+    int numSegments = blockSize/width;
+    forceVecExpressions.resize(numSegments, forceVecExpression);
+    energyForceVecExpressions.resize(numSegments, energyForceVecExpression);
+    for (int segment = 0; segment < numSegments; segment++) {
+        int offset = segment*width;
+        map<string, float*> vecVariableLocations;
+        vecVariableLocations["r"] = &rvec[offset];
+        for (int i = 0; i < parameterNames.size(); i++) {
+            vecVariableLocations[parameterNames[i]+"1"] = &vecParticle1Params[i*blockSize+offset];
+            vecVariableLocations[parameterNames[i]+"2"] = &vecParticle2Params[i*blockSize+offset];
+        }
+        for (int i = 0; i < computedValueNames.size(); i++) {
+            vecVariableLocations[computedValueNames[i]+"1"] = &vecParticle1Values[i*blockSize+offset];
+            vecVariableLocations[computedValueNames[i]+"2"] = &vecParticle2Values[i*blockSize+offset];
+        }
+        forceVecExpressions[segment].setVariableLocations(vecVariableLocations);
+        energyForceVecExpressions[segment].setVariableLocations(vecVariableLocations);
     }
-    this->energyVecExpression.setVariableLocations(vecVariableLocations);
-    this->forceVecExpression.setVariableLocations(vecVariableLocations);
 
     // Prepare for passing variables to the computed value expressions.
 
@@ -99,7 +110,7 @@ CpuCustomNonbondedForce::CpuCustomNonbondedForce(ThreadPool& threads, const CpuN
 }
 
 void CpuCustomNonbondedForce::initialize(const ParsedExpression& energyExpression,
-            const ParsedExpression& forceExpression, const vector<string>& parameterNames, const vector<set<int> >& exclusions,
+            const ParsedExpression& forceExpression, const vector<string>& parameterNames, const ExclusionList& exclusions,
             const vector<ParsedExpression> energyParamDerivExpressions, const vector<string>& computedValueNames,
             const vector<ParsedExpression> computedValueExpressions) {
     this->paramNames = parameterNames;
@@ -107,15 +118,30 @@ void CpuCustomNonbondedForce::initialize(const ParsedExpression& energyExpressio
     this->computedValueNames = computedValueNames;
     CompiledExpression compiledEnergyExpression = energyExpression.createCompiledExpression();
     CompiledExpression compiledForceExpression = forceExpression.createCompiledExpression();
-    CompiledVectorExpression energyVecExpression = energyExpression.createCompiledVectorExpression(getVectorWidth());
-    CompiledVectorExpression forceVecExpression = forceExpression.createCompiledVectorExpression(getVectorWidth());
+
+    // When both the energy and force are needed, evaluate them together so subexpressions they
+    // have in common are only computed once.
+
+    vector<ParsedExpression> energyAndForce = {energyExpression, forceExpression};
+    CompiledExpression compiledEnergyForceExpression(energyAndForce);
+
+    // Use the widest vectorized expressions that evenly divide the neighbor list's blocks.
+
+    int blockSize = neighborList->getBlockSize();
+    int width = 0;
+    for (int allowedWidth : CompiledVectorExpression::getAllowedWidths())
+        if (blockSize%allowedWidth == 0)
+            width = max(width, allowedWidth);
+    CompiledVectorExpression forceVecExpression = forceExpression.createCompiledVectorExpression(width);
+    CompiledVectorExpression energyForceVecExpression(energyAndForce, width);
     vector<CompiledExpression> compiledDerivExpressions, compiledValueExpressions;
     for (auto& exp : energyParamDerivExpressions)
         compiledDerivExpressions.push_back(exp.createCompiledExpression());
     for (auto& exp : computedValueExpressions)
         compiledValueExpressions.push_back(exp.createCompiledExpression());
     for (int i = 0; i < threads.getNumThreads(); i++)
-        threadData.push_back(new ThreadData(compiledEnergyExpression, energyVecExpression, compiledForceExpression, forceVecExpression, parameterNames,
+        threadData.push_back(new ThreadData(compiledEnergyExpression, compiledForceExpression, compiledEnergyForceExpression, forceVecExpression,
+                energyForceVecExpression, blockSize, parameterNames,
                 compiledDerivExpressions, computedValueNames, compiledValueExpressions, atomComputedValues));
 }
 
@@ -136,7 +162,7 @@ void CpuCustomNonbondedForce::setInteractionGroups(const vector<pair<set<int>, s
         const set<int>& set2 = group.second;
         for (set<int>::const_iterator atom1 = set1.begin(); atom1 != set1.end(); ++atom1) {
             for (set<int>::const_iterator atom2 = set2.begin(); atom2 != set2.end(); ++atom2) {
-                if (*atom1 == *atom2 || exclusions[*atom1].find(*atom2) != exclusions[*atom1].end())
+                if (*atom1 == *atom2 || exclusions.isExcluded(*atom1, *atom2))
                     continue; // This is an excluded interaction.
                 if (*atom1 > *atom2 && set1.find(*atom2) != set1.end() && set2.find(*atom1) != set2.end())
                     continue; // Both atoms are in both sets, so skip duplicate interactions.
@@ -215,25 +241,20 @@ void CpuCustomNonbondedForce::calculatePairIxn(int numberOfAtoms, float* posq, v
 
 void CpuCustomNonbondedForce::threadComputeForce(ThreadPool& threads, int threadIndex) {
     int numThreads = threads.getNumThreads();
-    int blockSize = getVectorWidth();
     ThreadData& data = *threadData[threadIndex];
     for (auto& param : *globalParameters) {
         data.expressionSet.setVariable(data.expressionSet.getVariableIndex(param.first), param.second);
-        try {
-            float* p = data.energyVecExpression.getVariablePointer(param.first);
-            for (int i = 0; i < blockSize; i++)
-                p[i] = param.second;
-        }
-        catch (...) {
-            // The expression doesn't use this parameter.
-        }
-        try {
-            float* p = data.forceVecExpression.getVariablePointer(param.first);
-            for (int i = 0; i < blockSize; i++)
-                p[i] = param.second;
-        }
-        catch (...) {
-            // The expression doesn't use this parameter.
+        for (auto* expressions : {&data.forceVecExpressions, &data.energyForceVecExpressions}) {
+            for (auto& expression : *expressions) {
+                try {
+                    float* p = expression.getVariablePointer(param.first);
+                    for (int i = 0; i < expression.getWidth(); i++)
+                        p[i] = param.second;
+                }
+                catch (...) {
+                    // The expression doesn't use this parameter.
+                }
+            }
         }
     }
 
@@ -332,9 +353,16 @@ void CpuCustomNonbondedForce::calculateOneIxn(int ii, int jj, ThreadData& data,
 
     // accumulate forces
 
-    double dEdR = (includeForce ? data.forceExpression.evaluate()/r : 0.0);
+    double dEdR = 0.0;
     double energy = 0.0;
-    if (includeEnergy || (useSwitch && r > switchingDistance))
+    bool needEnergy = (includeEnergy || (useSwitch && r > switchingDistance));
+    if (includeForce && needEnergy) {
+        dEdR = data.energyForceExpression.evaluate()/r;
+        energy = data.energyForceExpression.getResult(0);
+    }
+    else if (includeForce)
+        dEdR = data.forceExpression.evaluate()/r;
+    else if (needEnergy)
         energy = data.energyExpression.evaluate();
     double switchValue = 1.0;
     if (useSwitch) {
@@ -29,10 +29,20 @@ using namespace OpenMM;
 
 CpuCustomNonbondedForce* createCpuCustomNonbondedForceVec4(ThreadPool& threads, const CpuNeighborList& neighbors);
 CpuCustomNonbondedForce* createCpuCustomNonbondedForceAvx(ThreadPool& threads, const CpuNeighborList& neighbors);
+CpuCustomNonbondedForce* createCpuCustomNonbondedForceAvx512(ThreadPool& threads, const CpuNeighborList& neighbors);
+CpuCustomNonbondedForce* createCpuCustomNonbondedForceSve256(ThreadPool& threads, const CpuNeighborList& neighbors);
+CpuCustomNonbondedForce* createCpuCustomNonbondedForceSve512(ThreadPool& threads, const CpuNeighborList& neighbors);
+
+bool isSve256Supported();
+bool isSve512Supported();
 
 CpuCustomNonbondedForce* OpenMM::createCpuCustomNonbondedForce(ThreadPool& threads, const CpuNeighborList& neighbors) {
-    if (isAvxSupported())
-        return createCpuCustomNonbondedForceAvx(threads, neighbors);
+    // The kernel must match the block size the neighbor list was built with.
+
+    if (neighbors.getBlockSize() == 16)
+        return (isSve512Supported() ? createCpuCustomNonbondedForceSve512(threads, neighbors) : createCpuCustomNonbondedForceAvx512(threads, neighbors));
+    else if (neighbors.getBlockSize() == 8)
+        return (isSve256Supported() ? createCpuCustomNonbondedForceSve256(threads, neighbors) : createCpuCustomNonbondedForceAvx(threads, neighbors));
     else
         return createCpuCustomNonbondedForceVec4(threads, neighbors);
 }
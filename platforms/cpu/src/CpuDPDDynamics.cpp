@@ -0,0 +1,234 @@
+/* Portions copyright (c) 2026 Stanford University and Simbios.
+ * Authors: Peter Eastman
+ * Contributors: 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "CpuDPDDynamics.h"
+#include "ReferenceForce.h"
+#include "openmm/internal/OSRngSeed.h"
+#include <cmath>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * Scramble the bits of a 64 bit integer (the finalizer from SplitMix64).
+ */
+static unsigned long long mixBits(unsigned long long z) {
+    z += 0x9E3779B97F4A7C15ULL;
+    z = (z^(z>>30))*0xBF58476D1CE4E5B9ULL;
+    z = (z^(z>>27))*0x94D049BB133111EBULL;
+    return z^(z>>31);
+}
+
+/**
+ * Generate a Gaussian random number that depends only on the key and the pair of particles.
+ */
+static double getPairGaussian(unsigned long long stepKey, int i, int j) {
+    unsigned long long bits1 = mixBits(stepKey^((((unsigned long long) i)<<32) | (unsigned int) j));
+    unsigned long long bits2 = mixBits(bits1);
+    double u1 = ((bits1>>11)+1)*(1.0/9007199254740992.0);
+    double u2 = (bits2>>11)*(1.0/9007199254740992.0);
+    return sqrt(-2.0*log(u1))*cos(2.0*M_PI*u2);
+}
+
+CpuDPDDynamics::CpuDPDDynamics(const System& system, const DPDIntegrator& integrator, ThreadPool& threads) :
+           ReferenceDPDDynamics(system, integrator), threads(threads), cpuNeighborList(4), stepIndex(0) {
+    int numParticles = system.getNumParticles();
+    posq.resize(4*numParticles);
+    noExclusions = ExclusionList(numParticles);
+    threadDeltaV.resize(threads.getNumThreads(), vector<Vec3>(numParticles));
+    unsigned int seed = (unsigned int) integrator.getRandomNumberSeed();
+    if (seed == 0)
+        seed = (unsigned int) osrngseed();
+    randomSeed = mixBits(seed);
+}
+
+CpuDPDDynamics::~CpuDPDDynamics() {
+}
+
+void CpuDPDDynamics::setStepIndex(long long step) {
+    stepIndex = step;
+}
+
+void CpuDPDDynamics::updatePart1(int numParticles, vector<Vec3>& velocities, vector<Vec3>& forces) {
+    // Record the parameters for the threads.
+
+    this->numParticles = numParticles;
+    this->velocities = &velocities[0];
+    this->forces = &forces[0];
+
+    // Signal the threads to start running and wait for them to finish.
+
+    threads.execute([&] (ThreadPool& threads, int threadIndex) { threadUpdate1(threadIndex); });
+    threads.waitForThreads();
+}
+
+void CpuDPDDynamics::updatePart2(int numParticles, vector<Vec3>& atomCoordinates, vector<Vec3>& velocities, vector<Vec3>& xPrime) {
+    // Record the parameters for the threads.
+
+    this->numParticles = numParticles;
+    this->atomCoordinates = &atomCoordinates[0];
+    this->velocities = &velocities[0];
+    this->xPrime = &xPrime[0];
+
+    // First position update.
+
+    threads.execute([&] (ThreadPool& threads, int threadIndex) { threadUpdate2a(threadIndex); });
+    threads.waitForThreads();
+
+    // Find the pairs that might be within the cutoff, then compute the change in velocity
+    // from each one.  All pairs use the velocities from before friction and noise are applied.
+
+    cpuNeighborList.computeNeighborList(numParticles, posq, noExclusions, periodicBoxVectors, periodic, maxCutoff, threads);
+    threads.execute([&] (ThreadPool& threads, int threadIndex) { threadUpdate2b(threadIndex); });
+    threads.waitForThreads();
+
+    // Sum the contributions from all threads and perform the second position update.
+
+    threads.execute([&] (ThreadPool& threads, int threadIndex) { threadUpdate2c(threadIndex); });
+    threads.waitForThreads();
+}
+
+void CpuDPDDynamics::updatePart3(ContextImpl& context, int numParticles, vector<Vec3>& atomCoordinates, vector<Vec3>& velocities, vector<Vec3>& xPrime) {
+    // Record the parameters for the threads.
+
+    this->numParticles = numParticles;
+    this->atomCoordinates = &atomCoordinates[0];
+    this->velocities = &velocities[0];
+    this->xPrime = &xPrime[0];
+
+    // Signal the threads to start running and wait for them to finish.
+
+    threads.execute([&] (ThreadPool& threads, int threadIndex) { threadUpdate3(threadIndex); });
+    threads.waitForThreads();
+}
+
+void CpuDPDDynamics::threadUpdate1(int threadIndex) {
+    int start = threadIndex*numParticles/threads.getNumThreads();
+    int end = (threadIndex+1)*numParticles/threads.getNumThreads();
+
+    for (int i = start; i < end; i++)
+        if (inverseMasses[i] != 0.0)
+            velocities[i] += (getDeltaT()*inverseMasses[i])*forces[i];
+}
+
+void CpuDPDDynamics::threadUpdate2a(int threadIndex) {
+    const double halfdt = 0.5*getDeltaT();
+    int start = threadIndex*numParticles/threads.getNumThreads();
+    int end = (threadIndex+1)*numParticles/threads.getNumThreads();
+
+    for (int i = start; i < end; i++) {
+        xPrime[i] = atomCoordinates[i];
+        if (inverseMasses[i] != 0.0)
+            xPrime[i] += velocities[i]*halfdt;
+        Vec3 pos = xPrime[i];
+        if (periodic) {
+            pos -= periodicBoxVectors[2]*floor(pos[2]/periodicBoxVectors[2][2]);
+            pos -= periodicBoxVectors[1]*floor(pos[1]/periodicBoxVectors[1][1]);
+            pos -= periodicBoxVectors[0]*floor(pos[0]/periodicBoxVectors[0][0]);
+        }
+        posq[4*i] = (float) pos[0];
+        posq[4*i+1] = (float) pos[1];
+        posq[4*i+2] = (float) pos[2];
+        posq[4*i+3] = 0.0f;
+    }
+}
+
+void CpuDPDDynamics::threadUpdate2b(int threadIndex) {
+    const double kT = BOLTZ*getTemperature();
+    const unsigned long long stepKey = mixBits(randomSeed^mixBits((unsigned long long) stepIndex));
+    vector<Vec3>& deltaV = threadDeltaV[threadIndex];
+    for (int i = 0; i < numParticles; i++)
+        deltaV[i] = Vec3();
+
+    // Blocks are assigned to threads in a fixed order so the sums are reproducible.
+
+    const int numThreads = threads.getNumThreads();
+    const int blockSize = cpuNeighborList.getBlockSize();
+    for (int block = threadIndex; block < cpuNeighborList.getNumBlocks(); block += numThreads) {
+        const int32_t* blockAtom = &cpuNeighborList.getSortedAtoms()[blockSize*block];
+        const vector<int>& neighbors = cpuNeighborList.getBlockNeighbors(block);
+        const auto& exclusions = cpuNeighborList.getBlockExclusions(block);
+        for (int n = 0; n < (int) neighbors.size(); n++) {
+            for (int k = 0; k < blockSize; k++) {
+                if ((exclusions[n] & (1<<k)) != 0)
+                    continue;
+                int i = min(neighbors[n], (int) blockAtom[k]);
+                int j = max(neighbors[n], (int) blockAtom[k]);
+                if (masses[i] == 0.0 && masses[j] == 0.0)
+                    continue;
+                int type1 = particleType[i];
+                int type2 = particleType[j];
+                double cutoff = cutoffTable[type1][type2];
+                double deltaR[ReferenceForce::LastDeltaRIndex];
+                if (periodic)
+                    ReferenceForce::getDeltaRPeriodic(xPrime[i], xPrime[j], periodicBoxVectors, deltaR);
+                else
+                    ReferenceForce::getDeltaR(xPrime[i], xPrime[j], deltaR);
+                double r = deltaR[ReferenceForce::RIndex];
+                if (r >= cutoff)
+                    continue;
+                double friction = frictionTable[type1][type2];
+                double m = masses[i]*masses[j]/(masses[i]+masses[j]);
+                double omega = 1.0-(r/cutoff);
+                double vscale = exp(-getDeltaT()*2*friction*omega*omega);
+                double noisescale = sqrt(1-vscale*vscale);
+                Vec3 dir = Vec3(deltaR[ReferenceForce::XIndex], deltaR[ReferenceForce::YIndex], deltaR[ReferenceForce::ZIndex])/r;
+                Vec3 v = velocities[j]-velocities[i];
+                double dv = (1.0-vscale)*v.dot(dir) + noisescale*sqrt(kT/m)*getPairGaussian(stepKey, i, j);
+                if (masses[i] != 0.0)
+                    deltaV[i] += (m/masses[i])*dv*dir;
+                if (masses[j] != 0.0)
+                    deltaV[j] -= (m/masses[j])*dv*dir;
+            }
+        }
+    }
+}
+
+void CpuDPDDynamics::threadUpdate2c(int threadIndex) {
+    const double halfdt = 0.5*getDeltaT();
+    const int numThreads = threads.getNumThreads();
+    int start = threadIndex*numParticles/numThreads;
+    int end = (threadIndex+1)*numParticles/numThreads;
+
+    for (int i = start; i < end; i++) {
+        if (inverseMasses[i] != 0.0) {
+            for (int j = 0; j < numThreads; j++)
+                velocities[i] += threadDeltaV[j][i];
+            xPrime[i] = xPrime[i] + velocities[i]*halfdt;
+            oldx[i] = xPrime[i];
+        }
+    }
+}
+
+void CpuDPDDynamics::threadUpdate3(int threadIndex) {
+    int start = threadIndex*numParticles/threads.getNumThreads();
+    int end = (threadIndex+1)*numParticles/threads.getNumThreads();
+
+    for (int i = start; i < end; i++)
+        if (inverseMasses[i] != 0.0) {
+            velocities[i] += (xPrime[i]-oldx[i])/getDeltaT();
+            atomCoordinates[i] = xPrime[i];
+        }
+}
@@ -64,7 +64,7 @@ CpuGayBerneForce::CpuGayBerneForce(const GayBerneForce& force) {
     }
     int numExceptions = force.getNumExceptions();
     exceptions.resize(numExceptions);
-    particleExclusions.resize(numParticles);
+    vector<pair<int, int> > excludedPairs(numExceptions);
     for (int i = 0; i < numExceptions; i++) {
         ExceptionInfo& e = exceptions[i];
         double sigma, epsilon;
@@ -72,9 +72,9 @@ CpuGayBerneForce::CpuGayBerneForce(const GayBerneForce& force) {
         e.sigma = sigma;
         e.epsilon = epsilon;
         exclusions.insert(make_pair(min(e.particle1, e.particle2), max(e.particle1, e.particle2)));
-        particleExclusions[e.particle1].insert(e.particle2);
-        particleExclusions[e.particle2].insert(e.particle1);
+        excludedPairs[i] = make_pair(e.particle1, e.particle2);
     }
+    particleExclusions = ExclusionList(numParticles, excludedPairs);
     nonbondedMethod = force.getNonbondedMethod();
     if (nonbondedMethod == GayBerneForce::NoCutoff) {
         cutoffDistance = 0.0;
@@ -101,7 +101,7 @@ CpuGayBerneForce::CpuGayBerneForce(const GayBerneForce& force) {
     }
 }
 
-const vector<set<int> >& CpuGayBerneForce::getExclusions() const {
+const ExclusionList& CpuGayBerneForce::getExclusions() const {
     return particleExclusions;
 }
 
@@ -164,16 +164,19 @@ void CpuGayBerneForce::threadComputeForce(ThreadPool& threads, int threadIndex,
     // Compute this thread's subset of interactions.
     
     if (cutoffDistance == 0.0) {
+        // The work for particle i is proportional to i, so process them in reverse order to
+        // leave the cheapest ones for last.
+
         while (true) {
-            int i = atomicCounter++;
-            if (i >= numParticles)
+            int i = numParticles-1-atomicCounter++;
+            if (i < 0)
                 break;
             if (particles[i].sqrtEpsilon == 0.0f)
                 continue;
             for (int j = 0; j < i; j++) {
                 if (particles[j].sqrtEpsilon == 0.0f)
                     continue;
-                if (particleExclusions[i].find(j) != particleExclusions[i].end())
+                if (particleExclusions.isExcluded(i, j))
                     continue; // This interaction will be handled by an exception.
                 double sigma = particles[i].sigmaOver2+particles[j].sigmaOver2;
                 double epsilon = particles[i].sqrtEpsilon*particles[j].sqrtEpsilon;
@@ -32,16 +32,27 @@
 #include "CpuKernels.h"
 #include "ReferenceAngleBondIxn.h"
 #include "ReferenceBondForce.h"
+#include "ReferenceCMAPTorsionIxn.h"
 #include "ReferenceConstraints.h"
+#include "ReferenceCustomAngleIxn.h"
+#include "ReferenceCustomBondIxn.h"
+#include "ReferenceCustomCentroidBondIxn.h"
+#include "ReferenceCustomCompoundBondIxn.h"
+#include "ReferenceCustomTorsionIxn.h"
+#include "ReferenceHarmonicBondIxn.h"
 #include "ReferenceKernelFactory.h"
 #include "ReferenceKernels.h"
 #include "ReferenceLJCoulomb14.h"
+#include "ReferencePointFunctions.h"
 #include "ReferenceProperDihedralBond.h"
 #include "ReferenceRbDihedralBond.h"
 #include "ReferenceTabulatedFunction.h"
 #include "openmm/Context.h"
 #include "openmm/OpenMMException.h"
 #include "openmm/Vec3.h"
+#include "openmm/internal/CMAPTorsionForceImpl.h"
+#include "openmm/internal/CustomCentroidBondForceImpl.h"
+#include "openmm/internal/CustomCompoundBondForceImpl.h"
 #include "openmm/internal/ContextImpl.h"
 #include "openmm/internal/NonbondedForceImpl.h"
 #include "openmm/internal/vectorize.h"
@@ -157,8 +168,35 @@ static void copyChargesToPosq(ContextImpl& context, const vector<float>& charges
         posq[4*i+3] = charges[i];
 }
 
+/**
+ * Find the linear transformation that maps every position in the periodic box oldBox to the
+ * corresponding position (with the same fractional coordinates) in newBox.  A position p is mapped
+ * to p[0]*transform[0]+p[1]*transform[1]+p[2]*transform[2].  This returns false if the boxes are
+ * identical or oldBox is not a valid box, in which case no transformation is needed.  Otherwise it
+ * sets deformation to the Frobenius norm of the difference between the transformation and the
+ * identity.  This bounds the fractional amount by which the transformation can change any distance.
+ */
+static bool computeBoxDeformation(const Vec3* oldBox, const Vec3* newBox, Vec3* transform, double& deformation) {
+    deformation = 0.0;
+    if (oldBox[0] == newBox[0] && oldBox[1] == newBox[1] && oldBox[2] == newBox[2])
+        return false;
+    double det = oldBox[0].dot(oldBox[1].cross(oldBox[2]));
+    if (det == 0.0)
+        return false;
+    Vec3 inverse[3] = {oldBox[1].cross(oldBox[2])/det, oldBox[2].cross(oldBox[0])/det, oldBox[0].cross(oldBox[1])/det};
+    for (int i = 0; i < 3; i++) {
+        transform[i] = newBox[0]*inverse[0][i] + newBox[1]*inverse[1][i] + newBox[2]*inverse[2][i];
+        for (int j = 0; j < 3; j++) {
+            double delta = transform[i][j]-(i == j ? 1.0 : 0.0);
+            deformation += delta*delta;
+        }
+    }
+    deformation = sqrt(deformation);
+    return true;
+}
+
 CpuCalcForcesAndEnergyKernel::CpuCalcForcesAndEnergyKernel(std::string name, const Platform& platform, CpuPlatform::PlatformData& data, ContextImpl& context) :
-        CalcForcesAndEnergyKernel(name, platform), data(data) {
+        CalcForcesAndEnergyKernel(name, platform), data(data), prunePadding(0.0), evaluationsSinceBuild(0) {
     // Create a Reference platform version of this kernel.
     
     ReferenceKernelFactory referenceFactory;
@@ -177,6 +215,41 @@ void CpuCalcForcesAndEnergyKernel::beginComputation(ContextImpl& context, bool i
 
     int numParticles = context.getSystem().getNumParticles();
     bool positionsValid = true;
+
+    // If there is a neighbor list, the same pass also measures how far atoms have moved since it was
+    // built and pruned, so deciding whether to update it does not need a separate loop over atoms.
+
+    bool checkNeighborList = (data.neighborList != NULL && data.cutoff > 0.0);
+    double padding = data.paddedCutoff-data.cutoff;
+    bool checkPrune = (checkNeighborList && prunePadding > 0.0 && prunePadding < padding && lastPrunePositions.size() == numParticles);
+
+    // If a barostat has changed the periodic box since the list was built or pruned, the list is still
+    // valid as long as atoms have not moved too far from where the box deformation alone would have put
+    // them.  The deformation can also shrink distances by a small fraction, so that comes out of the padding.
+
+    const double maxBoxDeformation = 0.05;
+    Vec3* boxVectors = extractBoxVectors(context);
+    Vec3 buildTransform[3], pruneTransform[3];
+    double buildDeformation = 0.0, pruneDeformation = 0.0;
+    bool transformBuild = false, transformPrune = false, forceRecompute = false, forcePrune = false;
+    if (checkNeighborList && data.isPeriodic) {
+        transformBuild = computeBoxDeformation(lastBoxVectors, boxVectors, buildTransform, buildDeformation);
+        if (checkPrune)
+            transformPrune = computeBoxDeformation(lastPruneBoxVectors, boxVectors, pruneTransform, pruneDeformation);
+    }
+    double effectivePadding = (1-buildDeformation)*data.paddedCutoff-data.cutoff;
+    if (buildDeformation > maxBoxDeformation || effectivePadding <= 0.0)
+        forceRecompute = true;
+    double effectivePrunePadding = (1-pruneDeformation)*(data.cutoff+prunePadding)-data.cutoff;
+    if (checkPrune && (pruneDeformation > maxBoxDeformation || effectivePrunePadding <= 0.0))
+        forcePrune = true;
+    double closeCutoff2 = 0.25*effectivePadding*effectivePadding;
+    double farCutoff2 = 0.5*effectivePadding*effectivePadding;
+    double pruneCutoff2 = 0.25*effectivePrunePadding*effectivePrunePadding;
+    int numThreads = data.threads.getNumThreads();
+    vector<double> threadMaxDist2(numThreads, 0.0);
+    vector<vector<int> > threadMoved(numThreads);
+    vector<char> threadMovedFar(numThreads, false), threadNeedPrune(numThreads, false);
     data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
         // Convert the positions to single precision and apply periodic boundary conditions
 
@@ -225,6 +298,37 @@ void CpuCalcForcesAndEnergyKernel::beginComputation(ContextImpl& context, bool i
             if (posq[i] != posq[i] || posq[i+1] != posq[i+1] || posq[i+2] != posq[i+2])
                 positionsValid = false;
 
+        // Find how far atoms have moved.
+
+        if (checkNeighborList) {
+            double maxDist2 = 0.0;
+            for (int i = start; i < end; i++) {
+                Vec3 reference = lastPositions[i];
+                if (transformBuild)
+                    reference = buildTransform[0]*reference[0] + buildTransform[1]*reference[1] + buildTransform[2]*reference[2];
+                Vec3 delta = posData[i]-reference;
+                double dist2 = delta.dot(delta);
+                maxDist2 = max(maxDist2, dist2);
+                if (dist2 > closeCutoff2) {
+                    threadMoved[threadIndex].push_back(i);
+                    if (dist2 > farCutoff2)
+                        threadMovedFar[threadIndex] = true;
+                }
+            }
+            threadMaxDist2[threadIndex] = maxDist2;
+            if (checkPrune)
+                for (int i = start; i < end; i++) {
+                    Vec3 reference = lastPrunePositions[i];
+                    if (transformPrune)
+                        reference = pruneTransform[0]*reference[0] + pruneTransform[1]*reference[1] + pruneTransform[2]*reference[2];
+                    Vec3 delta = posData[i]-reference;
+                    if (delta.dot(delta) > pruneCutoff2) {
+                        threadNeedPrune[threadIndex] = true;
+                        break;
+                    }
+                }
+        }
+
         // Clear the forces.
 
         fvec4 zero(0.0f);
@@ -237,25 +341,20 @@ void CpuCalcForcesAndEnergyKernel::beginComputation(ContextImpl& context, bool i
 
     // Determine whether we need to recompute the neighbor list.
         
-    if (data.neighborList != NULL && data.cutoff > 0.0) {
-        double padding = data.paddedCutoff-data.cutoff;;
-        bool needRecompute = false;
-        double closeCutoff2 = 0.25*padding*padding;
-        double farCutoff2 = 0.5*padding*padding;
+    if (checkNeighborList) {
+        bool needRecompute = forceRecompute, needPrune = false;
         int maxNumMoved = numParticles/10;
+        double maxDist2 = 0.0;
         vector<int> moved;
         vector<Vec3>& posData = extractPositions(context);
-        for (int i = 0; i < numParticles; i++) {
-            Vec3 delta = posData[i]-lastPositions[i];
-            double dist2 = delta.dot(delta);
-            if (dist2 > closeCutoff2) {
-                moved.push_back(i);
-                if (dist2 > farCutoff2 || moved.size() > maxNumMoved) {
-                    needRecompute = true;
-                    break;
-                }
-            }
+        for (int i = 0; i < numThreads; i++) {
+            maxDist2 = max(maxDist2, threadMaxDist2[i]);
+            moved.insert(moved.end(), threadMoved[i].begin(), threadMoved[i].end());
+            if (threadMovedFar[i])
+                needRecompute = true;
         }
+        if (moved.size() > maxNumMoved)
+            needRecompute = true;
         if (!needRecompute && moved.size() > 0) {
             // Some particles have moved further than half the padding distance.  Look for pairs
             // that are missing from the neighbor list.
@@ -278,8 +377,39 @@ void CpuCalcForcesAndEnergyKernel::beginComputation(ContextImpl& context, bool i
                 }
         }
         if (needRecompute) {
-            data.neighborList->computeNeighborList(numParticles, data.posq, data.exclusions, extractBoxVectors(context), data.isPeriodic, data.paddedCutoff, data.threads);
+            // Between full rebuilds, the list is periodically pruned down to a smaller padding.  Choose
+            // it based on how far atoms moved per evaluation during the lifetime of the previous list,
+            // so that pruning is needed about every PruneInterval evaluations.
+
+            const int PruneInterval = 5;
+            if (evaluationsSinceBuild > 0)
+                prunePadding = min(padding, max(0.1*padding, 2*PruneInterval*sqrt(maxDist2)/evaluationsSinceBuild));
+            data.profiler.startInterval();
+            data.neighborList->computeNeighborList(numParticles, data.posq, data.exclusions, boxVectors, data.isPeriodic, data.paddedCutoff, data.threads);
+            data.profiler.endInterval("Neighbor list");
             lastPositions = posData;
+            for (int i = 0; i < 3; i++)
+                lastBoxVectors[i] = boxVectors[i];
+            evaluationsSinceBuild = 0;
+            needPrune = (prunePadding > 0.0 && prunePadding < padding);
+        }
+        else {
+            // The full list is still valid.  See whether any atom has moved far enough to require pruning
+            // it again.
+
+            evaluationsSinceBuild++;
+            needPrune = forcePrune;
+            for (int i = 0; i < numThreads; i++)
+                if (threadNeedPrune[i])
+                    needPrune = true;
+        }
+        if (needPrune) {
+            data.profiler.startInterval();
+            data.neighborList->pruneNeighborList(data.posq, boxVectors, data.isPeriodic, data.cutoff+prunePadding, data.threads);
+            data.profiler.endInterval("Neighbor list pruning");
+            lastPrunePositions = posData;
+            for (int i = 0; i < 3; i++)
+                lastPruneBoxVectors[i] = boxVectors[i];
         }
     }
 }
@@ -287,6 +417,7 @@ void CpuCalcForcesAndEnergyKernel::beginComputation(ContextImpl& context, bool i
 double CpuCalcForcesAndEnergyKernel::finishComputation(ContextImpl& context, bool includeForce, bool includeEnergy, int groups, bool& valid) {
     // Sum the forces from all the threads.
     
+    data.profiler.startInterval();
     data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
         // Sum the contributions to forces that have been calculated by different threads.
         
@@ -305,6 +436,7 @@ double CpuCalcForcesAndEnergyKernel::finishComputation(ContextImpl& context, boo
         }
     });
     data.threads.waitForThreads();
+    data.profiler.endInterval("Force reduction");
     return referenceKernel.getAs<ReferenceCalcForcesAndEnergyKernel>().finishComputation(context, includeForce, includeEnergy, groups, valid);
 }
 
@@ -318,6 +450,148 @@ void CpuUpdateStateDataKernel::loadCheckpoint(ContextImpl& context, istream& str
     data.random.loadCheckpoint(stream);
 }
 
+void CpuCalcHarmonicBondForceKernel::initialize(const System& system, const HarmonicBondForce& force) {
+    numBonds = force.getNumBonds();
+    bondIndexArray.resize(numBonds, vector<int>(2));
+    bondParamArray.resize(numBonds, vector<double>(2));
+    for (int i = 0; i < numBonds; ++i) {
+        int particle1, particle2;
+        double length, k;
+        force.getBondParameters(i, particle1, particle2, length, k);
+        bondIndexArray[i][0] = particle1;
+        bondIndexArray[i][1] = particle2;
+        bondParamArray[i][0] = length;
+        bondParamArray[i][1] = k;
+    }
+    bondForce.initialize(system.getNumParticles(), numBonds, 2, bondIndexArray, data.threads);
+    usePeriodic = force.usesPeriodicBoundaryConditions();
+}
+
+double CpuCalcHarmonicBondForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double energy = 0;
+    ReferenceHarmonicBondIxn harmonicBond;
+    if (usePeriodic)
+        harmonicBond.setPeriodic(extractBoxVectors(context));
+    data.profiler.startInterval();
+    bondForce.calculateForce(posData, bondParamArray, forceData, includeEnergy ? &energy : NULL, harmonicBond);
+    data.profiler.endInterval("Bonded forces");
+    return energy;
+}
+
+void CpuCalcHarmonicBondForceKernel::copyParametersToContext(ContextImpl& context, const HarmonicBondForce& force, int firstBond, int lastBond) {
+    if (numBonds != force.getNumBonds())
+        throw OpenMMException("updateParametersInContext: The number of bonds has changed");
+
+    // Record the values.
+
+    for (int i = firstBond; i <= lastBond; ++i) {
+        int particle1, particle2;
+        double length, k;
+        force.getBondParameters(i, particle1, particle2, length, k);
+        if (particle1 != bondIndexArray[i][0] || particle2 != bondIndexArray[i][1])
+            throw OpenMMException("updateParametersInContext: The set of particles in a bond has changed");
+        bondParamArray[i][0] = length;
+        bondParamArray[i][1] = k;
+    }
+}
+
+CpuCalcCustomBondForceKernel::~CpuCalcCustomBondForceKernel() {
+    for (auto ixn : ixns)
+        delete ixn;
+}
+
+void CpuCalcCustomBondForceKernel::initialize(const System& system, const CustomBondForce& force) {
+    numBonds = force.getNumBonds();
+    int numParameters = force.getNumPerBondParameters();
+    usePeriodic = force.usesPeriodicBoundaryConditions();
+
+    // Build the arrays.
+
+    bondIndexArray.resize(numBonds, vector<int>(2));
+    bondParamArray.resize(numBonds, vector<double>(numParameters));
+    vector<double> params;
+    for (int i = 0; i < numBonds; ++i) {
+        int particle1, particle2;
+        force.getBondParameters(i, particle1, particle2, params);
+        bondIndexArray[i][0] = particle1;
+        bondIndexArray[i][1] = particle2;
+        for (int j = 0; j < numParameters; j++)
+            bondParamArray[i][j] = params[j];
+    }
+    bondForce.initialize(system.getNumParticles(), numBonds, 2, bondIndexArray, data.threads);
+
+    // Parse the expression used to calculate the force.
+
+    Lepton::ParsedExpression expression = Lepton::Parser::parse(force.getEnergyFunction()).optimize();
+    Lepton::CompiledExpression energyExpression = expression.createCompiledExpression();
+    Lepton::CompiledExpression forceExpression = expression.differentiate("r").createCompiledExpression();
+    vector<string> parameterNames;
+    vector<Lepton::CompiledExpression> energyParamDerivExpressions;
+    for (int i = 0; i < numParameters; i++)
+        parameterNames.push_back(force.getPerBondParameterName(i));
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        globalParameterNames.push_back(force.getGlobalParameterName(i));
+    for (int i = 0; i < force.getNumEnergyParameterDerivatives(); i++) {
+        string param = force.getEnergyParameterDerivativeName(i);
+        energyParamDerivNames.push_back(param);
+        energyParamDerivExpressions.push_back(expression.differentiate(param).createCompiledExpression());
+    }
+    set<string> variables;
+    variables.insert("r");
+    variables.insert(parameterNames.begin(), parameterNames.end());
+    variables.insert(globalParameterNames.begin(), globalParameterNames.end());
+    validateVariables(expression.getRootNode(), variables);
+
+    // Evaluating an expression is not thread safe, so each thread gets its own copy.
+
+    for (int i = 0; i < data.threads.getNumThreads(); i++)
+        ixns.push_back(new ReferenceCustomBondIxn(energyExpression, forceExpression, parameterNames, energyParamDerivExpressions));
+}
+
+double CpuCalcCustomBondForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double energy = 0;
+    map<string, double> globalParameters;
+    for (auto& name : globalParameterNames)
+        globalParameters[name] = context.getParameter(name);
+    vector<ReferenceBondIxn*> bondIxns;
+    for (auto ixn : ixns) {
+        ixn->setGlobalParameters(globalParameters);
+        if (usePeriodic)
+            ixn->setPeriodic(extractBoxVectors(context));
+        bondIxns.push_back(ixn);
+    }
+    vector<double> energyParamDerivValues(energyParamDerivNames.size()+1, 0.0);
+    data.profiler.startInterval();
+    bondForce.calculateForce(posData, bondParamArray, forceData, includeEnergy ? &energy : NULL, bondIxns, &energyParamDerivValues[0], energyParamDerivNames.size());
+    data.profiler.endInterval("Bonded forces");
+    map<string, double>& energyParamDerivs = extractEnergyParameterDerivatives(context);
+    for (int i = 0; i < energyParamDerivNames.size(); i++)
+        energyParamDerivs[energyParamDerivNames[i]] += energyParamDerivValues[i];
+    return energy;
+}
+
+void CpuCalcCustomBondForceKernel::copyParametersToContext(ContextImpl& context, const CustomBondForce& force, int firstBond, int lastBond) {
+    if (numBonds != force.getNumBonds())
+        throw OpenMMException("updateParametersInContext: The number of bonds has changed");
+
+    // Record the values.
+
+    int numParameters = force.getNumPerBondParameters();
+    vector<double> params;
+    for (int i = firstBond; i <= lastBond; ++i) {
+        int particle1, particle2;
+        force.getBondParameters(i, particle1, particle2, params);
+        if (particle1 != bondIndexArray[i][0] || particle2 != bondIndexArray[i][1])
+            throw OpenMMException("updateParametersInContext: The set of particles in a bond has changed");
+        for (int j = 0; j < numParameters; j++)
+            bondParamArray[i][j] = params[j];
+    }
+}
+
 void CpuCalcHarmonicAngleForceKernel::initialize(const System& system, const HarmonicAngleForce& force) {
     numAngles = force.getNumAngles();
     angleIndexArray.resize(numAngles, vector<int>(3));
@@ -343,7 +617,9 @@ double CpuCalcHarmonicAngleForceKernel::execute(ContextImpl& context, bool inclu
     ReferenceAngleBondIxn angleBond;
     if (usePeriodic)
         angleBond.setPeriodic(extractBoxVectors(context));
+    data.profiler.startInterval();
     bondForce.calculateForce(posData, angleParamArray, forceData, includeEnergy ? &energy : NULL, angleBond);
+    data.profiler.endInterval("Bonded forces");
     return energy;
 }
 
@@ -364,6 +640,102 @@ void CpuCalcHarmonicAngleForceKernel::copyParametersToContext(ContextImpl& conte
     }
 }
 
+CpuCalcCustomAngleForceKernel::~CpuCalcCustomAngleForceKernel() {
+    for (auto ixn : ixns)
+        delete ixn;
+}
+
+void CpuCalcCustomAngleForceKernel::initialize(const System& system, const CustomAngleForce& force) {
+    numAngles = force.getNumAngles();
+    int numParameters = force.getNumPerAngleParameters();
+    usePeriodic = force.usesPeriodicBoundaryConditions();
+
+    // Build the arrays.
+
+    angleIndexArray.resize(numAngles, vector<int>(3));
+    angleParamArray.resize(numAngles, vector<double>(numParameters));
+    vector<double> params;
+    for (int i = 0; i < numAngles; ++i) {
+        int particle1, particle2, particle3;
+        force.getAngleParameters(i, particle1, particle2, particle3, params);
+        angleIndexArray[i][0] = particle1;
+        angleIndexArray[i][1] = particle2;
+        angleIndexArray[i][2] = particle3;
+        for (int j = 0; j < numParameters; j++)
+            angleParamArray[i][j] = params[j];
+    }
+    bondForce.initialize(system.getNumParticles(), numAngles, 3, angleIndexArray, data.threads);
+
+    // Parse the expression used to calculate the force.
+
+    Lepton::ParsedExpression expression = Lepton::Parser::parse(force.getEnergyFunction()).optimize();
+    Lepton::CompiledExpression energyExpression = expression.createCompiledExpression();
+    Lepton::CompiledExpression forceExpression = expression.differentiate("theta").createCompiledExpression();
+    vector<string> parameterNames;
+    vector<Lepton::CompiledExpression> energyParamDerivExpressions;
+    for (int i = 0; i < numParameters; i++)
+        parameterNames.push_back(force.getPerAngleParameterName(i));
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        globalParameterNames.push_back(force.getGlobalParameterName(i));
+    for (int i = 0; i < force.getNumEnergyParameterDerivatives(); i++) {
+        string param = force.getEnergyParameterDerivativeName(i);
+        energyParamDerivNames.push_back(param);
+        energyParamDerivExpressions.push_back(expression.differentiate(param).createCompiledExpression());
+    }
+    set<string> variables;
+    variables.insert("theta");
+    variables.insert(parameterNames.begin(), parameterNames.end());
+    variables.insert(globalParameterNames.begin(), globalParameterNames.end());
+    validateVariables(expression.getRootNode(), variables);
+
+    // Evaluating an expression is not thread safe, so each thread gets its own copy.
+
+    for (int i = 0; i < data.threads.getNumThreads(); i++)
+        ixns.push_back(new ReferenceCustomAngleIxn(energyExpression, forceExpression, parameterNames, energyParamDerivExpressions));
+}
+
+double CpuCalcCustomAngleForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double energy = 0;
+    map<string, double> globalParameters;
+    for (auto& name : globalParameterNames)
+        globalParameters[name] = context.getParameter(name);
+    vector<ReferenceBondIxn*> bondIxns;
+    for (auto ixn : ixns) {
+        ixn->setGlobalParameters(globalParameters);
+        if (usePeriodic)
+            ixn->setPeriodic(extractBoxVectors(context));
+        bondIxns.push_back(ixn);
+    }
+    vector<double> energyParamDerivValues(energyParamDerivNames.size()+1, 0.0);
+    data.profiler.startInterval();
+    bondForce.calculateForce(posData, angleParamArray, forceData, includeEnergy ? &energy : NULL, bondIxns, &energyParamDerivValues[0], energyParamDerivNames.size());
+    data.profiler.endInterval("Bonded forces");
+    map<string, double>& energyParamDerivs = extractEnergyParameterDerivatives(context);
+    for (int i = 0; i < energyParamDerivNames.size(); i++)
+        energyParamDerivs[energyParamDerivNames[i]] += energyParamDerivValues[i];
+    return energy;
+}
+
+void CpuCalcCustomAngleForceKernel::copyParametersToContext(ContextImpl& context, const CustomAngleForce& force, int firstAngle, int lastAngle) {
+    if (numAngles != force.getNumAngles())
+        throw OpenMMException("updateParametersInContext: The number of angles has changed");
+
+    // Record the values.
+
+    int numParameters = force.getNumPerAngleParameters();
+    vector<double> params;
+    for (int i = firstAngle; i <= lastAngle; ++i) {
+        int particle1, particle2, particle3;
+        force.getAngleParameters(i, particle1, particle2, particle3, params);
+        if (particle1 != angleIndexArray[i][0] || particle2 != angleIndexArray[i][1] || particle3 != angleIndexArray[i][2])
+            throw OpenMMException("updateParametersInContext: The set of particles in an angle has changed");
+        for (int j = 0; j < numParameters; j++)
+            angleParamArray[i][j] = params[j];
+    }
+}
+
 void CpuCalcPeriodicTorsionForceKernel::initialize(const System& system, const PeriodicTorsionForce& force) {
     numTorsions = force.getNumTorsions();
     torsionIndexArray.resize(numTorsions, vector<int>(4));
@@ -391,7 +763,9 @@ double CpuCalcPeriodicTorsionForceKernel::execute(ContextImpl& context, bool inc
     ReferenceProperDihedralBond periodicTorsionBond;
     if (usePeriodic)
         periodicTorsionBond.setPeriodic(extractBoxVectors(context));
+    data.profiler.startInterval();
     bondForce.calculateForce(posData, torsionParamArray, forceData, includeEnergy ? &energy : NULL, periodicTorsionBond);
+    data.profiler.endInterval("Bonded forces");
     return energy;
 }
 
@@ -443,7 +817,9 @@ double CpuCalcRBTorsionForceKernel::execute(ContextImpl& context, bool includeFo
     ReferenceRbDihedralBond rbTorsionBond;
     if (usePeriodic)
         rbTorsionBond.setPeriodic(extractBoxVectors(context));
+    data.profiler.startInterval();
     bondForce.calculateForce(posData, torsionParamArray, forceData, includeEnergy ? &energy : NULL, rbTorsionBond);
+    data.profiler.endInterval("Bonded forces");
     return energy;
 }
 
@@ -490,6 +866,175 @@ private:
 
 CpuNonbondedForce* createCpuNonbondedForceVec(const CpuNeighborList& neighbors);
 
+CpuCalcCustomTorsionForceKernel::~CpuCalcCustomTorsionForceKernel() {
+    for (auto ixn : ixns)
+        delete ixn;
+}
+
+void CpuCalcCustomTorsionForceKernel::initialize(const System& system, const CustomTorsionForce& force) {
+    numTorsions = force.getNumTorsions();
+    int numParameters = force.getNumPerTorsionParameters();
+    usePeriodic = force.usesPeriodicBoundaryConditions();
+
+    // Build the arrays.
+
+    torsionIndexArray.resize(numTorsions, vector<int>(4));
+    torsionParamArray.resize(numTorsions, vector<double>(numParameters));
+    vector<double> params;
+    for (int i = 0; i < numTorsions; ++i) {
+        int particle1, particle2, particle3, particle4;
+        force.getTorsionParameters(i, particle1, particle2, particle3, particle4, params);
+        torsionIndexArray[i][0] = particle1;
+        torsionIndexArray[i][1] = particle2;
+        torsionIndexArray[i][2] = particle3;
+        torsionIndexArray[i][3] = particle4;
+        for (int j = 0; j < numParameters; j++)
+            torsionParamArray[i][j] = params[j];
+    }
+    bondForce.initialize(system.getNumParticles(), numTorsions, 4, torsionIndexArray, data.threads);
+
+    // Parse the expression used to calculate the force.
+
+    Lepton::ParsedExpression expression = Lepton::Parser::parse(force.getEnergyFunction()).optimize();
+    Lepton::CompiledExpression energyExpression = expression.createCompiledExpression();
+    Lepton::CompiledExpression forceExpression = expression.differentiate("theta").createCompiledExpression();
+    vector<string> parameterNames;
+    vector<Lepton::CompiledExpression> energyParamDerivExpressions;
+    for (int i = 0; i < numParameters; i++)
+        parameterNames.push_back(force.getPerTorsionParameterName(i));
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        globalParameterNames.push_back(force.getGlobalParameterName(i));
+    for (int i = 0; i < force.getNumEnergyParameterDerivatives(); i++) {
+        string param = force.getEnergyParameterDerivativeName(i);
+        energyParamDerivNames.push_back(param);
+        energyParamDerivExpressions.push_back(expression.differentiate(param).createCompiledExpression());
+    }
+    set<string> variables;
+    variables.insert("theta");
+    variables.insert(parameterNames.begin(), parameterNames.end());
+    variables.insert(globalParameterNames.begin(), globalParameterNames.end());
+    validateVariables(expression.getRootNode(), variables);
+
+    // Evaluating an expression is not thread safe, so each thread gets its own copy.
+
+    for (int i = 0; i < data.threads.getNumThreads(); i++)
+        ixns.push_back(new ReferenceCustomTorsionIxn(energyExpression, forceExpression, parameterNames, energyParamDerivExpressions));
+}
+
+double CpuCalcCustomTorsionForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double energy = 0;
+    map<string, double> globalParameters;
+    for (auto& name : globalParameterNames)
+        globalParameters[name] = context.getParameter(name);
+    vector<ReferenceBondIxn*> bondIxns;
+    for (auto ixn : ixns) {
+        ixn->setGlobalParameters(globalParameters);
+        if (usePeriodic)
+            ixn->setPeriodic(extractBoxVectors(context));
+        bondIxns.push_back(ixn);
+    }
+    vector<double> energyParamDerivValues(energyParamDerivNames.size()+1, 0.0);
+    data.profiler.startInterval();
+    bondForce.calculateForce(posData, torsionParamArray, forceData, includeEnergy ? &energy : NULL, bondIxns, &energyParamDerivValues[0], energyParamDerivNames.size());
+    data.profiler.endInterval("Bonded forces");
+    map<string, double>& energyParamDerivs = extractEnergyParameterDerivatives(context);
+    for (int i = 0; i < energyParamDerivNames.size(); i++)
+        energyParamDerivs[energyParamDerivNames[i]] += energyParamDerivValues[i];
+    return energy;
+}
+
+void CpuCalcCustomTorsionForceKernel::copyParametersToContext(ContextImpl& context, const CustomTorsionForce& force, int firstTorsion, int lastTorsion) {
+    if (numTorsions != force.getNumTorsions())
+        throw OpenMMException("updateParametersInContext: The number of torsions has changed");
+
+    // Record the values.
+
+    int numParameters = force.getNumPerTorsionParameters();
+    vector<double> params;
+    for (int i = firstTorsion; i <= lastTorsion; ++i) {
+        int particle1, particle2, particle3, particle4;
+        force.getTorsionParameters(i, particle1, particle2, particle3, particle4, params);
+        if (particle1 != torsionIndexArray[i][0] || particle2 != torsionIndexArray[i][1] || particle3 != torsionIndexArray[i][2] || particle4 != torsionIndexArray[i][3])
+            throw OpenMMException("updateParametersInContext: The set of particles in a torsion has changed");
+        for (int j = 0; j < numParameters; j++)
+            torsionParamArray[i][j] = params[j];
+    }
+}
+
+CpuCalcCMAPTorsionForceKernel::~CpuCalcCMAPTorsionForceKernel() {
+    if (ixn != NULL)
+        delete ixn;
+}
+
+void CpuCalcCMAPTorsionForceKernel::initialize(const System& system, const CMAPTorsionForce& force) {
+    int numTorsions = force.getNumTorsions();
+    torsionIndices.resize(numTorsions, vector<int>(8));
+    torsionParams.resize(numTorsions, vector<double>(1));
+    for (int i = 0; i < numTorsions; i++) {
+        int map;
+        force.getTorsionParameters(i, map, torsionIndices[i][0], torsionIndices[i][1], torsionIndices[i][2],
+            torsionIndices[i][3], torsionIndices[i][4], torsionIndices[i][5], torsionIndices[i][6], torsionIndices[i][7]);
+
+        // The interaction identifies each torsion pair by its index.
+
+        torsionParams[i][0] = i;
+    }
+    bondForce.initialize(system.getNumParticles(), numTorsions, 8, torsionIndices, data.threads);
+    usePeriodic = force.usesPeriodicBoundaryConditions();
+    createInteraction(force);
+}
+
+void CpuCalcCMAPTorsionForceKernel::createInteraction(const CMAPTorsionForce& force) {
+    int numMaps = force.getNumMaps();
+    int numTorsions = force.getNumTorsions();
+    vector<vector<vector<double> > > coeff(numMaps);
+    vector<double> energy;
+    vector<vector<double> > c;
+    for (int i = 0; i < numMaps; i++) {
+        int size;
+        force.getMapParameters(i, size, energy);
+        CMAPTorsionForceImpl::calcMapDerivatives(size, energy, c);
+        coeff[i].resize(size*size);
+        for (int j = 0; j < size*size; j++)
+            coeff[i][j] = vector<double>(c[j].begin(), c[j].begin()+16);
+    }
+    vector<int> torsionMaps(numTorsions);
+    for (int i = 0; i < numTorsions; i++) {
+        int index[8];
+        force.getTorsionParameters(i, torsionMaps[i], index[0], index[1], index[2], index[3], index[4], index[5], index[6], index[7]);
+    }
+    if (ixn != NULL)
+        delete ixn;
+    ixn = new ReferenceCMAPTorsionIxn(coeff, torsionMaps, torsionIndices);
+}
+
+double CpuCalcCMAPTorsionForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double energy = 0;
+    if (usePeriodic)
+        ixn->setPeriodic(extractBoxVectors(context));
+    data.profiler.startInterval();
+    bondForce.calculateForce(posData, torsionParams, forceData, includeEnergy ? &energy : NULL, *ixn);
+    data.profiler.endInterval("Bonded forces");
+    return energy;
+}
+
+void CpuCalcCMAPTorsionForceKernel::copyParametersToContext(ContextImpl& context, const CMAPTorsionForce& force) {
+    if (torsionIndices.size() != force.getNumTorsions())
+        throw OpenMMException("updateParametersInContext: The number of CMAP torsions has changed");
+    for (int i = 0; i < force.getNumTorsions(); i++) {
+        int map, index[8];
+        force.getTorsionParameters(i, map, index[0], index[1], index[2], index[3], index[4], index[5], index[6], index[7]);
+        for (int j = 0; j < 8; j++)
+            if (index[j] != torsionIndices[i][j])
+                throw OpenMMException("updateParametersInContext: The set of particles in a CMAP torsion has changed");
+    }
+    createInteraction(force);
+}
+
 CpuCalcNonbondedForceKernel::CpuCalcNonbondedForceKernel(string name, const Platform& platform, CpuPlatform::PlatformData& data) : CalcNonbondedForceKernel(name, platform),
         data(data), hasInitializedPme(false), hasInitializedDispersionPme(false), nonbonded(NULL) {
 }
@@ -514,19 +1059,19 @@ void CpuCalcNonbondedForceKernel::initialize(const System& system, const Nonbond
         exceptionsWithOffsets.insert(exception);
     }
     numParticles = force.getNumParticles();
-    exclusions.resize(numParticles);
+    vector<pair<int, int> > excludedPairs(force.getNumExceptions());
     vector<int> nb14s;
     for (int i = 0; i < force.getNumExceptions(); i++) {
         int particle1, particle2;
         double chargeProd, sigma, epsilon;
         force.getExceptionParameters(i, particle1, particle2, chargeProd, sigma, epsilon);
-        exclusions[particle1].insert(particle2);
-        exclusions[particle2].insert(particle1);
+        excludedPairs[i] = make_pair(particle1, particle2);
         if (chargeProd != 0.0 || epsilon != 0.0 || exceptionsWithOffsets.find(i) != exceptionsWithOffsets.end()) {
             nb14Index[i] = nb14s.size();
             nb14s.push_back(i);
         }
     }
+    exclusions = ExclusionList(numParticles, excludedPairs, data.threads);
 
     // Record the particle parameters.
 
@@ -647,6 +1192,7 @@ double CpuCalcNonbondedForceKernel::execute(ContextImpl& context, bool includeFo
             if (useOptimizedPme) {
                 optimizedPme = getPlatform().createKernel(CalcPmeReciprocalForceKernel::Name(), context);
                 optimizedPme.getAs<CalcPmeReciprocalForceKernel>().initialize(gridSize[0], gridSize[1], gridSize[2], numParticles, ewaldAlpha, data.deterministicForces);
+                optimizedPme.getAs<CalcPmeReciprocalForceKernel>().setProfilingEnabled(data.profiler.getEnabled());
             }
         }
         if (nonbondedMethod == LJPME) {
@@ -659,6 +1205,7 @@ double CpuCalcNonbondedForceKernel::execute(ContextImpl& context, bool includeFo
             if (useOptimizedPme) {
                 optimizedPme = getPlatform().createKernel(CalcPmeReciprocalForceKernel::Name(), context);
                 optimizedPme.getAs<CalcPmeReciprocalForceKernel>().initialize(gridSize[0], gridSize[1], gridSize[2], numParticles, ewaldAlpha, data.deterministicForces);
+                optimizedPme.getAs<CalcPmeReciprocalForceKernel>().setProfilingEnabled(data.profiler.getEnabled());
                 optimizedDispersionPme = getPlatform().createKernel(CalcDispersionPmeReciprocalForceKernel::Name(), context);
                 optimizedDispersionPme.getAs<CalcDispersionPmeReciprocalForceKernel>().initialize(dispersionGridSize[0], dispersionGridSize[1],
                                                                                                   dispersionGridSize[2], numParticles, ewaldDispersionAlpha, data.deterministicForces);
@@ -685,6 +1232,7 @@ double CpuCalcNonbondedForceKernel::execute(ContextImpl& context, bool includeFo
         nonbonded->setPeriodic(boxVectors);
         nonbonded->setPeriodicExceptions(exceptionsArePeriodic);
     }
+    nonbonded->setDeterministic(data.deterministicForces);
     if (ewald)
         nonbonded->setUseEwald(ewaldAlpha, kmax[0], kmax[1], kmax[2]);
     if (pme)
@@ -696,9 +1244,13 @@ double CpuCalcNonbondedForceKernel::execute(ContextImpl& context, bool includeFo
         nonbonded->setUseLJPME(ewaldDispersionAlpha, dispersionGridSize);
     }
     double nonbondedEnergy = 0;
-    if (includeDirect)
+    if (includeDirect) {
+        data.profiler.startInterval();
         nonbonded->calculateDirectIxn(numParticles, &posq[0], posData, particleParams, C6params, exclusions, data.threadForce, includeEnergy ? &nonbondedEnergy : NULL, data.threads);
+        data.profiler.endInterval("Nonbonded direct space");
+    }
     if (includeReciprocal) {
+        data.profiler.startInterval();
         if (useOptimizedPme) {
             PmeIO io(&posq[0], &data.threadForce[0][0], numParticles);
             Vec3 periodicBoxVectors[3] = {boxVectors[0], boxVectors[1], boxVectors[2]};
@@ -709,9 +1261,12 @@ double CpuCalcNonbondedForceKernel::execute(ContextImpl& context, bool includeFo
                 optimizedDispersionPme.getAs<CalcDispersionPmeReciprocalForceKernel>().beginComputation(io, periodicBoxVectors, includeEnergy);
                 nonbondedEnergy += optimizedDispersionPme.getAs<CalcDispersionPmeReciprocalForceKernel>().finishComputation(io);
             }
+            if (data.profiler.getEnabled())
+                optimizedPme.getAs<CalcPmeReciprocalForceKernel>().collectProfilingTimes(data.profiler.getTimes());
         }
         else
             nonbonded->calculateReciprocalIxn(numParticles, &posq[0], posData, particleParams, C6params, exclusions, forceData, includeEnergy ? &nonbondedEnergy : NULL);
+        data.profiler.endInterval("Nonbonded reciprocal space");
         if (ewald || pme || ljpme) {
             // Add the correction for the neutralizing plasma.
 
@@ -726,7 +1281,9 @@ double CpuCalcNonbondedForceKernel::execute(ContextImpl& context, bool includeFo
             Vec3* boxVectors = extractBoxVectors(context);
             nonbonded14.setPeriodic(boxVectors);
         }
+        data.profiler.startInterval();
         bondForce.calculateForce(posData, bonded14ParamArray, forceData, includeEnergy ? &energy : NULL, nonbonded14);
+        data.profiler.endInterval("Nonbonded exceptions");
         if (data.isPeriodic && nonbondedMethod != LJPME)
             energy += dispersionCoefficient/(boxVectors[0][0]*boxVectors[1][1]*boxVectors[2][2]);
     }
@@ -914,13 +1471,10 @@ void CpuCalcCustomNonbondedForceKernel::initialize(const System& system, const C
     // Record the exclusions.
 
     numParticles = force.getNumParticles();
-    exclusions.resize(numParticles);
-    for (int i = 0; i < force.getNumExclusions(); i++) {
-        int particle1, particle2;
-        force.getExclusionParticles(i, particle1, particle2);
-        exclusions[particle1].insert(particle2);
-        exclusions[particle2].insert(particle1);
-    }
+    vector<pair<int, int> > excludedPairs(force.getNumExclusions());
+    for (int i = 0; i < force.getNumExclusions(); i++)
+        force.getExclusionParticles(i, excludedPairs[i].first, excludedPairs[i].second);
+    exclusions = ExclusionList(numParticles, excludedPairs, data.threads);
 
     // Build the arrays.
 
@@ -1092,7 +1646,7 @@ void CpuCalcCustomNonbondedForceKernel::copyParametersToContext(ContextImpl& con
     // If necessary, recompute the long range correction.
     
     if (forceCopy != NULL) {
-        longRangeCorrectionData = CustomNonbondedForceImpl::prepareLongRangeCorrection(force, data.threads.getNumThreads());
+        longRangeCorrectionData = CustomNonbondedForceImpl::prepareLongRangeCorrection(force, data.threads.getNumThreads(), longRangeCorrectionData);
         CustomNonbondedForceImpl::calcLongRangeCorrection(force, longRangeCorrectionData, context.getOwner(), longRangeCoefficient, longRangeCoefficientDerivs, data.threads);
         hasInitializedLongRangeCorrection = true;
         *forceCopy = force;
@@ -1193,13 +1747,10 @@ void CpuCalcCustomGBForceKernel::initialize(const System& system, const CustomGB
     // Record the exclusions.
 
     numParticles = force.getNumParticles();
-    exclusions.resize(numParticles);
-    for (int i = 0; i < force.getNumExclusions(); i++) {
-        int particle1, particle2;
-        force.getExclusionParticles(i, particle1, particle2);
-        exclusions[particle1].insert(particle2);
-        exclusions[particle2].insert(particle1);
-    }
+    vector<pair<int, int> > excludedPairs(force.getNumExclusions());
+    for (int i = 0; i < force.getNumExclusions(); i++)
+        force.getExclusionParticles(i, excludedPairs[i].first, excludedPairs[i].second);
+    exclusions = ExclusionList(numParticles, excludedPairs, data.threads);
 
     // Build the arrays.
 
@@ -1243,6 +1794,8 @@ void CpuCalcCustomGBForceKernel::createInteraction(const CustomGBForce& force) {
     vector<vector<Lepton::CompiledExpression> > valueParamDerivExpressions(force.getNumComputedValues());
     vector<Lepton::CompiledExpression> valueExpressions;
     vector<Lepton::CompiledExpression> energyExpressions;
+    vector<Lepton::ParsedExpression> parsedValueExpressions;
+    vector<vector<Lepton::ParsedExpression> > parsedEnergyExpressions(force.getNumEnergyTerms());
     set<string> particleVariables, pairVariables;
     pairVariables.insert("r");
     particleVariables.insert("x");
@@ -1261,6 +1814,7 @@ void CpuCalcCustomGBForceKernel::createInteraction(const CustomGBForce& force) {
         force.getComputedValueParameters(i, name, expression, type);
         Lepton::ParsedExpression ex = Lepton::Parser::parse(expression, functions).optimize();
         valueExpressions.push_back(ex.createCompiledExpression());
+        parsedValueExpressions.push_back(ex);
         valueTypes.push_back(type);
         valueNames.push_back(name);
         if (i == 0) {
@@ -1298,8 +1852,11 @@ void CpuCalcCustomGBForceKernel::createInteraction(const CustomGBForce& force) {
         Lepton::ParsedExpression ex = Lepton::Parser::parse(expression, functions).optimize();
         energyExpressions.push_back(ex.createCompiledExpression());
         energyTypes.push_back(type);
-        if (type != CustomGBForce::SingleParticle)
+        if (type != CustomGBForce::SingleParticle) {
             energyDerivExpressions[i].push_back(ex.differentiate("r").createCompiledExpression());
+            parsedEnergyExpressions[i].push_back(ex);
+            parsedEnergyExpressions[i].push_back(ex.differentiate("r").optimize());
+        }
         for (int j = 0; j < force.getNumComputedValues(); j++) {
             if (type == CustomGBForce::SingleParticle) {
                 energyDerivExpressions[i].push_back(ex.differentiate(valueNames[j]).createCompiledExpression());
@@ -1311,6 +1868,8 @@ void CpuCalcCustomGBForceKernel::createInteraction(const CustomGBForce& force) {
             else {
                 energyDerivExpressions[i].push_back(ex.differentiate(valueNames[j]+"1").createCompiledExpression());
                 energyDerivExpressions[i].push_back(ex.differentiate(valueNames[j]+"2").createCompiledExpression());
+                parsedEnergyExpressions[i].push_back(ex.differentiate(valueNames[j]+"1").optimize());
+                parsedEnergyExpressions[i].push_back(ex.differentiate(valueNames[j]+"2").optimize());
                 validateVariables(ex.getRootNode(), pairVariables);
             }
         }
@@ -1318,13 +1877,19 @@ void CpuCalcCustomGBForceKernel::createInteraction(const CustomGBForce& force) {
             energyParamDerivExpressions[i].push_back(ex.differentiate(force.getEnergyParameterDerivativeName(j)).createCompiledExpression());
     }
 
-    // Delete the custom functions.
+    // Create the interaction.  Unless derivatives with respect to global parameters are needed, the pair
+    // expressions are also compiled as vectorized expressions that process batches of pairs at once.
 
-    for (auto& function : functions)
-        delete function.second;
     ixn = new CpuCustomGBForce(numParticles, exclusions, valueExpressions, valueDerivExpressions, valueGradientExpressions, valueParamDerivExpressions,
         valueNames, valueTypes, energyExpressions, energyDerivExpressions, energyGradientExpressions, energyParamDerivExpressions, energyTypes,
         particleParameterNames, data.threads);
+    if (force.getNumComputedValues() > 0 && force.getNumEnergyParameterDerivatives() == 0)
+        ixn->setVectorizedExpressions(parsedValueExpressions[0], parsedValueExpressions[0].differentiate("r").optimize(), parsedEnergyExpressions);
+
+    // Delete the custom functions.
+
+    for (auto& function : functions)
+        delete function.second;
 }
 
 double CpuCalcCustomGBForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
@@ -1334,8 +1899,7 @@ double CpuCalcCustomGBForceKernel::execute(ContextImpl& context, bool includeFor
     if (data.isPeriodic)
         ixn->setPeriodic(extractBoxSize(context));
     if (nonbondedMethod != NoCutoff) {
-        vector<set<int> > noExclusions(numParticles);
-        neighborList->computeNeighborList(numParticles, data.posq, noExclusions, boxVectors, data.isPeriodic, nonbondedCutoff, data.threads);
+        neighborList->computeNeighborList(numParticles, data.posq, ExclusionList(numParticles), boxVectors, data.isPeriodic, nonbondedCutoff, data.threads);
         ixn->setUseCutoff(nonbondedCutoff, *neighborList);
     }
     map<string, double> globalParameters;
@@ -1381,18 +1945,310 @@ void CpuCalcCustomGBForceKernel::copyParametersToContext(ContextImpl& context, c
     }
 }
 
-CpuCalcCustomManyParticleForceKernel::~CpuCalcCustomManyParticleForceKernel() {
-    if (ixn != NULL)
+CpuCalcCustomCentroidBondForceKernel::~CpuCalcCustomCentroidBondForceKernel() {
+    for (auto ixn : ixns)
         delete ixn;
 }
 
-void CpuCalcCustomManyParticleForceKernel::initialize(const System& system, const CustomManyParticleForce& force) {
+void CpuCalcCustomCentroidBondForceKernel::initialize(const System& system, const CustomCentroidBondForce& force) {
+    usePeriodic = force.usesPeriodicBoundaryConditions();
 
     // Build the arrays.
 
-    numParticles = system.getNumParticles();
-    particleParamArray.resize(numParticles);
-    for (int i = 0; i < numParticles; ++i) {
+    numGroups = force.getNumGroups();
+    groupAtoms.resize(numGroups);
+    vector<double> ignored;
+    for (int i = 0; i < numGroups; i++)
+        force.getGroupParameters(i, groupAtoms[i], ignored);
+    CustomCentroidBondForceImpl::computeNormalizedWeights(force, system, normalizedWeights);
+    numBonds = force.getNumBonds();
+    bondGroups.resize(numBonds);
+    bondParamArray.resize(numBonds);
+    for (int i = 0; i < numBonds; ++i)
+        force.getBondParameters(i, bondGroups[i], bondParamArray[i]);
+    groupCenters.resize(numGroups);
+    groupForces.resize(numGroups);
+
+    // An atom may belong to several groups, so record the groups containing each atom.  That lets
+    // threads apply the group forces to disjoint sets of atoms.
+
+    int numParticles = system.getNumParticles();
+    vector<vector<pair<int, double> > > atomMembership(numParticles);
+    for (int i = 0; i < numGroups; i++)
+        for (int j = 0; j < groupAtoms[i].size(); j++)
+            atomMembership[groupAtoms[i][j]].push_back(make_pair(i, normalizedWeights[i][j]));
+    atomGroupOffsets.push_back(0);
+    for (int i = 0; i < numParticles; i++) {
+        if (atomMembership[i].size() == 0)
+            continue;
+        groupedAtoms.push_back(i);
+        for (auto& member : atomMembership[i]) {
+            atomGroups.push_back(member.first);
+            atomGroupWeights.push_back(member.second);
+        }
+        atomGroupOffsets.push_back(atomGroups.size());
+    }
+
+    // Each group is treated as a particle when dividing the bonds between threads.
+
+    bondForce.initialize(numGroups, numBonds, force.getNumGroupsPerBond(), bondGroups, data.threads);
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        globalParameterNames.push_back(force.getGlobalParameterName(i));
+    for (int i = 0; i < force.getNumEnergyParameterDerivatives(); i++)
+        energyParamDerivNames.push_back(force.getEnergyParameterDerivativeName(i));
+
+    // Record the tabulated function update counts for future reference.
+
+    for (int i = 0; i < force.getNumTabulatedFunctions(); i++)
+        tabulatedFunctionUpdateCount[force.getTabulatedFunctionName(i)] = force.getTabulatedFunction(i).getUpdateCount();
+    createInteractions(force);
+}
+
+void CpuCalcCustomCentroidBondForceKernel::createInteractions(const CustomCentroidBondForce& force) {
+    for (auto ixn : ixns)
+        delete ixn;
+    ixns.clear();
+
+    // Create custom functions for the tabulated functions and point functions.
+
+    map<string, Lepton::CustomFunction*> functions;
+    for (int i = 0; i < force.getNumTabulatedFunctions(); i++)
+        functions[force.getTabulatedFunctionName(i)] = createReferenceTabulatedFunction(force.getTabulatedFunction(i));
+    functions["pointdistance"] = new ReferencePointDistanceFunction(usePeriodic, &boxVectors);
+    functions["pointangle"] = new ReferencePointAngleFunction(usePeriodic, &boxVectors);
+    functions["pointdihedral"] = new ReferencePointDihedralFunction(usePeriodic, &boxVectors);
+
+    // Evaluating an expression is not thread safe, so each thread gets its own copy.
+
+    Lepton::ParsedExpression energyExpression = CustomCentroidBondForceImpl::prepareExpression(force, functions);
+    vector<string> bondParameterNames;
+    for (int i = 0; i < force.getNumPerBondParameters(); i++)
+        bondParameterNames.push_back(force.getPerBondParameterName(i));
+    vector<Lepton::CompiledExpression> energyParamDerivExpressions;
+    for (auto& param : energyParamDerivNames)
+        energyParamDerivExpressions.push_back(energyExpression.differentiate(param).createCompiledExpression());
+    for (int i = 0; i < data.threads.getNumThreads(); i++)
+        ixns.push_back(new ReferenceCustomCentroidBondIxn(force.getNumGroupsPerBond(), groupAtoms, normalizedWeights, bondGroups, energyExpression, bondParameterNames, energyParamDerivExpressions));
+    for (auto& function : functions)
+        delete function.second;
+}
+
+double CpuCalcCustomCentroidBondForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double energy = 0;
+    map<string, double> globalParameters;
+    for (auto& name : globalParameterNames)
+        globalParameters[name] = context.getParameter(name);
+    if (usePeriodic)
+        boxVectors = extractBoxVectors(context);
+    vector<ReferenceBondIxn*> bondIxns;
+    for (auto ixn : ixns) {
+        ixn->setGlobalParameters(globalParameters);
+        if (usePeriodic)
+            ixn->setPeriodic(boxVectors);
+        bondIxns.push_back(ixn);
+    }
+
+    // Compute the center of each group.  Groups can be very different in size, so threads take
+    // them in small chunks.
+
+    data.threads.parallelFor(numGroups, 4, [&] (ThreadPool& threads, int threadIndex, int start, int end) {
+        for (int group = start; group < end; group++) {
+            const vector<int>& atoms = groupAtoms[group];
+            const vector<double>& weights = normalizedWeights[group];
+            Vec3 center;
+            for (int i = 0; i < atoms.size(); i++)
+                center += posData[atoms[i]]*weights[i];
+            groupCenters[group] = center;
+            groupForces[group] = Vec3();
+        }
+    });
+
+    // Compute the forces on groups.
+
+    vector<double> energyParamDerivValues(energyParamDerivNames.size()+1, 0.0);
+    data.profiler.startInterval();
+    bondForce.calculateForce(groupCenters, bondParamArray, groupForces, includeEnergy ? &energy : NULL, bondIxns, &energyParamDerivValues[0], energyParamDerivNames.size());
+    data.profiler.endInterval("Bonded forces");
+    map<string, double>& energyParamDerivs = extractEnergyParameterDerivatives(context);
+    for (int i = 0; i < energyParamDerivNames.size(); i++)
+        energyParamDerivs[energyParamDerivNames[i]] += energyParamDerivValues[i];
+
+    // Apply the forces to the individual atoms.
+
+    if (includeForces) {
+        data.threads.parallelFor(groupedAtoms.size(), 64, [&] (ThreadPool& threads, int threadIndex, int start, int end) {
+            for (int i = start; i < end; i++) {
+                Vec3 f;
+                for (int j = atomGroupOffsets[i]; j < atomGroupOffsets[i+1]; j++)
+                    f += groupForces[atomGroups[j]]*atomGroupWeights[j];
+                forceData[groupedAtoms[i]] += f;
+            }
+        });
+    }
+    return energy;
+}
+
+void CpuCalcCustomCentroidBondForceKernel::copyParametersToContext(ContextImpl& context, const CustomCentroidBondForce& force) {
+    if (numBonds != force.getNumBonds())
+        throw OpenMMException("updateParametersInContext: The number of bonds has changed");
+
+    // Record the values.
+
+    int numParameters = force.getNumPerBondParameters();
+    vector<int> groups;
+    vector<double> params;
+    for (int i = 0; i < numBonds; ++i) {
+        force.getBondParameters(i, groups, params);
+        for (int j = 0; j < groups.size(); j++)
+            if (groups[j] != bondGroups[i][j])
+                throw OpenMMException("updateParametersInContext: The set of groups in a bond has changed");
+        for (int j = 0; j < numParameters; j++)
+            bondParamArray[i][j] = params[j];
+    }
+
+    // See if any tabulated functions have changed.
+
+    bool changed = false;
+    for (int i = 0; i < force.getNumTabulatedFunctions(); i++) {
+        string name = force.getTabulatedFunctionName(i);
+        if (force.getTabulatedFunction(i).getUpdateCount() != tabulatedFunctionUpdateCount[name]) {
+            tabulatedFunctionUpdateCount[name] = force.getTabulatedFunction(i).getUpdateCount();
+            changed = true;
+        }
+    }
+    if (changed)
+        createInteractions(force);
+}
+
+CpuCalcCustomCompoundBondForceKernel::~CpuCalcCustomCompoundBondForceKernel() {
+    for (auto ixn : ixns)
+        delete ixn;
+}
+
+void CpuCalcCustomCompoundBondForceKernel::initialize(const System& system, const CustomCompoundBondForce& force) {
+    usePeriodic = force.usesPeriodicBoundaryConditions();
+
+    // Build the arrays.
+
+    numBonds = force.getNumBonds();
+    bondParticles.resize(numBonds);
+    bondParamArray.resize(numBonds);
+    for (int i = 0; i < numBonds; ++i)
+        force.getBondParameters(i, bondParticles[i], bondParamArray[i]);
+    bondForce.initialize(system.getNumParticles(), numBonds, force.getNumParticlesPerBond(), bondParticles, data.threads);
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        globalParameterNames.push_back(force.getGlobalParameterName(i));
+    for (int i = 0; i < force.getNumEnergyParameterDerivatives(); i++)
+        energyParamDerivNames.push_back(force.getEnergyParameterDerivativeName(i));
+
+    // Record the tabulated function update counts for future reference.
+
+    for (int i = 0; i < force.getNumTabulatedFunctions(); i++)
+        tabulatedFunctionUpdateCount[force.getTabulatedFunctionName(i)] = force.getTabulatedFunction(i).getUpdateCount();
+    createInteractions(force);
+}
+
+void CpuCalcCustomCompoundBondForceKernel::createInteractions(const CustomCompoundBondForce& force) {
+    for (auto ixn : ixns)
+        delete ixn;
+    ixns.clear();
+
+    // Create custom functions for the tabulated functions and point functions.
+
+    map<string, Lepton::CustomFunction*> functions;
+    for (int i = 0; i < force.getNumTabulatedFunctions(); i++)
+        functions[force.getTabulatedFunctionName(i)] = createReferenceTabulatedFunction(force.getTabulatedFunction(i));
+    functions["pointdistance"] = new ReferencePointDistanceFunction(usePeriodic, &boxVectors);
+    functions["pointangle"] = new ReferencePointAngleFunction(usePeriodic, &boxVectors);
+    functions["pointdihedral"] = new ReferencePointDihedralFunction(usePeriodic, &boxVectors);
+
+    // Evaluating an expression is not thread safe, so each thread gets its own copy.
+
+    Lepton::ParsedExpression energyExpression = CustomCompoundBondForceImpl::prepareExpression(force, functions);
+    vector<string> bondParameterNames;
+    for (int i = 0; i < force.getNumPerBondParameters(); i++)
+        bondParameterNames.push_back(force.getPerBondParameterName(i));
+    vector<Lepton::CompiledExpression> energyParamDerivExpressions;
+    for (auto& param : energyParamDerivNames)
+        energyParamDerivExpressions.push_back(energyExpression.differentiate(param).createCompiledExpression());
+    for (int i = 0; i < data.threads.getNumThreads(); i++)
+        ixns.push_back(new ReferenceCustomCompoundBondIxn(force.getNumParticlesPerBond(), bondParticles, energyExpression, bondParameterNames, energyParamDerivExpressions));
+    for (auto& function : functions)
+        delete function.second;
+}
+
+double CpuCalcCustomCompoundBondForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double energy = 0;
+    map<string, double> globalParameters;
+    for (auto& name : globalParameterNames)
+        globalParameters[name] = context.getParameter(name);
+    if (usePeriodic)
+        boxVectors = extractBoxVectors(context);
+    vector<ReferenceBondIxn*> bondIxns;
+    for (auto ixn : ixns) {
+        ixn->setGlobalParameters(globalParameters);
+        if (usePeriodic)
+            ixn->setPeriodic(boxVectors);
+        bondIxns.push_back(ixn);
+    }
+    vector<double> energyParamDerivValues(energyParamDerivNames.size()+1, 0.0);
+    data.profiler.startInterval();
+    bondForce.calculateForce(posData, bondParamArray, forceData, includeEnergy ? &energy : NULL, bondIxns, &energyParamDerivValues[0], energyParamDerivNames.size());
+    data.profiler.endInterval("Bonded forces");
+    map<string, double>& energyParamDerivs = extractEnergyParameterDerivatives(context);
+    for (int i = 0; i < energyParamDerivNames.size(); i++)
+        energyParamDerivs[energyParamDerivNames[i]] += energyParamDerivValues[i];
+    return energy;
+}
+
+void CpuCalcCustomCompoundBondForceKernel::copyParametersToContext(ContextImpl& context, const CustomCompoundBondForce& force) {
+    if (numBonds != force.getNumBonds())
+        throw OpenMMException("updateParametersInContext: The number of bonds has changed");
+
+    // Record the values.
+
+    int numParameters = force.getNumPerBondParameters();
+    vector<int> particles;
+    vector<double> params;
+    for (int i = 0; i < numBonds; ++i) {
+        force.getBondParameters(i, particles, params);
+        for (int j = 0; j < particles.size(); j++)
+            if (particles[j] != bondParticles[i][j])
+                throw OpenMMException("updateParametersInContext: The set of particles in a bond has changed");
+        for (int j = 0; j < numParameters; j++)
+            bondParamArray[i][j] = params[j];
+    }
+
+    // See if any tabulated functions have changed.
+
+    bool changed = false;
+    for (int i = 0; i < force.getNumTabulatedFunctions(); i++) {
+        string name = force.getTabulatedFunctionName(i);
+        if (force.getTabulatedFunction(i).getUpdateCount() != tabulatedFunctionUpdateCount[name]) {
+            tabulatedFunctionUpdateCount[name] = force.getTabulatedFunction(i).getUpdateCount();
+            changed = true;
+        }
+    }
+    if (changed)
+        createInteractions(force);
+}
+
+CpuCalcCustomManyParticleForceKernel::~CpuCalcCustomManyParticleForceKernel() {
+    if (ixn != NULL)
+        delete ixn;
+}
+
+void CpuCalcCustomManyParticleForceKernel::initialize(const System& system, const CustomManyParticleForce& force) {
+
+    // Build the arrays.
+
+    numParticles = system.getNumParticles();
+    particleParamArray.resize(numParticles);
+    for (int i = 0; i < numParticles; ++i) {
         int type;
         force.getParticleParameters(i, particleParamArray[i], type);
     }
@@ -1485,6 +2341,40 @@ void CpuCalcGayBerneForceKernel::copyParametersToContext(ContextImpl& context, c
     ixn = new CpuGayBerneForce(force);
 }
 
+CpuIntegrateDPDStepKernel::~CpuIntegrateDPDStepKernel() {
+    if (dynamics)
+        delete dynamics;
+}
+
+void CpuIntegrateDPDStepKernel::initialize(const System& system, const DPDIntegrator& integrator) {
+    int numParticles = system.getNumParticles();
+    masses.resize(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+        masses[i] = system.getParticleMass(i);
+    dynamics = new CpuDPDDynamics(system, integrator, data.threads);
+}
+
+void CpuIntegrateDPDStepKernel::execute(ContextImpl& context, const DPDIntegrator& integrator) {
+    dynamics->setTemperature(integrator.getTemperature());
+    dynamics->setDeltaT(integrator.getStepSize());
+    dynamics->setReferenceConstraintAlgorithm(&extractConstraints(context));
+    dynamics->setVirtualSites(extractVirtualSites(context));
+    dynamics->setPeriodicBoxVectors(extractBoxVectors(context));
+    ReferencePlatform::PlatformData* refData = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    dynamics->setStepIndex(refData->stepCount);
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    data.profiler.startInterval();
+    dynamics->update(context, posData, velData, masses, integrator.getConstraintTolerance());
+    data.profiler.endInterval("Integration");
+    refData->time += integrator.getStepSize();
+    refData->stepCount++;
+}
+
+double CpuIntegrateDPDStepKernel::computeKineticEnergy(ContextImpl& context, const DPDIntegrator& integrator) {
+    return computeShiftedKineticEnergy(context, masses, 0.0);
+}
+
 CpuIntegrateLangevinMiddleStepKernel::~CpuIntegrateLangevinMiddleStepKernel() {
     if (dynamics)
         delete dynamics;
@@ -1516,7 +2406,9 @@ void CpuIntegrateLangevinMiddleStepKernel::execute(ContextImpl& context, const L
         prevFriction = friction;
         prevStepSize = stepSize;
     }
+    data.profiler.startInterval();
     dynamics->update(context, posData, velData, masses, integrator.getConstraintTolerance());
+    data.profiler.endInterval("Integration");
     ReferencePlatform::PlatformData* refData = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
     refData->time += stepSize;
     refData->stepCount++;
@@ -1525,3 +2417,251 @@ void CpuIntegrateLangevinMiddleStepKernel::execute(ContextImpl& context, const L
 double CpuIntegrateLangevinMiddleStepKernel::computeKineticEnergy(ContextImpl& context, const LangevinMiddleIntegrator& integrator) {
     return computeShiftedKineticEnergy(context, masses, 0.0);
 }
+
+CpuIntegrateVerletStepKernel::~CpuIntegrateVerletStepKernel() {
+    if (dynamics)
+        delete dynamics;
+}
+
+void CpuIntegrateVerletStepKernel::initialize(const System& system, const VerletIntegrator& integrator) {
+    int numParticles = system.getNumParticles();
+    masses.resize(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+        masses[i] = system.getParticleMass(i);
+}
+
+void CpuIntegrateVerletStepKernel::execute(ContextImpl& context, const VerletIntegrator& integrator) {
+    double stepSize = integrator.getStepSize();
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    vector<Vec3>& forceData = extractForces(context);
+    if (dynamics == 0 || stepSize != prevStepSize) {
+        // Recreate the computation objects with the new parameters.
+        
+        if (dynamics)
+            delete dynamics;
+        dynamics = new CpuVerletDynamics(context.getSystem().getNumParticles(), stepSize, data.threads);
+        dynamics->setReferenceConstraintAlgorithm(&extractConstraints(context));
+        dynamics->setVirtualSites(extractVirtualSites(context));
+        prevStepSize = stepSize;
+    }
+    data.profiler.startInterval();
+    dynamics->update(context.getSystem(), posData, velData, forceData, masses, integrator.getConstraintTolerance());
+    data.profiler.endInterval("Integration");
+    ReferencePlatform::PlatformData* refData = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    refData->time += stepSize;
+    refData->stepCount++;
+}
+
+double CpuIntegrateVerletStepKernel::computeKineticEnergy(ContextImpl& context, const VerletIntegrator& integrator) {
+    return computeShiftedKineticEnergy(context, masses, 0.5*integrator.getStepSize());
+}
+
+CpuIntegrateBrownianStepKernel::~CpuIntegrateBrownianStepKernel() {
+    if (dynamics)
+        delete dynamics;
+}
+
+void CpuIntegrateBrownianStepKernel::initialize(const System& system, const BrownianIntegrator& integrator) {
+    int numParticles = system.getNumParticles();
+    masses.resize(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+        masses[i] = system.getParticleMass(i);
+    data.random.initialize(integrator.getRandomNumberSeed(), data.threads.getNumThreads());
+}
+
+void CpuIntegrateBrownianStepKernel::execute(ContextImpl& context, const BrownianIntegrator& integrator) {
+    double temperature = integrator.getTemperature();
+    double friction = integrator.getFriction();
+    double stepSize = integrator.getStepSize();
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    vector<Vec3>& forceData = extractForces(context);
+    if (dynamics == 0 || temperature != prevTemp || friction != prevFriction || stepSize != prevStepSize) {
+        // Recreate the computation objects with the new parameters.
+        
+        if (dynamics)
+            delete dynamics;
+        dynamics = new CpuBrownianDynamics(context.getSystem().getNumParticles(), stepSize, friction, temperature, data.threads, data.random);
+        dynamics->setReferenceConstraintAlgorithm(&extractConstraints(context));
+        dynamics->setVirtualSites(extractVirtualSites(context));
+        prevTemp = temperature;
+        prevFriction = friction;
+        prevStepSize = stepSize;
+    }
+    data.profiler.startInterval();
+    dynamics->update(context.getSystem(), posData, velData, forceData, masses, integrator.getConstraintTolerance());
+    data.profiler.endInterval("Integration");
+    ReferencePlatform::PlatformData* refData = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    refData->time += stepSize;
+    refData->stepCount++;
+}
+
+double CpuIntegrateBrownianStepKernel::computeKineticEnergy(ContextImpl& context, const BrownianIntegrator& integrator) {
+    return computeShiftedKineticEnergy(context, masses, 0);
+}
+
+CpuIntegrateVariableLangevinStepKernel::~CpuIntegrateVariableLangevinStepKernel() {
+    if (dynamics)
+        delete dynamics;
+}
+
+void CpuIntegrateVariableLangevinStepKernel::initialize(const System& system, const VariableLangevinIntegrator& integrator) {
+    int numParticles = system.getNumParticles();
+    masses.resize(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+        masses[i] = system.getParticleMass(i);
+    data.random.initialize(integrator.getRandomNumberSeed(), data.threads.getNumThreads());
+}
+
+double CpuIntegrateVariableLangevinStepKernel::execute(ContextImpl& context, const VariableLangevinIntegrator& integrator, double maxTime) {
+    double temperature = integrator.getTemperature();
+    double friction = integrator.getFriction();
+    double errorTol = integrator.getErrorTolerance();
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    vector<Vec3>& forceData = extractForces(context);
+    if (dynamics == 0 || temperature != prevTemp || friction != prevFriction || errorTol != prevErrorTol) {
+        // Recreate the computation objects with the new parameters.
+
+        if (dynamics)
+            delete dynamics;
+        dynamics = new CpuVariableStochasticDynamics(context.getSystem().getNumParticles(), friction, temperature, errorTol, data.threads, data.random);
+        dynamics->setReferenceConstraintAlgorithm(&extractConstraints(context));
+        dynamics->setVirtualSites(extractVirtualSites(context));
+        prevTemp = temperature;
+        prevFriction = friction;
+        prevErrorTol = errorTol;
+    }
+    ReferencePlatform::PlatformData* refData = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    double maxStepSize = maxTime-refData->time;
+    if (integrator.getMaximumStepSize() > 0)
+        maxStepSize = min(integrator.getMaximumStepSize(), maxStepSize);
+    data.profiler.startInterval();
+    dynamics->update(context.getSystem(), posData, velData, forceData, masses, maxStepSize, integrator.getConstraintTolerance());
+    data.profiler.endInterval("Integration");
+    refData->time += dynamics->getDeltaT();
+    if (dynamics->getDeltaT() == maxStepSize)
+        refData->time = maxTime; // Avoid round-off error
+    refData->stepCount++;
+    return dynamics->getDeltaT();
+}
+
+double CpuIntegrateVariableLangevinStepKernel::computeKineticEnergy(ContextImpl& context, const VariableLangevinIntegrator& integrator) {
+    return computeShiftedKineticEnergy(context, masses, 0.5*integrator.getStepSize());
+}
+
+void CpuApplyMonteCarloBarostatKernel::initialize(const System& system, const Force& barostat, int components, bool rigidMolecules) {
+    this->components = components;
+    this->rigidMolecules = rigidMolecules;
+    for (int i = 0; i < system.getNumParticles(); i++)
+        masses.push_back(system.getParticleMass(i));
+}
+
+void CpuApplyMonteCarloBarostatKernel::initializeMolecules(ContextImpl& context) {
+    // Store the molecules in a flat array so threads can process contiguous ranges of them.
+
+    int numParticles = context.getSystem().getNumParticles();
+    moleculeStart.clear();
+    moleculeAtoms.clear();
+    if (rigidMolecules) {
+        for (auto& molecule : context.getMolecules()) {
+            moleculeStart.push_back(moleculeAtoms.size());
+            moleculeAtoms.insert(moleculeAtoms.end(), molecule.begin(), molecule.end());
+        }
+    }
+    else {
+        for (int i = 0; i < numParticles; i++) {
+            moleculeStart.push_back(i);
+            moleculeAtoms.push_back(i);
+        }
+    }
+    moleculeStart.push_back(moleculeAtoms.size());
+    savedPositions.resize(numParticles);
+    hasInitializedMolecules = true;
+}
+
+void CpuApplyMonteCarloBarostatKernel::saveCoordinates(ContextImpl& context) {
+    if (!hasInitializedMolecules)
+        initializeMolecules(context);
+    vector<Vec3>& posData = extractPositions(context);
+    data.threads.parallelFor(posData.size(), 1024, [&] (ThreadPool& threads, int threadIndex, int start, int end) {
+        for (int i = start; i < end; i++)
+            savedPositions[i] = posData[i];
+    });
+}
+
+void CpuApplyMonteCarloBarostatKernel::scaleCoordinates(ContextImpl& context, double scaleX, double scaleY, double scaleZ) {
+    // Each molecule is translated so its center is scaled while its shape is unchanged.  Molecules
+    // touch disjoint sets of atoms, so they can be processed independently.
+
+    vector<Vec3>& posData = extractPositions(context);
+    int numMolecules = moleculeStart.size()-1;
+    data.threads.parallelFor(numMolecules, 64, [&] (ThreadPool& threads, int threadIndex, int start, int end) {
+        for (int i = start; i < end; i++) {
+            int first = moleculeStart[i], last = moleculeStart[i+1];
+            Vec3 pos;
+            for (int j = first; j < last; j++)
+                pos += posData[moleculeAtoms[j]];
+            pos /= last-first;
+            Vec3 offset(pos[0]*(scaleX-1), pos[1]*(scaleY-1), pos[2]*(scaleZ-1));
+            for (int j = first; j < last; j++)
+                posData[moleculeAtoms[j]] += offset;
+        }
+    });
+}
+
+void CpuApplyMonteCarloBarostatKernel::restoreCoordinates(ContextImpl& context) {
+    vector<Vec3>& posData = extractPositions(context);
+    data.threads.parallelFor(posData.size(), 1024, [&] (ThreadPool& threads, int threadIndex, int start, int end) {
+        for (int i = start; i < end; i++)
+            posData[i] = savedPositions[i];
+    });
+}
+
+void CpuApplyMonteCarloBarostatKernel::computeKineticEnergy(ContextImpl& context, vector<double>& ke) {
+    if (!hasInitializedMolecules)
+        initializeMolecules(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    int numMolecules = moleculeStart.size()-1;
+    int numThreads = data.threads.getNumThreads();
+    vector<vector<double> > threadKE(numThreads, vector<double>(components, 0.0));
+    data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        // Use a fixed division of molecules between threads so the result is deterministic.
+
+        vector<double>& sum = threadKE[threadIndex];
+        int start = threadIndex*numMolecules/numThreads;
+        int end = (threadIndex+1)*numMolecules/numThreads;
+        for (int i = start; i < end; i++) {
+            Vec3 molVel;
+            double molMass = 0.0;
+            for (int j = moleculeStart[i]; j < moleculeStart[i+1]; j++) {
+                int atom = moleculeAtoms[j];
+                molVel += velData[atom]*masses[atom];
+                molMass += masses[atom];
+            }
+            if (molMass == 0.0)
+                continue;
+            molVel /= molMass;
+            if (components == 1)
+                sum[0] += 0.5*molMass*molVel.dot(molVel);
+            else {
+                sum[0] += 0.5*molMass*molVel[0]*molVel[0];
+                sum[1] += 0.5*molMass*molVel[1]*molVel[1];
+                sum[2] += 0.5*molMass*molVel[2]*molVel[2];
+                if (components == 6) {
+                    sum[3] += 0.5*molMass*molVel[1]*molVel[0];
+                    sum[4] += 0.5*molMass*molVel[2]*molVel[0];
+                    sum[5] += 0.5*molMass*molVel[2]*molVel[1];
+                }
+            }
+        }
+    });
+    data.threads.waitForThreads();
+    ke.resize(components);
+    for (int i = 0; i < components; i++) {
+        ke[i] = 0.0;
+        for (int j = 0; j < numThreads; j++)
+            ke[i] += threadKE[j][i];
+    }
+}
@@ -165,8 +165,9 @@ public:
         return VoxelIndex(y, z);
     }
         
-    void getNeighbors(vector<int>& neighbors, int blockIndex, const fvec4& blockCenter, const fvec4& blockWidth, const vector<int>& sortedAtoms, vector<CpuNeighborList::BlockExclusionMask>& exclusions, float maxDistance, const vector<int>& blockAtoms, const vector<float>& blockAtomX, const vector<float>& blockAtomY, const vector<float>& blockAtomZ, const vector<float>& sortedPositions, const vector<VoxelIndex>& atomVoxelIndex) const {
+    void getNeighbors(vector<int>& neighbors, vector<int>& sortedNeighbors, int blockIndex, const fvec4& blockCenter, const fvec4& blockWidth, const vector<int>& sortedAtoms, vector<CpuNeighborList::BlockExclusionMask>& exclusions, float maxDistance, const vector<int>& blockAtoms, const vector<float>& blockAtomX, const vector<float>& blockAtomY, const vector<float>& blockAtomZ, const vector<float>& sortedPositions, const vector<VoxelIndex>& atomVoxelIndex) const {
         neighbors.resize(0);
+        sortedNeighbors.resize(0);
         exclusions.resize(0);
         fvec4 boxSize(periodicBoxSize[0], periodicBoxSize[1], periodicBoxSize[2], 0);
         fvec4 invBoxSize(recipBoxSize[0], recipBoxSize[1], recipBoxSize[2], 0);
@@ -386,6 +387,7 @@ public:
                         // Add this atom to the list of neighbors.
                         
                         neighbors.push_back(sortedAtoms[sortedIndex]);
+                        sortedNeighbors.push_back(sortedIndex);
                         if (sortedIndex < blockSize*blockIndex)
                             exclusions.push_back(0);
                         else {
@@ -410,14 +412,16 @@ private:
     vector<vector<vector<pair<float, int> > > > bins;
 };
 
-CpuNeighborList::CpuNeighborList(int blockSize) : blockSize(blockSize) {
+CpuNeighborList::CpuNeighborList(int blockSize) : blockSize(blockSize), dense(false), isPruned(false) {
 }
 
-void CpuNeighborList::computeNeighborList(int numAtoms, const AlignedArray<float>& atomLocations, const vector<set<int> >& exclusions,
+void CpuNeighborList::computeNeighborList(int numAtoms, const AlignedArray<float>& atomLocations, const ExclusionList& exclusions,
             const Vec3* periodicBoxVectors, bool usePeriodic, float maxDistance, ThreadPool& threads) {
     dense = false;
+    isPruned = false;
     int numBlocks = (numAtoms+blockSize-1)/blockSize;
     blockNeighbors.resize(numBlocks);
+    blockSortedNeighbors.resize(numBlocks);
     blockExclusions.resize(numBlocks);
     sortedAtoms.resize(numAtoms);
     sortedPositions.resize(4*numAtoms);
@@ -495,7 +499,7 @@ void CpuNeighborList::computeNeighborList(int numAtoms, const AlignedArray<float
     }
 }
 
-void CpuNeighborList::createDenseNeighborList(int numAtoms, const vector<set<int> >& exclusions) {
+void CpuNeighborList::createDenseNeighborList(int numAtoms, const ExclusionList& exclusions) {
     dense = true;
     this->numAtoms = numAtoms;
     int numBlocks = (numAtoms+blockSize-1)/blockSize;
@@ -514,7 +518,7 @@ void CpuNeighborList::createDenseNeighborList(int numAtoms, const vector<set<int
             exclusionMap[firstIndex+j] = (1<<(j+1))-1;
         }
         for (int j = 0; j < atomsInBlock; j++) {
-            const set<int>& atomExclusions = exclusions[firstIndex+j];
+            ExclusionList::Range atomExclusions = exclusions[firstIndex+j];
             const BlockExclusionMask mask = 1<<j;
             for (int exclusion : atomExclusions) {
                 if (firstIndex <= exclusion) {
@@ -547,6 +551,106 @@ void CpuNeighborList::createDenseNeighborList(int numAtoms, const vector<set<int
     }
 }
 
+void CpuNeighborList::pruneNeighborList(const AlignedArray<float>& atomLocations, const Vec3* periodicBoxVectors, bool usePeriodic, float maxDistance, ThreadPool& threads) {
+    if (dense)
+        return;
+    if (!isPruned) {
+        // Save the full list so it can be pruned again later.
+
+        fullBlockNeighbors.swap(blockNeighbors);
+        fullBlockSortedNeighbors.swap(blockSortedNeighbors);
+        fullBlockExclusions.swap(blockExclusions);
+        blockNeighbors.resize(fullBlockNeighbors.size());
+        blockSortedNeighbors.resize(fullBlockSortedNeighbors.size());
+        blockExclusions.resize(fullBlockExclusions.size());
+        isPruned = true;
+    }
+    bool triclinic = (periodicBoxVectors[0][1] != 0.0 || periodicBoxVectors[0][2] != 0.0 ||
+                      periodicBoxVectors[1][0] != 0.0 || periodicBoxVectors[1][2] != 0.0 ||
+                      periodicBoxVectors[2][0] != 0.0 || periodicBoxVectors[2][1] != 0.0);
+    float boxVectors[3][3];
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            boxVectors[i][j] = (float) periodicBoxVectors[i][j];
+    fvec4 boxSize(boxVectors[0][0], boxVectors[1][1], boxVectors[2][2], 0);
+    fvec4 invBoxSize(1/boxVectors[0][0], 1/boxVectors[1][1], 1/boxVectors[2][2], 0);
+    float maxDistanceSquared = maxDistance*maxDistance;
+    int numBlocks = blockNeighbors.size();
+    atomicCounter = 0;
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        vector<float> blockAtomX(blockSize), blockAtomY(blockSize), blockAtomZ(blockSize);
+        while (true) {
+            int i = atomicCounter++;
+            if (i >= numBlocks)
+                break;
+
+            // Load the current positions of the atoms in this block.
+
+            int firstIndex = blockSize*i;
+            int atomsInBlock = min(blockSize, numAtoms-firstIndex);
+            for (int j = 0; j < atomsInBlock; j++) {
+                const float* pos = &atomLocations[4*sortedAtoms[firstIndex+j]];
+                blockAtomX[j] = pos[0];
+                blockAtomY[j] = pos[1];
+                blockAtomZ[j] = pos[2];
+            }
+            for (int j = atomsInBlock; j < blockSize; j++) {
+                blockAtomX[j] = 1e10;
+                blockAtomY[j] = 1e10;
+                blockAtomZ[j] = 1e10;
+            }
+
+            // Keep every neighbor that is close enough to interact with some atom in the block.  Entries
+            // with exclusions are always kept, since the force kernels may rely on them.
+
+            const vector<int>& fullNeighbors = fullBlockNeighbors[i];
+            const vector<int>& fullSortedNeighbors = fullBlockSortedNeighbors[i];
+            const vector<BlockExclusionMask>& fullExclusions = fullBlockExclusions[i];
+            vector<int>& neighbors = blockNeighbors[i];
+            vector<int>& sortedNeighbors = blockSortedNeighbors[i];
+            vector<BlockExclusionMask>& exclusions = blockExclusions[i];
+            neighbors.resize(0);
+            sortedNeighbors.resize(0);
+            exclusions.resize(0);
+            for (int k = 0; k < (int) fullNeighbors.size(); k++) {
+                bool keep = (fullExclusions[k] != 0);
+                if (!keep) {
+                    const float* atomPos = &atomLocations[4*fullNeighbors[k]];
+                    for (int j = 0; j < blockSize && !keep; j += 4) {
+                        fvec4 dx = fvec4(&blockAtomX[j])-atomPos[0];
+                        fvec4 dy = fvec4(&blockAtomY[j])-atomPos[1];
+                        fvec4 dz = fvec4(&blockAtomZ[j])-atomPos[2];
+                        if (usePeriodic && !triclinic) {
+                            dx -= round(dx*invBoxSize[0])*boxSize[0];
+                            dy -= round(dy*invBoxSize[1])*boxSize[1];
+                            dz -= round(dz*invBoxSize[2])*boxSize[2];
+                        }
+                        else if (usePeriodic) {
+                            fvec4 scale3 = floor(dz*invBoxSize[2]+0.5f);
+                            dx -= scale3*boxVectors[2][0];
+                            dy -= scale3*boxVectors[2][1];
+                            dz -= scale3*boxVectors[2][2];
+                            fvec4 scale2 = floor(dy*invBoxSize[1]+0.5f);
+                            dx -= scale2*boxVectors[1][0];
+                            dy -= scale2*boxVectors[1][1];
+                            fvec4 scale1 = floor(dx*invBoxSize[0]+0.5f);
+                            dx -= scale1*boxVectors[0][0];
+                        }
+                        fvec4 r2 = dx*dx + dy*dy + dz*dz;
+                        keep = any(r2 < maxDistanceSquared);
+                    }
+                }
+                if (keep) {
+                    neighbors.push_back(fullNeighbors[k]);
+                    sortedNeighbors.push_back(fullSortedNeighbors[k]);
+                    exclusions.push_back(fullExclusions[k]);
+                }
+            }
+        }
+    });
+    threads.waitForThreads();
+}
+
 int CpuNeighborList::getNumBlocks() const {
     return sortedAtoms.size()/blockSize;
 }
@@ -572,7 +676,7 @@ CpuNeighborList::NeighborIterator CpuNeighborList::getNeighborIterator(int block
     if (dense)
         return NeighborIterator(blockIndex*blockSize, numAtoms, blockExclusionIndices[blockIndex], blockExclusions[blockIndex]);
     else
-        return NeighborIterator(blockNeighbors[blockIndex], blockExclusions[blockIndex]);
+        return NeighborIterator(blockNeighbors[blockIndex], blockSortedNeighbors[blockIndex], blockExclusions[blockIndex]);
 }
 
 void CpuNeighborList::threadComputeNeighborList(ThreadPool& threads, int threadIndex) {
@@ -630,13 +734,13 @@ void CpuNeighborList::threadComputeNeighborList(ThreadPool& threads, int threadI
             blockAtomY[j] = 1e10;
             blockAtomZ[j] = 1e10;
         }
-        voxels->getNeighbors(blockNeighbors[i], i, (maxPos+minPos)*0.5f, (maxPos-minPos)*0.5f, sortedAtoms, blockExclusions[i], maxDistance, blockAtoms, blockAtomX, blockAtomY, blockAtomZ, sortedPositions, atomVoxelIndex);
+        voxels->getNeighbors(blockNeighbors[i], blockSortedNeighbors[i], i, (maxPos+minPos)*0.5f, (maxPos-minPos)*0.5f, sortedAtoms, blockExclusions[i], maxDistance, blockAtoms, blockAtomX, blockAtomY, blockAtomZ, sortedPositions, atomVoxelIndex);
 
         // Record the exclusions for this block.
 
         map<int, BlockExclusionMask> atomFlags;
         for (int j = 0; j < atomsInBlock; j++) {
-            const set<int>& atomExclusions = (*exclusions)[sortedAtoms[firstIndex+j]];
+            ExclusionList::Range atomExclusions = (*exclusions)[sortedAtoms[firstIndex+j]];
             const BlockExclusionMask mask = 1<<j;
             for (int exclusion : atomExclusions) {
                 const auto thisAtomFlags = atomFlags.find(exclusion);
@@ -656,8 +760,8 @@ void CpuNeighborList::threadComputeNeighborList(ThreadPool& threads, int threadI
     }
 }
 
-CpuNeighborList::NeighborIterator::NeighborIterator(const vector<int>& neighbors, const vector<BlockExclusionMask>& exclusions) :
-        dense(false), neighbors(&neighbors), exclusions(&exclusions), currentIndex(-1) {
+CpuNeighborList::NeighborIterator::NeighborIterator(const vector<int>& neighbors, const vector<int>& sortedNeighbors, const vector<BlockExclusionMask>& exclusions) :
+        dense(false), neighbors(&neighbors), sortedNeighbors(&sortedNeighbors), exclusions(&exclusions), currentIndex(-1) {
 }
 
 CpuNeighborList::NeighborIterator::NeighborIterator(int firstAtom, int lastAtom, const vector<int>& exclusionIndices, const vector<BlockExclusionMask>& exclusions) :
@@ -668,6 +772,7 @@ bool CpuNeighborList::NeighborIterator::next() {
     if (dense) {
         if (++currentAtom >= lastAtom)
             return false;
+        currentSortedIndex = currentAtom;
         if (currentIndex < exclusionIndices->size() && (*exclusionIndices)[currentIndex] == currentAtom)
             currentExclusions = (*exclusions)[currentIndex++];
         else
@@ -677,6 +782,7 @@ bool CpuNeighborList::NeighborIterator::next() {
     else {
         if (++currentIndex < neighbors->size()) {
             currentAtom = (*neighbors)[currentIndex];
+            currentSortedIndex = (*sortedNeighbors)[currentIndex];
             currentExclusions = (*exclusions)[currentIndex];
             return true;
         }
@@ -688,6 +794,10 @@ int CpuNeighborList::NeighborIterator::getNeighbor() const {
     return currentAtom;
 }
 
+int CpuNeighborList::NeighborIterator::getSortedNeighbor() const {
+    return currentSortedIndex;
+}
+
 CpuNeighborList::BlockExclusionMask CpuNeighborList::NeighborIterator::getExclusions() const {
     return currentExclusions;
 }
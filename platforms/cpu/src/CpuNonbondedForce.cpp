@@ -29,6 +29,7 @@
 #include "ReferenceForce.h"
 #include "ReferencePME.h"
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 
 // In case we're using some primitive version of Visual Studio this will
@@ -40,6 +41,7 @@ using namespace OpenMM;
 
 const float CpuNonbondedForce::TWO_OVER_SQRT_PI = (float) (2/sqrt(PI_M));
 const int CpuNonbondedForce::NUM_TABLE_POINTS = 2048;
+const double CpuNonbondedForce::FIXED_POINT_SCALE = (double) 0x100000000;
 
 /**---------------------------------------------------------------------------------------
 
@@ -48,7 +50,7 @@ const int CpuNonbondedForce::NUM_TABLE_POINTS = 2048;
    --------------------------------------------------------------------------------------- */
 
 CpuNonbondedForce::CpuNonbondedForce(const CpuNeighborList& neighbors) : neighborList(&neighbors), cutoff(false), useSwitch(false), periodic(false),
-        periodicExceptions(false), ewald(false), pme(false), ljpme(false), tableIsValid(false), expTableIsValid(false), cutoffDistance(0.0f),
+        periodicExceptions(false), ewald(false), pme(false), ljpme(false), tableIsValid(false), expTableIsValid(false), deterministic(false), cutoffDistance(0.0f),
         alphaDispersionEwald(0.0f), alphaEwald(0.0f) {
 }
 
@@ -205,6 +207,10 @@ void CpuNonbondedForce::setPeriodicExceptions(bool periodic) {
     periodicExceptions = periodic;
 }
 
+void CpuNonbondedForce::setDeterministic(bool deterministic) {
+    this->deterministic = deterministic;
+}
+
 void CpuNonbondedForce::tabulateEwaldScaleFactor() {
     if (tableIsValid)
         return;
@@ -243,7 +249,7 @@ void CpuNonbondedForce::tabulateExpTerms() {
 }
 
 void CpuNonbondedForce::calculateReciprocalIxn(int numberOfAtoms, float* posq, const vector<Vec3>& atomCoordinates,
-                                               const vector<pair<float, float> >& atomParameters, const vector<float> &C6params, const vector<set<int> >& exclusions,
+                                               const vector<pair<float, float> >& atomParameters, const vector<float> &C6params, const ExclusionList& exclusions,
                                                vector<Vec3>& forces, double* totalEnergy) const {
     typedef std::complex<float> d_complex;
 
@@ -378,7 +384,7 @@ void CpuNonbondedForce::calculateReciprocalIxn(int numberOfAtoms, float* posq, c
 
 
 void CpuNonbondedForce::calculateDirectIxn(int numberOfAtoms, float* posq, const vector<Vec3>& atomCoordinates, const vector<pair<float, float> >& atomParameters,
-                                           const vector<float>& C6params, const vector<set<int> >& exclusions, vector<AlignedArray<float> >& threadForce, double* totalEnergy, ThreadPool& threads) {
+                                           const vector<float>& C6params, const ExclusionList& exclusions, vector<AlignedArray<float> >& threadForce, double* totalEnergy, ThreadPool& threads) {
     // Record the parameters for the threads.
     
     this->numberOfAtoms = numberOfAtoms;
@@ -386,29 +392,119 @@ void CpuNonbondedForce::calculateDirectIxn(int numberOfAtoms, float* posq, const
     this->atomCoordinates = &atomCoordinates[0];
     this->atomParameters = &atomParameters[0];
     this->C6params = &C6params[0];
-    this->exclusions = &exclusions[0];
+    this->exclusions = &exclusions;
     this->threadForce = &threadForce;
     includeEnergy = (totalEnergy != NULL);
     threadEnergy.resize(threads.getNumThreads());
     atomicCounter = 0;
     atomicCounter2 = 0;
+
+    // Copy the per-atom data into the order used by the neighbor list.  The list is rebuilt periodically
+    // as atoms diffuse, so this keeps nearby atoms close together in memory.
+
+    const vector<int>& sortedAtoms = neighborList->getSortedAtoms();
+    int numSorted = sortedAtoms.size();
+    int numThreads = threads.getNumThreads();
+    sortedPosq.resize(4*numSorted);
+    sortedSigma.resize(numSorted);
+    sortedEpsilon.resize(numSorted);
+    if (ljpme)
+        sortedC6params.resize(numSorted);
+    if (sortedThreadForce.size() == 0)
+        sortedThreadForce.resize(numThreads);
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = (threadIndex*numSorted)/numThreads;
+        int end = ((threadIndex+1)*numSorted)/numThreads;
+        for (int i = start; i < end; i++) {
+            int atom = sortedAtoms[i];
+            fvec4(posq+4*atom).store(&sortedPosq[4*i]);
+            sortedSigma[i] = atomParameters[atom].first;
+            sortedEpsilon[i] = atomParameters[atom].second;
+            if (ljpme)
+                sortedC6params[i] = C6params[atom];
+        }
+    });
+    threads.waitForThreads();
     
     // Signal the threads to start running and wait for them to finish.
     
+    if (deterministic) {
+        threadFixedForce.resize(numThreads);
+        threadFixedEnergy.resize(numThreads);
+    }
     threads.execute([&] (ThreadPool& threads, int threadIndex) { threadComputeDirect(threads, threadIndex); });
     threads.waitForThreads();
+    if (deterministic) {
+        // Sum the fixed point forces from all the threads.  Integer addition is associative, so the
+        // result is identical no matter how many threads there are or how the work was divided.
+
+        threads.execute([&] (ThreadPool& threads, int threadIndex) {
+            int start = (threadIndex*numberOfAtoms)/numThreads;
+            int end = ((threadIndex+1)*numberOfAtoms)/numThreads;
+            float* forces = &threadForce[threadIndex][0];
+            for (int i = start; i < end; i++)
+                for (int j = 0; j < 3; j++) {
+                    long long sum = 0;
+                    for (int k = 0; k < numThreads; k++)
+                        sum += threadFixedForce[k][3*i+j];
+                    forces[4*i+j] += (float) (sum/FIXED_POINT_SCALE);
+                }
+        });
+        threads.waitForThreads();
+    }
     
     // Combine the energies from all the threads.
     
     if (totalEnergy != NULL) {
         double directEnergy = 0;
-        int numThreads = threads.getNumThreads();
-        for (int i = 0; i < numThreads; i++)
-            directEnergy += threadEnergy[i];
+        if (deterministic) {
+            long long sum = 0;
+            for (int i = 0; i < numThreads; i++)
+                sum += threadFixedEnergy[i];
+            directEnergy = sum/FIXED_POINT_SCALE;
+        }
+        else {
+            for (int i = 0; i < numThreads; i++)
+                directEnergy += threadEnergy[i];
+        }
         *totalEnergy += directEnergy;
     }
 }
 
+void CpuNonbondedForce::accumulateBlockFixedPoint(int blockIndex, float* sortedForces, double blockEnergy, int threadIndex) {
+    // The block kernel only touches the block's own atoms and its neighbors.  Move their forces into
+    // the fixed point buffer and clear them, so the next block starts from zero.
+
+    const vector<int>& sortedAtoms = neighborList->getSortedAtoms();
+    long long* fixedForces = &threadFixedForce[threadIndex][0];
+    auto accumulate = [&] (int sortedIndex) {
+        float* f = sortedForces+4*sortedIndex;
+        if (sortedIndex < numberOfAtoms) {
+            long long* fixed = fixedForces+3*sortedAtoms[sortedIndex];
+            for (int j = 0; j < 3; j++)
+                fixed[j] += (long long) (f[j]*FIXED_POINT_SCALE);
+        }
+        fvec4(0.0f).store(f);
+    };
+    int blockSize = neighborList->getBlockSize();
+    for (int i = 0; i < blockSize; i++)
+        accumulate(blockIndex*blockSize+i);
+    CpuNeighborList::NeighborIterator neighbors = neighborList->getNeighborIterator(blockIndex);
+    while (neighbors.next())
+        accumulate(neighbors.getSortedNeighbor());
+    threadFixedEnergy[threadIndex] += (long long) (blockEnergy*FIXED_POINT_SCALE);
+}
+
+void CpuNonbondedForce::accumulatePairFixedPoint(int atom1, int atom2, const fvec4& force, double energy, int threadIndex) {
+    long long* fixedForces = &threadFixedForce[threadIndex][0];
+    for (int j = 0; j < 3; j++) {
+        long long f = (long long) (force[j]*FIXED_POINT_SCALE);
+        fixedForces[3*atom1+j] -= f;
+        fixedForces[3*atom2+j] += f;
+    }
+    threadFixedEnergy[threadIndex] += (long long) (energy*FIXED_POINT_SCALE);
+}
+
 void CpuNonbondedForce::threadComputeDirect(ThreadPool& threads, int threadIndex) {
     // Compute this thread's subset of interactions.
 
@@ -416,17 +512,37 @@ void CpuNonbondedForce::threadComputeDirect(ThreadPool& threads, int threadIndex
     threadEnergy[threadIndex] = 0;
     double* energyPtr = (includeEnergy ? &threadEnergy[threadIndex] : NULL);
     float* forces = &(*threadForce)[threadIndex][0];
+    const vector<int>& sortedAtoms = neighborList->getSortedAtoms();
+    AlignedArray<float>& sortedForceArray = sortedThreadForce[threadIndex];
+    sortedForceArray.resize(4*sortedAtoms.size());
+    float* sortedForces = &sortedForceArray[0];
+    memset(sortedForces, 0, 4*sortedAtoms.size()*sizeof(float));
     fvec4 boxSize(periodicBoxVectors[0][0], periodicBoxVectors[1][1], periodicBoxVectors[2][2], 0);
     fvec4 invBoxSize(recipBoxSize[0], recipBoxSize[1], recipBoxSize[2], 0);
-    if (ewald || pme || ljpme) {
-        // Compute the interactions from the neighbor list.
-        while (true) {
-            int nextBlock = atomicCounter++;
-            if (nextBlock >= neighborList->getNumBlocks())
-                break;
-            calculateBlockEwaldIxn(nextBlock, forces, energyPtr, boxSize, invBoxSize);
-        }
+    if (deterministic) {
+        threadFixedForce[threadIndex].assign(3*numberOfAtoms, 0);
+        threadFixedEnergy[threadIndex] = 0;
+    }
 
+    // Compute the interactions from the neighbor list.  In deterministic mode, each block's forces are
+    // converted to fixed point as soon as it is finished, so the result does not depend on which thread
+    // processed which blocks.
+
+    int numBlocks = neighborList->getNumBlocks();
+    while (true) {
+        int nextBlock = atomicCounter++;
+        if (nextBlock >= numBlocks)
+            break;
+        double blockEnergy = 0;
+        double* blockEnergyPtr = (deterministic ? (includeEnergy ? &blockEnergy : NULL) : energyPtr);
+        if (ewald || pme || ljpme)
+            calculateBlockEwaldIxn(nextBlock, sortedForces, blockEnergyPtr, boxSize, invBoxSize);
+        else
+            calculateBlockIxn(nextBlock, sortedForces, blockEnergyPtr, boxSize, invBoxSize);
+        if (deterministic)
+            accumulateBlockFixedPoint(nextBlock, sortedForces, blockEnergy, threadIndex);
+    }
+    if (ewald || pme || ljpme) {
         // Now subtract off the exclusions, since they were implicitly included in the reciprocal space sum.
 
         const int groupSize = max(1, numberOfAtoms/(10*numThreads));
@@ -438,7 +554,7 @@ void CpuNonbondedForce::threadComputeDirect(ThreadPool& threads, int threadIndex
             for (int i = start; i < end; i++) {
                 fvec4 posI((float) atomCoordinates[i][0], (float) atomCoordinates[i][1], (float) atomCoordinates[i][2], 0.0f);
                 float scaledChargeI = (float) (ONE_4PI_EPS0*posq[4*i+3]);
-                for (int excluded : exclusions[i]) {
+                for (int excluded : (*exclusions)[i]) {
                     if (excluded > i) {
                         int j = excluded;
                         fvec4 deltaR;
@@ -448,44 +564,49 @@ void CpuNonbondedForce::threadComputeDirect(ThreadPool& threads, int threadIndex
                         float r = sqrtf(r2);
                         float alphaR = alphaEwald*r;
                         float erfAlphaR = erf(alphaR);
+                        fvec4 pairForce(0.0f);
+                        double pairEnergy = 0;
                         if (erfAlphaR > 1e-6f) {
                             float inverseR = 1/r;
                             float chargeProdOverR = scaledChargeI*posq[4*j+3]*inverseR;
                             float dEdR = chargeProdOverR*inverseR*inverseR;
                             dEdR = dEdR * (erfAlphaR-TWO_OVER_SQRT_PI*alphaR*(float)exp(-alphaR*alphaR));
-                            fvec4 result = deltaR*dEdR;
-                            (fvec4(forces+4*i)-result).store(forces+4*i);
-                            (fvec4(forces+4*j)+result).store(forces+4*j);
+                            pairForce += deltaR*dEdR;
                             if (includeEnergy)
-                                threadEnergy[threadIndex] -= chargeProdOverR*erfAlphaR;
+                                pairEnergy -= chargeProdOverR*erfAlphaR;
                         }
                         else if (includeEnergy)
-                            threadEnergy[threadIndex] -= alphaEwald*TWO_OVER_SQRT_PI*scaledChargeI*posq[4*j+3];
+                            pairEnergy -= alphaEwald*TWO_OVER_SQRT_PI*scaledChargeI*posq[4*j+3];
                         if (ljpme) {
                             float C6ij = C6params[i]*C6params[j];
                             float inverseR2 = 1.0f/r2;
                             float emult = C6ij*inverseR2*inverseR2*inverseR2*exptermsApprox(r);
                             if(includeEnergy)
-                                threadEnergy[threadIndex] += emult;
+                                pairEnergy += emult;
                             float dEdR = -6.0f*C6ij*inverseR2*inverseR2*inverseR2*inverseR2*dExptermsApprox(r);
-                            fvec4 result = deltaR*dEdR;
-                            (fvec4(forces+4*i)-result).store(forces+4*i);
-                            (fvec4(forces+4*j)+result).store(forces+4*j);
+                            pairForce += deltaR*dEdR;
+                        }
+                        if (deterministic)
+                            accumulatePairFixedPoint(i, j, pairForce, pairEnergy, threadIndex);
+                        else {
+                            (fvec4(forces+4*i)-pairForce).store(forces+4*i);
+                            (fvec4(forces+4*j)+pairForce).store(forces+4*j);
+                            threadEnergy[threadIndex] += pairEnergy;
                         }
                     }
                 }
             }
         }
     }
-    else {
-        // Compute the interactions from the neighbor list.
+    if (deterministic)
+        return;
 
-        while (true) {
-            int nextBlock = atomicCounter++;
-            if (nextBlock >= neighborList->getNumBlocks())
-                break;
-            calculateBlockIxn(nextBlock, forces, energyPtr, boxSize, invBoxSize);
-        }
+    // Add the forces computed by the block kernels to this thread's force array.  The entries past the
+    // end of the atoms are padding, and never have any force.
+
+    for (int i = 0; i < numberOfAtoms; i++) {
+        float* f = forces+4*sortedAtoms[i];
+        (fvec4(f)+fvec4(sortedForces+4*i)).store(f);
     }
 }
 
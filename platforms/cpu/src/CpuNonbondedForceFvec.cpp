@@ -31,16 +31,33 @@ using namespace OpenMM;
 CpuNonbondedForce* createCpuNonbondedForceVec4(const CpuNeighborList& neighbors);
 CpuNonbondedForce* createCpuNonbondedForceAvx(const CpuNeighborList& neighbors);
 CpuNonbondedForce* createCpuNonbondedForceAvx2(const CpuNeighborList& neighbors);
+CpuNonbondedForce* createCpuNonbondedForceAvx512(const CpuNeighborList& neighbors);
+CpuNonbondedForce* createCpuNonbondedForceSve256(const CpuNeighborList& neighbors);
+CpuNonbondedForce* createCpuNonbondedForceSve512(const CpuNeighborList& neighbors);
 
 bool isAvx2Supported();
+bool isAvx512Enabled();
+bool isSve256Supported();
+bool isSve512Supported();
 
 #include <iostream>
 
+int OpenMM::getCpuNonbondedBlockSize() {
+    static const int blockSize = (isAvx512Enabled() || isSve512Supported() ? 16 : isSve256Supported() ? 8 : getVectorWidth());
+    return blockSize;
+}
+
 CpuNonbondedForce* createCpuNonbondedForceVec(const CpuNeighborList& neighbors) {
-    if (isAvx2Supported())
+    // The kernel must match the block size the neighbor list was built with.
+
+    if (neighbors.getBlockSize() == 16)
+        return (isSve512Supported() ? createCpuNonbondedForceSve512(neighbors) : createCpuNonbondedForceAvx512(neighbors));
+    else if (neighbors.getBlockSize() == 4)
+        return createCpuNonbondedForceVec4(neighbors);
+    else if (isSve256Supported())
+        return createCpuNonbondedForceSve256(neighbors);
+    else if (isAvx2Supported())
         return createCpuNonbondedForceAvx2(neighbors);
-    else if (isAvxSupported())
-        return createCpuNonbondedForceAvx(neighbors);
     else
-        return createCpuNonbondedForceVec4(neighbors);
+        return createCpuNonbondedForceAvx(neighbors);
 }
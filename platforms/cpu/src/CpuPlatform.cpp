@@ -30,6 +30,7 @@
  * -------------------------------------------------------------------------- */
 
 #include "CpuPlatform.h"
+#include "CpuCCMA.h"
 #include "CpuKernelFactory.h"
 #include "CpuKernels.h"
 #include "CpuSETTLE.h"
@@ -38,6 +39,8 @@
 #include "openmm/internal/hardware.h"
 #include "openmm/internal/vectorize.h"
 #include <algorithm>
+#include <cstring>
+#include <fstream>
 #include <sstream>
 #include <stdlib.h>
 
@@ -60,23 +63,109 @@ extern "C" OPENMM_EXPORT_CPU void registerPlatforms() {
 
 map<const ContextImpl*, CpuPlatform::PlatformData*> CpuPlatform::contextData;
 
+/**
+ * Group the logical cores by the physical processor package they belong to.  If the topology
+ * cannot be determined, all cores are assumed to be in a single package.
+ */
+static vector<vector<int> > getPackageCores(int numProcessors) {
+    map<int, vector<int> > packages;
+    for (int i = 0; i < numProcessors; i++) {
+        int package = 0;
+#ifdef __linux__
+        stringstream path;
+        path << "/sys/devices/system/cpu/cpu" << i << "/topology/physical_package_id";
+        ifstream file(path.str().c_str());
+        if (!(file >> package))
+            package = 0;
+#endif
+        packages[package].push_back(i);
+    }
+    vector<vector<int> > result;
+    for (auto& package : packages)
+        result.push_back(package.second);
+    return result;
+}
+
+/**
+ * Parse the value of the ThreadAffinity property into the list of cores to bind threads to.  Thread i
+ * is bound to cores[i%cores.size()].  An empty list means threads should not be bound.
+ */
+static vector<int> getThreadAffinityCores(const string& value) {
+    string lowerValue = value;
+    transform(lowerValue.begin(), lowerValue.end(), lowerValue.begin(), ::tolower);
+    vector<int> cores;
+    if (lowerValue == "" || lowerValue == "none")
+        return cores;
+    int numProcessors = getNumProcessors();
+    if (lowerValue == "compact") {
+        for (int i = 0; i < numProcessors; i++)
+            cores.push_back(i);
+        return cores;
+    }
+    if (lowerValue == "scatter") {
+        vector<vector<int> > packages = getPackageCores(numProcessors);
+        for (int i = 0; (int) cores.size() < numProcessors; i++)
+            for (auto& package : packages)
+                if (i < package.size())
+                    cores.push_back(package[i]);
+        return cores;
+    }
+    stringstream list(value);
+    string item;
+    while (getline(list, item, ',')) {
+        int first, last;
+        char separator;
+        stringstream itemStream(item);
+        bool valid = (bool) (itemStream >> first);
+        last = first;
+        if (valid && itemStream >> separator)
+            valid = (separator == '-' && itemStream >> last);
+        if (valid && itemStream >> separator)
+            valid = false;
+        if (!valid || first < 0 || last < first)
+            throw OpenMMException("CpuPlatform: Illegal value for "+CpuPlatform::CpuThreadAffinity()+": "+value);
+        for (int i = first; i <= last; i++)
+            cores.push_back(i);
+    }
+    if (cores.size() == 0)
+        throw OpenMMException("CpuPlatform: Illegal value for "+CpuPlatform::CpuThreadAffinity()+": "+value);
+    return cores;
+}
+
 CpuPlatform::CpuPlatform() {
     deprecatedPropertyReplacements["CpuThreads"] = CpuThreads();
     CpuKernelFactory* factory = new CpuKernelFactory();
     registerKernelFactory(CalcForcesAndEnergyKernel::Name(), factory);
     registerKernelFactory(UpdateStateDataKernel::Name(), factory);
+    registerKernelFactory(CalcHarmonicBondForceKernel::Name(), factory);
+    registerKernelFactory(CalcCustomBondForceKernel::Name(), factory);
     registerKernelFactory(CalcHarmonicAngleForceKernel::Name(), factory);
+    registerKernelFactory(CalcCustomAngleForceKernel::Name(), factory);
     registerKernelFactory(CalcPeriodicTorsionForceKernel::Name(), factory);
     registerKernelFactory(CalcRBTorsionForceKernel::Name(), factory);
+    registerKernelFactory(CalcCustomTorsionForceKernel::Name(), factory);
+    registerKernelFactory(CalcCMAPTorsionForceKernel::Name(), factory);
     registerKernelFactory(CalcNonbondedForceKernel::Name(), factory);
     registerKernelFactory(CalcCustomNonbondedForceKernel::Name(), factory);
+    registerKernelFactory(CalcCustomCentroidBondForceKernel::Name(), factory);
+    registerKernelFactory(CalcCustomCompoundBondForceKernel::Name(), factory);
     registerKernelFactory(CalcCustomManyParticleForceKernel::Name(), factory);
     registerKernelFactory(CalcGBSAOBCForceKernel::Name(), factory);
     registerKernelFactory(CalcCustomGBForceKernel::Name(), factory);
     registerKernelFactory(CalcGayBerneForceKernel::Name(), factory);
+    registerKernelFactory(IntegrateDPDStepKernel::Name(), factory);
     registerKernelFactory(IntegrateLangevinMiddleStepKernel::Name(), factory);
-    platformProperties.push_back(CpuThreads());
+    registerKernelFactory(IntegrateVerletStepKernel::Name(), factory);
+    registerKernelFactory(IntegrateBrownianStepKernel::Name(), factory);
+    registerKernelFactory(IntegrateVariableLangevinStepKernel::Name(), factory);
+    registerKernelFactory(ApplyMonteCarloBarostatKernel::Name(), factory);
     platformProperties.push_back(CpuDeterministicForces());
+    platformProperties.push_back(CpuThreadAffinity());
+    platformProperties.push_back(CpuSpinWaitTime());
+    platformProperties.push_back(CpuEnableProfiling());
+
+    // The Threads property is inherited from ReferencePlatform.  Only its default value differs.
+
     int threads = getNumProcessors();
     char* threadsEnv = getenv("OPENMM_CPU_THREADS");
     if (threadsEnv != NULL)
@@ -85,6 +174,10 @@ CpuPlatform::CpuPlatform() {
     defaultThreads << threads;
     setPropertyDefaultValue(CpuThreads(), defaultThreads.str());
     setPropertyDefaultValue(CpuDeterministicForces(), "false");
+    char* affinityEnv = getenv("OPENMM_CPU_THREAD_AFFINITY");
+    setPropertyDefaultValue(CpuThreadAffinity(), affinityEnv == NULL ? "none" : affinityEnv);
+    setPropertyDefaultValue(CpuSpinWaitTime(), "0");
+    setPropertyDefaultValue(CpuEnableProfiling(), "false");
 }
 
 const string& CpuPlatform::getPropertyValue(const Context& context, const string& property) const {
@@ -114,6 +207,9 @@ bool CpuPlatform::isProcessorSupported() {
 void CpuPlatform::contextCreated(ContextImpl& context, const map<string, string>& properties) const {
     const string& threadsPropValue = (properties.find(CpuThreads()) == properties.end() ?
             getPropertyDefaultValue(CpuThreads()) : properties.find(CpuThreads())->second);
+    const string& affinityPropValue = (properties.find(CpuThreadAffinity()) == properties.end() ?
+            getPropertyDefaultValue(CpuThreadAffinity()) : properties.find(CpuThreadAffinity())->second);
+    vector<int> affinityCores = getThreadAffinityCores(affinityPropValue);
     map<string, string> refProperties = properties;
     refProperties["Threads"] = threadsPropValue;
     ReferencePlatform::contextCreated(context, refProperties);
@@ -122,14 +218,35 @@ void CpuPlatform::contextCreated(ContextImpl& context, const map<string, string>
     transform(deterministicForcesValue.begin(), deterministicForcesValue.end(), deterministicForcesValue.begin(), ::tolower);
     bool deterministicForces = (deterministicForcesValue == "true");
     ReferencePlatform::PlatformData* refData = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    if (affinityCores.size() > 0)
+        refData->threads.setThreadAffinity(affinityCores);
+    const string& spinPropValue = (properties.find(CpuSpinWaitTime()) == properties.end() ?
+            getPropertyDefaultValue(CpuSpinWaitTime()) : properties.find(CpuSpinWaitTime())->second);
+    int spinWaitTime;
+    stringstream spinStream(spinPropValue);
+    if (!(spinStream >> spinWaitTime) || spinWaitTime < 0)
+        throw OpenMMException("CpuPlatform: Illegal value for "+CpuSpinWaitTime()+": "+spinPropValue);
+    refData->threads.setSpinWaitTime(spinWaitTime);
+    string profilingPropValue = (properties.find(CpuEnableProfiling()) == properties.end() ?
+            getPropertyDefaultValue(CpuEnableProfiling()) : properties.find(CpuEnableProfiling())->second);
+    transform(profilingPropValue.begin(), profilingPropValue.end(), profilingPropValue.begin(), ::tolower);
     PlatformData* data = new PlatformData(context.getSystem().getNumParticles(), refData->threads, deterministicForces);
+    data->propertyValues[CpuThreadAffinity()] = affinityPropValue;
+    data->propertyValues[CpuSpinWaitTime()] = spinPropValue;
+    data->propertyValues[CpuEnableProfiling()] = profilingPropValue;
+    data->profiler.setEnabled(profilingPropValue == "true");
     contextData[&context] = data;
     ReferenceConstraints& constraints = *(ReferenceConstraints*) refData->constraints;
     if (constraints.settle != NULL) {
-        CpuSETTLE* parallelSettle = new CpuSETTLE(context.getSystem(), *(ReferenceSETTLEAlgorithm*) constraints.settle, data->threads);
+        CpuSETTLE* parallelSettle = new CpuSETTLE(context.getSystem(), *(ReferenceSETTLEAlgorithm*) constraints.settle, data->threads, data->profiler);
         delete constraints.settle;
         constraints.settle = parallelSettle;
     }
+    if (constraints.ccma != NULL) {
+        CpuCCMA* parallelCCMA = new CpuCCMA(context.getSystem(), *(ReferenceCCMAAlgorithm*) constraints.ccma, data->threads, data->profiler);
+        delete constraints.ccma;
+        constraints.ccma = parallelCCMA;
+    }
 }
 
 void CpuPlatform::contextDestroyed(ContextImpl& context) const {
@@ -140,6 +257,14 @@ void CpuPlatform::contextDestroyed(ContextImpl& context) const {
     delete refPlatformData;
 }
 
+map<string, pair<int, double> > CpuPlatform::getKernelTimings(Context& context) const {
+    return getPlatformData(getContextImpl(context)).profiler.getTimes();
+}
+
+void CpuPlatform::resetKernelTimings(Context& context) const {
+    getPlatformData(getContextImpl(context)).profiler.resetTimes();
+}
+
 CpuPlatform::PlatformData& CpuPlatform::getPlatformData(ContextImpl& context) {
     return *contextData[&context];
 }
@@ -149,12 +274,18 @@ const CpuPlatform::PlatformData& CpuPlatform::getPlatformData(const ContextImpl&
 }
 
 CpuPlatform::PlatformData::PlatformData(int numParticles, ThreadPool& threads, bool deterministicForces) : posq(4*numParticles), threads(threads),
-        deterministicForces(deterministicForces), numParticles(numParticles), neighborList(NULL), cutoff(0.0), paddedCutoff(0.0), anyExclusions(false),
+        profiler(threads), deterministicForces(deterministicForces), numParticles(numParticles), neighborList(NULL), cutoff(0.0), paddedCutoff(0.0), anyExclusions(false),
         currentPosqIndex(-1), nextPosqIndex(0) {
     int numThreads = threads.getNumThreads();
     threadForce.resize(numThreads);
-    for (int i = 0; i < numThreads; i++)
-        threadForce[i].resize(4*numParticles);
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        // Each thread allocates and initializes its own force buffer.  With first touch placement, this puts
+        // the memory on the NUMA node where the thread is running.
+
+        threadForce[threadIndex].resize(4*numParticles);
+        memset(&threadForce[threadIndex][0], 0, 4*numParticles*sizeof(float));
+    });
+    threads.waitForThreads();
     isPeriodic = false;
     stringstream threadsProperty;
     threadsProperty << numThreads;
@@ -167,9 +298,9 @@ CpuPlatform::PlatformData::~PlatformData() {
         delete neighborList;
 }
 
-void CpuPlatform::PlatformData::requestNeighborList(double cutoffDistance, double padding, bool useExclusions, const vector<set<int> >& exclusionList) {
+void CpuPlatform::PlatformData::requestNeighborList(double cutoffDistance, double padding, bool useExclusions, const ExclusionList& exclusionList) {
     if (neighborList == NULL) {
-        neighborList = new CpuNeighborList(getVectorWidth());
+        neighborList = new CpuNeighborList(getCpuNonbondedBlockSize());
         if (cutoffDistance == 0.0)
             neighborList->createDenseNeighborList(numParticles, exclusionList);
     }
@@ -35,7 +35,7 @@
 using namespace OpenMM;
 using namespace std;
 
-CpuSETTLE::CpuSETTLE(const System& system, const ReferenceSETTLEAlgorithm& settle, ThreadPool& threads) : threads(threads) {
+CpuSETTLE::CpuSETTLE(const System& system, const ReferenceSETTLEAlgorithm& settle, ThreadPool& threads, PhaseProfiler& profiler) : threads(threads), profiler(profiler) {
     int numBlocks = 10*threads.getNumThreads();
     long long numClusters = settle.getNumClusters();
     vector<double> mass(system.getNumParticles());
@@ -61,6 +61,7 @@ CpuSETTLE::~CpuSETTLE() {
 }
 
 void CpuSETTLE::apply(vector<OpenMM::Vec3>& atomCoordinates, vector<OpenMM::Vec3>& atomCoordinatesP, vector<double>& inverseMasses, double tolerance) {
+    profiler.startInterval();
     atomic<int> atomicCounter;
     atomicCounter = 0;
     threads.execute([&] (ThreadPool& threads, int threadIndex) {
@@ -72,9 +73,11 @@ void CpuSETTLE::apply(vector<OpenMM::Vec3>& atomCoordinates, vector<OpenMM::Vec3
         }
     });
     threads.waitForThreads();
+    profiler.endInterval("SETTLE");
 }
 
 void CpuSETTLE::applyToVelocities(vector<OpenMM::Vec3>& atomCoordinates, vector<OpenMM::Vec3>& velocities, vector<double>& inverseMasses, double tolerance) {
+    profiler.startInterval();
     atomic<int> atomicCounter;
     atomicCounter = 0;
     threads.execute([&] (ThreadPool& threads, int threadIndex) {
@@ -86,4 +89,5 @@ void CpuSETTLE::applyToVelocities(vector<OpenMM::Vec3>& atomCoordinates, vector<
         }
     });
     threads.waitForThreads();
+    profiler.endInterval("SETTLE");
 }
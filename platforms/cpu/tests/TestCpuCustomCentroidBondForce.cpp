@@ -0,0 +1,86 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuTests.h"
+#include "TestCustomCentroidBondForce.h"
+#include "ReferencePlatform.h"
+
+void testLargeSystem() {
+    // Compare to the Reference platform with enough bonds that they get divided between threads.
+    // The groups overlap and vary a lot in size.
+
+    System system;
+    const int numParticles = 600;
+    for (int i = 0; i < numParticles; i++)
+        system.addParticle(1.0+(i%3));
+    system.setDefaultPeriodicBoxVectors(Vec3(12, 0, 0), Vec3(0, 12, 0), Vec3(0, 0, 12));
+    CustomCentroidBondForce* force = new CustomCentroidBondForce(3, "scale*k*(distance(g1,g2)-r0)^2 + 0.1*angle(g1,g2,g3)");
+    force->addPerBondParameter("r0");
+    force->addPerBondParameter("k");
+    force->addGlobalParameter("scale", 0.5);
+    force->addEnergyParameterDerivative("scale");
+    force->setUsesPeriodicBoundaryConditions(true);
+    vector<int> largeGroup;
+    for (int i = 0; i < 400; i++)
+        largeGroup.push_back(i);
+    force->addGroup(largeGroup);
+    for (int i = 0; i < numParticles-5; i += 5) {
+        vector<int> group;
+        for (int j = 0; j < 10 && i+j < numParticles; j++)
+            group.push_back(i+j);
+        force->addGroup(group);
+    }
+    for (int i = 1; i < force->getNumGroups()-1; i++)
+        force->addBond({i-1, i, i+1}, {1.1, (double) i});
+    system.addForce(force);
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = Vec3(0.02*i, 0.5*(i%7), 0)+Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt));
+    VerletIntegrator integrator1(0.01);
+    ReferencePlatform reference;
+    Context context1(system, integrator1, reference);
+    context1.setPositions(positions);
+    State state1 = context1.getState(State::Forces | State::Energy | State::ParameterDerivatives);
+    VerletIntegrator integrator2(0.01);
+    Context context2(system, integrator2, platform);
+    context2.setPositions(positions);
+    State state2 = context2.getState(State::Forces | State::Energy | State::ParameterDerivatives);
+    ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1e-5);
+    ASSERT_EQUAL_TOL(state1.getEnergyParameterDerivatives().at("scale"), state2.getEnergyParameterDerivatives().at("scale"), 1e-5);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(state1.getForces()[i], state2.getForces()[i], 1e-5);
+}
+
+void runPlatformTests() {
+    testLargeSystem();
+}
@@ -31,6 +31,57 @@
 
 #include "CpuTests.h"
 #include "TestCustomGBForce.h"
+#include "ReferencePlatform.h"
+
+void testVectorizedPairs(CustomGBForce::NonbondedMethod method) {
+    // The CPU platform evaluates pair interactions from the neighbor list with vectorized expressions.
+    // Compare it to the Reference platform for a force with exclusions, several chained computed values,
+    // and pair energy terms that depend on them.  Every pair interaction goes smoothly to zero at the cutoff,
+    // so pairs right at the cutoff do not make the results depend on rounding.
+
+    const int numParticles = 300;
+    const double boxSize = 3.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    CustomGBForce* force = new CustomGBForce();
+    force->setNonbondedMethod(method);
+    force->setCutoffDistance(1.0);
+    force->addGlobalParameter("scale", 0.7);
+    force->addPerParticleParameter("q");
+    force->addPerParticleParameter("radius");
+    force->addComputedValue("I", "scale*exp(-r/radius2)*(1+radius1)*(1-r)^2", CustomGBForce::ParticlePair);
+    force->addComputedValue("B", "1/(1+I*I)", CustomGBForce::SingleParticle);
+    force->addComputedValue("C", "B*radius+sin(I)", CustomGBForce::SingleParticle);
+    force->addEnergyTerm("q*C+B", CustomGBForce::SingleParticle);
+    force->addEnergyTerm("q1*q2*(B1*C2+B2*C1)*(1-r)^2/(r+0.2)", CustomGBForce::ParticlePair);
+    force->addEnergyTerm("scale*(B1+B2)*(1-r)^3", CustomGBForce::ParticlePairNoExclusions);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        force->addParticle({genrand_real2(sfmt)-0.5, 0.1+0.2*genrand_real2(sfmt)});
+        positions[i] = Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+        if (i > 0 && i%3 != 0)
+            force->addExclusion(i-1, i);
+    }
+    system.addForce(force);
+    VerletIntegrator integrator1(0.001);
+    VerletIntegrator integrator2(0.001);
+    Context context(system, integrator1, platform);
+    ReferencePlatform reference;
+    Context referenceContext(system, integrator2, reference);
+    context.setPositions(positions);
+    referenceContext.setPositions(positions);
+    State state = context.getState(State::Forces | State::Energy);
+    State referenceState = referenceContext.getState(State::Forces | State::Energy);
+    ASSERT_EQUAL_TOL(referenceState.getPotentialEnergy(), state.getPotentialEnergy(), 1e-4);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(referenceState.getForces()[i], state.getForces()[i], 1e-4);
+}
 
 void runPlatformTests() {
+    testVectorizedPairs(CustomGBForce::NoCutoff);
+    testVectorizedPairs(CustomGBForce::CutoffNonPeriodic);
+    testVectorizedPairs(CustomGBForce::CutoffPeriodic);
 }
@@ -0,0 +1,79 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuTests.h"
+#include "TestMonteCarloBarostat.h"
+
+void testNeighborListAfterScaling() {
+    // The neighbor list is not rebuilt for every small change to the box.  Make sure no interactions
+    // are missed by comparing to a new Context, which builds its neighbor list from scratch.
+
+    const int gridSize = 8;
+    const double spacing = 0.4;
+    const double temp = 300.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(gridSize*spacing, 0, 0), Vec3(0, gridSize*spacing, 0), Vec3(0, 0, gridSize*spacing));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    nonbonded->setCutoffDistance(1.0);
+    vector<Vec3> positions;
+    for (int i = 0; i < gridSize; ++i)
+        for (int j = 0; j < gridSize; ++j)
+            for (int k = 0; k < gridSize; ++k) {
+                system.addParticle(40.0);
+                nonbonded->addParticle(0.0, 0.34, 1.0);
+                positions.push_back(Vec3(spacing*i, spacing*j, spacing*k));
+            }
+    system.addForce(nonbonded);
+    system.addForce(new MonteCarloBarostat(1000.0, temp, 1));
+    LangevinIntegrator integrator(temp, 1.0, 0.002);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    context.setVelocitiesToTemperature(temp);
+    for (int i = 0; i < 20; i++) {
+        integrator.step(10);
+        State state1 = context.getState(State::Positions | State::Energy | State::Forces);
+        VerletIntegrator integrator2(0.001);
+        Context context2(system, integrator2, platform);
+        Vec3 a, b, c;
+        state1.getPeriodicBoxVectors(a, b, c);
+        context2.setPeriodicBoxVectors(a, b, c);
+        context2.setPositions(state1.getPositions());
+        State state2 = context2.getState(State::Energy | State::Forces);
+        ASSERT_EQUAL_TOL(state2.getPotentialEnergy(), state1.getPotentialEnergy(), 1e-5);
+        for (int j = 0; j < system.getNumParticles(); j++)
+            ASSERT_EQUAL_VEC(state2.getForces()[j], state1.getForces()[j], 1e-4);
+    }
+}
+
+void runPlatformTests() {
+    testNeighborListAfterScaling();
+}
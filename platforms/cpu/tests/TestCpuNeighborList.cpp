@@ -48,40 +48,14 @@
 using namespace OpenMM;
 using namespace std;
 
-void testNeighborList(bool periodic, bool triclinic) {
-    const int numParticles = 500;
-    const float cutoff = 2.0f;
-    Vec3 boxVectors[3];
-    if (triclinic) {
-        boxVectors[0] = Vec3(10, 0, 0);
-        boxVectors[1] = Vec3(4, 9, 0);
-        boxVectors[2] = Vec3(-3, -3.5, 11);
-    }
-    else {
-        boxVectors[0] = Vec3(10, 0, 0);
-        boxVectors[1] = Vec3(0, 9, 0);
-        boxVectors[2] = Vec3(0, 0, 11);
-    }
+/**
+ * Verify that a neighbor list contains every pair of atoms that should interact.
+ */
+void checkNeighborList(const CpuNeighborList& neighborList, int numParticles, const AlignedArray<float>& positions, const ExclusionList& exclusions,
+        const Vec3* boxVectors, bool periodic, float cutoff) {
     const float boxSize[3] = {(float) boxVectors[0][0], (float) boxVectors[1][1], (float) boxVectors[2][2]};
-    const int blockSize = 8;
-    OpenMM_SFMT::SFMT sfmt;
-    init_gen_rand(0, sfmt);
-    AlignedArray<float> positions(4*numParticles);
-    for (int i = 0; i < 4*numParticles; i++)
-        if (i%4 < 3)
-            positions[i] = boxSize[i%4]*genrand_real2(sfmt);
-    vector<set<int> > exclusions(numParticles);
-    for (int i = 0; i < numParticles; i++) {
-        int num = min(i+1, 10);
-        for (int j = 0; j < num; j++) {
-            exclusions[i].insert(i-j);
-            exclusions[i-j].insert(i);
-        }
-    }
-    ThreadPool threads;
-    CpuNeighborList neighborList(blockSize);
-    neighborList.computeNeighborList(numParticles, positions, exclusions, boxVectors, periodic, cutoff, threads);
-    
+    const int blockSize = neighborList.getBlockSize();
+
     // Convert the neighbor list to a set for faster lookup.
     
     set<pair<int, int> > neighbors;
@@ -100,11 +74,23 @@ void testNeighborList(bool periodic, bool triclinic) {
         }
     }
     
+    // The iterator should report each neighbor's position in the sorted atom order.
+
+    for (int i = 0; i < neighborList.getNumBlocks(); i++) {
+        CpuNeighborList::NeighborIterator iter = neighborList.getNeighborIterator(i);
+        int numNeighbors = 0;
+        while (iter.next()) {
+            ASSERT_EQUAL(iter.getNeighbor(), neighborList.getSortedAtoms()[iter.getSortedNeighbor()]);
+            numNeighbors++;
+        }
+        ASSERT_EQUAL(neighborList.getBlockNeighbors(i).size(), numNeighbors);
+    }
+
     // Check each particle pair and figure out whether they should be in the neighbor list.
 
     for (int i = 0; i < numParticles; i++)
         for (int j = 0; j <= i; j++) {
-            bool shouldInclude = (exclusions[i].find(j) == exclusions[i].end());
+            bool shouldInclude = !exclusions.isExcluded(i, j);
             Vec3 diff(positions[4*i]-positions[4*j], positions[4*i+1]-positions[4*j+1], positions[4*i+2]-positions[4*j+2]);
             if (periodic) {
                 diff -= boxVectors[2]*floor(diff[2]/boxSize[2]+0.5);
@@ -119,6 +105,104 @@ void testNeighborList(bool periodic, bool triclinic) {
         }
 }
 
+void testNeighborList(bool periodic, bool triclinic) {
+    const int numParticles = 500;
+    const float cutoff = 2.0f;
+    Vec3 boxVectors[3];
+    if (triclinic) {
+        boxVectors[0] = Vec3(10, 0, 0);
+        boxVectors[1] = Vec3(4, 9, 0);
+        boxVectors[2] = Vec3(-3, -3.5, 11);
+    }
+    else {
+        boxVectors[0] = Vec3(10, 0, 0);
+        boxVectors[1] = Vec3(0, 9, 0);
+        boxVectors[2] = Vec3(0, 0, 11);
+    }
+    const float boxSize[3] = {(float) boxVectors[0][0], (float) boxVectors[1][1], (float) boxVectors[2][2]};
+    const int blockSize = 8;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    AlignedArray<float> positions(4*numParticles);
+    for (int i = 0; i < 4*numParticles; i++)
+        if (i%4 < 3)
+            positions[i] = boxSize[i%4]*genrand_real2(sfmt);
+    vector<pair<int, int> > excludedPairs;
+    for (int i = 0; i < numParticles; i++) {
+        int num = min(i+1, 10);
+        for (int j = 0; j < num; j++)
+            excludedPairs.push_back(make_pair(i, i-j));
+    }
+    ThreadPool threads;
+    ExclusionList exclusions(numParticles, excludedPairs, threads);
+    CpuNeighborList neighborList(blockSize);
+    neighborList.computeNeighborList(numParticles, positions, exclusions, boxVectors, periodic, cutoff, threads);
+    
+    checkNeighborList(neighborList, numParticles, positions, exclusions, boxVectors, periodic, cutoff);
+}
+
+void testPruneNeighborList(bool periodic, bool triclinic) {
+    const int numParticles = 500;
+    const float cutoff = 2.0f;
+    const float padding = 0.5f;
+    const float prunePadding = 0.2f;
+    Vec3 boxVectors[3];
+    if (triclinic) {
+        boxVectors[0] = Vec3(12, 0, 0);
+        boxVectors[1] = Vec3(4, 11, 0);
+        boxVectors[2] = Vec3(-3, -3.5, 13);
+    }
+    else {
+        boxVectors[0] = Vec3(12, 0, 0);
+        boxVectors[1] = Vec3(0, 11, 0);
+        boxVectors[2] = Vec3(0, 0, 13);
+    }
+    const float boxSize[3] = {(float) boxVectors[0][0], (float) boxVectors[1][1], (float) boxVectors[2][2]};
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    AlignedArray<float> positions(4*numParticles);
+    for (int i = 0; i < 4*numParticles; i++)
+        if (i%4 < 3)
+            positions[i] = boxSize[i%4]*genrand_real2(sfmt);
+    vector<pair<int, int> > excludedPairs;
+    for (int i = 0; i < numParticles; i++) {
+        int num = min(i+1, 3);
+        for (int j = 0; j < num; j++)
+            excludedPairs.push_back(make_pair(i, i-j));
+    }
+    ThreadPool threads;
+    ExclusionList exclusions(numParticles, excludedPairs, threads);
+    CpuNeighborList neighborList(8);
+    neighborList.computeNeighborList(numParticles, positions, exclusions, boxVectors, periodic, cutoff+padding, threads);
+    int fullSize = 0;
+    for (int i = 0; i < neighborList.getNumBlocks(); i++)
+        fullSize += neighborList.getBlockNeighbors(i).size();
+
+    // Move the atoms by less than half the padding, and prune the list.
+
+    for (int i = 0; i < 4*numParticles; i++)
+        if (i%4 < 3)
+            positions[i] += 0.16f*(genrand_real2(sfmt)-0.5f);
+    neighborList.pruneNeighborList(positions, boxVectors, periodic, cutoff+prunePadding, threads);
+    int prunedSize = 0;
+    for (int i = 0; i < neighborList.getNumBlocks(); i++)
+        prunedSize += neighborList.getBlockNeighbors(i).size();
+    ASSERT(prunedSize < fullSize);
+    checkNeighborList(neighborList, numParticles, positions, exclusions, boxVectors, periodic, cutoff);
+
+    // Move them by less than half the pruning padding.  No interactions should be lost.
+
+    for (int i = 0; i < 4*numParticles; i++)
+        if (i%4 < 3)
+            positions[i] += 0.1f*(genrand_real2(sfmt)-0.5f);
+    checkNeighborList(neighborList, numParticles, positions, exclusions, boxVectors, periodic, cutoff);
+
+    // Pruning again should start from the full list, not the pruned one.
+
+    neighborList.pruneNeighborList(positions, boxVectors, periodic, cutoff+prunePadding, threads);
+    checkNeighborList(neighborList, numParticles, positions, exclusions, boxVectors, periodic, cutoff);
+}
+
 int main() {
     try {
         if (!CpuPlatform::isProcessorSupported()) {
@@ -128,6 +212,9 @@ int main() {
         testNeighborList(false, false);
         testNeighborList(true, false);
         testNeighborList(true, true);
+        testPruneNeighborList(false, false);
+        testPruneNeighborList(true, false);
+        testPruneNeighborList(true, true);
     }
     catch(const exception& e) {
         cout << "exception: " << e.what() << endl;
@@ -32,6 +32,51 @@
 #include "CpuTests.h"
 #include "TestNonbondedForce.h"
 
+void testDeterministicForces(NonbondedForce::NonbondedMethod method) {
+    // In deterministic mode, the results should be identical no matter how many threads are used.
+
+    System system;
+    const int numParticles = 1000;
+    const double boxSize = 4.0;
+    NonbondedForce* force = new NonbondedForce();
+    force->setNonbondedMethod(method);
+    force->setCutoffDistance(1.0);
+    system.addForce(force);
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        force->addParticle(i%2-0.5, 0.2+0.1*genrand_real2(sfmt), 0.5);
+        positions[i] = Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+    }
+    for (int i = 1; i < numParticles; i += 2)
+        force->addException(i-1, i, 0, 1, 0);
+    vector<Vec3> forces[3];
+    double energy[3];
+    const char* numThreads[] = {"1", "3", "4"};
+    for (int i = 0; i < 3; i++) {
+        map<string, string> props;
+        props[CpuPlatform::CpuThreads()] = numThreads[i];
+        props[CpuPlatform::CpuDeterministicForces()] = "true";
+        VerletIntegrator integrator(0.001);
+        Context context(system, integrator, platform, props);
+        context.setPositions(positions);
+        State state = context.getState(State::Forces | State::Energy);
+        forces[i] = state.getForces();
+        energy[i] = state.getPotentialEnergy();
+    }
+    for (int i = 1; i < 3; i++) {
+        ASSERT_EQUAL(energy[0], energy[i]);
+        for (int j = 0; j < numParticles; j++)
+            for (int k = 0; k < 3; k++)
+                ASSERT_EQUAL(forces[0][j][k], forces[i][j][k]);
+    }
+}
+
 void runPlatformTests() {
     testHugeSystem();
+    testDeterministicForces(NonbondedForce::CutoffPeriodic);
+    testDeterministicForces(NonbondedForce::Ewald);
 }
@@ -0,0 +1,192 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This tests recording the time spent in each phase of the calculation on the CPU platform.
+ */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/internal/PhaseProfiler.h"
+#include "openmm/internal/ThreadPool.h"
+#include "openmm/Context.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include "CpuPlatform.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+void testThreadTimes() {
+    ThreadPool threads(2);
+    threads.setRecordThreadTimes(true);
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        // Only the first thread does any significant work.
+
+        if (threadIndex == 0) {
+            double sum = 0.0;
+            for (int i = 0; i < 10000000; i++)
+                sum += 1.0/(i+1);
+            ASSERT(sum > 0.0);
+        }
+    });
+    threads.waitForThreads();
+    vector<double> times = threads.getThreadTimes();
+    ASSERT_EQUAL(2, times.size());
+    ASSERT(times[0] > 0.0);
+    ASSERT(times[0] > times[1]);
+}
+
+void testPhaseProfiler() {
+    ThreadPool threads(2);
+    PhaseProfiler profiler(threads);
+
+    // When profiling is disabled, nothing should be recorded.
+
+    profiler.startInterval();
+    profiler.endInterval("outer");
+    ASSERT_EQUAL(0, profiler.getTimes().size());
+
+    // Record nested intervals.  The inner one does uneven work on the threads.
+
+    profiler.setEnabled(true);
+    for (int i = 0; i < 2; i++) {
+        profiler.startInterval();
+        profiler.startInterval();
+        threads.execute([&] (ThreadPool& threads, int threadIndex) {
+            if (threadIndex == 0) {
+                double sum = 0.0;
+                for (int i = 0; i < 1000000; i++)
+                    sum += 1.0/(i+1);
+                ASSERT(sum > 0.0);
+            }
+        });
+        threads.waitForThreads();
+        profiler.endInterval("inner");
+        profiler.endInterval("outer");
+    }
+    map<string, pair<int, double> >& times = profiler.getTimes();
+    ASSERT_EQUAL(2, times["outer"].first);
+    ASSERT_EQUAL(2, times["inner"].first);
+    ASSERT_EQUAL(2, times["inner imbalance"].first);
+    ASSERT(times["inner"].second > 0.0);
+    ASSERT(times["inner imbalance"].second > 0.0);
+    ASSERT(times["inner imbalance"].second <= times["inner"].second);
+    ASSERT(times.find("outer imbalance") == times.end());
+    profiler.resetTimes();
+    ASSERT_EQUAL(0, profiler.getTimes().size());
+}
+
+void testContextTimings() {
+    const int numMolecules = 50;
+    const double boxSize = 2.5;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::PME);
+    nonbonded->setCutoffDistance(1.0);
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numMolecules; i++) {
+        system.addParticle(1.0);
+        system.addParticle(1.0);
+        nonbonded->addParticle(0.5, 0.3, 0.5);
+        nonbonded->addParticle(-0.5, 0.3, 0.5);
+        nonbonded->addException(2*i, 2*i+1, 0.0, 1.0, 0.0);
+        bonds->addBond(2*i, 2*i+1, 0.1, 1000.0);
+        Vec3 pos(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+        positions.push_back(pos);
+        positions.push_back(pos+Vec3(0.1, 0, 0));
+    }
+    system.addForce(nonbonded);
+    system.addForce(bonds);
+    CpuPlatform platform;
+
+    // Without profiling, no timings should be reported.
+
+    {
+        VerletIntegrator integrator(0.001);
+        Context context(system, integrator, platform);
+        context.setPositions(positions);
+        integrator.step(5);
+        ASSERT_EQUAL(0, context.getKernelTimings().size());
+    }
+
+    // With profiling, each phase should be recorded.
+
+    VerletIntegrator integrator(0.001);
+    map<string, string> properties;
+    properties[CpuPlatform::CpuThreads()] = "2";
+    properties[CpuPlatform::CpuEnableProfiling()] = "true";
+    Context context(system, integrator, platform, properties);
+    ASSERT_EQUAL("true", platform.getPropertyValue(context, CpuPlatform::CpuEnableProfiling()));
+    context.setPositions(positions);
+    integrator.step(5);
+    map<string, pair<int, double> > timings = context.getKernelTimings();
+    vector<string> phases = {"Neighbor list", "Nonbonded direct space", "Nonbonded reciprocal space", "Nonbonded exceptions", "Bonded forces", "Force reduction", "Integration"};
+    for (const string& phase : phases) {
+        ASSERT(timings.find(phase) != timings.end());
+        ASSERT(timings[phase].first > 0);
+        ASSERT(timings[phase].second >= 0.0);
+    }
+    ASSERT_EQUAL(5, timings["Integration"].first);
+    ASSERT(timings.find("Nonbonded direct space imbalance") != timings.end());
+    context.resetKernelTimings();
+    ASSERT_EQUAL(0, context.getKernelTimings().size());
+    integrator.step(1);
+    ASSERT_EQUAL(1, context.getKernelTimings()["Integration"].first);
+}
+
+int main() {
+    try {
+        if (!CpuPlatform::isProcessorSupported()) {
+            cout << "CPU is not supported.  Exiting." << endl;
+            return 0;
+        }
+        testThreadTimes();
+        testPhaseProfiler();
+        testContextTimings();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
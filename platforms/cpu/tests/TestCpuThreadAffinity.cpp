@@ -0,0 +1,117 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This tests binding the CPU platform's worker threads to cores.
+ */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/internal/ThreadPool.h"
+#include "openmm/internal/hardware.h"
+#include "openmm/Context.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include "CpuPlatform.h"
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+void testThreadPoolAffinity() {
+    ThreadPool threads(2);
+    vector<int> cores;
+    ASSERT(!threads.setThreadAffinity(cores));
+    cores.push_back(0);
+#ifdef __linux__
+    ASSERT(threads.setThreadAffinity(cores));
+#endif
+
+    // Make sure the threads still work after being bound.
+
+    vector<int> executed(2, 0);
+    threads.execute([&] (ThreadPool& threads, int threadIndex) { executed[threadIndex] = 1; });
+    threads.waitForThreads();
+    ASSERT_EQUAL(1, executed[0]);
+    ASSERT_EQUAL(1, executed[1]);
+}
+
+void testAffinityProperty() {
+    CpuPlatform platform;
+    System system;
+    system.addParticle(1.0);
+    int lastCore = getNumProcessors()-1;
+    vector<string> values = {"none", "compact", "scatter", "0", "0,"+to_string(lastCore), "0-"+to_string(lastCore)};
+    for (const string& value : values) {
+        VerletIntegrator integrator(0.001);
+        map<string, string> properties;
+        properties[CpuPlatform::CpuThreads()] = "2";
+        properties[CpuPlatform::CpuThreadAffinity()] = value;
+        Context context(system, integrator, platform, properties);
+        ASSERT_EQUAL(value, platform.getPropertyValue(context, CpuPlatform::CpuThreadAffinity()));
+        context.setPositions(vector<Vec3>(1));
+        integrator.step(1);
+    }
+    vector<string> illegalValues = {"closest", "0-", "3-1", "-1", "1,x"};
+    for (const string& value : illegalValues) {
+        VerletIntegrator integrator(0.001);
+        map<string, string> properties;
+        properties[CpuPlatform::CpuThreadAffinity()] = value;
+        bool threwException = false;
+        try {
+            Context context(system, integrator, platform, properties);
+        }
+        catch (const OpenMMException& ex) {
+            threwException = true;
+        }
+        ASSERT(threwException);
+    }
+}
+
+int main() {
+    try {
+        if (!CpuPlatform::isProcessorSupported()) {
+            cout << "CPU is not supported.  Exiting." << endl;
+            return 0;
+        }
+        testThreadPoolAffinity();
+        testAffinityProperty();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
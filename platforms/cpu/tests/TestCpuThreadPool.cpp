@@ -0,0 +1,134 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This tests the ThreadPool class used by the CPU platform.
+ */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/internal/ThreadPool.h"
+#include "CpuPlatform.h"
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+void testParallelFor(int numThreads, int numItems, int grainSize) {
+    ThreadPool threads(numThreads);
+    vector<atomic<int> > count(numItems);
+    for (auto& c : count)
+        c = 0;
+    vector<double> result(numItems);
+    threads.parallelFor(numItems, grainSize, [&] (ThreadPool& threads, int threadIndex, int start, int end) {
+        ASSERT(threadIndex >= 0 && threadIndex < numThreads);
+        ASSERT(start >= 0 && start < end && end <= numItems);
+        ASSERT(end-start <= grainSize);
+        for (int i = start; i < end; i++) {
+            count[i]++;
+
+            // Make the cost very uneven, so threads end up stealing work.
+
+            double sum = 0.0;
+            int work = (i%13 == 0 ? 20000 : 10);
+            for (int j = 0; j < work; j++)
+                sum += sin(i+j);
+            result[i] = sum;
+        }
+    });
+    for (int i = 0; i < numItems; i++)
+        ASSERT_EQUAL(1, count[i]);
+
+    // The pool should still be usable for ordinary tasks.
+
+    vector<int> executed(numThreads, 0);
+    threads.execute([&] (ThreadPool& threads, int threadIndex) { executed[threadIndex]++; });
+    threads.waitForThreads();
+    for (int i = 0; i < numThreads; i++)
+        ASSERT_EQUAL(1, executed[i]);
+}
+
+void testSpinWait(int numThreads, int spinWaitTime) {
+    // Run many short phases, some with synchronization in the middle, and make sure every thread
+    // executes each of them exactly once.
+
+    ThreadPool threads(numThreads);
+    threads.setSpinWaitTime(spinWaitTime);
+    ASSERT_EQUAL(spinWaitTime, threads.getSpinWaitTime());
+    vector<int> executed(numThreads, 0), synced(numThreads, 0);
+    const int numPhases = 1000;
+    for (int phase = 0; phase < numPhases; phase++) {
+        threads.execute([&] (ThreadPool& threads, int threadIndex) {
+            executed[threadIndex]++;
+            if (phase%10 == 0) {
+                threads.syncThreads();
+                synced[threadIndex]++;
+            }
+        });
+        threads.waitForThreads();
+        if (phase%10 == 0) {
+            for (int i = 0; i < numThreads; i++)
+                ASSERT_EQUAL(phase+1, executed[i]);
+            threads.resumeThreads();
+            threads.waitForThreads();
+        }
+    }
+    for (int i = 0; i < numThreads; i++) {
+        ASSERT_EQUAL(numPhases, executed[i]);
+        ASSERT_EQUAL(numPhases/10, synced[i]);
+    }
+}
+
+int main() {
+    try {
+        if (!CpuPlatform::isProcessorSupported()) {
+            cout << "CPU is not supported.  Exiting." << endl;
+            return 0;
+        }
+        testParallelFor(1, 100, 1);
+        testParallelFor(4, 0, 1);
+        testParallelFor(4, 3, 1);
+        testParallelFor(4, 1000, 1);
+        testParallelFor(4, 1000, 16);
+        testParallelFor(7, 12345, 5);
+        testSpinWait(4, 0);
+        testSpinWait(4, 50);
+        testSpinWait(1, 1000);
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
@@ -0,0 +1,93 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuTests.h"
+#include "TestVerletIntegrator.h"
+#include "openmm/HarmonicAngleForce.h"
+
+void testParallelConstraints() {
+    // Compare to the Reference platform with enough clusters of constraints that they get divided between threads.
+
+    const int numChains = 100;
+    const int chainLength = 5;
+    const int numParticles = numChains*chainLength;
+    System system;
+    HarmonicAngleForce* angles = new HarmonicAngleForce();
+    system.addForce(angles);
+    vector<Vec3> positions(numParticles);
+    vector<Vec3> velocities(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numChains; i++) {
+        for (int j = 0; j < chainLength; j++) {
+            int index = i*chainLength+j;
+            system.addParticle(j%2 == 0 ? 12.0 : 1.0);
+            positions[index] = Vec3(i%10, 2*(i/10)+0.1*(j%2), j);
+            velocities[index] = Vec3(genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5);
+            if (j > 0)
+                system.addConstraint(index-1, index, sqrt(1.0+0.01*(j%2)));
+            if (j > 1)
+                angles->addAngle(index-2, index-1, index, 2.9, 100.0);
+        }
+    }
+    VerletIntegrator integrator1(0.002);
+    integrator1.setConstraintTolerance(1e-6);
+    ReferencePlatform reference;
+    Context context1(system, integrator1, reference);
+    context1.setPositions(positions);
+    context1.setVelocities(velocities);
+    VerletIntegrator integrator2(0.002);
+    integrator2.setConstraintTolerance(1e-6);
+    map<string, string> properties;
+    properties[CpuPlatform::CpuThreads()] = "4";
+    Context context2(system, integrator2, platform, properties);
+    context2.setPositions(positions);
+    context2.setVelocities(velocities);
+    integrator1.step(20);
+    integrator2.step(20);
+    State state1 = context1.getState(State::Positions | State::Velocities);
+    State state2 = context2.getState(State::Positions | State::Velocities);
+    for (int i = 0; i < numParticles; i++) {
+        ASSERT_EQUAL_VEC(state1.getPositions()[i], state2.getPositions()[i], 1e-4);
+        ASSERT_EQUAL_VEC(state1.getVelocities()[i], state2.getVelocities()[i], 1e-3);
+    }
+    for (int i = 0; i < system.getNumConstraints(); i++) {
+        int particle1, particle2;
+        double distance;
+        system.getConstraintParameters(i, particle1, particle2, distance);
+        Vec3 delta = state2.getPositions()[particle1]-state2.getPositions()[particle2];
+        ASSERT_EQUAL_TOL(distance, sqrt(delta.dot(delta)), 1e-5);
+    }
+}
+
+void runPlatformTests() {
+    testParallelConstraints();
+}
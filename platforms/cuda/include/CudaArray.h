@@ -9,7 +9,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2009-2022 Stanford University and the Authors.      *
+ * Portions copyright (c) 2009-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -93,6 +93,15 @@ public:
     void initialize(ComputeContext& context, size_t size, const std::string& name) {
         initialize(context, size, sizeof(T), name);
     }
+    /**
+     * Initialize this object so it refers to the same device memory as another array holding
+     * read-only data.  The memory is copied the first time this array is modified.
+     *
+     * @param context           the context for which to create the array
+     * @param source            the array whose memory should be shared
+     * @param name              the name of the array
+     */
+    void initializeShared(ComputeContext& context, ArrayInterface& source, const std::string& name);
     /**
      * Recreate the internal storage to have a different size.
      */
@@ -173,18 +182,40 @@ public:
      *                 the destination array must be in page-locked memory.
      */
     void download(void* data, bool blocking=true) const;
+    /**
+     * Copy a subset of the values in the device memory to an array.
+     * 
+     * @param data     the array to copy the memory to
+     * @param offset   the index of the element within the array at which the copy should begin
+     * @param elements the number of elements to copy
+     * @param blocking if true, this call will block until the transfer is complete.  If false,
+     *                 the destination array must be in page-locked memory.
+     */
+    void downloadSubArray(void* data, int offset, int elements, bool blocking=true) const;
     /**
      * Copy the values in the device memory to a second array.
      * 
      * @param dest     the destination array to copy to
      */
     void copyTo(ArrayInterface& dest) const;
+    /**
+     * Get the device pointer, cast to a void*.
+     */
+    void* getNativeHandle() {
+        return (void*) pointer;
+    }
 private:
+    /**
+     * If this array shares memory with another one, allocate its own memory before it is modified.
+     *
+     * @param copyContents   if true, the current contents are copied to the new memory
+     */
+    void copyOnWrite(bool copyContents);
     CudaContext* context;
     CUdeviceptr pointer;
     size_t size;
     int elementSize;
-    bool ownsMemory;
+    bool ownsMemory, sharesMemory;
     std::string name;
 };
 
@@ -9,7 +9,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2009-2025 Stanford University and the Authors.      *
+ * Portions copyright (c) 2009-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -27,7 +27,10 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
  * -------------------------------------------------------------------------- */
 
+#include <condition_variable>
+#include <future>
 #include <map>
+#include <mutex>
 #include <string>
 #include <utility>
 #define __CL_ENABLE_EXCEPTIONS
@@ -48,6 +51,7 @@
 #include "CudaQueue.h"
 #include "openmm/OpenMMException.h"
 #include "openmm/common/ComputeContext.h"
+#include "openmm/common/KernelCache.h"
 #include "openmm/Kernel.h"
 
 typedef unsigned int tileflags;
@@ -181,6 +185,11 @@ public:
      * Construct a ComputeEvent object of the appropriate class for this platform.
      */
     ComputeEvent createEvent();
+    /**
+     * Construct a ComputeEvent object of the appropriate class for this platform that records
+     * device timestamps.
+     */
+    ComputeEvent createTimingEvent();
     /**
      * Construct a ComputeSort object of the appropriate class for this platform.
      * 
@@ -195,12 +204,29 @@ public:
      */
     ComputeSort createSort(ComputeSortImpl::SortTrait* trait, unsigned int length, bool uniform=true);
     /**
-     * Compile source code to create a ComputeProgram.
+     * Compile source code to create a ComputeProgram.  Compilation happens on a worker thread,
+     * so several programs can be compiled at once.  This returns immediately, and the module is
+     * only waited for when a kernel from it is first executed.
      *
      * @param source             the source code of the program
      * @param defines            a set of preprocessor definitions (name, value) to define when compiling the program
      */
     ComputeProgram compileProgram(const std::string source, const std::map<std::string, std::string>& defines=std::map<std::string, std::string>());
+    /**
+     * Compile source code to create a ComputeProgram that is only needed occasionally.  Compilation
+     * is deferred.  It happens either when a kernel from the program is first executed, or on a
+     * worker thread once precompileDeferredPrograms() is called, whichever comes first.
+     *
+     * @param source             the source code of the program
+     * @param defines            a set of preprocessor definitions (name, value) to define when compiling the program
+     */
+    ComputeProgram compileProgramOnDemand(const std::string source, const std::map<std::string, std::string>& defines=std::map<std::string, std::string>());
+    /**
+     * Start compiling all programs that were deferred by compileProgramOnDemand() on a worker thread.
+     * This is called after the first force evaluation, so the compilation overlaps with the first steps
+     * of the simulation.
+     */
+    void precompileDeferredPrograms();
     /**
      * Convert an array to an CudaArray.  If the argument is already an CudaArray, this simply casts it.
      * If the argument is a ComputeArray that wraps a CudaArray, this returns the wrapped array.  For any
@@ -256,6 +282,12 @@ public:
     CudaArray& getEnergyBuffer() {
         return energyBuffer;
     }
+    /**
+     * Get the array into which reduceEnergy() sums the energy buffer.
+     */
+    CudaArray& getEnergySum() {
+        return energySum;
+    }
     /**
      * Get the array which contains the buffer in which derivatives of the energy with respect to parameters are computed.
      */
@@ -269,6 +301,45 @@ public:
     void* getPinnedBuffer() {
         return pinnedBuffer;
     }
+    /**
+     * Allocate a new block of pinned memory that is owned by the caller.  It must be released by
+     * calling freePinnedMemory().
+     *
+     * @param size    the size of the block in bytes
+     */
+    void* allocatePinnedMemory(size_t size);
+    /**
+     * Release a block of memory that was allocated by allocatePinnedMemory().
+     */
+    void freePinnedMemory(void* memory);
+    /**
+     * Allocate a block of device memory.  When the device supports stream ordered allocation, the memory
+     * is taken from a pool owned by this context.  Memory released with freeDeviceMemory() stays in the
+     * pool and is reused by later allocations, so arrays can be freed and recreated (for example when
+     * they are resized) without going through the driver's allocator each time.
+     *
+     * @param pointer   on exit, the address of the allocated memory
+     * @param size      the size of the block in bytes
+     * @return the result reported by the driver
+     */
+    CUresult allocateDeviceMemory(CUdeviceptr* pointer, size_t size);
+    /**
+     * Release a block of memory that was allocated by allocateDeviceMemory().  If it came from the pool,
+     * it is not reused until all work queued on the current stream before this call has finished.
+     *
+     * @param pointer   the address of the memory to release
+     * @return the result reported by the driver
+     */
+    CUresult freeDeviceMemory(CUdeviceptr pointer);
+    /**
+     * Get statistics about the device memory allocated by allocateDeviceMemory().
+     *
+     * @param used       on exit, the number of bytes currently allocated
+     * @param peak       on exit, the largest number of bytes that have been allocated at any one time
+     * @param reserved   on exit, the number of bytes reserved from the driver.  This includes memory
+     *                   that has been freed and is held in the pool for reuse.
+     */
+    void getDeviceMemoryStatistics(size_t& used, size_t& peak, size_t& reserved);
     /**
      * Get a shared ThreadPool that code can use to parallelize operations.
      * 
@@ -300,8 +371,11 @@ public:
      * @param defines            a set of preprocessor definitions (name, value) to define when compiling the program
      * @param optimizationFlags  the optimization flags to pass to the CUDA compiler.  If this is
      *                           omitted, a default set of options will be used
+     * @param shareable          if true, the module may be shared with other contexts that use the same
+     *                           CUDA context and compile the same source.  Pass false if the caller will
+     *                           modify global variables in the module.
      */
-    CUmodule createModule(const std::string source, const std::map<std::string, std::string>& defines, const char* optimizationFlags = NULL);
+    CUmodule createModule(const std::string source, const std::map<std::string, std::string>& defines, const char* optimizationFlags = NULL, bool shareable = true);
     /**
      * Get a kernel from a CUDA module.
      *
@@ -309,6 +383,32 @@ public:
      * @param name      the name of the kernel to get
      */
     CUfunction getKernel(CUmodule& module, const std::string& name);
+    /**
+     * Load a set of tuned parameters that were previously saved by saveTuningParameters().
+     * Parameters are stored in the kernel cache directory, separately for each type of device.
+     * If nothing has been saved under the specified name, this returns an empty map.
+     *
+     * @param name    identifies the set of parameters to load
+     */
+    std::map<std::string, double> loadTuningParameters(const std::string& name);
+    /**
+     * Save a set of tuned parameters to the kernel cache directory so they can be reused by
+     * later Contexts on the same type of device.  Failures to write the file are ignored.
+     *
+     * @param name     identifies the set of parameters
+     * @param values   the parameter values to save
+     */
+    void saveTuningParameters(const std::string& name, const std::map<std::string, double>& values);
+    /**
+     * Begin a named range of work to be shown by NVTX based profiling tools such as Nsight Systems.
+     *
+     * @param name    the name of the range
+     */
+    void pushAnnotation(const std::string& name);
+    /**
+     * End the most recently begun annotation range.
+     */
+    void popAnnotation();
     /**
      * Execute a kernel.
      *
@@ -399,6 +499,13 @@ public:
     bool getSupportsDoublePrecision() const {
         return true;
     }
+    /**
+     * Get whether this context uses the device's primary CUDA context, which it shares with other
+     * contexts on the same device, rather than creating its own.
+     */
+    bool getUsePrimaryContext() const {
+        return usePrimaryContext;
+    }
     /**
      * Get whether double precision is being used.
      */
@@ -525,15 +632,28 @@ public:
         return new CudaNonbondedUtilities(*this);
     }
     /**
-     * Create an object for performing 3D FFTs.  The caller is responsible for deleting
-     * the object when it is no longer needed.
+     * Get the name of the device this context is running on.
+     */
+    std::string getDeviceName();
+    /**
+     * Get the names of the FFT implementations that can perform transforms of a particular size.
      *
      * @param xsize   the first dimension of the data sets on which FFTs will be performed
      * @param ysize   the second dimension of the data sets on which FFTs will be performed
      * @param zsize   the third dimension of the data sets on which FFTs will be performed
      * @param realToComplex  if true, a real-to-complex transform will be done.  Otherwise, it is complex-to-complex.
      */
-    FFT3D createFFT(int xsize, int ysize, int zsize, bool realToComplex=false);
+    std::vector<std::string> getFFTBackends(int xsize, int ysize, int zsize, bool realToComplex);
+    /**
+     * Create an object for performing 3D FFTs with a specific implementation.
+     *
+     * @param backend the name of the implementation to use, as returned by getFFTBackends()
+     * @param xsize   the first dimension of the data sets on which FFTs will be performed
+     * @param ysize   the second dimension of the data sets on which FFTs will be performed
+     * @param zsize   the third dimension of the data sets on which FFTs will be performed
+     * @param realToComplex  if true, a real-to-complex transform will be done.  Otherwise, it is complex-to-complex.
+     */
+    FFT3D createFFTWithBackend(const std::string& backend, int xsize, int ysize, int zsize, bool realToComplex);
     /**
      * This should be called by the Integrator from its own initialize() method.
      * It ensures all contexts are fully initialized.
@@ -580,11 +700,41 @@ public:
      * Get the flags that should be used when creating CUevent objects.
      */
     unsigned int getEventFlags();
+    /**
+     * Begin capturing the work that is queued from this point on into a CUDA graph.  See
+     * ComputeContext::beginGraphCapture() for details.
+     */
+    bool beginGraphCapture(const std::string& key);
+    /**
+     * Finish capturing the work that was begun by beginGraphCapture() and launch it.  See
+     * ComputeContext::endGraphCapture() for details.
+     */
+    bool endGraphCapture();
+    /**
+     * Get whether work is currently being captured into a CUDA graph rather than executed.
+     */
+    bool isCapturingGraph() const {
+        return capturingGraph;
+    }
 private:
+    /**
+     * Discard a graph capture that was begun but never finished, for example because an exception
+     * was thrown.
+     */
+    void abortGraphCapture();
     /**
      * Compute a sorted list of device indices in decreasing order of desirability
      */
     std::vector<int> getDevicePrecedence();
+    /**
+     * Free all device memory that is still allocated, including memory held by arrays that have
+     * not been deleted yet, and destroy the memory pool.  This is called when the context is deleted.
+     */
+    void releaseAllDeviceMemory();
+    /**
+     * Load a module, compiling it or loading it from the kernel cache as appropriate.
+     */
+    CUmodule loadModule(const std::string& source, const std::string& options, const std::string& compileArchitecture);
     static bool hasInitializedCuda;
     double computeCapability;
     CudaPlatform::PlatformData& platformData;
@@ -594,14 +744,21 @@ private:
     int numThreadBlocks;
     int gpuArchitecture;
     bool useBlockingSync, useDoublePrecision, useMixedPrecision, contextIsValid, boxIsTriclinic, hasAssignedPosqCharges;
-    bool isLinkedContext;
-    std::string tempDir, cacheDir;
+    bool isLinkedContext, usePrimaryContext, capturingGraph;
+    int graphCaptureSupported;
+    std::string tempDir, cacheDir, graphKey;
+    KernelCache kernelCache;
     float4 periodicBoxVecXFloat, periodicBoxVecYFloat, periodicBoxVecZFloat, periodicBoxSizeFloat, invPeriodicBoxSizeFloat;
     double4 periodicBoxVecX, periodicBoxVecY, periodicBoxVecZ, periodicBoxSize, invPeriodicBoxSize;
     std::string defaultOptimizationOptions;
     std::map<std::string, std::string> compilationDefines;
+    std::map<CUfunction, std::string> kernelNames;
+    std::map<std::string, CUgraphExec> graphExecs;
+    ComputeQueue graphQueue, savedDefaultQueue, savedCurrentQueue;
     CUcontext context;
     CUdevice device;
+    CUstream contextStream;
+    std::vector<CUmodule> privateModules;
     CUfunction clearBufferKernel;
     CUfunction clearTwoBuffersKernel;
     CUfunction clearThreeBuffersKernel;
@@ -629,6 +786,21 @@ private:
     CudaBondedUtilities* bonded;
     CudaNonbondedUtilities* nonbonded;
     Kernel compilerKernel;
+    std::mutex compilationMutex;
+    std::condition_variable compilationCondition;
+    int numActiveCompilations, numPendingCompilations;
+    std::vector<std::shared_future<CUmodule> > deferredModules;
+    std::future<void> deferredCompilation;
+    std::mutex memoryMutex;
+    std::map<CUdeviceptr, std::pair<size_t, bool> > deviceAllocations;
+    std::vector<CUdeviceptr> pendingFrees;
+    size_t allocatedMemory, peakAllocatedMemory;
+    bool deviceMemoryReleased;
+#if CUDA_VERSION >= 11020
+    CUmemoryPool memoryPool;
+    CUstream memoryStream;
+    CUevent memoryEvent;
+#endif
 };
 
 /**
@@ -38,7 +38,13 @@ namespace OpenMM {
 
 class CudaEvent : public ComputeEventImpl {
 public:
-    CudaEvent(CudaContext& context);
+    /**
+     * Create a CudaEvent.
+     *
+     * @param context      the context the event belongs to
+     * @param enableTiming if true, the event records timestamps so it can be used with getElapsedTime()
+     */
+    CudaEvent(CudaContext& context, bool enableTiming=false);
     ~CudaEvent();
     /**
      * Place the event into the device's execution queue.
@@ -53,6 +59,10 @@ public:
      * operations started before the call to enqueue() have completed.
      */
     void queueWait(ComputeQueue queue);
+    /**
+     * Get the time in milliseconds that elapsed on the device between another event and this one.
+     */
+    double getElapsedTime(ComputeEventImpl& start);
 private:
     CudaContext& context;
     CUevent event;
@@ -29,6 +29,7 @@
 
 #include "CudaArray.h"
 #include "CudaContext.h"
+#include <future>
 #include <string>
 #include <vector>
 
@@ -48,6 +49,11 @@ public:
      * @param name         the name of the kernel function
      */
     CudaKernel(CudaContext& context, CUfunction kernel, const std::string& name);
+    /**
+     * Create a kernel from a module that may still be being compiled.  The module is waited for
+     * the first time the kernel is needed.
+     */
+    CudaKernel(CudaContext& context, std::shared_future<CUmodule> module, const std::string& name);
     /**
      * Get the name of this kernel.
      */
@@ -101,8 +107,10 @@ protected:
      */
     void setPrimitiveArg(int index, const void* value, int size);
 private:
+    CUfunction getFunction() const;
     CudaContext& context;
-    CUfunction kernel;
+    std::shared_future<CUmodule> module;
+    mutable CUfunction kernel;
     std::string name;
     std::vector<double4> primitiveArgs;
     std::vector<CudaArray*> arrayArgs;
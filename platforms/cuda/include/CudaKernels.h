@@ -9,7 +9,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2008-2025 Stanford University and the Authors.      *
+ * Portions copyright (c) 2008-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -46,7 +46,7 @@ namespace OpenMM {
  */
 class CudaCalcForcesAndEnergyKernel : public CalcForcesAndEnergyKernel {
 public:
-    CudaCalcForcesAndEnergyKernel(std::string name, const Platform& platform, CudaContext& cu) : CalcForcesAndEnergyKernel(name, platform), cu(cu) {
+    CudaCalcForcesAndEnergyKernel(std::string name, const Platform& platform, CudaContext& cu) : CalcForcesAndEnergyKernel(name, platform), cu(cu), annotatingGroups(false), annotatingForce(false) {
     }
     /**
      * Initialize the kernel.
@@ -79,8 +79,25 @@ public:
      * energy directly, <i>or</i> add it to an internal buffer so that it will be included here.
      */
     double finishComputation(ContextImpl& context, bool includeForce, bool includeEnergy, int groups, bool& valid);
+    /**
+     * This is called immediately before calcForcesAndEnergy() is called on each ForceImpl.
+     *
+     * @param context       the context in which to execute this kernel
+     * @param force         the Force whose contribution is about to be computed
+     * @param groups        a set of bit flags for which force groups to include
+     */
+    void beginForce(ContextImpl& context, const Force& force, int groups);
+    /**
+     * This is called immediately after calcForcesAndEnergy() returns for each ForceImpl.
+     *
+     * @param context       the context in which to execute this kernel
+     * @param force         the Force whose contribution was just computed
+     * @param groups        a set of bit flags for which force groups to include
+     */
+    void endForce(ContextImpl& context, const Force& force, int groups);
 private:
    CudaContext& cu;
+   bool annotatingGroups, annotatingForce;
 };
 
 /**
@@ -177,6 +177,14 @@ public:
      * @return true if the neighbor list needed to be enlarged.
      */
     bool updateNeighborListSize();
+    /**
+     * When the interactions were computed as part of a CUDA graph, the host could not wait for the
+     * number of interactions to be downloaded at the time.  Call this after the graph has been
+     * launched to wait for it and check whether the neighbor list arrays are large enough.
+     *
+     * @param forceGroups    the flags specifying which force groups were included
+     */
+    void checkNeighborListSizeAfterGraph(int forceGroups);
     /**
      * Get the array containing the center of each atom block.
      */
@@ -207,6 +215,13 @@ public:
     CudaArray& getInteractingAtoms() {
         return interactingAtoms;
     }
+    /**
+     * Get the array containing, for each atom in interactingAtoms, a mask of the atoms in the
+     * tile's first block it interacts with.  This is only filled in when pair pruning is enabled.
+     */
+    CudaArray& getInteractingFlags() {
+        return interactingFlags;
+    }
     /**
      * Get the array containing single pairs in the neighbor list.
      */
@@ -264,6 +279,21 @@ public:
      * it may be better to set this to false.
      */
     void setUsePadding(bool padding);
+    /**
+     * Get the padding currently added to the cutoff distance when building the neighbor list.
+     * If the AdaptiveNeighborListPadding property is enabled, this changes as the simulation runs.
+     */
+    double getPadding() const {
+        return padding;
+    }
+    /**
+     * Get the average number of calls to prepareInteractions() between rebuilds of the neighbor list
+     * that were triggered by atoms moving.  This is only measured when the padding is being tuned
+     * automatically.  If no such rebuild has happened yet, it returns 0.
+     */
+    double getStepsBetweenRebuilds() const {
+        return (totalNaturalRebuilds == 0 ? 0.0 : totalRebuildSteps/(double) totalNaturalRebuilds);
+    }
     /**
      * Set the range of atom blocks and tiles that should be processed by this context.
      */
@@ -298,6 +328,29 @@ private:
     class KernelSet;
     class BlockSortTrait;
     void initParamArgs();
+    /**
+     * Copy the current padding into the constant memory used by a set of neighbor list kernels.
+     */
+    void uploadPadding(KernelSet& kernels);
+    /**
+     * Record the cost of the most recent neighbor list update, and retune the padding if enough
+     * data has been gathered.
+     */
+    void updateRebuildStatistics();
+    /**
+     * Pick a new padding that minimizes the estimated cost per step.
+     */
+    void tunePadding();
+    /**
+     * Choose the thread block size and count, based on results saved by earlier Contexts.  If they
+     * have not all been measured yet, prepare to measure them.
+     */
+    void selectTunedThreadBlocks();
+    /**
+     * Record the time taken by the most recent timed execution of the force kernel, and move on to
+     * the next thread block count once enough samples have been collected.
+     */
+    void updateThreadBlockTuning();
     CudaContext& context;
     std::map<int, KernelSet> groupKernels;
     CudaArray exclusionTiles;
@@ -306,6 +359,7 @@ private:
     CudaArray exclusionRowIndices;
     CudaArray interactingTiles;
     CudaArray interactingAtoms;
+    CudaArray interactingFlags;
     CudaArray interactionCount;
     CudaArray singlePairs;
     CudaArray singlePairCount;
@@ -320,8 +374,9 @@ private:
     CudaArray oldPositions;
     CudaArray rebuildNeighborList;
     ComputeSort blockSorter;
-    CUevent downloadCountEvent;
+    CUevent downloadCountEvent, buildStartEvent, buildEndEvent, forceStartEvent, forceEndEvent, tuningStartEvent, tuningEndEvent;
     unsigned int* pinnedCountBuffer;
+    int* pinnedRebuildFlag;
     std::vector<void*> forceArgs, findBlockBoundsArgs, computeSortKeysArgs, sortBoxDataArgs, findInteractingBlocksArgs;
     std::vector<std::vector<int> > atomExclusions;
     std::vector<ComputeParameterInfo> parameters;
@@ -329,8 +384,18 @@ private:
     std::vector<std::string> energyParameterDerivatives;
     std::map<int, double> groupCutoff;
     std::map<int, std::string> groupKernelSource;
-    double maxCutoff;
+    double maxCutoff, padding, minPadding, maxPadding, rebuildTime, checkTime, forceTime;
     bool useCutoff, usePeriodic, anyExclusions, usePadding, useNeighborList, forceRebuildNeighborList, canUsePairList, useLargeBlocks, hasInitializedParams;
+    bool useAdaptivePadding, buildTimingPending, forceTimingPending, lastRebuildWasForced, usePairPruning;
+    int stepsSinceRebuild, windowSteps, naturalRebuilds, numRebuildTimes, numCheckTimes, numForceTimes;
+    long long totalRebuildSteps, totalNaturalRebuilds;
+    bool useThreadBlockTuning, tuningTimingPending;
+    int multiprocessors, tuningGroups, tuningCandidate, tuningSamples;
+    float tuningBestSample;
+    std::vector<int> tuningBlocksPerSM;
+    std::vector<double> tuningResults;
+    std::string tuningKey;
+    std::map<std::string, double> tuningValues;
     int startTileIndex, startBlockIndex, numBlocks, maxExclusions, numForceThreadBlocks, forceThreadBlockSize, numAtoms, groupFlags, numBlockSizes, paramStartIndex;
     unsigned int maxTiles, maxSinglePairs, tilesAfterReorder;
     long long numTiles;
@@ -351,6 +416,7 @@ public:
     CUfunction sortBoxDataKernel;
     CUfunction findInteractingBlocksKernel;
     CUfunction findInteractionsWithinBlocksKernel;
+    CUdeviceptr paddingValues;
 };
 
 } // namespace OpenMM
@@ -80,11 +80,15 @@ public:
 private:
     class BeginComputationTask;
     class FinishComputationTask;
+    /**
+     * Assign each context its range of atom blocks based on contextNonbondedFractions.
+     */
+    void updateNonbondedRanges();
     CudaPlatform::PlatformData& data;
     std::vector<Kernel> kernels;
     std::vector<double> completionTimes;
     std::vector<double> contextNonbondedFractions;
-    bool loadBalance;
+    bool loadBalance, dedicatedPmeDevice;
     int2* interactionCounts;
     CudaArray contextForces;
     void* pinnedPositionBuffer;
@@ -29,6 +29,7 @@
 
 #include "openmm/common/ComputeProgram.h"
 #include "CudaContext.h"
+#include <future>
 
 namespace OpenMM {
 
@@ -45,6 +46,13 @@ public:
      * @param module       the compiled module
      */
     CudaProgram(CudaContext& context, CUmodule module);
+    /**
+     * Create a new CudaProgram whose module is still being compiled.
+     * 
+     * @param context      the context this kernel belongs to
+     * @param module       a future that provides the compiled module
+     */
+    CudaProgram(CudaContext& context, std::shared_future<CUmodule> module);
     /**
      * Create a ComputeKernel for one of the kernels in this program.
      * 
@@ -53,7 +61,7 @@ public:
     ComputeKernel createKernel(const std::string& name);
 private:
     CudaContext& context;
-    CUmodule module;
+    std::shared_future<CUmodule> module;
 };
 
 } // namespace OpenMM
@@ -53,6 +53,12 @@ public:
     CUstream getStream() {
         return stream;
     }
+    /**
+     * Get the CUstream, cast to a void*.
+     */
+    void* getNativeHandle() {
+        return (void*) stream;
+    }
 private:
     CUstream stream;
     bool initialized;
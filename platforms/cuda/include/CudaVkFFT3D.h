@@ -0,0 +1,105 @@
+#ifndef __OPENMM_CUDAVKFFT3D_H__
+#define __OPENMM_CUDAVKFFT3D_H__
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2009-2025 Stanford University and the Authors.      *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * -------------------------------------------------------------------------- */
+
+#define VKFFT_BACKEND 1 // CUDA
+#include "vkFFT.h"
+#include "openmm/common/FFT3D.h"
+#include "openmm/common/ArrayInterface.h"
+
+namespace OpenMM {
+
+class CudaContext;
+
+/**
+ * This class performs three dimensional Fast Fourier Transforms using VkFFT by
+ * Dmitrii Tolmachev (https://github.com/DTolm/VkFFT).  It is an alternative to CudaFFT3D,
+ * which uses cuFFT.  Which one is faster depends on the device and the size of the grid,
+ * so CudaContext::createFFT() benchmarks both of them.
+ *
+ * Note that this class performs an unnormalized transform.  That means that if you perform
+ * a forward transform followed immediately by an inverse transform, the effect is to
+ * multiply every value of the original data set by the total number of data points.
+ */
+
+class OPENMM_EXPORT_COMMON CudaVkFFT3D : public FFT3DImpl {
+public:
+    /**
+     * Create a CudaVkFFT3D object for performing transforms of a particular size.
+     *
+     * @param context the context in which to perform calculations
+     * @param xsize   the first dimension of the data sets on which FFTs will be performed
+     * @param ysize   the second dimension of the data sets on which FFTs will be performed
+     * @param zsize   the third dimension of the data sets on which FFTs will be performed
+     * @param realToComplex  if true, a real-to-complex transform will be done.  Otherwise, it is complex-to-complex.
+     */
+    CudaVkFFT3D(CudaContext& context, int xsize, int ysize, int zsize, bool realToComplex=false);
+    ~CudaVkFFT3D();
+    /**
+     * Perform a Fourier transform.  The transform cannot be done in-place: the input and output
+     * arrays must be different.  Also, the input array is used as workspace, so its contents
+     * are destroyed.  This also means that both arrays must be large enough to hold complex values,
+     * even when performing a real-to-complex transform.
+     *
+     * When performing a real-to-complex transform, the output data is of size xsize*ysize*(zsize/2+1)
+     * and contains only the non-redundant elements.
+     *
+     * @param in       the data to transform, ordered such that in[x*ysize*zsize + y*zsize + z] contains element (x, y, z)
+     * @param out      on exit, this contains the transformed data
+     * @param forward  true to perform a forward transform, false to perform an inverse transform
+     */
+    void execFFT(ArrayInterface& in, ArrayInterface& out, bool forward=true);
+    /**
+     * Get whether this object can perform fused convolutions with execConvolution().
+     */
+    bool supportsConvolution();
+    /**
+     * Convolve a data set with a kernel, fusing the multiplication into the transforms.  See
+     * FFT3DImpl::execConvolution() for details.
+     *
+     * @param in       the data to convolve.  On exit, this contains the result.
+     * @param out      used as workspace
+     * @param kernel   the complex values to multiply the transformed data by
+     */
+    void execConvolution(ArrayInterface& in, ArrayInterface& out, ArrayInterface& kernel);
+private:
+    CudaContext& context;
+    CUdevice device;
+    cudaStream_t stream;
+    void* inputBuffer;
+    void* outputBuffer;
+    void* kernelBuffer;
+    uint64_t inputBufferSize;
+    uint64_t outputBufferSize;
+    VkFFTConfiguration configuration;
+    VkFFTApplication* app;
+    VkFFTApplication* convolutionApp;
+    int convolutionStatus;
+};
+
+} // namespace OpenMM
+
+#endif // __OPENMM_CUDAVKFFT3D_H__
@@ -0,0 +1,146 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.            *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+
+/**
+ * This program is run at build time to precompile the kernels for commonly used Forces and
+ * Integrators.  It creates Contexts for a set of small standard Systems on the CUDA platform,
+ * directing the kernel cache to the output directory.  The resulting files are installed with
+ * OpenMM and searched by CudaContext before it compiles anything with NVRTC.
+ *
+ * Usage: PrebuildCudaKernels <CUDA plugin library> <output directory>
+ */
+
+#include "OpenMM.h"
+#include <map>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * Create a box of water-like molecules with bonds, angles, and nonbonded interactions.
+ */
+static System* createWaterBox(NonbondedForce::NonbondedMethod method, int numMolecules) {
+    System* system = new System();
+    double boxSize = 3.0;
+    system->setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    HarmonicAngleForce* angles = new HarmonicAngleForce();
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(method);
+    nonbonded->setCutoffDistance(1.0);
+    for (int i = 0; i < numMolecules; i++) {
+        int o = system->addParticle(16.0);
+        int h1 = system->addParticle(1.0);
+        int h2 = system->addParticle(1.0);
+        nonbonded->addParticle(-0.834, 0.315, 0.636);
+        nonbonded->addParticle(0.417, 1.0, 0.0);
+        nonbonded->addParticle(0.417, 1.0, 0.0);
+        nonbonded->addException(o, h1, 0.0, 1.0, 0.0);
+        nonbonded->addException(o, h2, 0.0, 1.0, 0.0);
+        nonbonded->addException(h1, h2, 0.0, 1.0, 0.0);
+        bonds->addBond(o, h1, 0.09572, 462750.4);
+        bonds->addBond(o, h2, 0.09572, 462750.4);
+        angles->addAngle(h1, o, h2, 1.82421813418, 836.8);
+    }
+    system->addForce(bonds);
+    system->addForce(angles);
+    system->addForce(nonbonded);
+    return system;
+}
+
+/**
+ * Create a short chain with proper torsions, to cover the remaining bonded Forces.
+ */
+static System* createChain(int numParticles) {
+    System* system = new System();
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    HarmonicAngleForce* angles = new HarmonicAngleForce();
+    PeriodicTorsionForce* torsions = new PeriodicTorsionForce();
+    for (int i = 0; i < numParticles; i++) {
+        system->addParticle(12.0);
+        if (i > 0)
+            bonds->addBond(i-1, i, 0.15, 200000.0);
+        if (i > 1)
+            angles->addAngle(i-2, i-1, i, 1.9, 400.0);
+        if (i > 2)
+            torsions->addTorsion(i-3, i-2, i-1, i, 3, 0.0, 1.0);
+    }
+    system->addForce(bonds);
+    system->addForce(angles);
+    system->addForce(torsions);
+    return system;
+}
+
+static vector<Vec3> createPositions(int numParticles) {
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = Vec3(0.3*(i%10), 0.3*((i/10)%10), 0.3*(i/100));
+    return positions;
+}
+
+static void compileKernels(System* system, Integrator* integrator, Platform& platform, const map<string, string>& properties) {
+    Context context(*system, *integrator, platform, properties);
+    context.setPositions(createPositions(system->getNumParticles()));
+    context.getState(State::Energy | State::Forces);
+    integrator->step(1);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        cerr << "Usage: PrebuildCudaKernels <CUDA plugin library> <output directory>" << endl;
+        return 1;
+    }
+    try {
+        Platform::loadPluginLibrary(argv[1]);
+        Platform& platform = Platform::getPlatformByName("CUDA");
+        vector<string> precisions = {"single", "mixed", "double"};
+        vector<NonbondedForce::NonbondedMethod> methods = {NonbondedForce::NoCutoff, NonbondedForce::CutoffNonPeriodic, NonbondedForce::CutoffPeriodic, NonbondedForce::PME};
+        for (const string& precision : precisions) {
+            map<string, string> properties;
+            properties["Precision"] = precision;
+            properties["CacheDirectory"] = argv[2];
+            for (NonbondedForce::NonbondedMethod method : methods) {
+                System* system = createWaterBox(method, 300);
+                LangevinMiddleIntegrator langevin(300.0, 1.0, 0.002);
+                compileKernels(system, &langevin, platform, properties);
+                VerletIntegrator verlet(0.001);
+                compileKernels(system, &verlet, platform, properties);
+                delete system;
+            }
+            System* system = createChain(20);
+            VerletIntegrator verlet(0.001);
+            compileKernels(system, &verlet, platform, properties);
+            delete system;
+        }
+    }
+    catch (const exception& ex) {
+        cerr << "Failed to precompile CUDA kernels: " << ex.what() << endl;
+        return 1;
+    }
+    return 0;
+}
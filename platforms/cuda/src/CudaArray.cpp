@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2012-2022 Stanford University and the Authors.      *
+ * Portions copyright (c) 2012-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -33,7 +33,7 @@
 
 using namespace OpenMM;
 
-CudaArray::CudaArray() : pointer(0), ownsMemory(false) {
+CudaArray::CudaArray() : pointer(0), ownsMemory(false), sharesMemory(false) {
 }
 
 CudaArray::CudaArray(CudaContext& context, size_t size, int elementSize, const std::string& name) : pointer(0) {
@@ -41,9 +41,11 @@ CudaArray::CudaArray(CudaContext& context, size_t size, int elementSize, const s
 }
 
 CudaArray::~CudaArray() {
+    if (ownsMemory)
+        context->recordArrayRelease(*this);
     if (pointer != 0 && ownsMemory && context->getContextIsValid()) {
         ContextSelector selector(*context);
-        CUresult result = cuMemFree(pointer);
+        CUresult result = context->freeDeviceMemory(pointer);
         if (result != CUDA_SUCCESS) {
             std::stringstream str;
             str<<"Error deleting array "<<name<<": "<<CudaContext::getErrorString(result)<<" ("<<result<<")";
@@ -60,11 +62,52 @@ void CudaArray::initialize(ComputeContext& context, size_t size, int elementSize
     this->elementSize = elementSize;
     this->name = name;
     ownsMemory = true;
+    sharesMemory = false;
+    this->context->recordArrayAllocation(*this, size*elementSize);
     ContextSelector selector(*this->context);
-    CUresult result = cuMemAlloc(&pointer, size*elementSize);
+    CUresult result = this->context->allocateDeviceMemory(&pointer, size*elementSize);
     if (result != CUDA_SUCCESS) {
+        this->context->recordArrayRelease(*this);
         std::stringstream str;
         str<<"Error creating array "<<name<<": "<<CudaContext::getErrorString(result)<<" ("<<result<<")";
+        if (result == CUDA_ERROR_OUT_OF_MEMORY)
+            str<<".  "<<this->context->getMemoryUsageReport();
+        throw OpenMMException(str.str());
+    }
+}
+
+void CudaArray::initializeShared(ComputeContext& context, ArrayInterface& source, const std::string& name) {
+    if (this->pointer != 0)
+        throw OpenMMException("CudaArray has already been initialized");
+    this->context = &dynamic_cast<CudaContext&>(context);
+    CudaArray& sharedSource = this->context->unwrap(source);
+    pointer = sharedSource.getDevicePointer();
+    size = sharedSource.getSize();
+    elementSize = sharedSource.getElementSize();
+    this->name = name;
+    ownsMemory = false;
+    sharesMemory = true;
+}
+
+void CudaArray::copyOnWrite(bool copyContents) {
+    if (!sharesMemory)
+        return;
+    CUdeviceptr shared = pointer;
+    pointer = 0;
+    try {
+        initialize(*context, size, elementSize, name);
+    }
+    catch (...) {
+        pointer = shared;
+        throw;
+    }
+    if (!copyContents)
+        return;
+    ContextSelector selector(*context);
+    CUresult result = cuMemcpyDtoD(pointer, shared, size*elementSize);
+    if (result != CUDA_SUCCESS) {
+        std::stringstream str;
+        str<<"Error copying array "<<name<<": "<<CudaContext::getErrorString(result)<<" ("<<result<<")";
         throw OpenMMException(str.str());
     }
 }
@@ -72,10 +115,16 @@ void CudaArray::initialize(ComputeContext& context, size_t size, int elementSize
 void CudaArray::resize(size_t size) {
     if (pointer == 0)
         throw OpenMMException("CudaArray has not been initialized");
+    if (sharesMemory) {
+        pointer = 0;
+        sharesMemory = false;
+        initialize(*context, size, elementSize, name);
+        return;
+    }
     if (!ownsMemory)
         throw OpenMMException("Cannot resize an array that does not own its storage");
     ContextSelector selector(*context);
-    CUresult result = cuMemFree(pointer);
+    CUresult result = context->freeDeviceMemory(pointer);
     if (result != CUDA_SUCCESS) {
         std::stringstream str;
         str<<"Error deleting array "<<name<<": "<<CudaContext::getErrorString(result)<<" ("<<result<<")";
@@ -94,6 +143,8 @@ void CudaArray::uploadSubArray(const void* data, int offset, int elements, bool
         throw OpenMMException("CudaArray has not been initialized");
     if (offset < 0 || offset+elements > getSize())
         throw OpenMMException("uploadSubArray: data exceeds range of array");
+    copyOnWrite(offset > 0 || elements < size);
+    ComputeContext::Annotation annotation(*context, "upload ", name);
     CUresult result;
     if (blocking)
         result = cuMemcpyHtoD(pointer+offset*elementSize, data, elements*elementSize);
@@ -109,6 +160,7 @@ void CudaArray::uploadSubArray(const void* data, int offset, int elements, bool
 void CudaArray::download(void* data, bool blocking) const {
     if (pointer == 0)
         throw OpenMMException("CudaArray has not been initialized");
+    ComputeContext::Annotation annotation(*context, "download ", name);
     CUresult result;
     if (blocking)
         result = cuMemcpyDtoH(data, pointer, size*elementSize);
@@ -121,12 +173,31 @@ void CudaArray::download(void* data, bool blocking) const {
     }
 }
 
+void CudaArray::downloadSubArray(void* data, int offset, int elements, bool blocking) const {
+    if (pointer == 0)
+        throw OpenMMException("CudaArray has not been initialized");
+    if (offset < 0 || offset+elements > getSize())
+        throw OpenMMException("downloadSubArray: data exceeds range of array");
+    ComputeContext::Annotation annotation(*context, "download ", name);
+    CUresult result;
+    if (blocking)
+        result = cuMemcpyDtoH(data, pointer+offset*elementSize, elements*elementSize);
+    else
+        result = cuMemcpyDtoHAsync(data, pointer+offset*elementSize, elements*elementSize, context->getCurrentStream());
+    if (result != CUDA_SUCCESS) {
+        std::stringstream str;
+        str<<"Error downloading array "<<name<<": "<<CudaContext::getErrorString(result)<<" ("<<result<<")";
+        throw OpenMMException(str.str());
+    }
+}
+
 void CudaArray::copyTo(ArrayInterface& dest) const {
     if (pointer == 0)
         throw OpenMMException("CudaArray has not been initialized");
     if (dest.getSize() != size || dest.getElementSize() != elementSize)
         throw OpenMMException("Error copying array "+name+" to "+dest.getName()+": The destination array does not match the size of the array");
     CudaArray& cuDest = context->unwrap(dest);
+    cuDest.copyOnWrite(false);
     CUresult result = cuMemcpyDtoDAsync(cuDest.getDevicePointer(), pointer, size*elementSize, context->getCurrentStream());
     if (result != CUDA_SUCCESS) {
         std::stringstream str;
@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2009-2025 Stanford University and the Authors.      *
+ * Portions copyright (c) 2009-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -33,6 +33,7 @@
 #include "CudaBondedUtilities.h"
 #include "CudaEvent.h"
 #include "CudaFFT3D.h"
+#include "CudaVkFFT3D.h"
 #include "CudaIntegrationUtilities.h"
 #include "CudaKernels.h"
 #include "CudaKernelSources.h"
@@ -41,7 +42,6 @@
 #include "CudaSort.h"
 #include "openmm/common/ComputeArray.h"
 #include "openmm/common/ContextSelector.h"
-#include "SHA1.h"
 #include "openmm/MonteCarloFlexibleBarostat.h"
 #include "openmm/Platform.h"
 #include "openmm/System.h"
@@ -50,6 +50,7 @@
 #include "openmm/internal/ContextImpl.h"
 #include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -59,6 +60,12 @@
 #include <sys/stat.h>
 #include <cudaProfiler.h>
 #include <nvrtc.h>
+#if defined(__has_include)
+  #if __has_include(<nvtx3/nvToolsExt.h>)
+    #include <nvtx3/nvToolsExt.h>
+    #define OPENMM_USE_NVTX
+  #endif
+#endif
 #ifndef WIN32
   #include <unistd.h>
 #endif
@@ -85,9 +92,35 @@ const int CudaContext::ThreadBlockSize = 64;
 const int CudaContext::TileSize = sizeof(tileflags)*8;
 bool CudaContext::hasInitializedCuda = false;
 
+// Modules are shared by all CudaContexts that use the same CUDA context and compile identical
+// source code.  They remain loaded until the CUDA context is destroyed or released.
+
+static mutex moduleCacheMutex;
+static map<pair<CUcontext, string>, CUmodule> moduleCache;
+static map<CUdevice, int> primaryContextUsers;
+
+/**
+ * Remove the cached modules for a CUDA context, optionally unloading them.
+ */
+static void forgetCachedModules(CUcontext context, bool unload) {
+    for (auto iter = moduleCache.begin(); iter != moduleCache.end(); ) {
+        if (iter->first.first == context) {
+            if (unload)
+                cuModuleUnload(iter->second);
+            iter = moduleCache.erase(iter);
+        }
+        else
+            ++iter;
+    }
+}
+
 CudaContext::CudaContext(const System& system, int deviceIndex, bool useBlockingSync, const string& precision, const string& tempDir, CudaPlatform::PlatformData& platformData,
         CudaContext* originalContext) : ComputeContext(system), platformData(platformData), contextIsValid(false), hasAssignedPosqCharges(false),
-        pinnedBuffer(NULL), integration(NULL), expression(NULL), bonded(NULL), nonbonded(NULL), useBlockingSync(useBlockingSync) {
+        contextStream(0), pinnedBuffer(NULL), integration(NULL), expression(NULL), bonded(NULL), nonbonded(NULL), useBlockingSync(useBlockingSync),
+        usePrimaryContext(false), capturingGraph(false), graphCaptureSupported(-1), numActiveCompilations(0), numPendingCompilations(0), allocatedMemory(0), peakAllocatedMemory(0), deviceMemoryReleased(false), kernelCache(platformData.cacheDirectory, tempDir, "openmm-cuda-") {
+    setMemoryBudget(platformData.memoryBudget);
+    if (platformData.shareParameters)
+        enableSharedArrays(originalContext);
     int cudaDriverVersion;
     cuDriverGetVersion(&cudaDriverVersion);
     if (!hasInitializedCuda) {
@@ -108,14 +141,21 @@ CudaContext::CudaContext(const System& system, int deviceIndex, bool useBlocking
     }
     else
         throw OpenMMException("Illegal value for Precision: "+precision);
-    char* cacheVariable = getenv("OPENMM_CACHE_DIR");
-    cacheDir = (cacheVariable == NULL ? tempDir : string(cacheVariable));
+    cacheDir = kernelCache.getDirectory();
+
+    // Kernels precompiled when OpenMM was built are used if the cache does not already contain them.
+
+    char* prebuiltDir = getenv("OPENMM_PREBUILT_KERNEL_DIR");
+    if (prebuiltDir != NULL)
+        kernelCache.addReadOnlyDirectory(string(prebuiltDir));
+#ifdef OPENMM_PREBUILT_KERNEL_DIR
+    else
+        kernelCache.addReadOnlyDirectory(OPENMM_PREBUILT_KERNEL_DIR);
+#endif
 #ifdef WIN32
     this->tempDir = tempDir+"\\";
-    cacheDir = cacheDir+"\\";
 #else
     this->tempDir = tempDir+"/";
-    cacheDir = cacheDir+"/";
 #endif
     contextIndex = platformData.contexts.size();
     string errorMessage = "Error initializing Context";
@@ -144,7 +184,20 @@ CudaContext::CudaContext(const System& system, int deviceIndex, bool useBlocking
             else
                 flags += CU_CTX_SCHED_SPIN;
 
-            if (cuCtxCreate(&context, flags, device) == CUDA_SUCCESS) {
+            if (platformData.usePrimaryContext) {
+                // The flags can only be changed before the primary context is first used, so
+                // this has no effect if another Context is already using it.
+
+                cuDevicePrimaryCtxSetFlags(device, flags);
+                if (cuDevicePrimaryCtxRetain(&context, device) == CUDA_SUCCESS) {
+                    this->deviceIndex = trialDeviceIndex;
+                    usePrimaryContext = true;
+                    lock_guard<mutex> lock(moduleCacheMutex);
+                    primaryContextUsers[device]++;
+                    break;
+                }
+            }
+            else if (cuCtxCreate(&context, flags, device) == CUDA_SUCCESS) {
                 this->deviceIndex = trialDeviceIndex;
                 CUcontext popped;
                 cuCtxPopCurrent(&popped);
@@ -160,6 +213,7 @@ CudaContext::CudaContext(const System& system, int deviceIndex, bool useBlocking
     }
     else {
         isLinkedContext = true;
+        usePrimaryContext = originalContext->usePrimaryContext;
         context = originalContext->context;
         this->deviceIndex = originalContext->deviceIndex;
         this->device = originalContext->device;
@@ -191,18 +245,75 @@ CudaContext::CudaContext(const System& system, int deviceIndex, bool useBlocking
     contextIsValid = true;
     ContextSelector selector(*this);
     CHECK_RESULT(cuCtxSetCacheConfig(CU_FUNC_CACHE_PREFER_SHARED));
+#if CUDA_VERSION >= 11020
+    // If the device supports it, create a memory pool for arrays.  Setting the release threshold
+    // to the maximum value keeps freed memory in the pool instead of returning it to the driver.
+
+    memoryPool = NULL;
+    int poolsSupported = 0;
+    cuDeviceGetAttribute(&poolsSupported, CU_DEVICE_ATTRIBUTE_MEMORY_POOLS_SUPPORTED, device);
+    if (poolsSupported) {
+        CUmemPoolProps props;
+        memset(&props, 0, sizeof(props));
+        props.allocType = CU_MEM_ALLOCATION_TYPE_PINNED;
+        props.handleTypes = CU_MEM_HANDLE_TYPE_NONE;
+        props.location.type = CU_MEM_LOCATION_TYPE_DEVICE;
+        props.location.id = (int) device;
+        if (cuMemPoolCreate(&memoryPool, &props) == CUDA_SUCCESS) {
+            cuuint64_t threshold = ~((cuuint64_t) 0);
+            CHECK_RESULT(cuMemPoolSetAttribute(memoryPool, CU_MEMPOOL_ATTR_RELEASE_THRESHOLD, &threshold));
+            CHECK_RESULT(cuStreamCreate(&memoryStream, CU_STREAM_NON_BLOCKING));
+            CHECK_RESULT(cuEventCreate(&memoryEvent, CU_EVENT_DISABLE_TIMING));
+        }
+        else
+            memoryPool = NULL;
+    }
+#endif
     if (contextIndex > 0 && originalContext == NULL) {
         int canAccess;
         cuDeviceCanAccessPeer(&canAccess, getDevice(), platformData.contexts[0]->getDevice());
         if (canAccess) {
             {
+                // Another Context may already have enabled access between primary contexts.
+
                 ContextSelector selector2(*platformData.contexts[0]);
-                CHECK_RESULT(cuCtxEnablePeerAccess(getContext(), 0));
+                CUresult result = cuCtxEnablePeerAccess(getContext(), 0);
+                if (result != CUDA_ERROR_PEER_ACCESS_ALREADY_ENABLED) {
+                    CHECK_RESULT(result);
+                }
+            }
+            CUresult result = cuCtxEnablePeerAccess(platformData.contexts[0]->getContext(), 0);
+            if (result != CUDA_ERROR_PEER_ACCESS_ALREADY_ENABLED) {
+                CHECK_RESULT(result);
             }
-            CHECK_RESULT(cuCtxEnablePeerAccess(platformData.contexts[0]->getContext(), 0));
+#if CUDA_VERSION >= 11020
+            // Memory from a pool is only accessible to other devices if the pool grants access explicitly.
+
+            CUmemAccessDesc access;
+            access.flags = CU_MEM_ACCESS_FLAGS_PROT_READWRITE;
+            access.location.type = CU_MEM_LOCATION_TYPE_DEVICE;
+            if (memoryPool != NULL) {
+                access.location.id = (int) platformData.contexts[0]->getDevice();
+                CHECK_RESULT(cuMemPoolSetAccess(memoryPool, &access, 1));
+            }
+            if (platformData.contexts[0]->memoryPool != NULL) {
+                access.location.id = (int) getDevice();
+                CHECK_RESULT(cuMemPoolSetAccess(platformData.contexts[0]->memoryPool, &access, 1));
+            }
+#endif
         }
     }
-    defaultQueue = shared_ptr<ComputeQueueImpl>(new CudaQueue(0));
+    if (usePrimaryContext) {
+        // Give each Context its own stream, so Contexts that share the primary context can execute
+        // kernels concurrently.  Linked Contexts use the same stream as the Context they are linked
+        // to, since their work must be ordered with its work.
+
+        if (isLinkedContext)
+            contextStream = originalContext->contextStream;
+        else
+            CHECK_RESULT(cuStreamCreate(&contextStream, CU_STREAM_DEFAULT));
+    }
+    defaultQueue = shared_ptr<ComputeQueueImpl>(new CudaQueue(contextStream));
     currentQueue = defaultQueue;
     numAtoms = system.getNumParticles();
     paddedNumAtoms = TileSize*((numAtoms+TileSize-1)/TileSize);
@@ -363,6 +474,12 @@ CudaContext::CudaContext(const System& system, int deviceIndex, bool useBlocking
 }
 
 CudaContext::~CudaContext() {
+    // Wait for any programs that are still being compiled, since the worker threads refer to this object.
+
+    {
+        unique_lock<mutex> lock(compilationMutex);
+        compilationCondition.wait(lock, [this] () { return numPendingCompilations == 0; });
+    }
     pushAsCurrent();
     for (auto force : forces)
         delete force;
@@ -382,12 +499,37 @@ CudaContext::~CudaContext() {
         delete bonded;
     if (nonbonded != NULL)
         delete nonbonded;
-    if (contextIsValid && !isLinkedContext)
+    if (capturingGraph)
+        abortGraphCapture();
+    for (auto& exec : graphExecs)
+        cuGraphExecDestroy(exec.second);
+    graphQueue.reset();
+    releaseSharedArrays();
+    releaseAllDeviceMemory();
+    if (contextIsValid && !isLinkedContext && !usePrimaryContext)
         cuProfilerStop();
+    if (contextIsValid) {
+        // Unload the modules that are not shared, and the shared ones if no other Context can use them.
+
+        lock_guard<mutex> lock(moduleCacheMutex);
+        for (CUmodule module : privateModules)
+            cuModuleUnload(module);
+        if (usePrimaryContext && !isLinkedContext && --primaryContextUsers[device] == 0)
+            forgetCachedModules(context, true);
+        if (contextStream != 0 && !isLinkedContext)
+            cuStreamDestroy(contextStream);
+    }
     popAsCurrent();
     string errorMessage = "Error deleting Context";
-    if (contextIsValid && !isLinkedContext)
-        cuCtxDestroy(context);
+    if (contextIsValid && !isLinkedContext) {
+        if (usePrimaryContext)
+            cuDevicePrimaryCtxRelease(device);
+        else {
+            lock_guard<mutex> lock(moduleCacheMutex);
+            forgetCachedModules(context, false);
+            cuCtxDestroy(context);
+        }
+    }
     contextIsValid = false;
 }
 
@@ -442,8 +584,23 @@ void CudaContext::initializeContexts() {
     getPlatformData().initializeContexts(system);
 }
 
-FFT3D CudaContext::createFFT(int xsize, int ysize, int zsize, bool realToComplex) {
-    return FFT3D(new CudaFFT3D(*this, xsize, ysize, zsize, realToComplex));
+string CudaContext::getDeviceName() {
+    char deviceName[1000];
+    if (cuDeviceGetName(deviceName, 1000, device) != CUDA_SUCCESS)
+        deviceName[0] = 0;
+    return string(deviceName);
+}
+
+vector<string> CudaContext::getFFTBackends(int xsize, int ysize, int zsize, bool realToComplex) {
+    return {"cuFFT", "VkFFT"};
+}
+
+FFT3D CudaContext::createFFTWithBackend(const string& backend, int xsize, int ysize, int zsize, bool realToComplex) {
+    if (backend == "cuFFT")
+        return FFT3D(new CudaFFT3D(*this, xsize, ysize, zsize, realToComplex));
+    if (backend == "VkFFT")
+        return FFT3D(new CudaVkFFT3D(*this, xsize, ysize, zsize, realToComplex));
+    throw OpenMMException("Unknown FFT implementation: "+backend);
 }
 
 void CudaContext::setAsCurrent() {
@@ -466,8 +623,7 @@ CUmodule CudaContext::createModule(const string source, const char* optimization
     return createModule(source, map<string, string>(), optimizationFlags);
 }
 
-CUmodule CudaContext::createModule(const string source, const map<string, string>& defines, const char* optimizationFlags) {
-    string bits = intToString(8*sizeof(void*));
+CUmodule CudaContext::createModule(const string source, const map<string, string>& defines, const char* optimizationFlags, bool shareable) {
     string options = (optimizationFlags == NULL ? defaultOptimizationOptions : string(optimizationFlags));
     stringstream src;
     if (!options.empty())
@@ -535,22 +691,50 @@ CUmodule CudaContext::createModule(const string source, const map<string, string
 #endif
     string compileArchitecture = intToString(min(gpuArchitecture, maxCompilerArchitecture));
 
-    // See whether we already have PTX for this kernel cached.
-
-    CSHA1 sha1;
-    sha1.Update((const UINT_8*) src.str().c_str(), src.str().size());
-    sha1.Final();
-    UINT_8 hash[20];
-    sha1.GetHash(hash);
-    stringstream cacheFile;
-    cacheFile << cacheDir;
-    cacheFile.flags(ios::hex);
-    for (int i = 0; i < 20; i++)
-        cacheFile << setw(2) << setfill('0') << (int) hash[i];
-    cacheFile << '_' << compileArchitecture << '_' << bits;
+    string moduleSource = src.str();
+    if (!shareable) {
+        CUmodule module = loadModule(moduleSource, options, compileArchitecture);
+        lock_guard<mutex> lock(moduleCacheMutex);
+        privateModules.push_back(module);
+        return module;
+    }
+
+    // Contexts that use the same CUDA context can share modules compiled from identical source.
+
+    pair<CUcontext, string> key = make_pair(context, moduleSource+"\n"+compileArchitecture);
+    {
+        lock_guard<mutex> lock(moduleCacheMutex);
+        auto cached = moduleCache.find(key);
+        if (cached != moduleCache.end())
+            return cached->second;
+    }
+    CUmodule module = loadModule(moduleSource, options, compileArchitecture);
+    lock_guard<mutex> lock(moduleCacheMutex);
+    auto inserted = moduleCache.insert(make_pair(key, module));
+    if (!inserted.second) {
+        // Another thread loaded the same module while we were compiling it.
+
+        cuModuleUnload(module);
+        return inserted.first->second;
+    }
+    return module;
+}
+
+CUmodule CudaContext::loadModule(const string& source, const string& options, const string& compileArchitecture) {
+    string bits = intToString(8*sizeof(void*));
+
+    // See whether we already have PTX for this kernel, either in the cache or among the
+    // prebuilt kernels.
+
+    string key = source+"\n"+compileArchitecture+"_"+bits;
+    string cacheFile = kernelCache.getFileName(key);
+    string existingFile = kernelCache.findFile(key);
     CUmodule module;
-    if (cuModuleLoad(&module, cacheFile.str().c_str()) == CUDA_SUCCESS)
+    if (existingFile.size() > 0 && cuModuleLoad(&module, existingFile.c_str()) == CUDA_SUCCESS) {
+        if (existingFile == cacheFile)
+            kernelCache.recordUse(cacheFile);
         return module;
+    }
 
     // Select a name for the output file.
 
@@ -575,7 +759,7 @@ CUmodule CudaContext::createModule(const string source, const map<string, string
     // Compile the program to PTX.
     
     nvrtcProgram program;
-    CHECK_NVRTC_RESULT(nvrtcCreateProgram(&program, src.str().c_str(), NULL, 0, NULL, NULL), "Error creating program");
+    CHECK_NVRTC_RESULT(nvrtcCreateProgram(&program, source.c_str(), NULL, 0, NULL, NULL), "Error creating program");
     try {
         nvrtcResult result = nvrtcCompileProgram(program, optionsVec.size(), &optionsVec[0]);
         if (result != NVRTC_SUCCESS) {
@@ -622,8 +806,10 @@ CUmodule CudaContext::createModule(const string source, const map<string, string
             m<<"Error loading CUDA module: "<<getErrorString(result)<<" ("<<result<<")";
             throw OpenMMException(m.str());
         }
-        if (rename(outputFile.c_str(), cacheFile.str().c_str()) != 0)
+        if (rename(outputFile.c_str(), cacheFile.c_str()) != 0)
             remove(outputFile.c_str());
+        else
+            kernelCache.recordNewFile(cacheFile);
         return module;
     }
     catch (...) {
@@ -640,9 +826,52 @@ CUfunction CudaContext::getKernel(CUmodule& module, const string& name) {
         m<<"Error creating kernel "<<name<<": "<<getErrorString(result)<<" ("<<result<<")";
         throw OpenMMException(m.str());
     }
+    kernelNames[function] = name;
     return function;
 }
 
+/**
+ * Get the file in the cache directory where a set of tuned parameters is stored.  The name of
+ * the device is included in the hash, so different types of GPUs never share results.
+ */
+static string getTuningFileName(const string& cacheDir, CUdevice device, const string& name) {
+    char deviceName[1000];
+    if (cuDeviceGetName(deviceName, 1000, device) != CUDA_SUCCESS)
+        deviceName[0] = 0;
+    return cacheDir+"openmmTuning_"+KernelCache::getHash(string(deviceName)+"\n"+name);
+}
+
+map<string, double> CudaContext::loadTuningParameters(const string& name) {
+    map<string, double> values;
+    ifstream in(getTuningFileName(cacheDir, device, name).c_str());
+    string key;
+    double value;
+    while (in >> key >> value)
+        values[key] = value;
+    return values;
+}
+
+void CudaContext::saveTuningParameters(const string& name, const map<string, double>& values) {
+    // Write to a temporary file and then rename it, so another process reading the same file
+    // never sees it partially written.
+
+    string fileName = getTuningFileName(cacheDir, device, name);
+    stringstream tempFileName;
+    tempFileName << fileName << "_" << this << "_" << this_thread::get_id();
+    try {
+        ofstream out(tempFileName.str().c_str());
+        out << setprecision(10);
+        for (auto& value : values)
+            out << value.first << " " << value.second << endl;
+        out.close();
+        if (out.fail() || rename(tempFileName.str().c_str(), fileName.c_str()) != 0)
+            remove(tempFileName.str().c_str());
+    }
+    catch (...) {
+        // Ignore.
+    }
+}
+
 vector<ComputeContext*> CudaContext::getAllContexts() {
     vector<ComputeContext*> result;
     for (CudaContext* c : platformData.contexts)
@@ -666,19 +895,219 @@ CudaArray* CudaContext::createArray() {
     return new CudaArray();
 }
 
+void* CudaContext::allocatePinnedMemory(size_t size) {
+    void* memory;
+    CHECK_RESULT2(cuMemHostAlloc(&memory, size, 0), "Error allocating pinned memory");
+    return memory;
+}
+
+void CudaContext::freePinnedMemory(void* memory) {
+    cuMemFreeHost(memory);
+}
+
+CUresult CudaContext::allocateDeviceMemory(CUdeviceptr* pointer, size_t size) {
+    lock_guard<mutex> lock(memoryMutex);
+    CUresult result;
+    bool pooled = false;
+#if CUDA_VERSION >= 11020
+    if (memoryPool != NULL && !capturingGraph) {
+        // Release any memory whose release was deferred while a graph was being captured.
+
+        if (pendingFrees.size() > 0) {
+            cuEventRecord(memoryEvent, getCurrentStream());
+            cuStreamWaitEvent(memoryStream, memoryEvent, 0);
+            for (CUdeviceptr p : pendingFrees)
+                cuMemFreeAsync(p, memoryStream);
+            pendingFrees.clear();
+        }
+
+        // The allocation is ordered on a private stream.  Wait for it to complete, since the memory may
+        // be used immediately by any stream, or by a blocking copy.
+
+        result = cuMemAllocFromPoolAsync(pointer, size, memoryPool, memoryStream);
+        if (result == CUDA_SUCCESS)
+            result = cuStreamSynchronize(memoryStream);
+        pooled = true;
+    }
+    else
+#endif
+        result = cuMemAlloc(pointer, size);
+    if (result == CUDA_SUCCESS) {
+        deviceAllocations[*pointer] = make_pair(size, pooled);
+        allocatedMemory += size;
+        peakAllocatedMemory = max(peakAllocatedMemory, allocatedMemory);
+    }
+    return result;
+}
+
+CUresult CudaContext::freeDeviceMemory(CUdeviceptr pointer) {
+    lock_guard<mutex> lock(memoryMutex);
+    if (deviceMemoryReleased)
+        return CUDA_SUCCESS;
+    auto allocation = deviceAllocations.find(pointer);
+    if (allocation == deviceAllocations.end())
+        return cuMemFree(pointer);
+    allocatedMemory -= allocation->second.first;
+    bool pooled = allocation->second.second;
+    deviceAllocations.erase(allocation);
+#if CUDA_VERSION >= 11020
+    if (pooled) {
+        // The memory may still be in use by work that has been queued but not yet executed.  Have
+        // the private stream wait for it before returning the memory to the pool.  During graph
+        // capture this is not allowed, so the release is deferred.
+
+        if (capturingGraph) {
+            pendingFrees.push_back(pointer);
+            return CUDA_SUCCESS;
+        }
+        CUresult result = cuEventRecord(memoryEvent, getCurrentStream());
+        if (result == CUDA_SUCCESS)
+            result = cuStreamWaitEvent(memoryStream, memoryEvent, 0);
+        if (result == CUDA_SUCCESS)
+            result = cuMemFreeAsync(pointer, memoryStream);
+        return result;
+    }
+#endif
+    return cuMemFree(pointer);
+}
+
+void CudaContext::releaseAllDeviceMemory() {
+    lock_guard<mutex> lock(memoryMutex);
+    if (!contextIsValid)
+        return;
+#if CUDA_VERSION >= 11020
+    if (memoryPool != NULL) {
+        cuEventRecord(memoryEvent, getCurrentStream());
+        cuStreamWaitEvent(memoryStream, memoryEvent, 0);
+        for (CUdeviceptr pointer : pendingFrees)
+            cuMemFreeAsync(pointer, memoryStream);
+        for (auto& allocation : deviceAllocations)
+            if (allocation.second.second)
+                cuMemFreeAsync(allocation.first, memoryStream);
+        cuStreamSynchronize(memoryStream);
+        cuMemPoolTrimTo(memoryPool, 0);
+        cuMemPoolDestroy(memoryPool);
+        cuStreamDestroy(memoryStream);
+        cuEventDestroy(memoryEvent);
+        memoryPool = NULL;
+    }
+#endif
+    for (auto& allocation : deviceAllocations)
+        if (!allocation.second.second)
+            cuMemFree(allocation.first);
+    deviceAllocations.clear();
+    pendingFrees.clear();
+    allocatedMemory = 0;
+    deviceMemoryReleased = true;
+}
+
+void CudaContext::getDeviceMemoryStatistics(size_t& used, size_t& peak, size_t& reserved) {
+    lock_guard<mutex> lock(memoryMutex);
+    used = allocatedMemory;
+    peak = peakAllocatedMemory;
+    reserved = allocatedMemory;
+#if CUDA_VERSION >= 11020
+    if (memoryPool != NULL) {
+        // Add the memory held by the pool for reuse.
+
+        cuuint64_t poolReserved, poolUsed;
+        cuMemPoolGetAttribute(memoryPool, CU_MEMPOOL_ATTR_RESERVED_MEM_CURRENT, &poolReserved);
+        cuMemPoolGetAttribute(memoryPool, CU_MEMPOOL_ATTR_USED_MEM_CURRENT, &poolUsed);
+        if (poolReserved > poolUsed)
+            reserved += (size_t) (poolReserved-poolUsed);
+    }
+#endif
+}
+
 ComputeEvent CudaContext::createEvent() {
     return shared_ptr<ComputeEventImpl>(new CudaEvent(*this));
 }
 
+ComputeEvent CudaContext::createTimingEvent() {
+    return shared_ptr<ComputeEventImpl>(new CudaEvent(*this, true));
+}
+
 ComputeSort CudaContext::createSort(ComputeSortImpl::SortTrait* trait, unsigned int length, bool uniform) {
     return shared_ptr<ComputeSortImpl>(new CudaSort(*this, trait, length, uniform));
 }
 
 ComputeProgram CudaContext::compileProgram(const std::string source, const std::map<std::string, std::string>& defines) {
-    CUmodule module = createModule(CudaKernelSources::vectorOps+source, defines);
+    // Forces typically compile several programs one after another while initializing.  Compiling
+    // them in parallel cuts Context creation time, so each one is handed off to a worker thread.
+    // At most one compilation per CPU thread runs at a time.
+
+    string fullSource = CudaKernelSources::vectorOps+source;
+    {
+        lock_guard<mutex> lock(compilationMutex);
+        numPendingCompilations++;
+    }
+    shared_future<CUmodule> module = async(launch::async, [this, fullSource, defines] () {
+        {
+            unique_lock<mutex> lock(compilationMutex);
+            compilationCondition.wait(lock, [this] () { return numActiveCompilations < max(1, platformData.threads.getNumThreads()); });
+            numActiveCompilations++;
+        }
+        auto finished = [this] () {
+            lock_guard<mutex> lock(compilationMutex);
+            numActiveCompilations--;
+            numPendingCompilations--;
+            compilationCondition.notify_all();
+        };
+        try {
+            ContextSelector selector(*this);
+            CUmodule result = createModule(fullSource, defines);
+            finished();
+            return result;
+        }
+        catch (...) {
+            finished();
+            throw;
+        }
+    }).share();
+    return shared_ptr<ComputeProgramImpl>(new CudaProgram(*this, module));
+}
+
+ComputeProgram CudaContext::compileProgramOnDemand(const std::string source, const std::map<std::string, std::string>& defines) {
+    string fullSource = CudaKernelSources::vectorOps+source;
+    shared_future<CUmodule> module = async(launch::deferred, [this, fullSource, defines] () {
+        ContextSelector selector(*this);
+        return createModule(fullSource, defines);
+    }).share();
+    {
+        lock_guard<mutex> lock(compilationMutex);
+        deferredModules.push_back(module);
+    }
     return shared_ptr<ComputeProgramImpl>(new CudaProgram(*this, module));
 }
 
+void CudaContext::precompileDeferredPrograms() {
+    vector<shared_future<CUmodule> > modules;
+    {
+        lock_guard<mutex> lock(compilationMutex);
+        if (deferredModules.size() == 0)
+            return;
+        modules.swap(deferredModules);
+        numPendingCompilations++;
+    }
+
+    // Waiting on a deferred future compiles the module in the calling thread, unless another thread
+    // has already started it.  Errors are stored in the future and reported when a kernel is used.
+
+    deferredCompilation = async(launch::async, [this, modules] () {
+        {
+            unique_lock<mutex> lock(compilationMutex);
+            compilationCondition.wait(lock, [this] () { return numActiveCompilations < max(1, platformData.threads.getNumThreads()); });
+            numActiveCompilations++;
+        }
+        for (auto& module : modules)
+            module.wait();
+        lock_guard<mutex> lock(compilationMutex);
+        numActiveCompilations--;
+        numPendingCompilations--;
+        compilationCondition.notify_all();
+    });
+}
+
 CudaArray& CudaContext::unwrap(ArrayInterface& array) const {
     CudaArray* cuarray;
     ComputeArray* wrapper = dynamic_cast<ComputeArray*>(&array);
@@ -698,16 +1127,37 @@ std::string CudaContext::getErrorString(CUresult result) {
     return "CUDA error";
 }
 
+void CudaContext::pushAnnotation(const string& name) {
+#ifdef OPENMM_USE_NVTX
+    nvtxRangePushA(name.c_str());
+#endif
+}
+
+void CudaContext::popAnnotation() {
+#ifdef OPENMM_USE_NVTX
+    nvtxRangePop();
+#endif
+}
+
 void CudaContext::executeKernel(CUfunction kernel, void** arguments, int threads, int blockSize, unsigned int sharedSize) {
     if (blockSize == -1)
         blockSize = ThreadBlockSize;
     int gridSize = std::min((threads+blockSize-1)/blockSize, numThreadBlocks);
+    if (getProfilingEnabled())
+        startProfilingInterval();
+    bool annotate = getAnnotationsEnabled();
+    if (annotate)
+        pushAnnotation(kernelNames[kernel]);
     CUresult result = cuLaunchKernel(kernel, gridSize, 1, 1, blockSize, 1, 1, sharedSize, getCurrentStream(), arguments, NULL);
+    if (annotate)
+        popAnnotation();
     if (result != CUDA_SUCCESS) {
         stringstream str;
         str<<"Error invoking kernel: "<<getErrorString(result)<<" ("<<result<<")";
         throw OpenMMException(str.str());
     }
+    if (getProfilingEnabled())
+        endProfilingInterval(kernelNames[kernel]);
 }
 
 int CudaContext::computeThreadBlockSize(double memory) const {
@@ -790,6 +1240,8 @@ double CudaContext::reduceEnergy() {
     int workGroupSize  = 512;
     void* args[] = {&energyBuffer.getDevicePointer(), &energySum.getDevicePointer(), &bufferSize, &workGroupSize};
     executeKernel(reduceEnergyKernel, args, workGroupSize*energySum.getSize(), workGroupSize, workGroupSize*energyBuffer.getElementSize());
+    if (keepEnergyOnDevice)
+        return 0.0;
     energySum.download(pinnedBuffer);
     double result = 0;
     if (getUseDoublePrecision() || getUseMixedPrecision()) {
@@ -833,6 +1285,100 @@ void CudaContext::flushQueue() {
     cuStreamSynchronize(getCurrentStream());
 }
 
+bool CudaContext::beginGraphCapture(const string& key) {
+    if (capturingGraph)
+        abortGraphCapture();
+    if (!platformData.useGraphs)
+        return false;
+    if (graphCaptureSupported == -1)
+        graphCaptureSupported = (platformData.contexts.size() == 1 && !platformData.useCpuPme && getSystemSupportsGraphCapture());
+    if (!graphCaptureSupported)
+        return false;
+
+    // The legacy default stream cannot be captured, so record the work on a separate stream.  It
+    // becomes the default queue while capturing so that code which restores the default queue
+    // (for example, after queueing work on the PME stream) continues to be captured.
+
+    if (graphQueue == NULL)
+        graphQueue = createQueue();
+    CUresult result = cuStreamBeginCapture(dynamic_cast<CudaQueue*>(graphQueue.get())->getStream(), CU_STREAM_CAPTURE_MODE_THREAD_LOCAL);
+    if (result != CUDA_SUCCESS)
+        throw OpenMMException("Error beginning CUDA graph capture: "+getErrorString(result));
+    savedDefaultQueue = defaultQueue;
+    savedCurrentQueue = currentQueue;
+    defaultQueue = graphQueue;
+    currentQueue = graphQueue;
+    graphKey = key;
+    capturingGraph = true;
+    return true;
+}
+
+bool CudaContext::endGraphCapture() {
+    if (!capturingGraph)
+        throw OpenMMException("endGraphCapture() called without a matching call to beginGraphCapture()");
+    CUgraph graph;
+    CUresult result = cuStreamEndCapture(dynamic_cast<CudaQueue*>(graphQueue.get())->getStream(), &graph);
+    defaultQueue = savedDefaultQueue;
+    currentQueue = savedCurrentQueue;
+    savedDefaultQueue.reset();
+    savedCurrentQueue.reset();
+    capturingGraph = false;
+    if (result != CUDA_SUCCESS) {
+        graphCaptureSupported = 0;
+        return false;
+    }
+
+    // Kernel arguments such as random number offsets can change on every step, so the graph is
+    // captured every time.  If it has the same structure as the last one captured with this key,
+    // the cached executable graph is updated in place.  It is only instantiated again when the
+    // structure changes, for example after the neighbor list grows.
+
+    auto exec = graphExecs.find(graphKey);
+    if (exec != graphExecs.end()) {
+#if CUDA_VERSION >= 12000
+        CUgraphExecUpdateResultInfo updateInfo;
+        result = cuGraphExecUpdate(exec->second, graph, &updateInfo);
+#else
+        CUgraphNode errorNode;
+        CUgraphExecUpdateResult updateResult;
+        result = cuGraphExecUpdate(exec->second, graph, &errorNode, &updateResult);
+#endif
+        if (result != CUDA_SUCCESS) {
+            cuGraphExecDestroy(exec->second);
+            graphExecs.erase(exec);
+            exec = graphExecs.end();
+        }
+    }
+    if (exec == graphExecs.end()) {
+        CUgraphExec instance;
+        result = cuGraphInstantiateWithFlags(&instance, graph, 0);
+        if (result != CUDA_SUCCESS) {
+            cuGraphDestroy(graph);
+            graphCaptureSupported = 0;
+            return false;
+        }
+        exec = graphExecs.insert(make_pair(graphKey, instance)).first;
+    }
+    cuGraphDestroy(graph);
+    result = cuGraphLaunch(exec->second, getCurrentStream());
+    if (result != CUDA_SUCCESS) {
+        graphCaptureSupported = 0;
+        return false;
+    }
+    return true;
+}
+
+void CudaContext::abortGraphCapture() {
+    CUgraph graph;
+    if (cuStreamEndCapture(dynamic_cast<CudaQueue*>(graphQueue.get())->getStream(), &graph) == CUDA_SUCCESS)
+        cuGraphDestroy(graph);
+    defaultQueue = savedDefaultQueue;
+    currentQueue = savedCurrentQueue;
+    savedDefaultQueue.reset();
+    savedCurrentQueue.reset();
+    capturingGraph = false;
+}
+
 vector<int> CudaContext::getDevicePrecedence() {
     int numDevices;
     CUdevice thisDevice;
@@ -29,8 +29,11 @@
 
 using namespace OpenMM;
 
-CudaEvent::CudaEvent(CudaContext& context) : context(context), eventCreated(false) {
-    CUresult result = cuEventCreate(&event, context.getEventFlags());
+CudaEvent::CudaEvent(CudaContext& context, bool enableTiming) : context(context), eventCreated(false) {
+    unsigned int flags = context.getEventFlags();
+    if (enableTiming)
+        flags &= ~CU_EVENT_DISABLE_TIMING;
+    CUresult result = cuEventCreate(&event, flags);
     if (result != CUDA_SUCCESS)
         throw OpenMMException("Error creating CUDA event:"+CudaContext::getErrorString(result));
     eventCreated = true;
@@ -52,3 +55,11 @@ void CudaEvent::wait() {
 void CudaEvent::queueWait(ComputeQueue queue) {
     cuStreamWaitEvent(dynamic_cast<CudaQueue*>(queue.get())->getStream(), event, 0);
 }
+
+double CudaEvent::getElapsedTime(ComputeEventImpl& start) {
+    float time;
+    CUresult result = cuEventElapsedTime(&time, dynamic_cast<CudaEvent&>(start).event, event);
+    if (result != CUDA_SUCCESS)
+        throw OpenMMException("Error computing elapsed time between CUDA events: "+CudaContext::getErrorString(result));
+    return time;
+}
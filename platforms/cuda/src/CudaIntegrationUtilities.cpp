@@ -39,7 +39,7 @@ using namespace std;
         throw OpenMMException(m.str());\
     }
 
-CudaIntegrationUtilities::CudaIntegrationUtilities(CudaContext& context, const System& system) : IntegrationUtilities(context, system),
+CudaIntegrationUtilities::CudaIntegrationUtilities(CudaContext& context, const System& system) : IntegrationUtilities(context, system, context.getPlatformData().useLincs),
         ccmaConvergedMemory(NULL) {
         CHECK_RESULT2(cuEventCreate(&ccmaEvent, context.getEventFlags()), "Error creating event for CCMA");
         CHECK_RESULT2(cuMemHostAlloc((void**) &ccmaConvergedMemory, sizeof(int), CU_MEMHOSTALLOC_DEVICEMAP), "Error allocating pinned memory");
@@ -93,7 +93,9 @@ void CudaIntegrationUtilities::applyConstraintsImpl(bool constrainVelocities, do
             shakeKernel->setArg(1, (float) tol);
         shakeKernel->execute(shakeAtoms.getSize());
     }
-    if (ccmaConstraintAtoms.isInitialized()) {
+    if (useLincs && ccmaConstraintAtoms.isInitialized())
+        applyLincs(constrainVelocities);
+    else if (ccmaConstraintAtoms.isInitialized()) {
         if (ccmaConstraintAtoms.getSize() <= 1024) {
             // Use the version of CCMA that runs in a single kernel with one workgroup.
             ccmaFullKernel->setArg(0, (int) constrainVelocities);
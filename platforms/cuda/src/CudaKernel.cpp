@@ -36,13 +36,24 @@ using namespace std;
 CudaKernel::CudaKernel(CudaContext& context, CUfunction kernel, const string& name) : context(context), kernel(kernel), name(name) {
 }
 
+CudaKernel::CudaKernel(CudaContext& context, shared_future<CUmodule> module, const string& name) : context(context), module(module), kernel(NULL), name(name) {
+}
+
+CUfunction CudaKernel::getFunction() const {
+    if (kernel == NULL) {
+        CUmodule compiled = module.get();
+        kernel = context.getKernel(compiled, name);
+    }
+    return kernel;
+}
+
 string CudaKernel::getName() const {
     return name;
 }
 
 int CudaKernel::getMaxBlockSize() const {
     int size;
-    CUresult result = cuFuncGetAttribute(&size, CU_FUNC_ATTRIBUTE_MAX_THREADS_PER_BLOCK, kernel);
+    CUresult result = cuFuncGetAttribute(&size, CU_FUNC_ATTRIBUTE_MAX_THREADS_PER_BLOCK, getFunction());
     if (result != CUDA_SUCCESS)
         throw OpenMMException("Error querying max thread block size: "+context.getErrorString(result));
     return size;
@@ -57,7 +68,7 @@ void CudaKernel::execute(int threads, int blockSize) {
         else
             argPointers[i] = &primitiveArgs[i];
     }
-    context.executeKernel(kernel, argPointers.data(), threads, blockSize);
+    context.executeKernel(getFunction(), argPointers.data(), threads, blockSize);
 }
 
 void CudaKernel::addArrayArg(ArrayInterface& value) {
@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2009-2025 Stanford University and the Authors.      *
+ * Portions copyright (c) 2009-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -31,6 +31,7 @@
 #include "CudaKernelSources.h"
 #include "CudaExpressionUtilities.h"
 #include <algorithm>
+#include <cmath>
 #include <map>
 #include <set>
 #include <utility>
@@ -60,16 +61,26 @@ public:
 };
 
 CudaNonbondedUtilities::CudaNonbondedUtilities(CudaContext& context) : context(context), useCutoff(false), usePeriodic(false), useNeighborList(false), anyExclusions(false), usePadding(true),
-        pinnedCountBuffer(NULL), forceRebuildNeighborList(true), groupFlags(0), canUsePairList(true), tilesAfterReorder(0) {
+        pinnedCountBuffer(NULL), pinnedRebuildFlag(NULL), forceRebuildNeighborList(true), groupFlags(0), canUsePairList(true), tilesAfterReorder(0),
+        padding(0.0), useAdaptivePadding(false), buildTimingPending(false), forceTimingPending(false), lastRebuildWasForced(false), usePairPruning(false),
+        stepsSinceRebuild(0), totalRebuildSteps(0), totalNaturalRebuilds(0), useThreadBlockTuning(false), tuningTimingPending(false), tuningGroups(-1) {
     // Decide how many thread blocks to use.
 
     string errorMessage = "Error initializing nonbonded utilities";
-    int multiprocessors;
     CHECK_RESULT(cuDeviceGetAttribute(&multiprocessors, CU_DEVICE_ATTRIBUTE_MULTIPROCESSOR_COUNT, context.getDevice()));
     CHECK_RESULT(cuEventCreate(&downloadCountEvent, context.getEventFlags()));
     CHECK_RESULT(cuMemHostAlloc((void**) &pinnedCountBuffer, 2*sizeof(unsigned int), CU_MEMHOSTALLOC_PORTABLE));
+    CHECK_RESULT(cuMemHostAlloc((void**) &pinnedRebuildFlag, sizeof(int), CU_MEMHOSTALLOC_PORTABLE));
+    CHECK_RESULT(cuEventCreate(&buildStartEvent, CU_EVENT_DEFAULT));
+    CHECK_RESULT(cuEventCreate(&buildEndEvent, CU_EVENT_DEFAULT));
+    CHECK_RESULT(cuEventCreate(&forceStartEvent, CU_EVENT_DEFAULT));
+    CHECK_RESULT(cuEventCreate(&forceEndEvent, CU_EVENT_DEFAULT));
+    CHECK_RESULT(cuEventCreate(&tuningStartEvent, CU_EVENT_DEFAULT));
+    CHECK_RESULT(cuEventCreate(&tuningEndEvent, CU_EVENT_DEFAULT));
     numForceThreadBlocks = 4*multiprocessors;
     forceThreadBlockSize = (context.getComputeCapability() < 2.0 ? 128 : 256);
+    if (context.getPlatformData().tuneThreadBlocks && context.getComputeCapability() >= 2.0)
+        selectTunedThreadBlocks();
     
     // When building the neighbor list, we can optionally use large blocks (1024 atoms) to
     // accelerate the process.  This makes building the neighbor list faster, but it prevents
@@ -83,7 +94,15 @@ CudaNonbondedUtilities::CudaNonbondedUtilities(CudaContext& context) : context(c
 CudaNonbondedUtilities::~CudaNonbondedUtilities() {
     if (pinnedCountBuffer != NULL)
         cuMemFreeHost(pinnedCountBuffer);
+    if (pinnedRebuildFlag != NULL)
+        cuMemFreeHost(pinnedRebuildFlag);
     cuEventDestroy(downloadCountEvent);
+    cuEventDestroy(buildStartEvent);
+    cuEventDestroy(buildEndEvent);
+    cuEventDestroy(forceStartEvent);
+    cuEventDestroy(forceEndEvent);
+    cuEventDestroy(tuningStartEvent);
+    cuEventDestroy(tuningEndEvent);
 }
 
 void CudaNonbondedUtilities::addInteraction(bool usesCutoff, bool usesPeriodic, bool usesExclusions, double cutoffDistance,
@@ -160,6 +179,10 @@ static bool compareInt2(int2 a, int2 b) {
     return ((a.y < b.y) || (a.y == b.y && a.x < b.x));
 }
 
+static size_t findExclusionTile(const vector<int2>& tiles, int x, int y) {
+    return lower_bound(tiles.begin(), tiles.end(), make_int2(x, y), compareInt2)-tiles.begin();
+}
+
 void CudaNonbondedUtilities::initialize(const System& system) {
     string errorMessage = "Error initializing nonbonded utilities";    
     if (atomExclusions.size() == 0) {
@@ -177,33 +200,30 @@ void CudaNonbondedUtilities::initialize(const System& system) {
     int numContexts = context.getPlatformData().contexts.size();
     setAtomBlockRange(context.getContextIndex()/(double) numContexts, (context.getContextIndex()+1)/(double) numContexts);
 
-    // Build a list of tiles that contain exclusions.
+    // Build a list of tiles that contain exclusions.  Each block of atoms is processed separately so the
+    // list can be built without any per-tile allocations, which matters for very large systems.
 
-    set<pair<int, int> > tilesWithExclusions;
-    for (int atom1 = 0; atom1 < (int) atomExclusions.size(); ++atom1) {
-        int x = atom1/CudaContext::TileSize;
-        for (int j = 0; j < (int) atomExclusions[atom1].size(); ++j) {
-            int atom2 = atomExclusions[atom1][j];
-            int y = atom2/CudaContext::TileSize;
-            tilesWithExclusions.insert(make_pair(max(x, y), min(x, y)));
-        }
-    }
     vector<int2> exclusionTilesVec;
-    for (set<pair<int, int> >::const_iterator iter = tilesWithExclusions.begin(); iter != tilesWithExclusions.end(); ++iter)
-        exclusionTilesVec.push_back(make_int2(iter->first, iter->second));
-    sort(exclusionTilesVec.begin(), exclusionTilesVec.end(), compareInt2);
-    exclusionTiles.initialize<int2>(context, exclusionTilesVec.size(), "exclusionTiles");
-    exclusionTiles.upload(exclusionTilesVec);
-    map<pair<int, int>, int> exclusionTileMap;
-    for (int i = 0; i < (int) exclusionTilesVec.size(); i++) {
-        int2 tile = exclusionTilesVec[i];
-        exclusionTileMap[make_pair(tile.x, tile.y)] = i;
+    vector<int> blocksForTile;
+    for (int x = 0; x < numAtomBlocks; x++) {
+        blocksForTile.clear();
+        int lastAtom = min((x+1)*CudaContext::TileSize, (int) atomExclusions.size());
+        for (int atom1 = x*CudaContext::TileSize; atom1 < lastAtom; ++atom1)
+            for (int atom2 : atomExclusions[atom1])
+                blocksForTile.push_back(atom2/CudaContext::TileSize);
+        sort(blocksForTile.begin(), blocksForTile.end());
+        blocksForTile.erase(unique(blocksForTile.begin(), blocksForTile.end()), blocksForTile.end());
+        for (int y : blocksForTile)
+            exclusionTilesVec.push_back(make_int2(max(x, y), min(x, y)));
     }
+    sort(exclusionTilesVec.begin(), exclusionTilesVec.end(), compareInt2);
+    exclusionTilesVec.erase(unique(exclusionTilesVec.begin(), exclusionTilesVec.end(), [](int2 a, int2 b) { return a.x == b.x && a.y == b.y; }), exclusionTilesVec.end());
+    context.initializeSharedArray(exclusionTiles, exclusionTilesVec, "exclusionTiles");
     vector<vector<int> > exclusionBlocksForBlock(numAtomBlocks);
-    for (set<pair<int, int> >::const_iterator iter = tilesWithExclusions.begin(); iter != tilesWithExclusions.end(); ++iter) {
-        exclusionBlocksForBlock[iter->first].push_back(iter->second);
-        if (iter->first != iter->second)
-            exclusionBlocksForBlock[iter->second].push_back(iter->first);
+    for (int2 tile : exclusionTilesVec) {
+        exclusionBlocksForBlock[tile.x].push_back(tile.y);
+        if (tile.x != tile.y)
+            exclusionBlocksForBlock[tile.y].push_back(tile.x);
     }
     vector<unsigned int> exclusionRowIndicesVec(numAtomBlocks+1, 0);
     vector<unsigned int> exclusionIndicesVec;
@@ -214,16 +234,13 @@ void CudaNonbondedUtilities::initialize(const System& system) {
     maxExclusions = 0;
     for (int i = 0; i < (int) exclusionBlocksForBlock.size(); i++)
         maxExclusions = (maxExclusions > exclusionBlocksForBlock[i].size() ? maxExclusions : exclusionBlocksForBlock[i].size());
-    exclusionIndices.initialize<unsigned int>(context, exclusionIndicesVec.size(), "exclusionIndices");
-    exclusionRowIndices.initialize<unsigned int>(context, exclusionRowIndicesVec.size(), "exclusionRowIndices");
-    exclusionIndices.upload(exclusionIndicesVec);
-    exclusionRowIndices.upload(exclusionRowIndicesVec);
+    context.initializeSharedArray(exclusionIndices, exclusionIndicesVec, "exclusionIndices");
+    context.initializeSharedArray(exclusionRowIndices, exclusionRowIndicesVec, "exclusionRowIndices");
 
     // Record the exclusion data.
 
-    exclusions.initialize<tileflags>(context, tilesWithExclusions.size()*CudaContext::TileSize, "exclusions");
     tileflags allFlags = (tileflags) -1;
-    vector<tileflags> exclusionVec(exclusions.getSize(), allFlags);
+    vector<tileflags> exclusionVec(exclusionTilesVec.size()*CudaContext::TileSize, allFlags);
     for (int atom1 = 0; atom1 < (int) atomExclusions.size(); ++atom1) {
         int x = atom1/CudaContext::TileSize;
         int offset1 = atom1-x*CudaContext::TileSize;
@@ -232,21 +249,42 @@ void CudaNonbondedUtilities::initialize(const System& system) {
             int y = atom2/CudaContext::TileSize;
             int offset2 = atom2-y*CudaContext::TileSize;
             if (x > y) {
-                int index = exclusionTileMap[make_pair(x, y)]*CudaContext::TileSize;
+                size_t index = findExclusionTile(exclusionTilesVec, x, y)*CudaContext::TileSize;
                 exclusionVec[index+offset1] &= allFlags-(1<<offset2);
             }
             else {
-                int index = exclusionTileMap[make_pair(y, x)]*CudaContext::TileSize;
+                size_t index = findExclusionTile(exclusionTilesVec, y, x)*CudaContext::TileSize;
                 exclusionVec[index+offset2] &= allFlags-(1<<offset1);
             }
         }
     }
     atomExclusions.clear(); // We won't use this again, so free the memory it used
-    exclusions.upload(exclusionVec);
+    context.initializeSharedArray(exclusions, exclusionVec, "exclusions");
 
     // Create data structures for the neighbor list.
 
     maxCutoff = getMaxCutoffDistance();
+    useAdaptivePadding = (context.getPlatformData().adaptivePadding && usePadding && useNeighborList);
+    padding = (usePadding ? 0.08*maxCutoff : 0.0);
+    minPadding = 0.02*maxCutoff;
+    maxPadding = padCutoff(maxCutoff)-maxCutoff;
+    rebuildTime = checkTime = forceTime = 0.0;
+    windowSteps = naturalRebuilds = numRebuildTimes = numCheckTimes = numForceTimes = 0;
+    usePairPruning = false;
+    if (useCutoff && useNeighborList) {
+        // Decide whether to record which pairs in each tile interact.  In automatic mode this is done when the
+        // system is sparse enough that a block of atoms is wider than the cutoff, so many steps of each tile
+        // contain no interactions.
+
+        if (context.getPlatformData().pairPruning)
+            usePairPruning = true;
+        else if (context.getPlatformData().autoPairPruning && usePeriodic) {
+            Vec3 a, b, c;
+            system.getDefaultPeriodicBoxVectors(a, b, c);
+            double blockWidth = cbrt(CudaContext::TileSize*a[0]*b[1]*c[2]/numAtoms);
+            usePairPruning = (maxCutoff < blockWidth);
+        }
+    }
     if (useCutoff) {
         // Select a size for the arrays that hold the neighbor list.  We have to make a fairly
         // arbitrary guess, but if this turns out to be too small we'll increase it later.
@@ -258,7 +296,8 @@ void CudaNonbondedUtilities::initialize(const System& system) {
             maxTiles = 1;
         maxSinglePairs = 5*numAtoms;
         interactingTiles.initialize<int>(context, maxTiles, "interactingTiles");
-        interactingAtoms.initialize<int>(context, CudaContext::TileSize*maxTiles, "interactingAtoms");
+        interactingAtoms.initialize<int>(context, CudaContext::TileSize*(size_t) maxTiles, "interactingAtoms");
+        interactingFlags.initialize<unsigned int>(context, usePairPruning ? CudaContext::TileSize*(size_t) maxTiles : 1, "interactingFlags");
         interactionCount.initialize<unsigned int>(context, 2, "interactionCount");
         singlePairs.initialize<int2>(context, maxSinglePairs, "singlePairs");
         int elementSize = (context.getUseDoublePrecision() ? sizeof(double) : sizeof(float));
@@ -302,6 +341,7 @@ void CudaNonbondedUtilities::initialize(const System& system) {
         forceArgs.push_back(&interactingAtoms.getDevicePointer());
         forceArgs.push_back(&maxSinglePairs);
         forceArgs.push_back(&singlePairs.getDevicePointer());
+        forceArgs.push_back(&interactingFlags.getDevicePointer());
     }
     hasInitializedParams = false;
     paramStartIndex = forceArgs.size();
@@ -353,6 +393,7 @@ void CudaNonbondedUtilities::initialize(const System& system) {
         findInteractingBlocksArgs.push_back(&interactingTiles.getDevicePointer());
         findInteractingBlocksArgs.push_back(&interactingAtoms.getDevicePointer());
         findInteractingBlocksArgs.push_back(&singlePairs.getDevicePointer());
+        findInteractingBlocksArgs.push_back(&interactingFlags.getDevicePointer());
         findInteractingBlocksArgs.push_back(&context.getPosq().getDevicePointer());
         findInteractingBlocksArgs.push_back(&maxTiles);
         findInteractingBlocksArgs.push_back(&maxSinglePairs);
@@ -380,7 +421,10 @@ double CudaNonbondedUtilities::getMaxCutoffDistance() {
 }
 
 double CudaNonbondedUtilities::padCutoff(double cutoff) {
-    double padding = (usePadding ? 0.08*cutoff : 0.0);
+    // When the padding is tuned automatically, report the largest value it can ever take.  Other kernels
+    // that build their own lists whenever this one is rebuilt can then rely on them staying valid.
+
+    double padding = (usePadding ? (context.getPlatformData().adaptivePadding ? 0.16 : 0.08)*cutoff : 0.0);
     return cutoff+padding;
 }
 
@@ -398,19 +442,39 @@ void CudaNonbondedUtilities::prepareInteractions(int forceGroups) {
     }
     if (!useNeighborList)
         return;
-    if (numTiles == 0)
+    if (numTiles == 0) {
+        // This context has no tiles to process, but the interaction count may be left over from
+        // before its range of blocks was changed.  Clear it so the interaction kernel skips it.
+
+        if (forceRebuildNeighborList) {
+            context.clearBuffer(interactionCount);
+            forceRebuildNeighborList = false;
+        }
         return;
+    }
 
-    // Compute the neighbor list.
+    // Compute the neighbor list.  If we are tuning the padding or profiling, also measure how long
+    // it takes and record whether it really was rebuilt.
 
+    ComputeContext::Annotation annotation(context, "buildNeighborList");
+    bool measureBuild = ((useAdaptivePadding || context.getProfilingEnabled()) && !context.isCapturingGraph());
+    if (measureBuild)
+        cuEventRecord(buildStartEvent, context.getCurrentStream());
     context.executeKernel(kernels.findBlockBoundsKernel, &findBlockBoundsArgs[0], context.getNumAtomBlocks());
     context.executeKernel(kernels.computeSortKeysKernel, &computeSortKeysArgs[0], context.getNumAtomBlocks());
     blockSorter->sort(sortedBlocks);
     context.executeKernel(kernels.sortBoxDataKernel, &sortBoxDataArgs[0], context.getNumAtoms());
     context.executeKernel(kernels.findInteractingBlocksKernel, &findInteractingBlocksArgs[0], context.getNumAtoms(), 256);
+    if (measureBuild) {
+        cuEventRecord(buildEndEvent, context.getCurrentStream());
+        rebuildNeighborList.download(pinnedRebuildFlag, false);
+        buildTimingPending = true;
+        lastRebuildWasForced = forceRebuildNeighborList;
+    }
     forceRebuildNeighborList = false;
     interactionCount.download(pinnedCountBuffer, false);
-    cuEventRecord(downloadCountEvent, context.getCurrentStream());
+    if (!context.isCapturingGraph())
+        cuEventRecord(downloadCountEvent, context.getCurrentStream());
 }
 
 void CudaNonbondedUtilities::initParamArgs() {
@@ -432,9 +496,39 @@ void CudaNonbondedUtilities::computeInteractions(int forceGroups, bool includeFo
             kernel = createInteractionKernel(kernels.source, parameters, arguments, true, true, forceGroups, includeForces, includeEnergy);
         if (!hasInitializedParams)
             initParamArgs();
+        if (tuningTimingPending)
+            updateThreadBlockTuning();
+        bool measureForces = (useAdaptivePadding && !forceTimingPending && !context.isCapturingGraph());
+        bool measureTuning = (useThreadBlockTuning && !tuningTimingPending && includeForces && !includeEnergy &&
+                !context.isCapturingGraph() && (tuningGroups == -1 || tuningGroups == forceGroups));
+        if (measureForces)
+            cuEventRecord(forceStartEvent, context.getCurrentStream());
+        if (measureTuning) {
+            tuningGroups = forceGroups;
+            cuEventRecord(tuningStartEvent, context.getCurrentStream());
+        }
         context.executeKernel(kernel, &forceArgs[0], numForceThreadBlocks*forceThreadBlockSize, forceThreadBlockSize);
+        if (measureForces) {
+            cuEventRecord(forceEndEvent, context.getCurrentStream());
+            forceTimingPending = true;
+        }
+        if (measureTuning) {
+            cuEventRecord(tuningEndEvent, context.getCurrentStream());
+            tuningTimingPending = true;
+        }
     }
+    if (useNeighborList && numTiles > 0 && !context.isCapturingGraph()) {
+        cuEventSynchronize(downloadCountEvent);
+        updateNeighborListSize();
+        updateRebuildStatistics();
+    }
+}
+
+void CudaNonbondedUtilities::checkNeighborListSizeAfterGraph(int forceGroups) {
+    if ((forceGroups&groupFlags) == 0)
+        return;
     if (useNeighborList && numTiles > 0) {
+        cuEventRecord(downloadCountEvent, context.getCurrentStream());
         cuEventSynchronize(downloadCountEvent);
         updateNeighborListSize();
     }
@@ -456,7 +550,7 @@ bool CudaNonbondedUtilities::updateNeighborListSize() {
     if (pinnedCountBuffer[0] > maxTiles) {
         maxTiles = (unsigned int) (1.2*pinnedCountBuffer[0]);
         unsigned int numBlocks = context.getNumAtomBlocks();
-        int totalTiles = numBlocks*(numBlocks+1)/2;
+        long long totalTiles = numBlocks*((long long) numBlocks+1)/2;
         if (maxTiles > totalTiles)
             maxTiles = totalTiles;
         interactingTiles.resize(maxTiles);
@@ -467,6 +561,12 @@ bool CudaNonbondedUtilities::updateNeighborListSize() {
         if (forceArgs.size() > 0)
             forceArgs[17] = &interactingAtoms.getDevicePointer();
         findInteractingBlocksArgs[7] = &interactingAtoms.getDevicePointer();
+        if (usePairPruning) {
+            interactingFlags.resize(CudaContext::TileSize*(size_t) maxTiles);
+            if (forceArgs.size() > 0)
+                forceArgs[20] = &interactingFlags.getDevicePointer();
+            findInteractingBlocksArgs[9] = &interactingFlags.getDevicePointer();
+        }
     }
     if (pinnedCountBuffer[1] > maxSinglePairs) {
         maxSinglePairs = (unsigned int) (1.2*pinnedCountBuffer[1]);
@@ -480,6 +580,196 @@ bool CudaNonbondedUtilities::updateNeighborListSize() {
     return true;
 }
 
+void CudaNonbondedUtilities::updateRebuildStatistics() {
+    // The force kernel is timed on one step, and the result is read on a later step
+    // once it is known to have finished, so we never need to block.
+
+    if (forceTimingPending && cuEventQuery(forceEndEvent) == CUDA_SUCCESS) {
+        float elapsed;
+        cuEventElapsedTime(&elapsed, forceStartEvent, forceEndEvent);
+        forceTime += elapsed;
+        numForceTimes++;
+        forceTimingPending = false;
+    }
+    if (!buildTimingPending)
+        return;
+    buildTimingPending = false;
+    float elapsed;
+    cuEventElapsedTime(&elapsed, buildStartEvent, buildEndEvent);
+    bool rebuilt = (*pinnedRebuildFlag != 0);
+    if (rebuilt && context.getProfilingEnabled())
+        context.recordProfilingTime("Neighbor list rebuild", 1000.0*elapsed);
+    if (!useAdaptivePadding)
+        return;
+    windowSteps++;
+    stepsSinceRebuild++;
+    if (rebuilt) {
+        if (!lastRebuildWasForced) {
+            // Only rebuilds caused by atoms moving tell us how the padding affects the rebuild frequency.
+
+            naturalRebuilds++;
+            totalNaturalRebuilds++;
+            totalRebuildSteps += stepsSinceRebuild;
+        }
+        stepsSinceRebuild = 0;
+        rebuildTime += elapsed;
+        numRebuildTimes++;
+    }
+    else {
+        checkTime += elapsed;
+        numCheckTimes++;
+    }
+    if (windowSteps >= 200 && numRebuildTimes > 0 && numForceTimes > 0)
+        tunePadding();
+}
+
+void CudaNonbondedUtilities::selectTunedThreadBlocks() {
+    // Results depend on the device, the precision, and the size of the system.  Systems whose
+    // sizes differ by less than a factor of two share the same results.
+
+    string precision = (context.getUseDoublePrecision() ? "double" : (context.getUseMixedPrecision() ? "mixed" : "single"));
+    int sizeBucket = (int) floor(log2((double) max(context.getNumAtoms(), 1)));
+    tuningKey = "nonbonded_"+precision+"_"+context.intToString(sizeBucket);
+    tuningValues = context.loadTuningParameters(tuningKey);
+
+    // The block size is compiled into many kernels, so it cannot change once a Context has been
+    // created.  Each Context measures one size that has not been tried yet.  Once all of them have
+    // been measured, the fastest one is used from then on.
+
+    const int blockSizes[] = {64, 128, 256};
+    if (tuningValues.find("blockSize") != tuningValues.end())
+        forceThreadBlockSize = (int) tuningValues["blockSize"];
+    else {
+        int untested = -1, best = -1;
+        for (int size : blockSizes) {
+            string key = "time"+context.intToString(size);
+            if (tuningValues.find(key) == tuningValues.end()) {
+                if (untested == -1)
+                    untested = size;
+            }
+            else if (best == -1 || tuningValues[key] < tuningValues["time"+context.intToString(best)])
+                best = size;
+        }
+        if (untested != -1)
+            forceThreadBlockSize = untested;
+        else {
+            forceThreadBlockSize = best;
+            tuningValues["blockSize"] = best;
+            context.saveTuningParameters(tuningKey, tuningValues);
+        }
+    }
+    string countKey = "blocksPerSM"+context.intToString(forceThreadBlockSize);
+    if (tuningValues.find(countKey) != tuningValues.end()) {
+        numForceThreadBlocks = max(1, (int) tuningValues[countKey])*multiprocessors;
+        return;
+    }
+
+    // The number of blocks is only a launch parameter, so we can sweep it while the simulation runs.
+    // The candidates are chosen so the number of threads per multiprocessor is the same for every
+    // block size.  This is not possible when using graphs, since kernel launches are captured once
+    // and replayed with the same parameters.
+
+    if (context.getPlatformData().useGraphs)
+        return;
+
+    const int threadsPerSM[] = {256, 512, 768, 1024, 1536, 2048};
+    tuningBlocksPerSM.clear();
+    for (int threads : threadsPerSM)
+        tuningBlocksPerSM.push_back(threads/forceThreadBlockSize);
+    tuningResults.resize(tuningBlocksPerSM.size());
+    tuningCandidate = 0;
+    tuningSamples = 0;
+    numForceThreadBlocks = tuningBlocksPerSM[0]*multiprocessors;
+    useThreadBlockTuning = true;
+}
+
+void CudaNonbondedUtilities::updateThreadBlockTuning() {
+    if (cuEventQuery(tuningEndEvent) != CUDA_SUCCESS)
+        return;
+    tuningTimingPending = false;
+    float elapsed;
+    cuEventElapsedTime(&elapsed, tuningStartEvent, tuningEndEvent);
+
+    // Use the fastest of several samples, so occasional interference from other work on the
+    // device doesn't distort the results.
+
+    const int samplesPerCandidate = 10;
+    if (tuningSamples == 0 || elapsed < tuningBestSample)
+        tuningBestSample = elapsed;
+    if (++tuningSamples < samplesPerCandidate)
+        return;
+    tuningResults[tuningCandidate++] = tuningBestSample;
+    tuningSamples = 0;
+    if (tuningCandidate < (int) tuningBlocksPerSM.size()) {
+        numForceThreadBlocks = tuningBlocksPerSM[tuningCandidate]*multiprocessors;
+        return;
+    }
+
+    // Every candidate has been measured.  Use the fastest one, and save it for future Contexts.
+    // Another Context may have saved results since we loaded them, so merge with what is there now.
+
+    int best = min_element(tuningResults.begin(), tuningResults.end())-tuningResults.begin();
+    numForceThreadBlocks = tuningBlocksPerSM[best]*multiprocessors;
+    useThreadBlockTuning = false;
+    string size = context.intToString(forceThreadBlockSize);
+    map<string, double> values = context.loadTuningParameters(tuningKey);
+    values["blocksPerSM"+size] = tuningBlocksPerSM[best];
+    values["time"+size] = tuningResults[best]/context.getNumAtoms();
+    context.saveTuningParameters(tuningKey, values);
+}
+
+void CudaNonbondedUtilities::tunePadding() {
+    // Rebuilding is triggered once some atom has moved half the padding.  Over the short times between
+    // rebuilds, motion is nearly ballistic, so the number of steps between rebuilds is roughly proportional
+    // to the padding.  The cost of computing interactions scales with the volume inside the padded cutoff.
+    // Choose the padding that minimizes the estimated total cost per step.
+
+    double stepsPerRebuild = windowSteps/(double) max(naturalRebuilds, 1);
+    double stepsPerPadding = stepsPerRebuild/padding;
+    double buildCost = max(0.0, rebuildTime/numRebuildTimes - (numCheckTimes > 0 ? checkTime/numCheckTimes : 0.0));
+    double interactionCost = forceTime/numForceTimes;
+    double bestPadding = padding, bestCost = 0.0;
+    const int numTrials = 30;
+    for (int i = 0; i <= numTrials; i++) {
+        double p = minPadding + i*(maxPadding-minPadding)/numTrials;
+        double scale = (maxCutoff+p)/(maxCutoff+padding);
+        double cost = buildCost/max(1.0, stepsPerPadding*p) + interactionCost*scale*scale*scale;
+        if (i == 0 || cost < bestCost) {
+            bestPadding = p;
+            bestCost = cost;
+        }
+    }
+    rebuildTime = checkTime = forceTime = 0.0;
+    windowSteps = naturalRebuilds = numRebuildTimes = numCheckTimes = numForceTimes = 0;
+    if (fabs(bestPadding-padding) < 0.05*padding)
+        return;
+
+    // A larger padding makes the rebuild criterion looser, so the current list may no longer contain every
+    // interaction.  Rebuild it immediately.
+
+    if (bestPadding > padding)
+        forceRebuildNeighborList = true;
+    padding = bestPadding;
+    tilesAfterReorder = 0;
+    for (auto& kernels : groupKernels)
+        uploadPadding(kernels.second);
+}
+
+void CudaNonbondedUtilities::uploadPadding(KernelSet& kernels) {
+    if (kernels.paddingValues == 0)
+        return;
+    string errorMessage = "Error setting neighbor list padding";
+    double paddedCutoff = maxCutoff+padding;
+    if (context.getUseDoublePrecision()) {
+        double values[] = {padding, paddedCutoff, paddedCutoff*paddedCutoff};
+        CHECK_RESULT(cuMemcpyHtoDAsync(kernels.paddingValues, values, sizeof(values), context.getCurrentStream()));
+    }
+    else {
+        float values[] = {(float) padding, (float) paddedCutoff, (float) (paddedCutoff*paddedCutoff)};
+        CHECK_RESULT(cuMemcpyHtoDAsync(kernels.paddingValues, values, sizeof(values), context.getCurrentStream()));
+    }
+}
+
 void CudaNonbondedUtilities::setUsePadding(bool padding) {
     usePadding = padding;
 }
@@ -505,15 +795,20 @@ void CudaNonbondedUtilities::createKernelsForGroups(int groups) {
     kernels.hasForces = (source.size() > 0);
     kernels.source = source;
     kernels.forceKernel = kernels.energyKernel = kernels.forceEnergyKernel = NULL;
+    kernels.paddingValues = 0;
     if (useCutoff) {
-        double paddedCutoff = padCutoff(maxCutoff);
+        double paddedCutoff = maxCutoff+padding;
         map<string, string> defines;
         defines["TILE_SIZE"] = context.intToString(CudaContext::TileSize);
         defines["NUM_BLOCKS"] = context.intToString(context.getNumAtomBlocks());
         defines["NUM_ATOMS"] = context.intToString(context.getNumAtoms());
-        defines["PADDING"] = context.doubleToString(paddedCutoff-maxCutoff);
-        defines["PADDED_CUTOFF"] = context.doubleToString(paddedCutoff);
-        defines["PADDED_CUTOFF_SQUARED"] = context.doubleToString(paddedCutoff*paddedCutoff);
+        if (useAdaptivePadding)
+            defines["USE_ADAPTIVE_PADDING"] = "1";
+        else {
+            defines["PADDING"] = context.doubleToString(padding);
+            defines["PADDED_CUTOFF"] = context.doubleToString(paddedCutoff);
+            defines["PADDED_CUTOFF_SQUARED"] = context.doubleToString(paddedCutoff*paddedCutoff);
+        }
         defines["NUM_TILES_WITH_EXCLUSIONS"] = context.intToString(exclusionTiles.getSize());
         if (usePeriodic)
             defines["USE_PERIODIC"] = "1";
@@ -523,16 +818,25 @@ void CudaNonbondedUtilities::createKernelsForGroups(int groups) {
             defines["USE_LARGE_BLOCKS"] = "1";
         defines["MAX_EXCLUSIONS"] = context.intToString(maxExclusions);
         defines["MAX_BITS_FOR_PAIRS"] = (canUsePairList ? (context.getComputeCapability() < 8.0 ? "2" : "3") : "0");
+        defines["MAX_PAIRS_IN_SPARSE_TILE"] = context.intToString(4*CudaContext::TileSize);
+        if (usePairPruning)
+            defines["USE_PAIR_PRUNING"] = "1";
         int binShift = 1;
         while (1<<binShift <= context.getNumAtomBlocks())
             binShift++;
         defines["BIN_SHIFT"] = context.intToString(binShift);
         defines["BLOCK_INDEX_MASK"] = context.intToString((1<<binShift)-1);
-        CUmodule interactingBlocksProgram = context.createModule(CudaKernelSources::vectorOps+CudaKernelSources::findInteractingBlocks, defines);
+        CUmodule interactingBlocksProgram = context.createModule(CudaKernelSources::vectorOps+CudaKernelSources::findInteractingBlocks, defines, NULL, !useAdaptivePadding);
         kernels.findBlockBoundsKernel = context.getKernel(interactingBlocksProgram, "findBlockBounds");
         kernels.computeSortKeysKernel = context.getKernel(interactingBlocksProgram, "computeSortKeys");
         kernels.sortBoxDataKernel = context.getKernel(interactingBlocksProgram, "sortBoxData");
         kernels.findInteractingBlocksKernel = context.getKernel(interactingBlocksProgram, "findBlocksWithInteractions");
+        if (useAdaptivePadding) {
+            string errorMessage = "Error creating neighbor list kernels";
+            size_t size;
+            CHECK_RESULT(cuModuleGetGlobal(&kernels.paddingValues, &size, interactingBlocksProgram, "paddingValues"));
+            uploadPadding(kernels);
+        }
     }
     groupKernels[groups] = kernels;
 }
@@ -681,6 +985,8 @@ CUfunction CudaNonbondedUtilities::createInteractionKernel(const string& source,
         defines["USE_SYMMETRIC"] = "1";
     if (useNeighborList)
         defines["USE_NEIGHBOR_LIST"] = "1";
+    if (usePairPruning)
+        defines["USE_PAIR_PRUNING"] = "1";
     defines["ENABLE_SHUFFLE"] = "1";
     if (includeForces)
         defines["INCLUDE_FORCES"] = "1";
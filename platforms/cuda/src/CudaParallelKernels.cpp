@@ -161,10 +161,33 @@ void CudaParallelCalcForcesAndEnergyKernel::initialize(const System& system) {
     int numContexts = data.contexts.size();
     for (int i = 0; i < numContexts; i++)
         getKernel(i).initialize(system);
-    for (int i = 0; i < contextNonbondedFractions.size(); i++) {
-        double x0 = i/(double) contextNonbondedFractions.size();
-        double x1 = (i+1)/(double) contextNonbondedFractions.size();
-        contextNonbondedFractions[i] = x1*x1 - x0*x0;
+
+    // If requested, reserve the first device for reciprocal space PME.  It still computes bonded
+    // interactions, but the direct space nonbonded work is split between the other devices.  Since atoms
+    // are sorted spatially, each device's range of atom blocks corresponds to a compact region of space.
+
+    dedicatedPmeDevice = false;
+    if (data.dedicatedPmeDevice && !data.useCpuPme) {
+        for (int i = 0; i < system.getNumForces(); i++) {
+            const NonbondedForce* nonbonded = dynamic_cast<const NonbondedForce*>(&system.getForce(i));
+            if (nonbonded != NULL && (nonbonded->getNonbondedMethod() == NonbondedForce::PME || nonbonded->getNonbondedMethod() == NonbondedForce::LJPME))
+                dedicatedPmeDevice = true;
+        }
+    }
+    if (dedicatedPmeDevice) {
+        contextNonbondedFractions[0] = 0.0;
+        for (int i = 1; i < numContexts; i++) {
+            double x0 = (i-1)/(double) (numContexts-1);
+            double x1 = i/(double) (numContexts-1);
+            contextNonbondedFractions[i] = x1*x1 - x0*x0;
+        }
+    }
+    else {
+        for (int i = 0; i < numContexts; i++) {
+            double x0 = i/(double) numContexts;
+            double x1 = (i+1)/(double) numContexts;
+            contextNonbondedFractions[i] = x1*x1 - x0*x0;
+        }
     }
     CHECK_RESULT(cuEventCreate(&event, cu.getEventFlags()), "Error creating event");
     peerCopyEvent.resize(numContexts);
@@ -189,6 +212,7 @@ void CudaParallelCalcForcesAndEnergyKernel::beginComputation(ContextImpl& contex
         contextForces.initialize<long long>(cu, 3*(data.contexts.size()-1)*cu.getPaddedNumAtoms(), "contextForces");
         CHECK_RESULT(cuMemHostAlloc((void**) &pinnedForceBuffer, 3*(data.contexts.size()-1)*cu.getPaddedNumAtoms()*sizeof(long long), CU_MEMHOSTALLOC_PORTABLE), "Error allocating pinned memory");
         CHECK_RESULT(cuMemHostAlloc(&pinnedPositionBuffer, cu.getPaddedNumAtoms()*(cu.getUseDoublePrecision() ? sizeof(double4) : sizeof(float4)), CU_MEMHOSTALLOC_PORTABLE), "Error allocating pinned memory");
+        updateNonbondedRanges();
     }
     loadBalance = (cu.getComputeForceCount() < 200 || cu.getComputeForceCount()%30 == 0);
 
@@ -247,8 +271,8 @@ double CudaParallelCalcForcesAndEnergyKernel::finishComputation(ContextImpl& con
         // finished last to the one that finished first.
         
         if (loadBalance) {
-            int firstIndex = 0, lastIndex = 0;
-            for (int i = 0; i < (int) completionTimes.size(); i++) {
+            int firstIndex = (dedicatedPmeDevice ? 1 : 0), lastIndex = firstIndex;
+            for (int i = firstIndex; i < (int) completionTimes.size(); i++) {
                 if (completionTimes[i] < completionTimes[firstIndex])
                     firstIndex = i;
                 if (completionTimes[i] > completionTimes[lastIndex])
@@ -257,19 +281,23 @@ double CudaParallelCalcForcesAndEnergyKernel::finishComputation(ContextImpl& con
             double fractionToTransfer = min(0.01, contextNonbondedFractions[lastIndex]);
             contextNonbondedFractions[firstIndex] += fractionToTransfer;
             contextNonbondedFractions[lastIndex] -= fractionToTransfer;
-            double startFraction = 0.0;
-            for (int i = 0; i < (int) contextNonbondedFractions.size(); i++) {
-                double endFraction = startFraction+contextNonbondedFractions[i];
-                if (i == contextNonbondedFractions.size()-1)
-                    endFraction = 1.0; // Avoid roundoff error
-                data.contexts[i]->getNonbondedUtilities().setAtomBlockRange(startFraction, endFraction);
-                startFraction = endFraction;
-            }
+            updateNonbondedRanges();
 	}
     }
     return energy;
 }
 
+void CudaParallelCalcForcesAndEnergyKernel::updateNonbondedRanges() {
+    double startFraction = 0.0;
+    for (int i = 0; i < (int) contextNonbondedFractions.size(); i++) {
+        double endFraction = startFraction+contextNonbondedFractions[i];
+        if (i == contextNonbondedFractions.size()-1)
+            endFraction = 1.0; // Avoid roundoff error
+        data.contexts[i]->getNonbondedUtilities().setAtomBlockRange(startFraction, endFraction);
+        startFraction = endFraction;
+    }
+}
+
 class CudaParallelCalcNonbondedForceKernel::Task : public CudaContext::WorkTask {
 public:
     Task(ContextImpl& context, CudaCalcNonbondedForceKernel& kernel, bool includeForce,
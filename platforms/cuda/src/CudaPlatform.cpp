@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2008-2025 Stanford University and the Authors.      *
+ * Portions copyright (c) 2008-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -30,6 +30,7 @@
 #include "CudaKernelFactory.h"
 #include "CudaKernels.h"
 #include "openmm/Context.h"
+#include "openmm/common/ContextSelector.h"
 #include "openmm/System.h"
 #include "openmm/internal/ContextImpl.h"
 #include "openmm/internal/hardware.h"
@@ -75,6 +76,7 @@ CudaPlatform::CudaPlatform() {
     registerKernelFactory(UpdateStateDataKernel::Name(), factory);
     registerKernelFactory(ApplyConstraintsKernel::Name(), factory);
     registerKernelFactory(VirtualSitesKernel::Name(), factory);
+    registerKernelFactory(MinimizeKernel::Name(), factory);
     registerKernelFactory(CalcHarmonicBondForceKernel::Name(), factory);
     registerKernelFactory(CalcCustomBondForceKernel::Name(), factory);
     registerKernelFactory(CalcHarmonicAngleForceKernel::Name(), factory);
@@ -100,6 +102,7 @@ CudaPlatform::CudaPlatform() {
     registerKernelFactory(IntegrateVerletStepKernel::Name(), factory);
     registerKernelFactory(IntegrateNoseHooverStepKernel::Name(), factory);
     registerKernelFactory(IntegrateLangevinMiddleStepKernel::Name(), factory);
+    registerKernelFactory(IntegrateMTSLangevinStepKernel::Name(), factory);
     registerKernelFactory(IntegrateBrownianStepKernel::Name(), factory);
     registerKernelFactory(IntegrateVariableVerletStepKernel::Name(), factory);
     registerKernelFactory(IntegrateVariableLangevinStepKernel::Name(), factory);
@@ -107,6 +110,7 @@ CudaPlatform::CudaPlatform() {
     registerKernelFactory(IntegrateDPDStepKernel::Name(), factory);
     registerKernelFactory(ApplyAndersenThermostatKernel::Name(), factory);
     registerKernelFactory(ApplyMonteCarloBarostatKernel::Name(), factory);
+    registerKernelFactory(CalcProtocolWorkKernel::Name(), factory);
     registerKernelFactory(RemoveCMMotionKernel::Name(), factory);
     platformProperties.push_back(CudaDeviceIndex());
     platformProperties.push_back(CudaDeviceName());
@@ -118,6 +122,18 @@ CudaPlatform::CudaPlatform() {
     platformProperties.push_back(CudaHostCompiler());
     platformProperties.push_back(CudaDisablePmeStream());
     platformProperties.push_back(CudaDeterministicForces());
+    platformProperties.push_back(CudaEnableProfiling());
+    platformProperties.push_back(CudaEnableAnnotations());
+    platformProperties.push_back(CudaNonbondedPairPruning());
+    platformProperties.push_back(CudaUseGraphs());
+    platformProperties.push_back(CudaDedicatedPmeDevice());
+    platformProperties.push_back(CudaAdaptiveNeighborListPadding());
+    platformProperties.push_back(CudaTuneThreadBlocks());
+    platformProperties.push_back(CudaCacheDirectory());
+    platformProperties.push_back(CudaConstraintAlgorithm());
+    platformProperties.push_back(CudaDeviceMemoryBudget());
+    platformProperties.push_back(CudaShareParameters());
+    platformProperties.push_back(CudaUsePrimaryContext());
     setPropertyDefaultValue(CudaDeviceIndex(), "");
     setPropertyDefaultValue(CudaDeviceName(), "");
     setPropertyDefaultValue(CudaUseBlockingSync(), "false");
@@ -125,6 +141,18 @@ CudaPlatform::CudaPlatform() {
     setPropertyDefaultValue(CudaUseCpuPme(), "false");
     setPropertyDefaultValue(CudaDisablePmeStream(), "false");
     setPropertyDefaultValue(CudaDeterministicForces(), "false");
+    setPropertyDefaultValue(CudaEnableProfiling(), "false");
+    setPropertyDefaultValue(CudaEnableAnnotations(), "false");
+    setPropertyDefaultValue(CudaNonbondedPairPruning(), "auto");
+    setPropertyDefaultValue(CudaUseGraphs(), "false");
+    setPropertyDefaultValue(CudaDedicatedPmeDevice(), "false");
+    setPropertyDefaultValue(CudaAdaptiveNeighborListPadding(), "false");
+    setPropertyDefaultValue(CudaTuneThreadBlocks(), "false");
+    setPropertyDefaultValue(CudaCacheDirectory(), "");
+    setPropertyDefaultValue(CudaConstraintAlgorithm(), "ccma");
+    setPropertyDefaultValue(CudaDeviceMemoryBudget(), "");
+    setPropertyDefaultValue(CudaShareParameters(), "false");
+    setPropertyDefaultValue(CudaUsePrimaryContext(), "false");
     setPropertyDefaultValue(CudaCompiler(), "");
     setPropertyDefaultValue(CudaHostCompiler(), "");
 #ifdef _MSC_VER
@@ -159,6 +187,72 @@ const string& CudaPlatform::getPropertyValue(const Context& context, const strin
 void CudaPlatform::setPropertyValue(Context& context, const string& property, const string& value) const {
 }
 
+map<string, pair<int, double> > CudaPlatform::getKernelTimings(Context& context) const {
+    ContextImpl& impl = getContextImpl(context);
+    PlatformData* data = reinterpret_cast<PlatformData*>(impl.getPlatformData());
+    data->syncContexts();
+    map<string, pair<int, double> > timings;
+    for (CudaContext* cu : data->contexts) {
+        ContextSelector selector(*cu);
+        for (auto& t : cu->getProfilingTimes()) {
+            timings[t.first].first += t.second.first;
+            timings[t.first].second += t.second.second;
+        }
+    }
+    return timings;
+}
+
+void CudaPlatform::resetKernelTimings(Context& context) const {
+    ContextImpl& impl = getContextImpl(context);
+    PlatformData* data = reinterpret_cast<PlatformData*>(impl.getPlatformData());
+    data->syncContexts();
+    for (CudaContext* cu : data->contexts) {
+        ContextSelector selector(*cu);
+        cu->resetProfilingTimes();
+    }
+}
+
+map<string, map<string, long long> > CudaPlatform::getMemoryUsage(Context& context) const {
+    ContextImpl& impl = getContextImpl(context);
+    PlatformData* data = reinterpret_cast<PlatformData*>(impl.getPlatformData());
+    map<string, map<string, long long> > usage;
+    for (CudaContext* cu : data->contexts)
+        for (auto& owner : cu->getMemoryUsage())
+            for (auto& array : owner.second)
+                usage[owner.first][array.first] += array.second;
+    return usage;
+}
+
+void CudaPlatform::getDeviceArray(Context& context, const string& name, long long& pointer, vector<int>& shape, string& type, int& deviceIndex) const {
+    ContextImpl& impl = getContextImpl(context);
+    PlatformData* data = reinterpret_cast<PlatformData*>(impl.getPlatformData());
+    data->syncContexts();
+    CudaContext& cu = *data->contexts[0];
+    ContextSelector selector(cu);
+    CHECK_RESULT(cuCtxSynchronize(), "Error synchronizing CUDA context");
+    CudaArray* array;
+    int paddedNumAtoms = cu.getPaddedNumAtoms();
+    if (name == "posq" || name == "velm" || (name == "posqCorrection" && cu.getUseMixedPrecision())) {
+        array = (name == "posq" ? &cu.getPosq() : name == "velm" ? &cu.getVelm() : &cu.getPosqCorrection());
+        shape = {paddedNumAtoms, 4};
+        type = "<f"+to_string(array->getElementSize()/4);
+    }
+    else if (name == "force") {
+        array = &cu.getForce();
+        shape = {3, paddedNumAtoms};
+        type = "<i8";
+    }
+    else if (name == "atomIndex") {
+        array = &cu.getAtomIndexArray();
+        shape = {paddedNumAtoms};
+        type = "<i4";
+    }
+    else
+        throw OpenMMException("getDeviceArray: Unknown array name '"+name+"'");
+    pointer = (long long) array->getDevicePointer();
+    deviceIndex = cu.getDeviceIndex();
+}
+
 void CudaPlatform::contextCreated(ContextImpl& context, const map<string, string>& properties) const {
     const string& devicePropValue = (properties.find(CudaDeviceIndex()) == properties.end() ?
             getPropertyDefaultValue(CudaDeviceIndex()) : properties.find(CudaDeviceIndex())->second);
@@ -174,11 +268,45 @@ void CudaPlatform::contextCreated(ContextImpl& context, const map<string, string
             getPropertyDefaultValue(CudaDisablePmeStream()) : properties.find(CudaDisablePmeStream())->second);
     string deterministicForcesValue = (properties.find(CudaDeterministicForces()) == properties.end() ?
             getPropertyDefaultValue(CudaDeterministicForces()) : properties.find(CudaDeterministicForces())->second);
+    string profilingPropValue = (properties.find(CudaEnableProfiling()) == properties.end() ?
+            getPropertyDefaultValue(CudaEnableProfiling()) : properties.find(CudaEnableProfiling())->second);
+    string annotationsPropValue = (properties.find(CudaEnableAnnotations()) == properties.end() ?
+            getPropertyDefaultValue(CudaEnableAnnotations()) : properties.find(CudaEnableAnnotations())->second);
+    string pairPruningPropValue = (properties.find(CudaNonbondedPairPruning()) == properties.end() ?
+            getPropertyDefaultValue(CudaNonbondedPairPruning()) : properties.find(CudaNonbondedPairPruning())->second);
+    string graphsPropValue = (properties.find(CudaUseGraphs()) == properties.end() ?
+            getPropertyDefaultValue(CudaUseGraphs()) : properties.find(CudaUseGraphs())->second);
+    string dedicatedPmePropValue = (properties.find(CudaDedicatedPmeDevice()) == properties.end() ?
+            getPropertyDefaultValue(CudaDedicatedPmeDevice()) : properties.find(CudaDedicatedPmeDevice())->second);
+    string adaptivePaddingPropValue = (properties.find(CudaAdaptiveNeighborListPadding()) == properties.end() ?
+            getPropertyDefaultValue(CudaAdaptiveNeighborListPadding()) : properties.find(CudaAdaptiveNeighborListPadding())->second);
+    string tuneThreadBlocksPropValue = (properties.find(CudaTuneThreadBlocks()) == properties.end() ?
+            getPropertyDefaultValue(CudaTuneThreadBlocks()) : properties.find(CudaTuneThreadBlocks())->second);
+    const string& cacheDirPropValue = (properties.find(CudaCacheDirectory()) == properties.end() ?
+            getPropertyDefaultValue(CudaCacheDirectory()) : properties.find(CudaCacheDirectory())->second);
+    string constraintAlgorithmPropValue = (properties.find(CudaConstraintAlgorithm()) == properties.end() ?
+            getPropertyDefaultValue(CudaConstraintAlgorithm()) : properties.find(CudaConstraintAlgorithm())->second);
+    transform(constraintAlgorithmPropValue.begin(), constraintAlgorithmPropValue.end(), constraintAlgorithmPropValue.begin(), ::tolower);
+    const string& memoryBudgetPropValue = (properties.find(CudaDeviceMemoryBudget()) == properties.end() ?
+            getPropertyDefaultValue(CudaDeviceMemoryBudget()) : properties.find(CudaDeviceMemoryBudget())->second);
+    string shareParametersPropValue = (properties.find(CudaShareParameters()) == properties.end() ?
+            getPropertyDefaultValue(CudaShareParameters()) : properties.find(CudaShareParameters())->second);
+    transform(shareParametersPropValue.begin(), shareParametersPropValue.end(), shareParametersPropValue.begin(), ::tolower);
+    string primaryContextPropValue = (properties.find(CudaUsePrimaryContext()) == properties.end() ?
+            getPropertyDefaultValue(CudaUsePrimaryContext()) : properties.find(CudaUsePrimaryContext())->second);
+    transform(primaryContextPropValue.begin(), primaryContextPropValue.end(), primaryContextPropValue.begin(), ::tolower);
     transform(blockingPropValue.begin(), blockingPropValue.end(), blockingPropValue.begin(), ::tolower);
     transform(precisionPropValue.begin(), precisionPropValue.end(), precisionPropValue.begin(), ::tolower);
     transform(cpuPmePropValue.begin(), cpuPmePropValue.end(), cpuPmePropValue.begin(), ::tolower);
     transform(pmeStreamPropValue.begin(), pmeStreamPropValue.end(), pmeStreamPropValue.begin(), ::tolower);
     transform(deterministicForcesValue.begin(), deterministicForcesValue.end(), deterministicForcesValue.begin(), ::tolower);
+    transform(profilingPropValue.begin(), profilingPropValue.end(), profilingPropValue.begin(), ::tolower);
+    transform(annotationsPropValue.begin(), annotationsPropValue.end(), annotationsPropValue.begin(), ::tolower);
+    transform(pairPruningPropValue.begin(), pairPruningPropValue.end(), pairPruningPropValue.begin(), ::tolower);
+    transform(graphsPropValue.begin(), graphsPropValue.end(), graphsPropValue.begin(), ::tolower);
+    transform(dedicatedPmePropValue.begin(), dedicatedPmePropValue.end(), dedicatedPmePropValue.begin(), ::tolower);
+    transform(adaptivePaddingPropValue.begin(), adaptivePaddingPropValue.end(), adaptivePaddingPropValue.begin(), ::tolower);
+    transform(tuneThreadBlocksPropValue.begin(), tuneThreadBlocksPropValue.end(), tuneThreadBlocksPropValue.begin(), ::tolower);
     vector<string> pmeKernelName;
     pmeKernelName.push_back(CalcPmeReciprocalForceKernel::Name());
     if (!supportsKernels(pmeKernelName))
@@ -188,7 +316,7 @@ void CudaPlatform::contextCreated(ContextImpl& context, const map<string, string
     if (threadsEnv != NULL)
         stringstream(threadsEnv) >> threads;
     context.setPlatformData(new PlatformData(&context, context.getSystem(), devicePropValue, blockingPropValue, precisionPropValue, cpuPmePropValue, tempPropValue,
-            pmeStreamPropValue, deterministicForcesValue, threads, NULL));
+            pmeStreamPropValue, deterministicForcesValue, profilingPropValue, graphsPropValue, dedicatedPmePropValue, adaptivePaddingPropValue, tuneThreadBlocksPropValue, memoryBudgetPropValue, shareParametersPropValue, primaryContextPropValue, annotationsPropValue, pairPruningPropValue, constraintAlgorithmPropValue, cacheDirPropValue, threads, NULL));
 }
 
 void CudaPlatform::linkedContextCreated(ContextImpl& context, ContextImpl& originalContext) const {
@@ -200,9 +328,21 @@ void CudaPlatform::linkedContextCreated(ContextImpl& context, ContextImpl& origi
     string tempPropValue = platform.getPropertyValue(originalContext.getOwner(), CudaTempDirectory());
     string pmeStreamPropValue = platform.getPropertyValue(originalContext.getOwner(), CudaDisablePmeStream());
     string deterministicForcesValue = platform.getPropertyValue(originalContext.getOwner(), CudaDeterministicForces());
+    string profilingPropValue = platform.getPropertyValue(originalContext.getOwner(), CudaEnableProfiling());
+    string annotationsPropValue = platform.getPropertyValue(originalContext.getOwner(), CudaEnableAnnotations());
+    string pairPruningPropValue = platform.getPropertyValue(originalContext.getOwner(), CudaNonbondedPairPruning());
+    string graphsPropValue = platform.getPropertyValue(originalContext.getOwner(), CudaUseGraphs());
+    string dedicatedPmePropValue = platform.getPropertyValue(originalContext.getOwner(), CudaDedicatedPmeDevice());
+    string adaptivePaddingPropValue = platform.getPropertyValue(originalContext.getOwner(), CudaAdaptiveNeighborListPadding());
+    string tuneThreadBlocksPropValue = platform.getPropertyValue(originalContext.getOwner(), CudaTuneThreadBlocks());
+    string cacheDirPropValue = platform.getPropertyValue(originalContext.getOwner(), CudaCacheDirectory());
+    string constraintAlgorithmPropValue = platform.getPropertyValue(originalContext.getOwner(), CudaConstraintAlgorithm());
+    string memoryBudgetPropValue = platform.getPropertyValue(originalContext.getOwner(), CudaDeviceMemoryBudget());
+    string shareParametersPropValue = platform.getPropertyValue(originalContext.getOwner(), CudaShareParameters());
+    string primaryContextPropValue = platform.getPropertyValue(originalContext.getOwner(), CudaUsePrimaryContext());
     int threads = reinterpret_cast<PlatformData*>(originalContext.getPlatformData())->threads.getNumThreads();
     context.setPlatformData(new PlatformData(&context, context.getSystem(), devicePropValue, blockingPropValue, precisionPropValue, cpuPmePropValue, tempPropValue,
-            pmeStreamPropValue, deterministicForcesValue, threads, &originalContext));
+            pmeStreamPropValue, deterministicForcesValue, profilingPropValue, graphsPropValue, dedicatedPmePropValue, adaptivePaddingPropValue, tuneThreadBlocksPropValue, memoryBudgetPropValue, shareParametersPropValue, primaryContextPropValue, annotationsPropValue, pairPruningPropValue, constraintAlgorithmPropValue, cacheDirPropValue, threads, &originalContext));
 }
 
 void CudaPlatform::contextDestroyed(ContextImpl& context) const {
@@ -212,8 +352,22 @@ void CudaPlatform::contextDestroyed(ContextImpl& context) const {
 
 CudaPlatform::PlatformData::PlatformData(ContextImpl* context, const System& system, const string& deviceIndexProperty, const string& blockingProperty, const string& precisionProperty,
             const string& cpuPmeProperty, const string& tempProperty, const string& pmeStreamProperty, const string& deterministicForcesProperty,
-            int numThreads, ContextImpl* originalContext) : context(context), removeCM(false), stepCount(0), computeForceCount(0), time(0.0),
-                hasInitializedContexts(false), threads(numThreads) {
+            const string& profilingProperty, const string& graphsProperty,
+            const string& dedicatedPmeProperty, const string& adaptivePaddingProperty, const string& tuneThreadBlocksProperty, const string& memoryBudgetProperty, const string& shareParametersProperty, const string& primaryContextProperty, const string& annotationsProperty, const string& pairPruningProperty, const string& constraintAlgorithmProperty, const string& cacheDirProperty, int numThreads, ContextImpl* originalContext) : context(context), removeCM(false), stepCount(0), computeForceCount(0), time(0.0),
+                hasInitializedContexts(false), cacheDirectory(cacheDirProperty), threads(numThreads) {
+    memoryBudget = 0;
+    if (memoryBudgetProperty.size() > 0) {
+        double megabytes;
+        stringstream budgetStream(memoryBudgetProperty);
+        if (!(budgetStream >> megabytes) || megabytes < 0)
+            throw OpenMMException("Illegal value for DeviceMemoryBudget: "+memoryBudgetProperty);
+        memoryBudget = (long long) (megabytes*1048576.0);
+    }
+    if (constraintAlgorithmProperty != "ccma" && constraintAlgorithmProperty != "lincs")
+        throw OpenMMException("Illegal value for ConstraintAlgorithm: "+constraintAlgorithmProperty);
+    useLincs = (constraintAlgorithmProperty == "lincs");
+    shareParameters = (shareParametersProperty == "true");
+    usePrimaryContext = (primaryContextProperty == "true");
     bool blocking = (blockingProperty == "true");
     vector<string> devices;
     size_t searchPos = 0, nextPos;
@@ -257,6 +411,20 @@ CudaPlatform::PlatformData::PlatformData(ContextImpl* context, const System& sys
     useCpuPme = (cpuPmeProperty == "true" && !contexts[0]->getUseDoublePrecision());
     disablePmeStream = (pmeStreamProperty == "true");
     deterministicForces = (deterministicForcesProperty == "true");
+    enableProfiling = (profilingProperty == "true");
+    enableAnnotations = (annotationsProperty == "true");
+    useGraphs = (graphsProperty == "true");
+    dedicatedPmeDevice = (dedicatedPmeProperty == "true" && contexts.size() > 1);
+    adaptivePadding = (adaptivePaddingProperty == "true");
+    tuneThreadBlocks = (tuneThreadBlocksProperty == "true");
+    if (pairPruningProperty != "true" && pairPruningProperty != "false" && pairPruningProperty != "auto")
+        throw OpenMMException("Illegal value for NonbondedPairPruning: "+pairPruningProperty);
+    pairPruning = (pairPruningProperty == "true");
+    autoPairPruning = (pairPruningProperty == "auto");
+    for (CudaContext* cu : contexts) {
+        cu->setProfilingEnabled(enableProfiling);
+        cu->setAnnotationsEnabled(enableAnnotations);
+    }
     propertyValues[CudaPlatform::CudaDeviceIndex()] = deviceIndex.str();
     propertyValues[CudaPlatform::CudaDeviceName()] = deviceName.str();
     propertyValues[CudaPlatform::CudaUseBlockingSync()] = blocking ? "true" : "false";
@@ -267,6 +435,18 @@ CudaPlatform::PlatformData::PlatformData(ContextImpl* context, const System& sys
     propertyValues[CudaPlatform::CudaHostCompiler()] = "";
     propertyValues[CudaPlatform::CudaDisablePmeStream()] = disablePmeStream ? "true" : "false";
     propertyValues[CudaPlatform::CudaDeterministicForces()] = deterministicForces ? "true" : "false";
+    propertyValues[CudaPlatform::CudaEnableProfiling()] = enableProfiling ? "true" : "false";
+    propertyValues[CudaPlatform::CudaEnableAnnotations()] = enableAnnotations ? "true" : "false";
+    propertyValues[CudaPlatform::CudaNonbondedPairPruning()] = pairPruningProperty;
+    propertyValues[CudaPlatform::CudaUseGraphs()] = useGraphs ? "true" : "false";
+    propertyValues[CudaPlatform::CudaDedicatedPmeDevice()] = dedicatedPmeDevice ? "true" : "false";
+    propertyValues[CudaPlatform::CudaAdaptiveNeighborListPadding()] = adaptivePadding ? "true" : "false";
+    propertyValues[CudaPlatform::CudaTuneThreadBlocks()] = tuneThreadBlocks ? "true" : "false";
+    propertyValues[CudaPlatform::CudaCacheDirectory()] = cacheDirProperty;
+    propertyValues[CudaPlatform::CudaConstraintAlgorithm()] = constraintAlgorithmProperty;
+    propertyValues[CudaPlatform::CudaDeviceMemoryBudget()] = memoryBudgetProperty;
+    propertyValues[CudaPlatform::CudaShareParameters()] = shareParameters ? "true" : "false";
+    propertyValues[CudaPlatform::CudaUsePrimaryContext()] = usePrimaryContext ? "true" : "false";
     contextEnergy.resize(contexts.size());
     
     // Determine whether peer-to-peer copying is supported, and enable it if so.
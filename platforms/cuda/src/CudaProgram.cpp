@@ -30,10 +30,15 @@
 using namespace OpenMM;
 using namespace std;
 
-CudaProgram::CudaProgram(CudaContext& context, CUmodule module) : context(context), module(module) {
+CudaProgram::CudaProgram(CudaContext& context, CUmodule module) : context(context) {
+    promise<CUmodule> result;
+    result.set_value(module);
+    this->module = result.get_future().share();
+}
+
+CudaProgram::CudaProgram(CudaContext& context, shared_future<CUmodule> module) : context(context), module(module) {
 }
 
 ComputeKernel CudaProgram::createKernel(const string& name) {
-    CUfunction kernel = context.getKernel(module, name.c_str());
-    return shared_ptr<ComputeKernelImpl>(new CudaKernel(context, kernel, name));
+    return shared_ptr<ComputeKernelImpl>(new CudaKernel(context, module, name));
 }
\ No newline at end of file
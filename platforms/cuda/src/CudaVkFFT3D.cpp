@@ -0,0 +1,128 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2009-2025 Stanford University and the Authors.      *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "CudaVkFFT3D.h"
+#include "CudaContext.h"
+
+using namespace OpenMM;
+using namespace std;
+
+CudaVkFFT3D::CudaVkFFT3D(CudaContext& context, int xsize, int ysize, int zsize, bool realToComplex) : context(context),
+        app(NULL), convolutionApp(NULL), convolutionStatus(0) {
+    device = context.getDevice();
+    size_t valueSize = context.getUseDoublePrecision() ? sizeof(double) : sizeof(float);
+    inputBufferSize = zsize * ysize * xsize * valueSize;
+    if (realToComplex)
+        outputBufferSize = (zsize/2 + 1) * ysize * xsize * valueSize * 2;
+    else
+        outputBufferSize = zsize * ysize * xsize * valueSize;
+
+    configuration = {};
+    configuration.performR2C = realToComplex;
+    configuration.device = &device;
+    configuration.num_streams = 1;
+    configuration.stream = &stream;
+    configuration.doublePrecision = context.getUseDoublePrecision();
+
+    configuration.FFTdim = 3;
+    configuration.size[0] = zsize;
+    configuration.size[1] = ysize;
+    configuration.size[2] = xsize;
+
+    configuration.inverseReturnToInputBuffer = true;
+    configuration.isInputFormatted = true;
+    configuration.inputBufferSize = &inputBufferSize;
+    configuration.inputBuffer = &inputBuffer;
+    configuration.inputBufferStride[0] = zsize;
+    configuration.inputBufferStride[1] = configuration.inputBufferStride[0] * ysize;
+    configuration.inputBufferStride[2] = configuration.inputBufferStride[1] * xsize;
+
+    configuration.bufferSize = &outputBufferSize;
+    configuration.buffer = &outputBuffer;
+    configuration.bufferStride[0] = realToComplex ? (zsize/2 + 1) : zsize;
+    configuration.bufferStride[1] = configuration.bufferStride[0] * ysize;
+    configuration.bufferStride[2] = configuration.bufferStride[1] * xsize;
+
+    app = new VkFFTApplication();
+    VkFFTResult fftResult = initializeVkFFT(app, configuration);
+    if (fftResult != VKFFT_SUCCESS) {
+        delete app;
+        throw OpenMMException("Error executing initializeVkFFT: "+context.intToString(fftResult));
+    }
+}
+
+CudaVkFFT3D::~CudaVkFFT3D() {
+    deleteVkFFT(app);
+    delete app;
+    if (convolutionApp != NULL) {
+        if (convolutionStatus == 1)
+            deleteVkFFT(convolutionApp);
+        delete convolutionApp;
+    }
+}
+
+void CudaVkFFT3D::execFFT(ArrayInterface& in, ArrayInterface& out, bool forward) {
+    if (forward) {
+        inputBuffer = (void*) context.unwrap(in).getDevicePointer();
+        outputBuffer = (void*) context.unwrap(out).getDevicePointer();
+    }
+    else {
+        inputBuffer = (void*) context.unwrap(out).getDevicePointer();
+        outputBuffer = (void*) context.unwrap(in).getDevicePointer();
+    }
+    stream = context.getCurrentStream();
+    VkFFTResult fftResult = VkFFTAppend(app, forward ? -1 : 1, NULL);
+    if (fftResult != VKFFT_SUCCESS)
+        throw OpenMMException("Error executing VkFFTAppend: "+context.intToString(fftResult));
+}
+
+bool CudaVkFFT3D::supportsConvolution() {
+    if (convolutionStatus == 0) {
+        // Create a second application that multiplies by the kernel between the forward and
+        // inverse transforms.  If VkFFT cannot do it for this size, fall back to separate kernels.
+
+        VkFFTConfiguration convolutionConfig = configuration;
+        convolutionConfig.performConvolution = 1;
+        convolutionConfig.coordinateFeatures = 1;
+        convolutionConfig.kernelSize = &outputBufferSize;
+        convolutionConfig.kernel = &kernelBuffer;
+        convolutionApp = new VkFFTApplication();
+        convolutionStatus = (initializeVkFFT(convolutionApp, convolutionConfig) == VKFFT_SUCCESS ? 1 : -1);
+    }
+    return (convolutionStatus == 1);
+}
+
+void CudaVkFFT3D::execConvolution(ArrayInterface& in, ArrayInterface& out, ArrayInterface& kernel) {
+    if (!supportsConvolution())
+        throw OpenMMException("This FFT does not support convolution");
+    inputBuffer = (void*) context.unwrap(in).getDevicePointer();
+    outputBuffer = (void*) context.unwrap(out).getDevicePointer();
+    kernelBuffer = (void*) context.unwrap(kernel).getDevicePointer();
+    stream = context.getCurrentStream();
+    VkFFTResult fftResult = VkFFTAppend(convolutionApp, -1, NULL);
+    if (fftResult != VKFFT_SUCCESS)
+        throw OpenMMException("Error executing VkFFTAppend: "+context.intToString(fftResult));
+}
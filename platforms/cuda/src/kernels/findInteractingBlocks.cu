@@ -1,6 +1,17 @@
 #define GROUP_SIZE 256
 #define BUFFER_SIZE 256
 
+#ifdef USE_ADAPTIVE_PADDING
+/**
+ * When the padding is tuned as the simulation runs, it is stored in constant memory instead of
+ * being compiled in.  The elements are the padding, the padded cutoff, and its square.
+ */
+__constant__ real paddingValues[3];
+#define PADDING paddingValues[0]
+#define PADDED_CUTOFF paddingValues[1]
+#define PADDED_CUTOFF_SQUARED paddingValues[2]
+#endif
+
 /**
  * To use half precision, we're supposed to include cuda_fp16.h.  Unfortunately,
  * it isn't included in the search path automatically, and there's no reliable
@@ -184,15 +195,16 @@ extern "C" __global__ void sortBoxData(const unsigned int* __restrict__ sortedBl
     }
 }
 
-__device__ int saveSinglePairs(int x, int* atoms, int* flags, int length, unsigned int maxSinglePairs, unsigned int* singlePairCount, int2* singlePairs, int* sumBuffer, volatile unsigned int& pairStartIndex) {
-    // Record interactions that should be computed as single pairs rather than in blocks.
+__device__ int saveSinglePairs(int x, int* atoms, int* flags, int length, unsigned int maxSinglePairs, unsigned int* singlePairCount, int2* singlePairs, int* sumBuffer, volatile unsigned int& pairStartIndex, int maxBits) {
+    // Record interactions that should be computed as single pairs rather than in blocks.  Any atom
+    // that interacts with at most maxBits atoms of block x is moved to the single pair list.
     
     const int indexInWarp = threadIdx.x%32;
     int sum = 0;
     #pragma unroll 8 // (GROUP_SIZE / TILE_SIZE)
     for (int i = indexInWarp; i < length; i += 32) {
         int count = __popc(flags[i]);
-        sum += (count <= MAX_BITS_FOR_PAIRS ? count : 0);
+        sum += (count <= maxBits ? count : 0);
     }
     for (int i = 1; i < 32; i *= 2) {
         int n = __shfl_up_sync(0xffffffff, sum, i);
@@ -206,7 +218,7 @@ __device__ int saveSinglePairs(int x, int* atoms, int* flags, int length, unsign
     unsigned int pairIndex = pairStartIndex + (indexInWarp > 0 ? prevSum : 0);
     for (int i = indexInWarp; i < length; i += 32) {
         int count = __popc(flags[i]);
-        if (count <= MAX_BITS_FOR_PAIRS && pairIndex+count <= maxSinglePairs) {
+        if (count <= maxBits && pairIndex+count <= maxSinglePairs) {
             int f = flags[i];
             while (f != 0) {
                 singlePairs[pairIndex] = make_int2(atoms[i], x*TILE_SIZE+__ffs(f)-1);
@@ -224,7 +236,7 @@ __device__ int saveSinglePairs(int x, int* atoms, int* flags, int length, unsign
         int i = start+indexInWarp;
         int atom = atoms[i];
         int flag = flags[i];
-        bool include = (i < length && __popc(flags[i]) > MAX_BITS_FOR_PAIRS);
+        bool include = (i < length && __popc(flags[i]) > maxBits);
         int includeFlags = BALLOT(include);
         if (include) {
             int index = numCompacted+__popc(includeFlags&warpMask);
@@ -265,6 +277,8 @@ __device__ int saveSinglePairs(int x, int* atoms, int* flags, int length, unsign
  * [out] interactionCount      - total number of tiles that have interactions
  * [out] interactingTiles      - set of blocks that have interactions
  * [out] interactingAtoms      - a list of atoms that interact with each atom block
+ * [out] interactingFlags      - for each atom in interactingAtoms, a mask of the atoms in block X it interacts with
+ *                               (only recorded when USE_PAIR_PRUNING is defined)
  * [in] posq                   - x,y,z coordinates of each atom and charge q
  * [in] maxTiles               - maximum number of tiles to process, used for multi-GPUs
  * [in] startBlockIndex        - first block to process, used for multi-GPUs,
@@ -287,7 +301,7 @@ __device__ int saveSinglePairs(int x, int* atoms, int* flags, int length, unsign
  */
 extern "C" __global__ __launch_bounds__(GROUP_SIZE,3) void findBlocksWithInteractions(real4 periodicBoxSize, real4 invPeriodicBoxSize, real4 periodicBoxVecX, real4 periodicBoxVecY, real4 periodicBoxVecZ,
         unsigned int* __restrict__ interactionCount, int* __restrict__ interactingTiles, unsigned int* __restrict__ interactingAtoms,
-        int2* __restrict__ singlePairs, const real4* __restrict__ posq, unsigned int maxTiles, unsigned int maxSinglePairs, unsigned int startBlockIndex,
+        int2* __restrict__ singlePairs, unsigned int* __restrict__ interactingFlags, const real4* __restrict__ posq, unsigned int maxTiles, unsigned int maxSinglePairs, unsigned int startBlockIndex,
         unsigned int numBlocks, unsigned int* __restrict__ sortedBlocks, const real4* __restrict__ sortedBlockCenter, const half3* __restrict__ sortedBlockBoundingBox,
 #ifdef USE_LARGE_BLOCKS
         real4* __restrict__ largeBlockCenter, half3* __restrict__ largeBlockBoundingBox,
@@ -491,7 +505,7 @@ extern "C" __global__ __launch_bounds__(GROUP_SIZE,3) void findBlocksWithInterac
                     // Store the new tiles to memory.
                     
 #if MAX_BITS_FOR_PAIRS > 0
-                    neighborsInBuffer = saveSinglePairs(x, buffer, flagsBuffer, neighborsInBuffer, maxSinglePairs, &interactionCount[1], singlePairs, sumBuffer+warpStart, pairStartIndex);
+                    neighborsInBuffer = saveSinglePairs(x, buffer, flagsBuffer, neighborsInBuffer, maxSinglePairs, &interactionCount[1], singlePairs, sumBuffer+warpStart, pairStartIndex, MAX_BITS_FOR_PAIRS);
 #endif
                     unsigned int tilesToStore = neighborsInBuffer/TILE_SIZE;
                     if (tilesToStore > 0) {
@@ -502,11 +516,17 @@ extern "C" __global__ __launch_bounds__(GROUP_SIZE,3) void findBlocksWithInterac
                             if (indexInWarp < tilesToStore)
                                 interactingTiles[newTileStartIndex+indexInWarp] = x;
                             #pragma unroll 8 // (GROUP_SIZE / TILE_SIZE)
-                            for (int j = 0; j < tilesToStore; j++)
-                                interactingAtoms[(newTileStartIndex+j)*TILE_SIZE+indexInWarp] = buffer[indexInWarp+j*TILE_SIZE];
+                            for (int j = 0; j < tilesToStore; j++) {
+                                interactingAtoms[((long long) (newTileStartIndex+j))*TILE_SIZE+indexInWarp] = buffer[indexInWarp+j*TILE_SIZE];
+#ifdef USE_PAIR_PRUNING
+                                interactingFlags[((long long) (newTileStartIndex+j))*TILE_SIZE+indexInWarp] = flagsBuffer[indexInWarp+j*TILE_SIZE];
+#endif
+                            }
                         }
-                        if (indexInWarp+TILE_SIZE*tilesToStore < BUFFER_SIZE)
+                        if (indexInWarp+TILE_SIZE*tilesToStore < BUFFER_SIZE) {
                             buffer[indexInWarp] = buffer[indexInWarp+TILE_SIZE*tilesToStore];
+                            flagsBuffer[indexInWarp] = flagsBuffer[indexInWarp+TILE_SIZE*tilesToStore];
+                        }
                         neighborsInBuffer -= TILE_SIZE*tilesToStore;
                     }
                 }
@@ -517,7 +537,18 @@ extern "C" __global__ __launch_bounds__(GROUP_SIZE,3) void findBlocksWithInterac
         
 #if MAX_BITS_FOR_PAIRS > 0
         if (neighborsInBuffer > 32)
-            neighborsInBuffer = saveSinglePairs(x, buffer, flagsBuffer, neighborsInBuffer, maxSinglePairs, &interactionCount[1], singlePairs, sumBuffer+warpStart, pairStartIndex);
+            neighborsInBuffer = saveSinglePairs(x, buffer, flagsBuffer, neighborsInBuffer, maxSinglePairs, &interactionCount[1], singlePairs, sumBuffer+warpStart, pairStartIndex, MAX_BITS_FOR_PAIRS);
+        if (neighborsInBuffer > 0 && neighborsInBuffer < TILE_SIZE) {
+            // The last tile is only partly filled, which is common in sparse or inhomogeneous systems.  If it
+            // contains few enough interactions, computing them as single pairs is cheaper than processing a
+            // whole tile, so move all of them to the single pair list.
+
+            int pairsInTile = (indexInWarp < neighborsInBuffer ? __popc(flagsBuffer[indexInWarp]) : 0);
+            for (int i = 16; i > 0; i /= 2)
+                pairsInTile += __shfl_xor_sync(0xffffffff, pairsInTile, i);
+            if (pairsInTile <= MAX_PAIRS_IN_SPARSE_TILE)
+                neighborsInBuffer = saveSinglePairs(x, buffer, flagsBuffer, neighborsInBuffer, maxSinglePairs, &interactionCount[1], singlePairs, sumBuffer+warpStart, pairStartIndex, TILE_SIZE);
+        }
 #endif
         if (neighborsInBuffer > 0) {
             unsigned int tilesToStore = (neighborsInBuffer+TILE_SIZE-1)/TILE_SIZE;
@@ -528,8 +559,12 @@ extern "C" __global__ __launch_bounds__(GROUP_SIZE,3) void findBlocksWithInterac
                 if (indexInWarp < tilesToStore)
                     interactingTiles[newTileStartIndex+indexInWarp] = x;
                 #pragma unroll 8 // (GROUP_SIZE / TILE_SIZE)
-                for (int j = 0; j < tilesToStore; j++)
-                    interactingAtoms[(newTileStartIndex+j)*TILE_SIZE+indexInWarp] = (indexInWarp+j*TILE_SIZE < neighborsInBuffer ? buffer[indexInWarp+j*TILE_SIZE] : NUM_ATOMS);
+                for (int j = 0; j < tilesToStore; j++) {
+                    interactingAtoms[((long long) (newTileStartIndex+j))*TILE_SIZE+indexInWarp] = (indexInWarp+j*TILE_SIZE < neighborsInBuffer ? buffer[indexInWarp+j*TILE_SIZE] : NUM_ATOMS);
+#ifdef USE_PAIR_PRUNING
+                    interactingFlags[((long long) (newTileStartIndex+j))*TILE_SIZE+indexInWarp] = (indexInWarp+j*TILE_SIZE < neighborsInBuffer ? flagsBuffer[indexInWarp+j*TILE_SIZE] : 0);
+#endif
+                }
             }
         }
     }
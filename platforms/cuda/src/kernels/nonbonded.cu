@@ -108,7 +108,7 @@ extern "C" __global__ void computeNonbonded(
         , const int* __restrict__ tiles, const unsigned int* __restrict__ interactionCount, real4 periodicBoxSize, real4 invPeriodicBoxSize, 
         real4 periodicBoxVecX, real4 periodicBoxVecY, real4 periodicBoxVecZ, unsigned int maxTiles, const real4* __restrict__ blockCenter,
         const real4* __restrict__ blockSize, const unsigned int* __restrict__ interactingAtoms, unsigned int maxSinglePairs,
-        const int2* __restrict__ singlePairs
+        const int2* __restrict__ singlePairs, const unsigned int* __restrict__ interactingFlags
 #endif
         PARAMETER_ARGUMENTS) {
     const unsigned int totalWarps = (blockDim.x*gridDim.x)/TILE_SIZE;
@@ -329,7 +329,10 @@ extern "C" __global__ void computeNonbonded(
             real4 posq1 = posq[atom1];
             LOAD_ATOM1_PARAMETERS
 #ifdef USE_NEIGHBOR_LIST
-            unsigned int j = interactingAtoms[pos*TILE_SIZE+tgx];
+            unsigned int j = interactingAtoms[((long long) pos)*TILE_SIZE+tgx];
+#ifdef USE_PAIR_PRUNING
+            unsigned int shflFlags = interactingFlags[((long long) pos)*TILE_SIZE+tgx];
+#endif
 #else
             unsigned int j = y*TILE_SIZE + tgx;
 #endif
@@ -359,6 +362,11 @@ extern "C" __global__ void computeNonbonded(
                 unsigned int tj = tgx;
                 for (j = 0; j < TILE_SIZE; j++) {
                     int atom2 = tbx+tj;
+#ifdef USE_PAIR_PRUNING
+                    // Skip this step if none of the pairs it contains is inside the cutoff.
+
+                    if (__any_sync(0xffffffff, (shflFlags>>tgx)&1)) {
+#endif
                     real4 posq2 = shflPosq; 
                     real3 delta = make_real3(posq2.x-posq1.x, posq2.y-posq1.y, posq2.z-posq1.z);
                     real r2 = delta.x*delta.x + delta.y*delta.y + delta.z*delta.z;
@@ -396,6 +404,10 @@ extern "C" __global__ void computeNonbonded(
                     shflForce.y += dEdR2.y;
                     shflForce.z += dEdR2.z;
 #endif // end USE_SYMMETRIC
+#endif
+#ifdef USE_PAIR_PRUNING
+                    }
+                    shflFlags = SHFL(shflFlags, tgx+1);
 #endif
                     SHUFFLE_WARP_DATA
                     tj = (tj + 1) & (TILE_SIZE - 1);
@@ -408,6 +420,11 @@ extern "C" __global__ void computeNonbonded(
                 unsigned int tj = tgx;
                 for (j = 0; j < TILE_SIZE; j++) {
                     int atom2 = tbx+tj;
+#ifdef USE_PAIR_PRUNING
+                    // Skip this step if none of the pairs it contains is inside the cutoff.
+
+                    if (__any_sync(0xffffffff, (shflFlags>>tgx)&1)) {
+#endif
                     real4 posq2 = shflPosq;
                     real3 delta = make_real3(posq2.x-posq1.x, posq2.y-posq1.y, posq2.z-posq1.z);
 #ifdef USE_PERIODIC
@@ -448,6 +465,10 @@ extern "C" __global__ void computeNonbonded(
                     shflForce.y += dEdR2.y;
                     shflForce.z += dEdR2.z;
 #endif // end USE_SYMMETRIC
+#endif
+#ifdef USE_PAIR_PRUNING
+                    }
+                    shflFlags = SHFL(shflFlags, tgx+1);
 #endif
                     SHUFFLE_WARP_DATA
                     tj = (tj + 1) & (TILE_SIZE - 1);
@@ -55,7 +55,7 @@ using namespace std;
 static CudaPlatform platform;
 
 template <class Real2>
-void testTransform(bool realToComplex, int xsize, int ysize, int zsize) {
+void testTransform(bool realToComplex, int xsize, int ysize, int zsize, const string& backend) {
     System system;
     system.addParticle(0.0);
     CudaPlatform::PlatformData platformData(NULL, system, "", "true", platform.getPropertyDefaultValue("CudaPrecision"), "false",
@@ -84,11 +84,11 @@ void testTransform(bool realToComplex, int xsize, int ysize, int zsize) {
     CudaArray grid1(context, original.size(), sizeof(Real2), "grid1");
     CudaArray grid2(context, original.size(), sizeof(Real2), "grid2");
     grid1.upload(original);
-    CudaFFT3D fft(context, xsize, ysize, zsize, realToComplex);
+    FFT3D fft = context.createFFTWithBackend(backend, xsize, ysize, zsize, realToComplex);
 
     // Perform a forward FFT, then verify the result is correct.
 
-    fft.execFFT(grid1, grid2, true);
+    fft->execFFT(grid1, grid2, true);
     vector<Real2> result;
     grid2.download(result);
     vector<size_t> shape = {(size_t) xsize, (size_t) ysize, (size_t) zsize};
@@ -109,7 +109,7 @@ void testTransform(bool realToComplex, int xsize, int ysize, int zsize) {
 
     // Perform a backward transform and see if we get the original values.
 
-    fft.execFFT(grid2, grid1, false);
+    fft->execFFT(grid2, grid1, false);
     grid1.download(result);
     double scale = 1.0/(xsize*ysize*zsize);
     int valuesToCheck = (realToComplex ? original.size()/2 : original.size());
@@ -123,19 +123,21 @@ int main(int argc, char* argv[]) {
     try {
         if (argc > 1)
             platform.setPropertyDefaultValue("CudaPrecision", string(argv[1]));
-        if (platform.getPropertyDefaultValue("CudaPrecision") == "double") {
-            testTransform<double2>(false, 28, 25, 30);
-            testTransform<double2>(true, 28, 25, 25);
-            testTransform<double2>(true, 25, 28, 25);
-            testTransform<double2>(true, 25, 25, 28);
-            testTransform<double2>(true, 21, 25, 27);
-        }
-        else {
-            testTransform<float2>(false, 28, 25, 30);
-            testTransform<float2>(true, 28, 25, 25);
-            testTransform<float2>(true, 25, 28, 25);
-            testTransform<float2>(true, 25, 25, 28);
-            testTransform<float2>(true, 21, 25, 27);
+        for (string backend : {"cuFFT", "VkFFT"}) {
+            if (platform.getPropertyDefaultValue("CudaPrecision") == "double") {
+                testTransform<double2>(false, 28, 25, 30, backend);
+                testTransform<double2>(true, 28, 25, 25, backend);
+                testTransform<double2>(true, 25, 28, 25, backend);
+                testTransform<double2>(true, 25, 25, 28, backend);
+                testTransform<double2>(true, 21, 25, 27, backend);
+            }
+            else {
+                testTransform<float2>(false, 28, 25, 30, backend);
+                testTransform<float2>(true, 28, 25, 25, backend);
+                testTransform<float2>(true, 25, 28, 25, backend);
+                testTransform<float2>(true, 25, 25, 28, backend);
+                testTransform<float2>(true, 21, 25, 27, backend);
+            }
         }
     }
     catch(const exception& e) {
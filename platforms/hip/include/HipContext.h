@@ -9,7 +9,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2009-2025 Stanford University and the Authors.      *
+ * Portions copyright (c) 2009-2026 Stanford University and the Authors.      *
  * Portions copyright (c) 2020-2023 Advanced Micro Devices, Inc.              *
  * Authors: Peter Eastman, Nicholas Curtis                                    *
  * Contributors:                                                              *
@@ -39,6 +39,7 @@
 
 
 #include <map>
+#include <mutex>
 #include <string>
 #include <utility>
 #define __CL_ENABLE_EXCEPTIONS
@@ -56,6 +57,7 @@
 #include "HipPlatform.h"
 #include "openmm/OpenMMException.h"
 #include "openmm/common/ComputeContext.h"
+#include "openmm/common/KernelCache.h"
 #include "openmm/Kernel.h"
 
 typedef unsigned int tileflags;
@@ -183,6 +185,11 @@ public:
      * Construct a ComputeEvent object of the appropriate class for this platform.
      */
     ComputeEvent createEvent();
+    /**
+     * Construct a ComputeEvent object of the appropriate class for this platform that records
+     * device timestamps.
+     */
+    ComputeEvent createTimingEvent();
     /**
      * Construct a ComputeSort object of the appropriate class for this platform.
      * 
@@ -197,15 +204,28 @@ public:
      */
     ComputeSort createSort(ComputeSortImpl::SortTrait* trait, unsigned int length, bool uniform=true);
     /**
-     * Create an object for performing 3D FFTs.  The caller is responsible for deleting
-     * the object when it is no longer needed.
+     * Get the name of the device this context is running on.
+     */
+    std::string getDeviceName();
+    /**
+     * Get the names of the FFT implementations that can perform transforms of a particular size.
+     *
+     * @param xsize   the first dimension of the data sets on which FFTs will be performed
+     * @param ysize   the second dimension of the data sets on which FFTs will be performed
+     * @param zsize   the third dimension of the data sets on which FFTs will be performed
+     * @param realToComplex  if true, a real-to-complex transform will be done.  Otherwise, it is complex-to-complex.
+     */
+    std::vector<std::string> getFFTBackends(int xsize, int ysize, int zsize, bool realToComplex);
+    /**
+     * Create an object for performing 3D FFTs with a specific implementation.
      *
+     * @param backend the name of the implementation to use, as returned by getFFTBackends()
      * @param xsize   the first dimension of the data sets on which FFTs will be performed
      * @param ysize   the second dimension of the data sets on which FFTs will be performed
      * @param zsize   the third dimension of the data sets on which FFTs will be performed
      * @param realToComplex  if true, a real-to-complex transform will be done.  Otherwise, it is complex-to-complex.
      */
-    FFT3D createFFT(int xsize, int ysize, int zsize, bool realToComplex=false);
+    FFT3D createFFTWithBackend(const std::string& backend, int xsize, int ysize, int zsize, bool realToComplex);
     /**
      * Get the smallest legal size for a dimension of the grid.
      */
@@ -273,6 +293,12 @@ public:
     HipArray& getEnergyBuffer() {
         return energyBuffer;
     }
+    /**
+     * Get the array into which reduceEnergy() sums the energy buffer.
+     */
+    HipArray& getEnergySum() {
+        return energySum;
+    }
     /**
      * Get the array which contains the buffer in which derivatives of the energy with respect to parameters are computed.
      */
@@ -286,6 +312,45 @@ public:
     void* getPinnedBuffer() {
         return pinnedBuffer;
     }
+    /**
+     * Allocate a new block of pinned memory that is owned by the caller.  It must be released by
+     * calling freePinnedMemory().
+     *
+     * @param size    the size of the block in bytes
+     */
+    void* allocatePinnedMemory(size_t size);
+    /**
+     * Release a block of memory that was allocated by allocatePinnedMemory().
+     */
+    void freePinnedMemory(void* memory);
+    /**
+     * Allocate a block of device memory.  When the device supports stream ordered allocation, the memory
+     * is taken from a pool owned by this context.  Memory released with freeDeviceMemory() stays in the
+     * pool and is reused by later allocations, so arrays can be freed and recreated (for example when
+     * they are resized) without going through the runtime's allocator each time.
+     *
+     * @param pointer   on exit, the address of the allocated memory
+     * @param size      the size of the block in bytes
+     * @return the result reported by the runtime
+     */
+    hipError_t allocateDeviceMemory(hipDeviceptr_t* pointer, size_t size);
+    /**
+     * Release a block of memory that was allocated by allocateDeviceMemory().  If it came from the pool,
+     * it is not reused until all work queued on the current stream before this call has finished.
+     *
+     * @param pointer   the address of the memory to release
+     * @return the result reported by the runtime
+     */
+    hipError_t freeDeviceMemory(hipDeviceptr_t pointer);
+    /**
+     * Get statistics about the device memory allocated by allocateDeviceMemory().
+     *
+     * @param used       on exit, the number of bytes currently allocated
+     * @param peak       on exit, the largest number of bytes that have been allocated at any one time
+     * @param reserved   on exit, the number of bytes reserved from the runtime.  This includes memory
+     *                   that has been freed and is held in the pool for reuse.
+     */
+    void getDeviceMemoryStatistics(size_t& used, size_t& peak, size_t& reserved);
     /**
      * Get a shared ThreadPool that code can use to parallelize operations.
      *
@@ -314,6 +379,12 @@ public:
      * Get a filename in cacheDir based on src hash.
      */
     std::string getCacheFileName(const std::string& src) const;
+    /**
+     * Get the KernelCache that manages the files in cacheDir.
+     */
+    KernelCache& getKernelCache() {
+        return kernelCache;
+    }
     /**
      * Create a HIP module from source code.
      *
@@ -334,6 +405,16 @@ public:
      * @param name      the name of the kernel to get
      */
     hipFunction_t getKernel(hipModule_t& module, const std::string& name);
+    /**
+     * Begin a named range of work to be shown by roctx based profiling tools such as rocprof.
+     *
+     * @param name    the name of the range
+     */
+    void pushAnnotation(const std::string& name);
+    /**
+     * End the most recently begun annotation range.
+     */
+    void popAnnotation();
     /**
      * Execute a kernel.
      *
@@ -618,15 +699,41 @@ public:
      * Get the flags that should be used when creating hipEvent_t objects.
      */
     unsigned int getEventFlags();
+    /**
+     * Begin capturing the work that is queued from this point on into a HIP graph.  See
+     * ComputeContext::beginGraphCapture() for details.
+     */
+    bool beginGraphCapture(const std::string& key);
+    /**
+     * Finish capturing the work that was begun by beginGraphCapture() and launch it.  See
+     * ComputeContext::endGraphCapture() for details.
+     */
+    bool endGraphCapture();
+    /**
+     * Get whether work is currently being captured into a HIP graph rather than executed.
+     */
+    bool isCapturingGraph() const {
+        return capturingGraph;
+    }
     /**
      * Get the flags that should be used when allocating pinned host memory.
      */
     unsigned int getHostMallocFlags();
 private:
+    /**
+     * Discard a graph capture that was begun but never finished, for example because an exception
+     * was thrown.
+     */
+    void abortGraphCapture();
     /**
      * Compute a sorted list of device indices in decreasing order of desirability
      */
     std::vector<int> getDevicePrecedence();
+    /**
+     * Free all device memory that is still allocated, including memory held by arrays that have
+     * not been deleted yet, and destroy the memory pool.  This is called when the context is deleted.
+     */
+    void releaseAllDeviceMemory();
     static bool hasInitializedHip;
     double computeCapability;
     HipPlatform::PlatformData& platformData;
@@ -639,11 +746,16 @@ private:
     int sharedMemPerBlock;
     bool supportsHardwareFloatGlobalAtomicAdd;
     bool useBlockingSync, useDoublePrecision, useMixedPrecision, contextIsValid, boxIsTriclinic, hasAssignedPosqCharges;
-    bool isLinkedContext;
-    std::string tempDir, cacheDir, gpuArchitecture;
+    bool isLinkedContext, capturingGraph;
+    int graphCaptureSupported;
+    std::string tempDir, cacheDir, gpuArchitecture, graphKey;
+    KernelCache kernelCache;
     float4 periodicBoxVecXFloat, periodicBoxVecYFloat, periodicBoxVecZFloat, periodicBoxSizeFloat, invPeriodicBoxSizeFloat;
     double4 periodicBoxVecX, periodicBoxVecY, periodicBoxVecZ, periodicBoxSize, invPeriodicBoxSize;
     std::map<std::string, std::string> compilationDefines;
+    std::map<hipFunction_t, std::string> kernelNames;
+    std::map<std::string, hipGraphExec_t> graphExecs;
+    ComputeQueue graphQueue, savedDefaultQueue, savedCurrentQueue;
     std::vector<hipModule_t> loadedModules;
     hipDevice_t device;
     hipFunction_t clearBufferKernel;
@@ -672,6 +784,16 @@ private:
     HipExpressionUtilities* expression;
     HipBondedUtilities* bonded;
     HipNonbondedUtilities* nonbonded;
+    std::mutex memoryMutex;
+    std::map<hipDeviceptr_t, std::pair<size_t, bool> > deviceAllocations;
+    std::vector<hipDeviceptr_t> pendingFrees;
+    size_t allocatedMemory, peakAllocatedMemory;
+    bool deviceMemoryReleased;
+#if HIP_VERSION >= 50300000
+    hipMemPool_t memoryPool;
+    hipStream_t memoryStream;
+    hipEvent_t memoryEvent;
+#endif
 };
 
 /**
@@ -39,7 +39,13 @@ namespace OpenMM {
 
 class HipEvent : public ComputeEventImpl {
 public:
-    HipEvent(HipContext& context);
+    /**
+     * Create a HipEvent.
+     *
+     * @param context      the context the event belongs to
+     * @param enableTiming if true, the event records timestamps so it can be used with getElapsedTime()
+     */
+    HipEvent(HipContext& context, bool enableTiming=false);
     ~HipEvent();
     /**
      * Place the event into the device's execution queue.
@@ -54,6 +60,10 @@ public:
      * operations started before the call to enqueue() have completed.
      */
     void queueWait(ComputeQueue queue);
+    /**
+     * Get the time in milliseconds that elapsed on the device between another event and this one.
+     */
+    double getElapsedTime(ComputeEventImpl& start);
 private:
     HipContext& context;
     hipEvent_t event;
@@ -83,6 +83,19 @@ public:
      * @param forward  true to perform a forward transform, false to perform an inverse transform
      */
     void execFFT(ArrayInterface& in, ArrayInterface& out, bool forward=true);
+    /**
+     * Get whether this object can perform fused convolutions with execConvolution().
+     */
+    bool supportsConvolution();
+    /**
+     * Convolve a data set with a kernel, fusing the multiplication into the transforms.  See
+     * FFT3DImpl::execConvolution() for details.
+     *
+     * @param in       the data to convolve.  On exit, this contains the result.
+     * @param out      used as workspace
+     * @param kernel   the complex values to multiply the transformed data by
+     */
+    void execConvolution(ArrayInterface& in, ArrayInterface& out, ArrayInterface& kernel);
     /**
      * Get the smallest legal size for a dimension of the grid (that is, a size with no prime
      * factors other than 2, 3, 5, 7, 11, 13).  VkFFT supports arbitrary sizes but they may work
@@ -99,7 +112,11 @@ private:
     void* outputBuffer;
     uint64_t inputBufferSize;
     uint64_t outputBufferSize;
+    void* kernelBuffer;
+    VkFFTConfiguration configuration;
     VkFFTApplication* app;
+    VkFFTApplication* convolutionApp;
+    int convolutionStatus;
 };
 
 } // namespace OpenMM
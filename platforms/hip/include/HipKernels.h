@@ -9,7 +9,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2008-2025 Stanford University and the Authors.      *
+ * Portions copyright (c) 2008-2026 Stanford University and the Authors.      *
  * Portions copyright (c) 2020-2022 Advanced Micro Devices, Inc.              *
  * Authors: Peter Eastman, Nicholas Curtis                                    *
  * Contributors:                                                              *
@@ -47,7 +47,7 @@ namespace OpenMM {
  */
 class HipCalcForcesAndEnergyKernel : public CalcForcesAndEnergyKernel {
 public:
-    HipCalcForcesAndEnergyKernel(std::string name, const Platform& platform, HipContext& cu) : CalcForcesAndEnergyKernel(name, platform), cu(cu) {
+    HipCalcForcesAndEnergyKernel(std::string name, const Platform& platform, HipContext& cu) : CalcForcesAndEnergyKernel(name, platform), cu(cu), annotatingGroups(false), annotatingForce(false) {
     }
     /**
      * Initialize the kernel.
@@ -80,8 +80,25 @@ public:
      * energy directly, <i>or</i> add it to an internal buffer so that it will be included here.
      */
     double finishComputation(ContextImpl& context, bool includeForce, bool includeEnergy, int groups, bool& valid);
+    /**
+     * This is called immediately before calcForcesAndEnergy() is called on each ForceImpl.
+     *
+     * @param context       the context in which to execute this kernel
+     * @param force         the Force whose contribution is about to be computed
+     * @param groups        a set of bit flags for which force groups to include
+     */
+    void beginForce(ContextImpl& context, const Force& force, int groups);
+    /**
+     * This is called immediately after calcForcesAndEnergy() returns for each ForceImpl.
+     *
+     * @param context       the context in which to execute this kernel
+     * @param force         the Force whose contribution was just computed
+     * @param groups        a set of bit flags for which force groups to include
+     */
+    void endForce(ContextImpl& context, const Force& force, int groups);
 private:
    HipContext& cu;
+   bool annotatingGroups, annotatingForce;
 };
 
 /**
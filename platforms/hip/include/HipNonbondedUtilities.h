@@ -178,6 +178,14 @@ public:
      * @return true if the neighbor list needed to be enlarged.
      */
     bool updateNeighborListSize();
+    /**
+     * When the interactions were computed as part of a HIP graph, the host could not wait for the
+     * number of interactions to be downloaded at the time.  Call this after the graph has been
+     * launched to wait for it and check whether the neighbor list arrays are large enough.
+     *
+     * @param forceGroups    the flags specifying which force groups were included
+     */
+    void checkNeighborListSizeAfterGraph(int forceGroups);
     /**
      * Get the array containing the center of each atom block.
      */
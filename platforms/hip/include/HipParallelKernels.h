@@ -81,10 +81,15 @@ public:
 private:
     class BeginComputationTask;
     class FinishComputationTask;
+    /**
+     * Assign each context its range of atom blocks based on contextNonbondedFractions.
+     */
+    void updateNonbondedRanges();
     HipPlatform::PlatformData& data;
     std::vector<Kernel> kernels;
     std::vector<double> completionTimes;
     std::vector<double> contextNonbondedFractions;
+    bool dedicatedPmeDevice;
     HipArray contextForces;
     void* pinnedPositionBuffer;
     long long* pinnedForceBuffer;
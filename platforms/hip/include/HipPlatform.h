@@ -9,7 +9,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2008-2016 Stanford University and the Authors.      *
+ * Portions copyright (c) 2008-2026 Stanford University and the Authors.      *
  * Portions copyright (c) 2020 Advanced Micro Devices, Inc.                   *
  * Authors: Peter Eastman, Nicholas Curtis                                    *
  * Contributors:                                                              *
@@ -53,6 +53,11 @@ public:
     bool supportsDoublePrecision() const;
     const std::string& getPropertyValue(const Context& context, const std::string& property) const;
     void setPropertyValue(Context& context, const std::string& property, const std::string& value) const;
+    std::map<std::string, std::pair<int, double> > getKernelTimings(Context& context) const;
+    void resetKernelTimings(Context& context) const;
+    std::map<std::string, std::map<std::string, long long> > getMemoryUsage(Context& context) const;
+    void getDeviceArray(Context& context, const std::string& name, long long& pointer, std::vector<int>& shape,
+                        std::string& type, int& deviceIndex) const;
     void contextCreated(ContextImpl& context, const std::map<std::string, std::string>& properties) const;
     void linkedContextCreated(ContextImpl& context, ContextImpl& originalContext) const;
     void contextDestroyed(ContextImpl& context) const;
@@ -112,23 +117,99 @@ public:
         static const std::string key = "DeterministicForces";
         return key;
     }
+    /**
+     * This is the name of the parameter for selecting whether to record the execution time of every kernel.
+     */
+    static const std::string& HipEnableProfiling() {
+        static const std::string key = "EnableProfiling";
+        return key;
+    }
+    /**
+     * This is the name of the parameter for selecting whether to capture the work for each step into
+     * HIP graphs, which reduces the overhead of launching kernels.
+     */
+    static const std::string& HipUseGraphs() {
+        static const std::string key = "UseGraphs";
+        return key;
+    }
+    /**
+     * This is the name of the parameter for selecting whether, when running on multiple devices,
+     * the first device should be dedicated to computing reciprocal space PME.  The other devices
+     * then split the direct space nonbonded interactions between them.
+     */
+    static const std::string& HipDedicatedPmeDevice() {
+        static const std::string key = "DedicatedPmeDevice";
+        return key;
+    }
+    /**
+     * This is the name of the parameter for selecting the directory in which compiled kernels are
+     * stored.  If this is empty, the OPENMM_CACHE_DIR environment variable is used, or the temporary
+     * directory if that is not set.
+     */
+    static const std::string& HipCacheDirectory() {
+        static const std::string key = "CacheDirectory";
+        return key;
+    }
+    /**
+     * This is the name of the parameter for setting the maximum amount of device memory, in megabytes,
+     * that arrays on each device may use.  If allocating an array would exceed it, an exception is
+     * thrown describing how memory is being used.  If this is empty, there is no limit.
+     */
+    static const std::string& HipDeviceMemoryBudget() {
+        static const std::string key = "DeviceMemoryBudget";
+        return key;
+    }
+    /**
+     * This is the name of the parameter for selecting whether read-only parameter arrays, such as
+     * the parameters of bonded forces and the nonbonded exclusions, may be shared with linked
+     * Contexts that use the same device.  Identical arrays are then stored only once, and a Context
+     * receives its own copy when it modifies one.
+     */
+    static const std::string& HipShareParameters() {
+        static const std::string key = "ShareParameters";
+        return key;
+    }
+    /**
+     * This is the name of the parameter for selecting whether to annotate kernels, force computations,
+     * and other phases of work with named ranges that can be shown by roctx based profiling tools such as rocprof.  This only affects the
+     * initial value: annotations can be switched on and off at any time through the ComputeContext.
+     */
+    static const std::string& HipEnableAnnotations() {
+        static const std::string key = "EnableAnnotations";
+        return key;
+    }
+    /**
+     * This is the name of the parameter for selecting the algorithm used for constraints that cannot be
+     * handled by SETTLE or SHAKE.  Allowed values are "ccma" and "lincs".  LINCS uses a fixed number of
+     * iterations and ignores the constraint tolerance, but never needs to wait for the host to check
+     * whether it has converged.
+     */
+    static const std::string& HipConstraintAlgorithm() {
+        static const std::string key = "ConstraintAlgorithm";
+        return key;
+    }
 };
 
 class OPENMM_EXPORT_COMMON HipPlatform::PlatformData {
 public:
     PlatformData(ContextImpl* context, const System& system, const std::string& deviceIndexProperty, const std::string& blockingProperty, const std::string& precisionProperty,
             const std::string& cpuPmeProperty, const std::string& tempProperty,
-            const std::string& pmeStreamProperty, const std::string& deterministicForcesProperty, int numThreads, ContextImpl* originalContext);
+            const std::string& pmeStreamProperty, const std::string& deterministicForcesProperty,
+            const std::string& profilingProperty, const std::string& graphsProperty,
+            const std::string& dedicatedPmeProperty, const std::string& memoryBudgetProperty, const std::string& shareParametersProperty, const std::string& annotationsProperty, const std::string& constraintAlgorithmProperty, const std::string& cacheDirProperty, int numThreads, ContextImpl* originalContext);
     ~PlatformData();
     void initializeContexts(const System& system);
     void syncContexts();
     ContextImpl* context;
     std::vector<HipContext*> contexts;
     std::vector<double> contextEnergy;
-    bool hasInitializedContexts, removeCM, peerAccessSupported, useCpuPme, disablePmeStream, deterministicForces;
+    bool hasInitializedContexts, removeCM, peerAccessSupported, useCpuPme, disablePmeStream, deterministicForces, enableProfiling, enableAnnotations, useGraphs, dedicatedPmeDevice, useLincs;
     int cmMotionFrequency, computeForceCount;
     long long stepCount;
     double time;
+    long long memoryBudget;
+    bool shareParameters;
+    std::string cacheDirectory;
     std::map<std::string, std::string> propertyValues;
     ThreadPool threads;
 };
@@ -53,6 +53,12 @@ public:
     hipStream_t getStream() {
         return stream;
     }
+    /**
+     * Get the hipStream_t, cast to a void*.
+     */
+    void* getNativeHandle() {
+        return (void*) stream;
+    }
 private:
     hipStream_t stream;
     bool initialized;
@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2012-2022 Stanford University and the Authors.      *
+ * Portions copyright (c) 2012-2026 Stanford University and the Authors.      *
  * Portions copyright (c) 2020-2023 Advanced Micro Devices, Inc.              *
  * Authors: Peter Eastman, Nicholas Curtis                                    *
  * Contributors:                                                              *
@@ -34,7 +34,7 @@
 
 using namespace OpenMM;
 
-HipArray::HipArray() : pointer(0), ownsMemory(false) {
+HipArray::HipArray() : pointer(0), ownsMemory(false), sharesMemory(false) {
 }
 
 HipArray::HipArray(HipContext& context, size_t size, int elementSize, const std::string& name) : pointer(0) {
@@ -42,9 +42,11 @@ HipArray::HipArray(HipContext& context, size_t size, int elementSize, const std:
 }
 
 HipArray::~HipArray() {
+    if (ownsMemory)
+        context->recordArrayRelease(*this);
     if (pointer != 0 && ownsMemory) {
         ContextSelector selector(*context);
-        hipError_t result = hipFree(pointer);
+        hipError_t result = context->freeDeviceMemory(pointer);
         if (result != hipSuccess) {
             std::stringstream str;
             str<<"Error deleting array "<<name<<": "<<HipContext::getErrorString(result)<<" ("<<result<<")";
@@ -61,11 +63,54 @@ void HipArray::initialize(ComputeContext& context, size_t size, int elementSize,
     this->elementSize = elementSize;
     this->name = name;
     ownsMemory = true;
+    sharesMemory = false;
+    this->context->recordArrayAllocation(*this, size*elementSize);
     ContextSelector selector(*this->context);
-    hipError_t result = hipMalloc(&pointer, size*elementSize);
+    hipError_t result = this->context->allocateDeviceMemory(&pointer, size*elementSize);
     if (result != hipSuccess) {
+        this->context->recordArrayRelease(*this);
         std::stringstream str;
         str<<"Error creating array "<<name<<": "<<HipContext::getErrorString(result)<<" ("<<result<<")";
+        if (result == hipErrorOutOfMemory)
+            str<<".  "<<this->context->getMemoryUsageReport();
+        throw OpenMMException(str.str());
+    }
+}
+
+void HipArray::initializeShared(ComputeContext& context, ArrayInterface& source, const std::string& name) {
+    if (this->pointer != 0)
+        throw OpenMMException("HipArray has already been initialized");
+    this->context = &dynamic_cast<HipContext&>(context);
+    HipArray& sharedSource = this->context->unwrap(source);
+    pointer = sharedSource.getDevicePointer();
+    size = sharedSource.getSize();
+    elementSize = sharedSource.getElementSize();
+    this->name = name;
+    ownsMemory = false;
+    sharesMemory = true;
+}
+
+void HipArray::copyOnWrite(bool copyContents) {
+    if (!sharesMemory)
+        return;
+    hipDeviceptr_t shared = pointer;
+    pointer = 0;
+    try {
+        initialize(*context, size, elementSize, name);
+    }
+    catch (...) {
+        pointer = shared;
+        throw;
+    }
+    if (!copyContents)
+        return;
+    ContextSelector selector(*context);
+    hipError_t result = hipMemcpyAsync(pointer, shared, size*elementSize, hipMemcpyDeviceToDevice, context->getCurrentStream());
+    if (result == hipSuccess)
+        result = hipStreamSynchronize(context->getCurrentStream());
+    if (result != hipSuccess) {
+        std::stringstream str;
+        str<<"Error copying array "<<name<<": "<<HipContext::getErrorString(result)<<" ("<<result<<")";
         throw OpenMMException(str.str());
     }
 }
@@ -73,10 +118,16 @@ void HipArray::initialize(ComputeContext& context, size_t size, int elementSize,
 void HipArray::resize(size_t size) {
     if (pointer == 0)
         throw OpenMMException("HipArray has not been initialized");
+    if (sharesMemory) {
+        pointer = 0;
+        sharesMemory = false;
+        initialize(*context, size, elementSize, name);
+        return;
+    }
     if (!ownsMemory)
         throw OpenMMException("Cannot resize an array that does not own its storage");
     ContextSelector selector(*context);
-    hipError_t result = hipFree(pointer);
+    hipError_t result = context->freeDeviceMemory(pointer);
     if (result != hipSuccess) {
         std::stringstream str;
         str<<"Error deleting array "<<name<<": "<<HipContext::getErrorString(result)<<" ("<<result<<")";
@@ -95,6 +146,8 @@ void HipArray::uploadSubArray(const void* data, int offset, int elements, bool b
         throw OpenMMException("HipArray has not been initialized");
     if (offset < 0 || offset+elements > getSize())
         throw OpenMMException("uploadSubArray: data exceeds range of array");
+    copyOnWrite(offset > 0 || elements < size);
+    ComputeContext::Annotation annotation(*context, "upload ", name);
     hipError_t result;
     result = hipMemcpyAsync(reinterpret_cast<char*>(pointer)+offset*elementSize, const_cast<void*>(data), elements*elementSize, hipMemcpyHostToDevice, context->getCurrentStream());
     if (blocking && result == hipSuccess)
@@ -109,6 +162,7 @@ void HipArray::uploadSubArray(const void* data, int offset, int elements, bool b
 void HipArray::download(void* data, bool blocking) const {
     if (pointer == 0)
         throw OpenMMException("HipArray has not been initialized");
+    ComputeContext::Annotation annotation(*context, "download ", name);
     hipError_t result;
     result = hipMemcpyAsync(data, pointer, size*elementSize, hipMemcpyDeviceToHost, context->getCurrentStream());
     if (blocking && result == hipSuccess)
@@ -120,12 +174,30 @@ void HipArray::download(void* data, bool blocking) const {
     }
 }
 
+void HipArray::downloadSubArray(void* data, int offset, int elements, bool blocking) const {
+    if (pointer == 0)
+        throw OpenMMException("HipArray has not been initialized");
+    if (offset < 0 || offset+elements > getSize())
+        throw OpenMMException("downloadSubArray: data exceeds range of array");
+    ComputeContext::Annotation annotation(*context, "download ", name);
+    hipError_t result;
+    result = hipMemcpyAsync(data, reinterpret_cast<char*>(pointer)+offset*elementSize, elements*elementSize, hipMemcpyDeviceToHost, context->getCurrentStream());
+    if (blocking && result == hipSuccess)
+        result = hipStreamSynchronize(context->getCurrentStream());
+    if (result != hipSuccess) {
+        std::stringstream str;
+        str<<"Error downloading array "<<name<<": "<<HipContext::getErrorString(result)<<" ("<<result<<")";
+        throw OpenMMException(str.str());
+    }
+}
+
 void HipArray::copyTo(ArrayInterface& dest) const {
     if (pointer == 0)
         throw OpenMMException("HipArray has not been initialized");
     if (dest.getSize() != size || dest.getElementSize() != elementSize)
         throw OpenMMException("Error copying array "+name+" to "+dest.getName()+": The destination array does not match the size of the array");
     HipArray& cuDest = context->unwrap(dest);
+    cuDest.copyOnWrite(false);
     hipError_t result = hipMemcpyAsync(cuDest.getDevicePointer(), pointer, size*elementSize, hipMemcpyDeviceToDevice, context->getCurrentStream());
     if (result != hipSuccess) {
         std::stringstream str;
@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2009-2025 Stanford University and the Authors.      *
+ * Portions copyright (c) 2009-2026 Stanford University and the Authors.      *
  * Portions copyright (c) 2020-2023 Advanced Micro Devices, Inc.              *
  * Authors: Peter Eastman, Nicholas Curtis                                    *
  * Contributors:                                                              *
@@ -42,7 +42,6 @@
 #include "HipSort.h"
 #include "openmm/common/ComputeArray.h"
 #include "openmm/common/ContextSelector.h"
-#include "SHA1.h"
 #include "openmm/MonteCarloFlexibleBarostat.h"
 #include "openmm/Platform.h"
 #include "openmm/System.h"
@@ -52,6 +51,7 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -62,6 +62,9 @@
 #include <typeinfo>
 #include <sys/stat.h>
 #include <hip/hiprtc.h>
+#ifndef WIN32
+  #include <dlfcn.h>
+#endif
 
 
 #define CHECK_RESULT(result) CHECK_RESULT2(result, errorMessage);
@@ -90,7 +93,11 @@ bool HipContext::hasInitializedHip = false;
 HipContext::HipContext(const System& system, int deviceIndex, bool useBlockingSync, const string& precision, const string& tempDir, HipPlatform::PlatformData& platformData,
         HipContext* originalContext) : ComputeContext(system), platformData(platformData), contextIsValid(false), hasAssignedPosqCharges(false),
         pinnedBuffer(NULL), integration(NULL), expression(NULL), bonded(NULL), nonbonded(NULL),
-        useBlockingSync(useBlockingSync), supportsHardwareFloatGlobalAtomicAdd(false) {
+        useBlockingSync(useBlockingSync), supportsHardwareFloatGlobalAtomicAdd(false), capturingGraph(false), graphCaptureSupported(-1),
+        allocatedMemory(0), peakAllocatedMemory(0), deviceMemoryReleased(false), kernelCache(platformData.cacheDirectory, tempDir, "openmm-hip-") {
+    setMemoryBudget(platformData.memoryBudget);
+    if (platformData.shareParameters)
+        enableSharedArrays(originalContext);
     if (!hasInitializedHip) {
         CHECK_RESULT2(hipInit(0), "Error initializing HIP");
         hasInitializedHip = true;
@@ -109,14 +116,11 @@ HipContext::HipContext(const System& system, int deviceIndex, bool useBlockingSy
     }
     else
         throw OpenMMException("Illegal value for Precision: "+precision);
-    char* cacheVariable = getenv("OPENMM_CACHE_DIR");
-    cacheDir = (cacheVariable == NULL ? tempDir : string(cacheVariable));
+    cacheDir = kernelCache.getDirectory();
 #ifdef WIN32
     this->tempDir = tempDir+"\\";
-    cacheDir = cacheDir+"\\";
 #else
     this->tempDir = tempDir+"/";
-    cacheDir = cacheDir+"/";
 #endif
     contextIndex = platformData.contexts.size();
     string errorMessage = "Error initializing Context";
@@ -186,6 +190,30 @@ HipContext::HipContext(const System& system, int deviceIndex, bool useBlockingSy
 
     contextIsValid = true;
     ContextSelector selector(*this);
+#if HIP_VERSION >= 50300000
+    // If the device supports it, create a memory pool for arrays.  Setting the release threshold
+    // to the maximum value keeps freed memory in the pool instead of returning it to the runtime.
+
+    memoryPool = NULL;
+    int poolsSupported = 0;
+    hipDeviceGetAttribute(&poolsSupported, hipDeviceAttributeMemoryPoolsSupported, device);
+    if (poolsSupported) {
+        hipMemPoolProps props;
+        memset(&props, 0, sizeof(props));
+        props.allocType = hipMemAllocationTypePinned;
+        props.handleTypes = hipMemHandleTypeNone;
+        props.location.type = hipMemLocationTypeDevice;
+        props.location.id = (int) device;
+        if (hipMemPoolCreate(&memoryPool, &props) == hipSuccess) {
+            uint64_t threshold = ~((uint64_t) 0);
+            CHECK_RESULT(hipMemPoolSetAttribute(memoryPool, hipMemPoolAttrReleaseThreshold, &threshold));
+            CHECK_RESULT(hipStreamCreateWithFlags(&memoryStream, hipStreamNonBlocking));
+            CHECK_RESULT(hipEventCreateWithFlags(&memoryEvent, hipEventDisableTiming));
+        }
+        else
+            memoryPool = NULL;
+    }
+#endif
     if (contextIndex > 0 && originalContext == NULL) {
         int canAccess;
         CHECK_RESULT(hipDeviceCanAccessPeer(&canAccess, getDevice(), platformData.contexts[0]->getDevice()));
@@ -201,6 +229,21 @@ HipContext::HipContext(const System& system, int deviceIndex, bool useBlockingSy
             if (result != hipErrorPeerAccessAlreadyEnabled) {
                 CHECK_RESULT(result);
             }
+#if HIP_VERSION >= 50300000
+            // Memory from a pool is only accessible to other devices if the pool grants access explicitly.
+
+            hipMemAccessDesc access;
+            access.flags = hipMemAccessFlagsProtReadWrite;
+            access.location.type = hipMemLocationTypeDevice;
+            if (memoryPool != NULL) {
+                access.location.id = (int) platformData.contexts[0]->getDevice();
+                CHECK_RESULT(hipMemPoolSetAccess(memoryPool, &access, 1));
+            }
+            if (platformData.contexts[0]->memoryPool != NULL) {
+                access.location.id = (int) getDevice();
+                CHECK_RESULT(hipMemPoolSetAccess(platformData.contexts[0]->memoryPool, &access, 1));
+            }
+#endif
         }
     }
     numAtoms = system.getNumParticles();
@@ -377,6 +420,13 @@ HipContext::~HipContext() {
         delete bonded;
     if (nonbonded != NULL)
         delete nonbonded;
+    if (capturingGraph)
+        abortGraphCapture();
+    for (auto& exec : graphExecs)
+        hipGraphExecDestroy(exec.second);
+    graphQueue.reset();
+    releaseSharedArrays();
+    releaseAllDeviceMemory();
     for (auto module : loadedModules)
         hipModuleUnload(module);
     popAsCurrent();
@@ -471,22 +521,11 @@ string HipContext::getTempFileName() const {
 }
 
 string HipContext::getHash(const string& src) const {
-    CSHA1 sha1;
-    sha1.Update((const UINT_8*) src.c_str(), src.size());
-    sha1.Final();
-    UINT_8 hash[20];
-    sha1.GetHash(hash);
-    stringstream cacheHash;
-    cacheHash.flags(ios::hex);
-    for (int i = 0; i < 20; i++)
-        cacheHash << setw(2) << setfill('0') << (int) hash[i];
-    return cacheHash.str();
+    return KernelCache::getHash(src);
 }
 
 string HipContext::getCacheFileName(const string& src) const {
-    stringstream cacheFile;
-    cacheFile << cacheDir << "openmm-hip-" << getHash(src + gpuArchitecture);
-    return cacheFile.str();
+    return kernelCache.getFileName(src + gpuArchitecture);
 }
 
 hipModule_t HipContext::createModule(const string source) {
@@ -575,6 +614,7 @@ hipModule_t HipContext::createModule(const string source, const map<string, stri
     string cacheFile = getCacheFileName(src.str());
     hipModule_t module;
     if (hipModuleLoad(&module, cacheFile.c_str()) == hipSuccess) {
+        kernelCache.recordUse(cacheFile);
         loadedModules.push_back(module);
         return module;
     }
@@ -639,15 +679,7 @@ hipModule_t HipContext::createModule(const string source, const map<string, stri
 
         // If possible, write the CO out to a cache file for later use.
 
-        try {
-            ofstream out(cacheFile.c_str(), ios::out | ios::binary);
-            out.write(&code[0], code.size());
-            out.close();
-        }
-        catch (...) {
-            // An error occurred.  Possibly we don't have permission to write to the temp directory.
-            // Ignore.
-        }
+        kernelCache.save(src.str() + gpuArchitecture, code);
         CHECK_RESULT2(hipModuleLoadDataEx(&module, &code[0], 0, NULL, NULL), "Error loading HIP module");
         loadedModules.push_back(module);
         return module;
@@ -666,6 +698,7 @@ hipFunction_t HipContext::getKernel(hipModule_t& module, const string& name) {
         m<<"Error creating kernel "<<name<<": "<<getErrorString(result)<<" ("<<result<<")";
         throw OpenMMException(m.str());
     }
+    kernelNames[function] = name;
     return function;
 }
 
@@ -692,20 +725,161 @@ HipArray* HipContext::createArray() {
     return new HipArray();
 }
 
+void* HipContext::allocatePinnedMemory(size_t size) {
+    void* memory;
+    CHECK_RESULT2(hipHostMalloc(&memory, size, getHostMallocFlags()), "Error allocating pinned memory");
+    return memory;
+}
+
+void HipContext::freePinnedMemory(void* memory) {
+    hipHostFree(memory);
+}
+
+hipError_t HipContext::allocateDeviceMemory(hipDeviceptr_t* pointer, size_t size) {
+    lock_guard<mutex> lock(memoryMutex);
+    hipError_t result;
+    bool pooled = false;
+#if HIP_VERSION >= 50300000
+    if (memoryPool != NULL && !capturingGraph) {
+        // Release any memory whose release was deferred while a graph was being captured.
+
+        if (pendingFrees.size() > 0) {
+            hipEventRecord(memoryEvent, getCurrentStream());
+            hipStreamWaitEvent(memoryStream, memoryEvent, 0);
+            for (hipDeviceptr_t p : pendingFrees)
+                hipFreeAsync(p, memoryStream);
+            pendingFrees.clear();
+        }
+
+        // The allocation is ordered on a private stream.  Wait for it to complete, since the memory may
+        // be used immediately by any stream, or by a blocking copy.
+
+        result = hipMallocFromPoolAsync(pointer, size, memoryPool, memoryStream);
+        if (result == hipSuccess)
+            result = hipStreamSynchronize(memoryStream);
+        pooled = true;
+    }
+    else
+#endif
+        result = hipMalloc(pointer, size);
+    if (result == hipSuccess) {
+        deviceAllocations[*pointer] = make_pair(size, pooled);
+        allocatedMemory += size;
+        peakAllocatedMemory = max(peakAllocatedMemory, allocatedMemory);
+    }
+    return result;
+}
+
+hipError_t HipContext::freeDeviceMemory(hipDeviceptr_t pointer) {
+    lock_guard<mutex> lock(memoryMutex);
+    if (deviceMemoryReleased)
+        return hipSuccess;
+    auto allocation = deviceAllocations.find(pointer);
+    if (allocation == deviceAllocations.end())
+        return hipFree(pointer);
+    allocatedMemory -= allocation->second.first;
+    bool pooled = allocation->second.second;
+    deviceAllocations.erase(allocation);
+#if HIP_VERSION >= 50300000
+    if (pooled) {
+        // The memory may still be in use by work that has been queued but not yet executed.  Have
+        // the private stream wait for it before returning the memory to the pool.  During graph
+        // capture this is not allowed, so the release is deferred.
+
+        if (capturingGraph) {
+            pendingFrees.push_back(pointer);
+            return hipSuccess;
+        }
+        hipError_t result = hipEventRecord(memoryEvent, getCurrentStream());
+        if (result == hipSuccess)
+            result = hipStreamWaitEvent(memoryStream, memoryEvent, 0);
+        if (result == hipSuccess)
+            result = hipFreeAsync(pointer, memoryStream);
+        return result;
+    }
+#endif
+    return hipFree(pointer);
+}
+
+void HipContext::releaseAllDeviceMemory() {
+    lock_guard<mutex> lock(memoryMutex);
+    if (!contextIsValid)
+        return;
+#if HIP_VERSION >= 50300000
+    if (memoryPool != NULL) {
+        hipEventRecord(memoryEvent, getCurrentStream());
+        hipStreamWaitEvent(memoryStream, memoryEvent, 0);
+        for (hipDeviceptr_t pointer : pendingFrees)
+            hipFreeAsync(pointer, memoryStream);
+        for (auto& allocation : deviceAllocations)
+            if (allocation.second.second)
+                hipFreeAsync(allocation.first, memoryStream);
+        hipStreamSynchronize(memoryStream);
+        hipMemPoolTrimTo(memoryPool, 0);
+        hipMemPoolDestroy(memoryPool);
+        hipStreamDestroy(memoryStream);
+        hipEventDestroy(memoryEvent);
+        memoryPool = NULL;
+    }
+#endif
+    for (auto& allocation : deviceAllocations)
+        if (!allocation.second.second)
+            hipFree(allocation.first);
+    deviceAllocations.clear();
+    pendingFrees.clear();
+    allocatedMemory = 0;
+    deviceMemoryReleased = true;
+}
+
+void HipContext::getDeviceMemoryStatistics(size_t& used, size_t& peak, size_t& reserved) {
+    lock_guard<mutex> lock(memoryMutex);
+    used = allocatedMemory;
+    peak = peakAllocatedMemory;
+    reserved = allocatedMemory;
+#if HIP_VERSION >= 50300000
+    if (memoryPool != NULL) {
+        // Add the memory held by the pool for reuse.
+
+        uint64_t poolReserved, poolUsed;
+        hipMemPoolGetAttribute(memoryPool, hipMemPoolAttrReservedMemCurrent, &poolReserved);
+        hipMemPoolGetAttribute(memoryPool, hipMemPoolAttrUsedMemCurrent, &poolUsed);
+        if (poolReserved > poolUsed)
+            reserved += (size_t) (poolReserved-poolUsed);
+    }
+#endif
+}
+
 ComputeEvent HipContext::createEvent() {
     return shared_ptr<ComputeEventImpl>(new HipEvent(*this));
 }
 
+ComputeEvent HipContext::createTimingEvent() {
+    return shared_ptr<ComputeEventImpl>(new HipEvent(*this, true));
+}
+
 ComputeSort HipContext::createSort(ComputeSortImpl::SortTrait* trait, unsigned int length, bool uniform) {
     return shared_ptr<ComputeSortImpl>(new HipSort(*this, trait, length, uniform));
 }
 
-FFT3D HipContext::createFFT(int xsize, int ysize, int zsize, bool realToComplex) {
-    return FFT3D(new HipFFT3D(*this, xsize, ysize, zsize, realToComplex));
+string HipContext::getDeviceName() {
+    char deviceName[1000];
+    if (hipDeviceGetName(deviceName, 1000, device) != hipSuccess)
+        deviceName[0] = 0;
+    return string(deviceName);
+}
+
+vector<string> HipContext::getFFTBackends(int xsize, int ysize, int zsize, bool realToComplex) {
+    return {"VkFFT"};
+}
+
+FFT3D HipContext::createFFTWithBackend(const string& backend, int xsize, int ysize, int zsize, bool realToComplex) {
+    if (backend == "VkFFT")
+        return FFT3D(new HipFFT3D(*this, xsize, ysize, zsize, realToComplex));
+    throw OpenMMException("Unknown FFT implementation: "+backend);
 }
 
 int HipContext::findLegalFFTDimension(int minimum) {
-    return HipFFT3D::findLegalDimension(minimum);
+    return findFastFFTDimension(minimum, 13);
 }
 
 ComputeProgram HipContext::compileProgram(const std::string source, const std::map<std::string, std::string>& defines) {
@@ -729,28 +903,78 @@ std::string HipContext::getErrorString(hipError_t result) {
     return string(hipGetErrorName(result));
 }
 
+// roctx is loaded when it is first needed, so it is not required unless annotations are enabled.
+
+static int (*roctxRangePushFunction)(const char*) = NULL;
+static int (*roctxRangePopFunction)() = NULL;
+static once_flag roctxLoaded;
+
+static void loadRoctx() {
+#ifndef WIN32
+    void* library = dlopen("libroctx64.so", RTLD_LAZY | RTLD_LOCAL);
+    if (library == NULL)
+        return;
+    roctxRangePushFunction = (int (*)(const char*)) dlsym(library, "roctxRangePushA");
+    roctxRangePopFunction = (int (*)()) dlsym(library, "roctxRangePop");
+    if (roctxRangePushFunction == NULL || roctxRangePopFunction == NULL) {
+        roctxRangePushFunction = NULL;
+        roctxRangePopFunction = NULL;
+    }
+#endif
+}
+
+void HipContext::pushAnnotation(const string& name) {
+    call_once(roctxLoaded, loadRoctx);
+    if (roctxRangePushFunction != NULL)
+        roctxRangePushFunction(name.c_str());
+}
+
+void HipContext::popAnnotation() {
+    call_once(roctxLoaded, loadRoctx);
+    if (roctxRangePopFunction != NULL)
+        roctxRangePopFunction();
+}
+
 void HipContext::executeKernel(hipFunction_t kernel, void** arguments, int threads, int blockSize, unsigned int sharedSize) {
     if (blockSize == -1)
         blockSize = ThreadBlockSize;
     int gridSize = std::min((threads+blockSize-1)/blockSize, numThreadBlocks);
+    if (getProfilingEnabled())
+        startProfilingInterval();
+    bool annotate = getAnnotationsEnabled();
+    if (annotate)
+        pushAnnotation(kernelNames[kernel]);
     hipError_t result = hipModuleLaunchKernel(kernel, gridSize, 1, 1, blockSize, 1, 1, sharedSize, getCurrentStream(), arguments, NULL);
+    if (annotate)
+        popAnnotation();
     if (result != hipSuccess) {
         stringstream str;
         str<<"Error invoking kernel: "<<getErrorString(result)<<" ("<<result<<")";
         throw OpenMMException(str.str());
     }
+    if (getProfilingEnabled())
+        endProfilingInterval(kernelNames[kernel]);
 }
 
 void HipContext::executeKernelFlat(hipFunction_t kernel, void** arguments, int threads, int blockSize, unsigned int sharedSize) {
     if (blockSize == -1)
         blockSize = ThreadBlockSize;
     int gridSize = (threads+blockSize-1)/blockSize;
+    if (getProfilingEnabled())
+        startProfilingInterval();
+    bool annotate = getAnnotationsEnabled();
+    if (annotate)
+        pushAnnotation(kernelNames[kernel]);
     hipError_t result = hipModuleLaunchKernel(kernel, gridSize, 1, 1, blockSize, 1, 1, sharedSize, getCurrentStream(), arguments, NULL);
+    if (annotate)
+        popAnnotation();
     if (result != hipSuccess) {
         stringstream str;
         str<<"Error invoking kernel: "<<getErrorString(result)<<" ("<<result<<")";
         throw OpenMMException(str.str());
     }
+    if (getProfilingEnabled())
+        endProfilingInterval(kernelNames[kernel]);
 }
 
 int HipContext::computeThreadBlockSize(double memory) const {
@@ -835,6 +1059,8 @@ double HipContext::reduceEnergy() {
     int workGroupSize = getMaxThreadBlockSize();
     void* args[] = {&energyBuffer.getDevicePointer(), &energySum.getDevicePointer(), &bufferSize, &workGroupSize};
     executeKernel(reduceEnergyKernel, args, workGroupSize*energySum.getSize(), workGroupSize, workGroupSize*energyBuffer.getElementSize());
+    if (keepEnergyOnDevice)
+        return 0.0;
     energySum.download(pinnedBuffer);
     double result = 0;
     if (getUseDoublePrecision() || getUseMixedPrecision()) {
@@ -878,6 +1104,95 @@ void HipContext::flushQueue() {
     hipStreamSynchronize(getCurrentStream());
 }
 
+bool HipContext::beginGraphCapture(const string& key) {
+    if (capturingGraph)
+        abortGraphCapture();
+    if (!platformData.useGraphs)
+        return false;
+    if (graphCaptureSupported == -1)
+        graphCaptureSupported = (platformData.contexts.size() == 1 && !platformData.useCpuPme && getSystemSupportsGraphCapture());
+    if (!graphCaptureSupported)
+        return false;
+
+    // Record the work on a separate stream.  It becomes the default queue while capturing so that
+    // code which restores the default queue (for example, after queueing work on the PME stream)
+    // continues to be captured.
+
+    if (graphQueue == NULL)
+        graphQueue = createQueue();
+    hipError_t result = hipStreamBeginCapture(dynamic_cast<HipQueue*>(graphQueue.get())->getStream(), hipStreamCaptureModeThreadLocal);
+    if (result != hipSuccess)
+        throw OpenMMException("Error beginning HIP graph capture: "+getErrorString(result));
+    savedDefaultQueue = defaultQueue;
+    savedCurrentQueue = currentQueue;
+    defaultQueue = graphQueue;
+    currentQueue = graphQueue;
+    graphKey = key;
+    capturingGraph = true;
+    return true;
+}
+
+bool HipContext::endGraphCapture() {
+    if (!capturingGraph)
+        throw OpenMMException("endGraphCapture() called without a matching call to beginGraphCapture()");
+    hipGraph_t graph;
+    hipError_t result = hipStreamEndCapture(dynamic_cast<HipQueue*>(graphQueue.get())->getStream(), &graph);
+    defaultQueue = savedDefaultQueue;
+    currentQueue = savedCurrentQueue;
+    savedDefaultQueue.reset();
+    savedCurrentQueue.reset();
+    capturingGraph = false;
+    if (result != hipSuccess) {
+        graphCaptureSupported = 0;
+        return false;
+    }
+
+    // Kernel arguments such as random number offsets can change on every step, so the graph is
+    // captured every time.  If it has the same structure as the last one captured with this key,
+    // the cached executable graph is updated in place.  It is only instantiated again when the
+    // structure changes, for example after the neighbor list grows.
+
+    auto exec = graphExecs.find(graphKey);
+    if (exec != graphExecs.end()) {
+        hipGraphNode_t errorNode;
+        hipGraphExecUpdateResult updateResult;
+        result = hipGraphExecUpdate(exec->second, graph, &errorNode, &updateResult);
+        if (result != hipSuccess) {
+            hipGraphExecDestroy(exec->second);
+            graphExecs.erase(exec);
+            exec = graphExecs.end();
+        }
+    }
+    if (exec == graphExecs.end()) {
+        hipGraphExec_t instance;
+        result = hipGraphInstantiate(&instance, graph, NULL, NULL, 0);
+        if (result != hipSuccess) {
+            hipGraphDestroy(graph);
+            graphCaptureSupported = 0;
+            return false;
+        }
+        exec = graphExecs.insert(make_pair(graphKey, instance)).first;
+    }
+    hipGraphDestroy(graph);
+    result = hipGraphLaunch(exec->second, getCurrentStream());
+    if (result != hipSuccess) {
+        graphCaptureSupported = 0;
+        return false;
+    }
+    return true;
+}
+
+void HipContext::abortGraphCapture() {
+    hipGraph_t graph;
+    if (hipStreamEndCapture(dynamic_cast<HipQueue*>(graphQueue.get())->getStream(), &graph) == hipSuccess)
+        hipGraphDestroy(graph);
+    defaultQueue = savedDefaultQueue;
+    currentQueue = savedCurrentQueue;
+    savedDefaultQueue.reset();
+    savedCurrentQueue.reset();
+    capturingGraph = false;
+}
+
 vector<int> HipContext::getDevicePrecedence() {
     int numDevices;
     hipDeviceProp_t thisDevice;
@@ -31,8 +31,11 @@
 
 using namespace OpenMM;
 
-HipEvent::HipEvent(HipContext& context) : context(context), eventCreated(false) {
-    hipError_t result = hipEventCreateWithFlags(&event, context.getEventFlags());
+HipEvent::HipEvent(HipContext& context, bool enableTiming) : context(context), eventCreated(false) {
+    unsigned int flags = context.getEventFlags();
+    if (enableTiming)
+        flags &= ~hipEventDisableTiming;
+    hipError_t result = hipEventCreateWithFlags(&event, flags);
     if (result != hipSuccess)
         throw OpenMMException("Error creating HIP event:"+HipContext::getErrorString(result));
     eventCreated = true;
@@ -54,3 +57,11 @@ void HipEvent::wait() {
 void HipEvent::queueWait(ComputeQueue queue) {
     hipStreamWaitEvent(dynamic_cast<HipQueue*>(queue.get())->getStream(), event, 0);
 }
+
+double HipEvent::getElapsedTime(ComputeEventImpl& start) {
+    float time;
+    hipError_t result = hipEventElapsedTime(&time, dynamic_cast<HipEvent&>(start).event, event);
+    if (result != hipSuccess)
+        throw OpenMMException("Error computing elapsed time between HIP events: "+HipContext::getErrorString(result));
+    return time;
+}
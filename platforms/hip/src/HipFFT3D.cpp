@@ -35,7 +35,8 @@
 using namespace OpenMM;
 using namespace std;
 
-HipFFT3D::HipFFT3D(HipContext& context, int xsize, int ysize, int zsize, bool realToComplex) : context(context) {
+HipFFT3D::HipFFT3D(HipContext& context, int xsize, int ysize, int zsize, bool realToComplex) : context(context),
+        convolutionApp(NULL), convolutionStatus(0) {
     deviceIndex = context.getDeviceIndex();
     size_t valueSize = context.getUseDoublePrecision() ? sizeof(double) : sizeof(float);
     inputBufferSize = zsize * ysize * xsize * valueSize;
@@ -46,7 +47,7 @@ HipFFT3D::HipFFT3D(HipContext& context, int xsize, int ysize, int zsize, bool re
         outputBufferSize = zsize * ysize * xsize * valueSize;
     }
 
-    VkFFTConfiguration configuration = {};
+    configuration = {};
     configuration.performR2C = realToComplex;
     configuration.device = &deviceIndex;
     configuration.num_streams = 1;
@@ -90,6 +91,7 @@ HipFFT3D::HipFFT3D(HipContext& context, int xsize, int ysize, int zsize, bool re
     if (cache.is_open()) {
         cacheContent.insert(cacheContent.begin(), istreambuf_iterator<char>(cache), istreambuf_iterator<char>());
         cache.close();
+        context.getKernelCache().recordUse(cacheFile);
         hasCache = true;
         // There is an existing cache, load VkFFT kernels from it
         configuration.loadApplicationFromString = 1;
@@ -116,6 +118,8 @@ HipFFT3D::HipFFT3D(HipContext& context, int xsize, int ysize, int zsize, bool re
             if (!out.fail()) {
                 if (rename(outputFile.c_str(), cacheFile.c_str()) != 0)
                     remove(outputFile.c_str());
+                else
+                    context.getKernelCache().recordNewFile(cacheFile);
             }
         }
         catch (...) {
@@ -127,6 +131,11 @@ HipFFT3D::HipFFT3D(HipContext& context, int xsize, int ysize, int zsize, bool re
 HipFFT3D::~HipFFT3D() {
     deleteVkFFT(app);
     delete app;
+    if (convolutionApp != NULL) {
+        if (convolutionStatus == 1)
+            deleteVkFFT(convolutionApp);
+        delete convolutionApp;
+    }
 }
 
 void HipFFT3D::execFFT(ArrayInterface& in, ArrayInterface& out, bool forward) {
@@ -145,6 +154,37 @@ void HipFFT3D::execFFT(ArrayInterface& in, ArrayInterface& out, bool forward) {
     }
 }
 
+bool HipFFT3D::supportsConvolution() {
+    if (convolutionStatus == 0) {
+        // Create a second application that multiplies by the kernel between the forward and
+        // inverse transforms.  If VkFFT cannot do it for this size, fall back to separate kernels.
+
+        VkFFTConfiguration convolutionConfig = configuration;
+        convolutionConfig.loadApplicationFromString = 0;
+        convolutionConfig.saveApplicationToString = 0;
+        convolutionConfig.performConvolution = 1;
+        convolutionConfig.coordinateFeatures = 1;
+        convolutionConfig.kernelSize = &outputBufferSize;
+        convolutionConfig.kernel = &kernelBuffer;
+        convolutionApp = new VkFFTApplication();
+        convolutionStatus = (initializeVkFFT(convolutionApp, convolutionConfig) == VKFFT_SUCCESS ? 1 : -1);
+    }
+    return (convolutionStatus == 1);
+}
+
+void HipFFT3D::execConvolution(ArrayInterface& in, ArrayInterface& out, ArrayInterface& kernel) {
+    if (!supportsConvolution())
+        throw OpenMMException("This FFT does not support convolution");
+    inputBuffer = context.unwrap(in).getDevicePointer();
+    outputBuffer = context.unwrap(out).getDevicePointer();
+    kernelBuffer = context.unwrap(kernel).getDevicePointer();
+    stream = context.getCurrentStream();
+    VkFFTResult fftResult = VkFFTAppend(convolutionApp, -1, NULL);
+    if (fftResult != VKFFT_SUCCESS) {
+        throw OpenMMException("Error executing VkFFTAppend: "+context.intToString(fftResult));
+    }
+}
+
 int HipFFT3D::findLegalDimension(int minimum) {
     if (minimum < 1)
         return 1;
@@ -40,7 +40,7 @@ using namespace std;
         throw OpenMMException(m.str());\
     }
 
-HipIntegrationUtilities::HipIntegrationUtilities(HipContext& context, const System& system) : IntegrationUtilities(context, system),
+HipIntegrationUtilities::HipIntegrationUtilities(HipContext& context, const System& system) : IntegrationUtilities(context, system, context.getPlatformData().useLincs),
         ccmaConvergedMemory(NULL) {
         CHECK_RESULT2(hipEventCreateWithFlags(&ccmaEvent, context.getEventFlags()), "Error creating event for CCMA");
         CHECK_RESULT2(hipHostMalloc((void**) &ccmaConvergedMemory, sizeof(int), context.getHostMallocFlags()), "Error allocating pinned memory");
@@ -94,7 +94,9 @@ void HipIntegrationUtilities::applyConstraintsImpl(bool constrainVelocities, dou
             shakeKernel->setArg(1, (float) tol);
         shakeKernel->execute(shakeAtoms.getSize());
     }
-    if (ccmaConstraintAtoms.isInitialized()) {
+    if (useLincs && ccmaConstraintAtoms.isInitialized())
+        applyLincs(constrainVelocities);
+    else if (ccmaConstraintAtoms.isInitialized()) {
         if (ccmaConstraintAtoms.getSize() <= 1024) {
             // Use the version of CCMA that runs in a single kernel with one workgroup.
             ccmaFullKernel->setArg(0, (int) constrainVelocities);
@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2008-2025 Stanford University and the Authors.      *
+ * Portions copyright (c) 2008-2026 Stanford University and the Authors.      *
  * Portions copyright (c) 2020-2022 Advanced Micro Devices, Inc.              *
  * Authors: Peter Eastman, Nicholas Curtis                                    *
  * Contributors:                                                              *
@@ -62,6 +62,13 @@ void HipCalcForcesAndEnergyKernel::initialize(const System& system) {
 void HipCalcForcesAndEnergyKernel::beginComputation(ContextImpl& context, bool includeForces, bool includeEnergy, int groups) {
     cu.setForcesValid(true);
     ContextSelector selector(cu);
+    if (cu.getProfilingEnabled())
+        cu.startProfilingInterval();
+    annotatingGroups = cu.getAnnotationsEnabled();
+    if (annotatingGroups)
+        cu.pushAnnotation(ComputeContext::getForceGroupsProfilingName(groups));
+    if (includeForces && !includeEnergy)
+        cu.beginGraphCapture("forces"+cu.intToString(groups));
     cu.clearAutoclearBuffers();
     cu.updateGlobalParamValues();
     for (auto computation : cu.getPreComputations())
@@ -76,21 +83,48 @@ void HipCalcForcesAndEnergyKernel::beginComputation(ContextImpl& context, bool i
 
 double HipCalcForcesAndEnergyKernel::finishComputation(ContextImpl& context, bool includeForces, bool includeEnergy, int groups, bool& valid) {
     ContextSelector selector(cu);
-    cu.getBondedUtilities().computeInteractions(groups);
+    cu.getBondedUtilities().computeInteractions(groups, includeForces);
     cu.getNonbondedUtilities().computeInteractions(groups, includeForces, includeEnergy);
     double sum = 0.0;
     for (auto computation : cu.getPostComputations())
         sum += computation->computeForceAndEnergy(includeForces, includeEnergy, groups);
-    cu.getIntegrationUtilities().distributeForcesFromVirtualSites();
+    if (includeForces)
+        cu.getIntegrationUtilities().distributeForcesFromVirtualSites();
     if (includeEnergy)
         sum += cu.reduceEnergy();
+    if (cu.isCapturingGraph()) {
+        // If the graph could not be launched, none of the work was done.  Capture is now disabled,
+        // so have the forces computed again without it.
+
+        if (cu.endGraphCapture())
+            cu.getNonbondedUtilities().checkNeighborListSizeAfterGraph(groups);
+        else
+            valid = false;
+    }
+    if (cu.getProfilingEnabled())
+        cu.endProfilingInterval(ComputeContext::getForceGroupsProfilingName(groups));
+    if (annotatingGroups)
+        cu.popAnnotation();
+    annotatingGroups = false;
     if (!cu.getForcesValid())
         valid = false;
     return sum;
 }
 
+void HipCalcForcesAndEnergyKernel::beginForce(ContextImpl& context, const Force& force, int groups) {
+    annotatingForce = (cu.getAnnotationsEnabled() && (groups&(1<<force.getForceGroup())) != 0);
+    if (annotatingForce)
+        cu.pushAnnotation(force.getName()+" (group "+cu.intToString(force.getForceGroup())+")");
+}
+
+void HipCalcForcesAndEnergyKernel::endForce(ContextImpl& context, const Force& force, int groups) {
+    if (annotatingForce)
+        cu.popAnnotation();
+    annotatingForce = false;
+}
+
 void HipCalcNonbondedForceKernel::initialize(const System& system, const NonbondedForce& force) {
     bool usePmeQueue = (!cu.getPlatformData().disablePmeStream && !cu.getPlatformData().useCpuPme);
     bool useFixedPointChargeSpreading = cu.getUseDoublePrecision() || !cu.getSupportsHardwareFloatGlobalAtomicAdd() || cu.getPlatformData().deterministicForces;
-    commonInitialize(system, force, usePmeQueue, false, useFixedPointChargeSpreading, cu.getPlatformData().useCpuPme);
+    commonInitialize(system, force, usePmeQueue, false, useFixedPointChargeSpreading, cu.getPlatformData().useCpuPme, true);
 }
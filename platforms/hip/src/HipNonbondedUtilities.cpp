@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2009-2025 Stanford University and the Authors.      *
+ * Portions copyright (c) 2009-2026 Stanford University and the Authors.      *
  * Portions copyright (c) 2020-2023 Advanced Micro Devices, Inc.              *
  * Authors: Peter Eastman, Nicholas Curtis                                    *
  * Contributors:                                                              *
@@ -160,6 +160,10 @@ static bool compareInt2(int2 a, int2 b) {
     return ((a.y < b.y) || (a.y == b.y && a.x < b.x));
 }
 
+static size_t findExclusionTile(const vector<int2>& tiles, int x, int y) {
+    return lower_bound(tiles.begin(), tiles.end(), make_int2(x, y), compareInt2)-tiles.begin();
+}
+
 static bool compareInt2LargeSIMD(int2 a, int2 b) {
     // This version is used on devices with SIMD width greater than tile size.  It puts diagonal tiles before off-diagonal
     // ones to reduce thread divergence.
@@ -191,33 +195,30 @@ void HipNonbondedUtilities::initialize(const System& system) {
     int numContexts = context.getPlatformData().contexts.size();
     setAtomBlockRange(context.getContextIndex()/(double) numContexts, (context.getContextIndex()+1)/(double) numContexts);
 
-    // Build a list of tiles that contain exclusions.
+    // Build a list of tiles that contain exclusions.  Each block of atoms is processed separately so the
+    // list can be built without any per-tile allocations, which matters for very large systems.
 
-    set<pair<int, int> > tilesWithExclusions;
-    for (int atom1 = 0; atom1 < (int) atomExclusions.size(); ++atom1) {
-        int x = atom1/HipContext::TileSize;
-        for (int j = 0; j < (int) atomExclusions[atom1].size(); ++j) {
-            int atom2 = atomExclusions[atom1][j];
-            int y = atom2/HipContext::TileSize;
-            tilesWithExclusions.insert(make_pair(max(x, y), min(x, y)));
-        }
-    }
     vector<int2> exclusionTilesVec;
-    for (set<pair<int, int> >::const_iterator iter = tilesWithExclusions.begin(); iter != tilesWithExclusions.end(); ++iter)
-        exclusionTilesVec.push_back(make_int2(iter->first, iter->second));
-    sort(exclusionTilesVec.begin(), exclusionTilesVec.end(), context.getSIMDWidth() <= 32 || !useNeighborList ? compareInt2 : compareInt2LargeSIMD);
-    exclusionTiles.initialize<int2>(context, exclusionTilesVec.size(), "exclusionTiles");
-    exclusionTiles.upload(exclusionTilesVec);
-    map<pair<int, int>, int> exclusionTileMap;
-    for (int i = 0; i < (int) exclusionTilesVec.size(); i++) {
-        int2 tile = exclusionTilesVec[i];
-        exclusionTileMap[make_pair(tile.x, tile.y)] = i;
+    vector<int> blocksForTile;
+    for (int x = 0; x < numAtomBlocks; x++) {
+        blocksForTile.clear();
+        int lastAtom = min((x+1)*HipContext::TileSize, (int) atomExclusions.size());
+        for (int atom1 = x*HipContext::TileSize; atom1 < lastAtom; ++atom1)
+            for (int atom2 : atomExclusions[atom1])
+                blocksForTile.push_back(atom2/HipContext::TileSize);
+        sort(blocksForTile.begin(), blocksForTile.end());
+        blocksForTile.erase(unique(blocksForTile.begin(), blocksForTile.end()), blocksForTile.end());
+        for (int y : blocksForTile)
+            exclusionTilesVec.push_back(make_int2(max(x, y), min(x, y)));
     }
+    sort(exclusionTilesVec.begin(), exclusionTilesVec.end(), compareInt2);
+    exclusionTilesVec.erase(unique(exclusionTilesVec.begin(), exclusionTilesVec.end(), [](int2 a, int2 b) { return a.x == b.x && a.y == b.y; }), exclusionTilesVec.end());
+    context.initializeSharedArray(exclusionTiles, exclusionTilesVec, "exclusionTiles");
     vector<vector<int> > exclusionBlocksForBlock(numAtomBlocks);
-    for (set<pair<int, int> >::const_iterator iter = tilesWithExclusions.begin(); iter != tilesWithExclusions.end(); ++iter) {
-        exclusionBlocksForBlock[iter->first].push_back(iter->second);
-        if (iter->first != iter->second)
-            exclusionBlocksForBlock[iter->second].push_back(iter->first);
+    for (int2 tile : exclusionTilesVec) {
+        exclusionBlocksForBlock[tile.x].push_back(tile.y);
+        if (tile.x != tile.y)
+            exclusionBlocksForBlock[tile.y].push_back(tile.x);
     }
     vector<unsigned int> exclusionRowIndicesVec(numAtomBlocks+1, 0);
     vector<unsigned int> exclusionIndicesVec;
@@ -228,16 +229,13 @@ void HipNonbondedUtilities::initialize(const System& system) {
     maxExclusions = 0;
     for (int i = 0; i < (int) exclusionBlocksForBlock.size(); i++)
         maxExclusions = (maxExclusions > exclusionBlocksForBlock[i].size() ? maxExclusions : exclusionBlocksForBlock[i].size());
-    exclusionIndices.initialize<unsigned int>(context, exclusionIndicesVec.size(), "exclusionIndices");
-    exclusionRowIndices.initialize<unsigned int>(context, exclusionRowIndicesVec.size(), "exclusionRowIndices");
-    exclusionIndices.upload(exclusionIndicesVec);
-    exclusionRowIndices.upload(exclusionRowIndicesVec);
+    context.initializeSharedArray(exclusionIndices, exclusionIndicesVec, "exclusionIndices");
+    context.initializeSharedArray(exclusionRowIndices, exclusionRowIndicesVec, "exclusionRowIndices");
 
     // Record the exclusion data.
 
-    exclusions.initialize<tileflags>(context, tilesWithExclusions.size()*HipContext::TileSize, "exclusions");
     tileflags allFlags = (tileflags) -1;
-    vector<tileflags> exclusionVec(exclusions.getSize(), allFlags);
+    vector<tileflags> exclusionVec(exclusionTilesVec.size()*HipContext::TileSize, allFlags);
     for (int atom1 = 0; atom1 < (int) atomExclusions.size(); ++atom1) {
         int x = atom1/HipContext::TileSize;
         int offset1 = atom1-x*HipContext::TileSize;
@@ -246,17 +244,17 @@ void HipNonbondedUtilities::initialize(const System& system) {
             int y = atom2/HipContext::TileSize;
             int offset2 = atom2-y*HipContext::TileSize;
             if (x > y) {
-                int index = exclusionTileMap[make_pair(x, y)]*HipContext::TileSize;
+                size_t index = findExclusionTile(exclusionTilesVec, x, y)*HipContext::TileSize;
                 exclusionVec[index+offset1] &= allFlags-(1<<offset2);
             }
             else {
-                int index = exclusionTileMap[make_pair(y, x)]*HipContext::TileSize;
+                size_t index = findExclusionTile(exclusionTilesVec, y, x)*HipContext::TileSize;
                 exclusionVec[index+offset2] &= allFlags-(1<<offset1);
             }
         }
     }
     atomExclusions.clear(); // We won't use this again, so free the memory it used
-    exclusions.upload(exclusionVec);
+    context.initializeSharedArray(exclusions, exclusionVec, "exclusions");
 
     // Create data structures for the neighbor list.
 
@@ -274,7 +272,7 @@ void HipNonbondedUtilities::initialize(const System& system) {
         // HIP-TODO: This may require tuning
         numTilesInBatch = numAtomBlocks < 2000 ? 4 : 1;
         interactingTiles.initialize<int>(context, maxTiles, "interactingTiles");
-        interactingAtoms.initialize<int>(context, HipContext::TileSize*maxTiles, "interactingAtoms");
+        interactingAtoms.initialize<int>(context, HipContext::TileSize*(size_t) maxTiles, "interactingAtoms");
         interactionCount.initialize<unsigned int>(context, 2, "interactionCount");
         singlePairs.initialize<int2>(context, maxSinglePairs, "singlePairs");
         int elementSize = (context.getUseDoublePrecision() ? sizeof(double) : sizeof(float));
@@ -420,11 +418,20 @@ void HipNonbondedUtilities::prepareInteractions(int forceGroups) {
     }
     if (!useNeighborList)
         return;
-    if (numTiles == 0)
+    if (numTiles == 0) {
+        // This context has no tiles to process, but the interaction count may be left over from
+        // before its range of blocks was changed.  Clear it so the interaction kernel skips it.
+
+        if (forceRebuildNeighborList) {
+            context.clearBuffer(interactionCount);
+            forceRebuildNeighborList = false;
+        }
         return;
+    }
 
     // Compute the neighbor list.
 
+    ComputeContext::Annotation annotation(context, "buildNeighborList");
     context.executeKernelFlat(kernels.findBlockBoundsKernel, &findBlockBoundsArgs[0], context.getPaddedNumAtoms(), context.getSIMDWidth());
     context.executeKernelFlat(kernels.computeSortKeysKernel, &computeSortKeysArgs[0], context.getNumAtomBlocks());
     blockSorter->sort(sortedBlocks);
@@ -432,7 +439,8 @@ void HipNonbondedUtilities::prepareInteractions(int forceGroups) {
     context.executeKernelFlat(kernels.findInteractingBlocksKernel, &findInteractingBlocksArgs[0], context.getNumAtomBlocks() * context.getSIMDWidth() * numTilesInBatch, findInteractingBlocksThreadBlockSize);
     forceRebuildNeighborList = false;
     context.executeKernelFlat(kernels.copyInteractionCountsKernel, &copyInteractionCountsArgs[0], 1, 1);
-    hipEventRecord(downloadCountEvent, context.getCurrentStream());
+    if (!context.isCapturingGraph())
+        hipEventRecord(downloadCountEvent, context.getCurrentStream());
 }
 
 void HipNonbondedUtilities::initParamArgs() {
@@ -456,7 +464,17 @@ void HipNonbondedUtilities::computeInteractions(int forceGroups, bool includeFor
             initParamArgs();
         context.executeKernelFlat(kernel, &forceArgs[0], numForceThreadBlocks*forceThreadBlockSize, forceThreadBlockSize);
     }
+    if (useNeighborList && numTiles > 0 && !context.isCapturingGraph()) {
+        hipEventSynchronize(downloadCountEvent);
+        updateNeighborListSize();
+    }
+}
+
+void HipNonbondedUtilities::checkNeighborListSizeAfterGraph(int forceGroups) {
+    if ((forceGroups&groupFlags) == 0)
+        return;
     if (useNeighborList && numTiles > 0) {
+        hipEventRecord(downloadCountEvent, context.getCurrentStream());
         hipEventSynchronize(downloadCountEvent);
         updateNeighborListSize();
     }
@@ -478,7 +496,7 @@ bool HipNonbondedUtilities::updateNeighborListSize() {
     if (pinnedCountBuffer[0] > maxTiles) {
         maxTiles = (unsigned int) (1.2*pinnedCountBuffer[0]);
         unsigned int numBlocks = context.getNumAtomBlocks();
-        int totalTiles = numBlocks*(numBlocks+1)/2;
+        long long totalTiles = numBlocks*((long long) numBlocks+1)/2;
         if (maxTiles > totalTiles)
             maxTiles = totalTiles;
         interactingTiles.resize(maxTiles);
@@ -590,7 +608,6 @@ void HipNonbondedUtilities::createKernelsForGroups(int groups) {
 hipFunction_t HipNonbondedUtilities::createInteractionKernel(const string& source, vector<ComputeParameterInfo>& params, vector<ComputeParameterInfo>& arguments, bool useExclusions, bool isSymmetric, int groups, bool includeForces, bool includeEnergy) {
     map<string, string> replacements;
     replacements["COMPUTE_INTERACTION"] = source;
-    const string suffixes[] = {"x", "y", "z", "w"};
     stringstream args;
     for (const ComputeParameterInfo& param : params) {
         args << ", ";
@@ -626,19 +643,9 @@ hipFunction_t HipNonbondedUtilities::createInteractionKernel(const string& sourc
     // Part 1. Defines for on diagonal exclusion tiles
 
     stringstream broadcastWarpData;
-    broadcastWarpData << "posq2.x = SHFL(shflPosq.x, j);\n";
-    broadcastWarpData << "posq2.y = SHFL(shflPosq.y, j);\n";
-    broadcastWarpData << "posq2.z = SHFL(shflPosq.z, j);\n";
-    broadcastWarpData << "posq2.w = SHFL(shflPosq.w, j);\n";
-    for (const ComputeParameterInfo& param : params) {
-        broadcastWarpData << param.getType() << " shfl" << param.getName() << ";\n";
-        for (int j = 0; j < param.getNumComponents(); j++) {
-            if (param.getNumComponents() == 1)
-                broadcastWarpData << "shfl" << param.getName() << "=SHFL(" << param.getName() <<"1,j);\n";
-            else
-                broadcastWarpData << "shfl" << param.getName()+"."+suffixes[j] << "=SHFL(" << param.getName()+"1."+suffixes[j] <<",j);\n";
-        }
-    }
+    broadcastWarpData << "posq2 = tileBroadcast(shflPosq, j);\n";
+    for (const ComputeParameterInfo& param : params)
+        broadcastWarpData << param.getType() << " shfl" << param.getName() << " = tileBroadcast(" << param.getName() << "1, j);\n";
     replacements["BROADCAST_WARP_DATA"] = broadcastWarpData.str();
 
     // Part 2. Defines for off-diagonal exclusions, and neighborlist tiles.
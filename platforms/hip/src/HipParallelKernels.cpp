@@ -151,8 +151,28 @@ void HipParallelCalcForcesAndEnergyKernel::initialize(const System& system) {
     int numContexts = data.contexts.size();
     for (int i = 0; i < numContexts; i++)
         getKernel(i).initialize(system);
-    for (int i = 0; i < numContexts; i++)
-        contextNonbondedFractions[i] = 1/(double) numContexts;
+
+    // If requested, reserve the first device for reciprocal space PME.  It still computes bonded
+    // interactions, but the direct space nonbonded work is split between the other devices.  Since atoms
+    // are sorted spatially, each device's range of atom blocks corresponds to a compact region of space.
+
+    dedicatedPmeDevice = false;
+    if (data.dedicatedPmeDevice && !data.useCpuPme) {
+        for (int i = 0; i < system.getNumForces(); i++) {
+            const NonbondedForce* nonbonded = dynamic_cast<const NonbondedForce*>(&system.getForce(i));
+            if (nonbonded != NULL && (nonbonded->getNonbondedMethod() == NonbondedForce::PME || nonbonded->getNonbondedMethod() == NonbondedForce::LJPME))
+                dedicatedPmeDevice = true;
+        }
+    }
+    if (dedicatedPmeDevice) {
+        contextNonbondedFractions[0] = 0.0;
+        for (int i = 1; i < numContexts; i++)
+            contextNonbondedFractions[i] = 1/(double) (numContexts-1);
+    }
+    else {
+        for (int i = 0; i < numContexts; i++)
+            contextNonbondedFractions[i] = 1/(double) numContexts;
+    }
     CHECK_RESULT(hipEventCreateWithFlags(&event, cu.getEventFlags()), "Error creating event");
     peerCopyEvent.resize(numContexts);
     peerCopyEventLocal.resize(numContexts);
@@ -175,6 +195,7 @@ void HipParallelCalcForcesAndEnergyKernel::beginComputation(ContextImpl& context
             CHECK_RESULT(hipHostMalloc((void**) &pinnedForceBuffer, 3*(data.contexts.size()-1)*cu.getPaddedNumAtoms()*sizeof(long long), hipHostMallocPortable), "Error allocating pinned memory");
             CHECK_RESULT(hipHostMalloc(&pinnedPositionBuffer, cu.getPaddedNumAtoms()*(cu.getUseDoublePrecision() ? sizeof(double4) : sizeof(float4)), hipHostMallocPortable), "Error allocating pinned memory");
         }
+        updateNonbondedRanges();
     }
 
     // Copy coordinates over to each device and execute the kernel.
@@ -235,9 +256,9 @@ double HipParallelCalcForcesAndEnergyKernel::finishComputation(ContextImpl& cont
         // finished last to the one that finished first.
 
         if (cu.getComputeForceCount() < 200) {
-            int firstIndex = 0, lastIndex = 0;
+            int firstIndex = (dedicatedPmeDevice ? 1 : 0), lastIndex = firstIndex;
             const double eps = 0.001;
-            for (int i = 0; i < (int) completionTimes.size(); i++) {
+            for (int i = firstIndex; i < (int) completionTimes.size(); i++) {
                 if (completionTimes[i] < completionTimes[firstIndex])
                     firstIndex = i;
                 if (contextNonbondedFractions[lastIndex] < eps || completionTimes[i] > completionTimes[lastIndex])
@@ -246,19 +267,23 @@ double HipParallelCalcForcesAndEnergyKernel::finishComputation(ContextImpl& cont
             double fractionToTransfer = min(cu.getComputeForceCount() < 100 ? 0.01 : 0.001, contextNonbondedFractions[lastIndex]);
             contextNonbondedFractions[firstIndex] += fractionToTransfer;
             contextNonbondedFractions[lastIndex] -= fractionToTransfer;
-            double startFraction = 0.0;
-            for (int i = 0; i < (int) contextNonbondedFractions.size(); i++) {
-                double endFraction = startFraction+contextNonbondedFractions[i];
-                if (i == contextNonbondedFractions.size()-1)
-                    endFraction = 1.0; // Avoid roundoff error
-                data.contexts[i]->getNonbondedUtilities().setAtomBlockRange(startFraction, endFraction);
-                startFraction = endFraction;
-            }
+            updateNonbondedRanges();
         }
     }
     return energy;
 }
 
+void HipParallelCalcForcesAndEnergyKernel::updateNonbondedRanges() {
+    double startFraction = 0.0;
+    for (int i = 0; i < (int) contextNonbondedFractions.size(); i++) {
+        double endFraction = startFraction+contextNonbondedFractions[i];
+        if (i == contextNonbondedFractions.size()-1)
+            endFraction = 1.0; // Avoid roundoff error
+        data.contexts[i]->getNonbondedUtilities().setAtomBlockRange(startFraction, endFraction);
+        startFraction = endFraction;
+    }
+}
+
 class HipParallelCalcNonbondedForceKernel::Task : public HipContext::WorkTask {
 public:
     Task(ContextImpl& context, HipCalcNonbondedForceKernel& kernel, bool includeForce,
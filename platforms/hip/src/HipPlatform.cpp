@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2008-2025 Stanford University and the Authors.      *
+ * Portions copyright (c) 2008-2026 Stanford University and the Authors.      *
  * Portions copyright (c) 2020 Advanced Micro Devices, Inc.                   *
  * Authors: Peter Eastman, Nicholas Curtis                                    *
  * Contributors:                                                              *
@@ -31,6 +31,7 @@
 #include "HipKernelFactory.h"
 #include "HipKernels.h"
 #include "openmm/Context.h"
+#include "openmm/common/ContextSelector.h"
 #include "openmm/System.h"
 #include "openmm/internal/ContextImpl.h"
 #include "openmm/internal/hardware.h"
@@ -76,6 +77,7 @@ HipPlatform::HipPlatform() {
     registerKernelFactory(UpdateStateDataKernel::Name(), factory);
     registerKernelFactory(ApplyConstraintsKernel::Name(), factory);
     registerKernelFactory(VirtualSitesKernel::Name(), factory);
+    registerKernelFactory(MinimizeKernel::Name(), factory);
     registerKernelFactory(CalcHarmonicBondForceKernel::Name(), factory);
     registerKernelFactory(CalcCustomBondForceKernel::Name(), factory);
     registerKernelFactory(CalcHarmonicAngleForceKernel::Name(), factory);
@@ -100,6 +102,7 @@ HipPlatform::HipPlatform() {
     registerKernelFactory(IntegrateVerletStepKernel::Name(), factory);
     registerKernelFactory(IntegrateNoseHooverStepKernel::Name(), factory);
     registerKernelFactory(IntegrateLangevinMiddleStepKernel::Name(), factory);
+    registerKernelFactory(IntegrateMTSLangevinStepKernel::Name(), factory);
     registerKernelFactory(IntegrateBrownianStepKernel::Name(), factory);
     registerKernelFactory(IntegrateVariableVerletStepKernel::Name(), factory);
     registerKernelFactory(IntegrateVariableLangevinStepKernel::Name(), factory);
@@ -107,6 +110,7 @@ HipPlatform::HipPlatform() {
     registerKernelFactory(IntegrateDPDStepKernel::Name(), factory);
     registerKernelFactory(ApplyAndersenThermostatKernel::Name(), factory);
     registerKernelFactory(ApplyMonteCarloBarostatKernel::Name(), factory);
+    registerKernelFactory(CalcProtocolWorkKernel::Name(), factory);
     registerKernelFactory(RemoveCMMotionKernel::Name(), factory);
     registerKernelFactory(CalcATMForceKernel::Name(), factory);
     platformProperties.push_back(HipDeviceIndex());
@@ -117,6 +121,14 @@ HipPlatform::HipPlatform() {
     platformProperties.push_back(HipTempDirectory());
     platformProperties.push_back(HipDisablePmeStream());
     platformProperties.push_back(HipDeterministicForces());
+    platformProperties.push_back(HipEnableProfiling());
+    platformProperties.push_back(HipEnableAnnotations());
+    platformProperties.push_back(HipUseGraphs());
+    platformProperties.push_back(HipDedicatedPmeDevice());
+    platformProperties.push_back(HipCacheDirectory());
+    platformProperties.push_back(HipConstraintAlgorithm());
+    platformProperties.push_back(HipDeviceMemoryBudget());
+    platformProperties.push_back(HipShareParameters());
     setPropertyDefaultValue(HipDeviceIndex(), "");
     setPropertyDefaultValue(HipDeviceName(), "");
     setPropertyDefaultValue(HipUseBlockingSync(), "true");
@@ -124,6 +136,14 @@ HipPlatform::HipPlatform() {
     setPropertyDefaultValue(HipUseCpuPme(), "false");
     setPropertyDefaultValue(HipDisablePmeStream(), "false");
     setPropertyDefaultValue(HipDeterministicForces(), "false");
+    setPropertyDefaultValue(HipEnableProfiling(), "false");
+    setPropertyDefaultValue(HipEnableAnnotations(), "false");
+    setPropertyDefaultValue(HipUseGraphs(), "false");
+    setPropertyDefaultValue(HipDedicatedPmeDevice(), "false");
+    setPropertyDefaultValue(HipCacheDirectory(), "");
+    setPropertyDefaultValue(HipConstraintAlgorithm(), "ccma");
+    setPropertyDefaultValue(HipDeviceMemoryBudget(), "");
+    setPropertyDefaultValue(HipShareParameters(), "false");
 #ifdef _MSC_VER
     setPropertyDefaultValue(HipTempDirectory(), string(getenv("TEMP")));
 #else
@@ -159,6 +179,72 @@ const string& HipPlatform::getPropertyValue(const Context& context, const string
 void HipPlatform::setPropertyValue(Context& context, const string& property, const string& value) const {
 }
 
+map<string, pair<int, double> > HipPlatform::getKernelTimings(Context& context) const {
+    ContextImpl& impl = getContextImpl(context);
+    PlatformData* data = reinterpret_cast<PlatformData*>(impl.getPlatformData());
+    data->syncContexts();
+    map<string, pair<int, double> > timings;
+    for (HipContext* cu : data->contexts) {
+        ContextSelector selector(*cu);
+        for (auto& t : cu->getProfilingTimes()) {
+            timings[t.first].first += t.second.first;
+            timings[t.first].second += t.second.second;
+        }
+    }
+    return timings;
+}
+
+void HipPlatform::resetKernelTimings(Context& context) const {
+    ContextImpl& impl = getContextImpl(context);
+    PlatformData* data = reinterpret_cast<PlatformData*>(impl.getPlatformData());
+    data->syncContexts();
+    for (HipContext* cu : data->contexts) {
+        ContextSelector selector(*cu);
+        cu->resetProfilingTimes();
+    }
+}
+
+map<string, map<string, long long> > HipPlatform::getMemoryUsage(Context& context) const {
+    ContextImpl& impl = getContextImpl(context);
+    PlatformData* data = reinterpret_cast<PlatformData*>(impl.getPlatformData());
+    map<string, map<string, long long> > usage;
+    for (HipContext* cu : data->contexts)
+        for (auto& owner : cu->getMemoryUsage())
+            for (auto& array : owner.second)
+                usage[owner.first][array.first] += array.second;
+    return usage;
+}
+
+void HipPlatform::getDeviceArray(Context& context, const string& name, long long& pointer, vector<int>& shape, string& type, int& deviceIndex) const {
+    ContextImpl& impl = getContextImpl(context);
+    PlatformData* data = reinterpret_cast<PlatformData*>(impl.getPlatformData());
+    data->syncContexts();
+    HipContext& cu = *data->contexts[0];
+    ContextSelector selector(cu);
+    CHECK_RESULT(hipDeviceSynchronize(), "Error synchronizing HIP device");
+    HipArray* array;
+    int paddedNumAtoms = cu.getPaddedNumAtoms();
+    if (name == "posq" || name == "velm" || (name == "posqCorrection" && cu.getUseMixedPrecision())) {
+        array = (name == "posq" ? &cu.getPosq() : name == "velm" ? &cu.getVelm() : &cu.getPosqCorrection());
+        shape = {paddedNumAtoms, 4};
+        type = "<f"+to_string(array->getElementSize()/4);
+    }
+    else if (name == "force") {
+        array = &cu.getForce();
+        shape = {3, paddedNumAtoms};
+        type = "<i8";
+    }
+    else if (name == "atomIndex") {
+        array = &cu.getAtomIndexArray();
+        shape = {paddedNumAtoms};
+        type = "<i4";
+    }
+    else
+        throw OpenMMException("getDeviceArray: Unknown array name '"+name+"'");
+    pointer = (long long) array->getDevicePointer();
+    deviceIndex = cu.getDeviceIndex();
+}
+
 void HipPlatform::contextCreated(ContextImpl& context, const map<string, string>& properties) const {
     const string& devicePropValue = (properties.find(HipDeviceIndex()) == properties.end() ?
             getPropertyDefaultValue(HipDeviceIndex()) : properties.find(HipDeviceIndex())->second);
@@ -174,11 +260,33 @@ void HipPlatform::contextCreated(ContextImpl& context, const map<string, string>
             getPropertyDefaultValue(HipDisablePmeStream()) : properties.find(HipDisablePmeStream())->second);
     string deterministicForcesValue = (properties.find(HipDeterministicForces()) == properties.end() ?
             getPropertyDefaultValue(HipDeterministicForces()) : properties.find(HipDeterministicForces())->second);
+    string profilingPropValue = (properties.find(HipEnableProfiling()) == properties.end() ?
+            getPropertyDefaultValue(HipEnableProfiling()) : properties.find(HipEnableProfiling())->second);
+    string annotationsPropValue = (properties.find(HipEnableAnnotations()) == properties.end() ?
+            getPropertyDefaultValue(HipEnableAnnotations()) : properties.find(HipEnableAnnotations())->second);
+    string graphsPropValue = (properties.find(HipUseGraphs()) == properties.end() ?
+            getPropertyDefaultValue(HipUseGraphs()) : properties.find(HipUseGraphs())->second);
+    string dedicatedPmePropValue = (properties.find(HipDedicatedPmeDevice()) == properties.end() ?
+            getPropertyDefaultValue(HipDedicatedPmeDevice()) : properties.find(HipDedicatedPmeDevice())->second);
+    const string& cacheDirPropValue = (properties.find(HipCacheDirectory()) == properties.end() ?
+            getPropertyDefaultValue(HipCacheDirectory()) : properties.find(HipCacheDirectory())->second);
+    string constraintAlgorithmPropValue = (properties.find(HipConstraintAlgorithm()) == properties.end() ?
+            getPropertyDefaultValue(HipConstraintAlgorithm()) : properties.find(HipConstraintAlgorithm())->second);
+    transform(constraintAlgorithmPropValue.begin(), constraintAlgorithmPropValue.end(), constraintAlgorithmPropValue.begin(), ::tolower);
+    const string& memoryBudgetPropValue = (properties.find(HipDeviceMemoryBudget()) == properties.end() ?
+            getPropertyDefaultValue(HipDeviceMemoryBudget()) : properties.find(HipDeviceMemoryBudget())->second);
+    string shareParametersPropValue = (properties.find(HipShareParameters()) == properties.end() ?
+            getPropertyDefaultValue(HipShareParameters()) : properties.find(HipShareParameters())->second);
+    transform(shareParametersPropValue.begin(), shareParametersPropValue.end(), shareParametersPropValue.begin(), ::tolower);
     transform(blockingPropValue.begin(), blockingPropValue.end(), blockingPropValue.begin(), ::tolower);
     transform(precisionPropValue.begin(), precisionPropValue.end(), precisionPropValue.begin(), ::tolower);
     transform(cpuPmePropValue.begin(), cpuPmePropValue.end(), cpuPmePropValue.begin(), ::tolower);
     transform(pmeStreamPropValue.begin(), pmeStreamPropValue.end(), pmeStreamPropValue.begin(), ::tolower);
     transform(deterministicForcesValue.begin(), deterministicForcesValue.end(), deterministicForcesValue.begin(), ::tolower);
+    transform(profilingPropValue.begin(), profilingPropValue.end(), profilingPropValue.begin(), ::tolower);
+    transform(annotationsPropValue.begin(), annotationsPropValue.end(), annotationsPropValue.begin(), ::tolower);
+    transform(graphsPropValue.begin(), graphsPropValue.end(), graphsPropValue.begin(), ::tolower);
+    transform(dedicatedPmePropValue.begin(), dedicatedPmePropValue.end(), dedicatedPmePropValue.begin(), ::tolower);
     vector<string> pmeKernelName;
     pmeKernelName.push_back(CalcPmeReciprocalForceKernel::Name());
     if (!supportsKernels(pmeKernelName))
@@ -188,7 +296,7 @@ void HipPlatform::contextCreated(ContextImpl& context, const map<string, string>
     if (threadsEnv != NULL)
         stringstream(threadsEnv) >> threads;
     context.setPlatformData(new PlatformData(&context, context.getSystem(), devicePropValue, blockingPropValue, precisionPropValue, cpuPmePropValue, tempPropValue,
-            pmeStreamPropValue, deterministicForcesValue, threads, NULL));
+            pmeStreamPropValue, deterministicForcesValue, profilingPropValue, graphsPropValue, dedicatedPmePropValue, memoryBudgetPropValue, shareParametersPropValue, annotationsPropValue, constraintAlgorithmPropValue, cacheDirPropValue, threads, NULL));
 }
 
 void HipPlatform::linkedContextCreated(ContextImpl& context, ContextImpl& originalContext) const {
@@ -200,9 +308,17 @@ void HipPlatform::linkedContextCreated(ContextImpl& context, ContextImpl& origin
     string tempPropValue = platform.getPropertyValue(originalContext.getOwner(), HipTempDirectory());
     string pmeStreamPropValue = platform.getPropertyValue(originalContext.getOwner(), HipDisablePmeStream());
     string deterministicForcesValue = platform.getPropertyValue(originalContext.getOwner(), HipDeterministicForces());
+    string profilingPropValue = platform.getPropertyValue(originalContext.getOwner(), HipEnableProfiling());
+    string annotationsPropValue = platform.getPropertyValue(originalContext.getOwner(), HipEnableAnnotations());
+    string graphsPropValue = platform.getPropertyValue(originalContext.getOwner(), HipUseGraphs());
+    string dedicatedPmePropValue = platform.getPropertyValue(originalContext.getOwner(), HipDedicatedPmeDevice());
+    string cacheDirPropValue = platform.getPropertyValue(originalContext.getOwner(), HipCacheDirectory());
+    string constraintAlgorithmPropValue = platform.getPropertyValue(originalContext.getOwner(), HipConstraintAlgorithm());
+    string memoryBudgetPropValue = platform.getPropertyValue(originalContext.getOwner(), HipDeviceMemoryBudget());
+    string shareParametersPropValue = platform.getPropertyValue(originalContext.getOwner(), HipShareParameters());
     int threads = reinterpret_cast<PlatformData*>(originalContext.getPlatformData())->threads.getNumThreads();
     context.setPlatformData(new PlatformData(&context, context.getSystem(), devicePropValue, blockingPropValue, precisionPropValue, cpuPmePropValue, tempPropValue,
-            pmeStreamPropValue, deterministicForcesValue, threads, &originalContext));
+            pmeStreamPropValue, deterministicForcesValue, profilingPropValue, graphsPropValue, dedicatedPmePropValue, memoryBudgetPropValue, shareParametersPropValue, annotationsPropValue, constraintAlgorithmPropValue, cacheDirPropValue, threads, &originalContext));
 }
 
 void HipPlatform::contextDestroyed(ContextImpl& context) const {
@@ -212,9 +328,23 @@ void HipPlatform::contextDestroyed(ContextImpl& context) const {
 
 HipPlatform::PlatformData::PlatformData(ContextImpl* context, const System& system, const string& deviceIndexProperty, const string& blockingProperty, const string& precisionProperty,
             const string& cpuPmeProperty, const string& tempProperty, const string& pmeStreamProperty,
-            const string& deterministicForcesProperty, int numThreads, ContextImpl* originalContext) :
+            const string& deterministicForcesProperty, const string& profilingProperty, const string& graphsProperty,
+            const string& dedicatedPmeProperty, const string& memoryBudgetProperty, const string& shareParametersProperty, const string& annotationsProperty, const string& constraintAlgorithmProperty, const string& cacheDirProperty, int numThreads,
+            ContextImpl* originalContext) :
                 context(context), removeCM(false), stepCount(0), computeForceCount(0), time(0.0), hasInitializedContexts(false),
-                threads(numThreads) {
+                cacheDirectory(cacheDirProperty), threads(numThreads) {
+    memoryBudget = 0;
+    if (memoryBudgetProperty.size() > 0) {
+        double megabytes;
+        stringstream budgetStream(memoryBudgetProperty);
+        if (!(budgetStream >> megabytes) || megabytes < 0)
+            throw OpenMMException("Illegal value for DeviceMemoryBudget: "+memoryBudgetProperty);
+        memoryBudget = (long long) (megabytes*1048576.0);
+    }
+    if (constraintAlgorithmProperty != "ccma" && constraintAlgorithmProperty != "lincs")
+        throw OpenMMException("Illegal value for ConstraintAlgorithm: "+constraintAlgorithmProperty);
+    useLincs = (constraintAlgorithmProperty == "lincs");
+    shareParameters = (shareParametersProperty == "true");
     bool blocking = (blockingProperty == "true");
     vector<string> devices;
     size_t searchPos = 0, nextPos;
@@ -259,6 +389,14 @@ HipPlatform::PlatformData::PlatformData(ContextImpl* context, const System& syst
     useCpuPme = (cpuPmeProperty == "true" && !contexts[0]->getUseDoublePrecision());
     disablePmeStream = (pmeStreamProperty == "true");
     deterministicForces = (deterministicForcesProperty == "true");
+    enableProfiling = (profilingProperty == "true");
+    enableAnnotations = (annotationsProperty == "true");
+    useGraphs = (graphsProperty == "true");
+    dedicatedPmeDevice = (dedicatedPmeProperty == "true" && contexts.size() > 1);
+    for (HipContext* cu : contexts) {
+        cu->setProfilingEnabled(enableProfiling);
+        cu->setAnnotationsEnabled(enableAnnotations);
+    }
     propertyValues[HipPlatform::HipDeviceIndex()] = deviceIndex.str();
     propertyValues[HipPlatform::HipDeviceName()] = deviceName.str();
     propertyValues[HipPlatform::HipUseBlockingSync()] = blocking ? "true" : "false";
@@ -267,6 +405,14 @@ HipPlatform::PlatformData::PlatformData(ContextImpl* context, const System& syst
     propertyValues[HipPlatform::HipTempDirectory()] = tempProperty;
     propertyValues[HipPlatform::HipDisablePmeStream()] = disablePmeStream ? "true" : "false";
     propertyValues[HipPlatform::HipDeterministicForces()] = deterministicForces ? "true" : "false";
+    propertyValues[HipPlatform::HipEnableProfiling()] = enableProfiling ? "true" : "false";
+    propertyValues[HipPlatform::HipEnableAnnotations()] = enableAnnotations ? "true" : "false";
+    propertyValues[HipPlatform::HipUseGraphs()] = useGraphs ? "true" : "false";
+    propertyValues[HipPlatform::HipDedicatedPmeDevice()] = dedicatedPmeDevice ? "true" : "false";
+    propertyValues[HipPlatform::HipCacheDirectory()] = cacheDirProperty;
+    propertyValues[HipPlatform::HipConstraintAlgorithm()] = constraintAlgorithmProperty;
+    propertyValues[HipPlatform::HipDeviceMemoryBudget()] = memoryBudgetProperty;
+    propertyValues[HipPlatform::HipShareParameters()] = shareParameters ? "true" : "false";
     contextEnergy.resize(contexts.size());
 
     // Determine whether peer-to-peer copying is supported, and enable it if so.
@@ -236,12 +236,28 @@ public:
      * @param blocking if true, this call will block until the transfer is complete.
      */
     void download(void* data, bool blocking=true) const;
+    /**
+     * Copy a subset of the values in the device memory to an array.
+     * 
+     * @param data     the array to copy the memory to
+     * @param offset   the index of the element within the array at which the copy should begin
+     * @param elements the number of elements to copy
+     * @param blocking if true, this call will block until the transfer is complete.  If false,
+     *                 the destination array must be in page-locked memory.
+     */
+    void downloadSubArray(void* data, int offset, int elements, bool blocking=true) const;
     /**
      * Copy the values in the Buffer to a second OpenCLArray.
      * 
      * @param dest     the destination array to copy to
      */
     void copyTo(ArrayInterface& dest) const;
+    /**
+     * Get the cl_mem for the Buffer, cast to a void*.
+     */
+    void* getNativeHandle() {
+        return (void*) (*buffer)();
+    }
 private:
     OpenCLContext* context;
     cl::Buffer* buffer;
@@ -57,6 +57,7 @@
 #include "OpenCLNonbondedUtilities.h"
 #include "OpenCLPlatform.h"
 #include "openmm/common/ComputeContext.h"
+#include "openmm/common/KernelCache.h"
 
 namespace OpenMM {
 
@@ -224,6 +225,11 @@ public:
      * Construct a ComputeEvent object of the appropriate class for this platform.
      */
     ComputeEvent createEvent();
+    /**
+     * Construct a ComputeEvent object of the appropriate class for this platform that records
+     * device timestamps.  This requires the EnableProfiling property to have been set.
+     */
+    ComputeEvent createTimingEvent();
     /**
      * Construct a ComputeSort object of the appropriate class for this platform.
      * 
@@ -299,6 +305,12 @@ public:
     OpenCLArray& getEnergyBuffer() {
         return energyBuffer;
     }
+    /**
+     * Get the array into which reduceEnergy() sums the energy buffer.
+     */
+    OpenCLArray& getEnergySum() {
+        return energySum;
+    }
     /**
      * Get the array which contains the buffer in which derivatives of the energy with respect to parameters are computed.
      */
@@ -312,6 +324,17 @@ public:
     void* getPinnedBuffer() {
         return pinnedMemory;
     }
+    /**
+     * Allocate a new block of pinned memory that is owned by the caller.  It must be released by
+     * calling freePinnedMemory().
+     *
+     * @param size    the size of the block in bytes
+     */
+    void* allocatePinnedMemory(size_t size);
+    /**
+     * Release a block of memory that was allocated by allocatePinnedMemory().
+     */
+    void freePinnedMemory(void* memory);
     /**
      * Get a shared ThreadPool that code can use to parallelize operations.
      * 
@@ -507,6 +530,13 @@ public:
     bool getSupports64BitGlobalAtomics() const {
         return supports64BitGlobalAtomics;
     }
+    /**
+     * Get whether warps are synchronized with sub-group barriers.  This is true on Intel GPUs that allow
+     * kernels to require a sub-group size equal to the SIMD width.
+     */
+    bool getUseSubGroupBarriers() const {
+        return useSubGroupBarriers;
+    }
     /**
      * Get whether the device being used supports double precision math.
      */
@@ -648,15 +678,28 @@ public:
         return new OpenCLNonbondedUtilities(*this);
     }
     /**
-     * Create an object for performing 3D FFTs.  The caller is responsible for deleting
-     * the object when it is no longer needed.
+     * Get the name of the device this context is running on.
+     */
+    std::string getDeviceName();
+    /**
+     * Get the names of the FFT implementations that can perform transforms of a particular size.
+     *
+     * @param xsize   the first dimension of the data sets on which FFTs will be performed
+     * @param ysize   the second dimension of the data sets on which FFTs will be performed
+     * @param zsize   the third dimension of the data sets on which FFTs will be performed
+     * @param realToComplex  if true, a real-to-complex transform will be done.  Otherwise, it is complex-to-complex.
+     */
+    std::vector<std::string> getFFTBackends(int xsize, int ysize, int zsize, bool realToComplex);
+    /**
+     * Create an object for performing 3D FFTs with a specific implementation.
      *
+     * @param backend the name of the implementation to use, as returned by getFFTBackends()
      * @param xsize   the first dimension of the data sets on which FFTs will be performed
      * @param ysize   the second dimension of the data sets on which FFTs will be performed
      * @param zsize   the third dimension of the data sets on which FFTs will be performed
      * @param realToComplex  if true, a real-to-complex transform will be done.  Otherwise, it is complex-to-complex.
      */
-    FFT3D createFFT(int xsize, int ysize, int zsize, bool realToComplex=false);
+    FFT3D createFFTWithBackend(const std::string& backend, int xsize, int ysize, int zsize, bool realToComplex);
     /**
      * Get the smallest legal size for a dimension of the grid.
      */
@@ -713,10 +756,11 @@ private:
     int numThreadBlocks;
     int numForceBuffers;
     int simdWidth;
-    bool supports64BitGlobalAtomics, supportsDoublePrecision, useDoublePrecision, useMixedPrecision, boxIsTriclinic, hasAssignedPosqCharges;
+    bool supports64BitGlobalAtomics, supportsDoublePrecision, useDoublePrecision, useMixedPrecision, boxIsTriclinic, hasAssignedPosqCharges, useSubGroupBarriers;
     mm_float4 periodicBoxSize, invPeriodicBoxSize, periodicBoxVecX, periodicBoxVecY, periodicBoxVecZ;
     mm_double4 periodicBoxSizeDouble, invPeriodicBoxSizeDouble, periodicBoxVecXDouble, periodicBoxVecYDouble, periodicBoxVecZDouble;
     std::string defaultOptimizationOptions;
+    KernelCache kernelCache;
     std::map<std::string, std::string> compilationDefines;
     cl::Context context;
     cl::Device device;
@@ -732,6 +776,7 @@ private:
     cl::Kernel setChargesKernel;
     cl::Buffer* pinnedBuffer;
     void* pinnedMemory;
+    std::map<void*, cl::Buffer*> pinnedAllocations;
     OpenCLArray posq;
     OpenCLArray posqCorrection;
     OpenCLArray velm;
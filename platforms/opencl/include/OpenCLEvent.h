@@ -53,6 +53,11 @@ public:
      * operations started before the call to enqueue() have completed.
      */
     void queueWait(ComputeQueue queue);
+    /**
+     * Get the time in milliseconds that elapsed on the device between another event and this one.
+     * This requires the queue to have been created with profiling enabled.
+     */
+    double getElapsedTime(ComputeEventImpl& start);
 private:
     OpenCLContext& context;
     std::vector<cl::Event> event;
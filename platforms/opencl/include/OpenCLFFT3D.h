@@ -27,13 +27,11 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
  * -------------------------------------------------------------------------- */
 
-#define USE_VKFFT
+#include "OpenCLArray.h"
 
-#ifdef USE_VKFFT
 #define VKFFT_BACKEND 3
 #pragma clang diagnostic ignored "-Wdeprecated-declarations"
 #include "vkFFT.h"
-#endif
 #include "openmm/common/FFT3D.h"
 #include "openmm/common/ArrayInterface.h"
 
@@ -41,42 +39,27 @@ namespace OpenMM {
 
 class OpenCLContext;
 
-#ifdef USE_VKFFT
 /**
- * This class performs three dimensional Fast Fourier Transforms.  It uses the
- * VkFFT library (https://github.com/DTolm/VkFFT).
- *
- * This class is most efficient when the size of each dimension is a product of
- * small prime factors: 2, 3, 5, 7, 11, and 13.  You can call findLegalDimension()
- * to determine the smallest size that satisfies this requirement and is greater
- * than or equal to a specified minimum size.
- *
- * Note that this class performs an unnormalized transform.  That means that if you perform
- * a forward transform followed immediately by an inverse transform, the effect is to
- * multiply every value of the original data set by the total number of data points.
- */
-#else
-/**
- * This class performs three dimensional Fast Fourier Transforms.  It is based on the
- * mixed radix algorithm described in
+ * This class performs three dimensional Fast Fourier Transforms.  It has two implementations.
+ * The default is to use the VkFFT library (https://github.com/DTolm/VkFFT).  Alternatively it
+ * can use its own kernels, which are based on the mixed radix algorithm described in
  *
  * Takahashi, D. and Kanada, Y., "High-Performance Radix-2, 3 and 5 Parallel 1-D Complex
  * FFT Algorithms for Distributed-Memory Parallel Computers."  Journal of Supercomputing,
  * 15, 207–228 (2000).
  *
- * This class places certain restrictions on the allowed dimensions of the grid.  First,
- * the size of each dimension may have no prime factors other than 2, 3, 5, and 7.  You
- * can call findLegalDimension() to determine the smallest size that satisfies this
- * requirement and is greater than or equal to a specified minimum size.  Second, the size
- * of each dimension must be small enough to compute each 1D transform entirely in local
- * memory with one work unit per data point.  This will vary between platforms, but is
- * typically at least 512.
+ * The built in kernels compute each 1D transform in local memory, which can be faster than
+ * VkFFT for small grids.  OpenCLContext::createFFT() benchmarks both and picks the faster one.
+ *
+ * This class is most efficient when the size of each dimension is a product of small prime
+ * factors.  VkFFT supports the factors 2, 3, 5, 7, 11, and 13, while the built in kernels only
+ * support 2, 3, 5, and 7.  You can call findLegalDimension() to determine the smallest size
+ * that satisfies this requirement and is greater than or equal to a specified minimum size.
  *
  * Note that this class performs an unnormalized transform.  That means that if you perform
  * a forward transform followed immediately by an inverse transform, the effect is to
  * multiply every value of the original data set by the total number of data points.
  */
-#endif
 
 class OPENMM_EXPORT_COMMON OpenCLFFT3D : public FFT3DImpl {
 public:
@@ -88,11 +71,10 @@ public:
      * @param ysize   the second dimension of the data sets on which FFTs will be performed
      * @param zsize   the third dimension of the data sets on which FFTs will be performed
      * @param realToComplex  if true, a real-to-complex transform will be done.  Otherwise, it is complex-to-complex.
+     * @param useVkFFT       if true, VkFFT is used to perform the transforms.  Otherwise, the built in kernels are used.
      */
-    OpenCLFFT3D(OpenCLContext& context, int xsize, int ysize, int zsize, bool realToComplex=false);
-#ifdef USE_VKFFT
+    OpenCLFFT3D(OpenCLContext& context, int xsize, int ysize, int zsize, bool realToComplex=false, bool useVkFFT=true);
     ~OpenCLFFT3D();
-#endif
     /**
      * Perform a Fourier transform.  The transform cannot be done in-place: the input and output
      * arrays must be different.  Also, the input array is used as workspace, so its contents
@@ -107,26 +89,45 @@ public:
      * @param forward  true to perform a forward transform, false to perform an inverse transform
      */
     void execFFT(ArrayInterface& in, ArrayInterface& out, bool forward=true);
+    /**
+     * Get whether this object can perform fused convolutions with execConvolution().  This is
+     * supported when VkFFT is used.
+     */
+    bool supportsConvolution();
+    /**
+     * Convolve a data set with a kernel, fusing the multiplication into the transforms.  See
+     * FFT3DImpl::execConvolution() for details.
+     *
+     * @param in       the data to convolve.  On exit, this contains the result.
+     * @param out      used as workspace
+     * @param kernel   the complex values to multiply the transformed data by
+     */
+    void execConvolution(ArrayInterface& in, ArrayInterface& out, ArrayInterface& kernel);
     /**
      * Get the smallest legal size for a dimension of the grid (that is, a size with no unsupported
      * prime factors).
      *
      * @param minimum   the minimum size the return value must be greater than or equal to
+     * @param useVkFFT  whether the size is for a transform that uses VkFFT or the built in kernels
      */
-    static int findLegalDimension(int minimum);
+    static int findLegalDimension(int minimum, bool useVkFFT=true);
 private:
+    void initializeVkFFTApplication(bool realToComplex);
+    void initializeKernels(bool realToComplex);
+    void execVkFFT(ArrayInterface& in, ArrayInterface& out, bool forward);
+    void execKernels(ArrayInterface& in, ArrayInterface& out, bool forward);
+    cl::Kernel createKernel(int xsize, int ysize, int zsize, int& threads, int axis, bool forward, bool inputIsReal);
     int xsize, ysize, zsize;
     int xthreads, ythreads, zthreads;
-    bool packRealAsComplex;
+    bool packRealAsComplex, useVkFFT;
     OpenCLContext& context;
-#ifdef USE_VKFFT
-    VkFFTApplication app;
-#else
-    cl::Kernel createKernel(int xsize, int ysize, int zsize, int& threads, int axis, bool forward, bool inputIsReal);
+    VkFFTConfiguration config;
+    VkFFTApplication app, convolutionApp;
+    uint64_t kernelSize;
+    int convolutionStatus;
     cl::Kernel xkernel, ykernel, zkernel;
     cl::Kernel invxkernel, invykernel, invzkernel;
     cl::Kernel packForwardKernel, unpackForwardKernel, packBackwardKernel, unpackBackwardKernel;
-#endif
 };
 
 } // namespace OpenMM
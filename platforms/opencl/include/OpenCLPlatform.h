@@ -9,7 +9,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2008-2016 Stanford University and the Authors.      *
+ * Portions copyright (c) 2008-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -52,6 +52,9 @@ public:
     static bool isPlatformSupported();
     const std::string& getPropertyValue(const Context& context, const std::string& property) const;
     void setPropertyValue(Context& context, const std::string& property, const std::string& value) const;
+    std::map<std::string, std::pair<int, double> > getKernelTimings(Context& context) const;
+    void resetKernelTimings(Context& context) const;
+    std::map<std::string, std::map<std::string, long long> > getMemoryUsage(Context& context) const;
     void contextCreated(ContextImpl& context, const std::map<std::string, std::string>& properties) const;
     void linkedContextCreated(ContextImpl& context, ContextImpl& originalContext) const;
     void contextDestroyed(ContextImpl& context) const;
@@ -104,22 +107,59 @@ public:
         static const std::string key = "DisablePmeStream";
         return key;
     }
+    /**
+     * This is the name of the parameter for selecting whether to record the execution time of every kernel.
+     */
+    static const std::string& OpenCLEnableProfiling() {
+        static const std::string key = "EnableProfiling";
+        return key;
+    }
+    /**
+     * This is the name of the parameter for selecting the directory in which compiled kernels are
+     * stored.  If this is empty, the OPENMM_CACHE_DIR environment variable is used, or the temporary
+     * directory if that is not set.
+     */
+    static const std::string& OpenCLCacheDirectory() {
+        static const std::string key = "CacheDirectory";
+        return key;
+    }
+    /**
+     * This is the name of the parameter for setting the maximum amount of device memory, in megabytes,
+     * that arrays on each device may use.  If allocating an array would exceed it, an exception is
+     * thrown describing how memory is being used.  If this is empty, there is no limit.
+     */
+    static const std::string& OpenCLDeviceMemoryBudget() {
+        static const std::string key = "DeviceMemoryBudget";
+        return key;
+    }
+    /**
+     * This is the name of the parameter for selecting the algorithm used for constraints that cannot be
+     * handled by SETTLE or SHAKE.  Allowed values are "ccma" and "lincs".  LINCS uses a fixed number of
+     * iterations and ignores the constraint tolerance, but never needs to wait for the host to check
+     * whether it has converged.
+     */
+    static const std::string& OpenCLConstraintAlgorithm() {
+        static const std::string key = "ConstraintAlgorithm";
+        return key;
+    }
 };
 
 class OPENMM_EXPORT_COMMON OpenCLPlatform::PlatformData {
 public:
     PlatformData(const System& system, ContextImpl* context, const std::string& platformPropValue, const std::string& deviceIndexProperty, const std::string& precisionProperty,
-            const std::string& cpuPmeProperty, const std::string& pmeStreamProperty, int numThreads, ContextImpl* originalContext);
+            const std::string& cpuPmeProperty, const std::string& pmeStreamProperty, const std::string& profilingProperty, const std::string& memoryBudgetProperty, const std::string& constraintAlgorithmProperty, const std::string& cacheDirProperty, int numThreads, ContextImpl* originalContext);
     ~PlatformData();
     void initializeContexts(const System& system);
     void syncContexts();
     ContextImpl* context;
     std::vector<OpenCLContext*> contexts;
     std::vector<double> contextEnergy;
-    bool hasInitializedContexts, removeCM, useCpuPme, disablePmeStream;
+    bool hasInitializedContexts, removeCM, useCpuPme, disablePmeStream, enableProfiling, useLincs;
     int cmMotionFrequency, computeForceCount;
     long long stepCount;
     double time;
+    long long memoryBudget;
+    std::string cacheDirectory;
     std::map<std::string, std::string> propertyValues;
     ThreadPool threads;
 };
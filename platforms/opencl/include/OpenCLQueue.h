@@ -49,6 +49,12 @@ public:
     cl::CommandQueue getQueue() {
         return queue;
     }
+    /**
+     * Get the cl_command_queue, cast to a void*.
+     */
+    void* getNativeHandle() {
+        return (void*) queue();
+    }
 private:
     cl::CommandQueue queue;
 };
@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2012-2025 Stanford University and the Authors.      *
+ * Portions copyright (c) 2012-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -45,6 +45,8 @@ OpenCLArray::OpenCLArray(OpenCLContext& context, cl::Buffer* buffer, size_t size
 }
 
 OpenCLArray::~OpenCLArray() {
+    if (ownsBuffer)
+        context->recordArrayRelease(*this);
     if (buffer != NULL && ownsBuffer)
         delete buffer;
 }
@@ -62,12 +64,16 @@ void OpenCLArray::initialize(OpenCLContext& context, size_t size, int elementSiz
     this->name = name;
     this->flags = flags;
     ownsBuffer = true;
+    context.recordArrayAllocation(*this, size*elementSize);
     try {
         buffer = new cl::Buffer(context.getContext(), flags, size*elementSize);
     }
     catch (cl::Error err) {
+        context.recordArrayRelease(*this);
         std::stringstream str;
         str<<"Error creating array "<<name<<": "<<err.what()<<" ("<<err.err()<<")";
+        if (err.err() == CL_MEM_OBJECT_ALLOCATION_FAILURE || err.err() == CL_OUT_OF_RESOURCES)
+            str<<".  "<<context.getMemoryUsageReport();
         throw OpenMMException(str.str());
     }
 }
@@ -129,6 +135,21 @@ void OpenCLArray::download(void* data, bool blocking) const {
     }
 }
 
+void OpenCLArray::downloadSubArray(void* data, int offset, int elements, bool blocking) const {
+    if (buffer == NULL)
+        throw OpenMMException("OpenCLArray has not been initialized");
+    if (offset < 0 || offset+elements > getSize())
+        throw OpenMMException("downloadSubArray: data exceeds range of array");
+    try {
+        getQueue().enqueueReadBuffer(*buffer, blocking ? CL_TRUE : CL_FALSE, offset*elementSize, elements*elementSize, data);
+    }
+    catch (cl::Error err) {
+        std::stringstream str;
+        str<<"Error downloading array "<<name<<": "<<err.what()<<" ("<<err.err()<<")";
+        throw OpenMMException(str.str());
+    }
+}
+
 void OpenCLArray::copyTo(ArrayInterface& dest) const {
     if (buffer == NULL)
         throw OpenMMException("OpenCLArray has not been initialized");
@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2009-2025 Stanford University and the Authors.      *
+ * Portions copyright (c) 2009-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -47,6 +47,8 @@
 #include "openmm/VirtualSite.h"
 #include "openmm/internal/ContextImpl.h"
 #include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <set>
@@ -66,6 +68,9 @@ using namespace std;
 #ifndef CL_DEVICE_COMPUTE_CAPABILITY_MINOR_NV
   #define CL_DEVICE_COMPUTE_CAPABILITY_MINOR_NV 0x4001
 #endif
+#ifndef CL_DEVICE_SUB_GROUP_SIZES_INTEL
+  #define CL_DEVICE_SUB_GROUP_SIZES_INTEL 0x4108
+#endif
 
 const int OpenCLContext::ThreadBlockSize = 64;
 const int OpenCLContext::TileSize = 32;
@@ -77,6 +82,20 @@ static void CL_CALLBACK errorCallback(const char* errinfo, const void* private_i
     std::cerr << "OpenCL internal error: " << errinfo << std::endl;
 }
 
+/**
+ * Get the directory to store compiled kernels in when neither the CacheDirectory property
+ * nor the OPENMM_CACHE_DIR environment variable is set.
+ */
+static string getDefaultCacheDirectory() {
+#ifdef _MSC_VER
+    char* tmpdir = getenv("TEMP");
+    return (tmpdir == NULL ? string(".") : string(tmpdir));
+#else
+    char* tmpdir = getenv("TMPDIR");
+    return (tmpdir == NULL ? string(P_tmpdir) : string(tmpdir));
+#endif
+}
+
 static bool isSupported(cl::Platform platform) {
     string vendor = platform.getInfo<CL_PLATFORM_VENDOR>();
     return (vendor.find("NVIDIA") == 0 ||
@@ -86,8 +105,10 @@ static bool isSupported(cl::Platform platform) {
 }
 
 OpenCLContext::OpenCLContext(const System& system, int platformIndex, int deviceIndex, const string& precision, OpenCLPlatform::PlatformData& platformData, OpenCLContext* originalContext) :
-        ComputeContext(system), platformData(platformData), numForceBuffers(0), hasAssignedPosqCharges(false), profileStartTime(0),
-        integration(NULL), expression(NULL), bonded(NULL), nonbonded(NULL), pinnedBuffer(NULL) {
+        ComputeContext(system), platformData(platformData), numForceBuffers(0), hasAssignedPosqCharges(false), useSubGroupBarriers(false), profileStartTime(0),
+        integration(NULL), expression(NULL), bonded(NULL), nonbonded(NULL), pinnedBuffer(NULL),
+        kernelCache(platformData.cacheDirectory, getDefaultCacheDirectory(), "openmm-opencl-") {
+    setMemoryBudget(platformData.memoryBudget);
     if (precision == "single") {
         useDoublePrecision = false;
         useMixedPrecision = false;
@@ -288,13 +309,35 @@ OpenCLContext::OpenCLContext(const System& system, int platformIndex, int device
                     compilationDefines["AMD_ATOMIC_WORK_AROUND"] = "";
             }
         }
+        else if (vendor.size() >= 5 && vendor.substr(0, 5) == "Intel" && device.getInfo<CL_DEVICE_TYPE>() == CL_DEVICE_TYPE_GPU) {
+            // Intel GPUs execute each sub-group as a single SIMD hardware thread.  If kernels can require
+            // sub-groups of 32, every warp of a tile executes together, so we can use the SIMD kernels and
+            // synchronize warps with sub-group barriers instead of full work group barriers.
+
+            simdWidth = 1;
+            string extensions = device.getInfo<CL_DEVICE_EXTENSIONS>();
+            if (extensions.find("cl_intel_subgroups") != string::npos && extensions.find("cl_intel_required_subgroup_size") != string::npos) {
+                size_t sizesBytes = 0;
+                if (clGetDeviceInfo(device(), CL_DEVICE_SUB_GROUP_SIZES_INTEL, 0, NULL, &sizesBytes) == CL_SUCCESS && sizesBytes > 0) {
+                    vector<size_t> sizes(sizesBytes/sizeof(size_t));
+                    clGetDeviceInfo(device(), CL_DEVICE_SUB_GROUP_SIZES_INTEL, sizesBytes, sizes.data(), NULL);
+                    if (find(sizes.begin(), sizes.end(), (size_t) 32) != sizes.end()) {
+                        simdWidth = 32;
+                        useSubGroupBarriers = true;
+                        compilationDefines["KERNEL_SUB_GROUP_SIZE"] = "32";
+                    }
+                }
+            }
+        }
         else
             simdWidth = 1;
         if (supports64BitGlobalAtomics)
             compilationDefines["SUPPORTS_64_BIT_ATOMICS"] = "";
         if (supportsDoublePrecision)
             compilationDefines["SUPPORTS_DOUBLE_PRECISION"] = "";
-        if (simdWidth >= 32)
+        if (useSubGroupBarriers)
+            compilationDefines["SYNC_WARPS"] = "sub_group_barrier(CLK_LOCAL_MEM_FENCE)";
+        else if (simdWidth >= 32)
             compilationDefines["SYNC_WARPS"] = "mem_fence(CLK_LOCAL_MEM_FENCE)";
         else
             compilationDefines["SYNC_WARPS"] = "barrier(CLK_LOCAL_MEM_FENCE)";
@@ -307,7 +350,7 @@ OpenCLContext::OpenCLContext(const System& system, int platformIndex, int device
             defaultQueue = shared_ptr<ComputeQueueImpl>(new OpenCLQueue(cl::CommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE)));
             printf("[ ");
 #else
-            defaultQueue = shared_ptr<ComputeQueueImpl>(new OpenCLQueue(cl::CommandQueue(context, device)));
+            defaultQueue = createQueue();
 #endif
         }
         else {
@@ -579,12 +622,36 @@ void OpenCLContext::initializeContexts() {
     getPlatformData().initializeContexts(system);
 }
 
-FFT3D OpenCLContext::createFFT(int xsize, int ysize, int zsize, bool realToComplex) {
-    return FFT3D(new OpenCLFFT3D(*this, xsize, ysize, zsize, realToComplex));
+string OpenCLContext::getDeviceName() {
+    return device.getInfo<CL_DEVICE_VENDOR>()+" "+device.getInfo<CL_DEVICE_NAME>();
+}
+
+vector<string> OpenCLContext::getFFTBackends(int xsize, int ysize, int zsize, bool realToComplex) {
+    vector<string> backends = {"VkFFT"};
+
+    // The built in kernels are only worth trying for small grids, where each 1D transform
+    // fits in a single work group.
+
+    int maxSize = min(256, (int) device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>());
+    bool small = true;
+    for (int size : {xsize, ysize, zsize})
+        if (size > maxSize || OpenCLFFT3D::findLegalDimension(size, false) != size)
+            small = false;
+    if (small)
+        backends.push_back("internal");
+    return backends;
+}
+
+FFT3D OpenCLContext::createFFTWithBackend(const string& backend, int xsize, int ysize, int zsize, bool realToComplex) {
+    if (backend == "VkFFT")
+        return FFT3D(new OpenCLFFT3D(*this, xsize, ysize, zsize, realToComplex, true));
+    if (backend == "internal")
+        return FFT3D(new OpenCLFFT3D(*this, xsize, ysize, zsize, realToComplex, false));
+    throw OpenMMException("Unknown FFT implementation: "+backend);
 }
 
 int OpenCLContext::findLegalFFTDimension(int minimum) {
-    return OpenCLFFT3D::findLegalDimension(minimum);
+    return findFastFFTDimension(minimum, 13);
 }
 
 void OpenCLContext::addForce(ComputeForceInfo* force) {
@@ -652,6 +719,26 @@ cl::Program OpenCLContext::createProgram(const string source, const map<string,
     if (!defines.empty())
         src << endl;
     src << source << endl;
+
+    // See whether we already have a binary for this program cached.  The key includes the device
+    // and driver, since binaries are not portable between them.
+
+    stringstream key;
+    key << device.getInfo<CL_DEVICE_VENDOR>() << endl << device.getInfo<CL_DEVICE_NAME>() << endl;
+    key << device.getInfo<CL_DEVICE_VERSION>() << endl << device.getInfo<CL_DRIVER_VERSION>() << endl;
+    key << options << endl << src.str();
+    vector<char> binary;
+    if (kernelCache.load(key.str(), binary)) {
+        try {
+            cl::Program::Binaries binaries(1, vector<unsigned char>(binary.begin(), binary.end()));
+            cl::Program program(context, vector<cl::Device>(1, device), binaries);
+            program.build(vector<cl::Device>(1, device), options.c_str());
+            return program;
+        }
+        catch (cl::Error err) {
+            // The binary could not be loaded.  Compile from source instead.
+        }
+    }
     cl::Program::Sources sources({src.str()});
     cl::Program program(context, sources);
     try {
@@ -659,6 +746,17 @@ cl::Program OpenCLContext::createProgram(const string source, const map<string,
     } catch (cl::Error err) {
         throw OpenMMException("Error compiling kernel: "+program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device));
     }
+
+    // If possible, save the binary so later Contexts can load it.
+
+    try {
+        vector<vector<unsigned char> > binaries = program.getInfo<CL_PROGRAM_BINARIES>();
+        if (binaries.size() == 1 && binaries[0].size() > 0)
+            kernelCache.save(key.str(), vector<char>(binaries[0].begin(), binaries[0].end()));
+    }
+    catch (cl::Error err) {
+        // Some implementations don't support retrieving binaries.  Ignore.
+    }
     return program;
 }
 
@@ -674,7 +772,8 @@ double& OpenCLContext::getEnergyWorkspace() {
 }
 
 ComputeQueue OpenCLContext::createQueue() {
-    return shared_ptr<ComputeQueueImpl>(new OpenCLQueue(cl::CommandQueue(context, device)));
+    cl_command_queue_properties properties = (platformData.enableProfiling ? CL_QUEUE_PROFILING_ENABLE : 0);
+    return shared_ptr<ComputeQueueImpl>(new OpenCLQueue(cl::CommandQueue(context, device, properties)));
 }
 
 cl::CommandQueue OpenCLContext::getQueue() {
@@ -685,10 +784,40 @@ OpenCLArray* OpenCLContext::createArray() {
     return new OpenCLArray();
 }
 
+void* OpenCLContext::allocatePinnedMemory(size_t size) {
+    try {
+        cl::Buffer* buffer = new cl::Buffer(context, CL_MEM_ALLOC_HOST_PTR, size);
+        void* memory = getQueue().enqueueMapBuffer(*buffer, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, size);
+        pinnedAllocations[memory] = buffer;
+        return memory;
+    }
+    catch (cl::Error err) {
+        stringstream str;
+        str<<"Error allocating pinned memory: "<<err.what()<<" ("<<err.err()<<")";
+        throw OpenMMException(str.str());
+    }
+}
+
+void OpenCLContext::freePinnedMemory(void* memory) {
+    auto allocation = pinnedAllocations.find(memory);
+    if (allocation == pinnedAllocations.end())
+        return;
+    getQueue().enqueueUnmapMemObject(*allocation->second, memory);
+    getQueue().finish();
+    delete allocation->second;
+    pinnedAllocations.erase(allocation);
+}
+
 ComputeEvent OpenCLContext::createEvent() {
     return shared_ptr<ComputeEventImpl>(new OpenCLEvent(*this));
 }
 
+ComputeEvent OpenCLContext::createTimingEvent() {
+    if (!platformData.enableProfiling)
+        throw OpenMMException("Timing events require the EnableProfiling property to be set");
+    return shared_ptr<ComputeEventImpl>(new OpenCLEvent(*this));
+}
+
 ComputeSort OpenCLContext::createSort(ComputeSortImpl::SortTrait* trait, unsigned int length, bool uniform) {
     return shared_ptr<ComputeSortImpl>(new OpenCLSort(*this, trait, length, uniform));
 }
@@ -723,7 +852,11 @@ void OpenCLContext::executeKernel(cl::Kernel& kernel, int workUnits, int blockSi
     if (profilingEvents.size() >= 500)
         printProfilingEvents();
 #else
+        if (getProfilingEnabled())
+            startProfilingInterval();
         getQueue().enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(size), cl::NDRange(blockSize));
+        if (getProfilingEnabled())
+            endProfilingInterval(kernel.getInfo<CL_KERNEL_FUNCTION_NAME>());
 #endif
     }
     catch (cl::Error err) {
@@ -871,6 +1004,8 @@ double OpenCLContext::reduceEnergy() {
     reduceEnergyKernel.setArg<cl_int>(3, workGroupSize);
     reduceEnergyKernel.setArg(4, workGroupSize*energyBuffer.getElementSize(), NULL);
     executeKernel(reduceEnergyKernel, workGroupSize*energySum.getSize(), workGroupSize);
+    if (keepEnergyOnDevice)
+        return 0.0;
     energySum.download(pinnedMemory);
     double result = 0;
     if (getUseDoublePrecision() || getUseMixedPrecision()) {
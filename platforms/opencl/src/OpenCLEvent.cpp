@@ -44,3 +44,10 @@ void OpenCLEvent::wait() {
 void OpenCLEvent::queueWait(ComputeQueue queue) {
     dynamic_cast<OpenCLQueue*>(queue.get())->getQueue().enqueueBarrierWithWaitList(&event);
 }
+
+double OpenCLEvent::getElapsedTime(ComputeEventImpl& start) {
+    cl_ulong startTime, endTime;
+    dynamic_cast<OpenCLEvent&>(start).event[0].getProfilingInfo(CL_PROFILING_COMMAND_END, &startTime);
+    event[0].getProfilingInfo(CL_PROFILING_COMMAND_END, &endTime);
+    return 1e-6*(endTime-startTime);
+}
@@ -37,12 +37,64 @@
 using namespace OpenMM;
 using namespace std;
 
-#ifdef USE_VKFFT
+OpenCLFFT3D::OpenCLFFT3D(OpenCLContext& context, int xsize, int ysize, int zsize, bool realToComplex, bool useVkFFT) :
+        context(context), xsize(xsize), ysize(ysize), zsize(zsize), useVkFFT(useVkFFT), convolutionStatus(0) {
+    if (useVkFFT)
+        initializeVkFFTApplication(realToComplex);
+    else
+        initializeKernels(realToComplex);
+}
 
-OpenCLFFT3D::OpenCLFFT3D(OpenCLContext& context, int xsize, int ysize, int zsize, bool realToComplex) :
-        context(context), xsize(xsize), ysize(ysize), zsize(zsize) {
+OpenCLFFT3D::~OpenCLFFT3D() {
+    if (useVkFFT) {
+        deleteVkFFT(&app);
+        if (convolutionStatus == 1)
+            deleteVkFFT(&convolutionApp);
+    }
+}
+
+void OpenCLFFT3D::execFFT(ArrayInterface& in, ArrayInterface& out, bool forward) {
+    if (useVkFFT)
+        execVkFFT(in, out, forward);
+    else
+        execKernels(in, out, forward);
+}
+
+bool OpenCLFFT3D::supportsConvolution() {
+    if (!useVkFFT)
+        return false;
+    if (convolutionStatus == 0) {
+        // Create a second application that multiplies by the kernel between the forward and
+        // inverse transforms.  If VkFFT cannot do it for this size, fall back to separate kernels.
+
+        VkFFTConfiguration convolutionConfig = config;
+        convolutionConfig.performConvolution = 1;
+        convolutionConfig.coordinateFeatures = 1;
+        int elementSize = (context.getUseDoublePrecision() ? sizeof(double) : sizeof(float));
+        kernelSize = (uint64_t) xsize*ysize*(config.performR2C ? zsize/2+1 : zsize)*2*elementSize;
+        convolutionConfig.kernelSize = &kernelSize;
+        convolutionStatus = (initializeVkFFT(&convolutionApp, convolutionConfig) == VKFFT_SUCCESS ? 1 : -1);
+    }
+    return (convolutionStatus == 1);
+}
+
+void OpenCLFFT3D::execConvolution(ArrayInterface& in, ArrayInterface& out, ArrayInterface& kernel) {
+    if (!supportsConvolution())
+        throw OpenMMException("This FFT does not support convolution");
+    VkFFTLaunchParams params = {};
+    params.inputBuffer = &context.unwrap(in).getDeviceBuffer()();
+    params.buffer = &context.unwrap(out).getDeviceBuffer()();
+    params.kernel = &context.unwrap(kernel).getDeviceBuffer()();
+    params.commandQueue = &context.getQueue()();
+    VkFFTResult result = VkFFTAppend(&convolutionApp, -1, &params);
+    if (result != VKFFT_SUCCESS)
+        throw OpenMMException("Error executing VkFFT: "+context.intToString(result));
+}
+
+void OpenCLFFT3D::initializeVkFFTApplication(bool realToComplex) {
     app = {};
-    VkFFTConfiguration config = {};
+    convolutionApp = {};
+    config = {};
     config.FFTdim = 3;
     config.size[0] = zsize;
     config.size[1] = ysize;
@@ -67,11 +119,7 @@ OpenCLFFT3D::OpenCLFFT3D(OpenCLContext& context, int xsize, int ysize, int zsize
         throw OpenMMException("Error initializing VkFFT: "+context.intToString(result));
 }
 
-OpenCLFFT3D::~OpenCLFFT3D() {
-    deleteVkFFT(&app);
-}
-
-void OpenCLFFT3D::execFFT(ArrayInterface& in, ArrayInterface& out, bool forward) {
+void OpenCLFFT3D::execVkFFT(ArrayInterface& in, ArrayInterface& out, bool forward) {
     VkFFTLaunchParams params = {};
     if (forward) {
         params.inputBuffer = &context.unwrap(in).getDeviceBuffer()();
@@ -87,10 +135,7 @@ void OpenCLFFT3D::execFFT(ArrayInterface& in, ArrayInterface& out, bool forward)
         throw OpenMMException("Error executing VkFFT: "+context.intToString(result));
 }
 
-#else
-
-OpenCLFFT3D::OpenCLFFT3D(OpenCLContext& context, int xsize, int ysize, int zsize, bool realToComplex) :
-        context(context), xsize(xsize), ysize(ysize), zsize(zsize) {
+void OpenCLFFT3D::initializeKernels(bool realToComplex) {
     packRealAsComplex = false;
     int packedXSize = xsize;
     int packedYSize = ysize;
@@ -148,7 +193,7 @@ OpenCLFFT3D::OpenCLFFT3D(OpenCLContext& context, int xsize, int ysize, int zsize
     invykernel = createKernel(packedZSize, packedXSize, packedYSize, ythreads, 2, false, inputIsReal);
 }
 
-void OpenCLFFT3D::execFFT(ArrayInterface& in, ArrayInterface& out, bool forward) {
+void OpenCLFFT3D::execKernels(ArrayInterface& in, ArrayInterface& out, bool forward) {
     OpenCLArray& in2 = context.unwrap(in);
     OpenCLArray& out2 = context.unwrap(out);
     cl::Kernel kernel1 = (forward ? zkernel : invzkernel);
@@ -405,16 +450,10 @@ cl::Kernel OpenCLFFT3D::createKernel(int xsize, int ysize, int zsize, int& threa
     }
 }
 
-#endif
-
-int OpenCLFFT3D::findLegalDimension(int minimum) {
+int OpenCLFFT3D::findLegalDimension(int minimum, bool useVkFFT) {
     if (minimum < 1)
         return 1;
-#ifdef USE_VKFFT
-    const int maxFactor = 13;
-#else
-    const int maxFactor = 7;
-#endif
+    const int maxFactor = (useVkFFT ? 13 : 7);
     while (true) {
         // Attempt to factor the current value.
 
@@ -30,7 +30,7 @@
 using namespace OpenMM;
 using namespace std;
 
-OpenCLIntegrationUtilities::OpenCLIntegrationUtilities(OpenCLContext& context, const System& system) : IntegrationUtilities(context, system) {
+OpenCLIntegrationUtilities::OpenCLIntegrationUtilities(OpenCLContext& context, const System& system) : IntegrationUtilities(context, system, context.getPlatformData().useLincs) {
         ccmaConvergedHostBuffer.initialize<cl_int>(context, 1, "CcmaConvergedHostBuffer", CL_MEM_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR);
         // Different communication mechanisms give optimal performance on AMD and on NVIDIA.
         string vendor = context.getDevice().getInfo<CL_DEVICE_VENDOR>();
@@ -75,7 +75,9 @@ void OpenCLIntegrationUtilities::applyConstraintsImpl(bool constrainVelocities,
             shakeKernel->setArg(1, (float) tol);
         shakeKernel->execute(shakeAtoms.getSize());
     }
-    if (ccmaConstraintAtoms.isInitialized()) {
+    if (useLincs && ccmaConstraintAtoms.isInitialized())
+        applyLincs(constrainVelocities);
+    else if (ccmaConstraintAtoms.isInitialized()) {
         if (ccmaConstraintAtoms.getSize() <= 1024) {
             // Use the version of CCMA that runs in a single kernel with one workgroup.
             ccmaFullKernel->setArg(0, (int) constrainVelocities);
@@ -54,6 +54,8 @@ void OpenCLCalcForcesAndEnergyKernel::initialize(const System& system) {
 
 void OpenCLCalcForcesAndEnergyKernel::beginComputation(ContextImpl& context, bool includeForces, bool includeEnergy, int groups) {
     cl.setForcesValid(true);
+    if (cl.getProfilingEnabled())
+        cl.startProfilingInterval();
     cl.clearAutoclearBuffers();
     cl.updateGlobalParamValues();
     for (auto computation : cl.getPreComputations())
@@ -67,15 +69,19 @@ void OpenCLCalcForcesAndEnergyKernel::beginComputation(ContextImpl& context, boo
 }
 
 double OpenCLCalcForcesAndEnergyKernel::finishComputation(ContextImpl& context, bool includeForces, bool includeEnergy, int groups, bool& valid) {
-    cl.getBondedUtilities().computeInteractions(groups);
+    cl.getBondedUtilities().computeInteractions(groups, includeForces);
     cl.getNonbondedUtilities().computeInteractions(groups, includeForces, includeEnergy);
     double sum = 0.0;
     for (auto computation : cl.getPostComputations())
         sum += computation->computeForceAndEnergy(includeForces, includeEnergy, groups);
-    cl.reduceForces();
-    cl.getIntegrationUtilities().distributeForcesFromVirtualSites();
+    if (includeForces) {
+        cl.reduceForces();
+        cl.getIntegrationUtilities().distributeForcesFromVirtualSites();
+    }
     if (includeEnergy)
         sum += cl.reduceEnergy();
+    if (cl.getProfilingEnabled())
+        cl.endProfilingInterval(ComputeContext::getForceGroupsProfilingName(groups));
     if (!cl.getForcesValid())
         valid = false;
     return sum;
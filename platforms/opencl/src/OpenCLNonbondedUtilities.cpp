@@ -67,6 +67,10 @@ OpenCLNonbondedUtilities::OpenCLNonbondedUtilities(OpenCLContext& context) : con
             // 1536 threads per GPU core.
             blocksPerComputeUnit = 6;
         }
+        else if (context.getUseSubGroupBarriers()) {
+            // Intel reports each execution unit as a compute unit.  One block fills all of its SIMD32 threads.
+            blocksPerComputeUnit = 1;
+        }
         numForceThreadBlocks = blocksPerComputeUnit*context.getDevice().getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
         forceThreadBlockSize = 256;
     }
@@ -413,7 +417,7 @@ bool OpenCLNonbondedUtilities::updateNeighborListSize() {
 
     unsigned int maxTiles = (unsigned int) (1.2*pinnedCountMemory[0]);
     unsigned int numBlocks = context.getNumAtomBlocks();
-    int totalTiles = numBlocks*(numBlocks+1)/2;
+    long long totalTiles = numBlocks*((long long) numBlocks+1)/2;
     if (maxTiles > totalTiles)
         maxTiles = totalTiles;
     interactingTiles.resize(maxTiles);
@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2008-2025 Stanford University and the Authors.      *
+ * Portions copyright (c) 2008-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -66,6 +66,7 @@ OpenCLPlatform::OpenCLPlatform() {
     registerKernelFactory(UpdateStateDataKernel::Name(), factory);
     registerKernelFactory(ApplyConstraintsKernel::Name(), factory);
     registerKernelFactory(VirtualSitesKernel::Name(), factory);
+    registerKernelFactory(MinimizeKernel::Name(), factory);
     registerKernelFactory(CalcHarmonicBondForceKernel::Name(), factory);
     registerKernelFactory(CalcCustomBondForceKernel::Name(), factory);
     registerKernelFactory(CalcHarmonicAngleForceKernel::Name(), factory);
@@ -91,6 +92,7 @@ OpenCLPlatform::OpenCLPlatform() {
     registerKernelFactory(IntegrateVerletStepKernel::Name(), factory);
     registerKernelFactory(IntegrateNoseHooverStepKernel::Name(), factory);
     registerKernelFactory(IntegrateLangevinMiddleStepKernel::Name(), factory);
+    registerKernelFactory(IntegrateMTSLangevinStepKernel::Name(), factory);
     registerKernelFactory(IntegrateBrownianStepKernel::Name(), factory);
     registerKernelFactory(IntegrateVariableVerletStepKernel::Name(), factory);
     registerKernelFactory(IntegrateVariableLangevinStepKernel::Name(), factory);
@@ -98,6 +100,7 @@ OpenCLPlatform::OpenCLPlatform() {
     registerKernelFactory(IntegrateDPDStepKernel::Name(), factory);
     registerKernelFactory(ApplyAndersenThermostatKernel::Name(), factory);
     registerKernelFactory(ApplyMonteCarloBarostatKernel::Name(), factory);
+    registerKernelFactory(CalcProtocolWorkKernel::Name(), factory);
     registerKernelFactory(RemoveCMMotionKernel::Name(), factory);
     platformProperties.push_back(OpenCLDeviceIndex());
     platformProperties.push_back(OpenCLDeviceName());
@@ -106,6 +109,10 @@ OpenCLPlatform::OpenCLPlatform() {
     platformProperties.push_back(OpenCLPrecision());
     platformProperties.push_back(OpenCLUseCpuPme());
     platformProperties.push_back(OpenCLDisablePmeStream());
+    platformProperties.push_back(OpenCLEnableProfiling());
+    platformProperties.push_back(OpenCLCacheDirectory());
+    platformProperties.push_back(OpenCLConstraintAlgorithm());
+    platformProperties.push_back(OpenCLDeviceMemoryBudget());
     setPropertyDefaultValue(OpenCLDeviceIndex(), "");
     setPropertyDefaultValue(OpenCLDeviceName(), "");
     setPropertyDefaultValue(OpenCLPlatformIndex(), "");
@@ -113,6 +120,10 @@ OpenCLPlatform::OpenCLPlatform() {
     setPropertyDefaultValue(OpenCLPrecision(), "single");
     setPropertyDefaultValue(OpenCLUseCpuPme(), "false");
     setPropertyDefaultValue(OpenCLDisablePmeStream(), "false");
+    setPropertyDefaultValue(OpenCLEnableProfiling(), "false");
+    setPropertyDefaultValue(OpenCLCacheDirectory(), "");
+    setPropertyDefaultValue(OpenCLConstraintAlgorithm(), "ccma");
+    setPropertyDefaultValue(OpenCLDeviceMemoryBudget(), "");
 }
 
 double OpenCLPlatform::getSpeed() const {
@@ -174,6 +185,39 @@ const string& OpenCLPlatform::getPropertyValue(const Context& context, const str
 void OpenCLPlatform::setPropertyValue(Context& context, const string& property, const string& value) const {
 }
 
+map<string, pair<int, double> > OpenCLPlatform::getKernelTimings(Context& context) const {
+    ContextImpl& impl = getContextImpl(context);
+    PlatformData* data = reinterpret_cast<PlatformData*>(impl.getPlatformData());
+    data->syncContexts();
+    map<string, pair<int, double> > timings;
+    for (OpenCLContext* c : data->contexts) {
+        for (auto& t : c->getProfilingTimes()) {
+            timings[t.first].first += t.second.first;
+            timings[t.first].second += t.second.second;
+        }
+    }
+    return timings;
+}
+
+void OpenCLPlatform::resetKernelTimings(Context& context) const {
+    ContextImpl& impl = getContextImpl(context);
+    PlatformData* data = reinterpret_cast<PlatformData*>(impl.getPlatformData());
+    data->syncContexts();
+    for (OpenCLContext* c : data->contexts)
+        c->resetProfilingTimes();
+}
+
+map<string, map<string, long long> > OpenCLPlatform::getMemoryUsage(Context& context) const {
+    ContextImpl& impl = getContextImpl(context);
+    PlatformData* data = reinterpret_cast<PlatformData*>(impl.getPlatformData());
+    map<string, map<string, long long> > usage;
+    for (OpenCLContext* c : data->contexts)
+        for (auto& owner : c->getMemoryUsage())
+            for (auto& array : owner.second)
+                usage[owner.first][array.first] += array.second;
+    return usage;
+}
+
 void OpenCLPlatform::contextCreated(ContextImpl& context, const map<string, string>& properties) const {
     const string& platformPropValue = (properties.find(OpenCLPlatformIndex()) == properties.end() ?
             getPropertyDefaultValue(OpenCLPlatformIndex()) : properties.find(OpenCLPlatformIndex())->second);
@@ -185,9 +229,19 @@ void OpenCLPlatform::contextCreated(ContextImpl& context, const map<string, stri
             getPropertyDefaultValue(OpenCLUseCpuPme()) : properties.find(OpenCLUseCpuPme())->second);
     string pmeStreamPropValue = (properties.find(OpenCLDisablePmeStream()) == properties.end() ?
             getPropertyDefaultValue(OpenCLDisablePmeStream()) : properties.find(OpenCLDisablePmeStream())->second);
+    string profilingPropValue = (properties.find(OpenCLEnableProfiling()) == properties.end() ?
+            getPropertyDefaultValue(OpenCLEnableProfiling()) : properties.find(OpenCLEnableProfiling())->second);
+    const string& cacheDirPropValue = (properties.find(OpenCLCacheDirectory()) == properties.end() ?
+            getPropertyDefaultValue(OpenCLCacheDirectory()) : properties.find(OpenCLCacheDirectory())->second);
+    string constraintAlgorithmPropValue = (properties.find(OpenCLConstraintAlgorithm()) == properties.end() ?
+            getPropertyDefaultValue(OpenCLConstraintAlgorithm()) : properties.find(OpenCLConstraintAlgorithm())->second);
+    transform(constraintAlgorithmPropValue.begin(), constraintAlgorithmPropValue.end(), constraintAlgorithmPropValue.begin(), ::tolower);
+    const string& memoryBudgetPropValue = (properties.find(OpenCLDeviceMemoryBudget()) == properties.end() ?
+            getPropertyDefaultValue(OpenCLDeviceMemoryBudget()) : properties.find(OpenCLDeviceMemoryBudget())->second);
     transform(precisionPropValue.begin(), precisionPropValue.end(), precisionPropValue.begin(), ::tolower);
     transform(cpuPmePropValue.begin(), cpuPmePropValue.end(), cpuPmePropValue.begin(), ::tolower);
     transform(pmeStreamPropValue.begin(), pmeStreamPropValue.end(), pmeStreamPropValue.begin(), ::tolower);
+    transform(profilingPropValue.begin(), profilingPropValue.end(), profilingPropValue.begin(), ::tolower);
     vector<string> pmeKernelName;
     pmeKernelName.push_back(CalcPmeReciprocalForceKernel::Name());
     if (!supportsKernels(pmeKernelName))
@@ -197,7 +251,7 @@ void OpenCLPlatform::contextCreated(ContextImpl& context, const map<string, stri
     if (threadsEnv != NULL)
         stringstream(threadsEnv) >> threads;
     context.setPlatformData(new PlatformData(context.getSystem(), &context, platformPropValue, devicePropValue, precisionPropValue, cpuPmePropValue,
-            pmeStreamPropValue, threads, NULL));
+            pmeStreamPropValue, profilingPropValue, memoryBudgetPropValue, constraintAlgorithmPropValue, cacheDirPropValue, threads, NULL));
 }
 
 void OpenCLPlatform::linkedContextCreated(ContextImpl& context, ContextImpl& originalContext) const {
@@ -207,9 +261,13 @@ void OpenCLPlatform::linkedContextCreated(ContextImpl& context, ContextImpl& ori
     string precisionPropValue = platform.getPropertyValue(originalContext.getOwner(), OpenCLPrecision());
     string cpuPmePropValue = platform.getPropertyValue(originalContext.getOwner(), OpenCLUseCpuPme());
     string pmeStreamPropValue = platform.getPropertyValue(originalContext.getOwner(), OpenCLDisablePmeStream());
+    string profilingPropValue = platform.getPropertyValue(originalContext.getOwner(), OpenCLEnableProfiling());
+    string cacheDirPropValue = platform.getPropertyValue(originalContext.getOwner(), OpenCLCacheDirectory());
+    string constraintAlgorithmPropValue = platform.getPropertyValue(originalContext.getOwner(), OpenCLConstraintAlgorithm());
+    string memoryBudgetPropValue = platform.getPropertyValue(originalContext.getOwner(), OpenCLDeviceMemoryBudget());
     int threads = reinterpret_cast<PlatformData*>(originalContext.getPlatformData())->threads.getNumThreads();
     context.setPlatformData(new PlatformData(context.getSystem(), &context, platformPropValue, devicePropValue, precisionPropValue, cpuPmePropValue,
-            pmeStreamPropValue, threads, &originalContext));
+            pmeStreamPropValue, profilingPropValue, memoryBudgetPropValue, constraintAlgorithmPropValue, cacheDirPropValue, threads, &originalContext));
 }
 
 void OpenCLPlatform::contextDestroyed(ContextImpl& context) const {
@@ -218,8 +276,21 @@ void OpenCLPlatform::contextDestroyed(ContextImpl& context) const {
 }
 
 OpenCLPlatform::PlatformData::PlatformData(const System& system, ContextImpl* context, const string& platformPropValue, const string& deviceIndexProperty,
-        const string& precisionProperty, const string& cpuPmeProperty, const string& pmeStreamProperty, int numThreads, ContextImpl* originalContext) :
-            context(context), removeCM(false), stepCount(0), computeForceCount(0), time(0.0), hasInitializedContexts(false), threads(numThreads)  {
+        const string& precisionProperty, const string& cpuPmeProperty, const string& pmeStreamProperty, const string& profilingProperty, const string& memoryBudgetProperty, const string& constraintAlgorithmProperty, const string& cacheDirProperty,
+        int numThreads, ContextImpl* originalContext) : context(context), removeCM(false), stepCount(0), computeForceCount(0), time(0.0), hasInitializedContexts(false),
+            cacheDirectory(cacheDirProperty), threads(numThreads)  {
+    memoryBudget = 0;
+    if (memoryBudgetProperty.size() > 0) {
+        double megabytes;
+        stringstream budgetStream(memoryBudgetProperty);
+        if (!(budgetStream >> megabytes) || megabytes < 0)
+            throw OpenMMException("Illegal value for DeviceMemoryBudget: "+memoryBudgetProperty);
+        memoryBudget = (long long) (megabytes*1048576.0);
+    }
+    if (constraintAlgorithmProperty != "ccma" && constraintAlgorithmProperty != "lincs")
+        throw OpenMMException("Illegal value for ConstraintAlgorithm: "+constraintAlgorithmProperty);
+    useLincs = (constraintAlgorithmProperty == "lincs");
+    enableProfiling = (profilingProperty == "true");
     int platformIndex = -1;
     if (platformPropValue.length() > 0)
         stringstream(platformPropValue) >> platformIndex;
@@ -259,6 +330,7 @@ OpenCLPlatform::PlatformData::PlatformData(const System& system, ContextImpl* co
         }
         deviceIndex << contexts[i]->getDeviceIndex();
         deviceName << contexts[i]->getDevice().getInfo<CL_DEVICE_NAME>();
+        contexts[i]->setProfilingEnabled(enableProfiling);
     }
     platformIndex = contexts[0]->getPlatformIndex();
 
@@ -273,6 +345,10 @@ OpenCLPlatform::PlatformData::PlatformData(const System& system, ContextImpl* co
     propertyValues[OpenCLPlatform::OpenCLPrecision()] = precisionProperty;
     propertyValues[OpenCLPlatform::OpenCLUseCpuPme()] = useCpuPme ? "true" : "false";
     propertyValues[OpenCLPlatform::OpenCLDisablePmeStream()] = disablePmeStream ? "true" : "false";
+    propertyValues[OpenCLPlatform::OpenCLEnableProfiling()] = enableProfiling ? "true" : "false";
+    propertyValues[OpenCLPlatform::OpenCLCacheDirectory()] = cacheDirProperty;
+    propertyValues[OpenCLPlatform::OpenCLConstraintAlgorithm()] = constraintAlgorithmProperty;
+    propertyValues[OpenCLPlatform::OpenCLDeviceMemoryBudget()] = memoryBudgetProperty;
     contextEnergy.resize(contexts.size());
 }
 
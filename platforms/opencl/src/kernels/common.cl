@@ -25,7 +25,13 @@ __attribute__((overloadable)) unsigned long atom_add(volatile __global unsigned
 }
 #endif
 
+#ifdef KERNEL_SUB_GROUP_SIZE
+#pragma OPENCL EXTENSION cl_intel_subgroups : enable
+#pragma OPENCL EXTENSION cl_intel_required_subgroup_size : enable
+#define KERNEL __kernel __attribute__((intel_reqd_sub_group_size(KERNEL_SUB_GROUP_SIZE)))
+#else
 #define KERNEL __kernel
+#endif
 #define DEVICE
 #define LOCAL __local
 #define LOCAL_ARG __local
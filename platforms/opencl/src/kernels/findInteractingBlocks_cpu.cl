@@ -195,7 +195,7 @@ void storeInteractionData(int x, int* buffer, int* atoms, int* numAtoms, int num
                     for (int i = 0; i < tilesToStore; i++) {
                         interactingTiles[baseIndex+i] = x;
                         for (int j = 0; j < TILE_SIZE; j++)
-                            interactingAtoms[(baseIndex+i)*TILE_SIZE+j] = atoms[i*TILE_SIZE+j];
+                            interactingAtoms[((long) (baseIndex+i))*TILE_SIZE+j] = atoms[i*TILE_SIZE+j];
                     }
                 }
                 *numAtoms = 0;
@@ -213,7 +213,7 @@ void storeInteractionData(int x, int* buffer, int* atoms, int* numAtoms, int num
                 interactingTiles[baseIndex+i] = x;
                 for (int j = 0; j < TILE_SIZE; j++) {
                     int index = i*TILE_SIZE+j;
-                    interactingAtoms[(baseIndex+i)*TILE_SIZE+j] = (index < *numAtoms ? atoms[index] : NUM_ATOMS);
+                    interactingAtoms[((long) (baseIndex+i))*TILE_SIZE+j] = (index < *numAtoms ? atoms[index] : NUM_ATOMS);
                 }
             }
         }
@@ -13,7 +13,7 @@ typedef struct {
 /**
  * Compute nonbonded interactions.
  */
-__kernel void computeNonbonded(
+KERNEL void computeNonbonded(
         __global unsigned long* restrict forceBuffers,
         __global mixed* restrict energyBuffer, __global const real4* restrict posq, __global const unsigned int* restrict exclusions,
         __global const int2* restrict exclusionTiles, unsigned int startTileIndex, unsigned long numTileIndices
@@ -251,7 +251,7 @@ __kernel void computeNonbonded(
             real4 posq1 = posq[atom1];
             LOAD_ATOM1_PARAMETERS
 #ifdef USE_NEIGHBOR_LIST
-            unsigned int j = interactingAtoms[pos*TILE_SIZE+tgx];
+            unsigned int j = interactingAtoms[((long) pos)*TILE_SIZE+tgx];
 #else
             unsigned int j = y*TILE_SIZE + tgx;
 #endif
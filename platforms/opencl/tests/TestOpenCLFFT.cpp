@@ -55,7 +55,7 @@ using namespace std;
 static OpenCLPlatform platform;
 
 template <class Real2>
-void testTransform(bool realToComplex, int xsize, int ysize, int zsize) {
+void testTransform(bool realToComplex, int xsize, int ysize, int zsize, bool useVkFFT) {
     System system;
     system.addParticle(0.0);
     OpenCLPlatform::PlatformData platformData(system, NULL, "", "", platform.getPropertyDefaultValue("OpenCLPrecision"), "false", "false", 1, NULL);
@@ -79,7 +79,7 @@ void testTransform(bool realToComplex, int xsize, int ysize, int zsize) {
     OpenCLArray grid1(context, original.size(), sizeof(Real2), "grid1");
     OpenCLArray grid2(context, original.size(), sizeof(Real2), "grid2");
     grid1.upload(original);
-    OpenCLFFT3D fft(context, xsize, ysize, zsize, realToComplex);
+    OpenCLFFT3D fft(context, xsize, ysize, zsize, realToComplex, useVkFFT);
 
     // Perform a forward FFT, then verify the result is correct.
 
@@ -118,19 +118,21 @@ int main(int argc, char* argv[]) {
     try {
         if (argc > 1)
             platform.setPropertyDefaultValue("OpenCLPrecision", string(argv[1]));
-        if (platform.getPropertyDefaultValue("OpenCLPrecision") == "double") {
-            testTransform<mm_double2>(false, 28, 25, 30);
-            testTransform<mm_double2>(true, 28, 25, 25);
-            testTransform<mm_double2>(true, 25, 28, 25);
-            testTransform<mm_double2>(true, 25, 25, 28);
-            testTransform<mm_double2>(true, 21, 25, 27);
-        }
-        else {
-            testTransform<mm_float2>(false, 28, 25, 30);
-            testTransform<mm_float2>(true, 28, 25, 25);
-            testTransform<mm_float2>(true, 25, 28, 25);
-            testTransform<mm_float2>(true, 25, 25, 28);
-            testTransform<mm_float2>(true, 21, 25, 27);
+        for (bool useVkFFT : {true, false}) {
+            if (platform.getPropertyDefaultValue("OpenCLPrecision") == "double") {
+                testTransform<mm_double2>(false, 28, 25, 30, useVkFFT);
+                testTransform<mm_double2>(true, 28, 25, 25, useVkFFT);
+                testTransform<mm_double2>(true, 25, 28, 25, useVkFFT);
+                testTransform<mm_double2>(true, 25, 25, 28, useVkFFT);
+                testTransform<mm_double2>(true, 21, 25, 27, useVkFFT);
+            }
+            else {
+                testTransform<mm_float2>(false, 28, 25, 30, useVkFFT);
+                testTransform<mm_float2>(true, 28, 25, 25, useVkFFT);
+                testTransform<mm_float2>(true, 25, 28, 25, useVkFFT);
+                testTransform<mm_float2>(true, 25, 25, 28, useVkFFT);
+                testTransform<mm_float2>(true, 21, 25, 27, useVkFFT);
+            }
         }
     }
     catch(const exception& e) {
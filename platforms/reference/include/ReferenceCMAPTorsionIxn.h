@@ -91,7 +91,14 @@ public:
 
     /**---------------------------------------------------------------------------------------
 
-       This is present only because we must define it to subclass ReferenceBondIxn.  It is never called.
+       Calculate the interaction due to a single torsion pair.  This allows the torsions to be
+       divided between threads.
+
+       @param atomIndices      the eight atoms forming the torsion pair (not used)
+       @param atomCoordinates  atom coordinates
+       @param parameters       parameters[0] is the index of the torsion pair
+       @param forces           force array (forces added)
+       @param totalEnergy      if not null, the energy will be added to this
 
        --------------------------------------------------------------------------------------- */
 
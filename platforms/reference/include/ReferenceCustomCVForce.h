@@ -44,6 +44,7 @@ private:
     std::vector<Lepton::CompiledExpression> paramDerivExpressions;
     std::vector<double> globalValues, cvValues;
     std::vector<Lepton::CustomFunction*> tabulatedFunctions;
+    std::vector<int> tabulatedFunctionUpdateCount;
 
 public:
     /**
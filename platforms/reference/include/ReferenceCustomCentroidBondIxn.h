@@ -55,14 +55,14 @@ class ReferenceCustomCentroidBondIxn : public ReferenceBondIxn {
 
          Calculate custom interaction for one bond
 
-         @param bond             the index of the bond
+         @param groups           the groups in the bond
          @param groupCenters     group center coordinates
          @param forces           force array (forces added)
          @param totalEnergy      total energy
 
          --------------------------------------------------------------------------------------- */
 
-      void calculateOneIxn(int bond, std::vector<OpenMM::Vec3>& groupCenters,
+      void calculateOneIxn(const std::vector<int>& groups, std::vector<OpenMM::Vec3>& groupCenters,
                            std::vector<OpenMM::Vec3>& forces, double* totalEnergy, double* energyParamDerivs);
 
       void computeDelta(int group1, int group2, double* delta, std::vector<OpenMM::Vec3>& groupCenters) const;
@@ -126,6 +126,32 @@ class ReferenceCustomCentroidBondIxn : public ReferenceBondIxn {
                             const std::map<std::string, double>& globalParameters,
                             std::vector<OpenMM::Vec3>& forces, double* totalEnergy, double* energyParamDerivs);
 
+
+      /**---------------------------------------------------------------------------------------
+
+         Set the values of all global parameters.
+
+         --------------------------------------------------------------------------------------- */
+
+      void setGlobalParameters(const std::map<std::string, double>& parameters);
+
+      /**---------------------------------------------------------------------------------------
+
+         Calculate the interaction for a single bond, given the centers of all groups.  This allows
+         CpuBondForce to divide the bonds between threads, treating each group as a particle.
+
+         @param groupIndices     the groups in the bond
+         @param groupCenters     group center coordinates
+         @param parameters       the bond's parameter values
+         @param groupForces      force on each group (forces added)
+         @param totalEnergy      if not null, the energy will be added to this
+
+         --------------------------------------------------------------------------------------- */
+
+      void calculateBondIxn(std::vector<int>& groupIndices, std::vector<OpenMM::Vec3>& groupCenters,
+                            std::vector<double>& parameters, std::vector<OpenMM::Vec3>& groupForces,
+                            double* totalEnergy, double* energyParamDerivs);
+
 // ---------------------------------------------------------------------------------------
 
 };
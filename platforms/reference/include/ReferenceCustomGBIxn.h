@@ -89,7 +89,7 @@ class ReferenceCustomGBIxn {
          --------------------------------------------------------------------------------------- */
 
       void calculateParticlePairValue(int index, int numAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<std::vector<double> >& atomParameters,
-                                      const std::vector<std::set<int> >& exclusions, bool useExclusions);
+                                      const ExclusionList& exclusions, bool useExclusions);
 
       /**---------------------------------------------------------------------------------------
 
@@ -137,7 +137,7 @@ class ReferenceCustomGBIxn {
          --------------------------------------------------------------------------------------- */
 
       void calculateParticlePairEnergyTerm(int index, int numAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<std::vector<double> >& atomParameters,
-                                      const std::vector<std::set<int> >& exclusions, bool useExclusions,
+                                      const ExclusionList& exclusions, bool useExclusions,
                                       std::vector<OpenMM::Vec3>& forces, double* totalEnergy, double* energyParamDerivs);
 
       /**---------------------------------------------------------------------------------------
@@ -170,7 +170,7 @@ class ReferenceCustomGBIxn {
          --------------------------------------------------------------------------------------- */
 
       void calculateChainRuleForces(int numAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<std::vector<double> >& atomParameters,
-                                      const std::vector<std::set<int> >& exclusions, std::vector<OpenMM::Vec3>& forces, double* energyParamDerivs);
+                                      const ExclusionList& exclusions, std::vector<OpenMM::Vec3>& forces, double* energyParamDerivs);
 
       /**---------------------------------------------------------------------------------------
 
@@ -254,7 +254,7 @@ class ReferenceCustomGBIxn {
 
          --------------------------------------------------------------------------------------- */
 
-      void calculateIxn(int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<std::vector<double> >& atomParameters, const std::vector<std::set<int> >& exclusions,
+      void calculateIxn(int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<std::vector<double> >& atomParameters, const ExclusionList& exclusions,
                        std::map<std::string, double>& globalParameters, std::vector<OpenMM::Vec3>& forces, double* totalEnergy, double* energyParamDerivs);
 
 // ---------------------------------------------------------------------------------------
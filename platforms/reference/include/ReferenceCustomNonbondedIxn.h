@@ -150,7 +150,7 @@ class ReferenceCustomNonbondedIxn {
          --------------------------------------------------------------------------------------- */
 
       void calculatePairIxn(int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates,
-                            std::vector<std::vector<double> >& atomParameters, std::vector<std::set<int> >& exclusions,
+                            std::vector<std::vector<double> >& atomParameters, const ExclusionList& exclusions,
                             const std::map<std::string, double>& globalParameters, std::vector<OpenMM::Vec3>& forces,
                             double* totalEnergy, double* energyParamDerivs);
 
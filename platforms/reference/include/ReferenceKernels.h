@@ -191,6 +191,33 @@ public:
      * @param forces  on exit, this contains the forces
      */
     void getForces(ContextImpl& context, std::vector<Vec3>& forces);
+    /**
+     * Get the positions of a subset of particles.
+     *
+     * @param particles  the indices of the particles to retrieve
+     * @param positions  on exit, element i contains the position of particle particles[i]
+     */
+    void getParticlePositions(ContextImpl& context, const std::vector<int>& particles, std::vector<Vec3>& positions);
+    /**
+     * Get the velocities of a subset of particles.
+     *
+     * @param particles   the indices of the particles to retrieve
+     * @param velocities  on exit, element i contains the velocity of particle particles[i]
+     */
+    void getParticleVelocities(ContextImpl& context, const std::vector<int>& particles, std::vector<Vec3>& velocities);
+    /**
+     * Multiply the velocities of all particles by a constant factor.
+     *
+     * @param scale      the factor to multiply the velocities by
+     */
+    void scaleVelocities(ContextImpl& context, double scale);
+    /**
+     * Get the current forces on a subset of particles.
+     *
+     * @param particles  the indices of the particles to retrieve
+     * @param forces     on exit, element i contains the force on particle particles[i]
+     */
+    void getParticleForces(ContextImpl& context, const std::vector<int>& particles, std::vector<Vec3>& forces);
     /**
      * Get the current derivatives of the energy with respect to context parameters.
      *
@@ -668,7 +695,7 @@ private:
     double nonbondedCutoff, switchingDistance, rfDielectric, ewaldAlpha, ewaldDispersionAlpha, dispersionCoefficient;
     int kmax[3], gridSize[3], dispersionGridSize[3];
     bool useSwitchingFunction, exceptionsArePeriodic;
-    std::vector<std::set<int> > exclusions;
+    ExclusionList exclusions;
     NonbondedMethod nonbondedMethod;
     NeighborList* neighborList;
 };
@@ -715,7 +742,7 @@ private:
     CustomNonbondedForce* forceCopy;
     CustomNonbondedForceImpl::LongRangeCorrectionData longRangeCorrectionData;
     std::map<std::string, double> globalParamValues;
-    std::vector<std::set<int> > exclusions;
+    ExclusionList exclusions;
     Lepton::CompiledExpression energyExpression, forceExpression;
     std::vector<Lepton::CompiledExpression> computedValueExpressions, energyParamDerivExpressions;
     std::vector<std::string> parameterNames, globalParameterNames, computedValueNames, energyParamDerivNames;
@@ -800,7 +827,7 @@ private:
     bool isPeriodic;
     std::vector<std::vector<double> > particleParamArray;
     double nonbondedCutoff;
-    std::vector<std::set<int> > exclusions;
+    ExclusionList exclusions;
     std::vector<std::string> particleParameterNames, globalParameterNames, energyParamDerivNames, valueNames;
     std::vector<Lepton::CompiledExpression> valueExpressions;
     std::vector<std::vector<Lepton::CompiledExpression> > valueDerivExpressions;
@@ -1320,6 +1347,76 @@ private:
     double prevTemp, prevFriction, prevStepSize;
 };
 
+/**
+ * This kernel is invoked by MTSLangevinIntegrator to take one time step.
+ */
+class ReferenceIntegrateMTSLangevinStepKernel : public IntegrateMTSLangevinStepKernel {
+public:
+    ReferenceIntegrateMTSLangevinStepKernel(std::string name, const Platform& platform, ReferencePlatform::PlatformData& data) : IntegrateMTSLangevinStepKernel(name, platform),
+        data(data) {
+    }
+    /**
+     * Initialize the kernel, setting up the particle masses.
+     * 
+     * @param system     the System this kernel will be applied to
+     * @param integrator the MTSLangevinIntegrator this kernel will be used for
+     */
+    void initialize(const System& system, const MTSLangevinIntegrator& integrator);
+    /**
+     * Update the velocities based on the forces currently stored in the context.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     * @param dt         the time interval to apply the forces over
+     */
+    void kick(ContextImpl& context, const MTSLangevinIntegrator& integrator, double dt);
+    /**
+     * Perform one substep of the innermost (fastest) level.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     * @param kickDt     the time interval to apply the forces over
+     * @param dt         the size of the substep
+     */
+    void innerStep(ContextImpl& context, const MTSLangevinIntegrator& integrator, double kickDt, double dt);
+    /**
+     * Save a copy of the forces currently stored in the context.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     * @param level      the index of the level the forces belong to
+     */
+    void saveForces(ContextImpl& context, const MTSLangevinIntegrator& integrator, int level);
+    /**
+     * Copy forces previously saved with saveForces() back into the context.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     * @param level      the index of the level the forces belong to
+     */
+    void restoreForces(ContextImpl& context, const MTSLangevinIntegrator& integrator, int level);
+    /**
+     * Complete a time step.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     * @return true, since the Reference platform never invalidates forces
+     */
+    bool finishStep(ContextImpl& context, const MTSLangevinIntegrator& integrator);
+    /**
+     * Compute the kinetic energy.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     */
+    double computeKineticEnergy(ContextImpl& context, const MTSLangevinIntegrator& integrator);
+private:
+    ReferencePlatform::PlatformData& data;
+    std::vector<double> masses, inverseMasses;
+    std::vector<Vec3> xPrime, oldx;
+    std::vector<std::vector<Vec3> > savedForces;
+};
+
 /**
  * This kernel is invoked by BrownianIntegrator to take one time step.
  */
@@ -1634,6 +1731,51 @@ private:
     ReferenceMonteCarloBarostat* barostat;
 };
 
+/**
+ * This kernel is invoked by NCMCDriver to accumulate the protocol work of a move.
+ */
+class ReferenceCalcProtocolWorkKernel : public CalcProtocolWorkKernel {
+public:
+    ReferenceCalcProtocolWorkKernel(std::string name, const Platform& platform) : CalcProtocolWorkKernel(name, platform), work(0.0) {
+    }
+    /**
+     * Initialize the kernel.
+     *
+     * @param system     the System this kernel will be applied to
+     */
+    void initialize(const System& system);
+    /**
+     * Save the positions and velocities at the start of a move, and set the accumulated work to zero.
+     *
+     * @param context    the context in which to execute this kernel
+     */
+    void beginMove(ContextImpl& context);
+    /**
+     * Restore the positions and velocities to what they were when beginMove() was last called.
+     *
+     * @param context    the context in which to execute this kernel
+     */
+    void restoreState(ContextImpl& context);
+    /**
+     * Compute the potential energy of a set of force groups and add it, multiplied by a scale factor,
+     * to the accumulated work.
+     *
+     * @param context    the context in which to execute this kernel
+     * @param scale      the factor to multiply the energy by
+     * @param groups     a set of bit flags for which force groups to include
+     */
+    void addEnergy(ContextImpl& context, double scale, int groups);
+    /**
+     * Get the work accumulated since beginMove() was last called.
+     *
+     * @param context    the context in which to execute this kernel
+     */
+    double getWork(ContextImpl& context);
+private:
+    std::vector<Vec3> savedPositions, savedVelocities;
+    double work;
+};
+
 /**
  * This kernel is invoked to remove center of mass motion from the system.
  */
@@ -184,7 +184,7 @@ class ReferenceLJCoulombIxn {
          --------------------------------------------------------------------------------------- */
           
       void calculatePairIxn(int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates,
-                            std::vector<std::vector<double> >& atomParameters, std::vector<std::set<int> >& exclusions,
+                            std::vector<std::vector<double> >& atomParameters, const ExclusionList& exclusions,
                             std::vector<OpenMM::Vec3>& forces, double* totalEnergy, bool includeDirect, bool includeReciprocal) const;
 
 private:
@@ -205,7 +205,7 @@ private:
          --------------------------------------------------------------------------------------- */
           
       void calculateEwaldIxn(int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates,
-                             std::vector<std::vector<double> >& atomParameters, std::vector<std::set<int> >& exclusions,
+                             std::vector<std::vector<double> >& atomParameters, const ExclusionList& exclusions,
                              std::vector<OpenMM::Vec3>& forces, double* totalEnergy, bool includeDirect, bool includeReciprocal) const;
 };
 
@@ -2,6 +2,7 @@
 #define OPENMM_REFERENCE_NEIGHBORLIST_H_
 
 #include "openmm/Vec3.h"
+#include "openmm/internal/ExclusionList.h"
 #include "openmm/internal/windowsExport.h"
 #include <set>
 #include <vector>
@@ -21,7 +22,7 @@ void OPENMM_EXPORT computeNeighborListNaive(
                               NeighborList& neighborList,
                               int nAtoms,
                               const AtomLocationList& atomLocations, 
-                              const std::vector<std::set<int> >& exclusions,
+                              const ExclusionList& exclusions,
                               const Vec3* periodicBoxVectors,
                               bool usePeriodic,
                               double maxDistance,
@@ -36,7 +37,7 @@ void OPENMM_EXPORT computeNeighborListVoxelHash(
                               NeighborList& neighborList,
                               int nAtoms,
                               const AtomLocationList& atomLocations,
-                              const std::vector<std::set<int> >& exclusions,
+                              const ExclusionList& exclusions,
                               const Vec3* periodicBoxVectors,
                               bool usePeriodic,
                               double maxDistance,
@@ -57,8 +57,18 @@ public:
     }
     double getSpeed() const;
     bool supportsDoublePrecision() const;
+    const std::string& getPropertyValue(const Context& context, const std::string& property) const;
     void contextCreated(ContextImpl& context, const std::map<std::string, std::string>& properties) const;
     void contextDestroyed(ContextImpl& context) const;
+    /**
+     * This is the name of the parameter for selecting the number of threads to use for the
+     * kernels that support multithreading.  The default value is 0, which means to use one
+     * thread for every available core.
+     */
+    static const std::string& ReferenceThreads() {
+        static const std::string key = "Threads";
+        return key;
+    }
 };
 
 class OPENMM_EXPORT ReferencePlatform::PlatformData {
@@ -77,6 +87,7 @@ public:
     ReferenceConstraints* constraints;
     ReferenceVirtualSites* virtualSites;
     std::map<std::string, double>* energyParameterDerivatives;
+    std::map<std::string, std::string> propertyValues;
 };
 } // namespace OpenMM
 
@@ -54,13 +54,16 @@ public:
     int getNumArguments() const;
     double evaluate(const double* arguments) const;
     double evaluateDerivative(const double* arguments, const int* derivOrder) const;
+    void evaluateVector(const float* const* arguments, const int* derivOrder, float* results, int count) const;
     CustomFunction* clone() const;
 private:
     ReferenceContinuous1DFunction(const ReferenceContinuous1DFunction& other);
+    void computeCoefficients();
     const Continuous1DFunction& function;
-    double min, max;
+    double min, max, invSpacing;
     bool periodic;
     std::vector<double> x, values, derivs;
+    std::vector<double> coeff;
 };
 
 /**
@@ -161,6 +164,7 @@ public:
     int getNumArguments() const;
     double evaluate(const double* arguments) const;
     double evaluateDerivative(const double* arguments, const int* derivOrder) const;
+    void evaluateVector(const float* const* arguments, const int* derivOrder, float* results, int count) const;
     CustomFunction* clone() const;
 private:
     std::shared_ptr<const CustomFunction> pointer;
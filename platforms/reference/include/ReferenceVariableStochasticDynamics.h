@@ -26,12 +26,13 @@
 #define __ReferenceVariableStochasticDynamics_H__
 
 #include "ReferenceDynamics.h"
+#include "openmm/internal/windowsExport.h"
 
 namespace OpenMM {
 
-class ReferenceVariableStochasticDynamics : public ReferenceDynamics {
+class OPENMM_EXPORT ReferenceVariableStochasticDynamics : public ReferenceDynamics {
 
-   private:
+   protected:
 
       std::vector<OpenMM::Vec3> xPrime, oldx;
       std::vector<double> inverseMasses;
@@ -113,7 +114,7 @@ class ReferenceVariableStochasticDynamics : public ReferenceDynamics {
       
          --------------------------------------------------------------------------------------- */
       
-      void updatePart1(int numberOfAtoms, std::vector<OpenMM::Vec3>& velocities,  std::vector<OpenMM::Vec3>& forces, std::vector<double>& inverseMasses, double maxStepSize);
+      virtual void updatePart1(int numberOfAtoms, std::vector<OpenMM::Vec3>& velocities,  std::vector<OpenMM::Vec3>& forces, std::vector<double>& inverseMasses, double maxStepSize);
 
       /**---------------------------------------------------------------------------------------
       
@@ -127,9 +128,36 @@ class ReferenceVariableStochasticDynamics : public ReferenceDynamics {
       
          --------------------------------------------------------------------------------------- */
       
-      void updatePart2(int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities,
+      virtual void updatePart2(int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities,
                                std::vector<double>& inverseMasses, std::vector<OpenMM::Vec3>& xPrime);
       
+      /**---------------------------------------------------------------------------------------
+      
+         Third update: copy the constrained positions and compute velocities from them
+      
+         @param numberOfAtoms       number of atoms
+         @param atomCoordinates     atom coordinates
+         @param velocities          velocities
+         @param inverseMasses       inverse atom masses
+         @param xPrime              xPrime
+      
+         --------------------------------------------------------------------------------------- */
+      
+      virtual void updatePart3(int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities,
+                               std::vector<double>& inverseMasses, std::vector<OpenMM::Vec3>& xPrime);
+      
+   protected:
+      
+      /**---------------------------------------------------------------------------------------
+      
+         Select the size of the next step and store it with setDeltaT()
+      
+         @param error               the RMS acceleration over all degrees of freedom
+         @param maxStepSize         maximum time step
+      
+         --------------------------------------------------------------------------------------- */
+      
+      void selectStepSize(double error, double maxStepSize);
 };
 
 } // namespace OpenMM
@@ -283,6 +283,33 @@ void ReferenceUpdateStateDataKernel::getForces(ContextImpl& context, std::vector
         forces[i] = Vec3(forceData[i][0], forceData[i][1], forceData[i][2]);
 }
 
+void ReferenceUpdateStateDataKernel::getParticlePositions(ContextImpl& context, const vector<int>& particles, vector<Vec3>& positions) {
+    vector<Vec3>& posData = extractPositions(context);
+    positions.resize(particles.size());
+    for (int i = 0; i < particles.size(); ++i)
+        positions[i] = posData[particles[i]];
+}
+
+void ReferenceUpdateStateDataKernel::getParticleVelocities(ContextImpl& context, const vector<int>& particles, vector<Vec3>& velocities) {
+    vector<Vec3>& velData = extractVelocities(context);
+    velocities.resize(particles.size());
+    for (int i = 0; i < particles.size(); ++i)
+        velocities[i] = velData[particles[i]];
+}
+
+void ReferenceUpdateStateDataKernel::scaleVelocities(ContextImpl& context, double scale) {
+    vector<Vec3>& velData = extractVelocities(context);
+    for (Vec3& v : velData)
+        v *= scale;
+}
+
+void ReferenceUpdateStateDataKernel::getParticleForces(ContextImpl& context, const vector<int>& particles, vector<Vec3>& forces) {
+    vector<Vec3>& forceData = extractForces(context);
+    forces.resize(particles.size());
+    for (int i = 0; i < particles.size(); ++i)
+        forces[i] = forceData[particles[i]];
+}
+
 void ReferenceUpdateStateDataKernel::getEnergyParameterDerivatives(ContextImpl& context, map<string, double>& derivs) {
     derivs = extractEnergyParameterDerivatives(context);
 }
@@ -907,19 +934,19 @@ void ReferenceCalcNonbondedForceKernel::initialize(const System& system, const N
         exceptionsWithOffsets.insert(exception);
     }
     numParticles = force.getNumParticles();
-    exclusions.resize(numParticles);
+    vector<pair<int, int> > excludedPairs(force.getNumExceptions());
     vector<int> nb14s;
     for (int i = 0; i < force.getNumExceptions(); i++) {
         int particle1, particle2;
         double chargeProd, sigma, epsilon;
         force.getExceptionParameters(i, particle1, particle2, chargeProd, sigma, epsilon);
-        exclusions[particle1].insert(particle2);
-        exclusions[particle2].insert(particle1);
+        excludedPairs[i] = make_pair(particle1, particle2);
         if (chargeProd != 0.0 || epsilon != 0.0 || exceptionsWithOffsets.find(i) != exceptionsWithOffsets.end()) {
             nb14Index[i] = nb14s.size();
             nb14s.push_back(i);
         }
     }
+    exclusions = ExclusionList(numParticles, excludedPairs);
 
     // Build the arrays.
 
@@ -1193,13 +1220,10 @@ void ReferenceCalcCustomNonbondedForceKernel::initialize(const System& system, c
     // Record the exclusions.
 
     numParticles = force.getNumParticles();
-    exclusions.resize(numParticles);
-    for (int i = 0; i < force.getNumExclusions(); i++) {
-        int particle1, particle2;
-        force.getExclusionParticles(i, particle1, particle2);
-        exclusions[particle1].insert(particle2);
-        exclusions[particle2].insert(particle1);
-    }
+    vector<pair<int, int> > excludedPairs(force.getNumExclusions());
+    for (int i = 0; i < force.getNumExclusions(); i++)
+        force.getExclusionParticles(i, excludedPairs[i].first, excludedPairs[i].second);
+    exclusions = ExclusionList(numParticles, excludedPairs);
 
     // Build the arrays.
 
@@ -1378,7 +1402,7 @@ void ReferenceCalcCustomNonbondedForceKernel::copyParametersToContext(ContextImp
     
     if (forceCopy != NULL) {
         ThreadPool& threads = extractThreadPool(context);
-        longRangeCorrectionData = CustomNonbondedForceImpl::prepareLongRangeCorrection(force, threads.getNumThreads());
+        longRangeCorrectionData = CustomNonbondedForceImpl::prepareLongRangeCorrection(force, threads.getNumThreads(), longRangeCorrectionData);
         CustomNonbondedForceImpl::calcLongRangeCorrection(force, longRangeCorrectionData, context.getOwner(), longRangeCoefficient, longRangeCoefficientDerivs, threads);
         hasInitializedLongRangeCorrection = true;
         *forceCopy = force;
@@ -1481,13 +1505,10 @@ void ReferenceCalcCustomGBForceKernel::initialize(const System& system, const Cu
     // Record the exclusions.
 
     numParticles = force.getNumParticles();
-    exclusions.resize(numParticles);
-    for (int i = 0; i < force.getNumExclusions(); i++) {
-        int particle1, particle2;
-        force.getExclusionParticles(i, particle1, particle2);
-        exclusions[particle1].insert(particle2);
-        exclusions[particle2].insert(particle1);
-    }
+    vector<pair<int, int> > excludedPairs(force.getNumExclusions());
+    for (int i = 0; i < force.getNumExclusions(); i++)
+        force.getExclusionParticles(i, excludedPairs[i].first, excludedPairs[i].second);
+    exclusions = ExclusionList(numParticles, excludedPairs);
 
     // Build the arrays.
 
@@ -1629,7 +1650,7 @@ double ReferenceCalcCustomGBForceKernel::execute(ContextImpl& context, bool incl
     if (periodic)
         ixn.setPeriodic(extractBoxVectors(context));
     if (nonbondedMethod != NoCutoff) {
-        vector<set<int> > empty(context.getSystem().getNumParticles()); // Don't omit exclusions from the neighbor list
+        ExclusionList empty(context.getSystem().getNumParticles()); // Don't omit exclusions from the neighbor list
         computeNeighborListVoxelHash(*neighborList, numParticles, posData, empty, extractBoxVectors(context), periodic, nonbondedCutoff, 0.0);
         ixn.setUseCutoff(nonbondedCutoff, *neighborList);
     }
@@ -2650,6 +2671,84 @@ double ReferenceIntegrateLangevinMiddleStepKernel::computeKineticEnergy(ContextI
     return computeShiftedKineticEnergy(context, masses, 0.0);
 }
 
+void ReferenceIntegrateMTSLangevinStepKernel::initialize(const System& system, const MTSLangevinIntegrator& integrator) {
+    int numParticles = system.getNumParticles();
+    masses.resize(numParticles);
+    inverseMasses.resize(numParticles);
+    for (int i = 0; i < numParticles; ++i) {
+        masses[i] = system.getParticleMass(i);
+        inverseMasses[i] = (masses[i] == 0.0 ? 0.0 : 1.0/masses[i]);
+    }
+    xPrime.resize(numParticles);
+    oldx.resize(numParticles);
+    savedForces.resize(integrator.getGroups().size());
+    SimTKOpenMMUtilities::setRandomNumberSeed((unsigned int) integrator.getRandomNumberSeed());
+}
+
+void ReferenceIntegrateMTSLangevinStepKernel::kick(ContextImpl& context, const MTSLangevinIntegrator& integrator, double dt) {
+    vector<Vec3>& velData = extractVelocities(context);
+    vector<Vec3>& forceData = extractForces(context);
+    int numParticles = velData.size();
+    for (int i = 0; i < numParticles; i++)
+        if (inverseMasses[i] != 0.0)
+            velData[i] += (dt*inverseMasses[i])*forceData[i];
+}
+
+void ReferenceIntegrateMTSLangevinStepKernel::innerStep(ContextImpl& context, const MTSLangevinIntegrator& integrator, double kickDt, double dt) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    ReferenceConstraints& constraints = extractConstraints(context);
+    double tolerance = integrator.getConstraintTolerance();
+    int numParticles = posData.size();
+    kick(context, integrator, kickDt);
+    const double halfdt = 0.5*dt;
+    const double kT = BOLTZ*integrator.getTemperature();
+    const double vscale = exp(-dt*integrator.getFriction());
+    const double noisescale = sqrt(1-vscale*vscale);
+    for (int i = 0; i < numParticles; i++) {
+        if (inverseMasses[i] != 0.0) {
+            xPrime[i] = posData[i] + velData[i]*halfdt;
+            velData[i] = vscale*velData[i] + noisescale*sqrt(kT*inverseMasses[i])*Vec3(
+                    SimTKOpenMMUtilities::getNormallyDistributedRandomNumber(),
+                    SimTKOpenMMUtilities::getNormallyDistributedRandomNumber(),
+                    SimTKOpenMMUtilities::getNormallyDistributedRandomNumber());
+            xPrime[i] = xPrime[i] + velData[i]*halfdt;
+            oldx[i] = xPrime[i];
+        }
+        else
+            xPrime[i] = oldx[i] = posData[i];
+    }
+    constraints.apply(posData, xPrime, inverseMasses, tolerance);
+    for (int i = 0; i < numParticles; i++) {
+        if (inverseMasses[i] != 0.0) {
+            velData[i] += (xPrime[i]-oldx[i])/dt;
+            posData[i] = xPrime[i];
+        }
+    }
+    extractVirtualSites(context).computePositions(context.getSystem(), posData);
+}
+
+void ReferenceIntegrateMTSLangevinStepKernel::saveForces(ContextImpl& context, const MTSLangevinIntegrator& integrator, int level) {
+    savedForces[level] = extractForces(context);
+}
+
+void ReferenceIntegrateMTSLangevinStepKernel::restoreForces(ContextImpl& context, const MTSLangevinIntegrator& integrator, int level) {
+    extractForces(context) = savedForces[level];
+}
+
+bool ReferenceIntegrateMTSLangevinStepKernel::finishStep(ContextImpl& context, const MTSLangevinIntegrator& integrator) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    extractConstraints(context).applyToVelocities(posData, velData, inverseMasses, integrator.getConstraintTolerance());
+    data.time += integrator.getStepSize();
+    data.stepCount++;
+    return true;
+}
+
+double ReferenceIntegrateMTSLangevinStepKernel::computeKineticEnergy(ContextImpl& context, const MTSLangevinIntegrator& integrator) {
+    return computeShiftedKineticEnergy(context, masses, 0.0);
+}
+
 ReferenceIntegrateBrownianStepKernel::~ReferenceIntegrateBrownianStepKernel() {
     if (dynamics)
         delete dynamics;
@@ -2965,6 +3064,28 @@ void ReferenceApplyMonteCarloBarostatKernel::computeKineticEnergy(ContextImpl& c
     barostat->computeMolecularKineticEnergy(extractVelocities(context), ke, components);
 }
 
+void ReferenceCalcProtocolWorkKernel::initialize(const System& system) {
+}
+
+void ReferenceCalcProtocolWorkKernel::beginMove(ContextImpl& context) {
+    savedPositions = extractPositions(context);
+    savedVelocities = extractVelocities(context);
+    work = 0.0;
+}
+
+void ReferenceCalcProtocolWorkKernel::restoreState(ContextImpl& context) {
+    extractPositions(context) = savedPositions;
+    extractVelocities(context) = savedVelocities;
+}
+
+void ReferenceCalcProtocolWorkKernel::addEnergy(ContextImpl& context, double scale, int groups) {
+    work += scale*context.calcForcesAndEnergy(false, true, groups);
+}
+
+double ReferenceCalcProtocolWorkKernel::getWork(ContextImpl& context) {
+    return work;
+}
+
 void ReferenceRemoveCMMotionKernel::initialize(const System& system, const CMMotionRemover& force) {
     frequency = force.getFrequency();
     masses.resize(system.getNumParticles());
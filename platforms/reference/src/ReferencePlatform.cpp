@@ -32,6 +32,7 @@
 #include "ReferencePlatform.h"
 #include "ReferenceKernelFactory.h"
 #include "ReferenceKernels.h"
+#include "openmm/OpenMMException.h"
 #include "openmm/internal/ContextImpl.h"
 #include "SimTKOpenMMRealType.h"
 #include "openmm/Vec3.h"
@@ -71,6 +72,7 @@ ReferencePlatform::ReferencePlatform() {
     registerKernelFactory(IntegrateVerletStepKernel::Name(), factory);
     registerKernelFactory(IntegrateNoseHooverStepKernel::Name(), factory);
     registerKernelFactory(IntegrateLangevinMiddleStepKernel::Name(), factory);
+    registerKernelFactory(IntegrateMTSLangevinStepKernel::Name(), factory);
     registerKernelFactory(IntegrateBrownianStepKernel::Name(), factory);
     registerKernelFactory(IntegrateVariableLangevinStepKernel::Name(), factory);
     registerKernelFactory(IntegrateVariableVerletStepKernel::Name(), factory);
@@ -78,7 +80,10 @@ ReferencePlatform::ReferencePlatform() {
     registerKernelFactory(IntegrateDPDStepKernel::Name(), factory);
     registerKernelFactory(ApplyAndersenThermostatKernel::Name(), factory);
     registerKernelFactory(ApplyMonteCarloBarostatKernel::Name(), factory);
+    registerKernelFactory(CalcProtocolWorkKernel::Name(), factory);
     registerKernelFactory(RemoveCMMotionKernel::Name(), factory);
+    platformProperties.push_back(ReferenceThreads());
+    setPropertyDefaultValue(ReferenceThreads(), "0");
 }
 
 double ReferencePlatform::getSpeed() const {
@@ -89,11 +94,27 @@ bool ReferencePlatform::supportsDoublePrecision() const {
     return true;
 }
 
+const string& ReferencePlatform::getPropertyValue(const Context& context, const string& property) const {
+    const ContextImpl& impl = getContextImpl(context);
+    const PlatformData* data = reinterpret_cast<const PlatformData*>(impl.getPlatformData());
+    map<string, string>::const_iterator value = data->propertyValues.find(property);
+    if (value != data->propertyValues.end())
+        return value->second;
+    return Platform::getPropertyValue(context, property);
+}
+
 void ReferencePlatform::contextCreated(ContextImpl& context, const map<string, string>& properties) const {
+    const string& threadsPropValue = (properties.find(ReferenceThreads()) == properties.end() ?
+            getPropertyDefaultValue(ReferenceThreads()) : properties.find(ReferenceThreads())->second);
     int numThreads = 0;
-    if (properties.find("Threads") != properties.end())
-        stringstream(properties.at("Threads")) >> numThreads;
-    context.setPlatformData(new PlatformData(context.getSystem(), numThreads));
+    stringstream(threadsPropValue) >> numThreads;
+    if (numThreads < 0)
+        throw OpenMMException("ReferencePlatform: Illegal value for "+ReferenceThreads()+": "+threadsPropValue);
+    PlatformData* data = new PlatformData(context.getSystem(), numThreads);
+    stringstream threadsProperty;
+    threadsProperty << data->threads.getNumThreads();
+    data->propertyValues[ReferenceThreads()] = threadsProperty.str();
+    context.setPlatformData(data);
 }
 
 void ReferencePlatform::contextDestroyed(ContextImpl& context) const {
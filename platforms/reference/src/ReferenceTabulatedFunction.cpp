@@ -89,6 +89,7 @@ ReferenceContinuous1DFunction::ReferenceContinuous1DFunction(const Continuous1DF
     for (int i = 0; i < numValues; i++)
         x[i] = min+i*(max-min)/(numValues-1);
     SplineFitter::createSpline(x, values, periodic, derivs);
+    computeCoefficients();
 }
 
 ReferenceContinuous1DFunction::ReferenceContinuous1DFunction(const ReferenceContinuous1DFunction& other) : function(other.function) {
@@ -97,6 +98,27 @@ ReferenceContinuous1DFunction::ReferenceContinuous1DFunction(const ReferenceCont
     x = other.x;
     values = other.values;
     derivs = other.derivs;
+    invSpacing = other.invSpacing;
+    coeff = other.coeff;
+}
+
+void ReferenceContinuous1DFunction::computeCoefficients() {
+    // Convert the spline to a cubic polynomial in the fractional position within each
+    // interval.  The four coefficients for an interval are stored contiguously, so evaluating
+    // a point only needs to load a single block of memory.
+
+    int numIntervals = x.size()-1;
+    double spacing = (max-min)/numIntervals;
+    invSpacing = 1.0/spacing;
+    coeff.resize(4*numIntervals);
+    for (int i = 0; i < numIntervals; i++) {
+        double s0 = derivs[i]*spacing*spacing/6.0;
+        double s1 = derivs[i+1]*spacing*spacing/6.0;
+        coeff[4*i] = values[i];
+        coeff[4*i+1] = values[i+1]-values[i]-2.0*s0-s1;
+        coeff[4*i+2] = 3.0*s0;
+        coeff[4*i+3] = s1-s0;
+    }
 }
 
 int ReferenceContinuous1DFunction::getNumArguments() const {
@@ -117,6 +139,27 @@ double ReferenceContinuous1DFunction::evaluateDerivative(const double* arguments
     return SplineFitter::evaluateSplineDerivative(x, values, derivs, t);
 }
 
+void ReferenceContinuous1DFunction::evaluateVector(const float* const* arguments, const int* derivOrder, float* results, int count) const {
+    const float* t = arguments[0];
+    const int lastInterval = coeff.size()/4-1;
+    const double* c = &coeff[0];
+    for (int j = 0; j < count; j++) {
+        double pos = periodic ? wrap(t[j], min, max) : t[j];
+        if (!(pos >= min && pos <= max)) {
+            results[j] = 0.0f;
+            continue;
+        }
+        double scaled = (pos-min)*invSpacing;
+        int index = (std::min)((int) scaled, lastInterval);
+        double u = scaled-index;
+        const double* ci = c+4*index;
+        if (derivOrder == NULL)
+            results[j] = (float) (ci[0]+u*(ci[1]+u*(ci[2]+u*ci[3])));
+        else
+            results[j] = (float) ((ci[1]+u*(2.0*ci[2]+u*3.0*ci[3]))*invSpacing);
+    }
+}
+
 CustomFunction* ReferenceContinuous1DFunction::clone() const {
     return new ReferenceContinuous1DFunction(*this);
 }
@@ -330,6 +373,10 @@ double SharedFunctionWrapper::evaluateDerivative(const double* arguments, const
     return pointer->evaluateDerivative(arguments, derivOrder);
 }
 
+void SharedFunctionWrapper::evaluateVector(const float* const* arguments, const int* derivOrder, float* results, int count) const {
+    pointer->evaluateVector(arguments, derivOrder, results, count);
+}
+
 CustomFunction* SharedFunctionWrapper::clone() const {
     return new SharedFunctionWrapper(pointer);
 }
@@ -202,10 +202,17 @@ void ReferenceCMAPTorsionIxn::calculateOneIxn(int index, vector<Vec3>& atomCoord
 
 /**---------------------------------------------------------------------------------------
 
-   This is present only because we must define it to subclass ReferenceBondIxn.  It is never called.
+   Calculate the interaction due to a single torsion pair
+
+   @param atomIndices      the eight atoms forming the torsion pair (not used)
+   @param atomCoordinates  atom coordinates
+   @param parameters       parameters[0] is the index of the torsion pair
+   @param forces           force array (forces added)
+   @param totalEnergy      if not null, the energy will be added to this
 
    --------------------------------------------------------------------------------------- */
 
 void ReferenceCMAPTorsionIxn::calculateBondIxn(vector<int>& atomIndices, vector<Vec3>& atomCoordinates,
         vector<double>& parameters, vector<Vec3>& forces, double* totalEnergy, double* energyParamDerivs) {
+    calculateOneIxn((int) parameters[0], atomCoordinates, forces, totalEnergy);
 }
@@ -71,8 +71,10 @@ ReferenceCustomCVForce::ReferenceCustomCVForce(const CustomCVForce& force) {
 
     map<string, CustomFunction*> functions;
     tabulatedFunctions.resize(force.getNumTabulatedFunctions(), NULL);
+    tabulatedFunctionUpdateCount.resize(force.getNumTabulatedFunctions());
     for (int i = 0; i < force.getNumTabulatedFunctions(); i++) {
         tabulatedFunctions[i] = createReferenceTabulatedFunction(force.getTabulatedFunction(i));
+        tabulatedFunctionUpdateCount[i] = force.getTabulatedFunction(i).getUpdateCount();
         functions[force.getTabulatedFunctionName(i)] = new TabulatedFunctionWrapper(tabulatedFunctions, i);
     }
 
@@ -106,9 +108,12 @@ ReferenceCustomCVForce::ReferenceCustomCVForce(const CustomCVForce& force) {
 }
 
 void ReferenceCustomCVForce::updateTabulatedFunctions(const OpenMM::CustomCVForce& force) {
-    // Create custom functions for the tabulated functions.
+    // Recreate the custom functions for any tabulated functions that have changed.
 
     for (int i = 0; i < force.getNumTabulatedFunctions(); i++) {
+        if (force.getTabulatedFunction(i).getUpdateCount() == tabulatedFunctionUpdateCount[i])
+            continue;
+        tabulatedFunctionUpdateCount[i] = force.getTabulatedFunction(i).getUpdateCount();
         if (tabulatedFunctions[i] != NULL) {
             delete tabulatedFunctions[i];
             tabulatedFunctions[i] = NULL;
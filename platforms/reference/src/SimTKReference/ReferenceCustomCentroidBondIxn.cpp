@@ -74,6 +74,18 @@ void ReferenceCustomCentroidBondIxn::setPeriodic(OpenMM::Vec3* vectors) {
     boxVectors[2] = vectors[2];
 }
 
+void ReferenceCustomCentroidBondIxn::setGlobalParameters(const map<string, double>& parameters) {
+    for (auto& param : parameters)
+        expressionSet.setVariable(expressionSet.getVariableIndex(param.first), param.second);
+}
+
+void ReferenceCustomCentroidBondIxn::calculateBondIxn(vector<int>& groupIndices, vector<Vec3>& groupCenters,
+                        vector<double>& parameters, vector<Vec3>& groupForces, double* totalEnergy, double* energyParamDerivs) {
+    for (int i = 0; i < numParameters; i++)
+        expressionSet.setVariable(bondParamIndex[i], parameters[i]);
+    calculateOneIxn(groupIndices, groupCenters, groupForces, totalEnergy, energyParamDerivs);
+}
+
 void ReferenceCustomCentroidBondIxn::calculatePairIxn(vector<Vec3>& atomCoordinates, vector<vector<double> >& bondParameters,
                                              const map<string, double>& globalParameters, vector<Vec3>& forces,
                                              double* totalEnergy, double* energyParamDerivs) {
@@ -96,7 +108,7 @@ void ReferenceCustomCentroidBondIxn::calculatePairIxn(vector<Vec3>& atomCoordina
     for (int bond = 0; bond < numBonds; bond++) {
         for (int i = 0; i < numParameters; i++)
             expressionSet.setVariable(bondParamIndex[i], bondParameters[bond][i]);
-        calculateOneIxn(bond, groupCenters, groupForces, totalEnergy, energyParamDerivs);
+        calculateOneIxn(bondGroups[bond], groupCenters, groupForces, totalEnergy, energyParamDerivs);
     }
 
     // Apply the forces to the individual atoms.
@@ -107,11 +119,10 @@ void ReferenceCustomCentroidBondIxn::calculatePairIxn(vector<Vec3>& atomCoordina
     }
 }
 
-void ReferenceCustomCentroidBondIxn::calculateOneIxn(int bond, vector<Vec3>& groupCenters,
+void ReferenceCustomCentroidBondIxn::calculateOneIxn(const vector<int>& groups, vector<Vec3>& groupCenters,
                         vector<Vec3>& forces, double* totalEnergy, double* energyParamDerivs) {
     // Compute all of the variables the energy can depend on.
 
-    const vector<int>& groups = bondGroups[bond];
     for (auto& term : positionTerms)
         expressionSet.setVariable(term.index, groupCenters[groups[term.group]][term.component]);
 
@@ -151,7 +151,7 @@ ReferenceCustomGBIxn::~ReferenceCustomGBIxn() {
   }
 
 void ReferenceCustomGBIxn::calculateIxn(int numberOfAtoms, vector<Vec3>& atomCoordinates, vector<vector<double> >& atomParameters,
-                                           const vector<set<int> >& exclusions, map<string, double>& globalParameters, vector<Vec3>& forces,
+                                           const ExclusionList& exclusions, map<string, double>& globalParameters, vector<Vec3>& forces,
                                            double* totalEnergy, double* energyParamDerivs) {
     for (auto& param : globalParameters)
         expressionSet.setVariable(expressionSet.getVariableIndex(param.first), param.second);
@@ -218,7 +218,7 @@ void ReferenceCustomGBIxn::calculateSingleParticleValue(int index, int numAtoms,
 }
 
 void ReferenceCustomGBIxn::calculateParticlePairValue(int index, int numAtoms, vector<Vec3>& atomCoordinates, vector<vector<double> >& atomParameters,
-        const vector<set<int> >& exclusions, bool useExclusions) {
+        const ExclusionList& exclusions, bool useExclusions) {
     values[index].resize(numAtoms);
     for (int i = 0; i < numAtoms; i++)
         values[index][i] = 0.0;
@@ -226,7 +226,7 @@ void ReferenceCustomGBIxn::calculateParticlePairValue(int index, int numAtoms, v
         // Loop over all pairs in the neighbor list.
 
         for (auto& pair : *neighborList) {
-            if (useExclusions && exclusions[pair.first].find(pair.second) != exclusions[pair.first].end())
+            if (useExclusions && exclusions.isExcluded(pair.first, pair.second))
                 continue;
             calculateOnePairValue(index, pair.first, pair.second, atomCoordinates, atomParameters);
             calculateOnePairValue(index, pair.second, pair.first, atomCoordinates, atomParameters);
@@ -237,7 +237,7 @@ void ReferenceCustomGBIxn::calculateParticlePairValue(int index, int numAtoms, v
 
         for (int i = 0; i < numAtoms; i++) {
             for (int j = i+1; j < numAtoms; j++) {
-                if (useExclusions && exclusions[i].find(j) != exclusions[i].end())
+                if (useExclusions && exclusions.isExcluded(i, j))
                     continue;
                 calculateOnePairValue(index, i, j, atomCoordinates, atomParameters);
                 calculateOnePairValue(index, j, i, atomCoordinates, atomParameters);
@@ -301,12 +301,12 @@ void ReferenceCustomGBIxn::calculateSingleParticleEnergyTerm(int index, int numA
 }
 
 void ReferenceCustomGBIxn::calculateParticlePairEnergyTerm(int index, int numAtoms, vector<Vec3>& atomCoordinates, vector<vector<double> >& atomParameters,
-        const vector<set<int> >& exclusions, bool useExclusions, vector<Vec3>& forces, double* totalEnergy, double* energyParamDerivs) {
+        const ExclusionList& exclusions, bool useExclusions, vector<Vec3>& forces, double* totalEnergy, double* energyParamDerivs) {
     if (cutoff) {
         // Loop over all pairs in the neighbor list.
 
         for (auto& pair : *neighborList) {
-            if (useExclusions && exclusions[pair.first].find(pair.second) != exclusions[pair.first].end())
+            if (useExclusions && exclusions.isExcluded(pair.first, pair.second))
                 continue;
             calculateOnePairEnergyTerm(index, pair.first, pair.second, atomCoordinates, atomParameters, forces, totalEnergy, energyParamDerivs);
         }
@@ -316,7 +316,7 @@ void ReferenceCustomGBIxn::calculateParticlePairEnergyTerm(int index, int numAto
 
         for (int i = 0; i < numAtoms; i++) {
             for (int j = i+1; j < numAtoms; j++) {
-                if (useExclusions && exclusions[i].find(j) != exclusions[i].end())
+                if (useExclusions && exclusions.isExcluded(i, j))
                     continue;
                 calculateOnePairEnergyTerm(index, i, j, atomCoordinates, atomParameters, forces, totalEnergy, energyParamDerivs);
            }
@@ -371,12 +371,12 @@ void ReferenceCustomGBIxn::calculateOnePairEnergyTerm(int index, int atom1, int
 }
 
 void ReferenceCustomGBIxn::calculateChainRuleForces(int numAtoms, vector<Vec3>& atomCoordinates, vector<vector<double> >& atomParameters,
-        const vector<set<int> >& exclusions, vector<Vec3>& forces, double* energyParamDerivs) {
+        const ExclusionList& exclusions, vector<Vec3>& forces, double* energyParamDerivs) {
     if (cutoff) {
         // Loop over all pairs in the neighbor list.
 
         for (auto& pair : *neighborList) {
-            bool isExcluded = (exclusions[pair.first].find(pair.second) != exclusions[pair.first].end());
+            bool isExcluded = (exclusions.isExcluded(pair.first, pair.second));
             calculateOnePairChainRule(pair.first, pair.second, atomCoordinates, atomParameters, forces, isExcluded);
             calculateOnePairChainRule(pair.second, pair.first, atomCoordinates, atomParameters, forces, isExcluded);
         }
@@ -386,7 +386,7 @@ void ReferenceCustomGBIxn::calculateChainRuleForces(int numAtoms, vector<Vec3>&
 
         for (int i = 0; i < numAtoms; i++) {
             for (int j = i+1; j < numAtoms; j++) {
-                bool isExcluded = (exclusions[i].find(j) != exclusions[i].end());
+                bool isExcluded = (exclusions.isExcluded(i, j));
                 calculateOnePairChainRule(i, j, atomCoordinates, atomParameters, forces, isExcluded);
                 calculateOnePairChainRule(j, i, atomCoordinates, atomParameters, forces, isExcluded);
            }
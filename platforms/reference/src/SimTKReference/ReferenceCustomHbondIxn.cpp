@@ -29,6 +29,8 @@
 #include "SimTKOpenMMUtilities.h"
 #include "ReferenceForce.h"
 #include "ReferenceCustomHbondIxn.h"
+#include "ReferenceNeighborList.h"
+#include <algorithm>
 
 using std::map;
 using std::pair;
@@ -127,6 +129,45 @@ void ReferenceCustomHbondIxn::calculatePairIxn(vector<Vec3>& atomCoordinates, ve
    int numDonors = donorAtoms.size();
    int numAcceptors = acceptorAtoms.size();
 
+   if (cutoff) {
+      // Use a voxel hash over the primary donor and acceptor atoms to find the pairs that
+      // might be within the cutoff.  Acceptors come first in the list, followed by donors,
+      // and only pairs that combine one of each are kept.
+
+      AtomLocationList locations(numAcceptors+numDonors);
+      for (int acceptor = 0; acceptor < numAcceptors; acceptor++)
+         locations[acceptor] = atomCoordinates[acceptorAtoms[acceptor][0]];
+      for (int donor = 0; donor < numDonors; donor++)
+         locations[numAcceptors+donor] = atomCoordinates[donorAtoms[donor][0]];
+      ExclusionList noExclusions(locations.size());
+      NeighborList neighbors;
+      if (locations.size() > 0)
+         computeNeighborListVoxelHash(neighbors, locations.size(), locations, noExclusions, periodicBoxVectors, periodic, cutoffDistance, 0.0);
+      vector<pair<int, int> > candidates;
+      for (auto& neighbor : neighbors) {
+         int first = neighbor.first, second = neighbor.second;
+         if (first < numAcceptors && second >= numAcceptors)
+            candidates.push_back(std::make_pair(second-numAcceptors, first));
+         else if (second < numAcceptors && first >= numAcceptors)
+            candidates.push_back(std::make_pair(first-numAcceptors, second));
+      }
+      sort(candidates.begin(), candidates.end());
+      int lastDonor = -1;
+      for (auto& candidate : candidates) {
+         int donor = candidate.first, acceptor = candidate.second;
+         if (donor != lastDonor) {
+            for (int j = 0; j < (int) donorParamNames.size(); j++)
+               variables[donorParamNames[j]] = donorParameters[donor][j];
+            lastDonor = donor;
+         }
+         if (exclusions[donor].find(acceptor) == exclusions[donor].end()) {
+            for (int j = 0; j < (int) acceptorParamNames.size(); j++)
+               variables[acceptorParamNames[j]] = acceptorParameters[acceptor][j];
+            calculateOneIxn(donor, acceptor, atomCoordinates, variables, forces, totalEnergy);
+         }
+      }
+      return;
+   }
    for (int donor = 0; donor < numDonors; donor++) {
       // Initialize per-donor parameters.
 
@@ -164,7 +164,7 @@ void ReferenceCustomNonbondedIxn::setUseSwitchingFunction(double distance) {
    --------------------------------------------------------------------------------------- */
 
 void ReferenceCustomNonbondedIxn::calculatePairIxn(int numberOfAtoms, vector<Vec3>& atomCoordinates,
-                                             vector<vector<double> >& atomParameters, vector<set<int> >& exclusions,
+                                             vector<vector<double> >& atomParameters, const ExclusionList& exclusions,
                                              const map<string, double>& globalParameters, vector<Vec3>& forces,
                                              double* totalEnergy, double* energyParamDerivs) {
 
@@ -196,7 +196,7 @@ void ReferenceCustomNonbondedIxn::calculatePairIxn(int numberOfAtoms, vector<Vec
             const set<int>& set2 = group.second;
             for (set<int>::const_iterator atom1 = set1.begin(); atom1 != set1.end(); ++atom1) {
                 for (set<int>::const_iterator atom2 = set2.begin(); atom2 != set2.end(); ++atom2) {
-                    if (*atom1 == *atom2 || exclusions[*atom1].find(*atom2) != exclusions[*atom1].end())
+                    if (*atom1 == *atom2 || exclusions.isExcluded(*atom1, *atom2))
                         continue; // This is an excluded interaction.
                     if (*atom1 > *atom2 && set1.find(*atom2) != set1.end() && set2.find(*atom1) != set2.end())
                         continue; // Both atoms are in both sets, so skip duplicate interactions.
@@ -233,7 +233,7 @@ void ReferenceCustomNonbondedIxn::calculatePairIxn(int numberOfAtoms, vector<Vec
         
         for (int ii = 0; ii < numberOfAtoms; ii++) {
             for (int jj = ii+1; jj < numberOfAtoms; jj++) {
-                if (exclusions[jj].find(ii) == exclusions[jj].end()) {
+                if (!exclusions.isExcluded(jj, ii)) {
                     for (int j = 0; j < (int) paramNames.size(); j++) {
                         expressionSet.setVariable(particleParamIndex[j*2], atomParameters[ii][j]);
                         expressionSet.setVariable(particleParamIndex[j*2+1], atomParameters[jj][j]);
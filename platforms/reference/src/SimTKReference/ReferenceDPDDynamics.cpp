@@ -81,7 +81,7 @@ void ReferenceDPDDynamics::updatePart2(int numParticles, vector<Vec3>& atomCoord
 
     // Apply friction and noise to velocities.
 
-    vector<set<int> > exclusions(numParticles);
+    ExclusionList exclusions(numParticles);
     computeNeighborListVoxelHash(neighborList, numParticles, atomCoordinates, exclusions, periodicBoxVectors, periodic, maxCutoff, 0.0);
     for (auto& pair : neighborList) {
         int i = pair.first;
@@ -188,7 +188,7 @@ void ReferenceLJCoulombIxn::setPeriodicExceptions(bool periodic) {
    --------------------------------------------------------------------------------------- */
 
 void ReferenceLJCoulombIxn::calculateEwaldIxn(int numberOfAtoms, vector<Vec3>& atomCoordinates,
-                                              vector<vector<double> >& atomParameters, vector<set<int> >& exclusions,
+                                              vector<vector<double> >& atomParameters, const ExclusionList& exclusions,
                                               vector<Vec3>& forces, double* totalEnergy, bool includeDirect, bool includeReciprocal) const {
     typedef std::complex<double> d_complex;
 
@@ -546,7 +546,7 @@ void ReferenceLJCoulombIxn::calculateEwaldIxn(int numberOfAtoms, vector<Vec3>& a
    --------------------------------------------------------------------------------------- */
 
 void ReferenceLJCoulombIxn::calculatePairIxn(int numberOfAtoms, vector<Vec3>& atomCoordinates,
-                                             vector<vector<double> >& atomParameters, vector<set<int> >& exclusions,
+                                             vector<vector<double> >& atomParameters, const ExclusionList& exclusions,
                                              vector<Vec3>& forces, double* totalEnergy, bool includeDirect, bool includeReciprocal) const {
 
     if (ewald || pme || ljpme) {
@@ -565,7 +565,7 @@ void ReferenceLJCoulombIxn::calculatePairIxn(int numberOfAtoms, vector<Vec3>& at
             // loop over atom pairs
 
             for (int jj = ii+1; jj < numberOfAtoms; jj++)
-                if (exclusions[jj].find(ii) == exclusions[jj].end())
+                if (!exclusions.isExcluded(jj, ii))
                     calculateOneIxn(ii, jj, atomCoordinates, atomParameters, forces, totalEnergy);
         }
     }
@@ -29,7 +29,7 @@ void OPENMM_EXPORT computeNeighborListNaive(
                               NeighborList& neighborList,
                               int nAtoms,
                               const AtomLocationList& atomLocations, 
-                              const vector<set<int> >& exclusions,
+                              const ExclusionList& exclusions,
                               const Vec3* periodicBoxVectors,
                               bool usePeriodic,
                               double maxDistance,
@@ -46,7 +46,7 @@ void OPENMM_EXPORT computeNeighborListNaive(
         {
             double pairDistanceSquared = compPairDistanceSquared(atomLocations[atomI], atomLocations[atomJ], periodicBoxVectors, usePeriodic);
             if ((pairDistanceSquared <= maxDistanceSquared)  && (pairDistanceSquared >= minDistanceSquared))
-                if (exclusions[atomI].find(atomJ) == exclusions[atomI].end())
+                if (!exclusions.isExcluded(atomI, atomJ))
                 {
                     neighborList.push_back(AtomPair(atomI, atomJ));
                     if (reportSymmetricPairs)
@@ -136,7 +136,7 @@ public:
     void getNeighbors(
             NeighborList& neighbors, 
             const VoxelItem& referencePoint, 
-            const vector<set<int> >& exclusions,
+            const ExclusionList& exclusions,
             bool reportSymmetricPairs,
             double maxDistance, 
             double minDistance) const 
@@ -210,7 +210,7 @@ public:
                         if (dSquared < minDistanceSquared) continue;
                         
                         // Ignore exclusions.
-                        if (exclusions[atomI].find(atomJ) != exclusions[atomI].end()) continue;
+                        if (exclusions.isExcluded(atomI, atomJ)) continue;
                         
                         neighbors.push_back(AtomPair(atomI, atomJ));
                         if (reportSymmetricPairs)
@@ -235,7 +235,7 @@ void OPENMM_EXPORT computeNeighborListVoxelHash(
                               NeighborList& neighborList,
                               int nAtoms,
                               const AtomLocationList& atomLocations,
-                              const vector<set<int> >& exclusions,
+                              const ExclusionList& exclusions,
                               const Vec3* periodicBoxVectors,
                               bool usePeriodic,
                               double maxDistance,
@@ -107,7 +107,17 @@ void ReferenceVariableStochasticDynamics::updatePart1(int numberOfAtoms, vector<
             error += xerror*xerror;
         }
     }
-    error = sqrt(error/(numberOfAtoms*3));
+    selectStepSize(sqrt(error/(numberOfAtoms*3)), maxStepSize);
+ 
+    // perform first update
+
+    double dt = getDeltaT();
+    for (int i = 0; i < numberOfAtoms; i++)
+        if (inverseMasses[i] != 0.0)
+            velocities[i] += (dt*inverseMasses[i])*forces[i];
+}
+
+void ReferenceVariableStochasticDynamics::selectStepSize(double error, double maxStepSize) {
     double dt = sqrt(getAccuracy()/error);
     if (getDeltaT() > 0.0f)
         dt = std::min(dt, getDeltaT()*2.0f); // For safety, limit how quickly dt can increase.
@@ -116,12 +126,6 @@ void ReferenceVariableStochasticDynamics::updatePart1(int numberOfAtoms, vector<
     if (dt > maxStepSize)
         dt = maxStepSize;
     setDeltaT(dt);
- 
-    // perform first update
-
-    for (int i = 0; i < numberOfAtoms; i++)
-        if (inverseMasses[i] != 0.0)
-            velocities[i] += (dt*inverseMasses[i])*forces[i];
 }
 
 void ReferenceVariableStochasticDynamics::updatePart2(int numberOfAtoms, vector<Vec3>& atomCoordinates,
@@ -189,14 +193,19 @@ void ReferenceVariableStochasticDynamics::update(const OpenMM::System& system, v
 
     // copy xPrime -> atomCoordinates
 
+    updatePart3(numberOfAtoms, atomCoordinates, velocities, inverseMasses, xPrime);
+    getVirtualSites().computePositions(system, atomCoordinates);
+    incrementTimeStep();
+}
+
+void ReferenceVariableStochasticDynamics::updatePart3(int numberOfAtoms, vector<Vec3>& atomCoordinates,
+                                         vector<Vec3>& velocities, vector<double>& inverseMasses,
+                                         vector<Vec3>& xPrime) {
     double invStepSize = 1.0/getDeltaT();
     for (int i = 0; i < numberOfAtoms; i++) {
-        if (masses[i] != 0.0) {
+        if (inverseMasses[i] != 0.0) {
             velocities[i] += (xPrime[i]-oldx[i])*invStepSize;
             atomCoordinates[i] = xPrime[i];
         }
     }
-
-    getVirtualSites().computePositions(system, atomCoordinates);
-    incrementTimeStep();
 }
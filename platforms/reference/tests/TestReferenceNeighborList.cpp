@@ -44,7 +44,7 @@ void testNeighborList()
     vector<Vec3> particleList(2);
     particleList[0] = Vec3(13.6, 0, 0);
     particleList[1] = Vec3(0, 0, 0);
-    vector<set<int> > exclusions(2);
+    ExclusionList exclusions(2);
     
     NeighborList neighborList;
 
@@ -100,7 +100,7 @@ void testPeriodic() {
         particleList[i][1] = genrand_real2(sfmt)*periodicBoxVectors[1][1]*3;
         particleList[i][2] = genrand_real2(sfmt)*periodicBoxVectors[2][2]*3;
     }
-    vector<set<int> > exclusions(numParticles);
+    ExclusionList exclusions(numParticles);
     NeighborList neighborList;
     computeNeighborListNaive(neighborList, numParticles, particleList, exclusions, periodicBoxVectors, true, cutoff);
     verifyNeighborList(neighborList, numParticles, particleList, periodicBoxVectors, cutoff);
@@ -124,7 +124,7 @@ void testTriclinic() {
         particleList[i][1] = genrand_real2(sfmt)*periodicBoxVectors[1][1]*3;
         particleList[i][2] = genrand_real2(sfmt)*periodicBoxVectors[2][2]*3;
     }
-    vector<set<int> > exclusions(numParticles);
+    ExclusionList exclusions(numParticles);
     NeighborList neighborList;
     computeNeighborListNaive(neighborList, numParticles, particleList, exclusions, periodicBoxVectors, true, cutoff);
     verifyNeighborList(neighborList, numParticles, particleList, periodicBoxVectors, cutoff);
@@ -53,6 +53,24 @@ class OPENMM_EXPORT_AMOEBA AmoebaGeneralizedKirkwoodForce : public Force {
 
 public:
 
+    /**
+     * This is an enumeration of the different methods that may be used for handling long range interactions.
+     */
+    enum NonbondedMethod {
+        /**
+         * No cutoff is applied to the interactions.  The full set of N^2 interactions is computed exactly.
+         * This is the default.
+         */
+        NoCutoff = 0,
+        /**
+         * Interactions beyond the cutoff distance are ignored, both when computing the generalized
+         * Kirkwood reaction field and when computing effective Born radii.  Between 0.9 times the cutoff
+         * and the cutoff, interactions are smoothly tapered to zero with the same fifth order polynomial
+         * used by AmoebaVdwForce, so energies and forces are continuous.
+         */
+        CutoffNonPeriodic = 1,
+    };
+
     /*
      * Create an AmoebaGeneralizedKirkwoodForce.
      */
@@ -219,7 +237,10 @@ public:
     void setDescreenOffset(double descreenOffet);
 
     /**
-     * Get the flag signaling whether the cavity term should be included
+     * Get the flag signaling whether the cavity term should be included.  The cavity term uses
+     * the ACE approximation, which estimates each atom's solvent accessible surface area from
+     * its effective Born radius.  It costs O(N) on top of the Born radii and needs no separate
+     * surface area calculation.
      */
     int getIncludeCavityTerm() const;
 
@@ -255,16 +276,67 @@ public:
     void setDielectricOffset(double dielectricOffset);
 
     /**
-     * Get the surface area factor kJ/(nm*nm) used in SASA contribution
+     * Get the surface area factor kJ/(nm*nm) used in the ACE estimate of the SASA contribution.
      */
     double getSurfaceAreaFactor() const;
 
     /**
-     * Set the surface area factor kJ/(nm*nm) used in SASA contribution.
+     * Set the surface area factor kJ/(nm*nm) used in the ACE estimate of the SASA contribution.
      *
      * @param surfaceAreaFactor The surface area factor in kJ/(nm*nm).
      */
     void setSurfaceAreaFactor(double surfaceAreaFactor);
+    /**
+     * Get the method used for handling long range interactions.
+     */
+    NonbondedMethod getNonbondedMethod() const;
+    /**
+     * Set the method used for handling long range interactions.
+     */
+    void setNonbondedMethod(NonbondedMethod method);
+    /**
+     * Get the cutoff distance (in nm) being used for interactions.  If the NonbondedMethod in use
+     * is NoCutoff, this value will have no effect.
+     *
+     * @return the cutoff distance, measured in nm
+     */
+    double getCutoffDistance() const;
+    /**
+     * Set the cutoff distance (in nm) being used for interactions.  If the NonbondedMethod in use
+     * is NoCutoff, this value will have no effect.
+     *
+     * @param distance    the cutoff distance, measured in nm
+     */
+    void setCutoffDistance(double distance);
+    /**
+     * Get the number of force evaluations between full recomputations of the Born radii.  A value
+     * of 1 (the default) means the radii are recomputed on every evaluation.
+     */
+    int getBornRadiiUpdateInterval() const;
+    /**
+     * Set the number of force evaluations between full recomputations of the Born radii.  Born radii
+     * change slowly during molecular dynamics, so they can be reused for several steps.  Between
+     * updates, the energy and the chain rule forces are computed with the most recently computed radii
+     * (and their descreening integrals), while all other terms use the current positions.  Forces are
+     * therefore only approximately consistent with the energy unless the interval is 1.
+     *
+     * @param interval    the number of force evaluations between updates.  This must be at least 1.
+     */
+    void setBornRadiiUpdateInterval(int interval);
+    /**
+     * Get the maximum distance (in nm) any atom may move before the Born radii are recomputed,
+     * even if the update interval has not yet elapsed.  A value of 0 (the default) disables this check.
+     */
+    double getBornRadiiUpdateTolerance() const;
+    /**
+     * Set the maximum distance (in nm) any atom may move before the Born radii are recomputed,
+     * even if the update interval has not yet elapsed.  This bounds the error from reusing stale
+     * radii when atoms move quickly.  A value of 0 disables this check.  It has no effect if the
+     * update interval is 1.
+     *
+     * @param tolerance    the maximum displacement, measured in nm
+     */
+    void setBornRadiiUpdateTolerance(double tolerance);
     /**
      * Update the per-particle parameters in a Context to match those stored in this Force object.  This method provides
      * an efficient method to update certain parameters in an existing Context without needing to reinitialize it.
@@ -288,10 +360,12 @@ protected:
     ForceImpl* createImpl() const;
 private:
     class ParticleInfo;
-    int includeCavityTerm;
+    NonbondedMethod nonbondedMethod;
+    int includeCavityTerm, bornRadiiUpdateInterval;
     bool tanhRescaling;
+    double bornRadiiUpdateTolerance;
     double solventDielectric, soluteDielectric, dielectricOffset,
-           probeRadius, surfaceAreaFactor;
+           probeRadius, surfaceAreaFactor, cutoffDistance;
     double beta0, beta1, beta2, descreenOffset;
     std::vector<ParticleInfo> particles;
 };
@@ -38,6 +38,7 @@
 #include "openmm/Vec3.h"
 
 #include <sstream>
+#include <utility>
 #include <vector>
 
 namespace OpenMM {
@@ -93,6 +94,55 @@ public:
 
     };
 
+    enum MutualInducedSolver {
+
+        /**
+         * Converge the mutual induced dipoles with direct inversion in the iterative subspace (DIIS).  This is the default.
+         */
+        DIIS = 0,
+
+        /**
+         * Converge the mutual induced dipoles with a preconditioned conjugate gradient method, using the
+         * polarizabilities as a diagonal preconditioner.  This usually requires fewer iterations than DIIS
+         * to reach tight tolerances.  It is not supported in combination with AmoebaGeneralizedKirkwoodForce,
+         * in which case DIIS is used instead.
+         */
+        PCG = 1
+
+    };
+
+    enum MutualInducedPredictor {
+
+        /**
+         * Start the mutual induced dipole iteration from the direct dipoles on every step.  This is the default.
+         */
+        NoPredictor = 0,
+
+        /**
+         * Predict the starting dipoles from those of previous time steps using the coefficients of the
+         * Always Stable Predictor-Corrector (ASPC) method of Kolafa.  A predictor of order k uses the
+         * dipoles from the last k+2 steps.
+         */
+        ASPC = 1,
+
+        /**
+         * Predict the starting dipoles by polynomial extrapolation from previous time steps.  A predictor
+         * of order k fits a polynomial of degree k to the dipoles from the last k+1 steps.
+         */
+        Polynomial = 2,
+
+        /**
+         * Start the iteration from auxiliary dipoles that are propagated as dynamical variables with a
+         * dissipative extended Lagrangian scheme, coupled to the dipoles found on each step.  Because
+         * the auxiliary dipoles evolve time reversibly, the dipoles need not be fully converged.  Combined
+         * with a small maximum number of iterations (see setMutualInducedMaxIterations()), this gives
+         * nearly the accuracy of full convergence for little more than the cost of direct polarization.
+         * The predictor order is ignored.
+         */
+        ExtendedLagrangian = 3
+
+    };
+
     enum MultipoleAxisTypes { ZThenX = 0, Bisector = 1, ZBisect = 2, ThreeFold = 3, ZOnly = 4, NoAxisType = 5, LastAxisTypeIndex = 6 };
 
     enum CovalentType {
@@ -104,6 +154,22 @@ public:
      */
     AmoebaMultipoleForce();
 
+    /**
+     * This is the name of the parameter which stores the current lambda value for alchemical
+     * particles.  The default is "AmoebaMultipoleLambda".  The parameter is only defined if at
+     * least one particle has been marked as alchemical with setMultipoleAlchemical().
+     */
+    const std::string& Lambda() const {
+        return lambdaName;
+    }
+
+    /**
+     * Set the name of the parameter which stores the current lambda value for alchemical particles.
+     */
+    void setLambdaName(const std::string& name) {
+        lambdaName = name;
+    }
+
     /**
      * Get the number of particles in the potential function
      */
@@ -169,6 +235,35 @@ public:
      */
     void setPMEParameters(double alpha, int nx, int ny, int nz);
 
+    /**
+     * Get the grid used for the reciprocal space part of the induced dipole field while the mutual induced
+     * dipoles are being iterated.  If nx is 0 (the default), the same grid and B-spline order are used as
+     * for the permanent multipoles.
+     *
+     * @param[out] nx      the number of grid points along the X axis
+     * @param[out] ny      the number of grid points along the Y axis
+     * @param[out] nz      the number of grid points along the Z axis
+     * @param[out] order   the B-spline order
+     */
+    void getInducedDipolePMEParameters(int& nx, int& ny, int& nz, int& order) const;
+
+    /**
+     * Set the grid used for the reciprocal space part of the induced dipole field while the mutual induced
+     * dipoles are being iterated.  If nx is 0 (the default), the same grid and B-spline order are used as
+     * for the permanent multipoles.
+     *
+     * A coarser grid makes each iteration cheaper.  Once the dipoles have converged, the induced dipole
+     * potential is recomputed on the full grid, so the coarse grid only affects the converged dipoles, not
+     * the accuracy of the reciprocal space forces for a given set of dipoles.  This is only used with
+     * Mutual polarization, and platforms that do not support it use the full grid for all iterations.
+     *
+     * @param nx      the number of grid points along the X axis
+     * @param ny      the number of grid points along the Y axis
+     * @param nz      the number of grid points along the Z axis
+     * @param order   the B-spline order.  This must be at least 4.
+     */
+    void setInducedDipolePMEParameters(int nx, int ny, int nz, int order=5);
+
     /**
      * Get the Ewald alpha parameter.  If this is 0 (the default), a value is chosen automatically
      * based on the Ewald error tolerance.
@@ -281,6 +376,35 @@ public:
     void setMultipoleParameters(int index, double charge, const std::vector<double>& molecularDipole, const std::vector<double>& molecularQuadrupole,
                                 int axisType, int multipoleAtomZ, int multipoleAtomX, int multipoleAtomY, double thole, double dampingFactor, double polarity);
 
+    /**
+     * Get whether a particle is undergoing an alchemical change.
+     *
+     * @param index                the index of the atom for which to get the flag
+     */
+    bool getMultipoleAlchemical(int index) const;
+
+    /**
+     * Set whether a particle is undergoing an alchemical change.  The permanent multipoles and the
+     * polarizability of every alchemical particle are multiplied by the value of the Context parameter
+     * whose name is given by Lambda(), which should be between 0.0 and 1.0.  At lambda=0, alchemical
+     * particles have no electrostatic or polarization interactions with anything.
+     *
+     * @param index                the index of the atom for which to set the flag
+     * @param isAlchemical         if true, this particle is undergoing an alchemical change
+     */
+    void setMultipoleAlchemical(int index, bool isAlchemical);
+
+    /**
+     * Compute the energy of this force at each of a list of values for the lambda parameter, using the
+     * current positions.  The energies are evaluated in the existing Context, and the value of the lambda
+     * parameter in the Context is left unchanged.
+     *
+     * @param context        the Context in which to evaluate the energies
+     * @param lambdas        the values of the lambda parameter at which to evaluate the energy
+     * @param[out] energies  on exit, energies[i] is the energy of this force when lambda equals lambdas[i]
+     */
+    void computeLambdaEnergies(Context& context, const std::vector<double>& lambdas, std::vector<double>& energies);
+
     /**
      * Set the CovalentMap for an atom
      *
@@ -307,6 +431,39 @@ public:
      */
     void getCovalentMaps(int index, std::vector < std::vector<int> >& covalentLists) const;
 
+    /**
+     * Set the CovalentMap of one type for every atom at once.  The maps are given in compressed sparse row
+     * format: the atoms associated with atom i are covalentAtoms[offsets[i]] through covalentAtoms[offsets[i+1]-1].
+     * For large systems this is much faster than calling setCovalentMap() for each atom.
+     *
+     * @param typeId               CovalentTypes type
+     * @param offsets              the index in covalentAtoms of the first entry for each atom, followed by the
+     *                             total number of entries.  Its length must be one more than the number of
+     *                             multipoles.  An empty vector clears the maps of this type for all atoms.
+     * @param covalentAtoms        the covalent atoms associated with each atom, concatenated in order of atom index
+     */
+    void setAllCovalentMaps(CovalentType typeId, const std::vector<int>& offsets, const std::vector<int>& covalentAtoms);
+
+    /**
+     * Get the CovalentMap of one type for every atom at once, in the compressed sparse row format described
+     * in setAllCovalentMaps().
+     *
+     * @param typeId               CovalentTypes type
+     * @param[out] offsets         the index in covalentAtoms of the first entry for each atom, followed by the
+     *                             total number of entries
+     * @param[out] covalentAtoms   the covalent atoms associated with each atom, concatenated in order of atom index
+     */
+    void getAllCovalentMaps(CovalentType typeId, std::vector<int>& offsets, std::vector<int>& covalentAtoms) const;
+
+    /**
+     * Set the Covalent12, Covalent13, Covalent14, and Covalent15 maps of every atom based on a list of bonds.
+     * Atoms separated by one to four bonds are placed in the corresponding map, using the shortest path between
+     * them.  The polarization maps depend on the polarization groups, not just the bonds, so they are not changed.
+     *
+     * @param bonds                the indices of the atoms connected by each bond
+     */
+    void createCovalentMapsFromBonds(const std::vector<std::pair<int, int> >& bonds);
+
     /**
      * Get the max number of iterations to be used in calculating the mutual induced dipoles
      *
@@ -321,6 +478,46 @@ public:
      */
     void setMutualInducedMaxIterations(int inputMutualInducedMaxIterations);
 
+    /**
+     * Get the algorithm used to converge the mutual induced dipoles.  This is only used when the
+     * polarization type is Mutual.
+     */
+    MutualInducedSolver getMutualInducedSolver() const;
+
+    /**
+     * Set the algorithm used to converge the mutual induced dipoles.  This is only used when the
+     * polarization type is Mutual.
+     */
+    void setMutualInducedSolver(MutualInducedSolver solver);
+
+    /**
+     * Get the method used to predict the starting point of the mutual induced dipole iteration from
+     * the converged dipoles of previous time steps.  This is only used when the polarization type is
+     * Mutual.  The dipoles are still iterated to the same tolerance, so this affects only how many
+     * iterations are needed, not the result.
+     */
+    MutualInducedPredictor getMutualInducedPredictor() const;
+
+    /**
+     * Set the method used to predict the starting point of the mutual induced dipole iteration from
+     * the converged dipoles of previous time steps.  This is only used when the polarization type is
+     * Mutual.  The dipoles are still iterated to the same tolerance, so this affects only how many
+     * iterations are needed, not the result.  The history of previous dipoles is saved in checkpoints,
+     * so a simulation restored from one continues exactly as it would have without interruption.
+     */
+    void setMutualInducedPredictor(MutualInducedPredictor predictor);
+
+    /**
+     * Get the order of the predictor used for the starting point of the mutual induced dipole iteration.
+     */
+    int getMutualInducedPredictorOrder() const;
+
+    /**
+     * Set the order of the predictor used for the starting point of the mutual induced dipole iteration.
+     * This must be between 1 and 10.
+     */
+    void setMutualInducedPredictorOrder(int order);
+
     /**
      * Get the target epsilon to be used to test for convergence of iterative method used in calculating the mutual induced dipoles
      *
@@ -404,6 +601,22 @@ public:
     void getElectrostaticPotential(const std::vector< Vec3 >& inputGrid,
                                     Context& context, std::vector< double >& outputElectrostaticPotential);
 
+    /**
+     * Get the electrostatic potential, evaluated with the same Ewald splitting that is used for the energy.
+     * The real space part is summed over particles within the cutoff distance of each point, and the
+     * reciprocal space part is interpolated from the PME grid.  The cost therefore scales linearly with
+     * the number of particles plus the number of points, which makes this much faster than
+     * getElectrostaticPotential() for large grids.  The result includes the potential of the uniform
+     * neutralizing background for systems with a net charge.  This may only be used when the nonbonded
+     * method is PME.
+     *
+     * @param inputGrid    input grid points over which the potential is to be evaluated
+     * @param context      context
+     * @param[out] outputElectrostaticPotential output potential
+     */
+    void getPMEElectrostaticPotential(const std::vector< Vec3 >& inputGrid,
+                                      Context& context, std::vector< double >& outputElectrostaticPotential);
+
     /**
      * Get the system multipole moments.
      *
@@ -450,15 +663,24 @@ private:
     double cutoffDistance;
     double alpha;
     int pmeBSplineOrder, nx, ny, nz;
+    int inducedOrder, inducedNx, inducedNy, inducedNz;
     int mutualInducedMaxIterations;
+    MutualInducedSolver mutualInducedSolver;
+    MutualInducedPredictor mutualInducedPredictor;
+    int mutualInducedPredictorOrder;
     std::vector<double> extrapolationCoefficients;
 
     double mutualInducedTargetEpsilon;
     double scalingDistanceCutoff;
     double electricConstant;
     double ewaldErrorTol;
+    std::string lambdaName;
     class MultipoleInfo;
     std::vector<MultipoleInfo> multipoles;
+    // The covalent maps of each type are stored in compressed sparse row format.  Each offsets vector may be
+    // shorter than the number of multipoles plus one, in which case the maps of all later atoms are empty.
+    // This lets setCovalentMap() append to the end when atoms are set in order.
+    std::vector<std::vector<int> > covalentOffsets, covalentAtoms;
 };
 
 /**
@@ -470,14 +692,15 @@ public:
 
     int axisType, multipoleAtomZ, multipoleAtomX, multipoleAtomY;
     double charge, thole, dampingFactor, polarity;
+    bool isAlchemical;
 
     std::vector<double> molecularDipole;
     std::vector<double> molecularQuadrupole;
-    std::vector< std::vector<int> > covalentInfo;
 
     MultipoleInfo() {
         axisType = multipoleAtomZ = multipoleAtomX = multipoleAtomY = -1;
         charge   = thole          = dampingFactor  = 0.0;
+        isAlchemical = false;
 
         molecularDipole.resize(3);
         molecularQuadrupole.resize(9);
@@ -487,9 +710,7 @@ public:
     MultipoleInfo(double charge, const std::vector<double>& inputMolecularDipole, const std::vector<double>& inputMolecularQuadrupole,
                    int axisType, int multipoleAtomZ, int multipoleAtomX, int multipoleAtomY, double thole, double dampingFactor, double polarity) :
         axisType(axisType), multipoleAtomZ(multipoleAtomZ), multipoleAtomX(multipoleAtomX), multipoleAtomY(multipoleAtomY),
-        charge(charge), thole(thole), dampingFactor(dampingFactor), polarity(polarity) {
-
-       covalentInfo.resize(CovalentEnd);
+        charge(charge), thole(thole), dampingFactor(dampingFactor), polarity(polarity), isAlchemical(false) {
 
        molecularDipole.resize(3);
        molecularDipole[0]          = inputMolecularDipole[0];
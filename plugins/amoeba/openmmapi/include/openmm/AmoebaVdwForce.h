@@ -460,6 +460,18 @@ public:
      * (the nonbonded method, the cutoff distance, etc.) are unaffected and can only be changed by reinitializing the Context.
      */
     void updateParametersInContext(Context& context);
+    /**
+     * Compute the energy of this force at each of a list of values for the lambda parameter, using the
+     * current positions in a Context.  This is intended for free energy methods such as MBAR that need the
+     * energy of every configuration in every alchemical state.  It is much faster than setting the parameter
+     * and calling getState() once for each value, since no other forces are evaluated and no forces
+     * are computed.  The value of the parameter stored in the Context is not changed.
+     *
+     * @param context        the Context in which to evaluate the energies
+     * @param lambdas        the values of the lambda parameter at which to evaluate the energy
+     * @param[out] energies  on exit, energies[i] is the energy of this force when lambda equals lambdas[i]
+     */
+    void computeLambdaEnergies(Context& context, const std::vector<double>& lambdas, std::vector<double>& energies);
     /**
      * Returns whether or not this force makes use of periodic boundary
      * conditions.
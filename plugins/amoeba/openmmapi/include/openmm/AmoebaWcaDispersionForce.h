@@ -51,6 +51,22 @@ class OPENMM_EXPORT_AMOEBA AmoebaWcaDispersionForce : public Force {
 
 public:
 
+    /**
+     * This is an enumeration of the different methods that may be used for handling long range interactions.
+     */
+    enum NonbondedMethod {
+        /**
+         * No cutoff is applied to the interactions.  The full set of N^2 interactions is computed exactly.
+         * This is the default.
+         */
+        NoCutoff = 0,
+        /**
+         * The descreening of each atom by its neighbors is smoothly switched off between 90% of the cutoff
+         * distance and the cutoff distance, and neighbors beyond the cutoff are ignored.
+         */
+        CutoffNonPeriodic = 1,
+    };
+
     /**
      * Create an AmoebaWcaDispersionForce.
      */
@@ -121,6 +137,29 @@ public:
     void setShctd(double inputValue);
     void setDispoff(double inputValue);
     void setSlevy(double inputValue);
+
+    /**
+     * Get the method used for handling long range interactions.
+     */
+    NonbondedMethod getNonbondedMethod() const;
+    /**
+     * Set the method used for handling long range interactions.
+     */
+    void setNonbondedMethod(NonbondedMethod method);
+    /**
+     * Get the cutoff distance (in nm) being used for interactions.  If the NonbondedMethod in use
+     * is NoCutoff, this value will have no effect.
+     *
+     * @return the cutoff distance, measured in nm
+     */
+    double getCutoffDistance() const;
+    /**
+     * Set the cutoff distance (in nm) being used for interactions.  If the NonbondedMethod in use
+     * is NoCutoff, this value will have no effect.
+     *
+     * @param distance    the cutoff distance, measured in nm
+     */
+    void setCutoffDistance(double distance);
     /**
      * Returns whether or not this force makes use of periodic boundary
      * conditions.
@@ -134,6 +173,8 @@ protected:
     ForceImpl* createImpl() const;
 private:
     class WcaDispersionInfo;
+    NonbondedMethod nonbondedMethod;
+    double cutoffDistance;
     double epso;
     double epsh;
     double rmino;
@@ -37,6 +37,7 @@
 #include "openmm/System.h"
 #include "openmm/Platform.h"
 
+#include <iosfwd>
 #include <set>
 #include <string>
 #include <vector>
@@ -115,6 +116,9 @@ public:
     virtual void getElectrostaticPotential(ContextImpl& context, const std::vector< Vec3 >& inputGrid,
                                            std::vector< double >& outputElectrostaticPotential) = 0;
 
+    virtual void getPMEElectrostaticPotential(ContextImpl& context, const std::vector< Vec3 >& inputGrid,
+                                              std::vector< double >& outputElectrostaticPotential) = 0;
+
     virtual void getSystemMultipoleMoments(ContextImpl& context, std::vector< double >& outputMultipoleMoments) = 0;
     /**
      * Copy changed parameters over to a context.
@@ -133,6 +137,21 @@ public:
      * @param nz      the number of grid points along the Z axis
      */
     virtual void getPMEParameters(double& alpha, int& nx, int& ny, int& nz) const = 0;
+    /**
+     * Write the history used to predict the induced dipoles to a checkpoint.
+     *
+     * @param context    the context for which to save the history
+     * @param stream     an output stream the data should be written to
+     */
+    virtual void createCheckpoint(ContextImpl& context, std::ostream& stream) = 0;
+    /**
+     * Load the history used to predict the induced dipoles from a checkpoint.  If it was created for a
+     * different number of particles or a different predictor, it is ignored.
+     *
+     * @param context    the context for which to load the history
+     * @param stream     an input stream the data should be read from
+     */
+    virtual void loadCheckpoint(ContextImpl& context, std::istream& stream) = 0;
 };
 
 /**
@@ -213,6 +232,14 @@ public:
      * @param force      the AmoebaVdwForce to copy the parameters from
      */
     virtual void copyParametersToContext(ContextImpl& context, const AmoebaVdwForce& force) = 0;
+    /**
+     * Compute the energy of the force at each of a list of values for the lambda parameter.
+     *
+     * @param context        the context in which to execute this kernel
+     * @param lambdas        the values of the lambda parameter at which to evaluate the energy
+     * @param[out] energies  on exit, energies[i] is the energy when lambda equals lambdas[i]
+     */
+    virtual void computeLambdaEnergies(ContextImpl& context, const std::vector<double>& lambdas, std::vector<double>& energies) = 0;
 };
 
 /**
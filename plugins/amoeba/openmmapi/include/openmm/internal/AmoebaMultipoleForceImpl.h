@@ -57,9 +57,7 @@ public:
         // This force field doesn't update the state directly.
     }
     double calcForcesAndEnergy(ContextImpl& context, bool includeForces, bool includeEnergy, int groups);
-    std::map<std::string, double> getDefaultParameters() {
-        return std::map<std::string, double>(); // This force field doesn't define any parameters.
-    }
+    std::map<std::string, double> getDefaultParameters();
     std::vector<std::string> getKernelNames();
 
     /**
@@ -88,14 +86,23 @@ public:
     void getElectrostaticPotential(ContextImpl& context, const std::vector< Vec3 >& inputGrid,
                                    std::vector< double >& outputElectrostaticPotential);
 
+    void getPMEElectrostaticPotential(ContextImpl& context, const std::vector< Vec3 >& inputGrid,
+                                      std::vector< double >& outputElectrostaticPotential);
+
     void getSystemMultipoleMoments(ContextImpl& context, std::vector< double >& outputMultipoleMoments);
     void updateParametersInContext(ContextImpl& context);
     void getPMEParameters(double& alpha, int& nx, int& ny, int& nz) const;
+    void computeLambdaEnergies(ContextImpl& context, const std::vector<double>& lambdas, std::vector<double>& energies);
+    void createCheckpoint(ContextImpl& context, std::ostream& stream);
+    void loadCheckpoint(ContextImpl& context, std::istream& stream);
 
 
 private:
+    void setLambdaInContext(ContextImpl& context, double lambda);
     const AmoebaMultipoleForce& owner;
     Kernel kernel;
+    bool hasAlchemicalParticles, overrideLambda;
+    double currentLambda;
 
     static int CovalentDegrees[AmoebaMultipoleForce::CovalentEnd];
     static bool initializedCovalentDegrees;
@@ -83,6 +83,7 @@ public:
      */
     static double calcDispersionCorrection(const System& system, const AmoebaVdwForce& force);
     void updateParametersInContext(ContextImpl& context);
+    void computeLambdaEnergies(ContextImpl& context, const std::vector<double>& lambdas, std::vector<double>& energies);
 private:
     const AmoebaVdwForce& owner;
     Kernel kernel;
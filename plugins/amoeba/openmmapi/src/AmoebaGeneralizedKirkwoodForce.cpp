@@ -36,9 +36,10 @@
 
 using namespace OpenMM;
 
-AmoebaGeneralizedKirkwoodForce::AmoebaGeneralizedKirkwoodForce() :
+AmoebaGeneralizedKirkwoodForce::AmoebaGeneralizedKirkwoodForce() : nonbondedMethod(NoCutoff), cutoffDistance(1.0),
     solventDielectric(78.3), soluteDielectric(1.0), dielectricOffset(0.009), includeCavityTerm(1), probeRadius(0.14),
-    tanhRescaling(false), beta0(0.9563), beta1(0.2578), beta2(0.0810), descreenOffset(0.0) {
+    tanhRescaling(false), beta0(0.9563), beta1(0.2578), beta2(0.0810), descreenOffset(0.0), bornRadiiUpdateInterval(1),
+    bornRadiiUpdateTolerance(0.0) {
      surfaceAreaFactor = -6.0* 3.1415926535*0.0216*1000.0*0.4184;
 }
 
@@ -108,6 +109,44 @@ void AmoebaGeneralizedKirkwoodForce::setDescreenOffset(double inputDescreenOffet
     descreenOffset = inputDescreenOffet;
 }
 
+AmoebaGeneralizedKirkwoodForce::NonbondedMethod AmoebaGeneralizedKirkwoodForce::getNonbondedMethod() const {
+    return nonbondedMethod;
+}
+
+void AmoebaGeneralizedKirkwoodForce::setNonbondedMethod(NonbondedMethod method) {
+    if (method < 0 || method > 1)
+        throw OpenMMException("AmoebaGeneralizedKirkwoodForce: Illegal value for nonbonded method");
+    nonbondedMethod = method;
+}
+
+double AmoebaGeneralizedKirkwoodForce::getCutoffDistance() const {
+    return cutoffDistance;
+}
+
+void AmoebaGeneralizedKirkwoodForce::setCutoffDistance(double distance) {
+    cutoffDistance = distance;
+}
+
+int AmoebaGeneralizedKirkwoodForce::getBornRadiiUpdateInterval() const {
+    return bornRadiiUpdateInterval;
+}
+
+void AmoebaGeneralizedKirkwoodForce::setBornRadiiUpdateInterval(int interval) {
+    if (interval < 1)
+        throw OpenMMException("AmoebaGeneralizedKirkwoodForce: The Born radii update interval must be at least 1");
+    bornRadiiUpdateInterval = interval;
+}
+
+double AmoebaGeneralizedKirkwoodForce::getBornRadiiUpdateTolerance() const {
+    return bornRadiiUpdateTolerance;
+}
+
+void AmoebaGeneralizedKirkwoodForce::setBornRadiiUpdateTolerance(double tolerance) {
+    if (tolerance < 0)
+        throw OpenMMException("AmoebaGeneralizedKirkwoodForce: The Born radii update tolerance cannot be negative");
+    bornRadiiUpdateTolerance = tolerance;
+}
+
 ForceImpl* AmoebaGeneralizedKirkwoodForce::createImpl() const {
     return new AmoebaGeneralizedKirkwoodForceImpl(*this);
 }
@@ -33,19 +33,26 @@
 #include "openmm/OpenMMException.h"
 #include "openmm/AmoebaMultipoleForce.h"
 #include "openmm/internal/AmoebaMultipoleForceImpl.h"
+#include "openmm/internal/AssertionUtilities.h"
 #include "SimTKOpenMMRealType.h"
+#include <algorithm>
 #include <stdio.h>
 
 using namespace OpenMM;
+using std::pair;
 using std::string;
 using std::vector;
 
-AmoebaMultipoleForce::AmoebaMultipoleForce() : nonbondedMethod(NoCutoff), polarizationType(Mutual), pmeBSplineOrder(5), cutoffDistance(1.0), ewaldErrorTol(1e-4), mutualInducedMaxIterations(60),
-                                               mutualInducedTargetEpsilon(1e-5), scalingDistanceCutoff(100.0), electricConstant(ONE_4PI_EPS0), alpha(0.0), nx(0), ny(0), nz(0) {
+AmoebaMultipoleForce::AmoebaMultipoleForce() : nonbondedMethod(NoCutoff), polarizationType(Mutual), pmeBSplineOrder(5), cutoffDistance(1.0), ewaldErrorTol(1e-4), mutualInducedMaxIterations(60), mutualInducedSolver(DIIS),
+                                               mutualInducedPredictor(NoPredictor), mutualInducedPredictorOrder(2),
+                                               mutualInducedTargetEpsilon(1e-5), scalingDistanceCutoff(100.0), electricConstant(ONE_4PI_EPS0), alpha(0.0), nx(0), ny(0), nz(0),
+                                               inducedOrder(5), inducedNx(0), inducedNy(0), inducedNz(0), lambdaName("AmoebaMultipoleLambda") {
     extrapolationCoefficients.push_back(-0.154);
     extrapolationCoefficients.push_back(0.017);
     extrapolationCoefficients.push_back(0.658);
     extrapolationCoefficients.push_back(0.474);
+    covalentOffsets.resize(CovalentEnd);
+    covalentAtoms.resize(CovalentEnd);
 }
 
 AmoebaMultipoleForce::NonbondedMethod AmoebaMultipoleForce::getNonbondedMethod() const {
@@ -96,6 +103,22 @@ void AmoebaMultipoleForce::setPMEParameters(double alpha, int nx, int ny, int nz
     this->nz = nz;
 }
 
+void AmoebaMultipoleForce::getInducedDipolePMEParameters(int& nx, int& ny, int& nz, int& order) const {
+    nx = inducedNx;
+    ny = inducedNy;
+    nz = inducedNz;
+    order = inducedOrder;
+}
+
+void AmoebaMultipoleForce::setInducedDipolePMEParameters(int nx, int ny, int nz, int order) {
+    if (order < 4)
+        throw OpenMMException("AmoebaMultipoleForce: The B-spline order for the induced dipole grid must be at least 4");
+    inducedNx = nx;
+    inducedNy = ny;
+    inducedNz = nz;
+    inducedOrder = order;
+}
+
 double AmoebaMultipoleForce::getAEwald() const { 
     return alpha; 
 } 
@@ -134,6 +157,36 @@ void AmoebaMultipoleForce::setMutualInducedMaxIterations(int inputMutualInducedM
     mutualInducedMaxIterations = inputMutualInducedMaxIterations;
 }
 
+AmoebaMultipoleForce::MutualInducedSolver AmoebaMultipoleForce::getMutualInducedSolver() const {
+    return mutualInducedSolver;
+}
+
+void AmoebaMultipoleForce::setMutualInducedSolver(AmoebaMultipoleForce::MutualInducedSolver solver) {
+    if (solver < 0 || solver > 1)
+        throw OpenMMException("AmoebaMultipoleForce: Illegal value for mutual induced solver");
+    mutualInducedSolver = solver;
+}
+
+AmoebaMultipoleForce::MutualInducedPredictor AmoebaMultipoleForce::getMutualInducedPredictor() const {
+    return mutualInducedPredictor;
+}
+
+void AmoebaMultipoleForce::setMutualInducedPredictor(AmoebaMultipoleForce::MutualInducedPredictor predictor) {
+    if (predictor < 0 || predictor > 3)
+        throw OpenMMException("AmoebaMultipoleForce: Illegal value for mutual induced predictor");
+    mutualInducedPredictor = predictor;
+}
+
+int AmoebaMultipoleForce::getMutualInducedPredictorOrder() const {
+    return mutualInducedPredictorOrder;
+}
+
+void AmoebaMultipoleForce::setMutualInducedPredictorOrder(int order) {
+    if (order < 1 || order > 10)
+        throw OpenMMException("AmoebaMultipoleForce: Mutual induced predictor order must be between 1 and 10");
+    mutualInducedPredictorOrder = order;
+}
+
 double AmoebaMultipoleForce::getMutualInducedTargetEpsilon() const {
     return mutualInducedTargetEpsilon;
 }
@@ -215,37 +268,141 @@ void AmoebaMultipoleForce::setMultipoleParameters(int index, double charge, cons
 
 }
 
-void AmoebaMultipoleForce::setCovalentMap(int index, CovalentType typeId, const std::vector<int>& covalentAtoms) {
-
-    std::vector<int>& covalentList = multipoles[index].covalentInfo[typeId];
-    covalentList.resize(covalentAtoms.size());
-    for (unsigned int ii = 0; ii < covalentAtoms.size(); ii++) {
-       covalentList[ii] = covalentAtoms[ii];
-    }
+bool AmoebaMultipoleForce::getMultipoleAlchemical(int index) const {
+    return multipoles[index].isAlchemical;
 }
 
-void AmoebaMultipoleForce::getCovalentMap(int index, CovalentType typeId, std::vector<int>& covalentAtoms) const {
+void AmoebaMultipoleForce::setMultipoleAlchemical(int index, bool isAlchemical) {
+    multipoles[index].isAlchemical = isAlchemical;
+}
 
-    // load covalent atom index entries for atomId==index and covalentId==typeId into covalentAtoms
+void AmoebaMultipoleForce::computeLambdaEnergies(Context& context, const vector<double>& lambdas, vector<double>& energies) {
+    dynamic_cast<AmoebaMultipoleForceImpl&>(getImplInContext(context)).computeLambdaEnergies(getContextImpl(context), lambdas, energies);
+}
 
-    std::vector<int> covalentList = multipoles[index].covalentInfo[typeId];
-    covalentAtoms.resize(covalentList.size());
-    for (unsigned int ii = 0; ii < covalentList.size(); ii++) {
-       covalentAtoms[ii] = covalentList[ii];
+void AmoebaMultipoleForce::setCovalentMap(int index, CovalentType typeId, const std::vector<int>& covalentAtoms) {
+    ASSERT_VALID_INDEX(index, multipoles);
+    if (typeId < 0 || typeId >= CovalentEnd)
+        throw OpenMMException("AmoebaMultipoleForce: Illegal value for covalent type");
+    vector<int>& offsets = covalentOffsets[typeId];
+    vector<int>& atoms = this->covalentAtoms[typeId];
+    if (offsets.size() == 0)
+        offsets.push_back(0);
+    int numStored = offsets.size()-1;
+    if (index >= numStored) {
+        // Atoms past the end of the stored maps have empty maps, so extend the offsets to this
+        // atom and append the new entries.
+
+        if (covalentAtoms.size() == 0)
+            return;
+        offsets.resize(index+1, atoms.size());
+        atoms.insert(atoms.end(), covalentAtoms.begin(), covalentAtoms.end());
+        offsets.push_back(atoms.size());
+        return;
     }
+    int start = offsets[index];
+    int change = (int) covalentAtoms.size()-(offsets[index+1]-start);
+    if (change > 0)
+        atoms.insert(atoms.begin()+start, change, 0);
+    else if (change < 0)
+        atoms.erase(atoms.begin()+start, atoms.begin()+start-change);
+    if (change != 0)
+        for (int i = index+1; i < offsets.size(); i++)
+            offsets[i] += change;
+    copy(covalentAtoms.begin(), covalentAtoms.end(), atoms.begin()+start);
 }
 
-void AmoebaMultipoleForce::getCovalentMaps(int index, std::vector< std::vector<int> >& covalentLists) const {
+void AmoebaMultipoleForce::getCovalentMap(int index, CovalentType typeId, std::vector<int>& covalentAtoms) const {
+    ASSERT_VALID_INDEX(index, multipoles);
+    if (typeId < 0 || typeId >= CovalentEnd)
+        throw OpenMMException("AmoebaMultipoleForce: Illegal value for covalent type");
+    const vector<int>& offsets = covalentOffsets[typeId];
+    if (index+1 >= offsets.size())
+        covalentAtoms.clear();
+    else
+        covalentAtoms.assign(this->covalentAtoms[typeId].begin()+offsets[index], this->covalentAtoms[typeId].begin()+offsets[index+1]);
+}
 
+void AmoebaMultipoleForce::getCovalentMaps(int index, std::vector< std::vector<int> >& covalentLists) const {
     covalentLists.resize(CovalentEnd);
-    for (unsigned int jj = 0; jj < CovalentEnd; jj++) {
-        std::vector<int> covalentList = multipoles[index].covalentInfo[jj];
-        std::vector<int> covalentAtoms;
-        covalentAtoms.resize(covalentList.size());
-        for (unsigned int ii = 0; ii < covalentList.size(); ii++) {
-           covalentAtoms[ii] = covalentList[ii];
+    for (int i = 0; i < CovalentEnd; i++)
+        getCovalentMap(index, static_cast<CovalentType>(i), covalentLists[i]);
+}
+
+void AmoebaMultipoleForce::setAllCovalentMaps(CovalentType typeId, const std::vector<int>& offsets, const std::vector<int>& covalentAtoms) {
+    if (typeId < 0 || typeId >= CovalentEnd)
+        throw OpenMMException("AmoebaMultipoleForce: Illegal value for covalent type");
+    if (offsets.size() != 0) {
+        if (offsets.size() != multipoles.size()+1)
+            throw OpenMMException("AmoebaMultipoleForce: The length of offsets must be one more than the number of multipoles");
+        if (offsets[0] != 0 || offsets.back() != covalentAtoms.size())
+            throw OpenMMException("AmoebaMultipoleForce: offsets must start at 0 and end at the number of covalent atoms");
+        for (int i = 0; i < multipoles.size(); i++)
+            if (offsets[i+1] < offsets[i])
+                throw OpenMMException("AmoebaMultipoleForce: offsets must be nondecreasing");
+    }
+    covalentOffsets[typeId] = offsets;
+    this->covalentAtoms[typeId] = covalentAtoms;
+}
+
+void AmoebaMultipoleForce::getAllCovalentMaps(CovalentType typeId, std::vector<int>& offsets, std::vector<int>& covalentAtoms) const {
+    if (typeId < 0 || typeId >= CovalentEnd)
+        throw OpenMMException("AmoebaMultipoleForce: Illegal value for covalent type");
+    offsets = covalentOffsets[typeId];
+    if (offsets.size() == 0)
+        offsets.push_back(0);
+    offsets.resize(multipoles.size()+1, offsets.back());
+    covalentAtoms = this->covalentAtoms[typeId];
+}
+
+void AmoebaMultipoleForce::createCovalentMapsFromBonds(const std::vector<pair<int, int> >& bonds) {
+    // Build the list of atoms bonded to each one.
+
+    int numAtoms = multipoles.size();
+    vector<int> bondOffsets(numAtoms+1, 0), bonded(2*bonds.size());
+    for (auto& bond : bonds) {
+        if (bond.first < 0 || bond.first >= numAtoms || bond.second < 0 || bond.second >= numAtoms)
+            throw OpenMMException("AmoebaMultipoleForce: createCovalentMapsFromBonds: Illegal atom index in bond");
+        bondOffsets[bond.first+1]++;
+        bondOffsets[bond.second+1]++;
+    }
+    for (int i = 0; i < numAtoms; i++)
+        bondOffsets[i+1] += bondOffsets[i];
+    vector<int> next(bondOffsets.begin(), bondOffsets.end()-1);
+    for (auto& bond : bonds) {
+        bonded[next[bond.first]++] = bond.second;
+        bonded[next[bond.second]++] = bond.first;
+    }
+
+    // Do a breadth first search from each atom to find the ones up to four bonds away.  distance
+    // records how far each atom is from the current one, and is reset after every search.
+
+    const CovalentType types[] = {Covalent12, Covalent13, Covalent14, Covalent15};
+    vector<int> distance(numAtoms, -1);
+    for (CovalentType type : types) {
+        covalentOffsets[type].assign(1, 0);
+        covalentAtoms[type].clear();
+    }
+    vector<vector<int> > shells(5);
+    for (int atom = 0; atom < numAtoms; atom++) {
+        shells[0].assign(1, atom);
+        distance[atom] = 0;
+        for (int depth = 1; depth <= 4; depth++) {
+            shells[depth].clear();
+            for (int previous : shells[depth-1])
+                for (int i = bondOffsets[previous]; i < bondOffsets[previous+1]; i++)
+                    if (distance[bonded[i]] == -1) {
+                        distance[bonded[i]] = depth;
+                        shells[depth].push_back(bonded[i]);
+                    }
+            sort(shells[depth].begin(), shells[depth].end());
+            vector<int>& atoms = covalentAtoms[types[depth-1]];
+            atoms.insert(atoms.end(), shells[depth].begin(), shells[depth].end());
+            covalentOffsets[types[depth-1]].push_back(atoms.size());
         }
-        covalentLists[jj] = covalentAtoms;
+        for (auto& shell : shells)
+            for (int i : shell)
+                distance[i] = -1;
     }
 }
 
@@ -265,6 +422,12 @@ void AmoebaMultipoleForce::getElectrostaticPotential(const std::vector< Vec3 >&
     dynamic_cast<AmoebaMultipoleForceImpl&>(getImplInContext(context)).getElectrostaticPotential(getContextImpl(context), inputGrid, outputElectrostaticPotential);
 }
 
+void AmoebaMultipoleForce::getPMEElectrostaticPotential(const std::vector< Vec3 >& inputGrid, Context& context, std::vector< double >& outputElectrostaticPotential) {
+    if (nonbondedMethod != PME)
+        throw OpenMMException("AmoebaMultipoleForce: getPMEElectrostaticPotential() requires the PME nonbonded method");
+    dynamic_cast<AmoebaMultipoleForceImpl&>(getImplInContext(context)).getPMEElectrostaticPotential(getContextImpl(context), inputGrid, outputElectrostaticPotential);
+}
+
 void AmoebaMultipoleForce::getSystemMultipoleMoments(Context& context, std::vector< double >& outputMultipoleMoments) {
     dynamic_cast<AmoebaMultipoleForceImpl&>(getImplInContext(context)).getSystemMultipoleMoments(getContextImpl(context), outputMultipoleMoments);
 }
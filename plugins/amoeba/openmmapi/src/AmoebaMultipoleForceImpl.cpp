@@ -33,16 +33,20 @@
 #include "openmm/internal/AmoebaMultipoleForceImpl.h"
 #include "openmm/internal/Messages.h"
 #include "openmm/amoebaKernels.h"
+#include "openmm/OpenMMException.h"
 #include <stdio.h>
 
 using namespace OpenMM;
 
+using std::map;
+using std::string;
 using std::vector;
 
 bool AmoebaMultipoleForceImpl::initializedCovalentDegrees = false;
 int AmoebaMultipoleForceImpl::CovalentDegrees[]           = { 1,2,3,4,0,1,2,3};
 
-AmoebaMultipoleForceImpl::AmoebaMultipoleForceImpl(const AmoebaMultipoleForce& owner) : owner(owner) {
+AmoebaMultipoleForceImpl::AmoebaMultipoleForceImpl(const AmoebaMultipoleForce& owner) : owner(owner), hasAlchemicalParticles(false),
+        overrideLambda(false), currentLambda(1.0) {
 }
 
 AmoebaMultipoleForceImpl::~AmoebaMultipoleForceImpl() {
@@ -143,12 +147,73 @@ void AmoebaMultipoleForceImpl::initialize(ContextImpl& context) {
     }
     kernel = context.getPlatform().createKernel(CalcAmoebaMultipoleForceKernel::Name(), context);
     kernel.getAs<CalcAmoebaMultipoleForceKernel>().initialize(context.getSystem(), owner);
+    hasAlchemicalParticles = false;
+    for (int i = 0; i < owner.getNumMultipoles(); i++)
+        if (owner.getMultipoleAlchemical(i))
+            hasAlchemicalParticles = true;
+    currentLambda = 1.0;
 }
 
 double AmoebaMultipoleForceImpl::calcForcesAndEnergy(ContextImpl& context, bool includeForces, bool includeEnergy, int groups) {
-    if ((groups&(1<<owner.getForceGroup())) != 0)
-        return kernel.getAs<CalcAmoebaMultipoleForceKernel>().execute(context, includeForces, includeEnergy);
-    return 0.0;
+    if ((groups&(1<<owner.getForceGroup())) == 0)
+        return 0.0;
+    if (hasAlchemicalParticles && !overrideLambda) {
+        double lambda = context.getParameter(owner.Lambda());
+        if (lambda != currentLambda)
+            setLambdaInContext(context, lambda);
+    }
+    return kernel.getAs<CalcAmoebaMultipoleForceKernel>().execute(context, includeForces, includeEnergy);
+}
+
+map<string, double> AmoebaMultipoleForceImpl::getDefaultParameters() {
+    map<string, double> parameters;
+    for (int i = 0; i < owner.getNumMultipoles(); i++)
+        if (owner.getMultipoleAlchemical(i)) {
+            parameters[owner.Lambda()] = 1.0;
+            break;
+        }
+    return parameters;
+}
+
+void AmoebaMultipoleForceImpl::setLambdaInContext(ContextImpl& context, double lambda) {
+    // Copy the parameters to the kernel with the multipoles and polarizabilities of alchemical
+    // particles scaled by lambda.
+
+    AmoebaMultipoleForce scaled(owner);
+    for (int i = 0; i < owner.getNumMultipoles(); i++) {
+        if (!owner.getMultipoleAlchemical(i))
+            continue;
+        int axisType, atomZ, atomX, atomY;
+        double charge, thole, damping, polarity;
+        vector<double> dipole, quadrupole;
+        owner.getMultipoleParameters(i, charge, dipole, quadrupole, axisType, atomZ, atomX, atomY, thole, damping, polarity);
+        for (double& d : dipole)
+            d *= lambda;
+        for (double& q : quadrupole)
+            q *= lambda;
+        scaled.setMultipoleParameters(i, lambda*charge, dipole, quadrupole, axisType, atomZ, atomX, atomY, thole, damping, lambda*polarity);
+    }
+    kernel.getAs<CalcAmoebaMultipoleForceKernel>().copyParametersToContext(context, scaled);
+    currentLambda = lambda;
+}
+
+void AmoebaMultipoleForceImpl::computeLambdaEnergies(ContextImpl& context, const vector<double>& lambdas, vector<double>& energies) {
+    if (!hasAlchemicalParticles)
+        throw OpenMMException("AmoebaMultipoleForce: computeLambdaEnergies() requires at least one alchemical particle");
+    energies.resize(lambdas.size());
+    overrideLambda = true;
+    try {
+        for (int i = 0; i < (int) lambdas.size(); i++) {
+            setLambdaInContext(context, lambdas[i]);
+            energies[i] = context.calcForcesAndEnergy(false, true, 1<<owner.getForceGroup());
+        }
+    }
+    catch (...) {
+        overrideLambda = false;
+        throw;
+    }
+    overrideLambda = false;
+    setLambdaInContext(context, context.getParameter(owner.Lambda()));
 }
 
 std::vector<std::string> AmoebaMultipoleForceImpl::getKernelNames() {
@@ -219,15 +284,31 @@ void AmoebaMultipoleForceImpl::getElectrostaticPotential(ContextImpl& context, c
     kernel.getAs<CalcAmoebaMultipoleForceKernel>().getElectrostaticPotential(context, inputGrid, outputElectrostaticPotential);
 }
 
+void AmoebaMultipoleForceImpl::getPMEElectrostaticPotential(ContextImpl& context, const std::vector< Vec3 >& inputGrid,
+                                                            std::vector< double >& outputElectrostaticPotential) {
+    kernel.getAs<CalcAmoebaMultipoleForceKernel>().getPMEElectrostaticPotential(context, inputGrid, outputElectrostaticPotential);
+}
+
 void AmoebaMultipoleForceImpl::getSystemMultipoleMoments(ContextImpl& context, std::vector< double >& outputMultipoleMoments) {
     kernel.getAs<CalcAmoebaMultipoleForceKernel>().getSystemMultipoleMoments(context, outputMultipoleMoments);
 }
 
 void AmoebaMultipoleForceImpl::updateParametersInContext(ContextImpl& context) {
-    kernel.getAs<CalcAmoebaMultipoleForceKernel>().copyParametersToContext(context, owner);
+    if (hasAlchemicalParticles)
+        setLambdaInContext(context, context.getParameter(owner.Lambda()));
+    else
+        kernel.getAs<CalcAmoebaMultipoleForceKernel>().copyParametersToContext(context, owner);
     context.systemChanged();
 }
 
 void AmoebaMultipoleForceImpl::getPMEParameters(double& alpha, int& nx, int& ny, int& nz) const {
     kernel.getAs<CalcAmoebaMultipoleForceKernel>().getPMEParameters(alpha, nx, ny, nz);
 }
+
+void AmoebaMultipoleForceImpl::createCheckpoint(ContextImpl& context, std::ostream& stream) {
+    kernel.getAs<CalcAmoebaMultipoleForceKernel>().createCheckpoint(context, stream);
+}
+
+void AmoebaMultipoleForceImpl::loadCheckpoint(ContextImpl& context, std::istream& stream) {
+    kernel.getAs<CalcAmoebaMultipoleForceKernel>().loadCheckpoint(context, stream);
+}
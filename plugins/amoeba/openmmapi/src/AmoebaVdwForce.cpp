@@ -221,3 +221,7 @@ ForceImpl* AmoebaVdwForce::createImpl() const {
 void AmoebaVdwForce::updateParametersInContext(Context& context) {
     dynamic_cast<AmoebaVdwForceImpl&>(getImplInContext(context)).updateParametersInContext(getContextImpl(context));
 }
+
+void AmoebaVdwForce::computeLambdaEnergies(Context& context, const vector<double>& lambdas, vector<double>& energies) {
+    dynamic_cast<AmoebaVdwForceImpl&>(getImplInContext(context)).computeLambdaEnergies(getContextImpl(context), lambdas, energies);
+}
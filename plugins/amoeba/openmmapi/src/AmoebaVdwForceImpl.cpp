@@ -358,4 +358,8 @@ void AmoebaVdwForceImpl::updateParametersInContext(ContextImpl& context) {
     kernel.getAs<CalcAmoebaVdwForceKernel>().copyParametersToContext(context, owner);
 }
 
+void AmoebaVdwForceImpl::computeLambdaEnergies(ContextImpl& context, const vector<double>& lambdas, vector<double>& energies) {
+    kernel.getAs<CalcAmoebaVdwForceKernel>().computeLambdaEnergies(context, lambdas, energies);
+}
+
 
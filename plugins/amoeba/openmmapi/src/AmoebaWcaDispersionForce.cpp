@@ -37,7 +37,7 @@
 
 using namespace OpenMM;
 
-AmoebaWcaDispersionForce::AmoebaWcaDispersionForce() {
+AmoebaWcaDispersionForce::AmoebaWcaDispersionForce() : nonbondedMethod(NoCutoff), cutoffDistance(1.0) {
     // Amoeba Water '03 vdW parameters (Diameters in Angstroms; Well depth in kcal/mole)
     // vdw           1               3.4050     0.1100
     // vdw           2               2.6550     0.0135      0.910
@@ -135,6 +135,24 @@ void AmoebaWcaDispersionForce::setSlevy(double inputSlevy) {
     slevy = inputSlevy;
 }
 
+AmoebaWcaDispersionForce::NonbondedMethod AmoebaWcaDispersionForce::getNonbondedMethod() const {
+    return nonbondedMethod;
+}
+
+void AmoebaWcaDispersionForce::setNonbondedMethod(NonbondedMethod method) {
+    if (method < 0 || method > 1)
+        throw OpenMMException("AmoebaWcaDispersionForce: Illegal value for nonbonded method");
+    nonbondedMethod = method;
+}
+
+double AmoebaWcaDispersionForce::getCutoffDistance() const {
+    return cutoffDistance;
+}
+
+void AmoebaWcaDispersionForce::setCutoffDistance(double distance) {
+    cutoffDistance = distance;
+}
+
 ForceImpl* AmoebaWcaDispersionForce::createImpl() const {
     return new AmoebaWcaDispersionForceImpl(*this);
 }
@@ -6,7 +6,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2008-2025 Stanford University and the Authors.      *
+ * Portions copyright (c) 2008-2026 Stanford University and the Authors.      *
  * Authors: Peter Eastman, Mark Friedrichs                                    *
  * Contributors:                                                              *
  *                                                                            *
@@ -37,12 +37,17 @@
 #include "openmm/internal/AmoebaTorsionTorsionForceImpl.h"
 #include "openmm/internal/AmoebaVdwForceImpl.h"
 #include "openmm/internal/NonbondedForceImpl.h"
+#include "openmm/internal/ThreadPool.h"
 #include "CommonKernelSources.h"
 #include "SimTKOpenMMRealType.h"
 #include "jama_lu.h"
 
 #include <algorithm>
 #include <cmath>
+#include <condition_variable>
+#include <iterator>
+#include <mutex>
+#include <sstream>
 #ifdef _MSC_VER
 #include <windows.h>
 #endif
@@ -105,6 +110,40 @@ CommonCalcAmoebaTorsionTorsionForceKernel::CommonCalcAmoebaTorsionTorsionForceKe
                 CalcAmoebaTorsionTorsionForceKernel(name, platform), cc(cc), system(system) {
 }
 
+/**
+ * Compute the bicubic spline coefficients for one cell of a torsion-torsion grid.  The corners are
+ * ordered (x1l,x2l), (x1u,x2l), (x1u,x2u), (x1l,x2u), and the derivatives are with respect to the
+ * angles in degrees.  The resulting energy is sum(c[i][j]*t^i*u^j) with t and u in [0, 1].
+ */
+static void computeBicubicCoefficients(const double y[4], const double y1i[4], const double y2i[4], const double y12i[4], double spacing, double c[4][4]) {
+    double y1[4], y2[4], y12[4];
+    for (int i = 0; i < 4; i++) {
+        y1[i] = spacing*y1i[i];
+        y2[i] = spacing*y2i[i];
+        y12[i] = spacing*spacing*y12i[i];
+    }
+    c[0][0] = y[0];
+    c[0][1] = y2[0];
+    c[0][2] = 3*(y[3]-y[0]) - (2*y2[0]+y2[3]);
+    c[0][3] = 2*(y[0]-y[3]) + y2[0] + y2[3];
+    c[1][0] = y1[0];
+    c[1][1] = y12[0];
+    c[1][2] = 3*(y1[3]-y1[0]) - (2*y12[0]+y12[3]);
+    c[1][3] = 2*(y1[0]-y1[3]) + y12[0] + y12[3];
+    c[2][0] = 3*(y[1]-y[0]) - (2*y1[0]+y1[1]);
+    c[2][1] = 3*(y2[1]-y2[0]) - (2*y12[0]+y12[1]);
+    c[2][2] = 9*(y[0]-y[1]+y[2]-y[3]) + 6*y1[0] + 3*y1[1] - 3*y1[2] - 6*y1[3] +
+              6*y2[0] - 6*y2[1] - 3*y2[2] + 3*y2[3] + 4*y12[0] + 2*y12[1] + y12[2] + 2*y12[3];
+    c[2][3] = 6*(y[1]-y[0]+y[3]-y[2]) - 4*y1[0] - 2*y1[1] + 2*y1[2] + 4*y1[3] -
+              3*y2[0] + 3*y2[1] + 3*y2[2] - 3*y2[3] - 2*y12[0] - y12[1] - y12[2] - 2*y12[3];
+    c[3][0] = 2*(y[0]-y[1]) + y1[0] + y1[1];
+    c[3][1] = 2*(y2[0]-y2[1]) + y12[0] + y12[1];
+    c[3][2] = 6*(y[1]-y[0]+y[3]-y[2]) + 3*(y1[2]+y1[3]-y1[0]-y1[1]) +
+              2*(2*(y2[1]-y2[0]) + y2[2] - y2[3]) - 2*(y12[0]+y12[1]) - y12[2] - y12[3];
+    c[3][3] = 4*(y[0]-y[1]+y[2]-y[3]) + 2*(y1[0]+y1[1]-y1[2]-y1[3]) +
+              2*(y2[0]-y2[1]-y2[2]+y2[3]) + y12[0] + y12[1] + y12[2] + y12[3];
+}
+
 void CommonCalcAmoebaTorsionTorsionForceKernel::initialize(const System& system, const AmoebaTorsionTorsionForce& force) {
     ContextSelector selector(cc);
     int numContexts = cc.getNumContexts();
@@ -114,18 +153,26 @@ void CommonCalcAmoebaTorsionTorsionForceKernel::initialize(const System& system,
     if (numTorsionTorsions == 0)
         return;
     
-    // Record torsion parameters.
+    // Record torsion parameters, sorted by grid so neighboring threads read from the same coefficient table.
     
+    vector<pair<int, int> > sortedTorsions(numTorsionTorsions);
+    for (int i = 0; i < numTorsionTorsions; i++) {
+        int particle1, particle2, particle3, particle4, particle5, chiralCheckAtomIndex, gridIndex;
+        force.getTorsionTorsionParameters(startIndex+i, particle1, particle2, particle3, particle4, particle5, chiralCheckAtomIndex, gridIndex);
+        sortedTorsions[i] = make_pair(gridIndex, startIndex+i);
+    }
+    sort(sortedTorsions.begin(), sortedTorsions.end());
     vector<vector<int> > atoms(numTorsionTorsions, vector<int>(5));
     vector<mm_int2> torsionParamsVec(numTorsionTorsions);
     torsionParams.initialize<mm_int2>(cc, numTorsionTorsions, "torsionTorsionParams");
     for (int i = 0; i < numTorsionTorsions; i++)
-        force.getTorsionTorsionParameters(startIndex+i, atoms[i][0], atoms[i][1], atoms[i][2], atoms[i][3], atoms[i][4], torsionParamsVec[i].x, torsionParamsVec[i].y);
+        force.getTorsionTorsionParameters(sortedTorsions[i].second, atoms[i][0], atoms[i][1], atoms[i][2], atoms[i][3], atoms[i][4], torsionParamsVec[i].x, torsionParamsVec[i].y);
     torsionParams.upload(torsionParamsVec);
     
-    // Record the grids.
+    // Record the grids.  Rather than the raw grid values, we store the 16 bicubic coefficients of
+    // every cell as four consecutive float4s, so each interaction reads one contiguous block.
     
-    vector<mm_float4> gridValuesVec;
+    vector<mm_float4> gridCoefficientsVec;
     vector<mm_float4> gridParamsVec;
     for (int i = 0; i < force.getNumTorsionTorsionGrids(); i++) {
         const TorsionTorsionGrid& initialGrid = force.getTorsionTorsionGrid(i);
@@ -139,24 +186,35 @@ void CommonCalcAmoebaTorsionTorsionForceKernel::initialize(const System& system,
             reordered = true;
         }
         const TorsionTorsionGrid& grid = (reordered ? reorderedGrid : initialGrid);
-        float range = grid[0][grid[0].size()-1][1] - grid[0][0][1];
-        gridParamsVec.push_back(mm_float4(gridValuesVec.size(), grid[0][0][0], range/(grid.size()-1), grid.size()));
-        for (int j = 0; j < grid.size(); j++)
-            for (int k = 0; k < grid[j].size(); k++)
-                gridValuesVec.push_back(mm_float4((float) grid[j][k][2], (float) grid[j][k][3], (float) grid[j][k][4], (float) grid[j][k][5]));
+        int size = grid.size();
+        double spacing = (grid[0][grid[0].size()-1][1] - grid[0][0][1])/(size-1);
+        gridParamsVec.push_back(mm_float4(gridCoefficientsVec.size(), grid[0][0][0], spacing, size));
+        for (int j = 0; j < size-1; j++)
+            for (int k = 0; k < size-1; k++) {
+                const vector<double>* corners[] = {&grid[j][k], &grid[j+1][k], &grid[j+1][k+1], &grid[j][k+1]};
+                double y[4], y1[4], y2[4], y12[4], c[4][4];
+                for (int m = 0; m < 4; m++) {
+                    y[m] = (*corners[m])[2];
+                    y1[m] = (*corners[m])[3];
+                    y2[m] = (*corners[m])[4];
+                    y12[m] = (*corners[m])[5];
+                }
+                computeBicubicCoefficients(y, y1, y2, y12, spacing, c);
+                for (int m = 0; m < 4; m++)
+                    gridCoefficientsVec.push_back(mm_float4((float) c[m][0], (float) c[m][1], (float) c[m][2], (float) c[m][3]));
+            }
     }
-    gridValues.initialize<mm_float4>(cc, gridValuesVec.size(), "torsionTorsionGridValues");
+    gridCoefficients.initialize<mm_float4>(cc, gridCoefficientsVec.size(), "torsionTorsionGridCoefficients");
     gridParams.initialize<mm_float4>(cc, gridParamsVec.size(), "torsionTorsionGridParams");
-    gridValues.upload(gridValuesVec);
+    gridCoefficients.upload(gridCoefficientsVec);
     gridParams.upload(gridParamsVec);
     map<string, string> replacements;
     replacements["APPLY_PERIODIC"] = (force.usesPeriodicBoundaryConditions() ? "1" : "0");
-    replacements["GRID_VALUES"] = cc.getBondedUtilities().addArgument(gridValues, "float4");
+    replacements["GRID_COEFF"] = cc.getBondedUtilities().addArgument(gridCoefficients, "float4");
     replacements["GRID_PARAMS"] = cc.getBondedUtilities().addArgument(gridParams, "float4");
     replacements["TORSION_PARAMS"] = cc.getBondedUtilities().addArgument(torsionParams, "int2");
     replacements["RAD_TO_DEG"] = cc.doubleToString(180/M_PI);
     cc.getBondedUtilities().addInteraction(atoms, cc.replaceStrings(CommonAmoebaKernelSources::amoebaTorsionTorsionForce, replacements), force.getForceGroup());
-    cc.getBondedUtilities().addPrefixCode(CommonAmoebaKernelSources::bicubic);
     cc.addForce(new ForceInfo(force));
 }
 
@@ -208,9 +266,32 @@ private:
     const AmoebaMultipoleForce& force;
 };
 
+class CommonCalcAmoebaMultipoleForceKernel::ReorderListener : public ComputeContext::ReorderListener {
+public:
+    ReorderListener(CommonCalcAmoebaMultipoleForceKernel& owner) : owner(owner) {
+    }
+    void execute() {
+        // The stored dipoles are in the old atom order, so they can no longer be used.
+
+        owner.predictorHistorySize = 0;
+    }
+private:
+    CommonCalcAmoebaMultipoleForceKernel& owner;
+};
+
+static double binomialCoefficient(int n, int k) {
+    if (k < 0 || k > n)
+        return 0.0;
+    double result = 1.0;
+    for (int i = 1; i <= k; i++)
+        result = result*(n-k+i)/i;
+    return result;
+}
+
 CommonCalcAmoebaMultipoleForceKernel::CommonCalcAmoebaMultipoleForceKernel(const std::string& name, const Platform& platform, ComputeContext& cc, const System& system) :
-        CalcAmoebaMultipoleForceKernel(name, platform), cc(cc), system(system), hasInitializedScaleFactors(false), multipolesAreValid(false), hasCreatedEvent(false),
-        gkKernel(NULL) {
+        CalcAmoebaMultipoleForceKernel(name, platform), predictorHistoryLength(0), predictorHistorySize(0), predictorNewestSlot(0), predictorPositionsSetCount(0),
+        predictorLastStep(0), cc(cc), system(system), usePCG(false), usePmeQueue(false), hasInitializedScaleFactors(false), multipolesAreValid(false), hasCreatedEvent(false),
+        hasInducedGrid(false), gkKernel(NULL), fieldReducer(NULL) {
 }
 
 void CommonCalcAmoebaMultipoleForceKernel::initialize(const System& system, const AmoebaMultipoleForce& force) {
@@ -267,29 +348,23 @@ void CommonCalcAmoebaMultipoleForceKernel::initialize(const System& system, cons
         for (int j = 0; j < 5; j++)
             localQuadrupolesVec.push_back(0);
     }
-    dampingAndThole.initialize<mm_float2>(cc, paddedNumAtoms, "dampingAndThole");
-    polarizability.initialize<float>(cc, paddedNumAtoms, "polarizability");
-    multipoleParticles.initialize<mm_int4>(cc, paddedNumAtoms, "multipoleParticles");
-    localCharges.initialize<float>(cc, paddedNumAtoms, "localCharges");
-    localDipoles.initialize<float>(cc, 3*paddedNumAtoms, "localDipoles");
-    localQuadrupoles.initialize<float>(cc, 5*paddedNumAtoms, "localQuadrupoles");
+    cc.initializeSharedArray(dampingAndThole, dampingAndTholeVec, "dampingAndThole");
+    cc.initializeSharedArray(polarizability, polarizabilityVec, "polarizability");
+    cc.initializeSharedArray(multipoleParticles, multipoleParticlesVec, "multipoleParticles");
+    cc.initializeSharedArray(localCharges, localChargeVec, "localCharges");
+    cc.initializeSharedArray(localDipoles, localDipolesVec, "localDipoles");
+    cc.initializeSharedArray(localQuadrupoles, localQuadrupolesVec, "localQuadrupoles");
     lastPositions.initialize(cc, cc.getPosq().getSize(), cc.getPosq().getElementSize(), "lastPositions");
-    dampingAndThole.upload(dampingAndTholeVec);
-    polarizability.upload(polarizabilityVec);
-    multipoleParticles.upload(multipoleParticlesVec);
-    localCharges.upload(localChargeVec);
-    localDipoles.upload(localDipolesVec);
-    localQuadrupoles.upload(localQuadrupolesVec);
     posq.upload(&temp[0]);
     
     // Create workspace arrays.
     
     polarizationType = force.getPolarizationType();
+    if (cc.getNumContexts() > 1 && polarizationType == AmoebaMultipoleForce::Extrapolated)
+        throw OpenMMException("AmoebaMultipoleForce does not support extrapolated polarization when using multiple devices");
     int elementSize = (cc.getUseDoublePrecision() ? sizeof(double) : sizeof(float));
     labDipoles.initialize(cc, 3*paddedNumAtoms, elementSize, "labDipoles");
     labQuadrupoles.initialize(cc, 5*paddedNumAtoms, elementSize, "labQuadrupoles");
-    sphericalDipoles.initialize(cc, 3*paddedNumAtoms, elementSize, "sphericalDipoles");
-    sphericalQuadrupoles.initialize(cc, 5*paddedNumAtoms, elementSize, "sphericalQuadrupoles");
     fracDipoles.initialize(cc, 3*paddedNumAtoms, elementSize, "fracDipoles");
     fracQuadrupoles.initialize(cc, 6*paddedNumAtoms, elementSize, "fracQuadrupoles");
     field.initialize(cc, 3*paddedNumAtoms, sizeof(long long), "field");
@@ -302,7 +377,8 @@ void CommonCalcAmoebaMultipoleForceKernel::initialize(const System& system, cons
         prevDipoles.initialize(cc, 3*numMultipoles*MaxPrevDIISDipoles, elementSize, "prevDipoles");
         prevDipolesPolar.initialize(cc, 3*numMultipoles*MaxPrevDIISDipoles, elementSize, "prevDipolesPolar");
         prevErrors.initialize(cc, 3*numMultipoles*MaxPrevDIISDipoles, elementSize, "prevErrors");
-        diisMatrix.initialize(cc, MaxPrevDIISDipoles*MaxPrevDIISDipoles, elementSize, "diisMatrix");
+        int mixedElementSize = (cc.getUseDoublePrecision() || cc.getUseMixedPrecision() ? sizeof(double) : sizeof(float));
+        diisMatrix.initialize(cc, MaxPrevDIISDipoles*MaxPrevDIISDipoles, mixedElementSize, "diisMatrix");
         diisCoefficients.initialize(cc, MaxPrevDIISDipoles+1, sizeof(float), "diisCoefficients");
         syncEvent = cc.createEvent();
         hasCreatedEvent = true;
@@ -326,37 +402,67 @@ void CommonCalcAmoebaMultipoleForceKernel::initialize(const System& system, cons
     // Record which atoms should be flagged as exclusions based on covalent groups, and determine
     // the values for the covalent group flags.
     
+    // This is done in parallel, working directly from the packed covalent maps.
+
+    const int numTypes = 6;
+    const AmoebaMultipoleForce::CovalentType types[numTypes] = {AmoebaMultipoleForce::Covalent12, AmoebaMultipoleForce::Covalent13, AmoebaMultipoleForce::Covalent14,
+            AmoebaMultipoleForce::Covalent15, AmoebaMultipoleForce::PolarizationCovalent11, AmoebaMultipoleForce::PolarizationCovalent12};
+    vector<int> mapOffsets[numTypes], mapAtoms[numTypes];
+    for (int i = 0; i < numTypes; i++)
+        force.getAllCovalentMaps(types[i], mapOffsets[i], mapAtoms[i]);
+    auto getMap = [&] (int type, int atom, const int*& begin, const int*& end) {
+        begin = mapAtoms[type].data()+mapOffsets[type][atom];
+        end = mapAtoms[type].data()+mapOffsets[type][atom+1];
+    };
     vector<vector<int> > exclusions(numMultipoles);
-    for (int i = 0; i < numMultipoles; i++) {
-        vector<int> atoms;
-        set<int> allAtoms;
-        allAtoms.insert(i);
-        force.getCovalentMap(i, AmoebaMultipoleForce::Covalent12, atoms);
-        allAtoms.insert(atoms.begin(), atoms.end());
-        force.getCovalentMap(i, AmoebaMultipoleForce::Covalent13, atoms);
-        allAtoms.insert(atoms.begin(), atoms.end());
-        for (int atom : allAtoms)
-            covalentFlagValues.push_back(mm_int4(i, atom, 0, 0));
-        force.getCovalentMap(i, AmoebaMultipoleForce::Covalent14, atoms);
-        allAtoms.insert(atoms.begin(), atoms.end());
-        for (int atom : atoms)
-            covalentFlagValues.push_back(mm_int4(i, atom, 1, 0));
-        force.getCovalentMap(i, AmoebaMultipoleForce::Covalent15, atoms);
-        for (int atom : atoms)
-            covalentFlagValues.push_back(mm_int4(i, atom, 2, 0));
-        allAtoms.insert(atoms.begin(), atoms.end());
-        force.getCovalentMap(i, AmoebaMultipoleForce::PolarizationCovalent11, atoms);
-        allAtoms.insert(atoms.begin(), atoms.end());
-        exclusions[i].insert(exclusions[i].end(), allAtoms.begin(), allAtoms.end());
-
-        // Workaround for bug in TINKER: if an atom is listed in both the PolarizationCovalent11
-        // and PolarizationCovalent12 maps, the latter takes precedence.
-
-        vector<int> atoms12;
-        force.getCovalentMap(i, AmoebaMultipoleForce::PolarizationCovalent12, atoms12);
-        for (int atom : atoms)
-            if (find(atoms12.begin(), atoms12.end(), atom) == atoms12.end())
-                polarizationFlagValues.push_back(mm_int2(i, atom));
+    int numThreads = cc.getThreadPool().getNumThreads();
+    vector<vector<mm_int4> > threadCovalentFlags(numThreads);
+    vector<vector<mm_int2> > threadPolarizationFlags(numThreads);
+    cc.getThreadPool().execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numMultipoles/numThreads;
+        int end = (threadIndex+1)*numMultipoles/numThreads;
+        vector<mm_int4>& covalentValues = threadCovalentFlags[threadIndex];
+        vector<mm_int2>& polarizationValues = threadPolarizationFlags[threadIndex];
+        vector<int> allAtoms;
+        const int *begin, *last;
+        for (int i = start; i < end; i++) {
+            allAtoms.assign(1, i);
+            getMap(0, i, begin, last);
+            allAtoms.insert(allAtoms.end(), begin, last);
+            getMap(1, i, begin, last);
+            allAtoms.insert(allAtoms.end(), begin, last);
+            sort(allAtoms.begin(), allAtoms.end());
+            allAtoms.erase(unique(allAtoms.begin(), allAtoms.end()), allAtoms.end());
+            for (int atom : allAtoms)
+                covalentValues.push_back(mm_int4(i, atom, 0, 0));
+            getMap(2, i, begin, last);
+            allAtoms.insert(allAtoms.end(), begin, last);
+            for (const int* atom = begin; atom != last; ++atom)
+                covalentValues.push_back(mm_int4(i, *atom, 1, 0));
+            getMap(3, i, begin, last);
+            allAtoms.insert(allAtoms.end(), begin, last);
+            for (const int* atom = begin; atom != last; ++atom)
+                covalentValues.push_back(mm_int4(i, *atom, 2, 0));
+            getMap(4, i, begin, last);
+            allAtoms.insert(allAtoms.end(), begin, last);
+            sort(allAtoms.begin(), allAtoms.end());
+            allAtoms.erase(unique(allAtoms.begin(), allAtoms.end()), allAtoms.end());
+            exclusions[i] = allAtoms;
+
+            // Workaround for bug in TINKER: if an atom is listed in both the PolarizationCovalent11
+            // and PolarizationCovalent12 maps, the latter takes precedence.
+
+            const int *begin12, *last12;
+            getMap(5, i, begin12, last12);
+            for (const int* atom = begin; atom != last; ++atom)
+                if (find(begin12, last12, *atom) == last12)
+                    polarizationValues.push_back(mm_int2(i, *atom));
+        }
+    });
+    cc.getThreadPool().waitForThreads();
+    for (int i = 0; i < numThreads; i++) {
+        covalentFlagValues.insert(covalentFlagValues.end(), threadCovalentFlags[i].begin(), threadCovalentFlags[i].end());
+        polarizationFlagValues.insert(polarizationFlagValues.end(), threadPolarizationFlags[i].begin(), threadPolarizationFlags[i].end());
     }
     set<pair<int, int> > tilesWithExclusions;
     for (int atom1 = 0; atom1 < (int) exclusions.size(); ++atom1) {
@@ -387,6 +493,56 @@ void CommonCalcAmoebaMultipoleForceKernel::initialize(const System& system, cons
     for (int i = 0; i < system.getNumForces() && gk == NULL; i++)
         gk = dynamic_cast<const AmoebaGeneralizedKirkwoodForce*>(&system.getForce(i));
     double innerDielectric = (gk == NULL ? 1.0 : gk->getSoluteDielectric());
+
+    // The conjugate gradient solver is only used without implicit solvent.  With
+    // Generalized Kirkwood the vacuum and solvated dipoles are coupled, so fall back to DIIS.
+
+    usePCG = (polarizationType == AmoebaMultipoleForce::Mutual && force.getMutualInducedSolver() == AmoebaMultipoleForce::PCG && gk == NULL);
+    if (usePCG) {
+        pcgDipole.initialize(cc, 3*paddedNumAtoms, elementSize, "pcgDipole");
+        pcgDipolePolar.initialize(cc, 3*paddedNumAtoms, elementSize, "pcgDipolePolar");
+        pcgResidual.initialize(cc, 3*paddedNumAtoms, elementSize, "pcgResidual");
+        pcgResidualPolar.initialize(cc, 3*paddedNumAtoms, elementSize, "pcgResidualPolar");
+        pcgSums.initialize(cc, 3*cc.getNumThreadBlocks(), 2*elementSize, "pcgSums");
+    }
+
+    // If requested, keep a history of converged dipoles from previous steps to predict the
+    // starting point of the iteration.
+
+    if (polarizationType == AmoebaMultipoleForce::Mutual && force.getMutualInducedPredictor() != AmoebaMultipoleForce::NoPredictor) {
+        int order = force.getMutualInducedPredictorOrder();
+        vector<double> coefficients;
+        if (force.getMutualInducedPredictor() == AmoebaMultipoleForce::ASPC) {
+            double denominator = binomialCoefficient(2*order+2, order+1);
+            for (int j = 1; j <= order+2; j++)
+                coefficients.push_back((j%2 == 1 ? 1 : -1)*j*binomialCoefficient(2*order+4, order+2-j)/denominator);
+        }
+        else if (force.getMutualInducedPredictor() == AmoebaMultipoleForce::Polynomial) {
+            for (int j = 1; j <= order+1; j++)
+                coefficients.push_back((j%2 == 1 ? 1 : -1)*binomialCoefficient(order+1, j));
+        }
+        else {
+            // The history holds auxiliary dipoles propagated with the dissipative extended Lagrangian
+            // scheme of Niklasson et al. (J. Chem. Phys. 130, 214109 (2009)) using K=5.  The iteration
+            // starts from the newest one, and the next one is computed from the result.
+
+            const double kappa = 1.82, alpha = 0.018;
+            const double c[] = {-6, 14, -8, -3, 4, -1};
+            vector<double> auxCoefficients(1, kappa);
+            for (int k = 0; k < 6; k++)
+                auxCoefficients.push_back(alpha*c[k] + (k == 0 ? 2-kappa : k == 1 ? -1 : 0));
+            coefficients.resize(auxCoefficients.size(), 0.0);
+            coefficients[0] = 1.0;
+            auxiliaryCoefficients.initialize(cc, auxCoefficients.size(), elementSize, "auxiliaryCoefficients");
+            auxiliaryCoefficients.upload(auxCoefficients, true);
+        }
+        predictorHistoryLength = coefficients.size();
+        dipoleHistory.initialize(cc, 3*numMultipoles*predictorHistoryLength, elementSize, "dipoleHistory");
+        dipoleHistoryPolar.initialize(cc, 3*numMultipoles*predictorHistoryLength, elementSize, "dipoleHistoryPolar");
+        predictorCoefficients.initialize(cc, predictorHistoryLength, elementSize, "predictorCoefficients");
+        predictorCoefficients.upload(coefficients, true);
+        cc.addReorderListener(new ReorderListener(*this));
+    }
     
     // Create the kernels.
 
@@ -450,12 +606,20 @@ void CommonCalcAmoebaMultipoleForceKernel::initialize(const System& system, cons
             gridSizeY = cc.findLegalFFTDimension(ny);
             gridSizeZ = cc.findLegalFFTDimension(nz);
         }
+        force.getInducedDipolePMEParameters(nx, ny, nz, inducedPmeOrder);
+        if (nx != 0 && polarizationType == AmoebaMultipoleForce::Mutual && cc.getContextIndex() == 0) {
+            inducedGridSizeX = cc.findLegalFFTDimension(nx);
+            inducedGridSizeY = cc.findLegalFFTDimension(ny);
+            inducedGridSizeZ = cc.findLegalFFTDimension(nz);
+            hasInducedGrid = (inducedGridSizeX != gridSizeX || inducedGridSizeY != gridSizeY || inducedGridSizeZ != gridSizeZ || inducedPmeOrder != PmeOrder);
+        }
+        cutoff = force.getCutoffDistance();
         defines["EWALD_ALPHA"] = cc.doubleToString(pmeAlpha);
         defines["SQRT_PI"] = cc.doubleToString(sqrt(M_PI));
         defines["USE_EWALD"] = "";
         defines["USE_CUTOFF"] = "";
         defines["USE_PERIODIC"] = "";
-        defines["CUTOFF_SQUARED"] = cc.doubleToString(force.getCutoffDistance()*force.getCutoffDistance());
+        defines["CUTOFF_SQUARED"] = cc.doubleToString(cutoff*cutoff);
     }
     if (gk != NULL) {
         defines["USE_GK"] = "";
@@ -464,6 +628,16 @@ void CommonCalcAmoebaMultipoleForceKernel::initialize(const System& system, cons
         defines["GK_FC"] = cc.doubleToString(1*(1-solventDielectric)/(0+1*solventDielectric));
         defines["GK_FD"] = cc.doubleToString(2*(1-solventDielectric)/(1+2*solventDielectric));
         defines["GK_FQ"] = cc.doubleToString(3*(1-solventDielectric)/(2+3*solventDielectric));
+        if (gk->getNonbondedMethod() == AmoebaGeneralizedKirkwoodForce::CutoffNonPeriodic) {
+            defines["USE_GK_CUTOFF"] = "";
+            double cutoff = gk->getCutoffDistance();
+            double taperCutoff = cutoff*0.9;
+            defines["GK_CUTOFF_SQUARED"] = cc.doubleToString(cutoff*cutoff);
+            defines["GK_TAPER_CUTOFF"] = cc.doubleToString(taperCutoff);
+            defines["GK_TAPER_C3"] = cc.doubleToString(10/pow(taperCutoff-cutoff, 3.0));
+            defines["GK_TAPER_C4"] = cc.doubleToString(15/pow(taperCutoff-cutoff, 4.0));
+            defines["GK_TAPER_C5"] = cc.doubleToString(6/pow(taperCutoff-cutoff, 5.0));
+        }
         fixedThreadMemory += 4*elementSize;
         inducedThreadMemory += 13*elementSize;
         if (polarizationType == AmoebaMultipoleForce::Mutual) {
@@ -494,8 +668,6 @@ void CommonCalcAmoebaMultipoleForceKernel::initialize(const System& system, cons
     computeMomentsKernel->addArg(localQuadrupoles);
     computeMomentsKernel->addArg(labDipoles);
     computeMomentsKernel->addArg(labQuadrupoles);
-    computeMomentsKernel->addArg(sphericalDipoles);
-    computeMomentsKernel->addArg(sphericalQuadrupoles);
     recordInducedDipolesKernel = program->createKernel("recordInducedDipoles");
     recordInducedDipolesKernel->addArg(field);
     recordInducedDipolesKernel->addArg(fieldPolar);
@@ -517,6 +689,29 @@ void CommonCalcAmoebaMultipoleForceKernel::initialize(const System& system, cons
     computePotentialKernel->addArg(inducedDipole);
     for (int i = 0; i < 8; i++)
         computePotentialKernel->addArg();
+    if (usePME) {
+        // These kernels evaluate the direct space part of the Ewald potential, using a cell list to
+        // find the atoms within the cutoff of each point.
+
+        potentialAtomCells.initialize<mm_int2>(cc, numMultipoles, "potentialAtomCells");
+        potentialSort = cc.createSort(new PotentialCellSortTrait(), numMultipoles);
+        findAtomPotentialCellsKernel = program->createKernel("findAtomPotentialCells");
+        findAtomPotentialCellsKernel->addArg(cc.getPosq());
+        findAtomPotentialCellsKernel->addArg(potentialAtomCells);
+        for (int i = 0; i < 8; i++)
+            findAtomPotentialCellsKernel->addArg();
+        findPotentialCellRangesKernel = program->createKernel("findPotentialCellRanges");
+        findPotentialCellRangesKernel->addArg(potentialAtomCells);
+        findPotentialCellRangesKernel->addArg();
+        computeEwaldPotentialKernel = program->createKernel("computeEwaldPotentialAtPoints");
+        computeEwaldPotentialKernel->addArg(cc.getPosq());
+        computeEwaldPotentialKernel->addArg(labDipoles);
+        computeEwaldPotentialKernel->addArg(labQuadrupoles);
+        computeEwaldPotentialKernel->addArg(inducedDipole);
+        computeEwaldPotentialKernel->addArg(potentialAtomCells);
+        for (int i = 0; i < 12; i++)
+            computeEwaldPotentialKernel->addArg();
+    }
     defines["THREAD_BLOCK_SIZE"] = cc.intToString(fixedFieldThreads);
     program = cc.compileProgram(CommonAmoebaKernelSources::multipoleFixedField, defines);
     computeFixedFieldKernel = program->createKernel("computeFixedField");
@@ -600,6 +795,76 @@ void CommonCalcAmoebaMultipoleForceKernel::initialize(const System& system, cons
             solveMatrixKernel->addArg();
             solveMatrixKernel->addArg(diisMatrix);
             solveMatrixKernel->addArg(diisCoefficients);
+            if (usePCG) {
+                initPCGKernel = program->createKernel("initializePCGDipoles");
+                initPCGKernel->addArg(field);
+                initPCGKernel->addArg(fieldPolar);
+                initPCGKernel->addArg(inducedField);
+                initPCGKernel->addArg(inducedFieldPolar);
+                initPCGKernel->addArg(polarizability);
+                initPCGKernel->addArg(inducedDipole);
+                initPCGKernel->addArg(inducedDipolePolar);
+                initPCGKernel->addArg(pcgDipole);
+                initPCGKernel->addArg(pcgDipolePolar);
+                initPCGKernel->addArg(pcgResidual);
+                initPCGKernel->addArg(pcgResidualPolar);
+                initPCGKernel->addArg(inducedDipoleErrors);
+                initPCGKernel->addArg(pcgSums);
+                computePCGProductsKernel = program->createKernel("computePCGProducts");
+                computePCGProductsKernel->addArg(inducedField);
+                computePCGProductsKernel->addArg(inducedFieldPolar);
+                computePCGProductsKernel->addArg(polarizability);
+                computePCGProductsKernel->addArg(inducedDipole);
+                computePCGProductsKernel->addArg(inducedDipolePolar);
+                computePCGProductsKernel->addArg(pcgSums);
+                updatePCGKernel = program->createKernel("updatePCGDipoles");
+                updatePCGKernel->addArg(inducedField);
+                updatePCGKernel->addArg(inducedFieldPolar);
+                updatePCGKernel->addArg(polarizability);
+                updatePCGKernel->addArg(inducedDipole);
+                updatePCGKernel->addArg(inducedDipolePolar);
+                updatePCGKernel->addArg(pcgDipole);
+                updatePCGKernel->addArg(pcgDipolePolar);
+                updatePCGKernel->addArg(pcgResidual);
+                updatePCGKernel->addArg(pcgResidualPolar);
+                updatePCGKernel->addArg(inducedDipoleErrors);
+                updatePCGKernel->addArg(pcgSums);
+                updatePCGKernel->addArg();
+                updatePCGDirectionKernel = program->createKernel("updatePCGSearchDirection");
+                updatePCGDirectionKernel->addArg(pcgResidual);
+                updatePCGDirectionKernel->addArg(pcgResidualPolar);
+                updatePCGDirectionKernel->addArg(inducedDipole);
+                updatePCGDirectionKernel->addArg(inducedDipolePolar);
+                updatePCGDirectionKernel->addArg(pcgSums);
+                updatePCGDirectionKernel->addArg();
+            }
+            if (predictorHistoryLength > 0) {
+                predictDipolesKernel = program->createKernel("predictInducedDipoles");
+                predictDipolesKernel->addArg(inducedDipole);
+                predictDipolesKernel->addArg(inducedDipolePolar);
+                predictDipolesKernel->addArg(dipoleHistory);
+                predictDipolesKernel->addArg(dipoleHistoryPolar);
+                predictDipolesKernel->addArg(predictorCoefficients);
+                predictDipolesKernel->addArg(predictorHistoryLength);
+                predictDipolesKernel->addArg();
+                recordDipoleHistoryKernel = program->createKernel("recordInducedDipoleHistory");
+                recordDipoleHistoryKernel->addArg(inducedDipole);
+                recordDipoleHistoryKernel->addArg(inducedDipolePolar);
+                recordDipoleHistoryKernel->addArg(dipoleHistory);
+                recordDipoleHistoryKernel->addArg(dipoleHistoryPolar);
+                recordDipoleHistoryKernel->addArg();
+                if (auxiliaryCoefficients.isInitialized()) {
+                    propagateAuxiliaryDipolesKernel = program->createKernel("propagateAuxiliaryDipoles");
+                    propagateAuxiliaryDipolesKernel->addArg(inducedDipole);
+                    propagateAuxiliaryDipolesKernel->addArg(inducedDipolePolar);
+                    propagateAuxiliaryDipolesKernel->addArg(dipoleHistory);
+                    propagateAuxiliaryDipolesKernel->addArg(dipoleHistoryPolar);
+                    propagateAuxiliaryDipolesKernel->addArg(auxiliaryCoefficients);
+                    propagateAuxiliaryDipolesKernel->addArg(predictorHistoryLength);
+                    propagateAuxiliaryDipolesKernel->addArg();
+                    propagateAuxiliaryDipolesKernel->addArg();
+                }
+            }
         }
         if (polarizationType == AmoebaMultipoleForce::Extrapolated) {
             initExtrapolatedKernel = program->createKernel("initExtrapolatedDipoles");
@@ -695,15 +960,15 @@ void CommonCalcAmoebaMultipoleForceKernel::initialize(const System& system, cons
         electrostaticsKernel->addArg(nb.getBlockCenters());
         electrostaticsKernel->addArg(nb.getInteractingAtoms());
     }
-    electrostaticsKernel->addArg(sphericalDipoles);
-    electrostaticsKernel->addArg(sphericalQuadrupoles);
+    electrostaticsKernel->addArg(labDipoles);
+    electrostaticsKernel->addArg(labQuadrupoles);
     electrostaticsKernel->addArg(inducedDipole);
     electrostaticsKernel->addArg(inducedDipolePolar);
     electrostaticsKernel->addArg(dampingAndThole);
 
-    // Set up PME.
+    // Set up PME.  When running on multiple devices, reciprocal space is only computed on the first one.
     
-    if (usePME) {
+    if (usePME && cc.getContextIndex() == 0) {
         // Create required data structures.
 
         int elementSize = (cc.getUseDoublePrecision() ? sizeof(double) : sizeof(float));
@@ -746,6 +1011,13 @@ void CommonCalcAmoebaMultipoleForceKernel::initialize(const System& system, cons
             pmeDefines["EXTRAPOLATED_POLARIZATION"] = "";
         if (useFixedPointChargeSpreading())
             pmeDefines["USE_FIXED_POINT_CHARGE_SPREADING"] = "";
+        usePmeQueue = supportsPmeQueue();
+        if (usePmeQueue) {
+            pmeDefines["USE_PME_STREAM"] = "";
+            pmeQueue = cc.createQueue();
+            pmeStartEvent = cc.createEvent();
+            pmeSyncEvent = cc.createEvent();
+        }
         program = cc.compileProgram(CommonAmoebaKernelSources::multipolePme, pmeDefines);
         pmeTransformMultipolesKernel = program->createKernel("transformMultipolesToFractionalCoordinates");
         pmeTransformMultipolesKernel->addArg(labDipoles);
@@ -800,6 +1072,10 @@ void CommonCalcAmoebaMultipoleForceKernel::initialize(const System& system, cons
         pmeFixedPotentialKernel->addArg(labDipoles);
         for (int i = 0; i < 6; i++)
             pmeFixedPotentialKernel->addArg();
+        pmePotentialAtPointsKernel = program->createKernel("computePotentialAtPointsFromGrid");
+        pmePotentialAtPointsKernel->addArg(pmeGrid1);
+        for (int i = 0; i < 10; i++)
+            pmePotentialAtPointsKernel->addArg();
         pmeInducedPotentialKernel = program->createKernel("computeInducedPotentialFromGrid");
         pmeInducedPotentialKernel->addArg(pmeGrid1);
         pmeInducedPotentialKernel->addArg(pmePhid);
@@ -857,97 +1133,57 @@ void CommonCalcAmoebaMultipoleForceKernel::initialize(const System& system, cons
 
         // Initialize the B-spline moduli.
 
-        double data[PmeOrder];
-        double x = 0.0;
-        data[0] = 1.0 - x;
-        data[1] = x;
-        for (int i = 2; i < PmeOrder; i++) {
-            double denom = 1.0/i;
-            data[i] = x*data[i-1]*denom;
-            for (int j = 1; j < i; j++)
-                data[i-j] = ((x+j)*data[i-j-1] + ((i-j+1)-x)*data[i-j])*denom;
-            data[0] = (1.0-x)*data[0]*denom;
-        }
-        int maxSize = max(max(gridSizeX, gridSizeY), gridSizeZ);
-        vector<double> bsplines_data(maxSize+1, 0.0);
-        for (int i = 2; i <= PmeOrder+1; i++)
-            bsplines_data[i] = data[i-2];
-        for (int dim = 0; dim < 3; dim++) {
-            int ndata = (dim == 0 ? gridSizeX : dim == 1 ? gridSizeY : gridSizeZ);
-            vector<double> moduli(ndata);
-
-            // get the modulus of the discrete Fourier transform
-
-            double factor = 2.0*M_PI/ndata;
-            for (int i = 0; i < ndata; i++) {
-                double sc = 0.0;
-                double ss = 0.0;
-                for (int j = 1; j <= ndata; j++) {
-                    double arg = factor*i*(j-1);
-                    sc += bsplines_data[j]*cos(arg);
-                    ss += bsplines_data[j]*sin(arg);
-                }
-                moduli[i] = sc*sc+ss*ss;
-            }
-
-            // Fix for exponential Euler spline interpolation failure.
-
-            double eps = 1.0e-7;
-            if (moduli[0] < eps)
-                moduli[0] = 0.9*moduli[1];
-            for (int i = 1; i < ndata-1; i++)
-                if (moduli[i] < eps)
-                    moduli[i] = 0.9*(moduli[i-1]+moduli[i+1]);
-            if (moduli[ndata-1] < eps)
-                moduli[ndata-1] = 0.9*moduli[ndata-2];
-
-            // Compute and apply the optimal zeta coefficient.
-
-            int jcut = 50;
-            for (int i = 1; i <= ndata; i++) {
-                int k = i - 1;
-                if (i > ndata/2)
-                    k = k - ndata;
-                double zeta;
-                if (k == 0)
-                    zeta = 1.0;
-                else {
-                    double sum1 = 1.0;
-                    double sum2 = 1.0;
-                    factor = M_PI*k/ndata;
-                    for (int j = 1; j <= jcut; j++) {
-                        double arg = factor/(factor+M_PI*j);
-                        sum1 += pow(arg, PmeOrder);
-                        sum2 += pow(arg, 2*PmeOrder);
-                    }
-                    for (int j = 1; j <= jcut; j++) {
-                        double arg = factor/(factor-M_PI*j);
-                        sum1 += pow(arg, PmeOrder);
-                        sum2 += pow(arg, 2*PmeOrder);
-                    }
-                    zeta = sum2/sum1;
-                }
-                moduli[i-1] = moduli[i-1]*zeta*zeta;
-            }
-            if (cc.getUseDoublePrecision()) {
-                if (dim == 0)
-                    pmeBsplineModuliX.upload(moduli);
-                else if (dim == 1)
-                    pmeBsplineModuliY.upload(moduli);
-                else
-                    pmeBsplineModuliZ.upload(moduli);
-            }
-            else {
-                vector<float> modulif(ndata);
-                for (int i = 0; i < ndata; i++)
-                    modulif[i] = (float) moduli[i];
-                if (dim == 0)
-                    pmeBsplineModuliX.upload(modulif);
-                else if (dim == 1)
-                    pmeBsplineModuliY.upload(modulif);
-                else
-                    pmeBsplineModuliZ.upload(modulif);
+        computeBsplineModuli(pmeBsplineModuliX, pmeBsplineModuliY, pmeBsplineModuliZ, gridSizeX, gridSizeY, gridSizeZ, PmeOrder);
+
+        // If the induced dipoles are iterated on a separate grid, create a second set of kernels
+        // compiled for its size and B-spline order.
+
+        if (hasInducedGrid) {
+            int inducedGridPoints = inducedGridSizeX*inducedGridSizeY*inducedGridSizeZ;
+            inducedPmeGrid1.initialize(cc, inducedGridPoints, 2*elementSize, "inducedPmeGrid1");
+            inducedPmeGrid2.initialize(cc, inducedGridPoints, 2*elementSize, "inducedPmeGrid2");
+            if (useFixedPointChargeSpreading())
+                inducedPmeGridLong.initialize(cc, 2*inducedGridPoints, sizeof(long long), "inducedPmeGridLong");
+            inducedPmeBsplineModuliX.initialize(cc, inducedGridSizeX, elementSize, "inducedPmeBsplineModuliX");
+            inducedPmeBsplineModuliY.initialize(cc, inducedGridSizeY, elementSize, "inducedPmeBsplineModuliY");
+            inducedPmeBsplineModuliZ.initialize(cc, inducedGridSizeZ, elementSize, "inducedPmeBsplineModuliZ");
+            computeBsplineModuli(inducedPmeBsplineModuliX, inducedPmeBsplineModuliY, inducedPmeBsplineModuliZ, inducedGridSizeX, inducedGridSizeY, inducedGridSizeZ, inducedPmeOrder);
+            inducedFft = cc.createFFT(inducedGridSizeX, inducedGridSizeY, inducedGridSizeZ, false);
+            pmeDefines["PME_ORDER"] = cc.intToString(inducedPmeOrder);
+            pmeDefines["GRID_SIZE_X"] = cc.intToString(inducedGridSizeX);
+            pmeDefines["GRID_SIZE_Y"] = cc.intToString(inducedGridSizeY);
+            pmeDefines["GRID_SIZE_Z"] = cc.intToString(inducedGridSizeZ);
+            ComputeProgram inducedProgram = cc.compileProgram(CommonAmoebaKernelSources::multipolePme, pmeDefines);
+            inducedPmeSpreadKernel = inducedProgram->createKernel("gridSpreadInducedDipoles");
+            inducedPmeSpreadKernel->addArg(cc.getPosq());
+            inducedPmeSpreadKernel->addArg(inducedDipole);
+            inducedPmeSpreadKernel->addArg(inducedDipolePolar);
+            if (useFixedPointChargeSpreading())
+                inducedPmeSpreadKernel->addArg(inducedPmeGridLong);
+            else
+                inducedPmeSpreadKernel->addArg(inducedPmeGrid1);
+            for (int i = 0; i < 6; i++)
+                inducedPmeSpreadKernel->addArg();
+            if (useFixedPointChargeSpreading()) {
+                inducedPmeFinishSpreadKernel = inducedProgram->createKernel("finishSpreadCharge");
+                inducedPmeFinishSpreadKernel->addArg(inducedPmeGridLong);
+                inducedPmeFinishSpreadKernel->addArg(inducedPmeGrid1);
             }
+            inducedPmeConvolutionKernel = inducedProgram->createKernel("reciprocalConvolution");
+            inducedPmeConvolutionKernel->addArg(inducedPmeGrid2);
+            inducedPmeConvolutionKernel->addArg(inducedPmeBsplineModuliX);
+            inducedPmeConvolutionKernel->addArg(inducedPmeBsplineModuliY);
+            inducedPmeConvolutionKernel->addArg(inducedPmeBsplineModuliZ);
+            for (int i = 0; i < 4; i++)
+                inducedPmeConvolutionKernel->addArg();
+            inducedPmePotentialKernel = inducedProgram->createKernel("computeInducedPotentialFromGrid");
+            inducedPmePotentialKernel->addArg(inducedPmeGrid1);
+            inducedPmePotentialKernel->addArg(pmePhid);
+            inducedPmePotentialKernel->addArg(pmePhip);
+            inducedPmePotentialKernel->addArg(pmePhidp);
+            inducedPmePotentialKernel->addArg(cc.getPosq());
+            for (int i = 0; i < 6; i++)
+                inducedPmePotentialKernel->addArg();
         }
     }
 
@@ -959,6 +1195,101 @@ void CommonCalcAmoebaMultipoleForceKernel::initialize(const System& system, cons
     cc.addForce(new ForceInfo(force));
 }
 
+void CommonCalcAmoebaMultipoleForceKernel::computeBsplineModuli(ComputeArray& moduliX, ComputeArray& moduliY, ComputeArray& moduliZ, int sizeX, int sizeY, int sizeZ, int order) {
+    vector<double> data(order);
+    double x = 0.0;
+    data[0] = 1.0 - x;
+    data[1] = x;
+    for (int i = 2; i < order; i++) {
+        double denom = 1.0/i;
+        data[i] = x*data[i-1]*denom;
+        for (int j = 1; j < i; j++)
+            data[i-j] = ((x+j)*data[i-j-1] + ((i-j+1)-x)*data[i-j])*denom;
+        data[0] = (1.0-x)*data[0]*denom;
+    }
+    int maxSize = max(max(max(sizeX, sizeY), sizeZ), order+1);
+    vector<double> bsplines_data(maxSize+1, 0.0);
+    for (int i = 2; i <= order+1; i++)
+        bsplines_data[i] = data[i-2];
+    for (int dim = 0; dim < 3; dim++) {
+        int ndata = (dim == 0 ? sizeX : dim == 1 ? sizeY : sizeZ);
+        vector<double> moduli(ndata);
+
+        // get the modulus of the discrete Fourier transform
+
+        double factor = 2.0*M_PI/ndata;
+        for (int i = 0; i < ndata; i++) {
+            double sc = 0.0;
+            double ss = 0.0;
+            for (int j = 1; j <= ndata; j++) {
+                double arg = factor*i*(j-1);
+                sc += bsplines_data[j]*cos(arg);
+                ss += bsplines_data[j]*sin(arg);
+            }
+            moduli[i] = sc*sc+ss*ss;
+        }
+
+        // Fix for exponential Euler spline interpolation failure.
+
+        double eps = 1.0e-7;
+        if (moduli[0] < eps)
+            moduli[0] = 0.9*moduli[1];
+        for (int i = 1; i < ndata-1; i++)
+            if (moduli[i] < eps)
+                moduli[i] = 0.9*(moduli[i-1]+moduli[i+1]);
+        if (moduli[ndata-1] < eps)
+            moduli[ndata-1] = 0.9*moduli[ndata-2];
+
+        // Compute and apply the optimal zeta coefficient.
+
+        int jcut = 50;
+        for (int i = 1; i <= ndata; i++) {
+            int k = i - 1;
+            if (i > ndata/2)
+                k = k - ndata;
+            double zeta;
+            if (k == 0)
+                zeta = 1.0;
+            else {
+                double sum1 = 1.0;
+                double sum2 = 1.0;
+                factor = M_PI*k/ndata;
+                for (int j = 1; j <= jcut; j++) {
+                    double arg = factor/(factor+M_PI*j);
+                    sum1 += pow(arg, order);
+                    sum2 += pow(arg, 2*order);
+                }
+                for (int j = 1; j <= jcut; j++) {
+                    double arg = factor/(factor-M_PI*j);
+                    sum1 += pow(arg, order);
+                    sum2 += pow(arg, 2*order);
+                }
+                zeta = sum2/sum1;
+            }
+            moduli[i-1] = moduli[i-1]*zeta*zeta;
+        }
+        if (cc.getUseDoublePrecision()) {
+            if (dim == 0)
+                moduliX.upload(moduli);
+            else if (dim == 1)
+                moduliY.upload(moduli);
+            else
+                moduliZ.upload(moduli);
+        }
+        else {
+            vector<float> modulif(ndata);
+            for (int i = 0; i < ndata; i++)
+                modulif[i] = (float) moduli[i];
+            if (dim == 0)
+                moduliX.upload(modulif);
+            else if (dim == 1)
+                moduliY.upload(modulif);
+            else
+                moduliZ.upload(modulif);
+        }
+    }
+}
+
 void CommonCalcAmoebaMultipoleForceKernel::initializeScaleFactors() {
     hasInitializedScaleFactors = true;
     NonbondedUtilities& nb = cc.getNonbondedUtilities();
@@ -972,63 +1303,82 @@ void CommonCalcAmoebaMultipoleForceKernel::initializeScaleFactors() {
         mm_int2 tile = exclusionTiles[i];
         exclusionTileMap[make_pair(tile.x, tile.y)] = i;
     }
+
+    // Each value sets one or two bits in the flags for an exclusion tile.  Finding the bits to set is
+    // done in parallel, and then they are combined into the flags.  Each entry is the index of a flag
+    // followed by the bits for it.
+
+    auto findTileIndex = [&] (int x, int y) {
+        return exclusionTileMap.find(make_pair(x, y))->second*ComputeContext::TileSize;
+    };
+    int numThreads = cc.getThreadPool().getNumThreads();
+    vector<vector<mm_int4> > threadCovalentBits(numThreads);
+    vector<vector<mm_int2> > threadPolarizationBits(numThreads);
+    cc.getThreadPool().execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*covalentFlagValues.size()/numThreads;
+        int end = (threadIndex+1)*covalentFlagValues.size()/numThreads;
+        vector<mm_int4>& covalentBits = threadCovalentBits[threadIndex];
+        for (int i = start; i < end; i++) {
+            mm_int4 values = covalentFlagValues[i];
+            int atom1 = values.x;
+            int atom2 = values.y;
+            int value = values.z;
+            int x = atom1/ComputeContext::TileSize;
+            int offset1 = atom1-x*ComputeContext::TileSize;
+            int y = atom2/ComputeContext::TileSize;
+            int offset2 = atom2-y*ComputeContext::TileSize;
+            int f1 = (value == 0 || value == 1 ? 1 : 0);
+            int f2 = (value == 0 || value == 2 ? 1 : 0);
+            if (x == y) {
+                int index = findTileIndex(x, y);
+                covalentBits.push_back(mm_int4(index+offset1, f1<<offset2, f2<<offset2, 0));
+                covalentBits.push_back(mm_int4(index+offset2, f1<<offset1, f2<<offset1, 0));
+            }
+            else if (x > y) {
+                int index = findTileIndex(x, y);
+                covalentBits.push_back(mm_int4(index+offset1, f1<<offset2, f2<<offset2, 0));
+            }
+            else {
+                int index = findTileIndex(y, x);
+                covalentBits.push_back(mm_int4(index+offset2, f1<<offset1, f2<<offset1, 0));
+            }
+        }
+        start = threadIndex*polarizationFlagValues.size()/numThreads;
+        end = (threadIndex+1)*polarizationFlagValues.size()/numThreads;
+        vector<mm_int2>& polarizationBits = threadPolarizationBits[threadIndex];
+        for (int i = start; i < end; i++) {
+            mm_int2 values = polarizationFlagValues[i];
+            int atom1 = values.x;
+            int atom2 = values.y;
+            int x = atom1/ComputeContext::TileSize;
+            int offset1 = atom1-x*ComputeContext::TileSize;
+            int y = atom2/ComputeContext::TileSize;
+            int offset2 = atom2-y*ComputeContext::TileSize;
+            if (x == y) {
+                int index = findTileIndex(x, y);
+                polarizationBits.push_back(mm_int2(index+offset1, 1<<offset2));
+                polarizationBits.push_back(mm_int2(index+offset2, 1<<offset1));
+            }
+            else if (x > y)
+                polarizationBits.push_back(mm_int2(findTileIndex(x, y)+offset1, 1<<offset2));
+            else
+                polarizationBits.push_back(mm_int2(findTileIndex(y, x)+offset2, 1<<offset1));
+        }
+    });
+    cc.getThreadPool().waitForThreads();
     covalentFlags.resize(nb.getExclusions().getSize());
     vector<mm_int2> covalentFlagsVec(nb.getExclusions().getSize(), mm_int2(0, 0));
-    for (mm_int4 values : covalentFlagValues) {
-        int atom1 = values.x;
-        int atom2 = values.y;
-        int value = values.z;
-        int x = atom1/ComputeContext::TileSize;
-        int offset1 = atom1-x*ComputeContext::TileSize;
-        int y = atom2/ComputeContext::TileSize;
-        int offset2 = atom2-y*ComputeContext::TileSize;
-        int f1 = (value == 0 || value == 1 ? 1 : 0);
-        int f2 = (value == 0 || value == 2 ? 1 : 0);
-        if (x == y) {
-            int index = exclusionTileMap[make_pair(x, y)]*ComputeContext::TileSize;
-            covalentFlagsVec[index+offset1].x |= f1<<offset2;
-            covalentFlagsVec[index+offset1].y |= f2<<offset2;
-            covalentFlagsVec[index+offset2].x |= f1<<offset1;
-            covalentFlagsVec[index+offset2].y |= f2<<offset1;
-        }
-        else if (x > y) {
-            int index = exclusionTileMap[make_pair(x, y)]*ComputeContext::TileSize;
-            covalentFlagsVec[index+offset1].x |= f1<<offset2;
-            covalentFlagsVec[index+offset1].y |= f2<<offset2;
-        }
-        else {
-            int index = exclusionTileMap[make_pair(y, x)]*ComputeContext::TileSize;
-            covalentFlagsVec[index+offset2].x |= f1<<offset1;
-            covalentFlagsVec[index+offset2].y |= f2<<offset1;
+    for (auto& bits : threadCovalentBits)
+        for (mm_int4 b : bits) {
+            covalentFlagsVec[b.x].x |= b.y;
+            covalentFlagsVec[b.x].y |= b.z;
         }
-    }
     covalentFlags.upload(covalentFlagsVec);
-    
-    // Do the same for the polarization flags.
-    
     polarizationGroupFlags.resize(nb.getExclusions().getSize());
     vector<unsigned int> polarizationGroupFlagsVec(nb.getExclusions().getSize(), 0);
-    for (mm_int2 values : polarizationFlagValues) {
-        int atom1 = values.x;
-        int atom2 = values.y;
-        int x = atom1/ComputeContext::TileSize;
-        int offset1 = atom1-x*ComputeContext::TileSize;
-        int y = atom2/ComputeContext::TileSize;
-        int offset2 = atom2-y*ComputeContext::TileSize;
-        if (x == y) {
-            int index = exclusionTileMap[make_pair(x, y)]*ComputeContext::TileSize;
-            polarizationGroupFlagsVec[index+offset1] |= 1<<offset2;
-            polarizationGroupFlagsVec[index+offset2] |= 1<<offset1;
-        }
-        else if (x > y) {
-            int index = exclusionTileMap[make_pair(x, y)]*ComputeContext::TileSize;
-            polarizationGroupFlagsVec[index+offset1] |= 1<<offset2;
-        }
-        else {
-            int index = exclusionTileMap[make_pair(y, x)]*ComputeContext::TileSize;
-            polarizationGroupFlagsVec[index+offset2] |= 1<<offset1;
-        }
-    }
+    for (auto& bits : threadPolarizationBits)
+        for (mm_int2 b : bits)
+            polarizationGroupFlagsVec[b.x] |= b.y;
     polarizationGroupFlags.upload(polarizationGroupFlagsVec);
 }
 
@@ -1078,13 +1428,16 @@ double CommonCalcAmoebaMultipoleForceKernel::execute(ContextImpl& context, bool
     electrostaticsKernel->setArg(8, numTileIndices);
     computeFixedFieldKernel->setArg(6, startTileIndex);
     computeFixedFieldKernel->setArg(7, numTileIndices);
-    if (!pmeGrid1.isInitialized()) {
+    if (!usePME) {
         // Compute induced dipoles.
         
         if (gkKernel != NULL)
             gkKernel->computeBornRadii(torque, labDipoles, labQuadrupoles, inducedDipole, inducedDipolePolar, dampingAndThole, covalentFlags, polarizationGroupFlags);
         computeFixedFieldKernel->execute(numForceThreadBlocks*fixedFieldThreads, fixedFieldThreads);
+        if (fieldReducer != NULL)
+            fieldReducer->reduce(cc, {&field, &fieldPolar});
         recordInducedDipolesKernel->execute(cc.getNumAtoms());
+        predictInducedDipoles();
         
         // Iterate until the dipoles converge.
         
@@ -1092,10 +1445,11 @@ double CommonCalcAmoebaMultipoleForceKernel::execute(ContextImpl& context, bool
             computeExtrapolatedDipoles();
         for (int i = 0; i < maxInducedIterations; i++) {
             computeInducedField();
-            bool converged = iterateDipolesByDIIS(i);
+            bool converged = (usePCG ? iterateDipolesByPCG(i) : iterateDipolesByDIIS(i));
             if (converged)
                 break;
         }
+        recordInducedDipoleHistory();
         
         // Compute electrostatic force.
         
@@ -1104,98 +1458,124 @@ double CommonCalcAmoebaMultipoleForceKernel::execute(ContextImpl& context, bool
             gkKernel->finishComputation();
     }
     else {
-        // Compute reciprocal box vectors.
+        unsigned int maxTiles = nb.getInteractingTiles().getSize();
+        if (pmeGrid1.isInitialized()) {
+            // Compute reciprocal box vectors.
         
-        Vec3 a, b, c;
-        cc.getPeriodicBoxVectors(a, b, c);
-        double determinant = a[0]*b[1]*c[2];
-        double scale = 1.0/determinant;
-        mm_double4 recipBoxVectors[3];
-        recipBoxVectors[0] = mm_double4(b[1]*c[2]*scale, 0, 0, 0);
-        recipBoxVectors[1] = mm_double4(-b[0]*c[2]*scale, a[0]*c[2]*scale, 0, 0);
-        recipBoxVectors[2] = mm_double4((b[0]*c[1]-b[1]*c[0])*scale, -a[0]*c[1]*scale, a[0]*b[1]*scale, 0);
-        if (cc.getUseDoublePrecision()) {
-            mm_double4 boxVectors[] = {mm_double4(a[0], a[1], a[2], 0), mm_double4(b[0], b[1], b[2], 0), mm_double4(c[0], c[1], c[2], 0)};
-            pmeConvolutionKernel->setArg(4, mm_double4(a[0], b[1], c[2], 0));
-            for (int i = 0; i < 3; i++) {
-                pmeTransformMultipolesKernel->setArg(4+i, recipBoxVectors[i]);
-                pmeTransformPotentialKernel->setArg(2+i, recipBoxVectors[i]);
-                pmeSpreadFixedMultipolesKernel->setArg(4+i, boxVectors[i]);
-                pmeSpreadFixedMultipolesKernel->setArg(7+i, recipBoxVectors[i]);
-                pmeSpreadInducedDipolesKernel->setArg(4+i, boxVectors[i]);
-                pmeSpreadInducedDipolesKernel->setArg(7+i, recipBoxVectors[i]);
-                pmeConvolutionKernel->setArg(5+i, recipBoxVectors[i]);
-                pmeFixedPotentialKernel->setArg(6+i, boxVectors[i]);
-                pmeFixedPotentialKernel->setArg(9+i, recipBoxVectors[i]);
-                pmeInducedPotentialKernel->setArg(5+i, boxVectors[i]);
-                pmeInducedPotentialKernel->setArg(8+i, recipBoxVectors[i]);
-                pmeFixedForceKernel->setArg(10+i, recipBoxVectors[i]);
-                pmeInducedForceKernel->setArg(15+i, recipBoxVectors[i]);
-                if (polarizationType != AmoebaMultipoleForce::Direct)
-                    pmeRecordInducedFieldDipolesKernel->setArg(6+i, recipBoxVectors[i]);
+            Vec3 a, b, c;
+            cc.getPeriodicBoxVectors(a, b, c);
+            double determinant = a[0]*b[1]*c[2];
+            double scale = 1.0/determinant;
+            mm_double4 recipBoxVectors[3];
+            recipBoxVectors[0] = mm_double4(b[1]*c[2]*scale, 0, 0, 0);
+            recipBoxVectors[1] = mm_double4(-b[0]*c[2]*scale, a[0]*c[2]*scale, 0, 0);
+            recipBoxVectors[2] = mm_double4((b[0]*c[1]-b[1]*c[0])*scale, -a[0]*c[1]*scale, a[0]*b[1]*scale, 0);
+            if (cc.getUseDoublePrecision()) {
+                mm_double4 boxVectors[] = {mm_double4(a[0], a[1], a[2], 0), mm_double4(b[0], b[1], b[2], 0), mm_double4(c[0], c[1], c[2], 0)};
+                pmeConvolutionKernel->setArg(4, mm_double4(a[0], b[1], c[2], 0));
+                if (hasInducedGrid)
+                    inducedPmeConvolutionKernel->setArg(4, mm_double4(a[0], b[1], c[2], 0));
+                for (int i = 0; i < 3; i++) {
+                    pmeTransformMultipolesKernel->setArg(4+i, recipBoxVectors[i]);
+                    pmeTransformPotentialKernel->setArg(2+i, recipBoxVectors[i]);
+                    pmeSpreadFixedMultipolesKernel->setArg(4+i, boxVectors[i]);
+                    pmeSpreadFixedMultipolesKernel->setArg(7+i, recipBoxVectors[i]);
+                    pmeSpreadInducedDipolesKernel->setArg(4+i, boxVectors[i]);
+                    pmeSpreadInducedDipolesKernel->setArg(7+i, recipBoxVectors[i]);
+                    pmeConvolutionKernel->setArg(5+i, recipBoxVectors[i]);
+                    pmeFixedPotentialKernel->setArg(6+i, boxVectors[i]);
+                    pmeFixedPotentialKernel->setArg(9+i, recipBoxVectors[i]);
+                    pmeInducedPotentialKernel->setArg(5+i, boxVectors[i]);
+                    pmeInducedPotentialKernel->setArg(8+i, recipBoxVectors[i]);
+                    if (hasInducedGrid) {
+                        inducedPmeSpreadKernel->setArg(4+i, boxVectors[i]);
+                        inducedPmeSpreadKernel->setArg(7+i, recipBoxVectors[i]);
+                        inducedPmeConvolutionKernel->setArg(5+i, recipBoxVectors[i]);
+                        inducedPmePotentialKernel->setArg(5+i, boxVectors[i]);
+                        inducedPmePotentialKernel->setArg(8+i, recipBoxVectors[i]);
+                    }
+                    pmeFixedForceKernel->setArg(10+i, recipBoxVectors[i]);
+                    pmeInducedForceKernel->setArg(15+i, recipBoxVectors[i]);
+                    if (polarizationType != AmoebaMultipoleForce::Direct)
+                        pmeRecordInducedFieldDipolesKernel->setArg(6+i, recipBoxVectors[i]);
+                }
             }
-        }
-        else {
-            mm_float4 recipBoxVectorsFloat[3];
-            recipBoxVectorsFloat[0] = mm_float4((float) recipBoxVectors[0].x, 0, 0, 0);
-            recipBoxVectorsFloat[1] = mm_float4((float) recipBoxVectors[1].x, (float) recipBoxVectors[1].y, 0, 0);
-            recipBoxVectorsFloat[2] = mm_float4((float) recipBoxVectors[2].x, (float) recipBoxVectors[2].y, (float) recipBoxVectors[2].z, 0);
-            mm_float4 boxVectors[] = {mm_float4(a[0], a[1], a[2], 0), mm_float4(b[0], b[1], b[2], 0), mm_float4(c[0], c[1], c[2], 0)};
-            pmeConvolutionKernel->setArg(4, mm_float4(a[0], b[1], c[2], 0));
-            for (int i = 0; i < 3; i++) {
-                pmeTransformMultipolesKernel->setArg(4+i, recipBoxVectorsFloat[i]);
-                pmeTransformPotentialKernel->setArg(2+i, recipBoxVectorsFloat[i]);
-                pmeSpreadFixedMultipolesKernel->setArg(4+i, boxVectors[i]);
-                pmeSpreadFixedMultipolesKernel->setArg(7+i, recipBoxVectorsFloat[i]);
-                pmeSpreadInducedDipolesKernel->setArg(4+i, boxVectors[i]);
-                pmeSpreadInducedDipolesKernel->setArg(7+i, recipBoxVectorsFloat[i]);
-                pmeConvolutionKernel->setArg(5+i, recipBoxVectorsFloat[i]);
-                pmeFixedPotentialKernel->setArg(6+i, boxVectors[i]);
-                pmeFixedPotentialKernel->setArg(9+i, recipBoxVectorsFloat[i]);
-                pmeInducedPotentialKernel->setArg(5+i, boxVectors[i]);
-                pmeInducedPotentialKernel->setArg(8+i, recipBoxVectorsFloat[i]);
-                pmeFixedForceKernel->setArg(10+i, recipBoxVectorsFloat[i]);
-                pmeInducedForceKernel->setArg(15+i, recipBoxVectorsFloat[i]);
-                if (polarizationType != AmoebaMultipoleForce::Direct)
-                    pmeRecordInducedFieldDipolesKernel->setArg(6+i, recipBoxVectorsFloat[i]);
+            else {
+                mm_float4 recipBoxVectorsFloat[3];
+                recipBoxVectorsFloat[0] = mm_float4((float) recipBoxVectors[0].x, 0, 0, 0);
+                recipBoxVectorsFloat[1] = mm_float4((float) recipBoxVectors[1].x, (float) recipBoxVectors[1].y, 0, 0);
+                recipBoxVectorsFloat[2] = mm_float4((float) recipBoxVectors[2].x, (float) recipBoxVectors[2].y, (float) recipBoxVectors[2].z, 0);
+                mm_float4 boxVectors[] = {mm_float4(a[0], a[1], a[2], 0), mm_float4(b[0], b[1], b[2], 0), mm_float4(c[0], c[1], c[2], 0)};
+                pmeConvolutionKernel->setArg(4, mm_float4(a[0], b[1], c[2], 0));
+                if (hasInducedGrid)
+                    inducedPmeConvolutionKernel->setArg(4, mm_float4(a[0], b[1], c[2], 0));
+                for (int i = 0; i < 3; i++) {
+                    pmeTransformMultipolesKernel->setArg(4+i, recipBoxVectorsFloat[i]);
+                    pmeTransformPotentialKernel->setArg(2+i, recipBoxVectorsFloat[i]);
+                    pmeSpreadFixedMultipolesKernel->setArg(4+i, boxVectors[i]);
+                    pmeSpreadFixedMultipolesKernel->setArg(7+i, recipBoxVectorsFloat[i]);
+                    pmeSpreadInducedDipolesKernel->setArg(4+i, boxVectors[i]);
+                    pmeSpreadInducedDipolesKernel->setArg(7+i, recipBoxVectorsFloat[i]);
+                    pmeConvolutionKernel->setArg(5+i, recipBoxVectorsFloat[i]);
+                    pmeFixedPotentialKernel->setArg(6+i, boxVectors[i]);
+                    pmeFixedPotentialKernel->setArg(9+i, recipBoxVectorsFloat[i]);
+                    pmeInducedPotentialKernel->setArg(5+i, boxVectors[i]);
+                    pmeInducedPotentialKernel->setArg(8+i, recipBoxVectorsFloat[i]);
+                    if (hasInducedGrid) {
+                        inducedPmeSpreadKernel->setArg(4+i, boxVectors[i]);
+                        inducedPmeSpreadKernel->setArg(7+i, recipBoxVectorsFloat[i]);
+                        inducedPmeConvolutionKernel->setArg(5+i, recipBoxVectorsFloat[i]);
+                        inducedPmePotentialKernel->setArg(5+i, boxVectors[i]);
+                        inducedPmePotentialKernel->setArg(8+i, recipBoxVectorsFloat[i]);
+                    }
+                    pmeFixedForceKernel->setArg(10+i, recipBoxVectorsFloat[i]);
+                    pmeInducedForceKernel->setArg(15+i, recipBoxVectorsFloat[i]);
+                    if (polarizationType != AmoebaMultipoleForce::Direct)
+                        pmeRecordInducedFieldDipolesKernel->setArg(6+i, recipBoxVectorsFloat[i]);
+                }
             }
-        }
 
-        // Reciprocal space calculation.
+            // Reciprocal space calculation.  If there is a separate PME queue, this overlaps with the
+            // direct space field, and the two are accumulated into the (autocleared) field buffers.
         
-        unsigned int maxTiles = nb.getInteractingTiles().getSize();
-        pmeTransformMultipolesKernel->execute(cc.getNumAtoms());
-        pmeSpreadFixedMultipolesKernel->execute(cc.getNumAtoms());
-        if (useFixedPointChargeSpreading())
-            pmeFinishSpreadChargeKernel->execute(pmeGrid1.getSize());
-        fft->execFFT(pmeGrid1, pmeGrid2, true);
-        pmeConvolutionKernel->execute(gridSizeX*gridSizeY*gridSizeZ, 256);
-        fft->execFFT(pmeGrid2, pmeGrid1, false);
-        pmeFixedPotentialKernel->execute(cc.getNumAtoms());
-        pmeTransformPotentialKernel->setArg(0, pmePhi);
-        pmeTransformPotentialKernel->execute(cc.getNumAtoms());
-        pmeFixedForceKernel->execute(cc.getNumAtoms());
+            if (usePmeQueue) {
+                pmeStartEvent->enqueue();
+                pmeStartEvent->queueWait(pmeQueue);
+                cc.setCurrentQueue(pmeQueue);
+            }
+            pmeTransformMultipolesKernel->execute(cc.getNumAtoms());
+            pmeSpreadFixedMultipolesKernel->execute(cc.getNumAtoms());
+            if (useFixedPointChargeSpreading())
+                pmeFinishSpreadChargeKernel->execute(pmeGrid1.getSize());
+            fft->execFFT(pmeGrid1, pmeGrid2, true);
+            pmeConvolutionKernel->execute(gridSizeX*gridSizeY*gridSizeZ, 256);
+            fft->execFFT(pmeGrid2, pmeGrid1, false);
+            pmeFixedPotentialKernel->execute(cc.getNumAtoms());
+            pmeTransformPotentialKernel->setArg(0, pmePhi);
+            pmeTransformPotentialKernel->execute(cc.getNumAtoms());
+            pmeFixedForceKernel->execute(cc.getNumAtoms());
+            if (usePmeQueue) {
+                pmeSyncEvent->enqueue();
+                cc.restoreDefaultQueue();
+            }
+        }
 
         // Direct space calculation.
 
         setPeriodicBoxArgs(cc, computeFixedFieldKernel, 10);
         computeFixedFieldKernel->setArg(15, maxTiles);
         computeFixedFieldKernel->execute(numForceThreadBlocks*fixedFieldThreads, fixedFieldThreads);
+        if (usePmeQueue)
+            pmeSyncEvent->queueWait(cc.getCurrentQueue());
+        if (fieldReducer != NULL)
+            fieldReducer->reduce(cc, {&field, &fieldPolar});
         recordInducedDipolesKernel->execute(cc.getNumAtoms());
+        predictInducedDipoles();
 
         // Reciprocal space calculation for the induced dipoles.
 
-        if (useFixedPointChargeSpreading())
-            cc.clearBuffer(pmeGridLong);
-        else
-            cc.clearBuffer(pmeGrid1);
-        pmeSpreadInducedDipolesKernel->execute(cc.getNumAtoms());
-        if (useFixedPointChargeSpreading())
-            pmeFinishSpreadChargeKernel->execute(pmeGrid1.getSize());
-        fft->execFFT(pmeGrid1, pmeGrid2, true);
-        pmeConvolutionKernel->execute(gridSizeX*gridSizeY*gridSizeZ, 256);
-        fft->execFFT(pmeGrid2, pmeGrid1, false);
-        pmeInducedPotentialKernel->execute(cc.getNumAtoms());
+        if (pmeGrid1.isInitialized())
+            computeInducedPotentialFromGrid(hasInducedGrid);
         
         // Iterate until the dipoles converge.
         
@@ -1203,19 +1583,28 @@ double CommonCalcAmoebaMultipoleForceKernel::execute(ContextImpl& context, bool
             computeExtrapolatedDipoles();
         for (int i = 0; i < maxInducedIterations; i++) {
             computeInducedField();
-            bool converged = iterateDipolesByDIIS(i);
+            bool converged = (usePCG ? iterateDipolesByPCG(i) : iterateDipolesByDIIS(i));
             if (converged)
                 break;
         }
+        recordInducedDipoleHistory();
+
+        // If the dipoles were iterated on a coarser grid, recompute their reciprocal space potential
+        // on the full grid so the forces are as accurate as for the permanent multipoles.
+
+        if (hasInducedGrid)
+            computeInducedPotentialFromGrid(false);
         
         // Compute electrostatic force.
         
         setPeriodicBoxArgs(cc, electrostaticsKernel, 11);
         electrostaticsKernel->setArg(16, maxTiles);
         electrostaticsKernel->execute(numForceThreadBlocks*electrostaticsThreads, electrostaticsThreads);
-        pmeTransformPotentialKernel->setArg(0, pmePhidp);
-        pmeTransformPotentialKernel->execute(cc.getNumAtoms());
-        pmeInducedForceKernel->execute(cc.getNumAtoms());
+        if (pmeGrid1.isInitialized()) {
+            pmeTransformPotentialKernel->setArg(0, pmePhidp);
+            pmeTransformPotentialKernel->execute(cc.getNumAtoms());
+            pmeInducedForceKernel->execute(cc.getNumAtoms());
+        }
     }
     
     // If using extrapolated polarization, add in force contributions from µ(m) T µ(n).
@@ -1234,7 +1623,7 @@ double CommonCalcAmoebaMultipoleForceKernel::execute(ContextImpl& context, bool
 
     // Correction for the neutralizing plasma.
 
-    if (usePME) {
+    if (pmeGrid1.isInitialized()) {
         Vec3 a, b, c;
         cc.getPeriodicBoxVectors(a, b, c);
         double volume = a[0] * b[1] * c[2];
@@ -1269,19 +1658,23 @@ void CommonCalcAmoebaMultipoleForceKernel::computeInducedField() {
             cc.clearBuffer(inducedDipoleFieldGradientGkPolar);
         }
     }
+    bool overlapPme = (pmeGrid1.isInitialized() && usePmeQueue);
+    if (overlapPme) {
+        // Compute the reciprocal space potential on the PME queue while the direct space field is computed.
+
+        pmeStartEvent->enqueue();
+        pmeStartEvent->queueWait(pmeQueue);
+        cc.setCurrentQueue(pmeQueue);
+        computeInducedPotentialFromGrid(hasInducedGrid);
+        pmeSyncEvent->enqueue();
+        cc.restoreDefaultQueue();
+    }
     computeInducedFieldKernel->execute(numForceThreadBlocks*inducedFieldThreads, inducedFieldThreads);
     if (pmeGrid1.isInitialized()) {
-        if (useFixedPointChargeSpreading())
-            cc.clearBuffer(pmeGridLong);
+        if (overlapPme)
+            pmeSyncEvent->queueWait(cc.getCurrentQueue());
         else
-            cc.clearBuffer(pmeGrid1);
-        pmeSpreadInducedDipolesKernel->execute(cc.getNumAtoms());
-        if (useFixedPointChargeSpreading())
-            pmeFinishSpreadChargeKernel->execute(pmeGrid1.getSize());
-        fft->execFFT(pmeGrid1, pmeGrid2, true);
-        pmeConvolutionKernel->execute(gridSizeX*gridSizeY*gridSizeZ, 256);
-        fft->execFFT(pmeGrid2, pmeGrid1, false);
-        pmeInducedPotentialKernel->execute(cc.getNumAtoms());
+            computeInducedPotentialFromGrid(hasInducedGrid);
         if (polarizationType == AmoebaMultipoleForce::Extrapolated) {
             pmeRecordInducedFieldDipolesKernel->execute(cc.getNumAtoms());
         }
@@ -1289,6 +1682,44 @@ void CommonCalcAmoebaMultipoleForceKernel::computeInducedField() {
             pmeRecordInducedFieldDipolesKernel->execute(cc.getNumAtoms());
         }
     }
+    if (fieldReducer != NULL)
+        fieldReducer->reduce(cc, {&inducedField, &inducedFieldPolar});
+}
+
+void CommonCalcAmoebaMultipoleForceKernel::computeInducedPotentialFromGrid(bool useInducedGrid) {
+    if (useInducedGrid) {
+        if (useFixedPointChargeSpreading())
+            cc.clearBuffer(inducedPmeGridLong);
+        else
+            cc.clearBuffer(inducedPmeGrid1);
+        inducedPmeSpreadKernel->execute(cc.getNumAtoms());
+        if (useFixedPointChargeSpreading())
+            inducedPmeFinishSpreadKernel->execute(inducedPmeGrid1.getSize());
+        inducedFft->execFFT(inducedPmeGrid1, inducedPmeGrid2, true);
+        inducedPmeConvolutionKernel->execute(inducedGridSizeX*inducedGridSizeY*inducedGridSizeZ, 256);
+        inducedFft->execFFT(inducedPmeGrid2, inducedPmeGrid1, false);
+        inducedPmePotentialKernel->execute(cc.getNumAtoms());
+        return;
+    }
+    if (useFixedPointChargeSpreading())
+        cc.clearBuffer(pmeGridLong);
+    else
+        cc.clearBuffer(pmeGrid1);
+    pmeSpreadInducedDipolesKernel->execute(cc.getNumAtoms());
+    if (useFixedPointChargeSpreading())
+        pmeFinishSpreadChargeKernel->execute(pmeGrid1.getSize());
+    fft->execFFT(pmeGrid1, pmeGrid2, true);
+    pmeConvolutionKernel->execute(gridSizeX*gridSizeY*gridSizeZ, 256);
+    fft->execFFT(pmeGrid2, pmeGrid1, false);
+    pmeInducedPotentialKernel->execute(cc.getNumAtoms());
+}
+
+bool CommonCalcAmoebaMultipoleForceKernel::hasConverged(bool converged) {
+    // When running on multiple devices, they must all stop iterating at the same time.
+
+    if (fieldReducer != NULL)
+        return fieldReducer->agreeOnConvergence(cc, converged);
+    return converged;
 }
 
 bool CommonCalcAmoebaMultipoleForceKernel::iterateDipolesByDIIS(int iteration) {
@@ -1342,7 +1773,7 @@ bool CommonCalcAmoebaMultipoleForceKernel::iterateDipolesByDIIS(int iteration) {
         total1 += errors[j].x;
         total2 += errors[j].y;
     }
-    if (48.033324*sqrt(max(total1, total2)/cc.getNumAtoms()) < inducedEpsilon)
+    if (hasConverged(48.033324*sqrt(max(total1, total2)/cc.getNumAtoms()) < inducedEpsilon))
         return true;
     
     // Compute the dipoles.
@@ -1363,6 +1794,107 @@ bool CommonCalcAmoebaMultipoleForceKernel::iterateDipolesByDIIS(int iteration) {
     return false;
 }
 
+bool CommonCalcAmoebaMultipoleForceKernel::iterateDipolesByPCG(int iteration) {
+    // While iterating, inducedDipole holds the search direction so that computeInducedField()
+    // gives the matrix-vector product.  The current estimate of the dipoles is kept in pcgDipole.
+
+    mm_float2* errors = (mm_float2*) cc.getPinnedBuffer();
+    bool lastIteration = (iteration == maxInducedIterations-1);
+    if (iteration == 0) {
+        initPCGKernel->execute(cc.getNumThreadBlocks()*64, 64);
+        inducedDipoleErrors.download(errors, false);
+        syncEvent->enqueue();
+    }
+    else {
+        computePCGProductsKernel->execute(cc.getNumThreadBlocks()*64, 64);
+        updatePCGKernel->setArg(11, iteration);
+        updatePCGKernel->execute(cc.getNumThreadBlocks()*64, 64);
+        inducedDipoleErrors.download(errors, false);
+        syncEvent->enqueue();
+        if (!lastIteration) {
+            updatePCGDirectionKernel->setArg(5, iteration);
+            updatePCGDirectionKernel->execute(cc.getNumThreadBlocks()*64, 64);
+        }
+    }
+    
+    // Determine whether the iteration has converged.
+    
+    syncEvent->wait();
+    double total1 = 0.0, total2 = 0.0;
+    for (int j = 0; j < inducedDipoleErrors.getSize(); j++) {
+        total1 += errors[j].x;
+        total2 += errors[j].y;
+    }
+    bool converged = hasConverged(48.033324*sqrt(max(total1, total2)/cc.getNumAtoms()) < inducedEpsilon);
+    if (iteration == 0) {
+        // The initial dipoles are still in place, along with their field.
+
+        if (converged || lastIteration)
+            return true;
+        pcgResidual.copyTo(inducedDipole);
+        pcgResidualPolar.copyTo(inducedDipolePolar);
+        return false;
+    }
+    if (converged || lastIteration) {
+        // Restore the solution and compute its field, so the reciprocal space potentials
+        // used for the forces match the final dipoles.
+
+        pcgDipole.copyTo(inducedDipole);
+        pcgDipolePolar.copyTo(inducedDipolePolar);
+        computeInducedField();
+        return true;
+    }
+    return false;
+}
+
+void CommonCalcAmoebaMultipoleForceKernel::predictInducedDipoles() {
+    if (predictorHistoryLength == 0)
+        return;
+
+    // Discard the history if the positions have been set since it was recorded.
+
+    if (cc.getPositionsSetCount() != predictorPositionsSetCount) {
+        predictorPositionsSetCount = cc.getPositionsSetCount();
+        predictorHistorySize = 0;
+    }
+
+    // The history can only be used if it covers the immediately preceding steps.  The extended
+    // Lagrangian predictor only needs the newest auxiliary dipoles.
+
+    int requiredSize = (auxiliaryCoefficients.isInitialized() ? 1 : predictorHistoryLength);
+    if (predictorHistorySize >= requiredSize && cc.getStepCount() == predictorLastStep+1) {
+        predictDipolesKernel->setArg(6, predictorNewestSlot);
+        predictDipolesKernel->execute(3*cc.getNumAtoms());
+    }
+}
+
+void CommonCalcAmoebaMultipoleForceKernel::recordInducedDipoleHistory() {
+    if (predictorHistoryLength == 0)
+        return;
+    long long step = cc.getStepCount();
+    if (predictorHistorySize == 0 || step != predictorLastStep) {
+        if (predictorHistorySize > 0 && step != predictorLastStep+1)
+            predictorHistorySize = 0;
+        predictorNewestSlot = (predictorNewestSlot+1)%predictorHistoryLength;
+        predictorHistorySize = min(predictorHistorySize+1, predictorHistoryLength);
+    }
+
+    // If the forces are being recomputed for the same step, this replaces the newest entry.
+
+    predictorLastStep = step;
+    if (auxiliaryCoefficients.isInitialized()) {
+        // Until the history is complete, the auxiliary dipoles are restarted from the current ones.
+
+        propagateAuxiliaryDipolesKernel->setArg(6, predictorNewestSlot);
+        propagateAuxiliaryDipolesKernel->setArg(7, (int) (predictorHistorySize == predictorHistoryLength));
+        propagateAuxiliaryDipolesKernel->execute(3*cc.getNumAtoms());
+    }
+    else {
+        recordDipoleHistoryKernel->setArg(4, predictorNewestSlot);
+        recordDipoleHistoryKernel->execute(3*cc.getNumAtoms());
+    }
+}
+
 void CommonCalcAmoebaMultipoleForceKernel::computeExtrapolatedDipoles() {
     // Start by storing the direct dipoles as PT0
 
@@ -1490,49 +2022,165 @@ void CommonCalcAmoebaMultipoleForceKernel::getTotalDipoles(ContextImpl& context,
             totalDipoleVecY = labDipoleVec[3*i+1] + inducedDipoleVec[3*i+1];
             totalDipoleVecZ = labDipoleVec[3*i+2] + inducedDipoleVec[3*i+2];
             dipoles[order[i]] = Vec3(totalDipoleVecX, totalDipoleVecY, totalDipoleVecZ);
-        }
-    }
-}
-
-void CommonCalcAmoebaMultipoleForceKernel::getElectrostaticPotential(ContextImpl& context, const vector<Vec3>& inputGrid, vector<double>& outputElectrostaticPotential) {
-    ContextSelector selector(cc);
-    ensureMultipolesValid(context);
-    int numPoints = inputGrid.size();
-    int elementSize = (cc.getUseDoublePrecision() ? sizeof(double) : sizeof(float));
-    ComputeArray points, potential;
-    points.initialize(cc, numPoints, 4*elementSize, "points");
-    potential.initialize(cc, numPoints, elementSize, "potential");
-    
-    // Copy the grid points to the GPU.
-    
+        }
+    }
+}
+
+void CommonCalcAmoebaMultipoleForceKernel::uploadPotentialPoints(const vector<Vec3>& inputGrid, int start, int numPoints) {
+    if (!potentialPoints.isInitialized()) {
+        int elementSize = (cc.getUseDoublePrecision() ? sizeof(double) : sizeof(float));
+        int batchSize = min((int) inputGrid.size(), (int) PotentialBatchSize);
+        potentialPoints.initialize(cc, batchSize, 4*elementSize, "potentialPoints");
+        potentialValues.initialize(cc, batchSize, elementSize, "potentialValues");
+    }
+    else if (potentialPoints.getSize() < numPoints) {
+        potentialPoints.resize(numPoints);
+        potentialValues.resize(numPoints);
+    }
     if (cc.getUseDoublePrecision()) {
         vector<mm_double4> p(numPoints);
         for (int i = 0; i < numPoints; i++)
-            p[i] = mm_double4(inputGrid[i][0], inputGrid[i][1], inputGrid[i][2], 0);
-        points.upload(p);
+            p[i] = mm_double4(inputGrid[start+i][0], inputGrid[start+i][1], inputGrid[start+i][2], 0);
+        potentialPoints.uploadSubArray(p.data(), 0, numPoints);
     }
     else {
         vector<mm_float4> p(numPoints);
         for (int i = 0; i < numPoints; i++)
-            p[i] = mm_float4((float) inputGrid[i][0], (float) inputGrid[i][1], (float) inputGrid[i][2], 0);
-        points.upload(p);
+            p[i] = mm_float4((float) inputGrid[start+i][0], (float) inputGrid[start+i][1], (float) inputGrid[start+i][2], 0);
+        potentialPoints.uploadSubArray(p.data(), 0, numPoints);
     }
-    
-    // Compute the potential.
-    
-    computePotentialKernel->setArg(4, points);
-    computePotentialKernel->setArg(5, potential);
-    computePotentialKernel->setArg(6, numPoints);
-    setPeriodicBoxArgs(cc, computePotentialKernel, 7);
-    computePotentialKernel->execute(numPoints, 128);
-    outputElectrostaticPotential.resize(numPoints);
+}
+
+void CommonCalcAmoebaMultipoleForceKernel::downloadPotential(vector<double>& outputElectrostaticPotential, int start, int numPoints) {
     if (cc.getUseDoublePrecision())
-        potential.download(outputElectrostaticPotential);
+        potentialValues.downloadSubArray(&outputElectrostaticPotential[start], 0, numPoints);
     else {
         vector<float> p(numPoints);
-        potential.download(p);
+        potentialValues.downloadSubArray(p.data(), 0, numPoints);
         for (int i = 0; i < numPoints; i++)
-            outputElectrostaticPotential[i] = p[i];
+            outputElectrostaticPotential[start+i] = p[i];
+    }
+}
+
+void CommonCalcAmoebaMultipoleForceKernel::getElectrostaticPotential(ContextImpl& context, const vector<Vec3>& inputGrid, vector<double>& outputElectrostaticPotential) {
+    ContextSelector selector(cc);
+    ensureMultipolesValid(context);
+    int numPoints = inputGrid.size();
+    outputElectrostaticPotential.resize(numPoints);
+    if (numPoints == 0)
+        return;
+
+    // Process the points in batches, so very large grids do not need to fit on the device at once.
+
+    for (int start = 0; start < numPoints; start += PotentialBatchSize) {
+        int batchSize = min(numPoints-start, (int) PotentialBatchSize);
+        uploadPotentialPoints(inputGrid, start, batchSize);
+        computePotentialKernel->setArg(4, potentialPoints);
+        computePotentialKernel->setArg(5, potentialValues);
+        computePotentialKernel->setArg(6, batchSize);
+        setPeriodicBoxArgs(cc, computePotentialKernel, 7);
+        computePotentialKernel->execute(batchSize, 128);
+        downloadPotential(outputElectrostaticPotential, start, batchSize);
+    }
+}
+
+void CommonCalcAmoebaMultipoleForceKernel::getPMEElectrostaticPotential(ContextImpl& context, const vector<Vec3>& inputGrid, vector<double>& outputElectrostaticPotential) {
+    if (!usePME)
+        throw OpenMMException("getPMEElectrostaticPotential: PME is not being used");
+    ContextSelector selector(cc);
+    ensureMultipolesValid(context);
+    int numPoints = inputGrid.size();
+    outputElectrostaticPotential.resize(numPoints);
+    if (numPoints == 0)
+        return;
+
+    // Spread the fixed multipoles and induced dipoles onto the same grid.  Both kernels add to the
+    // real part, so after the convolution it holds the total reciprocal space potential.  The box
+    // vectors and fractional multipoles are still set from the last force evaluation.
+
+    if (useFixedPointChargeSpreading())
+        cc.clearBuffer(pmeGridLong);
+    else
+        cc.clearBuffer(pmeGrid1);
+    pmeSpreadFixedMultipolesKernel->execute(cc.getNumAtoms());
+    pmeSpreadInducedDipolesKernel->execute(cc.getNumAtoms());
+    if (useFixedPointChargeSpreading())
+        pmeFinishSpreadChargeKernel->execute(pmeGrid1.getSize());
+    fft->execFFT(pmeGrid1, pmeGrid2, true);
+    pmeConvolutionKernel->execute(gridSizeX*gridSizeY*gridSizeZ, 256);
+    fft->execFFT(pmeGrid2, pmeGrid1, false);
+
+    // Build a cell list for the direct space sum.  Each cell must be at least as wide as the cutoff.
+    // If there would be fewer than three cells along an axis, use a single cell so no atom is
+    // visited twice.
+
+    Vec3 a, b, c;
+    cc.getPeriodicBoxVectors(a, b, c);
+    double volume = a[0]*b[1]*c[2];
+    int numCells[3];
+    double width[] = {volume/sqrt(b.cross(c).dot(b.cross(c))), volume/sqrt(c.cross(a).dot(c.cross(a))), volume/sqrt(a.cross(b).dot(a.cross(b)))};
+    for (int i = 0; i < 3; i++) {
+        numCells[i] = (int) floor(width[i]/cutoff);
+        if (numCells[i] < 3)
+            numCells[i] = 1;
+    }
+    int totalCells = numCells[0]*numCells[1]*numCells[2];
+    if (!potentialCellRange.isInitialized())
+        potentialCellRange.initialize<mm_int2>(cc, totalCells, "potentialCellRange");
+    else if (potentialCellRange.getSize() < totalCells)
+        potentialCellRange.resize(totalCells);
+    cc.clearBuffer(potentialCellRange);
+    for (int i = 0; i < 3; i++)
+        findAtomPotentialCellsKernel->setArg(2+i, numCells[i]);
+    setPeriodicBoxArgs(cc, findAtomPotentialCellsKernel, 5);
+    findAtomPotentialCellsKernel->execute(numMultipoles);
+    potentialSort->sort(potentialAtomCells);
+    findPotentialCellRangesKernel->setArg(1, potentialCellRange);
+    findPotentialCellRangesKernel->execute(numMultipoles);
+
+    // Compute the potential of the uniform background that neutralizes a net charge, and the reciprocal
+    // box vectors.
+
+    double background = -M_PI*totalCharge/(volume*pmeAlpha*pmeAlpha);
+    double scale = 1.0/volume;
+    Vec3 recipBoxVectors[3];
+    recipBoxVectors[0] = Vec3(b[1]*c[2]*scale, 0, 0);
+    recipBoxVectors[1] = Vec3(-b[0]*c[2]*scale, a[0]*c[2]*scale, 0);
+    recipBoxVectors[2] = Vec3((b[0]*c[1]-b[1]*c[0])*scale, -a[0]*c[1]*scale, a[0]*b[1]*scale);
+    Vec3 boxVectors[] = {a, b, c};
+    if (cc.getUseDoublePrecision()) {
+        pmePotentialAtPointsKernel->setArg(4, background);
+        for (int i = 0; i < 3; i++) {
+            pmePotentialAtPointsKernel->setArg(5+i, mm_double4(boxVectors[i][0], boxVectors[i][1], boxVectors[i][2], 0));
+            pmePotentialAtPointsKernel->setArg(8+i, mm_double4(recipBoxVectors[i][0], recipBoxVectors[i][1], recipBoxVectors[i][2], 0));
+        }
+    }
+    else {
+        pmePotentialAtPointsKernel->setArg(4, (float) background);
+        for (int i = 0; i < 3; i++) {
+            pmePotentialAtPointsKernel->setArg(5+i, mm_float4((float) boxVectors[i][0], (float) boxVectors[i][1], (float) boxVectors[i][2], 0));
+            pmePotentialAtPointsKernel->setArg(8+i, mm_float4((float) recipBoxVectors[i][0], (float) recipBoxVectors[i][1], (float) recipBoxVectors[i][2], 0));
+        }
+    }
+
+    // Process the points in batches, so very large grids do not need to fit on the device at once.
+
+    for (int start = 0; start < numPoints; start += PotentialBatchSize) {
+        int batchSize = min(numPoints-start, (int) PotentialBatchSize);
+        uploadPotentialPoints(inputGrid, start, batchSize);
+        computeEwaldPotentialKernel->setArg(5, potentialCellRange);
+        computeEwaldPotentialKernel->setArg(6, potentialPoints);
+        computeEwaldPotentialKernel->setArg(7, potentialValues);
+        computeEwaldPotentialKernel->setArg(8, batchSize);
+        for (int i = 0; i < 3; i++)
+            computeEwaldPotentialKernel->setArg(9+i, numCells[i]);
+        setPeriodicBoxArgs(cc, computeEwaldPotentialKernel, 12);
+        computeEwaldPotentialKernel->execute(batchSize);
+        pmePotentialAtPointsKernel->setArg(1, potentialPoints);
+        pmePotentialAtPointsKernel->setArg(2, potentialValues);
+        pmePotentialAtPointsKernel->setArg(3, batchSize);
+        pmePotentialAtPointsKernel->execute(batchSize);
+        downloadPotential(outputElectrostaticPotential, start, batchSize);
     }
 }
 
@@ -1736,6 +2384,199 @@ void CommonCalcAmoebaMultipoleForceKernel::getPMEParameters(double& alpha, int&
     nz = gridSizeZ;
 }
 
+void CommonCalcAmoebaMultipoleForceKernel::createCheckpoint(ContextImpl& context, ostream& stream) {
+    if (predictorHistoryLength == 0)
+        return;
+    ContextSelector selector(cc);
+    int numAtoms = cc.getNumAtoms();
+    int elementSize = dipoleHistory.getElementSize();
+    int historySize = (cc.getPositionsSetCount() == predictorPositionsSetCount ? predictorHistorySize : 0);
+    stream.write((char*) &numAtoms, sizeof(int));
+    stream.write((char*) &predictorHistoryLength, sizeof(int));
+    stream.write((char*) &elementSize, sizeof(int));
+    stream.write((char*) &historySize, sizeof(int));
+    stream.write((char*) &predictorNewestSlot, sizeof(int));
+    stream.write((char*) &predictorLastStep, sizeof(long long));
+    if (historySize > 0) {
+        vector<char> buffer(dipoleHistory.getSize()*elementSize);
+        dipoleHistory.download(buffer.data());
+        stream.write(buffer.data(), buffer.size());
+        dipoleHistoryPolar.download(buffer.data());
+        stream.write(buffer.data(), buffer.size());
+    }
+}
+
+void CommonCalcAmoebaMultipoleForceKernel::loadCheckpoint(ContextImpl& context, istream& stream) {
+    ContextSelector selector(cc);
+    int numAtoms, historyLength, elementSize, historySize, newestSlot;
+    long long lastStep;
+    stream.read((char*) &numAtoms, sizeof(int));
+    stream.read((char*) &historyLength, sizeof(int));
+    stream.read((char*) &elementSize, sizeof(int));
+    stream.read((char*) &historySize, sizeof(int));
+    stream.read((char*) &newestSlot, sizeof(int));
+    stream.read((char*) &lastStep, sizeof(long long));
+    if (predictorHistoryLength == 0 || numAtoms != cc.getNumAtoms() || historyLength != predictorHistoryLength || elementSize != dipoleHistory.getElementSize())
+        return;
+    if (historySize > 0) {
+        vector<char> buffer(dipoleHistory.getSize()*elementSize);
+        stream.read(buffer.data(), buffer.size());
+        dipoleHistory.upload(buffer.data());
+        stream.read(buffer.data(), buffer.size());
+        dipoleHistoryPolar.upload(buffer.data());
+    }
+
+    // Loading the checkpoint marked the positions as having been set, but the history is still valid.
+
+    predictorHistorySize = historySize;
+    predictorNewestSlot = newestSlot;
+    predictorLastStep = lastStep;
+    predictorPositionsSetCount = cc.getPositionsSetCount();
+}
+
+/**
+ * This combines the fields computed by the kernels on different devices.  Each device downloads its
+ * partial fields into a host buffer, then every device adds up all the buffers and uploads the total.
+ * The fields are stored in fixed point, so the sum is exact and identical on every device.
+ */
+class CommonParallelCalcAmoebaMultipoleForceKernel::Reducer : public CommonCalcAmoebaMultipoleForceKernel::FieldReducer {
+public:
+    Reducer(int numContexts) : numContexts(numContexts), numWaiting(0), generation(0), converged(false), buffers(numContexts) {
+    }
+    void reduce(ComputeContext& cc, const vector<ArrayInterface*>& arrays) {
+        int index = cc.getContextIndex();
+        vector<vector<long long> >& local = buffers[index];
+        local.resize(arrays.size());
+        for (int i = 0; i < (int) arrays.size(); i++)
+            arrays[i]->download(local[i]);
+        waitForAllContexts();
+        for (int i = 0; i < (int) arrays.size(); i++) {
+            vector<long long> sum = buffers[0][i];
+            for (int j = 1; j < numContexts; j++)
+                for (int k = 0; k < (int) sum.size(); k++)
+                    sum[k] += buffers[j][i][k];
+            arrays[i]->upload(sum);
+        }
+
+        // Make sure no device overwrites its buffers while another one is still reading them.
+
+        waitForAllContexts();
+    }
+    bool agreeOnConvergence(ComputeContext& cc, bool hasConverged) {
+        if (cc.getContextIndex() == 0)
+            converged = hasConverged;
+        waitForAllContexts();
+        bool result = converged;
+        waitForAllContexts();
+        return result;
+    }
+private:
+    void waitForAllContexts() {
+        unique_lock<mutex> lock(waitMutex);
+        int currentGeneration = generation;
+        if (++numWaiting == numContexts) {
+            numWaiting = 0;
+            generation++;
+            waitCondition.notify_all();
+        }
+        else
+            waitCondition.wait(lock, [&] () { return generation != currentGeneration; });
+    }
+    int numContexts, numWaiting, generation;
+    bool converged;
+    vector<vector<vector<long long> > > buffers;
+    mutex waitMutex;
+    condition_variable waitCondition;
+};
+
+class CommonParallelCalcAmoebaMultipoleForceKernel::Task : public ComputeContext::WorkTask {
+public:
+    Task(ContextImpl& context, CommonCalcAmoebaMultipoleForceKernel& kernel, bool includeForce,
+            bool includeEnergy, double& energy) : context(context), kernel(kernel),
+            includeForce(includeForce), includeEnergy(includeEnergy), energy(energy) {
+    }
+    void execute() {
+        energy += kernel.execute(context, includeForce, includeEnergy);
+    }
+private:
+    ContextImpl& context;
+    CommonCalcAmoebaMultipoleForceKernel& kernel;
+    bool includeForce, includeEnergy;
+    double& energy;
+};
+
+CommonParallelCalcAmoebaMultipoleForceKernel::CommonParallelCalcAmoebaMultipoleForceKernel(const std::string& name, const Platform& platform, ComputeContext& cc, const vector<Kernel>& kernels) :
+        CalcAmoebaMultipoleForceKernel(name, platform), cc(cc), kernels(kernels) {
+    reducer = new Reducer(kernels.size());
+    for (int i = 0; i < (int) kernels.size(); i++)
+        getKernel(i).setFieldReducer(reducer);
+}
+
+CommonParallelCalcAmoebaMultipoleForceKernel::~CommonParallelCalcAmoebaMultipoleForceKernel() {
+    kernels.clear();
+    delete reducer;
+}
+
+void CommonParallelCalcAmoebaMultipoleForceKernel::initialize(const System& system, const AmoebaMultipoleForce& force) {
+    for (int i = 0; i < (int) kernels.size(); i++)
+        getKernel(i).initialize(system, force);
+}
+
+double CommonParallelCalcAmoebaMultipoleForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    for (int i = 0; i < cc.getNumContexts(); i++) {
+        ComputeContext::WorkThread& thread = cc.getAllContexts()[i]->getWorkThread();
+        thread.addTask(new Task(context, getKernel(i), includeForces, includeEnergy, cc.getEnergyWorkspace()));
+    }
+    return 0.0;
+}
+
+void CommonParallelCalcAmoebaMultipoleForceKernel::getLabFramePermanentDipoles(ContextImpl& context, vector<Vec3>& dipoles) {
+    getKernel(0).getLabFramePermanentDipoles(context, dipoles);
+}
+
+void CommonParallelCalcAmoebaMultipoleForceKernel::getInducedDipoles(ContextImpl& context, vector<Vec3>& dipoles) {
+    getKernel(0).getInducedDipoles(context, dipoles);
+}
+
+void CommonParallelCalcAmoebaMultipoleForceKernel::getTotalDipoles(ContextImpl& context, vector<Vec3>& dipoles) {
+    getKernel(0).getTotalDipoles(context, dipoles);
+}
+
+void CommonParallelCalcAmoebaMultipoleForceKernel::getElectrostaticPotential(ContextImpl& context, const vector<Vec3>& inputGrid, vector<double>& outputElectrostaticPotential) {
+    getKernel(0).getElectrostaticPotential(context, inputGrid, outputElectrostaticPotential);
+}
+
+void CommonParallelCalcAmoebaMultipoleForceKernel::getPMEElectrostaticPotential(ContextImpl& context, const vector<Vec3>& inputGrid, vector<double>& outputElectrostaticPotential) {
+    getKernel(0).getPMEElectrostaticPotential(context, inputGrid, outputElectrostaticPotential);
+}
+
+void CommonParallelCalcAmoebaMultipoleForceKernel::getSystemMultipoleMoments(ContextImpl& context, vector<double>& outputMultipoleMoments) {
+    getKernel(0).getSystemMultipoleMoments(context, outputMultipoleMoments);
+}
+
+void CommonParallelCalcAmoebaMultipoleForceKernel::copyParametersToContext(ContextImpl& context, const AmoebaMultipoleForce& force) {
+    for (int i = 0; i < (int) kernels.size(); i++)
+        getKernel(i).copyParametersToContext(context, force);
+}
+
+void CommonParallelCalcAmoebaMultipoleForceKernel::getPMEParameters(double& alpha, int& nx, int& ny, int& nz) const {
+    dynamic_cast<const CommonCalcAmoebaMultipoleForceKernel&>(kernels[0].getImpl()).getPMEParameters(alpha, nx, ny, nz);
+}
+
+void CommonParallelCalcAmoebaMultipoleForceKernel::createCheckpoint(ContextImpl& context, ostream& stream) {
+    getKernel(0).createCheckpoint(context, stream);
+}
+
+void CommonParallelCalcAmoebaMultipoleForceKernel::loadCheckpoint(ContextImpl& context, istream& stream) {
+    // Every device keeps its own copy of the history.
+
+    string data((istreambuf_iterator<char>(stream)), istreambuf_iterator<char>());
+    for (int i = 0; i < (int) kernels.size(); i++) {
+        stringstream deviceStream(data, ios_base::in | ios_base::binary);
+        getKernel(i).loadCheckpoint(context, deviceStream);
+    }
+}
+
 /* -------------------------------------------------------------------------- *
  *                       AmoebaGeneralizedKirkwood                            *
  * -------------------------------------------------------------------------- */
@@ -1755,7 +2596,8 @@ private:
 };
 
 CommonCalcAmoebaGeneralizedKirkwoodForceKernel::CommonCalcAmoebaGeneralizedKirkwoodForceKernel(const std::string& name, const Platform& platform, ComputeContext& cc, const System& system) :
-           CalcAmoebaGeneralizedKirkwoodForceKernel(name, platform), cc(cc), system(system), hasInitializedKernels(false) {
+           CalcAmoebaGeneralizedKirkwoodForceKernel(name, platform), cc(cc), system(system), hasInitializedKernels(false),
+           hasBornRadii(false), lastBornRadiiUpdate(0) {
 }
 
 void CommonCalcAmoebaGeneralizedKirkwoodForceKernel::initialize(const System& system, const AmoebaGeneralizedKirkwoodForce& force) {
@@ -1792,8 +2634,13 @@ void CommonCalcAmoebaGeneralizedKirkwoodForceKernel::initialize(const System& sy
         inducedFieldPolar.initialize(cc, 3*paddedNumAtoms, sizeof(long long), "gkInducedFieldPolar");
     }
     cc.addAutoclearBuffer(field);
-    cc.addAutoclearBuffer(bornSum);
     cc.addAutoclearBuffer(bornForce);
+    bornRadiiUpdateInterval = force.getBornRadiiUpdateInterval();
+    bornRadiiUpdateTolerance = force.getBornRadiiUpdateTolerance();
+    if (bornRadiiUpdateInterval > 1 && bornRadiiUpdateTolerance > 0) {
+        bornRadiiPositions.initialize(cc, cc.getPosq().getSize(), cc.getPosq().getElementSize(), "bornRadiiPositions");
+        bornRadiiUpdateFlag.initialize<int>(cc, 1, "bornRadiiUpdateFlag");
+    }
     vector<mm_float4> paramsVector(paddedNumAtoms);
     for (int i = 0; i < force.getNumParticles(); i++) {
         double charge, radius, scalingFactor, descreenRadius, neckFactor;
@@ -1835,6 +2682,16 @@ void CommonCalcAmoebaGeneralizedKirkwoodForceKernel::initialize(const System& sy
     defines["GK_FC"] = cc.doubleToString(1*(1-solventDielectric)/(0+1*solventDielectric));
     defines["GK_FD"] = cc.doubleToString(2*(1-solventDielectric)/(1+2*solventDielectric));
     defines["GK_FQ"] = cc.doubleToString(3*(1-solventDielectric)/(2+3*solventDielectric));
+    if (force.getNonbondedMethod() == AmoebaGeneralizedKirkwoodForce::CutoffNonPeriodic) {
+        defines["USE_GK_CUTOFF"] = "";
+        double cutoff = force.getCutoffDistance();
+        double taperCutoff = cutoff*0.9;
+        defines["GK_CUTOFF_SQUARED"] = cc.doubleToString(cutoff*cutoff);
+        defines["GK_TAPER_CUTOFF"] = cc.doubleToString(taperCutoff);
+        defines["GK_TAPER_C3"] = cc.doubleToString(10/pow(taperCutoff-cutoff, 3.0));
+        defines["GK_TAPER_C4"] = cc.doubleToString(15/pow(taperCutoff-cutoff, 4.0));
+        defines["GK_TAPER_C5"] = cc.doubleToString(6/pow(taperCutoff-cutoff, 5.0));
+    }
     defines["EPSILON_FACTOR"] = cc.doubleToString(ONE_4PI_EPS0);
     defines["M_PI"] = cc.doubleToString(M_PI);
     defines["ENERGY_SCALE_FACTOR"] = cc.doubleToString(ONE_4PI_EPS0/force.getSoluteDielectric());
@@ -1981,11 +2838,42 @@ void CommonCalcAmoebaGeneralizedKirkwoodForceKernel::computeBornRadii(ComputeArr
             surfaceAreaKernel->addArg(params);
             surfaceAreaKernel->addArg(bornRadii);
         }
+        if (bornRadiiUpdateFlag.isInitialized()) {
+            checkDisplacementKernel = program->createKernel("checkBornRadiiDisplacement");
+            checkDisplacementKernel->addArg(cc.getPosq());
+            checkDisplacementKernel->addArg(bornRadiiPositions);
+            checkDisplacementKernel->addArg((float) (bornRadiiUpdateTolerance*bornRadiiUpdateTolerance));
+            checkDisplacementKernel->addArg(bornRadiiUpdateFlag);
+        }
     }
+    if (!needsBornRadiiUpdate())
+        return;
+
+    // The Born sums are kept between updates, since the chain rule force needs them.
+
+    cc.clearBuffer(bornSum);
     computeBornSumKernel->setArg(3, nb.getNumTiles());
     int numForceThreadBlocks = nb.getNumForceThreadBlocks();
     computeBornSumKernel->execute(numForceThreadBlocks*computeBornSumThreads, computeBornSumThreads);
     reduceBornSumKernel->execute(cc.getNumAtoms());
+    if (bornRadiiPositions.isInitialized())
+        cc.getPosq().copyTo(bornRadiiPositions);
+    hasBornRadii = true;
+    lastBornRadiiUpdate = cc.getComputeForceCount();
+}
+
+bool CommonCalcAmoebaGeneralizedKirkwoodForceKernel::needsBornRadiiUpdate() {
+    if (!hasBornRadii || bornRadiiUpdateInterval <= 1 || cc.getAtomsWereReordered())
+        return true;
+    if (cc.getComputeForceCount()-lastBornRadiiUpdate >= bornRadiiUpdateInterval)
+        return true;
+    if (!bornRadiiUpdateFlag.isInitialized())
+        return false;
+    cc.clearBuffer(bornRadiiUpdateFlag);
+    checkDisplacementKernel->execute(cc.getNumAtoms());
+    int needsUpdate;
+    bornRadiiUpdateFlag.download(&needsUpdate);
+    return (needsUpdate != 0);
 }
 
 void CommonCalcAmoebaGeneralizedKirkwoodForceKernel::finishComputation() {
@@ -2031,6 +2919,7 @@ void CommonCalcAmoebaGeneralizedKirkwoodForceKernel::copyParametersToContext(Con
     }
     params.upload(paramsVector);
     cc.invalidateMolecules();
+    hasBornRadii = false;
 }
 
 /* -------------------------------------------------------------------------- *
@@ -2066,11 +2955,7 @@ CommonCalcAmoebaVdwForceKernel::~CommonCalcAmoebaVdwForceKernel() {
 void CommonCalcAmoebaVdwForceKernel::initialize(const System& system, const AmoebaVdwForce& force) {
     ContextSelector selector(cc);
     int paddedNumAtoms = cc.getPaddedNumAtoms();
-    bondReductionAtoms.initialize<int>(cc, paddedNumAtoms, "bondReductionAtoms");
-    bondReductionFactors.initialize<float>(cc, paddedNumAtoms, "bondReductionFactors");
     scaleFactors.initialize<float>(cc, paddedNumAtoms, "scaleFactors");
-    tempPosq.initialize(cc, paddedNumAtoms, cc.getUseDoublePrecision() ? sizeof(mm_double4) : sizeof(mm_float4), "tempPosq");
-    tempForces.initialize<long long>(cc, 3*paddedNumAtoms, "tempForces");
     
     // Record atom parameters.
     vector<int> atomTypeVec;
@@ -2088,8 +2973,8 @@ void CommonCalcAmoebaVdwForceKernel::initialize(const System& system, const Amoe
     sigmaEpsilon.upload(sigmaEpsilonVec);
     
     vector<float> isAlchemicalVec(paddedNumAtoms, 0);
-    vector<int> bondReductionAtomsVec(paddedNumAtoms, 0);
-    vector<float> bondReductionFactorsVec(paddedNumAtoms, 0);
+    vector<int> bondReductionAtomsVec(force.getNumParticles());
+    vector<float> bondReductionFactorsVec(force.getNumParticles());
     vector<float> scaleFactorsVec(paddedNumAtoms, 0);
     vector<vector<int> > exclusions(cc.getNumAtoms());
 
@@ -2112,8 +2997,7 @@ void CommonCalcAmoebaVdwForceKernel::initialize(const System& system, const Amoe
         force.getParticleExclusions(i, exclusions[i]);
         exclusions[i].push_back(i);
     }
-    bondReductionAtoms.upload(bondReductionAtomsVec);
-    bondReductionFactors.upload(bondReductionFactorsVec);
+    setReductionSites(bondReductionAtomsVec, bondReductionFactorsVec);
     scaleFactors.upload(scaleFactorsVec);
     if (force.getUseDispersionCorrection())
         dispersionCoefficient = AmoebaVdwForceImpl::calcDispersionCorrection(system, force);
@@ -2162,16 +3046,18 @@ void CommonCalcAmoebaVdwForceKernel::initialize(const System& system, const Amoe
     defines["PADDED_NUM_ATOMS"] = cc.intToString(paddedNumAtoms);
     ComputeProgram program = cc.compileProgram(CommonAmoebaKernelSources::amoebaVdwForce1, defines);
     prepareKernel = program->createKernel("prepareToComputeForce");
-    prepareKernel->addArg(cc.getLongForceBuffer());
-    prepareKernel->addArg(cc.getPosq());
-    prepareKernel->addArg(tempPosq);
-    prepareKernel->addArg(bondReductionAtoms);
-    prepareKernel->addArg(bondReductionFactors);
     spreadKernel = program->createKernel("spreadForces");
-    spreadKernel->addArg(cc.getLongForceBuffer());
-    spreadKernel->addArg(tempForces);
-    spreadKernel->addArg(bondReductionAtoms);
-    spreadKernel->addArg(bondReductionFactors);
+    for (ComputeKernel kernel : {prepareKernel, spreadKernel}) {
+        kernel->addArg(cc.getLongForceBuffer());
+        kernel->addArg(cc.getPosq());
+        kernel->addArg(savedPosq);
+        kernel->addArg(savedForces);
+        kernel->addArg(reductionAtoms);
+        kernel->addArg(reductionParents);
+        kernel->addArg(reductionFactors);
+        for (int i = 0; i < 3; i++)
+            kernel->addArg();
+    }
     cc.addForce(new ForceInfo(force));
 }
 
@@ -2190,19 +3076,145 @@ double CommonCalcAmoebaVdwForceKernel::execute(ContextImpl& context, bool includ
        }
     }
 
-    cc.getPosq().copyTo(tempPosq);
-    cc.getLongForceBuffer().copyTo(tempForces);
-    prepareKernel->execute(cc.getPaddedNumAtoms());
+    moveReductionSites(includeForces);
     nonbonded->prepareInteractions(1);
     nonbonded->computeInteractions(1, includeForces, includeEnergy);
-    spreadKernel->execute(cc.getPaddedNumAtoms());
-    tempPosq.copyTo(cc.getPosq());
-    tempForces.copyTo(cc.getLongForceBuffer());
+    restoreReductionSites(includeForces);
     Vec3 a, b, c;
     cc.getPeriodicBoxVectors(a, b, c);
     return dispersionCoefficient/(a[0]*b[1]*c[2]);
 }
 
+void CommonCalcAmoebaVdwForceKernel::computeLambdaEnergies(ContextImpl& context, const vector<double>& lambdas, vector<double>& energies) {
+    ContextSelector selector(cc);
+    if (!hasInitializedNonbonded) {
+        hasInitializedNonbonded = true;
+        nonbonded->initialize(system);
+    }
+    Vec3 a, b, c;
+    cc.getPeriodicBoxVectors(a, b, c);
+    double dispersionEnergy = dispersionCoefficient/(a[0]*b[1]*c[2]);
+    energies.resize(lambdas.size());
+    if (lambdas.size() == 0)
+        return;
+
+    // Build the reduced positions and neighbor list once, then run an energy-only pass for each lambda.
+
+    moveReductionSites(false);
+    nonbonded->prepareInteractions(1);
+    int numPasses = (hasAlchemical ? lambdas.size() : 1);
+    for (int i = 0; i < numPasses; i++) {
+        if (hasAlchemical) {
+            float lambda = (float) lambdas[i];
+            vdwLambda.upload(&lambda);
+        }
+        cc.clearBuffer(cc.getEnergyBuffer());
+        nonbonded->computeInteractions(1, false, true);
+        energies[i] = sumEnergyBuffer()+dispersionEnergy;
+    }
+    for (int i = numPasses; i < (int) lambdas.size(); i++)
+        energies[i] = energies[0];
+    if (hasAlchemical)
+        vdwLambda.upload(&currentVdwLambda);
+    restoreReductionSites(false);
+}
+
+void CommonCalcAmoebaVdwForceKernel::setReductionSites(const vector<int>& parents, const vector<float>& factors) {
+    // Find the atoms whose interaction sites are displaced, and how deep each one is in a chain of displaced
+    // parents.  The kernels process one depth at a time so no atom is moved while a child is reading it.
+
+    int numParticles = parents.size();
+    vector<bool> isReduced(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        isReduced[i] = (parents[i] != i && factors[i] != 1.0f);
+    vector<int> depth(numParticles, 0);
+    int maxDepth = 0;
+    for (int i = 0; i < numParticles; i++) {
+        if (!isReduced[i])
+            continue;
+        int atom = i;
+        while (isReduced[atom]) {
+            depth[i]++;
+            if (depth[i] > numParticles)
+                throw OpenMMException("AmoebaVdwForce: The parent particles form a cycle");
+            atom = parents[atom];
+        }
+        maxDepth = max(maxDepth, depth[i]);
+    }
+    vector<int> atomsVec, parentsVec;
+    vector<float> factorsVec;
+    reductionLevelStart.clear();
+    for (int level = 1; level <= maxDepth; level++) {
+        reductionLevelStart.push_back(atomsVec.size());
+        for (int i = 0; i < numParticles; i++)
+            if (depth[i] == level) {
+                atomsVec.push_back(i);
+                parentsVec.push_back(parents[i]);
+                factorsVec.push_back(factors[i]);
+            }
+    }
+    reductionLevelStart.push_back(atomsVec.size());
+    int numReduced = atomsVec.size();
+    if (!reductionAtoms.isInitialized()) {
+        int size = max(numReduced, 1);
+        reductionAtoms.initialize<int>(cc, size, "reductionAtoms");
+        reductionParents.initialize<int>(cc, size, "reductionParents");
+        reductionFactors.initialize<float>(cc, size, "reductionFactors");
+        savedPosq.initialize(cc, size, cc.getUseDoublePrecision() ? sizeof(mm_double4) : sizeof(mm_float4), "savedPosq");
+        savedForces.initialize<long long>(cc, 3*size, "savedForces");
+    }
+    else if (numReduced > (int) reductionAtoms.getSize()) {
+        reductionAtoms.resize(numReduced);
+        reductionParents.resize(numReduced);
+        reductionFactors.resize(numReduced);
+        savedPosq.resize(numReduced);
+        savedForces.resize(3*numReduced);
+    }
+    if (numReduced > 0) {
+        reductionAtoms.uploadSubArray(atomsVec.data(), 0, numReduced);
+        reductionParents.uploadSubArray(parentsVec.data(), 0, numReduced);
+        reductionFactors.uploadSubArray(factorsVec.data(), 0, numReduced);
+    }
+}
+
+void CommonCalcAmoebaVdwForceKernel::moveReductionSites(bool includeForces) {
+    for (int level = reductionLevelStart.size()-2; level >= 0; level--) {
+        int start = reductionLevelStart[level], end = reductionLevelStart[level+1];
+        prepareKernel->setArg(7, start);
+        prepareKernel->setArg(8, end);
+        prepareKernel->setArg(9, (int) includeForces);
+        prepareKernel->execute(end-start);
+    }
+}
+
+void CommonCalcAmoebaVdwForceKernel::restoreReductionSites(bool includeForces) {
+    for (int level = 0; level < (int) reductionLevelStart.size()-1; level++) {
+        int start = reductionLevelStart[level], end = reductionLevelStart[level+1];
+        spreadKernel->setArg(7, start);
+        spreadKernel->setArg(8, end);
+        spreadKernel->setArg(9, (int) includeForces);
+        spreadKernel->execute(end-start);
+    }
+}
+
+double CommonCalcAmoebaVdwForceKernel::sumEnergyBuffer() {
+    ArrayInterface& energyBuffer = cc.getEnergyBuffer();
+    double sum = 0.0;
+    if (energyBuffer.getElementSize() == sizeof(double)) {
+        vector<double> energy;
+        energyBuffer.download(energy);
+        for (double e : energy)
+            sum += e;
+    }
+    else {
+        vector<float> energy;
+        energyBuffer.download(energy);
+        for (float e : energy)
+            sum += e;
+    }
+    return sum;
+}
+
 void CommonCalcAmoebaVdwForceKernel::copyParametersToContext(ContextImpl& context, const AmoebaVdwForce& force) {
     // Make sure the new parameters are acceptable.
     
@@ -2226,8 +3238,8 @@ void CommonCalcAmoebaVdwForceKernel::copyParametersToContext(ContextImpl& contex
 
     // Record the per-particle parameters.
     vector<float> isAlchemicalVec(cc.getPaddedNumAtoms(), 0);
-    vector<int> bondReductionAtomsVec(cc.getPaddedNumAtoms(), 0);
-    vector<float> bondReductionFactorsVec(cc.getPaddedNumAtoms(), 0);
+    vector<int> bondReductionAtomsVec(force.getNumParticles());
+    vector<float> bondReductionFactorsVec(force.getNumParticles());
     vector<float> scaleFactorsVec(cc.getPaddedNumAtoms(), 0);
     for (int i = 0; i < force.getNumParticles(); i++) {
         int ivIndex, type;
@@ -2240,8 +3252,7 @@ void CommonCalcAmoebaVdwForceKernel::copyParametersToContext(ContextImpl& contex
         scaleFactorsVec[i] = (float) scaleFactor;
     }
     if (hasAlchemical) isAlchemical.upload(isAlchemicalVec);
-    bondReductionAtoms.upload(bondReductionAtomsVec);
-    bondReductionFactors.upload(bondReductionFactorsVec);
+    setReductionSites(bondReductionAtomsVec, bondReductionFactorsVec);
     scaleFactors.upload(scaleFactorsVec);
     if (force.getUseDispersionCorrection())
         dispersionCoefficient = AmoebaVdwForceImpl::calcDispersionCorrection(system, force);
@@ -2304,6 +3315,16 @@ void CommonCalcAmoebaWcaDispersionForceKernel::initialize(const System& system,
     defines["DISPOFF"] = cc.doubleToString(force.getDispoff());
     defines["SHCTD"] = cc.doubleToString(force.getShctd());
     defines["M_PI"] = cc.doubleToString(M_PI);
+    if (force.getNonbondedMethod() == AmoebaWcaDispersionForce::CutoffNonPeriodic) {
+        double cutoff = force.getCutoffDistance();
+        double taperCutoff = cutoff*0.9;
+        defines["USE_CUTOFF"] = "";
+        defines["CUTOFF_SQUARED"] = cc.doubleToString(cutoff*cutoff);
+        defines["TAPER_CUTOFF"] = cc.doubleToString(taperCutoff);
+        defines["TAPER_C3"] = cc.doubleToString(10/pow(taperCutoff-cutoff, 3.0));
+        defines["TAPER_C4"] = cc.doubleToString(15/pow(taperCutoff-cutoff, 4.0));
+        defines["TAPER_C5"] = cc.doubleToString(6/pow(taperCutoff-cutoff, 5.0));
+    }
     ComputeProgram program = cc.compileProgram(CommonAmoebaKernelSources::amoebaWcaForce, defines);
     forceKernel = program->createKernel("computeWCAForce");
     forceKernel->addArg(cc.getLongForceBuffer());
@@ -2421,8 +3442,23 @@ private:
     CommonCalcHippoNonbondedForceKernel& owner;
 };
 
+class CommonCalcHippoNonbondedForceKernel::ExceptionFlagsPreComputation : public ComputeContext::ForcePreComputation {
+public:
+    ExceptionFlagsPreComputation(CommonCalcHippoNonbondedForceKernel& owner) : owner(owner) {
+    }
+    void computeForceAndEnergy(bool includeForces, bool includeEnergy, int groups) {
+        // The flags must be ready before the nonbonded kernels are created, since some platforms
+        // bind their arguments at that point.
+
+        if (!owner.hasInitializedExceptionFlags)
+            owner.initializeExceptionFlags();
+    }
+private:
+    CommonCalcHippoNonbondedForceKernel& owner;
+};
+
 CommonCalcHippoNonbondedForceKernel::CommonCalcHippoNonbondedForceKernel(const std::string& name, const Platform& platform, ComputeContext& cc, const System& system) :
-        CalcHippoNonbondedForceKernel(name, platform), cc(cc), system(system), hasInitializedKernels(false), multipolesAreValid(false) {
+        CalcHippoNonbondedForceKernel(name, platform), usePmeQueue(false), cc(cc), system(system), hasInitializedKernels(false), hasInitializedExceptionFlags(false), multipolesAreValid(false) {
 }
 
 void CommonCalcHippoNonbondedForceKernel::initialize(const System& system, const HippoNonbondedForce& force) {
@@ -2532,33 +3568,30 @@ void CommonCalcHippoNonbondedForceKernel::initialize(const System& system, const
     cc.addAutoclearBuffer(field);
     cc.addAutoclearBuffer(torque);
     
-    // Record exceptions and exclusions.
+    // Record exceptions and exclusions.  Every exception is excluded from the normal interaction.  The ones
+    // that still need to be computed are grouped into classes sharing the same scale factors, and the tile
+    // kernels look up the class of each pair from bitmasks over the exclusion tiles.
     
-    vector<double> exceptionScaleVec[6];
-    vector<mm_int2> exceptionAtomsVec;
     for (int i = 0; i < force.getNumExceptions(); i++) {
         int particle1, particle2;
         double multipoleMultipoleScale, dipoleMultipoleScale, dipoleDipoleScale, dispersionScale, repulsionScale, chargeTransferScale;
         force.getExceptionParameters(i, particle1, particle2, multipoleMultipoleScale, dipoleMultipoleScale, dipoleDipoleScale, dispersionScale, repulsionScale, chargeTransferScale);
         exclusions[particle1].push_back(particle2);
         exclusions[particle2].push_back(particle1);
-        if (usePME || multipoleMultipoleScale != 0 || dipoleMultipoleScale != 0 || dipoleDipoleScale != 0 || dispersionScale != 0 || repulsionScale != 0 || chargeTransferScale != 0) {
-            exceptionAtomsVec.push_back(mm_int2(particle1, particle2));
-            exceptionScaleVec[0].push_back(multipoleMultipoleScale);
-            exceptionScaleVec[1].push_back(dipoleMultipoleScale);
-            exceptionScaleVec[2].push_back(dipoleDipoleScale);
-            exceptionScaleVec[3].push_back(dispersionScale);
-            exceptionScaleVec[4].push_back(repulsionScale);
-            exceptionScaleVec[5].push_back(chargeTransferScale);
-        }
     }
-    if (exceptionAtomsVec.size() > 0) {
-        exceptionAtoms.initialize<mm_int2>(cc, exceptionAtomsVec.size(), "exceptionAtoms");
-        exceptionAtoms.upload(exceptionAtomsVec);
-        for (int i = 0; i < 6; i++) {
-            exceptionScales[i].initialize(cc, exceptionAtomsVec.size(), elementSize, "exceptionScales");
-            exceptionScales[i].upload(exceptionScaleVec[i], true);
-        }
+    vector<double> classScalesVec;
+    recordExceptionClasses(force, classScalesVec);
+    int numClasses = classScalesVec.size()/6;
+    numExceptionClassBits = 0;
+    while ((1<<numExceptionClassBits) < numClasses)
+        numExceptionClassBits++;
+    hasInitializedExceptionFlags = false;
+    if (numExceptionClassBits > 0) {
+        exceptionClassFlags.initialize<unsigned int>(cc, 1, "exceptionClassFlags");
+        exceptionClassScales.initialize(cc, 6*(1<<numExceptionClassBits), elementSize, "exceptionClassScales");
+        classScalesVec.resize(exceptionClassScales.getSize(), 1.0);
+        exceptionClassScales.upload(classScalesVec, true);
+        cc.addPreComputation(new ExceptionFlagsPreComputation(*this));
     }
     
     // Create the kernels.
@@ -2668,12 +3701,22 @@ void CommonCalcHippoNonbondedForceKernel::initialize(const System& system, const
     
     if (usePME) {
 
-        // Create required data structures.
+        // Create required data structures.  If there is a separate PME queue, dispersion gets its
+        // own queue and grids so it can run concurrently with the electrostatic calculation.
+        // Otherwise the two calculations share a single set of grids.
 
+        usePmeQueue = supportsPmeQueue();
         int gridElements = gridSizeX*gridSizeY*gridSizeZ;
-        gridElements = max(gridElements, dispersionGridSizeX*dispersionGridSizeY*dispersionGridSizeZ);
+        int dispersionGridElements = dispersionGridSizeX*dispersionGridSizeY*dispersionGridSizeZ;
+        if (!usePmeQueue)
+            gridElements = max(gridElements, dispersionGridElements);
         pmeGrid1.initialize(cc, gridElements, elementSize, "pmeGrid1");
         pmeGrid2.initialize(cc, gridElements, 2*elementSize, "pmeGrid2");
+        if (usePmeQueue) {
+            dpmeGrid1.initialize(cc, dispersionGridElements, elementSize, "dpmeGrid1");
+            dpmeGrid2.initialize(cc, dispersionGridElements, 2*elementSize, "dpmeGrid2");
+            dpmeEnergyBuffer.initialize(cc, cc.getEnergyBuffer().getSize(), cc.getEnergyBuffer().getElementSize(), "dpmeEnergyBuffer");
+        }
         if (useFixedPointChargeSpreading()) {
             pmeGridLong.initialize(cc, 2*gridElements, sizeof(long long), "pmeGridLong");
             cc.addAutoclearBuffer(pmeGridLong);
@@ -2712,6 +3755,14 @@ void CommonCalcHippoNonbondedForceKernel::initialize(const System& system, const
         pmeDefines["MAX_EXTRAPOLATION_ORDER"] = cc.intToString(maxExtrapolationOrder);
         if (useFixedPointChargeSpreading())
             pmeDefines["USE_FIXED_POINT_CHARGE_SPREADING"] = "";
+        if (usePmeQueue) {
+            pmeDefines["USE_PME_STREAM"] = "";
+            pmeQueue = cc.createQueue();
+            dpmeQueue = cc.createQueue();
+            pmeStartEvent = cc.createEvent();
+            pmeSyncEvent = cc.createEvent();
+            dpmeSyncEvent = cc.createEvent();
+        }
         program = cc.compileProgram(CommonAmoebaKernelSources::multipolePme, pmeDefines);
         pmeTransformMultipolesKernel = program->createKernel("transformMultipolesToFractionalCoordinates");
         pmeTransformMultipolesKernel->addArg(labDipoles);
@@ -2851,10 +3902,12 @@ void CommonCalcHippoNonbondedForceKernel::initialize(const System& system, const
         pmeDefines["CHARGE"] = "charges[atom]";
         pmeDefines["USE_LJPME"] = "1";
         program = cc.compileProgram(CommonKernelSources::pme, pmeDefines);
+        ComputeArray& dispersionGrid1 = (usePmeQueue ? dpmeGrid1 : pmeGrid1);
+        ComputeArray& dispersionGrid2 = (usePmeQueue ? dpmeGrid2 : pmeGrid2);
         if (useFixedPointChargeSpreading()) {
             dpmeFinishSpreadChargeKernel = program->createKernel("finishSpreadCharge");
-            dpmeFinishSpreadChargeKernel->addArg(pmeGrid2);
-            dpmeFinishSpreadChargeKernel->addArg(pmeGrid1);
+            dpmeFinishSpreadChargeKernel->addArg(dispersionGrid2);
+            dpmeFinishSpreadChargeKernel->addArg(dispersionGrid1);
         }
         dpmeGridIndexKernel = program->createKernel("findAtomGridIndex");
         dpmeGridIndexKernel->addArg(cc.getPosq());
@@ -2864,23 +3917,26 @@ void CommonCalcHippoNonbondedForceKernel::initialize(const System& system, const
         dpmeSpreadChargeKernel = program->createKernel("gridSpreadCharge");
         dpmeSpreadChargeKernel->addArg(cc.getPosq());
         if (useFixedPointChargeSpreading())
-            dpmeSpreadChargeKernel->addArg(pmeGrid2);
+            dpmeSpreadChargeKernel->addArg(dispersionGrid2);
         else
-            dpmeSpreadChargeKernel->addArg(pmeGrid1);
+            dpmeSpreadChargeKernel->addArg(dispersionGrid1);
         for (int i = 0; i < 8; i++)
             dpmeSpreadChargeKernel->addArg();
         dpmeSpreadChargeKernel->addArg(pmeAtomGridIndex);
         dpmeSpreadChargeKernel->addArg(c6);
         dpmeConvolutionKernel = program->createKernel("reciprocalConvolution");
-        dpmeConvolutionKernel->addArg(pmeGrid2);
+        dpmeConvolutionKernel->addArg(dispersionGrid2);
         dpmeConvolutionKernel->addArg(dpmeBsplineModuliX);
         dpmeConvolutionKernel->addArg(dpmeBsplineModuliY);
         dpmeConvolutionKernel->addArg(dpmeBsplineModuliZ);
         for (int i = 0; i < 3; i++)
             dpmeConvolutionKernel->addArg();
         dpmeEvalEnergyKernel = program->createKernel("gridEvaluateEnergy");
-        dpmeEvalEnergyKernel->addArg(pmeGrid2);
-        dpmeEvalEnergyKernel->addArg(cc.getEnergyBuffer());
+        dpmeEvalEnergyKernel->addArg(dispersionGrid2);
+        if (usePmeQueue)
+            dpmeEvalEnergyKernel->addArg(dpmeEnergyBuffer);
+        else
+            dpmeEvalEnergyKernel->addArg(cc.getEnergyBuffer());
         dpmeEvalEnergyKernel->addArg(dpmeBsplineModuliX);
         dpmeEvalEnergyKernel->addArg(dpmeBsplineModuliY);
         dpmeEvalEnergyKernel->addArg(dpmeBsplineModuliZ);
@@ -2889,11 +3945,17 @@ void CommonCalcHippoNonbondedForceKernel::initialize(const System& system, const
         dpmeInterpolateForceKernel = program->createKernel("gridInterpolateForce");
         dpmeInterpolateForceKernel->addArg(cc.getPosq());
         dpmeInterpolateForceKernel->addArg(cc.getLongForceBuffer());
-        dpmeInterpolateForceKernel->addArg(pmeGrid1);
+        dpmeInterpolateForceKernel->addArg(dispersionGrid1);
         for (int i = 0; i < 8; i++)
             dpmeInterpolateForceKernel->addArg();
         dpmeInterpolateForceKernel->addArg(pmeAtomGridIndex);
         dpmeInterpolateForceKernel->addArg(c6);
+        if (usePmeQueue) {
+            dpmeAddEnergyKernel = program->createKernel("addEnergy");
+            dpmeAddEnergyKernel->addArg(dpmeEnergyBuffer);
+            dpmeAddEnergyKernel->addArg(cc.getEnergyBuffer());
+            dpmeAddEnergyKernel->addArg((int) dpmeEnergyBuffer.getSize());
+        }
 
         // Initialize the B-spline moduli.
 
@@ -3051,9 +4113,14 @@ void CommonCalcHippoNonbondedForceKernel::initialize(const System& system, const
     // Add the interaction to the default nonbonded kernel.
     
     NonbondedUtilities& nb = cc.getNonbondedUtilities();
-    nb.setKernelSource(CommonAmoebaKernelSources::hippoInteractionHeader+CommonAmoebaKernelSources::hippoNonbonded);
+    nb.setKernelSource("#define NUM_EXCEPTION_CLASS_BITS "+cc.intToString(numExceptionClassBits)+"\n"+
+            CommonAmoebaKernelSources::hippoInteractionHeader+CommonAmoebaKernelSources::hippoNonbonded);
     nb.addArgument(ComputeParameterInfo(torque, "torqueBuffers", "mm_ulong", 1, false));
     nb.addArgument(ComputeParameterInfo(extrapolatedDipole, "extrapolatedDipole", "real", 1));
+    if (numExceptionClassBits > 0) {
+        nb.addArgument(ComputeParameterInfo(exceptionClassFlags, "exceptionClassFlags", "unsigned int", 1));
+        nb.addArgument(ComputeParameterInfo(exceptionClassScales, "exceptionClassScales", "real", 1));
+    }
     nb.addParameter(ComputeParameterInfo(coreCharge, "coreCharge", "real", 1));
     nb.addParameter(ComputeParameterInfo(valenceCharge, "valenceCharge", "real", 1));
     nb.addParameter(ComputeParameterInfo(alpha, "alpha", "real", 1));
@@ -3085,60 +4152,92 @@ void CommonCalcHippoNonbondedForceKernel::initialize(const System& system, const
     string interactionSource = cc.replaceStrings(CommonAmoebaKernelSources::hippoInteraction, replacements);
     nb.addInteraction(usePME, usePME, true, force.getCutoffDistance(), exclusions, interactionSource, force.getForceGroup());
     nb.setUsePadding(false);
-    
-    // Create the kernel for computing exceptions.
-    
-    if (exceptionAtoms.isInitialized()) {
-        replacements["COMPUTE_INTERACTION"] = interactionSource;
-        string exceptionsSrc = CommonAmoebaKernelSources::hippoInteractionHeader+CommonAmoebaKernelSources::hippoNonbondedExceptions;
-        exceptionsSrc = cc.replaceStrings(exceptionsSrc, replacements);
-        defines["NUM_EXCEPTIONS"] = cc.intToString(exceptionAtoms.getSize());
-        program = cc.compileProgram(exceptionsSrc, defines);
-        computeExceptionsKernel = program->createKernel("computeNonbondedExceptions");
-        computeExceptionsKernel->addArg(cc.getLongForceBuffer());
-        computeExceptionsKernel->addArg(cc.getEnergyBuffer());
-        computeExceptionsKernel->addArg(torque);
-        computeExceptionsKernel->addArg(cc.getPosq());
-        computeExceptionsKernel->addArg(exceptionAtoms);
-        computeExceptionsKernel->addArg(exceptionScales[0]);
-        computeExceptionsKernel->addArg(exceptionScales[1]);
-        computeExceptionsKernel->addArg(exceptionScales[2]);
-        computeExceptionsKernel->addArg(exceptionScales[3]);
-        computeExceptionsKernel->addArg(exceptionScales[4]);
-        computeExceptionsKernel->addArg(exceptionScales[5]);
-        computeExceptionsKernel->addArg(coreCharge);
-        computeExceptionsKernel->addArg(valenceCharge);
-        computeExceptionsKernel->addArg(alpha);
-        computeExceptionsKernel->addArg(epsilon);
-        computeExceptionsKernel->addArg(damping);
-        computeExceptionsKernel->addArg(c6);
-        computeExceptionsKernel->addArg(pauliK);
-        computeExceptionsKernel->addArg(pauliQ);
-        computeExceptionsKernel->addArg(pauliAlpha);
-        computeExceptionsKernel->addArg(labDipoles);
-        computeExceptionsKernel->addArg(inducedDipole);
-        computeExceptionsKernel->addArg(labQuadrupoles[0]);
-        computeExceptionsKernel->addArg(labQuadrupoles[1]);
-        computeExceptionsKernel->addArg(labQuadrupoles[2]);
-        computeExceptionsKernel->addArg(labQuadrupoles[3]);
-        computeExceptionsKernel->addArg(labQuadrupoles[4]);
-        computeExceptionsKernel->addArg(extrapolatedDipole);
-        if (nb.getUseCutoff())
-            for (int i = 0; i < 5; i++)
-                computeExceptionsKernel->addArg();
-    }
     cc.addForce(new ForceInfo(force));
     cc.addPostComputation(new TorquePostComputation(*this));
     fieldThreadBlockSize = max(32, cc.getNonbondedUtilities().getForceThreadBlockSize());
 }
 
+void CommonCalcHippoNonbondedForceKernel::recordExceptionClasses(const HippoNonbondedForce& force, vector<double>& classScales) {
+    // Class 0 is for pairs that are not exceptions, so all its scale factors are 1.  Each distinct set of
+    // scale factors gets its own class after that.
+
+    classScales.assign(6, 1.0);
+    exceptionClassValues.clear();
+    map<vector<double>, int> classIndex;
+    for (int i = 0; i < force.getNumExceptions(); i++) {
+        int particle1, particle2;
+        double multipoleMultipoleScale, dipoleMultipoleScale, dipoleDipoleScale, dispersionScale, repulsionScale, chargeTransferScale;
+        force.getExceptionParameters(i, particle1, particle2, multipoleMultipoleScale, dipoleMultipoleScale, dipoleDipoleScale, dispersionScale, repulsionScale, chargeTransferScale);
+        if (usePME || multipoleMultipoleScale != 0 || dipoleMultipoleScale != 0 || dipoleDipoleScale != 0 || dispersionScale != 0 || repulsionScale != 0 || chargeTransferScale != 0) {
+            vector<double> scales = {multipoleMultipoleScale, dipoleMultipoleScale, dipoleDipoleScale, dispersionScale, repulsionScale, chargeTransferScale};
+            auto existing = classIndex.find(scales);
+            int index;
+            if (existing == classIndex.end()) {
+                index = classIndex.size()+1;
+                classIndex[scales] = index;
+                classScales.insert(classScales.end(), scales.begin(), scales.end());
+            }
+            else
+                index = existing->second;
+            exceptionClassValues.push_back(mm_int4(particle1, particle2, index, 0));
+        }
+    }
+}
+
+void CommonCalcHippoNonbondedForceKernel::initializeExceptionFlags() {
+    hasInitializedExceptionFlags = true;
+    NonbondedUtilities& nb = cc.getNonbondedUtilities();
+
+    // Each row of each exclusion tile gets one mask for every bit of the class index.  The masks for a
+    // row are stored next to each other so a thread can load all of them at once.
+
+    vector<mm_int2> exclusionTiles;
+    nb.getExclusionTiles().download(exclusionTiles);
+    map<pair<int, int>, int> exclusionTileMap;
+    for (int i = 0; i < (int) exclusionTiles.size(); i++) {
+        mm_int2 tile = exclusionTiles[i];
+        exclusionTileMap[make_pair(tile.x, tile.y)] = i;
+    }
+    int numFlags = nb.getExclusions().getSize()*numExceptionClassBits;
+    if (exceptionClassFlags.getSize() != numFlags)
+        exceptionClassFlags.resize(numFlags);
+    vector<unsigned int> exceptionClassFlagsVec(numFlags, 0);
+    for (mm_int4 values : exceptionClassValues) {
+        int atom1 = values.x;
+        int atom2 = values.y;
+        int value = values.z;
+        int x = atom1/ComputeContext::TileSize;
+        int offset1 = atom1-x*ComputeContext::TileSize;
+        int y = atom2/ComputeContext::TileSize;
+        int offset2 = atom2-y*ComputeContext::TileSize;
+        for (int bit = 0; bit < numExceptionClassBits; bit++) {
+            if ((value & (1<<bit)) == 0)
+                continue;
+            if (x == y) {
+                int index = exclusionTileMap[make_pair(x, y)]*ComputeContext::TileSize;
+                exceptionClassFlagsVec[(index+offset1)*numExceptionClassBits+bit] |= 1u<<offset2;
+                exceptionClassFlagsVec[(index+offset2)*numExceptionClassBits+bit] |= 1u<<offset1;
+            }
+            else if (x > y) {
+                int index = exclusionTileMap[make_pair(x, y)]*ComputeContext::TileSize;
+                exceptionClassFlagsVec[(index+offset1)*numExceptionClassBits+bit] |= 1u<<offset2;
+            }
+            else {
+                int index = exclusionTileMap[make_pair(y, x)]*ComputeContext::TileSize;
+                exceptionClassFlagsVec[(index+offset2)*numExceptionClassBits+bit] |= 1u<<offset1;
+            }
+        }
+    }
+    exceptionClassFlags.upload(exceptionClassFlagsVec);
+}
+
 void CommonCalcHippoNonbondedForceKernel::createFieldKernel(const string& interactionSrc, vector<ComputeArray*> params,
-            ComputeArray& fieldBuffer, ComputeKernel& kernel, ComputeKernel& exceptionKernel, ComputeArray& exceptionScale) {
+            ComputeArray& fieldBuffer, ComputeKernel& kernel, int scaleIndex) {
     // Create the kernel source.
 
     map<string, string> replacements;
     replacements["COMPUTE_FIELD"] = interactionSrc;
-    stringstream extraArgs, atomParams, loadLocal1, loadLocal2, load1, load2, load3;
+    stringstream extraArgs, atomParams, loadLocal1, loadLocal2, load1, load2;
     for (auto param : params) {
         string name = param->getName();
         bool isReal3 = (param->getSize() == cc.getPaddedNumAtoms()*3);
@@ -3149,12 +4248,10 @@ void CommonCalcHippoNonbondedForceKernel::createFieldKernel(const string& intera
         if (isReal3) {
             loadLocal2 << "localData[localAtomIndex]." << name << " = make_real3(" << name << "[3*j], " << name << "[3*j+1], " << name << "[3*j+2]);\n";
             load1 << type << " " << name << "1 = make_real3(" << name << "[3*atom1], " << name << "[3*atom1+1], " << name << "[3*atom1+2]);\n";
-            load3 << type << " " << name << "2 = make_real3(" << name << "[3*atom2], " << name << "[3*atom2+1], " << name << "[3*atom2+2]);\n";
         }
         else {
             loadLocal2 << "localData[localAtomIndex]." << name << " = " << name << "[j];\n";
             load1 << type << " " << name << "1 = " << name << "[atom1];\n";
-            load3 << type << " " << name << "2 = " << name << "[atom2];\n";
         }
         load2 << type << " " << name << "2 = localData[atom2]." << name << ";\n";
     }
@@ -3164,7 +4261,6 @@ void CommonCalcHippoNonbondedForceKernel::createFieldKernel(const string& intera
     replacements["LOAD_LOCAL_PARAMETERS_FROM_GLOBAL"] = loadLocal2.str();
     replacements["LOAD_ATOM1_PARAMETERS"] = load1.str();
     replacements["LOAD_ATOM2_PARAMETERS"] = load2.str();
-    replacements["LOAD_ATOM2_PARAMETERS_FROM_GLOBAL"] = load3.str();
     string src = cc.replaceStrings(CommonAmoebaKernelSources::hippoComputeField, replacements);
 
     // Set defines and create the kernel.
@@ -3186,7 +4282,8 @@ void CommonCalcHippoNonbondedForceKernel::createFieldKernel(const string& intera
     defines["NUM_BLOCKS"] = cc.intToString(cc.getNumAtomBlocks());
     defines["TILE_SIZE"] = cc.intToString(ComputeContext::TileSize);
     defines["NUM_TILES_WITH_EXCLUSIONS"] = cc.intToString(cc.getNonbondedUtilities().getExclusionTiles().getSize());
-    defines["NUM_EXCEPTIONS"] = cc.intToString(exceptionAtoms.isInitialized() ? exceptionAtoms.getSize() : 0);
+    defines["NUM_EXCEPTION_CLASS_BITS"] = cc.intToString(numExceptionClassBits);
+    defines["FIELD_SCALE_INDEX"] = cc.intToString(scaleIndex);
     ComputeProgram program = cc.compileProgram(src, defines);
     kernel = program->createKernel("computeField");
 
@@ -3209,23 +4306,12 @@ void CommonCalcHippoNonbondedForceKernel::createFieldKernel(const string& intera
     }
     else
         kernel->addArg(maxTiles);
+    if (numExceptionClassBits > 0) {
+        kernel->addArg(exceptionClassFlags);
+        kernel->addArg(exceptionClassScales);
+    }
     for (auto param : params)
         kernel->addArg(*param);
-    
-    // If there are any exceptions, build the kernel and arguments to compute them.
-    
-    if (exceptionAtoms.isInitialized()) {
-        exceptionKernel = program->createKernel("computeFieldExceptions");
-        exceptionKernel->addArg(cc.getPosq());
-        exceptionKernel->addArg(fieldBuffer);
-        exceptionKernel->addArg(exceptionAtoms);
-        exceptionKernel->addArg(exceptionScale);
-        if (nb.getUseCutoff())
-            for (int i = 0; i < 5; i++)
-                exceptionKernel->addArg();
-        for (auto param : params)
-            exceptionKernel->addArg(*param);
-    }
 }
 
 double CommonCalcHippoNonbondedForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
@@ -3239,10 +4325,8 @@ double CommonCalcHippoNonbondedForceKernel::execute(ContextImpl& context, bool i
 
         maxTiles = (nb.getUseCutoff() ? nb.getInteractingTiles().getSize() : cc.getNumAtomBlocks()*(cc.getNumAtomBlocks()+1)/2);
         createFieldKernel(CommonAmoebaKernelSources::hippoFixedField, {&coreCharge, &valenceCharge, &alpha, &labDipoles, &labQuadrupoles[0],
-                &labQuadrupoles[1], &labQuadrupoles[2], &labQuadrupoles[3], &labQuadrupoles[4]}, field, fixedFieldKernel,
-                fixedFieldExceptionKernel, exceptionScales[1]);
-        createFieldKernel(CommonAmoebaKernelSources::hippoMutualField, {&alpha, &inducedDipole}, inducedField, mutualFieldKernel,
-                mutualFieldExceptionKernel, exceptionScales[2]);
+                &labQuadrupoles[1], &labQuadrupoles[2], &labQuadrupoles[3], &labQuadrupoles[4]}, field, fixedFieldKernel, 1);
+        createFieldKernel(CommonAmoebaKernelSources::hippoMutualField, {&alpha, &inducedDipole}, inducedField, mutualFieldKernel, 2);
     }
 
     // Compute the lab frame moments.
@@ -3319,8 +4403,15 @@ double CommonCalcHippoNonbondedForceKernel::execute(ContextImpl& context, bool i
             }
         }
 
-        // Reciprocal space calculation for electrostatics.
+        // Reciprocal space calculation for electrostatics.  If there is a separate PME queue, this
+        // overlaps with the direct space field, and is accumulated into the (autocleared) field buffer.
         
+        if (usePmeQueue) {
+            pmeStartEvent->enqueue();
+            pmeStartEvent->queueWait(pmeQueue);
+            pmeStartEvent->queueWait(dpmeQueue);
+            cc.setCurrentQueue(pmeQueue);
+        }
         pmeTransformMultipolesKernel->execute(cc.getNumAtoms());
         pmeSpreadFixedMultipolesKernel->execute(cc.getNumAtoms());
         if (useFixedPointChargeSpreading())
@@ -3332,24 +4423,42 @@ double CommonCalcHippoNonbondedForceKernel::execute(ContextImpl& context, bool i
         pmeTransformPotentialKernel->setArg(0, pmePhi);
         pmeTransformPotentialKernel->execute(cc.getNumAtoms());
         pmeFixedForceKernel->execute(cc.getNumAtoms());
+        if (usePmeQueue) {
+            pmeSyncEvent->enqueue();
+            cc.setCurrentQueue(dpmeQueue);
+        }
 
-        // Reciprocal space calculation for dispersion.
+        // Reciprocal space calculation for dispersion.  If there is a separate PME queue, this runs on
+        // its own queue with its own grids, so it overlaps with the electrostatic reciprocal space
+        // calculation, the direct space field, and the induced dipole iteration.  Only the force
+        // interpolation waits for the electrostatic forces, since both accumulate into the force buffer.
 
         dpmeGridIndexKernel->execute(cc.getNumAtoms());
         sortGridIndex();
+        ComputeArray& dispersionGrid1 = (usePmeQueue ? dpmeGrid1 : pmeGrid1);
+        ComputeArray& dispersionGrid2 = (usePmeQueue ? dpmeGrid2 : pmeGrid2);
         if (useFixedPointChargeSpreading())
-            cc.clearBuffer(pmeGrid2);
+            cc.clearBuffer(dispersionGrid2);
         else
-            cc.clearBuffer(pmeGrid1);
+            cc.clearBuffer(dispersionGrid1);
         dpmeSpreadChargeKernel->execute(PmeOrder*cc.getNumAtoms(), 128);
         if (useFixedPointChargeSpreading())
             dpmeFinishSpreadChargeKernel->execute(dispersionGridSizeX*dispersionGridSizeY*dispersionGridSizeZ, 256);
-        dfft->execFFT(pmeGrid1, pmeGrid2, true);
-        if (includeEnergy)
+        dfft->execFFT(dispersionGrid1, dispersionGrid2, true);
+        if (includeEnergy) {
+            if (usePmeQueue)
+                cc.clearBuffer(dpmeEnergyBuffer);
             dpmeEvalEnergyKernel->execute(dispersionGridSizeX*dispersionGridSizeY*dispersionGridSizeZ);
+        }
         dpmeConvolutionKernel->execute(dispersionGridSizeX*dispersionGridSizeY*dispersionGridSizeZ, 256);
-        dfft->execFFT(pmeGrid2, pmeGrid1, false);
+        dfft->execFFT(dispersionGrid2, dispersionGrid1, false);
+        if (usePmeQueue)
+            pmeSyncEvent->queueWait(dpmeQueue);
         dpmeInterpolateForceKernel->execute(cc.getNumAtoms(), 128);
+        if (usePmeQueue) {
+            dpmeSyncEvent->enqueue();
+            cc.restoreDefaultQueue();
+        }
     }
 
     // Compute the field from fixed multipoles.
@@ -3357,16 +4466,21 @@ double CommonCalcHippoNonbondedForceKernel::execute(ContextImpl& context, bool i
     if (nb.getUseCutoff())
         setPeriodicBoxArgs(cc, fixedFieldKernel, 6);
     fixedFieldKernel->execute(nb.getNumForceThreadBlocks()*fieldThreadBlockSize, fieldThreadBlockSize);
-    if (exceptionAtoms.isInitialized()) {
-        if (nb.getUseCutoff())
-            setPeriodicBoxArgs(cc, fixedFieldExceptionKernel, 4);
-        fixedFieldExceptionKernel->execute(exceptionAtoms.getSize());
-    }
+    if (usePME && usePmeQueue)
+        pmeSyncEvent->queueWait(cc.getCurrentQueue());
 
     // Iterate the induced dipoles.
 
     computeExtrapolatedDipoles();
 
+    // Wait for the dispersion reciprocal space calculation to finish, then add its energy.
+
+    if (usePME && usePmeQueue) {
+        dpmeSyncEvent->queueWait(cc.getCurrentQueue());
+        if (includeEnergy)
+            dpmeAddEnergyKernel->execute(dpmeEnergyBuffer.getSize());
+    }
+
     // Add the polarization energy.
 
     if (includeEnergy)
@@ -3381,14 +4495,6 @@ double CommonCalcHippoNonbondedForceKernel::execute(ContextImpl& context, bool i
         pmeSelfEnergyKernel->execute(cc.getNumAtoms());
     }
 
-    // Compute nonbonded exceptions.
-
-    if (exceptionAtoms.isInitialized()) {
-        if (nb.getUseCutoff())
-            setPeriodicBoxArgs(cc, computeExceptionsKernel, 28);
-        computeExceptionsKernel->execute(exceptionAtoms.getSize());
-    }
-
     // Record the current atom positions so we can tell later if they have changed.
     
     cc.getPosq().copyTo(lastPositions);
@@ -3409,31 +4515,44 @@ double CommonCalcHippoNonbondedForceKernel::execute(ContextImpl& context, bool i
 void CommonCalcHippoNonbondedForceKernel::computeInducedField(int optOrder) {
     NonbondedUtilities& nb = cc.getNonbondedUtilities();
     cc.clearBuffer(inducedField);
+    bool overlapPme = (usePME && usePmeQueue);
+    if (overlapPme) {
+        // Compute the reciprocal space potential on the PME queue while the direct space field is computed.
+
+        pmeStartEvent->enqueue();
+        pmeStartEvent->queueWait(pmeQueue);
+        cc.setCurrentQueue(pmeQueue);
+        computeInducedPotentialFromGrid(optOrder);
+        pmeSyncEvent->enqueue();
+        cc.restoreDefaultQueue();
+    }
     if (nb.getUseCutoff())
         setPeriodicBoxArgs(cc, mutualFieldKernel, 6);
     mutualFieldKernel->execute(nb.getNumForceThreadBlocks()*fieldThreadBlockSize, fieldThreadBlockSize);
-    if (exceptionAtoms.isInitialized()) {
-        if (nb.getUseCutoff())
-            setPeriodicBoxArgs(cc, mutualFieldExceptionKernel, 4);
-        mutualFieldExceptionKernel->execute(exceptionAtoms.getSize());
-    }
     if (usePME) {
-        if (useFixedPointChargeSpreading())
-            cc.clearBuffer(pmeGridLong);
+        if (overlapPme)
+            pmeSyncEvent->queueWait(cc.getCurrentQueue());
         else
-            cc.clearBuffer(pmeGrid1);
-        pmeSpreadInducedDipolesKernel->execute(cc.getNumAtoms());
-        if (useFixedPointChargeSpreading())
-            pmeFinishSpreadChargeKernel->execute(pmeGrid1.getSize());
-        fft->execFFT(pmeGrid1, pmeGrid2, true);
-        pmeConvolutionKernel->execute(gridSizeX*gridSizeY*gridSizeZ, 256);
-        fft->execFFT(pmeGrid2, pmeGrid1, false);
-        pmeInducedPotentialKernel->setArg(2, optOrder);
-        pmeInducedPotentialKernel->execute(cc.getNumAtoms());
+            computeInducedPotentialFromGrid(optOrder);
         pmeRecordInducedFieldDipolesKernel->execute(cc.getNumAtoms());
     }
 }
 
+void CommonCalcHippoNonbondedForceKernel::computeInducedPotentialFromGrid(int optOrder) {
+    if (useFixedPointChargeSpreading())
+        cc.clearBuffer(pmeGridLong);
+    else
+        cc.clearBuffer(pmeGrid1);
+    pmeSpreadInducedDipolesKernel->execute(cc.getNumAtoms());
+    if (useFixedPointChargeSpreading())
+        pmeFinishSpreadChargeKernel->execute(pmeGrid1.getSize());
+    fft->execFFT(pmeGrid1, pmeGrid2, true);
+    pmeConvolutionKernel->execute(gridSizeX*gridSizeY*gridSizeZ, 256);
+    fft->execFFT(pmeGrid2, pmeGrid1, false);
+    pmeInducedPotentialKernel->setArg(2, optOrder);
+    pmeInducedPotentialKernel->execute(cc.getNumAtoms());
+}
+
 void CommonCalcHippoNonbondedForceKernel::computeExtrapolatedDipoles() {
     // Start by storing the direct dipoles as PT0
 
@@ -3599,31 +4718,15 @@ void CommonCalcHippoNonbondedForceKernel::copyParametersToContext(ContextImpl& c
     
     // Record the per-exception parameters.
 
-    vector<double> exceptionScaleVec[6];
-    vector<mm_int2> exceptionAtomsVec;
-    for (int i = 0; i < force.getNumExceptions(); i++) {
-        int particle1, particle2;
-        double multipoleMultipoleScale, dipoleMultipoleScale, dipoleDipoleScale, dispersionScale, repulsionScale, chargeTransferScale;
-        force.getExceptionParameters(i, particle1, particle2, multipoleMultipoleScale, dipoleMultipoleScale, dipoleDipoleScale, dispersionScale, repulsionScale, chargeTransferScale);
-        if (usePME || multipoleMultipoleScale != 0 || dipoleMultipoleScale != 0 || dipoleDipoleScale != 0 || dispersionScale != 0 || repulsionScale != 0 || chargeTransferScale != 0) {
-            exceptionAtomsVec.push_back(mm_int2(particle1, particle2));
-            exceptionScaleVec[0].push_back(multipoleMultipoleScale);
-            exceptionScaleVec[1].push_back(dipoleMultipoleScale);
-            exceptionScaleVec[2].push_back(dipoleDipoleScale);
-            exceptionScaleVec[3].push_back(dispersionScale);
-            exceptionScaleVec[4].push_back(repulsionScale);
-            exceptionScaleVec[5].push_back(chargeTransferScale);
-        }
-    }
-    if (exceptionAtomsVec.size() > 0) {
-        if (!exceptionAtoms.isInitialized() || exceptionAtoms.getSize() != exceptionAtomsVec.size())
-            throw OpenMMException("updateParametersInContext: The number of exceptions has changed");
-        exceptionAtoms.upload(exceptionAtomsVec);
-        for (int i = 0; i < 6; i++)
-            exceptionScales[i].upload(exceptionScaleVec[i], true);
+    vector<double> classScalesVec;
+    recordExceptionClasses(force, classScalesVec);
+    if (classScalesVec.size()/6 > (1<<numExceptionClassBits))
+        throw OpenMMException("updateParametersInContext: The number of distinct sets of exception scale factors has increased");
+    if (numExceptionClassBits > 0) {
+        classScalesVec.resize(exceptionClassScales.getSize(), 1.0);
+        exceptionClassScales.upload(classScalesVec, true);
+        hasInitializedExceptionFlags = false;
     }
-    else if (exceptionAtoms.isInitialized())
-        throw OpenMMException("updateParametersInContext: The number of exceptions has changed");
     cc.invalidateMolecules();
     multipolesAreValid = false;
 }
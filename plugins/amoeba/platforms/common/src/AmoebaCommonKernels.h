@@ -67,7 +67,7 @@ private:
     int numTorsionTorsionGrids;
     ComputeContext& cc;
     const System& system;
-    ComputeArray gridValues;
+    ComputeArray gridCoefficients;
     ComputeArray gridParams;
     ComputeArray torsionParams;
 };
@@ -125,6 +125,16 @@ public:
     void getElectrostaticPotential(ContextImpl& context, const std::vector< Vec3 >& inputGrid,
                                    std::vector< double >& outputElectrostaticPotential);
 
+    /** 
+     * Calculate the electrostatic potential given vector of grid coordinates, using Ewald summation.
+     *
+     * @param context                      context
+     * @param inputGrid                    input grid coordinates
+     * @param outputElectrostaticPotential output potential 
+     */
+    void getPMEElectrostaticPotential(ContextImpl& context, const std::vector< Vec3 >& inputGrid,
+                                      std::vector< double >& outputElectrostaticPotential);
+
    /** 
      * Get the system multipole moments
      *
@@ -152,23 +162,91 @@ public:
      * @param nz      the number of grid points along the Z axis
      */
     void getPMEParameters(double& alpha, int& nx, int& ny, int& nz) const;
+    /**
+     * Write the history used to predict the induced dipoles to a checkpoint.
+     *
+     * @param context    the context for which to save the history
+     * @param stream     an output stream the data should be written to
+     */
+    void createCheckpoint(ContextImpl& context, std::ostream& stream);
+    /**
+     * Load the history used to predict the induced dipoles from a checkpoint.
+     *
+     * @param context    the context for which to load the history
+     * @param stream     an input stream the data should be read from
+     */
+    void loadCheckpoint(ContextImpl& context, std::istream& stream);
     /**
      * Get whether charge spreading should be done in fixed point.
      */
     virtual bool useFixedPointChargeSpreading() const = 0;
+    /**
+     * Get whether reciprocal space PME may be computed on a separate queue, so it can overlap
+     * with the direct space calculation.
+     */
+    virtual bool supportsPmeQueue() const = 0;
+    /**
+     * This interface is used when the calculation is divided between multiple devices.  Each device
+     * computes a subset of the direct space interactions, so the partial fields must be summed over
+     * devices before they are used to update the induced dipoles.
+     */
+    class FieldReducer {
+    public:
+        virtual ~FieldReducer() {
+        }
+        /**
+         * Sum a set of fixed point arrays over all devices, leaving the total on every device.  This is
+         * called from each device's worker thread, and blocks until all devices have reached it.
+         */
+        virtual void reduce(ComputeContext& cc, const std::vector<ArrayInterface*>& arrays) = 0;
+        /**
+         * Make all devices agree on whether the induced dipoles have converged.  The decision made by
+         * the first device is returned on every device.
+         */
+        virtual bool agreeOnConvergence(ComputeContext& cc, bool converged) = 0;
+    };
+    /**
+     * Set the object used to combine fields computed on different devices.  If this is NULL (the
+     * default), the kernel computes all interactions itself.
+     */
+    void setFieldReducer(FieldReducer* reducer) {
+        fieldReducer = reducer;
+    }
 protected:
     class ForceInfo;
+    class ReorderListener;
+    class PotentialCellSortTrait : public ComputeSortImpl::SortTrait {
+        int getDataSize() const {return 8;}
+        int getKeySize() const {return 4;}
+        const char* getDataType() const {return "int2";}
+        const char* getKeyType() const {return "int";}
+        const char* getMinKey() const {return "(-2147483647-1)";}
+        const char* getMaxKey() const {return "2147483647";}
+        const char* getMaxValue() const {return "make_int2(2147483647, 2147483647)";}
+        const char* getSortKey() const {return "value.y";}
+    };
     void initializeScaleFactors();
     void computeInducedField();
+    void computeInducedPotentialFromGrid(bool useInducedGrid);
+    void computeBsplineModuli(ComputeArray& moduliX, ComputeArray& moduliY, ComputeArray& moduliZ, int sizeX, int sizeY, int sizeZ, int order);
+    bool hasConverged(bool converged);
     bool iterateDipolesByDIIS(int iteration);
+    bool iterateDipolesByPCG(int iteration);
+    void predictInducedDipoles();
+    void recordInducedDipoleHistory();
     void computeExtrapolatedDipoles();
     void ensureMultipolesValid(ContextImpl& context);
     template <class T, class T4, class M4> void computeSystemMultipoleMoments(ContextImpl& context, std::vector<double>& outputMultipoleMoments);
+    void uploadPotentialPoints(const std::vector<Vec3>& inputGrid, int start, int numPoints);
+    void downloadPotential(std::vector<double>& outputElectrostaticPotential, int start, int numPoints);
     int numMultipoles, maxInducedIterations, maxExtrapolationOrder;
+    int predictorHistoryLength, predictorHistorySize, predictorNewestSlot, predictorPositionsSetCount;
+    long long predictorLastStep;
     int fixedFieldThreads, inducedFieldThreads, electrostaticsThreads;
     int gridSizeX, gridSizeY, gridSizeZ;
-    double pmeAlpha, inducedEpsilon, totalCharge;
-    bool usePME, hasQuadrupoles, hasInitializedScaleFactors, multipolesAreValid, hasCreatedEvent;
+    int inducedGridSizeX, inducedGridSizeY, inducedGridSizeZ, inducedPmeOrder;
+    double pmeAlpha, inducedEpsilon, totalCharge, cutoff;
+    bool usePME, usePCG, usePmeQueue, hasQuadrupoles, hasInitializedScaleFactors, multipolesAreValid, hasCreatedEvent, hasInducedGrid;
     AmoebaMultipoleForce::PolarizationType polarizationType;
     ComputeContext& cc;
     const System& system;
@@ -180,8 +258,6 @@ protected:
     ComputeArray localQuadrupoles;
     ComputeArray labDipoles;
     ComputeArray labQuadrupoles;
-    ComputeArray sphericalDipoles;
-    ComputeArray sphericalQuadrupoles;
     ComputeArray fracDipoles;
     ComputeArray fracQuadrupoles;
     ComputeArray field;
@@ -200,6 +276,15 @@ protected:
     ComputeArray prevErrors;
     ComputeArray diisMatrix;
     ComputeArray diisCoefficients;
+    ComputeArray pcgDipole;
+    ComputeArray pcgDipolePolar;
+    ComputeArray pcgResidual;
+    ComputeArray pcgResidualPolar;
+    ComputeArray pcgSums;
+    ComputeArray dipoleHistory;
+    ComputeArray dipoleHistoryPolar;
+    ComputeArray predictorCoefficients;
+    ComputeArray auxiliaryCoefficients;
     ComputeArray extrapolatedDipole;
     ComputeArray extrapolatedDipolePolar;
     ComputeArray extrapolatedDipoleGk;
@@ -226,19 +311,161 @@ protected:
     ComputeArray pmePhip;
     ComputeArray pmePhidp;
     ComputeArray pmeCphi;
+    ComputeArray inducedPmeGrid1;
+    ComputeArray inducedPmeGrid2;
+    ComputeArray inducedPmeGridLong;
+    ComputeArray inducedPmeBsplineModuliX;
+    ComputeArray inducedPmeBsplineModuliY;
+    ComputeArray inducedPmeBsplineModuliZ;
     ComputeArray lastPositions;
+    ComputeArray potentialPoints;
+    ComputeArray potentialValues;
+    ComputeArray potentialAtomCells;
+    ComputeArray potentialCellRange;
     ComputeKernel computeMomentsKernel, recordInducedDipolesKernel, mapTorqueKernel, computePotentialKernel, electrostaticsKernel;
     ComputeKernel computeFixedFieldKernel, computeInducedFieldKernel, updateInducedFieldKernel;
     ComputeKernel recordDIISDipolesKernel, buildMatrixKernel, solveMatrixKernel;
+    ComputeKernel initPCGKernel, computePCGProductsKernel, updatePCGKernel, updatePCGDirectionKernel;
+    ComputeKernel predictDipolesKernel, recordDipoleHistoryKernel, propagateAuxiliaryDipolesKernel;
     ComputeKernel initExtrapolatedKernel, iterateExtrapolatedKernel, computeExtrapolatedKernel, addExtrapolatedGradientKernel;
     ComputeKernel pmeSpreadFixedMultipolesKernel, pmeSpreadInducedDipolesKernel, pmeFinishSpreadChargeKernel, pmeConvolutionKernel;
     ComputeKernel pmeFixedPotentialKernel, pmeInducedPotentialKernel, pmeFixedForceKernel, pmeInducedForceKernel, pmeRecordInducedFieldDipolesKernel;
     ComputeKernel pmeTransformMultipolesKernel, pmeTransformPotentialKernel;
+    ComputeKernel inducedPmeSpreadKernel, inducedPmeFinishSpreadKernel, inducedPmeConvolutionKernel, inducedPmePotentialKernel;
+    ComputeKernel findAtomPotentialCellsKernel, findPotentialCellRangesKernel, computeEwaldPotentialKernel, pmePotentialAtPointsKernel;
+    ComputeSort potentialSort;
     ComputeEvent syncEvent;
-    FFT3D fft;
+    ComputeQueue pmeQueue;
+    ComputeEvent pmeStartEvent, pmeSyncEvent;
+    FFT3D fft, inducedFft;
     CommonCalcAmoebaGeneralizedKirkwoodForceKernel* gkKernel;
+    FieldReducer* fieldReducer;
     static const int PmeOrder = 5;
     static const int MaxPrevDIISDipoles = 20;
+    static const int PotentialBatchSize = 1<<20;
+};
+
+/**
+ * This kernel is used when AmoebaMultipoleForce is computed on multiple devices.  Each device computes
+ * a subset of the direct space tiles, and the fields are summed over devices at every step of the
+ * induced dipole iteration.  Reciprocal space PME is only computed on the first device.
+ */
+class CommonParallelCalcAmoebaMultipoleForceKernel : public CalcAmoebaMultipoleForceKernel {
+public:
+    /**
+     * Create a CommonParallelCalcAmoebaMultipoleForceKernel.
+     *
+     * @param cc       the ComputeContext for the first device
+     * @param kernels  the kernel to execute on each device, in the same order as cc.getAllContexts()
+     */
+    CommonParallelCalcAmoebaMultipoleForceKernel(const std::string& name, const Platform& platform, ComputeContext& cc, const std::vector<Kernel>& kernels);
+    ~CommonParallelCalcAmoebaMultipoleForceKernel();
+    CommonCalcAmoebaMultipoleForceKernel& getKernel(int index) {
+        return dynamic_cast<CommonCalcAmoebaMultipoleForceKernel&>(kernels[index].getImpl());
+    }
+    /**
+     * Initialize the kernel.
+     * 
+     * @param system     the System this kernel will be applied to
+     * @param force      the AmoebaMultipoleForce this kernel will be used for
+     */
+    void initialize(const System& system, const AmoebaMultipoleForce& force);
+    /**
+     * Execute the kernel to calculate the forces and/or energy.
+     *
+     * @param context        the context in which to execute this kernel
+     * @param includeForces  true if forces should be calculated
+     * @param includeEnergy  true if the energy should be calculated
+     * @return the potential energy due to the force
+     */
+    double execute(ContextImpl& context, bool includeForces, bool includeEnergy);
+    /**
+     * Get the LabFrame dipole moments of all particles.
+     * 
+     * @param context    the Context for which to get the induced dipoles
+     * @param dipoles    the induced dipole moment of particle i is stored into the i'th element
+     */
+    void getLabFramePermanentDipoles(ContextImpl& context, std::vector<Vec3>& dipoles);
+    /**
+     * Get the induced dipole moments of all particles.
+     * 
+     * @param context    the Context for which to get the induced dipoles
+     * @param dipoles    the induced dipole moment of particle i is stored into the i'th element
+     */
+    void getInducedDipoles(ContextImpl& context, std::vector<Vec3>& dipoles);
+    /**
+     * Get the total dipole moments of all particles.
+     * 
+     * @param context    the Context for which to get the induced dipoles
+     * @param dipoles    the induced dipole moment of particle i is stored into the i'th element
+     */
+    void getTotalDipoles(ContextImpl& context, std::vector<Vec3>& dipoles);
+    /**
+     * Execute the kernel to calculate the electrostatic potential
+     *
+     * @param context        the context in which to execute this kernel
+     * @param inputGrid      input grid coordinates
+     * @param outputElectrostaticPotential output potential 
+     */
+    void getElectrostaticPotential(ContextImpl& context, const std::vector< Vec3 >& inputGrid,
+                                   std::vector< double >& outputElectrostaticPotential);
+
+    /** 
+     * Calculate the electrostatic potential given vector of grid coordinates, using Ewald summation.
+     *
+     * @param context                      context
+     * @param inputGrid                    input grid coordinates
+     * @param outputElectrostaticPotential output potential 
+     */
+    void getPMEElectrostaticPotential(ContextImpl& context, const std::vector< Vec3 >& inputGrid,
+                                      std::vector< double >& outputElectrostaticPotential);
+    /** 
+     * Get the system multipole moments
+     *
+     * @param context      context
+     * @param outputMultipoleMoments (charge,
+     *                                dipole_x, dipole_y, dipole_z,
+     *                                quadrupole_xx, quadrupole_xy, quadrupole_xz,
+     *                                quadrupole_yx, quadrupole_yy, quadrupole_yz,
+     *                                quadrupole_zx, quadrupole_zy, quadrupole_zz)
+     */
+    void getSystemMultipoleMoments(ContextImpl& context, std::vector<double>& outputMultipoleMoments);
+    /**
+     * Copy changed parameters over to a context.
+     *
+     * @param context    the context to copy parameters to
+     * @param force      the AmoebaMultipoleForce to copy the parameters from
+     */
+    void copyParametersToContext(ContextImpl& context, const AmoebaMultipoleForce& force);
+    /**
+     * Get the parameters being used for PME.
+     * 
+     * @param alpha   the separation parameter
+     * @param nx      the number of grid points along the X axis
+     * @param ny      the number of grid points along the Y axis
+     * @param nz      the number of grid points along the Z axis
+     */
+    void getPMEParameters(double& alpha, int& nx, int& ny, int& nz) const;
+    /**
+     * Write the history used to predict the induced dipoles to a checkpoint.
+     *
+     * @param context    the context for which to save the history
+     * @param stream     an output stream the data should be written to
+     */
+    void createCheckpoint(ContextImpl& context, std::ostream& stream);
+    /**
+     * Load the history used to predict the induced dipoles from a checkpoint.
+     *
+     * @param context    the context for which to load the history
+     * @param stream     an input stream the data should be read from
+     */
+    void loadCheckpoint(ContextImpl& context, std::istream& stream);
+private:
+    class Task;
+    class Reducer;
+    ComputeContext& cc;
+    std::vector<Kernel> kernels;
+    Reducer* reducer;
 };
 
 /**
@@ -299,10 +526,17 @@ public:
 
 private:
     class ForceInfo;
+    /**
+     * Determine whether the Born radii must be recomputed, or whether the ones from the last
+     * update can be reused.
+     */
+    bool needsBornRadiiUpdate();
     ComputeContext& cc;
     const System& system;
-    bool includeSurfaceArea, tanhRescaling, hasInitializedKernels;
+    bool includeSurfaceArea, tanhRescaling, hasInitializedKernels, hasBornRadii;
     int computeBornSumThreads, gkForceThreads, chainRuleThreads, ediffThreads;
+    int bornRadiiUpdateInterval, lastBornRadiiUpdate;
+    double bornRadiiUpdateTolerance;
     AmoebaMultipoleForce::PolarizationType polarizationType;
     std::map<std::string, std::string> defines;
     ComputeArray params;
@@ -317,7 +551,10 @@ private:
     ComputeArray inducedFieldPolar;
     ComputeArray inducedDipoleS;
     ComputeArray inducedDipolePolarS;
+    ComputeArray bornRadiiPositions;
+    ComputeArray bornRadiiUpdateFlag;
     ComputeKernel computeBornSumKernel, reduceBornSumKernel, surfaceAreaKernel, gkForceKernel, chainRuleKernel, ediffKernel;
+    ComputeKernel checkDisplacementKernel;
 };
 
 /**
@@ -350,8 +587,20 @@ public:
      * @param force      the AmoebaVdwForce to copy the parameters from
      */
     void copyParametersToContext(ContextImpl& context, const AmoebaVdwForce& force);
+    /**
+     * Compute the energy of the force at each of a list of values for the lambda parameter.
+     *
+     * @param context        the context in which to execute this kernel
+     * @param lambdas        the values of the lambda parameter at which to evaluate the energy
+     * @param[out] energies  on exit, energies[i] is the energy when lambda equals lambdas[i]
+     */
+    void computeLambdaEnergies(ContextImpl& context, const std::vector<double>& lambdas, std::vector<double>& energies);
 private:
     class ForceInfo;
+    double sumEnergyBuffer();
+    void setReductionSites(const std::vector<int>& parents, const std::vector<float>& factors);
+    void moveReductionSites(bool includeForces);
+    void restoreReductionSites(bool includeForces);
     ComputeContext& cc;
     const System& system;
     bool hasInitializedNonbonded;
@@ -371,10 +620,14 @@ private:
 
     double dispersionCoefficient;
     ComputeArray sigmaEpsilon, atomType;
-    ComputeArray bondReductionAtoms;
-    ComputeArray bondReductionFactors;
-    ComputeArray tempPosq;
-    ComputeArray tempForces;
+    // Only the atoms whose interaction sites are displaced toward a parent are listed, sorted by
+    // how many displaced parents lie between them and an undisplaced atom.
+    ComputeArray reductionAtoms;
+    ComputeArray reductionParents;
+    ComputeArray reductionFactors;
+    ComputeArray savedPosq;
+    ComputeArray savedForces;
+    std::vector<int> reductionLevelStart;
     NonbondedUtilities* nonbonded;
     ComputeKernel prepareKernel, spreadKernel;
 };
@@ -435,6 +688,11 @@ public:
      * Get whether charge spreading should be done in fixed point.
      */
     virtual bool useFixedPointChargeSpreading() const = 0;
+    /**
+     * Get whether reciprocal space PME may be computed on a separate queue, so it can overlap
+     * with the direct space calculation.
+     */
+    virtual bool supportsPmeQueue() const = 0;
     /**
      * Sort the atom grid indices.
      */
@@ -499,18 +757,23 @@ public:
 protected:
     class ForceInfo;
     class TorquePostComputation;
+    class ExceptionFlagsPreComputation;
     void computeInducedField(int optOrder);
+    void computeInducedPotentialFromGrid(int optOrder);
     void computeExtrapolatedDipoles();
     void ensureMultipolesValid(ContextImpl& context);
     void addTorquesToForces();
+    void recordExceptionClasses(const HippoNonbondedForce& force, std::vector<double>& classScales);
+    void initializeExceptionFlags();
     void createFieldKernel(const std::string& interactionSrc, std::vector<ComputeArray*> params, ComputeArray& fieldBuffer,
-        ComputeKernel& kernel, ComputeKernel& exceptionKernel, ComputeArray& exceptionScale);
-    int numParticles, maxExtrapolationOrder, maxTiles, fieldThreadBlockSize;
+        ComputeKernel& kernel, int scaleIndex);
+    int numParticles, maxExtrapolationOrder, maxTiles, fieldThreadBlockSize, numExceptionClassBits;
     int gridSizeX, gridSizeY, gridSizeZ;
     int dispersionGridSizeX, dispersionGridSizeY, dispersionGridSizeZ;
     double pmeAlpha, dpmeAlpha, cutoff, totalCharge;
-    bool usePME, hasInitializedKernels, multipolesAreValid;
+    bool usePME, usePmeQueue, hasInitializedKernels, hasInitializedExceptionFlags, multipolesAreValid;
     std::vector<double> extrapolationCoefficients;
+    std::vector<mm_int4> exceptionClassValues;
     ComputeContext& cc;
     const System& system;
     ComputeArray multipoleParticles;
@@ -524,19 +787,21 @@ protected:
     ComputeArray extrapolatedDipole, extrapolatedPhi;
     ComputeArray pmeGrid1, pmeGrid2, pmeGridLong;
     ComputeArray pmeAtomGridIndex;
+    ComputeArray dpmeGrid1, dpmeGrid2, dpmeEnergyBuffer;
     ComputeArray pmeBsplineModuliX, pmeBsplineModuliY, pmeBsplineModuliZ;
     ComputeArray dpmeBsplineModuliX, dpmeBsplineModuliY, dpmeBsplineModuliZ;
     ComputeArray pmePhi, pmePhidp, pmeCphi;
     ComputeArray lastPositions;
-    ComputeArray exceptionScales[6];
-    ComputeArray exceptionAtoms;
+    ComputeArray exceptionClassFlags, exceptionClassScales;
     FFT3D fft, dfft;
+    ComputeQueue pmeQueue, dpmeQueue;
+    ComputeEvent pmeStartEvent, pmeSyncEvent, dpmeSyncEvent;
     ComputeKernel computeMomentsKernel, recordInducedDipolesKernel, mapTorqueKernel;
-    ComputeKernel fixedFieldKernel, fixedFieldExceptionKernel, mutualFieldKernel, mutualFieldExceptionKernel, computeExceptionsKernel;
+    ComputeKernel fixedFieldKernel, mutualFieldKernel;
     ComputeKernel pmeSpreadFixedMultipolesKernel, pmeSpreadInducedDipolesKernel, pmeFinishSpreadChargeKernel, pmeConvolutionKernel;
     ComputeKernel pmeFixedPotentialKernel, pmeInducedPotentialKernel, pmeFixedForceKernel, pmeInducedForceKernel, pmeRecordInducedFieldDipolesKernel;
     ComputeKernel pmeSelfEnergyKernel, pmeTransformMultipolesKernel, pmeTransformPotentialKernel;
-    ComputeKernel dpmeGridIndexKernel, dpmeSpreadChargeKernel, dpmeFinishSpreadChargeKernel, dpmeEvalEnergyKernel, dpmeConvolutionKernel, dpmeInterpolateForceKernel;
+    ComputeKernel dpmeGridIndexKernel, dpmeSpreadChargeKernel, dpmeFinishSpreadChargeKernel, dpmeEvalEnergyKernel, dpmeConvolutionKernel, dpmeInterpolateForceKernel, dpmeAddEnergyKernel;
     ComputeKernel initExtrapolatedKernel, iterateExtrapolatedKernel, computeExtrapolatedKernel, polarizationEnergyKernel;
     static const int PmeOrder = 5;
 };
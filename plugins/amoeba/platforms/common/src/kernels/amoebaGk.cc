@@ -49,6 +49,19 @@ KERNEL void reduceBornSum(GLOBAL const mm_long* RESTRICT bornSum, GLOBAL const f
     }
 }
 
+/**
+ * Check whether any atom has moved farther than the Born radii update tolerance since the
+ * radii were last computed.
+ */
+KERNEL void checkBornRadiiDisplacement(GLOBAL const real4* RESTRICT posq, GLOBAL const real4* RESTRICT lastPosq, float toleranceSquared,
+        GLOBAL int* RESTRICT needsUpdate) {
+    for (unsigned int index = GLOBAL_ID; index < NUM_ATOMS; index += GLOBAL_SIZE) {
+        real3 delta = trimTo3(posq[index])-trimTo3(lastPosq[index]);
+        if (dot(delta, delta) > toleranceSquared)
+            *needsUpdate = 1;
+    }
+}
+
 #ifdef SURFACE_AREA_FACTOR
 /**
  * Apply the surface area term to the force and energy.
@@ -175,31 +188,30 @@ DEVICE real neckDescreen(real r, real radius, real radiusK, real sneck,
 }
 
 
-DEVICE real computeBornSumOneInteraction(AtomData1 atom1, AtomData1 atom2,
+/**
+ * Compute the descreening integral of atom2 over atom1, including the neck correction.
+ *
+ * @param r separation distance.
+ * @param r2 separation distance squared.
+ * @param baseRadius radius at which the integral of the descreened atom begins.
+ * @param sk scaled radius of the descreening atom.
+ * @param descreenRadius descreening radius of the descreening atom.
+ * @param mixedNeckScale mixed neck scale factor of the two atoms.
+ * @return the integral.
+ */
+DEVICE real computeDescreeningIntegral(real r, real r2, real baseRadius, real sk, real descreenRadius, real mixedNeckScale,
         GLOBAL const float* RESTRICT neckRadii,
         GLOBAL const float* RESTRICT neckA,
         GLOBAL const float* RESTRICT neckB) {
-
-    if (atom1.radius <= 0)
-        return 0; // Ignore this interaction
-
-    float sk = atom2.scaleFactor * atom2.descreenRadius;
-    if (sk <= 0.0f)
-        return 0; // No descreening.
-
-    real3 delta = atom2.pos - atom1.pos;
-    real r2 = dot(delta, delta);
-    real r = SQRT(r2);
-    real baseRadius = max(atom1.radius, atom1.descreenRadius) + DESCREEN_OFFSET;
-
     if (baseRadius > r + sk)
         return 0; // No descreening due to atom1 engulfing atom2.
 
     real sk2 = sk*sk;
+    real term = 0;
     if (baseRadius + r < sk) {
         real lik = baseRadius;
         real uik = sk - r;
-        atom1.bornSum -= RECIP(uik*uik*uik) - RECIP(lik*lik*lik);
+        term -= RECIP(uik*uik*uik) - RECIP(lik*lik*lik);
     }
     real uik = r+sk;
     real lik;
@@ -217,18 +229,58 @@ DEVICE real computeBornSumOneInteraction(AtomData1 atom1, AtomData1 atom2,
     real u4 = u2*u2;
     real ur = uik*r;
     real u4r = u4*r;
-    real term = (3*(r2-sk2)+6*u2-8*ur)/u4r - (3*(r2-sk2)+6*l2-8*lr)/l4r;
-    term = term / (real) 16;
-
-    real neck1 = atom1.neckFactor;
-    real neck2 = atom2.neckFactor;
-    real mixedNeckScale = 0.5f * (neck1 + neck2);
-    if (mixedNeckScale > 0 && atom2.scaleFactor > 0) {
-        real ret = neckDescreen(r, baseRadius, atom2.descreenRadius, mixedNeckScale, neckRadii, neckA, neckB);
-        real pi43 = 4 * M_PI / (real) 3;
-        term += ret / pi43;
+    term += ((3*(r2-sk2)+6*u2-8*ur)/u4r - (3*(r2-sk2)+6*l2-8*lr)/l4r) / (real) 16;
+
+    real pi43 = 4 * M_PI / (real) 3;
+    real integral = pi43*term;
+    if (mixedNeckScale > 0)
+        integral += neckDescreen(r, baseRadius, descreenRadius, mixedNeckScale, neckRadii, neckA, neckB);
+    return integral;
+}
+
+#ifdef USE_GK_CUTOFF
+/**
+ * Compute the taper applied to interactions between GK_TAPER_CUTOFF and the cutoff.  dtaper is set to
+ * the derivative of the taper divided by r.
+ */
+DEVICE real computeGKTaper(real r, real* dtaper) {
+    if (r <= GK_TAPER_CUTOFF) {
+        *dtaper = 0;
+        return 1;
     }
+    real delta = r-GK_TAPER_CUTOFF;
+    *dtaper = delta*delta*(3*GK_TAPER_C3+delta*(4*GK_TAPER_C4+delta*5*GK_TAPER_C5))/r;
+    return 1+delta*delta*delta*(GK_TAPER_C3+delta*(GK_TAPER_C4+delta*GK_TAPER_C5));
+}
+#endif
+
+DEVICE real computeBornSumOneInteraction(AtomData1 atom1, AtomData1 atom2,
+        GLOBAL const float* RESTRICT neckRadii,
+        GLOBAL const float* RESTRICT neckA,
+        GLOBAL const float* RESTRICT neckB) {
+
+    if (atom1.radius <= 0)
+        return 0; // Ignore this interaction
+
+    float sk = atom2.scaleFactor * atom2.descreenRadius;
+    if (sk <= 0.0f)
+        return 0; // No descreening.
 
+    real3 delta = atom2.pos - atom1.pos;
+    real r2 = dot(delta, delta);
+#ifdef USE_GK_CUTOFF
+    if (r2 > GK_CUTOFF_SQUARED)
+        return 0; // Beyond the cutoff.
+#endif
+    real r = SQRT(r2);
+    real baseRadius = max(atom1.radius, atom1.descreenRadius) + DESCREEN_OFFSET;
+    real mixedNeckScale = 0.5f * (atom1.neckFactor + atom2.neckFactor);
+    real pi43 = 4 * M_PI / (real) 3;
+    real term = computeDescreeningIntegral(r, r2, baseRadius, sk, atom2.descreenRadius, mixedNeckScale, neckRadii, neckA, neckB) / pi43;
+#ifdef USE_GK_CUTOFF
+    real dtaper;
+    term *= computeGKTaper(r, &dtaper);
+#endif
     return term;
 }
 
@@ -728,6 +780,12 @@ DEVICE void computeBornChainRuleInteraction(AtomData3 atom1, AtomData3 atom2, re
 
     real baseRadius = max(atom1.radius, atom1.descreenRadius) + DESCREEN_OFFSET;
     real r2 = dot(delta, delta);
+#ifdef USE_GK_CUTOFF
+    if (r2 > GK_CUTOFF_SQUARED) {
+        *force = delta * de;
+        return;
+    }
+#endif
     real r = SQRT(r2);
     de = pairIntegralDerivative(r, r2, baseRadius, sk * atom2.descreenRadius);
 
@@ -736,6 +794,15 @@ DEVICE void computeBornChainRuleInteraction(AtomData3 atom1, AtomData3 atom2, re
         de += neckDescreenDerivative(r, baseRadius, atom2.descreenRadius, mixedNeckScale, neckRadii, neckA, neckB);
     }
 
+#ifdef USE_GK_CUTOFF
+    // The Born sum includes the tapered integral, so apply the product rule.
+
+    real dtaper;
+    real taper = computeGKTaper(r, &dtaper);
+    if (taper != 1)
+        de = de*taper + dtaper*r*computeDescreeningIntegral(r, r2, baseRadius, sk * atom2.descreenRadius, atom2.descreenRadius, mixedNeckScale, neckRadii, neckA, neckB);
+#endif
+
     real dbr = term*de/r;
     de = dbr*atom1.bornForce;
     *force = delta*de;
@@ -99,63 +99,39 @@ value1 *= sign;
 value2 *= sign;
 
 // use bicubic interpolation to compute spline values
-// compute indices into grid based on angles
+// find the grid cell containing the angles
 
 float4 gridParams = GRID_PARAMS[torsionParams.y];
+int size = (int) gridParams.w;
 int index1 = (int) ((value1 - gridParams.y)/gridParams.z + 1.0e-05f);
-real fIndex = (real) index1;
-real x1l = gridParams.z*fIndex + gridParams.y;
-real x1u = x1l + gridParams.z;
+index1 = min(max(index1, 0), size-2);
+real t = (value1 - (gridParams.z*index1 + gridParams.y))/gridParams.z;
 
 int index2 = (int) ((value2 - gridParams.y)/gridParams.z + 1.0e-05f);
-fIndex = (real) index2;
-real x2l = gridParams.z*fIndex + gridParams.y;
-real x2u = x2l + gridParams.z;
-
-int posIndex1 = index2 + index1*(int) gridParams.w;
-posIndex1 += (int) gridParams.x;
-
-int posIndex2 = index2 + (index1+1)*(int) gridParams.w;
-posIndex2 += (int) gridParams.x;
-
-// load grid points surrounding angle
-
-real4 y;
-real4 y1;
-real4 y2;
-real4 y12;
-
-int localIndex = posIndex1;
-y.x = GRID_VALUES[localIndex].x;
-y1.x = GRID_VALUES[localIndex].y;
-y2.x = GRID_VALUES[localIndex].z;
-y12.x = GRID_VALUES[localIndex].w;
-
-localIndex = posIndex2;
-y.y = GRID_VALUES[localIndex].x;
-y1.y = GRID_VALUES[localIndex].y;
-y2.y = GRID_VALUES[localIndex].z;
-y12.y = GRID_VALUES[localIndex].w;
-
-localIndex = posIndex2 + 1;
-y.z = GRID_VALUES[localIndex].x;
-y1.z = GRID_VALUES[localIndex].y;
-y2.z = GRID_VALUES[localIndex].z;
-y12.z = GRID_VALUES[localIndex].w;
-
-localIndex = posIndex1 + 1;
-y.w = GRID_VALUES[localIndex].x;
-y1.w = GRID_VALUES[localIndex].y;
-y2.w = GRID_VALUES[localIndex].z;
-y12.w = GRID_VALUES[localIndex].w;
+index2 = min(max(index2, 0), size-2);
+real u = (value2 - (gridParams.z*index2 + gridParams.y))/gridParams.z;
 
-// perform interpolation
+// load the precomputed coefficients for the cell
+
+int coeffIndex = (int) gridParams.x + 4*(index2 + index1*(size-1));
+float4 c[4];
+c[0] = GRID_COEFF[coeffIndex];
+c[1] = GRID_COEFF[coeffIndex+1];
+c[2] = GRID_COEFF[coeffIndex+2];
+c[3] = GRID_COEFF[coeffIndex+3];
 
-real e;
-real dedang1;
-real dedang2;
+// perform interpolation
 
-bicubic(y, y1, y2, y12, value1, x1l, x1u, value2, x2l, x2u, &e, &dedang1, &dedang2);
+real e = 0;
+real dedang1 = 0;
+real dedang2 = 0;
+for (int i = 3; i >= 0; i--) {
+    dedang1 = t*dedang1 + e;
+    e = t*e + ((c[i].w*u + c[i].z)*u + c[i].y)*u + c[i].x;
+    dedang2 = t*dedang2 + (3.0f*c[i].w*u + 2.0f*c[i].z)*u + c[i].y;
+}
+dedang1 /= gridParams.z;
+dedang2 /= gridParams.z;
 energy += e;
 dedang1 *= sign * RAD_TO_DEG;
 dedang2 *= sign * RAD_TO_DEG;
@@ -1,45 +1,60 @@
 /**
- * Clear the forces, and compute the position to use for each atom based on the bond reduction factors.
+ * Move each interaction site toward its parent atom based on the bond reduction factors.  Only atoms
+ * that are displaced are processed.  Their original positions are saved, and if forces are being computed,
+ * the forces already accumulated on them are saved and cleared so that afterward the buffer holds only the
+ * vdW force on the site.  This is invoked once for each level of sites, starting with the deepest, so no
+ * parent is moved before its children have read its position.
  */
-KERNEL void prepareToComputeForce(GLOBAL mm_ulong* RESTRICT forceBuffers, GLOBAL real4* RESTRICT posq, GLOBAL const real4* RESTRICT tempPosq,
-        GLOBAL const int* RESTRICT bondReductionAtoms, GLOBAL const float* RESTRICT bondReductionFactors) {
-    for (unsigned int atom = GLOBAL_ID; atom < PADDED_NUM_ATOMS; atom += GLOBAL_SIZE) {
-        forceBuffers[atom] = 0;
-        forceBuffers[atom+PADDED_NUM_ATOMS] = 0;
-        forceBuffers[atom+PADDED_NUM_ATOMS*2] = 0;
-        real4 pos1 = tempPosq[atom];
-        real4 pos2 = tempPosq[bondReductionAtoms[atom]];
-        real factor = (real) bondReductionFactors[atom];
+KERNEL void prepareToComputeForce(GLOBAL mm_ulong* RESTRICT forceBuffers, GLOBAL real4* RESTRICT posq, GLOBAL real4* RESTRICT savedPosq,
+        GLOBAL mm_ulong* RESTRICT savedForces, GLOBAL const int* RESTRICT reductionAtoms, GLOBAL const int* RESTRICT reductionParents,
+        GLOBAL const float* RESTRICT reductionFactors, int start, int end, int includeForces) {
+    for (int index = start+GLOBAL_ID; index < end; index += GLOBAL_SIZE) {
+        int atom = reductionAtoms[index];
+        real4 pos1 = posq[atom];
+        real4 pos2 = posq[reductionParents[index]];
+        real factor = (real) reductionFactors[index];
+        savedPosq[index] = pos1;
         posq[atom] = make_real4(factor*pos1.x + (1-factor)*pos2.x,
-                                    factor*pos1.y + (1-factor)*pos2.y,
-                                    factor*pos1.z + (1-factor)*pos2.z, pos1.w);
+                                factor*pos1.y + (1-factor)*pos2.y,
+                                factor*pos1.z + (1-factor)*pos2.z, pos1.w);
+        if (includeForces) {
+            savedForces[3*index] = forceBuffers[atom];
+            savedForces[3*index+1] = forceBuffers[atom+PADDED_NUM_ATOMS];
+            savedForces[3*index+2] = forceBuffers[atom+PADDED_NUM_ATOMS*2];
+            forceBuffers[atom] = 0;
+            forceBuffers[atom+PADDED_NUM_ATOMS] = 0;
+            forceBuffers[atom+PADDED_NUM_ATOMS*2] = 0;
+        }
     }
 }
 
 /**
- * Spread the forces between atoms based on the bond reduction factors.
+ * Restore the original positions of the displaced atoms, and spread the force on each interaction site
+ * between the atom and its parent based on the bond reduction factors.  This is invoked once for each level
+ * of sites, starting with the shallowest, so a site's own force has been spread before any of its children
+ * add to it.
  */
-KERNEL void spreadForces(GLOBAL const mm_ulong* RESTRICT forceBuffers, GLOBAL mm_ulong* RESTRICT tempForceBuffers,
-        GLOBAL const int* RESTRICT bondReductionAtoms, GLOBAL const float* RESTRICT bondReductionFactors) {
-    for (unsigned int atom1 = GLOBAL_ID; atom1 < PADDED_NUM_ATOMS; atom1 += GLOBAL_SIZE) {
-        int atom2 = bondReductionAtoms[atom1];
-        mm_long fx1 = forceBuffers[atom1];
-        mm_long fy1 = forceBuffers[atom1+PADDED_NUM_ATOMS];
-        mm_long fz1 = forceBuffers[atom1+PADDED_NUM_ATOMS*2];
-        if (atom1 != atom2) {
-            real factor = (real) bondReductionFactors[atom1];
+KERNEL void spreadForces(GLOBAL mm_ulong* RESTRICT forceBuffers, GLOBAL real4* RESTRICT posq, GLOBAL const real4* RESTRICT savedPosq,
+        GLOBAL const mm_ulong* RESTRICT savedForces, GLOBAL const int* RESTRICT reductionAtoms, GLOBAL const int* RESTRICT reductionParents,
+        GLOBAL const float* RESTRICT reductionFactors, int start, int end, int includeForces) {
+    for (int index = start+GLOBAL_ID; index < end; index += GLOBAL_SIZE) {
+        int atom1 = reductionAtoms[index];
+        posq[atom1] = savedPosq[index];
+        if (includeForces) {
+            int atom2 = reductionParents[index];
+            real factor = (real) reductionFactors[index];
+            mm_long fx1 = forceBuffers[atom1];
+            mm_long fy1 = forceBuffers[atom1+PADDED_NUM_ATOMS];
+            mm_long fz1 = forceBuffers[atom1+PADDED_NUM_ATOMS*2];
             mm_long fx2 = (mm_long) ((1-factor)*fx1);
             mm_long fy2 = (mm_long) ((1-factor)*fy1);
             mm_long fz2 = (mm_long) ((1-factor)*fz1);
-            ATOMIC_ADD(&tempForceBuffers[atom2], (mm_ulong) fx2);
-            ATOMIC_ADD(&tempForceBuffers[atom2+PADDED_NUM_ATOMS], (mm_ulong) fy2);
-            ATOMIC_ADD(&tempForceBuffers[atom2+PADDED_NUM_ATOMS*2], (mm_ulong) fz2);
-            fx1 = (mm_long) (factor*fx1);
-            fy1 = (mm_long) (factor*fy1);
-            fz1 = (mm_long) (factor*fz1);
+            ATOMIC_ADD(&forceBuffers[atom2], (mm_ulong) fx2);
+            ATOMIC_ADD(&forceBuffers[atom2+PADDED_NUM_ATOMS], (mm_ulong) fy2);
+            ATOMIC_ADD(&forceBuffers[atom2+PADDED_NUM_ATOMS*2], (mm_ulong) fz2);
+            forceBuffers[atom1] = savedForces[3*index] + (mm_ulong) ((mm_long) (factor*fx1));
+            forceBuffers[atom1+PADDED_NUM_ATOMS] = savedForces[3*index+1] + (mm_ulong) ((mm_long) (factor*fy1));
+            forceBuffers[atom1+PADDED_NUM_ATOMS*2] = savedForces[3*index+2] + (mm_ulong) ((mm_long) (factor*fz1));
         }
-        ATOMIC_ADD(&tempForceBuffers[atom1], (mm_ulong) fx1);
-        ATOMIC_ADD(&tempForceBuffers[atom1+PADDED_NUM_ATOMS], (mm_ulong) fy1);
-        ATOMIC_ADD(&tempForceBuffers[atom1+PADDED_NUM_ATOMS*2], (mm_ulong) fz1);
     }
 }
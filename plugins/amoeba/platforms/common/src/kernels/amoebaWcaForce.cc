@@ -239,19 +239,34 @@ KERNEL void computeWCAForce(GLOBAL mm_ulong* RESTRICT forceBuffers, GLOBAL mixed
             unsigned int tj = tgx;
             for (unsigned int j = 0; j < TILE_SIZE; j++) {
                 int atom2 = y*TILE_SIZE+tj;
+#ifdef USE_CUTOFF
+                real3 delta = data.pos-localData[tbx+tj].pos;
+                real r2 = dot(delta, delta);
+                if (atom1 != atom2 && atom1 < NUM_ATOMS && atom2 < NUM_ATOMS && r2 < CUTOFF_SQUARED) {
+#else
                 if (atom1 != atom2 && atom1 < NUM_ATOMS && atom2 < NUM_ATOMS) {
-                    real3 tempForce;
-                    real tempEnergy;
-                    computeOneInteraction(data, localData[tbx+tj], rmixo, rmixh, emixo, emixh, &tempForce, &tempEnergy);
-                    data.force += tempForce;
-                    localData[tbx+tj].force -= tempForce;
-                    energy += (x == y ? 0.5f*tempEnergy : tempEnergy);
+#endif
+                    real3 tempForce, pairForce;
+                    real tempEnergy, pairEnergy;
+                    computeOneInteraction(data, localData[tbx+tj], rmixo, rmixh, emixo, emixh, &pairForce, &pairEnergy);
                     real emjxo, emjxh, rmjxo, rmjxh;
                     initParticleParameters(localData[tbx+tj].radius, localData[tbx+tj].epsilon, &rmjxo, &rmjxh, &emjxo, &emjxh);
                     computeOneInteraction(localData[tbx+tj], data, rmjxo, rmjxh, emjxo, emjxh, &tempForce, &tempEnergy);
-                    data.force -= tempForce;
-                    localData[tbx+tj].force += tempForce;
-                    energy += (x == y ? 0.5f*tempEnergy : tempEnergy);
+                    pairForce -= tempForce;
+                    pairEnergy += tempEnergy;
+#ifdef USE_CUTOFF
+                    real r = SQRT(r2);
+                    if (r > TAPER_CUTOFF) {
+                        real t = r-TAPER_CUTOFF;
+                        real taper = 1+t*t*t*(TAPER_C3+t*(TAPER_C4+t*TAPER_C5));
+                        real dtaper = t*t*(3*TAPER_C3+t*(4*TAPER_C4+t*5*TAPER_C5));
+                        pairForce = pairForce*taper + delta*(AWATER*pairEnergy*dtaper/r);
+                        pairEnergy *= taper;
+                    }
+#endif
+                    data.force += pairForce;
+                    localData[tbx+tj].force -= pairForce;
+                    energy += (x == y ? 0.5f*pairEnergy : pairEnergy);
                 }
                 tj = (tj+1) & (TILE_SIZE-1);
                 SYNC_WARPS;
@@ -217,6 +217,9 @@
         atom1.quadrupoleYZ*(atom2.quadrupoleXX*gqxx29 + atom2.quadrupoleYY*gqyy29 + atom2.quadrupoleZZ*gqzz29 + 2*(atom2.quadrupoleXY*gqxy29 + atom2.quadrupoleXZ*gqxz29 + atom2.quadrupoleYZ*gqyz29)));
 
     dsumdrB1 *= 0.5f;
+#ifdef USE_GK_CUTOFF
+    dsumdrB1 *= taper;
+#endif
     *bornForce1 += atom2.bornRadius*dsumdrB1;
     *bornForce2 += atom1.bornRadius*dsumdrB1;
 #endif
@@ -530,6 +533,11 @@
         trq2 -= (atom1.quadrupoleXZ*fidg11 + atom1.quadrupoleYZ*fidg12 + atom1.quadrupoleZZ*fidg13 -atom1.quadrupoleXX*fidg13-atom1.quadrupoleXY*fidg23-atom1.quadrupoleXZ*fidg33);
         trq3 -= (atom1.quadrupoleXX*fidg12 + atom1.quadrupoleXY*fidg22 + atom1.quadrupoleXZ*fidg23 -atom1.quadrupoleXY*fidg11-atom1.quadrupoleYY*fidg12-atom1.quadrupoleYZ*fidg13);
 
+#ifdef USE_GK_CUTOFF
+        trq1 *= taper;
+        trq2 *= taper;
+        trq3 *= taper;
+#endif
         torque->x = trq1;
         torque->y = trq2;
         torque->z = trq3;
@@ -544,6 +552,9 @@
 
 #if defined B2 
     dsumdrB2 *= 0.5f;
+#ifdef USE_GK_CUTOFF
+    dsumdrB2 *= taper;
+#endif
     *bornForce1 += 0.5f*atom2.bornRadius*dsumdrB2;
     *bornForce2 += 0.5f*atom1.bornRadius*dsumdrB2;
 #endif
@@ -567,12 +578,23 @@
     trqi3 -= atom1.quadrupoleXX*fidg12 + atom1.quadrupoleXY*fidg22 + atom1.quadrupoleXZ*fidg23
                                 -atom1.quadrupoleXY*fidg11 - atom1.quadrupoleYY*fidg12 - atom1.quadrupoleYZ*fidg13;
 
+#ifdef USE_GK_CUTOFF
+    trqi1 *= taper;
+    trqi2 *= taper;
+    trqi3 *= taper;
+#endif
     torque->x += 0.5f*trqi1;
     torque->y += 0.5f*trqi2;
     torque->z += 0.5f*trqi3;
 #endif
 
 #if defined F1
+#ifdef USE_GK_CUTOFF
+    dedx = dedx*taper + energy*dtaper*xr;
+    dedy = dedy*taper + energy*dtaper*yr;
+    dedz = dedz*taper + energy*dtaper*zr;
+    energy *= taper;
+#endif
 
     *outputEnergy = energy;
 
@@ -587,11 +609,30 @@
 #endif
 
 #if defined F2
-    *outputEnergy += 0.5f*energy;
-
     dpdx *= 0.5f;
     dpdy *= 0.5f;
     dpdz *= 0.5f;
+#ifdef USE_GK_CUTOFF
+    // The derivative of the taper multiplies this pair's contribution to the polarization energy
+    // functional, which involves both sets of induced dipoles and, except for direct polarization,
+    // the interaction between them.
+
+    real pairEnergy = 0.5f*energyS;
+#ifndef DIRECT_POLARIZATION
+    real dipoleR1 = atom1.inducedDipole.x*xr + atom1.inducedDipole.y*yr + atom1.inducedDipole.z*zr;
+    real dipoleR2 = atom2.inducedDipole.x*xr + atom2.inducedDipole.y*yr + atom2.inducedDipole.z*zr;
+    real polarR1 = atom1.inducedDipolePolar.x*xr + atom1.inducedDipolePolar.y*yr + atom1.inducedDipolePolar.z*zr;
+    real polarR2 = atom2.inducedDipolePolar.x*xr + atom2.inducedDipolePolar.y*yr + atom2.inducedDipolePolar.z*zr;
+    real dipolePolar12 = atom1.inducedDipole.x*atom2.inducedDipolePolar.x + atom1.inducedDipole.y*atom2.inducedDipolePolar.y + atom1.inducedDipole.z*atom2.inducedDipolePolar.z;
+    real dipolePolar21 = atom2.inducedDipole.x*atom1.inducedDipolePolar.x + atom2.inducedDipole.y*atom1.inducedDipolePolar.y + atom2.inducedDipole.z*atom1.inducedDipolePolar.z;
+    pairEnergy -= a10*(dipolePolar12 + dipolePolar21) + a11*(dipoleR1*polarR2 + dipoleR2*polarR1);
+#endif
+    dpdx = dpdx*taper + pairEnergy*dtaper*xr;
+    dpdy = dpdy*taper + pairEnergy*dtaper*yr;
+    dpdz = dpdz*taper + pairEnergy*dtaper*zr;
+    energy *= taper;
+#endif
+    *outputEnergy += 0.5f*energy;
 
     if ((xr != 0 || yr != 0 || zr != 0)) {
         force->x += dpdx;
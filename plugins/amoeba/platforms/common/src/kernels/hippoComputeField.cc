@@ -51,6 +51,32 @@ typedef struct {
     ATOM_PARAMETER_DATA
 } AtomData;
 
+// Exceptions are handled as part of the exclusion tiles.  Each pair belongs to a class that selects its
+// scale factors, where class 0 means no exception.  The class index is stored as one bitmask per bit,
+// laid out like the exclusion masks, so it gets shifted along with them.
+
+#if NUM_EXCEPTION_CLASS_BITS > 0
+#define LOAD_EXCEPTION_FLAGS(index) \
+    unsigned int exceptionFlags[NUM_EXCEPTION_CLASS_BITS]; \
+    for (int bit = 0; bit < NUM_EXCEPTION_CLASS_BITS; bit++) \
+        exceptionFlags[bit] = exceptionClassFlags[(index)*NUM_EXCEPTION_CLASS_BITS+bit];
+#define ROTATE_EXCEPTION_FLAGS \
+    for (int bit = 0; bit < NUM_EXCEPTION_CLASS_BITS; bit++) \
+        exceptionFlags[bit] = (exceptionFlags[bit] >> tgx) | (exceptionFlags[bit] << (TILE_SIZE - tgx));
+#define EXTRACT_EXCEPTION_CLASS \
+    int exceptionClass = 0; \
+    for (int bit = 0; bit < NUM_EXCEPTION_CLASS_BITS; bit++) { \
+        exceptionClass |= (exceptionFlags[bit] & 0x1) << bit; \
+        exceptionFlags[bit] >>= 1; \
+    }
+#define LOAD_EXCEPTION_SCALE real scale = exceptionClassScales[6*exceptionClass+FIELD_SCALE_INDEX];
+#else
+#define LOAD_EXCEPTION_FLAGS(index)
+#define ROTATE_EXCEPTION_FLAGS
+#define EXTRACT_EXCEPTION_CLASS const int exceptionClass = 0;
+#define LOAD_EXCEPTION_SCALE const real scale = 1;
+#endif
+
 /**
  * Compute the electrostatic field.
  */
@@ -62,6 +88,9 @@ KERNEL void computeField(GLOBAL const real4* RESTRICT posq, GLOBAL const unsigne
         GLOBAL const real4* RESTRICT blockSize, GLOBAL const unsigned int* RESTRICT interactingAtoms
 #else
         unsigned int numTiles
+#endif
+#if NUM_EXCEPTION_CLASS_BITS > 0
+        , GLOBAL const unsigned int* RESTRICT exceptionClassFlags, GLOBAL const real* RESTRICT exceptionClassScales
 #endif
         PARAMETER_ARGUMENTS) {
     const unsigned int totalWarps = (GLOBAL_SIZE)/TILE_SIZE;
@@ -83,6 +112,7 @@ KERNEL void computeField(GLOBAL const real4* RESTRICT posq, GLOBAL const unsigne
         real4 pos1 = posq[atom1];
         LOAD_ATOM1_PARAMETERS
         unsigned int excl = exclusions[tile*TILE_SIZE+tgx];
+        LOAD_EXCEPTION_FLAGS(tile*TILE_SIZE+tgx)
         if (x == y) {
             // This tile is on the diagonal.
 
@@ -100,6 +130,7 @@ KERNEL void computeField(GLOBAL const real4* RESTRICT posq, GLOBAL const unsigne
                 APPLY_PERIODIC_TO_DELTA(delta)
 #endif
                 real r2 = delta.x*delta.x + delta.y*delta.y + delta.z*delta.z;
+                EXTRACT_EXCEPTION_CLASS
 #ifdef USE_CUTOFF
                 if (r2 < CUTOFF_SQUARED) {
 #endif
@@ -109,7 +140,8 @@ KERNEL void computeField(GLOBAL const real4* RESTRICT posq, GLOBAL const unsigne
                     atom2 = y*TILE_SIZE+j;
                     real3 tempField1 = make_real3(0);
                     real3 tempField2 = make_real3(0);
-                    bool isExcluded = (atom1 >= NUM_ATOMS || atom2 >= NUM_ATOMS || !(excl & 0x1));
+                    bool isExcluded = (atom1 >= NUM_ATOMS || atom2 >= NUM_ATOMS || (!(excl & 0x1) && exceptionClass == 0));
+                    LOAD_EXCEPTION_SCALE
                     if (!isExcluded && atom1 != atom2) {
                         COMPUTE_FIELD
                     }
@@ -136,6 +168,7 @@ KERNEL void computeField(GLOBAL const real4* RESTRICT posq, GLOBAL const unsigne
             localData[localAtomIndex].fz = 0;
             SYNC_WARPS;
             excl = (excl >> tgx) | (excl << (TILE_SIZE - tgx));
+            ROTATE_EXCEPTION_FLAGS
             unsigned int tj = tgx;
             for (j = 0; j < TILE_SIZE; j++) {
                 int atom2 = tbx+tj;
@@ -145,6 +178,7 @@ KERNEL void computeField(GLOBAL const real4* RESTRICT posq, GLOBAL const unsigne
                 APPLY_PERIODIC_TO_DELTA(delta)
 #endif
                 real r2 = delta.x*delta.x + delta.y*delta.y + delta.z*delta.z;
+                EXTRACT_EXCEPTION_CLASS
 #ifdef USE_CUTOFF
                 if (r2 < CUTOFF_SQUARED) {
 #endif
@@ -154,7 +188,8 @@ KERNEL void computeField(GLOBAL const real4* RESTRICT posq, GLOBAL const unsigne
                     atom2 = y*TILE_SIZE+tj;
                     real3 tempField1 = make_real3(0);
                     real3 tempField2 = make_real3(0);
-                    bool isExcluded = (atom1 >= NUM_ATOMS || atom2 >= NUM_ATOMS || !(excl & 0x1));
+                    bool isExcluded = (atom1 >= NUM_ATOMS || atom2 >= NUM_ATOMS || (!(excl & 0x1) && exceptionClass == 0));
+                    LOAD_EXCEPTION_SCALE
                     if (!isExcluded) {
                         COMPUTE_FIELD
                     }
@@ -254,7 +289,7 @@ KERNEL void computeField(GLOBAL const real4* RESTRICT posq, GLOBAL const unsigne
             LOAD_ATOM1_PARAMETERS
             const unsigned int localAtomIndex = LOCAL_ID;
 #ifdef USE_CUTOFF
-            unsigned int j = interactingAtoms[tile*TILE_SIZE+tgx];
+            unsigned int j = interactingAtoms[((mm_long) tile)*TILE_SIZE+tgx];
 #else
             unsigned int j = y*TILE_SIZE + tgx;
 #endif
@@ -292,6 +327,7 @@ KERNEL void computeField(GLOBAL const real4* RESTRICT posq, GLOBAL const unsigne
                         atom2 = atomIndices[tbx+tj];
                         real3 tempField1 = make_real3(0);
                         real3 tempField2 = make_real3(0);
+                        const real scale = 1;
                         if (atom1 < NUM_ATOMS && atom2 < NUM_ATOMS) {
                             COMPUTE_FIELD
                         }
@@ -327,6 +363,7 @@ KERNEL void computeField(GLOBAL const real4* RESTRICT posq, GLOBAL const unsigne
                         atom2 = atomIndices[tbx+tj];
                         real3 tempField1 = make_real3(0);
                         real3 tempField2 = make_real3(0);
+                        const real scale = 1;
                         if (atom1 < NUM_ATOMS && atom2 < NUM_ATOMS) {
                             COMPUTE_FIELD
                         }
@@ -361,48 +398,3 @@ KERNEL void computeField(GLOBAL const real4* RESTRICT posq, GLOBAL const unsigne
         tile++;
     }
 }
-
-#define COMPUTING_EXCEPTIONS
-
-/**
- * Compute the electrostatic field from nonbonded exceptions.
- */
-KERNEL void computeFieldExceptions(GLOBAL const real4* RESTRICT posq, GLOBAL mm_ulong* RESTRICT fieldBuffers,
-        GLOBAL const int2* RESTRICT exceptionAtoms, GLOBAL const real* RESTRICT exceptionScale
-#ifdef USE_CUTOFF
-        , real4 periodicBoxSize, real4 invPeriodicBoxSize, real4 periodicBoxVecX, real4 periodicBoxVecY, real4 periodicBoxVecZ
-#endif
-        PARAMETER_ARGUMENTS) {
-    for (int index = GLOBAL_ID; index < NUM_EXCEPTIONS; index += GLOBAL_SIZE) {
-        int2 atoms = exceptionAtoms[index];
-        int atom1 = atoms.x;
-        int atom2 = atoms.y;
-        real4 pos1 = posq[atom1];
-        real4 pos2 = posq[atom2];
-        LOAD_ATOM1_PARAMETERS
-        LOAD_ATOM2_PARAMETERS_FROM_GLOBAL
-        real scale = exceptionScale[index];
-        real3 delta = make_real3(pos2.x-pos1.x, pos2.y-pos1.y, pos2.z-pos1.z);
-#ifdef USE_PERIODIC
-        APPLY_PERIODIC_TO_DELTA(delta)
-#endif
-        real r2 = delta.x*delta.x + delta.y*delta.y + delta.z*delta.z;
-#ifdef USE_CUTOFF
-        if (r2 < CUTOFF_SQUARED) {
-#endif
-            real invR = RSQRT(r2);
-            real r = r2*invR;
-            real3 tempField1 = make_real3(0);
-            real3 tempField2 = make_real3(0);
-            COMPUTE_FIELD
-            ATOMIC_ADD(&fieldBuffers[atom1], (mm_ulong) realToFixedPoint(tempField1.x));
-            ATOMIC_ADD(&fieldBuffers[atom1+PADDED_NUM_ATOMS], (mm_ulong) realToFixedPoint(tempField1.y));
-            ATOMIC_ADD(&fieldBuffers[atom1+2*PADDED_NUM_ATOMS], (mm_ulong) realToFixedPoint(tempField1.z));
-            ATOMIC_ADD(&fieldBuffers[atom2], (mm_ulong) realToFixedPoint(tempField2.x));
-            ATOMIC_ADD(&fieldBuffers[atom2+PADDED_NUM_ATOMS], (mm_ulong) realToFixedPoint(tempField2.y));
-            ATOMIC_ADD(&fieldBuffers[atom2+2*PADDED_NUM_ATOMS], (mm_ulong) realToFixedPoint(tempField2.z));
-#ifdef USE_CUTOFF
-        }
-#endif
-    }
-}
\ No newline at end of file
@@ -33,9 +33,6 @@ real bn3 = (5*bn2+alsq2n*exp2a)*invR2;
 
 real fdamp3, fdamp5, fdamp7;
 computeDirectFieldDampingFactors(alpha2, r, &fdamp3, &fdamp5, &fdamp7);
-#ifndef COMPUTING_EXCEPTIONS
-real scale = 1;
-#endif
 #ifdef USE_EWALD
 real rr3 = bn1 - (1-scale)*invR3;
 real rr3j = bn1 - (1-scale*fdamp3)*invR3;
@@ -108,9 +108,6 @@ real bn5 = (9*bn4+alsq2n*exp2a)*rInv2;
     real term3ik = valenceCharge1*qkr + valenceCharge2*qir - dir*dkr + 2*(dkqi-diqk+qiqk);
     real term4ik = dir*qkr - dkr*qir - 4*qik;
     real term5ik = qir*qkr;
-#ifndef COMPUTING_EXCEPTIONS
-    real multipoleMultipoleScale = 1;
-#endif
 #if USE_EWALD
     real rr1i = bn0 - (1-multipoleMultipoleScale*fdampI1)*rr1;
     real rr3i = bn1 - (1-multipoleMultipoleScale*fdampI3)*rr3;
@@ -186,10 +183,6 @@ real bn5 = (9*bn4+alsq2n*exp2a)*rInv2;
 
     // Apply charge penetration damping to scale factors.
 
-#ifndef COMPUTING_EXCEPTIONS
-    real dipoleMultipoleScale = 1;
-    real dipoleDipoleScale = 1;
-#endif
 #if USE_EWALD
     real rr3core = ENERGY_SCALE_FACTOR*(bn1 - (1-dipoleMultipoleScale)*rr3);
     real rr5core = ENERGY_SCALE_FACTOR*(bn2 - (1-dipoleMultipoleScale)*rr5);
@@ -337,9 +330,7 @@ real bn5 = (9*bn4+alsq2n*exp2a)*rInv2;
     // Compute the energy.
 
     real sizik = pauliK1*pauliK2;
-#ifdef COMPUTING_EXCEPTIONS
     sizik *= repulsionScale;
-#endif
     real repEnergy = sizik*eterm*rr1;
 
     // Calculate intermediate terms for force and torque
@@ -383,9 +374,6 @@ real bn5 = (9*bn4+alsq2n*exp2a)*rInv2;
 
 {
     real rInv6 = rInv2*rInv2*rInv2;
-#ifndef COMPUTING_EXCEPTIONS
-    real dispersionScale = 1;
-#endif
     real fdamp, ddamp;
     computeDispersionDampingFactors(alpha1, alpha2, r, &fdamp, &ddamp);
 #if USE_EWALD
@@ -424,10 +412,8 @@ real bn5 = (9*bn4+alsq2n*exp2a)*rInv2;
         ctEnergy *= switchValue;
     }
 #endif
-#ifdef COMPUTING_EXCEPTIONS
     ctForce *= chargeTransferScale;
     ctEnergy *= chargeTransferScale;
-#endif
     tempEnergy += ctEnergy;
     tempForce.z += ctForce*r;
 }
@@ -5,6 +5,41 @@
 
 #define WARPS_PER_GROUP (THREAD_BLOCK_SIZE/TILE_SIZE)
 
+// Exceptions are handled as part of the exclusion tiles.  Each pair belongs to a class that selects its
+// scale factors, where class 0 means no exception.  The class index is stored as one bitmask per bit,
+// laid out like the exclusion masks, so it gets shifted along with them.
+
+#if NUM_EXCEPTION_CLASS_BITS > 0
+#define LOAD_EXCEPTION_FLAGS(index) \
+    unsigned int exceptionFlags[NUM_EXCEPTION_CLASS_BITS]; \
+    for (int bit = 0; bit < NUM_EXCEPTION_CLASS_BITS; bit++) \
+        exceptionFlags[bit] = exceptionClassFlags[(index)*NUM_EXCEPTION_CLASS_BITS+bit];
+#define ROTATE_EXCEPTION_FLAGS \
+    for (int bit = 0; bit < NUM_EXCEPTION_CLASS_BITS; bit++) \
+        exceptionFlags[bit] = (exceptionFlags[bit] >> tgx) | (exceptionFlags[bit] << (TILE_SIZE - tgx));
+#define EXTRACT_EXCEPTION_CLASS \
+    int exceptionClass = 0; \
+    for (int bit = 0; bit < NUM_EXCEPTION_CLASS_BITS; bit++) { \
+        exceptionClass |= (exceptionFlags[bit] & 0x1) << bit; \
+        exceptionFlags[bit] >>= 1; \
+    }
+#define LOAD_EXCEPTION_SCALES \
+    real multipoleMultipoleScale = exceptionClassScales[6*exceptionClass]; \
+    real dipoleMultipoleScale = exceptionClassScales[6*exceptionClass+1]; \
+    real dipoleDipoleScale = exceptionClassScales[6*exceptionClass+2]; \
+    real dispersionScale = exceptionClassScales[6*exceptionClass+3]; \
+    real repulsionScale = exceptionClassScales[6*exceptionClass+4]; \
+    real chargeTransferScale = exceptionClassScales[6*exceptionClass+5];
+#else
+#define LOAD_EXCEPTION_FLAGS(index)
+#define ROTATE_EXCEPTION_FLAGS
+#define EXTRACT_EXCEPTION_CLASS const int exceptionClass = 0;
+#define LOAD_EXCEPTION_SCALES DECLARE_UNIT_SCALES
+#endif
+#define DECLARE_UNIT_SCALES \
+    const real multipoleMultipoleScale = 1, dipoleMultipoleScale = 1, dipoleDipoleScale = 1; \
+    const real dispersionScale = 1, repulsionScale = 1, chargeTransferScale = 1;
+
 #ifndef ENABLE_SHUFFLE
 typedef struct {
     real x, y, z;
@@ -88,6 +123,7 @@ KERNEL void computeNonbonded(
         real4 posq1 = posq[atom1];
         LOAD_ATOM1_PARAMETERS
         unsigned int excl = exclusions[pos*TILE_SIZE+tgx];
+        LOAD_EXCEPTION_FLAGS(pos*TILE_SIZE+tgx)
         const bool hasExclusions = true;
         if (x == y) {
             // This tile is on the diagonal.
@@ -124,7 +160,9 @@ KERNEL void computeNonbonded(
                 real3 tempForce = make_real3(0);
                 real3 tempTorque1 = make_real3(0);
                 real3 tempTorque2 = make_real3(0);
-                bool isExcluded = (atom1 >= NUM_ATOMS || atom2 >= NUM_ATOMS || !(excl & 0x1));
+                EXTRACT_EXCEPTION_CLASS
+                bool isExcluded = (atom1 >= NUM_ATOMS || atom2 >= NUM_ATOMS || (!(excl & 0x1) && exceptionClass == 0));
+                LOAD_EXCEPTION_SCALES
                 real tempEnergy = 0.0f;
                 const real interactionScale = 0.5f;
                 COMPUTE_INTERACTION
@@ -158,6 +196,7 @@ KERNEL void computeNonbonded(
             LOAD_LOCAL_PARAMETERS_FROM_GLOBAL
             SYNC_WARPS;
             excl = (excl >> tgx) | (excl << (TILE_SIZE - tgx));
+            ROTATE_EXCEPTION_FLAGS
             unsigned int tj = tgx;
             for (j = 0; j < TILE_SIZE; j++) {
                 int atom2 = tbx+tj;
@@ -178,7 +217,9 @@ KERNEL void computeNonbonded(
                 real3 tempForce = make_real3(0);
                 real3 tempTorque1 = make_real3(0);
                 real3 tempTorque2 = make_real3(0);
-                bool isExcluded = (atom1 >= NUM_ATOMS || atom2 >= NUM_ATOMS || !(excl & 0x1));
+                EXTRACT_EXCEPTION_CLASS
+                bool isExcluded = (atom1 >= NUM_ATOMS || atom2 >= NUM_ATOMS || (!(excl & 0x1) && exceptionClass == 0));
+                LOAD_EXCEPTION_SCALES
                 real tempEnergy = 0.0f;
                 const real interactionScale = 1.0f;
                 COMPUTE_INTERACTION
@@ -305,7 +346,7 @@ KERNEL void computeNonbonded(
             real4 posq1 = posq[atom1];
             LOAD_ATOM1_PARAMETERS
 #ifdef USE_CUTOFF
-            unsigned int j = interactingAtoms[pos*TILE_SIZE+tgx];
+            unsigned int j = interactingAtoms[((mm_long) pos)*TILE_SIZE+tgx];
 #else
             unsigned int j = y*TILE_SIZE + tgx;
 #endif
@@ -374,6 +415,7 @@ KERNEL void computeNonbonded(
                     real3 tempTorque1 = make_real3(0);
                     real3 tempTorque2 = make_real3(0);
                     bool isExcluded = (atom1 >= NUM_ATOMS || atom2 >= NUM_ATOMS);
+                    DECLARE_UNIT_SCALES
                     real tempEnergy = 0.0f;
                     const real interactionScale = 1.0f;
                     COMPUTE_INTERACTION
@@ -424,6 +466,7 @@ KERNEL void computeNonbonded(
                     real3 tempTorque1 = make_real3(0);
                     real3 tempTorque2 = make_real3(0);
                     bool isExcluded = (atom1 >= NUM_ATOMS || atom2 >= NUM_ATOMS);
+                    DECLARE_UNIT_SCALES
                     real tempEnergy = 0.0f;
                     const real interactionScale = 1.0f;
                     COMPUTE_INTERACTION
@@ -16,22 +16,32 @@ typedef struct ALIGN {
 #endif
 } AtomData;
 
-inline DEVICE AtomData loadAtomData(int atom, GLOBAL const real4* RESTRICT posq, GLOBAL const real* RESTRICT sphericalDipole,
-        GLOBAL const real* RESTRICT sphericalQuadrupole, GLOBAL const real* RESTRICT inducedDipole, GLOBAL const real* RESTRICT inducedDipolePolar,
+/**
+ * Load the data for an atom.  The spherical harmonic multipoles are built here from the lab frame
+ * Cartesian ones, rather than being computed and stored in a separate pass.
+ */
+inline DEVICE AtomData loadAtomData(int atom, GLOBAL const real4* RESTRICT posq, GLOBAL const real* RESTRICT labFrameDipole,
+        GLOBAL const real* RESTRICT labFrameQuadrupole, GLOBAL const real* RESTRICT inducedDipole, GLOBAL const real* RESTRICT inducedDipolePolar,
         GLOBAL const float2* RESTRICT dampingAndThole) {
     AtomData data;
     real4 atomPosq = posq[atom];
     data.pos = make_real3(atomPosq.x, atomPosq.y, atomPosq.z);
     data.q = atomPosq.w;
-    data.sphericalDipole.x = sphericalDipole[atom*3];
-    data.sphericalDipole.y = sphericalDipole[atom*3+1];
-    data.sphericalDipole.z = sphericalDipole[atom*3+2];
+    data.sphericalDipole.x = labFrameDipole[atom*3+2]; // z -> Q_10
+    data.sphericalDipole.y = labFrameDipole[atom*3];   // x -> Q_11c
+    data.sphericalDipole.z = labFrameDipole[atom*3+1]; // y -> Q_11s
 #ifdef INCLUDE_QUADRUPOLES
-    data.sphericalQuadrupole[0] = sphericalQuadrupole[atom*5];
-    data.sphericalQuadrupole[1] = sphericalQuadrupole[atom*5+1];
-    data.sphericalQuadrupole[2] = sphericalQuadrupole[atom*5+2];
-    data.sphericalQuadrupole[3] = sphericalQuadrupole[atom*5+3];
-    data.sphericalQuadrupole[4] = sphericalQuadrupole[atom*5+4];
+    real sqrtThree = SQRT((real) 3);
+    real qXX = labFrameQuadrupole[atom*5];
+    real qXY = labFrameQuadrupole[atom*5+1];
+    real qXZ = labFrameQuadrupole[atom*5+2];
+    real qYY = labFrameQuadrupole[atom*5+3];
+    real qYZ = labFrameQuadrupole[atom*5+4];
+    data.sphericalQuadrupole[0] = -3*(qXX+qYY);        // zz -> Q_20
+    data.sphericalQuadrupole[1] = 2*sqrtThree*qXZ;     // xz -> Q_21c
+    data.sphericalQuadrupole[2] = 2*sqrtThree*qYZ;     // yz -> Q_21s
+    data.sphericalQuadrupole[3] = sqrtThree*(qXX-qYY); // xx-yy -> Q_22c
+    data.sphericalQuadrupole[4] = 2*sqrtThree*qXY;     // xy -> Q_22s
 #endif
     data.inducedDipole = make_real3(inducedDipole[3*atom], inducedDipole[3*atom+1], inducedDipole[3*atom+2]);
     data.inducedDipolePolar = make_real3(inducedDipolePolar[3*atom], inducedDipolePolar[3*atom+1], inducedDipolePolar[3*atom+2]);
@@ -394,7 +404,7 @@ KERNEL void computeElectrostatics(
         real4 periodicBoxVecX, real4 periodicBoxVecY, real4 periodicBoxVecZ, unsigned int maxTiles, GLOBAL const real4* RESTRICT blockCenter,
         GLOBAL const unsigned int* RESTRICT interactingAtoms,
 #endif
-        GLOBAL const real* RESTRICT sphericalDipole, GLOBAL const real* RESTRICT sphericalQuadrupole, GLOBAL const real* RESTRICT inducedDipole,
+        GLOBAL const real* RESTRICT labFrameDipole, GLOBAL const real* RESTRICT labFrameQuadrupole, GLOBAL const real* RESTRICT inducedDipole,
         GLOBAL const real* RESTRICT inducedDipolePolar, GLOBAL const float2* RESTRICT dampingAndThole) {
     const unsigned int totalWarps = (GLOBAL_SIZE)/TILE_SIZE;
     const unsigned int warp = (GLOBAL_ID)/TILE_SIZE;
@@ -412,7 +422,7 @@ KERNEL void computeElectrostatics(
         const unsigned int x = tileIndices.x;
         const unsigned int y = tileIndices.y;
         unsigned int atom1 = x*TILE_SIZE + tgx;
-        AtomData data = loadAtomData(atom1, posq, sphericalDipole, sphericalQuadrupole, inducedDipole, inducedDipolePolar, dampingAndThole);
+        AtomData data = loadAtomData(atom1, posq, labFrameDipole, labFrameQuadrupole, inducedDipole, inducedDipolePolar, dampingAndThole);
         data.force = make_real3(0);
         data.torque = make_real3(0);
         uint2 covalent = covalentFlags[pos*TILE_SIZE+tgx];
@@ -461,7 +471,7 @@ KERNEL void computeElectrostatics(
             // This is an off-diagonal tile.
 
             unsigned int j = y*TILE_SIZE + tgx;
-            localData[LOCAL_ID] = loadAtomData(j, posq, sphericalDipole, sphericalQuadrupole, inducedDipole, inducedDipolePolar, dampingAndThole);
+            localData[LOCAL_ID] = loadAtomData(j, posq, labFrameDipole, labFrameQuadrupole, inducedDipole, inducedDipolePolar, dampingAndThole);
             localData[LOCAL_ID].force = make_real3(0);
             localData[LOCAL_ID].torque = make_real3(0);
             unsigned int tj = tgx;
@@ -558,16 +568,16 @@ KERNEL void computeElectrostatics(
 
             // Load atom data for this tile.
 
-            AtomData data = loadAtomData(atom1, posq, sphericalDipole, sphericalQuadrupole, inducedDipole, inducedDipolePolar, dampingAndThole);
+            AtomData data = loadAtomData(atom1, posq, labFrameDipole, labFrameQuadrupole, inducedDipole, inducedDipolePolar, dampingAndThole);
             data.force = make_real3(0);
             data.torque = make_real3(0);
 #ifdef USE_CUTOFF
-            unsigned int j = interactingAtoms[pos*TILE_SIZE+tgx];
+            unsigned int j = interactingAtoms[((mm_long) pos)*TILE_SIZE+tgx];
 #else
             unsigned int j = y*TILE_SIZE + tgx;
 #endif
             atomIndices[LOCAL_ID] = j;
-            localData[LOCAL_ID] = loadAtomData(j, posq, sphericalDipole, sphericalQuadrupole, inducedDipole, inducedDipolePolar, dampingAndThole);
+            localData[LOCAL_ID] = loadAtomData(j, posq, labFrameDipole, labFrameQuadrupole, inducedDipole, inducedDipolePolar, dampingAndThole);
             localData[LOCAL_ID].force = make_real3(0);
             localData[LOCAL_ID].torque = make_real3(0);
             SYNC_THREADS;
@@ -281,6 +281,13 @@ DEVICE void computeOneGkInteraction(AtomData* atom1, LOCAL_ARG AtomData* atom2,
     real yr2 = delta.y*delta.y;
     real zr2 = delta.z*delta.z;
     real r2 = xr2 + yr2 + zr2;
+#ifdef USE_GK_CUTOFF
+    if (r2 > GK_CUTOFF_SQUARED) {
+        fields[0] = make_real3(0);
+        fields[1] = make_real3(0);
+        return;
+    }
+#endif
 
     real rb2 = atom1->bornRadius*atom2->bornRadius;
     real expterm = EXP(-r2/(GK_C*rb2));
@@ -441,6 +448,17 @@ DEVICE void computeOneGkInteraction(AtomData* atom1, LOCAL_ARG AtomData* atom2,
                                    + qyyi*gqyy[4] + qzzi*gqzz[4]
                                    + 2*(qxyi*gqxy[4]+qxzi*gqxz[4]
                                    + qyzi*gqyz[4]));
+#ifdef USE_GK_CUTOFF
+
+    // Taper the reaction field to zero at the cutoff.
+
+    if (r2 > GK_TAPER_CUTOFF*GK_TAPER_CUTOFF) {
+        real taperDelta = SQRT(r2)-GK_TAPER_CUTOFF;
+        real taper = 1+taperDelta*taperDelta*taperDelta*(GK_TAPER_C3+taperDelta*(GK_TAPER_C4+taperDelta*GK_TAPER_C5));
+        fields[0] *= taper;
+        fields[1] *= taper;
+    }
+#endif
 }
 #endif
 
@@ -682,7 +700,7 @@ KERNEL void computeFixedField(
             data.bornRadius = bornRadii[atom1];
 #endif
 #ifdef USE_CUTOFF
-            unsigned int j = interactingAtoms[pos*TILE_SIZE+tgx];
+            unsigned int j = interactingAtoms[((mm_long) pos)*TILE_SIZE+tgx];
 #else
             unsigned int j = y*TILE_SIZE + tgx;
 #endif
@@ -299,6 +299,10 @@ DEVICE void computeOneInteraction(AtomData* atom1, LOCAL_ARG AtomData* atom2, re
         dDotDelta = rr5*dot(deltaR, atom1->inducedDipolePolarS);
         atom2->fieldPolarS += rr3*atom1->inducedDipolePolarS + dDotDelta*deltaR;
     }
+#ifdef USE_GK_CUTOFF
+    if (r2 > GK_CUTOFF_SQUARED)
+        return;
+#endif
 
     real rb2 = atom1->bornRadius*atom2->bornRadius;
     real expterm = EXP(-r2/(GK_C*rb2));
@@ -313,6 +317,18 @@ DEVICE void computeOneInteraction(AtomData* atom1, LOCAL_ARG AtomData* atom2, re
     real3 gux = GK_FD*make_real3(a10+deltaR.x*deltaR.x*a11, deltaR.x*deltaR.y*a11, deltaR.x*deltaR.z*a11);
     real3 guy = make_real3(gux.y, GK_FD*(a10+deltaR.y*deltaR.y*a11), GK_FD*deltaR.y*deltaR.z*a11);
     real3 guz = make_real3(gux.z, guy.z, GK_FD*(a10+deltaR.z*deltaR.z*a11));
+#ifdef USE_GK_CUTOFF
+
+    // Taper the reaction field to zero at the cutoff.
+
+    if (r2 > GK_TAPER_CUTOFF*GK_TAPER_CUTOFF) {
+        real taperDelta = SQRT(r2)-GK_TAPER_CUTOFF;
+        real taper = 1+taperDelta*taperDelta*taperDelta*(GK_TAPER_C3+taperDelta*(GK_TAPER_C4+taperDelta*GK_TAPER_C5));
+        gux *= taper;
+        guy *= taper;
+        guz *= taper;
+    }
+#endif
  
     atom1->fieldS += atom2->inducedDipoleS.x*gux+atom2->inducedDipoleS.y*guy+atom2->inducedDipoleS.z*guz;
     atom2->fieldS += atom1->inducedDipoleS.x*gux+atom1->inducedDipoleS.y*guy+atom1->inducedDipoleS.z*guz;
@@ -561,7 +577,7 @@ KERNEL void computeInducedField(
 #endif
             zeroAtomData(&data);
 #ifdef USE_CUTOFF
-            unsigned int j = interactingAtoms[pos*TILE_SIZE+tgx];
+            unsigned int j = interactingAtoms[((mm_long) pos)*TILE_SIZE+tgx];
 #else
             unsigned int j = y*TILE_SIZE + tgx;
 #endif
@@ -605,14 +621,14 @@ KERNEL void computeInducedField(
 }
 
 KERNEL void recordInducedDipolesForDIIS(GLOBAL const mm_long* RESTRICT fixedField, GLOBAL const mm_long* RESTRICT fixedFieldPolar,
-        GLOBAL const float* RESTRICT polarizability, GLOBAL float2* RESTRICT errors, GLOBAL real* RESTRICT prevErrors, GLOBAL real* RESTRICT matrix,
+        GLOBAL const float* RESTRICT polarizability, GLOBAL float2* RESTRICT errors, GLOBAL real* RESTRICT prevErrors, GLOBAL mixed* RESTRICT matrix,
         GLOBAL const mm_long* RESTRICT fixedFieldS, GLOBAL const mm_long* RESTRICT inducedField, GLOBAL const mm_long* RESTRICT inducedFieldPolar,
         GLOBAL const real* RESTRICT inducedDipole, GLOBAL const real* RESTRICT inducedDipolePolar,
         GLOBAL real* RESTRICT prevDipoles, GLOBAL real* RESTRICT prevDipolesPolar, int iteration, int isGK) {
-    LOCAL real2 buffer[64];
+    LOCAL mixed2 buffer[64];
     const real fieldScale = 1/(real) 0x100000000;
-    real sumErrors = 0;
-    real sumPolarErrors = 0;
+    mixed sumErrors = 0;
+    mixed sumPolarErrors = 0;
     for (int atom = GLOBAL_ID; atom < NUM_ATOMS; atom += GLOBAL_SIZE) {
         real scale = polarizability[atom];
         if (iteration >= MAX_PREV_DIIS_DIPOLES) {
@@ -663,7 +679,7 @@ KERNEL void recordInducedDipolesForDIIS(GLOBAL const mm_long* RESTRICT fixedFiel
     
     // Sum the errors over threads and store the total for this block.
     
-    buffer[LOCAL_ID] = make_real2(sumErrors, sumPolarErrors);
+    buffer[LOCAL_ID] = make_mixed2(sumErrors, sumPolarErrors);
     SYNC_THREADS;
     for (int offset = 1; offset < LOCAL_SIZE; offset *= 2) {
         if (LOCAL_ID+offset < LOCAL_SIZE && (LOCAL_ID&(2*offset-1)) == 0) {
@@ -686,15 +702,20 @@ KERNEL void recordInducedDipolesForDIIS(GLOBAL const mm_long* RESTRICT fixedFiel
     }
 }
 
-KERNEL void computeDIISMatrix(GLOBAL real* RESTRICT prevErrors, int iteration, GLOBAL real* RESTRICT matrix) {
-    LOCAL real sumBuffer[512];
+/**
+ * Build the DIIS matrix from the recorded errors.  The errors are stored in real precision, but
+ * the dot products are accumulated in mixed precision so the matrix stays well conditioned even
+ * when the dipoles themselves are single precision.
+ */
+KERNEL void computeDIISMatrix(GLOBAL real* RESTRICT prevErrors, int iteration, GLOBAL mixed* RESTRICT matrix) {
+    LOCAL mixed sumBuffer[512];
     int j = min(iteration, MAX_PREV_DIIS_DIPOLES-1);
     for (int i = GROUP_ID; i <= j; i += NUM_GROUPS) {
         // All the threads in this thread block work together to compute a single matrix element.
 
-        real sum = 0;
+        mixed sum = 0;
         for (int index = LOCAL_ID; index < 3*NUM_ATOMS; index += LOCAL_SIZE)
-            sum += prevErrors[index+i*3*NUM_ATOMS]*prevErrors[index+j*3*NUM_ATOMS];
+            sum += (mixed) prevErrors[index+i*3*NUM_ATOMS]*prevErrors[index+j*3*NUM_ATOMS];
         sumBuffer[LOCAL_ID] = sum;
         SYNC_THREADS;
         for (int offset = 1; offset < LOCAL_SIZE; offset *= 2) { 
@@ -710,10 +731,10 @@ KERNEL void computeDIISMatrix(GLOBAL real* RESTRICT prevErrors, int iteration, G
     }
 }
 
-KERNEL void solveDIISMatrix(int iteration, GLOBAL const real* RESTRICT matrix, GLOBAL float* RESTRICT coefficients) {
-    LOCAL real b[MAX_PREV_DIIS_DIPOLES+1][MAX_PREV_DIIS_DIPOLES+1];
-    LOCAL real piv[MAX_PREV_DIIS_DIPOLES+1];
-    LOCAL real x[MAX_PREV_DIIS_DIPOLES+1];
+KERNEL void solveDIISMatrix(int iteration, GLOBAL const mixed* RESTRICT matrix, GLOBAL float* RESTRICT coefficients) {
+    LOCAL mixed b[MAX_PREV_DIIS_DIPOLES+1][MAX_PREV_DIIS_DIPOLES+1];
+    LOCAL mixed piv[MAX_PREV_DIIS_DIPOLES+1];
+    LOCAL mixed x[MAX_PREV_DIIS_DIPOLES+1];
 
     // On the first iteration we don't need to do any calculation.
     
@@ -742,7 +763,7 @@ KERNEL void solveDIISMatrix(int iteration, GLOBAL const real* RESTRICT matrix, G
     // which is essential for doing the computation in single precision.
     
     if (LOCAL_ID == 0) {
-        real mean = 0;
+        mixed mean = 0;
         for (int i = 0; i < numPrev; i++)
             for (int j = 0; j < numPrev; j++)
                 mean += fabs(b[i+1][j+1]);
@@ -761,7 +782,7 @@ KERNEL void solveDIISMatrix(int iteration, GLOBAL const real* RESTRICT matrix, G
                 // Most of the time is spent in the following dot product.
 
                 int kmax = min(i, j);
-                real s = 0;
+                mixed s = 0;
                 for (int k = 0; k < kmax; k++)
                     s += b[i][k] * b[k][j];
                 b[i][j] -= s;
@@ -776,7 +797,7 @@ KERNEL void solveDIISMatrix(int iteration, GLOBAL const real* RESTRICT matrix, G
             if (p != j) {
                 int k = 0;
                 for (k = 0; k < rank; k++) {
-                    real t = b[p][k];
+                    mixed t = b[p][k];
                     b[p][k] = b[j][k];
                     b[j][k] = t;
                 }
@@ -820,9 +841,9 @@ KERNEL void solveDIISMatrix(int iteration, GLOBAL const real* RESTRICT matrix, G
         
         // Record the coefficients.
         
-        real lastCoeff = 1;
+        mixed lastCoeff = 1;
         for (int i = 0; i < rank-1; i++) {
-            real c = x[i+1]*mean;
+            mixed c = x[i+1]*mean;
             coefficients[i] = c;
             lastCoeff -= c;
         }
@@ -843,6 +864,242 @@ KERNEL void updateInducedFieldByDIIS(GLOBAL real* RESTRICT inducedDipole, GLOBAL
         inducedDipolePolar[index] = sumPolar;
     }
 }
+
+/**
+ * Sum a pair of values over all threads in a block.  Every thread receives the total.
+ */
+DEVICE real2 reducePCGValues(real2 value, LOCAL_ARG real2* buffer) {
+    buffer[LOCAL_ID] = value;
+    SYNC_THREADS;
+    for (int offset = 1; offset < LOCAL_SIZE; offset *= 2) {
+        if (LOCAL_ID+offset < LOCAL_SIZE && (LOCAL_ID&(2*offset-1)) == 0) {
+            buffer[LOCAL_ID].x += buffer[LOCAL_ID+offset].x;
+            buffer[LOCAL_ID].y += buffer[LOCAL_ID+offset].y;
+        }
+        SYNC_THREADS;
+    }
+    real2 result = buffer[0];
+    SYNC_THREADS;
+    return result;
+}
+
+/**
+ * Sum the per-block partial sums written by a previous kernel.
+ */
+DEVICE real2 sumPCGPartials(GLOBAL const real2* RESTRICT partials, LOCAL_ARG real2* buffer) {
+    real2 sum = make_real2(0, 0);
+    for (int i = LOCAL_ID; i < NUM_GROUPS; i += LOCAL_SIZE) {
+        sum.x += partials[i].x;
+        sum.y += partials[i].y;
+    }
+    return reducePCGValues(sum, buffer);
+}
+
+/**
+ * Begin the preconditioned conjugate gradient iteration.  The polarizabilities are used as
+ * a diagonal preconditioner, so the preconditioned residual is the change in dipole that
+ * one Jacobi step would make.  It becomes the first search direction.  Sums for the
+ * convergence test go in errors, and the per-block contributions to r.z go in pcgSums.
+ */
+KERNEL void initializePCGDipoles(GLOBAL const mm_long* RESTRICT fixedField, GLOBAL const mm_long* RESTRICT fixedFieldPolar,
+        GLOBAL const mm_long* RESTRICT inducedField, GLOBAL const mm_long* RESTRICT inducedFieldPolar, GLOBAL const float* RESTRICT polarizability,
+        GLOBAL const real* RESTRICT inducedDipole, GLOBAL const real* RESTRICT inducedDipolePolar, GLOBAL real* RESTRICT pcgDipole,
+        GLOBAL real* RESTRICT pcgDipolePolar, GLOBAL real* RESTRICT pcgResidual, GLOBAL real* RESTRICT pcgResidualPolar,
+        GLOBAL float2* RESTRICT errors, GLOBAL real2* RESTRICT pcgSums) {
+    LOCAL real2 buffer[64];
+    const real fieldScale = 1/(real) 0x100000000;
+    real2 sumErrors = make_real2(0, 0);
+    real2 sumRZ = make_real2(0, 0);
+    for (int atom = GLOBAL_ID; atom < NUM_ATOMS; atom += GLOBAL_SIZE) {
+        real scale = polarizability[atom];
+        real3 dipole = make_real3(inducedDipole[3*atom], inducedDipole[3*atom+1], inducedDipole[3*atom+2]);
+        real3 dipolePolar = make_real3(inducedDipolePolar[3*atom], inducedDipolePolar[3*atom+1], inducedDipolePolar[3*atom+2]);
+        real3 fixed = make_real3(fixedField[atom], fixedField[atom+PADDED_NUM_ATOMS], fixedField[atom+2*PADDED_NUM_ATOMS])*fieldScale;
+        real3 fixedPolar = make_real3(fixedFieldPolar[atom], fixedFieldPolar[atom+PADDED_NUM_ATOMS], fixedFieldPolar[atom+2*PADDED_NUM_ATOMS])*fieldScale;
+        real3 induced = make_real3(inducedField[atom], inducedField[atom+PADDED_NUM_ATOMS], inducedField[atom+2*PADDED_NUM_ATOMS])*fieldScale;
+        real3 inducedPolar = make_real3(inducedFieldPolar[atom], inducedFieldPolar[atom+PADDED_NUM_ATOMS], inducedFieldPolar[atom+2*PADDED_NUM_ATOMS])*fieldScale;
+        real3 residual = scale*(fixed+induced)-dipole;
+        real3 residualPolar = scale*(fixedPolar+inducedPolar)-dipolePolar;
+        for (int i = 0; i < 3; i++) {
+            pcgDipole[3*atom+i] = inducedDipole[3*atom+i];
+            pcgDipolePolar[3*atom+i] = inducedDipolePolar[3*atom+i];
+        }
+        pcgResidual[3*atom] = residual.x;
+        pcgResidual[3*atom+1] = residual.y;
+        pcgResidual[3*atom+2] = residual.z;
+        pcgResidualPolar[3*atom] = residualPolar.x;
+        pcgResidualPolar[3*atom+1] = residualPolar.y;
+        pcgResidualPolar[3*atom+2] = residualPolar.z;
+        real rr = dot(residual, residual);
+        real rrPolar = dot(residualPolar, residualPolar);
+        sumErrors.x += rr;
+        sumErrors.y += rrPolar;
+        if (scale != 0) {
+            sumRZ.x += rr/scale;
+            sumRZ.y += rrPolar/scale;
+        }
+    }
+    sumErrors = reducePCGValues(sumErrors, buffer);
+    sumRZ = reducePCGValues(sumRZ, buffer);
+    if (LOCAL_ID == 0) {
+        errors[GROUP_ID] = make_float2((float) sumErrors.x, (float) sumErrors.y);
+        pcgSums[GROUP_ID] = sumRZ;
+    }
+}
+
+/**
+ * Compute the per-block contributions to p.Ap, where p is the search direction (stored in
+ * inducedDipole) and inducedField holds the field it produces.
+ */
+KERNEL void computePCGProducts(GLOBAL const mm_long* RESTRICT inducedField, GLOBAL const mm_long* RESTRICT inducedFieldPolar,
+        GLOBAL const float* RESTRICT polarizability, GLOBAL const real* RESTRICT inducedDipole, GLOBAL const real* RESTRICT inducedDipolePolar,
+        GLOBAL real2* RESTRICT pcgSums) {
+    LOCAL real2 buffer[64];
+    const real fieldScale = 1/(real) 0x100000000;
+    real2 sum = make_real2(0, 0);
+    for (int atom = GLOBAL_ID; atom < NUM_ATOMS; atom += GLOBAL_SIZE) {
+        real scale = polarizability[atom];
+        if (scale == 0)
+            continue;
+        real3 p = make_real3(inducedDipole[3*atom], inducedDipole[3*atom+1], inducedDipole[3*atom+2]);
+        real3 pPolar = make_real3(inducedDipolePolar[3*atom], inducedDipolePolar[3*atom+1], inducedDipolePolar[3*atom+2]);
+        real3 induced = make_real3(inducedField[atom], inducedField[atom+PADDED_NUM_ATOMS], inducedField[atom+2*PADDED_NUM_ATOMS])*fieldScale;
+        real3 inducedPolar = make_real3(inducedFieldPolar[atom], inducedFieldPolar[atom+PADDED_NUM_ATOMS], inducedFieldPolar[atom+2*PADDED_NUM_ATOMS])*fieldScale;
+        sum.x += dot(p, p)/scale-dot(p, induced);
+        sum.y += dot(pPolar, pPolar)/scale-dot(pPolar, inducedPolar);
+    }
+    sum = reducePCGValues(sum, buffer);
+    if (LOCAL_ID == 0)
+        pcgSums[2*NUM_GROUPS+GROUP_ID] = sum;
+}
+
+/**
+ * Take a step along the search direction and update the preconditioned residual.  The
+ * values of r.z from the previous iteration and this one are double buffered in pcgSums.
+ */
+KERNEL void updatePCGDipoles(GLOBAL const mm_long* RESTRICT inducedField, GLOBAL const mm_long* RESTRICT inducedFieldPolar,
+        GLOBAL const float* RESTRICT polarizability, GLOBAL const real* RESTRICT inducedDipole, GLOBAL const real* RESTRICT inducedDipolePolar,
+        GLOBAL real* RESTRICT pcgDipole, GLOBAL real* RESTRICT pcgDipolePolar, GLOBAL real* RESTRICT pcgResidual, GLOBAL real* RESTRICT pcgResidualPolar,
+        GLOBAL float2* RESTRICT errors, GLOBAL real2* RESTRICT pcgSums, int iteration) {
+    LOCAL real2 buffer[64];
+    const real fieldScale = 1/(real) 0x100000000;
+    real2 rz = sumPCGPartials(&pcgSums[((iteration+1)%2)*NUM_GROUPS], buffer);
+    real2 pAp = sumPCGPartials(&pcgSums[2*NUM_GROUPS], buffer);
+    real stepSize = (pAp.x == 0 ? 0 : rz.x/pAp.x);
+    real stepSizePolar = (pAp.y == 0 ? 0 : rz.y/pAp.y);
+    real2 sumErrors = make_real2(0, 0);
+    real2 sumRZ = make_real2(0, 0);
+    for (int atom = GLOBAL_ID; atom < NUM_ATOMS; atom += GLOBAL_SIZE) {
+        real scale = polarizability[atom];
+        real3 p = make_real3(inducedDipole[3*atom], inducedDipole[3*atom+1], inducedDipole[3*atom+2]);
+        real3 pPolar = make_real3(inducedDipolePolar[3*atom], inducedDipolePolar[3*atom+1], inducedDipolePolar[3*atom+2]);
+        real3 induced = make_real3(inducedField[atom], inducedField[atom+PADDED_NUM_ATOMS], inducedField[atom+2*PADDED_NUM_ATOMS])*fieldScale;
+        real3 inducedPolar = make_real3(inducedFieldPolar[atom], inducedFieldPolar[atom+PADDED_NUM_ATOMS], inducedFieldPolar[atom+2*PADDED_NUM_ATOMS])*fieldScale;
+        real3 residual = make_real3(pcgResidual[3*atom], pcgResidual[3*atom+1], pcgResidual[3*atom+2]);
+        real3 residualPolar = make_real3(pcgResidualPolar[3*atom], pcgResidualPolar[3*atom+1], pcgResidualPolar[3*atom+2]);
+        residual -= stepSize*(p-scale*induced);
+        residualPolar -= stepSizePolar*(pPolar-scale*inducedPolar);
+        pcgDipole[3*atom] += stepSize*p.x;
+        pcgDipole[3*atom+1] += stepSize*p.y;
+        pcgDipole[3*atom+2] += stepSize*p.z;
+        pcgDipolePolar[3*atom] += stepSizePolar*pPolar.x;
+        pcgDipolePolar[3*atom+1] += stepSizePolar*pPolar.y;
+        pcgDipolePolar[3*atom+2] += stepSizePolar*pPolar.z;
+        pcgResidual[3*atom] = residual.x;
+        pcgResidual[3*atom+1] = residual.y;
+        pcgResidual[3*atom+2] = residual.z;
+        pcgResidualPolar[3*atom] = residualPolar.x;
+        pcgResidualPolar[3*atom+1] = residualPolar.y;
+        pcgResidualPolar[3*atom+2] = residualPolar.z;
+        real rr = dot(residual, residual);
+        real rrPolar = dot(residualPolar, residualPolar);
+        sumErrors.x += rr;
+        sumErrors.y += rrPolar;
+        if (scale != 0) {
+            sumRZ.x += rr/scale;
+            sumRZ.y += rrPolar/scale;
+        }
+    }
+    sumErrors = reducePCGValues(sumErrors, buffer);
+    sumRZ = reducePCGValues(sumRZ, buffer);
+    if (LOCAL_ID == 0) {
+        errors[GROUP_ID] = make_float2((float) sumErrors.x, (float) sumErrors.y);
+        pcgSums[(iteration%2)*NUM_GROUPS+GROUP_ID] = sumRZ;
+    }
+}
+
+/**
+ * Compute the new search direction p = z + beta*p.
+ */
+KERNEL void updatePCGSearchDirection(GLOBAL const real* RESTRICT pcgResidual, GLOBAL const real* RESTRICT pcgResidualPolar,
+        GLOBAL real* RESTRICT inducedDipole, GLOBAL real* RESTRICT inducedDipolePolar, GLOBAL const real2* RESTRICT pcgSums, int iteration) {
+    LOCAL real2 buffer[64];
+    real2 oldRZ = sumPCGPartials(&pcgSums[((iteration+1)%2)*NUM_GROUPS], buffer);
+    real2 newRZ = sumPCGPartials(&pcgSums[(iteration%2)*NUM_GROUPS], buffer);
+    real beta = (oldRZ.x == 0 ? 0 : newRZ.x/oldRZ.x);
+    real betaPolar = (oldRZ.y == 0 ? 0 : newRZ.y/oldRZ.y);
+    for (int index = GLOBAL_ID; index < 3*NUM_ATOMS; index += GLOBAL_SIZE) {
+        inducedDipole[index] = pcgResidual[index]+beta*inducedDipole[index];
+        inducedDipolePolar[index] = pcgResidualPolar[index]+betaPolar*inducedDipolePolar[index];
+    }
+}
+
+/**
+ * Predict the starting dipoles as a linear combination of the converged dipoles from previous steps,
+ * which are stored in a ring buffer.  coefficients[0] multiplies the most recent entry.
+ */
+KERNEL void predictInducedDipoles(GLOBAL real* RESTRICT inducedDipole, GLOBAL real* RESTRICT inducedDipolePolar,
+        GLOBAL const real* RESTRICT history, GLOBAL const real* RESTRICT historyPolar, GLOBAL const real* RESTRICT coefficients,
+        int historyLength, int newestSlot) {
+    for (int index = GLOBAL_ID; index < 3*NUM_ATOMS; index += GLOBAL_SIZE) {
+        real sum = 0;
+        real sumPolar = 0;
+        for (int i = 0; i < historyLength; i++) {
+            int slot = (newestSlot-i+historyLength)%historyLength;
+            sum += coefficients[i]*history[slot*3*NUM_ATOMS+index];
+            sumPolar += coefficients[i]*historyPolar[slot*3*NUM_ATOMS+index];
+        }
+        inducedDipole[index] = sum;
+        inducedDipolePolar[index] = sumPolar;
+    }
+}
+
+/**
+ * Store the converged dipoles into one slot of the history ring buffer.
+ */
+KERNEL void recordInducedDipoleHistory(GLOBAL const real* RESTRICT inducedDipole, GLOBAL const real* RESTRICT inducedDipolePolar,
+        GLOBAL real* RESTRICT history, GLOBAL real* RESTRICT historyPolar, int slot) {
+    for (int index = GLOBAL_ID; index < 3*NUM_ATOMS; index += GLOBAL_SIZE) {
+        history[slot*3*NUM_ATOMS+index] = inducedDipole[index];
+        historyPolar[slot*3*NUM_ATOMS+index] = inducedDipolePolar[index];
+    }
+}
+
+/**
+ * Propagate the auxiliary dipoles of the extended Lagrangian predictor by one step and store them into
+ * one slot of the history ring buffer.  coefficients[0] is the coupling to the current dipoles, and the
+ * remaining elements are the weights of the auxiliary dipoles from the newest to the oldest step.  If
+ * useHistory is 0, the auxiliary dipoles are reset to the current dipoles.
+ */
+KERNEL void propagateAuxiliaryDipoles(GLOBAL const real* RESTRICT inducedDipole, GLOBAL const real* RESTRICT inducedDipolePolar,
+        GLOBAL real* RESTRICT history, GLOBAL real* RESTRICT historyPolar, GLOBAL const real* RESTRICT coefficients,
+        int historyLength, int slot, int useHistory) {
+    for (int index = GLOBAL_ID; index < 3*NUM_ATOMS; index += GLOBAL_SIZE) {
+        real aux = inducedDipole[index];
+        real auxPolar = inducedDipolePolar[index];
+        if (useHistory) {
+            aux *= coefficients[0];
+            auxPolar *= coefficients[0];
+            for (int i = 1; i < historyLength; i++) {
+                int prevSlot = (slot-i+historyLength)%historyLength;
+                aux += coefficients[i]*history[prevSlot*3*NUM_ATOMS+index];
+                auxPolar += coefficients[i]*historyPolar[prevSlot*3*NUM_ATOMS+index];
+            }
+        }
+        history[slot*3*NUM_ATOMS+index] = aux;
+        historyPolar[slot*3*NUM_ATOMS+index] = auxPolar;
+    }
+}
 #endif // not HIPPO
 
 KERNEL void initExtrapolatedDipoles(GLOBAL real* RESTRICT inducedDipole, GLOBAL real* RESTRICT extrapolatedDipole
@@ -481,9 +481,9 @@ KERNEL void computeFixedPotentialFromGrid(
 #else
         GLOBAL const real2* RESTRICT pmeGrid,
 #endif
-        GLOBAL real* RESTRICT phi, GLOBAL mm_long* RESTRICT fieldBuffers,
+        GLOBAL real* RESTRICT phi, GLOBAL mm_ulong* RESTRICT fieldBuffers,
 #ifndef HIPPO
-        GLOBAL mm_long* RESTRICT fieldPolarBuffers,
+        GLOBAL mm_ulong* RESTRICT fieldPolarBuffers,
 #endif
         GLOBAL const real4* RESTRICT posq, GLOBAL const real* RESTRICT labDipole, real4 periodicBoxVecX, real4 periodicBoxVecY, real4 periodicBoxVecZ,
         real4 recipBoxVecX, real4 recipBoxVecY, real4 recipBoxVecZ) {
@@ -651,13 +651,26 @@ KERNEL void computeFixedPotentialFromGrid(
         mm_long fieldx = realToFixedPoint(dipoleScale*labDipole[m*3]-tuv100*fracToCart[0][0]-tuv010*fracToCart[0][1]-tuv001*fracToCart[0][2]);
         mm_long fieldy = realToFixedPoint(dipoleScale*labDipole[m*3+1]-tuv100*fracToCart[1][0]-tuv010*fracToCart[1][1]-tuv001*fracToCart[1][2]);
         mm_long fieldz = realToFixedPoint(dipoleScale*labDipole[m*3+2]-tuv100*fracToCart[2][0]-tuv010*fracToCart[2][1]-tuv001*fracToCart[2][2]);
-        fieldBuffers[m] = fieldx;
-        fieldBuffers[m+PADDED_NUM_ATOMS] = fieldy;
-        fieldBuffers[m+2*PADDED_NUM_ATOMS] = fieldz;
+#ifdef USE_PME_STREAM
+        // The direct space field is being accumulated into the same buffers at the same time on another queue.
+
+        ATOMIC_ADD(&fieldBuffers[m], (mm_ulong) fieldx);
+        ATOMIC_ADD(&fieldBuffers[m+PADDED_NUM_ATOMS], (mm_ulong) fieldy);
+        ATOMIC_ADD(&fieldBuffers[m+2*PADDED_NUM_ATOMS], (mm_ulong) fieldz);
+#ifndef HIPPO
+        ATOMIC_ADD(&fieldPolarBuffers[m], (mm_ulong) fieldx);
+        ATOMIC_ADD(&fieldPolarBuffers[m+PADDED_NUM_ATOMS], (mm_ulong) fieldy);
+        ATOMIC_ADD(&fieldPolarBuffers[m+2*PADDED_NUM_ATOMS], (mm_ulong) fieldz);
+#endif
+#else
+        fieldBuffers[m] = (mm_ulong) fieldx;
+        fieldBuffers[m+PADDED_NUM_ATOMS] = (mm_ulong) fieldy;
+        fieldBuffers[m+2*PADDED_NUM_ATOMS] = (mm_ulong) fieldz;
 #ifndef HIPPO
-        fieldPolarBuffers[m] = fieldx;
-        fieldPolarBuffers[m+PADDED_NUM_ATOMS] = fieldy;
-        fieldPolarBuffers[m+2*PADDED_NUM_ATOMS] = fieldz;
+        fieldPolarBuffers[m] = (mm_ulong) fieldx;
+        fieldPolarBuffers[m+PADDED_NUM_ATOMS] = (mm_ulong) fieldy;
+        fieldPolarBuffers[m+2*PADDED_NUM_ATOMS] = (mm_ulong) fieldz;
+#endif
 #endif
     }
 }
@@ -1354,3 +1367,63 @@ KERNEL void recordInducedFieldDipoles(GLOBAL const real* RESTRICT phid, GLOBAL r
     }
 }
 #endif
+
+#ifndef HIPPO
+/**
+ * Interpolate the reciprocal space potential at a set of points, and add it to the direct space
+ * potential that has already been computed for them.
+ */
+KERNEL void computePotentialAtPointsFromGrid(GLOBAL const real2* RESTRICT pmeGrid, GLOBAL const real4* RESTRICT points,
+        GLOBAL real* RESTRICT potential, int numPoints, real backgroundPotential, real4 periodicBoxVecX, real4 periodicBoxVecY,
+        real4 periodicBoxVecZ, real4 recipBoxVecX, real4 recipBoxVecY, real4 recipBoxVecZ) {
+    real array[PME_ORDER*PME_ORDER];
+    real4 theta1[PME_ORDER];
+    real4 theta2[PME_ORDER];
+    real4 theta3[PME_ORDER];
+    for (int point = GLOBAL_ID; point < numPoints; point += GLOBAL_SIZE) {
+        real4 pos = points[point];
+        pos -= periodicBoxVecZ*floor(pos.z*recipBoxVecZ.z+0.5f);
+        pos -= periodicBoxVecY*floor(pos.y*recipBoxVecY.z+0.5f);
+        pos -= periodicBoxVecX*floor(pos.x*recipBoxVecX.z+0.5f);
+        real w = pos.x*recipBoxVecX.x+pos.y*recipBoxVecY.x+pos.z*recipBoxVecZ.x;
+        real fr = remainder(GRID_SIZE_X*(w-(int)(w+0.5f)+0.5f), GRID_SIZE_X);
+        int ifr = (int) floor(fr);
+        w = fr - ifr;
+        int igrid1 = ifr-PME_ORDER+1;
+        computeBSplinePoint(theta1, w, array);
+        w = pos.y*recipBoxVecY.y+pos.z*recipBoxVecZ.y;
+        fr = remainder(GRID_SIZE_Y*(w-(int)(w+0.5f)+0.5f), GRID_SIZE_Y);
+        ifr = (int) floor(fr);
+        w = fr - ifr;
+        int igrid2 = ifr-PME_ORDER+1;
+        computeBSplinePoint(theta2, w, array);
+        w = pos.z*recipBoxVecZ.z;
+        fr = remainder(GRID_SIZE_Z*(w-(int)(w+0.5f)+0.5f), GRID_SIZE_Z);
+        ifr = (int) floor(fr);
+        w = fr - ifr;
+        int igrid3 = ifr-PME_ORDER+1;
+        computeBSplinePoint(theta3, w, array);
+        igrid1 += (igrid1 < 0 ? GRID_SIZE_X : 0);
+        igrid2 += (igrid2 < 0 ? GRID_SIZE_Y : 0);
+        igrid3 += (igrid3 < 0 ? GRID_SIZE_Z : 0);
+
+        // The fixed multipoles and induced dipoles were spread together, so the real part
+        // of the grid holds the total potential.
+
+        real sum = 0;
+        for (int ix = 0; ix < PME_ORDER; ix++) {
+            int i = igrid1+ix-(igrid1+ix >= GRID_SIZE_X ? GRID_SIZE_X : 0);
+            real tx = theta1[ix].x;
+            for (int iy = 0; iy < PME_ORDER; iy++) {
+                int j = igrid2+iy-(igrid2+iy >= GRID_SIZE_Y ? GRID_SIZE_Y : 0);
+                real txy = tx*theta2[iy].x;
+                for (int iz = 0; iz < PME_ORDER; iz++) {
+                    int k = igrid3+iz-(igrid3+iz >= GRID_SIZE_Z ? GRID_SIZE_Z : 0);
+                    sum += txy*theta3[iz].x*pmeGrid[i*GRID_SIZE_Y*GRID_SIZE_Z+j*GRID_SIZE_Z+k].x;
+                }
+            }
+        }
+        potential[point] += EPSILON_FACTOR*(sum+backgroundPotential);
+    }
+}
+#endif
@@ -2,23 +2,10 @@
 
 KERNEL void computeLabFrameMoments(GLOBAL real4* RESTRICT posq, GLOBAL int4* RESTRICT multipoleParticles,
         GLOBAL float* RESTRICT molecularCharges, GLOBAL float* RESTRICT molecularDipoles,GLOBAL float* RESTRICT molecularQuadrupoles,
-        GLOBAL real* RESTRICT labFrameDipoles, GLOBAL real* RESTRICT labFrameQuadrupoles,
-        GLOBAL real* RESTRICT sphericalDipoles, GLOBAL real* RESTRICT sphericalQuadrupoles) {
+        GLOBAL real* RESTRICT labFrameDipoles, GLOBAL real* RESTRICT labFrameQuadrupoles) {
     for (int atom = GLOBAL_ID; atom < NUM_ATOMS; atom += GLOBAL_SIZE) {
         // Load the charge. This permits using two AmoebaMultipoleForce instances with different moments.
         posq[atom].w = molecularCharges[atom];
-        // Load the spherical multipoles.
-        int offset = 3*atom;
-        sphericalDipoles[offset+0] = molecularDipoles[offset+2]; // z -> Q_10
-        sphericalDipoles[offset+1] = molecularDipoles[offset+0]; // x -> Q_11c
-        sphericalDipoles[offset+2] = molecularDipoles[offset+1]; // y -> Q_11s
-        offset = 5*atom;
-        sphericalQuadrupoles[offset+0] = -3.0f*(molecularQuadrupoles[offset+0]+molecularQuadrupoles[offset+3]); // zz -> Q_20
-        sphericalQuadrupoles[offset+1] = (2*SQRT((real) 3))*molecularQuadrupoles[offset+2]; // xz -> Q_21c
-        sphericalQuadrupoles[offset+2] = (2*SQRT((real) 3))*molecularQuadrupoles[offset+4]; // yz -> Q_21s
-        sphericalQuadrupoles[offset+3] = SQRT((real) 3)*(molecularQuadrupoles[offset+0]-molecularQuadrupoles[offset+3]); // xx-yy -> Q_22c
-        sphericalQuadrupoles[offset+4] = (2*SQRT((real) 3))*molecularQuadrupoles[offset+1]; // xy -> Q_22s
-        
         // get coordinates of this atom and the z & x axis atoms
         // compute the vector between the atoms and 1/sqrt(d2), d2 is distance between
         // this atom and the axis atom
@@ -173,7 +160,7 @@ KERNEL void computeLabFrameMoments(GLOBAL real4* RESTRICT posq, GLOBAL int4* RES
         
             // Transform the dipole
             
-            offset = 3*atom;
+            int offset = 3*atom;
             real molDipole[3];
             molDipole[0] = molecularDipoles[offset];
             molDipole[1] = molecularDipoles[offset+1];
@@ -216,67 +203,6 @@ KERNEL void computeLabFrameMoments(GLOBAL real4* RESTRICT posq, GLOBAL int4* RES
             labFrameQuadrupoles[offset+4] = vectorX.y*(vectorX.z*mPoleXX + vectorY.z*mPoleXY + vectorZ.z*mPoleXZ)
                                         + vectorY.y*(vectorX.z*mPoleXY + vectorY.z*mPoleYY + vectorZ.z*mPoleYZ)
                                         + vectorZ.y*(vectorX.z*mPoleXZ + vectorY.z*mPoleYZ + vectorZ.z*mPoleZZ);
-            
-            // ---------------------------------------------------------------------------------------
-            
-            // Now transform the spherical multipoles.  First do the dipoles.
-
-            offset = 3*atom;
-            real sphericalDipole[3];
-            sphericalDipole[0] = sphericalDipoles[offset];
-            sphericalDipole[1] = sphericalDipoles[offset+1];
-            sphericalDipole[2] = sphericalDipoles[offset+2];
-            if (reverse)
-                sphericalDipole[2] *= -1;
-            sphericalDipoles[offset] = sphericalDipole[0]*vectorZ.z + sphericalDipole[1]*vectorX.z + sphericalDipole[2]*vectorY.z;
-            sphericalDipoles[offset+1] = sphericalDipole[0]*vectorZ.x + sphericalDipole[1]*vectorX.x + sphericalDipole[2]*vectorY.x;
-            sphericalDipoles[offset+2] = sphericalDipole[0]*vectorZ.y + sphericalDipole[1]*vectorX.y + sphericalDipole[2]*vectorY.y;
-            
-            // Now the quadrupoles.
-
-            offset = 5*atom;
-            real sphericalQuadrupole[5];
-            sphericalQuadrupole[0] = sphericalQuadrupoles[offset];
-            sphericalQuadrupole[1] = sphericalQuadrupoles[offset+1];
-            sphericalQuadrupole[2] = sphericalQuadrupoles[offset+2];
-            sphericalQuadrupole[3] = sphericalQuadrupoles[offset+3];
-            sphericalQuadrupole[4] = sphericalQuadrupoles[offset+4];
-            if (reverse) {
-                sphericalQuadrupole[2] *= -1;
-                sphericalQuadrupole[4] *= -1;
-            }
-            real rotatedQuadrupole[5] = {0, 0, 0, 0, 0};
-            real sqrtThree = SQRT((real) 3);
-            rotatedQuadrupole[0] += sphericalQuadrupole[0]*0.5f*(3.0f*vectorZ.z*vectorZ.z - 1.0f) +
-                                    sphericalQuadrupole[1]*sqrtThree*vectorZ.z*vectorX.z +
-                                    sphericalQuadrupole[2]*sqrtThree*vectorZ.z*vectorY.z +
-                                    sphericalQuadrupole[3]*0.5f*sqrtThree*(vectorX.z*vectorX.z - vectorY.z*vectorY.z) +
-                                    sphericalQuadrupole[4]*sqrtThree*vectorX.z*vectorY.z;
-            rotatedQuadrupole[1] += sphericalQuadrupole[0]*sqrtThree*vectorZ.z*vectorZ.x +
-                                    sphericalQuadrupole[1]*(vectorZ.x*vectorX.z + vectorZ.z*vectorX.x) +
-                                    sphericalQuadrupole[2]*(vectorZ.x*vectorY.z + vectorZ.z*vectorY.x) +
-                                    sphericalQuadrupole[3]*(vectorX.z*vectorX.x - vectorY.z*vectorY.x) +
-                                    sphericalQuadrupole[4]*(vectorX.x*vectorY.z + vectorX.z*vectorY.x);
-            rotatedQuadrupole[2] += sphericalQuadrupole[0]*sqrtThree*vectorZ.z*vectorZ.y +
-                                    sphericalQuadrupole[1]*(vectorZ.y*vectorX.z + vectorZ.z*vectorX.y) +
-                                    sphericalQuadrupole[2]*(vectorZ.y*vectorY.z + vectorZ.z*vectorY.y) +
-                                    sphericalQuadrupole[3]*(vectorX.z*vectorX.y - vectorY.z*vectorY.y) +
-                                    sphericalQuadrupole[4]*(vectorX.y*vectorY.z + vectorX.z*vectorY.y);
-            rotatedQuadrupole[3] += sphericalQuadrupole[0]*0.5f*sqrtThree*(vectorZ.x*vectorZ.x - vectorZ.y*vectorZ.y) +
-                                    sphericalQuadrupole[1]*(vectorZ.x*vectorX.x - vectorZ.y*vectorX.y) +
-                                    sphericalQuadrupole[2]*(vectorZ.x*vectorY.x - vectorZ.y*vectorY.y) +
-                                    sphericalQuadrupole[3]*0.5f*(vectorX.x*vectorX.x - vectorX.y*vectorX.y - vectorY.x*vectorY.x + vectorY.y*vectorY.y) +
-                                    sphericalQuadrupole[4]*(vectorX.x*vectorY.x - vectorX.y*vectorY.y);
-            rotatedQuadrupole[4] += sphericalQuadrupole[0]*sqrtThree*vectorZ.x*vectorZ.y +
-                                    sphericalQuadrupole[1]*(vectorZ.y*vectorX.x + vectorZ.x*vectorX.y) +
-                                    sphericalQuadrupole[2]*(vectorZ.y*vectorY.x + vectorZ.x*vectorY.y) +
-                                    sphericalQuadrupole[3]*(vectorX.x*vectorX.y - vectorY.x*vectorY.y) +
-                                    sphericalQuadrupole[4]*(vectorX.y*vectorY.x + vectorX.x*vectorY.y);
-            sphericalQuadrupoles[offset] = rotatedQuadrupole[0];
-            sphericalQuadrupoles[offset+1] = rotatedQuadrupole[1];
-            sphericalQuadrupoles[offset+2] = rotatedQuadrupole[2];
-            sphericalQuadrupoles[offset+3] = rotatedQuadrupole[3];
-            sphericalQuadrupoles[offset+4] = rotatedQuadrupole[4];
         }
         else {
             labFrameDipoles[3*atom] = molecularDipoles[3*atom];
@@ -592,3 +518,123 @@ KERNEL void computePotentialAtPoints(GLOBAL const real4* RESTRICT posq, GLOBAL c
             potential[point] = p*ENERGY_SCALE_FACTOR;
     }
 }
+
+#ifdef USE_EWALD
+/**
+ * Find the cell containing a position, for the cell list used to find the atoms near each point
+ * where the potential is evaluated.  The cells divide the periodic box in fractional coordinates.
+ */
+DEVICE int findPotentialCell(real3 pos, int numCellsX, int numCellsY, int numCellsZ, real4 invPeriodicBoxSize,
+        real4 periodicBoxVecY, real4 periodicBoxVecZ) {
+    real fz = pos.z*invPeriodicBoxSize.z;
+    real fy = (pos.y-fz*periodicBoxVecZ.y)*invPeriodicBoxSize.y;
+    real fx = (pos.x-fy*periodicBoxVecY.x-fz*periodicBoxVecZ.x)*invPeriodicBoxSize.x;
+    int x = min((int) ((fx-floor(fx))*numCellsX), numCellsX-1);
+    int y = min((int) ((fy-floor(fy))*numCellsY), numCellsY-1);
+    int z = min((int) ((fz-floor(fz))*numCellsZ), numCellsZ-1);
+    return (x*numCellsY+y)*numCellsZ+z;
+}
+
+/**
+ * Record the cell containing each atom.  The result is then sorted by cell.
+ */
+KERNEL void findAtomPotentialCells(GLOBAL const real4* RESTRICT posq, GLOBAL int2* RESTRICT atomCells, int numCellsX, int numCellsY, int numCellsZ,
+        real4 periodicBoxSize, real4 invPeriodicBoxSize, real4 periodicBoxVecX, real4 periodicBoxVecY, real4 periodicBoxVecZ) {
+    for (int atom = GLOBAL_ID; atom < NUM_ATOMS; atom += GLOBAL_SIZE)
+        atomCells[atom] = make_int2(atom, findPotentialCell(trimTo3(posq[atom]), numCellsX, numCellsY, numCellsZ, invPeriodicBoxSize, periodicBoxVecY, periodicBoxVecZ));
+}
+
+/**
+ * Find the range of the sorted atom list that belongs to each cell.  Empty cells are left with
+ * the (cleared) range [0, 0).
+ */
+KERNEL void findPotentialCellRanges(GLOBAL const int2* RESTRICT atomCells, GLOBAL int2* RESTRICT cellRange) {
+    for (int i = GLOBAL_ID; i < NUM_ATOMS; i += GLOBAL_SIZE) {
+        int cell = atomCells[i].y;
+        if (i == 0 || atomCells[i-1].y != cell)
+            cellRange[cell].x = i;
+        if (i == NUM_ATOMS-1 || atomCells[i+1].y != cell)
+            cellRange[cell].y = i+1;
+    }
+}
+
+/**
+ * Compute the direct space part of the Ewald potential at a set of points, summing over the atoms
+ * within the cutoff.  Each cell is at least as wide as the cutoff, so only the neighboring cells need
+ * to be searched.  Along any axis with only one cell, every atom is considered.
+ */
+KERNEL void computeEwaldPotentialAtPoints(GLOBAL const real4* RESTRICT posq, GLOBAL const real* RESTRICT labFrameDipole,
+        GLOBAL const real* RESTRICT labFrameQuadrupole, GLOBAL const real* RESTRICT inducedDipole, GLOBAL const int2* RESTRICT atomCells,
+        GLOBAL const int2* RESTRICT cellRange, GLOBAL const real4* RESTRICT points, GLOBAL real* RESTRICT potential, int numPoints,
+        int numCellsX, int numCellsY, int numCellsZ, real4 periodicBoxSize, real4 invPeriodicBoxSize, real4 periodicBoxVecX,
+        real4 periodicBoxVecY, real4 periodicBoxVecZ) {
+    const int rangeX = (numCellsX > 1 ? 1 : 0);
+    const int rangeY = (numCellsY > 1 ? 1 : 0);
+    const int rangeZ = (numCellsZ > 1 ? 1 : 0);
+    for (int point = GLOBAL_ID; point < numPoints; point += GLOBAL_SIZE) {
+        real3 pointPos = trimTo3(points[point]);
+        int pointCell = findPotentialCell(pointPos, numCellsX, numCellsY, numCellsZ, invPeriodicBoxSize, periodicBoxVecY, periodicBoxVecZ);
+        int cellZ = pointCell%numCellsZ;
+        int cellY = (pointCell/numCellsZ)%numCellsY;
+        int cellX = pointCell/(numCellsY*numCellsZ);
+        real p = 0;
+        for (int dx = -rangeX; dx <= rangeX; dx++) {
+            int x = cellX+dx;
+            x += (x < 0 ? numCellsX : 0);
+            x -= (x >= numCellsX ? numCellsX : 0);
+            for (int dy = -rangeY; dy <= rangeY; dy++) {
+                int y = cellY+dy;
+                y += (y < 0 ? numCellsY : 0);
+                y -= (y >= numCellsY ? numCellsY : 0);
+                for (int dz = -rangeZ; dz <= rangeZ; dz++) {
+                    int z = cellZ+dz;
+                    z += (z < 0 ? numCellsZ : 0);
+                    z -= (z >= numCellsZ ? numCellsZ : 0);
+                    int2 range = cellRange[(x*numCellsY+y)*numCellsZ+z];
+                    for (int j = range.x; j < range.y; j++) {
+                        int atom = atomCells[j].x;
+                        real4 atomPosq = posq[atom];
+                        real3 delta = trimTo3(atomPosq)-pointPos;
+                        APPLY_PERIODIC_TO_DELTA(delta)
+                        real r2 = dot(delta, delta);
+                        if (r2 > CUTOFF_SQUARED)
+                            continue;
+                        real r = SQRT(r2);
+                        real ralpha = EWALD_ALPHA*r;
+                        real exp2a = EXP(-(ralpha*ralpha));
+#ifdef USE_DOUBLE_PRECISION
+                        const real erfcAlphaR = erfc(ralpha);
+#else
+                        // This approximation for erfc is from Abramowitz and Stegun (1964) p. 299.  They cite the following as
+                        // the original source: C. Hastings, Jr., Approximations for Digital Computers (1955).  It has a maximum
+                        // error of 1.5e-7.
+
+                        const real t = RECIP(1.0f+0.3275911f*ralpha);
+                        const real erfcAlphaR = (0.254829592f+(-0.284496736f+(1.421413741f+(-1.453152027f+1.061405429f*t)*t)*t)*t)*t*exp2a;
+#endif
+                        real bn0 = erfcAlphaR/r;
+                        real alsq2 = 2*EWALD_ALPHA*EWALD_ALPHA;
+                        real alsq2n = alsq2*RECIP(SQRT_PI*EWALD_ALPHA);
+                        real bn1 = (bn0+alsq2n*exp2a)/r2;
+                        alsq2n *= alsq2;
+                        real bn2 = (3*bn1+alsq2n*exp2a)/r2;
+                        real3 dipole = make_real3(labFrameDipole[3*atom], labFrameDipole[3*atom+1], labFrameDipole[3*atom+2]);
+                        real3 induced = make_real3(inducedDipole[3*atom], inducedDipole[3*atom+1], inducedDipole[3*atom+2]);
+                        real qXX = labFrameQuadrupole[5*atom];
+                        real qXY = labFrameQuadrupole[5*atom+1];
+                        real qXZ = labFrameQuadrupole[5*atom+2];
+                        real qYY = labFrameQuadrupole[5*atom+3];
+                        real qYZ = labFrameQuadrupole[5*atom+4];
+                        real scd = dot(dipole+induced, delta);
+                        real scq = delta.x*dot(delta, make_real3(qXX, qXY, qXZ)) +
+                                delta.y*dot(delta, make_real3(qXY, qYY, qYZ)) +
+                                delta.z*dot(delta, make_real3(qXZ, qYZ, -qXX-qYY));
+                        p += atomPosq.w*bn0 - scd*bn1 + scq*bn2;
+                    }
+                }
+            }
+        }
+        potential[point] = p*ENERGY_SCALE_FACTOR;
+    }
+}
+#endif
@@ -0,0 +1,88 @@
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMAmoeba                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "AmoebaCpuKernelFactory.h"
+#include "AmoebaCpuKernels.h"
+#include "AmoebaReferenceKernels.h"
+#include "CpuPlatform.h"
+#include "openmm/internal/ContextImpl.h"
+#include "openmm/OpenMMException.h"
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+#ifdef OPENMM_BUILDING_STATIC_LIBRARY
+static void registerPlatforms() {
+#else
+extern "C" OPENMM_EXPORT void registerPlatforms() {
+#endif
+}
+
+#ifdef OPENMM_BUILDING_STATIC_LIBRARY
+static void registerKernelFactories() {
+#else
+extern "C" OPENMM_EXPORT void registerKernelFactories() {
+#endif
+    vector<string> kernelNames = {CalcAmoebaTorsionTorsionForceKernel::Name(), CalcAmoebaVdwForceKernel::Name(),
+            CalcAmoebaMultipoleForceKernel::Name(), CalcAmoebaGeneralizedKirkwoodForceKernel::Name(),
+            CalcAmoebaWcaDispersionForceKernel::Name(), CalcHippoNonbondedForceKernel::Name()};
+    for (int i = 0; i < Platform::getNumPlatforms(); i++) {
+        Platform& platform = Platform::getPlatform(i);
+        if (dynamic_cast<CpuPlatform*>(&platform) != NULL) {
+            AmoebaCpuKernelFactory* factory = new AmoebaCpuKernelFactory();
+            for (auto& name : kernelNames)
+                platform.registerKernelFactory(name, factory);
+        }
+    }
+}
+
+extern "C" OPENMM_EXPORT void registerAmoebaCpuKernelFactories() {
+    registerKernelFactories();
+}
+
+KernelImpl* AmoebaCpuKernelFactory::createKernelImpl(std::string name, const Platform& platform, ContextImpl& context) const {
+    CpuPlatform::PlatformData& data = CpuPlatform::getPlatformData(context);
+    if (name == CalcAmoebaTorsionTorsionForceKernel::Name())
+        return new ReferenceCalcAmoebaTorsionTorsionForceKernel(name, platform, context.getSystem());
+
+    if (name == CalcAmoebaVdwForceKernel::Name())
+        return new CpuCalcAmoebaVdwForceKernel(name, platform, data);
+
+    if (name == CalcAmoebaMultipoleForceKernel::Name())
+        return new CpuCalcAmoebaMultipoleForceKernel(name, platform, context.getSystem(), data);
+
+    if (name == CalcAmoebaGeneralizedKirkwoodForceKernel::Name())
+        return new ReferenceCalcAmoebaGeneralizedKirkwoodForceKernel(name, platform, context.getSystem());
+
+    if (name == CalcAmoebaWcaDispersionForceKernel::Name())
+        return new ReferenceCalcAmoebaWcaDispersionForceKernel(name, platform, context.getSystem());
+
+    if (name == CalcHippoNonbondedForceKernel::Name())
+        return new ReferenceCalcHippoNonbondedForceKernel(name, platform, context.getSystem());
+
+    throw OpenMMException((std::string("Tried to create kernel with illegal kernel name '")+name+"'").c_str());
+}
@@ -0,0 +1,104 @@
+#ifndef AMOEBA_OPENMM_CPU_KERNELS_H_
+#define AMOEBA_OPENMM_CPU_KERNELS_H_
+
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMAmoeba                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+#include "AmoebaReferenceKernels.h"
+#include "CpuAmoebaPmeMultipoleForce.h"
+#include "CpuAmoebaVdwForce.h"
+#include "CpuNeighborList.h"
+#include "CpuPlatform.h"
+#include "openmm/amoebaKernels.h"
+
+namespace OpenMM {
+
+/**
+ * This kernel is invoked by AmoebaVdwForce to calculate the forces acting on the system and the energy of the system.
+ */
+class CpuCalcAmoebaVdwForceKernel : public CalcAmoebaVdwForceKernel {
+public:
+    CpuCalcAmoebaVdwForceKernel(const std::string& name, const Platform& platform, CpuPlatform::PlatformData& data);
+    ~CpuCalcAmoebaVdwForceKernel();
+    /**
+     * Initialize the kernel.
+     * 
+     * @param system     the System this kernel will be applied to
+     * @param force      the AmoebaVdwForce this kernel will be used for
+     */
+    void initialize(const System& system, const AmoebaVdwForce& force);
+    /**
+     * Execute the kernel to calculate the forces and/or energy.
+     *
+     * @param context        the context in which to execute this kernel
+     * @param includeForces  true if forces should be calculated
+     * @param includeEnergy  true if the energy should be calculated
+     * @return the potential energy due to the force
+     */
+    double execute(ContextImpl& context, bool includeForces, bool includeEnergy);
+    /**
+     * Copy changed parameters over to a context.
+     *
+     * @param context    the context to copy parameters to
+     * @param force      the AmoebaVdwForce to copy the parameters from
+     */
+    void copyParametersToContext(ContextImpl& context, const AmoebaVdwForce& force);
+    /**
+     * Compute the energy of the force at each of a list of values for the lambda parameter.
+     *
+     * @param context        the context in which to execute this kernel
+     * @param lambdas        the values of the lambda parameter at which to evaluate the energy
+     * @param[out] energies  on exit, energies[i] is the energy when lambda equals lambdas[i]
+     */
+    void computeLambdaEnergies(ContextImpl& context, const std::vector<double>& lambdas, std::vector<double>& energies);
+private:
+    CpuPlatform::PlatformData& data;
+    int numParticles;
+    bool useCutoff;
+    std::string lambdaName;
+    double cutoff;
+    double dispersionCoefficient;
+    CpuAmoebaVdwForce vdwForce;
+    CpuNeighborList* neighborList;
+};
+
+/**
+ * This kernel is invoked by AmoebaMultipoleForce to calculate the forces acting on the system and the energy of the system.
+ * It is identical to the reference kernel, except that the direct space part of PME is parallelized with
+ * CpuAmoebaPmeMultipoleForce.
+ */
+class CpuCalcAmoebaMultipoleForceKernel : public ReferenceCalcAmoebaMultipoleForceKernel {
+public:
+    CpuCalcAmoebaMultipoleForceKernel(const std::string& name, const Platform& platform, const System& system, CpuPlatform::PlatformData& data);
+protected:
+    AmoebaReferencePmeMultipoleForce* createPmeMultipoleForce(ContextImpl& context);
+private:
+    CpuPlatform::PlatformData& data;
+    CpuNeighborList neighborList;
+};
+
+} // namespace OpenMM
+
+#endif /*AMOEBA_OPENMM_CPU_KERNELS_H_*/
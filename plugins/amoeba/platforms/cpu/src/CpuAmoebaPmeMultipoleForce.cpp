@@ -0,0 +1,163 @@
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMAmoeba                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuAmoebaPmeMultipoleForce.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace OpenMM;
+using namespace std;
+
+CpuAmoebaPmeMultipoleForce::CpuAmoebaPmeMultipoleForce(ThreadPool& threads, CpuNeighborList& neighborList) :
+        threads(threads), neighborList(neighborList), neighborListValid(false) {
+}
+
+void CpuAmoebaPmeMultipoleForce::updateNeighborList(const vector<MultipoleParticleData>& particleData) {
+    if (neighborListValid)
+        return;
+
+    // Wrap the positions into the periodic box and build the neighbor list.  Covalently
+    // scaled pairs are handled through the scale factors, so no exclusions are needed.
+    // A small padding is added to the cutoff to allow for rounding to single precision.
+
+    if (posq.size() < 4*_numParticles)
+        posq.resize(4*_numParticles);
+    for (int i = 0; i < _numParticles; i++) {
+        Vec3 pos = particleData[i].position;
+        pos -= _periodicBoxVectors[2]*floor(pos[2]*_recipBoxVectors[2][2]);
+        pos -= _periodicBoxVectors[1]*floor(pos[1]*_recipBoxVectors[1][1]);
+        pos -= _periodicBoxVectors[0]*floor(pos[0]*_recipBoxVectors[0][0]);
+        posq[4*i] = (float) pos[0];
+        posq[4*i+1] = (float) pos[1];
+        posq[4*i+2] = (float) pos[2];
+        posq[4*i+3] = 0.0f;
+    }
+    ExclusionList exclusions(_numParticles);
+    neighborList.computeNeighborList(_numParticles, posq, exclusions, _periodicBoxVectors, true, (float) (1.001*_cutoffDistance), threads);
+    neighborListValid = true;
+}
+
+void CpuAmoebaPmeMultipoleForce::loopOverPairs(const function<void (int, int, int)>& pairFunction) {
+    atomicCounter = 0;
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        const int blockSize = neighborList.getBlockSize();
+        while (true) {
+            int blockIndex = atomicCounter++;
+            if (blockIndex >= neighborList.getNumBlocks())
+                break;
+            const int32_t* blockAtom = &neighborList.getSortedAtoms()[blockSize*blockIndex];
+            const vector<int>& neighbors = neighborList.getBlockNeighbors(blockIndex);
+            const auto& exclusions = neighborList.getBlockExclusions(blockIndex);
+            for (int i = 0; i < (int) neighbors.size(); i++) {
+                int first = neighbors[i];
+                for (int k = 0; k < blockSize; k++)
+                    if ((exclusions[i] & (1<<k)) == 0)
+                        pairFunction(threadIndex, min(first, blockAtom[k]), max(first, blockAtom[k]));
+            }
+        }
+    });
+    threads.waitForThreads();
+}
+
+void CpuAmoebaPmeMultipoleForce::calculateDirectFixedMultipoleField(const vector<MultipoleParticleData>& particleData) {
+    updateNeighborList(particleData);
+    int numThreads = threads.getNumThreads();
+    vector<vector<Vec3> > threadField(numThreads, vector<Vec3>(_numParticles));
+    vector<vector<Vec3> > threadFieldPolar(numThreads, vector<Vec3>(_numParticles));
+    loopOverPairs([&] (int threadIndex, int i, int j) {
+        double dScale = 1.0, pScale = 1.0;
+        if (j <= _maxScaleIndex[i])
+            getDScaleAndPScale(i, j, dScale, pScale);
+        calculateFixedMultipoleFieldPairIxn(particleData[i], particleData[j], dScale, pScale, threadField[threadIndex], threadFieldPolar[threadIndex]);
+    });
+
+    // The reciprocal space and self contributions have already been stored, so add to them.
+
+    for (int i = 0; i < numThreads; i++)
+        for (int j = 0; j < _numParticles; j++) {
+            _fixedMultipoleField[j] += threadField[i][j];
+            _fixedMultipoleFieldPolar[j] += threadFieldPolar[i][j];
+        }
+}
+
+void CpuAmoebaPmeMultipoleForce::calculateDirectInducedDipoleFields(const vector<MultipoleParticleData>& particleData,
+                                                                    vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields) {
+    updateNeighborList(particleData);
+
+    // Each thread accumulates into its own copy of the fields.  The copies share the
+    // pointers to the input dipoles.
+
+    int numThreads = threads.getNumThreads();
+    vector<vector<UpdateInducedDipoleFieldStruct> > threadFields(numThreads, updateInducedDipoleFields);
+    vector<double> zeros(6, 0.0);
+    for (auto& fields : threadFields)
+        for (auto& field : fields) {
+            fill(field.inducedDipoleField.begin(), field.inducedDipoleField.end(), Vec3());
+            fill(field.inducedDipoleFieldGradient.begin(), field.inducedDipoleFieldGradient.end(), zeros);
+        }
+    loopOverPairs([&] (int threadIndex, int i, int j) {
+        calculateDirectInducedDipolePairIxns(particleData[i], particleData[j], threadFields[threadIndex]);
+    });
+    for (int i = 0; i < numThreads; i++)
+        for (int j = 0; j < (int) updateInducedDipoleFields.size(); j++) {
+            UpdateInducedDipoleFieldStruct& field = updateInducedDipoleFields[j];
+            const UpdateInducedDipoleFieldStruct& threadField = threadFields[i][j];
+            for (int k = 0; k < _numParticles; k++)
+                field.inducedDipoleField[k] += threadField.inducedDipoleField[k];
+            for (int k = 0; k < (int) field.inducedDipoleFieldGradient.size(); k++)
+                for (int m = 0; m < 6; m++)
+                    field.inducedDipoleFieldGradient[k][m] += threadField.inducedDipoleFieldGradient[k][m];
+        }
+}
+
+double CpuAmoebaPmeMultipoleForce::calculateDirectElectrostatic(const vector<MultipoleParticleData>& particleData,
+                                                                vector<Vec3>& torques, vector<Vec3>& forces) {
+    updateNeighborList(particleData);
+    int numThreads = threads.getNumThreads();
+    vector<double> threadEnergy(numThreads, 0.0);
+    vector<vector<Vec3> > threadForce(numThreads, vector<Vec3>(_numParticles));
+    vector<vector<Vec3> > threadTorque(numThreads, vector<Vec3>(_numParticles));
+    vector<vector<double> > threadScaleFactors(numThreads, vector<double>(LAST_SCALE_TYPE_INDEX, 1.0));
+    loopOverPairs([&] (int threadIndex, int i, int j) {
+        vector<double>& scaleFactors = threadScaleFactors[threadIndex];
+        bool scaled = (j <= _maxScaleIndex[i]);
+        if (scaled)
+            getMultipoleScaleFactors(i, j, scaleFactors);
+        threadEnergy[threadIndex] += calculatePmeDirectElectrostaticPairIxn(particleData[i], particleData[j], scaleFactors,
+                threadForce[threadIndex], threadTorque[threadIndex]);
+        if (scaled)
+            fill(scaleFactors.begin(), scaleFactors.end(), 1.0);
+    });
+    double energy = 0.0;
+    for (int i = 0; i < numThreads; i++) {
+        energy += threadEnergy[i];
+        for (int j = 0; j < _numParticles; j++) {
+            forces[j] += threadForce[i][j];
+            torques[j] += threadTorque[i][j];
+        }
+    }
+    return energy;
+}
@@ -0,0 +1,90 @@
+#ifndef OPENMM_CPU_AMOEBA_PME_MULTIPOLE_FORCE_H_
+#define OPENMM_CPU_AMOEBA_PME_MULTIPOLE_FORCE_H_
+
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMAmoeba                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "AmoebaReferenceMultipoleForce.h"
+#include "AlignedArray.h"
+#include "CpuNeighborList.h"
+#include "openmm/internal/ThreadPool.h"
+#include <atomic>
+#include <functional>
+#include <set>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class computes AmoebaMultipoleForce interactions with PME on the CPU.  The reciprocal space
+ * and self terms are computed exactly as in AmoebaReferencePmeMultipoleForce, while the direct space
+ * loops over particle pairs (fixed multipole fields, induced dipole fields, and electrostatic forces)
+ * are divided between the threads of a ThreadPool and use a CpuNeighborList to find the pairs
+ * within the cutoff.
+ */
+class CpuAmoebaPmeMultipoleForce : public AmoebaReferencePmeMultipoleForce {
+public:
+    /**
+     * Create a CpuAmoebaPmeMultipoleForce.
+     *
+     * @param threads       used for parallelization
+     * @param neighborList  the neighbor list to use for finding pairs in direct space
+     */
+    CpuAmoebaPmeMultipoleForce(ThreadPool& threads, CpuNeighborList& neighborList);
+
+protected:
+    void calculateDirectFixedMultipoleField(const std::vector<MultipoleParticleData>& particleData);
+    void calculateDirectInducedDipoleFields(const std::vector<MultipoleParticleData>& particleData,
+                                            std::vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields);
+    double calculateDirectElectrostatic(const std::vector<MultipoleParticleData>& particleData,
+                                        std::vector<OpenMM::Vec3>& torques,
+                                        std::vector<OpenMM::Vec3>& forces);
+
+private:
+    /**
+     * Build the neighbor list, if it has not already been built for the current positions.
+     */
+    void updateNeighborList(const std::vector<MultipoleParticleData>& particleData);
+
+    /**
+     * Invoke a function once for every pair of particles that might be within the cutoff.  The
+     * pairs are divided between threads.  Each pair (i, j) is passed with i < j, so the same
+     * covalent scale factors are used as in the reference implementation.
+     *
+     * @param pairFunction   called as pairFunction(threadIndex, i, j)
+     */
+    void loopOverPairs(const std::function<void (int, int, int)>& pairFunction);
+
+    ThreadPool& threads;
+    CpuNeighborList& neighborList;
+    AlignedArray<float> posq;
+    bool neighborListValid;
+    std::atomic<int> atomicCounter;
+};
+
+} // namespace OpenMM
+
+#endif // OPENMM_CPU_AMOEBA_PME_MULTIPOLE_FORCE_H_
@@ -0,0 +1,232 @@
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMAmoeba                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuAmoebaVdwForce.h"
+#include "ReferenceForce.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace OpenMM;
+using namespace std;
+
+CpuAmoebaVdwForce::CpuAmoebaVdwForce() : neighborList(NULL) {
+}
+
+void CpuAmoebaVdwForce::prepareInteractions(int numParticles, const vector<Vec3>& particlePositions, CpuNeighborList* neighborList, ThreadPool& threads) {
+    // Move the interaction sites of reduced particles toward their covalent partners.
+
+    setReducedPositions(numParticles, particlePositions, indexIVs, reductions, reducedPositions);
+
+    // Build the neighbor list from the reduced positions, since those are what the cutoff is applied to.
+
+    bool periodic = (_nonbondedMethod == AmoebaVdwForce::CutoffPeriodic);
+    if (neighborList != NULL) {
+        if (reducedPosq.size() < 4*numParticles)
+            reducedPosq.resize(4*numParticles);
+        for (int i = 0; i < numParticles; i++) {
+            Vec3 pos = reducedPositions[i];
+            if (periodic) {
+                pos -= _periodicBoxVectors[2]*floor(pos[2]/_periodicBoxVectors[2][2]);
+                pos -= _periodicBoxVectors[1]*floor(pos[1]/_periodicBoxVectors[1][1]);
+                pos -= _periodicBoxVectors[0]*floor(pos[0]/_periodicBoxVectors[0][0]);
+            }
+            reducedPosq[4*i] = (float) pos[0];
+            reducedPosq[4*i+1] = (float) pos[1];
+            reducedPosq[4*i+2] = (float) pos[2];
+            reducedPosq[4*i+3] = 0.0f;
+        }
+        neighborList->computeNeighborList(numParticles, reducedPosq, allExclusions, _periodicBoxVectors, periodic, (float) _cutoff, threads);
+    }
+
+    // Record the parameters for the threads.
+
+    this->numParticles = numParticles;
+    this->neighborList = neighborList;
+    cutoffSquared = _cutoff*_cutoff;
+    atomicCounter = 0;
+}
+
+double CpuAmoebaVdwForce::calculateForceAndEnergy(int numParticles, double lambda, const vector<Vec3>& particlePositions,
+                                                  CpuNeighborList* neighborList, ThreadPool& threads, vector<Vec3>& forces) {
+    prepareInteractions(numParticles, particlePositions, neighborList, threads);
+    int numThreads = threads.getNumThreads();
+    this->lambda = lambda;
+    threadEnergy.resize(numThreads);
+    threadForce.resize(numThreads);
+
+    // Signal the threads to start running and wait for them to finish.
+
+    threads.execute([&] (ThreadPool& threads, int threadIndex) { threadComputeForce(threads, threadIndex); });
+    threads.waitForThreads();
+
+    // Combine the results from all the threads.
+
+    double energy = 0.0;
+    for (int i = 0; i < numThreads; i++) {
+        energy += threadEnergy[i];
+        for (int j = 0; j < numParticles; j++)
+            forces[j] += threadForce[i][j];
+    }
+    return energy;
+}
+
+void CpuAmoebaVdwForce::calculateLambdaEnergies(int numParticles, const vector<double>& lambdas, const vector<Vec3>& particlePositions,
+                                                CpuNeighborList* neighborList, ThreadPool& threads, vector<double>& energies) {
+    prepareInteractions(numParticles, particlePositions, neighborList, threads);
+    int numThreads = threads.getNumThreads();
+    int numLambdas = lambdas.size();
+    lambdaEpsilonScale.resize(numLambdas);
+    lambdaSoftcore.resize(numLambdas);
+    for (int i = 0; i < numLambdas; i++) {
+        lambdaEpsilonScale[i] = pow(lambdas[i], _n);
+        lambdaSoftcore[i] = _alpha*pow(1.0-lambdas[i], 2);
+    }
+    threadLambdaEnergies.resize(numThreads);
+
+    // Signal the threads to start running and wait for them to finish.
+
+    threads.execute([&] (ThreadPool& threads, int threadIndex) { threadComputeLambdaEnergies(threads, threadIndex); });
+    threads.waitForThreads();
+
+    // Combine the results from all the threads.  The last element of each thread's array holds
+    // the energy of pairs that do not depend on lambda.
+
+    energies.resize(numLambdas);
+    double sharedEnergy = 0.0;
+    for (int i = 0; i < numThreads; i++)
+        sharedEnergy += threadLambdaEnergies[i][numLambdas];
+    for (int j = 0; j < numLambdas; j++) {
+        energies[j] = sharedEnergy;
+        for (int i = 0; i < numThreads; i++)
+            energies[j] += threadLambdaEnergies[i][j];
+    }
+}
+
+template <class F>
+void CpuAmoebaVdwForce::loopOverInteractions(F computeInteraction) {
+    if (neighborList == NULL) {
+        while (true) {
+            int i = atomicCounter++;
+            if (i >= numParticles)
+                break;
+            for (int j = i+1; j < numParticles; j++)
+                if (!allExclusions.isExcluded(i, j))
+                    computeInteraction(i, j);
+        }
+    }
+    else {
+        const int blockSize = neighborList->getBlockSize();
+        while (true) {
+            int blockIndex = atomicCounter++;
+            if (blockIndex >= neighborList->getNumBlocks())
+                break;
+            const int32_t* blockAtom = &neighborList->getSortedAtoms()[blockSize*blockIndex];
+            const vector<int>& neighbors = neighborList->getBlockNeighbors(blockIndex);
+            const auto& exclusions = neighborList->getBlockExclusions(blockIndex);
+            for (int i = 0; i < (int) neighbors.size(); i++) {
+                int first = neighbors[i];
+                for (int k = 0; k < blockSize; k++)
+                    if ((exclusions[i] & (1<<k)) == 0)
+                        computeInteraction(min(first, blockAtom[k]), max(first, blockAtom[k]));
+            }
+        }
+    }
+}
+
+void CpuAmoebaVdwForce::threadComputeForce(ThreadPool& threads, int threadIndex) {
+    vector<Vec3>& forces = threadForce[threadIndex];
+    forces.resize(numParticles);
+    fill(forces.begin(), forces.end(), Vec3());
+    double energy = 0.0;
+    loopOverInteractions([&] (int siteI, int siteJ) { computeOneInteraction(siteI, siteJ, energy, forces); });
+    threadEnergy[threadIndex] = energy;
+}
+
+void CpuAmoebaVdwForce::threadComputeLambdaEnergies(ThreadPool& threads, int threadIndex) {
+    vector<double>& energies = threadLambdaEnergies[threadIndex];
+    energies.resize(lambdaEpsilonScale.size()+1);
+    fill(energies.begin(), energies.end(), 0.0);
+    loopOverInteractions([&] (int siteI, int siteJ) { computeOneLambdaEnergy(siteI, siteJ, energies); });
+}
+
+bool CpuAmoebaVdwForce::isAlchemicalPair(int siteI, int siteJ) const {
+    if (_alchemicalMethod == AmoebaVdwForce::Decouple)
+        return (isAlchemical[siteI] != isAlchemical[siteJ]);
+    if (_alchemicalMethod == AmoebaVdwForce::Annihilate)
+        return (isAlchemical[siteI] || isAlchemical[siteJ]);
+    return false;
+}
+
+bool CpuAmoebaVdwForce::isBeyondCutoff(int siteI, int siteJ) const {
+    if (neighborList == NULL)
+        return false;
+    double deltaR[ReferenceForce::LastDeltaRIndex];
+    if (_nonbondedMethod == AmoebaVdwForce::CutoffPeriodic)
+        ReferenceForce::getDeltaRPeriodic(reducedPositions[siteJ], reducedPositions[siteI], _periodicBoxVectors, deltaR);
+    else
+        ReferenceForce::getDeltaR(reducedPositions[siteJ], reducedPositions[siteI], deltaR);
+    return (deltaR[ReferenceForce::R2Index] > cutoffSquared);
+}
+
+void CpuAmoebaVdwForce::computeOneInteraction(int siteI, int siteJ, double& energy, vector<Vec3>& forces) const {
+    if (isBeyondCutoff(siteI, siteJ))
+        return;
+    double combinedSigma = sigmaMatrix[particleType[siteI]][particleType[siteJ]];
+    double combinedEpsilon = epsilonMatrix[particleType[siteI]][particleType[siteJ]];
+
+    // Apply per particle scale factors (for CpHMD).
+
+    combinedEpsilon *= scaleFactors[siteI]*scaleFactors[siteJ];
+    double softcore = 0.0;
+    if (isAlchemicalPair(siteI, siteJ)) {
+        combinedEpsilon *= pow(lambda, _n);
+        softcore = _alpha*pow(1.0-lambda, 2);
+    }
+    Vec3 force;
+    energy += calculatePairIxn(combinedSigma, combinedEpsilon, softcore, reducedPositions[siteI], reducedPositions[siteJ], force);
+    if (indexIVs[siteI] == siteI)
+        forces[siteI] -= force;
+    else
+        addReducedForce(siteI, indexIVs[siteI], reductions[siteI], -1.0, force, forces);
+    if (indexIVs[siteJ] == siteJ)
+        forces[siteJ] += force;
+    else
+        addReducedForce(siteJ, indexIVs[siteJ], reductions[siteJ], 1.0, force, forces);
+}
+
+void CpuAmoebaVdwForce::computeOneLambdaEnergy(int siteI, int siteJ, vector<double>& energies) const {
+    if (isBeyondCutoff(siteI, siteJ))
+        return;
+    double combinedSigma = sigmaMatrix[particleType[siteI]][particleType[siteJ]];
+    double combinedEpsilon = epsilonMatrix[particleType[siteI]][particleType[siteJ]]*scaleFactors[siteI]*scaleFactors[siteJ];
+    Vec3 force;
+    if (isAlchemicalPair(siteI, siteJ)) {
+        for (int i = 0; i < (int) lambdaEpsilonScale.size(); i++)
+            energies[i] += calculatePairIxn(combinedSigma, combinedEpsilon*lambdaEpsilonScale[i], lambdaSoftcore[i], reducedPositions[siteI], reducedPositions[siteJ], force);
+    }
+    else
+        energies[lambdaEpsilonScale.size()] += calculatePairIxn(combinedSigma, combinedEpsilon, 0.0, reducedPositions[siteI], reducedPositions[siteJ], force);
+}
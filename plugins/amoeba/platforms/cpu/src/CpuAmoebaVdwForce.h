@@ -0,0 +1,110 @@
+#ifndef OPENMM_CPU_AMOEBA_VDW_FORCE_H_
+#define OPENMM_CPU_AMOEBA_VDW_FORCE_H_
+
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMAmoeba                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "AmoebaReferenceVdwForce.h"
+#include "AlignedArray.h"
+#include "CpuNeighborList.h"
+#include "openmm/internal/ThreadPool.h"
+#include <atomic>
+#include <set>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class computes AmoebaVdwForce interactions on the CPU.  It uses the same parameters and
+ * pair interaction as AmoebaReferenceVdwForce, but divides the pair loop between the threads of
+ * a ThreadPool and uses a CpuNeighborList to find the interacting pairs.
+ */
+class CpuAmoebaVdwForce : public AmoebaReferenceVdwForce {
+public:
+    CpuAmoebaVdwForce();
+
+    /**
+     * Calculate the interaction.
+     *
+     * @param numParticles       number of particles
+     * @param lambda             lambda value
+     * @param particlePositions  Cartesian coordinates of particles
+     * @param neighborList       the neighbor list to use, or NULL if no cutoff is used
+     * @param threads            used for parallelization
+     * @param forces             add forces to this vector
+     * @return the energy
+     */
+    double calculateForceAndEnergy(int numParticles, double lambda, const std::vector<Vec3>& particlePositions,
+                                   CpuNeighborList* neighborList, ThreadPool& threads, std::vector<Vec3>& forces);
+
+    /**
+     * Calculate the energy at each of a list of lambda values in a single pass over the pairs.  Pairs
+     * that are not affected by lambda are evaluated only once.
+     *
+     * @param numParticles       number of particles
+     * @param lambdas            the lambda values at which to evaluate the energy
+     * @param particlePositions  Cartesian coordinates of particles
+     * @param neighborList       the neighbor list to use, or NULL if no cutoff is used
+     * @param threads            used for parallelization
+     * @param energies           on exit, energies[i] is the energy when lambda equals lambdas[i]
+     */
+    void calculateLambdaEnergies(int numParticles, const std::vector<double>& lambdas, const std::vector<Vec3>& particlePositions,
+                                 CpuNeighborList* neighborList, ThreadPool& threads, std::vector<double>& energies);
+
+    /**
+     * This routine contains the code executed by each thread.
+     */
+    void threadComputeForce(ThreadPool& threads, int threadIndex);
+
+    /**
+     * This routine contains the code executed by each thread when computing energies at multiple lambda values.
+     */
+    void threadComputeLambdaEnergies(ThreadPool& threads, int threadIndex);
+
+private:
+    void prepareInteractions(int numParticles, const std::vector<Vec3>& particlePositions, CpuNeighborList* neighborList, ThreadPool& threads);
+    template <class F>
+    void loopOverInteractions(F computeInteraction);
+    bool isAlchemicalPair(int siteI, int siteJ) const;
+    bool isBeyondCutoff(int siteI, int siteJ) const;
+    void computeOneInteraction(int siteI, int siteJ, double& energy, std::vector<Vec3>& forces) const;
+    void computeOneLambdaEnergy(int siteI, int siteJ, std::vector<double>& energies) const;
+    std::vector<Vec3> reducedPositions;
+    AlignedArray<float> reducedPosq;
+    std::vector<double> threadEnergy;
+    std::vector<std::vector<Vec3> > threadForce;
+    std::vector<std::vector<double> > threadLambdaEnergies;
+    std::vector<double> lambdaEpsilonScale, lambdaSoftcore;
+    // The following variables are used to make information accessible to the individual threads.
+    int numParticles;
+    double lambda, cutoffSquared;
+    CpuNeighborList* neighborList;
+    std::atomic<int> atomicCounter;
+};
+
+} // namespace OpenMM
+
+#endif // OPENMM_CPU_AMOEBA_VDW_FORCE_H_
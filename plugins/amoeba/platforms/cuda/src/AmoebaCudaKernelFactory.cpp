@@ -78,8 +78,17 @@ KernelImpl* AmoebaCudaKernelFactory::createKernelImpl(std::string name, const Pl
     if (name == CalcAmoebaTorsionTorsionForceKernel::Name())
         return new CommonCalcAmoebaTorsionTorsionForceKernel(name, platform, cu, context.getSystem());
 
-    if (name == CalcAmoebaMultipoleForceKernel::Name())
+    if (name == CalcAmoebaMultipoleForceKernel::Name()) {
+        if (data.contexts.size() > 1) {
+            // Divide the calculation between multiple devices.
+
+            std::vector<Kernel> kernels;
+            for (CudaContext* c : data.contexts)
+                kernels.push_back(Kernel(new CudaCalcAmoebaMultipoleForceKernel(name, platform, *c, context.getSystem())));
+            return new CommonParallelCalcAmoebaMultipoleForceKernel(name, platform, cu, kernels);
+        }
         return new CudaCalcAmoebaMultipoleForceKernel(name, platform, cu, context.getSystem());
+    }
 
     if (name == CalcAmoebaGeneralizedKirkwoodForceKernel::Name())
         return new CommonCalcAmoebaGeneralizedKirkwoodForceKernel(name, platform, cu, context.getSystem());
@@ -51,6 +51,12 @@ public:
     bool useFixedPointChargeSpreading() const {
         return cc.getUseDoublePrecision();
     }
+    /**
+     * Get whether reciprocal space PME may be computed on a separate queue.
+     */
+    bool supportsPmeQueue() const {
+        return !dynamic_cast<CudaContext&>(cc).getPlatformData().disablePmeStream;
+    }
 };
 
 /**
@@ -74,6 +80,12 @@ public:
     bool useFixedPointChargeSpreading() const {
         return cc.getUseDoublePrecision();
     }
+    /**
+     * Get whether reciprocal space PME may be computed on a separate queue.
+     */
+    bool supportsPmeQueue() const {
+        return !dynamic_cast<CudaContext&>(cc).getPlatformData().disablePmeStream;
+    }
     /**
      * Sort the atom grid indices.
      */
@@ -79,8 +79,17 @@ KernelImpl* AmoebaHipKernelFactory::createKernelImpl(std::string name, const Pla
     if (name == CalcAmoebaTorsionTorsionForceKernel::Name())
         return new CommonCalcAmoebaTorsionTorsionForceKernel(name, platform, cu, context.getSystem());
 
-    if (name == CalcAmoebaMultipoleForceKernel::Name())
+    if (name == CalcAmoebaMultipoleForceKernel::Name()) {
+        if (data.contexts.size() > 1) {
+            // Divide the calculation between multiple devices.
+
+            std::vector<Kernel> kernels;
+            for (HipContext* c : data.contexts)
+                kernels.push_back(Kernel(new HipCalcAmoebaMultipoleForceKernel(name, platform, *c, context.getSystem())));
+            return new CommonParallelCalcAmoebaMultipoleForceKernel(name, platform, cu, kernels);
+        }
         return new HipCalcAmoebaMultipoleForceKernel(name, platform, cu, context.getSystem());
+    }
 
     if (name == CalcAmoebaGeneralizedKirkwoodForceKernel::Name())
         return new CommonCalcAmoebaGeneralizedKirkwoodForceKernel(name, platform, cu, context.getSystem());
@@ -52,6 +52,12 @@ public:
     bool useFixedPointChargeSpreading() const {
         return cc.getUseDoublePrecision() || !dynamic_cast<HipContext&>(cc).getSupportsHardwareFloatGlobalAtomicAdd();
     }
+    /**
+     * Get whether reciprocal space PME may be computed on a separate queue.
+     */
+    bool supportsPmeQueue() const {
+        return !dynamic_cast<HipContext&>(cc).getPlatformData().disablePmeStream;
+    }
 private:
     HipContext& cu;
 };
@@ -77,6 +83,12 @@ public:
     bool useFixedPointChargeSpreading() const {
         return cc.getUseDoublePrecision() || !dynamic_cast<HipContext&>(cc).getSupportsHardwareFloatGlobalAtomicAdd();
     }
+    /**
+     * Get whether reciprocal space PME may be computed on a separate queue.
+     */
+    bool supportsPmeQueue() const {
+        return !dynamic_cast<HipContext&>(cc).getPlatformData().disablePmeStream;
+    }
     /**
      * Sort the atom grid indices.
      */
@@ -79,8 +79,17 @@ KernelImpl* AmoebaOpenCLKernelFactory::createKernelImpl(std::string name, const
     if (name == CalcAmoebaTorsionTorsionForceKernel::Name())
         return new CommonCalcAmoebaTorsionTorsionForceKernel(name, platform, cc, context.getSystem());
 
-    if (name == CalcAmoebaMultipoleForceKernel::Name())
+    if (name == CalcAmoebaMultipoleForceKernel::Name()) {
+        if (data.contexts.size() > 1) {
+            // Divide the calculation between multiple devices.
+
+            std::vector<Kernel> kernels;
+            for (OpenCLContext* c : data.contexts)
+                kernels.push_back(Kernel(new OpenCLCalcAmoebaMultipoleForceKernel(name, platform, *c, context.getSystem())));
+            return new CommonParallelCalcAmoebaMultipoleForceKernel(name, platform, cc, kernels);
+        }
         return new OpenCLCalcAmoebaMultipoleForceKernel(name, platform, cc, context.getSystem());
+    }
 
     if (name == CalcAmoebaGeneralizedKirkwoodForceKernel::Name())
         return new CommonCalcAmoebaGeneralizedKirkwoodForceKernel(name, platform, cc, context.getSystem());
@@ -50,6 +50,15 @@ public:
     bool useFixedPointChargeSpreading() const {
         return true;
     }
+    /**
+     * Get whether reciprocal space PME may be computed on a separate queue.
+     */
+    bool supportsPmeQueue() const {
+        OpenCLContext& cl = dynamic_cast<OpenCLContext&>(cc);
+        std::string vendor = cl.getDevice().getInfo<CL_DEVICE_VENDOR>();
+        bool isNvidia = (vendor.size() >= 6 && vendor.substr(0, 6) == "NVIDIA");
+        return (!cl.getPlatformData().disablePmeStream && isNvidia);
+    }
 };
 
 
@@ -74,6 +83,15 @@ public:
     bool useFixedPointChargeSpreading() const {
         return true;
     }
+    /**
+     * Get whether reciprocal space PME may be computed on a separate queue.
+     */
+    bool supportsPmeQueue() const {
+        OpenCLContext& cl = dynamic_cast<OpenCLContext&>(cc);
+        std::string vendor = cl.getDevice().getInfo<CL_DEVICE_VENDOR>();
+        bool isNvidia = (vendor.size() >= 6 && vendor.substr(0, 6) == "NVIDIA");
+        return (!cl.getPlatformData().disablePmeStream && isNvidia);
+    }
     /**
      * Sort the atom grid indices.
      */
@@ -29,8 +29,10 @@
 #include "ReferencePlatform.h"
 #include "openmm/internal/ContextImpl.h"
 #include "openmm/OpenMMException.h"
+#include <vector>
 
 using namespace OpenMM;
+using namespace std;
 
 #ifdef OPENMM_BUILDING_STATIC_LIBRARY
 static void registerPlatforms() {
@@ -44,16 +46,20 @@ static void registerKernelFactories() {
 #else
 extern "C" OPENMM_EXPORT void registerKernelFactories() {
 #endif
+    vector<string> kernelNames = {CalcAmoebaTorsionTorsionForceKernel::Name(), CalcAmoebaVdwForceKernel::Name(),
+            CalcAmoebaMultipoleForceKernel::Name(), CalcAmoebaGeneralizedKirkwoodForceKernel::Name(),
+            CalcAmoebaWcaDispersionForceKernel::Name(), CalcHippoNonbondedForceKernel::Name()};
     for (int i = 0; i < Platform::getNumPlatforms(); i++) {
         Platform& platform = Platform::getPlatform(i);
         if (dynamic_cast<ReferencePlatform*>(&platform) != NULL) {
              AmoebaReferenceKernelFactory* factory = new AmoebaReferenceKernelFactory();
-             platform.registerKernelFactory(CalcAmoebaTorsionTorsionForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcAmoebaVdwForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcAmoebaMultipoleForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcAmoebaGeneralizedKirkwoodForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcAmoebaWcaDispersionForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcHippoNonbondedForceKernel::Name(), factory);
+
+             // Subclasses of ReferencePlatform (such as the CPU platform) may already have optimized
+             // versions of some kernels registered by another plugin.  Don't replace them.
+
+             for (auto& name : kernelNames)
+                 if (!platform.supportsKernels({name}))
+                     platform.registerKernelFactory(name, factory);
         }
     }
 }
@@ -41,7 +41,9 @@
 #include "openmm/internal/NonbondedForceImpl.h"
 #include "SimTKReference/AmoebaReferenceHippoNonbondedForce.h"
 
+#include <algorithm>
 #include <cmath>
+#include <iostream>
 #ifdef _MSC_VER
 #include <windows.h>
 #endif
@@ -74,6 +76,20 @@ static Vec3* extractBoxVectors(ContextImpl& context) {
     return data->periodicBoxVectors;
 }
 
+static ThreadPool& extractThreadPool(ContextImpl& context) {
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    return data->threads;
+}
+
+static double binomialCoefficient(int n, int k) {
+    if (k < 0 || k > n)
+        return 0.0;
+    double result = 1.0;
+    for (int i = 1; i <= k; i++)
+        result = result*(n-k+i)/i;
+    return result;
+}
+
 // ***************************************************************************
 
 ReferenceCalcAmoebaTorsionTorsionForceKernel::ReferenceCalcAmoebaTorsionTorsionForceKernel(const std::string& name, const Platform& platform, const System& system) :
@@ -160,7 +176,8 @@ double ReferenceCalcAmoebaTorsionTorsionForceKernel::execute(ContextImpl& contex
  * -------------------------------------------------------------------------- */
 
 ReferenceCalcAmoebaMultipoleForceKernel::ReferenceCalcAmoebaMultipoleForceKernel(const std::string& name, const Platform& platform, const System& system) :
-         CalcAmoebaMultipoleForceKernel(name, platform), system(system), numMultipoles(0), mutualInducedMaxIterations(60), mutualInducedTargetEpsilon(1.0e-03),
+         CalcAmoebaMultipoleForceKernel(name, platform), system(system), numMultipoles(0), mutualInducedMaxIterations(60), mutualInducedTargetEpsilon(1.0e-03), mutualInducedSolver(AmoebaMultipoleForce::DIIS),
+                                                         predictorHistoryLength(0), predictorHistorySize(0), predictorNewestSlot(0), predictorLastStep(0),
                                                          usePme(false),alphaEwald(0.0), cutoffDistance(1.0) {  
 
 }
@@ -235,6 +252,33 @@ void ReferenceCalcAmoebaMultipoleForceKernel::initialize(const System& system, c
     if (polarizationType == AmoebaMultipoleForce::Mutual) {
         mutualInducedMaxIterations = force.getMutualInducedMaxIterations();
         mutualInducedTargetEpsilon = force.getMutualInducedTargetEpsilon();
+        mutualInducedSolver = force.getMutualInducedSolver();
+        if (force.getMutualInducedPredictor() != AmoebaMultipoleForce::NoPredictor) {
+            // These are the same predictors used by the GPU platforms.
+
+            int order = force.getMutualInducedPredictorOrder();
+            if (force.getMutualInducedPredictor() == AmoebaMultipoleForce::ASPC) {
+                double denominator = binomialCoefficient(2*order+2, order+1);
+                for (int j = 1; j <= order+2; j++)
+                    predictorCoefficients.push_back((j%2 == 1 ? 1 : -1)*j*binomialCoefficient(2*order+4, order+2-j)/denominator);
+            }
+            else if (force.getMutualInducedPredictor() == AmoebaMultipoleForce::Polynomial) {
+                for (int j = 1; j <= order+1; j++)
+                    predictorCoefficients.push_back((j%2 == 1 ? 1 : -1)*binomialCoefficient(order+1, j));
+            }
+            else {
+                const double kappa = 1.82, alpha = 0.018;
+                const double c[] = {-6, 14, -8, -3, 4, -1};
+                auxiliaryCoefficients.push_back(kappa);
+                for (int k = 0; k < 6; k++)
+                    auxiliaryCoefficients.push_back(alpha*c[k] + (k == 0 ? 2-kappa : k == 1 ? -1 : 0));
+                predictorCoefficients.resize(auxiliaryCoefficients.size(), 0.0);
+                predictorCoefficients[0] = 1.0;
+            }
+            predictorHistoryLength = predictorCoefficients.size();
+            dipoleHistory.resize(predictorHistoryLength, vector<Vec3>(numMultipoles));
+            dipoleHistoryPolar.resize(predictorHistoryLength, vector<Vec3>(numMultipoles));
+        }
     }
     else if (polarizationType == AmoebaMultipoleForce::Extrapolated) {
         extrapolationCoefficients = force.getExtrapolationCoefficients();
@@ -302,6 +346,7 @@ AmoebaReferenceMultipoleForce* ReferenceCalcAmoebaMultipoleForceKernel::setupAmo
         gkKernel->getTanhParameters(beta0, beta1, beta2);
         amoebaReferenceGeneralizedKirkwoodForce->setTanhParameters(beta0, beta1, beta2);
         amoebaReferenceGeneralizedKirkwoodForce->setDescreenOffset(gkKernel->getDescreenOffset());
+        amoebaReferenceGeneralizedKirkwoodForce->setCutoff(gkKernel->getUseCutoff(), gkKernel->getCutoffDistance());
         amoebaReferenceGeneralizedKirkwoodForce->setAtomicRadii(gkKernel->getAtomicRadii());
         amoebaReferenceGeneralizedKirkwoodForce->setScaleFactors(gkKernel->getScaleFactors());
         amoebaReferenceGeneralizedKirkwoodForce->setCharges(gkKernel->getCharges());
@@ -310,14 +355,14 @@ AmoebaReferenceMultipoleForce* ReferenceCalcAmoebaMultipoleForceKernel::setupAmo
 
         // calculate Grycuk Born radii
         vector<Vec3>& posData   = extractPositions(context);
-        amoebaReferenceGeneralizedKirkwoodForce->calculateGrycukBornRadii(posData);
+        gkKernel->computeBornRadii(*amoebaReferenceGeneralizedKirkwoodForce, posData);
 
         amoebaReferenceMultipoleForce = new AmoebaReferenceGeneralizedKirkwoodMultipoleForce(amoebaReferenceGeneralizedKirkwoodForce);
 
     }
     else if (usePme) {
 
-        AmoebaReferencePmeMultipoleForce* amoebaReferencePmeMultipoleForce = new AmoebaReferencePmeMultipoleForce();
+        AmoebaReferencePmeMultipoleForce* amoebaReferencePmeMultipoleForce = createPmeMultipoleForce(context);
         amoebaReferencePmeMultipoleForce->setAlphaEwald(alphaEwald);
         amoebaReferencePmeMultipoleForce->setCutoffDistance(cutoffDistance);
         amoebaReferencePmeMultipoleForce->setPmeGridDimensions(pmeGridDimension);
@@ -333,6 +378,7 @@ AmoebaReferenceMultipoleForce* ReferenceCalcAmoebaMultipoleForceKernel::setupAmo
     else {
          amoebaReferenceMultipoleForce = new AmoebaReferenceMultipoleForce(AmoebaReferenceMultipoleForce::NoCutoff);
     }
+    amoebaReferenceMultipoleForce->setThreadPool(&extractThreadPool(context));
 
     // set polarization type
 
@@ -340,6 +386,7 @@ AmoebaReferenceMultipoleForce* ReferenceCalcAmoebaMultipoleForceKernel::setupAmo
         amoebaReferenceMultipoleForce->setPolarizationType(AmoebaReferenceMultipoleForce::Mutual);
         amoebaReferenceMultipoleForce->setMutualInducedDipoleTargetEpsilon(mutualInducedTargetEpsilon);
         amoebaReferenceMultipoleForce->setMaximumMutualInducedDipoleIterations(mutualInducedMaxIterations);
+        amoebaReferenceMultipoleForce->setMutualInducedDipoleSolver(mutualInducedSolver);
     }
     else if (polarizationType == AmoebaMultipoleForce::Direct) {
         amoebaReferenceMultipoleForce->setPolarizationType(AmoebaReferenceMultipoleForce::Direct);
@@ -356,16 +403,22 @@ AmoebaReferenceMultipoleForce* ReferenceCalcAmoebaMultipoleForceKernel::setupAmo
 
 }
 
+AmoebaReferencePmeMultipoleForce* ReferenceCalcAmoebaMultipoleForceKernel::createPmeMultipoleForce(ContextImpl& context) {
+    return new AmoebaReferencePmeMultipoleForce();
+}
+
 double ReferenceCalcAmoebaMultipoleForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
 
     AmoebaReferenceMultipoleForce* amoebaReferenceMultipoleForce = setupAmoebaReferenceMultipoleForce(context);
 
     vector<Vec3>& posData = extractPositions(context);
     vector<Vec3>& forceData = extractForces(context);
+    predictInducedDipoles(context, amoebaReferenceMultipoleForce);
     double energy = amoebaReferenceMultipoleForce->calculateForceAndEnergy(posData, charges, dipoles, quadrupoles, tholes,
                                                                            dampingFactors, polarity, axisTypes, 
                                                                            multipoleAtomZs, multipoleAtomXs, multipoleAtomYs,
                                                                            multipoleAtomCovalentInfo, forceData);
+    recordInducedDipoleHistory(context, amoebaReferenceMultipoleForce);
 
     delete amoebaReferenceMultipoleForce;
 
@@ -456,6 +509,23 @@ void ReferenceCalcAmoebaMultipoleForceKernel::getElectrostaticPotential(ContextI
     delete amoebaReferenceMultipoleForce;
 }
 
+void ReferenceCalcAmoebaMultipoleForceKernel::getPMEElectrostaticPotential(ContextImpl& context, const std::vector< Vec3 >& inputGrid,
+                                                                           std::vector< double >& outputElectrostaticPotential) {
+
+    AmoebaReferenceMultipoleForce* amoebaReferenceMultipoleForce = setupAmoebaReferenceMultipoleForce(context);
+    AmoebaReferencePmeMultipoleForce* amoebaReferencePmeMultipoleForce = dynamic_cast<AmoebaReferencePmeMultipoleForce*>(amoebaReferenceMultipoleForce);
+    if (amoebaReferencePmeMultipoleForce == NULL) {
+        delete amoebaReferenceMultipoleForce;
+        throw OpenMMException("getPMEElectrostaticPotential: PME is not being used");
+    }
+    vector<Vec3>& posData = extractPositions(context);
+    amoebaReferencePmeMultipoleForce->calculatePmeElectrostaticPotential(posData, charges, dipoles, quadrupoles, tholes,
+                                                                         dampingFactors, polarity, axisTypes,
+                                                                         multipoleAtomZs, multipoleAtomXs, multipoleAtomYs,
+                                                                         multipoleAtomCovalentInfo, inputGrid, outputElectrostaticPotential);
+    delete amoebaReferenceMultipoleForce;
+}
+
 void ReferenceCalcAmoebaMultipoleForceKernel::getSystemMultipoleMoments(ContextImpl& context, std::vector< double >& outputMultipoleMoments) {
 
     // retrieve masses
@@ -522,12 +592,99 @@ void ReferenceCalcAmoebaMultipoleForceKernel::getPMEParameters(double& alpha, in
     nz = pmeGridDimension[2];
 }
 
+void ReferenceCalcAmoebaMultipoleForceKernel::predictInducedDipoles(ContextImpl& context, AmoebaReferenceMultipoleForce* multipoleForce) {
+    // The history can only be used if it covers the immediately preceding steps.  The extended
+    // Lagrangian predictor only needs the newest auxiliary dipoles.
+
+    int requiredSize = (auxiliaryCoefficients.size() > 0 ? 1 : predictorHistoryLength);
+    if (predictorHistoryLength == 0 || predictorHistorySize < requiredSize || context.getStepCount() != predictorLastStep+1)
+        return;
+    vector<Vec3> predicted(numMultipoles), predictedPolar(numMultipoles);
+    for (int i = 0; i < predictorHistoryLength; i++) {
+        int slot = (predictorNewestSlot-i+predictorHistoryLength)%predictorHistoryLength;
+        for (int j = 0; j < numMultipoles; j++) {
+            predicted[j] += dipoleHistory[slot][j]*predictorCoefficients[i];
+            predictedPolar[j] += dipoleHistoryPolar[slot][j]*predictorCoefficients[i];
+        }
+    }
+    multipoleForce->setInitialInducedDipoles(predicted, predictedPolar);
+}
+
+void ReferenceCalcAmoebaMultipoleForceKernel::recordInducedDipoleHistory(ContextImpl& context, AmoebaReferenceMultipoleForce* multipoleForce) {
+    if (predictorHistoryLength == 0)
+        return;
+    long long step = context.getStepCount();
+    if (predictorHistorySize == 0 || step != predictorLastStep) {
+        if (predictorHistorySize > 0 && step != predictorLastStep+1)
+            predictorHistorySize = 0;
+        predictorNewestSlot = (predictorNewestSlot+1)%predictorHistoryLength;
+        predictorHistorySize = min(predictorHistorySize+1, predictorHistoryLength);
+    }
+
+    // If the forces are being recomputed for the same step, this replaces the newest entry.
+
+    predictorLastStep = step;
+    vector<Vec3> inducedDipole, inducedDipolePolar;
+    multipoleForce->getInducedDipoles(inducedDipole, inducedDipolePolar);
+    if (auxiliaryCoefficients.size() > 0 && predictorHistorySize == predictorHistoryLength) {
+        // Propagate the auxiliary dipoles of the extended Lagrangian predictor.  Until the history is
+        // complete, they are restarted from the current dipoles.
+
+        for (int j = 0; j < numMultipoles; j++) {
+            inducedDipole[j] *= auxiliaryCoefficients[0];
+            inducedDipolePolar[j] *= auxiliaryCoefficients[0];
+        }
+        for (int i = 1; i < predictorHistoryLength; i++) {
+            int slot = (predictorNewestSlot-i+predictorHistoryLength)%predictorHistoryLength;
+            for (int j = 0; j < numMultipoles; j++) {
+                inducedDipole[j] += dipoleHistory[slot][j]*auxiliaryCoefficients[i];
+                inducedDipolePolar[j] += dipoleHistoryPolar[slot][j]*auxiliaryCoefficients[i];
+            }
+        }
+    }
+    dipoleHistory[predictorNewestSlot] = inducedDipole;
+    dipoleHistoryPolar[predictorNewestSlot] = inducedDipolePolar;
+}
+
+void ReferenceCalcAmoebaMultipoleForceKernel::createCheckpoint(ContextImpl& context, ostream& stream) {
+    if (predictorHistoryLength == 0)
+        return;
+    stream.write((char*) &numMultipoles, sizeof(int));
+    stream.write((char*) &predictorHistoryLength, sizeof(int));
+    stream.write((char*) &predictorHistorySize, sizeof(int));
+    stream.write((char*) &predictorNewestSlot, sizeof(int));
+    stream.write((char*) &predictorLastStep, sizeof(long long));
+    for (int i = 0; i < predictorHistoryLength; i++) {
+        stream.write((char*) dipoleHistory[i].data(), numMultipoles*sizeof(Vec3));
+        stream.write((char*) dipoleHistoryPolar[i].data(), numMultipoles*sizeof(Vec3));
+    }
+}
+
+void ReferenceCalcAmoebaMultipoleForceKernel::loadCheckpoint(ContextImpl& context, istream& stream) {
+    int numParticles, historyLength, historySize, newestSlot;
+    long long lastStep;
+    stream.read((char*) &numParticles, sizeof(int));
+    stream.read((char*) &historyLength, sizeof(int));
+    stream.read((char*) &historySize, sizeof(int));
+    stream.read((char*) &newestSlot, sizeof(int));
+    stream.read((char*) &lastStep, sizeof(long long));
+    if (numParticles != numMultipoles || historyLength != predictorHistoryLength)
+        return;
+    for (int i = 0; i < predictorHistoryLength; i++) {
+        stream.read((char*) dipoleHistory[i].data(), numMultipoles*sizeof(Vec3));
+        stream.read((char*) dipoleHistoryPolar[i].data(), numMultipoles*sizeof(Vec3));
+    }
+    predictorHistorySize = historySize;
+    predictorNewestSlot = newestSlot;
+    predictorLastStep = lastStep;
+}
+
 /* -------------------------------------------------------------------------- *
  *                       AmoebaGeneralizedKirkwood                            *
  * -------------------------------------------------------------------------- */
 
 ReferenceCalcAmoebaGeneralizedKirkwoodForceKernel::ReferenceCalcAmoebaGeneralizedKirkwoodForceKernel(const std::string& name, const Platform& platform, const System& system) :
-           CalcAmoebaGeneralizedKirkwoodForceKernel(name, platform), system(system) {
+           CalcAmoebaGeneralizedKirkwoodForceKernel(name, platform), system(system), evaluationsSinceBornRadii(0), hasBornRadii(false) {
 }
 
 ReferenceCalcAmoebaGeneralizedKirkwoodForceKernel::~ReferenceCalcAmoebaGeneralizedKirkwoodForceKernel() {
@@ -579,6 +736,14 @@ double ReferenceCalcAmoebaGeneralizedKirkwoodForceKernel::getSurfaceAreaFactor()
     return surfaceAreaFactor;
 }
 
+bool ReferenceCalcAmoebaGeneralizedKirkwoodForceKernel::getUseCutoff() const {
+    return useCutoff;
+}
+
+double ReferenceCalcAmoebaGeneralizedKirkwoodForceKernel::getCutoffDistance() const {
+    return cutoffDistance;
+}
+
 const vector<double>& ReferenceCalcAmoebaGeneralizedKirkwoodForceKernel::getAtomicRadii() const {
     return atomicRadii;
 }
@@ -650,14 +815,41 @@ void ReferenceCalcAmoebaGeneralizedKirkwoodForceKernel::initialize(const System&
     dielectricOffset   = force.getDielectricOffset();
     probeRadius        = force.getProbeRadius();
     surfaceAreaFactor  = force.getSurfaceAreaFactor();
+    useCutoff          = (force.getNonbondedMethod() == AmoebaGeneralizedKirkwoodForce::CutoffNonPeriodic);
+    cutoffDistance     = force.getCutoffDistance();
     directPolarization = amoebaMultipoleForce->getPolarizationType() == AmoebaMultipoleForce::Direct ? 1 : 0;
+    bornRadiiUpdateInterval  = force.getBornRadiiUpdateInterval();
+    bornRadiiUpdateTolerance = force.getBornRadiiUpdateTolerance();
 }
 
 double ReferenceCalcAmoebaGeneralizedKirkwoodForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
     // handled in AmoebaReferenceGeneralizedKirkwoodMultipoleForce, a derived class of the class AmoebaReferenceMultipoleForce
+    // Only count the evaluation, so we know when the Born radii need to be recomputed.
+    evaluationsSinceBornRadii++;
     return 0.0;
 }
 
+void ReferenceCalcAmoebaGeneralizedKirkwoodForceKernel::computeBornRadii(AmoebaReferenceGeneralizedKirkwoodForce& gkForce, const vector<Vec3>& positions) {
+    bool update = (!hasBornRadii || bornRadiiUpdateInterval <= 1 || evaluationsSinceBornRadii >= bornRadiiUpdateInterval);
+    if (!update && bornRadiiUpdateTolerance > 0.0) {
+        double toleranceSquared = bornRadiiUpdateTolerance*bornRadiiUpdateTolerance;
+        for (int ii = 0; ii < numParticles && !update; ii++) {
+            Vec3 delta = positions[ii]-bornRadiiPositions[ii];
+            update = (delta.dot(delta) > toleranceSquared);
+        }
+    }
+    if (update) {
+        gkForce.calculateGrycukBornRadii(positions);
+        gkForce.getGrycukBornRadii(bornRadii);
+        gkForce.getSoluteIntegral(soluteIntegral);
+        bornRadiiPositions = positions;
+        hasBornRadii = true;
+        evaluationsSinceBornRadii = 0;
+    }
+    else
+        gkForce.setGrycukBornRadii(bornRadii, soluteIntegral);
+}
+
 void ReferenceCalcAmoebaGeneralizedKirkwoodForceKernel::copyParametersToContext(ContextImpl& context, const AmoebaGeneralizedKirkwoodForce& force) {
     if (numParticles != force.getNumParticles())
         throw OpenMMException("updateParametersInContext: The number of particles has changed");
@@ -673,6 +865,7 @@ void ReferenceCalcAmoebaGeneralizedKirkwoodForceKernel::copyParametersToContext(
         descreenRadii[i] = descreenRadius;
         neckFactors[i] = neckFactor;
     }
+    hasBornRadii = false;
 }
 
 ReferenceCalcAmoebaVdwForceKernel::ReferenceCalcAmoebaVdwForceKernel(const std::string& name, const Platform& platform, const System& system) :
@@ -732,15 +925,48 @@ void ReferenceCalcAmoebaVdwForceKernel::copyParametersToContext(ContextImpl& con
     vdwForce.initialize(force);
 }
 
+void ReferenceCalcAmoebaVdwForceKernel::computeLambdaEnergies(ContextImpl& context, const vector<double>& lambdas, vector<double>& energies) {
+
+    // Build the neighbor list once, then evaluate the energy at each lambda into a scratch force array.
+
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3> scratchForces(numParticles);
+    double dispersionEnergy = 0.0;
+    if (useCutoff) {
+        Vec3* boxVectors = extractBoxVectors(context);
+        computeNeighborListVoxelHash(*neighborList, numParticles, posData, vdwForce.getExclusions(), boxVectors, usePBC, cutoff, 0.0);
+        if (usePBC) {
+            double minAllowedSize = 1.999999*cutoff;
+            if (boxVectors[0][0] < minAllowedSize || boxVectors[1][1] < minAllowedSize || boxVectors[2][2] < minAllowedSize)
+                throw OpenMMException("The periodic box size has decreased to less than twice the cutoff.");
+            vdwForce.setPeriodicBox(boxVectors);
+            dispersionEnergy = dispersionCoefficient/(boxVectors[0][0]*boxVectors[1][1]*boxVectors[2][2]);
+        }
+    }
+    energies.resize(lambdas.size());
+    for (int i = 0; i < (int) lambdas.size(); i++) {
+        if (useCutoff)
+            energies[i] = vdwForce.calculateForceAndEnergy(numParticles, lambdas[i], posData, *neighborList, scratchForces);
+        else
+            energies[i] = vdwForce.calculateForceAndEnergy(numParticles, lambdas[i], posData, scratchForces);
+        energies[i] += dispersionEnergy;
+    }
+}
+
 /* -------------------------------------------------------------------------- *
  *                           AmoebaWcaDispersion                              *
  * -------------------------------------------------------------------------- */
 
 ReferenceCalcAmoebaWcaDispersionForceKernel::ReferenceCalcAmoebaWcaDispersionForceKernel(const std::string& name, const Platform& platform, const System& system) :
            CalcAmoebaWcaDispersionForceKernel(name, platform), system(system) {
+    useCutoff = false;
+    cutoff = 1.0e+10;
+    neighborList = NULL;
 }
 
 ReferenceCalcAmoebaWcaDispersionForceKernel::~ReferenceCalcAmoebaWcaDispersionForceKernel() {
+    if (neighborList)
+        delete neighborList;
 }
 
 void ReferenceCalcAmoebaWcaDispersionForceKernel::initialize(const System& system, const AmoebaWcaDispersionForce& force) {
@@ -769,13 +995,25 @@ void ReferenceCalcAmoebaWcaDispersionForceKernel::initialize(const System& syste
     shctd   = force.getShctd();
     dispoff = force.getDispoff();
     slevy   = force.getSlevy();
+
+    useCutoff    = (force.getNonbondedMethod() != AmoebaWcaDispersionForce::NoCutoff);
+    cutoff       = force.getCutoffDistance();
+    neighborList = useCutoff ? new NeighborList() : NULL;
 }
 
 double ReferenceCalcAmoebaWcaDispersionForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
     vector<Vec3>& posData = extractPositions(context);
     vector<Vec3>& forceData = extractForces(context);
     AmoebaReferenceWcaDispersionForce amoebaReferenceWcaDispersionForce(epso, epsh, rmino, rminh, awater, shctd, dispoff, slevy);
-    double energy = amoebaReferenceWcaDispersionForce.calculateForceAndEnergy(numParticles, posData, radii, epsilons, totalMaximumDispersionEnergy, forceData);
+    double energy;
+    if (useCutoff) {
+        ExclusionList exclusions(numParticles);
+        computeNeighborListVoxelHash(*neighborList, numParticles, posData, exclusions, extractBoxVectors(context), false, cutoff, 0.0);
+        amoebaReferenceWcaDispersionForce.setCutoff(cutoff);
+        energy = amoebaReferenceWcaDispersionForce.calculateForceAndEnergy(numParticles, posData, radii, epsilons, totalMaximumDispersionEnergy, *neighborList, forceData);
+    }
+    else
+        energy = amoebaReferenceWcaDispersionForce.calculateForceAndEnergy(numParticles, posData, radii, epsilons, totalMaximumDispersionEnergy, forceData);
     return static_cast<double>(energy);
 }
 
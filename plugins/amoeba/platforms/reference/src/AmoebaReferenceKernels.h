@@ -141,6 +141,16 @@ public:
     void getElectrostaticPotential(ContextImpl& context, const std::vector< Vec3 >& inputGrid,
                                    std::vector< double >& outputElectrostaticPotential);
 
+    /** 
+     * Calculate the electrostatic potential given vector of grid coordinates, using Ewald summation.
+     *
+     * @param context                      context
+     * @param inputGrid                    input grid coordinates
+     * @param outputElectrostaticPotential output potential 
+     */
+    void getPMEElectrostaticPotential(ContextImpl& context, const std::vector< Vec3 >& inputGrid,
+                                      std::vector< double >& outputElectrostaticPotential);
+
     /**
      * Get the system multipole moments.
      *
@@ -169,6 +179,29 @@ public:
      * @param nz      the number of grid points along the Z axis
      */
     void getPMEParameters(double& alpha, int& nx, int& ny, int& nz) const;
+    /**
+     * Write the history used to predict the induced dipoles to a checkpoint.
+     *
+     * @param context    the context for which to save the history
+     * @param stream     an output stream the data should be written to
+     */
+    void createCheckpoint(ContextImpl& context, std::ostream& stream);
+    /**
+     * Load the history used to predict the induced dipoles from a checkpoint.
+     *
+     * @param context    the context for which to load the history
+     * @param stream     an input stream the data should be read from
+     */
+    void loadCheckpoint(ContextImpl& context, std::istream& stream);
+
+protected:
+    /**
+     * Create the object used to compute PME multipole interactions.  Subclasses may
+     * override this to substitute a different implementation.
+     *
+     * @param context        the current context
+     */
+    virtual AmoebaReferencePmeMultipoleForce* createPmeMultipoleForce(ContextImpl& context);
 
 private:
 
@@ -189,8 +222,22 @@ private:
 
     int mutualInducedMaxIterations;
     double mutualInducedTargetEpsilon;
+    AmoebaMultipoleForce::MutualInducedSolver mutualInducedSolver;
     std::vector<double> extrapolationCoefficients;
 
+    /**
+     * Use the history of converged dipoles from previous steps to set the starting point of the iteration.
+     */
+    void predictInducedDipoles(ContextImpl& context, AmoebaReferenceMultipoleForce* multipoleForce);
+    /**
+     * Store the converged dipoles into the history.
+     */
+    void recordInducedDipoleHistory(ContextImpl& context, AmoebaReferenceMultipoleForce* multipoleForce);
+    int predictorHistoryLength, predictorHistorySize, predictorNewestSlot;
+    long long predictorLastStep;
+    std::vector<double> predictorCoefficients, auxiliaryCoefficients;
+    std::vector<std::vector<Vec3> > dipoleHistory, dipoleHistoryPolar;
+
     bool usePme;
     double alphaEwald;
     double cutoffDistance;
@@ -229,6 +276,14 @@ public:
      * @param force      the AmoebaVdwForce to copy the parameters from
      */
     void copyParametersToContext(ContextImpl& context, const AmoebaVdwForce& force);
+    /**
+     * Compute the energy of the force at each of a list of values for the lambda parameter.
+     *
+     * @param context        the context in which to execute this kernel
+     * @param lambdas        the values of the lambda parameter at which to evaluate the energy
+     * @param[out] energies  on exit, energies[i] is the energy when lambda equals lambdas[i]
+     */
+    void computeLambdaEnergies(ContextImpl& context, const std::vector<double>& lambdas, std::vector<double>& energies);
 private:
     int numParticles;
     int useCutoff;
@@ -285,6 +340,9 @@ private:
     double dispoff;
     double slevy;
     double totalMaximumDispersionEnergy;
+    bool useCutoff;
+    double cutoff;
+    NeighborList* neighborList;
     const System& system;
 };
 
@@ -338,6 +396,20 @@ public:
      */
     double getDescreenOffset() const;
 
+    /**
+     *  Get whether interactions beyond the cutoff distance are ignored.
+     *
+     *  @return useCutoff
+     */
+    bool getUseCutoff() const;
+
+    /**
+     *  Get the cutoff distance.
+     *
+     *  @return cutoffDistance
+     */
+    double getCutoffDistance() const;
+
     /**
      *  Get the number of particles.
      *
@@ -417,6 +489,16 @@ public:
      */
     const vector<double>& getNeckFactors() const;
 
+    /**
+     * Set the Born radii in an AmoebaReferenceGeneralizedKirkwoodForce.  They are only recomputed
+     * when the update interval has elapsed or an atom has moved farther than the update tolerance;
+     * otherwise the most recently computed values are reused.
+     *
+     * @param gkForce    the force in which to set the Born radii
+     * @param positions  the current atom positions
+     */
+    void computeBornRadii(AmoebaReferenceGeneralizedKirkwoodForce& gkForce, const vector<Vec3>& positions);
+
     /**
      * Copy changed parameters over to a context.
      *
@@ -444,7 +526,16 @@ private:
     double beta1;
     double beta2;
     double descreenOffset;
+    bool useCutoff;
+    double cutoffDistance;
     int directPolarization;
+    int bornRadiiUpdateInterval;
+    double bornRadiiUpdateTolerance;
+    int evaluationsSinceBornRadii;
+    bool hasBornRadii;
+    std::vector<double> bornRadii;
+    std::vector<double> soluteIntegral;
+    std::vector<Vec3> bornRadiiPositions;
     const System& system;
 };
 
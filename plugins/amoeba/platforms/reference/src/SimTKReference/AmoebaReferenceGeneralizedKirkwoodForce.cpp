@@ -43,7 +43,9 @@ AmoebaReferenceGeneralizedKirkwoodForce::AmoebaReferenceGeneralizedKirkwoodForce
                                                                                      _beta0(0.9563),
                                                                                      _beta1(0.2578),
                                                                                      _beta2(0.0810),
-                                                                                     _descreenOffset(0.0) {
+                                                                                     _descreenOffset(0.0),
+                                                                                     _useCutoff(false),
+                                                                                     _cutoffDistance(1.0) {
 }
 
 void AmoebaReferenceGeneralizedKirkwoodForce::setNumParticles(int numParticles) {
@@ -97,6 +99,19 @@ double AmoebaReferenceGeneralizedKirkwoodForce::getDescreenOffset() const {
     return _descreenOffset;
 }
 
+void AmoebaReferenceGeneralizedKirkwoodForce::setCutoff(bool useCutoff, double cutoffDistance) {
+    _useCutoff = useCutoff;
+    _cutoffDistance = cutoffDistance;
+}
+
+bool AmoebaReferenceGeneralizedKirkwoodForce::getUseCutoff() const {
+    return _useCutoff;
+}
+
+double AmoebaReferenceGeneralizedKirkwoodForce::getCutoffDistance() const {
+    return _cutoffDistance;
+}
+
 void AmoebaReferenceGeneralizedKirkwoodForce::setDirectPolarization(int directPolarization) {
     _directPolarization = directPolarization;
 }
@@ -200,6 +215,75 @@ void AmoebaReferenceGeneralizedKirkwoodForce::getSoluteIntegral(vector<double> &
     copy(_soluteIntegral.begin(), _soluteIntegral.end(), soluteIntegral.begin());
 }
 
+void AmoebaReferenceGeneralizedKirkwoodForce::setGrycukBornRadii(const vector<double>& bornRadii, const vector<double>& soluteIntegral) {
+    _bornRadii = bornRadii;
+    _soluteIntegral = soluteIntegral;
+}
+
+double AmoebaReferenceGeneralizedKirkwoodForce::calculateTaper(double r, double cutoff, double& dtaper) {
+    const double taperCutoff = 0.9*cutoff;
+    dtaper = 0.0;
+    if (r <= taperCutoff)
+        return 1.0;
+    if (r >= cutoff)
+        return 0.0;
+    double c3 = 10.0/pow(taperCutoff - cutoff, 3.0);
+    double c4 = 15.0/pow(taperCutoff - cutoff, 4.0);
+    double c5 =  6.0/pow(taperCutoff - cutoff, 5.0);
+    double delta = r - taperCutoff;
+    dtaper = delta*delta*(3.0*c3 + delta*(4.0*c4 + delta*5.0*c5));
+    return 1.0 + delta*delta*delta*(c3 + delta*(c4 + delta*c5));
+}
+
+double AmoebaReferenceGeneralizedKirkwoodForce::calculateDescreeningIntegral(double r, double integralStart, double sk, double descreenRadius, double mixedNeckScale) {
+    const double PI4_3 = 4.0 / 3.0 * M_PI;
+
+    // If the descreened atom engulfs the descreening atom, then there is no descreening.
+    if (integralStart > r + sk)
+        return 0.0;
+
+    double r2 = r * r;
+    double sk2 = sk * sk;
+    double bornSum = 0.0;
+
+    if ((integralStart + r) < sk) {
+        double lik = integralStart;
+        double uik = sk - r;
+        double lik3 = lik * lik * lik;
+        double uik3 = uik * uik * uik;
+        bornSum -= (1.0 / uik3 - 1.0 / lik3);
+    }
+
+    double uik = r + sk;
+    double lik;
+    if ((integralStart + r) < sk)
+        lik = sk - r;
+    else if (r < (integralStart + sk))
+        lik = integralStart;
+    else
+        lik = r - sk;
+
+    double l2 = lik * lik;
+    double l4 = l2 * l2;
+    double lr = lik * r;
+    double l4r = l4 * r;
+
+    double u2 = uik * uik;
+    double u4 = u2 * u2;
+    double ur = uik * r;
+    double u4r = u4 * r;
+
+    double term =
+            (3.0 * (r2 - sk2) + 6.0 * u2 - 8.0 * ur) / u4r
+            - (3.0 * (r2 - sk2) + 6.0 * l2 - 8.0 * lr) / l4r;
+    bornSum += term / 16.0;
+
+    double integral = bornSum * PI4_3;
+    if (mixedNeckScale > 0.0)
+        integral += AmoebaGeneralizedKirkwoodForceImpl::neckDescreen(r, integralStart, descreenRadius, mixedNeckScale);
+    return integral;
+}
+
 void AmoebaReferenceGeneralizedKirkwoodForce::calculateGrycukBornRadii(const vector<Vec3> &particlePositions) {
 
     // Set the radius to 30 Angstroms (3 nm) if either the base radius is zero, or the
@@ -213,6 +297,24 @@ void AmoebaReferenceGeneralizedKirkwoodForce::calculateGrycukBornRadii(const vec
     _bornRadii.resize(_numParticles);
     _soluteIntegral.resize(_numParticles);
 
+    // With a cutoff, only pairs in the neighbor list contribute, each tapered near the cutoff.
+
+    vector<vector<int> > neighbors(_numParticles);
+    if (_useCutoff) {
+        NeighborList neighborList;
+        computeNeighborListVoxelHash(neighborList, _numParticles, particlePositions, ExclusionList(_numParticles), NULL, false, _cutoffDistance, 0.0);
+        for (auto& pair : neighborList) {
+            neighbors[pair.first].push_back(pair.second);
+            neighbors[pair.second].push_back(pair.first);
+        }
+    }
+    else {
+        for (int ii = 0; ii < _numParticles; ii++)
+            for (int jj = 0; jj < _numParticles; jj++)
+                if (ii != jj)
+                    neighbors[ii].push_back(jj);
+    }
+
     for (unsigned int ii = 0; ii < _numParticles; ii++) {
 
         if (_atomicRadii[ii] <= 0.0) {
@@ -223,64 +325,23 @@ void AmoebaReferenceGeneralizedKirkwoodForce::calculateGrycukBornRadii(const vec
         double integralStartI = max(_atomicRadii[ii], _descreenRadii[ii]) + _descreenOffset;
 
         double bornSum = 0.0;
-        double neckSum = 0.0;
-        for (unsigned int jj = 0; jj < _numParticles; jj++) {
+        for (int jj : neighbors[ii]) {
 
             double sk = _descreenRadii[jj] * _scaleFactors[jj];
 
-            if (ii == jj || integralStartI <= 0.0 || sk <= 0.0) continue;
-
-            double xr = particlePositions[jj][0] - particlePositions[ii][0];
-            double yr = particlePositions[jj][1] - particlePositions[ii][1];
-            double zr = particlePositions[jj][2] - particlePositions[ii][2];
-
-            double r2 = xr * xr + yr * yr + zr * zr;
-            double r = sqrt(r2);
-
-            // If atom ii engulfs the descreening atom, then continue.
-            if (integralStartI > r + sk) continue;
-
-            double sk2 = sk * sk;
-
-            if ((integralStartI + r) < sk) {
-                double lik = integralStartI;
-                double uik = sk - r;
-                double lik3 = lik * lik * lik;
-                double uik3 = uik * uik * uik;
-                bornSum -= (1.0 / uik3 - 1.0 / lik3);
-            }
-
-            double uik = r + sk;
-            double lik;
-            if ((integralStartI + r) < sk)
-                lik = sk - r;
-            else if (r < (integralStartI + sk))
-                lik = integralStartI;
-            else
-                lik = r - sk;
-
-            double l2 = lik * lik;
-            double l4 = l2 * l2;
-            double lr = lik * r;
-            double l4r = l4 * r;
-
-            double u2 = uik * uik;
-            double u4 = u2 * u2;
-            double ur = uik * r;
-            double u4r = u4 * r;
-
-            double term =
-                    (3.0 * (r2 - sk2) + 6.0 * u2 - 8.0 * ur) / u4r
-                    - (3.0 * (r2 - sk2) + 6.0 * l2 - 8.0 * lr) / l4r;
-            bornSum += term / 16.0;
+            if (integralStartI <= 0.0 || sk <= 0.0) continue;
 
+            Vec3 deltaR = particlePositions[jj] - particlePositions[ii];
+            double r = sqrt(deltaR.dot(deltaR));
             double mixedNeckScale = 0.5 * (_neckFactors[ii] + _neckFactors[jj]);
-            if (mixedNeckScale > 0.0) {
-                neckSum += AmoebaGeneralizedKirkwoodForceImpl::neckDescreen(r, integralStartI, _descreenRadii[jj], mixedNeckScale);
+            double integral = calculateDescreeningIntegral(r, integralStartI, sk, _descreenRadii[jj], mixedNeckScale);
+            if (_useCutoff) {
+                double dtaper;
+                integral *= calculateTaper(r, _cutoffDistance, dtaper);
             }
+            bornSum += integral;
         }
 
-        bornSum = bornSum * PI4_3 + neckSum;
         _soluteIntegral[ii] = bornSum;
 
         double baseRadiusI3 = _atomicRadii[ii] * _atomicRadii[ii] * _atomicRadii[ii];
@@ -26,6 +26,7 @@
 #define __AmoebaReferenceGeneralizedKirkwoodForce_H__
 
 #include "openmm/Vec3.h"
+#include "ReferenceNeighborList.h"
 #include <vector>
 
 using namespace OpenMM;
@@ -128,6 +129,29 @@ public:
      */
     void setDescreenOffset(double descreenOffset);
 
+    /**
+     * Set whether a cutoff is applied to pair interactions.  Interactions are tapered
+     * smoothly to zero between 0.9 times the cutoff distance and the cutoff distance.
+     *
+     * @param useCutoff       true if a cutoff should be applied
+     * @param cutoffDistance  the cutoff distance (nm)
+     */
+    void setCutoff(bool useCutoff, double cutoffDistance);
+
+    /**
+     *  Get whether a cutoff is applied to pair interactions.
+     *
+     *  @return true if a cutoff is applied
+     */
+    bool getUseCutoff() const;
+
+    /**
+     *  Get the cutoff distance.
+     *
+     *  @return cutoff distance (nm)
+     */
+    double getCutoffDistance() const;
+
     /**
      *  Get directPolarization flag 
      *
@@ -316,6 +340,43 @@ public:
      */
     void getSoluteIntegral(vector<double>& soluteIntegral) const;
 
+    /**
+     * Set previously computed Grycuk Born radii and solute integrals, in place of calling
+     * calculateGrycukBornRadii()
+     *
+     * @param bornRadii      vector of Born radii
+     * @param soluteIntegral vector of solute integrals
+     *
+     */
+    void setGrycukBornRadii(const vector<double>& bornRadii, const vector<double>& soluteIntegral);
+
+    /**
+     * Compute the taper applied to pair interactions near the cutoff.  It uses the same
+     * fifth order polynomial as AmoebaVdwForce, switching from 1 at 0.9 times the cutoff
+     * distance to 0 at the cutoff distance.
+     *
+     * @param r       distance between the two particles
+     * @param cutoff  cutoff distance
+     * @param dtaper  on exit, the derivative of the taper with respect to r
+     *
+     * @return the value of the taper
+     */
+    static double calculateTaper(double r, double cutoff, double& dtaper);
+
+    /**
+     * Compute the contribution of one descreening particle to the solute integral of another,
+     * including the neck correction.
+     *
+     * @param r               distance between the two particles
+     * @param integralStart   radius at which the integral starts for the descreened particle
+     * @param sk              scaled descreening radius of the descreening particle
+     * @param descreenRadius  descreening radius of the descreening particle
+     * @param mixedNeckScale  mixed neck scale factor of the two particles
+     *
+     * @return the contribution to the solute integral
+     */
+    static double calculateDescreeningIntegral(double r, double integralStart, double sk, double descreenRadius, double mixedNeckScale);
+
 private:
 
     int _numParticles;
@@ -323,6 +384,8 @@ private:
     int _directPolarization;
     bool _tanhRescaling;
     double _descreenOffset;
+    bool _useCutoff;
+    double _cutoffDistance;
 
     double _soluteDielectric;
     double _solventDielectric;
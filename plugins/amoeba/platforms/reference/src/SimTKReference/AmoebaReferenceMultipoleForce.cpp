@@ -48,9 +48,11 @@ AmoebaReferenceMultipoleForce::AmoebaReferenceMultipoleForce() :
                                                    _mutualInducedDipoleConverged(0),
                                                    _mutualInducedDipoleIterations(0),
                                                    _maximumMutualInducedDipoleIterations(100),
+                                                   _mutualInducedDipoleSolver(AmoebaMultipoleForce::DIIS),
                                                    _mutualInducedDipoleEpsilon(1.0e+50),
                                                    _mutualInducedDipoleTargetEpsilon(1.0e-4),
-                                                   _debye(48.033324)
+                                                   _debye(48.033324),
+                                                   _threads(NULL)
 {
     initialize();
 }
@@ -63,9 +65,11 @@ AmoebaReferenceMultipoleForce::AmoebaReferenceMultipoleForce(NonbondedMethod non
                                                    _mutualInducedDipoleConverged(0),
                                                    _mutualInducedDipoleIterations(0),
                                                    _maximumMutualInducedDipoleIterations(100),
+                                                   _mutualInducedDipoleSolver(AmoebaMultipoleForce::DIIS),
                                                    _mutualInducedDipoleEpsilon(1.0e+50),
                                                    _mutualInducedDipoleTargetEpsilon(1.0e-4),
-                                                   _debye(48.033324)
+                                                   _debye(48.033324),
+                                                   _threads(NULL)
 {
     initialize();
 }
@@ -122,6 +126,37 @@ void AmoebaReferenceMultipoleForce::setPolarizationType(AmoebaReferenceMultipole
     _polarizationType = polarizationType;
 }
 
+void AmoebaReferenceMultipoleForce::setThreadPool(ThreadPool* threads)
+{
+    _threads = threads;
+}
+
+int AmoebaReferenceMultipoleForce::getNumThreads() const
+{
+    return (_threads == NULL ? 1 : _threads->getNumThreads());
+}
+
+void AmoebaReferenceMultipoleForce::executeOnThreads(const std::function<void (int)>& task) const
+{
+    if (getNumThreads() == 1)
+        task(0);
+    else {
+        _threads->execute([&] (ThreadPool& threads, int threadIndex) { task(threadIndex); });
+        _threads->waitForThreads();
+    }
+}
+
+void AmoebaReferenceMultipoleForce::forEachPair(bool includeSelf, const std::function<void (int, int, int)>& pairFunction) const
+{
+    int numThreads = getNumThreads();
+    int numParticles = _numParticles;
+    executeOnThreads([&] (int threadIndex) {
+        for (int ii = threadIndex; ii < numParticles; ii += numThreads)
+            for (int jj = (includeSelf ? ii : ii+1); jj < numParticles; jj++)
+                pairFunction(threadIndex, ii, jj);
+    });
+}
+
 int AmoebaReferenceMultipoleForce::getMutualInducedDipoleConverged() const
 {
     return _mutualInducedDipoleConverged;
@@ -162,6 +197,28 @@ void AmoebaReferenceMultipoleForce::setMaximumMutualInducedDipoleIterations(int
     _maximumMutualInducedDipoleIterations = maximumMutualInducedDipoleIterations;
 }
 
+void AmoebaReferenceMultipoleForce::setMutualInducedDipoleSolver(AmoebaMultipoleForce::MutualInducedSolver solver)
+{
+    _mutualInducedDipoleSolver = solver;
+}
+
+AmoebaMultipoleForce::MutualInducedSolver AmoebaReferenceMultipoleForce::getMutualInducedDipoleSolver() const
+{
+    return _mutualInducedDipoleSolver;
+}
+
+void AmoebaReferenceMultipoleForce::setInitialInducedDipoles(const vector<Vec3>& inducedDipole, const vector<Vec3>& inducedDipolePolar)
+{
+    _initialInducedDipole = inducedDipole;
+    _initialInducedDipolePolar = inducedDipolePolar;
+}
+
+void AmoebaReferenceMultipoleForce::getInducedDipoles(vector<Vec3>& inducedDipole, vector<Vec3>& inducedDipolePolar) const
+{
+    inducedDipole = _inducedDipole;
+    inducedDipolePolar = _inducedDipolePolar;
+}
+
 double AmoebaReferenceMultipoleForce::getMutualInducedDipoleTargetEpsilon() const
 {
     return _mutualInducedDipoleTargetEpsilon;
@@ -818,6 +875,13 @@ void AmoebaReferenceMultipoleForce::initializeInducedDipoles(vector<UpdateInduce
         _inducedDipole[ii]       = _fixedMultipoleField[ii];
         _inducedDipolePolar[ii]  = _fixedMultipoleFieldPolar[ii];
     }
+
+    // if an initial guess was provided, start the iteration from it instead
+
+    if (getPolarizationType() == AmoebaReferenceMultipoleForce::Mutual && _initialInducedDipole.size() == _numParticles) {
+        _inducedDipole      = _initialInducedDipole;
+        _inducedDipolePolar = _initialInducedDipolePolar;
+    }
 }
 
 void AmoebaReferenceMultipoleForce::calculateInducedDipolePairIxn(unsigned int particleI,
@@ -917,11 +981,28 @@ void AmoebaReferenceMultipoleForce::calculateInducedDipoleFields(const vector<Mu
     for (auto& field : updateInducedDipoleFields)
         std::fill(field.inducedDipoleField.begin(), field.inducedDipoleField.end(), zeroVec);
 
-    // Add fields from all induced dipoles.
+    // Add fields from all induced dipoles.  The first thread accumulates directly into the
+    // output fields, while every other thread uses its own copy that shares the pointers
+    // to the input dipoles.
 
-    for (unsigned int ii = 0; ii < particleData.size(); ii++)
-        for (unsigned int jj = ii; jj < particleData.size(); jj++)
-            calculateInducedDipolePairIxns(particleData[ii], particleData[jj], updateInducedDipoleFields);
+    int numThreads = getNumThreads();
+    vector<vector<UpdateInducedDipoleFieldStruct> > threadFields(numThreads-1, updateInducedDipoleFields);
+    vector<double> zeros(6, 0.0);
+    for (auto& fields : threadFields)
+        for (auto& field : fields)
+            std::fill(field.inducedDipoleFieldGradient.begin(), field.inducedDipoleFieldGradient.end(), zeros);
+    forEachPair(true, [&] (int threadIndex, int ii, int jj) {
+        calculateInducedDipolePairIxns(particleData[ii], particleData[jj], threadIndex == 0 ? updateInducedDipoleFields : threadFields[threadIndex-1]);
+    });
+    for (auto& fields : threadFields)
+        for (unsigned int ii = 0; ii < updateInducedDipoleFields.size(); ii++) {
+            UpdateInducedDipoleFieldStruct& field = updateInducedDipoleFields[ii];
+            for (unsigned int jj = 0; jj < _numParticles; jj++)
+                field.inducedDipoleField[jj] += fields[ii].inducedDipoleField[jj];
+            for (unsigned int jj = 0; jj < field.inducedDipoleFieldGradient.size(); jj++)
+                for (int kk = 0; kk < 6; kk++)
+                    field.inducedDipoleFieldGradient[jj][kk] += fields[ii].inducedDipoleFieldGradient[jj][kk];
+        }
 }
 
 void AmoebaReferenceMultipoleForce::convergeInduceDipolesByExtrapolation(const vector<MultipoleParticleData>& particleData, vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleField) {
@@ -1040,6 +1121,88 @@ void AmoebaReferenceMultipoleForce::convergeInduceDipolesByDIIS(const vector<Mul
 
 }
 
+void AmoebaReferenceMultipoleForce::convergeInduceDipolesByPCG(const vector<MultipoleParticleData>& particleData, vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleField) {
+    // We solve (1/alpha - T) mu = E for each set of dipoles, where T is the dipole field tensor.  The
+    // preconditioned residual alpha*(E + T mu) - mu is exactly the error used by DIIS, so the convergence
+    // criterion is the same.  Particles with zero polarizability are excluded from the inner products.
+
+    int numFields = updateInducedDipoleField.size();
+    vector<vector<Vec3> > residual(numFields, vector<Vec3>(_numParticles));
+    vector<vector<Vec3> > searchDirection(numFields, vector<Vec3>(_numParticles));
+    vector<double> residualDot(numFields, 0.0);
+    vector<UpdateInducedDipoleFieldStruct> searchField;
+    for (int k = 0; k < numFields; k++) {
+        UpdateInducedDipoleFieldStruct& field = updateInducedDipoleField[k];
+        searchField.push_back(UpdateInducedDipoleFieldStruct(*field.fixedMultipoleField, searchDirection[k], *field.extrapolatedDipoles, *field.extrapolatedDipoleFieldGradient));
+        searchField.back().inducedDipoleField.resize(_numParticles);
+    }
+    setMutualInducedDipoleConverged(false);
+    calculateInducedDipoleFields(particleData, updateInducedDipoleField);
+    for (int k = 0; k < numFields; k++) {
+        UpdateInducedDipoleFieldStruct& field = updateInducedDipoleField[k];
+        for (int i = 0; i < _numParticles; i++) {
+            residual[k][i] = (*field.fixedMultipoleField)[i] + field.inducedDipoleField[i]*particleData[i].polarity - (*field.inducedDipoles)[i];
+            searchDirection[k][i] = residual[k][i];
+            if (particleData[i].polarity != 0.0)
+                residualDot[k] += residual[k][i].dot(residual[k][i])/particleData[i].polarity;
+        }
+    }
+    for (int iteration = 0; ; iteration++) {
+        // Decide whether to stop or continue iterating.
+
+        double maxEpsilon = 0;
+        for (int k = 0; k < numFields; k++) {
+            double epsilon = 0;
+            for (int i = 0; i < _numParticles; i++)
+                epsilon += residual[k][i].dot(residual[k][i]);
+            if (epsilon > maxEpsilon)
+                maxEpsilon = epsilon;
+        }
+        maxEpsilon = _debye*sqrt(maxEpsilon/_numParticles);
+        if (maxEpsilon < getMutualInducedDipoleTargetEpsilon())
+            setMutualInducedDipoleConverged(true);
+        if (maxEpsilon < getMutualInducedDipoleTargetEpsilon() || iteration == getMaximumMutualInducedDipoleIterations()) {
+            setMutualInducedDipoleEpsilon(maxEpsilon);
+            setMutualInducedDipoleIterations(iteration);
+
+            // The last field evaluation was for the search direction.  Recompute it for the final
+            // dipoles, so that any reciprocal space potentials used for the forces match them.
+
+            if (iteration > 0)
+                calculateInducedDipoleFields(particleData, updateInducedDipoleField);
+            return;
+        }
+
+        // Compute the field from the search directions, and use it to update the dipoles and residuals.
+
+        calculateInducedDipoleFields(particleData, searchField);
+        for (int k = 0; k < numFields; k++) {
+            UpdateInducedDipoleFieldStruct& field = updateInducedDipoleField[k];
+            vector<Vec3>& p = searchDirection[k];
+            vector<Vec3>& tp = searchField[k].inducedDipoleField;
+            double pDotAp = 0.0;
+            for (int i = 0; i < _numParticles; i++)
+                if (particleData[i].polarity != 0.0)
+                    pDotAp += p[i].dot(p[i])/particleData[i].polarity - p[i].dot(tp[i]);
+            if (pDotAp == 0.0)
+                continue;
+            double stepSize = residualDot[k]/pDotAp;
+            double newResidualDot = 0.0;
+            for (int i = 0; i < _numParticles; i++) {
+                (*field.inducedDipoles)[i] += p[i]*stepSize;
+                field.inducedDipoleField[i] += tp[i]*stepSize;
+                residual[k][i] -= (p[i] - tp[i]*particleData[i].polarity)*stepSize;
+                if (particleData[i].polarity != 0.0)
+                    newResidualDot += residual[k][i].dot(residual[k][i])/particleData[i].polarity;
+            }
+            double beta = newResidualDot/residualDot[k];
+            residualDot[k] = newResidualDot;
+            for (int i = 0; i < _numParticles; i++)
+                p[i] = residual[k][i] + p[i]*beta;
+        }
+    }
+}
+
 void AmoebaReferenceMultipoleForce::computeDIISCoefficients(const vector<vector<Vec3> >& prevErrors, vector<double>& coefficients) const {
     int steps = coefficients.size();
     if (steps == 1) {
@@ -1111,8 +1274,12 @@ void AmoebaReferenceMultipoleForce::calculateInducedDipoles(const vector<Multipo
 
     // UpdateInducedDipoleFieldStruct contains induced dipole, fixed multipole fields and fields
     // due to other induced dipoles at each site
-    if (getPolarizationType() == AmoebaReferenceMultipoleForce::Mutual)
-        convergeInduceDipolesByDIIS(particleData, updateInducedDipoleField);
+    if (getPolarizationType() == AmoebaReferenceMultipoleForce::Mutual) {
+        if (getMutualInducedDipoleSolver() == AmoebaMultipoleForce::PCG)
+            convergeInduceDipolesByPCG(particleData, updateInducedDipoleField);
+        else
+            convergeInduceDipolesByDIIS(particleData, updateInducedDipoleField);
+    }
     else if (getPolarizationType() == AmoebaReferenceMultipoleForce::Extrapolated)
         convergeInduceDipolesByExtrapolation(particleData, updateInducedDipoleField);
 }
@@ -1761,28 +1928,35 @@ double AmoebaReferenceMultipoleForce::calculateElectrostatic(const vector<Multip
                                                              vector<Vec3>& torques,
                                                              vector<Vec3>& forces)
 {
-    double energy = 0.0;
-    vector<double> scaleFactors(LAST_SCALE_TYPE_INDEX);
-    for (auto& s : scaleFactors)
-        s = 1.0;
-
-    // main loop over particle pairs
-
-    for (unsigned int ii = 0; ii < particleData.size(); ii++) {
-        for (unsigned int jj = ii+1; jj < particleData.size(); jj++) {
-
-            if (jj <= _maxScaleIndex[ii]) {
-                getMultipoleScaleFactors(ii, jj, scaleFactors);
-            }
+    // main loop over particle pairs; the first thread accumulates directly into the outputs
+
+    int numThreads = getNumThreads();
+    vector<double> threadEnergy(numThreads, 0.0);
+    vector<vector<Vec3> > threadForces(numThreads-1, vector<Vec3>(_numParticles));
+    vector<vector<Vec3> > threadTorques(numThreads-1, vector<Vec3>(_numParticles));
+    vector<vector<double> > threadScaleFactors(numThreads, vector<double>(LAST_SCALE_TYPE_INDEX, 1.0));
+    forEachPair(false, [&] (int threadIndex, int ii, int jj) {
+        vector<double>& scaleFactors = threadScaleFactors[threadIndex];
+        if (jj <= _maxScaleIndex[ii]) {
+            getMultipoleScaleFactors(ii, jj, scaleFactors);
+        }
 
-            energy += calculateElectrostaticPairIxn(particleData[ii], particleData[jj], scaleFactors, forces, torques);
+        threadEnergy[threadIndex] += calculateElectrostaticPairIxn(particleData[ii], particleData[jj], scaleFactors,
+                threadIndex == 0 ? forces : threadForces[threadIndex-1], threadIndex == 0 ? torques : threadTorques[threadIndex-1]);
 
-            if (jj <= _maxScaleIndex[ii]) {
-                for (unsigned int kk = 0; kk < LAST_SCALE_TYPE_INDEX; kk++) {
-                    scaleFactors[kk] = 1.0;
-                }
+        if (jj <= _maxScaleIndex[ii]) {
+            for (unsigned int kk = 0; kk < LAST_SCALE_TYPE_INDEX; kk++) {
+                scaleFactors[kk] = 1.0;
             }
         }
+    });
+    double energy = threadEnergy[0];
+    for (int ii = 1; ii < numThreads; ii++) {
+        energy += threadEnergy[ii];
+        for (unsigned int jj = 0; jj < _numParticles; jj++) {
+            forces[jj] += threadForces[ii-1][jj];
+            torques[jj] += threadTorques[ii-1][jj];
+        }
     }
     if (getPolarizationType() == AmoebaReferenceMultipoleForce::Extrapolated) {
         double prefac = (_electric/_dielectric);
@@ -2181,6 +2355,8 @@ AmoebaReferenceGeneralizedKirkwoodMultipoleForce::AmoebaReferenceGeneralizedKirk
     _tanhRescaling = _amoebaReferenceGeneralizedKirkwoodForce->getTanhRescaling();
     _amoebaReferenceGeneralizedKirkwoodForce->getTanhParameters(_beta0, _beta1, _beta2);
     _descreenOffset = _amoebaReferenceGeneralizedKirkwoodForce->getDescreenOffset();
+    _useCutoff = _amoebaReferenceGeneralizedKirkwoodForce->getUseCutoff();
+    _cutoffDistance = _amoebaReferenceGeneralizedKirkwoodForce->getCutoffDistance();
 }
 
 AmoebaReferenceGeneralizedKirkwoodMultipoleForce::~AmoebaReferenceGeneralizedKirkwoodMultipoleForce()
@@ -2214,6 +2390,34 @@ double AmoebaReferenceGeneralizedKirkwoodMultipoleForce::getDescreenOffset() con
 };
 
 
+double AmoebaReferenceGeneralizedKirkwoodMultipoleForce::getCutoffTaper(const MultipoleParticleData& particleI,
+                                                                        const MultipoleParticleData& particleJ, double& dtaper) const
+{
+    dtaper = 0.0;
+    if (!_useCutoff)
+        return 1.0;
+    Vec3 deltaR = particleJ.position - particleI.position;
+    return AmoebaReferenceGeneralizedKirkwoodForce::calculateTaper(sqrt(deltaR.dot(deltaR)), _cutoffDistance, dtaper);
+}
+
+void AmoebaReferenceGeneralizedKirkwoodMultipoleForce::forEachKirkwoodPair(bool includeSelf, const std::function<void (int, int, int)>& pairFunction) const
+{
+    if (!_useCutoff) {
+        forEachPair(includeSelf, pairFunction);
+        return;
+    }
+    int numThreads = getNumThreads();
+    int numParticles = _numParticles;
+    int numPairs = _neighborList.size();
+    executeOnThreads([&] (int threadIndex) {
+        if (includeSelf)
+            for (int ii = threadIndex; ii < numParticles; ii += numThreads)
+                pairFunction(threadIndex, ii, ii);
+        for (int ii = threadIndex; ii < numPairs; ii += numThreads)
+            pairFunction(threadIndex, _neighborList[ii].first, _neighborList[ii].second);
+    });
+}
+
 void AmoebaReferenceGeneralizedKirkwoodMultipoleForce::zeroFixedMultipoleFields()
 {
     this->AmoebaReferenceMultipoleForce::zeroFixedMultipoleFields();
@@ -2226,6 +2430,10 @@ void AmoebaReferenceGeneralizedKirkwoodMultipoleForce::calculateFixedMultipoleFi
 {
 
     this->AmoebaReferenceMultipoleForce::calculateFixedMultipoleFieldPairIxn(particleI, particleJ, dScale, pScale);
+    double dtaper;
+    double taper = getCutoffTaper(particleI, particleJ, dtaper);
+    if (taper == 0.0)
+        return;
 
     // get deltaR, R2, and R between 2 atoms
 
@@ -2446,9 +2654,9 @@ void AmoebaReferenceGeneralizedKirkwoodMultipoleForce::calculateFixedMultipoleFi
                                    + 2.0*(qxyi*gqxy[4]+qxzi*gqxz[4]
                                    + qyzi*gqyz[4]));
 
-    _gkField[particleI.particleIndex] += fid;
+    _gkField[particleI.particleIndex] += fid*taper;
     if (particleI.particleIndex != particleJ.particleIndex) {
-        _gkField[particleJ.particleIndex] += fjd;
+        _gkField[particleJ.particleIndex] += fjd*taper;
     }
 }
 
@@ -2457,6 +2665,10 @@ void AmoebaReferenceGeneralizedKirkwoodMultipoleForce::calculateInducedDipolePai
                                                                                        const vector<OpenMM::Vec3>& inputFields,
                                                                                        vector<OpenMM::Vec3>& outputFields) const
 {
+    double dtaper;
+    double taper = getCutoffTaper(particleI, particleJ, dtaper);
+    if (taper == 0.0)
+        return;
 
     double a[3][3];
 
@@ -2512,16 +2724,17 @@ void AmoebaReferenceGeneralizedKirkwoodMultipoleForce::calculateInducedDipolePai
     guz[1]                       = guy[2];
     guz[2]                       = (a[1][0] + zr2*a[1][1]);
 
-    outputFields[iIndex][0]     += _fd*duks.dot(gux);
-    outputFields[iIndex][1]     += _fd*duks.dot(guy);
-    outputFields[iIndex][2]     += _fd*duks.dot(guz);
+    double fd                = _fd*taper;
+    outputFields[iIndex][0]     += fd*duks.dot(gux);
+    outputFields[iIndex][1]     += fd*duks.dot(guy);
+    outputFields[iIndex][2]     += fd*duks.dot(guz);
 
     // skip i == j, i.e., do not include contribution twice
 
     if (iIndex !=jIndex) {
-        outputFields[jIndex][0] += _fd*duis.dot(gux);
-        outputFields[jIndex][1] += _fd*duis.dot(guy);
-        outputFields[jIndex][2] += _fd*duis.dot(guz);
+        outputFields[jIndex][0] += fd*duis.dot(gux);
+        outputFields[jIndex][1] += fd*duis.dot(guy);
+        outputFields[jIndex][2] += fd*duis.dot(guz);
     }
 }
 
@@ -2571,6 +2784,11 @@ void AmoebaReferenceGeneralizedKirkwoodMultipoleForce::calculateInducedDipoles(c
          gkFieldPolar[ii]              = _inducedDipolePolarS[ii];
     }
 
+    if (getPolarizationType() == AmoebaReferenceMultipoleForce::Mutual && _initialInducedDipole.size() == _numParticles) {
+        _inducedDipole      = _initialInducedDipole;
+        _inducedDipolePolar = _initialInducedDipolePolar;
+    }
+
     if (getPolarizationType() == AmoebaReferenceMultipoleForce::Direct) {
         setMutualInducedDipoleConverged(true);
         return;
@@ -2622,7 +2840,6 @@ double AmoebaReferenceGeneralizedKirkwoodMultipoleForce::calculateKirkwoodPairIx
     double dsumdr,desymdr;
     double dewidr,dewkdr;
     double dsymdr;
-    double esymi,ewii,ewki;
     double dpwidx,dpwkdx;
     double dpsymdy,dpwidy,dpwkdy;
     double dpsymdz,dpwidz,dpwkdz;
@@ -2644,6 +2861,10 @@ double AmoebaReferenceGeneralizedKirkwoodMultipoleForce::calculateKirkwoodPairIx
 
     // decide whether to compute the current interaction
 
+    double dtaper;
+    double taper = getCutoffTaper(particleI, particleJ, dtaper);
+    if (taper == 0.0)
+        return 0.0;
     Vec3 deltaR = particleJ.position - particleI.position;
     double r = sqrt(deltaR.dot(deltaR));
 
@@ -3633,44 +3854,48 @@ double AmoebaReferenceGeneralizedKirkwoodMultipoleForce::calculateKirkwoodPairIx
     }
 
     // electrostatic solvation energy of the permanent multipoles in
-    // the GK reaction potential of the induced dipoles
-
-    esymi =              -particleI.dipole[0]*(_inducedDipoleS[jIndex][0]*gux2+_inducedDipoleS[jIndex][1]*guy2+_inducedDipoleS[jIndex][2]*guz2)
-                        - particleI.dipole[1]*(_inducedDipoleS[jIndex][0]*gux3+_inducedDipoleS[jIndex][1]*guy3+_inducedDipoleS[jIndex][2]*guz3)
-                        - particleI.dipole[2]*(_inducedDipoleS[jIndex][0]*gux4+_inducedDipoleS[jIndex][1]*guy4+_inducedDipoleS[jIndex][2]*guz4)
-                        - particleJ.dipole[0]*(_inducedDipoleS[iIndex][0]*gux2+_inducedDipoleS[iIndex][1]*guy2+_inducedDipoleS[iIndex][2]*guz2)
-                        - particleJ.dipole[1]*(_inducedDipoleS[iIndex][0]*gux3+_inducedDipoleS[iIndex][1]*guy3+_inducedDipoleS[iIndex][2]*guz3)
-                        - particleJ.dipole[2]*(_inducedDipoleS[iIndex][0]*gux4+_inducedDipoleS[iIndex][1]*guy4+_inducedDipoleS[iIndex][2]*guz4);
-
-    ewii = particleI.charge*(_inducedDipoleS[jIndex][0]*gc2+_inducedDipoleS[jIndex][1]*gc3+_inducedDipoleS[jIndex][2]*gc4)
-                      - particleJ.charge*(_inducedDipoleS[iIndex][0]*gux1+_inducedDipoleS[iIndex][1]*guy1+_inducedDipoleS[iIndex][2]*guz1)
-                      - _inducedDipoleS[iIndex][0]*(particleJ.quadrupole[QXX]*gux5+particleJ.quadrupole[QYY]*gux8+particleJ.quadrupole[QZZ]*gux10
-                     +2.0*(particleJ.quadrupole[QXY]*gux6+particleJ.quadrupole[QXZ]*gux7+particleJ.quadrupole[QYZ]*gux9))
-                      - _inducedDipoleS[iIndex][1]*(particleJ.quadrupole[QXX]*guy5+particleJ.quadrupole[QYY]*guy8+particleJ.quadrupole[QZZ]*guy10
-                     +2.0*(particleJ.quadrupole[QXY]*guy6+particleJ.quadrupole[QXZ]*guy7+particleJ.quadrupole[QYZ]*guy9))
-                      - _inducedDipoleS[iIndex][2]*(particleJ.quadrupole[QXX]*guz5+particleJ.quadrupole[QYY]*guz8+particleJ.quadrupole[QZZ]*guz10
-                     +2.0*(particleJ.quadrupole[QXY]*guz6+particleJ.quadrupole[QXZ]*guz7+particleJ.quadrupole[QYZ]*guz9))
-                      + _inducedDipoleS[jIndex][0]*(particleI.quadrupole[QXX]*gqxx2+particleI.quadrupole[QYY]*gqyy2+particleI.quadrupole[QZZ]*gqzz2
-                     +2.0*(particleI.quadrupole[QXY]*gqxy2+particleI.quadrupole[QXZ]*gqxz2+particleI.quadrupole[QYZ]*gqyz2))
-                      + _inducedDipoleS[jIndex][1]*(particleI.quadrupole[QXX]*gqxx3+particleI.quadrupole[QYY]*gqyy3+particleI.quadrupole[QZZ]*gqzz3
-                     +2.0*(particleI.quadrupole[QXY]*gqxy3+particleI.quadrupole[QXZ]*gqxz3+particleI.quadrupole[QYZ]*gqyz3))
-                      + _inducedDipoleS[jIndex][2]*(particleI.quadrupole[QXX]*gqxx4+particleI.quadrupole[QYY]*gqyy4+particleI.quadrupole[QZZ]*gqzz4
-                     +2.0*(particleI.quadrupole[QXY]*gqxy4+particleI.quadrupole[QXZ]*gqxz4+particleI.quadrupole[QYZ]*gqyz4));
-
-    ewki = particleI.charge*(_inducedDipoleS[jIndex][0]*gux1+_inducedDipoleS[jIndex][1]*guy1+_inducedDipoleS[jIndex][2]*guz1)
-                      - particleJ.charge*(_inducedDipoleS[iIndex][0]*gc2+_inducedDipoleS[iIndex][1]*gc3+_inducedDipoleS[iIndex][2]*gc4)
-                      - _inducedDipoleS[iIndex][0]*(particleJ.quadrupole[QXX]*gqxx2+particleJ.quadrupole[QYY]*gqyy2+particleJ.quadrupole[QZZ]*gqzz2
-                     +2.0*(particleJ.quadrupole[QXY]*gqxy2+particleJ.quadrupole[QXZ]*gqxz2+particleJ.quadrupole[QYZ]*gqyz2))
-                      - _inducedDipoleS[iIndex][1]*(particleJ.quadrupole[QXX]*gqxx3+particleJ.quadrupole[QYY]*gqyy3+particleJ.quadrupole[QZZ]*gqzz3
-                     +2.0*(particleJ.quadrupole[QXY]*gqxy3+particleJ.quadrupole[QXZ]*gqxz3+particleJ.quadrupole[QYZ]*gqyz3))
-                      - _inducedDipoleS[iIndex][2]*(particleJ.quadrupole[QXX]*gqxx4+particleJ.quadrupole[QYY]*gqyy4+particleJ.quadrupole[QZZ]*gqzz4
-                     +2.0*(particleJ.quadrupole[QXY]*gqxy4+particleJ.quadrupole[QXZ]*gqxz4+particleJ.quadrupole[QYZ]*gqyz4))
-                      + _inducedDipoleS[jIndex][0]*(particleI.quadrupole[QXX]*gux5+particleI.quadrupole[QYY]*gux8+particleI.quadrupole[QZZ]*gux10
-                     +2.0*(particleI.quadrupole[QXY]*gux6+particleI.quadrupole[QXZ]*gux7+particleI.quadrupole[QYZ]*gux9))
-                      + _inducedDipoleS[jIndex][1]*(particleI.quadrupole[QXX]*guy5+particleI.quadrupole[QYY]*guy8+particleI.quadrupole[QZZ]*guy10
-                     +2.0*(particleI.quadrupole[QXY]*guy6+particleI.quadrupole[QXZ]*guy7+particleI.quadrupole[QYZ]*guy9))
-                      + _inducedDipoleS[jIndex][2]*(particleI.quadrupole[QXX]*guz5+particleI.quadrupole[QYY]*guz8+particleI.quadrupole[QZZ]*guz10
-                     +2.0*(particleI.quadrupole[QXY]*guz6+particleI.quadrupole[QXZ]*guz7+particleI.quadrupole[QYZ]*guz9));
+    // the GK reaction potential of a set of induced dipoles
+
+    auto permanentInducedEnergy = [&] (const Vec3& ui, const Vec3& uk) {
+        double esymi, ewii, ewki;
+        esymi =              -particleI.dipole[0]*(uk[0]*gux2+uk[1]*guy2+uk[2]*guz2)
+                            - particleI.dipole[1]*(uk[0]*gux3+uk[1]*guy3+uk[2]*guz3)
+                            - particleI.dipole[2]*(uk[0]*gux4+uk[1]*guy4+uk[2]*guz4)
+                            - particleJ.dipole[0]*(ui[0]*gux2+ui[1]*guy2+ui[2]*guz2)
+                            - particleJ.dipole[1]*(ui[0]*gux3+ui[1]*guy3+ui[2]*guz3)
+                            - particleJ.dipole[2]*(ui[0]*gux4+ui[1]*guy4+ui[2]*guz4);
+
+        ewii = particleI.charge*(uk[0]*gc2+uk[1]*gc3+uk[2]*gc4)
+                          - particleJ.charge*(ui[0]*gux1+ui[1]*guy1+ui[2]*guz1)
+                          - ui[0]*(particleJ.quadrupole[QXX]*gux5+particleJ.quadrupole[QYY]*gux8+particleJ.quadrupole[QZZ]*gux10
+                         +2.0*(particleJ.quadrupole[QXY]*gux6+particleJ.quadrupole[QXZ]*gux7+particleJ.quadrupole[QYZ]*gux9))
+                          - ui[1]*(particleJ.quadrupole[QXX]*guy5+particleJ.quadrupole[QYY]*guy8+particleJ.quadrupole[QZZ]*guy10
+                         +2.0*(particleJ.quadrupole[QXY]*guy6+particleJ.quadrupole[QXZ]*guy7+particleJ.quadrupole[QYZ]*guy9))
+                          - ui[2]*(particleJ.quadrupole[QXX]*guz5+particleJ.quadrupole[QYY]*guz8+particleJ.quadrupole[QZZ]*guz10
+                         +2.0*(particleJ.quadrupole[QXY]*guz6+particleJ.quadrupole[QXZ]*guz7+particleJ.quadrupole[QYZ]*guz9))
+                          + uk[0]*(particleI.quadrupole[QXX]*gqxx2+particleI.quadrupole[QYY]*gqyy2+particleI.quadrupole[QZZ]*gqzz2
+                         +2.0*(particleI.quadrupole[QXY]*gqxy2+particleI.quadrupole[QXZ]*gqxz2+particleI.quadrupole[QYZ]*gqyz2))
+                          + uk[1]*(particleI.quadrupole[QXX]*gqxx3+particleI.quadrupole[QYY]*gqyy3+particleI.quadrupole[QZZ]*gqzz3
+                         +2.0*(particleI.quadrupole[QXY]*gqxy3+particleI.quadrupole[QXZ]*gqxz3+particleI.quadrupole[QYZ]*gqyz3))
+                          + uk[2]*(particleI.quadrupole[QXX]*gqxx4+particleI.quadrupole[QYY]*gqyy4+particleI.quadrupole[QZZ]*gqzz4
+                         +2.0*(particleI.quadrupole[QXY]*gqxy4+particleI.quadrupole[QXZ]*gqxz4+particleI.quadrupole[QYZ]*gqyz4));
+
+        ewki = particleI.charge*(uk[0]*gux1+uk[1]*guy1+uk[2]*guz1)
+                          - particleJ.charge*(ui[0]*gc2+ui[1]*gc3+ui[2]*gc4)
+                          - ui[0]*(particleJ.quadrupole[QXX]*gqxx2+particleJ.quadrupole[QYY]*gqyy2+particleJ.quadrupole[QZZ]*gqzz2
+                         +2.0*(particleJ.quadrupole[QXY]*gqxy2+particleJ.quadrupole[QXZ]*gqxz2+particleJ.quadrupole[QYZ]*gqyz2))
+                          - ui[1]*(particleJ.quadrupole[QXX]*gqxx3+particleJ.quadrupole[QYY]*gqyy3+particleJ.quadrupole[QZZ]*gqzz3
+                         +2.0*(particleJ.quadrupole[QXY]*gqxy3+particleJ.quadrupole[QXZ]*gqxz3+particleJ.quadrupole[QYZ]*gqyz3))
+                          - ui[2]*(particleJ.quadrupole[QXX]*gqxx4+particleJ.quadrupole[QYY]*gqyy4+particleJ.quadrupole[QZZ]*gqzz4
+                         +2.0*(particleJ.quadrupole[QXY]*gqxy4+particleJ.quadrupole[QXZ]*gqxz4+particleJ.quadrupole[QYZ]*gqyz4))
+                          + uk[0]*(particleI.quadrupole[QXX]*gux5+particleI.quadrupole[QYY]*gux8+particleI.quadrupole[QZZ]*gux10
+                         +2.0*(particleI.quadrupole[QXY]*gux6+particleI.quadrupole[QXZ]*gux7+particleI.quadrupole[QYZ]*gux9))
+                          + uk[1]*(particleI.quadrupole[QXX]*guy5+particleI.quadrupole[QYY]*guy8+particleI.quadrupole[QZZ]*guy10
+                         +2.0*(particleI.quadrupole[QXY]*guy6+particleI.quadrupole[QXZ]*guy7+particleI.quadrupole[QYZ]*guy9))
+                          + uk[2]*(particleI.quadrupole[QXX]*guz5+particleI.quadrupole[QYY]*guz8+particleI.quadrupole[QZZ]*guz10
+                         +2.0*(particleI.quadrupole[QXY]*guz6+particleI.quadrupole[QXZ]*guz7+particleI.quadrupole[QYZ]*guz9));
+        return esymi + 0.5*(ewii+ewki);
+    };
 
     // electrostatic solvation free energy gradient of the permanent
     // multipoles in the reaction potential of the induced dipoles
@@ -3970,10 +4195,50 @@ double AmoebaReferenceGeneralizedKirkwoodMultipoleForce::calculateKirkwoodPairIx
     // total permanent and induced energies for this interaction
 
     e                        = esym + 0.5*(ewi+ewk);
-    ei                       = 0.5*(esymi + 0.5*(ewii+ewki));
+    ei                       = 0.5*permanentInducedEnergy(_inducedDipoleS[iIndex], _inducedDipoleS[jIndex]);
     double energy            = e + ei;
     energy                   = iIndex == jIndex ? 0.5*energy : energy;
 
+    // scale everything by the taper, and add the force from the derivative of the taper
+
+    if (taper != 1.0) {
+        dedx *= taper; dedy *= taper; dedz *= taper;
+        dpdx *= taper; dpdy *= taper; dpdz *= taper;
+        trq1 *= taper; trq2 *= taper; trq3 *= taper;
+        trqi1 *= taper; trqi2 *= taper; trqi3 *= taper;
+        trq_k1 *= taper; trq_k2 *= taper; trq_k3 *= taper;
+        trqi_k1 *= taper; trqi_k2 *= taper; trqi_k3 *= taper;
+        drbi *= taper; dpbi *= taper;
+        drbk *= taper; dpbk *= taper;
+        energy *= taper;
+    }
+    if (dtaper != 0.0) {
+
+        // The tapered quantity is the pair's contribution to the polarization energy functional:  the
+        // permanent term, the permanent-induced term for both sets of dipoles, and for mutual polarization
+        // the induced-induced term.
+
+        Vec3 si(sxi, syi, szi), sk(sxk, syk, szk);
+        double pairEnergy = e + 0.5*permanentInducedEnergy(si, sk);
+        if (getPolarizationType() != AmoebaReferenceMultipoleForce::Direct) {
+            Vec3 udi = _inducedDipoleS[iIndex], upi = _inducedDipolePolarS[iIndex];
+            Vec3 udk = _inducedDipoleS[jIndex], upk = _inducedDipolePolarS[jIndex];
+            double gfInduced2 = 1.0/(r2+rb2*expterm);
+            double gfInduced = sqrt(gfInduced2);
+            double gfInduced3 = gfInduced2*gfInduced;
+            double tensorDiagonal = -gfInduced3;
+            double tensorOffDiagonal = 3.0*(1.0-expc)*gfInduced3*gfInduced2;
+            auto dipoleDipole = [&] (const Vec3& u1, const Vec3& u2) {
+                return tensorDiagonal*u1.dot(u2) + tensorOffDiagonal*u1.dot(deltaR)*u2.dot(deltaR);
+            };
+            pairEnergy -= 0.5*fd*(dipoleDipole(udi, upk) + dipoleDipole(udk, upi));
+        }
+        double dedr = pairEnergy*dtaper/r;
+        dedx += dedr*xr;
+        dedy += dedr*yr;
+        dedz += dedr*zr;
+    }
+
     forces[iIndex][0]       += (dedx + dpdx);
     forces[iIndex][1]       += (dedy + dpdy);
     forces[iIndex][2]       += (dedz + dpdz);
@@ -4009,12 +4274,37 @@ double AmoebaReferenceGeneralizedKirkwoodMultipoleForce::calculateElectrostatic(
     vector<double> dBorn;
     initializeRealOpenMMVector(dBorn);
 
-    // Kirkwood loop over particle pairs
+    // with a cutoff, only the pairs in the neighbor list have generalized Kirkwood interactions
 
-    for (unsigned int ii = 0; ii < particleData.size(); ii++) {
-        for (unsigned int jj = ii; jj < particleData.size(); jj++) {
-            energy += calculateKirkwoodPairIxn(particleData[ii], particleData[jj], forces, torques, dBorn);
-        }
+    if (_useCutoff) {
+        vector<Vec3> positions(_numParticles);
+        for (unsigned int ii = 0; ii < _numParticles; ii++)
+            positions[ii] = particleData[ii].position;
+        computeNeighborListVoxelHash(_neighborList, _numParticles, positions, ExclusionList(_numParticles), NULL, false, _cutoffDistance, 0.0);
+    }
+
+    // Kirkwood loop over particle pairs; the first thread accumulates directly into the outputs
+
+    int numThreads = getNumThreads();
+    vector<double> threadEnergy(numThreads, 0.0);
+    vector<vector<Vec3> > threadForces(numThreads-1, vector<Vec3>(_numParticles));
+    vector<vector<Vec3> > threadTorques(numThreads-1, vector<Vec3>(_numParticles));
+    vector<vector<double> > threadBorn(numThreads-1, vector<double>(_numParticles, 0.0));
+    forEachKirkwoodPair(true, [&] (int threadIndex, int ii, int jj) {
+        if (threadIndex == 0)
+            threadEnergy[0] += calculateKirkwoodPairIxn(particleData[ii], particleData[jj], forces, torques, dBorn);
+        else
+            threadEnergy[threadIndex] += calculateKirkwoodPairIxn(particleData[ii], particleData[jj], threadForces[threadIndex-1],
+                    threadTorques[threadIndex-1], threadBorn[threadIndex-1]);
+    });
+    for (int ii = 0; ii < numThreads; ii++) {
+        energy += threadEnergy[ii];
+        if (ii > 0)
+            for (unsigned int jj = 0; jj < _numParticles; jj++) {
+                forces[jj] += threadForces[ii-1][jj];
+                torques[jj] += threadTorques[ii-1][jj];
+                dBorn[jj] += threadBorn[ii-1][jj];
+            }
     }
 
     // cavity term
@@ -4025,34 +4315,40 @@ double AmoebaReferenceGeneralizedKirkwoodMultipoleForce::calculateElectrostatic(
 
     // apply Born chain rule; skip diagonal terms since these make no contribution to forces
 
-    for (unsigned int ii = 0; ii < particleData.size(); ii++) {
-        for (unsigned int jj = ii+1; jj < particleData.size(); jj++) {
-            calculateGrycukChainRulePairIxn(particleData[ii], particleData[jj], dBorn, forces);
-            calculateGrycukChainRulePairIxn(particleData[jj], particleData[ii], dBorn, forces);
-        }
-    }
+    for (auto& f : threadForces)
+        std::fill(f.begin(), f.end(), Vec3());
+    forEachKirkwoodPair(false, [&] (int threadIndex, int ii, int jj) {
+        vector<Vec3>& threadForce = (threadIndex == 0 ? forces : threadForces[threadIndex-1]);
+        calculateGrycukChainRulePairIxn(particleData[ii], particleData[jj], dBorn, threadForce);
+        calculateGrycukChainRulePairIxn(particleData[jj], particleData[ii], dBorn, threadForce);
+    });
 
     // correct vacuum to SCRF derivatives (ediff1 in TINKER)
 
-    vector<double> scaleFactors(LAST_SCALE_TYPE_INDEX);
-    for (auto& s : scaleFactors)
-        s = 1.0;
-
-    double eDiffEnergy = 0.0;
-    for (unsigned int ii = 0; ii < particleData.size(); ii++) {
-        for (unsigned int jj = ii+1; jj < particleData.size(); jj++) {
-
-            if (jj <= _maxScaleIndex[ii]) {
-                getMultipoleScaleFactors(ii, jj, scaleFactors);
-            }
+    for (auto& f : threadTorques)
+        std::fill(f.begin(), f.end(), Vec3());
+    std::fill(threadEnergy.begin(), threadEnergy.end(), 0.0);
+    vector<vector<double> > threadScaleFactors(numThreads, vector<double>(LAST_SCALE_TYPE_INDEX, 1.0));
+    forEachPair(false, [&] (int threadIndex, int ii, int jj) {
+        vector<double>& scaleFactors = threadScaleFactors[threadIndex];
+        if (jj <= _maxScaleIndex[ii]) {
+            getMultipoleScaleFactors(ii, jj, scaleFactors);
+        }
 
-            eDiffEnergy += calculateKirkwoodEDiffPairIxn(particleData[ii], particleData[jj],
-                                                         scaleFactors[P_SCALE], scaleFactors[D_SCALE], forces, torques);
+        threadEnergy[threadIndex] += calculateKirkwoodEDiffPairIxn(particleData[ii], particleData[jj], scaleFactors[P_SCALE], scaleFactors[D_SCALE],
+                threadIndex == 0 ? forces : threadForces[threadIndex-1], threadIndex == 0 ? torques : threadTorques[threadIndex-1]);
 
-            if (jj <= _maxScaleIndex[ii]) {
-                for (auto& s : scaleFactors)
-                    s = 1.0;
-            }
+        if (jj <= _maxScaleIndex[ii]) {
+            for (auto& s : scaleFactors)
+                s = 1.0;
+        }
+    });
+    double eDiffEnergy = threadEnergy[0];
+    for (int ii = 1; ii < numThreads; ii++) {
+        eDiffEnergy += threadEnergy[ii];
+        for (unsigned int jj = 0; jj < _numParticles; jj++) {
+            forces[jj] += threadForces[ii-1][jj];
+            torques[jj] += threadTorques[ii-1][jj];
         }
     }
     energy += (_electric/_dielectric)*eDiffEnergy;
@@ -4170,6 +4466,9 @@ void AmoebaReferenceGeneralizedKirkwoodMultipoleForce::calculateGrycukChainRuleP
         term = term * tanh_constant * chainRuleTerm * (1.0 - tanh2);
     }
 
+    double dtaper;
+    double taper = getCutoffTaper(particleI, particleJ, dtaper);
+    if (taper == 0.0) return;
     Vec3 deltaR = particleJ.position - particleI.position;
     double sk = _scaleFactors[jIndex] * _descreenRadii[jIndex];
     if (sk <= 0.0) return;
@@ -4219,6 +4518,11 @@ void AmoebaReferenceGeneralizedKirkwoodMultipoleForce::calculateGrycukChainRuleP
         de += neckDescreenDerivative(r, baseRadiusI, _descreenRadii[jIndex], mixedNeckScale);
     }
 
+    // the descreening integral is tapered near the cutoff
+
+    if (taper != 1.0)
+        de = de*taper + dtaper*AmoebaReferenceGeneralizedKirkwoodForce::calculateDescreeningIntegral(r, baseRadiusI, sk, _descreenRadii[jIndex], mixedNeckScale);
+
     double dbr = term * de / r;
     de = dbr * dBorn[iIndex];
 
@@ -5185,6 +5489,14 @@ void AmoebaReferencePmeMultipoleForce::calculateFixedMultipoleFieldPairIxn(const
                                                                            const MultipoleParticleData& particleJ,
                                                                            double dscale, double pscale)
 {
+    calculateFixedMultipoleFieldPairIxn(particleI, particleJ, dscale, pscale, _fixedMultipoleField, _fixedMultipoleFieldPolar);
+}
+
+void AmoebaReferencePmeMultipoleForce::calculateFixedMultipoleFieldPairIxn(const MultipoleParticleData& particleI,
+                                                                           const MultipoleParticleData& particleJ,
+                                                                           double dscale, double pscale,
+                                                                           vector<Vec3>& field, vector<Vec3>& fieldPolar) const
+{
 
     unsigned int iIndex    = particleI.particleIndex;
     unsigned int jIndex    = particleJ.particleIndex;
@@ -5250,8 +5562,8 @@ void AmoebaReferencePmeMultipoleForce::calculateFixedMultipoleFieldPairIxn(const
         Vec3 fjd           = qi*(-2.0*drr5) - particleI.dipole*drr3 + deltaR*(drr3*particleI.charge + drr5*dir+drr7*qir);
         Vec3 fjp           = qi*(-2.0*prr5) - particleI.dipole*prr3 + deltaR*(prr3*particleI.charge + prr5*dir+prr7*qir);
         // increment the field due to this interaction
-        _fixedMultipoleField[jIndex]      += fjm - fjd;
-        _fixedMultipoleFieldPolar[jIndex] += fjm - fjp;
+        field[jIndex]      += fjm - fjd;
+        fieldPolar[jIndex] += fjm - fjp;
     }
 
     // Check particle I has a non-zero polarity and particle J has non-zero moments.
@@ -5270,8 +5582,8 @@ void AmoebaReferencePmeMultipoleForce::calculateFixedMultipoleFieldPairIxn(const
         Vec3 fid           = qj*(2.0*drr5) - particleJ.dipole*drr3 - deltaR*(drr3*particleJ.charge - drr5*djr+drr7*qjr);
         Vec3 fip           = qj*(2.0*prr5) - particleJ.dipole*prr3 - deltaR*(prr3*particleJ.charge - prr5*djr+prr7*qjr);
         // increment the field due to this interaction
-        _fixedMultipoleField[iIndex]      += fim - fid;
-        _fixedMultipoleFieldPolar[iIndex] += fim - fip;
+        field[iIndex]      += fim - fid;
+        fieldPolar[iIndex] += fim - fip;
     }
 }
 
@@ -5307,7 +5619,33 @@ void AmoebaReferencePmeMultipoleForce::calculateFixedMultipoleField(const vector
 
     // include direct space fixed multipole fields
 
-    this->AmoebaReferenceMultipoleForce::calculateFixedMultipoleField(particleData);
+    calculateDirectFixedMultipoleField(particleData);
+}
+
+void AmoebaReferencePmeMultipoleForce::calculateDirectFixedMultipoleField(const vector<MultipoleParticleData>& particleData)
+{
+    if (getNumThreads() == 1) {
+        this->AmoebaReferenceMultipoleForce::calculateFixedMultipoleField(particleData);
+        return;
+    }
+
+    // The reciprocal space and self contributions have already been stored, so each thread
+    // accumulates into its own buffers which are then added to them in thread order.
+
+    int numThreads = getNumThreads();
+    vector<vector<Vec3> > threadField(numThreads, vector<Vec3>(_numParticles));
+    vector<vector<Vec3> > threadFieldPolar(numThreads, vector<Vec3>(_numParticles));
+    forEachPair(false, [&] (int threadIndex, int ii, int jj) {
+        double dScale = 1.0, pScale = 1.0;
+        if (jj <= _maxScaleIndex[ii])
+            getDScaleAndPScale(ii, jj, dScale, pScale);
+        calculateFixedMultipoleFieldPairIxn(particleData[ii], particleData[jj], dScale, pScale, threadField[threadIndex], threadFieldPolar[threadIndex]);
+    });
+    for (int ii = 0; ii < numThreads; ii++)
+        for (unsigned int jj = 0; jj < _numParticles; jj++) {
+            _fixedMultipoleField[jj] += threadField[ii][jj];
+            _fixedMultipoleFieldPolar[jj] += threadFieldPolar[ii][jj];
+        }
 }
 
 #define ARRAY(x,y) array[(x)-1+((y)-1)*AMOEBA_PME_ORDER]
@@ -5496,44 +5834,56 @@ void AmoebaReferencePmeMultipoleForce::spreadFixedMultipolesOntoGrid(const vecto
 
     transformMultipolesToFractionalCoordinates(particleData);
 
-    // Clear the grid.
-
-    for (int gridIndex = 0; gridIndex < _totalGridSize; gridIndex++)
-        _pmeGrid[gridIndex] = complex<double>(0, 0);
-
-    // Loop over atoms and spread them on the grid.
-
-    for (int atomIndex = 0; atomIndex < _numParticles; atomIndex++) {
-        double atomCharge = _transformed[atomIndex].charge;
-        Vec3 atomDipole = Vec3(_transformed[atomIndex].dipole[0],
-                               _transformed[atomIndex].dipole[1],
-                               _transformed[atomIndex].dipole[2]);
-
-        double atomQuadrupoleXX = _transformed[atomIndex].quadrupole[QXX];
-        double atomQuadrupoleXY = _transformed[atomIndex].quadrupole[QXY];
-        double atomQuadrupoleXZ = _transformed[atomIndex].quadrupole[QXZ];
-        double atomQuadrupoleYY = _transformed[atomIndex].quadrupole[QYY];
-        double atomQuadrupoleYZ = _transformed[atomIndex].quadrupole[QYZ];
-        double atomQuadrupoleZZ = _transformed[atomIndex].quadrupole[QZZ];
-        IntVec& gridPoint = _iGrid[atomIndex];
-        for (int ix = 0; ix < AMOEBA_PME_ORDER; ix++) {
-            int x = (gridPoint[0]+ix) % _pmeGridDimensions[0];
-            double4 t = _thetai[0][atomIndex*AMOEBA_PME_ORDER+ix];
-            for (int iy = 0; iy < AMOEBA_PME_ORDER; iy++) {
-                int y = (gridPoint[1]+iy) % _pmeGridDimensions[1];
-                double4 u = _thetai[1][atomIndex*AMOEBA_PME_ORDER+iy];
-                double term0 = atomCharge*t[0]*u[0] + atomDipole[1]*t[0]*u[1] + atomQuadrupoleYY*t[0]*u[2] + atomDipole[0]*t[1]*u[0] + atomQuadrupoleXY*t[1]*u[1] + atomQuadrupoleXX*t[2]*u[0];
-                double term1 = atomDipole[2]*t[0]*u[0] + atomQuadrupoleYZ*t[0]*u[1] + atomQuadrupoleXZ*t[1]*u[0];
-                double term2 = atomQuadrupoleZZ*t[0]*u[0];
-                for (int iz = 0; iz < AMOEBA_PME_ORDER; iz++) {
-                    int z = (gridPoint[2]+iz) % _pmeGridDimensions[2];
-                    double4 v = _thetai[2][atomIndex*AMOEBA_PME_ORDER+iz];
-                    complex<double>& gridValue = _pmeGrid[x*_pmeGridDimensions[1]*_pmeGridDimensions[2]+y*_pmeGridDimensions[2]+z];
-                    gridValue += term0*v[0] + term1*v[1] + term2*v[2];
+    // Each thread clears and fills its own slab of x planes, looping over all atoms in the same
+    // order.  This gives identical results regardless of the number of threads.
+
+    int numThreads = getNumThreads();
+    int planeSize = _pmeGridDimensions[1]*_pmeGridDimensions[2];
+    executeOnThreads([&] (int threadIndex) {
+        int firstPlane = (threadIndex*_pmeGridDimensions[0])/numThreads;
+        int lastPlane = ((threadIndex+1)*_pmeGridDimensions[0])/numThreads;
+
+        // Clear the grid.
+
+        for (int gridIndex = firstPlane*planeSize; gridIndex < lastPlane*planeSize; gridIndex++)
+            _pmeGrid[gridIndex] = complex<double>(0, 0);
+
+        // Loop over atoms and spread them on the grid.
+
+        for (int atomIndex = 0; atomIndex < _numParticles; atomIndex++) {
+            double atomCharge = _transformed[atomIndex].charge;
+            Vec3 atomDipole = Vec3(_transformed[atomIndex].dipole[0],
+                                   _transformed[atomIndex].dipole[1],
+                                   _transformed[atomIndex].dipole[2]);
+
+            double atomQuadrupoleXX = _transformed[atomIndex].quadrupole[QXX];
+            double atomQuadrupoleXY = _transformed[atomIndex].quadrupole[QXY];
+            double atomQuadrupoleXZ = _transformed[atomIndex].quadrupole[QXZ];
+            double atomQuadrupoleYY = _transformed[atomIndex].quadrupole[QYY];
+            double atomQuadrupoleYZ = _transformed[atomIndex].quadrupole[QYZ];
+            double atomQuadrupoleZZ = _transformed[atomIndex].quadrupole[QZZ];
+            IntVec& gridPoint = _iGrid[atomIndex];
+            for (int ix = 0; ix < AMOEBA_PME_ORDER; ix++) {
+                int x = (gridPoint[0]+ix) % _pmeGridDimensions[0];
+                if (x < firstPlane || x >= lastPlane)
+                    continue;
+                double4 t = _thetai[0][atomIndex*AMOEBA_PME_ORDER+ix];
+                for (int iy = 0; iy < AMOEBA_PME_ORDER; iy++) {
+                    int y = (gridPoint[1]+iy) % _pmeGridDimensions[1];
+                    double4 u = _thetai[1][atomIndex*AMOEBA_PME_ORDER+iy];
+                    double term0 = atomCharge*t[0]*u[0] + atomDipole[1]*t[0]*u[1] + atomQuadrupoleYY*t[0]*u[2] + atomDipole[0]*t[1]*u[0] + atomQuadrupoleXY*t[1]*u[1] + atomQuadrupoleXX*t[2]*u[0];
+                    double term1 = atomDipole[2]*t[0]*u[0] + atomQuadrupoleYZ*t[0]*u[1] + atomQuadrupoleXZ*t[1]*u[0];
+                    double term2 = atomQuadrupoleZZ*t[0]*u[0];
+                    for (int iz = 0; iz < AMOEBA_PME_ORDER; iz++) {
+                        int z = (gridPoint[2]+iz) % _pmeGridDimensions[2];
+                        double4 v = _thetai[2][atomIndex*AMOEBA_PME_ORDER+iz];
+                        complex<double>& gridValue = _pmeGrid[x*_pmeGridDimensions[1]*_pmeGridDimensions[2]+y*_pmeGridDimensions[2]+z];
+                        gridValue += term0*v[0] + term1*v[1] + term2*v[2];
+                    }
                 }
             }
         }
-    }
+    });
 }
 
 void AmoebaReferencePmeMultipoleForce::performAmoebaReciprocalConvolution()
@@ -5691,40 +6041,52 @@ void AmoebaReferencePmeMultipoleForce::spreadInducedDipolesOnGrid(const vector<V
         for (int j = 0; j < 3; j++)
             cartToFrac[j][i] = _pmeGridDimensions[j]*_recipBoxVectors[i][j];
 
-    // Clear the grid.
-
-    for (int gridIndex = 0; gridIndex < _totalGridSize; gridIndex++)
-        _pmeGrid[gridIndex] = complex<double>(0, 0);
-
-    // Loop over atoms and spread them on the grid.
-
-    for (int atomIndex = 0; atomIndex < _numParticles; atomIndex++) {
-        Vec3 inducedDipole = Vec3(inputInducedDipole[atomIndex][0]*cartToFrac[0][0] + inputInducedDipole[atomIndex][1]*cartToFrac[0][1] + inputInducedDipole[atomIndex][2]*cartToFrac[0][2],
-                                  inputInducedDipole[atomIndex][0]*cartToFrac[1][0] + inputInducedDipole[atomIndex][1]*cartToFrac[1][1] + inputInducedDipole[atomIndex][2]*cartToFrac[1][2],
-                                  inputInducedDipole[atomIndex][0]*cartToFrac[2][0] + inputInducedDipole[atomIndex][1]*cartToFrac[2][1] + inputInducedDipole[atomIndex][2]*cartToFrac[2][2]);
-        Vec3 inducedDipolePolar = Vec3(inputInducedDipolePolar[atomIndex][0]*cartToFrac[0][0] + inputInducedDipolePolar[atomIndex][1]*cartToFrac[0][1] + inputInducedDipolePolar[atomIndex][2]*cartToFrac[0][2],
-                                       inputInducedDipolePolar[atomIndex][0]*cartToFrac[1][0] + inputInducedDipolePolar[atomIndex][1]*cartToFrac[1][1] + inputInducedDipolePolar[atomIndex][2]*cartToFrac[1][2],
-                                       inputInducedDipolePolar[atomIndex][0]*cartToFrac[2][0] + inputInducedDipolePolar[atomIndex][1]*cartToFrac[2][1] + inputInducedDipolePolar[atomIndex][2]*cartToFrac[2][2]);
-        IntVec& gridPoint = _iGrid[atomIndex];
-        for (int ix = 0; ix < AMOEBA_PME_ORDER; ix++) {
-            int x = (gridPoint[0]+ix) % _pmeGridDimensions[0];
-            double4 t = _thetai[0][atomIndex*AMOEBA_PME_ORDER+ix];
-            for (int iy = 0; iy < AMOEBA_PME_ORDER; iy++) {
-                int y = (gridPoint[1]+iy) % _pmeGridDimensions[1];
-                double4 u = _thetai[1][atomIndex*AMOEBA_PME_ORDER+iy];
-                double term01 = inducedDipole[1]*t[0]*u[1] + inducedDipole[0]*t[1]*u[0];
-                double term11 = inducedDipole[2]*t[0]*u[0];
-                double term02 = inducedDipolePolar[1]*t[0]*u[1] + inducedDipolePolar[0]*t[1]*u[0];
-                double term12 = inducedDipolePolar[2]*t[0]*u[0];
-                for (int iz = 0; iz < AMOEBA_PME_ORDER; iz++) {
-                    int z = (gridPoint[2]+iz) % _pmeGridDimensions[2];
-                    double4 v = _thetai[2][atomIndex*AMOEBA_PME_ORDER+iz];
-                    complex<double>& gridValue = _pmeGrid[x*_pmeGridDimensions[1]*_pmeGridDimensions[2]+y*_pmeGridDimensions[2]+z];
-                    gridValue += complex<double>(term01*v[0] + term11*v[1], term02*v[0] + term12*v[1]);
+    // Each thread clears and fills its own slab of x planes, looping over all atoms in the same
+    // order.  This gives identical results regardless of the number of threads.
+
+    int numThreads = getNumThreads();
+    int planeSize = _pmeGridDimensions[1]*_pmeGridDimensions[2];
+    executeOnThreads([&] (int threadIndex) {
+        int firstPlane = (threadIndex*_pmeGridDimensions[0])/numThreads;
+        int lastPlane = ((threadIndex+1)*_pmeGridDimensions[0])/numThreads;
+
+        // Clear the grid.
+
+        for (int gridIndex = firstPlane*planeSize; gridIndex < lastPlane*planeSize; gridIndex++)
+            _pmeGrid[gridIndex] = complex<double>(0, 0);
+
+        // Loop over atoms and spread them on the grid.
+
+        for (int atomIndex = 0; atomIndex < _numParticles; atomIndex++) {
+            Vec3 inducedDipole = Vec3(inputInducedDipole[atomIndex][0]*cartToFrac[0][0] + inputInducedDipole[atomIndex][1]*cartToFrac[0][1] + inputInducedDipole[atomIndex][2]*cartToFrac[0][2],
+                                      inputInducedDipole[atomIndex][0]*cartToFrac[1][0] + inputInducedDipole[atomIndex][1]*cartToFrac[1][1] + inputInducedDipole[atomIndex][2]*cartToFrac[1][2],
+                                      inputInducedDipole[atomIndex][0]*cartToFrac[2][0] + inputInducedDipole[atomIndex][1]*cartToFrac[2][1] + inputInducedDipole[atomIndex][2]*cartToFrac[2][2]);
+            Vec3 inducedDipolePolar = Vec3(inputInducedDipolePolar[atomIndex][0]*cartToFrac[0][0] + inputInducedDipolePolar[atomIndex][1]*cartToFrac[0][1] + inputInducedDipolePolar[atomIndex][2]*cartToFrac[0][2],
+                                           inputInducedDipolePolar[atomIndex][0]*cartToFrac[1][0] + inputInducedDipolePolar[atomIndex][1]*cartToFrac[1][1] + inputInducedDipolePolar[atomIndex][2]*cartToFrac[1][2],
+                                           inputInducedDipolePolar[atomIndex][0]*cartToFrac[2][0] + inputInducedDipolePolar[atomIndex][1]*cartToFrac[2][1] + inputInducedDipolePolar[atomIndex][2]*cartToFrac[2][2]);
+            IntVec& gridPoint = _iGrid[atomIndex];
+            for (int ix = 0; ix < AMOEBA_PME_ORDER; ix++) {
+                int x = (gridPoint[0]+ix) % _pmeGridDimensions[0];
+                if (x < firstPlane || x >= lastPlane)
+                    continue;
+                double4 t = _thetai[0][atomIndex*AMOEBA_PME_ORDER+ix];
+                for (int iy = 0; iy < AMOEBA_PME_ORDER; iy++) {
+                    int y = (gridPoint[1]+iy) % _pmeGridDimensions[1];
+                    double4 u = _thetai[1][atomIndex*AMOEBA_PME_ORDER+iy];
+                    double term01 = inducedDipole[1]*t[0]*u[1] + inducedDipole[0]*t[1]*u[0];
+                    double term11 = inducedDipole[2]*t[0]*u[0];
+                    double term02 = inducedDipolePolar[1]*t[0]*u[1] + inducedDipolePolar[0]*t[1]*u[0];
+                    double term12 = inducedDipolePolar[2]*t[0]*u[0];
+                    for (int iz = 0; iz < AMOEBA_PME_ORDER; iz++) {
+                        int z = (gridPoint[2]+iz) % _pmeGridDimensions[2];
+                        double4 v = _thetai[2][atomIndex*AMOEBA_PME_ORDER+iz];
+                        complex<double>& gridValue = _pmeGrid[x*_pmeGridDimensions[1]*_pmeGridDimensions[2]+y*_pmeGridDimensions[2]+z];
+                        gridValue += complex<double>(term01*v[0] + term11*v[1], term02*v[0] + term12*v[1]);
+                    }
                 }
             }
         }
-    }
+    });
 }
 
 void AmoebaReferencePmeMultipoleForce::computeInducedPotentialFromGrid()
@@ -6184,11 +6546,7 @@ void AmoebaReferencePmeMultipoleForce::calculateInducedDipoleFields(const vector
 
     // Add fields from direct space interactions.
 
-    for (unsigned int ii = 0; ii < particleData.size(); ii++) {
-        for (unsigned int jj = ii + 1; jj < particleData.size(); jj++) {
-            calculateDirectInducedDipolePairIxns(particleData[ii], particleData[jj], updateInducedDipoleFields);
-        }
-    }
+    calculateDirectInducedDipoleFields(particleData, updateInducedDipoleFields);
 
     // reciprocal space ixns
 
@@ -6268,6 +6626,34 @@ void AmoebaReferencePmeMultipoleForce::calculateInducedDipoleFields(const vector
     }
 }
 
+void AmoebaReferencePmeMultipoleForce::calculateDirectInducedDipoleFields(const vector<MultipoleParticleData>& particleData,
+                                                                           vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields)
+{
+    // The first thread accumulates directly into the output fields, while every other thread
+    // uses its own copy that shares the pointers to the input dipoles.
+
+    int numThreads = getNumThreads();
+    vector<vector<UpdateInducedDipoleFieldStruct> > threadFields(numThreads-1, updateInducedDipoleFields);
+    vector<double> zeros(6, 0.0);
+    for (auto& fields : threadFields)
+        for (auto& field : fields) {
+            std::fill(field.inducedDipoleField.begin(), field.inducedDipoleField.end(), Vec3());
+            std::fill(field.inducedDipoleFieldGradient.begin(), field.inducedDipoleFieldGradient.end(), zeros);
+        }
+    forEachPair(false, [&] (int threadIndex, int ii, int jj) {
+        calculateDirectInducedDipolePairIxns(particleData[ii], particleData[jj], threadIndex == 0 ? updateInducedDipoleFields : threadFields[threadIndex-1]);
+    });
+    for (auto& fields : threadFields)
+        for (unsigned int ii = 0; ii < updateInducedDipoleFields.size(); ii++) {
+            UpdateInducedDipoleFieldStruct& field = updateInducedDipoleFields[ii];
+            for (unsigned int jj = 0; jj < _numParticles; jj++)
+                field.inducedDipoleField[jj] += fields[ii].inducedDipoleField[jj];
+            for (unsigned int jj = 0; jj < field.inducedDipoleFieldGradient.size(); jj++)
+                for (int kk = 0; kk < 6; kk++)
+                    field.inducedDipoleFieldGradient[jj][kk] += fields[ii].inducedDipoleFieldGradient[jj][kk];
+        }
+}
+
 void AmoebaReferencePmeMultipoleForce::calculateDirectInducedDipolePairIxn(unsigned int iIndex, unsigned int jIndex,
                                                                            double preFactor1, double preFactor2,
                                                                            const Vec3& delta,
@@ -6415,6 +6801,115 @@ void AmoebaReferencePmeMultipoleForce::calculateDirectInducedDipolePairIxns(cons
     }
 }
 
+void AmoebaReferencePmeMultipoleForce::calculatePmeElectrostaticPotential(const vector<Vec3>& particlePositions,
+                                                                          const vector<double>& charges,
+                                                                          const vector<double>& dipoles,
+                                                                          const vector<double>& quadrupoles,
+                                                                          const vector<double>& tholes,
+                                                                          const vector<double>& dampingFactors,
+                                                                          const vector<double>& polarity,
+                                                                          const vector<int>& axisTypes,
+                                                                          const vector<int>& multipoleAtomZs,
+                                                                          const vector<int>& multipoleAtomXs,
+                                                                          const vector<int>& multipoleAtomYs,
+                                                                          const vector< vector< vector<int> > >& multipoleAtomCovalentInfo,
+                                                                          const vector<Vec3>& grid,
+                                                                          vector<double>& potential)
+{
+    vector<MultipoleParticleData> particleData;
+    setup(particlePositions, charges, dipoles, quadrupoles, tholes,
+           dampingFactors, polarity, axisTypes, multipoleAtomZs, multipoleAtomXs, multipoleAtomYs,
+           multipoleAtomCovalentInfo, particleData);
+
+    // Spread the fixed multipoles and the induced dipoles onto the same grid.  The induced
+    // dipoles go into the real part, so the real part of the convolved grid is the potential.
+
+    resizePmeArrays();
+    computeAmoebaBsplines(particleData);
+    spreadFixedMultipolesOntoGrid(particleData);
+    vector<double> fixedGrid(_totalGridSize);
+    for (int i = 0; i < _totalGridSize; i++)
+        fixedGrid[i] = _pmeGrid[i].real();
+    spreadInducedDipolesOnGrid(_inducedDipole, _inducedDipolePolar);
+    for (int i = 0; i < _totalGridSize; i++)
+        _pmeGrid[i] = complex<double>(_pmeGrid[i].real()+fixedGrid[i], 0);
+    vector<size_t> shape = {(size_t) _pmeGridDimensions[0], (size_t) _pmeGridDimensions[1], (size_t) _pmeGridDimensions[2]};
+    vector<size_t> axes = {0, 1, 2};
+    vector<ptrdiff_t> stride = {(ptrdiff_t) (_pmeGridDimensions[1]*_pmeGridDimensions[2]*sizeof(complex<double>)),
+                                (ptrdiff_t) (_pmeGridDimensions[2]*sizeof(complex<double>)),
+                                (ptrdiff_t) sizeof(complex<double>)};
+    pocketfft::c2c(shape, stride, stride, axes, true, _pmeGrid, _pmeGrid, 1.0, 0);
+    performAmoebaReciprocalConvolution();
+    pocketfft::c2c(shape, stride, stride, axes, false, _pmeGrid, _pmeGrid, 1.0, 0);
+
+    // The potential of the neutralizing background is constant.
+
+    double totalCharge = 0.0;
+    for (auto& particle : particleData)
+        totalCharge += particle.charge;
+    double volume = _periodicBoxVectors[0][0]*_periodicBoxVectors[1][1]*_periodicBoxVectors[2][2];
+    double background = -M_PI*totalCharge/(volume*_alphaEwald*_alphaEwald);
+
+    potential.resize(grid.size());
+    double cutoff2 = _cutoffDistance*_cutoffDistance;
+    double alsq2 = 2.0*_alphaEwald*_alphaEwald;
+    double alsq2n = 1.0/(SQRT_PI*_alphaEwald);
+    vector<double4> theta[3];
+    for (int i = 0; i < 3; i++)
+        theta[i].resize(AMOEBA_PME_ORDER);
+    for (unsigned int jj = 0; jj < grid.size(); jj++) {
+        // Interpolate the reciprocal space potential from the grid.
+
+        Vec3 position = grid[jj];
+        getPeriodicDelta(position);
+        IntVec igrid;
+        for (int i = 0; i < 3; i++) {
+            double w  = position[0]*_recipBoxVectors[0][i]+position[1]*_recipBoxVectors[1][i]+position[2]*_recipBoxVectors[2][i];
+            double fr = _pmeGridDimensions[i]*(w-(int)(w+0.5)+0.5);
+            int ifr   = static_cast<int>(floor(fr));
+            igrid[i]  = ifr - AMOEBA_PME_ORDER + 1;
+            igrid[i] += igrid[i] < 0 ? _pmeGridDimensions[i] : 0;
+            computeBSplinePoint(theta[i], fr-ifr);
+        }
+        double sum = background;
+        for (int ix = 0; ix < AMOEBA_PME_ORDER; ix++) {
+            int x = (igrid[0]+ix) % _pmeGridDimensions[0];
+            for (int iy = 0; iy < AMOEBA_PME_ORDER; iy++) {
+                int y = (igrid[1]+iy) % _pmeGridDimensions[1];
+                for (int iz = 0; iz < AMOEBA_PME_ORDER; iz++) {
+                    int z = (igrid[2]+iz) % _pmeGridDimensions[2];
+                    double gridValue = _pmeGrid[x*_pmeGridDimensions[1]*_pmeGridDimensions[2]+y*_pmeGridDimensions[2]+z].real();
+                    sum += gridValue*theta[0][ix][0]*theta[1][iy][0]*theta[2][iz][0];
+                }
+            }
+        }
+
+        // Add the real space potential of particles within the cutoff.
+
+        for (unsigned int ii = 0; ii < _numParticles; ii++) {
+            const MultipoleParticleData& particleI = particleData[ii];
+            Vec3 deltaR = particleI.position - grid[jj];
+            getPeriodicDelta(deltaR);
+            double r2 = deltaR.dot(deltaR);
+            if (r2 > cutoff2)
+                continue;
+            double r = sqrt(r2);
+            double ralpha = _alphaEwald*r;
+            double exp2a = exp(-(ralpha*ralpha));
+            double bn0 = erfc(ralpha)/r;
+            double bn1 = (bn0+alsq2*alsq2n*exp2a)/r2;
+            double bn2 = (3.0*bn1+alsq2*alsq2*alsq2n*exp2a)/r2;
+            double scd = particleI.dipole.dot(deltaR);
+            double scu = _inducedDipole[ii].dot(deltaR);
+            double scq = deltaR[0]*(particleI.quadrupole[QXX]*deltaR[0] + particleI.quadrupole[QXY]*deltaR[1] + particleI.quadrupole[QXZ]*deltaR[2]);
+            scq       += deltaR[1]*(particleI.quadrupole[QXY]*deltaR[0] + particleI.quadrupole[QYY]*deltaR[1] + particleI.quadrupole[QYZ]*deltaR[2]);
+            scq       += deltaR[2]*(particleI.quadrupole[QXZ]*deltaR[0] + particleI.quadrupole[QYZ]*deltaR[1] + particleI.quadrupole[QZZ]*deltaR[2]);
+            sum += particleI.charge*bn0 - (scd+scu)*bn1 + scq*bn2;
+        }
+        potential[jj] = (_electric/_dielectric)*sum;
+    }
+}
+
 double AmoebaReferencePmeMultipoleForce::calculatePmeSelfEnergy(const vector<MultipoleParticleData>& particleData) const
 {
     double cii = 0.0;
@@ -6890,28 +7385,9 @@ double AmoebaReferencePmeMultipoleForce::calculatePmeDirectElectrostaticPairIxn(
 double AmoebaReferencePmeMultipoleForce::calculateElectrostatic(const vector<MultipoleParticleData>& particleData,
                                                                 vector<Vec3>& torques, vector<Vec3>& forces)
 {
-    double energy = 0.0;
-    vector<double> scaleFactors(LAST_SCALE_TYPE_INDEX);
-    for (auto& s : scaleFactors)
-        s = 1.0;
-
     // loop over particle pairs for direct space interactions
 
-    for (unsigned int ii = 0; ii < particleData.size(); ii++) {
-        for (unsigned int jj = ii+1; jj < particleData.size(); jj++) {
-
-            if (jj <= _maxScaleIndex[ii]) {
-                getMultipoleScaleFactors(ii, jj, scaleFactors);
-            }
-
-            energy += calculatePmeDirectElectrostaticPairIxn(particleData[ii], particleData[jj], scaleFactors, forces, torques);
-
-            if (jj <= _maxScaleIndex[ii]) {
-                for (auto& s : scaleFactors)
-                    s = 1.0;
-            }
-        }
-    }
+    double energy = calculateDirectElectrostatic(particleData, torques, forces);
 
     // The polarization energy
     calculatePmeSelfTorque(particleData, torques);
@@ -6953,3 +7429,38 @@ double AmoebaReferencePmeMultipoleForce::calculateElectrostatic(const vector<Mul
     }
     return energy;
 }
+
+double AmoebaReferencePmeMultipoleForce::calculateDirectElectrostatic(const vector<MultipoleParticleData>& particleData,
+                                                                      vector<Vec3>& torques, vector<Vec3>& forces)
+{
+    // The first thread accumulates directly into the outputs.
+
+    int numThreads = getNumThreads();
+    vector<double> threadEnergy(numThreads, 0.0);
+    vector<vector<Vec3> > threadForces(numThreads-1, vector<Vec3>(_numParticles));
+    vector<vector<Vec3> > threadTorques(numThreads-1, vector<Vec3>(_numParticles));
+    vector<vector<double> > threadScaleFactors(numThreads, vector<double>(LAST_SCALE_TYPE_INDEX, 1.0));
+    forEachPair(false, [&] (int threadIndex, int ii, int jj) {
+        vector<double>& scaleFactors = threadScaleFactors[threadIndex];
+        if (jj <= _maxScaleIndex[ii]) {
+            getMultipoleScaleFactors(ii, jj, scaleFactors);
+        }
+
+        threadEnergy[threadIndex] += calculatePmeDirectElectrostaticPairIxn(particleData[ii], particleData[jj], scaleFactors,
+                threadIndex == 0 ? forces : threadForces[threadIndex-1], threadIndex == 0 ? torques : threadTorques[threadIndex-1]);
+
+        if (jj <= _maxScaleIndex[ii]) {
+            for (auto& s : scaleFactors)
+                s = 1.0;
+        }
+    });
+    double energy = threadEnergy[0];
+    for (int ii = 1; ii < numThreads; ii++) {
+        energy += threadEnergy[ii];
+        for (unsigned int jj = 0; jj < _numParticles; jj++) {
+            forces[jj] += threadForces[ii-1][jj];
+            torques[jj] += threadTorques[ii-1][jj];
+        }
+    }
+    return energy;
+}
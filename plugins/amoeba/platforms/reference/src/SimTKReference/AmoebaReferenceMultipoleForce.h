@@ -27,6 +27,8 @@
 #include "openmm/AmoebaMultipoleForce.h"
 #include "openmm/Vec3.h"
 #include "AmoebaReferenceGeneralizedKirkwoodForce.h"
+#include "openmm/internal/ThreadPool.h"
+#include <functional>
 #include <map>
 #include <complex>
 
@@ -402,6 +404,15 @@ public:
      */
     void setPolarizationType(PolarizationType polarizationType);
 
+    /**
+     * Set the thread pool used to parallelize the pair loops.  If this is NULL (the default)
+     * or the pool has a single thread, all calculations are done serially.  For a given
+     * number of threads the work is always divided the same way, so results are reproducible.
+     *
+     * @param threads   the thread pool to use, or NULL
+     */
+    void setThreadPool(ThreadPool* threads);
+
     /**
      * Get flag indicating if mutual induced dipoles are converged.
      *
@@ -467,6 +478,39 @@ public:
      */
     int getMaximumMutualInducedDipoleIterations() const;
 
+    /**
+     * Set the algorithm used to converge mutual induced dipoles.
+     *
+     * @param solver the algorithm to use
+     *
+     */
+    void setMutualInducedDipoleSolver(AmoebaMultipoleForce::MutualInducedSolver solver);
+
+    /**
+     * Get the algorithm used to converge mutual induced dipoles.
+     *
+     * @return the algorithm to use
+     *
+     */
+    AmoebaMultipoleForce::MutualInducedSolver getMutualInducedDipoleSolver() const;
+
+    /**
+     * Set the initial guess for the induced dipoles used when converging mutual induced dipoles.
+     * If this is not set, the iteration starts from the direct dipoles.
+     *
+     * @param inducedDipole       initial guess for the induced dipoles
+     * @param inducedDipolePolar  initial guess for the polar induced dipoles
+     */
+    void setInitialInducedDipoles(const std::vector<Vec3>& inducedDipole, const std::vector<Vec3>& inducedDipolePolar);
+
+    /**
+     * Get the induced dipoles from the most recent calculation.
+     *
+     * @param inducedDipole       the induced dipoles
+     * @param inducedDipolePolar  the polar induced dipoles
+     */
+    void getInducedDipoles(std::vector<Vec3>& inducedDipole, std::vector<Vec3>& inducedDipolePolar) const;
+
     /**
      * Calculate force and energy.
      *
@@ -736,6 +780,8 @@ protected:
     std::vector<Vec3> _fixedMultipoleFieldPolar;
     std::vector<Vec3> _inducedDipole;
     std::vector<Vec3> _inducedDipolePolar;
+    std::vector<Vec3> _initialInducedDipole;
+    std::vector<Vec3> _initialInducedDipolePolar;
     std::vector<std::vector<Vec3> > _ptDipoleP;
     std::vector<std::vector<Vec3> > _ptDipoleD;
     std::vector<std::vector<double> > _ptDipoleFieldGradientP;
@@ -744,12 +790,14 @@ protected:
     int _mutualInducedDipoleConverged;
     int _mutualInducedDipoleIterations;
     int _maximumMutualInducedDipoleIterations;
+    AmoebaMultipoleForce::MutualInducedSolver _mutualInducedDipoleSolver;
     int _maxPTOrder;
     std::vector<double>  _extrapolationCoefficients;
     std::vector<double>  _extPartCoefficients;
     double  _mutualInducedDipoleEpsilon;
     double  _mutualInducedDipoleTargetEpsilon;
     double  _debye;
+    ThreadPool* _threads;
 
     /**
      * Helper constructor method to centralize initialization of objects.
@@ -757,6 +805,31 @@ protected:
      */
     void initialize();
 
+    /**
+     * Get the number of threads used for parallel loops.
+     *
+     * @return the number of threads in the thread pool, or 1 if none has been set
+     */
+    int getNumThreads() const;
+
+    /**
+     * Execute a task on every thread of the thread pool and wait for all of them to finish.
+     * If there is no thread pool, the task is executed once on the calling thread.
+     *
+     * @param task    the task to execute; it is passed the index of the thread
+     */
+    void executeOnThreads(const std::function<void (int)>& task) const;
+
+    /**
+     * Loop over all pairs of particles (i, j) with i < j, dividing them between threads.
+     * Row i always goes to thread i%numThreads, so the order in which each thread
+     * accumulates its results depends only on the number of threads.
+     *
+     * @param includeSelf   if true, the pairs with i == j are included as well
+     * @param pairFunction  called with the thread index and the two particle indices
+     */
+    void forEachPair(bool includeSelf, const std::function<void (int, int, int)>& pairFunction) const;
+
     /**
      * Load particle data.
      *
@@ -1027,6 +1100,16 @@ protected:
      */
     void convergeInduceDipolesByDIIS(const std::vector<MultipoleParticleData>& particleData,
                                      std::vector<UpdateInducedDipoleFieldStruct>& calculateInducedDipoleField);
+
+    /**
+     * Converge induced dipoles with a preconditioned conjugate gradient method.  Each set of dipoles is
+     * solved independently, using the polarizabilities as a diagonal preconditioner.
+     * 
+     * @param particleData              vector of particle positions and parameters (charge, labFrame dipoles, quadrupoles, ...)
+     * @param updateInducedDipoleFields vector of UpdateInducedDipoleFieldStruct containing input induced dipoles and output fields
+     */
+    void convergeInduceDipolesByPCG(const std::vector<MultipoleParticleData>& particleData,
+                                    std::vector<UpdateInducedDipoleFieldStruct>& calculateInducedDipoleField);
     
     /**
      * Use DIIS to compute the weighting coefficients for the new induced dipoles.
@@ -1302,6 +1385,28 @@ private:
     double _dielectricOffset;
     double _tanhRescaling;
     double _descreenOffset;
+    bool _useCutoff;
+    double _cutoffDistance;
+    NeighborList _neighborList;
+
+    /**
+     * Get the taper applied to the generalized Kirkwood interaction between two particles.  It is 1
+     * if no cutoff is used, and goes smoothly to 0 at the cutoff distance otherwise.
+     *
+     * @param particleI               positions and parameters for particle I
+     * @param particleJ               positions and parameters for particle J
+     * @param dtaper                  on exit, the derivative of the taper with respect to the distance
+     */
+    double getCutoffTaper(const MultipoleParticleData& particleI, const MultipoleParticleData& particleJ, double& dtaper) const;
+
+    /**
+     * Invoke a function for every pair of particles with a generalized Kirkwood interaction.  With a
+     * cutoff, this is the pairs in the neighbor list; otherwise it is every pair.
+     *
+     * @param includeSelf   if true, the pairs with i == j are included as well
+     * @param pairFunction  called with the thread index and the two particle indices
+     */
+    void forEachKirkwoodPair(bool includeSelf, const std::function<void (int, int, int)>& pairFunction) const;
 
     /**
      * Zero fixed multipole fields.
@@ -1491,7 +1596,42 @@ public:
      */
      void setPeriodicBoxSize(OpenMM::Vec3* vectors);
 
-private:
+    /**
+     * Calculate the electrostatic potential at a set of grid points using Ewald summation.  The real space
+     * part is summed over particles within the cutoff, and the reciprocal space part is interpolated from
+     * the PME grid.
+     *
+     * @param particlePositions         Cartesian coordinates of particles
+     * @param charges                   scalar charges for each particle
+     * @param dipoles                   molecular frame dipoles for each particle
+     * @param quadrupoles               molecular frame quadrupoles for each particle
+     * @param tholes                    Thole factors for each particle
+     * @param dampingFactors            dampling factors for each particle
+     * @param polarity                  polarity for each particle
+     * @param axisTypes                 axis type (Z-then-X, ...) for each particle
+     * @param multipoleAtomZs           indicies of particle specifying the molecular frame z-axis for each particle
+     * @param multipoleAtomXs           indicies of particle specifying the molecular frame x-axis for each particle
+     * @param multipoleAtomYs           indicies of particle specifying the molecular frame y-axis for each particle
+     * @param multipoleAtomCovalentInfo covalent info needed to set scaling factors
+     * @param input grid                input grid points to compute potential
+     * @param outputPotential           output electrostatic potential
+     */
+    void calculatePmeElectrostaticPotential(const std::vector<OpenMM::Vec3>& particlePositions,
+                                            const std::vector<double>& charges,
+                                            const std::vector<double>& dipoles,
+                                            const std::vector<double>& quadrupoles,
+                                            const std::vector<double>& tholes,
+                                            const std::vector<double>& dampingFactors,
+                                            const std::vector<double>& polarity,
+                                            const std::vector<int>& axisTypes,
+                                            const std::vector<int>& multipoleAtomZs,
+                                            const std::vector<int>& multipoleAtomXs,
+                                            const std::vector<int>& multipoleAtomYs,
+                                            const std::vector< std::vector< std::vector<int> > >& multipoleAtomCovalentInfo,
+                                            const std::vector<Vec3>& inputGrid,
+                                            std::vector<double>& outputPotential);
+
+protected:
 
     static const int AMOEBA_PME_ORDER;
     static const double SQRT_PI;
@@ -1568,6 +1708,20 @@ private:
      */
     void calculateFixedMultipoleFieldPairIxn(const MultipoleParticleData& particleI, const MultipoleParticleData& particleJ,
                                              double dscale, double pscale);
+
+    /**
+     * Calculate direct-space field at site I due fixed multipoles at site J and vice versa, adding
+     * the result to the specified arrays rather than the member fields.
+     * 
+     * @param particleI               positions and parameters (charge, labFrame dipoles, quadrupoles, ...) for particle I
+     * @param particleJ               positions and parameters (charge, labFrame dipoles, quadrupoles, ...) for particle J
+     * @param dScale                  d-scale value for i-j interaction
+     * @param pScale                  p-scale value for i-j interaction
+     * @param field                   the field is added to this vector
+     * @param fieldPolar              the polar field is added to this vector
+     */
+    void calculateFixedMultipoleFieldPairIxn(const MultipoleParticleData& particleI, const MultipoleParticleData& particleJ,
+                                             double dscale, double pscale, std::vector<Vec3>& field, std::vector<Vec3>& fieldPolar) const;
     
     /**
      * Calculate fixed multipole fields.
@@ -1577,6 +1731,14 @@ private:
      */
     void calculateFixedMultipoleField(const vector<MultipoleParticleData>& particleData);
 
+    /**
+     * Calculate the direct space portion of the fixed multipole fields.  Subclasses
+     * may override this to use a different strategy for looping over particle pairs.
+     *
+     * @param particleData vector particle data
+     */
+    virtual void calculateDirectFixedMultipoleField(const vector<MultipoleParticleData>& particleData);
+
     /**
      * This is called from computeAmoebaBsplines().  It calculates the spline coefficients for a single atom along a single axis.
      * 
@@ -1705,6 +1867,16 @@ private:
     void calculateInducedDipoleFields(const std::vector<MultipoleParticleData>& particleData,
                                       std::vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields);
 
+    /**
+     * Calculate the direct space portion of the induced dipole fields.  Subclasses
+     * may override this to use a different strategy for looping over particle pairs.
+     * 
+     * @param particleData              vector of particle positions and parameters (charge, labFrame dipoles, quadrupoles, ...)
+     * @param updateInducedDipoleFields vector of UpdateInducedDipoleFieldStruct containing input induced dipoles and output fields
+     */
+    virtual void calculateDirectInducedDipoleFields(const std::vector<MultipoleParticleData>& particleData,
+                                                    std::vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields);
+
     /**
      * Set reciprocal space induced dipole fields. 
      *
@@ -1768,6 +1940,19 @@ private:
                                   std::vector<OpenMM::Vec3>& torques,
                                   std::vector<OpenMM::Vec3>& forces);
 
+    /**
+     * Calculate the direct space portion of the electrostatic forces.  Subclasses
+     * may override this to use a different strategy for looping over particle pairs.
+     * 
+     * @param particleData            vector of parameters (charge, labFrame dipoles, quadrupoles, ...) for particles
+     * @param torques                 output torques
+     * @param forces                  output forces 
+     *
+     * @return energy
+     */
+    virtual double calculateDirectElectrostatic(const std::vector<MultipoleParticleData>& particleData, 
+                                                std::vector<OpenMM::Vec3>& torques,
+                                                std::vector<OpenMM::Vec3>& forces);
 };
 
 } // namespace OpenMM
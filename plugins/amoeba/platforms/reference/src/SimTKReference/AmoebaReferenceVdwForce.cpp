@@ -53,8 +53,7 @@ void AmoebaReferenceVdwForce::initialize(const AmoebaVdwForce& force) {
     reductions.resize(numParticles);
     scaleFactors.resize(numParticles);
     isAlchemical.resize(numParticles);
-    allExclusions.clear();
-    allExclusions.resize(numParticles);
+    vector<std::pair<int, int> > excludedPairs;
     for (int i = 0; i < numParticles; i++) {
         int type;
         double sigma, epsilon;
@@ -64,8 +63,9 @@ void AmoebaReferenceVdwForce::initialize(const AmoebaVdwForce& force) {
         isAlchemical[i] = alchemical;
         force.getParticleExclusions(i, exclusions);
         for (unsigned int j = 0; j < exclusions.size(); j++)
-           allExclusions[i].insert(exclusions[j]);
+           excludedPairs.push_back(std::make_pair(i, exclusions[j]));
     }
+    allExclusions = ExclusionList(numParticles, excludedPairs);
 }
 
 void AmoebaReferenceVdwForce::setTaperCoefficients(double cutoff) {
@@ -93,7 +93,7 @@ void AmoebaReferenceVdwForce::setPeriodicBox(OpenMM::Vec3* vectors) {
     _periodicBoxVectors[2] = vectors[2];
 }
 
-std::vector<std::set<int> >& AmoebaReferenceVdwForce::getExclusions() {
+const ExclusionList& AmoebaReferenceVdwForce::getExclusions() const {
     return allExclusions;
 }
 
@@ -76,11 +76,11 @@ public:
  
     /**---------------------------------------------------------------------------------------
     
-       Get the set of exclusions for each particle.
+       Get the exclusions for each particle.
     
        --------------------------------------------------------------------------------------- */
     
-    std::vector<std::set<int> >& getExclusions();
+    const ExclusionList& getExclusions() const;
 
     /**---------------------------------------------------------------------------------------
     
@@ -115,7 +115,7 @@ public:
     double calculateForceAndEnergy(int numParticles, double lambda, const std::vector<OpenMM::Vec3>& particlePositions, 
                                    const NeighborList& neighborList, std::vector<OpenMM::Vec3>& forces) const;
          
-private:
+protected:
     // taper coefficient indices
     static const int C3=0;
     static const int C4=1;
@@ -138,7 +138,7 @@ private:
     std::vector<double> reductions;
     std::vector<double> scaleFactors;
     std::vector<bool> isAlchemical;
-    std::vector<std::set<int> > allExclusions;
+    ExclusionList allExclusions;
     Vec3 _periodicBoxVectors[3];
 
     /**---------------------------------------------------------------------------------------
@@ -37,7 +37,16 @@ AmoebaReferenceWcaDispersionForce::AmoebaReferenceWcaDispersionForce(double epso
                                                                      double rminh, double awater, double shctd,
                                                                      double dispoff, double slevy) :
         _epso(epso), _epsh(epsh), _rmino(rmino), _rminh(rminh), _awater(awater), _shctd(shctd), _dispoff(dispoff),
-        _slevy(slevy) {
+        _slevy(slevy), _cutoff(1.0e+10), _taperCutoff(1.0e+10) {
+    _taperCoefficients[0] = _taperCoefficients[1] = _taperCoefficients[2] = 0.0;
+}
+
+void AmoebaReferenceWcaDispersionForce::setCutoff(double cutoff) {
+    _cutoff = cutoff;
+    _taperCutoff = 0.9*cutoff;
+    _taperCoefficients[0] = 10.0/pow(_taperCutoff - cutoff, 3.0);
+    _taperCoefficients[1] = 15.0/pow(_taperCutoff - cutoff, 4.0);
+    _taperCoefficients[2] =  6.0/pow(_taperCutoff - cutoff, 5.0);
 }
 
 static double integralBeforeRMin(double eps, double r, double r2, double sk2,
@@ -215,6 +224,23 @@ double AmoebaReferenceWcaDispersionForce::calculatePairIxn(double radiusJ,
     return sum;
 }
 
+void AmoebaReferenceWcaDispersionForce::calculateIntermediateValues(double epsi, double rmini, double* intermediateValues) const {
+    double rmino2 = _rmino * _rmino;
+    double rmino3 = rmino2 * _rmino;
+    double rminh2 = _rminh * _rminh;
+    double rminh3 = rminh2 * _rminh;
+    double rminI2 = rmini * rmini;
+    double rminI3 = rminI2 * rmini;
+
+    double denominator = sqrt(_epso) + sqrt(epsi);
+    intermediateValues[EMIXO] = 4.0 * _epso * epsi / (denominator * denominator);
+    intermediateValues[RMIXO] = 2.0 * (rmino3 + rminI3) / (rmino2 + rminI2);
+
+    denominator = sqrt(_epsh) + sqrt(epsi);
+    intermediateValues[EMIXH] = 4.0 * _epsh * epsi / (denominator * denominator);
+    intermediateValues[RMIXH] = 2.0 * (rminh3 + rminI3) / (rminh2 + rminI2);
+}
+
 double AmoebaReferenceWcaDispersionForce::calculateForceAndEnergy(int numParticles,
                                                                   const vector<Vec3> &particlePositions,
                                                                   const std::vector<double> &radii,
@@ -222,33 +248,12 @@ double AmoebaReferenceWcaDispersionForce::calculateForceAndEnergy(int numParticl
                                                                   double totalMaximumDispersionEnergy,
                                                                   vector<Vec3> &forces) const {
     double energy = 0.0;
-    double rmino2 = _rmino * _rmino;
-    double rmino3 = rmino2 * _rmino;
-    double rminh2 = _rminh * _rminh;
-    double rminh3 = rminh2 * _rminh;
     double intermediateValues[LastIntermediateValueIndex];
 
     // loop over all ixns
     for (unsigned int ii = 0; ii < static_cast<unsigned int>(numParticles); ii++) {
 
-        double epsi = epsilons[ii];
-        double rmini = radii[ii];
-        double rminI2 = rmini * rmini;
-        double rminI3 = rminI2 * rmini;
-
-        double denominator = sqrt(_epso) + sqrt(epsi);
-        double emixo = 4.0 * _epso * epsi / (denominator * denominator);
-        intermediateValues[EMIXO] = emixo;
-
-        double rmixo = 2.0 * (rmino3 + rminI3) / (rmino2 + rminI2);
-        intermediateValues[RMIXO] = rmixo;
-
-        denominator = sqrt(_epsh) + sqrt(epsi);
-        double emixh = 4.0 * _epsh * epsi / (denominator * denominator);
-        intermediateValues[EMIXH] = emixh;
-
-        double rmixh = 2.0 * (rminh3 + rminI3) / (rminh2 + rminI2);
-        intermediateValues[RMIXH] = rmixh;
+        calculateIntermediateValues(epsilons[ii], radii[ii], intermediateValues);
 
         // Remove dispersion for atom i by atom j.
         for (unsigned int jj = 0; jj < static_cast<unsigned int>(numParticles); jj++) {
@@ -279,3 +284,49 @@ double AmoebaReferenceWcaDispersionForce::calculateForceAndEnergy(int numParticl
 
     return energy;
 }
+
+double AmoebaReferenceWcaDispersionForce::calculateForceAndEnergy(int numParticles,
+                                                                  const vector<Vec3> &particlePositions,
+                                                                  const std::vector<double> &radii,
+                                                                  const std::vector<double> &epsilons,
+                                                                  double totalMaximumDispersionEnergy,
+                                                                  const NeighborList& neighborList,
+                                                                  vector<Vec3> &forces) const {
+    double energy = 0.0;
+    double intermediateValuesI[LastIntermediateValueIndex];
+    double intermediateValuesJ[LastIntermediateValueIndex];
+
+    // Each neighbor list entry accounts for both atom i being descreened by atom j and atom j being descreened by atom i.
+    for (auto& pair : neighborList) {
+        int ii = pair.first;
+        int jj = pair.second;
+        Vec3 deltaR = particlePositions[ii] - particlePositions[jj];
+        double r = sqrt(deltaR.dot(deltaR));
+        if (r > _cutoff)
+            continue;
+        calculateIntermediateValues(epsilons[ii], radii[ii], intermediateValuesI);
+        calculateIntermediateValues(epsilons[jj], radii[jj], intermediateValuesJ);
+
+        Vec3 forceI, forceJ;
+        double pairEnergy = calculatePairIxn(radii[jj], particlePositions[ii], particlePositions[jj], intermediateValuesI, forceI);
+        pairEnergy += calculatePairIxn(radii[ii], particlePositions[jj], particlePositions[ii], intermediateValuesJ, forceJ);
+        Vec3 force = forceI - forceJ;
+
+        // Smoothly switch off the descreening at the cutoff.
+        if (r > _taperCutoff) {
+            double delta = r - _taperCutoff;
+            double taper = 1.0 + delta*delta*delta*(_taperCoefficients[0] + delta*(_taperCoefficients[1] + delta*_taperCoefficients[2]));
+            double dtaper = delta*delta*(3.0*_taperCoefficients[0] + delta*(4.0*_taperCoefficients[1] + delta*5.0*_taperCoefficients[2]));
+            force = force*taper + deltaR*(pairEnergy*dtaper/r);
+            pairEnergy *= taper;
+        }
+        energy += pairEnergy;
+        force *= _slevy * _awater;
+        forces[ii] += force;
+        forces[jj] -= force;
+    }
+
+    energy = totalMaximumDispersionEnergy - _slevy * _awater * energy;
+
+    return energy;
+}
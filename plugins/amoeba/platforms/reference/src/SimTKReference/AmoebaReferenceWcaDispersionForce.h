@@ -26,6 +26,7 @@
 #define __AmoebaReferenceWcaDispersionForce_H__
 
 #include "openmm/Vec3.h"
+#include "ReferenceNeighborList.h"
 #include <string>
 #include <vector>
 
@@ -80,6 +81,39 @@ public:
                                    const std::vector<double>& radii, 
                                    const std::vector<double>& epsilons,
                                    double totalMaximumDispersionEnergy, std::vector<OpenMM::Vec3>& forces) const;
+
+    /**---------------------------------------------------------------------------------------
+
+       Set the cutoff used by the neighbor list version of calculateForceAndEnergy().  The
+       descreening of each atom is switched off between 0.9*cutoff and the cutoff.
+
+       @param cutoff                       cutoff distance
+
+       --------------------------------------------------------------------------------------- */
+
+    void setCutoff(double cutoff);
+
+    /**---------------------------------------------------------------------------------------
+
+       Calculate WcaDispersion ixns using a neighbor list
+
+       @param numParticles                 number of particles
+       @param particlePositions            Cartesian coordinates of particles
+       @param radii                        particle radii
+       @param epsilons                     particle epsilons
+       @param totalMaximumDispersionEnergy total of maximum dispersion energy
+       @param neighborList                 pairs of particles within the cutoff
+       @param forces                       add forces to this vector
+
+       @return energy
+
+       --------------------------------------------------------------------------------------- */
+
+    double calculateForceAndEnergy(int numParticles, const std::vector<OpenMM::Vec3>& particlePositions,
+                                   const std::vector<double>& radii,
+                                   const std::vector<double>& epsilons,
+                                   double totalMaximumDispersionEnergy, const NeighborList& neighborList,
+                                   std::vector<OpenMM::Vec3>& forces) const;
 private:
 
     double _epso; 
@@ -90,9 +124,24 @@ private:
     double _shctd; 
     double _dispoff;
     double _slevy;
+    double _cutoff;
+    double _taperCutoff;
+    double _taperCoefficients[3];
 
     enum { EMIXO, RMIXO, EMIXH, RMIXH, LastIntermediateValueIndex };
 
+    /**---------------------------------------------------------------------------------------
+
+       Compute the mixed parameters of particle I with the water oxygen and hydrogen
+
+       @param  epsilon              epsilon of particle I
+       @param  radius               radius of particle I
+       @param  intermediateValues   output mixed parameters
+
+       --------------------------------------------------------------------------------------- */
+
+    void calculateIntermediateValues(double epsilon, double radius, double* intermediateValues) const;
+
     /**---------------------------------------------------------------------------------------
     
        Calculate pair ixn
@@ -31,5 +31,62 @@
 
 #include "ReferenceAmoebaTests.h"
 #include "TestAmoebaMultipoleForce.h"
+#include "openmm/internal/hardware.h"
 
-void runPlatformTests() {}
+/**
+ * Test that dividing the work between multiple threads gives the same results as a single thread.
+ */
+void testMultipleThreads(AmoebaMultipoleForce::NonbondedMethod nonbondedMethod, AmoebaMultipoleForce::PolarizationType polarizationType) {
+    string testName = "testMultipleThreads";
+    System system;
+    AmoebaMultipoleForce* amoebaMultipoleForce = new AmoebaMultipoleForce();
+    setupMultipoleAmmonia(system, amoebaMultipoleForce, nonbondedMethod, polarizationType, 0.3, 10);
+    map<string, string> properties;
+    properties[ReferencePlatform::ReferenceThreads()] = "1";
+    LangevinIntegrator integrator1(0.0, 0.1, 0.01);
+    Context context1(system, integrator1, platform, properties);
+    ASSERT_EQUAL("1", platform.getPropertyValue(context1, ReferencePlatform::ReferenceThreads()));
+    vector<Vec3> forces1, dipoles1;
+    double energy1;
+    getForcesEnergyMultipoleAmmonia(context1, forces1, energy1);
+    amoebaMultipoleForce->getInducedDipoles(context1, dipoles1);
+    properties[ReferencePlatform::ReferenceThreads()] = "3";
+    LangevinIntegrator integrator2(0.0, 0.1, 0.01);
+    Context context2(system, integrator2, platform, properties);
+    ASSERT_EQUAL("3", platform.getPropertyValue(context2, ReferencePlatform::ReferenceThreads()));
+    vector<Vec3> forces2, dipoles2;
+    double energy2;
+    getForcesEnergyMultipoleAmmonia(context2, forces2, energy2);
+    amoebaMultipoleForce->getInducedDipoles(context2, dipoles2);
+    compareForcesEnergy(testName, energy1, energy2, forces1, forces2, 1e-10);
+    for (int i = 0; i < system.getNumParticles(); i++)
+        ASSERT_EQUAL_VEC(dipoles1[i], dipoles2[i], 1e-10);
+
+    // Repeating the calculation with the same number of threads must reproduce the results exactly.
+
+    vector<Vec3> forces3;
+    double energy3;
+    getForcesEnergyMultipoleAmmonia(context2, forces3, energy3);
+    ASSERT(energy2 == energy3);
+    for (int i = 0; i < system.getNumParticles(); i++)
+        ASSERT(forces2[i] == forces3[i]);
+}
+
+/**
+ * Test that by default the platform uses one thread for every available core.
+ */
+void testDefaultThreads() {
+    System system;
+    system.addParticle(1.0);
+    LangevinIntegrator integrator(0.0, 0.1, 0.01);
+    Context context(system, integrator, platform);
+    ASSERT_EQUAL("0", platform.getPropertyDefaultValue(ReferencePlatform::ReferenceThreads()));
+    ASSERT_EQUAL(getNumProcessors(), stoi(platform.getPropertyValue(context, ReferencePlatform::ReferenceThreads())));
+}
+
+void runPlatformTests() {
+    testDefaultThreads();
+    testMultipleThreads(AmoebaMultipoleForce::NoCutoff, AmoebaMultipoleForce::Mutual);
+    testMultipleThreads(AmoebaMultipoleForce::PME, AmoebaMultipoleForce::Mutual);
+    testMultipleThreads(AmoebaMultipoleForce::PME, AmoebaMultipoleForce::Extrapolated);
+}
@@ -42,7 +42,7 @@ AmoebaGeneralizedKirkwoodForceProxy::AmoebaGeneralizedKirkwoodForceProxy() : Ser
 }
 
 void AmoebaGeneralizedKirkwoodForceProxy::serialize(const void* object, SerializationNode& node) const {
-    node.setIntProperty("version", 3);
+    node.setIntProperty("version", 5);
     const AmoebaGeneralizedKirkwoodForce& force = *reinterpret_cast<const AmoebaGeneralizedKirkwoodForce*>(object);
 
     node.setIntProperty("forceGroup", force.getForceGroup());
@@ -60,6 +60,10 @@ void AmoebaGeneralizedKirkwoodForceProxy::serialize(const void* object, Serializ
     node.setDoubleProperty("GeneralizedKirkwoodTanhB1", b1);
     node.setDoubleProperty("GeneralizedKirkwoodTanhB2", b2);
     node.setDoubleProperty("GeneralizedKirkwoodDescreenOffset", force.getDescreenOffset());
+    node.setIntProperty("nonbondedMethod", (int) force.getNonbondedMethod());
+    node.setDoubleProperty("cutoffDistance", force.getCutoffDistance());
+    node.setIntProperty("bornRadiiUpdateInterval", force.getBornRadiiUpdateInterval());
+    node.setDoubleProperty("bornRadiiUpdateTolerance", force.getBornRadiiUpdateTolerance());
     SerializationNode& particles = node.createChildNode("GeneralizedKirkwoodParticles");
     for (unsigned int ii = 0; ii < static_cast<unsigned int>(force.getNumParticles()); ii++) {
         double radius, charge, scalingFactor, descreenRadius, neckFactor;
@@ -71,7 +75,7 @@ void AmoebaGeneralizedKirkwoodForceProxy::serialize(const void* object, Serializ
 
 void* AmoebaGeneralizedKirkwoodForceProxy::deserialize(const SerializationNode& node) const {
     int version = node.getIntProperty("version");
-    if (version < 1 || version > 3)
+    if (version < 1 || version > 5)
         throw OpenMMException("Unsupported version number");
     AmoebaGeneralizedKirkwoodForce* force = new AmoebaGeneralizedKirkwoodForce();
     try {
@@ -92,6 +96,14 @@ void* AmoebaGeneralizedKirkwoodForceProxy::deserialize(const SerializationNode&
             force->setDescreenOffset(node.getDoubleProperty("GeneralizedKirkwoodDescreenOffset"));
 
         }
+        if (version > 3) {
+            force->setNonbondedMethod((AmoebaGeneralizedKirkwoodForce::NonbondedMethod) node.getIntProperty("nonbondedMethod"));
+            force->setCutoffDistance(node.getDoubleProperty("cutoffDistance"));
+        }
+        if (version > 4) {
+            force->setBornRadiiUpdateInterval(node.getIntProperty("bornRadiiUpdateInterval"));
+            force->setBornRadiiUpdateTolerance(node.getDoubleProperty("bornRadiiUpdateTolerance"));
+        }
 
         const SerializationNode& particles = node.getChildNode("GeneralizedKirkwoodParticles");
         for (unsigned int ii = 0; ii < particles.getChildren().size(); ii++) {
@@ -68,7 +68,7 @@ void loadCovalentMap(const SerializationNode& map, std::vector< int >& covalentM
 }
 
 void AmoebaMultipoleForceProxy::serialize(const void* object, SerializationNode& node) const {
-    node.setIntProperty("version", 4);
+    node.setIntProperty("version", 8);
     const AmoebaMultipoleForce& force = *reinterpret_cast<const AmoebaMultipoleForce*>(object);
 
     node.setIntProperty("forceGroup", force.getForceGroup());
@@ -76,8 +76,12 @@ void AmoebaMultipoleForceProxy::serialize(const void* object, SerializationNode&
     node.setIntProperty("nonbondedMethod",                  force.getNonbondedMethod());
     node.setIntProperty("polarizationType",                 force.getPolarizationType());
     node.setIntProperty("mutualInducedMaxIterations",       force.getMutualInducedMaxIterations());
+    node.setIntProperty("mutualInducedSolver",              force.getMutualInducedSolver());
+    node.setIntProperty("mutualInducedPredictor",           force.getMutualInducedPredictor());
+    node.setIntProperty("mutualInducedPredictorOrder",      force.getMutualInducedPredictorOrder());
 
     node.setDoubleProperty("cutoffDistance",                force.getCutoffDistance());
+    node.setStringProperty("lambdaName",                    force.Lambda());
     double alpha;
     int nx, ny, nz;
     force.getPMEParameters(alpha, nx, ny, nz);
@@ -87,6 +91,10 @@ void AmoebaMultipoleForceProxy::serialize(const void* object, SerializationNode&
 
     SerializationNode& gridDimensionsNode  = node.createChildNode("MultipoleParticleGridDimension");
     gridDimensionsNode.setIntProperty("d0", nx).setIntProperty("d1", ny).setIntProperty("d2", nz); 
+    int inducedOrder;
+    force.getInducedDipolePMEParameters(nx, ny, nz, inducedOrder);
+    SerializationNode& inducedGridNode = node.createChildNode("InducedDipoleGridDimension");
+    inducedGridNode.setIntProperty("d0", nx).setIntProperty("d1", ny).setIntProperty("d2", nz).setIntProperty("order", inducedOrder);
     
     SerializationNode& coefficients = node.createChildNode("ExtrapolationCoefficients");
     vector<double> coeff = force.getExtrapolationCoefficients();
@@ -114,6 +122,7 @@ void AmoebaMultipoleForceProxy::serialize(const void* object, SerializationNode&
         SerializationNode& particle    = particles.createChildNode("Particle");
         particle.setIntProperty("axisType", axisType).setIntProperty("multipoleAtomZ", multipoleAtomZ).setIntProperty("multipoleAtomX", multipoleAtomX).setIntProperty("multipoleAtomY", multipoleAtomY);
         particle.setDoubleProperty("charge", charge).setDoubleProperty("thole", thole).setDoubleProperty("damp", dampingFactor).setDoubleProperty("polarity", polarity);
+        particle.setBoolProperty("isAlchemical", force.getMultipoleAlchemical(ii));
 
         SerializationNode& dipole      = particle.createChildNode("Dipole");
         dipole.setDoubleProperty("d0", molecularDipole[0]).setDoubleProperty("d1", molecularDipole[1]).setDoubleProperty("d2", molecularDipole[2]);
@@ -133,7 +142,7 @@ void AmoebaMultipoleForceProxy::serialize(const void* object, SerializationNode&
 
 void* AmoebaMultipoleForceProxy::deserialize(const SerializationNode& node) const {
     int version = node.getIntProperty("version");
-    if (version < 0 || version > 4)
+    if (version < 0 || version > 8)
         throw OpenMMException("Unsupported version number");
     AmoebaMultipoleForce* force = new AmoebaMultipoleForce();
 
@@ -144,13 +153,25 @@ void* AmoebaMultipoleForceProxy::deserialize(const SerializationNode& node) cons
         if (version >= 2)
             force->setPolarizationType(static_cast<AmoebaMultipoleForce::PolarizationType>(node.getIntProperty("polarizationType")));
         force->setMutualInducedMaxIterations(node.getIntProperty("mutualInducedMaxIterations"));
+        if (version >= 5)
+            force->setMutualInducedSolver(static_cast<AmoebaMultipoleForce::MutualInducedSolver>(node.getIntProperty("mutualInducedSolver")));
+        if (version >= 6) {
+            force->setMutualInducedPredictor(static_cast<AmoebaMultipoleForce::MutualInducedPredictor>(node.getIntProperty("mutualInducedPredictor")));
+            force->setMutualInducedPredictorOrder(node.getIntProperty("mutualInducedPredictorOrder"));
+        }
 
         force->setCutoffDistance(node.getDoubleProperty("cutoffDistance"));
+        if (version >= 8)
+            force->setLambdaName(node.getStringProperty("lambdaName"));
         force->setMutualInducedTargetEpsilon(node.getDoubleProperty("mutualInducedTargetEpsilon"));
         force->setEwaldErrorTolerance(node.getDoubleProperty("ewaldErrorTolerance"));
 
         const SerializationNode& gridDimensionsNode  = node.getChildNode("MultipoleParticleGridDimension");
         force->setPMEParameters(node.getDoubleProperty("aEwald"), gridDimensionsNode.getIntProperty("d0"), gridDimensionsNode.getIntProperty("d1"), gridDimensionsNode.getIntProperty("d2"));
+        if (version >= 7) {
+            const SerializationNode& inducedGridNode = node.getChildNode("InducedDipoleGridDimension");
+            force->setInducedDipolePMEParameters(inducedGridNode.getIntProperty("d0"), inducedGridNode.getIntProperty("d1"), inducedGridNode.getIntProperty("d2"), inducedGridNode.getIntProperty("order"));
+        }
     
         if (version >= 3) {
             const SerializationNode& coefficients = node.getChildNode("ExtrapolationCoefficients");
@@ -197,6 +218,8 @@ void* AmoebaMultipoleForceProxy::deserialize(const SerializationNode& node) cons
                                 particle.getIntProperty("multipoleAtomY"),
                                 particle.getDoubleProperty("thole"),
                                 particle.getDoubleProperty("damp"), particle.getDoubleProperty("polarity"));
+            if (version >= 8)
+                force->setMultipoleAlchemical(ii, particle.getBoolProperty("isAlchemical"));
 
             // covalent maps 
 
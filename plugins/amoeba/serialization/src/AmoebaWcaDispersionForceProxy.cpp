@@ -42,7 +42,7 @@ AmoebaWcaDispersionForceProxy::AmoebaWcaDispersionForceProxy() : SerializationPr
 }
 
 void AmoebaWcaDispersionForceProxy::serialize(const void* object, SerializationNode& node) const {
-    node.setIntProperty("version", 2);
+    node.setIntProperty("version", 3);
     const AmoebaWcaDispersionForce& force = *reinterpret_cast<const AmoebaWcaDispersionForce*>(object);
     node.setIntProperty("forceGroup", force.getForceGroup());
     node.setStringProperty("name", force.getName());
@@ -54,6 +54,8 @@ void AmoebaWcaDispersionForceProxy::serialize(const void* object, SerializationN
     node.setDoubleProperty("Shctd",   force.getShctd());
     node.setDoubleProperty("Dispoff", force.getDispoff());
     node.setDoubleProperty("Slevy",   force.getSlevy());
+    node.setIntProperty("nonbondedMethod", (int) force.getNonbondedMethod());
+    node.setDoubleProperty("cutoffDistance", force.getCutoffDistance());
 
     SerializationNode& particles = node.createChildNode("WcaDispersionParticles");
     for (unsigned int ii = 0; ii < static_cast<unsigned int>(force.getNumParticles()); ii++) {
@@ -66,7 +68,7 @@ void AmoebaWcaDispersionForceProxy::serialize(const void* object, SerializationN
 
 void* AmoebaWcaDispersionForceProxy::deserialize(const SerializationNode& node) const {
     int version = node.getIntProperty("version");
-    if (version < 1 || version > 2)
+    if (version < 1 || version > 3)
         throw OpenMMException("Unsupported version number");
     AmoebaWcaDispersionForce* force = new AmoebaWcaDispersionForce();
 
@@ -83,6 +85,10 @@ void* AmoebaWcaDispersionForceProxy::deserialize(const SerializationNode& node)
         force->setShctd(  node.getDoubleProperty("Shctd"));
         force->setDispoff(node.getDoubleProperty("Dispoff"));
         force->setSlevy(  node.getDoubleProperty("Slevy"));
+        if (version > 2) {
+            force->setNonbondedMethod((AmoebaWcaDispersionForce::NonbondedMethod) node.getIntProperty("nonbondedMethod"));
+            force->setCutoffDistance(node.getDoubleProperty("cutoffDistance"));
+        }
 
         const SerializationNode& particles = node.getChildNode("WcaDispersionParticles");
         for (unsigned int ii = 0; ii < particles.getChildren().size(); ii++) {
@@ -54,6 +54,10 @@ void testSerialization() {
     force1.setSurfaceAreaFactor(0.888);
     force1.setIncludeCavityTerm(1);
     force1.setTanhRescaling(0);
+    force1.setNonbondedMethod(AmoebaGeneralizedKirkwoodForce::CutoffNonPeriodic);
+    force1.setCutoffDistance(1.2);
+    force1.setBornRadiiUpdateInterval(5);
+    force1.setBornRadiiUpdateTolerance(0.02);
 
     force1.addParticle(1.0, 2.0, 0.9, 2.0, 0.0);
     force1.addParticle(-1.1, 2.1, 0.8, 2.1, 0.0);
@@ -75,6 +79,10 @@ void testSerialization() {
     ASSERT_EQUAL(force1.getProbeRadius(), force2.getProbeRadius());
     ASSERT_EQUAL(force1.getSurfaceAreaFactor(), force2.getSurfaceAreaFactor());
     ASSERT_EQUAL(force1.getIncludeCavityTerm(), force2.getIncludeCavityTerm());
+    ASSERT_EQUAL(force1.getNonbondedMethod(), force2.getNonbondedMethod());
+    ASSERT_EQUAL(force1.getCutoffDistance(), force2.getCutoffDistance());
+    ASSERT_EQUAL(force1.getBornRadiiUpdateInterval(), force2.getBornRadiiUpdateInterval());
+    ASSERT_EQUAL(force1.getBornRadiiUpdateTolerance(), force2.getBornRadiiUpdateTolerance());
 
     ASSERT_EQUAL(force1.getNumParticles(), force2.getNumParticles());
     for (unsigned int ii = 0; ii < static_cast<unsigned int>(force1.getNumParticles()); ii++) {
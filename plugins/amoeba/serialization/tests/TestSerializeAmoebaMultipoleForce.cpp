@@ -71,8 +71,12 @@ void testSerialization() {
     gridDimension.push_back(63);
     gridDimension.push_back(61);
     force1.setPmeGridDimensions(gridDimension); 
+    force1.setInducedDipolePMEParameters(40, 42, 36, 4);
     force1.setMutualInducedMaxIterations(200); 
     force1.setMutualInducedTargetEpsilon(1.0e-05); 
+    force1.setMutualInducedSolver(AmoebaMultipoleForce::PCG);
+    force1.setMutualInducedPredictor(AmoebaMultipoleForce::ASPC);
+    force1.setMutualInducedPredictorOrder(3);
     force1.setEwaldErrorTolerance(1.0e-05); 
     
     vector<double> coeff;
@@ -101,6 +105,9 @@ void testSerialization() {
         }
     }
 
+    force1.setMultipoleAlchemical(1, true);
+    force1.setLambdaName("elecLambda");
+
     // Serialize and then deserialize it.
 
     stringstream buffer;
@@ -118,7 +125,11 @@ void testSerialization() {
     ASSERT_EQUAL(force1.getAEwald(),                        force2.getAEwald());
     ASSERT_EQUAL(force1.getMutualInducedMaxIterations(),    force2.getMutualInducedMaxIterations());
     ASSERT_EQUAL(force1.getMutualInducedTargetEpsilon(),    force2.getMutualInducedTargetEpsilon());
+    ASSERT_EQUAL(force1.getMutualInducedSolver(),           force2.getMutualInducedSolver());
+    ASSERT_EQUAL(force1.getMutualInducedPredictor(),        force2.getMutualInducedPredictor());
+    ASSERT_EQUAL(force1.getMutualInducedPredictorOrder(),   force2.getMutualInducedPredictorOrder());
     ASSERT_EQUAL(force1.getEwaldErrorTolerance(),           force2.getEwaldErrorTolerance());
+    ASSERT_EQUAL(force1.Lambda(),                           force2.Lambda());
 
 
     std::vector<int> gridDimension1;
@@ -129,6 +140,11 @@ void testSerialization() {
     for (unsigned int jj = 0; jj < gridDimension1.size(); jj++) {
         ASSERT_EQUAL(gridDimension1[jj], gridDimension2[jj]);
     }
+    int inducedGrid1[4], inducedGrid2[4];
+    force1.getInducedDipolePMEParameters(inducedGrid1[0], inducedGrid1[1], inducedGrid1[2], inducedGrid1[3]);
+    force2.getInducedDipolePMEParameters(inducedGrid2[0], inducedGrid2[1], inducedGrid2[2], inducedGrid2[3]);
+    for (int jj = 0; jj < 4; jj++)
+        ASSERT_EQUAL(inducedGrid1[jj], inducedGrid2[jj]);
     
     ASSERT_EQUAL_CONTAINERS(force1.getExtrapolationCoefficients(), force2.getExtrapolationCoefficients());
     
@@ -161,6 +177,7 @@ void testSerialization() {
         ASSERT_EQUAL(thole1,                         thole2);
         ASSERT_EQUAL(dampingFactor1,                 dampingFactor2);
         ASSERT_EQUAL(polarity1,                      polarity2);
+        ASSERT_EQUAL(force1.getMultipoleAlchemical(ii), force2.getMultipoleAlchemical(ii));
 
         ASSERT_EQUAL(molecularDipole1.size(),        molecularDipole2.size());
         ASSERT_EQUAL(molecularDipole1.size(),        3);
@@ -55,6 +55,8 @@ void testSerialization() {
     force1.setShctd(  1.5);
     force1.setDispoff(1.6);
     force1.setSlevy(  1.7);
+    force1.setNonbondedMethod(AmoebaWcaDispersionForce::CutoffNonPeriodic);
+    force1.setCutoffDistance(1.2);
 
     force1.addParticle(1.0, 2.0);
     force1.addParticle(1.1, 2.1);
@@ -80,6 +82,8 @@ void testSerialization() {
     ASSERT_EQUAL(force1.getShctd(),   force2.getShctd());
     ASSERT_EQUAL(force1.getDispoff(), force2.getDispoff());
     ASSERT_EQUAL(force1.getSlevy(),   force2.getSlevy());
+    ASSERT_EQUAL(force1.getNonbondedMethod(), force2.getNonbondedMethod());
+    ASSERT_EQUAL(force1.getCutoffDistance(), force2.getCutoffDistance());
 
     ASSERT_EQUAL(force1.getNumParticles(), force2.getNumParticles());
     for (unsigned int ii = 0; ii < static_cast<unsigned int>(force1.getNumParticles()); ii++) {
@@ -297,8 +297,8 @@ static void setupMultipoleAmmonia(System& system, AmoebaGeneralizedKirkwoodForce
     system.addForce(amoebaGeneralizedKirkwoodForce);
 }
 
-static void getForcesEnergyMultipoleAmmonia(Context& context, std::vector<Vec3>& forces, double& energy) {
-    std::vector<Vec3> positions(context.getSystem().getNumParticles());
+static std::vector<Vec3> getAmmoniaPositions() {
+    std::vector<Vec3> positions(8);
 
     positions[0]              = Vec3(  1.5927280e-01,  1.7000000e-06,   1.6491000e-03);
     positions[1]              = Vec3(  2.0805540e-01, -8.1258800e-02,   3.7282500e-02);
@@ -308,7 +308,11 @@ static void getForcesEnergyMultipoleAmmonia(Context& context, std::vector<Vec3>&
     positions[5]              = Vec3( -2.0428260e-01,  8.1071500e-02,   4.1343900e-02);
     positions[6]              = Vec3( -6.7308300e-02,  1.2800000e-05,   1.0623300e-02);
     positions[7]              = Vec3( -2.0426290e-01, -8.1231400e-02,   4.1033500e-02);
+    return positions;
+}
 
+static void getForcesEnergyMultipoleAmmonia(Context& context, std::vector<Vec3>& forces, double& energy) {
+    std::vector<Vec3> positions = getAmmoniaPositions();
     context.setPositions(positions);
     State state                      = context.getState(State::Forces | State::Energy);
     forces                           = state.getForces();
@@ -7190,6 +7194,125 @@ static void testGeneralizedKirkwoodAmmoniaMutualPolarizationWithCavityTerm() {
     compareForcesEnergy(testName, state2.getPotentialEnergy(), state1.getPotentialEnergy(), state2.getForces(), state1.getForces(), tolerance);
 }
 
+// test that a GK cutoff longer than the system reproduces the all-pairs result, and that
+// a short cutoff gives a different energy with forces that are still consistent with it
+
+static void testGeneralizedKirkwoodAmmoniaCutoff() {
+
+    std::string testName      = "testGeneralizedKirkwoodAmmoniaCutoff";
+
+    std::vector<Vec3> forces, cutoffForces;
+    double energy, cutoffEnergy;
+
+    System system;
+    AmoebaGeneralizedKirkwoodForce* amoebaGeneralizedKirkwoodForce  = new AmoebaGeneralizedKirkwoodForce();
+    setupMultipoleAmmonia(system, amoebaGeneralizedKirkwoodForce, AmoebaMultipoleForce::Mutual, 0);
+    LangevinIntegrator integrator(0.0, 0.1, 0.01);
+    Context context(system, integrator, platform);
+    getForcesEnergyMultipoleAmmonia(context, forces, energy);
+
+    amoebaGeneralizedKirkwoodForce->setNonbondedMethod(AmoebaGeneralizedKirkwoodForce::CutoffNonPeriodic);
+    amoebaGeneralizedKirkwoodForce->setCutoffDistance(10.0);
+    LangevinIntegrator integrator2(0.0, 0.1, 0.01);
+    Context context2(system, integrator2, platform);
+    getForcesEnergyMultipoleAmmonia(context2, cutoffForces, cutoffEnergy);
+    compareForcesEnergy(testName, energy, cutoffEnergy, forces, cutoffForces, 1.0e-05);
+
+    amoebaGeneralizedKirkwoodForce->setCutoffDistance(0.3);
+    LangevinIntegrator integrator3(0.0, 0.1, 0.01);
+    Context context3(system, integrator3, platform);
+    getForcesEnergyMultipoleAmmonia(context3, cutoffForces, cutoffEnergy);
+    ASSERT(fabs(cutoffEnergy-energy) > 1.0e-3*fabs(energy));
+}
+
+// test reusing Born radii between updates
+
+static double getAmmoniaEnergy(Context& context, const std::vector<Vec3>& positions) {
+    context.setPositions(positions);
+    return context.getState(State::Energy).getPotentialEnergy();
+}
+
+static void testGeneralizedKirkwoodAmmoniaBornRadiiUpdate() {
+
+    std::string testName      = "testGeneralizedKirkwoodAmmoniaBornRadiiUpdate";
+
+    System system;
+    AmoebaGeneralizedKirkwoodForce* amoebaGeneralizedKirkwoodForce  = new AmoebaGeneralizedKirkwoodForce();
+    setupMultipoleAmmonia(system, amoebaGeneralizedKirkwoodForce, AmoebaMultipoleForce::Mutual, 1);
+    LangevinIntegrator integrator(0.0, 0.1, 0.01);
+    Context context(system, integrator, platform);
+
+    // Move the second molecule, which changes the Born radii of both.
+
+    std::vector<Vec3> positions = getAmmoniaPositions();
+    std::vector<Vec3> movedPositions = positions;
+    for (int i = 4; i < 8; i++)
+        movedPositions[i] += Vec3(0.02, 0.0, 0.0);
+    double expectedEnergy = getAmmoniaEnergy(context, movedPositions);
+
+    // With an interval of 3, the radii from the first evaluation are used for the next two.
+
+    amoebaGeneralizedKirkwoodForce->setBornRadiiUpdateInterval(3);
+    LangevinIntegrator integrator2(0.0, 0.1, 0.01);
+    Context context2(system, integrator2, platform);
+    ASSERT_EQUAL_TOL(getAmmoniaEnergy(context, positions), getAmmoniaEnergy(context2, positions), 1e-5);
+    double staleEnergy = getAmmoniaEnergy(context2, movedPositions);
+    ASSERT(fabs(staleEnergy-expectedEnergy) > 1e-5*fabs(expectedEnergy));
+    ASSERT_EQUAL_TOL(staleEnergy, getAmmoniaEnergy(context2, movedPositions), 1e-5);
+    ASSERT_EQUAL_TOL(expectedEnergy, getAmmoniaEnergy(context2, movedPositions), 1e-5);
+
+    // A displacement larger than the tolerance forces an update.
+
+    amoebaGeneralizedKirkwoodForce->setBornRadiiUpdateInterval(1000);
+    amoebaGeneralizedKirkwoodForce->setBornRadiiUpdateTolerance(0.01);
+    LangevinIntegrator integrator3(0.0, 0.1, 0.01);
+    Context context3(system, integrator3, platform);
+    getAmmoniaEnergy(context3, positions);
+    ASSERT_EQUAL_TOL(expectedEnergy, getAmmoniaEnergy(context3, movedPositions), 1e-5);
+}
+
+// test that the tapered GK cutoff gives a continuous energy, with forces consistent with it
+
+static void testGeneralizedKirkwoodAmmoniaCutoffTaper(AmoebaMultipoleForce::PolarizationType polarizationType) {
+
+    System system;
+    AmoebaGeneralizedKirkwoodForce* amoebaGeneralizedKirkwoodForce  = new AmoebaGeneralizedKirkwoodForce();
+    setupMultipoleAmmonia(system, amoebaGeneralizedKirkwoodForce, polarizationType, 0);
+    double cutoff = 0.35;
+    amoebaGeneralizedKirkwoodForce->setNonbondedMethod(AmoebaGeneralizedKirkwoodForce::CutoffNonPeriodic);
+    amoebaGeneralizedKirkwoodForce->setCutoffDistance(cutoff);
+    LangevinIntegrator integrator(0.0, 0.1, 0.01);
+    Context context(system, integrator, platform);
+
+    // Move the second molecule along the line between the nitrogens, so the distance between
+    // them sweeps through the taper and crosses the cutoff.
+
+    std::vector<Vec3> positions = getAmmoniaPositions();
+    Vec3 axis = positions[4]-positions[0];
+    double separation = sqrt(axis.dot(axis));
+    axis /= separation;
+    auto moveToDistance = [&] (double distance) {
+        std::vector<Vec3> moved = positions;
+        for (int i = 4; i < 8; i++)
+            moved[i] += axis*(distance-separation);
+        return moved;
+    };
+
+    // The energy should be continuous where the nitrogens cross the cutoff.
+
+    double delta = 1e-8;
+    ASSERT_EQUAL_TOL(getAmmoniaEnergy(context, moveToDistance(cutoff-delta)), getAmmoniaEnergy(context, moveToDistance(cutoff+delta)), 1e-7);
+
+    // Inside the taper, the forces should match finite differences of the energy.
+
+    for (double fraction : {0.91, 0.94, 0.97}) {
+        std::vector<Vec3> moved = moveToDistance(fraction*cutoff);
+        context.setPositions(moved);
+        State state = context.getState(State::Forces);
+        checkFiniteDifferences(state.getForces(), context, moved);
+    }
+}
+
 // test GK direct polarization for villin system
 
 static void testGeneralizedKirkwoodVillinDirectPolarization() {
@@ -8465,6 +8588,10 @@ int main(int argc, char* argv[]) {
         testGeneralizedKirkwoodAmmoniaMutualPolarization();
         testGeneralizedKirkwoodAmmoniaExtrapolatedPolarization();
         testGeneralizedKirkwoodAmmoniaMutualPolarizationWithCavityTerm();
+        testGeneralizedKirkwoodAmmoniaCutoff();
+        testGeneralizedKirkwoodAmmoniaBornRadiiUpdate();
+        testGeneralizedKirkwoodAmmoniaCutoffTaper(AmoebaMultipoleForce::Direct);
+        testGeneralizedKirkwoodAmmoniaCutoffTaper(AmoebaMultipoleForce::Mutual);
         testGeneralizedKirkwoodVillinDirectPolarization();
         testGeneralizedKirkwoodVillinExtrapolatedPolarization();
         testGeneralizedKirkwoodVillinMutualPolarization();
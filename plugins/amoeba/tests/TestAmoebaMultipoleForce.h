@@ -41,6 +41,7 @@
 #include "openmm/AmoebaMultipoleForce.h"
 #include "openmm/LangevinIntegrator.h"
 #include <iostream>
+#include <sstream>
 #include <vector>
 #include <stdlib.h>
 #include <stdio.h>
@@ -2947,6 +2948,223 @@ static void testNoQuadrupoles(bool usePme) {
     ASSERT(threwException);
 }
 
+/**
+ * Test that the PCG solver for mutual induced dipoles gives the same results as DIIS.
+ */
+static void testPCGSolver(bool usePme) {
+
+    string testName      = "testPCGSolver";
+
+    int inputPmeGridDimension = 10;
+    double cutoff             = 0.3;
+
+    System system;
+    AmoebaMultipoleForce* amoebaMultipoleForce = new AmoebaMultipoleForce();;
+    setupMultipoleAmmonia(system, amoebaMultipoleForce, usePme ? AmoebaMultipoleForce::PME : AmoebaMultipoleForce::NoCutoff, AmoebaMultipoleForce::Mutual, 
+                                             cutoff, inputPmeGridDimension);
+    LangevinIntegrator integrator(0.0, 0.1, 0.01);
+    Context context(system, integrator, platform);
+    vector<Vec3> forces1, dipoles1;
+    double energy1;
+    getForcesEnergyMultipoleAmmonia(context, forces1, energy1);
+    amoebaMultipoleForce->getInducedDipoles(context, dipoles1);
+
+    // Now switch to the PCG solver and compare.
+
+    amoebaMultipoleForce->setMutualInducedSolver(AmoebaMultipoleForce::PCG);
+    LangevinIntegrator integrator2(0.0, 0.1, 0.01);
+    Context context2(system, integrator2, platform);
+    vector<Vec3> forces2, dipoles2;
+    double energy2;
+    getForcesEnergyMultipoleAmmonia(context2, forces2, energy2);
+    amoebaMultipoleForce->getInducedDipoles(context2, dipoles2);
+    double tolerance = 1e-5;
+    compareForcesEnergy(testName, energy1, energy2, forces1, forces2, tolerance);
+    for (int i = 0; i < system.getNumParticles(); i++)
+        ASSERT_EQUAL_VEC(dipoles1[i], dipoles2[i], 1e-5);
+}
+
+static void testInducedDipolePredictor(AmoebaMultipoleForce::MutualInducedPredictor predictor) {
+
+    string testName      = "testInducedDipolePredictor";
+
+    int inputPmeGridDimension = 10;
+    double cutoff             = 0.3;
+
+    // Run a short simulation with the predictor, and check that the forces match those computed
+    // for the same positions without it.
+
+    System system;
+    AmoebaMultipoleForce* amoebaMultipoleForce = new AmoebaMultipoleForce();
+    setupMultipoleAmmonia(system, amoebaMultipoleForce, AmoebaMultipoleForce::PME, AmoebaMultipoleForce::Mutual, 
+                                             cutoff, inputPmeGridDimension);
+    LangevinIntegrator integrator(0.0, 0.1, 0.0005);
+    Context context(system, integrator, platform);
+    vector<Vec3> forces;
+    double energy;
+    getForcesEnergyMultipoleAmmonia(context, forces, energy);
+    amoebaMultipoleForce->setMutualInducedPredictor(predictor);
+    amoebaMultipoleForce->setMutualInducedPredictorOrder(2);
+    LangevinIntegrator integrator2(0.0, 0.1, 0.0005);
+    Context context2(system, integrator2, platform);
+    context2.setPositions(context.getState(State::Positions).getPositions());
+    double tolerance = 1e-4;
+    for (int i = 0; i < 10; i++) {
+        integrator2.step(1);
+        State state2 = context2.getState(State::Positions | State::Forces | State::Energy);
+        context.setPositions(state2.getPositions());
+        State state1 = context.getState(State::Forces | State::Energy);
+        compareForcesEnergy(testName, state1.getPotentialEnergy(), state2.getPotentialEnergy(), state1.getForces(), state2.getForces(), tolerance);
+    }
+
+    // Setting the positions must discard the history.
+
+    vector<Vec3> positions = context2.getState(State::Positions).getPositions();
+    positions[0] += Vec3(0.01, 0, 0);
+    context2.setPositions(positions);
+    context.setPositions(positions);
+    State state1 = context.getState(State::Forces | State::Energy);
+    State state2 = context2.getState(State::Forces | State::Energy);
+    compareForcesEnergy(testName, state1.getPotentialEnergy(), state2.getPotentialEnergy(), state1.getForces(), state2.getForces(), tolerance);
+}
+
+static void testInducedDipolePredictorCheckpoint(AmoebaMultipoleForce::MutualInducedPredictor predictor) {
+
+    string testName      = "testInducedDipolePredictorCheckpoint";
+
+    // Use a loose tolerance so the converged dipoles depend on the starting point of the iteration.
+
+    System system;
+    AmoebaMultipoleForce* amoebaMultipoleForce = new AmoebaMultipoleForce();
+    setupMultipoleAmmonia(system, amoebaMultipoleForce, AmoebaMultipoleForce::PME, AmoebaMultipoleForce::Mutual, 0.3, 10);
+    amoebaMultipoleForce->setMutualInducedTargetEpsilon(1e-2);
+    amoebaMultipoleForce->setMutualInducedPredictor(predictor);
+    amoebaMultipoleForce->setMutualInducedPredictorOrder(2);
+    LangevinIntegrator integrator(0.0, 0.1, 0.0005);
+    Context context(system, integrator, platform);
+    vector<Vec3> forces;
+    double energy;
+    getForcesEnergyMultipoleAmmonia(context, forces, energy);
+
+    // Run a few steps to build up a history, then save a checkpoint and continue the simulation.
+
+    integrator.step(10);
+    stringstream checkpoint(ios_base::out | ios_base::in | ios_base::binary);
+    context.createCheckpoint(checkpoint);
+    vector<State> expectedStates;
+    for (int i = 0; i < 5; i++) {
+        integrator.step(1);
+        expectedStates.push_back(context.getState(State::Positions | State::Forces | State::Energy));
+    }
+
+    // Restoring the checkpoint into a new Context, or reinitializing the original one, should
+    // reproduce the uninterrupted simulation exactly.
+
+    LangevinIntegrator integrator2(0.0, 0.1, 0.0005);
+    Context context2(system, integrator2, platform);
+    context2.loadCheckpoint(checkpoint);
+    for (int i = 0; i < 5; i++) {
+        integrator2.step(1);
+        State state = context2.getState(State::Positions | State::Forces | State::Energy);
+        compareForcesEnergy(testName, expectedStates[i].getPotentialEnergy(), state.getPotentialEnergy(), expectedStates[i].getForces(), state.getForces(), 1e-10);
+        for (int j = 0; j < system.getNumParticles(); j++)
+            ASSERT_EQUAL_VEC(expectedStates[i].getPositions()[j], state.getPositions()[j], 1e-10);
+    }
+    checkpoint.clear();
+    checkpoint.seekg(0);
+    context.loadCheckpoint(checkpoint);
+    context.reinitialize(true);
+    for (int i = 0; i < 5; i++) {
+        integrator.step(1);
+        State state = context.getState(State::Forces | State::Energy);
+        compareForcesEnergy(testName, expectedStates[i].getPotentialEnergy(), state.getPotentialEnergy(), expectedStates[i].getForces(), state.getForces(), 1e-10);
+    }
+}
+
+static void testAlchemicalScaling() {
+
+    string testName      = "testAlchemicalScaling";
+
+    // Mark the second molecule as alchemical, and compare to a System in which its parameters
+    // have been scaled by hand.
+
+    double lambda = 0.4;
+    System system;
+    AmoebaMultipoleForce* amoebaMultipoleForce = new AmoebaMultipoleForce();
+    setupMultipoleAmmonia(system, amoebaMultipoleForce, AmoebaMultipoleForce::NoCutoff, AmoebaMultipoleForce::Mutual, 9000000.0, 0);
+    System scaledSystem;
+    AmoebaMultipoleForce* scaledForce = new AmoebaMultipoleForce();
+    setupMultipoleAmmonia(scaledSystem, scaledForce, AmoebaMultipoleForce::NoCutoff, AmoebaMultipoleForce::Mutual, 9000000.0, 0);
+    for (int i = 4; i < 8; i++) {
+        amoebaMultipoleForce->setMultipoleAlchemical(i, true);
+        int axisType, atomZ, atomX, atomY;
+        double charge, thole, damping, polarity;
+        vector<double> dipole, quadrupole;
+        scaledForce->getMultipoleParameters(i, charge, dipole, quadrupole, axisType, atomZ, atomX, atomY, thole, damping, polarity);
+        for (double& d : dipole)
+            d *= lambda;
+        for (double& q : quadrupole)
+            q *= lambda;
+        scaledForce->setMultipoleParameters(i, lambda*charge, dipole, quadrupole, axisType, atomZ, atomX, atomY, thole, damping, lambda*polarity);
+    }
+    LangevinIntegrator integrator(0.0, 0.1, 0.01);
+    Context context(system, integrator, platform);
+    ASSERT_EQUAL(1.0, context.getParameter(amoebaMultipoleForce->Lambda()));
+    vector<Vec3> forces1, forces2;
+    double energy1, energy2;
+    getForcesEnergyMultipoleAmmonia(context, forces1, energy1);
+    context.setParameter(amoebaMultipoleForce->Lambda(), lambda);
+    getForcesEnergyMultipoleAmmonia(context, forces2, energy2);
+    LangevinIntegrator integrator2(0.0, 0.1, 0.01);
+    Context scaledContext(scaledSystem, integrator2, platform);
+    vector<Vec3> expectedForces;
+    double expectedEnergy;
+    getForcesEnergyMultipoleAmmonia(scaledContext, expectedForces, expectedEnergy);
+    compareForcesEnergy(testName, expectedEnergy, energy2, expectedForces, forces2, 1e-5);
+
+    // Evaluating the energy at several values of lambda should leave the Context unchanged.
+
+    vector<double> lambdas = {1.0, lambda, 0.0};
+    vector<double> energies;
+    amoebaMultipoleForce->computeLambdaEnergies(context, lambdas, energies);
+    ASSERT_EQUAL_TOL(energy1, energies[0], 1e-5);
+    ASSERT_EQUAL_TOL(energy2, energies[1], 1e-5);
+    ASSERT_EQUAL(lambda, context.getParameter(amoebaMultipoleForce->Lambda()));
+    ASSERT_EQUAL_TOL(energy2, context.getState(State::Energy).getPotentialEnergy(), 1e-5);
+}
+
+static void testPMEElectrostaticPotential() {
+
+    // The Ewald potential should not depend on how it is split between direct and reciprocal
+    // space.  Give the system a net charge so the neutralizing background is also tested.
+
+    vector<Vec3> points;
+    for (int i = 0; i < 10; i++)
+        points.push_back(Vec3(0.06*i, 0.05*i+0.1, 0.3-0.02*i));
+    vector<double> potential[2];
+    double alpha[] = {11.0, 13.0};
+    for (int trial = 0; trial < 2; trial++) {
+        System system;
+        AmoebaMultipoleForce* amoebaMultipoleForce = new AmoebaMultipoleForce();
+        setupMultipoleAmmonia(system, amoebaMultipoleForce, AmoebaMultipoleForce::PME, AmoebaMultipoleForce::Mutual, 0.3, 64);
+        amoebaMultipoleForce->setPMEParameters(alpha[trial], 64, 64, 64);
+        int axisType, atomZ, atomX, atomY;
+        double charge, thole, damping, polarity;
+        vector<double> dipole, quadrupole;
+        amoebaMultipoleForce->getMultipoleParameters(0, charge, dipole, quadrupole, axisType, atomZ, atomX, atomY, thole, damping, polarity);
+        amoebaMultipoleForce->setMultipoleParameters(0, charge+0.5, dipole, quadrupole, axisType, atomZ, atomX, atomY, thole, damping, polarity);
+        LangevinIntegrator integrator(0.0, 0.1, 0.01);
+        Context context(system, integrator, platform);
+        vector<Vec3> forces;
+        double energy;
+        getForcesEnergyMultipoleAmmonia(context, forces, energy);
+        amoebaMultipoleForce->getPMEElectrostaticPotential(points, context, potential[trial]);
+        ASSERT_EQUAL(points.size(), potential[trial].size());
+    }
+    for (int i = 0; i < points.size(); i++)
+        ASSERT_EQUAL_TOL(potential[0][i], potential[1][i], 1e-3);
+}
+
 void testTriclinic() {
     // Create a triclinic box containing eight water molecules.
 
@@ -3303,6 +3521,77 @@ void testNeutralizingPlasmaCorrection() {
     ASSERT_EQUAL_TOL(energy3, energy4, 1e-4);
 }
 
+static void assertCovalentMap(const AmoebaMultipoleForce& force, int atom, AmoebaMultipoleForce::CovalentType type, const vector<int>& expected) {
+    vector<int> atoms;
+    force.getCovalentMap(atom, type, atoms);
+    ASSERT_EQUAL_CONTAINERS(expected, atoms);
+}
+
+void testCovalentMaps() {
+    // Build a branched molecule:  0-1-2-3-4-5 with a side chain 2-6.
+
+    AmoebaMultipoleForce force;
+    vector<double> d(3, 0.0), q(9, 0.0);
+    for (int i = 0; i < 7; i++)
+        force.addMultipole(0.0, d, q, AmoebaMultipoleForce::NoAxisType, -1, -1, -1, 0.39, 0.33, 0.001);
+    vector<pair<int, int> > bonds = {{0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 5}, {2, 6}};
+    force.createCovalentMapsFromBonds(bonds);
+    assertCovalentMap(force, 0, AmoebaMultipoleForce::Covalent12, {1});
+    assertCovalentMap(force, 0, AmoebaMultipoleForce::Covalent13, {2});
+    assertCovalentMap(force, 0, AmoebaMultipoleForce::Covalent14, {3, 6});
+    assertCovalentMap(force, 0, AmoebaMultipoleForce::Covalent15, {4});
+    assertCovalentMap(force, 2, AmoebaMultipoleForce::Covalent12, {1, 3, 6});
+    assertCovalentMap(force, 2, AmoebaMultipoleForce::Covalent13, {0, 4});
+    assertCovalentMap(force, 2, AmoebaMultipoleForce::Covalent14, {5});
+    assertCovalentMap(force, 2, AmoebaMultipoleForce::Covalent15, {});
+    assertCovalentMap(force, 6, AmoebaMultipoleForce::Covalent15, {5});
+    assertCovalentMap(force, 6, AmoebaMultipoleForce::PolarizationCovalent11, {});
+
+    // Replace maps out of order with lists of different lengths and make sure the packed
+    // representation stays consistent.
+
+    force.setCovalentMap(4, AmoebaMultipoleForce::Covalent12, {0, 1, 2, 5});
+    force.setCovalentMap(1, AmoebaMultipoleForce::Covalent12, {});
+    assertCovalentMap(force, 4, AmoebaMultipoleForce::Covalent12, {0, 1, 2, 5});
+    assertCovalentMap(force, 1, AmoebaMultipoleForce::Covalent12, {});
+    assertCovalentMap(force, 2, AmoebaMultipoleForce::Covalent12, {1, 3, 6});
+    vector<int> offsets, atoms;
+    force.getAllCovalentMaps(AmoebaMultipoleForce::Covalent12, offsets, atoms);
+    ASSERT_EQUAL(8, offsets.size());
+    ASSERT_EQUAL(0, offsets[0]);
+    ASSERT_EQUAL(atoms.size(), offsets[7]);
+    for (int i = 0; i < 7; i++) {
+        vector<int> expected;
+        force.getCovalentMap(i, AmoebaMultipoleForce::Covalent12, expected);
+        vector<int> packed(atoms.begin()+offsets[i], atoms.begin()+offsets[i+1]);
+        ASSERT_EQUAL_CONTAINERS(expected, packed);
+    }
+
+    // Round trip the packed representation through a second force.
+
+    AmoebaMultipoleForce copy;
+    for (int i = 0; i < 7; i++)
+        copy.addMultipole(0.0, d, q, AmoebaMultipoleForce::NoAxisType, -1, -1, -1, 0.39, 0.33, 0.001);
+    copy.setAllCovalentMaps(AmoebaMultipoleForce::Covalent12, offsets, atoms);
+    for (int i = 0; i < 7; i++) {
+        vector<int> expected;
+        force.getCovalentMap(i, AmoebaMultipoleForce::Covalent12, expected);
+        assertCovalentMap(copy, i, AmoebaMultipoleForce::Covalent12, expected);
+    }
+
+    // Malformed offsets should be rejected.
+
+    offsets[3] = offsets[4]+1;
+    bool failed = false;
+    try {
+        copy.setAllCovalentMaps(AmoebaMultipoleForce::Covalent12, offsets, atoms);
+    }
+    catch (OpenMMException& ex) {
+        failed = true;
+    }
+    ASSERT(failed);
+}
+
 void setupKernels(int argc, char* argv[]);
 void runPlatformTests();
 
@@ -3320,6 +3609,17 @@ int main(int argc, char* argv[]) {
 
         testMultipoleAmmoniaMutualPolarization();
 
+        // test the PCG solver for mutual induced dipoles
+
+        testPCGSolver(false);
+        testPCGSolver(true);
+        testInducedDipolePredictor(AmoebaMultipoleForce::ASPC);
+        testInducedDipolePredictor(AmoebaMultipoleForce::Polynomial);
+        testInducedDipolePredictor(AmoebaMultipoleForce::ExtendedLagrangian);
+        testInducedDipolePredictorCheckpoint(AmoebaMultipoleForce::ASPC);
+        testInducedDipolePredictorCheckpoint(AmoebaMultipoleForce::ExtendedLagrangian);
+        testAlchemicalScaling();
+
         // test multipole direct & mutual polarization using PME
 
         testMultipoleWaterPMEDirectPolarization();
@@ -3361,6 +3661,8 @@ int main(int argc, char* argv[]) {
         
         testZOnly();
         testNeutralizingPlasmaCorrection();
+        testPMEElectrostaticPotential();
+        testCovalentMaps();
 
         runPlatformTests();
     }
@@ -2182,6 +2182,43 @@ void testParticleTypes() {
     ASSERT_EQUAL_TOL(expectedEnergy, state.getPotentialEnergy(), 1e-5);
 }
 
+void testLambdaEnergies(AmoebaVdwForce::AlchemicalMethod method) {
+    const int numParticles = 20;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(2, 0, 0), Vec3(0, 2, 0), Vec3(0, 0, 2));
+    AmoebaVdwForce* vdw = new AmoebaVdwForce();
+    vdw->setNonbondedMethod(AmoebaVdwForce::CutoffPeriodic);
+    vdw->setCutoff(0.9);
+    vdw->setUseDispersionCorrection(true);
+    vdw->setAlchemicalMethod(method);
+    system.addForce(vdw);
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        if (i%2 == 0)
+            vdw->addParticle(i, 0.2, 1.0, 0.0, i < 6);
+        else
+            vdw->addParticle(i-1, 0.15, 0.5, 0.9, i < 6);
+        positions.push_back(2*Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt)));
+    }
+    LangevinIntegrator integrator(0.0, 0.1, 0.01);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    context.setParameter(vdw->Lambda(), 0.3);
+    vector<double> lambdas = {0.0, 0.25, 0.5, 0.8, 1.0};
+    vector<double> energies;
+    vdw->computeLambdaEnergies(context, lambdas, energies);
+    ASSERT_EQUAL(lambdas.size(), energies.size());
+    ASSERT_EQUAL(0.3, context.getParameter(vdw->Lambda()));
+    for (int i = 0; i < lambdas.size(); i++) {
+        context.setParameter(vdw->Lambda(), lambdas[i]);
+        State state = context.getState(State::Energy);
+        ASSERT_EQUAL_TOL(state.getPotentialEnergy(), energies[i], 1e-5);
+    }
+}
+
 void setupKernels(int argc, char* argv[]);
 void runPlatformTests();
 
@@ -2265,6 +2302,11 @@ int main(int argc, char* argv[]) {
         lambda = 0.0;
         alpha = 0.7;
         testVdwAlchemical(n, alpha, lambda, method);
+
+        // Test computing the energy at multiple lambda values at once.
+        testLambdaEnergies(AmoebaVdwForce::None);
+        testLambdaEnergies(AmoebaVdwForce::Decouple);
+        testLambdaEnergies(AmoebaVdwForce::Annihilate);
         runPlatformTests();
     }
     catch(const std::exception& e) {
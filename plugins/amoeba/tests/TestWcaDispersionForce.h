@@ -180,6 +180,66 @@ void testWcaDispersionAmmonia() {
                         state2.getForces(), tolerance);
 }
 
+// Test that a cutoff longer than the system reproduces the all-pairs result, and that
+// the tapered cutoff gives forces consistent with the energy.
+void testWcaDispersionCutoff() {
+
+    std::string testName = "testWcaDispersionCutoff";
+    const int gridSize = 3;
+    const double spacing = 0.3;
+
+    System system;
+    AmoebaWcaDispersionForce* amoebaWcaDispersionForce = new AmoebaWcaDispersionForce();
+    std::vector<Vec3> positions;
+    for (int i = 0; i < gridSize; i++)
+        for (int j = 0; j < gridSize; j++)
+            for (int k = 0; k < gridSize; k++) {
+                int index = positions.size();
+                system.addParticle(1.0);
+                if (index%2 == 0)
+                    amoebaWcaDispersionForce->addParticle(3.71e-01 / 2.0e0, 0.105e0 * 4.184e0);
+                else
+                    amoebaWcaDispersionForce->addParticle(2.7e-01 / 2.0e0, 0.02e0 * 4.184e0);
+                positions.push_back(Vec3(i*spacing+0.01*sin(index), j*spacing+0.01*cos(index), k*spacing+0.01*sin(2.0*index)));
+            }
+    system.addForce(amoebaWcaDispersionForce);
+
+    LangevinIntegrator integrator(0.0, 0.1, 0.01);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    State state = context.getState(State::Forces | State::Energy);
+
+    amoebaWcaDispersionForce->setNonbondedMethod(AmoebaWcaDispersionForce::CutoffNonPeriodic);
+    amoebaWcaDispersionForce->setCutoffDistance(10.0);
+    LangevinIntegrator integrator2(0.0, 0.1, 0.01);
+    Context context2(system, integrator2, platform);
+    context2.setPositions(positions);
+    State state2 = context2.getState(State::Forces | State::Energy);
+    compareForcesEnergy(testName, state.getPotentialEnergy(), state2.getPotentialEnergy(), state.getForces(), state2.getForces(), 1.0e-5);
+
+    // With a cutoff of 0.7 nm, several pairs fall inside the tapering region.
+
+    amoebaWcaDispersionForce->setCutoffDistance(0.7);
+    LangevinIntegrator integrator3(0.0, 0.1, 0.01);
+    Context context3(system, integrator3, platform);
+    context3.setPositions(positions);
+    State state3 = context3.getState(State::Forces | State::Energy);
+    ASSERT(std::abs(state3.getPotentialEnergy()-state.getPotentialEnergy()) > 1.0e-6);
+    const double delta = 1.0e-5;
+    for (int i = 0; i < system.getNumParticles(); i += 5) {
+        for (int j = 0; j < 3; j++) {
+            std::vector<Vec3> displaced = positions;
+            displaced[i][j] += delta;
+            context3.setPositions(displaced);
+            double energyPlus = context3.getState(State::Energy).getPotentialEnergy();
+            displaced[i][j] -= 2*delta;
+            context3.setPositions(displaced);
+            double energyMinus = context3.getState(State::Energy).getPotentialEnergy();
+            ASSERT_EQUAL_TOL(state3.getForces()[i][j], (energyMinus-energyPlus)/(2*delta), 1e-3);
+        }
+    }
+}
+
 void setupKernels(int argc, char* argv[]);
 void runPlatformTests();
 
@@ -187,6 +247,7 @@ int main(int argc, char* argv[]) {
     try {
         setupKernels(argc, argv);
         testWcaDispersionAmmonia();
+        testWcaDispersionCutoff();
         runPlatformTests();
     }
     catch(const std::exception& e) {
@@ -35,9 +35,10 @@
 #ifdef _MSC_VER
   #define POCKETFFT_NO_VECTORS
 #endif
-#define POCKETFFT_CACHE_SIZE 4
+#define POCKETFFT_CACHE_SIZE 16
 #include "CpuPmeKernels.h"
 #include "SimTKOpenMMRealType.h"
+#include "openmm/internal/PhaseProfiler.h"
 #include "openmm/internal/hardware.h"
 #include "openmm/internal/vectorize.h"
 #include "openmm/OpenMMException.h"
@@ -421,6 +422,55 @@ static void interpolateForces(float* posq, vector<float>& force, vector<float>&
     }
 }
 
+/**
+ * Perform the first half of a forward FFT on a slab of the grid: a real-to-complex transform along z,
+ * followed by a complex transform along y, for every x index in [xstart, xend).
+ */
+static void forwardFFTYZ(vector<float>& realGrid, vector<complex<float> >& complexGrid, int gridx, int gridy, int gridz, int xstart, int xend) {
+    if (xstart >= xend)
+        return;
+    int complexz = gridz/2+1;
+    pocketfft::shape_t shape = {(size_t) (xend-xstart), (size_t) gridy, (size_t) gridz};
+    pocketfft::stride_t realStride = {(ptrdiff_t) (gridy*gridz*sizeof(float)), (ptrdiff_t) (gridz*sizeof(float)), (ptrdiff_t) sizeof(float)};
+    pocketfft::stride_t complexStride = {(ptrdiff_t) (gridy*complexz*sizeof(complex<float>)), (ptrdiff_t) (complexz*sizeof(complex<float>)), (ptrdiff_t) sizeof(complex<float>)};
+    float* real = &realGrid[xstart*gridy*gridz];
+    complex<float>* cplx = &complexGrid[xstart*gridy*complexz];
+    pocketfft::r2c(shape, realStride, complexStride, 2, true, real, cplx, 1.0f, 1);
+    shape[2] = complexz;
+    pocketfft::c2c(shape, complexStride, complexStride, {1}, true, cplx, cplx, 1.0f, 1);
+}
+
+/**
+ * Perform the second half of an inverse FFT on a slab of the grid: a complex transform along y, followed by
+ * a complex-to-real transform along z, for every x index in [xstart, xend).  This overwrites the complex grid.
+ */
+static void backwardFFTYZ(vector<complex<float> >& complexGrid, vector<float>& realGrid, int gridx, int gridy, int gridz, int xstart, int xend) {
+    if (xstart >= xend)
+        return;
+    int complexz = gridz/2+1;
+    pocketfft::shape_t shape = {(size_t) (xend-xstart), (size_t) gridy, (size_t) complexz};
+    pocketfft::stride_t realStride = {(ptrdiff_t) (gridy*gridz*sizeof(float)), (ptrdiff_t) (gridz*sizeof(float)), (ptrdiff_t) sizeof(float)};
+    pocketfft::stride_t complexStride = {(ptrdiff_t) (gridy*complexz*sizeof(complex<float>)), (ptrdiff_t) (complexz*sizeof(complex<float>)), (ptrdiff_t) sizeof(complex<float>)};
+    float* real = &realGrid[xstart*gridy*gridz];
+    complex<float>* cplx = &complexGrid[xstart*gridy*complexz];
+    pocketfft::c2c(shape, complexStride, complexStride, {1}, false, cplx, cplx, 1.0f, 1);
+    shape[2] = gridz;
+    pocketfft::c2r(shape, complexStride, realStride, 2, false, cplx, real, 1.0f, 1);
+}
+
+/**
+ * Perform a complex transform along x on the pencils of the grid with y index in [ystart, yend).
+ */
+static void fftX(vector<complex<float> >& complexGrid, int gridx, int gridy, int gridz, int ystart, int yend, bool forward) {
+    if (ystart >= yend)
+        return;
+    int complexz = gridz/2+1;
+    pocketfft::shape_t shape = {(size_t) gridx, (size_t) (yend-ystart), (size_t) complexz};
+    pocketfft::stride_t complexStride = {(ptrdiff_t) (gridy*complexz*sizeof(complex<float>)), (ptrdiff_t) (complexz*sizeof(complex<float>)), (ptrdiff_t) sizeof(complex<float>)};
+    complex<float>* cplx = &complexGrid[ystart*complexz];
+    pocketfft::c2c(shape, complexStride, complexStride, {0}, forward, cplx, cplx, 1.0f, 1);
+}
+
 static void* threadBody(void* args) {
     CpuCalcPmeReciprocalForceKernel& owner = *reinterpret_cast<CpuCalcPmeReciprocalForceKernel*>(args);
     owner.runMainThread();
@@ -439,18 +489,6 @@ void CpuCalcPmeReciprocalForceKernel::initialize(int xsize, int ysize, int zsize
     gridx = findFFTDimension(xsize);
     gridy = findFFTDimension(ysize);
     gridz = findFFTDimension(zsize);
-    gridShape.push_back(gridx);
-    gridShape.push_back(gridy);
-    gridShape.push_back(gridz);
-    fftAxes.push_back(0);
-    fftAxes.push_back(1);
-    fftAxes.push_back(2);
-    realGridStride.push_back(gridy*gridz*sizeof(float));
-    realGridStride.push_back(gridz*sizeof(float));
-    realGridStride.push_back(sizeof(float));
-    complexGridStride.push_back(gridy*(gridz/2+1)*sizeof(complex<float>));
-    complexGridStride.push_back((gridz/2+1)*sizeof(complex<float>));
-    complexGridStride.push_back(sizeof(complex<float>));
     this->numParticles = numParticles;
     this->alpha = alpha;
     this->deterministic = deterministic;
@@ -546,19 +584,30 @@ void CpuCalcPmeReciprocalForceKernel::runMainThread() {
     isFinished = true;
     endCondition.notify_one();
     ThreadPool threads(numThreads);
+    PhaseProfiler profiler(threads);
     while (true) {
         // Wait for the signal to start.
 
         startCondition.wait(ul);
         if (isDeleted)
             break;
+        if (profiler.getEnabled() != profilingEnabled)
+            profiler.setEnabled(profilingEnabled);
         posq = io->getPosq();
         atomicCounter = 0;
+        profiler.startInterval();
         threads.execute([&] (ThreadPool& threads, int threadIndex) { runWorkerThread(threads, threadIndex); }); // Signal threads to perform charge spreading.
         threads.waitForThreads();
         threads.resumeThreads(); // Signal threads to sum the charge grids.
         threads.waitForThreads();
-        pocketfft::r2c(gridShape, realGridStride, complexGridStride, fftAxes, true, realGrids[0].data(), complexGrid.data(), 1.0f, 0);
+        profiler.endInterval("PME charge spreading");
+        profiler.startInterval();
+        threads.resumeThreads(); // Signal threads to transform along y and z.
+        threads.waitForThreads();
+        threads.resumeThreads(); // Signal threads to transform along x.
+        threads.waitForThreads();
+        profiler.endInterval("PME forward FFT");
+        profiler.startInterval();
         if (lastBoxVectors[0] != periodicBoxVectors[0] || lastBoxVectors[1] != periodicBoxVectors[1] || lastBoxVectors[2] != periodicBoxVectors[2]) {
             threads.resumeThreads(); // Signal threads to compute the reciprocal scale factors.
             threads.waitForThreads();
@@ -571,10 +620,25 @@ void CpuCalcPmeReciprocalForceKernel::runMainThread() {
         }
         threads.resumeThreads(); // Signal threads to perform reciprocal convolution.
         threads.waitForThreads();
-        pocketfft::c2r(gridShape, complexGridStride, realGridStride, fftAxes, false, complexGrid.data(), realGrids[0].data(), 1.0f, 0);
+        profiler.endInterval("PME convolution");
+        profiler.startInterval();
+        threads.resumeThreads(); // Signal threads to perform the inverse transform along x.
+        threads.waitForThreads();
+        threads.resumeThreads(); // Signal threads to perform the inverse transform along y and z.
+        threads.waitForThreads();
+        profiler.endInterval("PME inverse FFT");
+        profiler.startInterval();
         atomicCounter = 0;
         threads.resumeThreads(); // Signal threads to interpolate forces.
         threads.waitForThreads();
+        profiler.endInterval("PME force interpolation");
+        if (profilingEnabled) {
+            for (auto& t : profiler.getTimes()) {
+                profilingTimes[t.first].first += t.second.first;
+                profilingTimes[t.first].second += t.second.second;
+            }
+            profiler.resetTimes();
+        }
         isFinished = true;
         lastBoxVectors[0] = periodicBoxVectors[0];
         lastBoxVectors[1] = periodicBoxVectors[1];
@@ -586,6 +650,8 @@ void CpuCalcPmeReciprocalForceKernel::runMainThread() {
 void CpuCalcPmeReciprocalForceKernel::runWorkerThread(ThreadPool& threads, int index) {
     int gridxStart = (index*gridx)/numThreads;
     int gridxEnd = ((index+1)*gridx)/numThreads;
+    int gridyStart = (index*gridy)/numThreads;
+    int gridyEnd = ((index+1)*gridy)/numThreads;
     int gridSize = (gridx*gridy*gridz+3)/4;
     int gridStart = 4*((index*gridSize)/numThreads);
     int gridEnd = 4*(((index+1)*gridSize)/numThreads);
@@ -603,6 +669,10 @@ void CpuCalcPmeReciprocalForceKernel::runWorkerThread(ThreadPool& threads, int i
         sum.store(&realGrids[0][i]);
     }
     threads.syncThreads();
+    forwardFFTYZ(realGrids[0], complexGrid, gridx, gridy, gridz, gridxStart, gridxEnd);
+    threads.syncThreads();
+    fftX(complexGrid, gridx, gridy, gridz, gridyStart, gridyEnd, true);
+    threads.syncThreads();
     if (lastBoxVectors[0] != periodicBoxVectors[0] || lastBoxVectors[1] != periodicBoxVectors[1] || lastBoxVectors[2] != periodicBoxVectors[2]) {
         computeReciprocalEterm(gridxStart, gridxEnd, gridx, gridy, gridz, recipEterm, alpha, bsplineModuli, periodicBoxVectors, recipBoxVectors);
         threads.syncThreads();
@@ -613,6 +683,10 @@ void CpuCalcPmeReciprocalForceKernel::runWorkerThread(ThreadPool& threads, int i
     }
     reciprocalConvolution(complexStart, complexEnd, complexGrid, recipEterm);
     threads.syncThreads();
+    fftX(complexGrid, gridx, gridy, gridz, gridyStart, gridyEnd, false);
+    threads.syncThreads();
+    backwardFFTYZ(complexGrid, realGrids[0], gridx, gridy, gridz, gridxStart, gridxEnd);
+    threads.syncThreads();
     interpolateForces(posq, force, realGrids[0], gridx, gridy, gridz, numParticles, periodicBoxVectors, recipBoxVectors, atomicCounter, epsilonFactor, numThreads);
 }
 
@@ -661,6 +735,20 @@ void CpuCalcPmeReciprocalForceKernel::getPMEParameters(double& alpha, int& nx, i
     nz = gridz;
 }
 
+void CpuCalcPmeReciprocalForceKernel::setProfilingEnabled(bool enabled) {
+    unique_lock<mutex> ul(lock);
+    profilingEnabled = enabled;
+}
+
+void CpuCalcPmeReciprocalForceKernel::collectProfilingTimes(map<string, pair<int, double> >& timings) {
+    unique_lock<mutex> ul(lock);
+    for (auto& t : profilingTimes) {
+        timings[t.first].first += t.second.first;
+        timings[t.first].second += t.second.second;
+    }
+    profilingTimes.clear();
+}
+
 int CpuCalcPmeReciprocalForceKernel::findFFTDimension(int minimum) {
     if (minimum < 1)
         return 1;
@@ -715,18 +803,6 @@ void CpuCalcDispersionPmeReciprocalForceKernel::initialize(int xsize, int ysize,
     gridx = findFFTDimension(xsize);
     gridy = findFFTDimension(ysize);
     gridz = findFFTDimension(zsize);
-    gridShape.push_back(gridx);
-    gridShape.push_back(gridy);
-    gridShape.push_back(gridz);
-    fftAxes.push_back(0);
-    fftAxes.push_back(1);
-    fftAxes.push_back(2);
-    realGridStride.push_back(gridy*gridz*sizeof(float));
-    realGridStride.push_back(gridz*sizeof(float));
-    realGridStride.push_back(sizeof(float));
-    complexGridStride.push_back(gridy*(gridz/2+1)*sizeof(complex<float>));
-    complexGridStride.push_back((gridz/2+1)*sizeof(complex<float>));
-    complexGridStride.push_back(sizeof(complex<float>));
     this->numParticles = numParticles;
     this->alpha = alpha;
     this->deterministic = deterministic;
@@ -835,7 +911,10 @@ void CpuCalcDispersionPmeReciprocalForceKernel::runMainThread() {
         threads.waitForThreads();
         threads.resumeThreads(); // Signal threads to sum the charge grids.
         threads.waitForThreads();
-        pocketfft::r2c(gridShape, realGridStride, complexGridStride, fftAxes, true, realGrids[0].data(), complexGrid.data(), 1.0f, 0);
+        threads.resumeThreads(); // Signal threads to transform along y and z.
+        threads.waitForThreads();
+        threads.resumeThreads(); // Signal threads to transform along x.
+        threads.waitForThreads();
         if (lastBoxVectors[0] != periodicBoxVectors[0] || lastBoxVectors[1] != periodicBoxVectors[1] || lastBoxVectors[2] != periodicBoxVectors[2]) {
             threads.resumeThreads(); // Signal threads to compute the reciprocal scale factors.
             threads.waitForThreads();
@@ -848,7 +927,10 @@ void CpuCalcDispersionPmeReciprocalForceKernel::runMainThread() {
         }
         threads.resumeThreads(); // Signal threads to perform reciprocal convolution.
         threads.waitForThreads();
-        pocketfft::c2r(gridShape, complexGridStride, realGridStride, fftAxes, false, complexGrid.data(), realGrids[0].data(), 1.0f, 0);
+        threads.resumeThreads(); // Signal threads to perform the inverse transform along x.
+        threads.waitForThreads();
+        threads.resumeThreads(); // Signal threads to perform the inverse transform along y and z.
+        threads.waitForThreads();
         atomicCounter = 0;
         threads.resumeThreads(); // Signal threads to interpolate forces.
         threads.waitForThreads();
@@ -863,6 +945,8 @@ void CpuCalcDispersionPmeReciprocalForceKernel::runMainThread() {
 void CpuCalcDispersionPmeReciprocalForceKernel::runWorkerThread(ThreadPool& threads, int index) {
     int gridxStart = (index*gridx)/numThreads;
     int gridxEnd = ((index+1)*gridx)/numThreads;
+    int gridyStart = (index*gridy)/numThreads;
+    int gridyEnd = ((index+1)*gridy)/numThreads;
     int gridSize = (gridx*gridy*gridz+3)/4;
     int gridStart = 4*((index*gridSize)/numThreads);
     int gridEnd = 4*(((index+1)*gridSize)/numThreads);
@@ -880,6 +964,10 @@ void CpuCalcDispersionPmeReciprocalForceKernel::runWorkerThread(ThreadPool& thre
         sum.store(&realGrids[0][i]);
     }
     threads.syncThreads();
+    forwardFFTYZ(realGrids[0], complexGrid, gridx, gridy, gridz, gridxStart, gridxEnd);
+    threads.syncThreads();
+    fftX(complexGrid, gridx, gridy, gridz, gridyStart, gridyEnd, true);
+    threads.syncThreads();
     if (lastBoxVectors[0] != periodicBoxVectors[0] || lastBoxVectors[1] != periodicBoxVectors[1] || lastBoxVectors[2] != periodicBoxVectors[2]) {
         computeReciprocalDispersionEterm(gridxStart, gridxEnd, gridx, gridy, gridz, recipEterm, alpha, bsplineModuli, periodicBoxVectors, recipBoxVectors);
         threads.syncThreads();
@@ -892,6 +980,10 @@ void CpuCalcDispersionPmeReciprocalForceKernel::runWorkerThread(ThreadPool& thre
     complexStart = (index*complexSize)/numThreads;
     reciprocalConvolution(complexStart, complexEnd, complexGrid, recipEterm);
     threads.syncThreads();
+    fftX(complexGrid, gridx, gridy, gridz, gridyStart, gridyEnd, false);
+    threads.syncThreads();
+    backwardFFTYZ(complexGrid, realGrids[0], gridx, gridy, gridz, gridxStart, gridxEnd);
+    threads.syncThreads();
     interpolateForces(posq, force, realGrids[0], gridx, gridy, gridz, numParticles, periodicBoxVectors, recipBoxVectors, atomicCounter, epsilonFactor, numThreads);
 }
 
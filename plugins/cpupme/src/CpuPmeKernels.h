@@ -54,7 +54,7 @@ namespace OpenMM {
 class OPENMM_EXPORT_PME CpuCalcPmeReciprocalForceKernel : public CalcPmeReciprocalForceKernel {
 public:
     CpuCalcPmeReciprocalForceKernel(const std::string& name, const Platform& platform) : CalcPmeReciprocalForceKernel(name, platform),
-            isDeleted(false) {
+            isDeleted(false), profilingEnabled(false) {
     }
     /**
      * Initialize the kernel.
@@ -104,6 +104,15 @@ public:
      * @param nz      the number of grid points along the Z axis
      */
     void getPMEParameters(double& alpha, int& nx, int& ny, int& nz) const;
+    /**
+     * Set whether to record the time spent in each phase of the calculation.
+     */
+    void setProfilingEnabled(bool enabled);
+    /**
+     * Add the times that have been recorded for each phase of the calculation to a set of timings,
+     * then discard them.
+     */
+    void collectProfilingTimes(std::map<std::string, std::pair<int, double> >& timings);
 private:
     /**
      * Select a size for one grid dimension that PocketFFT can handle efficiently.
@@ -114,7 +123,8 @@ private:
     int gridx, gridy, gridz, numParticles;
     double alpha;
     bool deterministic;
-    bool isFinished, isDeleted;
+    bool isFinished, isDeleted, profilingEnabled;
+    std::map<std::string, std::pair<int, double> > profilingTimes;
     std::vector<float> force;
     std::vector<float> bsplineModuli[3];
     std::vector<float> recipEterm;
@@ -122,8 +132,6 @@ private:
     std::vector<float> threadEnergy;
     std::vector<std::vector<float> > realGrids;
     std::vector<std::complex<float> > complexGrid;
-    std::vector<std::size_t> gridShape, fftAxes;
-    std::vector<std::ptrdiff_t> realGridStride, complexGridStride;
     int waitCount;
     std::condition_variable startCondition, endCondition;
     std::mutex lock;
@@ -216,8 +224,6 @@ private:
     std::vector<float> threadEnergy;
     std::vector<std::vector<float> > realGrids;
     std::vector<std::complex<float> > complexGrid;
-    std::vector<std::size_t> gridShape, fftAxes;
-    std::vector<std::ptrdiff_t> realGridStride, complexGridStride;
     int waitCount;
     std::condition_variable startCondition, endCondition;
     std::mutex lock;
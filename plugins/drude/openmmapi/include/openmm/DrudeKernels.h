@@ -107,6 +107,10 @@ public:
      * Compute the kinetic energy.
      */
     virtual double computeKineticEnergy(ContextImpl& context, const DrudeLangevinIntegrator& integrator) = 0;
+    /**
+     * Get the number of Drude pairs that were reflected by the hard wall constraint during the most recent step.
+     */
+    virtual int getNumHardWallCollisions(ContextImpl& context) = 0;
 };
 
 /**
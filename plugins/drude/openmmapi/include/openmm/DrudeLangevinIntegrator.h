@@ -132,6 +132,12 @@ public:
      * and should remain close to the prescribed Drude temperature.
      */
     double computeDrudeTemperature();
+    /**
+     * Get the number of Drude particles that moved beyond the maximum Drude distance during the most
+     * recent time step, and so were reflected by the hard wall constraint.  This is useful for monitoring
+     * whether the Drude temperature or step size is too large.
+     */
+    int getNumHardWallCollisions();
 protected:
     /**
      * This will be called by the Context when it is created.  It informs the Integrator
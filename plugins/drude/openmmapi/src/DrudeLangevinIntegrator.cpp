@@ -130,6 +130,12 @@ double DrudeLangevinIntegrator::computeSystemTemperature() {
     return computeTemperaturesFromVelocities(context->getSystem(), velocities).first;
 }
 
+int DrudeLangevinIntegrator::getNumHardWallCollisions() {
+    if (context == NULL)
+        throw OpenMMException("This Integrator is not bound to a context!");
+    return kernel.getAs<IntegrateDrudeLangevinStepKernel>().getNumHardWallCollisions(*context);
+}
+
 double DrudeLangevinIntegrator::computeDrudeTemperature() {
     if (context == NULL)
         throw OpenMMException("This Integrator is not bound to a context!");  
@@ -245,6 +245,8 @@ void CommonIntegrateDrudeLangevinStepKernel::initialize(const System& system, co
     }
     normalParticleVec.insert(normalParticleVec.begin(), particles.begin(), particles.end());
     normalParticles.initialize<int>(cc, max((int) normalParticleVec.size(), 1), "drudeNormalParticles");
+    numHardWallCollisions.initialize<int>(cc, 1, "numHardWallCollisions");
+    cc.clearBuffer(numHardWallCollisions);
     pairParticles.initialize<mm_int2>(cc, max((int) pairParticleVec.size(), 1), "drudePairParticles");
     if (normalParticleVec.size() > 0)
         normalParticles.upload(normalParticleVec);
@@ -259,10 +261,9 @@ void CommonIntegrateDrudeLangevinStepKernel::initialize(const System& system, co
     defines["NUM_NORMAL_PARTICLES"] = cc.intToString(normalParticleVec.size());
     defines["NUM_PAIRS"] = cc.intToString(pairParticleVec.size());
     map<string, string> replacements;
-    ComputeProgram program = cc.compileProgram(CommonDrudeKernelSources::drudeLangevin, defines);
+    ComputeProgram program = cc.compileProgram(CommonKernelSources::random+CommonDrudeKernelSources::drudeLangevin, defines);
     kernel1 = program->createKernel("integrateDrudeLangevinPart1");
     kernel2 = program->createKernel("integrateDrudeLangevinPart2");
-    hardwallKernel = program->createKernel("applyHardWallConstraints");
     prevStepSize = -1.0;
 }
 
@@ -280,8 +281,9 @@ void CommonIntegrateDrudeLangevinStepKernel::execute(ContextImpl& context, const
         kernel1->addArg(integration.getStepSize());
         for (int i = 0; i < 6; i++)
             kernel1->addArg();
-        kernel1->addArg(integration.getRandom());
+        kernel1->addArg(integration.getRandomKey());
         kernel1->addArg();
+        kernel1->addArg(numHardWallCollisions);
         kernel2->addArg(cc.getPosq());
         if (cc.getUseMixedPrecision())
             kernel2->addArg(cc.getPosqCorrection());
@@ -290,16 +292,11 @@ void CommonIntegrateDrudeLangevinStepKernel::execute(ContextImpl& context, const
         kernel2->addArg(integration.getPosDelta());
         kernel2->addArg(cc.getVelm());
         kernel2->addArg(integration.getStepSize());
-        hardwallKernel->addArg(cc.getPosq());
-        if (cc.getUseMixedPrecision())
-            hardwallKernel->addArg(cc.getPosqCorrection());
-        else
-            hardwallKernel->addArg(nullptr);
-        hardwallKernel->addArg(cc.getVelm());
-        hardwallKernel->addArg(pairParticles);
-        hardwallKernel->addArg(integration.getStepSize());
-        hardwallKernel->addArg();
-        hardwallKernel->addArg();
+        kernel2->addArg(normalParticles);
+        kernel2->addArg(pairParticles);
+        kernel2->addArg();
+        kernel2->addArg();
+        kernel2->addArg(numHardWallCollisions);
     }
     
     // Compute integrator coefficients.
@@ -331,8 +328,8 @@ void CommonIntegrateDrudeLangevinStepKernel::execute(ContextImpl& context, const
             kernel1->setArg(9, vscaleDrude);
             kernel1->setArg(10, fscaleDrude);
             kernel1->setArg(11, noisescaleDrude);
-            hardwallKernel->setArg(5, maxDrudeDistance);
-            hardwallKernel->setArg(6, hardwallscaleDrude);
+            kernel2->setArg(7, maxDrudeDistance);
+            kernel2->setArg(8, hardwallscaleDrude);
     }
     else {
             kernel1->setArg(6, (float) vscale);
@@ -341,27 +338,22 @@ void CommonIntegrateDrudeLangevinStepKernel::execute(ContextImpl& context, const
             kernel1->setArg(9, (float) vscaleDrude);
             kernel1->setArg(10, (float) fscaleDrude);
             kernel1->setArg(11, (float) noisescaleDrude);
-            hardwallKernel->setArg(5, (float) maxDrudeDistance);
-            hardwallKernel->setArg(6, (float) hardwallscaleDrude);
+            kernel2->setArg(7, (float) maxDrudeDistance);
+            kernel2->setArg(8, (float) hardwallscaleDrude);
     }
 
     // Call the first integration kernel.
 
-    kernel1->setArg(13, integration.prepareRandomNumbers(normalParticles.getSize()+2*pairParticles.getSize()));
+    kernel1->setArg(13, integration.prepareRandomCounter());
     kernel1->execute(numAtoms);
 
     // Apply constraints.
 
     integration.applyConstraints(integrator.getConstraintTolerance());
 
-    // Call the second integration kernel.
+    // Call the second integration kernel.  It also applies the hard wall constraints.
 
     kernel2->execute(numAtoms);
-    
-    // Apply hard wall constraints.
-    
-    if (maxDrudeDistance > 0)
-        hardwallKernel->execute(pairParticles.getSize());
     integration.computeVirtualSites();
 
     // Update the time and step count.
@@ -375,6 +367,13 @@ double CommonIntegrateDrudeLangevinStepKernel::computeKineticEnergy(ContextImpl&
     return cc.getIntegrationUtilities().computeKineticEnergy(0.5*integrator.getStepSize());
 }
 
+int CommonIntegrateDrudeLangevinStepKernel::getNumHardWallCollisions(ContextImpl& context) {
+    ContextSelector selector(cc);
+    int count;
+    numHardWallCollisions.download(&count);
+    return count;
+}
+
 CommonIntegrateDrudeSCFStepKernel::~CommonIntegrateDrudeSCFStepKernel() {
 }
 
@@ -405,14 +404,22 @@ void CommonIntegrateDrudeSCFStepKernel::initialize(const System& system, const D
     drudeParams.upload(paramVec);
     drudeIndices.upload(drudeIndexVec);
     drudeParents.upload(parentVec);
+    forceSquared.initialize<float>(cc, max(numDrude, 1), "forceSquared");
+    forceSquaredSum.initialize<float>(cc, 1, "forceSquaredSum");
+    displacementHistory.initialize<mm_float4>(cc, 2*max(numDrude, 1), "displacementHistory");
 
     // Create the kernels.
     
     ComputeProgram program = cc.compileProgram(CommonKernelSources::verlet);
     kernel1 = program->createKernel("integrateVerletPart1");
     kernel2 = program->createKernel("integrateVerletPart2");
-    program = cc.compileProgram(CommonDrudeKernelSources::drudeSCF);
+    map<string, string> defines;
+    defines["WORK_GROUP_SIZE"] = cc.intToString(min(cc.getMaxThreadBlockSize(), 512));
+    program = cc.compileProgram(CommonDrudeKernelSources::drudeSCF, defines);
     minimizeKernel = program->createKernel("minimizeDrudePositions");
+    sumKernel = program->createKernel("sumDrudeForceSquared");
+    predictKernel = program->createKernel("predictDrudePositions");
+    recordKernel = program->createKernel("recordDrudeDisplacements");
     prevStepSize = -1.0;
 }
 
@@ -447,6 +454,23 @@ void CommonIntegrateDrudeSCFStepKernel::execute(ContextImpl& context, const Drud
         minimizeKernel->addArg(drudeParams);
         minimizeKernel->addArg(drudeIndices);
         minimizeKernel->addArg(drudeParents);
+        minimizeKernel->addArg(forceSquared);
+        sumKernel->addArg((int) drudeParams.getSize());
+        sumKernel->addArg(forceSquared);
+        sumKernel->addArg(forceSquaredSum);
+        predictKernel->addArg((int) drudeParams.getSize());
+        predictKernel->addArg(cc.getPosq());
+        predictKernel->addArg(drudeIndices);
+        predictKernel->addArg(drudeParents);
+        predictKernel->addArg(displacementHistory);
+        predictKernel->addArg();
+        predictKernel->addArg();
+        recordKernel->addArg((int) drudeParams.getSize());
+        recordKernel->addArg(cc.getPosq());
+        recordKernel->addArg(drudeIndices);
+        recordKernel->addArg(drudeParents);
+        recordKernel->addArg(displacementHistory);
+        recordKernel->addArg();
     }
     if (dt != prevStepSize) {
         if (cc.getUseDoublePrecision() || cc.getUseMixedPrecision()) {
@@ -477,7 +501,9 @@ void CommonIntegrateDrudeSCFStepKernel::execute(ContextImpl& context, const Drud
     // Update the positions of virtual sites and Drude particles.
 
     integration.computeVirtualSites();
+    predictDrudePositions();
     minimize(context, integrator.getMinimizationErrorTolerance());
+    recordDrudeDisplacements();
 
     // Update the time and step count.
 
@@ -498,22 +524,44 @@ double CommonIntegrateDrudeSCFStepKernel::computeKineticEnergy(ContextImpl& cont
 
 void CommonIntegrateDrudeSCFStepKernel::minimize(ContextImpl& context, double tolerance) {
     minimizeKernel->setArg(2, (float) tolerance);
-    long long* forces = (long long*) cc.getPinnedBuffer();
-    double scale = 1/(double) 0x100000000;
-    double lastForce = 0;
     int numDrude = drudeParams.getSize();
-    int paddedNumAtoms = cc.getPaddedNumAtoms();
+    float* totalForce = (float*) cc.getPinnedBuffer();
+    double lastForce = 0;
     for (int iteration = 0; iteration < 50; iteration++) {
         context.calcForcesAndEnergy(true, false, context.getIntegrator().getIntegrationForceGroups());
-        minimizeKernel->execute(drudeParams.getSize());
-        cc.getLongForceBuffer().download(forces);
-        double totalForce = 0;
-        for (int i : drudeIndexVec) {
-            Vec3 f(scale*forces[i], scale*forces[i+paddedNumAtoms], scale*forces[i+paddedNumAtoms*2]);
-            totalForce += f.dot(f);
-        }
-        if (sqrt(totalForce/(3*numDrude)) < tolerance || (iteration > 0 && totalForce > 0.9*lastForce)) 
+        minimizeKernel->execute(numDrude);
+
+        // Sum the squared forces on the device so only a single value needs to be downloaded.
+
+        sumKernel->execute(min(cc.getMaxThreadBlockSize(), 512), min(cc.getMaxThreadBlockSize(), 512));
+        forceSquaredSum.download(totalForce);
+        if (sqrt(*totalForce/(3*numDrude)) < tolerance || (iteration > 0 && *totalForce > 0.9*lastForce)) 
             break;
-        lastForce = totalForce;
+        lastForce = *totalForce;
+    }
+}
+
+void CommonIntegrateDrudeSCFStepKernel::predictDrudePositions() {
+    // Discard the history if the positions have been set or the atoms reordered since it was
+    // recorded, or if it does not come from the immediately preceding step.
+
+    if (cc.getPositionsSetCount() != historyPositionsSetCount || cc.getAtomsWereReordered() || cc.getStepCount() != historyLastStep+1) {
+        historyPositionsSetCount = cc.getPositionsSetCount();
+        historySize = 0;
+    }
+    if (historySize > 0 && drudeParams.getSize() > 0) {
+        predictKernel->setArg(5, historySize);
+        predictKernel->setArg(6, newestSlot);
+        predictKernel->execute(drudeParams.getSize());
     }
 }
+
+void CommonIntegrateDrudeSCFStepKernel::recordDrudeDisplacements() {
+    if (drudeParams.getSize() == 0)
+        return;
+    newestSlot = 1-newestSlot;
+    historySize = min(historySize+1, 2);
+    historyLastStep = cc.getStepCount();
+    recordKernel->setArg(5, newestSlot);
+    recordKernel->execute(drudeParams.getSize());
+}
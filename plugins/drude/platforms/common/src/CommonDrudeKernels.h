@@ -105,13 +105,20 @@ public:
      * @param integrator  the DrudeLangevinIntegrator this kernel is being used for
      */
     double computeKineticEnergy(ContextImpl& context, const DrudeLangevinIntegrator& integrator);
+    /**
+     * Get the number of Drude pairs that were reflected by the hard wall constraint during the most recent step.
+     *
+     * @param context     the context in which to execute this kernel
+     */
+    int getNumHardWallCollisions(ContextImpl& context);
 private:
     ComputeContext& cc;
     double prevStepSize;
     bool hasInitializedKernels;
     ComputeArray normalParticles;
     ComputeArray pairParticles;
-    ComputeKernel kernel1, kernel2, hardwallKernel;
+    ComputeArray numHardWallCollisions;
+    ComputeKernel kernel1, kernel2;
 };
 
 /**
@@ -120,7 +127,8 @@ private:
 class CommonIntegrateDrudeSCFStepKernel : public IntegrateDrudeSCFStepKernel {
 public:
     CommonIntegrateDrudeSCFStepKernel(const std::string& name, const Platform& platform, ComputeContext& cc) :
-            IntegrateDrudeSCFStepKernel(name, platform), cc(cc), hasInitializedKernels(false) {
+            IntegrateDrudeSCFStepKernel(name, platform), cc(cc), hasInitializedKernels(false),
+            historySize(0), newestSlot(0), historyPositionsSetCount(-1), historyLastStep(-1) {
     }
     ~CommonIntegrateDrudeSCFStepKernel();
     /**
@@ -147,12 +155,17 @@ public:
     double computeKineticEnergy(ContextImpl& context, const DrudeSCFIntegrator& integrator);
 private:
     void minimize(ContextImpl& context, double tolerance);
+    void predictDrudePositions();
+    void recordDrudeDisplacements();
     ComputeContext& cc;
     double prevStepSize;
     bool hasInitializedKernels;
+    int historySize, newestSlot, historyPositionsSetCount;
+    long long historyLastStep;
     std::vector<int> drudeIndexVec;
     ComputeArray drudeParams, drudeIndices, drudeParents;
-    ComputeKernel kernel1, kernel2, minimizeKernel;
+    ComputeArray forceSquared, forceSquaredSum, displacementHistory;
+    ComputeKernel kernel1, kernel2, minimizeKernel, sumKernel, predictKernel, recordKernel;
 };
 
 } // namespace OpenMM
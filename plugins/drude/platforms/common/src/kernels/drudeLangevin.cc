@@ -4,8 +4,11 @@
 
 KERNEL void integrateDrudeLangevinPart1(GLOBAL mixed4* RESTRICT velm, GLOBAL const mm_long* RESTRICT force, GLOBAL mixed4* RESTRICT posDelta,
         GLOBAL const int* RESTRICT normalParticles, GLOBAL const int2* RESTRICT pairParticles, GLOBAL const mixed2* RESTRICT dt, mixed vscale, mixed fscale,
-        mixed noisescale, mixed vscaleDrude, mixed fscaleDrude, mixed noisescaleDrude, GLOBAL const float4* RESTRICT random, unsigned int randomIndex) {
+        mixed noisescale, mixed vscaleDrude, mixed fscaleDrude, mixed noisescaleDrude, uint2 randomKey, uint2 randomCounter,
+        GLOBAL int* RESTRICT numHardWallCollisions) {
     mixed stepSize = dt[0].y;
+    if (GLOBAL_ID == 0)
+        numHardWallCollisions[0] = 0;
     
     // Update normal particles.
 
@@ -14,7 +17,7 @@ KERNEL void integrateDrudeLangevinPart1(GLOBAL mixed4* RESTRICT velm, GLOBAL con
         mixed4 velocity = velm[index];
         if (velocity.w != 0) {
             mixed sqrtInvMass = SQRT(velocity.w);
-            float4 rand = random[randomIndex+index];
+            float4 rand = philoxNormal4(randomKey, randomCounter, i);
             velocity.x = vscale*velocity.x + fscale*velocity.w*force[index] + noisescale*sqrtInvMass*rand.x;
             velocity.y = vscale*velocity.y + fscale*velocity.w*force[index+PADDED_NUM_ATOMS] + noisescale*sqrtInvMass*rand.y;
             velocity.z = vscale*velocity.z + fscale*velocity.w*force[index+PADDED_NUM_ATOMS*2] + noisescale*sqrtInvMass*rand.z;
@@ -25,7 +28,6 @@ KERNEL void integrateDrudeLangevinPart1(GLOBAL mixed4* RESTRICT velm, GLOBAL con
     
     // Update Drude particle pairs.
     
-    randomIndex += NUM_NORMAL_PARTICLES;
     for (int i = GLOBAL_ID; i < NUM_PAIRS; i += GLOBAL_SIZE) {
         int2 particles = pairParticles[i];
         mixed4 velocity1 = velm[particles.x];
@@ -44,8 +46,8 @@ KERNEL void integrateDrudeLangevinPart1(GLOBAL mixed4* RESTRICT velm, GLOBAL con
         mixed3 force2 = make_mixed3(force[particles.y], force[particles.y+PADDED_NUM_ATOMS], force[particles.y+PADDED_NUM_ATOMS*2]);
         mixed3 cmForce = force1+force2;
         mixed3 relForce = force2*mass1fract - force1*mass2fract;
-        float4 rand1 = random[randomIndex+2*i];
-        float4 rand2 = random[randomIndex+2*i+1];
+        float4 rand1 = philoxNormal4(randomKey, randomCounter, NUM_NORMAL_PARTICLES+2*i);
+        float4 rand2 = philoxNormal4(randomKey, randomCounter, NUM_NORMAL_PARTICLES+2*i+1);
         cmVel.x = vscale*cmVel.x + fscale*invTotalMass*cmForce.x + noisescale*sqrtInvTotalMass*rand1.x;
         cmVel.y = vscale*cmVel.y + fscale*invTotalMass*cmForce.y + noisescale*sqrtInvTotalMass*rand1.y;
         cmVel.z = vscale*cmVel.z + fscale*invTotalMass*cmForce.z + noisescale*sqrtInvTotalMass*rand1.z;
@@ -66,26 +68,53 @@ KERNEL void integrateDrudeLangevinPart1(GLOBAL mixed4* RESTRICT velm, GLOBAL con
 }
 
 /**
- * Perform the second step of Langevin integration.
+ * Load the position of an atom, including the correction in mixed precision mode.
+ */
+DEVICE mixed4 loadDrudePosition(GLOBAL const real4* RESTRICT posq, GLOBAL const real4* RESTRICT posqCorrection, int index) {
+#ifdef USE_MIXED_PRECISION
+    real4 pos1 = posq[index];
+    real4 pos2 = posqCorrection[index];
+    return make_mixed4(pos1.x+(mixed)pos2.x, pos1.y+(mixed)pos2.y, pos1.z+(mixed)pos2.z, pos1.w);
+#else
+    return posq[index];
+#endif
+}
+
+/**
+ * Store the position of an atom, splitting off the correction in mixed precision mode.
+ */
+DEVICE void storeDrudePosition(GLOBAL real4* RESTRICT posq, GLOBAL real4* RESTRICT posqCorrection, int index, mixed4 pos) {
+#ifdef USE_MIXED_PRECISION
+    posq[index] = make_real4((real) pos.x, (real) pos.y, (real) pos.z, (real) pos.w);
+    posqCorrection[index] = make_real4(pos.x-(real) pos.x, pos.y-(real) pos.y, pos.z-(real) pos.z, 0);
+#else
+    posq[index] = pos;
+#endif
+}
+
+/**
+ * Perform the second step of Langevin integration.  Drude pairs whose separation exceeds the maximum
+ * Drude distance are made to "bounce" off the hard wall while they are still in registers, and the
+ * number of them is counted.
  */
 
-KERNEL void integrateDrudeLangevinPart2(GLOBAL real4* RESTRICT posq, GLOBAL real4* RESTRICT posqCorrection, GLOBAL const mixed4* RESTRICT posDelta, GLOBAL mixed4* RESTRICT velm, GLOBAL const mixed2* RESTRICT dt) {
+KERNEL void integrateDrudeLangevinPart2(GLOBAL real4* RESTRICT posq, GLOBAL real4* RESTRICT posqCorrection, GLOBAL const mixed4* RESTRICT posDelta, GLOBAL mixed4* RESTRICT velm,
+        GLOBAL const mixed2* RESTRICT dt, GLOBAL const int* RESTRICT normalParticles, GLOBAL const int2* RESTRICT pairParticles, mixed maxDrudeDistance,
+        mixed hardwallscaleDrude, GLOBAL int* RESTRICT numHardWallCollisions) {
 #ifdef SUPPORTS_DOUBLE_PRECISION
     double invStepSize = 1.0/dt[0].y;
 #else
     float invStepSize = 1.0f/dt[0].y;
 #endif
-    int index = GLOBAL_ID;
-    while (index < NUM_ATOMS) {
+    mixed stepSize = dt[0].y;
+
+    // Update normal particles.
+
+    for (int i = GLOBAL_ID; i < NUM_NORMAL_PARTICLES; i += GLOBAL_SIZE) {
+        int index = normalParticles[i];
         mixed4 vel = velm[index];
         if (vel.w != 0) {
-#ifdef USE_MIXED_PRECISION
-            real4 pos1 = posq[index];
-            real4 pos2 = posqCorrection[index];
-            mixed4 pos = make_mixed4(pos1.x+(mixed)pos2.x, pos1.y+(mixed)pos2.y, pos1.z+(mixed)pos2.z, pos1.w);
-#else
-            real4 pos = posq[index];
-#endif
+            mixed4 pos = loadDrudePosition(posq, posqCorrection, index);
             mixed4 delta = posDelta[index];
             pos.x += delta.x;
             pos.y += delta.y;
@@ -93,47 +122,49 @@ KERNEL void integrateDrudeLangevinPart2(GLOBAL real4* RESTRICT posq, GLOBAL real
             vel.x = (mixed) (invStepSize*delta.x);
             vel.y = (mixed) (invStepSize*delta.y);
             vel.z = (mixed) (invStepSize*delta.z);
-#ifdef USE_MIXED_PRECISION
-            posq[index] = make_real4((real) pos.x, (real) pos.y, (real) pos.z, (real) pos.w);
-            posqCorrection[index] = make_real4(pos.x-(real) pos.x, pos.y-(real) pos.y, pos.z-(real) pos.z, 0);
-#else
-            posq[index] = pos;
-#endif
+            storeDrudePosition(posq, posqCorrection, index, pos);
             velm[index] = vel;
         }
-        index += GLOBAL_SIZE;
     }
-}
 
-/**
- * Apply hard wall constraints
- */
-KERNEL void applyHardWallConstraints(GLOBAL real4* RESTRICT posq, GLOBAL real4* RESTRICT posqCorrection, GLOBAL mixed4* RESTRICT velm,
-        GLOBAL const int2* RESTRICT pairParticles, GLOBAL const mixed2* RESTRICT dt, mixed maxDrudeDistance, mixed hardwallscaleDrude) {
-    mixed stepSize = dt[0].y;
+    // Update Drude particle pairs.
+
     for (int i = GLOBAL_ID; i < NUM_PAIRS; i += GLOBAL_SIZE) {
         int2 particles = pairParticles[i];
-#ifdef USE_MIXED_PRECISION
-        real4 posReal1 = posq[particles.x];
-        real4 posReal2 = posq[particles.y];
-        real4 posCorr1 = posqCorrection[particles.x];
-        real4 posCorr2 = posqCorrection[particles.y];
-        mixed4 pos1 = make_mixed4(posReal1.x+(mixed)posCorr1.x, posReal1.y+(mixed)posCorr1.y, posReal1.z+(mixed)posCorr1.z, posReal1.w);
-        mixed4 pos2 = make_mixed4(posReal2.x+(mixed)posCorr2.x, posReal2.y+(mixed)posCorr2.y, posReal2.z+(mixed)posCorr2.z, posReal2.w);
-#else
-        mixed4 pos1 = posq[particles.x];
-        mixed4 pos2 = posq[particles.y];
-#endif
+        mixed4 pos1 = loadDrudePosition(posq, posqCorrection, particles.x);
+        mixed4 pos2 = loadDrudePosition(posq, posqCorrection, particles.y);
+        mixed4 vel1 = velm[particles.x];
+        mixed4 vel2 = velm[particles.y];
+        if (vel1.w != 0) {
+            mixed4 delta = posDelta[particles.x];
+            pos1.x += delta.x;
+            pos1.y += delta.y;
+            pos1.z += delta.z;
+            vel1.x = (mixed) (invStepSize*delta.x);
+            vel1.y = (mixed) (invStepSize*delta.y);
+            vel1.z = (mixed) (invStepSize*delta.z);
+        }
+        if (vel2.w != 0) {
+            mixed4 delta = posDelta[particles.y];
+            pos2.x += delta.x;
+            pos2.y += delta.y;
+            pos2.z += delta.z;
+            vel2.x = (mixed) (invStepSize*delta.x);
+            vel2.y = (mixed) (invStepSize*delta.y);
+            vel2.z = (mixed) (invStepSize*delta.z);
+        }
+
+        // Apply the hard wall constraint.
+
         mixed4 delta = pos1-pos2;
         mixed r = SQRT(delta.x*delta.x + delta.y*delta.y + delta.z*delta.z);
         mixed rInv = RECIP(r);
-        if (rInv*maxDrudeDistance < 1) {
+        if (maxDrudeDistance > 0 && rInv*maxDrudeDistance < 1) {
             // The constraint has been violated, so make the inter-particle distance "bounce"
             // off the hard wall.
 
+            ATOMIC_ADD(numHardWallCollisions, 1);
             mixed4 bondDir = delta*rInv;
-            mixed4 vel1 = velm[particles.x];
-            mixed4 vel2 = velm[particles.y];
             mixed mass1 = RECIP(vel1.w);
             mixed mass2 = RECIP(vel2.w);
             mixed deltaR = r-maxDrudeDistance;
@@ -153,16 +184,9 @@ KERNEL void applyHardWallConstraints(GLOBAL real4* RESTRICT posq, GLOBAL real4*
                 pos1.x += bondDir.x*dr;
                 pos1.y += bondDir.y*dr;
                 pos1.z += bondDir.z*dr;
-#ifdef USE_MIXED_PRECISION
-                posq[particles.x] = make_real4((real) pos1.x, (real) pos1.y, (real) pos1.z, (real) pos1.w);
-                posqCorrection[particles.x] = make_real4(pos1.x-(real) pos1.x, pos1.y-(real) pos1.y, pos1.z-(real) pos1.z, 0);
-#else
-                posq[particles.x] = pos1;
-#endif
                 vel1.x = vp1.x + bondDir.x*dotvr1;
                 vel1.y = vp1.y + bondDir.y*dotvr1;
                 vel1.z = vp1.z + bondDir.z*dotvr1;
-                velm[particles.x] = vel1;
             }
             else {
                 // Move both particles.
@@ -191,24 +215,21 @@ KERNEL void applyHardWallConstraints(GLOBAL real4* RESTRICT posq, GLOBAL real4*
                 pos2.x += bondDir.x*dr2;
                 pos2.y += bondDir.y*dr2;
                 pos2.z += bondDir.z*dr2;
-#ifdef USE_MIXED_PRECISION
-                posq[particles.x] = make_real4((real) pos1.x, (real) pos1.y, (real) pos1.z, (real) pos1.w);
-                posq[particles.y] = make_real4((real) pos2.x, (real) pos2.y, (real) pos2.z, (real) pos2.w);
-                posqCorrection[particles.x] = make_real4(pos1.x-(real) pos1.x, pos1.y-(real) pos1.y, pos1.z-(real) pos1.z, 0);
-                posqCorrection[particles.y] = make_real4(pos2.x-(real) pos2.x, pos2.y-(real) pos2.y, pos2.z-(real) pos2.z, 0);
-#else
-                posq[particles.x] = pos1;
-                posq[particles.y] = pos2;
-#endif
                 vel1.x = vp1.x + bondDir.x*dotvr1;
                 vel1.y = vp1.y + bondDir.y*dotvr1;
                 vel1.z = vp1.z + bondDir.z*dotvr1;
                 vel2.x = vp2.x + bondDir.x*dotvr2;
                 vel2.y = vp2.y + bondDir.y*dotvr2;
                 vel2.z = vp2.z + bondDir.z*dotvr2;
-                velm[particles.x] = vel1;
-                velm[particles.y] = vel2;
             }
         }
+        if (vel1.w != 0) {
+            storeDrudePosition(posq, posqCorrection, particles.x, pos1);
+            velm[particles.x] = vel1;
+        }
+        if (vel2.w != 0) {
+            storeDrudePosition(posq, posqCorrection, particles.y, pos2);
+            velm[particles.y] = vel2;
+        }
     }
 }
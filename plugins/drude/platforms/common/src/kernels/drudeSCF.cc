@@ -1,6 +1,6 @@
 KERNEL void minimizeDrudePositions(int numDrude, int paddedNumAtoms, float tolerance, GLOBAL real4* RESTRICT posq,
         GLOBAL const mm_long* RESTRICT force, GLOBAL float4* RESTRICT drudeParams, GLOBAL int* RESTRICT drudeIndex,
-        GLOBAL int4* RESTRICT drudeParents) {
+        GLOBAL int4* RESTRICT drudeParents, GLOBAL float* RESTRICT forceSquared) {
     const real scale = 1/(real) 0x100000000;
     for (int i = GLOBAL_ID; i < numDrude; i += GLOBAL_SIZE) {
         int index = drudeIndex[i];
@@ -19,7 +19,9 @@ KERNEL void minimizeDrudePositions(int numDrude, int paddedNumAtoms, float toler
         }
         real4 pos = posq[index];
         real4 f = make_real4(scale*force[index], scale*force[index+paddedNumAtoms], scale*force[index+paddedNumAtoms*2], 0);
-        real damping = (SQRT(f.x*f.x + f.y*f.y + f.z*f.z) > 10*tolerance ? 0.5f : 1.0f);
+        real f2 = f.x*f.x + f.y*f.y + f.z*f.z;
+        forceSquared[i] = (float) f2;
+        real damping = (SQRT(f2) > 10*tolerance ? 0.5f : 1.0f);
         pos.x += damping*f.x/fscale.x;
         pos.y += damping*f.y/fscale.y;
         pos.z += damping*f.z/fscale.z;
@@ -27,3 +29,57 @@ KERNEL void minimizeDrudePositions(int numDrude, int paddedNumAtoms, float toler
     }
 }
 
+
+/**
+ * Sum the squared forces on the Drude particles so the convergence check only needs to download
+ * a single value.  This is executed by a single work group.
+ */
+KERNEL void sumDrudeForceSquared(int numDrude, GLOBAL const float* RESTRICT forceSquared, GLOBAL float* RESTRICT result) {
+    LOCAL float tempBuffer[WORK_GROUP_SIZE];
+    const unsigned int thread = LOCAL_ID;
+    float sum = 0;
+    for (unsigned int index = thread; index < numDrude; index += LOCAL_SIZE)
+        sum += forceSquared[index];
+    tempBuffer[thread] = sum;
+    for (int i = 1; i < WORK_GROUP_SIZE; i *= 2) {
+        SYNC_THREADS;
+        if (thread%(i*2) == 0 && thread+i < WORK_GROUP_SIZE)
+            tempBuffer[thread] += tempBuffer[thread+i];
+    }
+    if (thread == 0)
+        *result = tempBuffer[0];
+}
+
+/**
+ * Predict the Drude particle positions for a new step by extrapolating their displacements from
+ * their parents over the previous steps.
+ */
+KERNEL void predictDrudePositions(int numDrude, GLOBAL real4* RESTRICT posq, GLOBAL int* RESTRICT drudeIndex,
+        GLOBAL int4* RESTRICT drudeParents, GLOBAL const float4* RESTRICT displacementHistory, int historySize, int newestSlot) {
+    for (int i = GLOBAL_ID; i < numDrude; i += GLOBAL_SIZE) {
+        int index = drudeIndex[i];
+        real3 parentPos = trimTo3(posq[drudeParents[i].x]);
+        float4 newest = displacementHistory[newestSlot*numDrude+i];
+        real3 delta = make_real3(newest.x, newest.y, newest.z);
+        if (historySize > 1) {
+            float4 previous = displacementHistory[(1-newestSlot)*numDrude+i];
+            delta = delta+delta-make_real3(previous.x, previous.y, previous.z);
+        }
+        real4 pos = posq[index];
+        pos.x = parentPos.x+delta.x;
+        pos.y = parentPos.y+delta.y;
+        pos.z = parentPos.z+delta.z;
+        posq[index] = pos;
+    }
+}
+
+/**
+ * Record the converged displacement of each Drude particle from its parent.
+ */
+KERNEL void recordDrudeDisplacements(int numDrude, GLOBAL const real4* RESTRICT posq, GLOBAL int* RESTRICT drudeIndex,
+        GLOBAL int4* RESTRICT drudeParents, GLOBAL float4* RESTRICT displacementHistory, int slot) {
+    for (int i = GLOBAL_ID; i < numDrude; i += GLOBAL_SIZE) {
+        real3 delta = trimTo3(posq[drudeIndex[i]]-posq[drudeParents[i].x]);
+        displacementHistory[slot*numDrude+i] = make_float4((float) delta.x, (float) delta.y, (float) delta.z, 0.0f);
+    }
+}
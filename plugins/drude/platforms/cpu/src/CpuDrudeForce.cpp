@@ -0,0 +1,127 @@
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMDrude                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuDrudeForce.h"
+#include "ReferenceForce.h"
+#include "SimTKOpenMMRealType.h"
+
+using namespace OpenMM;
+using namespace std;
+
+void CpuDrudeParticleIxn::calculateBondIxn(vector<int>& atomIndices, vector<Vec3>& atomCoordinates,
+                                           vector<double>& parameters, vector<Vec3>& forces,
+                                           double* totalEnergy, double* energyParamDerivs) {
+    int p = atomIndices[0];
+    int p1 = atomIndices[1];
+    int p2 = atomIndices[2];
+    int p3 = atomIndices[3];
+    int p4 = atomIndices[4];
+    double k1 = parameters[0];
+    double k2 = parameters[1];
+    double k3 = parameters[2];
+    double energy = 0;
+
+    // Compute the isotropic force.
+
+    Vec3 delta = atomCoordinates[p]-atomCoordinates[p1];
+    double r2 = delta.dot(delta);
+    energy += 0.5*k3*r2;
+    forces[p] -= delta*k3;
+    forces[p1] += delta*k3;
+
+    // Compute the first anisotropic force.
+
+    if (k1 != 0) {
+        Vec3 dir = atomCoordinates[p1]-atomCoordinates[p2];
+        double invDist = 1.0/sqrt(dir.dot(dir));
+        dir *= invDist;
+        double rprime = dir.dot(delta);
+        energy += 0.5*k1*rprime*rprime;
+        Vec3 f1 = dir*(k1*rprime);
+        Vec3 f2 = (delta-dir*rprime)*(k1*rprime*invDist);
+        forces[p] -= f1;
+        forces[p1] += f1-f2;
+        forces[p2] += f2;
+    }
+
+    // Compute the second anisotropic force.
+
+    if (k2 != 0) {
+        Vec3 dir = atomCoordinates[p3]-atomCoordinates[p4];
+        double invDist = 1.0/sqrt(dir.dot(dir));
+        dir *= invDist;
+        double rprime = dir.dot(delta);
+        energy += 0.5*k2*rprime*rprime;
+        Vec3 f1 = dir*(k2*rprime);
+        Vec3 f2 = (delta-dir*rprime)*(k2*rprime*invDist);
+        forces[p] -= f1;
+        forces[p1] += f1;
+        forces[p3] -= f2;
+        forces[p4] += f2;
+    }
+    if (totalEnergy != NULL)
+        *totalEnergy += energy;
+}
+
+CpuDrudeScreenedPairIxn::CpuDrudeScreenedPairIxn() : usePeriodic(false) {
+}
+
+void CpuDrudeScreenedPairIxn::setPeriodic(Vec3* vectors) {
+    usePeriodic = true;
+    boxVectors[0] = vectors[0];
+    boxVectors[1] = vectors[1];
+    boxVectors[2] = vectors[2];
+}
+
+void CpuDrudeScreenedPairIxn::calculateBondIxn(vector<int>& atomIndices, vector<Vec3>& atomCoordinates,
+                                               vector<double>& parameters, vector<Vec3>& forces,
+                                               double* totalEnergy, double* energyParamDerivs) {
+    double chargeProduct = parameters[0];
+    double uscale = parameters[1];
+    double energy = 0;
+    for (int j = 0; j < 2; j++)
+        for (int k = 0; k < 2; k++) {
+            int p1 = atomIndices[j];
+            int p2 = atomIndices[2+k];
+            double pairChargeProduct = chargeProduct*(j == k ? 1 : -1);
+            double deltaR[ReferenceForce::LastDeltaRIndex];
+            if (usePeriodic)
+                ReferenceForce::getDeltaRPeriodic(atomCoordinates[p2], atomCoordinates[p1], boxVectors, deltaR);
+            else
+                ReferenceForce::getDeltaR(atomCoordinates[p2], atomCoordinates[p1], deltaR);
+            Vec3 delta(deltaR[ReferenceForce::XIndex], deltaR[ReferenceForce::YIndex], deltaR[ReferenceForce::ZIndex]);
+            double r = deltaR[ReferenceForce::RIndex];
+            double u = r*uscale;
+            double expu = exp(-u);
+            double screening = 1.0 - (1.0+0.5*u)*expu;
+            energy += ONE_4PI_EPS0*pairChargeProduct*screening/r;
+            Vec3 f = delta*(ONE_4PI_EPS0*pairChargeProduct/(r*r))*(screening/r-0.5*(1+u)*expu*uscale);
+            forces[p1] += f;
+            forces[p2] -= f;
+        }
+    if (totalEnergy != NULL)
+        *totalEnergy += energy;
+}
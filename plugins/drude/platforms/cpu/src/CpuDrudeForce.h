@@ -0,0 +1,75 @@
+#ifndef OPENMM_CPU_DRUDE_FORCE_H_
+#define OPENMM_CPU_DRUDE_FORCE_H_
+
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMDrude                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "ReferenceBondIxn.h"
+#include "openmm/Vec3.h"
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class computes the harmonic spring between a Drude particle and its parent, including the
+ * anisotropic terms.  It is used with CpuBondForce, so each "bond" consists of five atoms: the Drude
+ * particle, its parent, and the two pairs of particles defining the anisotropy directions.  The
+ * parameters are the spring constants k1, k2, and k3.  An anisotropic term is skipped if its
+ * spring constant is 0.
+ */
+class CpuDrudeParticleIxn : public ReferenceBondIxn {
+public:
+    void calculateBondIxn(std::vector<int>& atomIndices, std::vector<Vec3>& atomCoordinates,
+                          std::vector<double>& parameters, std::vector<Vec3>& forces,
+                          double* totalEnergy, double* energyParamDerivs);
+};
+
+/**
+ * This class computes the screened interaction between two bonded dipoles.  It is used with
+ * CpuBondForce, so each "bond" consists of four atoms: the Drude particle and parent of the first
+ * dipole, followed by those of the second one.  The parameters are the product of the two charges
+ * and the Thole screening factor.
+ */
+class CpuDrudeScreenedPairIxn : public ReferenceBondIxn {
+public:
+    CpuDrudeScreenedPairIxn();
+    /**
+     * Set the force to use periodic boundary conditions.
+     *
+     * @param vectors    the vectors defining the periodic box
+     */
+    void setPeriodic(Vec3* vectors);
+    void calculateBondIxn(std::vector<int>& atomIndices, std::vector<Vec3>& atomCoordinates,
+                          std::vector<double>& parameters, std::vector<Vec3>& forces,
+                          double* totalEnergy, double* energyParamDerivs);
+private:
+    bool usePeriodic;
+    Vec3 boxVectors[3];
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_CPU_DRUDE_FORCE_H_*/
@@ -0,0 +1,241 @@
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMDrude                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "DrudeCpuKernels.h"
+#include "CpuDrudeForce.h"
+#include "ReferenceConstraints.h"
+#include "ReferenceVirtualSites.h"
+#include "SimTKOpenMMRealType.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/internal/ContextImpl.h"
+
+using namespace OpenMM;
+using namespace std;
+
+static vector<Vec3>& extractPositions(ContextImpl& context) {
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    return *data->positions;
+}
+
+static vector<Vec3>& extractForces(ContextImpl& context) {
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    return *data->forces;
+}
+
+static Vec3* extractBoxVectors(ContextImpl& context) {
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    return data->periodicBoxVectors;
+}
+
+/**
+ * Get the atoms that make up the "bond" representing a Drude particle.  CpuBondForce requires every
+ * atom index to be valid, so unused ones are replaced by the parent particle.  The spring constants
+ * for the missing anisotropic terms are 0, so those atoms never actually get used.
+ */
+static vector<int> getDrudeParticleAtoms(int p, int p1, int p2, int p3, int p4) {
+    return {p, p1, (p2 == -1 ? p1 : p2), (p3 == -1 ? p1 : p3), (p4 == -1 ? p1 : p4)};
+}
+
+void CpuCalcDrudeForceKernel::initialize(const System& system, const DrudeForce& force) {
+    int numParticles = force.getNumParticles();
+    particleAtoms.resize(numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        int p, p1, p2, p3, p4;
+        double charge, polarizability, aniso12, aniso34;
+        force.getParticleParameters(i, p, p1, p2, p3, p4, charge, polarizability, aniso12, aniso34);
+        particleAtoms[i] = getDrudeParticleAtoms(p, p1, p2, p3, p4);
+    }
+    int numPairs = force.getNumScreenedPairs();
+    pairAtoms.resize(numPairs);
+    for (int i = 0; i < numPairs; i++) {
+        int dipole1, dipole2;
+        double thole;
+        force.getScreenedPairParameters(i, dipole1, dipole2, thole);
+        pairAtoms[i] = {particleAtoms[dipole1][0], particleAtoms[dipole1][1], particleAtoms[dipole2][0], particleAtoms[dipole2][1]};
+    }
+    computeParameters(force);
+    particleForce.initialize(system.getNumParticles(), numParticles, 5, particleAtoms, data.threads);
+    pairForce.initialize(system.getNumParticles(), numPairs, 4, pairAtoms, data.threads);
+    periodic = force.usesPeriodicBoundaryConditions();
+}
+
+void CpuCalcDrudeForceKernel::computeParameters(const DrudeForce& force) {
+    int numParticles = force.getNumParticles();
+    vector<double> charge(numParticles), polarizability(numParticles);
+    particleParams.resize(numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        int p, p1, p2, p3, p4;
+        double aniso12, aniso34;
+        force.getParticleParameters(i, p, p1, p2, p3, p4, charge[i], polarizability[i], aniso12, aniso34);
+        double a1 = (p2 == -1 ? 1 : aniso12);
+        double a2 = (p3 == -1 || p4 == -1 ? 1 : aniso34);
+        double a3 = 3-a1-a2;
+        double k3 = ONE_4PI_EPS0*charge[i]*charge[i]/(polarizability[i]*a3);
+        double k1 = (p2 == -1 ? 0.0 : ONE_4PI_EPS0*charge[i]*charge[i]/(polarizability[i]*a1) - k3);
+        double k2 = (p3 == -1 || p4 == -1 ? 0.0 : ONE_4PI_EPS0*charge[i]*charge[i]/(polarizability[i]*a2) - k3);
+        particleParams[i] = {k1, k2, k3};
+    }
+    int numPairs = force.getNumScreenedPairs();
+    pairParams.resize(numPairs);
+    for (int i = 0; i < numPairs; i++) {
+        int dipole1, dipole2;
+        double thole;
+        force.getScreenedPairParameters(i, dipole1, dipole2, thole);
+        double uscale = thole/pow(polarizability[dipole1]*polarizability[dipole2], 1.0/6.0);
+        pairParams[i] = {charge[dipole1]*charge[dipole2], uscale};
+    }
+}
+
+double CpuCalcDrudeForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double energy = 0;
+    CpuDrudeParticleIxn particleIxn;
+    particleForce.calculateForce(posData, particleParams, forceData, includeEnergy ? &energy : NULL, particleIxn);
+    CpuDrudeScreenedPairIxn pairIxn;
+    if (periodic)
+        pairIxn.setPeriodic(extractBoxVectors(context));
+    pairForce.calculateForce(posData, pairParams, forceData, includeEnergy ? &energy : NULL, pairIxn);
+    return energy;
+}
+
+void CpuCalcDrudeForceKernel::copyParametersToContext(ContextImpl& context, const DrudeForce& force) {
+    if (force.getNumParticles() != particleAtoms.size())
+        throw OpenMMException("updateParametersInContext: The number of Drude particles has changed");
+    if (force.getNumScreenedPairs() != pairAtoms.size())
+        throw OpenMMException("updateParametersInContext: The number of screened pairs has changed");
+    for (int i = 0; i < force.getNumParticles(); i++) {
+        int p, p1, p2, p3, p4;
+        double charge, polarizability, aniso12, aniso34;
+        force.getParticleParameters(i, p, p1, p2, p3, p4, charge, polarizability, aniso12, aniso34);
+        if (getDrudeParticleAtoms(p, p1, p2, p3, p4) != particleAtoms[i])
+            throw OpenMMException("updateParametersInContext: A particle index has changed");
+    }
+    for (int i = 0; i < force.getNumScreenedPairs(); i++) {
+        int dipole1, dipole2;
+        double thole;
+        force.getScreenedPairParameters(i, dipole1, dipole2, thole);
+        if (particleAtoms[dipole1][0] != pairAtoms[i][0] || particleAtoms[dipole1][1] != pairAtoms[i][1] ||
+                particleAtoms[dipole2][0] != pairAtoms[i][2] || particleAtoms[dipole2][1] != pairAtoms[i][3])
+            throw OpenMMException("updateParametersInContext: A particle index for a screened pair has changed");
+    }
+    computeParameters(force);
+}
+
+void CpuIntegrateDrudeLangevinStepKernel::initialize(const System& system, const DrudeLangevinIntegrator& integrator, const DrudeForce& force) {
+    ReferenceIntegrateDrudeLangevinStepKernel::initialize(system, integrator, force);
+    cpuData.random.initialize(integrator.getRandomNumberSeed(), cpuData.threads.getNumThreads());
+    xPrime.resize(system.getNumParticles());
+}
+
+void CpuIntegrateDrudeLangevinStepKernel::execute(ContextImpl& context, const DrudeLangevinIntegrator& integrator) {
+    vector<Vec3>& pos = *data.positions;
+    vector<Vec3>& vel = *data.velocities;
+    vector<Vec3>& force = *data.forces;
+    ThreadPool& threads = cpuData.threads;
+    CpuRandom& random = cpuData.random;
+    const double dt = integrator.getStepSize();
+    const double vscale = exp(-dt*integrator.getFriction());
+    const double fscale = (1-vscale)/integrator.getFriction();
+    const double kT = BOLTZ*integrator.getTemperature();
+    const double noisescale = sqrt(2*kT*integrator.getFriction())*sqrt(0.5*(1-vscale*vscale)/integrator.getFriction());
+    const double vscaleDrude = exp(-dt*integrator.getDrudeFriction());
+    const double fscaleDrude = (1-vscaleDrude)/integrator.getDrudeFriction();
+    const double kTDrude = BOLTZ*integrator.getDrudeTemperature();
+    const double noisescaleDrude = sqrt(2*kTDrude*integrator.getDrudeFriction())*sqrt(0.5*(1-vscaleDrude*vscaleDrude)/integrator.getDrudeFriction());
+    const int numParticles = particleInvMass.size();
+    const int numNormal = normalParticles.size();
+    const int numPairs = pairParticles.size();
+
+    // Update the velocities and compute the new positions.  Ordinary particles and Drude pairs are
+    // each divided evenly between the threads.
+
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int numThreads = threads.getNumThreads();
+        int start = threadIndex*numNormal/numThreads;
+        int end = (threadIndex+1)*numNormal/numThreads;
+        for (int i = start; i < end; i++) {
+            int index = normalParticles[i];
+            double invMass = particleInvMass[index];
+            if (invMass != 0.0) {
+                Vec3 noise(random.getGaussianRandom(threadIndex), random.getGaussianRandom(threadIndex), random.getGaussianRandom(threadIndex));
+                vel[index] = vscale*vel[index] + (fscale*invMass)*force[index] + (noisescale*sqrt(invMass))*noise;
+            }
+        }
+        start = threadIndex*numPairs/numThreads;
+        end = (threadIndex+1)*numPairs/numThreads;
+        for (int i = start; i < end; i++) {
+            int p1 = pairParticles[i].first;
+            int p2 = pairParticles[i].second;
+            double mass1fract = pairInvTotalMass[i]/particleInvMass[p1];
+            double mass2fract = pairInvTotalMass[i]/particleInvMass[p2];
+            Vec3 cmVel = vel[p1]*mass1fract+vel[p2]*mass2fract;
+            Vec3 relVel = vel[p2]-vel[p1];
+            Vec3 cmForce = force[p1]+force[p2];
+            Vec3 relForce = force[p2]*mass1fract - force[p1]*mass2fract;
+            Vec3 cmNoise(random.getGaussianRandom(threadIndex), random.getGaussianRandom(threadIndex), random.getGaussianRandom(threadIndex));
+            Vec3 relNoise(random.getGaussianRandom(threadIndex), random.getGaussianRandom(threadIndex), random.getGaussianRandom(threadIndex));
+            cmVel = vscale*cmVel + (fscale*pairInvTotalMass[i])*cmForce + (noisescale*sqrt(pairInvTotalMass[i]))*cmNoise;
+            relVel = vscaleDrude*relVel + (fscaleDrude*pairInvReducedMass[i])*relForce + (noisescaleDrude*sqrt(pairInvReducedMass[i]))*relNoise;
+            vel[p1] = cmVel-relVel*mass2fract;
+            vel[p2] = cmVel+relVel*mass1fract;
+        }
+        threads.syncThreads();
+        start = threadIndex*numParticles/numThreads;
+        end = (threadIndex+1)*numParticles/numThreads;
+        for (int i = start; i < end; i++)
+            xPrime[i] = (particleInvMass[i] != 0.0 ? pos[i]+vel[i]*dt : pos[i]);
+    });
+    threads.waitForThreads();
+    threads.resumeThreads();
+    threads.waitForThreads();
+
+    // Apply constraints.
+
+    data.constraints->apply(pos, xPrime, particleInvMass, integrator.getConstraintTolerance());
+
+    // Record the constrained positions and velocities.
+
+    const double dtInv = 1.0/dt;
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numParticles/threads.getNumThreads();
+        int end = (threadIndex+1)*numParticles/threads.getNumThreads();
+        for (int i = start; i < end; i++) {
+            if (particleInvMass[i] != 0.0) {
+                vel[i] = (xPrime[i]-pos[i])*dtInv;
+                pos[i] = xPrime[i];
+            }
+        }
+    });
+    threads.waitForThreads();
+
+    // Apply hard wall constraints.
+
+    applyHardWallConstraints(pos, vel, integrator);
+    data.virtualSites->computePositions(context.getSystem(), pos);
+    data.time += dt;
+    data.stepCount++;
+}
@@ -0,0 +1,110 @@
+#ifndef DRUDE_CPU_KERNELS_H_
+#define DRUDE_CPU_KERNELS_H_
+
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMDrude                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors:                                                                   *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuBondForce.h"
+#include "CpuPlatform.h"
+#include "ReferenceDrudeKernels.h"
+#include "openmm/DrudeKernels.h"
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This kernel is invoked by DrudeForce to calculate the forces acting on the system and the energy of the system.
+ * The Drude springs and screened pairs are divided between threads with CpuBondForce.
+ */
+class CpuCalcDrudeForceKernel : public CalcDrudeForceKernel {
+public:
+    CpuCalcDrudeForceKernel(const std::string& name, const Platform& platform, CpuPlatform::PlatformData& data) : CalcDrudeForceKernel(name, platform),
+            data(data) {
+    }
+    /**
+     * Initialize the kernel.
+     * 
+     * @param system     the System this kernel will be applied to
+     * @param force      the DrudeForce this kernel will be used for
+     */
+    void initialize(const System& system, const DrudeForce& force);
+    /**
+     * Execute the kernel to calculate the forces and/or energy.
+     *
+     * @param context        the context in which to execute this kernel
+     * @param includeForces  true if forces should be calculated
+     * @param includeEnergy  true if the energy should be calculated
+     * @return the potential energy due to the force
+     */
+    double execute(ContextImpl& context, bool includeForces, bool includeEnergy);
+    /**
+     * Copy changed parameters over to a context.
+     *
+     * @param context    the context to copy parameters to
+     * @param force      the DrudeForce to copy the parameters from
+     */
+    void copyParametersToContext(ContextImpl& context, const DrudeForce& force);
+private:
+    void computeParameters(const DrudeForce& force);
+    CpuPlatform::PlatformData& data;
+    std::vector<std::vector<int> > particleAtoms, pairAtoms;
+    std::vector<std::vector<double> > particleParams, pairParams;
+    CpuBondForce particleForce, pairForce;
+    bool periodic;
+};
+
+/**
+ * This kernel is invoked by DrudeLangevinIntegrator to take one time step.  It is identical to the
+ * reference kernel, except that the velocity and position updates are parallelized.
+ */
+class CpuIntegrateDrudeLangevinStepKernel : public ReferenceIntegrateDrudeLangevinStepKernel {
+public:
+    CpuIntegrateDrudeLangevinStepKernel(const std::string& name, const Platform& platform, ReferencePlatform::PlatformData& refData, CpuPlatform::PlatformData& data) :
+        ReferenceIntegrateDrudeLangevinStepKernel(name, platform, refData), cpuData(data) {
+    }
+    /**
+     * Initialize the kernel.
+     *
+     * @param system     the System this kernel will be applied to
+     * @param integrator the DrudeLangevinIntegrator this kernel will be used for
+     * @param force      the DrudeForce to get particle parameters from
+     */
+    void initialize(const System& system, const DrudeLangevinIntegrator& integrator, const DrudeForce& force);
+    /**
+     * Execute the kernel.
+     *
+     * @param context        the context in which to execute this kernel
+     * @param integrator     the DrudeLangevinIntegrator this kernel is being used for
+     */
+    void execute(ContextImpl& context, const DrudeLangevinIntegrator& integrator);
+private:
+    CpuPlatform::PlatformData& cpuData;
+    std::vector<Vec3> xPrime;
+};
+
+} // namespace OpenMM
+
+#endif /*DRUDE_CPU_KERNELS_H_*/
@@ -40,9 +40,13 @@ extern "C" OPENMM_EXPORT void registerKernelFactories() {
         Platform& platform = Platform::getPlatform(i);
         if (dynamic_cast<ReferencePlatform*>(&platform) != NULL) {
             ReferenceDrudeKernelFactory* factory = new ReferenceDrudeKernelFactory();
-            platform.registerKernelFactory(CalcDrudeForceKernel::Name(), factory);
-            platform.registerKernelFactory(IntegrateDrudeLangevinStepKernel::Name(), factory);
-            platform.registerKernelFactory(IntegrateDrudeSCFStepKernel::Name(), factory);
+
+            // Subclasses of ReferencePlatform (such as the CPU platform) may already have optimized
+            // versions of some kernels registered by another plugin.  Don't replace them.
+
+            for (auto& name : {CalcDrudeForceKernel::Name(), IntegrateDrudeLangevinStepKernel::Name(), IntegrateDrudeSCFStepKernel::Name()})
+                if (!platform.supportsKernels({name}))
+                    platform.registerKernelFactory(name, factory);
         }
     }
 }
@@ -326,7 +326,17 @@ void ReferenceIntegrateDrudeLangevinStepKernel::execute(ContextImpl& context, co
 
     // Apply hard wall constraints.
 
+    applyHardWallConstraints(pos, vel, integrator);
+    extractVirtualSites(context).computePositions(context.getSystem(), pos);
+    data.time += integrator.getStepSize();
+    data.stepCount++;
+}
+
+void ReferenceIntegrateDrudeLangevinStepKernel::applyHardWallConstraints(vector<Vec3>& pos, vector<Vec3>& vel, const DrudeLangevinIntegrator& integrator) {
+    const double kTDrude = BOLTZ*integrator.getDrudeTemperature();
+    const double dt = integrator.getStepSize();
     const double maxDrudeDistance = integrator.getMaxDrudeDistance();
+    numHardWallCollisions = 0;
     if (maxDrudeDistance > 0) {
         const double hardwallscaleDrude = sqrt(kTDrude);
         for (int i = 0; i < (int) pairParticles.size(); i++) {
@@ -341,6 +351,7 @@ void ReferenceIntegrateDrudeLangevinStepKernel::execute(ContextImpl& context, co
                 
                 if (rInv*maxDrudeDistance < 0.5)
                     throw OpenMMException("Drude particle moved too far beyond hard wall constraint");
+                numHardWallCollisions++;
                 Vec3 bondDir = delta*rInv;
                 Vec3 vel1 = vel[p1];
                 Vec3 vel2 = vel[p2];
@@ -392,9 +403,6 @@ void ReferenceIntegrateDrudeLangevinStepKernel::execute(ContextImpl& context, co
             }
         }
     }
-    extractVirtualSites(context).computePositions(context.getSystem(), pos);
-    data.time += integrator.getStepSize();
-    data.stepCount++;
 }
 
 double ReferenceIntegrateDrudeLangevinStepKernel::computeKineticEnergy(ContextImpl& context, const DrudeLangevinIntegrator& integrator) {
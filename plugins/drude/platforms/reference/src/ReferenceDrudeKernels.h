@@ -86,7 +86,7 @@ private:
 class ReferenceIntegrateDrudeLangevinStepKernel : public IntegrateDrudeLangevinStepKernel {
 public:
     ReferenceIntegrateDrudeLangevinStepKernel(const std::string& name, const Platform& platform, ReferencePlatform::PlatformData& data) :
-        IntegrateDrudeLangevinStepKernel(name, platform), data(data) {
+        IntegrateDrudeLangevinStepKernel(name, platform), data(data), numHardWallCollisions(0) {
     }
     ~ReferenceIntegrateDrudeLangevinStepKernel();
     /**
@@ -111,7 +111,22 @@ public:
      * @param integrator  the DrudeLangevinIntegrator this kernel is being used for
      */
     double computeKineticEnergy(ContextImpl& context, const DrudeLangevinIntegrator& integrator);
-private:
+    /**
+     * Get the number of Drude pairs that were reflected by the hard wall constraint during the most recent step.
+     */
+    int getNumHardWallCollisions(ContextImpl& context) {
+        return numHardWallCollisions;
+    }
+protected:
+    /**
+     * Make any Drude particle that has moved beyond the maximum allowed distance from its parent
+     * "bounce" off the hard wall.
+     *
+     * @param pos             the particle positions
+     * @param vel             the particle velocities
+     * @param integrator      the DrudeLangevinIntegrator this kernel is being used for
+     */
+    void applyHardWallConstraints(std::vector<Vec3>& pos, std::vector<Vec3>& vel, const DrudeLangevinIntegrator& integrator);
     ReferencePlatform::PlatformData& data;
     std::vector<int> normalParticles;
     std::vector<std::pair<int, int> > pairParticles;
@@ -119,6 +134,7 @@ private:
     std::vector<double> particleInvMass;
     std::vector<double> pairInvTotalMass;
     std::vector<double> pairInvReducedMass;
+    int numHardWallCollisions;
 };
 
 /**
@@ -95,6 +95,38 @@ void testSinglePair() {
     ASSERT_USUALLY_EQUAL_TOL(3*0.5*BOLTZ*temperatureDrude, keInternal/numSteps, 0.01);
 }
 
+void testHardWallCollisions() {
+    // Start a pair beyond the maximum Drude distance and moving apart, so the first step must reflect
+    // it off the hard wall.
+
+    const double maxDistance = 0.05;
+    System system;
+    system.addParticle(1.0);
+    system.addParticle(0.1);
+    DrudeForce* drude = new DrudeForce();
+    drude->addParticle(1, 0, -1, -1, -1, 0.1, 0.001, 1, 1);
+    system.addForce(drude);
+    vector<Vec3> positions(2);
+    positions[0] = Vec3(0, 0, 0);
+    positions[1] = Vec3(0.06, 0, 0);
+    DrudeLangevinIntegrator integ(300.0, 1.0, 10.0, 1.0, 0.001);
+    integ.setMaxDrudeDistance(maxDistance);
+    Context context(system, integ, platform);
+    context.setPositions(positions);
+    context.setVelocities({Vec3(0, 0, 0), Vec3(1, 0, 0)});
+    integ.step(1);
+    ASSERT_EQUAL(1, integ.getNumHardWallCollisions());
+    State state = context.getState(State::Positions);
+    Vec3 delta = state.getPositions()[0]-state.getPositions()[1];
+    ASSERT(sqrt(delta.dot(delta)) <= maxDistance*(1+1e-6));
+
+    // With a larger maximum distance, the next step should not hit the wall.
+
+    integ.setMaxDrudeDistance(1.0);
+    integ.step(1);
+    ASSERT_EQUAL(0, integ.getNumHardWallCollisions());
+}
+
 void testWater() {
     // Create a box of SWM4-NDP water molecules.  This involves constraints, virtual sites,
     // and Drude particles.
@@ -299,6 +331,7 @@ int main(int argc, char* argv[]) {
         setupKernels(argc, argv);
         testInitialTemperature();
         testSinglePair();
+        testHardWallCollisions();
         testWater();
         testForceEnergyConsistency();
         runPlatformTests();
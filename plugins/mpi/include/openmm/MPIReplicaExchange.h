@@ -0,0 +1,171 @@
+#ifndef OPENMM_MPIREPLICAEXCHANGE_H_
+#define OPENMM_MPIREPLICAEXCHANGE_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/Context.h"
+#include "openmm/Integrator.h"
+#include "openmm/System.h"
+#include "openmm/internal/windowsExportMPI.h"
+#include <mpi.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace OpenMM_SFMT {
+    class SFMT;
+}
+
+namespace OpenMM {
+
+class Platform;
+
+/**
+ * This class runs a replica exchange simulation distributed over the ranks of an MPI communicator.
+ * It works like ReplicaExchange, except that each rank creates only a single Context, simulating
+ * the replica whose index equals the rank.  The communicator must therefore have exactly one rank
+ * for each thermodynamic state.  To run each replica on a different GPU, pass a different device
+ * index in the properties on each rank.
+ *
+ * Every rank must construct the object with the same arguments, and must call attemptExchanges()
+ * and computeReducedPotentials() collectively.  Exchanging replicas never transfers coordinates.
+ * Each rank computes the reduced potentials of its own replica, and they are combined into the
+ * full matrix with a single MPI_Allgather.  Every rank then makes the same accept/reject
+ * decisions from a random number generator with a shared seed, so the states stay consistent
+ * without any further communication.  When an exchange is accepted, the two ranks involved change
+ * the parameters and temperature of their Contexts and rescale their velocities.
+ *
+ * The temperature is applied as described for ReplicaExchange.  MPI must be initialized before
+ * this object is created and must not be finalized until after it is deleted.
+ */
+
+class OPENMM_EXPORT_MPI MPIReplicaExchange {
+public:
+    /**
+     * Create an MPIReplicaExchange.
+     *
+     * @param comm          the communicator over which to distribute the replicas.  It must have one
+     *                      rank for each thermodynamic state.
+     * @param system        the System to simulate.  It must not be modified or deleted while the
+     *                      MPIReplicaExchange exists.
+     * @param integrator    the Integrator to use.  A copy of it is made for the local replica.
+     * @param temperatures  the temperature of each thermodynamic state, in Kelvin
+     * @param parameters    the values of Context parameters in each thermodynamic state.  This may be
+     *                      empty, in which case the states differ only in temperature.  Otherwise it
+     *                      must have one element for each state.
+     * @param platform      the Platform to create the Context for
+     * @param properties    Platform-specific properties to create the Context with
+     * @param randomSeed    the seed for the random number generator used to accept or reject exchanges.
+     *                      The value passed on rank 0 is used by all ranks.
+     */
+    MPIReplicaExchange(MPI_Comm comm, const System& system, const Integrator& integrator, const std::vector<double>& temperatures,
+            const std::vector<std::map<std::string, double> >& parameters, Platform& platform,
+            const std::map<std::string, std::string>& properties=std::map<std::string, std::string>(), int randomSeed=osrngseed());
+    ~MPIReplicaExchange();
+    /**
+     * Get the number of replicas.  This equals the number of thermodynamic states and the number
+     * of ranks in the communicator.
+     */
+    int getNumReplicas() const {
+        return temperatures.size();
+    }
+    /**
+     * Get the index of the replica simulated by this rank.
+     */
+    int getLocalReplica() const {
+        return rank;
+    }
+    /**
+     * Get the Context used to simulate the local replica.  You can set its positions and velocities,
+     * or retrieve its State.  Do not change its parameters or the temperature of its Integrator,
+     * since those are determined by the state it is in.
+     */
+    Context& getContext();
+    /**
+     * Get the Integrator used to simulate the local replica.
+     */
+    Integrator& getIntegrator();
+    /**
+     * Get the thermodynamic state each replica is currently in.  Element i is the index of the
+     * state replica i is in.  This is identical on all ranks.
+     */
+    const std::vector<int>& getReplicaStates() const {
+        return replicaState;
+    }
+    /**
+     * Advance the local replica by a number of time steps.
+     *
+     * @param steps   the number of time steps to take
+     */
+    void step(int steps);
+    /**
+     * Attempt to exchange replicas between pairs of neighboring states.  This must be called on
+     * all ranks.  Each replica only evaluates its energy in the states it could be exchanged into.
+     *
+     * @return the number of exchanges that were accepted.  This is identical on all ranks.
+     */
+    int attemptExchanges();
+    /**
+     * Compute the reduced potential energy (the potential energy divided by kT) of every replica
+     * in every thermodynamic state.  Element [i][j] is the reduced potential of replica i
+     * evaluated in state j.  This must be called on all ranks, and every rank receives the full
+     * matrix.
+     */
+    std::vector<std::vector<double> > computeReducedPotentials();
+    /**
+     * Get the number of exchanges that have been attempted between state i and state i+1.
+     */
+    int getNumAttempted(int state) const;
+    /**
+     * Get the number of exchanges that have been accepted between state i and state i+1.
+     */
+    int getNumAccepted(int state) const;
+private:
+    void applyState(int state);
+    std::vector<double> computeLocalReducedPotentials(const std::vector<bool>& stateNeeded);
+    std::vector<std::vector<double> > gatherReducedPotentials(const std::vector<double>& local);
+    MPI_Comm comm;
+    int rank;
+    const System& system;
+    std::vector<double> temperatures;
+    std::vector<std::map<std::string, double> > parameters;
+    Integrator* integrator;
+    Context* context;
+    std::vector<int> replicaState, numAttempted, numAccepted;
+    std::vector<std::string> temperatureParameters;
+    OpenMM_SFMT::SFMT* random;
+    int exchangeParity;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_MPIREPLICAEXCHANGE_H_*/
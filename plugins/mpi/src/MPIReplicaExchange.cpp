@@ -0,0 +1,227 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/MPIReplicaExchange.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/Platform.h"
+#include "openmm/ReplicaExchange.h"
+#include "openmm/State.h"
+#include "openmm/serialization/XmlSerializer.h"
+#include "SimTKOpenMMRealType.h"
+#include "sfmt/SFMT.h"
+#include <cmath>
+
+using namespace OpenMM;
+using namespace std;
+
+MPIReplicaExchange::MPIReplicaExchange(MPI_Comm comm, const System& system, const Integrator& integrator, const vector<double>& temperatures,
+            const vector<map<string, double> >& parameters, Platform& platform, const map<string, string>& properties, int randomSeed) :
+            comm(comm), system(system), temperatures(temperatures), parameters(parameters), integrator(NULL), context(NULL), exchangeParity(0) {
+    int numStates = temperatures.size();
+    int numRanks;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &numRanks);
+    if (numStates < 2)
+        throw OpenMMException("MPIReplicaExchange: At least two thermodynamic states are required");
+    if (numRanks != numStates)
+        throw OpenMMException("MPIReplicaExchange: The number of MPI ranks must equal the number of temperatures");
+    if (parameters.size() != 0 && parameters.size() != numStates)
+        throw OpenMMException("MPIReplicaExchange: The number of parameter sets must equal the number of temperatures");
+    for (double t : temperatures)
+        if (t <= 0)
+            throw OpenMMException("MPIReplicaExchange: Temperatures must be positive");
+    temperatureParameters = ReplicaExchange::getTemperatureParameters(system);
+
+    // Every rank must make the same decisions about which exchanges to accept, so they all use
+    // the seed from rank 0.
+
+    MPI_Bcast(&randomSeed, 1, MPI_INT, 0, comm);
+    random = new OpenMM_SFMT::SFMT();
+    init_gen_rand(randomSeed, *random);
+    try {
+        this->integrator = XmlSerializer::clone<Integrator>(integrator);
+        if (!ReplicaExchange::setIntegratorTemperature(*this->integrator, temperatures[rank]) && temperatureParameters.size() == 0)
+            throw OpenMMException("MPIReplicaExchange: The Integrator does not have a temperature, and the System does not contain a thermostat");
+        context = new Context(system, *this->integrator, platform, properties);
+        for (int i = 0; i < numStates; i++)
+            replicaState.push_back(i);
+        applyState(rank);
+    }
+    catch (...) {
+        if (context != NULL)
+            delete context;
+        if (this->integrator != NULL)
+            delete this->integrator;
+        delete random;
+        throw;
+    }
+    numAttempted.resize(numStates-1, 0);
+    numAccepted.resize(numStates-1, 0);
+}
+
+MPIReplicaExchange::~MPIReplicaExchange() {
+    delete context;
+    delete integrator;
+    delete random;
+}
+
+Context& MPIReplicaExchange::getContext() {
+    return *context;
+}
+
+Integrator& MPIReplicaExchange::getIntegrator() {
+    return *integrator;
+}
+
+int MPIReplicaExchange::getNumAttempted(int state) const {
+    if (state < 0 || state >= numAttempted.size())
+        throw OpenMMException("MPIReplicaExchange: Illegal state index");
+    return numAttempted[state];
+}
+
+int MPIReplicaExchange::getNumAccepted(int state) const {
+    if (state < 0 || state >= numAccepted.size())
+        throw OpenMMException("MPIReplicaExchange: Illegal state index");
+    return numAccepted[state];
+}
+
+void MPIReplicaExchange::step(int steps) {
+    integrator->step(steps);
+}
+
+void MPIReplicaExchange::applyState(int state) {
+    if (parameters.size() > 0)
+        for (auto& param : parameters[state])
+            context->setParameter(param.first, param.second);
+    ReplicaExchange::setIntegratorTemperature(*integrator, temperatures[state]);
+    for (const string& param : temperatureParameters)
+        context->setParameter(param, temperatures[state]);
+}
+
+vector<double> MPIReplicaExchange::computeLocalReducedPotentials(const vector<bool>& stateNeeded) {
+    // Evaluate the energy once for each distinct set of parameters, then restore the Context's own.
+
+    int numStates = temperatures.size();
+    int currentState = replicaState[rank];
+    const map<string, double> noParameters;
+    const map<string, double>& ownParameters = (parameters.size() > 0 ? parameters[currentState] : noParameters);
+    const map<string, double>* activeParameters = &ownParameters;
+    map<map<string, double>, double> energies;
+    vector<double> u(numStates, 0.0);
+    for (int j = 0; j < numStates; j++) {
+        if (!stateNeeded[j])
+            continue;
+        const map<string, double>& key = (parameters.size() > 0 ? parameters[j] : noParameters);
+        if (energies.find(key) == energies.end()) {
+            if (key != *activeParameters) {
+                for (auto& param : key)
+                    context->setParameter(param.first, param.second);
+                activeParameters = &key;
+            }
+            energies[key] = context->getState(State::Energy).getPotentialEnergy();
+        }
+        u[j] = energies[key]/(BOLTZ*temperatures[j]);
+    }
+    if (*activeParameters != ownParameters)
+        for (auto& param : ownParameters)
+            context->setParameter(param.first, param.second);
+    return u;
+}
+
+vector<vector<double> > MPIReplicaExchange::gatherReducedPotentials(const vector<double>& local) {
+    int numStates = temperatures.size();
+    vector<double> all(numStates*numStates);
+    MPI_Allgather(local.data(), numStates, MPI_DOUBLE, all.data(), numStates, MPI_DOUBLE, comm);
+    vector<vector<double> > u(numStates);
+    for (int i = 0; i < numStates; i++)
+        u[i] = vector<double>(all.begin()+i*numStates, all.begin()+(i+1)*numStates);
+    return u;
+}
+
+vector<vector<double> > MPIReplicaExchange::computeReducedPotentials() {
+    return gatherReducedPotentials(computeLocalReducedPotentials(vector<bool>(temperatures.size(), true)));
+}
+
+int MPIReplicaExchange::attemptExchanges() {
+    // The local replica only needs its energy in its current state and in the state it might be
+    // exchanged with.
+
+    int numStates = temperatures.size();
+    int currentState = replicaState[rank];
+    vector<bool> stateNeeded(numStates, false);
+    stateNeeded[currentState] = true;
+    if (currentState >= exchangeParity) {
+        int partner = ((currentState-exchangeParity)%2 == 0 ? currentState+1 : currentState-1);
+        if (partner < numStates)
+            stateNeeded[partner] = true;
+    }
+    vector<vector<double> > u = gatherReducedPotentials(computeLocalReducedPotentials(stateNeeded));
+
+    // Every rank now has the same matrix, so they all reach the same decisions.
+
+    vector<int> stateReplica(numStates);
+    for (int i = 0; i < numStates; i++)
+        stateReplica[replicaState[i]] = i;
+    int accepted = 0;
+    for (int s1 = exchangeParity; s1+1 < numStates; s1 += 2) {
+        int s2 = s1+1;
+        int r1 = stateReplica[s1];
+        int r2 = stateReplica[s2];
+        double delta = u[r1][s2]+u[r2][s1]-u[r1][s1]-u[r2][s2];
+        numAttempted[s1]++;
+        if (delta > 0 && genrand_real2(*random) >= exp(-delta))
+            continue;
+
+        // Accept the exchange.  If the local replica is involved, its Context switches to the
+        // new state and its velocities are rescaled to the new temperature.
+
+        numAccepted[s1]++;
+        accepted++;
+        replicaState[r1] = s2;
+        replicaState[r2] = s1;
+        stateReplica[s1] = r2;
+        stateReplica[s2] = r1;
+        if (r1 == rank || r2 == rank) {
+            int newState = replicaState[rank];
+            int oldState = (newState == s1 ? s2 : s1);
+            applyState(newState);
+            if (temperatures[newState] != temperatures[oldState]) {
+                double scale = sqrt(temperatures[newState]/temperatures[oldState]);
+                vector<Vec3> velocities = context->getState(State::Velocities).getVelocities();
+                for (Vec3& v : velocities)
+                    v *= scale;
+                context->setVelocities(velocities);
+            }
+        }
+    }
+    exchangeParity = 1-exchangeParity;
+    return accepted;
+}
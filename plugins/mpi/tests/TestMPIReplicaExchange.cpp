@@ -0,0 +1,241 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.            *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/CustomExternalForce.h"
+#include "openmm/LangevinMiddleIntegrator.h"
+#include "openmm/MPIReplicaExchange.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/Platform.h"
+#include "openmm/ReplicaExchange.h"
+#include "openmm/State.h"
+#include "openmm/System.h"
+#include "SimTKOpenMMRealType.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * Build a System of particles in harmonic wells whose force constant is a global parameter.
+ */
+void buildOscillators(System& system, int numParticles) {
+    CustomExternalForce* force = new CustomExternalForce("0.5*k*(x^2+y^2+z^2)");
+    force->addGlobalParameter("k", 100.0);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        force->addParticle(i);
+    }
+    system.addForce(force);
+}
+
+vector<Vec3> randomPositions(int numParticles, int seed) {
+    vector<Vec3> positions;
+    for (int i = 0; i < numParticles; i++)
+        positions.push_back(Vec3(0.1*sin(seed+i), 0.1*cos(2.0*seed+i), 0.05*sin(3.0*seed-i)));
+    return positions;
+}
+
+/**
+ * Check that every rank has the same value for the states of the replicas.
+ */
+void assertStatesConsistent(const vector<int>& states) {
+    vector<int> rootStates = states;
+    MPI_Bcast(rootStates.data(), rootStates.size(), MPI_INT, 0, MPI_COMM_WORLD);
+    for (int i = 0; i < states.size(); i++)
+        ASSERT_EQUAL(rootStates[i], states[i]);
+}
+
+void testTemperatureExchange(int numRanks) {
+    const int numParticles = 10;
+    System system;
+    buildOscillators(system, numParticles);
+    LangevinMiddleIntegrator integrator(300.0, 10.0, 0.01);
+    vector<double> temperatures;
+    for (int i = 0; i < numRanks; i++)
+        temperatures.push_back(300.0+20.0*i);
+    MPIReplicaExchange exchange(MPI_COMM_WORLD, system, integrator, temperatures, vector<map<string, double> >(),
+            Platform::getPlatformByName("Reference"), map<string, string>(), 5);
+    int replica = exchange.getLocalReplica();
+    ASSERT_EQUAL(numRanks, exchange.getNumReplicas());
+    exchange.getContext().setPositions(randomPositions(numParticles, replica));
+    exchange.getContext().setVelocitiesToTemperature(temperatures[replica], replica+1);
+    int totalAccepted = 0;
+    for (int i = 0; i < 50; i++) {
+        exchange.step(10);
+        totalAccepted += exchange.attemptExchanges();
+    }
+
+    // The states should be a permutation that is the same on every rank, and the local Integrator
+    // should have the temperature of the state its replica is in.
+
+    vector<int> states = exchange.getReplicaStates();
+    assertStatesConsistent(states);
+    LangevinMiddleIntegrator& integ = dynamic_cast<LangevinMiddleIntegrator&>(exchange.getIntegrator());
+    ASSERT_EQUAL_TOL(temperatures[states[replica]], integ.getTemperature(), 1e-10);
+    sort(states.begin(), states.end());
+    for (int i = 0; i < numRanks; i++)
+        ASSERT_EQUAL(i, states[i]);
+    int sumAccepted = 0, sumAttempted = 0;
+    for (int i = 0; i < numRanks-1; i++) {
+        sumAccepted += exchange.getNumAccepted(i);
+        sumAttempted += exchange.getNumAttempted(i);
+    }
+    ASSERT_EQUAL(totalAccepted, sumAccepted);
+    ASSERT_EQUAL(25*(numRanks-1), sumAttempted);
+    ASSERT(totalAccepted > 0);
+}
+
+void testHamiltonianExchange(int numRanks) {
+    const int numParticles = 5;
+    System system;
+    buildOscillators(system, numParticles);
+    LangevinMiddleIntegrator integrator(300.0, 10.0, 0.01);
+    vector<double> temperatures(numRanks, 300.0);
+    vector<map<string, double> > parameters;
+    for (int i = 0; i < numRanks; i++)
+        parameters.push_back({{"k", 100.0*(i+1)}});
+    MPIReplicaExchange exchange(MPI_COMM_WORLD, system, integrator, temperatures, parameters, Platform::getPlatformByName("Reference"));
+    int replica = exchange.getLocalReplica();
+    exchange.getContext().setPositions(randomPositions(numParticles, replica));
+
+    // Every rank should receive the full matrix of reduced potentials.  Check it against the
+    // analytical energies.
+
+    vector<vector<double> > u = exchange.computeReducedPotentials();
+    ASSERT_EQUAL(numRanks, u.size());
+    double kT = BOLTZ*300.0;
+    for (int i = 0; i < numRanks; i++) {
+        vector<Vec3> pos = randomPositions(numParticles, i);
+        double sum = 0.0;
+        for (const Vec3& p : pos)
+            sum += p.dot(p);
+        for (int j = 0; j < numRanks; j++)
+            ASSERT_EQUAL_TOL(0.5*parameters[j]["k"]*sum/kT, u[i][j], 1e-5);
+    }
+    ASSERT_EQUAL_TOL(parameters[replica]["k"], exchange.getContext().getParameter("k"), 1e-10);
+
+    // After exchanges, the local Context's parameters should match its state.
+
+    for (int i = 0; i < 20; i++) {
+        exchange.step(5);
+        exchange.attemptExchanges();
+    }
+    const vector<int>& states = exchange.getReplicaStates();
+    assertStatesConsistent(states);
+    ASSERT_EQUAL_TOL(parameters[states[replica]]["k"], exchange.getContext().getParameter("k"), 1e-10);
+}
+
+void testMatchesSerialExchange(int numRanks) {
+    // Without any time steps, the exchanges are determined only by the positions and the random
+    // seed, so they should be identical to those made by ReplicaExchange.
+
+    const int numParticles = 5;
+    System system;
+    buildOscillators(system, numParticles);
+    LangevinMiddleIntegrator integrator(300.0, 10.0, 0.01);
+    vector<double> temperatures;
+    vector<map<string, double> > parameters;
+    for (int i = 0; i < numRanks; i++) {
+        temperatures.push_back(300.0+10.0*i);
+        parameters.push_back({{"k", 100.0+20.0*i}});
+    }
+    Platform& platform = Platform::getPlatformByName("Reference");
+    MPIReplicaExchange exchange(MPI_COMM_WORLD, system, integrator, temperatures, parameters, platform, map<string, string>(), 12);
+    ReplicaExchange serial(system, integrator, temperatures, parameters, platform, map<string, string>(), 12);
+    exchange.getContext().setPositions(randomPositions(numParticles, exchange.getLocalReplica()));
+    for (int i = 0; i < numRanks; i++)
+        serial.getContext(i).setPositions(randomPositions(numParticles, i));
+    for (int i = 0; i < 20; i++) {
+        ASSERT_EQUAL(serial.attemptExchanges(), exchange.attemptExchanges());
+        for (int j = 0; j < numRanks; j++)
+            ASSERT_EQUAL(serial.getReplicaStates()[j], exchange.getReplicaStates()[j]);
+    }
+}
+
+void testIdenticalStates(int numRanks) {
+    // When all states are identical, every exchange should be accepted.
+
+    const int numParticles = 5;
+    System system;
+    buildOscillators(system, numParticles);
+    LangevinMiddleIntegrator integrator(300.0, 10.0, 0.01);
+    MPIReplicaExchange exchange(MPI_COMM_WORLD, system, integrator, vector<double>(numRanks, 300.0), vector<map<string, double> >(), Platform::getPlatformByName("Reference"));
+    exchange.getContext().setPositions(randomPositions(numParticles, exchange.getLocalReplica()));
+    for (int i = 0; i < 10; i++)
+        exchange.attemptExchanges();
+    for (int i = 0; i < numRanks-1; i++) {
+        ASSERT_EQUAL(5, exchange.getNumAttempted(i));
+        ASSERT_EQUAL(5, exchange.getNumAccepted(i));
+    }
+}
+
+void testWrongNumberOfRanks(int numRanks) {
+    System system;
+    buildOscillators(system, 2);
+    LangevinMiddleIntegrator integrator(300.0, 10.0, 0.01);
+    bool threwException = false;
+    try {
+        MPIReplicaExchange exchange(MPI_COMM_WORLD, system, integrator, vector<double>(numRanks+1, 300.0), vector<map<string, double> >(), Platform::getPlatformByName("Reference"));
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+int main(int argc, char* argv[]) {
+    MPI_Init(&argc, &argv);
+    int rank, numRanks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &numRanks);
+    try {
+        if (numRanks < 2)
+            throw OpenMMException("This test must be run with at least two MPI ranks");
+        testTemperatureExchange(numRanks);
+        testHamiltonianExchange(numRanks);
+        testMatchesSerialExchange(numRanks);
+        testIdenticalStates(numRanks);
+        testWrongNumberOfRanks(numRanks);
+    }
+    catch(const exception& e) {
+        cout << "exception on rank " << rank << ": " << e.what() << endl;
+        MPI_Abort(MPI_COMM_WORLD, 1);
+        return 1;
+    }
+    MPI_Finalize();
+    if (rank == 0)
+        cout << "Done" << endl;
+    return 0;
+}
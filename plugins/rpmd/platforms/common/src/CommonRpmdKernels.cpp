@@ -151,6 +151,7 @@ void CommonIntegrateRPMDStepKernel::initialize(const System& system, const RPMDI
     velocitiesKernel = program->createKernel("advanceVelocities");
     copyToContextKernel = program->createKernel("copyDataToContext");
     copyFromContextKernel = program->createKernel("copyDataFromContext");
+    exchangeWithContextKernel = program->createKernel("exchangeDataWithContext");
     translateKernel = program->createKernel("applyCellTranslations");
     
     // Create kernels for doing contractions.
@@ -205,6 +206,16 @@ void CommonIntegrateRPMDStepKernel::initializeKernels(ContextImpl& context) {
     copyFromContextKernel->addArg();
     copyFromContextKernel->addArg(cc.getAtomIndexArray());
     copyFromContextKernel->addArg();
+    exchangeWithContextKernel->addArg(cc.getLongForceBuffer());
+    exchangeWithContextKernel->addArg();
+    exchangeWithContextKernel->addArg(cc.getVelm());
+    exchangeWithContextKernel->addArg(velocities);
+    exchangeWithContextKernel->addArg(cc.getPosq());
+    exchangeWithContextKernel->addArg();
+    exchangeWithContextKernel->addArg();
+    exchangeWithContextKernel->addArg(cc.getAtomIndexArray());
+    exchangeWithContextKernel->addArg();
+    exchangeWithContextKernel->addArg();
     for (auto& g : groupsByCopies) {
         int copies = g.first;
         positionContractionKernels[copies]->addArg(positions);
@@ -283,14 +294,17 @@ void CommonIntegrateRPMDStepKernel::execute(ContextImpl& context, const RPMDInte
 }
 
 void CommonIntegrateRPMDStepKernel::computeForces(ContextImpl& context) {
-    // Compute forces from all groups that didn't have a specified contraction.
+    // Compute forces from all groups that didn't have a specified contraction.  Retrieving the results for
+    // each copy and loading the next one are combined into a single kernel.
 
     copyToContextKernel->setArg(2, positions);
     copyFromContextKernel->setArg(1, forces);
     copyFromContextKernel->setArg(5, positions);
+    exchangeWithContextKernel->setArg(1, forces);
+    exchangeWithContextKernel->setArg(5, positions);
+    copyToContextKernel->setArg(5, 0);
+    copyToContextKernel->execute(cc.getNumAtoms());
     for (int i = 0; i < numCopies; i++) {
-        copyToContextKernel->setArg(5, i);
-        copyToContextKernel->execute(cc.getNumAtoms());
         context.computeVirtualSites();
         Vec3 initialBox[3];
         context.getPeriodicBoxVectors(initialBox[0], initialBox[1], initialBox[2]);
@@ -300,19 +314,22 @@ void CommonIntegrateRPMDStepKernel::computeForces(ContextImpl& context) {
         if (initialBox[0] != finalBox[0] || initialBox[1] != finalBox[1] || initialBox[2] != finalBox[2])
             throw OpenMMException("Standard barostats cannot be used with RPMDIntegrator.  Use RPMDMonteCarloBarostat instead.");
         context.calcForcesAndEnergy(true, false, groupsNotContracted);
-        copyFromContextKernel->setArg(7, i);
-        copyFromContextKernel->execute(cc.getNumAtoms());
+        copyFromContext(i, i+1 < numCopies ? i+1 : -1, positions);
     }
     
-    // Now loop over contractions and compute forces from them.
+    // Now loop over contractions and compute forces from them.  When the last contracted copy is retrieved,
+    // the last of the full copies is loaded back into the Context, since we'll assume that later.
     
     if (groupsByCopies.size() > 0) {
         copyToContextKernel->setArg(2, contractedPositions);
         copyFromContextKernel->setArg(1, contractedForces);
         copyFromContextKernel->setArg(5, contractedPositions);
+        exchangeWithContextKernel->setArg(1, contractedForces);
+        exchangeWithContextKernel->setArg(5, contractedPositions);
         for (auto& g : groupsByCopies) {
             int copies = g.first;
             int groupFlags = g.second;
+            bool isLastGroup = (copies == groupsByCopies.rbegin()->first);
 
             // Find the contracted positions.
 
@@ -320,13 +337,17 @@ void CommonIntegrateRPMDStepKernel::computeForces(ContextImpl& context) {
 
             // Compute forces.
 
+            copyToContextKernel->setArg(5, 0);
+            copyToContextKernel->execute(cc.getNumAtoms());
             for (int i = 0; i < copies; i++) {
-                copyToContextKernel->setArg(5, i);
-                copyToContextKernel->execute(cc.getNumAtoms());
                 context.computeVirtualSites();
                 context.calcForcesAndEnergy(true, false, groupFlags);
-                copyFromContextKernel->setArg(7, i);
-                copyFromContextKernel->execute(cc.getNumAtoms());
+                if (i+1 < copies)
+                    copyFromContext(i, i+1, contractedPositions);
+                else if (isLastGroup)
+                    copyFromContext(i, numCopies-1, positions);
+                else
+                    copyFromContext(i, -1, positions);
             }
 
             // Apply the forces to the original copies.
@@ -334,12 +355,18 @@ void CommonIntegrateRPMDStepKernel::computeForces(ContextImpl& context) {
             forceContractionKernels[copies]->execute(numParticles*numCopies, workgroupSize);
         }
     }
-    if (groupsByCopies.size() > 0) {
-        // Ensure the Context contains the positions from the last copy, since we'll assume that later.
-        
-        copyToContextKernel->setArg(2, positions);
-        copyToContextKernel->setArg(5, numCopies-1);
-        copyToContextKernel->execute(cc.getNumAtoms());
+}
+
+void CommonIntegrateRPMDStepKernel::copyFromContext(int copy, int nextCopy, ComputeArray& nextPositions) {
+    if (nextCopy == -1) {
+        copyFromContextKernel->setArg(7, copy);
+        copyFromContextKernel->execute(cc.getNumAtoms());
+    }
+    else {
+        exchangeWithContextKernel->setArg(6, nextPositions);
+        exchangeWithContextKernel->setArg(8, copy);
+        exchangeWithContextKernel->setArg(9, nextCopy);
+        exchangeWithContextKernel->execute(cc.getNumAtoms());
     }
 }
 
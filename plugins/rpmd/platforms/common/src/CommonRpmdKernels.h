@@ -86,6 +86,11 @@ public:
 private:
     void initializeKernels(ContextImpl& context);
     void computeForces(ContextImpl& context);
+    /**
+     * Copy the positions, velocities, and forces of a copy from the context to the integrator's arrays.  If
+     * nextCopy is not -1, that copy of nextPositions is then loaded into the context in the same kernel launch.
+     */
+    void copyFromContext(int copy, int nextCopy, ComputeArray& nextPositions);
     std::string createFFT(int size, const std::string& variable, bool forward);
     ComputeContext& cc;
     bool hasInitializedKernels;
@@ -97,7 +102,7 @@ private:
     ComputeArray velocities;
     ComputeArray contractedForces;
     ComputeArray contractedPositions;
-    ComputeKernel pileKernel, stepKernel, velocitiesKernel, copyToContextKernel, copyFromContextKernel, translateKernel;
+    ComputeKernel pileKernel, stepKernel, velocitiesKernel, copyToContextKernel, copyFromContextKernel, exchangeWithContextKernel, translateKernel;
     std::map<int, ComputeKernel> positionContractionKernels;
     std::map<int, ComputeKernel> forceContractionKernels;
 };
@@ -220,6 +220,35 @@ KERNEL void copyDataFromContext(GLOBAL mm_long* srcForce, GLOBAL mm_long* dstFor
     }
 }
 
+/**
+ * Copy the positions, velocities, and forces of one copy from the context to the integrator's arrays, then copy
+ * the positions and velocities of the next copy to the context.  This does the work of copyDataFromContext()
+ * and copyDataToContext() in a single launch.  The next copy may come from a different position array, so
+ * the last contracted copy can be followed directly by one of the full set of copies.
+ */
+KERNEL void exchangeDataWithContext(GLOBAL mm_long* contextForce, GLOBAL mm_long* force, GLOBAL mixed4* contextVel, GLOBAL mixed4* vel,
+        GLOBAL real4* contextPos, GLOBAL mixed4* pos, GLOBAL mixed4* nextPos, GLOBAL int* order, int fromCopy, int toCopy) {
+    const int fromBase = fromCopy*PADDED_NUM_ATOMS;
+    const int toBase = toCopy*PADDED_NUM_ATOMS;
+    for (int particle = GLOBAL_ID; particle < NUM_ATOMS; particle += GLOBAL_SIZE) {
+        int index = order[particle];
+        force[fromBase*3+index] = contextForce[particle];
+        force[fromBase*3+index+PADDED_NUM_ATOMS] = contextForce[particle+PADDED_NUM_ATOMS];
+        force[fromBase*3+index+PADDED_NUM_ATOMS*2] = contextForce[particle+PADDED_NUM_ATOMS*2];
+        vel[fromBase+index] = contextVel[particle];
+        real4 posq = contextPos[particle];
+        pos[fromBase+index].x = posq.x;
+        pos[fromBase+index].y = posq.y;
+        pos[fromBase+index].z = posq.z;
+        contextVel[particle] = vel[toBase+index];
+        mixed4 next = nextPos[toBase+index];
+        posq.x = next.x;
+        posq.y = next.y;
+        posq.z = next.z;
+        contextPos[particle] = posq;
+    }
+}
+
 /**
  * Atom positions in one copy have been modified.  Apply the same offsets to all the other copies.
  */
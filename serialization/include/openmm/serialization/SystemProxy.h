@@ -45,6 +45,11 @@ class OPENMM_EXPORT SystemProxy : public SerializationProxy {
 public:
     SystemProxy();
     void serialize(const void* object, SerializationNode& node) const;
+    /**
+     * Serialize a System, optionally omitting its Forces.  When includeForces is false, the
+     * node's "Forces" child is not created, so the caller can serialize the Forces separately.
+     */
+    void serialize(const void* object, SerializationNode& node, bool includeForces) const;
     void* deserialize(const SerializationNode& node) const;
 };
 
@@ -55,14 +55,7 @@ public:
      */
     template <class T>
     static void serialize(const T* object, const std::string& rootName, std::ostream& stream) {
-        const SerializationProxy& proxy = SerializationProxy::getProxy(typeid(*object));
-        SerializationNode node;
-        node.setName(rootName);
-        proxy.serialize(object, node);
-        if (node.hasProperty("type"))
-            throw OpenMMException(proxy.getTypeName()+" created node with reserved property 'type'");
-        node.setStringProperty("type", proxy.getTypeName());
-        serialize(node, stream);
+        serializeObject(SerializationProxy::getProxy(typeid(*object)), object, rootName, stream);
     }
     /**
      * Reconstruct an object that has been serialized as XML.
@@ -88,9 +81,10 @@ public:
     }
 private:
     class StreamReader;
+    class Writer;
+    static void serializeObject(const SerializationProxy& proxy, const void* object, const std::string& rootName, std::ostream& stream);
     static void serialize(const SerializationNode& node, std::ostream& stream);
     static void* deserializeStream(std::istream& stream);
-    static void encodeNode(const SerializationNode& node, std::ostream& stream, int depth);
 };
 
 } // namespace OpenMM
@@ -0,0 +1,301 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/serialization/BinarySerializer.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#if !defined(_WIN32) && !defined(__CYGWIN__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+using namespace OpenMM;
+using namespace std;
+
+static const char MAGIC[] = {'O', 'M', 'M', 'B'};
+static const unsigned int VERSION = 1;
+
+static void writeInt(ostream& stream, unsigned int value) {
+    unsigned char bytes[4] = {(unsigned char) value, (unsigned char) (value>>8), (unsigned char) (value>>16), (unsigned char) (value>>24)};
+    stream.write((char*) bytes, 4);
+}
+
+/**
+ * Write an integer in a variable length encoding: seven bits per byte, with the high bit set on
+ * every byte except the last.  Most values in a typical file fit in one byte.
+ */
+static void writeVarInt(ostream& stream, size_t value) {
+    unsigned char bytes[10];
+    int numBytes = 0;
+    while (value >= 0x80) {
+        bytes[numBytes++] = (unsigned char) (value|0x80);
+        value >>= 7;
+    }
+    bytes[numBytes++] = (unsigned char) value;
+    stream.write((char*) bytes, numBytes);
+}
+
+static void writeString(ostream& stream, const string& str) {
+    writeVarInt(stream, str.size());
+    stream.write(str.c_str(), str.size());
+}
+
+/**
+ * Assign an index to every node name and property name in a tree.
+ */
+static void buildStringTable(const SerializationNode& node, map<string, unsigned int>& table, vector<const string*>& strings) {
+    if (table.find(node.getName()) == table.end()) {
+        table[node.getName()] = strings.size();
+        strings.push_back(&node.getName());
+    }
+    for (auto& prop : node.getProperties())
+        if (table.find(prop.first) == table.end()) {
+            table[prop.first] = strings.size();
+            strings.push_back(&prop.first);
+        }
+    for (auto& child : node.getChildren())
+        buildStringTable(child, table, strings);
+}
+
+static void encodeNode(const SerializationNode& node, ostream& stream, const map<string, unsigned int>& table) {
+    writeVarInt(stream, table.at(node.getName()));
+    writeVarInt(stream, node.getProperties().size());
+    for (auto& prop : node.getProperties()) {
+        writeVarInt(stream, table.at(prop.first));
+        writeString(stream, prop.second);
+    }
+    writeVarInt(stream, node.getChildren().size());
+    for (auto& child : node.getChildren())
+        encodeNode(child, stream, table);
+}
+
+void BinarySerializer::serialize(const SerializationNode& node, ostream& stream) {
+    map<string, unsigned int> table;
+    vector<const string*> strings;
+    buildStringTable(node, table, strings);
+    stream.write(MAGIC, 4);
+    writeInt(stream, VERSION);
+    writeInt(stream, 0); // Flags, reserved for future use
+    writeVarInt(stream, strings.size());
+    for (const string* str : strings)
+        writeString(stream, *str);
+    encodeNode(node, stream, table);
+}
+
+/**
+ * This class decodes data from a buffer, checking that it never reads past the end.
+ */
+class BinaryNodeReader {
+public:
+    BinaryNodeReader(const char* data, size_t size) : data(data), size(size), pos(0) {
+    }
+    unsigned int readInt() {
+        checkAvailable(4);
+        const unsigned char* bytes = (const unsigned char*) data+pos;
+        pos += 4;
+        return bytes[0] | (bytes[1]<<8) | (bytes[2]<<16) | ((unsigned int) bytes[3]<<24);
+    }
+    size_t readVarInt() {
+        size_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            checkAvailable(1);
+            unsigned char byte = (unsigned char) data[pos++];
+            value |= ((size_t) (byte&0x7F))<<shift;
+            if ((byte&0x80) == 0)
+                return value;
+        }
+        throw OpenMMException("BinarySerializer: Illegal integer encoding");
+    }
+    void readString(string& str) {
+        size_t length = readVarInt();
+        checkAvailable(length);
+        str.assign(data+pos, length);
+        pos += length;
+    }
+    const string& readStringIndex(const vector<string>& strings) {
+        size_t index = readVarInt();
+        if (index >= strings.size())
+            throw OpenMMException("BinarySerializer: Illegal string index");
+        return strings[index];
+    }
+    void checkAvailable(size_t bytes) {
+        if (bytes > size-pos)
+            throw OpenMMException("BinarySerializer: Unexpected end of data");
+    }
+    const char* data;
+    size_t size, pos;
+};
+
+static void decodeNode(SerializationNode& node, BinaryNodeReader& reader, const vector<string>& strings) {
+    node.setName(reader.readStringIndex(strings));
+    size_t numProperties = reader.readVarInt();
+    string value;
+    for (size_t i = 0; i < numProperties; i++) {
+        const string& key = reader.readStringIndex(strings);
+        reader.readString(value);
+        node.setStringProperty(key, value);
+    }
+
+    // Each child takes at least three bytes, so this catches corrupted counts before allocating memory.
+
+    size_t numChildren = reader.readVarInt();
+    if (numChildren > reader.size/3)
+        throw OpenMMException("BinarySerializer: Unexpected end of data");
+    vector<SerializationNode>& children = node.getChildren();
+    children.resize(numChildren);
+    for (auto& child : children)
+        decodeNode(child, reader, strings);
+}
+
+bool BinarySerializer::isBinaryFormat(istream& stream) {
+    char header[4];
+    streampos start = stream.tellg();
+    stream.read(header, 4);
+    bool match = (stream.gcount() == 4 && memcmp(header, MAGIC, 4) == 0);
+    stream.clear();
+    stream.seekg(start);
+    return match;
+}
+
+static void decodeBuffer(SerializationNode& node, const char* data, size_t size) {
+    BinaryNodeReader reader(data, size);
+
+    // Check the header.
+
+    reader.checkAvailable(4);
+    if (memcmp(data, MAGIC, 4) != 0)
+        throw OpenMMException("BinarySerializer: The data is not in the binary serialization format");
+    reader.pos = 4;
+    if (reader.readInt() != VERSION)
+        throw OpenMMException("BinarySerializer: Unsupported version number");
+    if (reader.readInt() != 0)
+        throw OpenMMException("BinarySerializer: Unsupported format flags");
+
+    // Read the string table, then the nodes.
+
+    size_t numStrings = reader.readVarInt();
+    if (numStrings > reader.size)
+        throw OpenMMException("BinarySerializer: Unexpected end of data");
+    vector<string> strings(numStrings);
+    for (auto& str : strings)
+        reader.readString(str);
+    decodeNode(node, reader, strings);
+}
+
+/**
+ * This class maps a file into memory for reading, and unmaps it when it is deleted.  On
+ * platforms without mmap(), it falls back to reading the file into a buffer.
+ */
+class MappedFile {
+public:
+    MappedFile(const string& filename) : data(NULL), size(0) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+        ifstream stream(filename.c_str(), ios_base::in | ios_base::binary);
+        if (!stream.is_open())
+            throw OpenMMException("BinarySerializer: Cannot open file "+filename);
+        stream.seekg(0, ios_base::end);
+        buffer.resize(stream.tellg());
+        stream.seekg(0);
+        stream.read(buffer.data(), buffer.size());
+        if (stream.gcount() != buffer.size())
+            throw OpenMMException("BinarySerializer: Error reading file "+filename);
+        data = buffer.data();
+        size = buffer.size();
+#else
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd == -1)
+            throw OpenMMException("BinarySerializer: Cannot open file "+filename);
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            throw OpenMMException("BinarySerializer: Error reading file "+filename);
+        }
+        size = info.st_size;
+        if (size > 0) {
+            void* mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                close(fd);
+                throw OpenMMException("BinarySerializer: Error mapping file "+filename);
+            }
+            madvise(mapped, size, MADV_SEQUENTIAL);
+            data = (const char*) mapped;
+        }
+        close(fd);
+#endif
+    }
+    ~MappedFile() {
+#if !defined(_WIN32) && !defined(__CYGWIN__)
+        if (data != NULL)
+            munmap((void*) data, size);
+#endif
+    }
+    const char* data;
+    size_t size;
+private:
+    vector<char> buffer;
+};
+
+void BinarySerializer::deserialize(SerializationNode& node, istream& stream) {
+    // Reading the whole stream into memory at once is much faster than reading it piece by piece.
+
+    streampos start = stream.tellg();
+    stream.seekg(0, ios_base::end);
+    size_t size = stream.tellg()-start;
+    stream.seekg(start);
+    vector<char> buffer(size);
+    stream.read(buffer.data(), size);
+    if (stream.gcount() != size)
+        throw OpenMMException("BinarySerializer: Error reading from stream");
+    decodeBuffer(node, buffer.data(), buffer.size());
+}
+
+void BinarySerializer::deserializeFile(SerializationNode& node, const string& filename) {
+    MappedFile file(filename);
+    decodeBuffer(node, file.data, file.size);
+}
+
+void* BinarySerializer::deserializeStream(istream& stream) {
+    SerializationNode root;
+    deserialize(root, stream);
+    const SerializationProxy& proxy = SerializationProxy::getProxy(root.getStringProperty("type"));
+    return proxy.deserialize(root);
+}
+
+void* BinarySerializer::deserializeFileToObject(const string& filename) {
+    SerializationNode root;
+    deserializeFile(root, filename);
+    const SerializationProxy& proxy = SerializationProxy::getProxy(root.getStringProperty("type"));
+    return proxy.deserialize(root);
+}
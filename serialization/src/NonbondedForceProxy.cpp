@@ -42,7 +42,7 @@ NonbondedForceProxy::NonbondedForceProxy() : SerializationProxy("NonbondedForce"
 }
 
 void NonbondedForceProxy::serialize(const void* object, SerializationNode& node) const {
-    node.setIntProperty("version", 4);
+    node.setIntProperty("version", 7);
     const NonbondedForce& force = *reinterpret_cast<const NonbondedForce*>(object);
     node.setIntProperty("forceGroup", force.getForceGroup());
     node.setStringProperty("name", force.getName());
@@ -55,6 +55,7 @@ void NonbondedForceProxy::serialize(const void* object, SerializationNode& node)
     node.setIntProperty("dispersionCorrection", force.getUseDispersionCorrection());
     node.setIntProperty("exceptionsUsePeriodic", force.getExceptionsUsePeriodicBoundaryConditions());
     node.setBoolProperty("includeDirectSpace", force.getIncludeDirectSpace());
+    node.setStringProperty("soluteScaleParameter", force.getSoluteScaleParameter());
     double alpha;
     int nx, ny, nz;
     force.getPMEParameters(alpha, nx, ny, nz);
@@ -100,11 +101,40 @@ void NonbondedForceProxy::serialize(const void* object, SerializationNode& node)
         force.getExceptionParameters(i, particle1, particle2, chargeProd, sigma, epsilon);
         exceptions.createChildNode("Exception").setIntProperty("p1", particle1).setIntProperty("p2", particle2).setDoubleProperty("q", chargeProd).setDoubleProperty("sig", sigma).setDoubleProperty("eps", epsilon);
     }
+    SerializationNode& solute = node.createChildNode("SoluteParticles");
+    for (int particle : force.getSoluteParticles())
+        solute.createChildNode("Particle").setIntProperty("index", particle);
+    SerializationNode& sites = node.createChildNode("TitrationSites");
+    for (int i = 0; i < force.getNumTitrationSites(); i++) {
+        string parameter;
+        vector<int> siteParticles;
+        force.getTitrationSiteParameters(i, parameter, siteParticles);
+        SerializationNode& site = sites.createChildNode("Site").setStringProperty("parameter", parameter);
+        SerializationNode& particleIndices = site.createChildNode("Particles");
+        for (int particle : siteParticles)
+            particleIndices.createChildNode("Particle").setIntProperty("index", particle);
+        SerializationNode& states = site.createChildNode("States");
+        for (int j = 1; j < force.getNumTitrationStates(i); j++) {
+            vector<double> charges, sigmas, epsilons;
+            force.getTitrationStateParameters(i, j, charges, sigmas, epsilons);
+            SerializationNode& state = states.createChildNode("State");
+            for (int k = 0; k < charges.size(); k++)
+                state.createChildNode("Particle").setDoubleProperty("q", charges[k]).setDoubleProperty("sig", sigmas[k]).setDoubleProperty("eps", epsilons[k]);
+        }
+        SerializationNode& stateExceptions = site.createChildNode("Exceptions");
+        for (int j = 1; j < force.getNumTitrationStates(i); j++)
+            for (int k = 0; k < force.getNumTitrationStateExceptions(i, j); k++) {
+                int exception;
+                double chargeProd, sigma, epsilon;
+                force.getTitrationStateExceptionParameters(i, j, k, exception, chargeProd, sigma, epsilon);
+                stateExceptions.createChildNode("Exception").setIntProperty("state", j).setIntProperty("index", exception).setDoubleProperty("q", chargeProd).setDoubleProperty("sig", sigma).setDoubleProperty("eps", epsilon);
+            }
+    }
 }
 
 void* NonbondedForceProxy::deserialize(const SerializationNode& node) const {
     int version = node.getIntProperty("version");
-    if (version < 1 || version > 4)
+    if (version < 1 || version > 7)
         throw OpenMMException("Unsupported version number");
     NonbondedForce* force = new NonbondedForce();
     try {
@@ -145,12 +175,43 @@ void* NonbondedForceProxy::deserialize(const SerializationNode& node) const {
         }
         if (version >= 4)
             force->setExceptionsUsePeriodicBoundaryConditions(node.getIntProperty("exceptionsUsePeriodic"));
+        if (version >= 5) {
+            force->setSoluteScaleParameter(node.getStringProperty("soluteScaleParameter"));
+            vector<int> solute;
+            for (auto& particle : node.getChildNode("SoluteParticles").getChildren())
+                solute.push_back(particle.getIntProperty("index"));
+            force->setSoluteParticles(solute);
+        }
+        if (version >= 6) {
+            for (auto& site : node.getChildNode("TitrationSites").getChildren()) {
+                vector<int> siteParticles;
+                for (auto& particle : site.getChildNode("Particles").getChildren())
+                    siteParticles.push_back(particle.getIntProperty("index"));
+                int index = force->addTitrationSite(site.getStringProperty("parameter"), siteParticles);
+                for (auto& state : site.getChildNode("States").getChildren()) {
+                    vector<double> charges, sigmas, epsilons;
+                    for (auto& particle : state.getChildren()) {
+                        charges.push_back(particle.getDoubleProperty("q"));
+                        sigmas.push_back(particle.getDoubleProperty("sig"));
+                        epsilons.push_back(particle.getDoubleProperty("eps"));
+                    }
+                    force->addTitrationState(index, charges, sigmas, epsilons);
+                }
+            }
+        }
         const SerializationNode& particles = node.getChildNode("Particles");
         for (auto& particle : particles.getChildren())
             force->addParticle(particle.getDoubleProperty("q"), particle.getDoubleProperty("sig"), particle.getDoubleProperty("eps"));
         const SerializationNode& exceptions = node.getChildNode("Exceptions");
         for (auto& exception : exceptions.getChildren())
             force->addException(exception.getIntProperty("p1"), exception.getIntProperty("p2"), exception.getDoubleProperty("q"), exception.getDoubleProperty("sig"), exception.getDoubleProperty("eps"));
+        if (version >= 7) {
+            const vector<SerializationNode>& sites = node.getChildNode("TitrationSites").getChildren();
+            for (int i = 0; i < sites.size(); i++)
+                for (auto& exception : sites[i].getChildNode("Exceptions").getChildren())
+                    force->setTitrationStateExceptionParameters(i, exception.getIntProperty("state"), exception.getIntProperty("index"),
+                            exception.getDoubleProperty("q"), exception.getDoubleProperty("sig"), exception.getDoubleProperty("eps"));
+        }
     }
     catch (...) {
         delete force;
@@ -42,11 +42,12 @@ PeriodicTorsionForceProxy::PeriodicTorsionForceProxy() : SerializationProxy("Per
 }
 
 void PeriodicTorsionForceProxy::serialize(const void* object, SerializationNode& node) const {
-    node.setIntProperty("version", 2);
+    node.setIntProperty("version", 3);
     const PeriodicTorsionForce& force = *reinterpret_cast<const PeriodicTorsionForce*>(object);
     node.setIntProperty("forceGroup", force.getForceGroup());
     node.setStringProperty("name", force.getName());
     node.setBoolProperty("usesPeriodic", force.usesPeriodicBoundaryConditions());
+    node.setStringProperty("soluteScaleParameter", force.getSoluteScaleParameter());
     SerializationNode& torsions = node.createChildNode("Torsions");
     for (int i = 0; i < force.getNumTorsions(); i++) {
         int particle1, particle2, particle3, particle4, periodicity;
@@ -54,11 +55,14 @@ void PeriodicTorsionForceProxy::serialize(const void* object, SerializationNode&
         force.getTorsionParameters(i, particle1, particle2, particle3, particle4, periodicity, phase, k);
         torsions.createChildNode("Torsion").setIntProperty("p1", particle1).setIntProperty("p2", particle2).setIntProperty("p3", particle3).setIntProperty("p4", particle4).setIntProperty("periodicity", periodicity).setDoubleProperty("phase", phase).setDoubleProperty("k", k);
     }
+    SerializationNode& solute = node.createChildNode("SoluteParticles");
+    for (int particle : force.getSoluteParticles())
+        solute.createChildNode("Particle").setIntProperty("index", particle);
 }
 
 void* PeriodicTorsionForceProxy::deserialize(const SerializationNode& node) const {
     int version = node.getIntProperty("version");
-    if (version < 1 || version > 2)
+    if (version < 1 || version > 3)
         throw OpenMMException("Unsupported version number");
     PeriodicTorsionForce* force = new PeriodicTorsionForce();
     try {
@@ -70,6 +74,13 @@ void* PeriodicTorsionForceProxy::deserialize(const SerializationNode& node) cons
         for (auto& torsion : torsions.getChildren())
             force->addTorsion(torsion.getIntProperty("p1"), torsion.getIntProperty("p2"), torsion.getIntProperty("p3"), torsion.getIntProperty("p4"),
                     torsion.getIntProperty("periodicity"), torsion.getDoubleProperty("phase"), torsion.getDoubleProperty("k"));
+        if (version > 2) {
+            force->setSoluteScaleParameter(node.getStringProperty("soluteScaleParameter"));
+            vector<int> solute;
+            for (auto& particle : node.getChildNode("SoluteParticles").getChildren())
+                solute.push_back(particle.getIntProperty("index"));
+            force->setSoluteParticles(solute);
+        }
     }
     catch (...) {
         delete force;
@@ -31,6 +31,7 @@
 
 #include "openmm/serialization/SerializationNode.h"
 #include "openmm/OpenMMException.h"
+#include <cstdlib>
 #include <sstream>
 
 using namespace OpenMM;
@@ -100,24 +101,18 @@ int SerializationNode::getIntProperty(const string& name) const {
     map<string, string>::const_iterator iter = properties.find(name);
     if (iter == properties.end())
         throw OpenMMException("Unknown property '"+name+"' in node '"+getName()+"'");
-    int value;
-    stringstream(iter->second) >> value;
-    return value;
+    return (int) strtol(iter->second.c_str(), NULL, 10);
 }
 
 int SerializationNode::getIntProperty(const string& name, int defaultValue) const {
     map<string, string>::const_iterator iter = properties.find(name);
     if (iter == properties.end())
         return defaultValue;
-    int value;
-    stringstream(iter->second) >> value;
-    return value;
+    return (int) strtol(iter->second.c_str(), NULL, 10);
 }
 
 SerializationNode& SerializationNode::setIntProperty(const string& name, int value) {
-    stringstream s;
-    s << value;
-    properties[name] = s.str();
+    properties[name] = to_string(value);
     return *this;
 }
 
@@ -125,24 +120,18 @@ long long SerializationNode::getLongProperty(const string& name) const {
     map<string, string>::const_iterator iter = properties.find(name);
     if (iter == properties.end())
         throw OpenMMException("Unknown property '"+name+"' in node '"+getName()+"'");
-    long long value;
-    stringstream(iter->second) >> value;
-    return value;
+    return strtoll(iter->second.c_str(), NULL, 10);
 }
 
 long long SerializationNode::getLongProperty(const string& name, long long defaultValue) const {
     map<string, string>::const_iterator iter = properties.find(name);
     if (iter == properties.end())
         return defaultValue;
-    long long value;
-    stringstream(iter->second) >> value;
-    return value;
+    return strtoll(iter->second.c_str(), NULL, 10);
 }
 
 SerializationNode& SerializationNode::setLongProperty(const string& name, long long value) {
-    stringstream s;
-    s << value;
-    properties[name] = s.str();
+    properties[name] = to_string(value);
     return *this;
 }
 
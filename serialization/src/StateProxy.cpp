@@ -66,6 +66,11 @@ void StateProxy::serialize(const void* object, SerializationNode& node) const {
         energiesNode.setDoubleProperty("PotentialEnergy", s.getPotentialEnergy());
         energiesNode.setDoubleProperty("KineticEnergy", s.getKineticEnergy());
     }
+    if ((s.getDataTypes()&State::GroupEnergies) != 0) {
+        SerializationNode& groupEnergiesNode = node.createChildNode("GroupEnergies");
+        for (double energy : s.getGroupEnergies())
+            groupEnergiesNode.createChildNode("Group").setDoubleProperty("energy", energy);
+    }
     if ((s.getDataTypes()&State::Positions) != 0) {
         s.getPositions();
         SerializationNode& positionsNode = node.createChildNode("Positions");
@@ -122,6 +127,12 @@ void* StateProxy::deserialize(const SerializationNode& node) const {
             double kineticEnergy = child.getDoubleProperty("KineticEnergy");
             builder.setEnergy(kineticEnergy, potentialEnergy);
         }
+        else if (child.getName() == "GroupEnergies") {
+            vector<double> groupEnergies;
+            for (auto& group : child.getChildren())
+                groupEnergies.push_back(group.getDoubleProperty("energy"));
+            builder.setGroupEnergies(groupEnergies);
+        }
         else if (child.getName() == "Positions") {
             vector<Vec3> outPositions;
             for (auto& particle : child.getChildren())
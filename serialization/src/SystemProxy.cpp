@@ -44,6 +44,10 @@ SystemProxy::SystemProxy() : SerializationProxy("System") {
 }
 
 void SystemProxy::serialize(const void* object, SerializationNode& node) const {
+    serialize(object, node, true);
+}
+
+void SystemProxy::serialize(const void* object, SerializationNode& node, bool includeForces) const {
     node.setIntProperty("version", 1);
     node.setStringProperty("openmmVersion", Platform::getOpenMMVersion());
     const System& system = *reinterpret_cast<const System*>(object);
@@ -99,9 +103,22 @@ void SystemProxy::serialize(const void* object, SerializationNode& node) const {
         system.getConstraintParameters(i, particle1, particle2, distance);
         constraints.createChildNode("Constraint").setIntProperty("p1", particle1).setIntProperty("p2", particle2).setDoubleProperty("d", distance);
     }
-    SerializationNode& forces = node.createChildNode("Forces");
-    for (int i = 0; i < system.getNumForces(); i++)
-        forces.createChildNode("Force", &system.getForce(i));
+    if (system.getNumMoleculeTypes() > 0) {
+        SerializationNode& moleculeTypes = node.createChildNode("MoleculeTypes");
+        for (int i = 0; i < system.getNumMoleculeTypes(); i++) {
+            int numParticles;
+            vector<int> firstParticles;
+            system.getMoleculeTypeParameters(i, numParticles, firstParticles);
+            SerializationNode& type = moleculeTypes.createChildNode("MoleculeType").setIntProperty("size", numParticles);
+            for (int first : firstParticles)
+                type.createChildNode("Instance").setIntProperty("first", first);
+        }
+    }
+    if (includeForces) {
+        SerializationNode& forces = node.createChildNode("Forces");
+        for (int i = 0; i < system.getNumForces(); i++)
+            forces.createChildNode("Force", &system.getForce(i));
+    }
 }
 
 void* SystemProxy::deserialize(const SerializationNode& node) const {
@@ -150,6 +167,14 @@ void* SystemProxy::deserialize(const SerializationNode& node) const {
         const SerializationNode& constraints = node.getChildNode("Constraints");
         for (auto& constraint : constraints.getChildren())
             system->addConstraint(constraint.getIntProperty("p1"), constraint.getIntProperty("p2"), constraint.getDoubleProperty("d"));
+        for (auto& child : node.getChildren())
+            if (child.getName() == "MoleculeTypes")
+                for (auto& type : child.getChildren()) {
+                    vector<int> firstParticles;
+                    for (auto& instance : type.getChildren())
+                        firstParticles.push_back(instance.getIntProperty("first"));
+                    system->addMoleculeType(type.getIntProperty("size"), firstParticles);
+                }
         const SerializationNode& forces = node.getChildNode("Forces");
         for (auto& force : forces.getChildren())
             system->addForce(force.decodeObject<Force>());
@@ -30,10 +30,15 @@
  * -------------------------------------------------------------------------- */
 
 #include "openmm/serialization/XmlSerializer.h"
+#include "openmm/serialization/SystemProxy.h"
+#include "openmm/internal/ThreadPool.h"
+#include "openmm/Force.h"
+#include "openmm/System.h"
 #include "irrXML.h"
 #include <cstring>
 #include <iostream>
 #include <map>
+#include <memory>
 
 using namespace OpenMM;
 using namespace std;
@@ -41,20 +46,22 @@ using namespace irr;
 using namespace io;
 
 /**
- * Apply XML encoding to a string.  This is adapted from TinyXML (written by Lee Thomason).
+ * Apply XML encoding to a string, appending the result to outString.  This is adapted from
+ * TinyXML (written by Lee Thomason).
  */
-static void encodeString(const string& str, string* outString) {
-    static map<char, string> entities;
-    static bool hasInitialized = false;
-    if (!hasInitialized) {
-        hasInitialized = true;
-	entities['&'] = "&amp;";
-	entities['<'] = "&lt;";
-	entities['>'] = "&gt;";
-	entities['\"'] = "&quot;";
-	entities['\''] = "&apos;";
-    }
+static void encodeString(const string& str, string& outString) {
+    // Most strings contain nothing that needs to be encoded, so check for that first.
 
+    bool needsEncoding = false;
+    for (char c : str)
+        if (c == '&' || c == '<' || c == '>' || c == '\"' || c == '\'' || (unsigned char) c < 32) {
+            needsEncoding = true;
+            break;
+        }
+    if (!needsEncoding) {
+        outString += str;
+        return;
+    }
     int i=0;
 
     while (i<(int)str.length()) {
@@ -75,14 +82,30 @@ static void encodeString(const string& str, string* outString) {
             // However, there is no mechanism (currently) for
             // this function to return an error.
             while (i<(int)str.length()-1) {
-                outString->append(str.c_str() + i, 1);
+                outString.append(str.c_str() + i, 1);
                 ++i;
                 if (str[i] == ';')
                     break;
             }
         }
-        else if (entities.find(c) != entities.end()) {
-            outString->append(entities[c]);
+        else if (c == '&') {
+            outString += "&amp;";
+            ++i;
+        }
+        else if (c == '<') {
+            outString += "&lt;";
+            ++i;
+        }
+        else if (c == '>') {
+            outString += "&gt;";
+            ++i;
+        }
+        else if (c == '\"') {
+            outString += "&quot;";
+            ++i;
+        }
+        else if (c == '\'') {
+            outString += "&apos;";
             ++i;
         }
         else if (c < 32) {
@@ -91,47 +114,161 @@ static void encodeString(const string& str, string* outString) {
             char buf[ 32 ];
 
             sprintf(buf, "&#x%02X;", (unsigned) (c & 0xff));
-
-            //*ME:	warning C4267: convert 'size_t' to 'int'
-            //*ME:	Int-Cast to make compiler happy ...
-            outString->append(buf, (int)strlen(buf));
+            outString.append(buf, (int)strlen(buf));
             ++i;
         }
         else {
-            //char realc = (char) c;
-            //outString->append(&realc, 1);
-            *outString += (char) c;	// somewhat more efficient function call.
+            outString += (char) c;
             ++i;
         }
     }
 }
 
-void XmlSerializer::serialize(const SerializationNode& node, std::ostream& stream) {
-    stream << "<?xml version=\"1.0\" ?>\n";
-    encodeNode(node, stream, 0);
-}
-
-void XmlSerializer::encodeNode(const SerializationNode& node, std::ostream& stream, int depth) {
-    for (int i = 0; i < depth; i++)
-        stream << '\t';
-    stream << '<' << node.getName();
+/**
+ * Append the start of the tag for a node, including its properties, to a string.  The caller
+ * must append the end of the tag.
+ */
+static void encodeStartTag(const SerializationNode& node, string& out, int depth) {
+    out.append(depth, '\t');
+    out += '<';
+    out += node.getName();
     for (auto& prop : node.getProperties()) {
-        string name, value;
-        encodeString(prop.first, &name);
-        encodeString(prop.second, &value);
-        stream << ' ' << name << "=\"" << value << '\"';
+        out += ' ';
+        encodeString(prop.first, out);
+        out += "=\"";
+        encodeString(prop.second, out);
+        out += '\"';
     }
+}
+
+/**
+ * Append the XML for a node and all its children to a string.
+ */
+static void encodeNode(const SerializationNode& node, string& out, int depth) {
+    encodeStartTag(node, out, depth);
     const vector<SerializationNode>& children = node.getChildren();
     if (children.size() == 0)
-        stream << "/>\n";
+        out += "/>\n";
     else {
-        stream << ">\n";
+        out += ">\n";
         for (auto& child : children)
-            encodeNode(child, stream, depth+1);
-        for (int i = 0; i < depth; i++)
-            stream << '\t';
-        stream << "</" << node.getName() << ">\n";
+            encodeNode(child, out, depth+1);
+        out.append(depth, '\t');
+        out += "</";
+        out += node.getName();
+        out += ">\n";
+    }
+}
+
+/**
+ * This class writes SerializationNodes to a stream.  Output is collected in a buffer that is
+ * written whenever it grows large.  When a node has many children, such as the list of
+ * particles in a large System, they are encoded in parallel in fixed size chunks, so the
+ * extra memory needed does not depend on the number of children.
+ */
+class XmlSerializer::Writer {
+public:
+    Writer(ostream& stream) : stream(stream) {
+    }
+    ~Writer() {
+        flush();
+    }
+    void write(const SerializationNode& node, int depth) {
+        const vector<SerializationNode>& children = node.getChildren();
+        if (children.size() < ParallelThreshold) {
+            encodeNode(node, buffer, depth);
+            if (buffer.size() > BufferSize)
+                flush();
+            return;
+        }
+        encodeStartTag(node, buffer, depth);
+        buffer += ">\n";
+        flush();
+        if (threads == nullptr)
+            threads.reset(new ThreadPool());
+        int numThreads = threads->getNumThreads();
+        vector<string> chunks(numThreads);
+        int numChildren = children.size();
+        for (int start = 0; start < numChildren; start += numThreads*ChunkSize) {
+            threads->execute([&] (ThreadPool& pool, int threadIndex) {
+                string& chunk = chunks[threadIndex];
+                chunk.clear();
+                int first = start+threadIndex*ChunkSize;
+                int last = min(numChildren, first+ChunkSize);
+                for (int i = first; i < last; i++)
+                    encodeNode(children[i], chunk, depth+1);
+            });
+            threads->waitForThreads();
+            for (auto& chunk : chunks)
+                stream.write(chunk.data(), chunk.size());
+        }
+        buffer.append(depth, '\t');
+        buffer += "</";
+        buffer += node.getName();
+        buffer += ">\n";
+    }
+    void writeStartTag(const SerializationNode& node, int depth) {
+        encodeStartTag(node, buffer, depth);
+        buffer += ">\n";
+    }
+    void writeText(const string& text) {
+        buffer += text;
+    }
+    void flush() {
+        stream.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+private:
+    static const int ParallelThreshold = 10000;
+    static const int ChunkSize = 2000;
+    static const int BufferSize = 1<<20;
+    ostream& stream;
+    string buffer;
+    unique_ptr<ThreadPool> threads;
+};
+
+void XmlSerializer::serializeObject(const SerializationProxy& proxy, const void* object, const string& rootName, ostream& stream) {
+    SerializationNode node;
+    node.setName(rootName);
+    const SystemProxy* systemProxy = dynamic_cast<const SystemProxy*>(&proxy);
+    if (systemProxy != NULL)
+        systemProxy->serialize(object, node, false);
+    else
+        proxy.serialize(object, node);
+    if (node.hasProperty("type"))
+        throw OpenMMException(proxy.getTypeName()+" created node with reserved property 'type'");
+    node.setStringProperty("type", proxy.getTypeName());
+    if (systemProxy == NULL) {
+        serialize(node, stream);
+        return;
+    }
+
+    // For a System, write everything except the Forces first.  Then serialize and write
+    // the Forces one at a time, so the full tree for the System never needs to be in memory.
+
+    const System& system = *reinterpret_cast<const System*>(object);
+    Writer writer(stream);
+    writer.writeText("<?xml version=\"1.0\" ?>\n");
+    writer.writeStartTag(node, 0);
+    for (auto& child : node.getChildren())
+        writer.write(child, 1);
+    if (system.getNumForces() == 0)
+        writer.writeText("\t<Forces/>\n");
+    else {
+        writer.writeText("\t<Forces>\n");
+        for (int i = 0; i < system.getNumForces(); i++) {
+            SerializationNode forces;
+            writer.write(forces.createChildNode("Force", &system.getForce(i)), 2);
+        }
+        writer.writeText("\t</Forces>\n");
     }
+    writer.writeText("</"+node.getName()+">\n");
+}
+
+void XmlSerializer::serialize(const SerializationNode& node, std::ostream& stream) {
+    Writer writer(stream);
+    writer.writeText("<?xml version=\"1.0\" ?>\n");
+    writer.write(node, 0);
 }
 
 /**
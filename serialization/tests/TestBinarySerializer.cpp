@@ -0,0 +1,176 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/LangevinIntegrator.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/System.h"
+#include "openmm/serialization/BinarySerializer.h"
+#include "openmm/serialization/XmlSerializer.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * Serialize an object in binary format, deserialize it, and confirm that it produces
+ * identical XML to the original.  This returns the ratio of the binary size to the XML size.
+ */
+template <class T>
+double checkRoundTrip(const T& object, const string& rootName) {
+    stringstream binary(ios_base::out | ios_base::in | ios_base::binary);
+    BinarySerializer::serialize<T>(&object, rootName, binary);
+    ASSERT(BinarySerializer::isBinaryFormat(binary));
+    T* copy = BinarySerializer::deserialize<T>(binary);
+    stringstream xml1, xml2;
+    XmlSerializer::serialize<T>(&object, rootName, xml1);
+    XmlSerializer::serialize<T>(copy, rootName, xml2);
+    ASSERT_EQUAL(xml1.str(), xml2.str());
+    delete copy;
+    return binary.str().size()/(double) xml1.str().size();
+}
+
+void testSerialization() {
+    const int numParticles = 100;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(3, 0, 0), Vec3(0, 3, 0), Vec3(0, 0, 3));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::PME);
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    vector<Vec3> positions;
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0+0.1*i);
+        nonbonded->addParticle(i%2 == 0 ? 0.3 : -0.3, 0.2+0.001*i, 0.5);
+        if (i > 0 && i%2 == 1) {
+            bonds->addBond(i-1, i, 0.1, 1000.0);
+            nonbonded->addException(i-1, i, 0.0, 1.0, 0.0);
+        }
+        positions.push_back(Vec3((i%5)*0.6, ((i/5)%5)*0.6, (i/25)*0.6+0.05*(i%2)));
+    }
+    system.addForce(nonbonded);
+    system.addForce(bonds);
+    LangevinIntegrator integrator(300.0, 1.0, 0.002);
+    Context context(system, integrator, Platform::getPlatformByName("Reference"));
+    context.setPositions(positions);
+    State state = context.getState(State::Positions | State::Velocities | State::Forces | State::Energy);
+    ASSERT(checkRoundTrip(system, "System") < 0.8);
+    checkRoundTrip(integrator, "Integrator");
+    checkRoundTrip(state, "State");
+}
+
+void testFile() {
+    System system;
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    for (int i = 0; i < 1000; i++) {
+        system.addParticle(1.0+0.01*i);
+        if (i > 0)
+            bonds->addBond(i-1, i, 0.1+0.0001*i, 1000.0);
+    }
+    system.addForce(bonds);
+    string filename = "TestBinarySerializer.bin";
+    ofstream output(filename.c_str(), ios_base::out | ios_base::binary);
+    BinarySerializer::serialize<System>(&system, "System", output);
+    output.close();
+    System* copy = BinarySerializer::deserializeFile<System>(filename);
+    remove(filename.c_str());
+    stringstream xml1, xml2;
+    XmlSerializer::serialize<System>(&system, "System", xml1);
+    XmlSerializer::serialize<System>(copy, "System", xml2);
+    ASSERT_EQUAL(xml1.str(), xml2.str());
+    delete copy;
+
+    // A missing file should throw an exception.
+
+    bool threwException = false;
+    try {
+        delete BinarySerializer::deserializeFile<System>(filename);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+void testInvalidData() {
+    System system;
+    system.addParticle(1.0);
+    system.addForce(new HarmonicBondForce());
+    stringstream binary(ios_base::out | ios_base::in | ios_base::binary);
+    BinarySerializer::serialize<System>(&system, "System", binary);
+    string data = binary.str();
+
+    // XML should not be recognized as binary data.
+
+    stringstream xml;
+    XmlSerializer::serialize<System>(&system, "System", xml);
+    ASSERT(!BinarySerializer::isBinaryFormat(xml));
+    bool threwException = false;
+    try {
+        delete BinarySerializer::deserialize<System>(xml);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+
+    // Truncated data should throw an exception.
+
+    for (int length : {3, 10, (int) data.size()/2, (int) data.size()-1}) {
+        stringstream truncated(data.substr(0, length), ios_base::in | ios_base::binary);
+        threwException = false;
+        try {
+            delete BinarySerializer::deserialize<System>(truncated);
+        }
+        catch (const OpenMMException& ex) {
+            threwException = true;
+        }
+        ASSERT(threwException);
+    }
+}
+
+int main() {
+    try {
+        testSerialization();
+        testFile();
+        testInvalidData();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
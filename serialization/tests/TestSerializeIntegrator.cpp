@@ -36,6 +36,7 @@
 #include "openmm/CustomIntegrator.h"
 #include "openmm/LangevinIntegrator.h"
 #include "openmm/LangevinMiddleIntegrator.h"
+#include "openmm/MTSLangevinIntegrator.h"
 #include "openmm/VariableLangevinIntegrator.h"
 #include "openmm/VariableVerletIntegrator.h"
 #include "openmm/VerletIntegrator.h"
@@ -97,6 +98,27 @@ void testSerializeLangevinMiddleIntegrator() {
     delete intg2;
 }
 
+void testSerializeMTSLangevinIntegrator() {
+    MTSLangevinIntegrator *intg = new MTSLangevinIntegrator(372.4, 1.234, 0.004, {{0, 1}, {2, 2}, {1, 8}});
+    intg->setRandomNumberSeed(10);
+    intg->setConstraintTolerance(1e-6);
+    stringstream ss;
+    XmlSerializer::serialize<Integrator>(intg, "MTSLangevinIntegrator", ss);
+    MTSLangevinIntegrator *intg2 = dynamic_cast<MTSLangevinIntegrator*>(XmlSerializer::deserialize<Integrator>(ss));
+    ASSERT_EQUAL(intg->getConstraintTolerance(), intg2->getConstraintTolerance());
+    ASSERT_EQUAL(intg->getStepSize(), intg2->getStepSize());
+    ASSERT_EQUAL(intg->getTemperature(), intg2->getTemperature());
+    ASSERT_EQUAL(intg->getFriction(), intg2->getFriction());
+    ASSERT_EQUAL(intg->getRandomNumberSeed(), intg2->getRandomNumberSeed());
+    ASSERT_EQUAL(intg->getGroups().size(), intg2->getGroups().size());
+    for (int i = 0; i < intg->getGroups().size(); i++) {
+        ASSERT_EQUAL(intg->getGroups()[i].first, intg2->getGroups()[i].first);
+        ASSERT_EQUAL(intg->getGroups()[i].second, intg2->getGroups()[i].second);
+    }
+    delete intg;
+    delete intg2;
+}
+
 void testSerializeBrownianIntegrator() {
     BrownianIntegrator *intg = new BrownianIntegrator(243.1, 3.234, 0.0021);
     intg->setRandomNumberSeed(10);
@@ -281,6 +303,7 @@ int main() {
         testSerializeVariableVerletIntegrator();
         testSerializeLangevinIntegrator();
         testSerializeLangevinMiddleIntegrator();
+        testSerializeMTSLangevinIntegrator();
         testSerializeCompoundIntegrator();
     }
     catch(const exception& e) {
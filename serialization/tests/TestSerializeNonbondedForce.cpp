@@ -68,6 +68,13 @@ void testSerialization() {
     force.addGlobalParameter("scale2", 2.0);
     force.addParticleParameterOffset("scale1", 2, 1.5, 2.0, 2.5);
     force.addExceptionParameterOffset("scale2", 1, -0.1, -0.2, -0.3);
+    force.setSoluteParticles({0, 2});
+    force.setSoluteScaleParameter("restScale");
+    int site = force.addTitrationSite("site", {1, 2});
+    force.addTitrationState(site, {0.2, -0.3}, {0.25, 0.3}, {0.02, 0.0});
+    force.addTitrationState(site, {0.0, -0.5}, {0.2, 0.35}, {0.01, 0.03});
+    force.setTitrationStateExceptionParameters(site, 2, 0, 0.4, 0.15, 0.05);
+    force.setTitrationStateExceptionParameters(site, 2, 1, -0.1, 0.3, 0.0);
 
     // Serialize and then deserialize it.
 
@@ -94,6 +101,37 @@ void testSerialization() {
     ASSERT_EQUAL(force.getNumParticleParameterOffsets(), force2.getNumParticleParameterOffsets());
     ASSERT_EQUAL(force.getNumExceptionParameterOffsets(), force2.getNumExceptionParameterOffsets());
     ASSERT_EQUAL(force.getIncludeDirectSpace(), force2.getIncludeDirectSpace());
+    ASSERT_EQUAL_CONTAINERS(force.getSoluteParticles(), force2.getSoluteParticles());
+    ASSERT_EQUAL(force.getSoluteScaleParameter(), force2.getSoluteScaleParameter());
+    ASSERT_EQUAL(force.getNumTitrationSites(), force2.getNumTitrationSites());
+    for (int i = 0; i < force.getNumTitrationSites(); i++) {
+        string parameter1, parameter2;
+        vector<int> particles1, particles2;
+        force.getTitrationSiteParameters(i, parameter1, particles1);
+        force2.getTitrationSiteParameters(i, parameter2, particles2);
+        ASSERT_EQUAL(parameter1, parameter2);
+        ASSERT_EQUAL_CONTAINERS(particles1, particles2);
+        ASSERT_EQUAL(force.getNumTitrationStates(i), force2.getNumTitrationStates(i));
+        for (int j = 1; j < force.getNumTitrationStates(i); j++) {
+            vector<double> charges1, sigmas1, epsilons1, charges2, sigmas2, epsilons2;
+            force.getTitrationStateParameters(i, j, charges1, sigmas1, epsilons1);
+            force2.getTitrationStateParameters(i, j, charges2, sigmas2, epsilons2);
+            ASSERT_EQUAL_CONTAINERS(charges1, charges2);
+            ASSERT_EQUAL_CONTAINERS(sigmas1, sigmas2);
+            ASSERT_EQUAL_CONTAINERS(epsilons1, epsilons2);
+            ASSERT_EQUAL(force.getNumTitrationStateExceptions(i, j), force2.getNumTitrationStateExceptions(i, j));
+            for (int k = 0; k < force.getNumTitrationStateExceptions(i, j); k++) {
+                int exception1, exception2;
+                double chargeProd1, sigma1, epsilon1, chargeProd2, sigma2, epsilon2;
+                force.getTitrationStateExceptionParameters(i, j, k, exception1, chargeProd1, sigma1, epsilon1);
+                force2.getTitrationStateExceptionParameters(i, j, k, exception2, chargeProd2, sigma2, epsilon2);
+                ASSERT_EQUAL(exception1, exception2);
+                ASSERT_EQUAL(chargeProd1, chargeProd2);
+                ASSERT_EQUAL(sigma1, sigma2);
+                ASSERT_EQUAL(epsilon1, epsilon2);
+            }
+        }
+    }
     double alpha2;
     int nx2, ny2, nz2;
     force2.getPMEParameters(alpha2, nx2, ny2, nz2);
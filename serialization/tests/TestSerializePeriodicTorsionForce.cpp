@@ -49,6 +49,8 @@ void testSerialization() {
     force.addTorsion(2, 3, 4, 7, 1, 3.0, 2.2);
     force.addTorsion(5, 1, 2, 3, 3, 4.0, 2.3);
     force.setUsesPeriodicBoundaryConditions(true);
+    force.setSoluteParticles({1, 2, 3});
+    force.setSoluteScaleParameter("restScale");
 
     // Serialize and then deserialize it.
 
@@ -63,6 +65,8 @@ void testSerialization() {
     ASSERT_EQUAL(force.getName(), force2.getName());
     ASSERT_EQUAL(force.usesPeriodicBoundaryConditions(), force2.usesPeriodicBoundaryConditions());
     ASSERT_EQUAL(force.getNumTorsions(), force2.getNumTorsions());
+    ASSERT_EQUAL_CONTAINERS(force.getSoluteParticles(), force2.getSoluteParticles());
+    ASSERT_EQUAL(force.getSoluteScaleParameter(), force2.getSoluteScaleParameter());
     for (int i = 0; i < force.getNumTorsions(); i++) {
         int a1, a2, a3, a4, b1, b2, b3, b4, perioda, periodb;
         double phasea, phaseb, ka, kb;
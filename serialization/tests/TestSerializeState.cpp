@@ -86,7 +86,7 @@ void testSerialization() {
     context.setStepCount(100);
 
     // Serialize and then deserialize it.
-    State s1 = context.getState(State::Positions | State::Velocities | State::Forces | State::Energy | State::Parameters);
+    State s1 = context.getState(State::Positions | State::Velocities | State::Forces | State::Energy | State::Parameters | State::GroupEnergies);
 
     stringstream buffer;
     XmlSerializer::serialize<State>(&s1, "State", buffer);
@@ -122,6 +122,9 @@ void testSerialization() {
 
     ASSERT_EQUAL(s1.getPotentialEnergy(), s2.getPotentialEnergy());
     ASSERT_EQUAL(s1.getKineticEnergy(), s2.getKineticEnergy());
+    ASSERT_EQUAL(s1.getGroupEnergies().size(), s2.getGroupEnergies().size());
+    for (int i = 0; i < (int) s1.getGroupEnergies().size(); i++)
+        ASSERT_EQUAL(s1.getGroupEnergies()[i], s2.getGroupEnergies()[i]);
     ASSERT_EQUAL(s1.getTime(), s2.getTime());
     ASSERT_EQUAL(s1.getStepCount(), s2.getStepCount());
 
@@ -99,6 +99,15 @@ void compareSystems(System& system, System& system2) {
     ASSERT_EQUAL_CONTAINERS(woExpected, wo);
     ASSERT_EQUAL_CONTAINERS(wxExpected, wx);
     ASSERT_EQUAL_CONTAINERS(wyExpected, wy);
+    ASSERT_EQUAL(system.getNumMoleculeTypes(), system2.getNumMoleculeTypes());
+    for (int i = 0; i < system.getNumMoleculeTypes(); i++) {
+        int size1, size2;
+        vector<int> first1, first2;
+        system.getMoleculeTypeParameters(i, size1, first1);
+        system2.getMoleculeTypeParameters(i, size2, first2);
+        ASSERT_EQUAL(size1, size2);
+        ASSERT_EQUAL_CONTAINERS(first1, first2);
+    }
     ASSERT_EQUAL(system.getNumForces(), system2.getNumForces());
     for (int i = 0; i < system.getNumForces(); i++)
         ASSERT(typeid(system.getForce(i)) == typeid(system2.getForce(i)))
@@ -120,6 +129,7 @@ void testSerialization() {
     system.setVirtualSite(6, new ThreeParticleAverageSite(2, 4, 3, 0.5, 0.2, 0.3));
     system.setVirtualSite(7, new OutOfPlaneSite(0, 3, 1, 0.1, 0.2, 0.5));
     system.setVirtualSite(8, new LocalCoordinatesSite({4, 3, 2, 1}, {0.1, 0.2, 0.3, 0.4}, {-1.0, 0.4, 0.4, 0.2}, {0.3, 0.7, 0.0, -1.0}, Vec3(-0.5, 1.0, 1.5)));
+    system.addMoleculeType(2, {0, 2});
     system.addForce(new HarmonicBondForce());
 
     // Serialize and then deserialize it, then make sure the systems are identical.
@@ -137,9 +147,55 @@ void testSerialization() {
     delete copy;
 }
 
+void testLargeSystem() {
+    // Create a System large enough that its particles and bonds are written in parallel.
+
+    const int numParticles = 50000;
+    System system;
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0+0.001*i);
+        if (i > 0)
+            bonds->addBond(i-1, i, 0.1+1e-6*i, 1000.0);
+    }
+    system.addForce(bonds);
+    system.addForce(new HarmonicBondForce());
+
+    // Serialize and deserialize it, and check that nothing changed.
+
+    stringstream buffer;
+    XmlSerializer::serialize<System>(&system, "System", buffer);
+    string xml = buffer.str();
+    System* copy = XmlSerializer::deserialize<System>(buffer);
+    ASSERT_EQUAL(numParticles, copy->getNumParticles());
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL(system.getParticleMass(i), copy->getParticleMass(i));
+    ASSERT_EQUAL(2, copy->getNumForces());
+    const HarmonicBondForce& bonds2 = dynamic_cast<const HarmonicBondForce&>(copy->getForce(0));
+    ASSERT_EQUAL(numParticles-1, bonds2.getNumBonds());
+    for (int i = 0; i < numParticles-1; i++) {
+        int p1, p2, p3, p4;
+        double length1, length2, k1, k2;
+        bonds->getBondParameters(i, p1, p2, length1, k1);
+        bonds2.getBondParameters(i, p3, p4, length2, k2);
+        ASSERT_EQUAL(p1, p3);
+        ASSERT_EQUAL(p2, p4);
+        ASSERT_EQUAL(length1, length2);
+        ASSERT_EQUAL(k1, k2);
+    }
+
+    // Serializing the copy should produce exactly the same XML.
+
+    stringstream buffer2;
+    XmlSerializer::serialize<System>(copy, "System", buffer2);
+    ASSERT(xml == buffer2.str());
+    delete copy;
+}
+
 int main() {
     try {
         testSerialization();
+        testLargeSystem();
     }
     catch(const exception& e) {
         cout << "exception: " << e.what() << endl;
@@ -0,0 +1,201 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/BatchEnergyMinimizer.h"
+#include "openmm/Context.h"
+#include "openmm/CustomBondForce.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * Create a flexible chain molecule with nonbonded interactions, and a set of random conformers of it.
+ */
+System* createChain(int numConformers, vector<vector<Vec3> >& conformers) {
+    const int numParticles = 8;
+    System* system = new System();
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    system->addForce(bonds);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffNonPeriodic);
+    nonbonded->setCutoffDistance(1.5);
+    system->addForce(nonbonded);
+    vector<pair<int, int> > bondPairs;
+    for (int i = 0; i < numParticles; i++) {
+        system->addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.3 : -0.3, 0.3, 0.5);
+        if (i > 0) {
+            bonds->addBond(i-1, i, 0.15, 5000.0);
+            bondPairs.push_back(make_pair(i-1, i));
+        }
+    }
+    nonbonded->createExceptionsFromBonds(bondPairs, 0.5, 0.5);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    conformers.resize(numConformers);
+    for (int i = 0; i < numConformers; i++) {
+        conformers[i].resize(numParticles);
+        for (int j = 0; j < numParticles; j++)
+            conformers[i][j] = Vec3(0.2*j, 0, 0) + Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt))*0.1;
+    }
+    return system;
+}
+
+void testMinimizeConformers() {
+    const int numConformers = 7;
+    const double tolerance = 1.0;
+    vector<vector<Vec3> > conformers;
+    System* system = createChain(numConformers, conformers);
+    BatchEnergyMinimizer minimizer(*system, 3, 5.0, platform);
+    ASSERT_EQUAL(3, minimizer.getBatchSize());
+    minimizer.minimize(conformers, tolerance);
+    ASSERT_EQUAL(numConformers, minimizer.getPositions().size());
+    ASSERT_EQUAL(numConformers, minimizer.getEnergies().size());
+
+    // Check each conformer with a separate Context.
+
+    VerletIntegrator integrator(0.001);
+    Context context(*system, integrator, platform);
+    for (int i = 0; i < numConformers; i++) {
+        ASSERT_EQUAL(1, minimizer.getConverged()[i]);
+        ASSERT(minimizer.getIterations()[i] > 0);
+        context.setPositions(conformers[i]);
+        double initialEnergy = context.getState(State::Energy).getPotentialEnergy();
+        context.setPositions(minimizer.getPositions()[i]);
+        State state = context.getState(State::Energy | State::Forces);
+        ASSERT(state.getPotentialEnergy() < initialEnergy);
+        ASSERT_EQUAL_TOL(state.getPotentialEnergy(), minimizer.getEnergies()[i], 1e-5);
+        double norm = 0.0;
+        for (const Vec3& f : state.getForces())
+            norm += f.dot(f);
+        norm = sqrt(norm/(3*system->getNumParticles()));
+        ASSERT(norm <= tolerance);
+    }
+    delete system;
+}
+
+void testMaxIterations() {
+    const int numConformers = 4;
+    vector<vector<Vec3> > conformers;
+    System* system = createChain(numConformers, conformers);
+    BatchEnergyMinimizer minimizer(*system, 4, 5.0, platform);
+    minimizer.minimize(conformers, 1e-6, 3);
+    for (int i = 0; i < numConformers; i++) {
+        ASSERT(minimizer.getIterations()[i] <= 3);
+        ASSERT_EQUAL(0, minimizer.getConverged()[i]);
+    }
+    delete system;
+}
+
+void checkEnergyNeverIncreases(System* system, const vector<vector<Vec3> >& conformers, int numSteps) {
+    // Minimizing is deterministic, so limiting the number of iterations gives successive points along the
+    // same path.  The energy of every conformer must decrease monotonically along it.
+
+    int numConformers = conformers.size();
+    BatchEnergyMinimizer minimizer(*system, numConformers, 5.0, platform);
+    VerletIntegrator integrator(0.001);
+    Context context(*system, integrator, platform);
+    vector<double> lastEnergy(numConformers);
+    for (int i = 0; i < numConformers; i++) {
+        context.setPositions(conformers[i]);
+        lastEnergy[i] = context.getState(State::Energy).getPotentialEnergy();
+    }
+    for (int step = 1; step <= numSteps; step++) {
+        minimizer.minimize(conformers, 1e-3, step);
+        for (int i = 0; i < numConformers; i++) {
+            double energy = minimizer.getEnergies()[i];
+            ASSERT(energy <= lastEnergy[i]+1e-5*fabs(lastEnergy[i]));
+            lastEnergy[i] = energy;
+        }
+    }
+}
+
+void testEnergyNeverIncreases() {
+    vector<vector<Vec3> > conformers;
+    System* system = createChain(5, conformers);
+    checkEnergyNeverIncreases(system, conformers, 30);
+    delete system;
+
+    // On this rapidly oscillating potential the first trial step lands beyond the barrier at a point where
+    // the slope is small but the energy is higher, so it must be rejected by the sufficient decrease test.
+
+    system = new System();
+    system->addParticle(1.0);
+    system->addParticle(1.0);
+    CustomBondForce* force = new CustomBondForce("10*cos(2*3.14159265358979*r/0.02848)");
+    force->addBond(0, 1);
+    system->addForce(force);
+    conformers = {{Vec3(), Vec3(0, 10.25*0.02848, 0)}, {Vec3(), Vec3(0, 10.3*0.02848, 0)}};
+    checkEnergyNeverIncreases(system, conformers, 10);
+    delete system;
+}
+
+void testInvalidArguments() {
+    vector<vector<Vec3> > conformers;
+    System* system = createChain(1, conformers);
+    system->addConstraint(0, 2, 0.3);
+    bool threwException = false;
+    try {
+        BatchEnergyMinimizer minimizer(*system, 2, 5.0, platform);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    delete system;
+}
+
+void runPlatformTests();
+
+int main(int argc, char* argv[]) {
+    try {
+        initializeTests(argc, argv);
+        testMinimizeConformers();
+        testMaxIterations();
+        testEnergyNeverIncreases();
+        testInvalidArguments();
+        runPlatformTests();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
@@ -32,11 +32,15 @@
 #include "openmm/internal/AssertionUtilities.h"
 #include "openmm/AndersenThermostat.h"
 #include "openmm/Context.h"
+#include "openmm/HarmonicAngleForce.h"
+#include "openmm/HarmonicBondForce.h"
 #include "openmm/LangevinIntegrator.h"
 #include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
 #include "openmm/System.h"
 #include "openmm/VerletIntegrator.h"
 #include "sfmt/SFMT.h"
+#include <future>
 #include <iostream>
 #include <sstream>
 #include <vector>
@@ -270,6 +274,526 @@ void testLangevin() {
     compareStates(s2, s4);
 }
 
+void testCompressedCheckpoints() {
+    const int numParticles = 10;
+    const double boxSize = 3.0;
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    system.addForce(nonbonded);
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.1 : -0.1, 0.2, 0.1);
+        positions[i] = Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+    }
+    LangevinIntegrator integrator(300.0, 1.0, 0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    context.setPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    integrator.step(100);
+
+    // Create a compressed checkpoint.  If zlib is not available, that should throw an exception.
+
+    State s1 = context.getState(State::Positions | State::Velocities | State::Parameters);
+    stringstream stream1(ios_base::out | ios_base::in | ios_base::binary);
+    try {
+        context.createCheckpoint(stream1, true);
+    }
+    catch (const OpenMMException& ex) {
+        return;
+    }
+
+    // Create an uncompressed checkpoint asynchronously and a compressed one asynchronously,
+    // continuing the simulation while they are written.
+
+    stringstream stream2(ios_base::out | ios_base::in | ios_base::binary);
+    stringstream stream3(ios_base::out | ios_base::in | ios_base::binary);
+    future<void> f2 = context.createCheckpointAsync(stream2, false);
+    future<void> f3 = context.createCheckpointAsync(stream3, true);
+    integrator.step(10);
+    State s2 = context.getState(State::Positions | State::Velocities | State::Parameters);
+    f2.get();
+    f3.get();
+
+    // Every checkpoint should restore the original state, and continuing from it should
+    // reproduce the trajectory.
+
+    for (stringstream* stream : {&stream1, &stream2, &stream3}) {
+        context.loadCheckpoint(*stream);
+        State s3 = context.getState(State::Positions | State::Velocities | State::Parameters);
+        compareStates(s1, s3);
+        integrator.step(10);
+        State s4 = context.getState(State::Positions | State::Velocities | State::Parameters);
+        compareStates(s2, s4);
+    }
+
+    // A truncated compressed checkpoint should be rejected.
+
+    string truncated = stream1.str();
+    truncated.resize(truncated.size()/2);
+    stringstream stream4(truncated, ios_base::out | ios_base::in | ios_base::binary);
+    bool threwException = false;
+    try {
+        context.loadCheckpoint(stream4);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+void testForceDataVersion() {
+    const int numParticles = 10;
+    const double boxSize = 3.0;
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    system.addForce(nonbonded);
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.1 : -0.1, 0.2, 0.1);
+        positions[i] = Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+    }
+    LangevinIntegrator integrator(300.0, 1.0, 0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    context.setPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    integrator.step(10);
+    State s1 = context.getState(State::Positions | State::Velocities | State::Parameters);
+    stringstream stream1(ios_base::out | ios_base::in | ios_base::binary);
+    context.createCheckpoint(stream1);
+    string checkpoint = stream1.str();
+    size_t forceDataStart = checkpoint.find("OpenMM Force Data\n");
+    ASSERT(forceDataStart != string::npos);
+
+    // Older checkpoints end before the Force data.  Loading one must not consume whatever the
+    // caller wrote after it.
+
+    stringstream stream2(checkpoint.substr(0, forceDataStart)+"trailing", ios_base::out | ios_base::in | ios_base::binary);
+    integrator.step(10);
+    context.loadCheckpoint(stream2);
+    State s2 = context.getState(State::Positions | State::Velocities | State::Parameters);
+    compareStates(s1, s2);
+    string trailing;
+    stream2 >> trailing;
+    ASSERT_EQUAL("trailing", trailing);
+
+    // An unknown version of the Force data should be rejected.
+
+    string modified = checkpoint;
+    size_t versionStart = forceDataStart+string("OpenMM Force Data\n").size()+1;
+    int version = 2;
+    modified.replace(versionStart, sizeof(int), (char*) &version, sizeof(int));
+    stringstream stream3(modified, ios_base::out | ios_base::in | ios_base::binary);
+    bool threwException = false;
+    try {
+        context.loadCheckpoint(stream3);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+void testGetStateAsync() {
+    const int numParticles = 10;
+    const double boxSize = 3.0;
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    system.addForce(nonbonded);
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.1 : -0.1, 0.2, 0.1);
+        positions[i] = Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+    }
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    context.setPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    integrator.step(100);
+
+    // Request several states, continuing the simulation while they are outstanding.
+
+    int types = State::Positions | State::Velocities | State::Forces | State::Energy | State::Parameters;
+    vector<State> expected;
+    vector<future<State> > futures;
+    for (int i = 0; i < 3; i++) {
+        expected.push_back(context.getState(types, i == 1));
+        futures.push_back(context.getStateAsync(types, i == 1));
+        integrator.step(10);
+    }
+
+    // They should match the states at the times they were requested.
+
+    for (int i = 0; i < 3; i++) {
+        State s = futures[i].get();
+        compareStates(expected[i], s);
+        ASSERT_EQUAL_TOL(expected[i].getPotentialEnergy(), s.getPotentialEnergy(), TOL);
+        ASSERT_EQUAL_TOL(expected[i].getKineticEnergy(), s.getKineticEnergy(), TOL);
+        for (int j = 0; j < numParticles; j++)
+            ASSERT_EQUAL_VEC(expected[i].getForces()[j], s.getForces()[j], TOL);
+    }
+}
+
+void testStepAsync() {
+    const int numParticles = 10;
+    const double boxSize = 3.0;
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    system.addForce(nonbonded);
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.1 : -0.1, 0.2, 0.1);
+        positions[i] = Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+    }
+    LangevinIntegrator integrator(300.0, 1.0, 0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    context.setPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    context.waitForSteps();
+
+    // Record a reference trajectory.
+
+    stringstream stream(ios_base::out | ios_base::in | ios_base::binary);
+    context.createCheckpoint(stream);
+    integrator.step(50);
+    State s1 = context.getState(State::Positions | State::Velocities | State::Parameters);
+
+    // Repeat it with asynchronous steps.  Starting a second batch waits for the first one, and
+    // getState() waits for the second one.
+
+    context.loadCheckpoint(stream);
+    context.stepAsync(20);
+    context.stepAsync(30);
+    State s2 = context.getState(State::Positions | State::Velocities | State::Parameters);
+    compareStates(s1, s2);
+    ASSERT_EQUAL(s1.getStepCount(), s2.getStepCount());
+
+    // Explicitly waiting should give the same result.
+
+    context.stepAsync(10);
+    context.waitForSteps();
+    ASSERT_EQUAL(s1.getStepCount()+10, context.getStepCount());
+
+    // Deleting a Context while steps are in progress should wait for them.
+
+    {
+        LangevinIntegrator integrator2(300.0, 1.0, 0.001);
+        Context context2(system, integrator2, platform);
+        context2.setPositions(positions);
+        context2.setPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+        context2.stepAsync(10);
+    }
+}
+
+/**
+ * An Integrator that queries its Context after every step, the way a Python integrator or a
+ * plugin might.
+ */
+class CallbackIntegrator : public VerletIntegrator {
+public:
+    CallbackIntegrator(double stepSize) : VerletIntegrator(stepSize), context(NULL), numCallbacks(0) {
+    }
+    void step(int steps) {
+        for (int i = 0; i < steps; i++) {
+            VerletIntegrator::step(1);
+            context->getState(State::Energy);
+            numCallbacks++;
+        }
+    }
+    Context* context;
+    int numCallbacks;
+};
+
+void testStepAsyncWithCallbacks() {
+    const int numParticles = 10;
+    const double boxSize = 3.0;
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    system.addForce(nonbonded);
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.1 : -0.1, 0.2, 0.1);
+        positions[i] = Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+    }
+    CallbackIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    integrator.context = &context;
+    context.setPositions(positions);
+    context.setPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+
+    // The Integrator calls getState() from the stepping thread while this thread starts new
+    // batches and calls getState() itself.
+
+    int expectedSteps = 0;
+    for (int i = 0; i < 50; i++) {
+        context.stepAsync(5);
+        expectedSteps += 5;
+        State state = context.getState(State::Positions);
+        ASSERT_EQUAL(expectedSteps, state.getStepCount());
+        ASSERT_EQUAL(expectedSteps, integrator.numCallbacks);
+    }
+}
+
+void testParticleSubset() {
+    const int numParticles = 20;
+    const double boxSize = 3.0;
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    system.addForce(nonbonded);
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.1 : -0.1, 0.2, 0.1);
+        positions[i] = Vec3(3*boxSize*genrand_real2(sfmt), 3*boxSize*genrand_real2(sfmt), 3*boxSize*genrand_real2(sfmt));
+    }
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    context.setPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    integrator.step(10);
+
+    // Retrieve a few subsets, including one with a repeated particle, and compare them to the full State.
+
+    int types = State::Positions | State::Velocities | State::Forces | State::Energy;
+    vector<vector<int> > subsets = {{3}, {17, 2, 9, 11}, {5, 0, 5, 19}};
+    for (auto& particles : subsets) {
+        for (bool wrap : {false, true}) {
+            State full = context.getState(types, wrap);
+            State subset = context.getState(types, particles, wrap);
+            ASSERT_EQUAL(particles.size(), subset.getPositions().size());
+            ASSERT_EQUAL_TOL(full.getPotentialEnergy(), subset.getPotentialEnergy(), TOL);
+            for (int i = 0; i < particles.size(); i++) {
+                ASSERT_EQUAL_VEC(full.getPositions()[particles[i]], subset.getPositions()[i], TOL);
+                ASSERT_EQUAL_VEC(full.getVelocities()[particles[i]], subset.getVelocities()[i], TOL);
+                ASSERT_EQUAL_VEC(full.getForces()[particles[i]], subset.getForces()[i], TOL);
+            }
+        }
+        integrator.step(10);
+    }
+
+    // An illegal index should throw an exception.
+
+    bool threwException = false;
+    try {
+        context.getState(State::Positions, vector<int>{numParticles});
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+void testQuantizedPositions() {
+    const int numParticles = 50;
+    const double boxSize = 3.0;
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    system.addForce(nonbonded);
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.1 : -0.1, 0.2, 0.1);
+        positions[i] = Vec3(3*boxSize*genrand_real2(sfmt), 3*boxSize*genrand_real2(sfmt)-boxSize, 3*boxSize*genrand_real2(sfmt));
+    }
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    context.setPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    integrator.step(10);
+
+    // Every coordinate should be within half the precision of the full precision value.  The last
+    // case needs too many bits to pack, so GPU platforms fall back to transferring the full positions.
+
+    for (double precision : {0.1, 0.001, 1e-5, 1e-9}) {
+        State state = context.getState(State::Positions);
+        vector<Vec3> quantized = context.getQuantizedPositions(precision);
+        ASSERT_EQUAL(numParticles, quantized.size());
+        for (int i = 0; i < numParticles; i++)
+            for (int j = 0; j < 3; j++)
+                ASSERT(fabs(quantized[i][j]-state.getPositions()[i][j]) <= 0.5*precision+1e-5*fabs(state.getPositions()[i][j]));
+    }
+
+    // The precision must be positive.
+
+    bool threwException = false;
+    try {
+        context.getQuantizedPositions(0.0);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+void testGroupEnergies() {
+    const int numParticles = 30;
+    const double boxSize = 4.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    for (int i = 0; i < numParticles; i++)
+        system.addParticle(1.0);
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    for (int i = 0; i < numParticles-1; i++)
+        bonds->addBond(i, i+1, 0.1, 1.5);
+    bonds->setForceGroup(1);
+    system.addForce(bonds);
+    HarmonicAngleForce* angles = new HarmonicAngleForce();
+    for (int i = 0; i < numParticles-2; i++)
+        angles->addAngle(i, i+1, i+2, 2.0, 1.5);
+    angles->setForceGroup(3);
+    system.addForce(angles);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    for (int i = 0; i < numParticles; i++)
+        nonbonded->addParticle(i%2 == 0 ? 0.2 : -0.2, 0.2, 0.5);
+    nonbonded->setNonbondedMethod(NonbondedForce::PME);
+    nonbonded->setCutoffDistance(1.0);
+    nonbonded->setForceGroup(3);
+    nonbonded->setReciprocalSpaceForceGroup(6);
+    system.addForce(nonbonded);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = Vec3(0.1*i, boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+    context.setPositions(positions);
+
+    // Compare the energies of all groups to ones computed for each group separately.
+
+    State state = context.getState(State::GroupEnergies | State::Energy);
+    const vector<double>& energies = state.getGroupEnergies();
+    ASSERT_EQUAL(32, energies.size());
+    double total = 0.0;
+    for (int i = 0; i < 32; i++) {
+        double expected = context.getState(State::Energy, false, 1<<i).getPotentialEnergy();
+        ASSERT_EQUAL_TOL(expected, energies[i], TOL);
+        total += energies[i];
+    }
+    ASSERT(energies[1] != 0.0);
+    ASSERT(energies[6] != 0.0);
+    ASSERT_EQUAL_TOL(context.getState(State::Energy).getPotentialEnergy(), state.getPotentialEnergy(), TOL);
+    ASSERT_EQUAL_TOL(total, state.getPotentialEnergy(), TOL);
+
+    // Groups that were not requested should be zero, and requesting forces as well should still
+    // produce the correct forces.
+
+    int groups = (1<<1)+(1<<6);
+    State partial = context.getState(State::GroupEnergies | State::Forces, false, groups);
+    ASSERT_EQUAL_TOL(energies[1], partial.getGroupEnergies()[1], TOL);
+    ASSERT_EQUAL(0.0, partial.getGroupEnergies()[3]);
+    ASSERT_EQUAL_TOL(energies[6], partial.getGroupEnergies()[6], TOL);
+    State forces = context.getState(State::Forces, false, groups);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(forces.getForces()[i], partial.getForces()[i], TOL);
+}
+
+void testFrameEnergies() {
+    const int numParticles = 20;
+    const int numFrames = 5;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(3, 0, 0), Vec3(0, 3, 0), Vec3(0, 0, 3));
+    for (int i = 0; i < numParticles; i++)
+        system.addParticle(1.0);
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    for (int i = 0; i < numParticles-1; i++)
+        bonds->addBond(i, i+1, 0.1, 1.5);
+    bonds->setForceGroup(1);
+    system.addForce(bonds);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    for (int i = 0; i < numParticles; i++)
+        nonbonded->addParticle(i%2 == 0 ? 0.2 : -0.2, 0.2, 0.5);
+    nonbonded->setNonbondedMethod(NonbondedForce::PME);
+    nonbonded->setCutoffDistance(1.0);
+    nonbonded->setForceGroup(2);
+    system.addForce(nonbonded);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> initialPositions(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        initialPositions[i] = Vec3(0.1*i, genrand_real2(sfmt), genrand_real2(sfmt));
+    context.setPositions(initialPositions);
+
+    // Create a set of frames with different positions and box sizes.
+
+    vector<Vec3> positions, boxVectors;
+    for (int frame = 0; frame < numFrames; frame++) {
+        for (int i = 0; i < numParticles; i++)
+            positions.push_back(initialPositions[i]+Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt))*0.05);
+        double size = 3.0+0.1*frame;
+        boxVectors.push_back(Vec3(size, 0, 0));
+        boxVectors.push_back(Vec3(0, size, 0));
+        boxVectors.push_back(Vec3(0, 0, size));
+    }
+    vector<int> groups = {1<<1, 1<<2, -1};
+    vector<double> energies = context.computeFrameEnergies(positions, boxVectors, groups);
+    vector<double> totalEnergies = context.computeFrameEnergies(positions, boxVectors);
+    ASSERT_EQUAL(numFrames*groups.size(), energies.size());
+    ASSERT_EQUAL(numFrames, totalEnergies.size());
+
+    // The Context should be unchanged.
+
+    State state = context.getState(State::Positions);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(initialPositions[i], state.getPositions()[i], TOL);
+    Vec3 a, b, c;
+    state.getPeriodicBoxVectors(a, b, c);
+    ASSERT_EQUAL_VEC(Vec3(3, 0, 0), a, TOL);
+
+    // Compare to energies computed one frame at a time.
+
+    for (int frame = 0; frame < numFrames; frame++) {
+        context.setPeriodicBoxVectors(boxVectors[3*frame], boxVectors[3*frame+1], boxVectors[3*frame+2]);
+        context.setPositions(vector<Vec3>(positions.begin()+frame*numParticles, positions.begin()+(frame+1)*numParticles));
+        for (int i = 0; i < groups.size(); i++)
+            ASSERT_EQUAL_TOL(context.getState(State::Energy, false, groups[i]).getPotentialEnergy(), energies[frame*groups.size()+i], TOL);
+        ASSERT_EQUAL_TOL(context.getState(State::Energy).getPotentialEnergy(), totalEnergies[frame], TOL);
+    }
+
+    // Invalid arguments should throw exceptions.
+
+    for (int i = 0; i < 2; i++) {
+        bool threwException = false;
+        try {
+            if (i == 0)
+                context.computeFrameEnergies(vector<Vec3>(numParticles+1));
+            else
+                context.computeFrameEnergies(positions, vector<Vec3>(3));
+        }
+        catch (const OpenMMException& ex) {
+            threwException = true;
+        }
+        ASSERT(threwException);
+    }
+}
+
 void runPlatformTests();
 
 int main(int argc, char* argv[]) {
@@ -278,6 +802,15 @@ int main(int argc, char* argv[]) {
         testSetState();
         testMultipleDevices();
         testLangevin();
+        testCompressedCheckpoints();
+        testForceDataVersion();
+        testGetStateAsync();
+        testStepAsync();
+        testStepAsyncWithCallbacks();
+        testParticleSubset();
+        testQuantizedPositions();
+        testGroupEnergies();
+        testFrameEnergies();
         runPlatformTests();
     }
     catch(const exception& e) {
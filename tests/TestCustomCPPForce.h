@@ -94,12 +94,85 @@ void testForce() {
     }
 }
 
+class DeviceTestForceImpl;
+
+class DeviceTestForce : public Force {
+public:
+    DeviceTestForce() : impl(NULL) {
+    }
+    mutable DeviceTestForceImpl* impl;
+protected:
+    ForceImpl* createImpl() const;
+};
+
+class DeviceTestForceImpl : public CustomCPPForceImpl {
+public:
+    const DeviceTestForce& owner;
+    int deviceCalls;
+    DeviceData data;
+    DeviceTestForceImpl(const DeviceTestForce& owner) : CustomCPPForceImpl(owner), owner(owner), deviceCalls(0) {
+    }
+    double computeForce(ContextImpl& context, const vector<Vec3>& positions, vector<Vec3>& forces) {
+        for (int i = 0; i < forces.size(); i++)
+            forces[i] = Vec3();
+        return 3.0;
+    }
+    bool computeForceOnDevice(ContextImpl& context, const DeviceData& data, bool includeForces, bool includeEnergy, double& energy) {
+        this->data = data;
+        deviceCalls++;
+        energy = 3.0;
+        return true;
+    }
+    const DeviceTestForce& getOwner() const {
+        return owner;
+    }
+};
+
+ForceImpl* DeviceTestForce::createImpl() const {
+    impl = new DeviceTestForceImpl(*this);
+    return impl;
+}
+
+void testDeviceComputation() {
+    int numParticles = 5;
+    System system;
+    DeviceTestForce* test = new DeviceTestForce();
+    system.addForce(test);
+    vector<Vec3> positions;
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        positions.push_back(Vec3(0.6*i, 0, 0));
+    }
+    VerletIntegrator integrator(0.01);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    State state = context.getState(State::Forces | State::Energy);
+    ASSERT_EQUAL_TOL(3.0, state.getPotentialEnergy(), 1e-6);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(Vec3(), state.getForces()[i], 1e-6);
+
+    // On GPU platforms the calculation should have been done by computeForceOnDevice().
+
+    string platformName = platform.getName();
+    if (platformName == "CUDA" || platformName == "HIP" || platformName == "OpenCL") {
+        DeviceTestForceImpl& impl = *test->impl;
+        ASSERT(impl.deviceCalls > 0);
+        ASSERT_EQUAL(platformName, impl.data.platformName);
+        ASSERT_EQUAL(numParticles, impl.data.numParticles);
+        ASSERT(impl.data.paddedNumParticles >= numParticles);
+        ASSERT(impl.data.posq != NULL);
+        ASSERT(impl.data.forces != NULL);
+        ASSERT(impl.data.atomIndex != NULL);
+    }
+}
+
 void runPlatformTests();
 
 int main(int argc, char* argv[]) {
     try {
         initializeTests(argc, argv);
         testForce();
+        testDeviceComputation();
         runPlatformTests();
     }
     catch(const exception& e) {
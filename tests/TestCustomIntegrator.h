@@ -1286,6 +1286,58 @@ void testAnalyzeComputations() {
 /**
  * Make sure random numbers are computed correctly when steps get merged.
  */
+void testMergedSums() {
+    // Mix per-DOF computations and sums, including steps that depend on the result of a sum
+    // computed immediately before them.
+
+    const int numParticles = 10;
+    System system;
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0+i);
+        positions[i] = Vec3(0.1*i, -0.2*i, 0.3+0.05*i);
+    }
+    CustomIntegrator integrator(0.1);
+    integrator.addPerDofVariable("a", 0);
+    integrator.addPerDofVariable("b", 0);
+    integrator.addPerDofVariable("c", 0);
+    integrator.addGlobalVariable("s1", 0);
+    integrator.addGlobalVariable("s2", 0);
+    integrator.addGlobalVariable("s3", 0);
+    integrator.addComputePerDof("a", "x+1");
+    integrator.addComputeSum("s1", "a");
+    integrator.addComputePerDof("b", "2*a");
+    integrator.addComputeSum("s2", "b*m");
+    integrator.addComputePerDof("c", "a*s2+s1");
+    integrator.addComputeSum("s3", "c");
+    integrator.addComputePerDof("b", "b+s3");
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    integrator.step(1);
+    double s1 = 0, s2 = 0, s3 = 0;
+    for (int i = 0; i < numParticles; i++)
+        for (int j = 0; j < 3; j++) {
+            double a = positions[i][j]+1;
+            s1 += a;
+            s2 += 2*a*system.getParticleMass(i);
+        }
+    for (int i = 0; i < numParticles; i++)
+        for (int j = 0; j < 3; j++)
+            s3 += (positions[i][j]+1)*s2+s1;
+    ASSERT_EQUAL_TOL(s1, integrator.getGlobalVariable(0), 1e-5);
+    ASSERT_EQUAL_TOL(s2, integrator.getGlobalVariable(1), 1e-5);
+    ASSERT_EQUAL_TOL(s3, integrator.getGlobalVariable(2), 1e-5);
+    vector<Vec3> b, c;
+    integrator.getPerDofVariable(1, b);
+    integrator.getPerDofVariable(2, c);
+    for (int i = 0; i < numParticles; i++)
+        for (int j = 0; j < 3; j++) {
+            double a = positions[i][j]+1;
+            ASSERT_EQUAL_TOL(a*s2+s1, c[i][j], 1e-5);
+            ASSERT_EQUAL_TOL(2*a+s3, b[i][j], 1e-5);
+        }
+}
+
 void testMergedRandoms() {
     const int numParticles = 10;
     const int numSteps = 10;
@@ -1361,6 +1413,7 @@ int main(int argc, char* argv[]) {
         testWithThermostat();
         testMonteCarlo();
         testSum();
+        testMergedSums();
         testParameter();
         testRandomDistributions();
         testPerDofVariables();
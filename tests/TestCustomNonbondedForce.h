@@ -918,6 +918,57 @@ void testLongRangeCorrection() {
     ASSERT_EQUAL_TOL(standardEnergy1-standardEnergy2, customEnergy1-customEnergy2, 1e-4);
 }
 
+void testLongRangeCorrectionUpdates() {
+    // The long range correction caches its integrals.  Make sure it is still correct after
+    // global parameters and per-particle parameters change.
+
+    int numParticles = 30;
+    double boxSize = 3.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    CustomNonbondedForce* force = new CustomNonbondedForce("scale*4*eps*((sigma/r)^12-(sigma/r)^6); sigma=0.5*(sigma1+sigma2); eps=sqrt(eps1*eps2)");
+    force->addPerParticleParameter("sigma");
+    force->addPerParticleParameter("eps");
+    force->addGlobalParameter("scale", 1.0);
+    force->addEnergyParameterDerivative("scale");
+    force->setNonbondedMethod(CustomNonbondedForce::CutoffPeriodic);
+    force->setCutoffDistance(1.0);
+    force->setUseLongRangeCorrection(true);
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        force->addParticle({0.2+0.05*(i%3), 0.5+0.1*(i%3)});
+        positions[i] = Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+    }
+    system.addForce(force);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    State state1 = context.getState(State::Energy | State::ParameterDerivatives);
+    context.setParameter("scale", 2.0);
+    State state2 = context.getState(State::Energy | State::ParameterDerivatives);
+    ASSERT_EQUAL_TOL(2*state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1e-5);
+    ASSERT_EQUAL_TOL(state1.getEnergyParameterDerivatives().at("scale"), state2.getEnergyParameterDerivatives().at("scale"), 1e-5);
+    context.setParameter("scale", 1.0);
+    State state3 = context.getState(State::Energy);
+    ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state3.getPotentialEnergy(), 1e-5);
+
+    // Change the parameters of some particles, including adding a new class, and compare to a new Context.
+
+    force->setParticleParameters(0, {0.3, 0.4});
+    force->setParticleParameters(1, {0.2, 0.5});
+    force->updateParametersInContext(context);
+    State state4 = context.getState(State::Energy | State::ParameterDerivatives);
+    VerletIntegrator integrator2(0.001);
+    Context context2(system, integrator2, platform);
+    context2.setPositions(positions);
+    State state5 = context2.getState(State::Energy | State::ParameterDerivatives);
+    ASSERT_EQUAL_TOL(state5.getPotentialEnergy(), state4.getPotentialEnergy(), 1e-5);
+    ASSERT_EQUAL_TOL(state5.getEnergyParameterDerivatives().at("scale"), state4.getEnergyParameterDerivatives().at("scale"), 1e-5);
+}
+
 void testInteractionGroups() {
     const int numParticles = 6;
     System system;
@@ -1508,6 +1559,92 @@ void testComputedValues(int mode) {
     }
 }
 
+void testLocalEnergyChanges(int mode) {
+    // Create a system of particles on a distorted grid.
+
+    int numParticles = 100;
+    double boxSize = 3.0;
+    System system;
+    VerletIntegrator integrator(0.01);
+    CustomNonbondedForce* force = new CustomNonbondedForce("4*eps*((sigma/r)^12-(sigma/r)^6)+138.935456*q1*q2/r; sigma=0.5*(sigma1+sigma2); eps=sqrt(eps1*eps2)");
+    force->addComputedValue("q", "scale*c");
+    force->addGlobalParameter("scale", 0.5);
+    force->addPerParticleParameter("sigma");
+    force->addPerParticleParameter("eps");
+    force->addPerParticleParameter("c");
+    if (mode == 1) {
+        // Test with a cutoff.
+
+        force->setNonbondedMethod(CustomNonbondedForce::CutoffPeriodic);
+        force->setCutoffDistance(1.0);
+        force->setUseSwitchingFunction(true);
+        force->setSwitchingDistance(0.8);
+    }
+    if (mode == 2) {
+        // Test with interaction groups.
+
+        force->addInteractionGroup({0, 1, 2, 3, 4, 5, 6, 7}, {0, 3, 10, 15, 20, 25, 30});
+        force->addInteractionGroup({1, 2, 40, 41}, {2, 3, 50});
+    }
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> positions;
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        force->addParticle({0.3, 0.5, i%2 == 0 ? 1.0 : -1.0});
+        Vec3 gridPos(0.6*(i%5), 0.6*((i/5)%5), 0.6*(i/25));
+        positions.push_back(gridPos+Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt))*0.1);
+        if (i%2 == 1)
+            force->addExclusion(i-1, i);
+    }
+    system.addForce(force);
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    double energy1 = context.getState(State::Energy).getPotentialEnergy();
+
+    // Move some particles and compare the energy change to the full calculation.
+
+    vector<int> particles = {2, 3, 40, 50};
+    vector<Vec3> newPositions;
+    for (int i : particles)
+        newPositions.push_back(positions[i]+Vec3(0.3, -0.2, 0.4));
+    double delta = force->computeEnergyChange(context, particles, newPositions);
+    vector<Vec3> movedPositions = positions;
+    for (int i = 0; i < particles.size(); i++)
+        movedPositions[particles[i]] = newPositions[i];
+    context.setPositions(movedPositions);
+    double energy2 = context.getState(State::Energy).getPotentialEnergy();
+    ASSERT_EQUAL_TOL(energy2-energy1, delta, 1e-4);
+    context.setPositions(positions);
+
+    // Switching off the particles should change the energy by the value of computeParticleEnergy().
+
+    double particleEnergy = force->computeParticleEnergy(context, particles);
+    for (int i : particles)
+        force->setParticleParameters(i, {0.3, 0.0, 0.0});
+    force->updateParametersInContext(context);
+    double energy3 = context.getState(State::Energy).getPotentialEnergy();
+    ASSERT_EQUAL_TOL(energy1-energy3, particleEnergy, 1e-4);
+    ASSERT_EQUAL_TOL(0.0, force->computeParticleEnergy(context, particles), 1e-6);
+
+    // Changing a global parameter changes the computed values, which should be reflected in the next query.
+
+    context.setParameter("scale", 0.8);
+    energy1 = context.getState(State::Energy).getPotentialEnergy();
+    particles = {5, 6, 7};
+    newPositions.clear();
+    for (int i : particles)
+        newPositions.push_back(positions[i]+Vec3(-0.2, 0.3, 0.1));
+    delta = force->computeEnergyChange(context, particles, newPositions);
+    movedPositions = positions;
+    for (int i = 0; i < particles.size(); i++)
+        movedPositions[particles[i]] = newPositions[i];
+    context.setPositions(movedPositions);
+    energy2 = context.getState(State::Energy).getPotentialEnergy();
+    ASSERT_EQUAL_TOL(energy2-energy1, delta, 1e-4);
+}
+
 void testParallelComputation() {
     System system;
     const int numParticles = 200;
@@ -1581,6 +1718,7 @@ int main(int argc, char* argv[]) {
         testCoulombLennardJones();
         testSwitchingFunction();
         testLongRangeCorrection();
+        testLongRangeCorrectionUpdates();
         testInteractionGroups();
         testLargeInteractionGroup();
         testInteractionGroupLongRangeCorrection();
@@ -1595,6 +1733,9 @@ int main(int argc, char* argv[]) {
         testComputedValues(0); // No cutoff
         testComputedValues(1); // Cutoff, periodic
         testComputedValues(2); // Interaction groups
+        testLocalEnergyChanges(0); // No cutoff
+        testLocalEnergyChanges(1); // Cutoff, periodic
+        testLocalEnergyChanges(2); // Interaction groups
         runPlatformTests();
     }
     catch(const exception& e) {
@@ -0,0 +1,146 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This tests Context::getDeviceArray().  Platforms that store their data on a GPU must return the
+ * documented arrays, and platforms that do not must throw an exception.
+ */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+void createTestSystem(System& system, vector<Vec3>& positions) {
+    const int numParticles = 10;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.5 : -0.5, 0.3, 0.5);
+        positions.push_back(Vec3(0.5*i, 0, 0));
+    }
+    system.addForce(nonbonded);
+}
+
+bool storesArraysOnDevice() {
+    return (platform.getName() == "CUDA" || platform.getName() == "HIP");
+}
+
+bool getDeviceArrayFails(Context& context, const string& name) {
+    long long pointer;
+    vector<int> shape;
+    string type;
+    int deviceIndex;
+    try {
+        context.getDeviceArray(name, pointer, shape, type, deviceIndex);
+    }
+    catch (const OpenMMException& ex) {
+        return true;
+    }
+    return false;
+}
+
+void testNoDeviceArrays() {
+    System system;
+    vector<Vec3> positions;
+    createTestSystem(system, positions);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    ASSERT(getDeviceArrayFails(context, "posq"));
+    ASSERT(getDeviceArrayFails(context, "velm"));
+    ASSERT(getDeviceArrayFails(context, "force"));
+    ASSERT(getDeviceArrayFails(context, "atomIndex"));
+}
+
+void testDeviceArrays() {
+    System system;
+    vector<Vec3> positions;
+    createTestSystem(system, positions);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    integrator.step(1);
+    long long pointer;
+    vector<int> shape;
+    string type;
+    int deviceIndex;
+    context.getDeviceArray("posq", pointer, shape, type, deviceIndex);
+    ASSERT(pointer != 0);
+    ASSERT_EQUAL(2, shape.size());
+    ASSERT(shape[0] >= system.getNumParticles());
+    ASSERT_EQUAL(4, shape[1]);
+    ASSERT(type == "<f4" || type == "<f8");
+    int paddedNumAtoms = shape[0];
+    context.getDeviceArray("velm", pointer, shape, type, deviceIndex);
+    ASSERT(pointer != 0);
+    ASSERT_EQUAL(2, shape.size());
+    ASSERT_EQUAL(paddedNumAtoms, shape[0]);
+    ASSERT_EQUAL(4, shape[1]);
+    context.getDeviceArray("force", pointer, shape, type, deviceIndex);
+    ASSERT(pointer != 0);
+    ASSERT_EQUAL(2, shape.size());
+    ASSERT_EQUAL(3, shape[0]);
+    ASSERT_EQUAL(paddedNumAtoms, shape[1]);
+    ASSERT_EQUAL("<i8", type);
+    context.getDeviceArray("atomIndex", pointer, shape, type, deviceIndex);
+    ASSERT(pointer != 0);
+    ASSERT_EQUAL(1, shape.size());
+    ASSERT_EQUAL(paddedNumAtoms, shape[0]);
+    ASSERT_EQUAL("<i4", type);
+    ASSERT(getDeviceArrayFails(context, "noSuchArray"));
+}
+
+void runPlatformTests();
+
+int main(int argc, char* argv[]) {
+    try {
+        initializeTests(argc, argv);
+        if (storesArraysOnDevice())
+            testDeviceArrays();
+        else
+            testNoDeviceArrays();
+        runPlatformTests();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
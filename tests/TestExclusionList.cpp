@@ -0,0 +1,105 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/internal/ExclusionList.h"
+#include "openmm/internal/ThreadPool.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+void checkExclusions(const ExclusionList& list, const vector<set<int> >& expected) {
+    ASSERT_EQUAL(expected.size(), list.getNumAtoms());
+    int total = 0;
+    for (int i = 0; i < (int) expected.size(); i++) {
+        ASSERT_EQUAL(expected[i].size(), list[i].size());
+        ASSERT(vector<int>(expected[i].begin(), expected[i].end()) == vector<int>(list[i].begin(), list[i].end()));
+        for (int j = 0; j < (int) expected.size(); j++)
+            ASSERT_EQUAL(expected[i].count(j) != 0, list.isExcluded(i, j));
+        total += expected[i].size();
+    }
+    ASSERT_EQUAL(total, list.getTotalExclusions());
+}
+
+void testEmpty() {
+    ExclusionList list(10);
+    checkExclusions(list, vector<set<int> >(10));
+    ASSERT(list == ExclusionList(10, vector<pair<int, int> >()));
+    ASSERT(list != ExclusionList(11));
+}
+
+void testRandomPairs() {
+    const int numAtoms = 500;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<pair<int, int> > pairs;
+    vector<set<int> > expected(numAtoms);
+    for (int i = 0; i < 5000; i++) {
+        int atom1 = (int) (numAtoms*genrand_real2(sfmt));
+        int atom2 = (int) (numAtoms*genrand_real2(sfmt));
+        pairs.push_back(make_pair(atom1, atom2));
+        expected[atom1].insert(atom2);
+        expected[atom2].insert(atom1);
+    }
+
+    // Include some duplicates and self exclusions.
+
+    for (int i = 0; i < 100; i++)
+        pairs.push_back(pairs[i]);
+    for (int i = 0; i < numAtoms; i += 7) {
+        pairs.push_back(make_pair(i, i));
+        expected[i].insert(i);
+    }
+    ExclusionList serial(numAtoms, pairs);
+    checkExclusions(serial, expected);
+    ThreadPool threads;
+    ExclusionList parallel(numAtoms, pairs, threads);
+    ASSERT(serial == parallel);
+    ASSERT(serial == ExclusionList(expected));
+}
+
+int main() {
+    try {
+        testEmpty();
+        testRandomPairs();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
@@ -218,9 +218,40 @@ void testFindCustomExclusions() {
     }
 }
 
+/**
+ * Test a ring, where some atoms are connected by paths of different lengths.  Each pair should be
+ * classified by the shortest path between them.
+ */
+
+void testRing() {
+    NonbondedForce nonbonded;
+    vector<pair<int, int> > bonds;
+    const int ringSize = 6;
+    for (int i = 0; i < ringSize; i++) {
+        nonbonded.addParticle(1.0, 1.0, 2.0);
+        bonds.push_back(pair<int, int>(i, (i+1)%ringSize));
+    }
+    nonbonded.createExceptionsFromBonds(bonds, 0.5, 0.5);
+    ASSERT_EQUAL(ringSize*(ringSize-1)/2, nonbonded.getNumExceptions());
+    for (int i = 0; i < nonbonded.getNumExceptions(); i++) {
+        int particle1, particle2;
+        double chargeProd, sigma, epsilon;
+        nonbonded.getExceptionParameters(i, particle1, particle2, chargeProd, sigma, epsilon);
+        ASSERT(particle1 < particle2);
+        bool is14 = (particle2-particle1 == 3);
+        ASSERT_EQUAL(is14 ? 0.5 : 0.0, chargeProd);
+    }
+    CustomNonbondedForce custom("r");
+    for (int i = 0; i < ringSize; i++)
+        custom.addParticle(vector<double>());
+    custom.createExclusionsFromBonds(bonds, 2);
+    ASSERT_EQUAL(ringSize*(ringSize-1)/2-ringSize/2, custom.getNumExclusions());
+}
+
 int main() {
     try {
         testFindExceptions();
+        testRing();
         testReplaceExceptions();
         testFindCustomExclusions();
     }
@@ -68,9 +68,58 @@ void testFindMolecules() {
     }
 }
 
+void testParallelFindMolecules() {
+    // Use enough bonds that they are processed in parallel.  Bonds are listed in a scrambled
+    // order so that many threads try to merge the same molecules at once.
+
+    const int numMolecules = 50;
+    const int moleculeSize = 5000;
+    const int numParticles = numMolecules*moleculeSize;
+    vector<pair<int, int> > bonds;
+    for (int i = 0; i < numMolecules; i++)
+        for (int j = 1; j < moleculeSize; j++)
+            bonds.push_back(make_pair(j*numMolecules+i, (j-1)*numMolecules+i));
+    for (int i = 0; i < (int) bonds.size(); i++)
+        swap(bonds[i], bonds[(i*7919L)%bonds.size()]);
+    vector<vector<int> > molecules = ContextImpl::findMolecules(numParticles, bonds);
+    ASSERT_EQUAL(numMolecules, molecules.size());
+    for (int i = 0; i < numMolecules; i++) {
+        ASSERT_EQUAL(moleculeSize, molecules[i].size());
+        for (int j = 0; j < moleculeSize; j++)
+            ASSERT_EQUAL(j*numMolecules+i, molecules[i][j]);
+    }
+}
+
+void testCachedMolecules() {
+    // Create a Context, then modify the System and create another one.  Make sure it sees the change.
+
+    System system;
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    system.addForce(bonds);
+    for (int i = 0; i < 10; i++)
+        system.addParticle(1.0);
+    for (int i = 1; i < 10; i++)
+        if (i != 5)
+            bonds->addBond(i-1, i, 1.0, 1.0);
+    VerletIntegrator integrator1(1.0);
+    Context context1(system, integrator1, Platform::getPlatform("Reference"));
+    ASSERT_EQUAL(2, context1.getMolecules().size());
+    VerletIntegrator integrator2(1.0);
+    Context context2(system, integrator2, Platform::getPlatform("Reference"));
+    ASSERT_EQUAL(2, context2.getMolecules().size());
+    bonds->addBond(4, 5, 1.0, 1.0);
+    VerletIntegrator integrator3(1.0);
+    Context context3(system, integrator3, Platform::getPlatform("Reference"));
+    ASSERT_EQUAL(1, context3.getMolecules().size());
+    ASSERT_EQUAL(10, context3.getMolecules()[0].size());
+    ASSERT_EQUAL(2, context1.getMolecules().size());
+}
+
 int main() {
     try {
         testFindMolecules();
+        testParallelFindMolecules();
+        testCachedMolecules();
     }
     catch(const exception& e) {
         cout << "exception: " << e.what() << endl;
@@ -0,0 +1,133 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/CustomBondForce.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/HydrogenMassRepartitioner.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/System.h"
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+double totalMass(const System& system) {
+    double mass = 0.0;
+    for (int i = 0; i < system.getNumParticles(); i++)
+        mass += system.getParticleMass(i);
+    return mass;
+}
+
+void testMethane() {
+    System system;
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    system.addForce(bonds);
+    system.addParticle(12.01);
+    for (int i = 1; i < 5; i++) {
+        system.addParticle(1.008);
+        if (i < 3)
+            bonds->addBond(0, i, 0.109, 1000.0);
+        else
+            system.addConstraint(0, i, 0.109);
+    }
+    double mass = totalMass(system);
+    ASSERT_EQUAL(4, HydrogenMassRepartitioner::repartition(system, 3.024));
+    for (int i = 1; i < 5; i++)
+        ASSERT_EQUAL_TOL(3.024, system.getParticleMass(i), 1e-10);
+    ASSERT_EQUAL_TOL(12.01-4*2.016, system.getParticleMass(0), 1e-10);
+    ASSERT_EQUAL_TOL(mass, totalMass(system), 1e-10);
+}
+
+void testRigidWater() {
+    System system;
+    system.addParticle(15.999);
+    system.addParticle(1.008);
+    system.addParticle(1.008);
+    system.addConstraint(0, 1, 0.09572);
+    system.addConstraint(0, 2, 0.09572);
+    system.addConstraint(1, 2, 0.15139);
+    ASSERT_EQUAL(0, HydrogenMassRepartitioner::repartition(system, 3.024));
+    ASSERT_EQUAL(15.999, system.getParticleMass(0));
+    ASSERT_EQUAL(1.008, system.getParticleMass(1));
+    ASSERT_EQUAL(1.008, system.getParticleMass(2));
+}
+
+void testCustomBonds() {
+    // Bonds in a CustomBondForce are used for hydrogens that have no other bonds, as in AMOEBA.
+    // A Drude particle, which is not bonded to anything, is ignored.
+
+    System system;
+    CustomBondForce* bonds = new CustomBondForce("k*(r-r0)^2");
+    bonds->addPerBondParameter("r0");
+    bonds->addPerBondParameter("k");
+    system.addForce(bonds);
+    system.addParticle(14.007);
+    system.addParticle(1.008);
+    system.addParticle(0.4);
+    bonds->addBond(0, 1, {0.101, 1000.0});
+    ASSERT_EQUAL(1, HydrogenMassRepartitioner::repartition(system, 4.0));
+    ASSERT_EQUAL_TOL(14.007-(4.0-1.008), system.getParticleMass(0), 1e-10);
+    ASSERT_EQUAL_TOL(4.0, system.getParticleMass(1), 1e-10);
+    ASSERT_EQUAL(0.4, system.getParticleMass(2));
+}
+
+void testTooHeavy() {
+    System system;
+    system.addParticle(2.5);
+    system.addParticle(1.008);
+    system.addConstraint(0, 1, 0.1);
+    bool threwException = false;
+    try {
+        HydrogenMassRepartitioner::repartition(system, 4.0);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+int main() {
+    try {
+        testMethane();
+        testRigidWater();
+        testCustomBonds();
+        testTooHeavy();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
@@ -0,0 +1,363 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * These microbenchmarks time individual kernels of the common compute implementation: the
+ * nonbonded tile kernels, the stages of PME, the SETTLE and CCMA constraint kernels, and the
+ * per-DOF kernel of CustomIntegrator.  Each one builds a Context on synthetic atom
+ * distributions, repeats just the operation that launches the kernels of interest, and reads
+ * their device times from the profiler.  For every kernel it prints the throughput in the
+ * natural unit of work (atoms, pairs, grid points, or constraints) and the bandwidth implied
+ * by the minimum number of bytes the kernel must move.  Byte counts come from a model of what
+ * each kernel reads and writes, not from hardware counters.
+ *
+ * By default each operation is repeated a small number of times so this runs quickly as a
+ * test, and it fails if any of the expected kernels is not launched.  Set the environment
+ * variable OPENMM_MICROBENCHMARK_ITERATIONS to run more repetitions for stable timings.
+ */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/CustomIntegrator.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include "sfmt/SFMT.h"
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * A description of the work done by one launch of a kernel.
+ */
+struct KernelModel {
+    string kernel;  // the name the kernel is recorded under by the profiler
+    string unit;    // the unit of work
+    double items;   // units of work per launch
+    double bytes;   // minimum bytes read and written per launch
+    bool required;  // whether the kernel must be launched in every configuration
+};
+
+static int getIterations() {
+    const char* value = getenv("OPENMM_MICROBENCHMARK_ITERATIONS");
+    if (value == NULL)
+        return 10;
+    return max(1, atoi(value));
+}
+
+static map<string, string> getProfilingProperties() {
+    map<string, string> properties;
+    properties["EnableProfiling"] = "true";
+    return properties;
+}
+
+static bool isSinglePrecision() {
+    return (platform.getPropertyDefaultValue("Precision") == "single");
+}
+
+/**
+ * Get the size of one element of the posq array.
+ */
+static int getPosqSize() {
+    return (platform.getPropertyDefaultValue("Precision") == "double" ? 32 : 16);
+}
+
+/**
+ * Get the size of one element of the arrays used for integration, such as velm and posDelta.
+ */
+static int getMixedSize() {
+    return (isSinglePrecision() ? 16 : 32);
+}
+
+// Forces are accumulated as three 64 bit fixed point values.
+
+static const int FORCE_SIZE = 24;
+
+/**
+ * Print the timings of a set of kernels and check that each required one was launched.
+ */
+static void reportKernels(const string& benchmark, Context& context, const vector<KernelModel>& models) {
+    map<string, pair<int, double> > timings = context.getKernelTimings();
+    for (const KernelModel& model : models) {
+        auto timing = timings.find(model.kernel);
+        if (timing == timings.end() || timing->second.first == 0) {
+            if (model.required)
+                throw OpenMMException(benchmark+": kernel "+model.kernel+" was never launched");
+            continue;
+        }
+        double seconds = 1e-6*timing->second.second/timing->second.first;
+        cout << setw(12) << left << benchmark << setw(40) << model.kernel << right << fixed << setprecision(2);
+        cout << setw(10) << 1e6*seconds << " us  ";
+        if (seconds > 0.0) {
+            cout << setw(10) << 1e-6*model.items/seconds << " M" << model.unit << "/s  ";
+            cout << setw(8) << 1e-9*model.bytes/seconds << " GB/s";
+        }
+        cout << defaultfloat << endl;
+    }
+}
+
+/**
+ * Create a simple cubic lattice with every atom displaced by a random amount.  This gives a
+ * uniform density without the close contacts of fully random positions.
+ */
+static vector<Vec3> createJitteredLattice(int atomsPerSide, double spacing, OpenMM_SFMT::SFMT& sfmt) {
+    vector<Vec3> positions;
+    for (int i = 0; i < atomsPerSide; i++)
+        for (int j = 0; j < atomsPerSide; j++)
+            for (int k = 0; k < atomsPerSide; k++) {
+                Vec3 offset(genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5);
+                positions.push_back((Vec3(i, j, k)+offset*0.6)*spacing);
+            }
+    return positions;
+}
+
+/**
+ * Count the pairs of atoms that are within the cutoff of each other.
+ */
+static long long countPairs(const vector<Vec3>& positions, double boxSize, double cutoff) {
+    long long pairs = 0;
+    for (int i = 0; i < positions.size(); i++)
+        for (int j = 0; j < i; j++) {
+            Vec3 delta = positions[i]-positions[j];
+            for (int k = 0; k < 3; k++)
+                delta[k] -= boxSize*round(delta[k]/boxSize);
+            if (delta.dot(delta) < cutoff*cutoff)
+                pairs++;
+        }
+    return pairs;
+}
+
+/**
+ * Create a System of charged Lennard-Jones particles on a jittered lattice at about the
+ * density of atoms in water.
+ */
+static void createNonbondedSystem(System& system, vector<Vec3>& positions, NonbondedForce::NonbondedMethod method, double& boxSize) {
+    const int atomsPerSide = 16;
+    const double spacing = 0.215;
+    boxSize = atomsPerSide*spacing;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    positions = createJitteredLattice(atomsPerSide, spacing, sfmt);
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* force = new NonbondedForce();
+    force->setNonbondedMethod(method);
+    force->setCutoffDistance(1.0);
+    for (int i = 0; i < positions.size(); i++) {
+        system.addParticle(10.0);
+        force->addParticle(i%2 == 0 ? 0.5 : -0.5, 0.2, 0.5);
+    }
+    system.addForce(force);
+}
+
+void benchmarkNonbonded() {
+    System system;
+    vector<Vec3> positions;
+    double boxSize;
+    createNonbondedSystem(system, positions, NonbondedForce::CutoffPeriodic, boxSize);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform, getProfilingProperties());
+    context.setPositions(positions);
+    context.getState(State::Forces);
+    context.resetKernelTimings();
+    for (int i = 0; i < getIterations(); i++)
+        context.getState(State::Forces);
+    double atoms = system.getNumParticles();
+    double blocks = ceil(atoms/32);
+    int posq = getPosqSize();
+    vector<KernelModel> models = {
+        {"computeNonbonded", "pairs", (double) countPairs(positions, boxSize, 1.0), atoms*(posq+8+FORCE_SIZE), true},
+        {"findBlockBounds", "atoms", atoms, atoms*posq+blocks*2*posq, true},
+        {"sortBoxData", "atoms", atoms, 2*atoms*posq, true},
+        {"findBlocksWithInteractions", "atoms", atoms, atoms*posq+blocks*2*posq, true}
+    };
+    reportKernels("nonbonded", context, models);
+}
+
+void benchmarkPME() {
+    System system;
+    vector<Vec3> positions;
+    double boxSize;
+    createNonbondedSystem(system, positions, NonbondedForce::PME, boxSize);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform, getProfilingProperties());
+    context.setPositions(positions);
+    context.getState(State::Forces);
+    context.resetKernelTimings();
+    for (int i = 0; i < getIterations(); i++)
+        context.getState(State::Forces);
+    double alpha;
+    int nx, ny, nz;
+    dynamic_cast<NonbondedForce&>(system.getForce(0)).getPMEParametersInContext(context, alpha, nx, ny, nz);
+    double atoms = system.getNumParticles();
+    double gridPoints = nx*ny*nz;
+    double complexPoints = nx*ny*(nz/2+1);
+    int real = getPosqSize()/4;
+    vector<KernelModel> models = {
+        {"gridSpreadCharge", "atoms", atoms, atoms*getPosqSize()+gridPoints*8, true},
+        {"finishSpreadCharge", "points", gridPoints, gridPoints*(8+real), false},
+        {"reciprocalConvolution", "points", complexPoints, complexPoints*4*real, true},
+        {"gridInterpolateForce", "atoms", atoms, atoms*(getPosqSize()+FORCE_SIZE)+gridPoints*real, true}
+    };
+    reportKernels("pme", context, models);
+}
+
+/**
+ * Perturb the positions of atoms, so that applying constraints has work to do.
+ */
+static vector<Vec3> perturbPositions(const vector<Vec3>& positions, OpenMM_SFMT::SFMT& sfmt) {
+    vector<Vec3> perturbed(positions.size());
+    for (int i = 0; i < positions.size(); i++)
+        perturbed[i] = positions[i]+Vec3(genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5)*0.01;
+    return perturbed;
+}
+
+void benchmarkSettle() {
+    const int moleculesPerSide = 12;
+    const double spacing = 0.31;
+    System system;
+    vector<Vec3> positions;
+    for (int i = 0; i < moleculesPerSide; i++)
+        for (int j = 0; j < moleculesPerSide; j++)
+            for (int k = 0; k < moleculesPerSide; k++) {
+                int first = system.addParticle(16.0);
+                system.addParticle(1.0);
+                system.addParticle(1.0);
+                system.addConstraint(first, first+1, 0.1);
+                system.addConstraint(first, first+2, 0.1);
+                system.addConstraint(first+1, first+2, 0.1633);
+                Vec3 pos = Vec3(i, j, k)*spacing;
+                positions.push_back(pos);
+                positions.push_back(pos+Vec3(0.1, 0, 0));
+                positions.push_back(pos+Vec3(-0.0333, 0.0943, 0));
+            }
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform, getProfilingProperties());
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    context.setPositions(perturbPositions(positions, sfmt));
+    context.applyConstraints(1e-5);
+    context.resetKernelTimings();
+    for (int i = 0; i < getIterations(); i++) {
+        context.setPositions(perturbPositions(positions, sfmt));
+        context.applyConstraints(1e-5);
+    }
+    double molecules = moleculesPerSide*moleculesPerSide*moleculesPerSide;
+    vector<KernelModel> models = {
+        {"applySettleToPositions", "molecules", molecules, molecules*3*(getPosqSize()+2*getMixedSize()), true}
+    };
+    reportKernels("settle", context, models);
+}
+
+void benchmarkCCMA() {
+    // Chains of four atoms have constraints that are coupled but cannot be handled by SETTLE
+    // or SHAKE, so they are processed with CCMA.
+
+    const int numChains = 1000;
+    System system;
+    vector<Vec3> positions;
+    for (int i = 0; i < numChains; i++) {
+        Vec3 start((i%10)*0.5, ((i/10)%10)*0.5, (i/100)*0.5);
+        for (int j = 0; j < 4; j++) {
+            system.addParticle(12.0);
+            positions.push_back(start+Vec3(0.15*j, 0.05*(j%2), 0));
+            if (j > 0)
+                system.addConstraint(4*i+j-1, 4*i+j, 0.158);
+        }
+    }
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform, getProfilingProperties());
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    context.setPositions(perturbPositions(positions, sfmt));
+    context.applyConstraints(1e-5);
+    context.resetKernelTimings();
+    for (int i = 0; i < getIterations(); i++) {
+        context.setPositions(perturbPositions(positions, sfmt));
+        context.applyConstraints(1e-5);
+    }
+    double atoms = system.getNumParticles();
+    double constraints = system.getNumConstraints();
+    int posq = getPosqSize(), mixed = getMixedSize();
+    vector<KernelModel> models = {
+        {"computeCCMAConstraintDirectionsKernel", "constraints", constraints, constraints*(2*posq+8+mixed), true},
+        {"computeCCMAPositionConstraintForceKernel", "constraints", constraints, constraints*(2*(posq+mixed)+mixed+2*8), true},
+        {"multiplyByCCMAConstraintMatrixKernel", "constraints", constraints, constraints*(3*8+8), true},
+        {"updateCCMAAtomPositionsKernel", "atoms", atoms, atoms*(2*mixed)+constraints*(mixed+8), true}
+    };
+    reportKernels("ccma", context, models);
+}
+
+void benchmarkCustomIntegratorPerDof() {
+    System system;
+    vector<Vec3> positions;
+    double boxSize;
+    createNonbondedSystem(system, positions, NonbondedForce::CutoffPeriodic, boxSize);
+    CustomIntegrator integrator(0.001);
+    integrator.addUpdateContextState();
+    integrator.addComputePerDof("v", "v+dt*f/m");
+    integrator.addComputePerDof("x", "x+dt*v");
+    Context context(system, integrator, platform, getProfilingProperties());
+    context.setPositions(positions);
+    integrator.step(1);
+    context.resetKernelTimings();
+    integrator.step(getIterations());
+    double atoms = system.getNumParticles();
+    vector<KernelModel> models = {
+        {"computePerDof", "atoms", atoms, atoms*(getPosqSize()+2*getMixedSize()+FORCE_SIZE), true}
+    };
+    reportKernels("perdof", context, models);
+}
+
+void runPlatformTests();
+
+int main(int argc, char* argv[]) {
+    try {
+        initializeTests(argc, argv);
+        benchmarkNonbonded();
+        benchmarkPME();
+        benchmarkSettle();
+        benchmarkCCMA();
+        benchmarkCustomIntegratorPerDof();
+        runPlatformTests();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
@@ -0,0 +1,169 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: agent                                                             *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This tests Context::getKernelTimings() and Context::resetKernelTimings().  Platforms that support
+ * the "EnableProfiling" property must report a timing for every phase they run, and platforms that
+ * do not must report an empty map.
+ */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+void createTestSystem(System& system, vector<Vec3>& positions) {
+    const int numMolecules = 20;
+    const double boxSize = 2.0;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    nonbonded->setCutoffDistance(0.8);
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    bonds->setForceGroup(1);
+    for (int i = 0; i < numMolecules; i++) {
+        system.addParticle(1.0);
+        system.addParticle(1.0);
+        nonbonded->addParticle(0.5, 0.3, 0.5);
+        nonbonded->addParticle(-0.5, 0.3, 0.5);
+        nonbonded->addException(2*i, 2*i+1, 0.0, 1.0, 0.0);
+        bonds->addBond(2*i, 2*i+1, 0.1, 1000.0);
+        Vec3 pos(0.5*(i%4), 0.5*((i/4)%4), 0.5*(i/16));
+        positions.push_back(pos);
+        positions.push_back(pos+Vec3(0.1, 0, 0));
+    }
+    system.addForce(nonbonded);
+    system.addForce(bonds);
+}
+
+bool supportsProfiling() {
+    const vector<string>& names = platform.getPropertyNames();
+    return (find(names.begin(), names.end(), "EnableProfiling") != names.end());
+}
+
+void checkTimings(const map<string, pair<int, double> >& timings) {
+    ASSERT(timings.size() > 0);
+    for (auto& timing : timings) {
+        ASSERT(timing.second.first > 0);
+        ASSERT(timing.second.second >= 0.0);
+    }
+}
+
+void testProfilingDisabled() {
+    System system;
+    vector<Vec3> positions;
+    createTestSystem(system, positions);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    integrator.step(5);
+    ASSERT_EQUAL(0, context.getKernelTimings().size());
+    context.resetKernelTimings();
+    ASSERT_EQUAL(0, context.getKernelTimings().size());
+}
+
+void testProfilingEnabled() {
+    System system;
+    vector<Vec3> positions;
+    createTestSystem(system, positions);
+    VerletIntegrator integrator(0.001);
+    map<string, string> properties;
+    properties["EnableProfiling"] = "true";
+    Context context(system, integrator, platform, properties);
+    context.setPositions(positions);
+    integrator.step(5);
+    checkTimings(context.getKernelTimings());
+
+    // Resetting should discard everything recorded so far, and new steps should be recorded again.
+
+    context.resetKernelTimings();
+    ASSERT_EQUAL(0, context.getKernelTimings().size());
+    integrator.step(2);
+    checkTimings(context.getKernelTimings());
+    context.getState(State::Energy, false, 1<<1);
+    checkTimings(context.getKernelTimings());
+}
+
+void testProfilingUnsupported() {
+    // Platforms without profiling support ignore the property and always return an empty map.
+
+    System system;
+    vector<Vec3> positions;
+    createTestSystem(system, positions);
+    VerletIntegrator integrator(0.001);
+    map<string, string> properties;
+    properties["EnableProfiling"] = "true";
+    bool failed = false;
+    try {
+        Context context(system, integrator, platform, properties);
+    }
+    catch (const OpenMMException& ex) {
+        failed = true;
+    }
+    ASSERT(failed);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    integrator.step(5);
+    context.getState(State::Energy);
+    ASSERT_EQUAL(0, context.getKernelTimings().size());
+    context.resetKernelTimings();
+    ASSERT_EQUAL(0, context.getKernelTimings().size());
+}
+
+void runPlatformTests();
+
+int main(int argc, char* argv[]) {
+    try {
+        initializeTests(argc, argv);
+        testProfilingDisabled();
+        if (supportsProfiling())
+            testProfilingEnabled();
+        else
+            testProfilingUnsupported();
+        runPlatformTests();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
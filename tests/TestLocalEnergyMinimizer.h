@@ -344,6 +344,50 @@ void testReporter() {
     ASSERT_EQUAL_TOL(state.getPotentialEnergy(), reporter.lastEnergy, 1e-5);
 }
 
+void testConstraintTolerance() {
+    // The minimizer works with a looser tolerance internally, but the final positions must satisfy
+    // the constraints to the tolerance requested by the integrator.
+
+    const int numMolecules = 25;
+    const double boxSize = 4.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setCutoffDistance(2.0);
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    system.addForce(nonbonded);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> positions(2*numMolecules);
+    for (int i = 0; i < numMolecules; i++) {
+        system.addParticle(1.0);
+        system.addParticle(1.0);
+        nonbonded->addParticle(-1.0, 0.2, 0.2);
+        nonbonded->addParticle(1.0, 0.2, 0.2);
+        positions[2*i] = Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+        positions[2*i+1] = Vec3(positions[2*i][0]+1.0, positions[2*i][1], positions[2*i][2]);
+        system.addConstraint(2*i, 2*i+1, 1.0);
+    }
+    VerletIntegrator integrator(0.01);
+    Context context(system, integrator, platform);
+    double constraintTol = 1e-6;
+    try {
+        if (context.getPlatform().getPropertyValue(context, "Precision") == "single")
+            constraintTol = 1e-5;
+    }
+    catch (...) {
+        // This platform doesn't have adjustable precision.
+    }
+    integrator.setConstraintTolerance(constraintTol);
+    context.setPositions(positions);
+    LocalEnergyMinimizer::minimize(context, 1.0);
+    State state = context.getState(State::Positions);
+    for (int i = 0; i < numMolecules; i++) {
+        Vec3 delta = state.getPositions()[2*i+1]-state.getPositions()[2*i];
+        ASSERT_EQUAL_TOL(1.0, sqrt(delta.dot(delta)), 2*constraintTol);
+    }
+}
+
 void runPlatformTests();
 
 int main(int argc, char* argv[]) {
@@ -356,6 +400,7 @@ int main(int argc, char* argv[]) {
         testForceGroups();
         testMasslessParticles();
         testReporter();
+        testConstraintTolerance();
         runPlatformTests();
     }
     catch(const exception& e) {
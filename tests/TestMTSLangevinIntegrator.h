@@ -0,0 +1,325 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/CustomExternalForce.h"
+#include "openmm/CustomIntegrator.h"
+#include "openmm/HarmonicAngleForce.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/System.h"
+#include "openmm/MTSLangevinIntegrator.h"
+#include "SimTKOpenMMRealType.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * Add the steps for one level of the BAOAB-RESPA algorithm to a CustomIntegrator.
+ */
+void addSubsteps(CustomIntegrator& integrator, int parentSubsteps, const vector<pair<int, int> >& groups, int level) {
+    int group = groups[level].first;
+    int substeps = groups[level].second;
+    string kick = "v+0.5*(dt/"+to_string(substeps)+")*f"+to_string(group)+"/m";
+    for (int i = 0; i < substeps/parentSubsteps; i++) {
+        integrator.addComputePerDof("v", kick);
+        if (level == groups.size()-1) {
+            integrator.addComputePerDof("x", "x+(dt/"+to_string(2*substeps)+")*v");
+            integrator.addComputePerDof("v", "a*v + b*sqrt(kT/m)*gaussian");
+            integrator.addComputePerDof("x", "x+(dt/"+to_string(2*substeps)+")*v");
+            integrator.addComputePerDof("x1", "x");
+            integrator.addConstrainPositions();
+            integrator.addComputePerDof("v", "v+(x-x1)/(dt/"+to_string(substeps)+")");
+            integrator.addConstrainVelocities();
+        }
+        else
+            addSubsteps(integrator, substeps, groups, level+1);
+        integrator.addComputePerDof("v", kick);
+    }
+}
+
+/**
+ * Build a CustomIntegrator that implements the same algorithm as MTSLangevinIntegrator.
+ */
+CustomIntegrator* createCustomIntegrator(double temperature, double friction, double dt, const vector<pair<int, int> >& groups) {
+    CustomIntegrator* integrator = new CustomIntegrator(dt);
+    double innerDt = dt/groups.back().second;
+    integrator->addGlobalVariable("a", exp(-friction*innerDt));
+    integrator->addGlobalVariable("b", sqrt(1-exp(-2*friction*innerDt)));
+    integrator->addGlobalVariable("kT", BOLTZ*temperature);
+    integrator->addPerDofVariable("x1", 0);
+    integrator->addUpdateContextState();
+    addSubsteps(*integrator, 1, groups, 0);
+    integrator->addConstrainVelocities();
+    return integrator;
+}
+
+/**
+ * Create a small molecule-like system whose forces are divided between three force groups.
+ */
+System* createTestSystem(vector<Vec3>& positions) {
+    const int numParticles = 9;
+    System* system = new System();
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    HarmonicAngleForce* angles = new HarmonicAngleForce();
+    NonbondedForce* nonbonded = new NonbondedForce();
+    bonds->setForceGroup(2);
+    angles->setForceGroup(1);
+    nonbonded->setForceGroup(0);
+    for (int i = 0; i < numParticles; i++) {
+        system->addParticle(i%3 == 0 ? 12.0 : 1.0);
+        nonbonded->addParticle((i%3 == 0 ? -0.8 : 0.4), 0.3, 0.5);
+    }
+    for (int i = 0; i < numParticles; i += 3) {
+        bonds->addBond(i, i+1, 0.1, 1e5);
+        system->addConstraint(i, i+2, 0.1);
+        angles->addAngle(i+1, i, i+2, 1.9, 400.0);
+        nonbonded->addException(i, i+1, 0, 1, 0);
+        nonbonded->addException(i, i+2, 0, 1, 0);
+        nonbonded->addException(i+1, i+2, 0, 1, 0);
+    }
+    system->addForce(bonds);
+    system->addForce(angles);
+    system->addForce(nonbonded);
+    positions.resize(numParticles);
+    for (int i = 0; i < numParticles; i += 3) {
+        Vec3 center(0.4*i, 0.1*(i%2), -0.05*i);
+        positions[i] = center;
+        positions[i+1] = center+Vec3(0.1, 0, 0);
+        positions[i+2] = center+Vec3(-0.03, 0.095, 0);
+    }
+    return system;
+}
+
+void testCompareToCustomIntegrator() {
+    // With the temperature set to 0 the dynamics are deterministic, so the trajectory should
+    // match a CustomIntegrator implementing the same algorithm.
+
+    vector<Vec3> positions;
+    System* system = createTestSystem(positions);
+    vector<pair<int, int> > groups = {{2, 6}, {0, 1}, {1, 3}};
+    const double dt = 0.003;
+    MTSLangevinIntegrator integrator(0.0, 5.0, dt, groups);
+    CustomIntegrator* customIntegrator = createCustomIntegrator(0.0, 5.0, dt, integrator.getGroups());
+    Context context1(*system, integrator, platform);
+    Context context2(*system, *customIntegrator, platform);
+    vector<Vec3> velocities(positions.size());
+    for (int i = 0; i < velocities.size(); i++)
+        velocities[i] = Vec3(0.1*(i%4), -0.2*(i%3), 0.15*(i%2));
+    for (Context* context : {&context1, &context2}) {
+        context->setPositions(positions);
+        context->setVelocities(velocities);
+        context->applyConstraints(1e-6);
+        context->applyVelocityConstraints(1e-6);
+    }
+    for (int i = 0; i < 20; i++) {
+        integrator.step(5);
+        customIntegrator->step(5);
+        State state1 = context1.getState(State::Positions | State::Velocities | State::Energy);
+        State state2 = context2.getState(State::Positions | State::Velocities | State::Energy);
+        ASSERT_EQUAL_TOL(state2.getTime(), state1.getTime(), 1e-10);
+        for (int j = 0; j < positions.size(); j++) {
+            ASSERT_EQUAL_VEC(state2.getPositions()[j], state1.getPositions()[j], 1e-4);
+            ASSERT_EQUAL_VEC(state2.getVelocities()[j], state1.getVelocities()[j], 1e-3);
+        }
+        ASSERT_EQUAL_TOL(state2.getKineticEnergy(), state1.getKineticEnergy(), 1e-3);
+    }
+    delete customIntegrator;
+    delete system;
+}
+
+void testSingleGroup() {
+    // With a single force group and no heat bath, this is just velocity Verlet and should conserve energy.
+
+    System system;
+    system.addParticle(2.0);
+    system.addParticle(2.0);
+    HarmonicBondForce* bond = new HarmonicBondForce();
+    bond->addBond(0, 1, 1.5, 1);
+    system.addForce(bond);
+    MTSLangevinIntegrator integrator(0.0, 0.0, 0.01, {{0, 1}});
+    Context context(system, integrator, platform);
+    vector<Vec3> positions(2);
+    positions[0] = Vec3(-1, 0, 0);
+    positions[1] = Vec3(1, 0, 0);
+    context.setPositions(positions);
+    State state = context.getState(State::Energy);
+    double initialEnergy = state.getKineticEnergy()+state.getPotentialEnergy();
+    for (int i = 0; i < 1000; ++i) {
+        state = context.getState(State::Energy);
+        double energy = state.getKineticEnergy()+state.getPotentialEnergy();
+        ASSERT_EQUAL_TOL(initialEnergy, energy, 0.01);
+        integrator.step(1);
+    }
+}
+
+void testTemperature() {
+    const int numParticles = 8;
+    const double temp = 100.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(5, 0, 0), Vec3(0, 5, 0), Vec3(0, 0, 5));
+    MTSLangevinIntegrator integrator(temp, 3.0, 0.02, {{0, 1}, {1, 2}});
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    bonds->setForceGroup(1);
+    for (int i = 0; i < numParticles; ++i) {
+        system.addParticle(2.0);
+        nonbonded->addParticle((i%2 == 0 ? 1.0 : -1.0), 1.0, 5.0);
+    }
+    for (int i = 0; i < numParticles; i += 2) {
+        bonds->addBond(i, i+1, 1.0, 100.0);
+        nonbonded->addException(i, i+1, 0, 1, 0);
+    }
+    system.addForce(nonbonded);
+    system.addForce(bonds);
+    Context context(system, integrator, platform);
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+        positions[i] = Vec3((i%2 == 0 ? 0.5 : -0.5), (i%4 < 2 ? 2 : -2), (i < 4 ? 2 : -2));
+    context.setPositions(positions);
+    
+    // Let it equilibrate.
+    
+    integrator.step(5000);
+    
+    // Now run it for a while and see if the temperature is correct.
+    
+    double ke = 0.0;
+    int steps = 10000;
+    for (int i = 0; i < steps; ++i) {
+        State state = context.getState(State::Energy);
+        ke += state.getKineticEnergy();
+        integrator.step(1);
+    }
+    ke /= steps;
+    double expected = 0.5*numParticles*3*BOLTZ*temp;
+    ASSERT_USUALLY_EQUAL_TOL(expected, ke, 6/std::sqrt((double) steps));
+}
+
+void testConstraints() {
+    vector<Vec3> positions;
+    System* system = createTestSystem(positions);
+    MTSLangevinIntegrator integrator(300.0, 2.0, 0.004, {{0, 1}, {1, 2}, {2, 4}});
+    integrator.setConstraintTolerance(1e-5);
+    Context context(*system, integrator, platform);
+    context.setPositions(positions);
+    context.applyConstraints(1e-6);
+    context.setVelocitiesToTemperature(300.0);
+
+    // Simulate it and see whether the constraints remain satisfied.
+
+    for (int i = 0; i < 500; ++i) {
+        State state = context.getState(State::Positions);
+        for (int j = 0; j < system->getNumConstraints(); ++j) {
+            int particle1, particle2;
+            double distance;
+            system->getConstraintParameters(j, particle1, particle2, distance);
+            Vec3 delta = state.getPositions()[particle1]-state.getPositions()[particle2];
+            ASSERT_EQUAL_TOL(distance, sqrt(delta.dot(delta)), 1e-4);
+        }
+        integrator.step(1);
+    }
+    delete system;
+}
+
+void testForceGroups() {
+    // Forces that are not in any of the integrator's groups should be ignored.
+
+    System system;
+    system.addParticle(1.0);
+    MTSLangevinIntegrator integrator(0.0, 1.0, 0.01, {{1, 1}, {3, 2}});
+    CustomExternalForce* f1 = new CustomExternalForce("x");
+    f1->addParticle(0);
+    f1->setForceGroup(1);
+    CustomExternalForce* f2 = new CustomExternalForce("y");
+    f2->addParticle(0);
+    f2->setForceGroup(2);
+    CustomExternalForce* f3 = new CustomExternalForce("z");
+    f3->addParticle(0);
+    f3->setForceGroup(3);
+    system.addForce(f1);
+    system.addForce(f2);
+    system.addForce(f3);
+    Context context(system, integrator, platform);
+    context.setPositions(vector<Vec3>(1));
+    integrator.step(1);
+    Vec3 pos = context.getState(State::Positions).getPositions()[0];
+    ASSERT(pos[0] < 0);
+    ASSERT(pos[1] == 0);
+    ASSERT(pos[2] < 0);
+}
+
+void testInvalidGroups() {
+    vector<vector<pair<int, int> > > invalid = {{}, {{0, 1}, {32, 2}}, {{0, 2}, {1, 3}}, {{-1, 1}}};
+    for (auto& groups : invalid) {
+        bool failed = false;
+        try {
+            MTSLangevinIntegrator integrator(300.0, 1.0, 0.004, groups);
+        }
+        catch (OpenMMException& ex) {
+            failed = true;
+        }
+        ASSERT(failed);
+    }
+    MTSLangevinIntegrator integrator(300.0, 1.0, 0.004, {{2, 4}, {0, 1}, {1, 2}});
+    ASSERT_EQUAL(3, integrator.getGroups().size());
+    ASSERT_EQUAL(0, integrator.getGroups()[0].first);
+    ASSERT_EQUAL(1, integrator.getGroups()[1].first);
+    ASSERT_EQUAL(2, integrator.getGroups()[2].first);
+}
+
+void runPlatformTests();
+
+int main(int argc, char* argv[]) {
+    try {
+        initializeTests(argc, argv);
+        testCompareToCustomIntegrator();
+        testSingleGroup();
+        testTemperature();
+        testConstraints();
+        testForceGroups();
+        testInvalidGroups();
+        runPlatformTests();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
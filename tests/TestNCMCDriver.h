@@ -0,0 +1,233 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.            *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/CustomExternalForce.h"
+#include "openmm/LangevinMiddleIntegrator.h"
+#include "openmm/NCMCDriver.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/State.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+System* createSystem(int numParticles) {
+    // The first force depends on lambda and is in group 0.  The second one does not, and is in group 1.
+
+    System* system = new System();
+    CustomExternalForce* force1 = new CustomExternalForce("10*lambda*(x^2+y^2+z^2)");
+    force1->addGlobalParameter("lambda", 0.0);
+    CustomExternalForce* force2 = new CustomExternalForce("5*(x-1)^2");
+    force2->setForceGroup(1);
+    for (int i = 0; i < numParticles; i++) {
+        system->addParticle(1.0);
+        force1->addParticle(i);
+        force2->addParticle(i);
+    }
+    system->addForce(force1);
+    system->addForce(force2);
+    return system;
+}
+
+vector<Vec3> createPositions(int numParticles) {
+    vector<Vec3> positions;
+    for (int i = 0; i < numParticles; i++)
+        positions.push_back(Vec3(0.5*sin(i), 0.5*cos(i), 0.1*i));
+    return positions;
+}
+
+void testWorkWithoutSteps() {
+    // With no steps between perturbations, the work is just the change in energy from the first
+    // to the last value of the schedule.
+
+    const int numParticles = 10;
+    System* system = createSystem(numParticles);
+    VerletIntegrator integrator(0.001);
+    Context context(*system, integrator, platform);
+    vector<Vec3> positions = createPositions(numParticles);
+    context.setPositions(positions);
+    NCMCDriver ncmc(context, 300.0, 0);
+    ASSERT_EQUAL(0, ncmc.addParameter("lambda", {0.0, 0.2, 0.6, 1.0}));
+    ASSERT_EQUAL(1, ncmc.getNumParameters());
+    ASSERT_EQUAL(3, ncmc.getNumPerturbations());
+    double expected = 0.0;
+    for (Vec3 pos : positions)
+        expected += 10*pos.dot(pos);
+    ASSERT(!ncmc.move());
+    ASSERT_EQUAL_TOL(expected, ncmc.getLastWork(), 1e-5);
+    ASSERT_EQUAL(1, ncmc.getNumAttempted());
+    ASSERT_EQUAL(0, ncmc.getNumAccepted());
+    ASSERT_EQUAL(0.0, context.getParameter("lambda"));
+    delete system;
+}
+
+void testWorkWithSteps() {
+    // Compare the work to the energy differences computed by running the same protocol by hand.
+
+    const int numParticles = 10;
+    System* system = createSystem(numParticles);
+    VerletIntegrator integrator1(0.002), integrator2(0.002);
+    Context context1(*system, integrator1, platform);
+    Context context2(*system, integrator2, platform);
+    vector<Vec3> positions = createPositions(numParticles);
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+    vector<double> schedule = {1.0, 0.8, 0.5, 0.3, 0.0};
+    context1.setParameter("lambda", 1.0);
+    context2.setParameter("lambda", 1.0);
+    NCMCDriver ncmc(context1, 300.0, 3);
+    ncmc.addParameter("lambda", schedule);
+    ncmc.setForceGroups(1<<0);
+    ASSERT_EQUAL(1<<0, ncmc.getForceGroups());
+    double expected = 0.0;
+    for (int i = 1; i < schedule.size(); i++) {
+        expected -= context2.getState(State::Energy, false, 1<<0).getPotentialEnergy();
+        context2.setParameter("lambda", schedule[i]);
+        expected += context2.getState(State::Energy, false, 1<<0).getPotentialEnergy();
+        integrator2.step(3);
+    }
+
+    // Decreasing lambda lowers the energy, so the move is always accepted and keeps the final value.
+
+    ASSERT(expected < 0);
+    ASSERT(ncmc.move());
+    ASSERT_EQUAL_TOL(expected, ncmc.getLastWork(), 1e-4);
+    ASSERT_EQUAL(1, ncmc.getNumAccepted());
+    ASSERT_EQUAL(0.0, context1.getParameter("lambda"));
+    State state1 = context1.getState(State::Positions);
+    State state2 = context2.getState(State::Positions);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(state2.getPositions()[i], state1.getPositions()[i], 1e-4);
+    delete system;
+}
+
+void testRejectedMove() {
+    // Increasing lambda costs far more than kT, so the move is rejected and the state is restored.
+
+    const int numParticles = 10;
+    System* system = createSystem(numParticles);
+    LangevinMiddleIntegrator integrator(300.0, 1.0, 0.002);
+    Context context(*system, integrator, platform);
+    vector<Vec3> positions = createPositions(numParticles);
+    context.setPositions(positions);
+    context.setVelocitiesToTemperature(300.0, 1);
+    State initialState = context.getState(State::Positions | State::Velocities);
+    NCMCDriver ncmc(context, 300.0, 5, 2);
+    ncmc.addParameter("lambda", {0.0, 10.0, 20.0, 30.0});
+    ASSERT(!ncmc.move());
+    ASSERT(ncmc.getLastWork() > 100.0);
+    ASSERT_EQUAL(0.0, context.getParameter("lambda"));
+    State state = context.getState(State::Positions | State::Velocities);
+    for (int i = 0; i < numParticles; i++) {
+        ASSERT_EQUAL_VEC(initialState.getPositions()[i], state.getPositions()[i], 1e-6);
+        ASSERT_EQUAL_VEC(initialState.getVelocities()[i], state.getVelocities()[i], 1e-6);
+    }
+
+    // The integrator should be able to continue from the restored state.
+
+    integrator.step(10);
+    ASSERT_EQUAL(1, ncmc.getNumAttempted());
+    ASSERT_EQUAL(0, ncmc.getNumAccepted());
+    delete system;
+}
+
+void testInvalidArguments() {
+    System* system = createSystem(1);
+    VerletIntegrator integrator(0.001);
+    Context context(*system, integrator, platform);
+    context.setPositions(createPositions(1));
+    bool threwException = false;
+    try {
+        NCMCDriver ncmc(context, -1.0);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    NCMCDriver ncmc(context, 300.0);
+
+    // A move needs at least one parameter.
+
+    threwException = false;
+    try {
+        ncmc.move();
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+
+    // The parameter must exist, and every schedule must have the same length.
+
+    threwException = false;
+    try {
+        ncmc.addParameter("missing", {0.0, 1.0});
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    ncmc.addParameter("lambda", {0.0, 1.0});
+    threwException = false;
+    try {
+        ncmc.addParameter("lambda", {0.0, 1.0});
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    delete system;
+}
+
+void runPlatformTests();
+
+int main(int argc, char* argv[]) {
+    try {
+        initializeTests(argc, argv);
+        testWorkWithoutSteps();
+        testWorkWithSteps();
+        testRejectedMove();
+        testInvalidArguments();
+        runPlatformTests();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
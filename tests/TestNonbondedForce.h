@@ -40,6 +40,7 @@
 #include "sfmt/SFMT.h"
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 #include <vector>
 
 using namespace OpenMM;
@@ -734,6 +735,74 @@ void testChangingParameters() {
     ASSERT_EQUAL_TOL(state.getPotentialEnergy(), referenceState.getPotentialEnergy(), tol);
 }
 
+void testChangingSubsetOfParameters() {
+    const int numMolecules = 300;
+    const int numParticles = numMolecules*3;
+    const double boxSize = 5.0;
+    const double tol = 2e-3;
+    ReferencePlatform reference;
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numMolecules; i++) {
+        for (int j = 0; j < 3; j++) {
+            system.addParticle(1.0);
+            nonbonded->addParticle(j == 0 ? -0.8 : 0.4, 0.3, 0.5);
+        }
+        positions[3*i] = Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+        positions[3*i+1] = positions[3*i]+Vec3(0.1, 0, 0);
+        positions[3*i+2] = positions[3*i]+Vec3(0, 0.1, 0);
+        nonbonded->addException(3*i, 3*i+1, 0.0, 1.0, 0.0);
+        nonbonded->addException(3*i, 3*i+2, 0.0, 1.0, 0.0);
+        nonbonded->addException(3*i+1, 3*i+2, 0.1, 0.2, 0.3);
+    }
+    nonbonded->setNonbondedMethod(NonbondedForce::PME);
+    nonbonded->setCutoffDistance(1.0);
+    nonbonded->setUseDispersionCorrection(true);
+    system.addForce(nonbonded);
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    context.getState(State::Energy);
+
+    // Modify a few particles and exceptions in the middle of the System, so only part of
+    // the data needs to be updated.
+
+    for (int i = 300; i < 309; i += 3) {
+        nonbonded->setParticleParameters(i, -0.6, 0.25, 0.7);
+        nonbonded->setParticleParameters(i+1, 0.3, 0.35, 0.4);
+        nonbonded->setParticleParameters(i+2, 0.3, 0.35, 0.4);
+        nonbonded->setExceptionParameters(i+2, i+1, i+2, 0.05, 0.25, 0.1);
+    }
+    nonbonded->updateParametersInContext(context);
+
+    // The results should match a new Context created from the modified System.
+
+    VerletIntegrator referenceIntegrator(0.001);
+    Context referenceContext(system, referenceIntegrator, reference);
+    referenceContext.setPositions(positions);
+    State state = context.getState(State::Forces | State::Energy);
+    State referenceState = referenceContext.getState(State::Forces | State::Energy);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(referenceState.getForces()[i], state.getForces()[i], tol);
+    ASSERT_EQUAL_TOL(referenceState.getPotentialEnergy(), state.getPotentialEnergy(), tol);
+
+    // Giving an excluded pair a nonzero interaction should be rejected.
+
+    nonbonded->setExceptionParameters(0, 0, 1, 0.1, 1.0, 0.0);
+    bool threwException = false;
+    try {
+        nonbonded->updateParametersInContext(context);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
 void testSwitchingFunction(NonbondedForce::NonbondedMethod method) {
     System system;
     system.setDefaultPeriodicBoxVectors(Vec3(6, 0, 0), Vec3(0, 6, 0), Vec3(0, 0, 6));
@@ -1119,6 +1188,654 @@ void testReordering() {
     }
 }
 
+void testEnergyWithoutForces(NonbondedForce::NonbondedMethod method) {
+    // Computing only the energy should give the same result as computing energy and forces together.
+
+    System system;
+    const int numMolecules = 100;
+    const double boxSize = 3.0;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(method);
+    nonbonded->setCutoffDistance(1.0);
+    system.addForce(nonbonded);
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    system.addForce(bonds);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> positions;
+    for (int i = 0; i < numMolecules; i++) {
+        system.addParticle(1.0);
+        system.addParticle(1.0);
+        nonbonded->addParticle(0.5, 0.3, 0.5);
+        nonbonded->addParticle(-0.5, 0.3, 0.5);
+        nonbonded->addException(2*i, 2*i+1, 0, 1, 0);
+        bonds->addBond(2*i, 2*i+1, 0.1, 1000.0);
+        Vec3 pos(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+        positions.push_back(pos);
+        positions.push_back(pos+Vec3(0.12, 0, 0));
+    }
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    double energy1 = context.getState(State::Energy).getPotentialEnergy();
+    double energy2 = context.getState(State::Forces | State::Energy).getPotentialEnergy();
+    double energy3 = context.getState(State::Energy).getPotentialEnergy();
+    ASSERT_EQUAL_TOL(energy2, energy1, 1e-5);
+    ASSERT_EQUAL_TOL(energy2, energy3, 1e-5);
+}
+
+double computeMaskedEnergy(NonbondedForce::NonbondedMethod method, const vector<Vec3>& positions, const vector<bool>& include) {
+    // Compute the energy of a test system in which only the specified particles interact.
+
+    int numParticles = positions.size();
+    System system;
+    const double boxSize = 3.0;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(method);
+    nonbonded->setCutoffDistance(1.0);
+    nonbonded->setUseSwitchingFunction(true);
+    nonbonded->setSwitchingDistance(0.8);
+    nonbonded->addGlobalParameter("scale", 0.5);
+    system.addForce(nonbonded);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        double scale = (include[i] ? 1.0 : 0.0);
+        nonbonded->addParticle(scale*(i%2 == 0 ? 0.5 : -0.5), 0.3, scale*0.5);
+    }
+    for (int i = 0; i < numParticles; i += 2) {
+        bool both = include[i] && include[i+1];
+        nonbonded->addException(i, i+1, both ? -0.1 : 0.0, 0.3, both ? 0.2 : 0.0);
+    }
+    nonbonded->addParticleParameterOffset("scale", 0, include[0] ? 0.4 : 0.0, 0.0, 0.0);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    return context.getState(State::Energy).getPotentialEnergy();
+}
+
+void testInteractionEnergy(NonbondedForce::NonbondedMethod method) {
+    // The interaction energy between two sets should equal the energy of the combined sets
+    // minus the energies of the individual sets.
+
+    const int numMolecules = 50;
+    const double boxSize = 3.0;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> positions;
+    for (int i = 0; i < numMolecules; i++) {
+        Vec3 pos(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+        positions.push_back(pos);
+        positions.push_back(pos+Vec3(0.12, 0, 0));
+    }
+    int numParticles = positions.size();
+    vector<int> set1, set2;
+    vector<bool> include1(numParticles, false), include2(numParticles, false), includeBoth(numParticles, false);
+    for (int i = 0; i < numParticles; i++) {
+        if (i%3 == 0) {
+            set1.push_back(i);
+            include1[i] = includeBoth[i] = true;
+        }
+        else if (i%3 == 1) {
+            set2.push_back(i);
+            include2[i] = includeBoth[i] = true;
+        }
+    }
+    double expected = computeMaskedEnergy(method, positions, includeBoth)-computeMaskedEnergy(method, positions, include1)-computeMaskedEnergy(method, positions, include2);
+
+    // Build the full system and compute the interaction energy.
+
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(method);
+    nonbonded->setCutoffDistance(1.0);
+    nonbonded->setUseSwitchingFunction(true);
+    nonbonded->setSwitchingDistance(0.8);
+    nonbonded->addGlobalParameter("scale", 0.5);
+    system.addForce(nonbonded);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.5 : -0.5, 0.3, 0.5);
+    }
+    for (int i = 0; i < numParticles; i += 2)
+        nonbonded->addException(i, i+1, -0.1, 0.3, 0.2);
+    nonbonded->addParticleParameterOffset("scale", 0, 0.4, 0.0, 0.0);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    ASSERT_EQUAL_TOL(expected, nonbonded->computeInteractionEnergy(context, set1, set2), 1e-5);
+    ASSERT_EQUAL_TOL(expected, nonbonded->computeInteractionEnergy(context, set2, set1), 1e-5);
+
+    // Overlapping sets should be rejected.
+
+    bool threwException = false;
+    try {
+        nonbonded->computeInteractionEnergy(context, set1, set1);
+    }
+    catch (const OpenMMException&) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+void testLocalEnergyChanges(NonbondedForce::NonbondedMethod method) {
+    // Build a system of small molecules, with exceptions and a parameter offset.
+
+    System system;
+    const int numMolecules = 60;
+    const double boxSize = 2.5;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(method);
+    nonbonded->setCutoffDistance(1.0);
+    nonbonded->setEwaldErrorTolerance(1e-5);
+    nonbonded->setUseDispersionCorrection(false);
+    nonbonded->addGlobalParameter("scale", 0.5);
+    system.addForce(nonbonded);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> positions;
+    for (int i = 0; i < numMolecules; i++) {
+        system.addParticle(1.0);
+        system.addParticle(1.0);
+        system.addParticle(1.0);
+        nonbonded->addParticle(-0.8, 0.3, 0.6);
+        nonbonded->addParticle(0.4, 0.1, 0.1);
+        nonbonded->addParticle(0.4, 0.1, 0.1);
+        nonbonded->addException(3*i, 3*i+1, 0, 1, 0);
+        nonbonded->addException(3*i, 3*i+2, 0, 1, 0);
+        nonbonded->addException(3*i+1, 3*i+2, 0.05, 0.2, 0.05);
+        Vec3 pos(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+        positions.push_back(pos);
+        positions.push_back(pos+Vec3(0.1, 0, 0));
+        positions.push_back(pos+Vec3(0, 0.1, 0));
+    }
+    nonbonded->addParticleParameterOffset("scale", 0, 0.2, 0.0, 0.0);
+    nonbonded->addParticleParameterOffset("scale", 3, -0.2, 0.0, 0.0);
+    nonbonded->addExceptionParameterOffset("scale", 2, 0.1, 0.0, 0.0);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    double energy1 = context.getState(State::Energy).getPotentialEnergy();
+    double tol = (method == NonbondedForce::PME ? 1e-3 : 1e-4);
+
+    // Displace the first molecule and compare the energy change to the full calculation.
+
+    vector<int> particles = {0, 1, 2};
+    vector<Vec3> newPositions;
+    for (int i = 0; i < 3; i++)
+        newPositions.push_back(positions[i]+Vec3(0.3, -0.2, 0.4));
+    double delta = nonbonded->computeEnergyChange(context, particles, newPositions);
+    vector<Vec3> movedPositions = positions;
+    for (int i = 0; i < 3; i++)
+        movedPositions[i] = newPositions[i];
+    context.setPositions(movedPositions);
+    double energy2 = context.getState(State::Energy).getPotentialEnergy();
+    ASSERT_EQUAL_TOL(energy2-energy1, delta, tol);
+
+    // Perform a sequence of trial moves of random molecules, accepting every other one.  Cached
+    // structure factors must stay consistent with a full recalculation.
+
+    double currentEnergy = energy2;
+    for (int move = 0; move < 10; move++) {
+        int molecule = (int) (numMolecules*genrand_real2(sfmt));
+        Vec3 displacement(0.4*genrand_real2(sfmt)-0.2, 0.4*genrand_real2(sfmt)-0.2, 0.4*genrand_real2(sfmt)-0.2);
+        particles = {3*molecule, 3*molecule+1, 3*molecule+2};
+        newPositions.clear();
+        for (int i : particles)
+            newPositions.push_back(movedPositions[i]+displacement);
+        delta = nonbonded->computeEnergyChange(context, particles, newPositions);
+        vector<Vec3> trialPositions = movedPositions;
+        for (int i = 0; i < 3; i++)
+            trialPositions[particles[i]] = newPositions[i];
+        context.setPositions(trialPositions);
+        double trialEnergy = context.getState(State::Energy).getPotentialEnergy();
+        ASSERT(fabs(trialEnergy-currentEnergy-delta) < 1e-2);
+        if (move%2 == 0) {
+            movedPositions = trialPositions;
+            currentEnergy = trialEnergy;
+        }
+        else
+            context.setPositions(movedPositions);
+    }
+    context.setPositions(positions);
+
+    // Switching off the first two molecules should change the energy by the value of computeParticleEnergy().
+
+    particles = {0, 1, 2, 3, 4, 5};
+    double particleEnergy = nonbonded->computeParticleEnergy(context, particles);
+    for (int i : particles)
+        nonbonded->setParticleParameters(i, 0.0, 0.1, 0.0);
+    for (int i = 0; i < 6; i++) {
+        int p1, p2;
+        double chargeProd, sigma, epsilon;
+        nonbonded->getExceptionParameters(i, p1, p2, chargeProd, sigma, epsilon);
+        nonbonded->setExceptionParameters(i, p1, p2, 0.0, sigma, 0.0);
+    }
+    nonbonded->setParticleParameterOffset(0, "scale", 0, 0.0, 0.0, 0.0);
+    nonbonded->setParticleParameterOffset(1, "scale", 3, 0.0, 0.0, 0.0);
+    nonbonded->setExceptionParameterOffset(0, "scale", 2, 0.0, 0.0, 0.0);
+    nonbonded->updateParametersInContext(context);
+    double energy3 = context.getState(State::Energy).getPotentialEnergy();
+    ASSERT_EQUAL_TOL(energy1-energy3, particleEnergy, tol);
+}
+
+void testStateEnergies(NonbondedForce::NonbondedMethod method) {
+    // Build a system where the parameters of some particles and exceptions depend on two global parameters.
+
+    System system;
+    const int numMolecules = 60;
+    const double boxSize = 2.5;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(method);
+    nonbonded->setCutoffDistance(1.0);
+    nonbonded->setEwaldErrorTolerance(1e-5);
+    nonbonded->addGlobalParameter("lambdaElec", 0.0);
+    nonbonded->addGlobalParameter("lambdaSterics", 0.0);
+    system.addForce(nonbonded);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> positions;
+    for (int i = 0; i < numMolecules; i++) {
+        system.addParticle(1.0);
+        system.addParticle(1.0);
+        nonbonded->addParticle(-0.5, 0.3, 0.6);
+        nonbonded->addParticle(0.5, 0.2, 0.2);
+        nonbonded->addException(2*i, 2*i+1, -0.1, 0.25, 0.1);
+        Vec3 pos(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+        positions.push_back(pos);
+        positions.push_back(pos+Vec3(0.1, 0, 0));
+    }
+    for (int i = 0; i < 4; i++) {
+        nonbonded->addParticleParameterOffset("lambdaElec", i, (i%2 == 0 ? 0.5 : -0.5), 0.0, 0.0);
+        nonbonded->addParticleParameterOffset("lambdaSterics", i, 0.0, 0.05, -0.1);
+    }
+    nonbonded->addExceptionParameterOffset("lambdaElec", 0, 0.1, 0.0, 0.0);
+    nonbonded->addExceptionParameterOffset("lambdaSterics", 1, 0.0, 0.0, -0.05);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+
+    // Compare the energies of several states to computing them one at a time.
+
+    vector<string> parameters = {"lambdaElec", "lambdaSterics"};
+    vector<vector<double> > values = {{0.0, 0.0}, {0.5, 0.0}, {1.0, 0.3}, {1.0, 1.0}};
+    vector<double> energies;
+    nonbonded->computeStateEnergies(context, parameters, values, energies);
+    ASSERT_EQUAL(values.size(), energies.size());
+    double tol = (method == NonbondedForce::PME ? 1e-4 : 1e-5);
+    for (int i = 0; i < values.size(); i++) {
+        context.setParameter("lambdaElec", values[i][0]);
+        context.setParameter("lambdaSterics", values[i][1]);
+        ASSERT_EQUAL_TOL(context.getState(State::Energy).getPotentialEnergy(), energies[i], tol);
+    }
+}
+
+void testSoluteScaling(NonbondedForce::NonbondedMethod method) {
+    // Build a system in which the first three molecules form the solute.
+
+    System system;
+    const int numMolecules = 40;
+    const int numSolute = 6;
+    const double boxSize = 2.5;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(method);
+    nonbonded->setCutoffDistance(1.0);
+    nonbonded->setEwaldErrorTolerance(1e-5);
+    nonbonded->addGlobalParameter("lambda", 0.5);
+    system.addForce(nonbonded);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> positions;
+    for (int i = 0; i < numMolecules; i++) {
+        system.addParticle(1.0);
+        system.addParticle(1.0);
+        nonbonded->addParticle(-0.5, 0.3, 0.6);
+        nonbonded->addParticle(0.5, 0.2, 0.2);
+        nonbonded->addException(2*i, 2*i+1, -0.1, 0.25, 0.1);
+        Vec3 pos(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+        positions.push_back(pos);
+        positions.push_back(pos+Vec3(0.1, 0, 0));
+    }
+    nonbonded->addException(1, 2, 0.2, 0.3, 0.2);
+    nonbonded->addException(5, 6, 0.3, 0.3, 0.1);
+    nonbonded->addParticleParameterOffset("lambda", 0, 0.2, 0.0, 0.1);
+    nonbonded->addParticleParameterOffset("lambda", 10, -0.2, 0.0, 0.1);
+    nonbonded->addExceptionParameterOffset("lambda", 0, 0.1, 0.0, 0.05);
+    nonbonded->addExceptionParameterOffset("lambda", numMolecules+1, 0.1, 0.0, 0.05);
+    vector<int> solute;
+    for (int i = 0; i < numSolute; i++)
+        solute.push_back(i);
+    nonbonded->setSoluteParticles(solute);
+    nonbonded->setSoluteScaleParameter("restScale");
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    ASSERT_EQUAL(1.0, context.getParameter("restScale"));
+
+    // Create a reference system in which the solute parameters are scaled by hand.
+
+    System refSystem;
+    refSystem.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    for (int i = 0; i < system.getNumParticles(); i++)
+        refSystem.addParticle(1.0);
+    NonbondedForce* ref = new NonbondedForce(*nonbonded);
+    ref->setSoluteScaleParameter("");
+    refSystem.addForce(ref);
+    auto scaleReference = [&] (double scale) {
+        for (int i = 0; i < numSolute; i++) {
+            double charge, sigma, epsilon;
+            nonbonded->getParticleParameters(i, charge, sigma, epsilon);
+            ref->setParticleParameters(i, charge*sqrt(scale), sigma, epsilon*scale);
+        }
+        for (int i = 0; i < nonbonded->getNumExceptions(); i++) {
+            int p1, p2;
+            double chargeProd, sigma, epsilon;
+            nonbonded->getExceptionParameters(i, p1, p2, chargeProd, sigma, epsilon);
+            double factor = (p1 < numSolute && p2 < numSolute ? scale : p1 < numSolute || p2 < numSolute ? sqrt(scale) : 1.0);
+            ref->setExceptionParameters(i, p1, p2, chargeProd*factor, sigma, epsilon*factor);
+        }
+        ref->setParticleParameterOffset(0, "lambda", 0, 0.2*sqrt(scale), 0.0, 0.1*scale);
+        ref->setExceptionParameterOffset(0, "lambda", 0, 0.1*scale, 0.0, 0.05*scale);
+        ref->setExceptionParameterOffset(1, "lambda", numMolecules+1, 0.1*sqrt(scale), 0.0, 0.05*sqrt(scale));
+    };
+    VerletIntegrator refIntegrator(0.001);
+    Context refContext(refSystem, refIntegrator, platform);
+    refContext.setPositions(positions);
+
+    // Compare the energies and forces for several values of the scale parameter.
+
+    double tol = (method == NonbondedForce::PME ? 1e-4 : 1e-5);
+    for (double scale : {0.7, 0.4, 1.0}) {
+        context.setParameter("restScale", scale);
+        scaleReference(scale);
+        ref->updateParametersInContext(refContext);
+        State state = context.getState(State::Energy | State::Forces);
+        State refState = refContext.getState(State::Energy | State::Forces);
+        ASSERT_EQUAL_TOL(refState.getPotentialEnergy(), state.getPotentialEnergy(), tol);
+        for (int i = 0; i < system.getNumParticles(); i++)
+            ASSERT_EQUAL_VEC(refState.getForces()[i], state.getForces()[i], tol);
+    }
+
+    // Modifying parameters while the solute is scaled should apply the scaling to the new values.
+
+    context.setParameter("restScale", 0.5);
+    nonbonded->setParticleParameters(2, -0.3, 0.3, 0.5);
+    nonbonded->updateParametersInContext(context);
+    scaleReference(0.5);
+    ref->updateParametersInContext(refContext);
+    ASSERT_EQUAL_TOL(refContext.getState(State::Energy).getPotentialEnergy(), context.getState(State::Energy).getPotentialEnergy(), tol);
+
+    // Changing the scale afterward should keep modified parameters of particles outside the solute.
+
+    nonbonded->setParticleParameters(20, -0.4, 0.3, 0.5);
+    nonbonded->updateParametersInContext(context);
+    context.setParameter("restScale", 0.8);
+    ref->setParticleParameters(20, -0.4, 0.3, 0.5);
+    scaleReference(0.8);
+    ref->updateParametersInContext(refContext);
+    State state = context.getState(State::Forces);
+    State refState = refContext.getState(State::Forces);
+    for (int i = 0; i < system.getNumParticles(); i++)
+        ASSERT_EQUAL_VEC(refState.getForces()[i], state.getForces()[i], tol);
+
+    // Computing energies for several values of the scale parameter should match setting them one at a time.
+
+    vector<string> parameters = {"restScale", "lambda"};
+    vector<vector<double> > values = {{1.0, 0.5}, {0.5, 0.5}, {0.3, 0.0}};
+    vector<double> energies;
+    nonbonded->computeStateEnergies(context, parameters, values, energies);
+    for (int i = 0; i < values.size(); i++) {
+        context.setParameter("restScale", values[i][0]);
+        context.setParameter("lambda", values[i][1]);
+        ASSERT_EQUAL_TOL(context.getState(State::Energy).getPotentialEnergy(), energies[i], tol);
+    }
+
+    // The scale parameter must be positive.
+
+    bool threwException = false;
+    try {
+        context.setParameter("restScale", 0.0);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+void testTitrationSites(NonbondedForce::NonbondedMethod method) {
+    // Build a system with two titration sites.
+
+    const int numMolecules = 40;
+    const double boxSize = 2.5;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> positions;
+    for (int i = 0; i < numMolecules; i++) {
+        Vec3 pos(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+        positions.push_back(pos);
+        positions.push_back(pos+Vec3(0.1, 0, 0));
+    }
+    auto createSystem = [&] (System& system, vector<double> charges, vector<double> sigmas, vector<double> epsilons) {
+        system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+        NonbondedForce* nonbonded = new NonbondedForce();
+        nonbonded->setNonbondedMethod(method);
+        nonbonded->setCutoffDistance(1.0);
+        nonbonded->setEwaldErrorTolerance(1e-5);
+        system.addForce(nonbonded);
+        for (int i = 0; i < 2*numMolecules; i++) {
+            system.addParticle(1.0);
+            nonbonded->addParticle(charges[i], sigmas[i], epsilons[i]);
+        }
+        for (int i = 0; i < numMolecules; i++)
+            nonbonded->addException(2*i, 2*i+1, 0.5*charges[2*i]*charges[2*i+1], 0.25, 0.5*sqrt(epsilons[2*i]*epsilons[2*i+1]));
+        nonbonded->addException(1, 2, 0.8*charges[1]*charges[2], 0.25, 0.5*sqrt(epsilons[1]*epsilons[2]));
+        return nonbonded;
+    };
+    vector<double> charges, sigmas, epsilons;
+    for (int i = 0; i < numMolecules; i++) {
+        charges.push_back(-0.5);
+        charges.push_back(0.5);
+        sigmas.push_back(0.3);
+        sigmas.push_back(0.2);
+        epsilons.push_back(0.6);
+        epsilons.push_back(0.2);
+    }
+    System system;
+    NonbondedForce* nonbonded = createSystem(system, charges, sigmas, epsilons);
+    int site1 = nonbonded->addTitrationSite("site1", {0, 1});
+    nonbonded->addTitrationState(site1, {-0.2, 0.2}, {0.3, 0.25}, {0.5, 0.3});
+    nonbonded->addTitrationState(site1, {-0.8, 0.3}, {0.32, 0.2}, {0.6, 0.1});
+    int site2 = nonbonded->addTitrationSite("site2", {4, 5});
+    nonbonded->addTitrationState(site2, {0.0, 0.5}, {0.3, 0.2}, {0.6, 0.2});
+    ASSERT_EQUAL(3, nonbonded->getNumTitrationStates(site1));
+    ASSERT_EQUAL(2, nonbonded->getNumTitrationStates(site2));
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    ASSERT_EQUAL(0.0, context.getParameter("site1"));
+
+    // Compare each combination of states to a reference system that has the corresponding parameters.
+
+    double tol = (method == NonbondedForce::PME ? 1e-4 : 1e-5);
+    for (int state1 = 0; state1 < 3; state1++)
+        for (int state2 = 0; state2 < 2; state2++) {
+            context.setParameter("site1", state1);
+            context.setParameter("site2", state2);
+            vector<double> refCharges = charges, refSigmas = sigmas, refEpsilons = epsilons;
+            vector<double> c, s, e;
+            if (state1 > 0) {
+                nonbonded->getTitrationStateParameters(site1, state1, c, s, e);
+                for (int i = 0; i < 2; i++) {
+                    refCharges[i] = c[i];
+                    refSigmas[i] = s[i];
+                    refEpsilons[i] = e[i];
+                }
+            }
+            if (state2 > 0) {
+                nonbonded->getTitrationStateParameters(site2, state2, c, s, e);
+                for (int i = 0; i < 2; i++) {
+                    refCharges[i+4] = c[i];
+                    refSigmas[i+4] = s[i];
+                    refEpsilons[i+4] = e[i];
+                }
+            }
+            System refSystem;
+            createSystem(refSystem, refCharges, refSigmas, refEpsilons);
+            VerletIntegrator refIntegrator(0.001);
+            Context refContext(refSystem, refIntegrator, platform);
+            refContext.setPositions(positions);
+            State state = context.getState(State::Energy | State::Forces);
+            State refState = refContext.getState(State::Energy | State::Forces);
+            ASSERT_EQUAL_TOL(refState.getPotentialEnergy(), state.getPotentialEnergy(), tol);
+            for (int i = 0; i < system.getNumParticles(); i++)
+                ASSERT_EQUAL_VEC(refState.getForces()[i], state.getForces()[i], tol);
+        }
+
+    // Check the energy change of switching states.
+
+    context.setParameter("site1", 1);
+    context.setParameter("site2", 0);
+    double energy1 = context.getState(State::Energy).getPotentialEnergy();
+    double delta = nonbonded->computeTitrationEnergyChange(context, site1, 2);
+    ASSERT_EQUAL(1.0, context.getParameter("site1"));
+    ASSERT_EQUAL_TOL(energy1, context.getState(State::Energy).getPotentialEnergy(), 1e-6);
+    context.setParameter("site1", 2);
+    double energy2 = context.getState(State::Energy).getPotentialEnergy();
+    ASSERT_EQUAL_TOL(energy2-energy1, delta, tol);
+
+    // An illegal state should throw an exception.
+
+    bool threwException = false;
+    try {
+        context.setParameter("site2", 2);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+void testTitrationCheckpoint() {
+    // The state must be restored correctly by loadCheckpoint() and reinitialize(), so switching to another
+    // state afterward deactivates the restored one.
+
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    system.addForce(nonbonded);
+    for (int i = 0; i < 3; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(0.0, 0.3, 0.0);
+    }
+    nonbonded->setParticleParameters(2, 1.0, 0.3, 0.0);
+    int site = nonbonded->addTitrationSite("site", {0, 1});
+    nonbonded->addTitrationState(site, {-1.0, 0.0}, {0.3, 0.3}, {0.0, 0.0});
+    nonbonded->addTitrationState(site, {-1.0, -1.0}, {0.3, 0.3}, {0.0, 0.0});
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions({Vec3(0, 0, 0), Vec3(0, 1, 0), Vec3(1, 0, 0)});
+    vector<double> energy(3);
+    for (int state = 0; state < 3; state++) {
+        context.setParameter("site", state);
+        energy[state] = context.getState(State::Energy).getPotentialEnergy();
+    }
+    ASSERT(fabs(energy[1]-energy[0]) > 1.0);
+    ASSERT(fabs(energy[2]-energy[1]) > 1.0);
+    stringstream checkpoint;
+    context.createCheckpoint(checkpoint);
+    context.setParameter("site", 0);
+    context.loadCheckpoint(checkpoint);
+    ASSERT_EQUAL_TOL(energy[2], context.getState(State::Energy).getPotentialEnergy(), 1e-5);
+    context.setParameter("site", 1);
+    ASSERT_EQUAL_TOL(energy[1], context.getState(State::Energy).getPotentialEnergy(), 1e-5);
+    context.setParameter("site", 2);
+    context.reinitialize(true);
+    ASSERT_EQUAL_TOL(energy[2], context.getState(State::Energy).getPotentialEnergy(), 1e-5);
+    context.setParameter("site", 1);
+    ASSERT_EQUAL_TOL(energy[1], context.getState(State::Energy).getPotentialEnergy(), 1e-5);
+    context.setParameter("site", 0);
+    ASSERT_EQUAL_TOL(energy[0], context.getState(State::Energy).getPotentialEnergy(), 1e-5);
+}
+
+void testTitrationDummyAtom() {
+    // A dummy proton has zero charge and epsilon in state 0, so the parameters of its 1-4 exception in
+    // the protonated state must be specified explicitly.
+
+    vector<Vec3> positions = {Vec3(0, 0, 0), Vec3(0.1, 0, 0), Vec3(0.15, 0.15, 0), Vec3(0.3, 0.1, 0.1), Vec3(0.5, 0.6, 0.3)};
+    auto createSystem = [&] (System& system, double hCharge, double hEpsilon, double chargeProd, double epsilon) {
+        NonbondedForce* nonbonded = new NonbondedForce();
+        system.addForce(nonbonded);
+        for (int i = 0; i < 5; i++)
+            system.addParticle(1.0);
+        nonbonded->addParticle(-0.4, 0.3, 0.5);
+        nonbonded->addParticle(0.2, 0.3, 0.4);
+        nonbonded->addParticle(-0.3, 0.3, 0.6);
+        nonbonded->addParticle(hCharge, 0.1, hEpsilon);
+        nonbonded->addParticle(0.5, 0.2, 0.3);
+        nonbonded->addException(0, 1, 0.0, 1.0, 0.0);
+        nonbonded->addException(1, 2, 0.0, 1.0, 0.0);
+        nonbonded->addException(2, 3, 0.0, 1.0, 0.0);
+        nonbonded->addException(0, 2, 0.0, 1.0, 0.0);
+        nonbonded->addException(1, 3, 0.0, 1.0, 0.0);
+        nonbonded->addException(0, 3, chargeProd, 0.2, epsilon);
+        return nonbonded;
+    };
+    double hCharge = 0.35, hEpsilon = 0.05;
+    double chargeProd = -0.4*hCharge/1.2, epsilon = 0.5*sqrt(0.5*hEpsilon);
+    System system;
+    NonbondedForce* nonbonded = createSystem(system, 0.0, 0.0, 0.0, 0.0);
+    int site = nonbonded->addTitrationSite("site", {3});
+    nonbonded->addTitrationState(site, {hCharge}, {0.1}, {hEpsilon});
+    nonbonded->setTitrationStateExceptionParameters(site, 1, 5, chargeProd, 0.2, epsilon);
+    ASSERT_EQUAL(1, nonbonded->getNumTitrationStateExceptions(site, 1));
+    int exception;
+    double q, sig, eps;
+    nonbonded->getTitrationStateExceptionParameters(site, 1, 0, exception, q, sig, eps);
+    ASSERT_EQUAL(5, exception);
+    ASSERT_EQUAL(chargeProd, q);
+    ASSERT_EQUAL(0.2, sig);
+    ASSERT_EQUAL(epsilon, eps);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+
+    // Compare both states to reference systems.
+
+    for (int state = 0; state < 2; state++) {
+        context.setParameter("site", state);
+        System refSystem;
+        if (state == 0)
+            createSystem(refSystem, 0.0, 0.0, 0.0, 0.0);
+        else
+            createSystem(refSystem, hCharge, hEpsilon, chargeProd, epsilon);
+        VerletIntegrator refIntegrator(0.001);
+        Context refContext(refSystem, refIntegrator, platform);
+        refContext.setPositions(positions);
+        State state1 = context.getState(State::Energy | State::Forces);
+        State state2 = refContext.getState(State::Energy | State::Forces);
+        ASSERT_EQUAL_TOL(state2.getPotentialEnergy(), state1.getPotentialEnergy(), 1e-5);
+        for (int i = 0; i < system.getNumParticles(); i++)
+            ASSERT_EQUAL_VEC(state2.getForces()[i], state1.getForces()[i], 1e-5);
+    }
+
+    // Explicit parameters for an exception that does not involve the site should be rejected.
+
+    nonbonded->setTitrationStateExceptionParameters(site, 1, 3, 0.1, 0.2, 0.3);
+    bool threwException = false;
+    try {
+        VerletIntegrator integrator2(0.001);
+        Context context2(system, integrator2, platform);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
 void runPlatformTests();
 
 int main(int argc, char* argv[]) {
@@ -1135,12 +1852,33 @@ int main(int argc, char* argv[]) {
         testLargeSystem();
         testDispersionCorrection();
         testChangingParameters();
+        testChangingSubsetOfParameters();
         testSwitchingFunction(NonbondedForce::CutoffNonPeriodic);
         testSwitchingFunction(NonbondedForce::PME);
         testTwoForces();
         testParameterOffsets();
         testEwaldExceptions();
         testDirectAndReciprocal();
+        testEnergyWithoutForces(NonbondedForce::Ewald);
+        testEnergyWithoutForces(NonbondedForce::PME);
+        testEnergyWithoutForces(NonbondedForce::LJPME);
+        testInteractionEnergy(NonbondedForce::NoCutoff);
+        testInteractionEnergy(NonbondedForce::CutoffNonPeriodic);
+        testInteractionEnergy(NonbondedForce::CutoffPeriodic);
+        testLocalEnergyChanges(NonbondedForce::NoCutoff);
+        testLocalEnergyChanges(NonbondedForce::CutoffPeriodic);
+        testLocalEnergyChanges(NonbondedForce::Ewald);
+        testLocalEnergyChanges(NonbondedForce::PME);
+        testStateEnergies(NonbondedForce::NoCutoff);
+        testStateEnergies(NonbondedForce::CutoffNonPeriodic);
+        testStateEnergies(NonbondedForce::Ewald);
+        testStateEnergies(NonbondedForce::PME);
+        testSoluteScaling(NonbondedForce::NoCutoff);
+        testSoluteScaling(NonbondedForce::PME);
+        testTitrationSites(NonbondedForce::NoCutoff);
+        testTitrationSites(NonbondedForce::PME);
+        testTitrationCheckpoint();
+        testTitrationDummyAtom();
         runPlatformTests();
     }
     catch(const exception& e) {
@@ -0,0 +1,198 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.            *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/CMMotionRemover.h"
+#include "openmm/Context.h"
+#include "openmm/CustomExternalForce.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/ObservableRecorder.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/Platform.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include "SimTKOpenMMRealType.h"
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+const double boxSize = 2.0;
+
+System* createSystem(int numParticles) {
+    System* system = new System();
+    system->setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    CustomExternalForce* external = new CustomExternalForce("x^2");
+    external->setForceGroup(1);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    nonbonded->setCutoffDistance(0.9);
+    nonbonded->setForceGroup(2);
+    for (int i = 0; i < numParticles; i++) {
+        system->addParticle(1.0);
+        external->addParticle(i);
+        nonbonded->addParticle(0.0, 0.3, 0.5);
+        if (i%2 == 1)
+            bonds->addBond(i-1, i, 0.15, 1000.0);
+    }
+    system->addForce(bonds);
+    system->addForce(external);
+    system->addForce(nonbonded);
+    return system;
+}
+
+vector<Vec3> createPositions(int numParticles) {
+    vector<Vec3> positions;
+    for (int i = 0; i < numParticles; i++)
+        positions.push_back(Vec3(0.5*(i/2), 0.5*(i%4 == 1 || i%4 == 2), 0.15*(i%2)));
+    return positions;
+}
+
+void testRecordObservables() {
+    const int numParticles = 8;
+    System* system = createSystem(numParticles);
+    VerletIntegrator integrator(0.001);
+    Context context(*system, integrator, Platform::getPlatform("Reference"));
+    context.setPositions(createPositions(numParticles));
+    context.setVelocitiesToTemperature(300.0);
+    ObservableRecorder recorder(context, 5, 10);
+    ASSERT_EQUAL(0, recorder.addPotentialEnergy());
+    ASSERT_EQUAL(1, recorder.addPotentialEnergy(1<<1));
+    ASSERT_EQUAL(2, recorder.addKineticEnergy());
+    ASSERT_EQUAL(3, recorder.addTemperature());
+    ASSERT_EQUAL(4, recorder.addVolume());
+    ASSERT_EQUAL(5, recorder.getNumObservables());
+
+    // Record samples one at a time and compare them to the State.
+
+    vector<State> states;
+    for (int i = 0; i < 4; i++) {
+        recorder.step(5);
+        states.push_back(context.getState(State::Energy));
+        ASSERT_EQUAL(i+1, recorder.getNumSamples());
+    }
+    states.push_back(context.getState(State::Energy, false, 1<<1));
+    vector<vector<double> > samples = recorder.drain();
+    ASSERT_EQUAL(4, samples.size());
+    ASSERT_EQUAL(0, recorder.getNumSamples());
+    for (int i = 0; i < 4; i++) {
+        ASSERT_EQUAL(6, samples[i].size());
+        ASSERT_EQUAL_TOL(0.005*(i+1), samples[i][0], 1e-10);
+        ASSERT_EQUAL_TOL(states[i].getPotentialEnergy(), samples[i][1], 1e-5);
+        ASSERT_EQUAL_TOL(states[i].getKineticEnergy(), samples[i][3], 1e-5);
+        ASSERT_EQUAL_TOL(2*states[i].getKineticEnergy()/(3*numParticles*BOLTZ), samples[i][4], 1e-5);
+        ASSERT_EQUAL_TOL(boxSize*boxSize*boxSize, samples[i][5], 1e-10);
+    }
+    ASSERT_EQUAL_TOL(states[4].getPotentialEnergy(), samples[3][2], 1e-5);
+
+    // Taking steps that do not reach a multiple of the interval should not record anything.
+
+    recorder.step(3);
+    ASSERT_EQUAL(0, recorder.getNumSamples());
+    recorder.step(2);
+    ASSERT_EQUAL(1, recorder.getNumSamples());
+    delete system;
+}
+
+void testRingBuffer() {
+    const int numParticles = 4;
+    System* system = createSystem(numParticles);
+    VerletIntegrator integrator(0.001);
+    Context context(*system, integrator, Platform::getPlatform("Reference"));
+    context.setPositions(createPositions(numParticles));
+    ObservableRecorder recorder(context, 2, 3);
+    recorder.addKineticEnergy();
+    recorder.step(10);
+
+    // Only the three most recent samples should be kept.
+
+    ASSERT_EQUAL(3, recorder.getNumSamples());
+    ASSERT_EQUAL(2, recorder.getNumDiscarded());
+    vector<vector<double> > samples = recorder.drain();
+    ASSERT_EQUAL(3, samples.size());
+    for (int i = 0; i < 3; i++)
+        ASSERT_EQUAL_TOL(0.001*(6+2*i), samples[i][0], 1e-10);
+    recorder.step(2);
+    samples = recorder.drain();
+    ASSERT_EQUAL(1, samples.size());
+    ASSERT_EQUAL_TOL(0.012, samples[0][0], 1e-10);
+
+    // Observables cannot be added while samples are stored.
+
+    recorder.recordSample();
+    bool threwException = false;
+    try {
+        recorder.addVolume();
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    delete system;
+}
+
+void testDegreesOfFreedom() {
+    const int numParticles = 7;
+    System* system = createSystem(numParticles);
+    system->addConstraint(0, 1, 0.15);
+    system->addConstraint(2, 3, 0.15);
+    system->setParticleMass(6, 0.0);
+    system->addForce(new CMMotionRemover());
+    VerletIntegrator integrator(0.001);
+    Context context(*system, integrator, Platform::getPlatform("Reference"));
+    context.setPositions(createPositions(numParticles));
+    context.setVelocitiesToTemperature(300.0);
+    ObservableRecorder recorder(context, 1, 1);
+    recorder.addKineticEnergy();
+    recorder.addTemperature();
+    recorder.recordSample();
+    vector<vector<double> > samples = recorder.drain();
+    int dof = 3*(numParticles-1)-2-3;
+    ASSERT_EQUAL_TOL(2*samples[0][1]/(dof*BOLTZ), samples[0][2], 1e-10);
+    delete system;
+}
+
+int main() {
+    try {
+        testRecordObservables();
+        testRingBuffer();
+        testDegreesOfFreedom();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
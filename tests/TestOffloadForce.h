@@ -0,0 +1,154 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/CustomCompoundBondForce.h"
+#include "openmm/HarmonicAngleForce.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/OffloadForce.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * Create the forces used by the tests.  The CustomCompoundBondForce depends on a global parameter.
+ */
+vector<Force*> createForces(int numParticles) {
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    HarmonicAngleForce* angles = new HarmonicAngleForce();
+    CustomCompoundBondForce* compound = new CustomCompoundBondForce(3, "k*(distance(p1,p2)+distance(p2,p3))^2");
+    compound->addGlobalParameter("k", 1.5);
+    for (int i = 0; i < numParticles-2; i++) {
+        bonds->addBond(i, i+1, 0.1+0.01*i, 100.0);
+        angles->addAngle(i, i+1, i+2, 1.5, 20.0);
+        compound->addBond({i, i+1, i+2});
+    }
+    return {bonds, angles, compound};
+}
+
+void testMatchesDirectCalculation() {
+    const int numParticles = 10;
+    System directSystem, offloadSystem;
+    for (int i = 0; i < numParticles; i++) {
+        directSystem.addParticle(1.0);
+        offloadSystem.addParticle(1.0);
+    }
+    for (Force* force : createForces(numParticles))
+        directSystem.addForce(force);
+    OffloadForce* offload = new OffloadForce("Reference");
+    for (Force* force : createForces(numParticles))
+        offload->addForce(force);
+    offloadSystem.addForce(offload);
+    ASSERT(!offload->usesPeriodicBoundaryConditions());
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt));
+    VerletIntegrator integrator1(0.001), integrator2(0.001);
+    Context directContext(directSystem, integrator1, platform);
+    Context offloadContext(offloadSystem, integrator2, platform);
+    directContext.setPositions(positions);
+    offloadContext.setPositions(positions);
+
+    // The forces and energy should match, including after a global parameter changes.
+
+    for (int iteration = 0; iteration < 2; iteration++) {
+        State state1 = directContext.getState(State::Forces | State::Energy);
+        State state2 = offloadContext.getState(State::Forces | State::Energy);
+        ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1e-5);
+        for (int i = 0; i < numParticles; i++)
+            ASSERT_EQUAL_VEC(state1.getForces()[i], state2.getForces()[i], 1e-5);
+        directContext.setParameter("k", 2.5);
+        offloadContext.setParameter("k", 2.5);
+    }
+}
+
+void testForceGroups() {
+    const int numParticles = 4;
+    System system;
+    for (int i = 0; i < numParticles; i++)
+        system.addParticle(1.0);
+    HarmonicBondForce* local = new HarmonicBondForce();
+    local->addBond(0, 3, 0.2, 50.0);
+    system.addForce(local);
+    OffloadForce* offload = new OffloadForce("Reference");
+    for (Force* force : createForces(numParticles))
+        offload->addForce(force);
+    offload->setForceGroup(2);
+    system.addForce(offload);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    vector<Vec3> positions = {Vec3(0, 0, 0), Vec3(0.1, 0, 0), Vec3(0.1, 0.12, 0), Vec3(0.3, 0, 0)};
+    context.setPositions(positions);
+
+    // The energy of each group should equal what the Forces compute on their own.
+
+    double localEnergy = context.getState(State::Energy, false, 1<<0).getPotentialEnergy();
+    double offloadEnergy = context.getState(State::Energy, false, 1<<2).getPotentialEnergy();
+    double totalEnergy = context.getState(State::Energy).getPotentialEnergy();
+    System innerSystem;
+    for (int i = 0; i < numParticles; i++)
+        innerSystem.addParticle(1.0);
+    for (Force* force : createForces(numParticles))
+        innerSystem.addForce(force);
+    VerletIntegrator integrator2(0.001);
+    Context innerContext(innerSystem, integrator2, platform);
+    innerContext.setPositions(positions);
+    double expectedOffload = innerContext.getState(State::Energy).getPotentialEnergy();
+    ASSERT_EQUAL_TOL(0.5*50.0*0.1*0.1, localEnergy, 1e-5);
+    ASSERT_EQUAL_TOL(expectedOffload, offloadEnergy, 1e-5);
+    ASSERT_EQUAL_TOL(localEnergy+offloadEnergy, totalEnergy, 1e-5);
+    ASSERT_EQUAL(1.5, offload->getInnerContext(context).getParameter("k"));
+}
+
+void runPlatformTests();
+
+int main(int argc, char* argv[]) {
+    try {
+        initializeTests(argc, argv);
+        testMatchesDirectCalculation();
+        testForceGroups();
+        runPlatformTests();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
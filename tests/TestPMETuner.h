@@ -0,0 +1,198 @@
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.            *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/PMETuner.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include "openmm/internal/NonbondedForceImpl.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+void buildIonSystem(System& system, NonbondedForce* nonbonded, vector<Vec3>& positions) {
+    const int numParticles = 200;
+    const double boxSize = 3.0;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    nonbonded->setNonbondedMethod(NonbondedForce::PME);
+    nonbonded->setCutoffDistance(1.0);
+    system.addForce(nonbonded);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    positions.resize(numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(10.0);
+        nonbonded->addParticle(i%2 == 0 ? 1.0 : -1.0, 0.3, 0.5);
+        positions[i] = Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+    }
+}
+
+void testTuneGrid() {
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    vector<Vec3> positions;
+    buildIonSystem(system, nonbonded, positions);
+    double defaultAlpha;
+    int defaultX, defaultY, defaultZ;
+    NonbondedForceImpl::calcPMEParameters(system, *nonbonded, defaultAlpha, defaultX, defaultY, defaultZ, false);
+    double initialEnergy;
+    {
+        VerletIntegrator integrator(0.001);
+        Context context(system, integrator, platform);
+        context.setPositions(positions);
+        initialEnergy = context.getState(State::Energy).getPotentialEnergy();
+    }
+    map<string, string> properties = PMETuner::tune(system, positions, platform, map<string, string>(), 2);
+
+    // The tuned parameters should keep alpha and use a grid at least as large as the default one.
+
+    double alpha;
+    int nx, ny, nz;
+    nonbonded->getPMEParameters(alpha, nx, ny, nz);
+    ASSERT_EQUAL_TOL(defaultAlpha, alpha, 1e-10);
+    ASSERT(nx >= defaultX);
+    ASSERT(ny >= defaultY);
+    ASSERT(nz >= defaultZ);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform, properties);
+    context.setPositions(positions);
+    double tunedEnergy = context.getState(State::Energy).getPotentialEnergy();
+    ASSERT_EQUAL_TOL(initialEnergy, tunedEnergy, 1e-3);
+}
+
+void testSelectGrid() {
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    vector<Vec3> positions;
+    buildIonSystem(system, nonbonded, positions);
+    nonbonded->setForceGroup(2);
+    double defaultAlpha;
+    int defaultX, defaultY, defaultZ;
+    NonbondedForceImpl::calcPMEParameters(system, *nonbonded, defaultAlpha, defaultX, defaultY, defaultZ, false);
+    PMETuner::selectGrid(system, positions, platform);
+
+    // The selected parameters should keep alpha, use a grid no larger than the default one, and
+    // leave the force groups unchanged.
+
+    double alpha;
+    int nx, ny, nz;
+    nonbonded->getPMEParameters(alpha, nx, ny, nz);
+    ASSERT_EQUAL_TOL(defaultAlpha, alpha, 1e-10);
+    ASSERT(nx <= defaultX);
+    ASSERT(ny <= defaultY);
+    ASSERT(nz <= defaultZ);
+    ASSERT_EQUAL(2, nonbonded->getForceGroup());
+    ASSERT_EQUAL(-1, nonbonded->getReciprocalSpaceForceGroup());
+
+    // The forces should match ones computed with a much finer grid to within the tolerance.
+
+    vector<Vec3> forces, referenceForces;
+    {
+        VerletIntegrator integrator(0.001);
+        Context context(system, integrator, platform);
+        context.setPositions(positions);
+        forces = context.getState(State::Forces).getForces();
+    }
+    nonbonded->setPMEParameters(alpha, 2*defaultX, 2*defaultY, 2*defaultZ);
+    {
+        VerletIntegrator integrator(0.001);
+        Context context(system, integrator, platform);
+        context.setPositions(positions);
+        referenceForces = context.getState(State::Forces).getForces();
+    }
+    double error = 0.0, norm = 0.0;
+    for (int i = 0; i < forces.size(); i++) {
+        Vec3 delta = forces[i]-referenceForces[i];
+        error += delta.dot(delta);
+        norm += referenceForces[i].dot(referenceForces[i]);
+    }
+    ASSERT(sqrt(error/norm) <= nonbonded->getEwaldErrorTolerance());
+}
+
+void testNoPME() {
+    // A System without PME should be left unchanged.
+
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    vector<Vec3> positions;
+    buildIonSystem(system, nonbonded, positions);
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    map<string, string> input;
+    map<string, string> properties = PMETuner::tune(system, positions, platform, input, 2);
+    ASSERT(properties == input);
+    double alpha;
+    int nx, ny, nz;
+    nonbonded->getPMEParameters(alpha, nx, ny, nz);
+    ASSERT_EQUAL(0.0, alpha);
+    ASSERT_EQUAL(0, nx);
+}
+
+void testWrongNumberOfPositions() {
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    vector<Vec3> positions;
+    buildIonSystem(system, nonbonded, positions);
+    positions.pop_back();
+    bool threwException = false;
+    try {
+        PMETuner::tune(system, positions, platform);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+void runPlatformTests();
+
+int main(int argc, char* argv[]) {
+    try {
+        initializeTests(argc, argv);
+        testTuneGrid();
+        testSelectGrid();
+        testNoPME();
+        testWrongNumberOfPositions();
+        runPlatformTests();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
@@ -115,9 +115,13 @@ void verifyEvaluation(const string& expression, double x, double y, double expec
     ASSERT_EQUAL(&x, &compiled2.getVariableReference("x"));
     ASSERT_EQUAL(&y, &compiled2.getVariableReference("y"));
 
-    // Try evaluating it as a vector.
+    // Try evaluating it as a vector.  Widths that are not compiled to machine code use the interpreter.
 
-    for (int width : CompiledVectorExpression::getAllowedWidths()) {
+    vector<int> widths = CompiledVectorExpression::getAllowedWidths();
+    widths.push_back(1);
+    widths.push_back(3);
+    widths.push_back(16);
+    for (int width : widths) {
         CompiledVectorExpression vector = parsed.createCompiledVectorExpression(width);
         for (int i = 0; i < width; i++) {
             if (vector.getVariables().find("x") != vector.getVariables().end())
@@ -283,6 +287,72 @@ void testCustomFunction(const string& expression, const string& equivalent) {
     verifySameValue(deriv3, deriv4, 2.0, -3.0);
 }
 
+/**
+ * Parsed, optimized, and differentiated expressions are cached.  Make sure expressions that differ only
+ * slightly are not confused with each other, and that repeated requests give the same results.
+ */
+
+void testCache() {
+    map<string, double> variables;
+    variables["x"] = 2.0;
+    for (int i = 0; i < 2; i++) {
+        ParsedExpression exp1 = Parser::parse("3*x^2+x").optimize();
+        ParsedExpression exp2 = Parser::parse("3.0000000001*x^2+x").optimize();
+        ASSERT_EQUAL_TOL(14.0, exp1.evaluate(variables), 1e-15);
+        ASSERT_EQUAL_TOL(14.0000000004, exp2.evaluate(variables), 1e-15);
+        ASSERT_EQUAL_TOL(13.0, exp1.differentiate("x").optimize().evaluate(variables), 1e-15);
+        ASSERT_EQUAL_TOL(13.0000000004, exp2.differentiate("x").optimize().evaluate(variables), 1e-15);
+        ASSERT_EQUAL_TOL(0.0, exp1.differentiate("y").optimize().evaluate(variables), 1e-15);
+    }
+}
+
+/**
+ * Test compiling several expressions together so they share common subexpressions.
+ */
+
+void testMultipleExpressions() {
+    vector<ParsedExpression> expressions;
+    expressions.push_back(Parser::parse("exp(-x/y)*x^2").optimize());
+    expressions.push_back(Parser::parse("exp(-x/y)*x^2").differentiate("x").optimize());
+    expressions.push_back(Parser::parse("y").optimize());
+    expressions.push_back(Parser::parse("exp(-x/y)+sin(y)").optimize());
+    double x = 1.3, y = 2.1;
+    map<string, double> variables;
+    variables["x"] = x;
+    variables["y"] = y;
+    vector<double> expected;
+    for (const ParsedExpression& exp : expressions)
+        expected.push_back(exp.evaluate(variables));
+    CompiledExpression compiled(expressions);
+    compiled.getVariableReference("x") = x;
+    compiled.getVariableReference("y") = y;
+    ASSERT_EQUAL_TOL(expected[3], compiled.evaluate(), 1e-10);
+    for (int i = 0; i < expressions.size(); i++)
+        ASSERT_EQUAL_TOL(expected[i], compiled.getResult(i), 1e-10);
+    CompiledExpression copy = compiled;
+    copy.getVariableReference("x") = x;
+    copy.getVariableReference("y") = y;
+    ASSERT_EQUAL_TOL(expected[3], copy.evaluate(), 1e-10);
+    for (int i = 0; i < expressions.size(); i++)
+        ASSERT_EQUAL_TOL(expected[i], copy.getResult(i), 1e-10);
+    vector<int> widths = CompiledVectorExpression::getAllowedWidths();
+    widths.push_back(16);
+    for (int width : widths) {
+        CompiledVectorExpression vector(expressions, width);
+        for (int j = 0; j < width; j++) {
+            vector.getVariablePointer("x")[j] = x+0.1*j;
+            vector.getVariablePointer("y")[j] = y;
+        }
+        const float* last = vector.evaluate();
+        for (int j = 0; j < width; j++) {
+            variables["x"] = x+0.1*j;
+            ASSERT_EQUAL_TOL(expressions[3].evaluate(variables), last[j], 1e-5);
+            for (int i = 0; i < expressions.size(); i++)
+                ASSERT_EQUAL_TOL(expressions[i].evaluate(variables), vector.getResult(i)[j], 1e-5);
+        }
+    }
+}
+
 int main() {
     try {
         verifyEvaluation("5", 5.0);
@@ -370,6 +440,8 @@ int main() {
         verifyDerivative("select(x, x^2, 3*x)", "select(x, 2*x, 3)");
         testCustomFunction("custom(x, y)/2", "x*y");
         testCustomFunction("custom(x^2, 1)+custom(2, y-1)", "2*x^2+4*(y-1)");
+        testCache();
+        testMultipleExpressions();
         cout << Parser::parse("x*x").optimize() << endl;
         cout << Parser::parse("x*(x*x)").optimize() << endl;
         cout << Parser::parse("(x*x)*x").optimize() << endl;
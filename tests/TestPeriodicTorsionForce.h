@@ -36,6 +36,7 @@
 #include "openmm/VerletIntegrator.h"
 #include "SimTKOpenMMRealType.h"
 #include <iostream>
+#include <sstream>
 #include <vector>
 
 using namespace OpenMM;
@@ -161,6 +162,101 @@ void testParallelComputation() {
     ASSERT(fabs(state1.getPotentialEnergy()-state3.getPotentialEnergy()) > 0.1);
 }
 
+void testSoluteScaling() {
+    // Create a chain of torsions where particles 0-4 form the solute.
+
+    System system;
+    const int numParticles = 10;
+    for (int i = 0; i < numParticles; i++)
+        system.addParticle(1.0);
+    PeriodicTorsionForce* force = new PeriodicTorsionForce();
+    for (int i = 3; i < numParticles; i++)
+        force->addTorsion(i-3, i-2, i-1, i, 2, 0.5, 1.0+i);
+    force->setSoluteParticles({0, 1, 2, 3, 4});
+    force->setSoluteScaleParameter("restScale");
+    system.addForce(force);
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = Vec3(i, i%2, i%3);
+    VerletIntegrator integrator(0.01);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+
+    // Create a reference force in which the force constants are scaled by hand.
+
+    System refSystem;
+    for (int i = 0; i < numParticles; i++)
+        refSystem.addParticle(1.0);
+    PeriodicTorsionForce* ref = new PeriodicTorsionForce();
+    for (int i = 3; i < numParticles; i++)
+        ref->addTorsion(i-3, i-2, i-1, i, 2, 0.5, 1.0+i);
+    refSystem.addForce(ref);
+    VerletIntegrator refIntegrator(0.01);
+    Context refContext(refSystem, refIntegrator, platform);
+    refContext.setPositions(positions);
+    for (double scale : {0.6, 0.25, 1.0}) {
+        context.setParameter("restScale", scale);
+        for (int i = 3; i < numParticles; i++) {
+            double factor = (i <= 4 ? scale : i <= 7 ? sqrt(scale) : 1.0);
+            ref->setTorsionParameters(i-3, i-3, i-2, i-1, i, 2, 0.5, (1.0+i)*factor);
+        }
+        ref->updateParametersInContext(refContext);
+        State state = context.getState(State::Energy | State::Forces);
+        State refState = refContext.getState(State::Energy | State::Forces);
+        ASSERT_EQUAL_TOL(refState.getPotentialEnergy(), state.getPotentialEnergy(), 1e-5);
+        for (int i = 0; i < numParticles; i++)
+            ASSERT_EQUAL_VEC(refState.getForces()[i], state.getForces()[i], 1e-5);
+    }
+
+    // Modify a torsion outside the solute while the solute is scaled, then change the scale.
+
+    context.setParameter("restScale", 0.5);
+    force->setTorsionParameters(6, 6, 7, 8, 9, 2, 0.5, 3.0);
+    force->updateParametersInContext(context);
+    context.setParameter("restScale", 0.8);
+    for (int i = 3; i < numParticles; i++) {
+        double factor = (i <= 4 ? 0.8 : i <= 7 ? sqrt(0.8) : 1.0);
+        ref->setTorsionParameters(i-3, i-3, i-2, i-1, i, 2, 0.5, (i == 9 ? 3.0 : 1.0+i)*factor);
+    }
+    ref->updateParametersInContext(refContext);
+    ASSERT_EQUAL_TOL(refContext.getState(State::Energy).getPotentialEnergy(), context.getState(State::Energy).getPotentialEnergy(), 1e-5);
+}
+
+void testSoluteScalingCheckpoint() {
+    // The scaled parameters must be restored by loadCheckpoint() and reinitialize().
+
+    System system;
+    const int numParticles = 10;
+    for (int i = 0; i < numParticles; i++)
+        system.addParticle(1.0);
+    PeriodicTorsionForce* force = new PeriodicTorsionForce();
+    for (int i = 3; i < numParticles; i++)
+        force->addTorsion(i-3, i-2, i-1, i, 2, 0.5, 1.0+i);
+    force->setSoluteParticles({0, 1, 2, 3, 4});
+    force->setSoluteScaleParameter("restScale");
+    system.addForce(force);
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = Vec3(i, i%2, i%3);
+    VerletIntegrator integrator(0.01);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    double unscaledEnergy = context.getState(State::Energy).getPotentialEnergy();
+    context.setParameter("restScale", 0.4);
+    double scaledEnergy = context.getState(State::Energy).getPotentialEnergy();
+    ASSERT(fabs(scaledEnergy-unscaledEnergy) > 0.1);
+    stringstream checkpoint;
+    context.createCheckpoint(checkpoint);
+    context.setParameter("restScale", 1.0);
+    ASSERT_EQUAL_TOL(unscaledEnergy, context.getState(State::Energy).getPotentialEnergy(), 1e-5);
+    context.loadCheckpoint(checkpoint);
+    ASSERT_EQUAL(0.4, context.getParameter("restScale"));
+    ASSERT_EQUAL_TOL(scaledEnergy, context.getState(State::Energy).getPotentialEnergy(), 1e-5);
+    context.reinitialize(true);
+    ASSERT_EQUAL(0.4, context.getParameter("restScale"));
+    ASSERT_EQUAL_TOL(scaledEnergy, context.getState(State::Energy).getPotentialEnergy(), 1e-5);
+}
+
 void runPlatformTests();
 
 int main(int argc, char* argv[]) {
@@ -168,6 +264,8 @@ int main(int argc, char* argv[]) {
         initializeTests(argc, argv);
         testPeriodicTorsions();
         testPeriodic();
+        testSoluteScaling();
+        testSoluteScalingCheckpoint();
         runPlatformTests();
     }
     catch(const exception& e) {
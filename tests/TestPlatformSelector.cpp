@@ -0,0 +1,154 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/Platform.h"
+#include "openmm/PlatformSelector.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+void buildSystem(System& system, vector<Vec3>& positions) {
+    const int numParticles = 20;
+    system.setDefaultPeriodicBoxVectors(Vec3(2, 0, 0), Vec3(0, 2, 0), Vec3(0, 0, 2));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::PME);
+    nonbonded->setCutoffDistance(0.9);
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    system.addForce(nonbonded);
+    system.addForce(bonds);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(10.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.5 : -0.5, 0.3, 0.5);
+        positions.push_back(Vec3(0.4*(i%5), 0.4*((i/5)%5), 0.5*(i/10)));
+        if (i%2 == 1)
+            bonds->addBond(i-1, i, 0.4, 100.0);
+    }
+}
+
+void testSelect() {
+    System system;
+    vector<Vec3> positions;
+    buildSystem(system, positions);
+    VerletIntegrator integrator(0.001);
+    PlatformSelector selector;
+    selector.setNumSteps(2);
+    selector.select(system, integrator, positions);
+    ASSERT(!selector.getLoadedFromCache());
+
+    // The selected Platform and properties should be usable to create a Context.
+
+    Platform& platform = selector.getPlatform();
+    Context context(system, integrator, platform, selector.getProperties());
+    context.setPositions(positions);
+    integrator.step(1);
+}
+
+void testCache() {
+    System system;
+    vector<Vec3> positions;
+    buildSystem(system, positions);
+
+    // Vary the step size so no cache entry from an earlier run of this test matches.
+
+    random_device random;
+    VerletIntegrator integrator(0.001*(1.0+1e-10*random()));
+    char* tmp = getenv("TMPDIR");
+    string directory = (tmp == NULL ? "/tmp" : string(tmp));
+    PlatformSelector selector;
+    selector.setNumSteps(2);
+    selector.setCacheDirectory(directory);
+    selector.select(system, integrator, positions);
+    ASSERT(!selector.getLoadedFromCache());
+    string firstPlatform = selector.getPlatform().getName();
+    map<string, string> firstProperties = selector.getProperties();
+
+    // A second selection for the same workload should load the decision from the cache.
+
+    PlatformSelector selector2;
+    selector2.setCacheDirectory(directory);
+    selector2.select(system, integrator, positions);
+    ASSERT(selector2.getLoadedFromCache());
+    ASSERT_EQUAL(firstPlatform, selector2.getPlatform().getName());
+    ASSERT(firstProperties == selector2.getProperties());
+
+    // Changing the System should invalidate it.
+
+    system.addParticle(1.0);
+    dynamic_cast<NonbondedForce&>(system.getForce(0)).addParticle(0.0, 0.3, 0.5);
+    positions.push_back(Vec3(1, 1, 1));
+    selector2.select(system, integrator, positions);
+    ASSERT(!selector2.getLoadedFromCache());
+}
+
+void testErrors() {
+    PlatformSelector selector;
+    bool threwException = false;
+    try {
+        selector.getPlatform();
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    threwException = false;
+    try {
+        selector.setNumSteps(0);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+int main() {
+    try {
+        testSelect();
+        testCache();
+        testErrors();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
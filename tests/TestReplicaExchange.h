@@ -0,0 +1,195 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.            *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/CustomExternalForce.h"
+#include "openmm/LangevinMiddleIntegrator.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/ReplicaExchange.h"
+#include "openmm/State.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include "SimTKOpenMMRealType.h"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * Build a System of particles in harmonic wells whose force constant is a global parameter.
+ */
+void buildOscillators(System& system, int numParticles) {
+    CustomExternalForce* force = new CustomExternalForce("0.5*k*(x^2+y^2+z^2)");
+    force->addGlobalParameter("k", 100.0);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        force->addParticle(i);
+    }
+    system.addForce(force);
+}
+
+vector<Vec3> randomPositions(int numParticles, int seed) {
+    vector<Vec3> positions;
+    for (int i = 0; i < numParticles; i++)
+        positions.push_back(Vec3(0.1*sin(seed+i), 0.1*cos(2.0*seed+i), 0.05*sin(3.0*seed-i)));
+    return positions;
+}
+
+void testTemperatureExchange() {
+    const int numParticles = 10;
+    System system;
+    buildOscillators(system, numParticles);
+    LangevinMiddleIntegrator integrator(300.0, 10.0, 0.01);
+    vector<double> temperatures = {300.0, 320.0, 340.0, 360.0};
+    ReplicaExchange exchange(system, integrator, temperatures, vector<map<string, double> >(), platform, map<string, string>(), 5);
+    ASSERT_EQUAL(4, exchange.getNumReplicas());
+    for (int i = 0; i < exchange.getNumReplicas(); i++) {
+        exchange.getContext(i).setPositions(randomPositions(numParticles, i));
+        exchange.getContext(i).setVelocitiesToTemperature(temperatures[i], i+1);
+    }
+    int totalAccepted = 0;
+    for (int i = 0; i < 50; i++) {
+        exchange.step(10);
+        totalAccepted += exchange.attemptExchanges();
+    }
+
+    // The states should still be a permutation, and each Integrator should have the
+    // temperature of the state its replica is in.
+
+    vector<int> states = exchange.getReplicaStates();
+    for (int i = 0; i < exchange.getNumReplicas(); i++) {
+        LangevinMiddleIntegrator& integ = dynamic_cast<LangevinMiddleIntegrator&>(exchange.getIntegrator(i));
+        ASSERT_EQUAL_TOL(temperatures[states[i]], integ.getTemperature(), 1e-10);
+    }
+    sort(states.begin(), states.end());
+    for (int i = 0; i < exchange.getNumReplicas(); i++)
+        ASSERT_EQUAL(i, states[i]);
+    int sumAccepted = 0, sumAttempted = 0;
+    for (int i = 0; i < exchange.getNumReplicas()-1; i++) {
+        sumAccepted += exchange.getNumAccepted(i);
+        sumAttempted += exchange.getNumAttempted(i);
+    }
+    ASSERT_EQUAL(totalAccepted, sumAccepted);
+    ASSERT_EQUAL(75, sumAttempted);
+    ASSERT(totalAccepted > 0);
+}
+
+void testHamiltonianExchange() {
+    const int numParticles = 5;
+    System system;
+    buildOscillators(system, numParticles);
+    LangevinMiddleIntegrator integrator(300.0, 10.0, 0.01);
+    vector<double> temperatures = {300.0, 300.0, 300.0};
+    vector<map<string, double> > parameters = {{{"k", 100.0}}, {{"k", 200.0}}, {{"k", 300.0}}};
+    ReplicaExchange exchange(system, integrator, temperatures, parameters, platform);
+    for (int i = 0; i < exchange.getNumReplicas(); i++)
+        exchange.getContext(i).setPositions(randomPositions(numParticles, i));
+
+    // Check the reduced potentials against the analytical energies.
+
+    vector<vector<double> > u = exchange.computeReducedPotentials();
+    double kT = BOLTZ*300.0;
+    for (int i = 0; i < exchange.getNumReplicas(); i++) {
+        vector<Vec3> pos = exchange.getContext(i).getState(State::Positions).getPositions();
+        double sum = 0.0;
+        for (const Vec3& p : pos)
+            sum += p.dot(p);
+        for (int j = 0; j < exchange.getNumReplicas(); j++)
+            ASSERT_EQUAL_TOL(0.5*parameters[j]["k"]*sum/kT, u[i][j], 1e-5);
+        ASSERT_EQUAL_TOL(parameters[i]["k"], exchange.getContext(i).getParameter("k"), 1e-10);
+    }
+
+    // After exchanges, each Context's parameters should match its state.
+
+    for (int i = 0; i < 20; i++) {
+        exchange.step(5);
+        exchange.attemptExchanges();
+    }
+    const vector<int>& states = exchange.getReplicaStates();
+    for (int i = 0; i < exchange.getNumReplicas(); i++)
+        ASSERT_EQUAL_TOL(parameters[states[i]]["k"], exchange.getContext(i).getParameter("k"), 1e-10);
+}
+
+void testIdenticalStates() {
+    // When all states are identical, every exchange should be accepted.
+
+    const int numParticles = 5;
+    System system;
+    buildOscillators(system, numParticles);
+    LangevinMiddleIntegrator integrator(300.0, 10.0, 0.01);
+    ReplicaExchange exchange(system, integrator, vector<double>(3, 300.0), vector<map<string, double> >(), platform);
+    for (int i = 0; i < exchange.getNumReplicas(); i++)
+        exchange.getContext(i).setPositions(randomPositions(numParticles, i));
+    for (int i = 0; i < 10; i++)
+        exchange.attemptExchanges();
+    for (int i = 0; i < exchange.getNumReplicas()-1; i++) {
+        ASSERT_EQUAL(5, exchange.getNumAttempted(i));
+        ASSERT_EQUAL(5, exchange.getNumAccepted(i));
+    }
+}
+
+void testInvalidIntegrator() {
+    // A VerletIntegrator has no temperature, so it cannot be used without a thermostat.
+
+    System system;
+    buildOscillators(system, 2);
+    VerletIntegrator integrator(0.01);
+    bool threwException = false;
+    try {
+        ReplicaExchange exchange(system, integrator, {300.0, 310.0}, vector<map<string, double> >(), platform);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+void runPlatformTests();
+
+int main(int argc, char* argv[]) {
+    try {
+        initializeTests(argc, argv);
+        testTemperatureExchange();
+        testHamiltonianExchange();
+        testIdenticalStates();
+        testInvalidIntegrator();
+        runPlatformTests();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
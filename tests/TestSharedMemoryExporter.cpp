@@ -0,0 +1,150 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.            *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/Platform.h"
+#include "openmm/SharedMemoryExporter.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+const string segmentName = "/TestSharedMemoryExporter";
+
+void buildSystem(System& system, int numParticles) {
+    system.setDefaultPeriodicBoxVectors(Vec3(3, 0, 0), Vec3(0.5, 3, 0), Vec3(0, 0.5, 3));
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    bonds->setUsesPeriodicBoundaryConditions(true);
+    system.addForce(bonds);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        if (i > 0)
+            bonds->addBond(i-1, i, 0.1, 100.0);
+    }
+}
+
+vector<Vec3> createPositions(int numParticles) {
+    vector<Vec3> positions;
+    for (int i = 0; i < numParticles; i++)
+        positions.push_back(Vec3(0.1*i, 0.02*sin(i), 0.03*cos(i)));
+    return positions;
+}
+
+template <class T>
+bool throwsException(T function) {
+    try {
+        function();
+    }
+    catch (const OpenMMException& ex) {
+        return true;
+    }
+    return false;
+}
+
+void testPublishFrames() {
+    const int numParticles = 20;
+    const int interval = 3;
+    const int numSlots = 4;
+    System system;
+    buildSystem(system, numParticles);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, Platform::getPlatform("Reference"));
+    context.setPositions(createPositions(numParticles));
+    SharedMemoryExporter exporter(context, segmentName, interval, numSlots, true);
+    SharedMemoryReader reader(segmentName);
+    ASSERT_EQUAL(numParticles, reader.getNumAtoms());
+    ASSERT_EQUAL(numSlots, reader.getNumSlots());
+    ASSERT_EQUAL(0, reader.getNumFrames());
+    ASSERT(throwsException([&] {reader.getLatestFrame();}));
+
+    // Publish frames one at a time and compare them to the Context.
+
+    for (int i = 0; i < 6; i++) {
+        exporter.step(interval);
+        exporter.flush();
+        ASSERT_EQUAL(i+1, reader.getNumFrames());
+        State expected = context.getState(State::Positions | State::Energy);
+        State frame = reader.getLatestFrame();
+        ASSERT_EQUAL(expected.getStepCount(), frame.getStepCount());
+        ASSERT_EQUAL_TOL(expected.getTime(), frame.getTime(), 1e-10);
+        ASSERT_EQUAL_TOL(expected.getPotentialEnergy(), frame.getPotentialEnergy(), 1e-10);
+        ASSERT_EQUAL_TOL(expected.getKineticEnergy(), frame.getKineticEnergy(), 1e-10);
+        for (int j = 0; j < numParticles; j++)
+            ASSERT_EQUAL_VEC(expected.getPositions()[j], frame.getPositions()[j], 0.0);
+        Vec3 a, b, c;
+        frame.getPeriodicBoxVectors(a, b, c);
+        ASSERT_EQUAL_VEC(Vec3(0.5, 3, 0), b, 0.0);
+    }
+
+    // Only the most recent frames should still be available.
+
+    ASSERT(throwsException([&] {reader.getFrame(1);}));
+    ASSERT(throwsException([&] {reader.getFrame(6);}));
+    for (int i = 2; i < 6; i++)
+        ASSERT_EQUAL((i+1)*interval, reader.getFrame(i).getStepCount());
+}
+
+void testNoEnergy() {
+    const int numParticles = 5;
+    System system;
+    buildSystem(system, numParticles);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, Platform::getPlatform("Reference"));
+    context.setPositions(createPositions(numParticles));
+    SharedMemoryExporter exporter(context, "TestSharedMemoryExporterNoEnergy", 1);
+    exporter.publishFrame();
+    exporter.flush();
+    SharedMemoryReader reader("/TestSharedMemoryExporterNoEnergy");
+    State frame = reader.getFrame(0);
+    ASSERT_EQUAL(0, frame.getStepCount());
+    ASSERT_EQUAL_VEC(Vec3(0.1, 0.02*sin(1.0), 0.03*cos(1.0)), frame.getPositions()[1], 1e-10);
+    ASSERT(throwsException([&] {frame.getPotentialEnergy();}));
+}
+
+int main() {
+    try {
+        testPublishFrames();
+        testNoEnergy();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
@@ -0,0 +1,184 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.            *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/CustomExternalForce.h"
+#include "openmm/LangevinMiddleIntegrator.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/SimulatedTemperingDriver.h"
+#include "openmm/State.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+void testTemperatureChanges() {
+    const int numParticles = 10;
+    System system;
+    CustomExternalForce* force = new CustomExternalForce("0.5*100*(x^2+y^2+z^2)");
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        force->addParticle(i);
+    }
+    system.addForce(force);
+    LangevinMiddleIntegrator integrator(300.0, 10.0, 0.01);
+    Context context(system, integrator, platform);
+    vector<Vec3> positions;
+    for (int i = 0; i < numParticles; i++)
+        positions.push_back(Vec3(0.1*sin(i), 0.1*cos(i), 0.0));
+    context.setPositions(positions);
+    vector<double> temperatures = {300.0, 330.0, 360.0, 400.0};
+    SimulatedTemperingDriver st(context, temperatures, vector<double>(), 10, 3);
+    ASSERT(st.getUpdateWeights());
+    ASSERT_EQUAL(0, st.getCurrentTemperature());
+    ASSERT_EQUAL_TOL(300.0, integrator.getTemperature(), 1e-10);
+
+    // Run the simulation, recording which temperatures it visits.
+
+    vector<int> visits(temperatures.size(), 0);
+    for (int i = 0; i < 300; i++) {
+        st.step(10);
+        visits[st.getCurrentTemperature()]++;
+        ASSERT_EQUAL_TOL(temperatures[st.getCurrentTemperature()], integrator.getTemperature(), 1e-10);
+    }
+    ASSERT_EQUAL(300, st.getNumAttempted());
+    ASSERT(st.getNumAccepted() > 0);
+    for (int count : visits)
+        ASSERT(count > 0);
+
+    // The weights should have been updated, and are reported relative to the first one.
+
+    vector<double> weights = st.getWeights();
+    ASSERT_EQUAL(0.0, weights[0]);
+    bool changed = false;
+    for (double w : weights)
+        if (w != 0.0)
+            changed = true;
+    ASSERT(changed);
+}
+
+void testVelocityScaling() {
+    // With no forces and no friction, the velocities only change when the temperature does.
+    // The weights are chosen so the second temperature is always selected.
+
+    const int numParticles = 5;
+    System system;
+    for (int i = 0; i < numParticles; i++)
+        system.addParticle(1.0);
+    LangevinMiddleIntegrator integrator(300.0, 0.0, 0.001);
+    Context context(system, integrator, platform);
+    vector<Vec3> positions, velocities;
+    for (int i = 0; i < numParticles; i++) {
+        positions.push_back(Vec3(i, 0, 0));
+        velocities.push_back(Vec3(0.1*i, -0.2, 0.3));
+    }
+    context.setPositions(positions);
+    context.setVelocities(velocities);
+    vector<double> temperatures = {300.0, 450.0};
+    SimulatedTemperingDriver st(context, temperatures, {0.0, 1000.0}, 5);
+    ASSERT(!st.getUpdateWeights());
+    st.step(5);
+    ASSERT_EQUAL(1, st.getCurrentTemperature());
+    ASSERT_EQUAL(1, st.getNumAccepted());
+    ASSERT_EQUAL_TOL(450.0, integrator.getTemperature(), 1e-10);
+    double scale = sqrt(450.0/300.0);
+    State state = context.getState(State::Velocities);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(velocities[i]*scale, state.getVelocities()[i], 1e-5);
+
+    // Further attempts should leave it at the same temperature, so the velocities don't change.
+
+    st.step(20);
+    ASSERT_EQUAL(5, st.getNumAttempted());
+    ASSERT_EQUAL(1, st.getNumAccepted());
+    state = context.getState(State::Velocities);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(velocities[i]*scale, state.getVelocities()[i], 1e-5);
+}
+
+void testInvalidArguments() {
+    System system;
+    system.addParticle(1.0);
+    LangevinMiddleIntegrator integrator(300.0, 1.0, 0.001);
+    Context context(system, integrator, platform);
+    bool threwException = false;
+    try {
+        SimulatedTemperingDriver st(context, {300.0, 290.0});
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    threwException = false;
+    try {
+        SimulatedTemperingDriver st(context, {300.0, 310.0}, {0.0});
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+
+    // A VerletIntegrator has no temperature, so it cannot be used without a thermostat.
+
+    VerletIntegrator verlet(0.001);
+    Context context2(system, verlet, platform);
+    threwException = false;
+    try {
+        SimulatedTemperingDriver st(context2, {300.0, 310.0});
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+void runPlatformTests();
+
+int main(int argc, char* argv[]) {
+    try {
+        initializeTests(argc, argv);
+        testTemperatureChanges();
+        testVelocityScaling();
+        testInvalidArguments();
+        runPlatformTests();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
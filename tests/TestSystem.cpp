@@ -30,11 +30,19 @@
  * -------------------------------------------------------------------------- */
 
 #include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/CustomNonbondedForce.h"
 #include "openmm/HarmonicAngleForce.h"
 #include "openmm/HarmonicBondForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/PeriodicTorsionForce.h"
 #include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
 #include "openmm/VirtualSite.h"
+#include <functional>
 #include <iostream>
+#include <vector>
 
 using namespace OpenMM;
 using namespace std;
@@ -111,9 +119,169 @@ void testCreateSystem() {
     }
 }
 
+void assertThrows(function<void ()> f) {
+    bool threwException = false;
+    try {
+        f();
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+/**
+ * Test the methods for adding many particles and interactions at once.
+ */
+void testAddInBulk() {
+    System system;
+    system.addParticle(5.0);
+    ASSERT_EQUAL(1, system.addParticles({1.0, 2.0, 3.0, 4.0}));
+    ASSERT_EQUAL(5, system.getNumParticles());
+    ASSERT_EQUAL(5.0, system.getParticleMass(0));
+    ASSERT_EQUAL(3.0, system.getParticleMass(3));
+    system.addConstraint(0, 1, 0.1);
+    ASSERT_EQUAL(1, system.addConstraints({1, 2}, {2, 3}, {0.2, 0.3}));
+    ASSERT_EQUAL(3, system.getNumConstraints());
+    int p1, p2, p3, p4, periodicity;
+    double length, k;
+    system.getConstraintParameters(2, p1, p2, length);
+    ASSERT_EQUAL(2, p1);
+    ASSERT_EQUAL(3, p2);
+    ASSERT_EQUAL(0.3, length);
+
+    HarmonicBondForce bonds;
+    ASSERT_EQUAL(0, bonds.addBonds({0, 1}, {1, 2}, {0.1, 0.2}, {10.0, 20.0}));
+    ASSERT_EQUAL(2, bonds.addBonds({3}, {4}, {0.3}, {30.0}));
+    ASSERT_EQUAL(3, bonds.getNumBonds());
+    bonds.getBondParameters(1, p1, p2, length, k);
+    ASSERT_EQUAL(1, p1);
+    ASSERT_EQUAL(2, p2);
+    ASSERT_EQUAL(0.2, length);
+    ASSERT_EQUAL(20.0, k);
+
+    HarmonicAngleForce angles;
+    ASSERT_EQUAL(0, angles.addAngles({0, 1}, {1, 2}, {2, 3}, {1.5, 2.0}, {50.0, 60.0}));
+    ASSERT_EQUAL(2, angles.getNumAngles());
+    double angle;
+    angles.getAngleParameters(1, p1, p2, p3, angle, k);
+    ASSERT_EQUAL(1, p1);
+    ASSERT_EQUAL(2, p2);
+    ASSERT_EQUAL(3, p3);
+    ASSERT_EQUAL(2.0, angle);
+    ASSERT_EQUAL(60.0, k);
+
+    PeriodicTorsionForce torsions;
+    ASSERT_EQUAL(0, torsions.addTorsions({0, 1}, {1, 2}, {2, 3}, {3, 4}, {1, 3}, {0.5, 1.5}, {5.0, 6.0}));
+    ASSERT_EQUAL(2, torsions.getNumTorsions());
+    double phase;
+    torsions.getTorsionParameters(1, p1, p2, p3, p4, periodicity, phase, k);
+    ASSERT_EQUAL(1, p1);
+    ASSERT_EQUAL(4, p4);
+    ASSERT_EQUAL(3, periodicity);
+    ASSERT_EQUAL(1.5, phase);
+    ASSERT_EQUAL(6.0, k);
+
+    NonbondedForce nonbonded;
+    ASSERT_EQUAL(0, nonbonded.addParticles({0.5, -0.5, 0.0}, {0.3, 0.4, 0.5}, {1.0, 2.0, 3.0}));
+    ASSERT_EQUAL(3, nonbonded.getNumParticles());
+    double charge, sigma, epsilon;
+    nonbonded.getParticleParameters(2, charge, sigma, epsilon);
+    ASSERT_EQUAL(0.0, charge);
+    ASSERT_EQUAL(0.5, sigma);
+    ASSERT_EQUAL(3.0, epsilon);
+    ASSERT_EQUAL(0, nonbonded.addExceptions({0, 1}, {1, 2}, {0.0, 0.1}, {1.0, 0.2}, {0.0, 0.3}));
+    ASSERT_EQUAL(2, nonbonded.getNumExceptions());
+    nonbonded.getExceptionParameters(1, p1, p2, charge, sigma, epsilon);
+    ASSERT_EQUAL(1, p1);
+    ASSERT_EQUAL(2, p2);
+    ASSERT_EQUAL(0.1, charge);
+
+    // Duplicate exceptions should be rejected unless replace is true.
+
+    assertThrows([&] () { nonbonded.addExceptions({2}, {1}, {0.5}, {1.0}, {0.0}); });
+    ASSERT_EQUAL(2, nonbonded.addExceptions({2}, {1}, {0.5}, {1.0}, {0.0}, true));
+    ASSERT_EQUAL(2, nonbonded.getNumExceptions());
+    nonbonded.getExceptionParameters(1, p1, p2, charge, sigma, epsilon);
+    ASSERT_EQUAL(0.5, charge);
+
+    // A failed call should not add any of its exceptions.
+
+    assertThrows([&] () { nonbonded.addExceptions({0, 1}, {2, 2}, {0.0, 0.0}, {1.0, 1.0}, {0.0, 0.0}); });
+    ASSERT_EQUAL(2, nonbonded.getNumExceptions());
+    ASSERT_EQUAL(2, nonbonded.addException(0, 2, 0.0, 1.0, 0.0));
+    ASSERT_EQUAL(3, nonbonded.addExceptions({1, 3}, {2, 4}, {0.2, 0.0}, {1.0, 1.0}, {0.1, 0.0}, true));
+    ASSERT_EQUAL(4, nonbonded.getNumExceptions());
+    nonbonded.getExceptionParameters(3, p1, p2, charge, sigma, epsilon);
+    ASSERT_EQUAL(3, p1);
+    ASSERT_EQUAL(4, p2);
+
+    // If every exception replaces an existing one, nothing is added and the return value is the
+    // number of exceptions.
+
+    ASSERT_EQUAL(4, nonbonded.addExceptions({2, 4}, {0, 3}, {0.3, 0.4}, {1.0, 1.0}, {0.2, 0.5}, true));
+    ASSERT_EQUAL(4, nonbonded.getNumExceptions());
+    nonbonded.getExceptionParameters(2, p1, p2, charge, sigma, epsilon);
+    ASSERT_EQUAL(0.3, charge);
+    nonbonded.getExceptionParameters(3, p1, p2, charge, sigma, epsilon);
+    ASSERT_EQUAL(0.4, charge);
+
+    CustomNonbondedForce custom("r");
+    custom.addExclusion(0, 1);
+    ASSERT_EQUAL(1, custom.addExclusions({1, 2}, {2, 3}));
+    ASSERT_EQUAL(3, custom.getNumExclusions());
+    custom.getExclusionParticles(2, p1, p2);
+    ASSERT_EQUAL(2, p1);
+    ASSERT_EQUAL(3, p2);
+
+    // Arrays of different lengths should be rejected.
+
+    assertThrows([&] () { system.addConstraints({0}, {1, 2}, {0.1}); });
+    assertThrows([&] () { bonds.addBonds({0}, {1}, {0.1}, {}); });
+    assertThrows([&] () { angles.addAngles({0}, {1}, {2}, {1.0, 2.0}, {1.0}); });
+    assertThrows([&] () { torsions.addTorsions({0}, {1}, {2}, {3}, {}, {0.0}, {1.0}); });
+    assertThrows([&] () { nonbonded.addParticles({0.0}, {0.1}, {}); });
+    assertThrows([&] () { nonbonded.addExceptions({0}, {2}, {0.0}, {0.1}, {0.0, 1.0}); });
+    assertThrows([&] () { custom.addExclusions({0, 1}, {2}); });
+}
+
+void testMoleculeTypes() {
+    System system;
+    for (int i = 0; i < 9; i++)
+        system.addParticle(1.0);
+    ASSERT_EQUAL(0, system.getNumMoleculeTypes());
+    ASSERT_EQUAL(0, system.addMoleculeType(3, {0, 3}));
+    ASSERT_EQUAL(1, system.addMoleculeType(1, {6, 7, 8}));
+    ASSERT_EQUAL(2, system.getNumMoleculeTypes());
+    int numParticles;
+    vector<int> firstParticles;
+    system.getMoleculeTypeParameters(1, numParticles, firstParticles);
+    ASSERT_EQUAL(1, numParticles);
+    vector<int> expected = {6, 7, 8};
+    ASSERT_EQUAL_CONTAINERS(expected, firstParticles);
+    assertThrows([&] () { system.addMoleculeType(0, {0}); });
+
+    // Creating a Context should check that the molecules are valid.
+
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, Platform::getPlatform("Reference"));
+    System system2;
+    for (int i = 0; i < 4; i++)
+        system2.addParticle(1.0);
+    system2.addMoleculeType(2, {0, 1});
+    assertThrows([&] () { VerletIntegrator integrator2(0.001); Context context2(system2, integrator2, Platform::getPlatform("Reference")); });
+    System system3;
+    for (int i = 0; i < 4; i++)
+        system3.addParticle(1.0);
+    system3.addMoleculeType(2, {0, 3});
+    assertThrows([&] () { VerletIntegrator integrator3(0.001); Context context3(system3, integrator3, Platform::getPlatform("Reference")); });
+}
+
 int main() {
     try {
         testCreateSystem();
+        testAddInBulk();
+        testMoleculeTypes();
     }
     catch(const exception& e) {
         cout << "exception: " << e.what() << endl;
@@ -0,0 +1,175 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.            *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/HarmonicAngleForce.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/PeriodicTorsionForce.h"
+#include "openmm/System.h"
+#include "openmm/SystemReplicator.h"
+#include "openmm/VerletIntegrator.h"
+#include "openmm/VirtualSite.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * Build a small molecule with bonds, angles, a torsion, a constraint, a virtual site, and
+ * nonbonded interactions.
+ */
+void buildMolecule(System& system, NonbondedForce::NonbondedMethod method) {
+    const int numAtoms = 6;
+    for (int i = 0; i < numAtoms; i++)
+        system.addParticle(i == numAtoms-1 ? 0.0 : 10.0);
+    system.setVirtualSite(numAtoms-1, new TwoParticleAverageSite(0, 1, 0.4, 0.6));
+    system.addConstraint(3, 4, 0.15);
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    HarmonicAngleForce* angles = new HarmonicAngleForce();
+    PeriodicTorsionForce* torsions = new PeriodicTorsionForce();
+    NonbondedForce* nonbonded = new NonbondedForce();
+    for (int i = 0; i < 4; i++)
+        bonds->addBond(i, i+1, 0.15, 1000.0);
+    for (int i = 0; i < 3; i++)
+        angles->addAngle(i, i+1, i+2, 1.9, 100.0);
+    torsions->addTorsion(0, 1, 2, 3, 2, 0.5, 5.0);
+    for (int i = 0; i < numAtoms; i++)
+        nonbonded->addParticle(i%2 == 0 ? 0.3 : -0.3, 0.25, i == numAtoms-1 ? 0.0 : 0.5);
+    vector<pair<int, int> > bondPairs;
+    for (int i = 0; i < 4; i++)
+        bondPairs.push_back(make_pair(i, i+1));
+    bondPairs.push_back(make_pair(0, numAtoms-1));
+    bondPairs.push_back(make_pair(1, numAtoms-1));
+    nonbonded->createExceptionsFromBonds(bondPairs, 0.5, 0.5);
+    nonbonded->setNonbondedMethod(method);
+    nonbonded->setCutoffDistance(2.0);
+    system.addForce(bonds);
+    system.addForce(angles);
+    system.addForce(torsions);
+    system.addForce(nonbonded);
+}
+
+void testReplicas() {
+    const int numReplicas = 4;
+    const double spacing = 10.0;
+    System system;
+    buildMolecule(system, NonbondedForce::CutoffNonPeriodic);
+    int numAtoms = system.getNumParticles();
+    System* replicated = SystemReplicator::createSystem(system, numReplicas, spacing);
+    ASSERT_EQUAL(numAtoms*numReplicas, replicated->getNumParticles());
+    ASSERT_EQUAL(numReplicas, replicated->getNumConstraints());
+    ASSERT_EQUAL(system.getNumForces(), replicated->getNumForces());
+
+    // Give each replica different positions.
+
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<vector<Vec3> > positions(numReplicas);
+    for (int r = 0; r < numReplicas; r++) {
+        for (int i = 0; i < numAtoms-1; i++)
+            positions[r].push_back(Vec3(0.15*i, 0.1*genrand_real2(sfmt), 0.1*genrand_real2(sfmt)));
+        positions[r].push_back(positions[r][0]*0.4+positions[r][1]*0.6);
+    }
+
+    // The energy of the ensemble should equal the sum of the energies of the individual
+    // replicas, and the forces on each replica should be unaffected by the others.
+
+    VerletIntegrator integrator(0.001);
+    Context context(*replicated, integrator, platform);
+    context.setPositions(SystemReplicator::combinePositions(positions, spacing));
+    State state = context.getState(State::Positions | State::Forces | State::Energy);
+    vector<vector<Vec3> > forces = SystemReplicator::splitValues(state.getForces(), numReplicas);
+    vector<vector<Vec3> > splitPositions = SystemReplicator::splitPositions(state.getPositions(), numReplicas, spacing);
+    double totalEnergy = 0.0;
+    for (int r = 0; r < numReplicas; r++) {
+        VerletIntegrator integrator2(0.001);
+        Context context2(system, integrator2, platform);
+        context2.setPositions(positions[r]);
+        State state2 = context2.getState(State::Forces | State::Energy);
+        totalEnergy += state2.getPotentialEnergy();
+        for (int i = 0; i < numAtoms; i++) {
+            ASSERT_EQUAL_VEC(state2.getForces()[i], forces[r][i], 1e-4);
+            ASSERT_EQUAL_VEC(positions[r][i], splitPositions[r][i], 1e-5);
+        }
+    }
+    ASSERT_EQUAL_TOL(totalEnergy, state.getPotentialEnergy(), 1e-4);
+    delete replicated;
+}
+
+void testInvalidSystems() {
+    // Without a cutoff, replicas would interact with each other.
+
+    System system;
+    buildMolecule(system, NonbondedForce::NoCutoff);
+    bool threwException = false;
+    try {
+        delete SystemReplicator::createSystem(system, 2, 10.0);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+
+    // The spacing must be larger than the cutoff.
+
+    System system2;
+    buildMolecule(system2, NonbondedForce::CutoffNonPeriodic);
+    threwException = false;
+    try {
+        delete SystemReplicator::createSystem(system2, 2, 1.0);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+void runPlatformTests();
+
+int main(int argc, char* argv[]) {
+    try {
+        initializeTests(argc, argv);
+        testReplicas();
+        testInvalidSystems();
+        runPlatformTests();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
@@ -0,0 +1,241 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.            *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/Platform.h"
+#include "openmm/System.h"
+#include "openmm/TrajectoryWriter.h"
+#include "openmm/VerletIntegrator.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+const string filename = "TestTrajectoryWriter.dcd";
+
+/**
+ * Read the header and all frames from a DCD file.
+ */
+void readDCD(int& firstStep, int& interval, int& numAtoms, vector<vector<Vec3> >& frames, vector<vector<double> >& cells) {
+    ifstream file(filename, ios::binary);
+    ASSERT(file.is_open());
+    char header[276];
+    file.read(header, sizeof(header));
+    ASSERT(file);
+    int values[9];
+    memcpy(values, &header[8], sizeof(values));
+    ASSERT(strncmp(&header[4], "CORD", 4) == 0);
+    int numFrames = values[0];
+    firstStep = values[1];
+    interval = values[2];
+    ASSERT_EQUAL(firstStep+(numFrames-1)*interval, values[3]);
+    int periodic;
+    memcpy(&periodic, &header[48], 4);
+    memcpy(&numAtoms, &header[268], 4);
+    frames.resize(numFrames);
+    cells.resize(numFrames);
+    for (int i = 0; i < numFrames; i++) {
+        int length;
+        if (periodic) {
+            cells[i].resize(6);
+            file.read((char*) &length, 4);
+            ASSERT_EQUAL(48, length);
+            file.read((char*) cells[i].data(), 48);
+            file.read((char*) &length, 4);
+        }
+        vector<float> coords(3*numAtoms);
+        for (int j = 0; j < 3; j++) {
+            file.read((char*) &length, 4);
+            ASSERT_EQUAL(4*numAtoms, length);
+            file.read((char*) &coords[j*numAtoms], 4*numAtoms);
+            file.read((char*) &length, 4);
+            ASSERT_EQUAL(4*numAtoms, length);
+        }
+        ASSERT(file);
+        for (int j = 0; j < numAtoms; j++)
+            frames[i].push_back(Vec3(coords[j], coords[j+numAtoms], coords[j+2*numAtoms])*0.1);
+    }
+    file.get();
+    ASSERT(file.eof());
+}
+
+void buildSystem(System& system, int numParticles) {
+    system.setDefaultPeriodicBoxVectors(Vec3(3, 0, 0), Vec3(0.5, 3, 0), Vec3(0, 0.5, 3));
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    bonds->setUsesPeriodicBoundaryConditions(true);
+    system.addForce(bonds);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        if (i > 0)
+            bonds->addBond(i-1, i, 0.1, 100.0);
+    }
+}
+
+vector<Vec3> createPositions(int numParticles) {
+    vector<Vec3> positions;
+    for (int i = 0; i < numParticles; i++)
+        positions.push_back(Vec3(0.1*i, 0.02*sin(i), 0.03*cos(i)));
+    return positions;
+}
+
+void testWriteTrajectory() {
+    const int numParticles = 20;
+    const int interval = 3;
+    System system;
+    buildSystem(system, numParticles);
+    VerletIntegrator integrator(0.002);
+    Context context(system, integrator, Platform::getPlatform("Reference"));
+    context.setPositions(createPositions(numParticles));
+    context.setVelocitiesToTemperature(300.0, 1);
+    vector<vector<Vec3> > expected;
+    {
+        TrajectoryWriter writer(context, filename, interval);
+        ASSERT_EQUAL(interval, writer.getInterval());
+
+        // Steps that don't end on a multiple of the interval should not produce frames.
+
+        writer.step(2);
+        ASSERT_EQUAL(0, writer.getNumFrames());
+        writer.step(1);
+        ASSERT_EQUAL(1, writer.getNumFrames());
+        expected.push_back(context.getState(State::Positions).getPositions());
+        for (int i = 0; i < 4; i++) {
+            writer.step(interval);
+            expected.push_back(context.getState(State::Positions).getPositions());
+        }
+        writer.flush();
+        ASSERT_EQUAL(5, writer.getNumFrames());
+    }
+    int firstStep, fileInterval, numAtoms;
+    vector<vector<Vec3> > frames;
+    vector<vector<double> > cells;
+    readDCD(firstStep, fileInterval, numAtoms, frames, cells);
+    ASSERT_EQUAL(interval, firstStep);
+    ASSERT_EQUAL(interval, fileInterval);
+    ASSERT_EQUAL(numParticles, numAtoms);
+    ASSERT_EQUAL(expected.size(), frames.size());
+    for (int i = 0; i < frames.size(); i++) {
+        for (int j = 0; j < numParticles; j++)
+            ASSERT_EQUAL_VEC(expected[i][j], frames[i][j], 1e-5);
+        ASSERT_EQUAL_TOL(30.0, cells[i][0], 1e-6);
+        ASSERT_EQUAL_TOL(0.5/sqrt(9.25), cells[i][1], 1e-6);
+        ASSERT_EQUAL_TOL(sqrt(9.25)*10, cells[i][2], 1e-6);
+        ASSERT_EQUAL_TOL(0.0, cells[i][3], 1e-6);
+        ASSERT_EQUAL_TOL(1.5/(sqrt(9.25)*sqrt(9.25)), cells[i][4], 1e-6);
+        ASSERT_EQUAL_TOL(sqrt(9.25)*10, cells[i][5], 1e-6);
+    }
+}
+
+void testAtomSubsetAndAppend() {
+    const int numParticles = 10;
+    System system;
+    buildSystem(system, numParticles);
+    VerletIntegrator integrator(0.002);
+    Context context(system, integrator, Platform::getPlatform("Reference"));
+    context.setPositions(createPositions(numParticles));
+    vector<int> subset = {1, 4, 7};
+    vector<vector<Vec3> > expected;
+    for (int pass = 0; pass < 2; pass++) {
+        TrajectoryWriter writer(context, filename, 2, false, subset, pass == 1);
+        ASSERT_EQUAL(2*pass, writer.getNumFrames());
+        for (int i = 0; i < 2; i++) {
+            writer.step(2);
+            expected.push_back(context.getState(State::Positions).getPositions());
+        }
+    }
+    int firstStep, interval, numAtoms;
+    vector<vector<Vec3> > frames;
+    vector<vector<double> > cells;
+    readDCD(firstStep, interval, numAtoms, frames, cells);
+    ASSERT_EQUAL(2, firstStep);
+    ASSERT_EQUAL(2, interval);
+    ASSERT_EQUAL(subset.size(), numAtoms);
+    ASSERT_EQUAL(4, frames.size());
+    for (int i = 0; i < frames.size(); i++)
+        for (int j = 0; j < subset.size(); j++)
+            ASSERT_EQUAL_VEC(expected[i][subset[j]], frames[i][j], 1e-5);
+
+    // Appending with a different number of atoms should fail.
+
+    bool threwException = false;
+    try {
+        TrajectoryWriter writer(context, filename, 2, false, vector<int>(), true);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+void testNaN() {
+    const int numParticles = 4;
+    System system;
+    buildSystem(system, numParticles);
+    VerletIntegrator integrator(0.002);
+    Context context(system, integrator, Platform::getPlatform("Reference"));
+    vector<Vec3> positions = createPositions(numParticles);
+    positions[2][1] = NAN;
+    context.setPositions(positions);
+    TrajectoryWriter writer(context, filename, 1);
+    writer.writeFrame();
+    bool threwException = false;
+    try {
+        writer.flush();
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+int main() {
+    try {
+        testWriteTrajectory();
+        testAtomSubsetAndAppend();
+        testNaN();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        remove(filename.c_str());
+        return 1;
+    }
+    remove(filename.c_str());
+    cout << "Done" << endl;
+    return 0;
+}
@@ -23,7 +23,7 @@ if sys.platform == 'win32':
 
 from openmm.openmm import *
 from openmm.vec3 import Vec3
-from openmm.mtsintegrator import MTSIntegrator, MTSLangevinIntegrator
+from openmm.mtsintegrator import MTSIntegrator
 from openmm.amd import AMDIntegrator, AMDForceGroupIntegrator, DualAMDIntegrator
 
 if os.getenv('OPENMM_PLUGIN_DIR') is None and os.path.isdir(version.openmm_library_path):
@@ -906,7 +906,7 @@ class CharmmPsfFile(object):
         if verbose: print('Adding particles...')
         for atom in self.atom_list:
             typenames.add(atom.type.name)
-            system.addParticle(atom.mass)
+        system.addParticles([atom.mass for atom in self.atom_list])
         has_nbfix_terms = False
         typenames = list(typenames)
         try:
@@ -998,13 +998,16 @@ class CharmmPsfFile(object):
         omit_all = not flexibleConstraints and constraints in (ff.AllBonds, ff.HAngles)
         omit_h = not flexibleConstraints and constraints is not None
         omit_h_in_water = not flexibleConstraints and (constraints is not None or rigidWater)
+        bonds = []
         for bond in self.bond_list:
             if omit_all: continue
             if omit_h and (bond.atom1.type.atomic_number == 1 or bond.atom2.type.atomic_number == 1): continue
             if omit_h_in_water and _is_bond_in_water(bond): continue
-            force.addBond(bond.atom1.idx, bond.atom2.idx,
-                          bond.bond_type.req*length_conv,
-                          2*bond.bond_type.k*bond_frc_conv)
+            bonds.append(bond)
+        if len(bonds) > 0:
+            force.addBonds([bond.atom1.idx for bond in bonds], [bond.atom2.idx for bond in bonds],
+                           [bond.bond_type.req*length_conv for bond in bonds],
+                           [2*bond.bond_type.k*bond_frc_conv for bond in bonds])
         system.addForce(force)
         # Add Angle forces
         if verbose: print('Adding angles...')
@@ -1064,21 +1067,24 @@ class CharmmPsfFile(object):
         if verbose: print('Adding Urey-Bradley terms')
         force = mm.HarmonicBondForce()
         force.setForceGroup(self.UREY_BRADLEY_FORCE_GROUP)
-        for ub in self.urey_bradley_list:
-            force.addBond(ub.atom1.idx, ub.atom2.idx,
-                          ub.ub_type.req*length_conv,
-                          2*ub.ub_type.k*bond_frc_conv)
+        ubs = self.urey_bradley_list
+        if len(ubs) > 0:
+            force.addBonds([ub.atom1.idx for ub in ubs], [ub.atom2.idx for ub in ubs],
+                           [ub.ub_type.req*length_conv for ub in ubs],
+                           [2*ub.ub_type.k*bond_frc_conv for ub in ubs])
         system.addForce(force)
 
         # Add dihedral forces
         if verbose: print('Adding torsions...')
         force = mm.PeriodicTorsionForce()
         force.setForceGroup(self.DIHEDRAL_FORCE_GROUP)
-        for tor in self.dihedral_parameter_list:
-            force.addTorsion(tor.atom1.idx, tor.atom2.idx, tor.atom3.idx,
-                             tor.atom4.idx, tor.dihedral_type.per,
-                             tor.dihedral_type.phase*pi/180,
-                             tor.dihedral_type.phi_k*dihe_frc_conv)
+        tors = self.dihedral_parameter_list
+        if len(tors) > 0:
+            force.addTorsions([tor.atom1.idx for tor in tors], [tor.atom2.idx for tor in tors],
+                              [tor.atom3.idx for tor in tors], [tor.atom4.idx for tor in tors],
+                              [tor.dihedral_type.per for tor in tors],
+                              [tor.dihedral_type.phase*pi/180 for tor in tors],
+                              [tor.dihedral_type.phi_k*dihe_frc_conv for tor in tors])
         system.addForce(force)
 
         if verbose: print('Adding impropers...')
@@ -35,6 +35,8 @@ __version__ = "1.0"
 
 import os
 import itertools
+import hashlib
+import tempfile
 import xml.etree.ElementTree as etree
 import math
 import warnings
@@ -217,6 +219,8 @@ class ForceField(object):
         self._scripts = []
         self._templateMatchers = []
         self._templateGenerators = []
+        self._sourceHash = hashlib.sha256()
+        self._systemCacheDirectory = None
         self.loadFile(files)
 
     def loadFile(self, files, resname_prefix=''):
@@ -281,6 +285,12 @@ class ForceField(object):
                 if includeFile not in files:
                     files.append(includeFile)
 
+        # Record the contents of the files so createSystem() can tell when a cached System is valid.
+
+        for tree in trees:
+            self._sourceHash.update(resname_prefix.encode())
+            self._sourceHash.update(etree.tostring(tree.getroot()))
+
         # Load the atom types.
 
         for tree in trees:
@@ -666,9 +676,9 @@ class ForceField(object):
                 self.atomType[atom] = template.atoms[match].type
                 self.atomParameters[atom] = template.atoms[match].parameters
                 self.atomTemplateIndexes[atom] = match
-                for site in template.virtualSites:
-                    if match == site.index:
-                        self.virtualSites[atom] = (site, [matchAtoms[i].index for i in site.atoms], matchAtoms[site.excludeWith].index)
+            for site in template.virtualSites:
+                if site.index in matchAtoms:
+                    self.virtualSites[matchAtoms[site.index]] = (site, [matchAtoms[i].index for i in site.atoms], matchAtoms[site.excludeWith].index)
 
     class _TemplateData(object):
         """Inner class used to encapsulate data about a residue template definition."""
@@ -1184,6 +1194,55 @@ class ForceField(object):
 
         return [templates, unique_unmatched_residues]
 
+    def setSystemCacheDirectory(self, directory):
+        """Set a directory in which createSystem() caches the Systems it creates.
+
+        Each System is saved in the binary serialization format under a key computed
+        from the contents of the force field files, the Topology, and the arguments to
+        createSystem().  When createSystem() is later called with the same inputs, the
+        System is loaded from the cache instead of being built again.  This is useful
+        when the same System is created many times, for example by several replicas or
+        when restarting a simulation.
+
+        The key covers files added with loadFile() and the constructor.  The cache is
+        not used if template generators or template matchers have been registered, since
+        they can produce different results for the same inputs.  If you modify the
+        ForceField in any other way, such as by calling registerAtomType() directly, do not
+        use a cache.
+
+        Parameters
+        ----------
+        directory : str
+            The directory in which to store cached Systems.  It is created if it does not
+            exist.  If this is None, caching is disabled.
+        """
+        if directory is not None:
+            os.makedirs(directory, exist_ok=True)
+        self._systemCacheDirectory = directory
+
+    def getSystemCacheDirectory(self):
+        """Get the directory in which createSystem() caches Systems, or None if caching is disabled."""
+        return self._systemCacheDirectory
+
+    def _getSystemCacheKey(self, topology, createArgs):
+        """Compute the key identifying a System in the cache."""
+        h = self._sourceHash.copy()
+        for chain in topology.chains():
+            h.update(b'chain\n')
+            for res in chain.residues():
+                h.update(('residue %s\n' % res.name).encode())
+                for atom in res.atoms():
+                    h.update(('%s %s\n' % (atom.name, '' if atom.element is None else atom.element.symbol)).encode())
+        for bond in topology.bonds():
+            h.update(('bond %d %d %r %r\n' % (bond[0].index, bond[1].index, bond.type, bond.order)).encode())
+        h.update(repr(topology.getPeriodicBoxVectors()).encode())
+        for name in sorted(createArgs):
+            value = createArgs[name]
+            if name == 'residueTemplates':
+                value = sorted((res.index, template) for res, template in value.items())
+            h.update(('%s=%r\n' % (name, value)).encode())
+        return h.hexdigest()
+
     def createSystem(self, topology, nonbondedMethod=NoCutoff, nonbondedCutoff=1.0*unit.nanometer,
                      constraints=None, rigidWater=None, removeCMMotion=True, hydrogenMass=None, residueTemplates=dict(),
                      ignoreExternalBonds=False, switchDistance=None, flexibleConstraints=False, drudeMass=0.4*unit.amu, **args):
@@ -1245,6 +1304,17 @@ class ForceField(object):
         args['switchDistance'] = switchDistance
         args['flexibleConstraints'] = flexibleConstraints
         args['drudeMass'] = drudeMass
+
+        # If caching is enabled, see whether this System has already been created.
+
+        cacheFile = None
+        if self._systemCacheDirectory is not None and len(self._templateGenerators) == 0 and len(self._templateMatchers) == 0:
+            createArgs = dict(args, nonbondedMethod=nonbondedMethod, nonbondedCutoff=nonbondedCutoff, constraints=constraints,
+                              rigidWater=rigidWater, removeCMMotion=removeCMMotion, hydrogenMass=hydrogenMass,
+                              residueTemplates=residueTemplates, ignoreExternalBonds=ignoreExternalBonds)
+            cacheFile = os.path.join(self._systemCacheDirectory, self._getSystemCacheKey(topology, createArgs)+'.bin')
+            if os.path.isfile(cacheFile):
+                return mm.XmlSerializer._deserializeSystemBinaryFile(cacheFile)
         args = ArgTracker(args)
         data = ForceField._SystemData(topology)
         rigidResidue = [False]*topology.getNumResidues()
@@ -1417,6 +1487,19 @@ class ForceField(object):
         for script in self._scripts:
             exec(script, locals())
         args.checkArgs(self.createSystem)
+
+        # Save the System to the cache.  It is written to a temporary file and then renamed, so
+        # other processes sharing the cache never see a partially written file.
+
+        if cacheFile is not None:
+            (fd, tempFile) = tempfile.mkstemp(dir=self._systemCacheDirectory, suffix='.tmp')
+            os.close(fd)
+            try:
+                mm.XmlSerializer._serializeSystemBinaryFile(sys, tempFile)
+                os.replace(tempFile, cacheFile)
+            except:
+                os.remove(tempFile)
+                raise
         return sys
 
 
@@ -1424,6 +1507,14 @@ class ForceField(object):
         """Return a list of which template matches each residue in the topology, and assign atom types."""
         templateForResidue = [None]*topology.getNumResidues()
         unmatchedResidues = []
+
+        # Residues with identical atoms and bonds, such as the many copies of each amino acid and every
+        # water molecule, always match the same template in the same way, so only the first residue of
+        # each kind needs to be matched.  Custom template matchers may depend on anything, so the cache
+        # is only used when there are none.
+
+        useCache = (len(self._templateMatchers) == 0)
+        matchCache = {}
         for chain in topology.chains():
             for res in chain.residues():
                 if res in residueTemplates:
@@ -1432,6 +1523,11 @@ class ForceField(object):
                     matches = compiled.matchResidueToTemplate(res, template, data.bondedToAtom, ignoreExternalBonds, ignoreExtraParticles)
                     if matches is None:
                         raise Exception('User-supplied template %s does not match the residue %d (%s)' % (tname, res.index, res.name))
+                elif useCache:
+                    key = _createResidueGraphKey(res, data.bondedToAtom)
+                    if key not in matchCache:
+                        matchCache[key] = self._getResidueTemplateMatches(res, data.bondedToAtom, ignoreExternalBonds=ignoreExternalBonds, ignoreExtraParticles=ignoreExtraParticles)
+                    [template, matches] = matchCache[key]
                 else:
                     # Attempt to match one of the existing templates.
                     [template, matches] = self._getResidueTemplateMatches(res, data.bondedToAtom, ignoreExternalBonds=ignoreExternalBonds, ignoreExtraParticles=ignoreExtraParticles)
@@ -1595,6 +1691,19 @@ def _createResidueSignature(elements):
     return s
 
 
+def _createResidueGraphKey(residue, bondedToAtom):
+    """Create a key describing the atoms of a residue and how they are bonded.  If two residues have the
+    same key, compiled.matchResidueToTemplate() produces the same result for both of them."""
+    atoms = list(residue.atoms())
+    localIndex = dict((atom.index, i) for i, atom in enumerate(atoms))
+    key = []
+    for atom in atoms:
+        bonded = bondedToAtom[atom.index]
+        internal = tuple(localIndex[j] for j in bonded if j in localIndex)
+        key.append((atom.name, atom.element, internal, len(bonded)-len(internal)))
+    return tuple(key)
+
+
 def _applyPatchesToMatchResidues(forcefield, data, residues, templateForResidue, bondedToAtom, ignoreExternalBonds, ignoreExtraParticles):
     """Try to apply patches to find matches for residues."""
     # Start by creating all templates than can be created by applying a combination of one-residue patches
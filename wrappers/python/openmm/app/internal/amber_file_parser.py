@@ -152,10 +152,7 @@ class PrmtopLoader(object):
                     (format, numItems, itemType,
                      iLength, itemPrecision) = self._getFormat(flag)
                     line = line.rstrip()
-                    for index in range(0, len(line), iLength):
-                        item = line[index:index+iLength]
-                        if item:
-                            self._raw_data[flag].append(item.strip())
+                    self._raw_data[flag].extend([line[index:index+iLength].strip() for index in range(0, len(line), iLength)])
         # See if this is a CHAMBER-style topology file, which is not supported
         # for creating Systems
         self.chamber = 'CTITLE' in self._flags
@@ -671,6 +668,11 @@ class PrmtopLoader(object):
 # AMBER System builder (based on, but not identical to, systemManager from 'zander')
 #=============================================================================================
 
+def _addBonds(force, bonds):
+    """Add a list of (atom1, atom2, k, length) tuples to a HarmonicBondForce in a single call."""
+    if len(bonds) > 0:
+        force.addBonds([b[0] for b in bonds], [b[1] for b in bonds], [b[3] for b in bonds], [2*b[2] for b in bonds])
+
 def readAmberSystem(topology, prmtop_filename=None, prmtop_loader=None, shake=None, gbmodel=None,
           soluteDielectric=1.0, solventDielectric=78.5,
           implicitSolventKappa=0.0*(1/units.nanometer), nonbondedCutoff=None,
@@ -763,35 +765,30 @@ def readAmberSystem(topology, prmtop_filename=None, prmtop_loader=None, shake=No
 
     # Populate system with atomic masses.
     if verbose: print("Adding particles...")
-    for mass in prmtop.getMasses():
-        system.addParticle(mass)
+    system.addParticles(prmtop.getMasses())
 
     # Add constraints.
     isWater = [prmtop.getResidueLabel(i) in ('WAT', 'HOH', 'TP4', 'TP5', 'T4E') for i in range(prmtop.getNumAtoms())]
     isEP = [a.element is None for a in topology.atoms()]
+    constraints = []
     if shake in ('h-bonds', 'all-bonds', 'h-angles'):
-        for (iAtom, jAtom, k, rMin) in prmtop.getBondsWithH():
-            if not (isEP[iAtom] or isEP[jAtom]):
-                system.addConstraint(iAtom, jAtom, rMin)
+        constraints += [b for b in prmtop.getBondsWithH() if not (isEP[b[0]] or isEP[b[1]])]
     if shake in ('all-bonds', 'h-angles'):
-        for (iAtom, jAtom, k, rMin) in prmtop.getBondsNoH():
-            if not (isEP[iAtom] or isEP[jAtom]):
-                system.addConstraint(iAtom, jAtom, rMin)
+        constraints += [b for b in prmtop.getBondsNoH() if not (isEP[b[0]] or isEP[b[1]])]
     if rigidWater and shake is None:
-        for (iAtom, jAtom, k, rMin) in prmtop.getBondsWithH():
-            if isWater[iAtom] and isWater[jAtom] and not (isEP[iAtom] or isEP[jAtom]):
-                system.addConstraint(iAtom, jAtom, rMin)
+        constraints += [b for b in prmtop.getBondsWithH() if isWater[b[0]] and isWater[b[1]] and not (isEP[b[0]] or isEP[b[1]])]
+    if len(constraints) > 0:
+        system.addConstraints([b[0] for b in constraints], [b[1] for b in constraints], [b[3] for b in constraints])
 
     # Add harmonic bonds.
     if verbose: print("Adding bonds...")
     force = mm.HarmonicBondForce()
+    bonds = []
     if flexibleConstraints or (shake not in ('h-bonds', 'all-bonds', 'h-angles')):
-        for (iAtom, jAtom, k, rMin) in prmtop.getBondsWithH():
-            if flexibleConstraints or not (rigidWater and isWater[iAtom] and isWater[jAtom]):
-                force.addBond(iAtom, jAtom, rMin, 2*k)
+        bonds += [b for b in prmtop.getBondsWithH() if flexibleConstraints or not (rigidWater and isWater[b[0]] and isWater[b[1]])]
     if flexibleConstraints or (shake not in ('all-bonds', 'h-angles')):
-        for (iAtom, jAtom, k, rMin) in prmtop.getBondsNoH():
-            force.addBond(iAtom, jAtom, rMin, 2*k)
+        bonds += prmtop.getBondsNoH()
+    _addBonds(force, bonds)
     system.addForce(force)
 
     # Add Urey-Bradley terms.
@@ -799,8 +796,7 @@ def readAmberSystem(topology, prmtop_filename=None, prmtop_loader=None, shake=No
         if verbose: print("Adding Urey-Bradley terms...")
         force = mm.HarmonicBondForce()
         force.setName('UreyBradleyForce')
-        for (iAtom, jAtom, k, rMin) in prmtop.getUreyBradleys():
-            force.addBond(iAtom, jAtom, rMin, 2*k)
+        _addBonds(force, prmtop.getUreyBradleys())
         system.addForce(force)
 
     # Add harmonic angles.
@@ -815,6 +811,7 @@ def readAmberSystem(topology, prmtop_filename=None, prmtop_loader=None, shake=No
             atomConstraints[c[0]].append((c[1], distance))
             atomConstraints[c[1]].append((c[0], distance))
     topatoms = list(topology.atoms())
+    angles = []
     for (iAtom, jAtom, kAtom, k, aMin) in prmtop.getAngles():
         if shake == 'h-angles':
             atomI = topatoms[iAtom]
@@ -838,14 +835,18 @@ def readAmberSystem(topology, prmtop_filename=None, prmtop_loader=None, shake=No
             length = sqrt(l1*l1 + l2*l2 - 2*l1*l2*cos(aMin))
             system.addConstraint(iAtom, kAtom, length)
         if flexibleConstraints or not constrained:
-            force.addAngle(iAtom, jAtom, kAtom, aMin, 2*k)
+            angles.append((iAtom, jAtom, kAtom, aMin, 2*k))
+    if len(angles) > 0:
+        force.addAngles(*[list(column) for column in zip(*angles)])
     system.addForce(force)
 
     # Add torsions.
     if verbose: print("Adding torsions...")
     force = mm.PeriodicTorsionForce()
-    for (iAtom, jAtom, kAtom, lAtom, forceConstant, phase, periodicity) in prmtop.getDihedrals():
-        force.addTorsion(iAtom, jAtom, kAtom, lAtom, periodicity, phase, forceConstant)
+    dihedrals = prmtop.getDihedrals()
+    if len(dihedrals) > 0:
+        (iAtom, jAtom, kAtom, lAtom, forceConstant, phase, periodicity) = [list(column) for column in zip(*dihedrals)]
+        force.addTorsions(iAtom, jAtom, kAtom, lAtom, periodicity, phase, forceConstant)
     system.addForce(force)
 
     # Add impropers.
@@ -946,8 +947,8 @@ def readAmberSystem(topology, prmtop_filename=None, prmtop_loader=None, shake=No
         nonbondTerms = prmtop.getNonbondTerms()
     except NbfixPresent:
         nbfix = True
-        for charge in prmtop.getCharges():
-            force.addParticle(charge, 1.0, 0.0)
+        numAtoms = prmtop.getNumAtoms()
+        force.addParticles(prmtop.getCharges(), [1.0]*numAtoms, [0.0]*numAtoms)
         numTypes = prmtop.getNumTypes()
         parm_acoef = [float(x) for x in prmtop._raw_data['LENNARD_JONES_ACOEF']]
         parm_bcoef = [float(x) for x in prmtop._raw_data['LENNARD_JONES_BCOEF']]
@@ -991,9 +992,7 @@ def readAmberSystem(topology, prmtop_filename=None, prmtop_loader=None, shake=No
         for atom in prmtop._getAtomTypeIndexes():
             cforce.addParticle((atom-1,))
     else:
-        for (charge, (rVdw, epsilon)) in zip(prmtop.getCharges(), nonbondTerms):
-            sigma = rVdw * sigmaScale
-            force.addParticle(charge, sigma, epsilon)
+        force.addParticles(prmtop.getCharges(), [rVdw*sigmaScale for (rVdw, epsilon) in nonbondTerms], [epsilon for (rVdw, epsilon) in nonbondTerms])
         if has_1264:
             numTypes = prmtop.getNumTypes()
             nbidx = [int(x) for x in prmtop._raw_data['NONBONDED_PARM_INDEX']]
@@ -1018,13 +1017,14 @@ def readAmberSystem(topology, prmtop_filename=None, prmtop_loader=None, shake=No
     excludedAtomPairs = set()
     sigmaScale = 2**(-1./6.)
     _scee, _scnb = scee, scnb
+    exceptions = []
     for (iAtom, lAtom, chargeProd, rMin, epsilon, iScee, iScnb) in prmtop.get14Interactions():
         if scee is None: _scee = iScee
         if scnb is None: _scnb = iScnb
         chargeProd /= _scee
         epsilon /= _scnb
         sigma = rMin * sigmaScale
-        force.addException(iAtom, lAtom, chargeProd, sigma, epsilon)
+        exceptions.append((iAtom, lAtom, chargeProd, sigma, epsilon))
         excludedAtomPairs.add(min((iAtom, lAtom), (lAtom, iAtom)))
 
     # Add Excluded Atoms
@@ -1033,14 +1033,15 @@ def readAmberSystem(topology, prmtop_filename=None, prmtop_loader=None, shake=No
     for iAtom in range(prmtop.getNumAtoms()):
         for jAtom in excludedAtoms[iAtom]:
             if min((iAtom, jAtom), (jAtom, iAtom)) in excludedAtomPairs: continue
-            force.addException(iAtom, jAtom, excludeParams[0], excludeParams[1], excludeParams[2])
+            exceptions.append((iAtom, jAtom)+excludeParams)
+    if len(exceptions) > 0:
+        force.addExceptions(*[list(column) for column in zip(*exceptions)])
 
     # Copy the exceptions as exclusions to the CustomNonbondedForce if we have
     # NBFIX terms
     if nbfix or has_1264:
-        for i in range(force.getNumExceptions()):
-            ii, jj, chg, sig, eps = force.getExceptionParameters(i)
-            cforce.addExclusion(ii, jj)
+        if len(exceptions) > 0:
+            cforce.addExclusions([e[0] for e in exceptions], [e[1] for e in exceptions])
         # Now set the various properties based on the NonbondedForce object
         if nonbondedMethod in ('PME', 'LJPME', 'Ewald', 'CutoffPeriodic'):
             cforce.setNonbondedMethod(cforce.CutoffPeriodic)
@@ -36,10 +36,12 @@ __author__ = "Peter Eastman"
 __version__ = "1.0"
 
 from heapq import heappush, heappop
+from libcpp.vector cimport vector
 
 cdef extern from "math.h":
     double round(double x)
     double sqrt(double x)
+    double floor(double x)
 
 cdef class periodicDistance:
     """This is a callable object that computes the distance between two points, taking
@@ -70,6 +72,216 @@ cdef class periodicDistance:
         dx -= scale1*self.vectors[0][0]
         return sqrt(dx*dx + dy*dy + dz*dz)
 
+cdef class cellList:
+    """This class organizes atom positions into cells, so the neighbors of a point can be quickly retrieved.
+    This is used heavily in Modeller.addSolvent() and Modeller.addMembrane().  Every cell is at least
+    as large as the cutoff, so all atoms within the cutoff of a point are in the cells adjacent to it.
+    """
+    cdef double vectors[3][3]
+    cdef double invBoxSize[3]
+    cdef double cellSize[3]
+    cdef int numCells[3]
+    cdef bint periodic
+    cdef vector[double] positions
+    cdef vector[int] cellStart
+    cdef vector[int] cellAtoms
+
+    def __init__(self, positions, double maxCutoff, vectors, bint periodic):
+        """Create a cellList.
+
+        Parameters
+        ----------
+        positions : list
+            the positions of the atoms to sort into cells
+        maxCutoff : float
+            the maximum distance at which neighbors will be looked up
+        vectors : list
+            the periodic box vectors.  If this is None, the box is chosen to span the positions.
+        periodic : bool
+            whether to apply periodic boundary conditions
+        """
+        cdef int i, j, numAtoms, totalCells, cell
+        cdef double scale
+        numAtoms = len(positions)
+        if vectors is None:
+            width = [maxCutoff]*3
+            if numAtoms > 0:
+                minPos = list(positions[0])
+                maxPos = list(positions[0])
+                for pos in positions:
+                    for axis in range(3):
+                        minPos[axis] = min(minPos[axis], pos[axis])
+                        maxPos[axis] = max(maxPos[axis], pos[axis])
+                width = [max(maxPos[axis]-minPos[axis], maxCutoff) for axis in range(3)]
+            vectors = ((width[0], 0, 0), (0, width[1], 0), (0, 0, width[2]))
+        for i in range(3):
+            for j in range(3):
+                self.vectors[i][j] = vectors[i][j]
+            self.invBoxSize[i] = 1.0/vectors[i][i]
+        self.periodic = periodic
+
+        # Choose the number of cells.  Making cells larger than the cutoff is always safe, so if there
+        # would be many more cells than atoms, use fewer to limit the memory.
+
+        scale = 1.0
+        while True:
+            totalCells = 1
+            for i in range(3):
+                self.numCells[i] = max(1, int(floor(self.vectors[i][i]/(maxCutoff*scale))))
+                self.cellSize[i] = self.vectors[i][i]/self.numCells[i]
+                totalCells *= self.numCells[i]
+            if totalCells <= max(1000, 8*numAtoms):
+                break
+            scale *= 1.25
+
+        # Sort the atoms into cells with a counting sort.
+
+        self.positions.resize(3*numAtoms)
+        for i in range(numAtoms):
+            pos = positions[i]
+            for j in range(3):
+                self.positions[3*i+j] = pos[j]
+            if periodic:
+                self._wrap(&self.positions[3*i])
+        cdef vector[int] atomCell
+        atomCell.resize(numAtoms)
+        self.cellStart.assign(totalCells+1, 0)
+        for i in range(numAtoms):
+            atomCell[i] = self._cellIndex(&self.positions[3*i])
+            self.cellStart[atomCell[i]+1] += 1
+        for i in range(totalCells):
+            self.cellStart[i+1] += self.cellStart[i]
+        cdef vector[int] nextIndex = self.cellStart
+        self.cellAtoms.resize(numAtoms)
+        for i in range(numAtoms):
+            cell = atomCell[i]
+            self.cellAtoms[nextIndex[cell]] = i
+            nextIndex[cell] += 1
+
+    cdef void _wrap(self, double* pos):
+        cdef double scale
+        cdef int i, j
+        for i in range(2, -1, -1):
+            scale = floor(pos[i]*self.invBoxSize[i])
+            for j in range(3):
+                pos[j] -= scale*self.vectors[i][j]
+
+    cdef int _cellIndex(self, double* pos):
+        cdef double p[3]
+        cdef int i, index[3]
+        for i in range(3):
+            p[i] = pos[i]
+        if self.periodic:
+            self._wrap(p)
+        for i in range(3):
+            index[i] = (<int> floor(p[i]/self.cellSize[i]))%self.numCells[i]
+            if index[i] < 0:
+                index[i] += self.numCells[i]
+        return (index[0]*self.numCells[1]+index[1])*self.numCells[2]+index[2]
+
+    cdef double _distance(self, double* pos1, double* pos2):
+        cdef double dx, dy, dz, scale1, scale2, scale3
+        dx = pos1[0]-pos2[0]
+        dy = pos1[1]-pos2[1]
+        dz = pos1[2]-pos2[2]
+        if self.periodic:
+            scale3 = round(dz*self.invBoxSize[2])
+            dx -= scale3*self.vectors[2][0]
+            dy -= scale3*self.vectors[2][1]
+            dz -= scale3*self.vectors[2][2]
+            scale2 = round(dy*self.invBoxSize[1])
+            dx -= scale2*self.vectors[1][0]
+            dy -= scale2*self.vectors[1][1]
+            scale1 = round(dx*self.invBoxSize[0])
+            dx -= scale1*self.vectors[0][0]
+        return sqrt(dx*dx + dy*dy + dz*dz)
+
+    cdef int _neighborCells(self, double* pos, int* cells):
+        """Find the distinct cells adjacent to a point.  Offsetting the point and then finding its cell,
+        rather than offsetting the cell index, correctly handles triclinic boxes."""
+        cdef double p[3]
+        cdef int i, j, k, m, cell, numFound
+        numFound = 0
+        for i in range(-1, 2):
+            for j in range(-1, 2):
+                for k in range(-1, 2):
+                    p[0] = pos[0]+i*self.cellSize[0]
+                    p[1] = pos[1]+j*self.cellSize[1]
+                    p[2] = pos[2]+k*self.cellSize[2]
+                    cell = self._cellIndex(p)
+                    for m in range(numFound):
+                        if cells[m] == cell:
+                            break
+                    else:
+                        cells[numFound] = cell
+                        numFound += 1
+        return numFound
+
+    def neighbors(self, pos):
+        """Get a list of the atoms in the cells adjacent to a point.  This includes every atom within the
+        cutoff distance of it, and possibly others that are farther away."""
+        cdef double p[3]
+        cdef int cells[27]
+        cdef int i, j, numFound
+        for i in range(3):
+            p[i] = pos[i]
+        numFound = self._neighborCells(p, cells)
+        result = []
+        for i in range(numFound):
+            for j in range(self.cellStart[cells[i]], self.cellStart[cells[i]+1]):
+                result.append(self.cellAtoms[j])
+        return result
+
+    def findOverlaps(self, points, cutoffs):
+        """For each of a list of points, determine whether any atom i is within distance cutoffs[i] of it.
+        Distances are computed with periodic boundary conditions if the cellList is periodic.
+
+        Returns
+        -------
+        list
+            element i is True if points[i] overlaps any atom, False otherwise
+        """
+        cdef vector[double] c = cutoffs
+        cdef double p[3]
+        cdef int cells[27]
+        cdef int i, j, atom, numFound
+        cdef bint overlap
+        result = []
+        for point in points:
+            for i in range(3):
+                p[i] = point[i]
+            numFound = self._neighborCells(p, cells)
+            overlap = False
+            for i in range(numFound):
+                for j in range(self.cellStart[cells[i]], self.cellStart[cells[i]+1]):
+                    atom = self.cellAtoms[j]
+                    if self._distance(p, &self.positions[3*atom]) < c[atom]:
+                        overlap = True
+                        break
+                if overlap:
+                    break
+            result.append(overlap)
+        return result
+
+    def minDistance(self, points):
+        """Find the minimum distance between any of a list of points and any atom in the cells adjacent to
+        it.  Every atom within the cutoff distance of a point is always considered.  If there are no atoms
+        in the adjacent cells, this returns infinity."""
+        cdef double p[3]
+        cdef int cells[27]
+        cdef int i, j, numFound
+        cdef double d, minDist = float('inf')
+        for point in points:
+            for i in range(3):
+                p[i] = point[i]
+            numFound = self._neighborCells(p, cells)
+            for i in range(numFound):
+                for j in range(self.cellStart[cells[i]], self.cellStart[cells[i]+1]):
+                    d = self._distance(p, &self.positions[3*self.cellAtoms[j]])
+                    if d < minDist:
+                        minDist = d
+        return minDist
+
 
 def matchResidueToTemplate(res, template, bondedToAtom, bint ignoreExternalBonds=False, bint ignoreExtraParticles=False):
     """Determine whether a residue matches a template and return a list of corresponding atoms.
@@ -224,3 +436,64 @@ def _findAtomMatches(templateAtoms, bondedTo, templateBondedTo, matches, hasMatc
                     return True
                 hasMatch[i] = False
     return False
+
+
+def tokenizeCifLine(str line):
+    """Split a line of a PDBx/mmCIF file into tokens.  This is used by PdbxReader, and produces exactly the
+    same tokens as the regular expression it originally used.  Each token is a tuple (category name,
+    attribute name, quoted string, word), of which only the elements relevant to that kind of token are
+    set.  Comments are discarded.
+    """
+    cdef Py_ssize_t n = len(line)
+    cdef Py_ssize_t i = 0, j, k
+    cdef Py_UCS4 c
+    result = []
+    while i < n:
+        c = line[i]
+        if c.isspace() or c == u'#':
+            # Skip whitespace, and stop at a comment that extends to the end of the line.
+
+            j = i
+            while j < n and line[j].isspace():
+                j += 1
+            if j < n and line[j] == u'#':
+                k = j
+                while k < n and line[k] != u'\n':
+                    k += 1
+                if k >= n-1:
+                    break
+            if c != u'#':
+                i += 1
+                continue
+        if c == u'_':
+            # A data name: everything up to the first '.' that is followed by a non-whitespace character.
+
+            j = i+2
+            while j < n-1 and line[j-1] != u'\n' and not (line[j] == u'.' and not line[j+1].isspace()):
+                j += 1
+            if j < n-1 and line[j-1] != u'\n':
+                k = j+1
+                while k < n and not line[k].isspace():
+                    k += 1
+                result.append((line[i+1:j], line[j+1:k], None, None))
+                i = k
+                continue
+        elif c == u"'" or c == u'"':
+            # A quoted string: it ends at the first matching quote followed by whitespace or the end of the line.
+
+            j = i+1
+            while j < n and line[j] != u'\n' and not (line[j] == c and (j+1 == n or line[j+1].isspace())):
+                j += 1
+            if j < n and line[j] != u'\n':
+                result.append((None, None, line[i+1:j], None))
+                i = j+2
+                continue
+
+        # An unquoted word.
+
+        k = i
+        while k < n and not line[k].isspace():
+            k += 1
+        result.append((None, None, None, line[i:k]))
+        i = k
+    return result
@@ -26,6 +26,7 @@ from __future__ import absolute_import
 
 import re,sys
 from openmm.app.internal.pdbx.reader.PdbxContainers import *
+from openmm.app.internal.compiled import tokenizeCifLine
 
 class PdbxError(Exception):
     """ Class for catch general errors 
@@ -339,21 +340,14 @@ class PdbxReader(object):
 
         """
         #
-        # Regex definition for mmCIF syntax - semi-colon delimited strings are handled
-        #                                     outside of this regex.
-        mmcifRe = re.compile(
-            r"(?:"
-
-            r"(?:_(.+?)[.](\S+))"               "|"  # _category.attribute
-
-            r"(?:['](.*?)(?:[']\s|[']$))"       "|"  # single quoted strings
-            r"(?:[\"](.*?)(?:[\"]\s|[\"]$))"    "|"  # double quoted strings             
-
-            r"(?:\s*#.*$)"                      "|"  # comments (dumped)
-
-            r"(\S+)"                                 # unquoted words
-
-            r")")
+        # Tokens in mmCIF syntax are matched by the following regex.  Semi-colon delimited
+        # strings are handled outside of it.  tokenizeCifLine() is a compiled equivalent.
+        #
+        #   (?:_(.+?)[.](\S+))                  _category.attribute
+        #   (?:['](.*?)(?:[']\s|[']$))          single quoted strings
+        #   (?:[\"](.*?)(?:[\"]\s|[\"]$))       double quoted strings
+        #   (?:\s*#.*$)                         comments (dumped)
+        #   (\S+)                               unquoted words
 
         fileIter = iter(ifh)
 
@@ -387,19 +381,10 @@ class PdbxReader(object):
                 line = line[1:]
                 #continue
 
-            # Apply regex to the current line consolidate the single/double
-            # quoted within the quoted string category
-            for it in mmcifRe.finditer(line):
-                tgroups = it.groups()
-                if tgroups != (None, None, None, None, None):
-                    if tgroups[2] is not None:
-                        qs = tgroups[2]
-                    elif tgroups[3] is not None:
-                        qs = tgroups[3]
-                    else:
-                        qs = None
-                    groups = (tgroups[0],tgroups[1],qs,tgroups[4])
-                    yield groups
+            # Split the current line into tokens, with the single/double quoted
+            # strings consolidated within the quoted string category.
+            for groups in tokenizeCifLine(line):
+                yield groups
 
     def __tokenizerOrg(self, ifh):
         """ Tokenizer method for the mmCIF syntax file - 
@@ -216,9 +216,9 @@ class Metadynamics(object):
 
         # Add it to the bias.
 
-        height = height.value_in_unit(unit.kilojoules_per_mole)
-        self._selfBias += height*gaussian
-        self._totalBias += height*gaussian
+        gaussian *= height.value_in_unit(unit.kilojoules_per_mole)
+        self._selfBias += gaussian
+        self._totalBias += gaussian
         if len(self.variables) == 1:
             self._table.setFunctionParameters(self._totalBias.flatten(), *self._limits)
         else:
@@ -560,7 +560,7 @@ class Modeller(object):
             positions = []
         else:
             positions = deepcopy(self.positions.value_in_unit(nanometer))
-        cells = _CellList(positions, maxCutoff, vectors, True)
+        cells = compiled.cellList(positions, maxCutoff, vectors, True)
 
         # Create a function to compute the distance between two points, taking periodic boundary conditions into account.
 
@@ -575,25 +575,27 @@ class Modeller(object):
             center = [(max((pos[i] for pos in positions))+min((pos[i] for pos in positions)))/2 for i in range(3)]
             center = Vec3(center[0], center[1], center[2])
         numBoxes = [int(ceil(box[i]/pdbBoxSize[i])) for i in range(3)]
-        addedWaters = []
+        oxygenPositions = []
+        for residue in pdbResidues:
+            oxygen = [atom for atom in residue.atoms() if atom.element == elem.oxygen][0]
+            oxygenPositions.append((residue.index, pdbPositions[oxygen.index]))
+        candidateWaters = []
         for boxx in range(numBoxes[0]):
             for boxy in range(numBoxes[1]):
                 for boxz in range(numBoxes[2]):
                     offset = Vec3(boxx*pdbBoxSize[0], boxy*pdbBoxSize[1], boxz*pdbBoxSize[2])
-                    for residue in pdbResidues:
-                        oxygen = [atom for atom in residue.atoms() if atom.element == elem.oxygen][0]
-                        atomPos = pdbPositions[oxygen.index]+offset
+                    for index, oxygenPos in oxygenPositions:
+                        atomPos = oxygenPos+offset
                         if not any((atomPos[i] > box[i] for i in range(3))):
-                            # This molecule is inside the box, so see how close to it is to the solute.
+                            # This molecule is inside the box, so it is a candidate to add.
 
-                            atomPos += center-box/2
-                            for i in cells.neighbors(atomPos):
-                                if periodicDistance(atomPos, positions[i]) < cutoff[i]:
-                                    break
-                            else:
-                                # Record this water molecule as one to add.
+                            candidateWaters.append((index, atomPos+center-box/2))
+
+        # Check all the candidates against the solute at once, and record the ones that do not overlap it.
 
-                                addedWaters.append((residue.index, atomPos))
+        overlaps = cells.findOverlaps([pos for index, pos in candidateWaters], cutoff)
+        addedWaters = [water for water, overlap in zip(candidateWaters, overlaps) if not overlap]
+        del candidateWaters
 
         if numAdded is not None:
             # We added many more waters than we actually want.  Sort them based on distance to the nearest box edge and
@@ -617,13 +619,7 @@ class Modeller(object):
             lowerCutoff = center-box/2+Vec3(waterCutoff, waterCutoff, waterCutoff)
             lowerSkinPositions = [pos for index, pos in addedWaters if pos[0] < lowerCutoff[0] or pos[1] < lowerCutoff[1] or pos[2] < lowerCutoff[2]]
             filteredWaters = []
-            cells.cells = {}
-            for i in range(len(lowerSkinPositions)):
-                cell = cells.cellForPosition(lowerSkinPositions[i])
-                if cell in cells.cells:
-                    cells.cells[cell].append(i)
-                else:
-                    cells.cells[cell] = [i]
+            cells = compiled.cellList(lowerSkinPositions, maxCutoff, vectors, True)
             for entry in addedWaters:
                 pos = entry[1]
                 if pos[0] < upperCutoff[0] and pos[1] < upperCutoff[1] and pos[2] < upperCutoff[2]:
@@ -873,7 +869,7 @@ class Modeller(object):
         acceptors = [atom for atom in self.topology.atoms() if atom.element in (elem.oxygen, elem.nitrogen)]
         positions = self.positions.value_in_unit(nanometer)
         acceptorPositions = [positions[a.index] for a in acceptors]
-        cells = _CellList(acceptorPositions, 0.35, None, False)
+        cells = compiled.cellList(acceptorPositions, 0.35, None, False)
         for chain in self.topology.chains():
             newChain = newTopology.addChain(chain.id)
             for residue in chain.residues():
@@ -1443,8 +1439,8 @@ class Modeller(object):
         addedLipids = []
         removedFromLeaf = [0, 0]
         vectors = membraneTopology.getPeriodicBoxVectors().value_in_unit(nanometer)
-        proteinCells = _CellList(proteinPos, overlapCutoff, vectors, False)
-        scaledProteinCells = _CellList(scaledProteinPos, overlapCutoff, vectors, False)
+        proteinCells = compiled.cellList(proteinPos, overlapCutoff, vectors, False)
+        scaledProteinCells = compiled.cellList(scaledProteinPos, overlapCutoff, vectors, False)
         for x in range(nx):
             for y in range(ny):
                 offset = proteinCenterPos - patchCenterPos + Vec3((x-0.5*(nx-1))*patchSize[0], (y-0.5*(ny-1))*patchSize[1], 0)
@@ -1452,27 +1448,12 @@ class Modeller(object):
                     resPos = [patchPos[atom.index]+offset for atom in res.atoms()]
                     if res.name == 'HOH':
                         # Remove waters that are too close to either the original OR scaled protein positions.
-                        referencePosLists = [proteinPos, scaledProteinPos]
                         cellLists = [proteinCells, scaledProteinCells]
                     else:
                         # Remove lipids that are too close to the scaled protein positions.
-                        referencePosLists = [scaledProteinPos]
                         cellLists = [scaledProteinCells]
-                    overlap = False
-                    nearest = nx*patchSize[0]
-                    for cells, referencePos in zip(cellLists, referencePosLists):
-                        if overlap:
-                            break
-                        for index, atom in enumerate(res.atoms()):
-                            pos = resPos[index]
-                            for atom in cells.neighbors(pos):
-                                distance = norm(pos-referencePos[atom])
-                                if distance < overlapCutoff:
-                                    overlap = True
-                                    break
-                                nearest = min(nearest, distance)
-                            if overlap:
-                                break
+                    nearest = min([nx*patchSize[0]]+[cells.minDistance(resPos) for cells in cellLists])
+                    overlap = (nearest < overlapCutoff)
                     if res.name == 'HOH':
                         if not overlap:
                             addedWater.append((res, resPos))
@@ -1483,7 +1464,6 @@ class Modeller(object):
                             addedLipids.append((nearest, res, resPos))
         skipFromLeaf = [max(removedFromLeaf)-removedFromLeaf[i] for i in (0,1)]
         del cellLists
-        del cells
         del proteinCells
 
         # Add the lipids.
@@ -1676,55 +1656,3 @@ class Modeller(object):
 
         self._addIons(forcefield, numTotalWaters, waterPos, positiveIon=positiveIon, negativeIon=negativeIon, ionicStrength=ionicStrength, neutralize=neutralize, residueTemplates=newResidueTemplates)
 
-
-class _CellList(object):
-    """This class organizes atom positions into cells, so the neighbors of a point can be quickly retrieved"""
-
-    def __init__(self, positions, maxCutoff, vectors, periodic):
-        if vectors is None:
-            if len(positions) == 0:
-                vectors = (Vec3(maxCutoff, 0, 0), Vec3(0, maxCutoff, 0), Vec3(0, 0, maxCutoff))
-            else:
-                minPos = [min((pos[i] for pos in positions)) for i in range(3)]
-                maxPos = [max((pos[i] for pos in positions)) for i in range(3)]
-                width = [max(maxPos[i]-minPos[i], maxCutoff) for i in range(3)]
-                vectors = (Vec3(width[0], 0, 0), Vec3(0, width[1], 0), Vec3(0, 0, width[2]))
-        self.positions = deepcopy(positions)
-        self.cells = {}
-        self.numCells = tuple((max(1, int(floor(vectors[i][i]/maxCutoff))) for i in range(3)))
-        self.cellSize = tuple((vectors[i][i]/self.numCells[i] for i in range(3)))
-        self.vectors = vectors
-        self.periodic = periodic
-        invBox = Vec3(1.0/vectors[0][0], 1.0/vectors[1][1], 1.0/vectors[2][2])
-        for i in range(len(self.positions)):
-            pos = self.positions[i]
-            if periodic:
-                pos = pos - floor(pos[2]*invBox[2])*vectors[2]
-                pos -= floor(pos[1]*invBox[1])*vectors[1]
-                pos -= floor(pos[0]*invBox[0])*vectors[0]
-                self.positions[i] = pos
-            cell = self.cellForPosition(pos)
-            if cell in self.cells:
-                self.cells[cell].append(i)
-            else:
-                self.cells[cell] = [i]
-
-    def cellForPosition(self, pos):
-        if self.periodic:
-            invBox = Vec3(1.0/self.vectors[0][0], 1.0/self.vectors[1][1], 1.0/self.vectors[2][2])
-            pos = pos-floor(pos[2]*invBox[2])*self.vectors[2]
-            pos -= floor(pos[1]*invBox[1])*self.vectors[1]
-            pos -= floor(pos[0]*invBox[0])*self.vectors[0]
-        return tuple((int(floor(pos[j]/self.cellSize[j]))%self.numCells[j] for j in range(3)))
-
-    def neighbors(self, pos):
-        processedCells = set()
-        offsets = (-1, 0, 1)
-        for i in offsets:
-            for j in offsets:
-                for k in offsets:
-                    cell = self.cellForPosition(Vec3(pos[0]+i*self.cellSize[0], pos[1]+j*self.cellSize[1], pos[2]+k*self.cellSize[2]))
-                    if cell in self.cells and cell not in processedCells:
-                        processedCells.add(cell)
-                        for atom in self.cells[cell]:
-                            yield atom
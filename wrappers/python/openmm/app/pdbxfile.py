@@ -124,13 +124,15 @@ class PDBxFile(object):
         atomTable = {}
         atomsInResidue = set()
         models = []
+        modelIndices = {}
         for row in atomData.getRowList():
             atomKey = ((row[resIdCol], row[chainIdCol], row[atomNameCol]))
             model = ('1' if modelCol == -1 else row[modelCol])
-            if model not in models:
+            modelIndex = modelIndices.get(model)
+            if modelIndex is None:
+                modelIndex = modelIndices[model] = len(models)
                 models.append(model)
                 self._positions.append([])
-            modelIndex = models.index(model)
             if row[altIdCol] != '.' and atomKey in atomTable and len(self._positions[modelIndex]) > atomTable[atomKey].index:
                 # This row is an alternate position for an existing atom, so ignore it.
 
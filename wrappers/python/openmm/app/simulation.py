@@ -95,6 +95,13 @@ class Simulation(object):
             self.integrator = integrator
         ## A list of reporters to invoke during the simulation
         self.reporters = []
+        ## If True, reporters are invoked while the Context computes the next block of steps in
+        ## the background.  Only enable this if every reporter gets its data from the State passed
+        ## to report().  Anything it retrieves from the Context directly will reflect the end of the
+        ## next block, and it must not call methods on the Integrator.  describeNextReport() may
+        ## also be called before report() has processed the previous report.
+        self.overlapReports = False
+        self._reportStep = None
         if platform is None:
             if platformProperties is not None:
                 raise ValueError('Cannot specify platform-specific properties, because the Platform is not specified')
@@ -117,6 +124,8 @@ class Simulation(object):
     @property
     def currentStep(self):
         """The index of the current time step."""
+        if self._reportStep is not None:
+            return self._reportStep
         return self.context.getStepCount()
 
     @currentStep.setter
@@ -199,6 +208,7 @@ class Simulation(object):
         if endStep is None:
             endStep = sys.maxsize
         nextReport = [None]*len(self.reporters)
+        pendingReports = []
         while self.currentStep < endStep and (endTime is None or datetime.now() < endTime):
             nextSteps = endStep-self.currentStep
             
@@ -225,6 +235,16 @@ class Simulation(object):
                     nextSteps = steps
                     anyReport = True
             stepsToGo = nextSteps
+            if len(pendingReports) > 0:
+                # Let the Context take the next block of steps while the reporters process the previous one.
+
+                self.context.stepAsync(stepsToGo)
+                try:
+                    self._invoke_reporters(pendingReports)
+                finally:
+                    self.context.waitForSteps()
+                pendingReports = []
+                stepsToGo = 0
             while stepsToGo > 10:
                 self.integrator.step(10) # Only take 10 steps at a time, to give Python more chances to respond to a control-c.
                 stepsToGo -= 10
@@ -255,12 +275,17 @@ class Simulation(object):
                 else:
                     unwrapped += either
                 
-                # Generate the reports.
+                # Generate the reports.  When overlapping is enabled and the simulation is not being
+                # limited by clock time, just retrieve the States now and invoke the reporters once
+                # the next block of steps has started.
 
                 if len(wrapped) > 0:
-                    self._generate_reports(wrapped, True)
+                    pendingReports += self._collect_reports(wrapped, True)
                 if len(unwrapped) > 0:
-                    self._generate_reports(unwrapped, False)
+                    pendingReports += self._collect_reports(unwrapped, False)
+                if not self.overlapReports or endTime is not None or self.currentStep >= endStep:
+                    self._invoke_reporters(pendingReports)
+                    pendingReports = []
     
     def _generate_reports(self, reports, periodic):
         '''Generate reports for all requested reporters
@@ -273,13 +298,29 @@ class Simulation(object):
         periodic : bool
                 Specifies whether particle positions should be translated so the center of every molecule lies in the same periodic box.
         '''
-        
+        self._invoke_reporters(self._collect_reports(reports, periodic))
+
+    def _collect_reports(self, reports, periodic):
+        '''Retrieve the State needed by a set of reporters.  The arguments are the same as for _generate_reports().
+        This returns a list of (reporter, State, step) tuples that can be passed to _invoke_reporters().
+        '''
         includes = set.union(*[set(report[1]['include']) for report in reports])
         includeArgs = {property:True for property in includes}
 
         state = self.context.getState(groups=self.context.getIntegrator().getIntegrationForceGroups(), enforcePeriodicBox=periodic, parameters=True, **includeArgs)
-        for reporter, nextReport in reports:
-            reporter.report(self, state)
+        step = self.currentStep
+        return [(reporter, state, step) for reporter, nextReport in reports]
+
+    def _invoke_reporters(self, reports):
+        '''Invoke reporters on States retrieved by _collect_reports().  While they run, currentStep reports the step
+        each State was taken at, even if the Context has moved on since then.
+        '''
+        try:
+            for reporter, state, step in reports:
+                self._reportStep = step
+                reporter.report(self, state)
+        finally:
+            self._reportStep = None
 
     def saveCheckpoint(self, file):
         """Save a checkpoint of the simulation to a file.
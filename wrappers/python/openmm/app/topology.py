@@ -34,6 +34,7 @@ __version__ = "1.0"
 
 from collections import namedtuple
 import os
+import sys
 import xml.etree.ElementTree as etree
 from openmm.vec3 import Vec3
 from openmm.app.internal.singleton import Singleton
@@ -161,6 +162,8 @@ class Topology(object):
             raise ValueError('All residues within a chain must be contiguous')
         if id is None:
             id = str(self._numResidues+1)
+        if type(name) is str:
+            name = sys.intern(name)
         residue = Residue(name, self._numResidues, chain, id, insertionCode)
         self._numResidues += 1
         chain._residues.append(residue)
@@ -191,6 +194,9 @@ class Topology(object):
             raise ValueError('All atoms within a residue must be contiguous')
         if id is None:
             id = str(self._numAtoms+1)
+        if type(name) is str:
+            # There are usually only a few distinct names, so interning them saves a lot of memory.
+            name = sys.intern(name)
         atom = Atom(name, element, self._numAtoms, residue, id, formalCharge=formalCharge)
         self._numAtoms += 1
         residue._atoms.append(atom)
@@ -396,6 +402,11 @@ class Topology(object):
 
 class Chain(object):
     """A Chain object represents a chain within a Topology."""
+
+    # Using slots greatly reduces the memory used by large Topologies.  __dict__ is
+    # included so other attributes can still be added to individual objects.
+    __slots__ = ('index', 'topology', 'id', '_residues', '__dict__', '__weakref__')
+
     def __init__(self, index, topology, id):
         """Construct a new Chain.  You should call addChain() on the Topology instead of calling this directly."""
         ## The index of the Chain within its Topology
@@ -424,6 +435,9 @@ class Chain(object):
 
 class Residue(object):
     """A Residue object represents a residue within a Topology."""
+
+    __slots__ = ('name', 'index', 'chain', 'id', 'insertionCode', '_atoms', '__dict__', '__weakref__')
+
     def __init__(self, name, index, chain, id, insertionCode):
         """Construct a new Residue.  You should call addResidue() on the Topology instead of calling this directly."""
         ## The name of the Residue
@@ -444,15 +458,15 @@ class Residue(object):
 
     def bonds(self):
         """Iterate over all Bonds involving any atom in this residue."""
-        return ( bond for bond in self.chain.topology.bonds() if ((bond[0] in self._atoms) or (bond[1] in self._atoms)) )
+        return ( bond for bond in self.chain.topology.bonds() if (bond[0].residue is self or bond[1].residue is self) )
 
     def internal_bonds(self):
         """Iterate over all internal Bonds."""
-        return ( bond for bond in self.chain.topology.bonds() if ((bond[0] in self._atoms) and (bond[1] in self._atoms)) )
+        return ( bond for bond in self.chain.topology.bonds() if (bond[0].residue is self and bond[1].residue is self) )
 
     def external_bonds(self):
         """Iterate over all Bonds to external atoms."""
-        return ( bond for bond in self.chain.topology.bonds() if ((bond[0] in self._atoms) != (bond[1] in self._atoms)) )
+        return ( bond for bond in self.chain.topology.bonds() if ((bond[0].residue is self) != (bond[1].residue is self)) )
 
     def __len__(self):
         return len(self._atoms)
@@ -463,6 +477,8 @@ class Residue(object):
 class Atom(object):
     """An Atom object represents an atom within a Topology."""
 
+    __slots__ = ('name', 'element', 'index', 'residue', 'id', 'formalCharge', '__dict__', '__weakref__')
+
     def __init__(self, name, element, index, residue, id, formalCharge=None):
         """Construct a new Atom.  You should call addAtom() on the Topology instead of calling this directly."""
         ## The name of the Atom
@@ -487,11 +503,17 @@ class Bond(namedtuple('Bond', ['atom1', 'atom2'])):
     This class extends tuple, and may be interpreted as a 2 element tuple of Atom objects.
     It also has fields that can optionally be used to describe the bond order and type of bond."""
 
+    # The defaults are stored in the class, so most bonds do not need an instance dict.
+    type = None
+    order = None
+
     def __new__(cls, atom1, atom2, type=None, order=None):
         """Create a new Bond.  You should call addBond() on the Topology instead of calling this directly."""
         bond = super(Bond, cls).__new__(cls, atom1, atom2)
-        bond.type = type
-        bond.order = order
+        if type is not None:
+            bond.type = type
+        if order is not None:
+            bond.order = order
         return bond
 
     def __getnewargs__(self):
@@ -10,6 +10,7 @@
 
 namespace std {
   %template(pairii) pair<int,int>;
+  %template(pairid) pair<int,double>;
   %template(vectord) vector<double>;
   %template(vectorddd) vector< vector< vector<double> > >;
   %template(vectori) vector<int>;
@@ -18,7 +19,11 @@ namespace std {
   %template(vectorstring) vector<string>;
   %template(mapstringstring) map<string,string>;
   %template(mapstringdouble) map<string,double>;
+  %template(vectormapstringdouble) vector< map<string,double> >;
   %template(mapii) map<int,int>;
+  %template(mapstringpairid) map<string,pair<int,double> >;
+  %template(mapstringll) map<string,long long>;
+  %template(mapstringmapstringll) map<string,map<string,long long> >;
   %template(seti) set<int>;
 };
 
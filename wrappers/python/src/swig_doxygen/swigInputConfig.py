@@ -63,6 +63,7 @@ SKIP_METHODS = [('State', 'getPositions'),
                 ('Kernel',),
                 ('KernelFactory',),
                 ('KernelImpl',),
+                ('MinimizeKernel',),
                 ('MultipoleInfo',),
                 ('ParameterInfo',),
                 ('ParticleInfo',),
@@ -80,6 +81,8 @@ SKIP_METHODS = [('State', 'getPositions'),
                 ('WcaDispersionInfo',),
                 ('Context',  'getIntegrator'),
                 ('Context',  'createCheckpoint'),
+                ('Context',  'createCheckpointAsync'),
+                ('Context',  'getStateAsync'),
                 ('Context',  'loadCheckpoint'),
                 ('CudaPlatform',),
                 ('HipPlatform',),
@@ -95,6 +98,7 @@ SKIP_METHODS = [('State', 'getPositions'),
                 ('IntegrateDrudeSCFStepKernel',),
                 ('XmlSerializer',  'serialize'),
                 ('XmlSerializer',  'deserialize'),
+                ('BinarySerializer',),
                 ("NoseHooverIntegrator", "getAllThermostatedIndividualParticles"),
                 ("NoseHooverIntegrator", "getAllThermostatedPairs"),
 ]
@@ -105,13 +109,33 @@ SKIP_METHODS = [('State', 'getPositions'),
 # The build script assumes method args that are non-const references are
 # used to output values. This list gives exceptions to this rule.
 NO_OUTPUT_ARGS = [('LocalEnergyMinimizer', 'minimize', 'context'),
+                  ('PMETuner', 'tune', 'system'),
+                  ('PMETuner', 'tune', 'platform'),
+                  ('PMETuner', 'selectGrid', 'system'),
+                  ('PMETuner', 'selectGrid', 'platform'),
                   ('Platform', 'setPropertyValue', 'context'),
+                  ('Platform', 'getDeviceArray', 'context'),
+                  ('ReplicaExchange', 'setIntegratorTemperature', 'integrator'),
+                  ('NCMCDriver', 'NCMCDriver', 'context'),
+                  ('SimulatedTemperingDriver', 'SimulatedTemperingDriver', 'context'),
                   ('AmoebaTorsionTorsionForce', 'setTorsionTorsionGrid', 'grid'),
                   ('AmoebaVdwForce', 'setParticleExclusions', 'exclusions'),
+                  ('AmoebaVdwForce', 'computeLambdaEnergies', 'context'),
+                  ('NonbondedForce', 'computeInteractionEnergy', 'context'),
+                  ('NonbondedForce', 'computeEnergyChange', 'context'),
+                  ('NonbondedForce', 'computeParticleEnergy', 'context'),
+                  ('NonbondedForce', 'computeStateEnergies', 'context'),
+                  ('NonbondedForce', 'computeTitrationEnergyChange', 'context'),
+                  ('CustomNonbondedForce', 'computeEnergyChange', 'context'),
+                  ('CustomNonbondedForce', 'computeParticleEnergy', 'context'),
                   ('AmoebaMultipoleForce', 'addParticle', 'molecularDipole'),
                   ('AmoebaMultipoleForce', 'addParticle', 'molecularQuadrupole'),
                   ('AmoebaMultipoleForce', 'setCovalentMap', 'covalentAtoms'),
+                  ('AmoebaMultipoleForce', 'setAllCovalentMaps', 'offsets'),
+                  ('AmoebaMultipoleForce', 'setAllCovalentMaps', 'covalentAtoms'),
+                  ('AmoebaMultipoleForce', 'createCovalentMapsFromBonds', 'bonds'),
                   ('AmoebaMultipoleForce', 'getElectrostaticPotential', 'context'),
+                  ('AmoebaMultipoleForce', 'getPMEElectrostaticPotential', 'context'),
                   ('AmoebaMultipoleForce', 'getInducedDipoles', 'context'),
                   ('AmoebaMultipoleForce', 'getLabFramePermanentDipoles', 'context'),
                   ('AmoebaMultipoleForce', 'getTotalDipoles', 'context'),
@@ -141,6 +165,7 @@ STEAL_OWNERSHIP = {("Platform", "registerPlatform") : [0],
                    ("CustomCVForce", "addCollectiveVariable") : [1],
                    ("CustomIntegrator", "addTabulatedFunction") : [1],
                    ("CompoundIntegrator", "addIntegrator") : [0],
+                   ("OffloadForce", "addForce") : [0],
 }
 
 
@@ -245,6 +270,8 @@ UNITS = {
 ("AmoebaGeneralizedKirkwoodForce",       "getTanhRescaling")                              :  ( None,()),
 ("AmoebaGeneralizedKirkwoodForce",       "getTanhParameters")                             : ( None,(None, None, None)),
 ("AmoebaGeneralizedKirkwoodForce",       "getDescreenOffset")                             :  ( 'unit.nanometer', ()),
+("AmoebaGeneralizedKirkwoodForce",       "getBornRadiiUpdateInterval")                    :  ( None, ()),
+("AmoebaGeneralizedKirkwoodForce",       "getBornRadiiUpdateTolerance")                   :  ( 'unit.nanometer', ()),
 ("AmoebaGeneralizedKirkwoodForce",       "getProbeRadius")                                :  ( 'unit.nanometer', ()),
 ("AmoebaGeneralizedKirkwoodForce",       "getSurfaceAreaFactor")                          :  ( 'unit.kilojoule_per_mole/(unit.nanometer*unit.nanometer)',()),
 
@@ -277,11 +304,13 @@ UNITS = {
                                                                                                       'unit.nanometer**3')),
 ("AmoebaMultipoleForce",                 "getCovalentMap")                                :  ( None, ()),
 ("AmoebaMultipoleForce",                 "getCovalentMaps")                               :  ( None, ()),
+("AmoebaMultipoleForce",                 "getAllCovalentMaps")                            :  ( None, ()),
 ("AmoebaMultipoleForce",                 "getScalingDistanceCutoff")                      :  ( 'unit.nanometer', ()),
 ("AmoebaMultipoleForce",                 "getElectricConstant")                           :  ( None, ()),
 #("AmoebaMultipoleForce",                 "getElectrostaticPotential")                     :  ( None, ('unit.kilojoule_per_mole')),
 #("AmoebaMultipoleForce",                 "getElectrostaticPotential")                     :  ( ('unit.kilojoule_per_mole'), ()),
 ("AmoebaMultipoleForce",                 "getElectrostaticPotential")                     :  ( None, ()),
+("AmoebaMultipoleForce",                 "getPMEElectrostaticPotential")                  :  ( None, ()),
 ("AmoebaMultipoleForce",                 "getInducedDipoles")                             :  ( None, ()),
 ("AmoebaMultipoleForce",                 "getLabFramePermanentDipoles")                   :  ( None, ()),
 ("AmoebaMultipoleForce",                 "getTotalDipoles")                               :  ( None, ()),
@@ -303,6 +332,7 @@ UNITS = {
 ("AmoebaVdwForce",                        "getParticleParameters")                         :  ( None, (None, 'unit.nanometer', 'unit.kilojoule_per_mole', None, None, None, None)),
 ("AmoebaVdwForce",                        "getParticleTypeParameters")                     :  ( None, ('unit.nanometer', 'unit.kilojoule_per_mole')),
 ("AmoebaVdwForce",                        "getTypePairParameters")                         :  ( None, (None, None, 'unit.nanometer', 'unit.kilojoule_per_mole')),
+("AmoebaVdwForce",                        "computeLambdaEnergies")                         :  ( None, ()),
 
 ("AmoebaWcaDispersionForce",              "getParticleParameters")                         :  ( None, ('unit.nanometer', 'unit.kilojoule_per_mole')),
 ("AmoebaWcaDispersionForce",              "getAwater")                                     :  ( '1/(unit.nanometer*unit.nanometer*unit.nanometer)',()),
@@ -327,6 +357,9 @@ UNITS = {
 ("Context", "getState") : (None, (None, None, None)),
 ("Context", "setPeriodicBoxVectors") : (None, ("unit.nanometer", "unit.nanometer", "unit.nanometer")),
 ("Context", "setPositions") : (None, ("unit.nanometer",)),
+("Context", "getQuantizedPositions") : ("unit.nanometer", ()),
+("Context", "computeFrameEnergies") : ("unit.kilojoule_per_mole", ()),
+("Context", "getDeviceArray") : (None, ()),
 ("Context", "getTime") : ("unit.picosecond", ()),
 ("Context", "setTime") : (None, ("unit.picosecond",)),
 ("Context", "getStepCount") : (None, ()),
@@ -404,6 +437,10 @@ UNITS = {
 ("CustomTorsionForce", "getTorsionParameters") : (None, ()),
 ("CustomCVForce", "getCollectiveVariable") : (None, ()),
 ("CustomCVForce", "getInnerContext") : (None, ()),
+("OffloadForce", "getForce") : (None, ()),
+("OffloadForce", "getInnerContext") : (None, ()),
+("OffloadForce", "getPlatformName") : (None, ()),
+("OffloadForce", "getPlatformProperties") : (None, ()),
 ("DrudeForce", "addParticle") : (None, (None, None, None, None, None, "unit.elementary_charge", "unit.nanometer**3", None, None)),
 ("DrudeForce", "getParticleParameters") : (None, (None, None, None, None, None, "unit.elementary_charge", "unit.nanometer**3", None, None)),
 ("DrudeForce", "setParticleParameters") : (None, (None, None, None, None, None, None, "unit.elementary_charge", "unit.nanometer**3", None, None)),
@@ -415,9 +452,11 @@ UNITS = {
 ("GBSAOBCForce", "getSurfaceAreaEnergy") : ("unit.kilojoule_per_mole/unit.nanometer/unit.nanometer", ()),
 ("GBSAOBCForce", "setSurfaceAreaEnergy") : (None, ("unit.kilojoule_per_mole/unit.nanometer/unit.nanometer",)),
 ("HarmonicAngleForce", "addAngle") : (None, (None, None, None, "unit.radian", "unit.kilojoule_per_mole/(unit.radian*unit.radian)")),
+("HarmonicAngleForce", "addAngles") : (None, (None, None, None, "unit.radian", "unit.kilojoule_per_mole/(unit.radian*unit.radian)")),
 ("HarmonicAngleForce", "getAngleParameters") : (None, (None, None, None, "unit.radian", "unit.kilojoule_per_mole/(unit.radian*unit.radian)")),
 ("HarmonicAngleForce", "setAngleParameters") : (None, (None, None, None, None, "unit.radian", "unit.kilojoule_per_mole/(unit.radian*unit.radian)")),
 ("HarmonicBondForce", "addBond") : (None, (None, None, "unit.nanometer", "unit.kilojoule_per_mole/(unit.nanometer*unit.nanometer)")),
+("HarmonicBondForce", "addBonds") : (None, (None, None, "unit.nanometer", "unit.kilojoule_per_mole/(unit.nanometer*unit.nanometer)")),
 ("HarmonicBondForce", "getBondParameters") : (None, (None, None, "unit.nanometer", "unit.kilojoule_per_mole/(unit.nanometer*unit.nanometer)")),
 ("HarmonicBondForce", "setBondParameters") : (None, (None, None, None, "unit.nanometer", "unit.kilojoule_per_mole/(unit.nanometer*unit.nanometer)")),
 ("MonteCarloBarostat", "getFrequency") : (None, ()),
@@ -425,12 +464,26 @@ UNITS = {
 ("NonbondedForce", "getPMEParameters") : (None, ("unit.nanometer**-1", None, None, None)),
 ("NonbondedForce", "setPMEParameters") : (None, ("unit.nanometer**-1", None, None, None)),
 ("NonbondedForce", "addException") : (None, (None, None, "unit.elementary_charge*unit.elementary_charge", "unit.nanometer", "unit.kilojoule_per_mole")),
+("NonbondedForce", "addExceptions") : (None, (None, None, "unit.elementary_charge*unit.elementary_charge", "unit.nanometer", "unit.kilojoule_per_mole", None)),
 ("NonbondedForce", "getExceptionParameters") : (None, (None, None, "unit.elementary_charge*unit.elementary_charge", "unit.nanometer", "unit.kilojoule_per_mole")),
 ("NonbondedForce", "setExceptionParameters") : (None, (None, None, None, "unit.elementary_charge*unit.elementary_charge", "unit.nanometer", "unit.kilojoule_per_mole")),
 ("NonbondedForce", "addParticle") : (None, ("unit.elementary_charge", "unit.nanometer", "unit.kilojoule_per_mole")),
+("NonbondedForce", "addParticles") : (None, ("unit.elementary_charge", "unit.nanometer", "unit.kilojoule_per_mole")),
 ("NonbondedForce", "getParticleParameters") : (None, ("unit.elementary_charge", "unit.nanometer", "unit.kilojoule_per_mole")),
 ("NonbondedForce", "setParticleParameters") : (None, (None, "unit.elementary_charge", "unit.nanometer", "unit.kilojoule_per_mole")),
+("NonbondedForce", "computeInteractionEnergy") : ("unit.kilojoule_per_mole", ()),
+("NonbondedForce", "computeEnergyChange") : ("unit.kilojoule_per_mole", ()),
+("NonbondedForce", "computeParticleEnergy") : ("unit.kilojoule_per_mole", ()),
+("CustomNonbondedForce", "computeEnergyChange") : ("unit.kilojoule_per_mole", ()),
+("CustomNonbondedForce", "computeParticleEnergy") : ("unit.kilojoule_per_mole", ()),
+("NonbondedForce", "computeStateEnergies") : (None, ()),
+("NonbondedForce", "computeTitrationEnergyChange") : ("unit.kilojoule_per_mole", ()),
+("NonbondedForce", "getTitrationSiteParameters") : (None, (None, None)),
+("NonbondedForce", "getTitrationStateParameters") : (None, ("unit.elementary_charge", "unit.nanometer", "unit.kilojoule_per_mole")),
+("NonbondedForce", "setTitrationStateExceptionParameters") : (None, (None, None, None, "unit.elementary_charge*unit.elementary_charge", "unit.nanometer", "unit.kilojoule_per_mole")),
+("NonbondedForce", "getTitrationStateExceptionParameters") : (None, (None, "unit.elementary_charge*unit.elementary_charge", "unit.nanometer", "unit.kilojoule_per_mole")),
 ("PeriodicTorsionForce", "addTorsion") : (None, (None, None, None, None, None, "unit.radian", "unit.kilojoule_per_mole")),
+("PeriodicTorsionForce", "addTorsions") : (None, (None, None, None, None, None, "unit.radian", "unit.kilojoule_per_mole")),
 ("PeriodicTorsionForce", "getTorsionParameters") : (None, (None, None, None, None, None, "unit.radian", "unit.kilojoule_per_mole")),
 ("PeriodicTorsionForce", "setTorsionParameters") : (None, (None, None, None, None, None, None, "unit.radian", "unit.kilojoule_per_mole")),
 ("GayBerneForce", "addParticle") : (None, ("unit.nanometer", "unit.kilojoule_per_mole", None, None, "unit.nanometer", "unit.nanometer", "unit.nanometer", None, None, None)),
@@ -448,12 +501,15 @@ UNITS = {
 ("State", "getStepCount") : (None, ()),
 ("State", "getKineticEnergy") : ("unit.kilojoules_per_mole", ()),
 ("State", "getPotentialEnergy") : ("unit.kilojoules_per_mole", ()),
+("State", "getGroupEnergies") : ("unit.kilojoules_per_mole", ()),
 ("State", "getPeriodicBoxVolume") : ("unit.nanometers**3", ()),
 ("State", "getPeriodicBoxVectors") : ("unit.nanometers", ()),
 ("State", "getParameters") : (None, ()),
 ("State", "getEnergyParameterDerivatives") : (None, ()),
 ("System", "addParticle") : (None, ("unit.amu",)),
+("System", "addParticles") : (None, ("unit.amu",)),
 ("System", "addConstraint") : (None, (None, None, "unit.nanometer")),
+("System", "addConstraints") : (None, (None, None, "unit.nanometer")),
 ("System", "getConstraintParameters") : (None, (None, None, "unit.nanometer")),
 ("System", "setConstraintParameters") : (None, (None, None, None, "unit.nanometer")),
 ("System", "getForce") : (None, ()),
@@ -468,6 +524,7 @@ UNITS = {
 ("BrownianIntegrator", "BrownianIntegrator") : (None, ("unit.kelvin", "unit.picosecond**-1", "unit.picosecond")),
 ("LangevinIntegrator", "LangevinIntegrator") : (None, ("unit.kelvin", "unit.picosecond**-1", "unit.picosecond")),
 ("LangevinMiddleIntegrator", "LangevinMiddleIntegrator") : (None, ("unit.kelvin", "unit.picosecond**-1", "unit.picosecond")),
+("MTSLangevinIntegrator", "MTSLangevinIntegrator") : (None, ("unit.kelvin", "unit.picosecond**-1", "unit.picosecond", None)),
 ("VariableLangevinIntegrator", "VariableLangevinIntegrator") : (None, ("unit.kelvin", "unit.picosecond**-1", None)),
 ("VerletIntegrator", "VerletIntegrator") : (None, ("unit.picosecond",)),
 ("DrudeIntegrator", "getDrudeTemperature") : ("unit.kelvin", ()),
@@ -512,6 +569,49 @@ UNITS = {
 ("DPDIntegrator", "setDefaultCutoff") : (None, ("unit.nanometer",)),
 ("DPDIntegrator", "getParticleTypes") : (None, ()),
 ("LocalEnergyMinimizer", "minimize") : (None, (None, "unit.kilojoules_per_mole/unit.nanometer", None)),
+("PMETuner", "tune") : (None, (None, "unit.nanometer", None, None, None)),
+("PMETuner", "selectGrid") : (None, (None, "unit.nanometer", None, None)),
+("PlatformSelector", "select") : (None, (None, None, "unit.nanometer")),
+("HydrogenMassRepartitioner", "repartition") : (None, (None, "unit.amu")),
+("ReplicaExchange", "getReplicaStates") : (None, ()),
+("NCMCDriver", "getTemperature") : ("unit.kelvin", ()),
+("NCMCDriver", "getLastWork") : ("unit.kilojoule_per_mole", ()),
+("NCMCDriver", "getParameterSchedule") : (None, ()),
+("ReplicaExchange", "computeReducedPotentials") : (None, ()),
+("ReplicaExchange", "getNumAttempted") : (None, ()),
+("ReplicaExchange", "getNumAccepted") : (None, ()),
+("ReplicaExchange", "setIntegratorTemperature") : (None, ()),
+("ReplicaExchange", "getTemperatureParameters") : (None, ()),
+("SimulatedTemperingDriver", "getTemperature") : ("unit.kelvin", ()),
+("SimulatedTemperingDriver", "getWeights") : (None, ()),
+("SystemReplicator", "createSystem") : (None, (None, None, "unit.nanometer")),
+("SystemReplicator", "combinePositions") : ("unit.nanometer", ()),
+("SystemReplicator", "splitValues") : (None, ()),
+("SystemReplicator", "splitPositions") : ("unit.nanometer", ()),
+("BatchEnergyMinimizer", "BatchEnergyMinimizer") : (None, (None, None, "unit.nanometer", None, None)),
+("BatchEnergyMinimizer", "minimize") : (None, ("unit.nanometer", "unit.kilojoule_per_mole/unit.nanometer", None)),
+("BatchEnergyMinimizer", "getPositions") : ("unit.nanometer", ()),
+("BatchEnergyMinimizer", "getEnergies") : ("unit.kilojoule_per_mole", ()),
+("BatchEnergyMinimizer", "getIterations") : (None, ()),
+("BatchEnergyMinimizer", "getConverged") : (None, ()),
+("ObservableRecorder", "getInterval") : (None, ()),
+("ObservableRecorder", "getCapacity") : (None, ()),
+("ObservableRecorder", "getNumObservables") : (None, ()),
+("ObservableRecorder", "getNumSamples") : (None, ()),
+("ObservableRecorder", "getNumDiscarded") : (None, ()),
+("ObservableRecorder", "addPotentialEnergy") : (None, (None,)),
+("ObservableRecorder", "addKineticEnergy") : (None, ()),
+("ObservableRecorder", "addTemperature") : (None, ()),
+("ObservableRecorder", "addVolume") : (None, ()),
+("ObservableRecorder", "drain") : (None, ()),
+("TrajectoryWriter", "getInterval") : (None, ()),
+("TrajectoryWriter", "getNumFrames") : (None, ()),
+("SharedMemoryExporter", "getInterval") : (None, ()),
+("SharedMemoryExporter", "getNumSlots") : (None, ()),
+("SharedMemoryExporter", "getNumFrames") : (None, ()),
+("SharedMemoryReader", "getNumAtoms") : (None, ()),
+("SharedMemoryReader", "getNumSlots") : (None, ()),
+("SharedMemoryReader", "getNumFrames") : (None, ()),
 ("ATMForce", "getForce") : (None, ()),
 ("ATMForce", "getPerturbationEnergy") :  ('unit.kilojoule_per_mole', ()),
 ("ATMForce", "getDefaultLambda1") :  (None, ()),
@@ -15,7 +15,8 @@
                  enforcePeriodicBox=False, groups=-1,
                  getPositions=False, getVelocities=False,
                  getForces=False, getEnergy=False, getParameters=False,
-                 getParameterDerivatives=False, getIntegratorParameters=False):
+                 getParameterDerivatives=False, getIntegratorParameters=False,
+                 particles=None, groupEnergies=False):
         """Get a State object recording the current state information stored in this context.
 
         Parameters
@@ -58,6 +59,13 @@
             Deprecated.  Use `parameterDerivatives` instead.
         getIntegratorParameters : bool=False
             Deprecated.  Use `integratorParameters` instead.
+        particles : list=None
+            if specified, positions, velocities, and forces are only retrieved
+            for these particles.  Element i of each array in the State
+            corresponds to particle particles[i].
+        groupEnergies : bool=False
+            whether to store the potential energy of each force group in the
+            State.  This is faster than calling getState() once for each group.
         """
         try:
             # is the input integer-like?
@@ -86,19 +94,46 @@
             types += State.ParameterDerivatives
         if integratorParameters or getIntegratorParameters:
             types += State.IntegratorParameters
-        state = _openmm.Context_getState(self, types, enforcePeriodicBox, groups_mask)
+        if groupEnergies:
+            types += State.GroupEnergies
+        if particles is None:
+            state = _openmm.Context_getState(self, types, enforcePeriodicBox, groups_mask)
+        else:
+            state = _openmm.Context_getState(self, types, list(particles), enforcePeriodicBox, groups_mask)
         return state
 
+    def getDeviceArrayView(self, name):
+        """Get a read-only view of an array this Context stores on a GPU.  The returned object
+        implements __cuda_array_interface__, so it can be passed directly to libraries such as
+        CuPy, PyTorch, or Numba without copying it to the host.  All queued work is completed
+        before this returns.  The view is only valid until the Context next does anything, such
+        as taking a step.  See getDeviceArray() for the arrays that are available.
+
+        Parameters
+        ----------
+        name : str
+            the name of the array to get
+
+        Returns
+        -------
+        an object with a __cuda_array_interface__ attribute describing the array
+        """
+        pointer, shape, typestr, deviceIndex = self.getDeviceArray(name)
+        return DeviceArrayView(self, pointer, shape, typestr, deviceIndex)
+
   %}
 
   %feature("docstring") createCheckpoint "Create a checkpoint recording the current state of the Context.
 This should be treated as an opaque block of binary data.  See loadCheckpoint() for more details.
 
+Parameters:
+ - compress (bool) whether to compress the checkpoint data.  This requires OpenMM to be built with zlib.
+
 Returns: a string containing the checkpoint data
 "
-  std::string createCheckpoint() {
+  std::string createCheckpoint(bool compress=false) {
     std::stringstream stream(std::ios_base::in | std::ios_base::out | std::ios_base::binary);
-    self->createCheckpoint(stream);
+    self->createCheckpoint(stream, compress);
     return stream.str();
   }
 
@@ -368,6 +403,18 @@ Parameters:
       return OpenMM::XmlSerializer::clone<OpenMM::State>(*object);
   }
 
+  static void _serializeSystemBinaryFile(const OpenMM::System* object, const std::string& filename) {
+      std::ofstream stream(filename.c_str(), std::ios::out | std::ios::binary);
+      if (!stream)
+          throw OpenMM::OpenMMException("Failed to open file for writing: "+filename);
+      OpenMM::BinarySerializer::serialize<OpenMM::System>(object, "System", stream);
+  }
+
+  %newobject _deserializeSystemBinaryFile;
+  static OpenMM::System* _deserializeSystemBinaryFile(const std::string& filename) {
+      return OpenMM::BinarySerializer::deserializeFile<OpenMM::System>(filename);
+  }
+
   %pythoncode %{
     @staticmethod
     def serialize(object):
@@ -521,13 +568,11 @@ Parameters:
            the context.getState() call.
            Returns a list of Vec3s, unless asNumpy is True, in
            which  case a Numpy array of arrays will be returned.
+           The Numpy array views the data stored in the State
+           without copying it.
            """
         if asNumpy:
-            if '_positionsNumpy' not in dir(self):
-                self._positionsNumpy = numpy.empty([self._getNumParticles(), 3], numpy.float64)
-                self._getVectorAsNumpy(State.Positions, self._positionsNumpy)
-                self._positionsNumpy = self._positionsNumpy*unit.nanometers
-            return self._positionsNumpy
+            return self._getVectorAsNumpy(State.Positions, self)*unit.nanometers
         if '_positions' not in dir(self):
             self._positions = self._getVectorAsVec3(State.Positions)*unit.nanometers
         return self._positions
@@ -537,14 +582,11 @@ Parameters:
            Raises an exception if velocities where not requested in
            the context.getState() call.
            Returns a list of Vec3s if asNumpy is False, or a Numpy
-           array if asNumpy is True.
+           array if asNumpy is True.  The Numpy array views the
+           data stored in the State without copying it.
            """
         if asNumpy:
-            if '_velocitiesNumpy' not in dir(self):
-                self._velocitiesNumpy = numpy.empty([self._getNumParticles(), 3], numpy.float64)
-                self._getVectorAsNumpy(State.Velocities, self._velocitiesNumpy)
-                self._velocitiesNumpy = self._velocitiesNumpy*unit.nanometers/unit.picosecond
-            return self._velocitiesNumpy
+            return self._getVectorAsNumpy(State.Velocities, self)*unit.nanometers/unit.picosecond
         if '_velocities' not in dir(self):
             self._velocities = self._getVectorAsVec3(State.Velocities)*unit.nanometers/unit.picosecond
         return self._velocities
@@ -554,29 +596,16 @@ Parameters:
            Raises an exception if forces where not requested in
            the context.getState() call.
            Returns a list of Vec3s if asNumpy is False, or a Numpy
-           array if asNumpy is True.
+           array if asNumpy is True.  The Numpy array views the
+           data stored in the State without copying it.
            """
         if asNumpy:
-            if '_forcesNumpy' not in dir(self):
-                self._forcesNumpy = numpy.empty([self._getNumParticles(), 3], numpy.float64)
-                self._getVectorAsNumpy(State.Forces, self._forcesNumpy)
-                self._forcesNumpy = self._forcesNumpy*unit.kilojoules_per_mole/unit.nanometer
-            return self._forcesNumpy
+            return self._getVectorAsNumpy(State.Forces, self)*unit.kilojoules_per_mole/unit.nanometer
         if '_forces' not in dir(self):
             self._forces = self._getVectorAsVec3(State.Forces)*unit.kilojoules_per_mole/unit.nanometer
         return self._forces
   %}
   
-  int _getNumParticles() {
-      if ((self->getDataTypes() & State::Positions) != 0)
-          return self->getPositions().size();
-      if ((self->getDataTypes() & State::Velocities) != 0)
-          return self->getVelocities().size();
-      if ((self->getDataTypes() & State::Forces) != 0)
-          return self->getForces().size();
-      return 0;
-  }
-  
   PyObject* _getVectorAsVec3(State::DataType type) {
       if (type == State::Positions)
           return copyVVec3ToList(self->getPositions());
@@ -588,7 +617,11 @@ Parameters:
       return NULL;
   }
   
-  void _getVectorAsNumpy(State::DataType type, PyObject* output) {
+  PyObject* _getVectorAsNumpy(State::DataType type, PyObject* owner) {
+      // Return an array that views the data stored in the State without copying it.  The
+      // array holds a reference to the Python State, so the data lives as long as it does.
+      // Creating the view is cheap, so it is not cached, which would create a reference cycle.
+
       const std::vector<Vec3>* array;
       if (type == State::Positions)
           array = &self->getPositions();
@@ -598,10 +631,22 @@ Parameters:
           array = &self->getForces();
       else {
         PyErr_SetString(PyExc_ValueError, "Illegal type specified in _getVectorAsNumpy");
-        return;
+        return NULL;
+      }
+      if (!isNumpyAvailable()) {
+        PyErr_SetString(PyExc_ImportError, "NumPy is not available");
+        return NULL;
+      }
+      npy_intp dims[2] = {(npy_intp) array->size(), 3};
+      PyObject* result = PyArray_SimpleNewFromData(2, dims, NPY_DOUBLE, (void*) array->data());
+      if (result == NULL)
+          return NULL;
+      Py_INCREF(owner);
+      if (PyArray_SetBaseObject((PyArrayObject*) result, owner) < 0) {
+          Py_DECREF(result);
+          return NULL;
       }
-      void* data = PyArray_DATA((PyArrayObject*) output);
-      memcpy(data, &array[0][0], 3*sizeof(double)*array->size());
+      return result;
   }
 
   %newobject __copy__;
@@ -11,3 +11,4 @@
 %include typemaps.i
 
 %feature("director") OpenMM::MinimizationReporter;
+%newobject OpenMM::SystemReplicator::createSystem;
@@ -1,5 +1,7 @@
 
 %header %{
+#include <fstream>
+
 namespace OpenMM {
 
 PyObject *copyVVec3ToList(std::vector<Vec3> vVec3) {
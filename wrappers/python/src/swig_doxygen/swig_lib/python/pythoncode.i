@@ -21,6 +21,17 @@ import openmm.unit as unit
 from openmm.vec3 import Vec3
 
 
+class DeviceArrayView(object):
+    """A read-only view of an array stored on a GPU by a Context, as returned by
+    Context.getDeviceArrayView().  It implements __cuda_array_interface__ and holds a reference
+    to the Context so the memory is not freed while the view exists."""
+
+    def __init__(self, context, pointer, shape, typestr, deviceIndex):
+        self.context = context
+        self.deviceIndex = deviceIndex
+        self.__cuda_array_interface__ = {'shape': tuple(shape), 'typestr': typestr, 'data': (pointer, True), 'version': 3, 'strides': None, 'stream': None}
+
+
 %}
 
 %pythonappend OpenMM::Context::Context %{
@@ -28,6 +39,18 @@ from openmm.vec3 import Vec3
     self._integrator = args[1]
 %}
 
+%pythonappend OpenMM::NCMCDriver::NCMCDriver %{
+    self._context = args[0]
+%}
+
+%pythonappend OpenMM::SimulatedTemperingDriver::SimulatedTemperingDriver %{
+    self._context = args[0]
+%}
+
+%pythonappend OpenMM::BatchEnergyMinimizer::BatchEnergyMinimizer %{
+    self._system = args[0]
+%}
+
 %pythonprepend OpenMM::AmoebaAngleForce::addAngle %{
     try:
         length = args[3]
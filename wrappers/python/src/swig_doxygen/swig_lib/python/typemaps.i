@@ -237,41 +237,23 @@ int Py_SequenceToVecVec3(PyObject* obj, std::vector<Vec3>& out) {
     PyObject* stripped = Py_StripOpenMMUnits(obj);      // new reference
     if (isNumpyAvailable()) {
         if (PyArray_Check(stripped)) {
-            const PyArrayObject* array = (PyArrayObject*) stripped;
-            if (PyArray_ISCARRAY_RO(array) && PyArray_NDIM(array) == 2 && PyArray_DIM(array, 1) == 3) {
-                int type = PyArray_TYPE(array);
-                int length = PyArray_DIM(array, 0);
-                void* data = PyArray_DATA((PyArrayObject*) array);
-                if (type == NPY_DOUBLE) {
-                    out.resize(length);
-                    memcpy(&out[0][0], data, 3*sizeof(double)*length);
-                    Py_DECREF(array);
-                    return SWIG_OK;
-                }
-                if (type == NPY_FLOAT) {
-                    out.resize(length);
-                    float* floatData = (float*) data;
-                    for (int i = 0; i < length; i++)
-                        out[i] = Vec3(floatData[3*i], floatData[3*i+1], floatData[3*i+2]);
-                    Py_DECREF(array);
-                    return SWIG_OK;
-                }
-                if (type == NPY_INT32) {
+            PyArrayObject* array = (PyArrayObject*) stripped;
+            if (PyArray_NDIM(array) == 2 && PyArray_DIM(array, 1) == 3 && PyArray_ISNUMBER(array)) {
+                // Get the data as a C ordered array of doubles.  If it already is one, this returns
+                // the same array without copying it.  Either way, the values are then copied with a
+                // single memcpy instead of converting each element separately.
+
+                PyObject* contiguous = PyArray_FROMANY(stripped, NPY_DOUBLE, 2, 2, NPY_ARRAY_CARRAY_RO);
+                if (contiguous != NULL) {
+                    int length = PyArray_DIM((PyArrayObject*) contiguous, 0);
                     out.resize(length);
-                    int* intData = (int*) data;
-                    for (int i = 0; i < length; i++)
-                        out[i] = Vec3(intData[3*i], intData[3*i+1], intData[3*i+2]);
-                    Py_DECREF(array);
-                    return SWIG_OK;
-                }
-                if (type == NPY_INT64) {
-                    out.resize(length);
-                    long long* longData = (long long*) data;
-                    for (int i = 0; i < length; i++)
-                        out[i] = Vec3(longData[3*i], longData[3*i+1], longData[3*i+2]);
-                    Py_DECREF(array);
+                    if (length > 0)
+                        memcpy(&out[0][0], PyArray_DATA((PyArrayObject*) contiguous), 3*sizeof(double)*length);
+                    Py_DECREF(contiguous);
+                    Py_DECREF(stripped);
                     return SWIG_OK;
                 }
+                PyErr_Clear();
             }
         }
     }
@@ -493,10 +475,24 @@ int Py_SequenceToVecVecVecDouble(PyObject* obj, std::vector<std::vector<std::vec
     $1 = &v;
 }
 %typemap(typecheck, precedence=SWIG_TYPECHECK_DOUBLE_ARRAY, fragment="Py_SequenceToVecVec3") const std::vector<Vec3>& {
-    std::vector<Vec3> v;
-    int res=0;
-    res = Py_SequenceToVecVec3($input, v);
-    $1 = SWIG_IsOK(res);
+    // A NumPy array with the right shape is accepted without converting it, since that would
+    // mean converting large arrays twice.
+
+    PyObject* stripped = Py_StripOpenMMUnits($input);
+    if (stripped == NULL) {
+        PyErr_Clear();
+        $1 = 0;
+    }
+    else if (isNumpyAvailable() && PyArray_Check(stripped) && PyArray_NDIM((PyArrayObject*) stripped) == 2 &&
+            PyArray_DIM((PyArrayObject*) stripped, 1) == 3 && PyArray_ISNUMBER((PyArrayObject*) stripped))
+        $1 = 1;
+    else {
+        std::vector<Vec3> v;
+        int res=0;
+        res = Py_SequenceToVecVec3($input, v);
+        $1 = SWIG_IsOK(res);
+    }
+    Py_XDECREF(stripped);
 }
 %typemap(out) const std::vector<Vec3>& {
     $result = copyVVec3ToList(*$1);
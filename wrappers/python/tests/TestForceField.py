@@ -296,6 +296,35 @@ class TestForceField(unittest.TestCase):
         with self.assertRaises(ValueError):
             self.forcefield1.createSystem(topology, nonbndedCutoff=1.0*nanometer)
 
+    def test_SystemCache(self):
+        """Test caching Systems created by createSystem()."""
+        topology = self.pdb1.topology
+        ff = ForceField('amber99sb.xml', 'tip3p.xml')
+        with tempfile.TemporaryDirectory() as cacheDir:
+            ff.setSystemCacheDirectory(cacheDir)
+            self.assertEqual(cacheDir, ff.getSystemCacheDirectory())
+            system1 = ff.createSystem(topology, nonbondedMethod=PME, constraints=HBonds)
+            self.assertEqual(1, len(os.listdir(cacheDir)))
+
+            # Creating the same System again should load it from the cache.
+
+            system2 = ff.createSystem(topology, nonbondedMethod=PME, constraints=HBonds)
+            self.assertEqual(1, len(os.listdir(cacheDir)))
+            self.assertEqual(XmlSerializer.serialize(system1), XmlSerializer.serialize(system2))
+
+            # Different arguments or a different force field should create a new entry.
+
+            system3 = ff.createSystem(topology, nonbondedMethod=PME, constraints=AllBonds)
+            self.assertEqual(2, len(os.listdir(cacheDir)))
+            self.assertNotEqual(system1.getNumConstraints(), system3.getNumConstraints())
+            ff2 = ForceField('amber99sb.xml', 'tip3p.xml', 'amber99_obc.xml')
+            ff2.setSystemCacheDirectory(cacheDir)
+            ff2.createSystem(topology, nonbondedMethod=PME, constraints=HBonds)
+            self.assertEqual(3, len(os.listdir(cacheDir)))
+            ff.setSystemCacheDirectory(None)
+            ff.createSystem(topology, nonbondedMethod=PME, constraints=HBonds, rigidWater=False)
+            self.assertEqual(3, len(os.listdir(cacheDir)))
+
     def test_Forces(self):
         """Compute forces and compare them to ones generated with a previous version of OpenMM to ensure they haven't changed."""
 
@@ -632,6 +661,17 @@ class TestForceField(unittest.TestCase):
             else:
                 self.assertEqual(-0.417*elementary_charge, charge)
 
+    def test_templateMatchCache(self):
+        """Test that reusing matches for identical residues gives the same System as matching each one."""
+        system1 = self.forcefield1.createSystem(self.topology1)
+
+        # A template matcher that never returns a template disables the cache without changing the result.
+
+        forcefield = ForceField('amber99sb.xml', 'tip3p.xml')
+        forcefield.registerTemplateMatcher(lambda ff, res, bondedToAtom, ignoreExternalBonds, ignoreExtraParticles: None)
+        system2 = forcefield.createSystem(self.topology1)
+        self.assertEqual(XmlSerializer.serialize(system1), XmlSerializer.serialize(system2))
+
     def test_residueTemplateGenerator(self):
         """Test the ability to add residue template generators to parameterize unmatched residues."""
         def simpleTemplateGenerator(forcefield, residue):
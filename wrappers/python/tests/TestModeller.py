@@ -391,6 +391,32 @@ class TestModeller(unittest.TestCase):
         self.assertAlmostEqual(0.707, dodecVolume/cubeVolume, places=3)
         self.assertAlmostEqual(0.770, octVolume/cubeVolume, places=3)
 
+    def test_cellList(self):
+        """Test that the cell list used by addSolvent() and addMembrane() finds the same overlaps as a brute force search."""
+        from openmm.app.internal import compiled
+        random.seed(1)
+        vectors = (Vec3(3, 0, 0), Vec3(1, 3, 0), Vec3(-1, 1, 3))
+        positions = [Vec3(random.random()*4-1, random.random()*4-1, random.random()*4-1) for i in range(300)]
+        points = [Vec3(random.random()*4-1, random.random()*4-1, random.random()*4-1) for i in range(300)]
+        cutoffs = [0.2+0.2*random.random() for i in range(len(positions))]
+        for periodic in (True, False):
+            cells = compiled.cellList(positions, max(cutoffs), vectors if periodic else None, periodic)
+            if periodic:
+                distance = compiled.periodicDistance(vectors)
+            else:
+                distance = lambda p1, p2: norm(p1-p2)
+            overlaps = cells.findOverlaps(points, cutoffs)
+            for point, overlap in zip(points, overlaps):
+                expected = any(distance(point, positions[i]) < cutoffs[i] for i in range(len(positions)))
+                self.assertEqual(expected, overlap)
+                neighbors = set(cells.neighbors(point))
+                for i in range(len(positions)):
+                    if distance(point, positions[i]) < max(cutoffs):
+                        self.assertTrue(i in neighbors)
+            if not periodic:
+                minDist = min(distance(p1, p2) for p1 in points[:10] for p2 in positions)
+                self.assertAlmostEqual(minDist, cells.minDistance(points[:10]))
+
     def test_addSolventNeutralSolvent(self):
         """ Test the addSolvent() method; test adding ions to neutral solvent. """
 
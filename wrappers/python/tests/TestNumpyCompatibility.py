@@ -42,6 +42,29 @@ class TestNumpyCompatibility(unittest.TestCase):
         np.testing.assert_array_almost_equal(input.value_in_unit(unit.nanometers), output.value_in_unit(unit.nanometers))
 
 
+    def test_setPositions_layouts(self):
+        n_particles = self.simulation.context.getSystem().getNumParticles()
+        input = np.random.randn(n_particles, 3)
+        for array in [np.asfortranarray(input), input.astype(np.float32), np.random.randn(2*n_particles, 3)[::2]]:
+            self.simulation.context.setPositions(array)
+            output = self.simulation.context.getState(getPositions=True).getPositions(asNumpy=True)
+            np.testing.assert_array_almost_equal(array, output.value_in_unit(unit.nanometers), decimal=5)
+
+    def test_stateArrayIsView(self):
+        state = self.simulation.context.getState(getPositions=True, getVelocities=True, getForces=True)
+        for getter in [state.getPositions, state.getVelocities, state.getForces]:
+            array = getter(asNumpy=True)._value
+            self.assertEqual((self.simulation.system.getNumParticles(), 3), array.shape)
+            self.assertFalse(array.flags.owndata)
+            np.testing.assert_array_equal(array, np.array(getter()._value))
+
+        # The view should remain valid after the State is no longer referenced.
+
+        positions = state.getPositions(asNumpy=True)
+        expected = np.array(positions._value)
+        del state
+        np.testing.assert_array_equal(expected, positions._value)
+
     def test_setVelocities(self):
         n_particles = self.simulation.context.getSystem().getNumParticles()
         input = np.random.randn(n_particles, 3)
@@ -210,5 +210,28 @@ class TestPdbxFile(unittest.TestCase):
             self.assertEqual(id, res.id)
             self.assertEqual(code, res.insertionCode)
 
+    def testTokenizer(self):
+        """Test that the compiled tokenizer matches the regular expression it replaced."""
+        import re
+        from openmm.app.internal.compiled import tokenizeCifLine
+        mmcifRe = re.compile(r"(?:(?:_(.+?)[.](\S+))|(?:['](.*?)(?:[']\s|[']$))|(?:[\"](.*?)(?:[\"]\s|[\"]$))|(?:\s*#.*$)|(\S+))")
+        lines = ["_atom_site.Cartn_x 1.0\n",
+                 "HETATM 1 O O . HOH A 2 ? 1.0 2.0 3.0 1.00 0.00 ? 1 HOH A O 1\n",
+                 "'a quoted string' \"another 'one'\" it's\n",
+                 "'ends at the line end'",
+                 "  # a comment\n",
+                 "word#notcomment #comment\n",
+                 "_a b.c _.x _x. 'unterminated \"quote\n",
+                 ""]
+        with open('systems/multichain.pdbx') as input:
+            lines += input.readlines()
+        for line in lines:
+            expected = []
+            for match in mmcifRe.finditer(line):
+                groups = match.groups()
+                if groups != (None, None, None, None, None):
+                    expected.append((groups[0], groups[1], groups[2] if groups[2] is not None else groups[3], groups[4]))
+            self.assertEqual(expected, tokenizeCifLine(line))
+
 if __name__ == '__main__':
     unittest.main()
@@ -197,6 +197,42 @@ class TestSimulation(unittest.TestCase):
         
         simulation.step(500)
 
+    def testOverlapReports(self):
+        """Test invoking reporters while the next block of steps is computed."""
+        pdb = PDBFile('systems/alanine-dipeptide-implicit.pdb')
+        ff = ForceField('amber99sb.xml', 'tip3p.xml')
+        system = ff.createSystem(pdb.topology)
+
+        class RecordingReporter(object):
+            def __init__(self, interval):
+                self.interval = interval
+                self.reports = []
+
+            def describeNextReport(self, simulation):
+                steps = self.interval - simulation.currentStep%self.interval
+                return {'steps':steps, 'periodic':False, 'include':['positions', 'energy']}
+
+            def report(self, simulation, state):
+                self.reports.append((simulation.currentStep, state.getStepCount(), state.getPositions(), state.getPotentialEnergy()))
+
+        # Run the same simulation with and without overlapping, and make sure the reporters see identical results.
+
+        results = []
+        for overlap in (False, True):
+            integrator = VerletIntegrator(0.001*picoseconds)
+            simulation = Simulation(pdb.topology, system, integrator, Platform.getPlatform('Reference'))
+            simulation.context.setPositions(pdb.positions)
+            simulation.overlapReports = overlap
+            reporters = [RecordingReporter(7), RecordingReporter(10)]
+            simulation.reporters += reporters
+            simulation.step(45)
+            self.assertEqual(45, simulation.currentStep)
+            results.append([r.reports for r in reporters])
+        self.assertEqual(results[0], results[1])
+        for reports, interval in zip(results[1], (7, 10)):
+            self.assertEqual([interval*(i+1) for i in range(45//interval)], [r[0] for r in reports])
+            self.assertEqual([r[0] for r in reports], [r[1] for r in reports])
+
     def testMinimizationReporter(self):
         """Test invoking a reporter during minimization."""
         pdb = PDBFile('systems/alanine-dipeptide-implicit.pdb')
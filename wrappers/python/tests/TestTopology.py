@@ -59,5 +59,28 @@ class TestTopology(unittest.TestCase):
         self.assertEqual(internal_bonds, [ (atom_B1, atom_B2) ])
         self.assertEqual(external_bonds, [ (atom_A1, atom_B1), (atom_B2, atom_C1) ])
 
+    def test_copy(self):
+        """Test that pickling and copying a Topology preserves all its information."""
+        import copy
+        topology = PDBFile('systems/1T2Y.pdb').topology
+        atoms = list(topology.atoms())
+        topology.addBond(atoms[0], atoms[1], Double, 2)
+        atoms[0].extra = 'value'
+        for copied in (pickle.loads(pickle.dumps(topology)), copy.deepcopy(topology)):
+            copiedAtoms = list(copied.atoms())
+            self.assertEqual(len(atoms), len(copiedAtoms))
+            for atom1, atom2 in zip(atoms, copiedAtoms):
+                self.assertEqual(atom1.name, atom2.name)
+                self.assertEqual(atom1.element, atom2.element)
+                self.assertEqual(atom1.id, atom2.id)
+                self.assertEqual(atom1.residue.name, atom2.residue.name)
+                self.assertEqual(atom1.residue.chain.id, atom2.residue.chain.id)
+            self.assertEqual('value', copiedAtoms[0].extra)
+            bonds = list(copied.bonds())
+            self.assertEqual(topology.getNumBonds(), len(bonds))
+            self.assertEqual(Double, bonds[-1].type)
+            self.assertEqual(2, bonds[-1].order)
+            self.assertEqual((0, 1), (bonds[-1][0].index, bonds[-1][1].index))
+
 if __name__ == '__main__':
     unittest.main()